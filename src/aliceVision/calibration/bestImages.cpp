@@ -7,6 +7,8 @@
 #include "bestImages.hpp"
 #include <aliceVision/system/Logger.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <numeric>
 #include <iostream>
@@ -22,16 +24,18 @@ void precomputeCellIndexes(const std::vector<std::vector<cv::Point2f> >& imagePo
 {
   float cellWidth = float(imageSize.width) / float(calibGridSize);
   float cellHeight = float(imageSize.height) / float(calibGridSize);
+  const int maxCell = static_cast<int>(calibGridSize) - 1;
 
   for (const auto& pointbuf : imagePoints)
   {
     std::vector<std::size_t> imageCellIndexes;
+    imageCellIndexes.reserve(pointbuf.size());
     // Points repartition in image
     for (cv::Point2f point : pointbuf)
     {
-      // Compute the index of the point
-      std::size_t cellPointX = std::floor(point.x / cellWidth);
-      std::size_t cellPointY = std::floor(point.y / cellHeight);
+      // Compute the index of the point, the points on the image border are in the border cells
+      std::size_t cellPointX = std::min(std::max(static_cast<int>(std::floor(point.x / cellWidth)), 0), maxCell);
+      std::size_t cellPointY = std::min(std::max(static_cast<int>(std::floor(point.y / cellHeight)), 0), maxCell);
       std::size_t cellIndex = cellPointY * calibGridSize + cellPointX;
       imageCellIndexes.push_back(cellIndex);
     }
@@ -105,27 +109,51 @@ void selectBestImages(const std::vector<std::vector<cv::Point2f> >& imagePoints,
   std::vector<std::size_t> bestImagesIndexes;
   if (maxCalibFrames < imagePoints.size())
   {
-    while (bestImagesIndexes.size() < maxCalibFrames )
+    const std::size_t nbCells = calibGridSize * calibGridSize;
+
+    // Occupied cells of each image, with the number of points of the image in each one
+    std::vector<std::vector<std::pair<std::size_t, std::size_t> > > cellCountsPerImage(imagePoints.size());
+    for (std::size_t i = 0; i < imagePoints.size(); ++i)
     {
-      std::map<std::size_t, std::size_t> cellsWeight;
-      std::vector<std::pair<float, std::size_t> > imageScores;
-      // Count points in each cell of the grid
-      if (bestImagesIndexes.empty())
-        computeCellsWeight(remainingImagesIndexes, cellIndexesPerImage, calibGridSize, cellsWeight);
-      else
-        computeCellsWeight(bestImagesIndexes, cellIndexesPerImage, calibGridSize, cellsWeight);
+      std::vector<std::size_t> imageCellIndexes = cellIndexesPerImage[i];
+      std::sort(imageCellIndexes.begin(), imageCellIndexes.end());
+      for (std::size_t cellIndex : imageCellIndexes)
+      {
+        if (cellCountsPerImage[i].empty() || cellCountsPerImage[i].back().first != cellIndex)
+          cellCountsPerImage[i].emplace_back(cellIndex, 0);
+        ++cellCountsPerImage[i].back().second;
+      }
+    }
+
+    // Number of images occupying each cell of the grid:
+    // all the images for the first selection, then only the selected images
+    std::vector<std::size_t> cellsOccupancy(nbCells, 0);
+    for (const auto& cellCounts : cellCountsPerImage)
+      for (const auto& cellCount : cellCounts)
+        ++cellsOccupancy[cellCount.first];
 
-      computeImageScores(remainingImagesIndexes, cellIndexesPerImage, cellsWeight, imageScores);
+    // Sum of the cell occupancy of the points of each image, updated with each selected image
+    std::vector<std::size_t> imageSums(imagePoints.size(), 0);
+    for (std::size_t i = 0; i < imagePoints.size(); ++i)
+      for (const auto& cellCount : cellCountsPerImage[i])
+        imageSums[i] += cellCount.second * cellsOccupancy[cellCount.first];
 
+    std::vector<bool> isCellOfNewImage(nbCells, false);
+
+    while (bestImagesIndexes.size() < maxCalibFrames )
+    {
       // Find best score
+      // (the points are normalized by the number of checker items:
+      //  if the detector support occlusions of the checker the number of items may vary)
       std::size_t bestImageIndex = std::numeric_limits<std::size_t>::max();
       float bestScore = std::numeric_limits<float>::max();
-      for (const auto& imageScore: imageScores)
+      for (std::size_t imageIndex : remainingImagesIndexes)
       {
-        if (imageScore.first < bestScore)
+        const float imageScore = float(imageSums[imageIndex]) / float(cellIndexesPerImage[imageIndex].size());
+        if (imageScore < bestScore)
         {
-          bestScore = imageScore.first;
-          bestImageIndex = imageScore.second;
+          bestScore = imageScore;
+          bestImageIndex = imageIndex;
         }
       }
       auto eraseIt = std::find(remainingImagesIndexes.begin(), remainingImagesIndexes.end(), bestImageIndex);
@@ -134,6 +162,25 @@ void selectBestImages(const std::vector<std::vector<cv::Point2f> >& imagePoints,
       remainingImagesIndexes.erase(eraseIt);
       bestImagesIndexes.push_back(bestImageIndex);
       calibImageScore.push_back(bestScore);
+
+      // Update the scores with the cells of the selected image
+      if (bestImagesIndexes.size() == 1)
+      {
+        // only the selected images weight the cells from now on
+        std::fill(imageSums.begin(), imageSums.end(), 0);
+      }
+
+      const auto& newCellCounts = cellCountsPerImage[bestImageIndex];
+      for (const auto& cellCount : newCellCounts)
+        isCellOfNewImage[cellCount.first] = true;
+
+      for (std::size_t imageIndex : remainingImagesIndexes)
+        for (const auto& cellCount : cellCountsPerImage[imageIndex])
+          if (isCellOfNewImage[cellCount.first])
+            imageSums[imageIndex] += cellCount.second;
+
+      for (const auto& cellCount : newCellCounts)
+        isCellOfNewImage[cellCount.first] = false;
     }
   }
   else
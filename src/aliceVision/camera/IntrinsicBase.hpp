@@ -147,13 +147,28 @@ struct IntrinsicBase
   inline Mat2X residuals(const geometry::Pose3& pose, const Mat3X& X, const Mat2X& x) const
   {
     assert(X.cols() == x.cols());
-    const std::size_t numPts = x.cols();
-    Mat2X residuals = Mat2X::Zero(2, numPts);
-    for(std::size_t i = 0; i < numPts; ++i)
-    {
-      residuals.col(i) = residual(pose, X.col(i), x.col(i));
-    }
-    return residuals;
+    Mat2X proj;
+    this->project(pose, X, proj);
+    return x - proj;
+  }
+
+  /**
+   * @brief Projection of 3D points into the camera plane (Apply pose, disto (if any) and Intrinsics)
+   *        with one call to the camera model per step instead of one per point
+   * @param[in] pose The pose
+   * @param[in] pts3D The 3d points, one per column
+   * @param[out] pts2D The 2d projections in the camera plane, one per column
+   * @param[in] applyDistortion If true apply distrortion if any
+   */
+  inline void project(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& pts2D, bool applyDistortion = true) const
+  {
+    const Mat3X X = pose(pts3D); // apply pose
+    pts2D.resize(2, X.cols());
+    pts2D.row(0) = X.row(0).cwiseQuotient(X.row(2));
+    pts2D.row(1) = X.row(1).cwiseQuotient(X.row(2));
+    if (applyDistortion && this->have_disto()) // apply disto
+      this->add_disto(pts2D, pts2D);
+    this->cam2ima(pts2D, pts2D); // apply intrinsics
   }
 
   /**
@@ -307,6 +322,82 @@ struct IntrinsicBase
    */
   virtual Vec2 get_d_pixel(const Vec2& p) const = 0;
 
+  // Batched versions of the point transformations.
+  // The points are stored by column, the output matrix can be the input one.
+  // The camera models override them to process all the points in one virtual call.
+
+  /**
+   * @brief Transform points from the camera plane to the image plane
+   * @param[in] points The points from the camera plane
+   * @param[out] out The image plane points
+   */
+  virtual void cam2ima(const Mat2X& points, Mat2X& out) const
+  {
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      out.col(i) = cam2ima(Vec2(points.col(i)));
+  }
+
+  /**
+   * @brief Transform points from the image plane to the camera plane
+   * @param[in] points The points from the image plane
+   * @param[out] out The camera plane points
+   */
+  virtual void ima2cam(const Mat2X& points, Mat2X& out) const
+  {
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      out.col(i) = ima2cam(Vec2(points.col(i)));
+  }
+
+  /**
+   * @brief Add the distortion field to points (that are in normalized camera frame)
+   * @param[in] points The points
+   * @param[out] out The points with added distortion field
+   */
+  virtual void add_disto(const Mat2X& points, Mat2X& out) const
+  {
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      out.col(i) = add_disto(Vec2(points.col(i)));
+  }
+
+  /**
+   * @brief Remove the distortion to camera points (that are in normalized camera frame)
+   * @param[in] points The points
+   * @param[out] out The points with removed distortion field
+   */
+  virtual void remove_disto(const Mat2X& points, Mat2X& out) const
+  {
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      out.col(i) = remove_disto(Vec2(points.col(i)));
+  }
+
+  /**
+   * @brief Return the undistorted pixels (with removed distortion)
+   * @param[in] points The pixels
+   * @param[out] out The undistorted pixels
+   */
+  virtual void get_ud_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      out.col(i) = get_ud_pixel(Vec2(points.col(i)));
+  }
+
+  /**
+   * @brief Return the distorted pixels (with added distortion)
+   * @param[in] points The undistorted pixels
+   * @param[out] out The distorted pixels
+   */
+  virtual void get_d_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      out.col(i) = get_d_pixel(Vec2(points.col(i)));
+  }
+
   /**
    * @brief Normalize a given unit pixel error to the camera plane
    * @param[in] value Given unit pixel error
@@ -98,6 +98,36 @@ class Pinhole : public IntrinsicBase
 
   virtual Vec2 remove_disto(const Vec2& p) const  { return p; }
 
+  // Transform points from the camera plane to the image plane
+  virtual void cam2ima(const Mat2X& points, Mat2X& out) const
+  {
+    const double f = focal();
+    const Vec2 pp = principal_point();
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      out(0, i) = f * points(0, i) + pp(0);
+      out(1, i) = f * points(1, i) + pp(1);
+    }
+  }
+
+  // Transform points from the image plane to the camera plane
+  virtual void ima2cam(const Mat2X& points, Mat2X& out) const
+  {
+    const double f = focal();
+    const Vec2 pp = principal_point();
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      out(0, i) = (points(0, i) - pp(0)) / f;
+      out(1, i) = (points(1, i) - pp(1)) / f;
+    }
+  }
+
+  virtual void add_disto(const Mat2X& points, Mat2X& out) const  { out = points; }
+
+  virtual void remove_disto(const Mat2X& points, Mat2X& out) const  { out = points; }
+
   virtual double imagePlane_toCameraPlaneError(double value) const
   {
     return value / focal();
@@ -160,6 +190,12 @@ class Pinhole : public IntrinsicBase
   /// Return the distorted pixel (with added distortion)
   virtual Vec2 get_d_pixel(const Vec2& p) const {return p;}
 
+  /// Return the un-distorted pixels (with removed distortion)
+  virtual void get_ud_pixel(const Mat2X& points, Mat2X& out) const {out = points;}
+
+  /// Return the distorted pixels (with added distortion)
+  virtual void get_d_pixel(const Mat2X& points, Mat2X& out) const {out = points;}
+
 private:
   // Focal & principal point are embed into the calibration matrix K
   Mat3 _K, _Kinv;
@@ -70,6 +70,53 @@ class PinholeBrownT2 : public Pinhole
       return cam2ima( add_disto(ima2cam(p)) );
     }
 
+    /// Add distortion to the points (assume they are in the camera frame [normalized coordinates])
+    virtual void add_disto(const Mat2X& points, Mat2X& out) const
+    {
+        out.resize(2, points.cols());
+        for(Mat2X::Index i = 0; i < points.cols(); ++i)
+        {
+            const Vec2 p = points.col(i);
+            out.col(i) = p + distoFunction(_distortionParams, p);
+        }
+    }
+
+    /// Remove distortion of the points, with the same iterative scheme as for a single point
+    virtual void remove_disto(const Mat2X& points, Mat2X& out) const
+    {
+        const double epsilon = 1e-8; //criteria to stop the iteration
+
+        out.resize(2, points.cols());
+        for(Mat2X::Index i = 0; i < points.cols(); ++i)
+        {
+            const Vec2 p = points.col(i);
+            Vec2 p_u = p;
+
+            while((p_u + distoFunction(_distortionParams, p_u) - p).lpNorm<1>() > epsilon)
+            {
+                p_u = p - distoFunction(_distortionParams, p_u);
+            }
+
+            out.col(i) = p_u;
+        }
+    }
+
+    /// Return the un-distorted pixels (with removed distortion)
+    virtual void get_ud_pixel(const Mat2X& points, Mat2X& out) const
+    {
+        ima2cam(points, out);
+        remove_disto(out, out);
+        cam2ima(out, out);
+    }
+
+    /// Return the distorted pixels (with added distortion)
+    virtual void get_d_pixel(const Mat2X& points, Mat2X& out) const
+    {
+        ima2cam(points, out);
+        add_disto(out, out);
+        cam2ima(out, out);
+    }
+
     private:
 
     /// Functor to calculate distortion offset accounting for both radial and tangential distortion
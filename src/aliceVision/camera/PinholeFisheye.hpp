@@ -99,6 +99,80 @@ class PinholeFisheye : public Pinhole
   {
     return cam2ima( add_disto(ima2cam(p)) );
   }
+
+  virtual void add_disto(const Mat2X& points, Mat2X& out) const
+  {
+    const double eps = 1e-8;
+    const double k1 = _distortionParams.at(0), k2 = _distortionParams.at(1), k3 = _distortionParams.at(2), k4 = _distortionParams.at(3);
+
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double x = points(0, i), y = points(1, i);
+      const double r = std::hypot(x, y);
+      const double theta = std::atan(r);
+      const double
+        theta2 = theta*theta,
+        theta3 = theta2*theta,
+        theta4 = theta2*theta2,
+        theta5 = theta4*theta,
+        theta6 = theta3*theta3,
+        theta7 = theta6*theta,
+        theta8 = theta4*theta4,
+        theta9 = theta8*theta;
+      const double theta_dist = theta + k1*theta3 + k2*theta5 + k3*theta7 + k4*theta9;
+      const double inv_r = r > eps ? 1.0/r : 1.0;
+      const double cdist = r > eps ? theta_dist * inv_r : 1.0;
+      out(0, i) = x * cdist;
+      out(1, i) = y * cdist;
+    }
+  }
+
+  virtual void remove_disto(const Mat2X& points, Mat2X& out) const
+  {
+    const double eps = 1e-8;
+    const double k1 = _distortionParams.at(0), k2 = _distortionParams.at(1), k3 = _distortionParams.at(2), k4 = _distortionParams.at(3);
+
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double x = points(0, i), y = points(1, i);
+      double scale = 1.0;
+      const double theta_dist = std::hypot(x, y);
+      if (theta_dist > eps)
+      {
+        double theta = theta_dist;
+        for (int j = 0; j < 10; ++j)
+        {
+          const double
+            theta2 = theta*theta,
+            theta4 = theta2*theta2,
+            theta6 = theta4*theta2,
+            theta8 = theta6*theta2;
+          theta = theta_dist / (1 + k1 * theta2 + k2 * theta4 + k3 * theta6 + k4 * theta8);
+        }
+        scale = std::tan(theta) / theta_dist;
+      }
+      out(0, i) = x * scale;
+      out(1, i) = y * scale;
+    }
+  }
+
+  /// Return the un-distorted pixels (with removed distortion)
+  virtual void get_ud_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    ima2cam(points, out);
+    remove_disto(out, out);
+    cam2ima(out, out);
+  }
+
+  /// Return the distorted pixels (with added distortion)
+  virtual void get_d_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    ima2cam(points, out);
+    add_disto(out, out);
+    cam2ima(out, out);
+  }
 };
 
 } // namespace camera
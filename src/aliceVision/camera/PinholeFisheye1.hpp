@@ -68,6 +68,54 @@ public:
   {
     return cam2ima( add_disto(ima2cam(p)) );
   }
+
+  virtual void add_disto(const Mat2X& points, Mat2X& out) const
+  {
+    const double k1 = _distortionParams.at(0);
+    const double tanHalfK1 = std::tan(0.5 * k1);
+
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double x = points(0, i), y = points(1, i);
+      const double r = std::hypot(x, y);
+      const double coef = (std::atan(2.0 * r * tanHalfK1) / k1) / r;
+      out(0, i) = x * coef;
+      out(1, i) = y * coef;
+    }
+  }
+
+  virtual void remove_disto(const Mat2X& points, Mat2X& out) const
+  {
+    const double k1 = _distortionParams.at(0);
+    const double tanHalfK1 = std::tan(0.5 * k1);
+
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double x = points(0, i), y = points(1, i);
+      const double r = std::hypot(x, y);
+      const double coef = 0.5 * std::tan(r * k1) / (tanHalfK1 * r);
+      out(0, i) = x * coef;
+      out(1, i) = y * coef;
+    }
+  }
+
+  /// Return the un-distorted pixels (with removed distortion)
+  virtual void get_ud_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    ima2cam(points, out);
+    remove_disto(out, out);
+    cam2ima(out, out);
+  }
+
+  /// Return the distorted pixels (with added distortion)
+  virtual void get_d_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    ima2cam(points, out);
+    add_disto(out, out);
+    cam2ima(out, out);
+  }
 };
 
 } // namespace camera
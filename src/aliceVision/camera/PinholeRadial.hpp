@@ -102,6 +102,47 @@ class PinholeRadialK1 : public Pinhole
     return cam2ima( add_disto(ima2cam(p)) );
   }
 
+  /// Add distortion to the points (assume they are in the camera frame [normalized coordinates])
+  virtual void add_disto(const Mat2X& points, Mat2X& out) const
+  {
+    const double k1 = _distortionParams.at(0);
+
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double x = points(0, i), y = points(1, i);
+      const double r2 = x*x + y*y;
+      const double r_coeff = (1. + k1*r2);
+
+      out(0, i) = x * r_coeff;
+      out(1, i) = y * r_coeff;
+    }
+  }
+
+  /// Remove distortion of the points
+  virtual void remove_disto(const Mat2X& points, Mat2X& out) const
+  {
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      out.col(i) = PinholeRadialK1::remove_disto(Vec2(points.col(i)));
+  }
+
+  /// Return the un-distorted pixels (with removed distortion)
+  virtual void get_ud_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    ima2cam(points, out);
+    remove_disto(out, out);
+    cam2ima(out, out);
+  }
+
+  /// Return the distorted pixels (with added distortion)
+  virtual void get_d_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    ima2cam(points, out);
+    add_disto(out, out);
+    cam2ima(out, out);
+  }
+
   private:
 
   /// Functor to solve Square(disto(radius(p'))) = r^2
@@ -170,6 +211,49 @@ class PinholeRadialK3 : public Pinhole
     return cam2ima( add_disto(ima2cam(p)) );
   }
 
+  /// Add distortion to the points (assume they are in the camera frame [normalized coordinates])
+  virtual void add_disto(const Mat2X& points, Mat2X& out) const
+  {
+    const double k1 = _distortionParams[0], k2 = _distortionParams[1], k3 = _distortionParams[2];
+
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double x = points(0, i), y = points(1, i);
+      const double r2 = x*x + y*y;
+      const double r4 = r2 * r2;
+      const double r6 = r4 * r2;
+      const double r_coeff = (1. + k1*r2 + k2*r4 + k3*r6);
+
+      out(0, i) = x * r_coeff;
+      out(1, i) = y * r_coeff;
+    }
+  }
+
+  /// Remove distortion of the points
+  virtual void remove_disto(const Mat2X& points, Mat2X& out) const
+  {
+    out.resize(2, points.cols());
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      out.col(i) = PinholeRadialK3::remove_disto(Vec2(points.col(i)));
+  }
+
+  /// Return the un-distorted pixels (with removed distortion)
+  virtual void get_ud_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    ima2cam(points, out);
+    remove_disto(out, out);
+    cam2ima(out, out);
+  }
+
+  /// Return the distorted pixels (with added distortion)
+  virtual void get_d_pixel(const Mat2X& points, Mat2X& out) const
+  {
+    ima2cam(points, out);
+    add_disto(out, out);
+    cam2ima(out, out);
+  }
+
   private:
 
   /// Functor to solve Square(disto(radius(p'))) = r^2
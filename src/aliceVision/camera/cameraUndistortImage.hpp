@@ -15,7 +15,16 @@
 #include <aliceVision/camera/IntrinsicBase.hpp>
 #include <aliceVision/camera/Pinhole.hpp>
 
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
 
 namespace aliceVision {
 namespace camera {
@@ -66,6 +75,189 @@ void UndistortImage(
   }
 }
 
+/**
+ * @brief Distorted coordinates of each pixel of the undistorted image of a camera.
+ *
+ * The map is computed once per intrinsic and image size and reused for all the images of the camera:
+ * the undistortion is then a gather of the inputs pixels.
+ * The coordinates are stored in fixed point with a precision of 1/1024 pixel.
+ */
+class UndistortionMap
+{
+public:
+  UndistortionMap() = default;
+
+  /**
+   * @brief Compute the map of a camera
+   * @param[in] intrinsicPtr The camera intrinsic
+   * @param[in] width The images width
+   * @param[in] height The images height
+   * @param[in] correctPrincipalPoint Move the principal point to the center of the undistorted image
+   */
+  UndistortionMap(const IntrinsicBase* intrinsicPtr, int width, int height, bool correctPrincipalPoint = false)
+  {
+    compute(intrinsicPtr, width, height, correctPrincipalPoint);
+  }
+
+  /**
+   * @brief Compute the map of a camera
+   * @param[in] intrinsicPtr The camera intrinsic
+   * @param[in] width The images width
+   * @param[in] height The images height
+   * @param[in] correctPrincipalPoint Move the principal point to the center of the undistorted image
+   */
+  void compute(const IntrinsicBase* intrinsicPtr, int width, int height, bool correctPrincipalPoint = false)
+  {
+    const Vec2 center(width * 0.5, height * 0.5);
+    Vec2 ppCorrection(0.0, 0.0);
+
+    if(correctPrincipalPoint)
+    {
+      if(camera::isPinhole(intrinsicPtr->getType()))
+      {
+        const camera::Pinhole* pinholePtr = dynamic_cast<const camera::Pinhole*>(intrinsicPtr);
+        ppCorrection = pinholePtr->principal_point() - center;
+      }
+    }
+
+    _width = width;
+    _height = height;
+    _coords.resize(2 * static_cast<std::size_t>(width) * height);
+
+    #pragma omp parallel for
+    for(int j = 0; j < height; ++j)
+    {
+      Mat2X undistoPix(2, width);
+      Mat2X distoPix;
+      for(int i = 0; i < width; ++i)
+        undistoPix.col(i) = Vec2(i, j);
+
+      // compute coordinates with distortion, one call for the whole row
+      intrinsicPtr->get_d_pixel(undistoPix, distoPix);
+
+      std::int32_t* coords = &_coords[2 * static_cast<std::size_t>(j) * width];
+      for(int i = 0; i < width; ++i)
+      {
+        const Vec2 p = distoPix.col(i) + ppCorrection;
+
+        // same image domain test as the sampling of the input image
+        if(0 <= int(p(0)) && int(p(0)) < width && 0 <= int(p(1)) && int(p(1)) < height)
+        {
+          coords[2 * i] = static_cast<std::int32_t>(std::lround(p(0) * _precision));
+          coords[2 * i + 1] = static_cast<std::int32_t>(std::lround(p(1) * _precision));
+        }
+        else
+        {
+          coords[2 * i] = _outside;
+          coords[2 * i + 1] = _outside;
+        }
+      }
+    }
+  }
+
+  inline int width() const { return _width; }
+  inline int height() const { return _height; }
+
+  /**
+   * @brief Undistort an image of the camera
+   * @param[in] imageIn The distorted image, of the size of the map
+   * @param[out] image_ud The undistorted image
+   * @param[in] fillcolor The color of the pixels out of the input image
+   */
+  template <typename T>
+  void apply(const image::Image<T>& imageIn, image::Image<T>& image_ud, T fillcolor) const
+  {
+    if(imageIn.Width() != _width || imageIn.Height() != _height)
+      throw std::invalid_argument("UndistortionMap: image size (" + std::to_string(imageIn.Width()) + "x" + std::to_string(imageIn.Height()) +
+                                  ") does not match the map size (" + std::to_string(_width) + "x" + std::to_string(_height) + ").");
+
+    image_ud.resize(_width, _height, true, fillcolor);
+    const image::Sampler2d<image::SamplerLinear> sampler;
+    const float invPrecision = 1.f / _precision;
+
+    #pragma omp parallel for
+    for(int j = 0; j < _height; ++j)
+    {
+      const std::int32_t* coords = &_coords[2 * static_cast<std::size_t>(j) * _width];
+      for(int i = 0; i < _width; ++i)
+      {
+        if(coords[2 * i] != _outside)
+          image_ud(j, i) = sampler(imageIn, coords[2 * i + 1] * invPrecision, coords[2 * i] * invPrecision);
+      }
+    }
+  }
+
+private:
+  /// fixed point scale of the coordinates
+  static constexpr double _precision = 1024.0;
+  /// marker of the pixels out of the input image
+  static constexpr std::int32_t _outside = std::numeric_limits<std::int32_t>::min();
+
+  int _width = 0;
+  int _height = 0;
+  /// distorted coordinates (x, y) of each pixel, row by row
+  std::vector<std::int32_t> _coords;
+};
+
+/**
+ * @brief Undistortion maps of the cameras, computed at their first use.
+ * The maps are identified by the intrinsic hash, the images size and the principal point correction.
+ * It can be used from several threads.
+ */
+class UndistortionMapCache
+{
+public:
+  /**
+   * @brief Get the undistortion map of a camera, compute it if needed
+   * @param[in] intrinsicPtr The camera intrinsic
+   * @param[in] width The images width
+   * @param[in] height The images height
+   * @param[in] correctPrincipalPoint Move the principal point to the center of the undistorted image
+   * @return The undistortion map
+   */
+  const UndistortionMap& get(const IntrinsicBase* intrinsicPtr, int width, int height, bool correctPrincipalPoint = false)
+  {
+    const auto key = std::make_tuple(intrinsicPtr->hashValue(), width, height, correctPrincipalPoint);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unique_ptr<UndistortionMap>& map = _maps[key];
+    if(!map)
+      map.reset(new UndistortionMap(intrinsicPtr, width, height, correctPrincipalPoint));
+    return *map;
+  }
+
+  /// Release the maps
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maps.clear();
+  }
+
+private:
+  std::mutex _mutex;
+  std::map<std::tuple<std::size_t, int, int, bool>, std::unique_ptr<UndistortionMap>> _maps;
+};
+
+/// Undistort an image according a given camera and its distortion model,
+/// with the undistortion map of the camera taken from the cache (and computed at its first use)
+template <typename T>
+void UndistortImage(
+  const image::Image<T>& imageIn,
+  const camera::IntrinsicBase* intrinsicPtr,
+  image::Image<T>& image_ud,
+  T fillcolor,
+  UndistortionMapCache& mapCache,
+  bool correctPrincipalPoint = false)
+{
+  if (!intrinsicPtr->have_disto()) // no distortion, perform a direct copy
+  {
+    image_ud = imageIn;
+    return;
+  }
+  const UndistortionMap& map = mapCache.get(intrinsicPtr, imageIn.Width(), imageIn.Height(), correctPrincipalPoint);
+  map.apply(imageIn, image_ud, fillcolor);
+}
+
 } // namespace camera
 } // namespace aliceVision
 
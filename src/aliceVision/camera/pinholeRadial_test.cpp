@@ -78,3 +78,95 @@ BOOST_AUTO_TEST_CASE(cameraPinholeRadial_disto_undisto_K3) {
     BOOST_CHECK(! (cam.add_disto(ptCamera) == cam.remove_disto(cam.add_disto(ptCamera))) ) ;
   }
 }
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a PinholeRadialK1 camera
+// - Generate random points inside the image domain
+// - Assert that the batched transformations give the same points as the single point ones
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraPinholeRadialK1_batch) {
+
+  const PinholeRadialK1 cam(1000, 1000, 1000, 500, 500,
+    // K1
+    0.1);
+  const IntrinsicBase& intrinsic = cam;
+
+  const int nbPoints = 10;
+  const Mat2X ptsImage = (Mat2X::Random(2, nbPoints) * 800./2.).colwise() + Vec2(500,500);
+  const Mat3X pts3D = (Mat3X::Random(3, nbPoints).colwise() + Vec3(0., 0., 5.));
+  const geometry::Pose3 pose(RotationAroundY(0.1), Vec3(0.1, -0.2, 0.3));
+
+  Mat2X ptsCamera, ptsDisto, ptsUndisto, ptsUdPixel, ptsDPixel, ptsProj;
+  intrinsic.ima2cam(ptsImage, ptsCamera);
+  intrinsic.add_disto(ptsCamera, ptsDisto);
+  intrinsic.remove_disto(ptsCamera, ptsUndisto);
+  intrinsic.get_ud_pixel(ptsImage, ptsUdPixel);
+  intrinsic.get_d_pixel(ptsImage, ptsDPixel);
+  intrinsic.project(pose, pts3D, ptsProj);
+
+  const double epsilon = 1e-10;
+  for(int i = 0; i < nbPoints; ++i)
+  {
+    const Vec2 ptImage = ptsImage.col(i);
+    const Vec2 ptCamera = cam.ima2cam(ptImage);
+    EXPECT_MATRIX_NEAR( ptCamera, ptsCamera.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.add_disto(ptCamera), ptsDisto.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.remove_disto(ptCamera), ptsUndisto.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.get_ud_pixel(ptImage), ptsUdPixel.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.get_d_pixel(ptImage), ptsDPixel.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.project(pose, pts3D.col(i)), ptsProj.col(i), epsilon);
+  }
+
+  // the output can be the input matrix
+  Mat2X pts = ptsCamera;
+  intrinsic.add_disto(pts, pts);
+  EXPECT_MATRIX_NEAR( ptsDisto, pts, epsilon);
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a PinholeRadialK3 camera
+// - Generate random points inside the image domain
+// - Assert that the batched transformations give the same points as the single point ones
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraPinholeRadialK3_batch) {
+
+  const PinholeRadialK3 cam(1000, 1000, 1000, 500, 500,
+    // K1, K2, K3
+    -0.245539, 0.255195, 0.163773);
+  const IntrinsicBase& intrinsic = cam;
+
+  const int nbPoints = 10;
+  const Mat2X ptsImage = (Mat2X::Random(2, nbPoints) * 800./2.).colwise() + Vec2(500,500);
+  const Mat3X pts3D = (Mat3X::Random(3, nbPoints).colwise() + Vec3(0., 0., 5.));
+  const geometry::Pose3 pose(RotationAroundY(0.1), Vec3(0.1, -0.2, 0.3));
+
+  Mat2X ptsCamera, ptsDisto, ptsUndisto, ptsUdPixel, ptsDPixel, ptsProj;
+  intrinsic.ima2cam(ptsImage, ptsCamera);
+  intrinsic.add_disto(ptsCamera, ptsDisto);
+  intrinsic.remove_disto(ptsCamera, ptsUndisto);
+  intrinsic.get_ud_pixel(ptsImage, ptsUdPixel);
+  intrinsic.get_d_pixel(ptsImage, ptsDPixel);
+  intrinsic.project(pose, pts3D, ptsProj);
+
+  const double epsilon = 1e-10;
+  for(int i = 0; i < nbPoints; ++i)
+  {
+    const Vec2 ptImage = ptsImage.col(i);
+    const Vec2 ptCamera = cam.ima2cam(ptImage);
+    EXPECT_MATRIX_NEAR( ptCamera, ptsCamera.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.add_disto(ptCamera), ptsDisto.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.remove_disto(ptCamera), ptsUndisto.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.get_ud_pixel(ptImage), ptsUdPixel.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.get_d_pixel(ptImage), ptsDPixel.col(i), epsilon);
+    EXPECT_MATRIX_NEAR( cam.project(pose, pts3D.col(i)), ptsProj.col(i), epsilon);
+  }
+
+  // the output can be the input matrix
+  Mat2X pts = ptsCamera;
+  intrinsic.add_disto(pts, pts);
+  EXPECT_MATRIX_NEAR( ptsDisto, pts, epsilon);
+}
@@ -0,0 +1,67 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/camera/cameraUndistortImage.hpp>
+
+#define BOOST_TEST_MODULE undistortionMap
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a PinholeRadialK3 camera and a random image
+// - Undistort the image with the undistortion map of the camera and with the per pixel computation
+// - Assert that both undistorted images are the same (up to the map precision)
+// - Assert that the map is computed once per intrinsic and principal point correction
+//-----------------
+BOOST_AUTO_TEST_CASE(undistortionMap_sameAsPerPixel) {
+
+  const PinholeRadialK3 cam(200, 100, 150, 105, 48,
+    // K1, K2, K3
+    -0.245539, 0.255195, 0.163773);
+
+  image::Image<float> image(200, 100);
+  for(int j = 0; j < image.Height(); ++j)
+    for(int i = 0; i < image.Width(); ++i)
+      image(j, i) = std::sin(i * 0.1f) * std::cos(j * 0.07f);
+
+  UndistortionMapCache mapCache;
+
+  for(bool correctPrincipalPoint : {false, true})
+  {
+    image::Image<float> imageUd, imageUdMap;
+    UndistortImage(image, &cam, imageUd, -10.f, correctPrincipalPoint);
+    UndistortImage(image, &cam, imageUdMap, -10.f, mapCache, correctPrincipalPoint);
+
+    BOOST_CHECK_EQUAL(imageUd.Width(), imageUdMap.Width());
+    BOOST_CHECK_EQUAL(imageUd.Height(), imageUdMap.Height());
+
+    int nbFilled = 0;
+    for(int j = 0; j < image.Height(); ++j)
+      for(int i = 0; i < image.Width(); ++i)
+      {
+        BOOST_CHECK_SMALL(imageUd(j, i) - imageUdMap(j, i), 1e-3f);
+        if(imageUdMap(j, i) != -10.f)
+          ++nbFilled;
+      }
+    // ensure that the test does not compare two empty images
+    BOOST_CHECK(nbFilled > image.Width() * image.Height() / 2);
+  }
+
+  // the maps are cached: the same map is returned for the same camera and size
+  const UndistortionMap& map = mapCache.get(&cam, 200, 100);
+  BOOST_CHECK_EQUAL(&map, &mapCache.get(&cam, 200, 100));
+  BOOST_CHECK_NE(&map, &mapCache.get(&cam, 200, 100, true));
+
+  // an image of an other size can't be undistorted with the map
+  image::Image<float> imageUd;
+  BOOST_CHECK_THROW(map.apply(image::Image<float>(100, 100), imageUd, 0.f), std::invalid_argument);
+}
@@ -60,6 +60,35 @@ public:
     }
   }
 
+  /**
+   * Compute the Histograms of the 3 color channels for the masked data, in one pass over the image
+   *
+   * \param[in] mask Binary image to determine acceptable zones
+   * \param[in] image Image with RGB or LAB type
+   * \param[out] histos Histograms of the red, green and blue channels.
+   *
+   */
+  template< typename ImageType >
+  static void computeHistos(
+    Histogram< double > (& histos)[3],
+    const image::Image< unsigned char >& mask,
+    const image::Image< ImageType >& image )
+  {
+    for(int j = 0; j < mask.Height(); ++j)
+    {
+      for(int i = 0; i < mask.Width(); ++i)
+      {
+        if((int)mask(j,i) != 0)
+        {
+          const ImageType& pixel = image(j,i);
+          histos[0].Add(pixel(0));
+          histos[1].Add(pixel(1));
+          histos[2].Add(pixel(2));
+        }
+      }
+    }
+  }
+
   const std::string & getLeftImage()const{ return _sLeftImage; }
   const std::string & getRightImage()const{ return _sRightImage; }
 
@@ -104,8 +104,9 @@ class CommonDataByPair_vldSegment  : public CommonDataByPair
 
 private:
   // Left and Right features
-  const std::vector<feature::SIOPointFeature>& _featsL;
-  const std::vector<feature::SIOPointFeature>& _featsR;
+  // (copied: the features are often extracted from the regions in a temporary)
+  const std::vector<feature::SIOPointFeature> _featsL;
+  const std::vector<feature::SIOPointFeature> _featsR;
   // Left and Right corresponding index (putatives matches)
   matching::IndMatches _matches;
 };
@@ -41,7 +41,7 @@ namespace histogram {
 template<typename T>
 inline void normalizeHisto(const std::vector<T> & vec_df, std::vector<double> & vec_normalized_df)
 {
-  double totalCount = static_cast<double>(std::accumulate(vec_df.begin(), vec_df.end(), 0));
+  double totalCount = static_cast<double>(std::accumulate(vec_df.begin(), vec_df.end(), static_cast<T>(0)));
   vec_normalized_df.resize(vec_df.size(), 0.0);
   for(std::size_t i=0; i<vec_df.size(); ++i)
     vec_normalized_df[i] = vec_df[i] / totalCount;
@@ -7,6 +7,7 @@
 #include "VideoFeed.hpp"
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/RingBuffer.hpp>
 #include <aliceVision/image/convertion.hpp>
 
 #include <opencv2/core.hpp>
@@ -16,6 +17,8 @@
 
 #include <iostream>
 #include <exception>
+#include <cassert>
+#include <thread>
 
 namespace aliceVision{
 namespace dataio{
@@ -28,6 +31,8 @@ public:
   FeederImpl(const std::string &videoPath, const std::string &calibPath);
   
   FeederImpl(int videoDevice, const std::string &calibPath);
+
+  ~FeederImpl();
   
   bool isInit() const {return _isInit;}
   
@@ -53,12 +58,51 @@ public:
   std::size_t nbFrames() const;
   
 private:
+
+  /**
+   * @brief Decode the frame following the video capture position
+   * @param[out] frame The decoded frame (BGR or gray)
+   * @return false at the end of the video
+   */
+  bool decodeNextFrame(cv::Mat &frame);
+
+  /**
+   * @brief Start decoding the frames following the current one in the decode-ahead thread
+   */
+  void startPrefetch();
+
+  /**
+   * @brief Stop the decode-ahead thread, the video capture is then at an undefined position
+   */
+  void stopPrefetch();
+
+  /**
+   * @brief Get the current frame and its intrinsics
+   * @return false if there is no current frame
+   */
+  bool getCurrentFrame(camera::PinholeRadialK3 &camIntrinsics,
+                       std::string &mediaPath,
+                       bool &hasIntrinsics) const;
+
   bool _isInit;
   bool _isLive;
   bool _withIntrinsics;
   std::string _videoPath;
   cv::VideoCapture _videoCapture;
   camera::PinholeRadialK3 _camIntrinsics;
+  /// Number of frames of the video, read once as the capture is used by the decode-ahead thread
+  std::size_t _nbFrames = 0;
+
+  /// Number of frames decoded ahead of the current frame (not for live feeds)
+  static const std::size_t _nbPrefetchFrames = 8;
+  /// Current decoded frame
+  cv::Mat _currentFrame;
+  /// Current frame index in the video
+  std::size_t _currentFrameIndex = 0;
+  /// Frames decoded ahead of the current frame
+  std::unique_ptr<system::RingBuffer<cv::Mat>> _prefetchQueue;
+  /// Decode-ahead thread, the only user of the video capture while it runs
+  std::thread _prefetchThread;
 };
 
 
@@ -66,12 +110,19 @@ VideoFeed::FeederImpl::FeederImpl(const std::string &videoPath, const std::strin
 : _isInit(false), _isLive(false), _withIntrinsics(false), _videoPath(videoPath)
 {
     // load the video
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 || (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 2)))
+  // use the hardware decoder of the backend if any (NVDEC, VAAPI, ...), software decoding otherwise
+  _videoCapture.open(videoPath, cv::CAP_ANY, {cv::CAP_PROP_HW_ACCELERATION, cv::VIDEO_ACCELERATION_ANY});
+#else
   _videoCapture.open(videoPath);
+#endif
   if (!_videoCapture.isOpened())
   {
     ALICEVISION_LOG_WARNING("Unable to open the video : " << videoPath);
     throw std::invalid_argument("Unable to open the video : "+videoPath);
   }
+  _nbFrames = _videoCapture.get(cv::CAP_PROP_FRAME_COUNT);
+
   // Grab frame 0, so we can call readImage.
   goToFrame(0);
 
@@ -104,48 +155,79 @@ VideoFeed::FeederImpl::FeederImpl(int videoDevice, const std::string &calibPath)
   _isInit = true;
 }
 
+VideoFeed::FeederImpl::~FeederImpl()
+{
+  stopPrefetch();
+}
+
+bool VideoFeed::FeederImpl::decodeNextFrame(cv::Mat &frame)
+{
+  frame.release(); // never decode in a frame shared with a previous one
+  return _videoCapture.grab() && _videoCapture.retrieve(frame) && frame.data;
+}
+
+void VideoFeed::FeederImpl::startPrefetch()
+{
+  assert(!_prefetchThread.joinable());
+
+  _prefetchQueue.reset(new system::RingBuffer<cv::Mat>(_nbPrefetchFrames));
+  _prefetchThread = std::thread([this]()
+  {
+    cv::Mat frame;
+    while(decodeNextFrame(frame))
+    {
+      if(!_prefetchQueue->push(frame))
+        return; // stopped
+    }
+    _prefetchQueue->close(); // end of the video
+  });
+}
+
+void VideoFeed::FeederImpl::stopPrefetch()
+{
+  if(!_prefetchThread.joinable())
+    return;
+
+  _prefetchQueue->close();
+  _prefetchThread.join();
+  _prefetchQueue.reset();
+}
+
+bool VideoFeed::FeederImpl::getCurrentFrame(camera::PinholeRadialK3 &camIntrinsics,
+                                            std::string &mediaPath,
+                                            bool &hasIntrinsics) const
+{
+  if(!_currentFrame.data)
+    return false;
+
+  hasIntrinsics = _withIntrinsics;
+  if(_withIntrinsics)
+    camIntrinsics = _camIntrinsics;
+
+  mediaPath = _videoPath;
+  return true;
+}
+
 bool VideoFeed::FeederImpl::readImage(image::Image<image::RGBColor> &imageRGB,
           camera::PinholeRadialK3 &camIntrinsics,
           std::string &mediaPath,
           bool &hasIntrinsics)
 {
-  cv::Mat frame;
-  const bool grabStatus = _videoCapture.retrieve(frame);
+  static_assert(sizeof(image::RGBColor) == 3, "RGBColor pixels must be packed");
 
-  if(!grabStatus || !frame.data)
-  {
+  if(!getCurrentFrame(camIntrinsics, mediaPath, hasIntrinsics))
     return false;
-  }
-  
-  if(frame.channels() == 3)
-  {
-    cv::Mat color;
-    resize(frame, color, cv::Size(frame.cols, frame.rows));
-    
-    cv::cvtColor(frame, color, cv::COLOR_BGR2RGB);
-    imageRGB.resize(color.cols, color.rows);
-    
-    unsigned char* pixelPtr = (unsigned char*)color.data;
-    for(int i = 0; i < color.rows; i++)
-    {
-      for(int j = 0; j < color.cols; j++)
-      {
-        const size_t index = i*color.cols*3 + j*3;
-        imageRGB(i,j) = image::RGBColor(pixelPtr[index], pixelPtr[index + 1], pixelPtr[index + 2]);
-      }
-    }
-  }
-  else
+
+  if(_currentFrame.channels() != 3)
   {
     ALICEVISION_LOG_WARNING("Error can't read RGB frame " << _videoPath);
     throw std::invalid_argument("Error can't read RGB frame " + _videoPath);
   }
-  
-  hasIntrinsics = _withIntrinsics;
-  if(_withIntrinsics)
-    camIntrinsics = _camIntrinsics;
 
-  mediaPath = _videoPath;
+  // convert directly in the image buffer
+  imageRGB.resize(_currentFrame.cols, _currentFrame.rows);
+  cv::Mat color(_currentFrame.rows, _currentFrame.cols, CV_8UC3, imageRGB.data());
+  cv::cvtColor(_currentFrame, color, cv::COLOR_BGR2RGB);
   return true;
 }
 
@@ -154,13 +236,18 @@ bool VideoFeed::FeederImpl::readImage(image::Image<float> &imageGray,
           std::string &mediaPath,
           bool &hasIntrinsics)
 {
-  image::Image<unsigned char> imageGrayUChar;
-  if(FeederImpl::readImage(imageGrayUChar, camIntrinsics, mediaPath, hasIntrinsics))
-  {
-    imageGray = (imageGrayUChar.GetMat().cast<float>() / 255.f);
-    return true;
-  }
-  return false;
+  if(!getCurrentFrame(camIntrinsics, mediaPath, hasIntrinsics))
+    return false;
+
+  cv::Mat grey = _currentFrame;
+  if(_currentFrame.channels() == 3)
+    cv::cvtColor(_currentFrame, grey, cv::COLOR_BGR2GRAY);
+
+  // convert directly in the image buffer
+  imageGray.resize(grey.cols, grey.rows);
+  cv::Mat greyFloat(grey.rows, grey.cols, CV_32FC1, imageGray.data());
+  grey.convertTo(greyFloat, CV_32F, 1.0 / 255.0);
+  return true;
 }
 
 
@@ -169,34 +256,18 @@ bool VideoFeed::FeederImpl::readImage(image::Image<unsigned char> &imageGray,
                    std::string &mediaPath,
                    bool &hasIntrinsics)
 {
-  cv::Mat frame;
-  const bool grabStatus = _videoCapture.retrieve(frame);
-
-  if(!grabStatus || !frame.data)
-  {
+  if(!getCurrentFrame(camIntrinsics, mediaPath, hasIntrinsics))
     return false;
-  }
-  
-  if(frame.channels() == 3)
-  {
-    // convert to gray
-    cv::Mat grey;
-    cv::cvtColor(frame, grey, cv::COLOR_BGR2GRAY);
-    imageGray.resize(grey.cols, grey.rows);
-    cv::cv2eigen(grey, imageGray);
-//      ALICEVISION_LOG_DEBUG(grey.channels() << " " << grey.rows << " " << grey.cols);
-//      ALICEVISION_LOG_DEBUG(imageGray.Depth() << " " << imageGray.Height() << " " << imageGray.Width());
-  }
-  else
-  {
-    cv::cv2eigen(frame, imageGray);
-  }
 
-  hasIntrinsics = _withIntrinsics;
-  if(_withIntrinsics)
-    camIntrinsics = _camIntrinsics;
+  // convert directly in the image buffer
+  imageGray.resize(_currentFrame.cols, _currentFrame.rows);
+  cv::Mat grey(_currentFrame.rows, _currentFrame.cols, CV_8UC1, imageGray.data());
+
+  if(_currentFrame.channels() == 3)
+    cv::cvtColor(_currentFrame, grey, cv::COLOR_BGR2GRAY);
+  else
+    _currentFrame.copyTo(grey);
 
-  mediaPath = _videoPath;
   return true;
 }
 
@@ -204,7 +275,9 @@ std::size_t VideoFeed::FeederImpl::nbFrames() const
 {
   if (!_videoCapture.isOpened())
     return 0;
-  return _videoCapture.get(cv::CAP_PROP_FRAME_COUNT);
+  if(_isLive)
+    return _videoCapture.get(cv::CAP_PROP_FRAME_COUNT);
+  return _nbFrames;
 }
 
 bool VideoFeed::FeederImpl::goToFrame(const unsigned int frame)
@@ -217,24 +290,50 @@ bool VideoFeed::FeederImpl::goToFrame(const unsigned int frame)
   
   if(_isLive)
     return goToNextFrame();
-  
-  if(frame > 0)
+
+  // already the current frame
+  if(frame == _currentFrameIndex && _currentFrame.data)
+    return (frame > 0);
+
+  // the next frames are already decoded, skip them instead of seeking
+  if(_prefetchThread.joinable() && frame > _currentFrameIndex && frame <= _currentFrameIndex + _nbPrefetchFrames)
   {
-    _videoCapture.set(cv::CAP_PROP_POS_FRAMES, frame);
-    _videoCapture.grab();
+    while(_currentFrameIndex < frame)
+    {
+      if(!goToNextFrame())
+        return false;
+    }
     return true;
   }
-  else
-  {
-    _videoCapture.set(cv::CAP_PROP_POS_FRAMES, 0);
-    _videoCapture.grab();
-    return false;
-  }
+
+  stopPrefetch();
+
+  _videoCapture.set(cv::CAP_PROP_POS_FRAMES, frame);
+  decodeNextFrame(_currentFrame);
+  _currentFrameIndex = frame;
+
+  startPrefetch();
+
+  return (frame > 0);
 }
 
 bool VideoFeed::FeederImpl::goToNextFrame()
 {
-  return _videoCapture.grab();
+  if(_isLive)
+    return decodeNextFrame(_currentFrame);
+
+  if(!_prefetchQueue)
+    return false;
+
+  ++_currentFrameIndex;
+
+  if(!_prefetchQueue->pop(_currentFrame))
+  {
+    // end of the video
+    _currentFrame.release();
+    return false;
+  }
+  return true;
 }
 
 /*******************************************************************************/
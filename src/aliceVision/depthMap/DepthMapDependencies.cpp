@@ -0,0 +1,215 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DepthMapDependencies.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/stl/hash.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace bfs = boost::filesystem;
+
+namespace {
+
+/// version of the manifest content, to recompute the depth maps when it changes
+const int manifestVersion = 1;
+
+/**
+ * @brief Parameters without effect on the depth maps.
+ */
+bool isIgnoredParameter(const std::string& key)
+{
+    return key == "images_cache" ||
+           key == "refineRc.num_gpus_to_use" ||
+           key == "global.verbose" ||
+           key == "depthMap.intermediateResults" ||
+           key == "depthMap.deviceProfile";
+}
+
+void hashParameters(std::size_t& seed, const bpt::ptree& tree, const std::string& path)
+{
+    for(const auto& child : tree)
+    {
+        const std::string key = path.empty() ? child.first : path + "." + child.first;
+        if(isIgnoredParameter(key))
+            continue;
+        stl::hash_combine(seed, key);
+        stl::hash_combine(seed, child.second.data());
+        hashParameters(seed, child.second, key);
+    }
+}
+
+std::string viewIdsToString(const mvsUtils::MultiViewParams& mp, const StaticVector<int>& cams)
+{
+    std::ostringstream s;
+    for(int c = 0; c < cams.size(); ++c)
+        s << (c > 0 ? " " : "") << mp.getViewId(cams[c]);
+    return s.str();
+}
+
+} // namespace
+
+DepthMapDependencies::DepthMapDependencies(const mvsUtils::MultiViewParams& mp)
+    : _mp(mp)
+    , _nbSgmTCams(mp.userParams.get<int>("semiGlobalMatching.maxTCams", 10))
+    , _nbRefineTCams(mp.userParams.get<int>("refineRc.maxTCams", 6))
+{
+    hashParameters(_parametersHash, mp.userParams, "");
+    // the SGM scale and step are deduced from the largest image if not set
+    stl::hash_combine(_parametersHash, mp.getMaxImageWidth());
+    stl::hash_combine(_parametersHash, mp.getMaxImageHeight());
+
+    std::map<IndexT, int> indexPerViewId;
+    for(int cam = 0; cam < mp.ncams; ++cam)
+        indexPerViewId[mp.getViewId(cam)] = cam;
+
+    // sum of the landmark hashes, independent of the landmarks order
+    _landmarksHashes.assign(mp.ncams, 0);
+    for(const auto& landmarkPair : mp.getInputSfMData().getLandmarks())
+    {
+        std::size_t landmarkHash = 0;
+        stl::hash_combine(landmarkHash, landmarkPair.first);
+        for(int i = 0; i < 3; ++i)
+            stl::hash_combine(landmarkHash, landmarkPair.second.X(i));
+
+        for(const auto& observationPair : landmarkPair.second.observations)
+        {
+            const auto it = indexPerViewId.find(observationPair.first);
+            if(it != indexPerViewId.end())
+                _landmarksHashes.at(it->second) += landmarkHash;
+        }
+    }
+}
+
+std::size_t DepthMapDependencies::getCameraHash(int cam) const
+{
+    std::size_t seed = 0;
+    for(int i = 0; i < 12; ++i)
+        stl::hash_combine(seed, _mp.camArr[cam].m[i]);
+    stl::hash_combine(seed, _mp.getWidth(cam));
+    stl::hash_combine(seed, _mp.getHeight(cam));
+    return seed;
+}
+
+std::size_t DepthMapDependencies::getImageHash(int cam) const
+{
+    // the image content is not read, its size and modification time tell if it was rewritten
+    const std::string& path = _mp.getImagePath(cam);
+    std::size_t seed = 0;
+    stl::hash_combine(seed, path);
+
+    boost::system::error_code ec;
+    const uintmax_t fileSize = bfs::file_size(path, ec);
+    if(!ec)
+        stl::hash_combine(seed, fileSize);
+    const std::time_t writeTime = bfs::last_write_time(path, ec);
+    if(!ec)
+        stl::hash_combine(seed, static_cast<long long>(writeTime));
+    return seed;
+}
+
+bpt::ptree DepthMapDependencies::getManifest(int rc) const
+{
+    const StaticVector<int> sgmTCams = _mp.findNearestCamsFromLandmarks(rc, _nbSgmTCams);
+    const StaticVector<int> refineTCams = _mp.findNearestCamsFromLandmarks(rc, _nbRefineTCams);
+
+    bpt::ptree manifest;
+    manifest.put("version", manifestVersion);
+    manifest.put("viewId", _mp.getViewId(rc));
+    manifest.put("parameters", std::to_string(_parametersHash));
+    manifest.put("rc.camera", std::to_string(getCameraHash(rc)));
+    manifest.put("rc.image", std::to_string(getImageHash(rc)));
+    manifest.put("rc.landmarks", std::to_string(_landmarksHashes.at(rc)));
+    manifest.put("sgmTCams", viewIdsToString(_mp, sgmTCams));
+    manifest.put("refineTCams", viewIdsToString(_mp, refineTCams));
+
+    std::vector<int> tcams = sgmTCams.getData();
+    tcams.insert(tcams.end(), refineTCams.getData().begin(), refineTCams.getData().end());
+    std::sort(tcams.begin(), tcams.end());
+    tcams.erase(std::unique(tcams.begin(), tcams.end()), tcams.end());
+
+    bpt::ptree tcamsTree;
+    for(const int tc : tcams)
+    {
+        bpt::ptree tcTree;
+        tcTree.put("viewId", _mp.getViewId(tc));
+        tcTree.put("camera", std::to_string(getCameraHash(tc)));
+        tcTree.put("image", std::to_string(getImageHash(tc)));
+        tcamsTree.push_back(std::make_pair("", tcTree));
+    }
+    manifest.add_child("tcams", tcamsTree);
+
+    return manifest;
+}
+
+bool DepthMapDependencies::isUpToDate(int rc) const
+{
+    const std::string manifestFilepath = getFileNameFromIndex(&_mp, rc, mvsUtils::EFileType::depthMapDeps, 1);
+
+    if(!mvsUtils::FileExists(manifestFilepath) ||
+       !mvsUtils::FileExists(getFileNameFromIndex(&_mp, rc, mvsUtils::EFileType::depthMap, 1)) ||
+       !mvsUtils::FileExists(getFileNameFromIndex(&_mp, rc, mvsUtils::EFileType::simMap, 1)))
+        return false;
+
+    bpt::ptree savedManifest;
+    try
+    {
+        bpt::read_json(manifestFilepath, savedManifest);
+    }
+    catch(const bpt::json_parser_error& e)
+    {
+        ALICEVISION_LOG_WARNING("Cannot read the depth map dependencies file: " << manifestFilepath << ", " << e.what());
+        return false;
+    }
+
+    const bpt::ptree manifest = getManifest(rc);
+    if(savedManifest == manifest)
+        return true;
+
+    std::string changes;
+    for(const auto& child : manifest)
+    {
+        const auto savedChild = savedManifest.get_child_optional(child.first);
+        if(!savedChild || *savedChild != child.second)
+            changes += (changes.empty() ? "" : ", ") + child.first;
+    }
+    ALICEVISION_LOG_INFO("Depth map of the view " << _mp.getViewId(rc) << " is out of date, changed: " << changes << ".");
+    return false;
+}
+
+void DepthMapDependencies::save(int rc) const
+{
+    bpt::write_json(getFileNameFromIndex(&_mp, rc, mvsUtils::EFileType::depthMapDeps, 1), getManifest(rc));
+}
+
+std::vector<int> DepthMapDependencies::getCamsToCompute(const std::vector<int>& cams) const
+{
+    std::vector<int> camsToCompute;
+    camsToCompute.reserve(cams.size());
+
+    for(const int rc : cams)
+    {
+        if(!isUpToDate(rc))
+            camsToCompute.push_back(rc);
+    }
+
+    ALICEVISION_LOG_INFO(cams.size() - camsToCompute.size() << " depth maps are up to date, "
+                         << camsToCompute.size() << " to compute.");
+    return camsToCompute;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
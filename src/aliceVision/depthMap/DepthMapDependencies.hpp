@@ -0,0 +1,73 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace bpt = boost::property_tree;
+
+/**
+ * @brief Dependency manifest of the depth maps.
+ *
+ * The manifest of a depth map records the hashes of its inputs: the rc and tcams
+ * projection matrices (pose and intrinsics), image files and sizes, the landmarks
+ * seen by the rc (neighbors selection and depth range) and the estimation parameters.
+ * It is written next to the depth map once computed, a depth map is only recomputed
+ * if its manifest does not match the current inputs.
+ */
+class DepthMapDependencies
+{
+public:
+    explicit DepthMapDependencies(const mvsUtils::MultiViewParams& mp);
+
+    /**
+     * @brief Get the manifest of the current inputs of a depth map.
+     * @param[in] rc the reference camera index
+     */
+    bpt::ptree getManifest(int rc) const;
+
+    /**
+     * @brief Check if the depth and similarity maps of the rc exist
+     *        and were computed from the current inputs.
+     */
+    bool isUpToDate(int rc) const;
+
+    /**
+     * @brief Write the manifest of the current inputs of a computed depth map.
+     */
+    void save(int rc) const;
+
+    /**
+     * @brief Get the cameras whose depth maps are missing or out of date.
+     */
+    std::vector<int> getCamsToCompute(const std::vector<int>& cams) const;
+
+private:
+    std::size_t getCameraHash(int cam) const;
+    std::size_t getImageHash(int cam) const;
+
+    const mvsUtils::MultiViewParams& _mp;
+    /// number of neighbor cameras of the SGM and of the refinement
+    int _nbSgmTCams;
+    int _nbRefineTCams;
+    /// hash of the parameters changing the depth maps
+    std::size_t _parametersHash = 0;
+    /// hash of the landmarks seen by each camera
+    std::vector<std::size_t> _landmarksHashes;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
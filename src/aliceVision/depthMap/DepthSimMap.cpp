@@ -419,6 +419,12 @@ void DepthSimMap::save(int rc, const StaticVector<int>& tcams)
     }
 
     using namespace imageIO;
+    if(mp->userParams.get<bool>("global.tiledHalfMaps", false))
+    {
+        writeImageTiled(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::depthMap, scale), width, height, depthMap->getDataWritable(), EImageQuality::OPTIMIZED, metadata);
+        writeImageTiled(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::simMap, scale), width, height, simMap->getDataWritable(), EImageQuality::OPTIMIZED, metadata);
+        return;
+    }
     OutputFileColorSpace colorspace(EImageColorSpace::NO_CONVERSION);
     writeImage(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::depthMap, scale), width, height, depthMap->getDataWritable(), EImageQuality::LOSSLESS, colorspace,  metadata);
     writeImage(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::simMap, scale), width, height, simMap->getDataWritable(), EImageQuality::OPTIMIZED,  colorspace, metadata);
@@ -469,6 +475,12 @@ void DepthSimMap::saveRefine(int rc, std::string depthMapFileName, std::string s
     }
 
     using namespace imageIO;
+    if(mp->userParams.get<bool>("global.tiledHalfMaps", false))
+    {
+        writeImageTiled(depthMapFileName, width, height, depthMap, EImageQuality::OPTIMIZED, metadata);
+        writeImageTiled(simMapFileName, width, height, simMap, EImageQuality::OPTIMIZED, metadata);
+        return;
+    }
     OutputFileColorSpace colorspace(EImageColorSpace::NO_CONVERSION);
     writeImage(depthMapFileName, width, height, depthMap, EImageQuality::LOSSLESS,  colorspace, metadata);
     writeImage(simMapFileName, width, height, simMap, EImageQuality::OPTIMIZED,  colorspace, metadata);
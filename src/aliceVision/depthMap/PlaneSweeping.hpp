@@ -0,0 +1,87 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/mvsUtils/ImagesCache.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/depthMap/DepthSimMap.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Plane sweeping interface used by the depth map estimation (SGM and refine).
+ *        Implemented on the GPU by PlaneSweepingCuda and on the host by PlaneSweepingCpu,
+ *        the "device" of the memory functions is the memory used by the implementation.
+ */
+class PlaneSweeping
+{
+public:
+    const int _scales;
+
+    mvsUtils::MultiViewParams* mp;
+
+    const bool _verbose;
+
+    mvsUtils::ImagesCache& _ic;
+
+    PlaneSweeping(mvsUtils::ImagesCache& ic, mvsUtils::MultiViewParams* _mp, int scales);
+    virtual ~PlaneSweeping() = default;
+
+    void getMinMaxdepths(int rc, const StaticVector<int>& tcams, float& minDepth, float& midDepth, float& maxDepth);
+    /// Fill out with the depths of rc spaced by the pixel size, in ascending order (out is cleared, its capacity is reused)
+    void getDepthsByPixelSize(StaticVector<float>& out, int rc, float minDepth, float midDepth, float maxDepth, int scale,
+                              int step, int maxDepthsHalf = 1024);
+    /// Fill out with the depths of rc along the epipolar line in tc, in ascending order (out is cleared, its capacity is reused)
+    void getDepthsRcTc(StaticVector<float>& out, int rc, int tc, int scale, float midDepth, int maxDepthsHalf = 1024);
+
+    virtual bool refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                                    StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
+                                    float gammaP, float epipShift, int xFrom, int wPart) = 0;
+
+    virtual float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                                      int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
+                                      const std::vector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
+                                      StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
+                                      float epipShift) = 0;
+    virtual bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
+                                      int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1, unsigned char P2,
+                                      bool streamVolume) = 0;
+
+    /// make_float3(avail,total,used) of the memory used by the implementation in MB
+    virtual Point3d getDeviceMemoryInfo() = 0;
+
+    /**
+     * @brief Number of parts to split a map into, so that each part fits into the free device memory.
+     * @param[in] mapMB The device memory needed to process the whole map in MB
+     * @param[in] minNbParts The minimum number of parts
+     */
+    int getNbPartsInDeviceMemory(float mapMB, int minNbParts = 1);
+
+    virtual bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                                      const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                                      int nSamplesHalf, int nDepthsToRefine, float sigma) = 0;
+    virtual bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                                    StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc,
+                                                    int nSamplesHalf, int nDepthsToRefine, float sigma, int nIters,
+                                                    int yFrom, int hPart) = 0;
+    virtual bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc) = 0;
+};
+
+/**
+ * @brief Number of CUDA devices, always 0 when AliceVision is built without CUDA
+ */
+int listCUDADevices(bool verbose);
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -12,7 +12,7 @@
 namespace aliceVision {
 namespace depthMap {
 
-RcTc::RcTc(mvsUtils::MultiViewParams* _mp, PlaneSweepingCuda& _cps)
+RcTc::RcTc(mvsUtils::MultiViewParams* _mp, PlaneSweeping& _cps)
     : cps( _cps )
 {
     mp = _mp;
@@ -20,7 +20,7 @@ RcTc::RcTc(mvsUtils::MultiViewParams* _mp, PlaneSweepingCuda& _cps)
 }
 
 void RcTc::refineRcTcDepthSimMap(bool useTcOrRcPixSize, DepthSimMap* depthSimMap, int rc, int tc,
-                                    int ndepthsToRefine, int wsh, float gammaC, float gammaP, float epipShift)
+                                    int ndepthsToRefine, int wsh, float gammaC, float gammaP, float epipShift, int nParts)
 {
     int scale = depthSimMap->scale;
     int w = mp->getWidth(rc) / scale;
@@ -31,11 +31,12 @@ void RcTc::refineRcTcDepthSimMap(bool useTcOrRcPixSize, DepthSimMap* depthSimMap
 
     long t1 = clock();
 
-    int nParts = 4;
-    int wPart = w / nParts;
+    int wPart = (w + nParts - 1) / nParts;
     for(int p = 0; p < nParts; p++)
     {
         int xFrom = p * wPart;
+        if(xFrom >= w)
+            break;
         int wPartAct = std::min(wPart, w - xFrom);
         StaticVector<float>* depthMap = depthSimMap->getDepthMapStep1XPart(xFrom, wPartAct);
         StaticVector<float>* simMap = depthSimMap->getSimMapStep1XPart(xFrom, wPartAct);
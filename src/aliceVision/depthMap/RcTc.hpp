@@ -8,7 +8,7 @@
 
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/depthMap/DepthSimMap.hpp>
-#include <aliceVision/depthMap/cuda/PlaneSweepingCuda.hpp>
+#include <aliceVision/depthMap/PlaneSweeping.hpp>
 
 namespace aliceVision {
 namespace depthMap {
@@ -17,13 +17,16 @@ class RcTc
 {
 public:
     mvsUtils::MultiViewParams* mp;
-    PlaneSweepingCuda&         cps;
+    PlaneSweeping&             cps;
     bool                       verbose;
 
-    RcTc(mvsUtils::MultiViewParams* _mp, PlaneSweepingCuda& _cps);
+    RcTc(mvsUtils::MultiViewParams* _mp, PlaneSweeping& _cps);
 
+    /**
+     * @param[in] nParts number of vertical parts the map is refined in, to fit into the device memory
+     */
     void refineRcTcDepthSimMap(bool useTcOrRcPixSize, DepthSimMap* depthSimMap, int rc, int tc, int ndepthsToRefine,
-                               int wsh, float gammaC, float gammaP, float epipShift);
+                               int wsh, float gammaC, float gammaP, float epipShift, int nParts = 4);
 
     // void smoothDepthMap(DepthSimMap* depthSimMap, int rc, int wsh, float gammaC, float gammaP);
     // void filterDepthMap(DepthSimMap* depthSimMap, int rc, int wsh, float gammaC);
@@ -5,7 +5,14 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "RefineRc.hpp"
+#include <aliceVision/config.hpp>
+#include <aliceVision/depthMap/DepthMapDependencies.hpp>
+#include <aliceVision/depthMap/cpu/PlaneSweepingCpu.hpp>
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/depthMap/cuda/PlaneSweepingCuda.hpp>
+#endif
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/gpu/gpu.hpp>
 
 #include <aliceVision/mvsData/Point2d.hpp>
@@ -14,9 +21,19 @@
 #include <aliceVision/mvsUtils/fileIO.hpp>
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
 namespace aliceVision {
 namespace depthMap {
 
@@ -28,6 +45,7 @@ RefineRc::RefineRc(int rc, int scale, int step, SemiGlobalMatchingParams* sp)
     const int nbNearestCams = sp->mp->userParams.get<int>("refineRc.maxTCams", 6);
     _refineTCams  = sp->mp->findNearestCamsFromLandmarks(rc, nbNearestCams);
     _userTcOrPixSize = _sp->mp->userParams.get<bool>("refineRc.useTcOrRcPixSize", false);
+    _keepMapsOnDevice = _sp->mp->userParams.get<bool>("refineRc.keepMapsOnDevice", true);
     _nbDepthsToRefine = _sp->mp->userParams.get<int>("refineRc.ndepthsToRefine", 31);
     _refineWsh = _sp->mp->userParams.get<int>("refineRc.wsh", 3);
     _refineNiters = _sp->mp->userParams.get<int>("refineRc.niters", 100);
@@ -42,10 +60,15 @@ RefineRc::~RefineRc()
   delete _depthSimMapOpt;
 }
 
-void RefineRc::preloadSgmTcams_async()
+void RefineRc::scheduleImages(const std::vector<int>& nextCams)
 {
-  for(int tc : _sgmTCams.getData())
-    _sp->cps._ic.refreshData_async(tc);
+  std::vector<int> cams;
+  cams.reserve(1 + _sgmTCams.size() + _refineTCams.size() + nextCams.size());
+  cams.push_back(_rc);
+  cams.insert(cams.end(), _sgmTCams.getData().begin(), _sgmTCams.getData().end());
+  cams.insert(cams.end(), _refineTCams.getData().begin(), _refineTCams.getData().end());
+  cams.insert(cams.end(), nextCams.begin(), nextCams.end());
+  _sp->cps._ic.setSchedule(cams);
 }
 
 DepthSimMap* RefineRc::getDepthPixSizeMapFromSGM()
@@ -94,6 +117,15 @@ DepthSimMap* RefineRc::getDepthPixSizeMapFromSGM()
     return depthSimMapScale1Step1;
 }
 
+int RefineRc::getNbParts(float bytesPerPixel)
+{
+    if(!_sp->useTiles)
+        return 4;
+
+    const float mapMB = (float)_sp->mp->getWidth(_rc) * (float)_sp->mp->getHeight(_rc) * bytesPerPixel / (1024.0f * 1024.0f);
+    return _sp->cps.getNbPartsInDeviceMemory(mapMB);
+}
+
 DepthSimMap* RefineRc::refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis)
 {
     int w11 = _sp->mp->getWidth(_rc);
@@ -114,8 +146,9 @@ DepthSimMap* RefineRc::refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMap
         depthSimMapC->initJustFromDepthMap(depthMap, 1.0f);
         delete depthMap;
 
+        // lastThreeSimsMap (float3) and the sim, depth, best sim and best depth maps (float)
         _sp->prt->refineRcTcDepthSimMap(_userTcOrPixSize, depthSimMapC, _rc, tc, _nbDepthsToRefine, _refineWsh, _refineGammaC, _refineGammaP,
-                                       0.0f);
+                                       0.0f, getNbParts(7.0f * sizeof(float)));
 
         dataMaps->push_back(depthSimMapC);
 
@@ -127,10 +160,13 @@ DepthSimMap* RefineRc::refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMap
     // in order to fit into GPU memory
     DepthSimMap* depthSimMapFused = new DepthSimMap(_rc, _sp->mp, scale, 1);
 
-    int nhParts = 4;
-    int hPartHeightGlob = h11 / nhParts;
+    // depthSimMaps, bestDepthSimMap and bestGsvSampleMap (float2), gsvSampleMap (float)
+    int nhParts = getNbParts((dataMaps->size() + 2) * 2 * sizeof(float) + sizeof(float));
+    int hPartHeightGlob = (h11 + nhParts - 1) / nhParts;
     for(int hPart = 0; hPart < nhParts; hPart++)
     {
+        if(hPart * hPartHeightGlob >= h11)
+            break;
         int hPartHeight = std::min(h11, (hPart + 1) * hPartHeightGlob) - hPart * hPartHeightGlob;
 
         // vector of one depthSimMap tile per Tc
@@ -206,11 +242,14 @@ DepthSimMap* RefineRc::optimizeDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis,
             dataMapsPtrs->push_back((*dataMaps)[i]->dsm);
         }
 
-        int nParts = 4;
-        int hPart = h11 / nParts;
+        // dataMaps and optDepthSimMap (float2), optDepthMap and its array (float)
+        int nParts = getNbParts((dataMaps->size() + 1) * 2 * sizeof(float) + 2 * sizeof(float));
+        int hPart = (h11 + nParts - 1) / nParts;
         for(int part = 0; part < nParts; part++)
         {
             int yFrom = part * hPart;
+            if(yFrom >= h11)
+                break;
             int hPartAct = std::min(hPart, h11 - yFrom);
             _sp->cps.optimizeDepthSimMapGradientDescent(depthSimMapOptimized->dsm, dataMapsPtrs, _rc, _refineNSamplesHalf,
                                                         _nbDepthsToRefine, _refineSigma, _refineNiters, yFrom, hPartAct);
@@ -230,6 +269,89 @@ DepthSimMap* RefineRc::optimizeDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis,
     return depthSimMapOptimized;
 }
 
+bool RefineRc::canKeepMapsOnDevice()
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    // the maps are only kept in the memory of the CUDA devices
+    if(!_keepMapsOnDevice || (dynamic_cast<PlaneSweepingCuda*>(&_sp->cps) == nullptr))
+        return false;
+
+    // the depth/pixSize map, the map of each tc, the fused and optimized maps (float2)
+    // and the temporary maps of the refinement (7 floats)
+    const float bytesPerPixel = ((_refineTCams.size() + 3) * 2 + 7) * sizeof(float);
+    const float mapMB = (float)_sp->mp->getWidth(_rc) * (float)_sp->mp->getHeight(_rc) * bytesPerPixel / (1024.0f * 1024.0f);
+    return (_sp->cps.getNbPartsInDeviceMemory(mapMB) == 1);
+#else
+    return false;
+#endif
+}
+
+DepthSimMap* RefineRc::refineFuseOptimizeOnDevice(DepthSimMap* depthPixSizeMapVis, DepthSimMap*& depthSimMapPhoto)
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    // only called if canKeepMapsOnDevice
+    PlaneSweepingCuda& cps = static_cast<PlaneSweepingCuda&>(_sp->cps);
+
+    const CudaSize<2> mapSize(_sp->mp->getWidth(_rc), _sp->mp->getHeight(_rc));
+
+    CudaDeviceMemoryPitched<float2, 2> depthPixSizeMapVis_dmp(mapSize);
+    copy(depthPixSizeMapVis_dmp, *depthPixSizeMapVis);
+
+    // the depth/pixSize map, then the refined map of each tc
+    std::vector<std::unique_ptr<CudaDeviceMemoryPitched<float2, 2>>> refinedMaps_dmp;
+    std::vector<CudaDeviceMemoryPitched<float2, 2>*> dataMaps_dmp;
+    dataMaps_dmp.reserve(_refineTCams.size() + 1);
+    dataMaps_dmp.push_back(&depthPixSizeMapVis_dmp);
+
+    for(int c = 0; c < _refineTCams.size(); c++)
+    {
+        const int tc = _refineTCams[c];
+
+        refinedMaps_dmp.emplace_back(new CudaDeviceMemoryPitched<float2, 2>(mapSize));
+        cps.refineRcTcDepthSimMap(_userTcOrPixSize, _nbDepthsToRefine, *refinedMaps_dmp.back(), depthPixSizeMapVis_dmp,
+                                  _rc, tc, _refineWsh, _refineGammaC, _refineGammaP, 0.0f);
+        dataMaps_dmp.push_back(refinedMaps_dmp.back().get());
+
+        if(_sp->exportIntermediateResults)
+        {
+            DepthSimMap depthSimMapC(_rc, _sp->mp, 1, 1);
+            copy(depthSimMapC, *refinedMaps_dmp.back());
+            depthSimMapC.saveToImage(_sp->mp->getDepthMapsFolder() + "refine_photo_" + std::to_string(_sp->mp->getViewId(_rc)) + "_tc_" +
+                                     std::to_string(_sp->mp->getViewId(tc)) + ".png", -2.0f);
+        }
+    }
+
+    CudaDeviceMemoryPitched<float2, 2> depthSimMapPhoto_dmp(mapSize);
+    cps.fuseDepthSimMapsGaussianKernelVoting(depthSimMapPhoto_dmp, dataMaps_dmp, _refineNSamplesHalf,
+                                             _nbDepthsToRefine, _refineSigma);
+
+    // the refined maps are fused, free them before the optimization
+    dataMaps_dmp.resize(1);
+    refinedMaps_dmp.clear();
+
+    if(_sp->exportIntermediateResults || !_sp->doRefineRc)
+    {
+        depthSimMapPhoto = new DepthSimMap(_rc, _sp->mp, 1, 1);
+        copy(*depthSimMapPhoto, depthSimMapPhoto_dmp);
+    }
+
+    if(!_sp->doRefineRc)
+        return nullptr;
+
+    dataMaps_dmp.push_back(&depthSimMapPhoto_dmp);
+
+    CudaDeviceMemoryPitched<float2, 2> depthSimMapOpt_dmp(mapSize);
+    cps.optimizeDepthSimMapGradientDescent(depthSimMapOpt_dmp, dataMaps_dmp, _rc, _refineNSamplesHalf,
+                                           _nbDepthsToRefine, _refineSigma, _refineNiters);
+
+    DepthSimMap* depthSimMapOpt = new DepthSimMap(_rc, _sp->mp, 1, 1);
+    copy(*depthSimMapOpt, depthSimMapOpt_dmp);
+    return depthSimMapOpt;
+#else
+    throw std::runtime_error("The depth maps can only be kept on a CUDA device.");
+#endif
+}
+
 bool RefineRc::refinerc(bool checkIfExists)
 {
     const IndexT viewId = _sp->mp->getViewId(_rc);
@@ -253,13 +375,22 @@ bool RefineRc::refinerc(bool checkIfExists)
     long tall = clock();
 
     DepthSimMap* depthPixSizeMapVis = getDepthPixSizeMapFromSGM();
-    DepthSimMap* depthSimMapPhoto = refineAndFuseDepthSimMapCUDA(depthPixSizeMapVis);
+    DepthSimMap* depthSimMapPhoto = nullptr;
 
-    if(_sp->doRefineRc)
+    if(canKeepMapsOnDevice())
     {
-        _depthSimMapOpt = optimizeDepthSimMapCUDA(depthPixSizeMapVis, depthSimMapPhoto);
+        // only the final map and the intermediate results are downloaded
+        _depthSimMapOpt = refineFuseOptimizeOnDevice(depthPixSizeMapVis, depthSimMapPhoto);
     }
     else
+    {
+        depthSimMapPhoto = refineAndFuseDepthSimMapCUDA(depthPixSizeMapVis);
+
+        if(_sp->doRefineRc)
+            _depthSimMapOpt = optimizeDepthSimMapCUDA(depthPixSizeMapVis, depthSimMapPhoto);
+    }
+
+    if(!_sp->doRefineRc)
     {
         _depthSimMapOpt = new DepthSimMap(_rc, _sp->mp, 1, 1);
         _depthSimMapOpt->add(depthSimMapPhoto);
@@ -286,52 +417,191 @@ void RefineRc::writeDepthMap()
   _depthSimMapOpt->save(_rc, _refineTCams);
 }
 
-void estimateAndRefineDepthMaps(mvsUtils::MultiViewParams* mp, const std::vector<int>& cams, int nbGPUs)
+namespace {
+
+/**
+ * @brief Dynamic distribution of the reference cameras to the CUDA devices.
+ *
+ * The cameras are handed out on demand, ordered by decreasing estimated cost
+ * (image size x number of SGM tcams), so the longest jobs start first and the
+ * devices finish together. Among the next pending cameras, a device gets the one
+ * sharing the most cameras with its previous job, to reuse the images already
+ * uploaded on the device by PlaneSweepingCuda::addCam.
+ */
+class DepthMapScheduler
 {
-  const int numGpus = listCUDADevices(true);
-  const int numCpuThreads = omp_get_num_procs();
-  int numThreads = std::min(numGpus, numCpuThreads);
+public:
+    DepthMapScheduler(const mvsUtils::MultiViewParams& mp, const std::vector<int>& cams, int nbDevices)
+        : _devices(nbDevices)
+        , _start(std::chrono::steady_clock::now())
+    {
+        const int nbSgmTCams = mp.userParams.get<int>("semiGlobalMatching.maxTCams", 10);
 
-  ALICEVISION_LOG_INFO("# GPU devices: " << numGpus << ", # CPU threads: " << numCpuThreads);
+        _pendingJobs.resize(cams.size());
 
-  if(nbGPUs > 0)
-      numThreads = nbGPUs;
+#pragma omp parallel for
+        for(int i = 0; i < cams.size(); ++i)
+        {
+            Job& job = _pendingJobs[i];
+            job.rc = cams[i];
+            job.cams = mp.findNearestCamsFromLandmarks(job.rc, nbSgmTCams).getData();
+            job.cost = static_cast<double>(mp.getWidth(job.rc)) * mp.getHeight(job.rc) * std::max<std::size_t>(job.cams.size(), 1);
+            job.cams.push_back(job.rc);
+            std::sort(job.cams.begin(), job.cams.end());
+        }
 
-  if(numThreads == 1)
-  {
-      // the GPU sorting is determined by an environment variable named CUDA_DEVICE_ORDER
-      // possible values: FASTEST_FIRST (default) or PCI_BUS_ID
-      const int cudaDeviceNo = 0;
-      estimateAndRefineDepthMaps(cudaDeviceNo, mp, cams);
-  }
-  else
-  {
-      omp_set_num_threads(numThreads); // create as many CPU threads as there are CUDA devices
-#pragma omp parallel
-      {
-          const int cpuThreadId = omp_get_thread_num();
-          const int cudaDeviceNo = cpuThreadId % numThreads;
-          const int rcFrom = cudaDeviceNo * (cams.size() / numThreads);
-          int rcTo = (cudaDeviceNo + 1) * (cams.size() / numThreads);
+        std::stable_sort(_pendingJobs.begin(), _pendingJobs.end(), [](const Job& a, const Job& b) { return a.cost > b.cost; });
+    }
 
-          ALICEVISION_LOG_INFO("CPU thread " << cpuThreadId << " / " << numThreads << " uses CUDA device: " << cudaDeviceNo);
+    /**
+     * @brief Get the next reference camera of a device, the previous job of the device is done.
+     * @param[in] device the device index
+     * @param[out] rc the reference camera to compute
+     * @param[out] nextCams the cameras of the job the device should get after this one, for the prefetching
+     * @return false if all the cameras are handed out
+     */
+    bool nextCam(int device, int& rc, std::vector<int>& nextCams)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        DeviceStats& stats = _devices.at(device);
+        if(stats.hasJob)
+            stats.busyTime += std::chrono::duration<double>(now - stats.jobStart).count();
+        stats.hasJob = false;
+
+        nextCams.clear();
+        if(_pendingJobs.empty())
+            return false;
+
+        const std::size_t best = selectJob(stats.previousCams);
+        rc = _pendingJobs[best].rc;
+        stats.previousCams = std::move(_pendingJobs[best].cams);
+        _pendingJobs.erase(_pendingJobs.begin() + best);
+
+        // the job selected now after this one, other devices may take it first
+        if(!_pendingJobs.empty())
+            nextCams = _pendingJobs[selectJob(stats.previousCams)].cams;
+
+        stats.hasJob = true;
+        stats.jobStart = std::chrono::steady_clock::now();
+        ++stats.nbJobs;
+        return true;
+    }
 
-          if(cudaDeviceNo == numThreads - 1)
-              rcTo = cams.size();
+    /// Log the number of cameras and the busy time of each device
+    void logUtilization() const
+    {
+        const double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+        std::lock_guard<std::mutex> lock(_mutex);
 
-          std::vector<int> subcams;
-          subcams.reserve(cams.size());
+        std::ostringstream ss;
+        ss << "Depth map estimation devices utilization (" << totalTime << " s):";
+        for(std::size_t device = 0; device < _devices.size(); ++device)
+        {
+            const DeviceStats& stats = _devices[device];
+            ss << "\n\t- device " << device << ": " << stats.nbJobs << " cameras, busy " << stats.busyTime << " s ("
+               << (totalTime > 0.0 ? 100.0 * stats.busyTime / totalTime : 0.0) << "%)";
+        }
+        ALICEVISION_LOG_INFO(ss.str());
+    }
 
-          for(int rc = rcFrom; rc < rcTo; rc++)
-              subcams.push_back(cams[rc]);
+private:
+    struct Job
+    {
+        int rc = -1;
+        /// the reference camera and its tcams, sorted
+        std::vector<int> cams;
+        double cost = 0.0;
+    };
 
-          estimateAndRefineDepthMaps(cpuThreadId, mp, subcams);
-      }
-  }
+    struct DeviceStats
+    {
+        /// the cameras of the previous job, sorted
+        std::vector<int> previousCams;
+        std::size_t nbJobs = 0;
+        double busyTime = 0.0;
+        bool hasJob = false;
+        std::chrono::steady_clock::time_point jobStart;
+    };
+
+    /**
+     * @brief The most expensive job by default, or a job close to it sharing the most cameras with the previous job.
+     */
+    std::size_t selectJob(const std::vector<int>& previousCams) const
+    {
+        std::size_t best = 0;
+        if(!previousCams.empty())
+        {
+            std::size_t bestShared = 0;
+            const std::size_t lookahead = std::min<std::size_t>(_pendingJobs.size(), 2 * _devices.size() + 2);
+            for(std::size_t i = 0; i < lookahead; ++i)
+            {
+                const std::size_t shared = nbSharedCams(previousCams, _pendingJobs[i].cams);
+                if(shared > bestShared)
+                {
+                    bestShared = shared;
+                    best = i;
+                }
+            }
+        }
+        return best;
+    }
+
+    static std::size_t nbSharedCams(const std::vector<int>& a, const std::vector<int>& b)
+    {
+        std::size_t nbShared = 0;
+        auto itA = a.begin();
+        auto itB = b.begin();
+        while(itA != a.end() && itB != b.end())
+        {
+            if(*itA < *itB)
+                ++itA;
+            else if(*itB < *itA)
+                ++itB;
+            else
+            {
+                ++nbShared;
+                ++itA;
+                ++itB;
+            }
+        }
+        return nbShared;
+    }
+
+    std::vector<Job> _pendingJobs;
+    std::vector<DeviceStats> _devices;
+    const std::chrono::steady_clock::time_point _start;
+    mutable std::mutex _mutex;
+};
+
+/**
+ * @brief Create the plane sweeping of a CUDA device, or on the host if the device number is negative
+ */
+std::unique_ptr<PlaneSweeping> createPlaneSweeping(int cudaDeviceNo, mvsUtils::ImagesCache& ic,
+                                                   mvsUtils::MultiViewParams* mp, int scales)
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  if(cudaDeviceNo >= 0)
+    return std::unique_ptr<PlaneSweeping>(new PlaneSweepingCuda(cudaDeviceNo, ic, mp, scales));
+#endif
+  return std::unique_ptr<PlaneSweeping>(new PlaneSweepingCpu(ic, mp, scales));
 }
 
-void estimateAndRefineDepthMaps(int cudaDeviceNo, mvsUtils::MultiViewParams* mp, const std::vector<int>& cams)
+/**
+ * @brief Estimate and refine the depth maps of the reference cameras given by nextCam on a CUDA device
+ * @param[in] cudaDeviceNo the CUDA device, the host if negative
+ * @param[in] mp the multi-view parameters
+ * @param[in] dependencies the depth maps manifests, written once the depth maps are computed
+ * @param[in] nextCam gives the reference camera and the cameras expected after it,
+ *            returns false when there is no more camera to compute
+ */
+void estimateAndRefineDepthMapsOnDevice(int cudaDeviceNo, mvsUtils::MultiViewParams* mp,
+                                        const DepthMapDependencies& dependencies,
+                                        const std::function<bool(int&, std::vector<int>&)>& nextCam)
 {
+  ALICEVISION_PROFILE_SCOPE("depthMap::estimateAndRefineDepthMapsOnDevice");
+
   const int fileScale = 1; // input images scale (should be one)
   int sgmScale = mp->userParams.get<int>("semiGlobalMatching.scale", -1);
   int sgmStep = mp->userParams.get<int>("semiGlobalMatching.step", -1);
@@ -355,32 +625,138 @@ void estimateAndRefineDepthMaps(int cudaDeviceNo, mvsUtils::MultiViewParams* mp,
   // load images from files into RAM
   mvsUtils::ImagesCache ic(mp, imageIO::EImageColorSpace::LINEAR);
   // load stuff on GPU memory and creates multi-level images and computes gradients
-  PlaneSweepingCuda cps(cudaDeviceNo, ic, mp, sgmScale);
+  std::unique_ptr<PlaneSweeping> cps = createPlaneSweeping(cudaDeviceNo, ic, mp, sgmScale);
   // init plane sweeping parameters
-  SemiGlobalMatchingParams sp(mp, cps);
+  SemiGlobalMatchingParams sp(mp, *cps);
 
-  for(const int rc : cams)
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  // the device stages are only profiled on the CUDA devices
+  PlaneSweepingCuda* cpsCuda = dynamic_cast<PlaneSweepingCuda*>(cps.get());
+#endif
+
+  int rc;
+  std::vector<int> nextCams;
+  while(nextCam(rc, nextCams))
   {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+      if(cpsCuda != nullptr)
+          cpsCuda->getProfile().reset();
+#endif
+
       RefineRc sgmRefineRc(rc, sgmScale, sgmStep, &sp);
 
-      sgmRefineRc.preloadSgmTcams_async();
+      // the images of this camera are loaded first, then the ones of the next camera while this one is computed
+      sgmRefineRc.scheduleImages(nextCams);
 
+      // the depth maps to compute are selected from their dependencies, not from the intermediate files
       ALICEVISION_LOG_INFO("Estimate depth map, view id: " << mp->getViewId(rc));
-      sgmRefineRc.sgmrc();
+      sgmRefineRc.sgmrc(false);
 
       ALICEVISION_LOG_INFO("Refine depth map, view id: " << mp->getViewId(rc));
-      sgmRefineRc.refinerc();
+      sgmRefineRc.refinerc(false);
 
       // write results
       sgmRefineRc.writeDepthMap();
+      dependencies.save(rc);
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+      if((cpsCuda != nullptr) && cpsCuda->getProfile().isEnabled())
+          cpsCuda->getProfile().save(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::deviceProfile, 1), mp->getViewId(rc));
+#endif
   }
 }
 
+void estimateAndRefineDepthMapsSequentially(int cudaDeviceNo, mvsUtils::MultiViewParams* mp,
+                                            const DepthMapDependencies& dependencies, const std::vector<int>& cams)
+{
+  const int nbSgmTCams = mp->userParams.get<int>("semiGlobalMatching.maxTCams", 10);
+  std::size_t i = 0;
+  estimateAndRefineDepthMapsOnDevice(cudaDeviceNo, mp, dependencies, [&](int& rc, std::vector<int>& nextCams)
+  {
+      nextCams.clear();
+      if(i >= cams.size())
+          return false;
+      rc = cams[i++];
+      if(i < cams.size())
+      {
+          nextCams = mp->findNearestCamsFromLandmarks(cams[i], nbSgmTCams).getData();
+          nextCams.insert(nextCams.begin(), cams[i]);
+      }
+      return true;
+  });
+}
+
+} // namespace
+
+void estimateAndRefineDepthMaps(mvsUtils::MultiViewParams* mp, const std::vector<int>& cams, int nbGPUs)
+{
+  ALICEVISION_PROFILE_SCOPE("depthMap::estimateAndRefineDepthMaps");
+  const system::MemoryStage memoryStage("depthMap::estimateAndRefineDepthMaps");
+
+  const int numGpus = listCUDADevices(true);
+  const int numCpuThreads = omp_get_num_procs();
+  int numThreads = std::min(numGpus, numCpuThreads);
 
+  ALICEVISION_LOG_INFO("# GPU devices: " << numGpus << ", # CPU threads: " << numCpuThreads);
+
+  const DepthMapDependencies dependencies(*mp);
+  const std::vector<int> camsToCompute = dependencies.getCamsToCompute(cams);
+
+  if(camsToCompute.empty())
+      return;
 
+  if(numGpus <= 0)
+  {
+      // the plane sweeping runs on the host, parallelized over the pixels of each camera
+      ALICEVISION_LOG_WARNING("No CUDA device found, the depth maps are computed on the CPU (much slower).");
+      estimateAndRefineDepthMapsSequentially(-1, mp, dependencies, camsToCompute);
+      return;
+  }
+
+  if(nbGPUs > 0)
+      numThreads = nbGPUs;
+
+  numThreads = std::min(numThreads, static_cast<int>(camsToCompute.size()));
+
+  if(numThreads == 1)
+  {
+      // the GPU sorting is determined by an environment variable named CUDA_DEVICE_ORDER
+      // possible values: FASTEST_FIRST (default) or PCI_BUS_ID
+      const int cudaDeviceNo = 0;
+      estimateAndRefineDepthMapsSequentially(cudaDeviceNo, mp, dependencies, camsToCompute);
+  }
+  else
+  {
+      // the cameras are handed out to the devices on demand
+      DepthMapScheduler scheduler(*mp, camsToCompute, numThreads);
+
+      omp_set_num_threads(numThreads); // create as many CPU threads as there are CUDA devices
+#pragma omp parallel
+      {
+          const int cpuThreadId = omp_get_thread_num();
+          const int cudaDeviceNo = cpuThreadId % numThreads;
+
+          ALICEVISION_LOG_INFO("CPU thread " << cpuThreadId << " / " << numThreads << " uses CUDA device: " << cudaDeviceNo);
+
+          estimateAndRefineDepthMapsOnDevice(cpuThreadId, mp, dependencies, [&](int& rc, std::vector<int>& nextCams)
+          {
+              return scheduler.nextCam(cudaDeviceNo, rc, nextCams);
+          });
+      }
+
+      scheduler.logUtilization();
+  }
+}
+
+void estimateAndRefineDepthMaps(int cudaDeviceNo, mvsUtils::MultiViewParams* mp, const std::vector<int>& cams)
+{
+  const DepthMapDependencies dependencies(*mp);
+  estimateAndRefineDepthMapsSequentially(cudaDeviceNo, mp, dependencies, dependencies.getCamsToCompute(cams));
+}
 
 void computeNormalMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, const StaticVector<int>& cams)
 {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
   const float igammaC = 1.0f;
   const float igammaP = 1.0f;
   const int wsh = 3;
@@ -409,15 +785,24 @@ void computeNormalMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, const St
       writeImage(normalMapFilepath, mp->getWidth(rc), mp->getHeight(rc), normalMap.getDataWritable(), EImageQuality::LOSSLESS, colorspace);
     }
   }
+#else
+  throw std::runtime_error("The normal maps computation needs AliceVision built with CUDA.");
+#endif
 }
 
 void computeNormalMaps(mvsUtils::MultiViewParams* mp, const StaticVector<int>& cams)
 {
+  ALICEVISION_PROFILE_SCOPE("depthMap::computeNormalMaps");
+  const system::MemoryStage memoryStage("depthMap::computeNormalMaps");
+
   const int nbGPUs = listCUDADevices(true);
   const int nbCPUThreads = omp_get_num_procs();
 
   ALICEVISION_LOG_INFO("Number of GPU devices: " << nbGPUs << ", number of CPU threads: " << nbCPUThreads);
 
+  if(nbGPUs <= 0)
+    throw std::runtime_error("The normal maps computation needs a CUDA device, none was found.");
+
   const int nbGPUsToUse = mp->userParams.get<int>("refineRc.num_gpus_to_use", 1);
   int nbThreads = std::min(nbGPUs, nbCPUThreads);
 
@@ -463,6 +848,97 @@ void computeNormalMaps(mvsUtils::MultiViewParams* mp, const StaticVector<int>& c
   }
 }
 
+void computeNbConsistentCamsMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, const StaticVector<int>& cams,
+                                 int pixSizeBall, int pixSizeBallWSP, int nNearestCams)
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  mvsUtils::ImagesCache ic(mp, imageIO::EImageColorSpace::LINEAR);
+  PlaneSweepingCuda cps(CUDADeviceNo, ic, mp, 1);
+
+  const auto loadDepthMap = [&](int tc, StaticVector<float>& tcDepthMap)
+  {
+    int width = 0;
+    int height = 0;
+    imageIO::readImage(getFileNameFromIndex(mp, tc, mvsUtils::EFileType::depthMap, 1), width, height, tcDepthMap.getDataWritable(), imageIO::EImageColorSpace::NO_CONVERSION);
+    return (width == mp->getWidth(tc)) && (height == mp->getHeight(tc));
+  };
+
+  for(const int rc : cams)
+  {
+    const std::string nmodMapFilepath = getFileNameFromIndex(mp, rc, mvsUtils::EFileType::nmodMap);
+
+    if(mvsUtils::FileExists(nmodMapFilepath))
+      continue;
+
+    const int w = mp->getWidth(rc);
+    const int h = mp->getHeight(rc);
+
+    StaticVector<float> depthMap;
+    StaticVector<float> simMap;
+    {
+      int width = 0;
+      int height = 0;
+      imageIO::readImage(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::depthMap, 1), width, height, depthMap.getDataWritable(), imageIO::EImageColorSpace::NO_CONVERSION);
+      imageIO::readImage(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::simMap, 1), width, height, simMap.getDataWritable(), imageIO::EImageColorSpace::NO_CONVERSION);
+    }
+
+    if((depthMap.size() != w * h) || (simMap.size() != w * h))
+    {
+      std::stringstream s;
+      s << "computeNbConsistentCamsMaps: bad image dimension for camera: " << mp->getViewId(rc) << "\n";
+      s << "depthMap size: " << depthMap.size() << ", simMap size: " << simMap.size() << ", width: " << w << ", height: " << h;
+      throw std::runtime_error(s.str());
+    }
+
+    const StaticVector<int> tcams = mp->findNearestCamsFromLandmarks(rc, nNearestCams);
+
+    std::vector<unsigned char> nmodMap;
+    cps.getProfile().reset();
+    cps.computeNbConsistentCamsMap(rc, depthMap, simMap, tcams, loadDepthMap, pixSizeBall, pixSizeBallWSP, nmodMap);
+
+    using namespace imageIO;
+    OutputFileColorSpace colorspace(EImageColorSpace::NO_CONVERSION);
+    writeImage(nmodMapFilepath, w, h, nmodMap, EImageQuality::LOSSLESS, colorspace);
+
+    if(cps.getProfile().isEnabled())
+      cps.getProfile().save(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::deviceProfile, 0), mp->getViewId(rc));
+  }
+#else
+  throw std::runtime_error("The consistent cameras maps computation needs AliceVision built with CUDA.");
+#endif
+}
+
+void computeNbConsistentCamsMaps(mvsUtils::MultiViewParams* mp, const StaticVector<int>& cams,
+                                 int pixSizeBall, int pixSizeBallWSP, int nNearestCams)
+{
+  const int nbGPUs = listCUDADevices(true);
+
+  if(nbGPUs <= 0)
+    throw std::runtime_error("The consistent cameras maps computation needs a CUDA device, none was found.");
+
+  const int nbThreads = std::min(nbGPUs, static_cast<int>(cams.size()));
+
+  if(nbThreads <= 1)
+  {
+    computeNbConsistentCamsMaps(0, mp, cams, pixSizeBall, pixSizeBallWSP, nNearestCams);
+    return;
+  }
+
+  omp_set_num_threads(nbThreads); // one CPU thread per CUDA device
+#pragma omp parallel
+  {
+    const int CUDADeviceNo = omp_get_thread_num();
+
+    // interleave the cameras, the neighbors of a camera are often the next cameras
+    StaticVector<int> subcams;
+    subcams.reserve(cams.size() / nbThreads + 1);
+    for(int c = CUDADeviceNo; c < cams.size(); c += nbThreads)
+      subcams.push_back(cams[c]);
+
+    computeNbConsistentCamsMaps(CUDADeviceNo, mp, subcams, pixSizeBall, pixSizeBallWSP, nNearestCams);
+  }
+}
+
 
 
 
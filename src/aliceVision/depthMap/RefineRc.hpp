@@ -9,6 +9,8 @@
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/depthMap/SemiGlobalMatchingRc.hpp>
 
+#include <vector>
+
 namespace aliceVision {
 namespace depthMap {
 
@@ -18,7 +20,11 @@ public:
     RefineRc(int rc, int scale, int step, SemiGlobalMatchingParams* sp);
     ~RefineRc();
 
-    void preloadSgmTcams_async();
+    /**
+     * @brief Give the cameras of this rc, then the given cameras of the next rc, to the images cache
+     *        which prefetches them in this order.
+     */
+    void scheduleImages(const std::vector<int>& nextCams);
 
     bool refinerc(bool checkIfExists = true);
 
@@ -34,19 +40,56 @@ private:
     int _refineNiters;
     int _nbDepthsToRefine;
     bool _userTcOrPixSize;
+    bool _keepMapsOnDevice;
 
     DepthSimMap* _depthSimMapOpt = nullptr;
 
+    /**
+     * @brief Number of horizontal parts the full resolution maps are processed in, to fit into the device memory.
+     * @param[in] bytesPerPixel device memory needed per pixel
+     */
+    int getNbParts(float bytesPerPixel);
+
     DepthSimMap* getDepthPixSizeMapFromSGM();
     DepthSimMap* refineAndFuseDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis);
     DepthSimMap* optimizeDepthSimMapCUDA(DepthSimMap* depthPixSizeMapVis, DepthSimMap* depthSimMapPhoto);
+
+    /// Whether the maps of refineFuseOptimizeOnDevice fit into the device memory
+    bool canKeepMapsOnDevice();
+
+    /**
+     * @brief Refine, fuse and optimize the depth map in a row, the intermediate maps stay in the device memory.
+     *        Same as refineAndFuseDepthSimMapCUDA then optimizeDepthSimMapCUDA, without the tiles.
+     * @param[in] depthPixSizeMapVis the depth/pixSize map from the SGM, uploaded once
+     * @param[out] depthSimMapPhoto the fused map, only downloaded for the intermediate results or without optimization
+     * @return the optimized map, nullptr without optimization
+     */
+    DepthSimMap* refineFuseOptimizeOnDevice(DepthSimMap* depthPixSizeMapVis, DepthSimMap*& depthSimMapPhoto);
 };
 
+/**
+ * @brief Estimate and refine the depth maps of the cameras, except the ones already
+ *        computed from the same inputs (see DepthMapDependencies).
+ *        Without CUDA device, the depth maps are computed on the CPU (PlaneSweepingCpu).
+ */
 void estimateAndRefineDepthMaps(mvsUtils::MultiViewParams* mp, const std::vector<int>& cams, int nbGPUs);
+/// Same on the given CUDA device, on the CPU if cudaDeviceNo is negative
 void estimateAndRefineDepthMaps(int cudaDeviceNo, mvsUtils::MultiViewParams* mp, const std::vector<int>& cams);
 
 void computeNormalMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, const StaticVector<int>& cams);
 void computeNormalMaps(mvsUtils::MultiViewParams* mp, const StaticVector<int>& cams);
 
+/**
+ * @brief Write the number of consistent neighbor cameras of each pixel of the depth maps (nmodMap),
+ *        same as fuseCut::Fuser::filterGroups on the CUDA devices.
+ * @param[in] pixSizeBall the neighborhood radius (in px)
+ * @param[in] pixSizeBallWSP the neighborhood radius when the similarity is low
+ * @param[in] nNearestCams the number of neighbor cameras
+ */
+void computeNbConsistentCamsMaps(int CUDADeviceNo, mvsUtils::MultiViewParams* mp, const StaticVector<int>& cams,
+                                 int pixSizeBall, int pixSizeBallWSP, int nNearestCams);
+void computeNbConsistentCamsMaps(mvsUtils::MultiViewParams* mp, const StaticVector<int>& cams,
+                                 int pixSizeBall, int pixSizeBallWSP, int nNearestCams);
+
 } // namespace depthMap
 } // namespace aliceVision
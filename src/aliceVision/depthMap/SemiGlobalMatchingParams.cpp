@@ -5,6 +5,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "SemiGlobalMatchingParams.hpp"
+#include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
@@ -13,12 +14,14 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace depthMap {
 
 namespace bfs = boost::filesystem;
 
-SemiGlobalMatchingParams::SemiGlobalMatchingParams(mvsUtils::MultiViewParams* _mp, PlaneSweepingCuda& _cps)
+SemiGlobalMatchingParams::SemiGlobalMatchingParams(mvsUtils::MultiViewParams* _mp, PlaneSweeping& _cps)
     : cps( _cps )
 {
     mp = _mp;
@@ -50,6 +53,13 @@ SemiGlobalMatchingParams::SemiGlobalMatchingParams(mvsUtils::MultiViewParams* _m
         mp->userParams.get<bool>("semiGlobalMatching.saveDepthsToSweepToTxtForVis", false);
 
     doSGMoptimizeVolume = mp->userParams.get<bool>("semiGlobalMatching.doSGMoptimizeVolume", true);
+    doSGMstreamVolume = mp->userParams.get<bool>("semiGlobalMatching.streamVolume", false);
+    useTiles = mp->userParams.get<bool>("depthMap.useTiles", false);
+    tileOverlap = std::max(1, mp->userParams.get<int>("semiGlobalMatching.tileOverlap", 16));
+    coarseToFine = mp->userParams.get<bool>("semiGlobalMatching.coarseToFine", false);
+    coarseToFineFactor = std::max(2, mp->userParams.get<int>("semiGlobalMatching.coarseToFineFactor", 4));
+    coarseToFineTileHeight = std::max(1, mp->userParams.get<int>("semiGlobalMatching.coarseToFineTileHeight", 64));
+    coarseToFineDepthsMargin = std::max(0, mp->userParams.get<int>("semiGlobalMatching.coarseToFineDepthsMargin", 32));
     doRefineRc = mp->userParams.get<bool>("semiGlobalMatching.doRefineRc", true);
 
     modalsMapDistLimit = mp->userParams.get<int>("semiGlobalMatching.modalsMapDistLimit", 2);
@@ -11,7 +11,7 @@
 #include <aliceVision/mvsUtils/ImagesCache.hpp>
 #include <aliceVision/depthMap/DepthSimMap.hpp>
 #include <aliceVision/depthMap/RcTc.hpp>
-#include <aliceVision/depthMap/cuda/PlaneSweepingCuda.hpp>
+#include <aliceVision/depthMap/PlaneSweeping.hpp>
 
 namespace aliceVision {
 namespace depthMap {
@@ -21,7 +21,7 @@ class SemiGlobalMatchingParams
 public:
     mvsUtils::MultiViewParams* mp;
     RcTc* prt;
-    PlaneSweepingCuda& cps;
+    PlaneSweeping& cps;
     bool exportIntermediateResults;
     bool doSmooth;
     // int   s_wsh;
@@ -49,13 +49,27 @@ public:
     float maxTcRcPixSizeInVoxRatio;
     int nSGGCIters;
     bool doSGMoptimizeVolume;
+    /// stream the similarity volume from the host during the SGM optimization instead of keeping it on the device
+    bool doSGMstreamVolume;
+    /// split the reference image into overlapping tiles sized from the free device memory
+    bool useTiles;
+    /// number of rows shared by two consecutive SGM tiles (in volume pixels)
+    int tileOverlap;
+    /// run a coarse SGM first and sweep each tile only around the depths found by the coarse SGM
+    bool coarseToFine;
+    /// pixel step factor of the coarse SGM
+    int coarseToFineFactor;
+    /// number of rows of the SGM tiles in coarse-to-fine mode (in volume pixels)
+    int coarseToFineTileHeight;
+    /// number of depths swept on each side of the depth range found by the coarse SGM in a tile
+    int coarseToFineDepthsMargin;
     bool doRefineRc;
     std::string SGMoutDirName;
     std::string SGMtmpDirName;
     bool useSilhouetteMaskCodedByColor;
     rgb silhouetteMaskColor;
 
-    SemiGlobalMatchingParams(mvsUtils::MultiViewParams* _mp, PlaneSweepingCuda& _cps);
+    SemiGlobalMatchingParams(mvsUtils::MultiViewParams* _mp, PlaneSweeping& _cps);
     ~SemiGlobalMatchingParams(void);
 
     DepthSimMap* getDepthSimMapFromBestIdVal(int w, int h, StaticVector<IdValue>* volumeBestIdVal, int scale,
@@ -19,6 +19,7 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 namespace aliceVision {
@@ -39,6 +40,7 @@ SemiGlobalMatchingRc::SemiGlobalMatchingRc(int rc, int scale, int step, SemiGlob
     _sgmWsh = sp->mp->userParams.get<int>("semiGlobalMatching.wsh", 4);
     _sgmGammaC = static_cast<float>(sp->mp->userParams.get<double>("semiGlobalMatching.gammaC", 5.5));
     _sgmGammaP = static_cast<float>(sp->mp->userParams.get<double>("semiGlobalMatching.gammaP", 8.0));
+    _coarseToFine = sp->coarseToFine;
     _depthsTcamsLimits.clear();
 
     computeDepthsAndResetTCams();
@@ -186,35 +188,26 @@ StaticVector<StaticVector<float>*>* SemiGlobalMatchingRc::computeAllDepthsAndRes
     StaticVector<StaticVector<float>*>* alldepths = new StaticVector<StaticVector<float>*>();
     alldepths->reserve(_sgmTCams.size());
 
+    // depths of the current tc, its capacity is reused when the tc is rejected
+    StaticVector<float> tcdepths;
+
     for(int c = 0; c < _sgmTCams.size(); c++)
     {
         // depths of all meaningful points on the principal ray of the reference camera regarding the target camera tc
-        StaticVector<float>* tcdepths = _sp->cps.getDepthsRcTc(_rc, _sgmTCams[c], _scale, midDepth, _sp->rcTcDepthsHalfLimit);
-        if(sizeOfStaticVector<float>(tcdepths) < 50)
+        _sp->cps.getDepthsRcTc(tcdepths, _rc, _sgmTCams[c], _scale, midDepth, _sp->rcTcDepthsHalfLimit);
+        if(tcdepths.size() < 50)
         {
             // fallback if we don't have enough valid samples over the epipolar line
-            if(tcdepths != nullptr)
-            {
-                delete tcdepths;
-                tcdepths = nullptr;
-            }
             float avMinDist, avMidDist, avMaxDist;
             _sp->cps.getMinMaxdepths(_rc, _sgmTCams, avMinDist, avMidDist, avMaxDist);
-            tcdepths = _sp->cps.getDepthsByPixelSize(_rc, avMinDist, avMidDist, avMaxDist, _scale, _sp->rcDepthsCompStep);
-
-            if(sizeOfStaticVector<float>(tcdepths) < 50)
-            {
-                if(tcdepths != nullptr)
-                {
-                    delete tcdepths;
-                    tcdepths = nullptr;
-                }
-            }
+            _sp->cps.getDepthsByPixelSize(tcdepths, _rc, avMinDist, avMidDist, avMaxDist, _scale, _sp->rcDepthsCompStep);
         }
 
-        if(tcdepths != nullptr)
+        if(tcdepths.size() >= 50)
         {
-            alldepths->push_back(tcdepths);
+            StaticVector<float>* keptDepths = new StaticVector<float>();
+            keptDepths->swap(tcdepths);
+            alldepths->push_back(keptDepths);
             tcamsNew.push_back(_sgmTCams[c]);
         }
     }
@@ -401,82 +394,146 @@ void SemiGlobalMatchingRc::computeDepthsAndResetTCams()
     deleteArrayOfArrays<float>(&alldepths);
 }
 
-void SemiGlobalMatchingRc::getSubDepthsForTCam( int tcamid, std::vector<float>& out )
+Pixel SemiGlobalMatchingRc::getSubDepthsForTCam(int tcamid, const Pixel& depthsRange, std::vector<float>& out)
 {
-    out.resize(_depthsTcamsLimits[tcamid].y);
+    const int z0 = std::max(_depthsTcamsLimits[tcamid].x, depthsRange.x);
+    const int z1 = std::min(_depthsTcamsLimits[tcamid].x + _depthsTcamsLimits[tcamid].y, depthsRange.x + depthsRange.y);
 
-    for(int i = 0; i<_depthsTcamsLimits[tcamid].y; i++ )
+    out.resize(std::max(0, z1 - z0));
+
+    for(int i = 0; i < z1 - z0; i++)
     {
-        out[i] = _depths[_depthsTcamsLimits[tcamid].x + i];
+        out[i] = _depths[z0 + i];
     }
+    return Pixel(z0 - depthsRange.x, std::max(0, z1 - z0));
 }
 
-bool SemiGlobalMatchingRc::sgmrc(bool checkIfExists)
+int SemiGlobalMatchingRc::getTileHeight()
 {
-    if(_sp->mp->verbose)
-      ALICEVISION_LOG_DEBUG("SGM (rc: " << (_rc + 1) << " / " << _sp->mp->ncams << ")");
+    if(!_sp->useTiles)
+        return _height;
+
+    // the SGM optimization needs 4 times the memory of the similarity volume (see SemiGlobalMatchingVolume)
+    const float volumeRowMB = (float)_width * (float)_depths.size() / (1024.0f * 1024.0f);
+    const int nbTiles = _sp->cps.getNbPartsInDeviceMemory(4.0f * volumeRowMB * (float)_height);
+    if(nbTiles <= 1)
+        return _height;
+
+    // leave room for the overlap of the tiles
+    const int tileHeight = (_height + nbTiles - 1) / nbTiles - 2 * _sp->tileOverlap;
+    return std::max(_sp->tileOverlap, tileHeight);
+}
 
-    if(_sgmTCams.size() == 0)
-    {
-      return false;
-    }
+bool SemiGlobalMatchingRc::computeCoarseBestIdVal(StaticVector<IdValue>& out_coarseBestIdVal)
+{
+    // the depths and tcams only depend on the scale, the coarse SGM has the same
+    SemiGlobalMatchingRc coarse(_rc, _scale, _step * _sp->coarseToFineFactor, _sp);
+    coarse._coarseToFine = false;
 
-    if((mvsUtils::FileExists(_sp->getSGM_idDepthMapFileName(_sp->mp->getViewId(_rc), _scale, _step))) && (checkIfExists))
+    if((coarse._width < 3) || (coarse._height < 3) || !coarse.sgmrc(false))
+        return false;
+
+    std::swap(out_coarseBestIdVal, coarse._volumeBestIdVal);
+    return true;
+}
+
+Pixel SemiGlobalMatchingRc::getTileDepthsRange(const StaticVector<IdValue>& coarseBestIdVal, int tileY0, int tileHeight) const
+{
+    const Pixel allDepths(0, _depths.size());
+
+    if(coarseBestIdVal.empty())
+        return allDepths;
+
+    const int factor = _sp->coarseToFineFactor;
+    const int coarseWidth = _sp->mp->getWidth(_rc) / (_scale * _step * factor);
+    const int coarseHeight = coarseBestIdVal.size() / coarseWidth;
+
+    // coarse rows of the tile, with one more row on each side
+    const int cy0 = std::max(0, tileY0 / factor - 1);
+    const int cy1 = std::min(coarseHeight, (tileY0 + tileHeight - 1) / factor + 2);
+
+    std::vector<int> ids;
+    ids.reserve(std::max(0, cy1 - cy0) * coarseWidth);
+    for(int cy = cy0; cy < cy1; ++cy)
     {
-      ALICEVISION_LOG_INFO("Already computed: " + _sp->getSGM_idDepthMapFileName(_sp->mp->getViewId(_rc), _scale, _step));
-      return false;
+        for(int cx = 0; cx < coarseWidth; ++cx)
+        {
+            // skip the borders, the background and the pixels without match
+            const IdValue& idVal = coarseBestIdVal[cy * coarseWidth + cx];
+            if((idVal.id >= 0) && (idVal.value < 1.0f))
+                ids.push_back(idVal.id);
+        }
     }
 
-    long tall = clock();
+    // not enough coarse depths to trust their range
+    if(ids.size() < static_cast<std::size_t>(coarseWidth))
+        return allDepths;
 
+    const std::size_t nbOutliers = ids.size() / 100;
+    std::nth_element(ids.begin(), ids.begin() + nbOutliers, ids.end());
+    const int minId = ids[nbOutliers];
+    std::nth_element(ids.begin(), ids.end() - 1 - nbOutliers, ids.end());
+    const int maxId = ids[ids.size() - 1 - nbOutliers];
+
+    const int z0 = std::max(0, minId - _sp->coarseToFineDepthsMargin);
+    const int z1 = std::min(allDepths.y, maxId + _sp->coarseToFineDepthsMargin + 1);
+    return Pixel(z0, z1 - z0);
+}
+
+void SemiGlobalMatchingRc::computeTileVolumeBestIdVal(int tileY0, int tileHeight, StaticVectorBool* rcSilhoueteMap,
+                                                      int zborder, const Pixel& depthsRange,
+                                                      StaticVector<IdValue>& out_volumeBestIdVal)
+{
     const int volDimX = _width;
-    const int volDimY = _height;
-    const int volDimZ = _depths.size();
+    const int volDimY = tileHeight;
+    const int volDimZ = depthsRange.y;
     float volumeMBinGPUMem = 0.0f;
 
-    StaticVector<unsigned char>* simVolume = nullptr;
+    // the intermediate volumes are only exported for the whole image and all the depths
+    const bool exportVolumes = _sp->exportIntermediateResults && (tileHeight == _height) && (volDimZ == _depths.size());
 
-    StaticVectorBool* rcSilhoueteMap = nullptr;
-    if(_sp->useSilhouetteMaskCodedByColor)
-    {
-        rcSilhoueteMap = new StaticVectorBool();
-        rcSilhoueteMap->reserve(_width * _height);
-        rcSilhoueteMap->resize_with(_width * _height, true);
-        _sp->cps.getSilhoueteMap(rcSilhoueteMap, _scale, _step, _sp->silhouetteMaskColor, _rc);
-    }
+    SemiGlobalMatchingVolume* svol = nullptr;
 
+    for(int c = 0; c < _sgmTCams.size(); c++)
     {
         std::vector<float> subDepths;
-        getSubDepthsForTCam(0, subDepths);
-        SemiGlobalMatchingRcTc srt(subDepths, _rc, _sgmTCams[0], _scale, _step, _sp, rcSilhoueteMap);
-        simVolume = srt.computeDepthSimMapVolume(volumeMBinGPUMem, _sgmWsh, _sgmGammaC, _sgmGammaP);
-    }
+        const Pixel tcDepthsLimits = getSubDepthsForTCam(c, depthsRange, subDepths);
 
-    // recompute to all depths
-    volumeMBinGPUMem = ((volumeMBinGPUMem / (float)_depthsTcamsLimits[0].y) * (float)volDimZ);
+        // the tcam does not see the depths of the tile
+        if(tcDepthsLimits.y == 0)
+            continue;
 
-    SemiGlobalMatchingVolume* svol = new SemiGlobalMatchingVolume(volumeMBinGPUMem, volDimX, volDimY, volDimZ, _sp);
-    svol->copyVolume(simVolume, _depthsTcamsLimits[0].x, _depthsTcamsLimits[0].y);
-    delete simVolume;
+        SemiGlobalMatchingRcTc srt(subDepths, _rc, _sgmTCams[c], _scale, _step, _sp, rcSilhoueteMap, tileY0, tileHeight);
+        StaticVector<unsigned char>* simVolume = srt.computeDepthSimMapVolume(volumeMBinGPUMem, _sgmWsh, _sgmGammaC, _sgmGammaP);
 
-    for(int c = 1; c < _sgmTCams.size(); c++)
-    {
-        std::vector<float> subDepths;
-        getSubDepthsForTCam(c, subDepths);
-        SemiGlobalMatchingRcTc* srt = new SemiGlobalMatchingRcTc(subDepths, _rc, _sgmTCams[c], _scale, _step, _sp, rcSilhoueteMap);
-        simVolume = srt->computeDepthSimMapVolume(volumeMBinGPUMem, _sgmWsh, _sgmGammaC, _sgmGammaP);
-        delete srt;
-        svol->addVolumeSecondMin(simVolume,_depthsTcamsLimits[c].x,_depthsTcamsLimits[c].y);
+        if(svol == nullptr)
+        {
+            // recompute to all depths
+            volumeMBinGPUMem = ((volumeMBinGPUMem / (float)tcDepthsLimits.y) * (float)volDimZ);
+
+            svol = new SemiGlobalMatchingVolume(volumeMBinGPUMem, volDimX, volDimY, volDimZ, _sp);
+            svol->copyVolume(simVolume, tcDepthsLimits.x, tcDepthsLimits.y);
+        }
+        else
+        {
+            svol->addVolumeSecondMin(simVolume, tcDepthsLimits.x, tcDepthsLimits.y);
+        }
         delete simVolume;
     }
 
+    if(svol == nullptr)
+    {
+        out_volumeBestIdVal.resize_with(volDimX * volDimY, IdValue(-1, 1.0f));
+        return;
+    }
+
     //if(_sp->exportIntermediateResults)
     //  svol->exportVolume(*_depths, _rc, _scale, _step, _sp->mp->getDepthMapsFolder() + std::to_string(_sp->mp->getViewId(_rc)) + "_vol_beforeReduction.abc");
 
     // reduction of 'volume' (X, Y, Z) into 'volumeStepZ' (X, Y, Z/step)
     svol->cloneVolumeSecondStepZ();
 
-    if(_sp->exportIntermediateResults)
+    if(exportVolumes)
     {
       svol->exportVolumeStep(_depths, _rc, _scale, _step, _sp->mp->getDepthMapsFolder() + std::to_string(_sp->mp->getViewId(_rc)) + "_vol_afterReduction.abc");
       svol->export9PCSV(_depths, _rc, _scale, _step, "afterReduction", _sp->mp->getDepthMapsFolder() + std::to_string(_sp->mp->getViewId(_rc)) + "_9p.csv");
@@ -487,20 +544,110 @@ bool SemiGlobalMatchingRc::sgmrc(bool checkIfExists)
     // this is here for experimental reason ... to show how SGGC work on non
     // optimized depthmaps ... it must equals to true in normal case
     if(_sp->doSGMoptimizeVolume)
-        svol->SGMoptimizeVolumeStepZ(_rc, _step, 0, 0, _scale);
+        svol->SGMoptimizeVolumeStepZ(_rc, _step, 0, tileY0, _scale);
 
-    if(_sp->exportIntermediateResults)
+    if(exportVolumes)
     {
       svol->exportVolumeStep(_depths, _rc, _scale, _step, _sp->mp->getDepthMapsFolder() + std::to_string(_sp->mp->getViewId(_rc)) + "_vol_afterFiltering.abc");
       svol->export9PCSV(_depths, _rc, _scale, _step, "afterFiltering", _sp->mp->getDepthMapsFolder() + std::to_string(_sp->mp->getViewId(_rc)) + "_9p.csv");
     }
 
     // for each pixel: choose the voxel with the minimal similarity value
-    const int zborder = 2;
-    svol->getOrigVolumeBestIdValFromVolumeStepZ(_volumeBestIdVal, zborder);
+    svol->getOrigVolumeBestIdValFromVolumeStepZ(out_volumeBestIdVal, zborder);
 
     delete svol;
 
+    // from the indices in the depths range to the indices in all the depths
+    if(depthsRange.x > 0)
+    {
+        for(int i = 0; i < out_volumeBestIdVal.size(); i++)
+        {
+            if(out_volumeBestIdVal[i].id >= 0)
+                out_volumeBestIdVal[i].id += depthsRange.x;
+        }
+    }
+}
+
+bool SemiGlobalMatchingRc::sgmrc(bool checkIfExists)
+{
+    if(_sp->mp->verbose)
+      ALICEVISION_LOG_DEBUG("SGM (rc: " << (_rc + 1) << " / " << _sp->mp->ncams << ")");
+
+    if(_sgmTCams.size() == 0)
+    {
+      return false;
+    }
+
+    if((mvsUtils::FileExists(_sp->getSGM_idDepthMapFileName(_sp->mp->getViewId(_rc), _scale, _step))) && (checkIfExists))
+    {
+      ALICEVISION_LOG_INFO("Already computed: " + _sp->getSGM_idDepthMapFileName(_sp->mp->getViewId(_rc), _scale, _step));
+      return false;
+    }
+
+    long tall = clock();
+
+    StaticVectorBool* rcSilhoueteMap = nullptr;
+    if(_sp->useSilhouetteMaskCodedByColor)
+    {
+        rcSilhoueteMap = new StaticVectorBool();
+        rcSilhoueteMap->reserve(_width * _height);
+        rcSilhoueteMap->resize_with(_width * _height, true);
+        _sp->cps.getSilhoueteMap(rcSilhoueteMap, _scale, _step, _sp->silhouetteMaskColor, _rc);
+    }
+
+    const int zborder = 2;
+    int tileHeight = getTileHeight();
+
+    // best depth index per pixel of the coarse SGM, empty without coarse-to-fine
+    StaticVector<IdValue> coarseBestIdVal;
+    if(_coarseToFine && computeCoarseBestIdVal(coarseBestIdVal))
+        tileHeight = std::min(tileHeight, _sp->coarseToFineTileHeight);
+
+    // number of depths and rows swept, for the coarse-to-fine statistics
+    long long nbSweptDepths = 0;
+    long long nbSweptRows = 0;
+
+    if(tileHeight >= _height)
+    {
+        const Pixel depthsRange = getTileDepthsRange(coarseBestIdVal, 0, _height);
+        nbSweptDepths += (long long)depthsRange.y * _height;
+        nbSweptRows += _height;
+        computeTileVolumeBestIdVal(0, _height, rcSilhoueteMap, zborder, depthsRange, _volumeBestIdVal);
+    }
+    else
+    {
+        // the tiles overlap so that the SGM paths are not cut at the borders of the kept rows
+        const int overlap = _sp->tileOverlap;
+
+        _volumeBestIdVal.resize_with(_width * _height, IdValue(-1, 1.0f));
+
+        for(int y0 = 0; y0 < _height; y0 += tileHeight)
+        {
+            const int y1 = std::min(_height, y0 + tileHeight);
+            const int tileY0 = std::max(0, y0 - overlap);
+            const int tileY1 = std::min(_height, y1 + overlap);
+
+            ALICEVISION_LOG_INFO("SGM (rc: " << _rc << ") tile rows [" << y0 << ", " << y1 << "[ of " << _height);
+
+            const Pixel depthsRange = getTileDepthsRange(coarseBestIdVal, tileY0, tileY1 - tileY0);
+            nbSweptDepths += (long long)depthsRange.y * (tileY1 - tileY0);
+            nbSweptRows += tileY1 - tileY0;
+
+            StaticVector<IdValue> tileBestIdVal;
+            computeTileVolumeBestIdVal(tileY0, tileY1 - tileY0, rcSilhoueteMap, zborder, depthsRange, tileBestIdVal);
+
+            for(int y = y0; y < y1; y++)
+                std::copy_n(tileBestIdVal.getData().begin() + (y - tileY0) * _width, _width,
+                            _volumeBestIdVal.getDataWritable().begin() + y * _width);
+        }
+    }
+
+    if(!coarseBestIdVal.empty())
+    {
+        ALICEVISION_LOG_INFO("SGM (rc: " << _rc << ") coarse-to-fine: " << nbSweptDepths / nbSweptRows
+                             << " depths swept per pixel on average instead of " << _depths.size() << ".");
+    }
+
     if(rcSilhoueteMap != nullptr)
     {
         for(int i = 0; i < _width * _height; i++)
@@ -32,6 +32,8 @@ protected:
     int _sgmWsh;
     float _sgmGammaC;
     float _sgmGammaP;
+    /// run a coarse SGM first to restrict the depths swept in each tile
+    bool _coarseToFine;
 
     StaticVector<int> _sgmTCams;
     StaticVector<Pixel> _depthsTcamsLimits;
@@ -58,7 +60,40 @@ private:
     void computeDepthsTcamsLimits(StaticVector<StaticVector<float>*>* alldepths);
     void computeDepths(float minDepth, float maxDepth, StaticVector<StaticVector<float>*>* alldepths);
     void computeDepthsAndResetTCams();
-    void getSubDepthsForTCam(int tcamid, std::vector<float>& subDepths);
+
+    /**
+     * @brief Get the depths of a tcam in the depth indices range [depthsRange.x, depthsRange.x + depthsRange.y[.
+     * @return the index range of these depths in depthsRange, with no depth if the tcam does not see the range
+     */
+    Pixel getSubDepthsForTCam(int tcamid, const Pixel& depthsRange, std::vector<float>& subDepths);
+
+    /**
+     * @brief Number of rows of the SGM tiles, without their overlap.
+     *        The tiles are sized from the free device memory, the whole image is a single tile without tiling.
+     */
+    int getTileHeight();
+
+    /**
+     * @brief Compute the SGM with a pixel step coarseToFineFactor times larger, on the same depths.
+     * @param[out] out_coarseBestIdVal the best depth index per pixel of the coarse SGM
+     * @return false if the coarse SGM cannot be computed
+     */
+    bool computeCoarseBestIdVal(StaticVector<IdValue>& out_coarseBestIdVal);
+
+    /**
+     * @brief Get the depth indices range to sweep for the rows [tileY0, tileY0 + tileHeight[:
+     *        the range of the coarse SGM depths of these rows, without 1% of outliers on each side,
+     *        inflated by coarseToFineDepthsMargin. All the depths without coarse SGM.
+     * @return the first depth index and the number of depths
+     */
+    Pixel getTileDepthsRange(const StaticVector<IdValue>& coarseBestIdVal, int tileY0, int tileHeight) const;
+
+    /**
+     * @brief Compute the similarity volume of the rows [tileY0, tileY0 + tileHeight[ for all the tcams
+     *        and the depth indices range depthsRange, optimize it and choose the best depth index per pixel.
+     */
+    void computeTileVolumeBestIdVal(int tileY0, int tileHeight, StaticVectorBool* rcSilhoueteMap, int zborder,
+                                    const Pixel& depthsRange, StaticVector<IdValue>& out_volumeBestIdVal);
 };
 
 } // namespace depthMap
@@ -17,14 +17,17 @@ SemiGlobalMatchingRcTc::SemiGlobalMatchingRcTc(
                          int scale,
                          int step,
                          SemiGlobalMatchingParams* _sp,
-                         StaticVectorBool* _rcSilhoueteMap)
+                         StaticVectorBool* _rcSilhoueteMap,
+                         int tileY0,
+                         int tileHeight)
     : rcTcDepths(_rcTcDepths)
     , sp( _sp )
     , rc( _rc )
     , _scale( scale )
     , _step( step )
     , _w( sp->mp->getWidth(rc) / (scale * step) )
-    , _h( sp->mp->getHeight(rc) / (scale * step) )
+    , _h( (tileHeight < 0) ? sp->mp->getHeight(rc) / (scale * step) : tileHeight )
+    , _tileY0( tileY0 )
 {
     tc = _tc;
     epipShift = 0.0f;
@@ -47,16 +50,17 @@ StaticVector<Voxel>* SemiGlobalMatchingRcTc::getPixels()
     {
         for(int x = 0; x < _w; x++)
         {
+            const int imageY = _tileY0 + y;
             if(rcSilhoueteMap == nullptr)
             {
-                pixels->push_back(Voxel(x * _step, y * _step, 0));
+                pixels->push_back(Voxel(x * _step, imageY * _step, 0));
             }
             else
             {
-                bool isBackgroundPixel = (*rcSilhoueteMap)[y * _w + x];
+                bool isBackgroundPixel = (*rcSilhoueteMap)[imageY * _w + x];
                 if(!isBackgroundPixel)
                 {
-                    pixels->push_back(Voxel(x * _step, y * _step, 0));
+                    pixels->push_back(Voxel(x * _step, imageY * _step, 0));
                 }
             }
         }
@@ -84,7 +88,7 @@ StaticVector<unsigned char>* SemiGlobalMatchingRcTc::computeDepthSimMapVolume(fl
     StaticVector<Voxel>* pixels = getPixels();
 
     volumeMBinGPUMem =
-        sp->cps.sweepPixelsToVolume(rcTcDepths.size(), volume, volDimX, volDimY, volDimZ, volStepXY, 0, 0, 0,
+        sp->cps.sweepPixelsToVolume(rcTcDepths.size(), volume, volDimX, volDimY, volDimZ, volStepXY, 0, _tileY0 * _step, 0,
                                      &rcTcDepths, rc, wsh, gammaC, gammaP, pixels, _scale, 1, tcams, 0.0f);
     delete pixels;
 
@@ -16,8 +16,12 @@ namespace depthMap {
 class SemiGlobalMatchingRcTc
 {
 public:
+    /**
+     * @param[in] _tileY0 first row of the tile of the reference image (in volume pixels)
+     * @param[in] _tileHeight number of rows of the tile, -1 for the whole image
+     */
     SemiGlobalMatchingRcTc(const std::vector<float>& _rcTcDepths, int _rc, int _tc, int _scale, int _step, SemiGlobalMatchingParams* _sp,
-                StaticVectorBool* _rcSilhoueteMap = NULL);
+                StaticVectorBool* _rcSilhoueteMap = NULL, int _tileY0 = 0, int _tileHeight = -1);
     ~SemiGlobalMatchingRcTc(void);
 
     StaticVector<unsigned char>* computeDepthSimMapVolume(float& volumeMBinGPUMem, int wsh, float gammaC, float gammaP);
@@ -34,6 +38,7 @@ private:
     const int _step;
     const int _w;
     const int _h;
+    const int _tileY0;
     float epipShift;
     // int w, h;
     StaticVectorBool* rcSilhoueteMap;
@@ -6,6 +6,7 @@
 
 #include "SemiGlobalMatchingVolume.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/jetColorMap.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
@@ -265,7 +266,7 @@ void SemiGlobalMatchingVolume::SGMoptimizeVolumeStepZ(int rc, int volStepXY, int
     long tall = clock();
 
     sp->cps.SGMoptimizeSimVolume(rc, _volumeStepZ, volDimX, volDimY, volDimZ / volStepZ, volStepXY, volLUX, volLUY,
-                                  scale, sp->P1, sp->P2);
+                                  scale, sp->P1, sp->P2, sp->doSGMstreamVolume);
 
     if(sp->mp->verbose)
         mvsUtils::printfElapsedTime(tall, "SemiGlobalMatchingVolume::SGMoptimizeVolumeStepZ");
@@ -0,0 +1,263 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PlaneSweepingCpu.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <iterator>
+
+namespace aliceVision {
+namespace depthMap {
+
+PlaneSweepingCpu::PlaneSweepingCpu(mvsUtils::ImagesCache& ic, mvsUtils::MultiViewParams* _mp, int scales)
+    : PlaneSweeping(ic, _mp, scales)
+{
+    const int maxImageWidth = mp->getMaxImageWidth();
+    const int maxImageHeight = mp->getMaxImageHeight();
+
+    float oneimagemb = 4.0f * (((float)(maxImageWidth * maxImageHeight) / 1024.0f) / 1024.0f);
+    for(int scale = 2; scale <= _scales; ++scale)
+    {
+        oneimagemb += 4.0 * (((float)((maxImageWidth / scale) * (maxImageHeight / scale)) / 1024.0) / 1024.0);
+    }
+
+    // same cache size as on the device, from the available system memory
+    const float imagesCacheMemoryRatio =
+        static_cast<float>(mp->userParams.get<double>("images_cache.gpuMemoryRatio", 0.3));
+    const float maxmb = imagesCacheMemoryRatio * getDeviceMemoryInfo().x;
+    int nImgsAtTime = (int)(maxmb / oneimagemb);
+    nImgsAtTime = std::max(2, std::min(mp->ncams, nImgsAtTime));
+
+    varianceWSH = mp->userParams.get<int>("global.varianceWSH", 4);
+
+    ALICEVISION_LOG_INFO("PlaneSweepingCpu:" << std::endl
+                         << "\t- nImgsAtTime: " << nImgsAtTime << " (" << nImgsAtTime * oneimagemb << " MB)" << std::endl
+                         << "\t- scales: " << _scales << std::endl
+                         << "\t- varianceWSH: " << varianceWSH);
+
+    _camsImages.resize(nImgsAtTime);
+    _camsRcs.assign(nImgsAtTime, -1);
+    _camsTimes.assign(nImgsAtTime, 0);
+}
+
+const LabImage& PlaneSweepingCpu::getLabImage(int camIndex, int scale)
+{
+    auto it = std::find(_camsRcs.begin(), _camsRcs.end(), camIndex);
+    if(it == _camsRcs.end())
+    {
+        // get the least recently used slot
+        it = _camsRcs.begin() + std::distance(_camsTimes.begin(), std::min_element(_camsTimes.begin(), _camsTimes.end()));
+        std::vector<LabImage>& images = _camsImages[std::distance(_camsRcs.begin(), it)];
+
+        long t1 = clock();
+
+        // the scales are downscaled from the full resolution Lab image
+        images.resize(_scales);
+        computeLabImage(images[0], *_ic.getImg_sync(camIndex), varianceWSH);
+        for(int s = 1; s < _scales; ++s)
+            downscaleLabImage(images[s], images[0], s + 1, varianceWSH);
+
+        if(_verbose)
+            mvsUtils::printfElapsedTime(t1, "compute Lab images ");
+
+        *it = camIndex;
+    }
+    const std::size_t id = std::distance(_camsRcs.begin(), it);
+    _camsTimes[id] = ++_imagesCacheAccess;
+    return _camsImages[id][scale - 1];
+}
+
+bool PlaneSweepingCpu::refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                                          StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh,
+                                          float gammaC, float gammaP, float epipShift, int xFrom, int wPart)
+{
+    const int w = wPart;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    if(_verbose)
+        ALICEVISION_LOG_DEBUG("\t- rc: " << rc << std::endl << "\t- tcams: " << tc);
+
+    const LabImage& rcImage = getLabImage(rc, scale);
+    const LabImage& tcImage = getLabImage(tc, scale);
+
+    refineDepthMap(simMap->getDataWritable(), rcDepthMap->getDataWritable(), w, h, xFrom,
+                   getCameraStruct(*mp, rc, scale), getCameraStruct(*mp, tc, scale), rcImage, tcImage,
+                   mp->getWidth(rc) / scale, mp->getHeight(rc) / scale, nStepsToRefine, wsh, gammaC, gammaP,
+                   epipShift, useTcOrRcPixSize);
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+float PlaneSweepingCpu::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX,
+                                            int volDimY, int volDimZ, int volStepXY, int volLUX, int volLUY,
+                                            int volLUZ, const std::vector<float>* depths, int rc, int wsh,
+                                            float gammaC, float gammaP, StaticVector<Voxel>* pixels, int scale,
+                                            int step, StaticVector<int>* tcams, float epipShift)
+{
+    if(_verbose)
+        ALICEVISION_LOG_DEBUG("sweepPixelsVolume:" << std::endl
+                              << "\t- scale: " << scale << std::endl
+                              << "\t- step: " << step << std::endl
+                              << "\t- npixels: " << pixels->size() << std::endl
+                              << "\t- volStepXY: " << volStepXY << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    if((tcams->size() == 0) || (pixels->size() == 0))
+        return -1.0f;
+
+    // as on the device, only the first tc is used
+    const int tc = (*tcams)[0];
+    const LabImage& rcImage = getLabImage(rc, scale);
+    const LabImage& tcImage = getLabImage(tc, scale);
+
+    depthMap::sweepPixelsToVolume(volume->getDataWritable(), volDimX, volDimY, volDimZ, volStepXY, volLUX, volLUY,
+                                  volLUZ, *depths, pixels->getData(), nDepthsToSearch,
+                                  getCameraStruct(*mp, rc, scale), getCameraStruct(*mp, tc, scale), rcImage,
+                                  tcImage, wsh, w, h, gammaC, gammaP, epipShift);
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return (float)volDimX * (float)volDimY * (float)volDimZ / (1024.0f * 1024.0f);
+}
+
+bool PlaneSweepingCpu::SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                                            int volDimZ, int volStepXY, int volLUX, int volLUY, int scale,
+                                            unsigned char P1, unsigned char P2, bool streamVolume)
+{
+    if(_verbose)
+        ALICEVISION_LOG_DEBUG("SGM optimizing volume:" << std::endl
+                              << "\t- volDimX: " << volDimX << std::endl
+                              << "\t- volDimY: " << volDimY << std::endl
+                              << "\t- volDimZ: " << volDimZ);
+
+    long t1 = clock();
+
+    // as on the device, P2 is computed from the color gradient of the rc image
+    // and the volume is always in the system memory (streamVolume has no effect)
+    optimizeSimVolumeSGM(volume->getDataWritable(), volDimX, volDimY, volDimZ, volLUX, volLUY,
+                         getLabImage(rc, scale), P1);
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+// make_float3(avail,total,used)
+Point3d PlaneSweepingCpu::getDeviceMemoryInfo()
+{
+    const system::MemoryInfo memInfo = system::getMemoryInfo();
+    const double toMB = 1.0 / (1024.0 * 1024.0);
+    return Point3d(memInfo.availableRam * toMB, memInfo.totalRam * toMB,
+                   (memInfo.totalRam - memInfo.availableRam) * toMB);
+}
+
+bool PlaneSweepingCpu::fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                                            const StaticVector<StaticVector<DepthSim>*>* dataMaps,
+                                                            int nSamplesHalf, int nDepthsToRefine, float sigma)
+{
+    long t1 = clock();
+
+    std::vector<const StaticVector<DepthSim>*> maps(dataMaps->getData().begin(), dataMaps->getData().end());
+    depthMap::fuseDepthSimMapsGaussianKernelVoting(w, h, *oDepthSimMap, maps, nSamplesHalf, nDepthsToRefine, sigma);
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                                          StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc,
+                                                          int nSamplesHalf, int nDepthsToRefine, float sigma,
+                                                          int nIters, int yFrom, int hPart)
+{
+    if(_verbose)
+        ALICEVISION_LOG_DEBUG("optimizeDepthSimMapGradientDescent.");
+
+    const int scale = 1;
+    const int w = mp->getWidth(rc);
+    const int h = hPart;
+
+    long t1 = clock();
+
+    // the part of the middle depth/pixSize and fused depth/sim maps
+    std::vector<DepthSim> midDepthPixSizeMap(w * h);
+    std::vector<DepthSim> fusedDepthSimMap(w * h);
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+        {
+            const int jO = (y + yFrom) * w + x;
+            midDepthPixSizeMap[y * w + x] = (*(*dataMaps)[0])[jO];
+            fusedDepthSimMap[y * w + x] = (*(*dataMaps)[1])[jO];
+        }
+    }
+
+    std::vector<DepthSim> optDepthSimMap;
+    depthMap::optimizeDepthSimMapGradientDescent(w, h, optDepthSimMap, midDepthPixSizeMap, fusedDepthSimMap,
+                                                 getCameraStruct(*mp, rc, scale), getLabImage(rc, scale),
+                                                 nSamplesHalf, nDepthsToRefine, nIters, yFrom);
+
+    for(int y = 0; y < h; ++y)
+    {
+        for(int x = 0; x < w; ++x)
+            (*oDepthSimMap)[(y + yFrom) * w + x] = optDepthSimMap[y * w + x];
+    }
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+bool PlaneSweepingCpu::getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc)
+{
+    if(_verbose)
+        ALICEVISION_LOG_DEBUG("getSilhoueteeMap: rc: " << rc);
+
+    const int w = mp->getWidth(rc) / scale;
+    const int h = mp->getHeight(rc) / scale;
+
+    long t1 = clock();
+
+    const LabImage& image = getLabImage(rc, scale);
+    const LabTexel maskLab = rgb2lab(Color(maskColor.r / 255.0f, maskColor.g / 255.0f, maskColor.b / 255.0f));
+
+    for(int y = 0; y < h / step; ++y)
+    {
+        for(int x = 0; x < w / step; ++x)
+        {
+            const LabTexel& texel = image.at(x * step, y * step);
+            (*oMap)[y * (w / step) + x] = (texel.x == maskLab.x) && (texel.y == maskLab.y) && (texel.z == maskLab.z);
+        }
+    }
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1);
+
+    return true;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
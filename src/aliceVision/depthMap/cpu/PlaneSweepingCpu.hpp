@@ -0,0 +1,73 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/depthMap/PlaneSweeping.hpp>
+#include <aliceVision/depthMap/cpu/planeSweepingKernels.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Plane sweeping on the host, used when no CUDA device is available.
+ *        The Lab images of the cameras at all the scales are kept in a cache in the system memory,
+ *        the results are the same as the device ones up to the floating point precision.
+ */
+class PlaneSweepingCpu : public PlaneSweeping
+{
+public:
+    int varianceWSH;
+
+    PlaneSweepingCpu(mvsUtils::ImagesCache& ic, mvsUtils::MultiViewParams* _mp, int scales);
+    ~PlaneSweepingCpu() override = default;
+
+    /**
+     * @brief Get the Lab image of a camera at a scale, compute the images of the camera if they are not cached.
+     * @param[in] camIndex the camera index
+     * @param[in] scale the scale (1 for the full resolution)
+     */
+    const LabImage& getLabImage(int camIndex, int scale);
+
+    bool refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
+                            StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
+                            float gammaP, float epipShift, int xFrom, int wPart) override;
+
+    float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
+                              int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
+                              const std::vector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
+                              StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
+                              float epipShift) override;
+    bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
+                              int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1, unsigned char P2,
+                              bool streamVolume) override;
+
+    /// make_float3(avail,total,used) of the system memory in MB
+    Point3d getDeviceMemoryInfo() override;
+
+    bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>* oDepthSimMap,
+                                              const StaticVector<StaticVector<DepthSim>*>* dataMaps, int nSamplesHalf,
+                                              int nDepthsToRefine, float sigma) override;
+    bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim>* oDepthSimMap,
+                                            StaticVector<StaticVector<DepthSim>*>* dataMaps, int rc, int nSamplesHalf,
+                                            int nDepthsToRefine, float sigma, int nIters, int yFrom,
+                                            int hPart) override;
+    bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc) override;
+
+private:
+    /// Lab images of the cached cameras, one image per scale
+    std::vector<std::vector<LabImage>> _camsImages;
+    /// camera index of each cache slot, -1 if empty
+    std::vector<int> _camsRcs;
+    /// last access of each cache slot, the slot with the smallest access is evicted first
+    std::vector<long> _camsTimes;
+    long _imagesCacheAccess = 0;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,709 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "planeSweepingKernels.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/mvsData/geometry.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+/// Truncation of a float to unsigned char, saturated as the device conversion
+inline unsigned char toUChar(float v)
+{
+    return static_cast<unsigned char>(std::max(0.0f, std::min(255.0f, v)));
+}
+
+inline Point2d project3DPoint(const Matrix3x4& P, const Point3d& p)
+{
+    const Point3d pp = P * p;
+    return Point2d(pp.x / pp.z, pp.y / pp.z);
+}
+
+inline float euclidean3(const Point4d& a, const Point4d& b)
+{
+    return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+}
+
+inline float sigmoid(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((xval - sigMid) / sigwidth))));
+}
+
+inline float sigmoid2(float zeroVal, float endVal, float sigwidth, float sigMid, float xval)
+{
+    return zeroVal + (endVal - zeroVal) * (1.0f / (1.0f + std::exp(10.0f * ((sigMid - xval) / sigwidth))));
+}
+
+/// Size of the rc pixel at the 3D point p
+inline float computeRcPixSize(const CameraStruct& rcCam, const Point3d& p)
+{
+    const Point2d rp = project3DPoint(rcCam.P, p);
+    const Point3d refvect = (rcCam.iP * (rp + Point2d(1.0, 0.0))).normalize();
+    return pointLineDistance3D(p, rcCam.C, refvect);
+}
+
+/// Gradient norm of L at (x, y)
+inline unsigned char computeGradientSizeOfL(const LabImage& image, int x, int y)
+{
+    const float dx = float(image.at(x - 1, y).x) - float(image.at(x + 1, y).x);
+    const float dy = float(image.at(x, y - 1).x) - float(image.at(x, y + 1).x);
+    return toUChar(std::sqrt(dx * dx + dy * dy));
+}
+
+void computeGradientOfL(LabImage& image)
+{
+    std::vector<unsigned char> grad(image.texels.size());
+
+    #pragma omp parallel for
+    for(int y = 0; y < image.height; ++y)
+        for(int x = 0; x < image.width; ++x)
+            grad[y * image.width + x] = computeGradientSizeOfL(image, x, y);
+
+    for(std::size_t i = 0; i < grad.size(); ++i)
+        image.texels[i].w = grad[i];
+}
+
+/// Patch of the 3D point p oriented between rc and tc (same as computeRotCSEpip)
+struct Patch
+{
+    Point3d p;
+    Point3d x;
+    Point3d y;
+    float d;
+};
+
+inline void computeRotCSEpip(Patch& ptch, const CameraStruct& rcCam, const CameraStruct& tcCam)
+{
+    const Point3d v1 = (rcCam.C - ptch.p).normalize();
+    const Point3d v2 = (tcCam.C - ptch.p).normalize();
+
+    ptch.y = cross(v1, v2).normalize();
+    const Point3d n = ((v1 + v2) / 2.0).normalize();
+    ptch.x = cross(ptch.y, n).normalize();
+}
+
+inline float computePatchSimilarity(const CameraStruct& rcCam, const CameraStruct& tcCam, const LabImage& rcImage,
+                                    const LabImage& tcImage, const Patch& ptch, int wsh, int width, int height,
+                                    float gammaC, float gammaP, float epipShift)
+{
+    const Point2d rp = project3DPoint(rcCam.P, ptch.p);
+    Point2d tp = project3DPoint(tcCam.P, ptch.p);
+
+    // assuming that ptch.y is ortogonal to epipolar plane
+    const Point2d tvUp = (project3DPoint(tcCam.P, ptch.p + ptch.y * (ptch.d * 10.0f)) - tp).normalize();
+    const Point2d vEpipShift = tvUp * epipShift;
+    tp = tp + vEpipShift;
+
+    const float dd = wsh + 2.0f;
+    if((rp.x < dd) || (rp.x > (float)(width - 1) - dd) || (rp.y < dd) || (rp.y > (float)(height - 1) - dd) ||
+       (tp.x < dd) || (tp.x > (float)(width - 1) - dd) || (tp.y < dd) || (tp.y > (float)(height - 1) - dd))
+    {
+        return 1.0f;
+    }
+
+    const Point4d gcr = rcImage.sample(rp.x, rp.y);
+    const Point4d gct = tcImage.sample(tp.x, tp.y);
+
+    SimStat sst;
+    for(int yp = -wsh; yp <= wsh; ++yp)
+    {
+        for(int xp = -wsh; xp <= wsh; ++xp)
+        {
+            const Point3d p = ptch.p + ptch.x * (ptch.d * (float)xp) + ptch.y * (ptch.d * (float)yp);
+            const Point2d rp1 = project3DPoint(rcCam.P, p);
+            const Point2d tp1 = project3DPoint(tcCam.P, p) + vEpipShift;
+
+            const Point4d gcr1 = rcImage.sample(rp1.x, rp1.y);
+            const Point4d gct1 = tcImage.sample(tp1.x, tp1.y);
+
+            // support weight of Yoon & Kweon, from the color difference to the patch center and the distance to it
+            const float deltaP = std::sqrt(float(xp * xp + yp * yp));
+            const float w = std::exp(-(euclidean3(gcr, gcr1) / gammaC + deltaP / gammaP)) *
+                            std::exp(-(euclidean3(gct, gct1) / gammaC + deltaP / gammaP));
+            sst.update(gcr1.x, gct1.x, w);
+        }
+    }
+    return sst.computeWSim();
+}
+
+inline float refinePatchSimilarity(const CameraStruct& rcCam, const CameraStruct& tcCam, const LabImage& rcImage,
+                                   const LabImage& tcImage, const Point3d& p, int wsh, int width, int height,
+                                   float gammaC, float gammaP, float epipShift)
+{
+    Patch ptch;
+    ptch.p = p;
+    ptch.d = computeRcPixSize(rcCam, p);
+    computeRotCSEpip(ptch, rcCam, tcCam);
+    return computePatchSimilarity(rcCam, tcCam, rcImage, tcImage, ptch, wsh, width, height, gammaC, gammaP, epipShift);
+}
+
+/// Same as triangulateMatchRef: the point of the rc ray closest to the tc ray
+inline Point3d triangulateMatchRef(const CameraStruct& rcCam, const CameraStruct& tcCam, const Point2d& refpix,
+                                   const Point2d& tarpix)
+{
+    const Point3d refvect = (rcCam.iP * refpix).normalize();
+    const Point3d tarvect = (tcCam.iP * tarpix).normalize();
+
+    float k, l;
+    Point3d lli1, lli2, llis;
+    lineLineIntersect(&k, &l, &llis, &lli1, &lli2, rcCam.C, rcCam.C + refvect, tcCam.C, tcCam.C + tarvect);
+
+    return rcCam.C + refvect * k;
+}
+
+} // namespace
+
+Point4d LabImage::sample(float x, float y) const
+{
+    const int x0 = (int)std::floor(x);
+    const int y0 = (int)std::floor(y);
+    const float fx = x - (float)x0;
+    const float fy = y - (float)y0;
+
+    const LabTexel& t00 = at(x0, y0);
+    const LabTexel& t10 = at(x0 + 1, y0);
+    const LabTexel& t01 = at(x0, y0 + 1);
+    const LabTexel& t11 = at(x0 + 1, y0 + 1);
+
+    const auto lerp2 = [&](unsigned char v00, unsigned char v10, unsigned char v01, unsigned char v11) {
+        return (1.0f - fy) * ((1.0f - fx) * v00 + fx * v10) + fy * ((1.0f - fx) * v01 + fx * v11);
+    };
+
+    return Point4d(lerp2(t00.x, t10.x, t01.x, t11.x), lerp2(t00.y, t10.y, t01.y, t11.y),
+                   lerp2(t00.z, t10.z, t01.z, t11.z), lerp2(t00.w, t10.w, t01.w, t11.w));
+}
+
+CameraStruct getCameraStruct(const mvsUtils::MultiViewParams& mp, int c, int scale)
+{
+    const Matrix3x3 K = diag3x3(1.0 / (double)scale, 1.0 / (double)scale, 1.0) * mp.KArr[c];
+
+    CameraStruct cam;
+    cam.C = mp.CArr[c];
+    cam.P = K * (mp.RArr[c] | (Point3d(0.0, 0.0, 0.0) - mp.RArr[c] * mp.CArr[c]));
+    cam.iP = mp.iRArr[c] * K.inverse();
+    cam.ZVect = (mp.iRArr[c] * Point3d(0.0, 0.0, 1.0)).normalize();
+    return cam;
+}
+
+LabTexel rgb2lab(const Color& rgb)
+{
+    // linear RGB to XYZ
+    const float X = 0.4124564f * rgb.r + 0.3575761f * rgb.g + 0.1804375f * rgb.b;
+    const float Y = 0.2126729f * rgb.r + 0.7151522f * rgb.g + 0.0721750f * rgb.b;
+    const float Z = 0.0193339f * rgb.r + 0.1191920f * rgb.g + 0.9503041f * rgb.b;
+
+    // XYZ to Lab, assuming whitepoint D65, XYZ=(0.95047, 1.00000, 1.08883)
+    const auto f = [](float v) { return v > 216.0f / 24389.0f ? std::cbrt(v) : (24389.0f / 27.0f * v + 16.0f) / 116.0f; };
+    const float fx = f(X / 0.95047f);
+    const float fy = f(Y);
+    const float fz = f(Z / 1.08883f);
+
+    LabTexel lab;
+    lab.x = toUChar((116.0f * fy - 16.0f) * 2.55f);
+    lab.y = toUChar(500.0f * (fx - fy) * 2.55f);
+    lab.z = toUChar(200.0f * (fy - fz) * 2.55f);
+    lab.w = 0;
+    return lab;
+}
+
+void computeLabImage(LabImage& out, const Image& rgb, int varianceWsh)
+{
+    out.width = rgb.width();
+    out.height = rgb.height();
+    out.texels.resize(out.width * out.height);
+
+    // the device images are uploaded as uchar
+    const auto quantize = [](float v) { return (float)toUChar(v * 255.0f) / 255.0f; };
+
+    #pragma omp parallel for
+    for(int y = 0; y < out.height; ++y)
+    {
+        for(int x = 0; x < out.width; ++x)
+        {
+            const Color& c = rgb.at(x, y);
+            out.texels[y * out.width + x] = rgb2lab(Color(quantize(c.r), quantize(c.g), quantize(c.b)));
+        }
+    }
+
+    if(varianceWsh > 0)
+        computeGradientOfL(out);
+}
+
+void downscaleLabImage(LabImage& out, const LabImage& in, int downscale, int varianceWsh)
+{
+    const int radius = downscale;
+
+    std::vector<float> gaussian(2 * radius + 1);
+    for(int i = -radius; i <= radius; ++i)
+        gaussian[i + radius] = std::exp(-float(i * i) / 2.0f);
+
+    out.width = in.width / downscale;
+    out.height = in.height / downscale;
+    out.texels.resize(out.width * out.height);
+
+    #pragma omp parallel for
+    for(int y = 0; y < out.height; ++y)
+    {
+        for(int x = 0; x < out.width; ++x)
+        {
+            Point4d t(0.0f, 0.0f, 0.0f, 0.0f);
+            float sum = 0.0f;
+            for(int i = -radius; i <= radius; ++i)
+            {
+                for(int j = -radius; j <= radius; ++j)
+                {
+                    // same texel position as tex2D(x * scale + j + scale / 2, y * scale + i + scale / 2)
+                    const Point4d curPix = in.sample((float)(x * downscale + j) + (float)downscale / 2.0f - 0.5f,
+                                                     (float)(y * downscale + i) + (float)downscale / 2.0f - 0.5f);
+                    const float factor = gaussian[i + radius] * gaussian[j + radius];
+                    t = t + curPix * factor;
+                    sum += factor;
+                }
+            }
+            LabTexel& texel = out.texels[y * out.width + x];
+            texel.x = toUChar(t.x / sum);
+            texel.y = toUChar(t.y / sum);
+            texel.z = toUChar(t.z / sum);
+            texel.w = toUChar(t.w / sum);
+        }
+    }
+
+    if(varianceWsh > 0)
+        computeGradientOfL(out);
+}
+
+float SimStat::computeWSim() const
+{
+    const double varX = (xxsum - xsum * xsum / wsum) / wsum;
+    const double varY = (yysum - ysum * ysum / wsum) / wsum;
+    const double varXY = (xysum - xsum * ysum / wsum) / wsum;
+
+    float sim = (float)(varXY / std::sqrt(varX * varY));
+    sim = std::isinf(sim) ? 1.0f : 0.0f - sim;
+    // fmaxf / fminf of the device return the number for a NaN, the NaN of a null variance gives 1
+    if(std::isnan(sim))
+        return 1.0f;
+    return std::max(std::min(sim, 1.0f), -1.0f);
+}
+
+float computePatchSimilarity(const CameraStruct& rcCam, const CameraStruct& tcCam, const LabImage& rcImage,
+                             const LabImage& tcImage, const Point3d& p, int wsh, int width, int height, float gammaC,
+                             float gammaP, float epipShift)
+{
+    return refinePatchSimilarity(rcCam, tcCam, rcImage, tcImage, p, wsh, width, height, gammaC, gammaP, epipShift);
+}
+
+void sweepPixelsToVolume(std::vector<unsigned char>& volume, int volDimX, int volDimY, int volDimZ, int volStepXY,
+                         int volLUX, int volLUY, int volLUZ, const std::vector<float>& depths,
+                         const std::vector<Voxel>& pixels, int nDepthsToSearch, const CameraStruct& rcCam,
+                         const CameraStruct& tcCam, const LabImage& rcImage, const LabImage& tcImage, int wsh,
+                         int width, int height, float gammaC, float gammaP, float epipShift)
+{
+    volume.assign(volDimX * volDimY * volDimZ, 255);
+
+    // the pixels are unique, each one updates its own voxels
+    #pragma omp parallel for
+    for(int i = 0; i < (int)pixels.size(); ++i)
+    {
+        const Voxel& pix = pixels[i];
+        const int vx = (pix.x - volLUX) / volStepXY;
+        const int vy = (pix.y - volLUY) / volStepXY;
+        if((vx < 0) || (vx >= volDimX) || (vy < 0) || (vy >= volDimY))
+            continue;
+
+        const Point3d ray = (rcCam.iP * Point2d((double)pix.x, (double)pix.y)).normalize();
+
+        for(int sdptid = 0; sdptid < nDepthsToSearch; ++sdptid)
+        {
+            const int depthid = sdptid + pix.z;
+            const int vz = depthid - volLUZ;
+            if((depthid >= (int)depths.size()) || (vz < 0) || (vz >= volDimZ))
+                continue;
+
+            // 3D point of the pixel on the fronto-parallel plane of the depth
+            Patch ptch;
+            ptch.p = linePlaneIntersect(rcCam.C, ray, rcCam.C + rcCam.ZVect * depths[depthid], rcCam.ZVect);
+            ptch.d = computeRcPixSize(rcCam, ptch.p);
+            computeRotCSEpip(ptch, rcCam, tcCam);
+
+            float fsim = computePatchSimilarity(rcCam, tcCam, rcImage, tcImage, ptch, wsh, width, height, gammaC,
+                                                gammaP, epipShift);
+            fsim = std::min(1.0f, std::max(0.0f, (fsim + 1.0f) / 2.0f));
+            const unsigned char sim = (unsigned char)(fsim * 255.0f);
+
+            unsigned char& volSim = volume[vz * volDimX * volDimY + vy * volDimX + vx];
+            volSim = std::min(sim, volSim);
+        }
+    }
+}
+
+float refineDepthSubPixel(const Point3d& depths, const Point3d& sims)
+{
+    const float simM1 = (sims.x + 1.0f) / 2.0f;
+    const float sim = (sims.y + 1.0f) / 2.0f;
+    const float simP1 = (sims.z + 1.0f) / 2.0f;
+
+    // sub-pixel refinement only if the middle similarity is the minimum of the three
+    if((simM1 > sim) && (simP1 > sim))
+    {
+        const float dispStep = -((simP1 - simM1) / (2.0f * (simP1 + simM1 - 2.0f * sim)));
+        const float b = (depths.z + depths.x) / 2.0f;
+        const float a = b - depths.x;
+        return a * dispStep + b;
+    }
+    return -1.0f;
+}
+
+void move3DPointByTcOrRcPixStep(const CameraStruct& rcCam, const CameraStruct& tcCam, Point3d& p, float pixStep,
+                                bool moveByTcOrRc)
+{
+    if(moveByTcOrRc)
+    {
+        const Point3d rpp = rcCam.P * p;
+        const Point2d rp = (rpp.z < 0.0) ? Point2d(-1.0, -1.0) : Point2d(rpp.x / rpp.z, rpp.y / rpp.z);
+
+        const Point2d tpo = project3DPoint(tcCam.P, p);
+        const Point2d tpv = (project3DPoint(tcCam.P, p + (rcCam.C - p) / 2.0) - tpo).normalize();
+        const Point2d tpd = tpo + tpv * pixStep;
+
+        p = triangulateMatchRef(rcCam, tcCam, rp, tpd);
+    }
+    else
+    {
+        const Point3d rpv = (p - rcCam.C).normalize();
+        p = p + rpv * (pixStep * computeRcPixSize(rcCam, p));
+    }
+}
+
+void refineDepthMap(std::vector<float>& simMap, std::vector<float>& depthMap, int width, int height, int xFrom,
+                    const CameraStruct& rcCam, const CameraStruct& tcCam, const LabImage& rcImage,
+                    const LabImage& tcImage, int imWidth, int imHeight, int nStepsToRefine, int wsh, float gammaC,
+                    float gammaP, float epipShift, bool moveByTcOrRc)
+{
+    const auto similarityAt = [&](float depth, const Point3d& ray, float step) {
+        if(depth <= 0.0f)
+            return 1.1f;
+        Point3d p = rcCam.C + ray * depth;
+        move3DPointByTcOrRcPixStep(rcCam, tcCam, p, step, moveByTcOrRc);
+        return refinePatchSimilarity(rcCam, tcCam, rcImage, tcImage, p, wsh, imWidth, imHeight, gammaC, gammaP,
+                                     epipShift);
+    };
+
+    #pragma omp parallel for
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const int i = y * width + x;
+            const Point3d ray = (rcCam.iP * Point2d((double)(x + xFrom), (double)y)).normalize();
+            const float depth = depthMap[i];
+
+            // best depth of the steps around the depth
+            float bestDepth = -1.0f;
+            float bestSim = 1.0f;
+            for(int s = 0; s < nStepsToRefine; ++s)
+            {
+                const float tcStep = (float)(s - (nStepsToRefine - 1) / 2);
+                float odpt = depth;
+                float osim = 1.0f;
+                if(odpt > 0.0f)
+                {
+                    Point3d p = rcCam.C + ray * odpt;
+                    move3DPointByTcOrRcPixStep(rcCam, tcCam, p, tcStep, moveByTcOrRc);
+                    odpt = (p - rcCam.C).size();
+                    osim = refinePatchSimilarity(rcCam, tcCam, rcImage, tcImage, p, wsh, imWidth, imHeight, gammaC,
+                                                 gammaP, epipShift);
+                }
+                if((s == 0) || (osim < bestSim))
+                {
+                    bestDepth = odpt;
+                    bestSim = osim;
+                }
+            }
+
+            // sub-pixel refinement with the similarities of the neighbor steps
+            const Point3d sims(similarityAt(bestDepth, ray, -1.0f), bestSim, similarityAt(bestDepth, ray, 1.0f));
+
+            float outDepth = bestDepth;
+            if(bestDepth > 0.0f)
+            {
+                Point3d pm1 = rcCam.C + ray * bestDepth;
+                Point3d pp1 = pm1;
+                move3DPointByTcOrRcPixStep(rcCam, tcCam, pm1, -1.0f, moveByTcOrRc);
+                move3DPointByTcOrRcPixStep(rcCam, tcCam, pp1, 1.0f, moveByTcOrRc);
+
+                const float refinedDepth =
+                    refineDepthSubPixel(Point3d((pm1 - rcCam.C).size(), bestDepth, (pp1 - rcCam.C).size()), sims);
+                if(refinedDepth > 0.0f)
+                    outDepth = refinedDepth;
+            }
+
+            simMap[i] = sims.y;
+            depthMap[i] = outDepth;
+        }
+    }
+}
+
+void optimizeSimVolumeSGM(std::vector<unsigned char>& volume, int volDimX, int volDimY, int volDimZ, int volLUX,
+                          int volLUY, const LabImage& rcImage, unsigned char P1)
+{
+    const int volDims[3] = {volDimX, volDimY, volDimZ};
+    const int volStrides[3] = {1, volDimX, volDimX * volDimY};
+
+    std::vector<unsigned char> volAgr(volume.size());
+
+    int npaths = 0;
+    const auto updateAggrVolume = [&](int dimTrnX, int dimTrnY, int dimTrnZ, bool invZ) {
+        // the path runs along dimTrnZ, for each line of dimTrnX, through the depths of dimTrnY
+        const int dimX = volDims[dimTrnX];
+        const int dimY = volDims[dimTrnY];
+        const int dimZ = volDims[dimTrnZ];
+        const int strideX = volStrides[dimTrnX];
+        const int strideY = volStrides[dimTrnY];
+        const int strideZ = volStrides[dimTrnZ];
+        const bool pathAlongY = (dimTrnX == 0);
+
+        #pragma omp parallel for
+        for(int x = 0; x < dimX; ++x)
+        {
+            std::vector<float> prevPath(dimY);
+            std::vector<float> curPath(dimY);
+
+            const auto voxelIndex = [&](int y, int k) {
+                const int z = invZ ? dimZ - 1 - k : k;
+                return x * strideX + y * strideY + z * strideZ;
+            };
+            const auto aggregate = [&](int v, float pathCost) {
+                volAgr[v] = (unsigned char)std::min(255.0f, (volAgr[v] * npaths + pathCost) / (float)(npaths + 1));
+            };
+
+            // the first slice of the path is not aggregated
+            for(int y = 0; y < dimY; ++y)
+            {
+                const int v = voxelIndex(y, 0);
+                prevPath[y] = volume[v];
+                aggregate(v, 255.0f);
+            }
+
+            for(int k = 1; k < dimZ; ++k)
+            {
+                const float bestCost = *std::min_element(prevPath.begin(), prevPath.end());
+
+                // P2 decreases with the color difference of the consecutive pixels of the path
+                const int zz = invZ ? dimZ - k : k;
+                const int z1 = invZ ? zz + 1 : zz - 1;
+                const int imX0 = volLUX + (pathAlongY ? x : zz);
+                const int imY0 = volLUY + (pathAlongY ? zz : x);
+                const int imX1 = volLUX + (pathAlongY ? x : z1);
+                const int imY1 = volLUY + (pathAlongY ? z1 : x);
+                const LabTexel& gc0 = rcImage.at(imX0, imY0);
+                const LabTexel& gc1 = rcImage.at(imX1, imY1);
+                const float deltaC = euclidean3(Point4d(gc0.x, gc0.y, gc0.z, gc0.w), Point4d(gc1.x, gc1.y, gc1.z, gc1.w));
+                const unsigned int P2 = (unsigned int)sigmoid(15.0f, 255.0f, 80.0f, 20.0f, deltaC);
+
+                for(int y = 0; y < dimY; ++y)
+                {
+                    const int v = voxelIndex(y, k);
+                    float pathCost = 255.0f;
+                    if((y >= 1) && (y < dimY - 1))
+                    {
+                        const float minCost = std::min(std::min(prevPath[y], prevPath[y - 1] + P1),
+                                                       std::min(prevPath[y + 1] + P1, bestCost + P2));
+                        pathCost = volume[v] + minCost - bestCost;
+                    }
+                    curPath[y] = pathCost;
+                    aggregate(v, std::min(255.0f, pathCost));
+                }
+                std::swap(prevPath, curPath);
+            }
+        }
+        ++npaths;
+    };
+
+    // XYZ -> XZY
+    updateAggrVolume(0, 2, 1, false);
+    // XYZ -> XZ'Y
+    updateAggrVolume(0, 2, 1, true);
+    // XYZ -> YZX
+    updateAggrVolume(1, 2, 0, false);
+    // XYZ -> YZ'X
+    updateAggrVolume(1, 2, 0, true);
+
+    volume.swap(volAgr);
+}
+
+void fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>& oDepthSimMap,
+                                          const std::vector<const StaticVector<DepthSim>*>& dataMaps,
+                                          int nSamplesHalf, int nDepthsToRefine, float sigma)
+{
+    const float samplesPerPixSize = (float)(nSamplesHalf / ((nDepthsToRefine - 1) / 2));
+    const float twoTimesSigmaPowerTwo = 2.0f * sigma * sigma;
+
+    #pragma omp parallel for
+    for(int i = 0; i < w * h; ++i)
+    {
+        const DepthSim& midDepthPixSize = (*dataMaps[0])[i];
+        if(midDepthPixSize.depth <= 0.0f)
+        {
+            oDepthSimMap[i] = DepthSim(-1.0f, 1.0f);
+            continue;
+        }
+
+        float bestGsv = 0.0f;
+        int bestSample = 0;
+        for(int s = -nSamplesHalf; s <= nSamplesHalf; ++s)
+        {
+            // gaussian votes of the depth maps for the sample depth
+            float gsvSample = 0.0f;
+            for(std::size_t c = 1; c < dataMaps.size(); ++c)
+            {
+                const DepthSim& depthSim = (*dataMaps[c])[i];
+                if(depthSim.depth > 0.0f)
+                {
+                    const float sample =
+                        (midDepthPixSize.depth - depthSim.depth) / (midDepthPixSize.sim / samplesPerPixSize);
+                    const float simWeight = sigmoid(0.0f, 1.0f, 0.7f, -0.7f, depthSim.sim);
+                    gsvSample += -simWeight * std::exp(-((sample - s) * (sample - s)) / twoTimesSigmaPowerTwo);
+                }
+            }
+            if((s == -nSamplesHalf) || (gsvSample < bestGsv))
+            {
+                bestGsv = gsvSample;
+                bestSample = s;
+            }
+        }
+        oDepthSimMap[i] =
+            DepthSim(midDepthPixSize.depth - (float)bestSample * midDepthPixSize.sim / samplesPerPixSize, bestGsv);
+    }
+}
+
+void optimizeDepthSimMapGradientDescent(int w, int h, std::vector<DepthSim>& oDepthSimMap,
+                                        const std::vector<DepthSim>& midDepthPixSizeMap,
+                                        const std::vector<DepthSim>& fusedDepthSimMap, const CameraStruct& rcCam,
+                                        const LabImage& rcImage, int nSamplesHalf, int nDepthsToRefine, int nIters,
+                                        int yFrom)
+{
+    // the optimization starts from the middle depths
+    std::vector<DepthSim> optDepthSimMap(midDepthPixSizeMap);
+    std::vector<float> optDepths(w * h);
+
+    const auto depthAt = [&](int x, int y) {
+        x = std::max(0, std::min(w - 1, x));
+        y = std::max(0, std::min(h - 1, y));
+        return optDepths[y * w + x];
+    };
+
+    // smoothness step to the 3D plane of the neighbors and energy (180 for a flat surface)
+    const auto getCellSmoothStepEnergy = [&](int x, int y, float d0) {
+        Point2d out(0.0, 180.0);
+        if(d0 <= 0.0f)
+            return out;
+
+        // as on the device, the points are unprojected from the part coordinates
+        const auto pointAt = [&](int px, int py, float d) {
+            return rcCam.C + (rcCam.iP * Point2d((double)px, (double)py)).normalize() * d;
+        };
+
+        const float dL = depthAt(x, y - 1);
+        const float dR = depthAt(x, y + 1);
+        const float dU = depthAt(x - 1, y);
+        const float dB = depthAt(x + 1, y);
+
+        const Point3d p0 = pointAt(x, y, d0);
+        const Point3d pL = pointAt(x, y - 1, dL);
+        const Point3d pR = pointAt(x, y + 1, dR);
+        const Point3d pU = pointAt(x - 1, y, dU);
+        const Point3d pB = pointAt(x + 1, y, dB);
+
+        Point3d cg(0.0, 0.0, 0.0);
+        float n = 0.0f;
+        if(dL > 0.0f) { cg = cg + pL; n += 1.0f; }
+        if(dR > 0.0f) { cg = cg + pR; n += 1.0f; }
+        if(dU > 0.0f) { cg = cg + pU; n += 1.0f; }
+        if(dB > 0.0f) { cg = cg + pB; n += 1.0f; }
+
+        if(n > 1.0f)
+        {
+            cg = cg / n;
+            const Point3d vcn = (rcCam.C - p0).normalize();
+            const Point3d pS = closestPointToLine3D(&cg, &p0, &vcn);
+            out.x = (rcCam.C - pS).size() - d0;
+        }
+
+        float e = 0.0f;
+        n = 0.0f;
+        if((dL > 0.0f) && (dR > 0.0f))
+        {
+            e = std::max(e, 180.0f - (float)angleBetwABandAC(p0, pL, pR));
+            n += 1.0f;
+        }
+        if((dU > 0.0f) && (dB > 0.0f))
+        {
+            e = std::max(e, 180.0f - (float)angleBetwABandAC(p0, pU, pB));
+            n += 1.0f;
+        }
+        out.y = (n > 0.0f) ? e : 180.0f;
+        return out;
+    };
+
+    for(int iter = 0; iter < nIters; ++iter)
+    {
+        for(int i = 0; i < w * h; ++i)
+            optDepths[i] = optDepthSimMap[i].depth;
+
+        #pragma omp parallel for
+        for(int y = 0; y < h; ++y)
+        {
+            for(int x = 0; x < w; ++x)
+            {
+                const int i = y * w + x;
+                const DepthSim& midDepthPixSize = midDepthPixSizeMap[i];
+                const DepthSim& fusedDepthSim = fusedDepthSimMap[i];
+                DepthSim& optDepthSim = optDepthSimMap[i];
+                const float depthOpt = optDepths[i];
+
+                if(iter == 0)
+                    optDepthSim = DepthSim(midDepthPixSize.depth, fusedDepthSim.sim);
+                if(depthOpt <= 0.0f)
+                    continue;
+
+                const Point2d stepToSmoothDepthEnergy = getCellSmoothStepEnergy(x, y, depthOpt);
+                const float maxStep = midDepthPixSize.sim / 10.0f;
+                const float stepToSmoothDepth =
+                    std::max(-maxStep, std::min(maxStep, (float)stepToSmoothDepthEnergy.x));
+                const float energy = (float)stepToSmoothDepthEnergy.y;
+                const float stepToFuseDepth = std::max(-maxStep, std::min(maxStep, fusedDepthSim.depth - depthOpt));
+                const float stepToVisDepth = midDepthPixSize.depth - depthOpt;
+
+                // weights from the gradient of the image, the fused similarity and the distance to the visibility
+                const float imgGradient = rcImage.at(x, y + yFrom).w;
+                const float imgGradientWeight = sigmoid2(5.0f, 30.0f, 40.0f, 20.0f, imgGradient);
+                const float simWeight = sigmoid(0.0f, 1.0f, 0.7f, -0.7f, fusedDepthSim.sim);
+                const float photoWeight = sigmoid(0.0f, 1.0f, 30.0f, imgGradientWeight, energy);
+                const float smoothWeight = 1.0f - photoWeight;
+                const float visWeight =
+                    1.0f - sigmoid(0.0f, 1.0f, 10.0f, 17.0f, std::fabs(stepToVisDepth / midDepthPixSize.sim));
+
+                optDepthSim.depth =
+                    depthOpt + visWeight * stepToVisDepth +
+                    (1.0f - visWeight) * (photoWeight * simWeight * stepToFuseDepth + smoothWeight * stepToSmoothDepth);
+                optDepthSim.sim = (1.0f - visWeight) * photoWeight * simWeight * fusedDepthSim.sim +
+                                  (1.0f - visWeight) * smoothWeight * (energy / 20.0f);
+            }
+        }
+    }
+
+    oDepthSimMap.swap(optDepthSimMap);
+}
+
+} // namespace depthMap
+} // namespace aliceVision
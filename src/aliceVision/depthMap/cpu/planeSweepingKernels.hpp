@@ -0,0 +1,215 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Color.hpp>
+#include <aliceVision/mvsData/Image.hpp>
+#include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/Matrix3x4.hpp>
+#include <aliceVision/mvsData/Point2d.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/Point4d.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsData/Voxel.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/depthMap/DepthSimMap.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace depthMap {
+
+/*
+ * Host versions of the plane sweeping kernels (see cuda/planeSweeping and cuda/deviceCommon),
+ * used by PlaneSweepingCpu. The images, the similarity volumes and the maps have the same layout
+ * and the same 0..255 quantization as on the device.
+ */
+
+/**
+ * @brief Texel of the Lab images, same as the device uchar4 textures:
+ *        x, y, z hold L, a, b and w the gradient norm of L
+ */
+struct LabTexel
+{
+    unsigned char x = 0;
+    unsigned char y = 0;
+    unsigned char z = 0;
+    unsigned char w = 0;
+};
+
+/**
+ * @brief Image in Lab colorspace at one scale
+ */
+struct LabImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<LabTexel> texels;
+
+    /// Texel at (x, y), clamped to the image borders
+    inline const LabTexel& at(int x, int y) const
+    {
+        x = (x < 0) ? 0 : ((x >= width) ? width - 1 : x);
+        y = (y < 0) ? 0 : ((y >= height) ? height - 1 : y);
+        return texels[y * width + x];
+    }
+
+    /**
+     * @brief Bilinear interpolation of the texels at the pixel position (x, y), with 0..255 components,
+     *        same as 255 * tex2D(tex, x + 0.5, y + 0.5) on the device
+     */
+    Point4d sample(float x, float y) const;
+};
+
+/**
+ * @brief Camera parameters at one scale, same as the cameraStruct of the device
+ */
+struct CameraStruct
+{
+    Point3d C;
+    Matrix3x4 P;
+    Matrix3x3 iP;
+    Point3d ZVect;
+};
+
+/**
+ * @brief Get the parameters of the camera c at the given scale (same as cps_fillCamera)
+ */
+CameraStruct getCameraStruct(const mvsUtils::MultiViewParams& mp, int c, int scale);
+
+/**
+ * @brief Linear RGB (0..1) color to Lab texel, w is 0 (same as rgb2lab_kernel)
+ */
+LabTexel rgb2lab(const Color& rgb);
+
+/**
+ * @brief Compute the Lab image of a linear RGB image (0..1), with the gradient of L if varianceWsh > 0
+ */
+void computeLabImage(LabImage& out, const Image& rgb, int varianceWsh);
+
+/**
+ * @brief Gaussian downscale of a Lab image (same as downscale_gauss_smooth_lab_kernel)
+ * @param[in] downscale the downscale factor, also the radius of the gaussian kernel
+ */
+void downscaleLabImage(LabImage& out, const LabImage& in, int downscale, int varianceWsh);
+
+/**
+ * @brief Weighted statistics of two signals for the NCC (same as simStat)
+ */
+struct SimStat
+{
+    double xsum = 0.0;
+    double ysum = 0.0;
+    double xxsum = 0.0;
+    double yysum = 0.0;
+    double xysum = 0.0;
+    double wsum = 0.0;
+
+    inline void update(double x, double y, double w)
+    {
+        wsum += w;
+        xsum += w * x;
+        ysum += w * y;
+        xxsum += w * x * x;
+        yysum += w * y * y;
+        xysum += w * x * y;
+    }
+
+    /**
+     * @brief Negated weighted NCC, from -1 (best) to 1 (worst), 1 for a null variance
+     */
+    float computeWSim() const;
+};
+
+/**
+ * @brief Weighted NCC of the patch of the 3D point p between rc and tc
+ *        (same as compNCCby3DptsYK with the patch of computeRotCSEpip)
+ * @param[in] width, height the size of the images at the scale of the cameras
+ * @return the similarity from -1 (best) to 1 (worst)
+ */
+float computePatchSimilarity(const CameraStruct& rcCam, const CameraStruct& tcCam, const LabImage& rcImage,
+                             const LabImage& tcImage, const Point3d& p, int wsh, int width, int height, float gammaC,
+                             float gammaP, float epipShift);
+
+/**
+ * @brief Fill the similarity volume with the best similarity to tc of the fronto-parallel planes of the depths
+ *        around the depth of each pixel (same as ps_planeSweepingGPUPixelsVolume)
+ * @param[out] volume the similarity volume (volDimX * volDimY * volDimZ), 255 where no depth is tested
+ * @param[in] pixels the rc pixels (x, y) with the index of their first depth (z)
+ * @param[in] width, height the size of the images at the scale of the cameras
+ */
+void sweepPixelsToVolume(std::vector<unsigned char>& volume, int volDimX, int volDimY, int volDimZ, int volStepXY,
+                         int volLUX, int volLUY, int volLUZ, const std::vector<float>& depths,
+                         const std::vector<Voxel>& pixels, int nDepthsToSearch, const CameraStruct& rcCam,
+                         const CameraStruct& tcCam, const LabImage& rcImage, const LabImage& tcImage, int wsh,
+                         int width, int height, float gammaC, float gammaP, float epipShift);
+
+/**
+ * @brief Sub-pixel depth of the minimum of the parabola through the similarities of three consecutive depths
+ * @param[in] depths the depths (-1 step, depth, +1 step)
+ * @param[in] sims the similarities of the depths
+ * @return the refined depth, -1 if the middle similarity is not the minimum
+ */
+float refineDepthSubPixel(const Point3d& depths, const Point3d& sims);
+
+/**
+ * @brief Move the 3D point p of the rc pixel by pixStep pixels in tc along the epipolar line (moveByTcOrRc)
+ *        or by pixStep rc pixel sizes along the rc ray (same as move3DPointByTcOrRcPixStep)
+ */
+void move3DPointByTcOrRcPixStep(const CameraStruct& rcCam, const CameraStruct& tcCam, Point3d& p, float pixStep,
+                                bool moveByTcOrRc);
+
+/**
+ * @brief Refine the depths of the rc depth map by sampling nStepsToRefine depths around each depth
+ *        with the similarity to tc, followed by a sub-pixel refinement (same as ps_refineRcDepthMap)
+ * @param[in,out] depthMap the depths of the map part (width * height), the refined depths
+ * @param[out] simMap the similarities of the refined depths
+ * @param[in] xFrom the x of the first column of the map part in the image
+ * @param[in] imWidth, imHeight the size of the images at the scale of the cameras
+ */
+void refineDepthMap(std::vector<float>& simMap, std::vector<float>& depthMap, int width, int height, int xFrom,
+                    const CameraStruct& rcCam, const CameraStruct& tcCam, const LabImage& rcImage,
+                    const LabImage& tcImage, int imWidth, int imHeight, int nStepsToRefine, int wsh, float gammaC,
+                    float gammaP, float epipShift, bool moveByTcOrRc);
+
+/**
+ * @brief Aggregate the similarity volume along the 4 image directions (SGM),
+ *        the penalty of the depth jumps decreases with the color gradient of the rc image
+ *        (same as ps_SGMoptimizeSimVolume)
+ * @param[in,out] volume the similarity volume (volDimX * volDimY * volDimZ), the aggregated volume
+ * @param[in] volLUX, volLUY the rc pixel of the first voxel
+ * @param[in] P1 the penalty of the one depth step jumps
+ */
+void optimizeSimVolumeSGM(std::vector<unsigned char>& volume, int volDimX, int volDimY, int volDimZ, int volLUX,
+                          int volLUY, const LabImage& rcImage, unsigned char P1);
+
+/**
+ * @brief Fuse the depth maps around the middle depths with a gaussian kernel voting
+ *        (same as ps_fuseDepthSimMapsGaussianKernelVoting)
+ * @param[out] oDepthSimMap the fused depth/sim map (w * h)
+ * @param[in] dataMaps the middle depth/pixSize map, then the depth/sim maps to fuse
+ */
+void fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim>& oDepthSimMap,
+                                          const std::vector<const StaticVector<DepthSim>*>& dataMaps,
+                                          int nSamplesHalf, int nDepthsToRefine, float sigma);
+
+/**
+ * @brief Optimize the fused depths with the smoothness of the neighbor depths
+ *        (same as ps_optimizeDepthSimMapGradientDescent)
+ * @param[out] oDepthSimMap the optimized depth/sim map (w * h)
+ * @param[in] midDepthPixSizeMap, fusedDepthSimMap the middle depth/pixSize map and the fused depth/sim map (w * h)
+ * @param[in] rcImage the rc image at scale 1
+ * @param[in] yFrom the y of the first row of the map part in the image
+ */
+void optimizeDepthSimMapGradientDescent(int w, int h, std::vector<DepthSim>& oDepthSimMap,
+                                        const std::vector<DepthSim>& midDepthPixSizeMap,
+                                        const std::vector<DepthSim>& fusedDepthSimMap, const CameraStruct& rcCam,
+                                        const LabImage& rcImage, int nSamplesHalf, int nDepthsToRefine, int nIters,
+                                        int yFrom);
+
+} // namespace depthMap
+} // namespace aliceVision
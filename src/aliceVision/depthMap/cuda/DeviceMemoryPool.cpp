@@ -0,0 +1,308 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DeviceMemoryPool.hpp"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace {
+
+/**
+ * @brief Get the size class of an allocation: the powers of 2 from 512 bytes
+ *        for the small blocks, the multiples of 2 MB for the large ones (maps, volumes)
+ * @param[in] bytes The number of bytes of the allocation
+ * @return the number of bytes of the allocated block
+ */
+std::size_t getSizeClass(std::size_t bytes)
+{
+    const std::size_t largeBlockBytes = 2 * 1024 * 1024;
+    if(bytes > largeBlockBytes / 2)
+        return (bytes + largeBlockBytes - 1) / largeBlockBytes * largeBlockBytes;
+
+    std::size_t blockBytes = 512;
+    while(blockBytes < bytes)
+        blockBytes *= 2;
+    return blockBytes;
+}
+
+/**
+ * @brief Make a device current in the scope
+ */
+class DeviceScope
+{
+public:
+    explicit DeviceScope(int device)
+    {
+        cudaGetDevice(&_previousDevice);
+        if(_previousDevice != device)
+            cudaSetDevice(device);
+        _device = device;
+    }
+
+    ~DeviceScope()
+    {
+        if(_previousDevice != _device)
+            cudaSetDevice(_previousDevice);
+    }
+
+private:
+    int _previousDevice = 0;
+    int _device = 0;
+};
+
+} // namespace
+
+struct DeviceMemoryPool::Impl
+{
+    /// block allocated from the driver
+    struct Block
+    {
+        int device = 0;
+        bool host = false;
+        std::size_t bytes = 0;
+        /// recorded on the default stream of the device at the release of the block
+        cudaEvent_t released = nullptr;
+    };
+
+    /// pool of the device memory or of the pinned host memory of a device
+    struct Pool
+    {
+        /// released blocks per size
+        std::multimap<std::size_t, void*> cached;
+        DeviceMemoryPoolStats stats;
+    };
+
+    Pool& getPool(int device, bool host)
+    {
+        return pools[std::make_pair(device, host)];
+    }
+
+    void updatePeaks(Pool& pool)
+    {
+        pool.stats.peakUsedBytes = std::max(pool.stats.peakUsedBytes, pool.stats.usedBytes);
+        pool.stats.peakReservedBytes = std::max(pool.stats.peakReservedBytes, pool.stats.usedBytes + pool.stats.cachedBytes);
+    }
+
+    /// give a block back to the driver (the mutex must be locked)
+    cudaError_t freeBlock(std::map<void*, Block>::iterator it)
+    {
+        const Block& block = it->second;
+        const DeviceScope deviceScope(block.device);
+
+        if(block.released != nullptr)
+            cudaEventDestroy(block.released);
+        const cudaError_t err = block.host ? cudaFreeHost(it->first) : cudaFree(it->first);
+        blocks.erase(it);
+        return err;
+    }
+
+    /// give the cached blocks of a pool back to the driver (the mutex must be locked)
+    void freeCached(Pool& pool)
+    {
+        for(const auto& cachedBlock : pool.cached)
+            freeBlock(blocks.find(cachedBlock.second));
+        pool.cached.clear();
+        pool.stats.cachedBytes = 0;
+    }
+
+    mutable std::mutex mutex;
+    /// pools per device, for the device memory (false) and for the pinned host memory (true)
+    std::map<std::pair<int, bool>, Pool> pools;
+    /// blocks allocated from the driver, used or cached
+    std::map<void*, Block> blocks;
+    /// pitch alignment per device
+    std::map<int, std::size_t> pitchAlignments;
+};
+
+DeviceMemoryPool& DeviceMemoryPool::get()
+{
+    static DeviceMemoryPool pool;
+    return pool;
+}
+
+DeviceMemoryPool::DeviceMemoryPool()
+    : _impl(new Impl)
+{}
+
+// the CUDA runtime may be unloaded before the pool: the blocks are not freed at exit
+DeviceMemoryPool::~DeviceMemoryPool() = default;
+
+cudaError_t DeviceMemoryPool::allocateDevice(void** ptr, std::size_t bytes)
+{
+    return allocate(ptr, bytes, false);
+}
+
+cudaError_t DeviceMemoryPool::deallocateDevice(void* ptr)
+{
+    return deallocate(ptr, false);
+}
+
+cudaError_t DeviceMemoryPool::allocateHost(void** ptr, std::size_t bytes)
+{
+    return allocate(ptr, bytes, true);
+}
+
+cudaError_t DeviceMemoryPool::deallocateHost(void* ptr)
+{
+    return deallocate(ptr, true);
+}
+
+cudaError_t DeviceMemoryPool::allocate(void** ptr, std::size_t bytes, bool host)
+{
+    *ptr = nullptr;
+    if(bytes == 0)
+        return cudaSuccess;
+
+    int device = 0;
+    cudaError_t err = cudaGetDevice(&device);
+    if(err != cudaSuccess)
+        return err;
+
+    const std::size_t blockBytes = getSizeClass(bytes);
+
+    // reuse a cached block of the size class (or slightly larger)
+    {
+        std::unique_lock<std::mutex> lock(_impl->mutex);
+        Impl::Pool& pool = _impl->getPool(device, host);
+        ++pool.stats.nbAllocations;
+
+        const auto cachedIt = pool.cached.lower_bound(blockBytes);
+        if(cachedIt != pool.cached.end() && cachedIt->first <= blockBytes + blockBytes / 8)
+        {
+            void* block = cachedIt->second;
+            const cudaEvent_t released = _impl->blocks.at(block).released;
+
+            pool.stats.cachedBytes -= cachedIt->first;
+            pool.stats.usedBytes += cachedIt->first;
+            ++pool.stats.nbCacheHits;
+            pool.cached.erase(cachedIt);
+            lock.unlock();
+
+            // the kernels issued before the release may still use the block
+            *ptr = block;
+            return cudaEventSynchronize(released);
+        }
+    }
+
+    void* block = nullptr;
+    err = host ? cudaMallocHost(&block, blockBytes) : cudaMalloc(&block, blockBytes);
+    if(err == cudaErrorMemoryAllocation)
+    {
+        // retry without the cached blocks of the device
+        cudaGetLastError();
+        {
+            std::lock_guard<std::mutex> lock(_impl->mutex);
+            _impl->freeCached(_impl->getPool(device, host));
+        }
+        err = host ? cudaMallocHost(&block, blockBytes) : cudaMalloc(&block, blockBytes);
+    }
+    if(err != cudaSuccess)
+        return err;
+
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    Impl::Block& newBlock = _impl->blocks[block];
+    newBlock.device = device;
+    newBlock.host = host;
+    newBlock.bytes = blockBytes;
+
+    Impl::Pool& pool = _impl->getPool(device, host);
+    pool.stats.usedBytes += blockBytes;
+    _impl->updatePeaks(pool);
+
+    *ptr = block;
+    return cudaSuccess;
+}
+
+cudaError_t DeviceMemoryPool::deallocate(void* ptr, bool host)
+{
+    if(ptr == nullptr)
+        return cudaSuccess;
+
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+
+    const auto blockIt = _impl->blocks.find(ptr);
+    if(blockIt == _impl->blocks.end() || blockIt->second.host != host)
+        return cudaErrorInvalidValue;
+
+    Impl::Block& block = blockIt->second;
+    Impl::Pool& pool = _impl->getPool(block.device, host);
+    pool.stats.usedBytes -= block.bytes;
+
+    cudaError_t err = cudaSuccess;
+    {
+        const DeviceScope deviceScope(block.device);
+        if(block.released == nullptr)
+            err = cudaEventCreateWithFlags(&block.released, cudaEventDisableTiming);
+        if(err == cudaSuccess)
+            err = cudaEventRecord(block.released, 0);
+    }
+
+    if(err != cudaSuccess)
+    {
+        // the end of the work on the block is unknown: give it back to the driver, that synchronizes
+        cudaGetLastError();
+        return _impl->freeBlock(blockIt);
+    }
+
+    pool.cached.emplace(block.bytes, ptr);
+    pool.stats.cachedBytes += block.bytes;
+    return cudaSuccess;
+}
+
+std::size_t DeviceMemoryPool::getPitch(std::size_t rowBytes)
+{
+    int device = 0;
+    cudaGetDevice(&device);
+
+    std::size_t alignment = 0;
+    {
+        std::lock_guard<std::mutex> lock(_impl->mutex);
+        auto it = _impl->pitchAlignments.find(device);
+        if(it == _impl->pitchAlignments.end())
+        {
+            int textureAlignment = 0;
+            if(cudaDeviceGetAttribute(&textureAlignment, cudaDevAttrTextureAlignment, device) != cudaSuccess || textureAlignment <= 0)
+                textureAlignment = 512;
+            it = _impl->pitchAlignments.emplace(device, static_cast<std::size_t>(textureAlignment)).first;
+        }
+        alignment = it->second;
+    }
+    return std::max(std::size_t(1), (rowBytes + alignment - 1) / alignment) * alignment;
+}
+
+DeviceMemoryPoolStats DeviceMemoryPool::getStats(int device, bool host) const
+{
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    const auto it = _impl->pools.find(std::make_pair(device, host));
+    return (it != _impl->pools.end()) ? it->second.stats : DeviceMemoryPoolStats();
+}
+
+void DeviceMemoryPool::resetPeaks(int device)
+{
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    for(const bool host : {false, true})
+    {
+        Impl::Pool& pool = _impl->getPool(device, host);
+        pool.stats.peakUsedBytes = pool.stats.usedBytes;
+        pool.stats.peakReservedBytes = pool.stats.usedBytes + pool.stats.cachedBytes;
+    }
+}
+
+void DeviceMemoryPool::clear()
+{
+    std::lock_guard<std::mutex> lock(_impl->mutex);
+    for(auto& pool : _impl->pools)
+        _impl->freeCached(pool.second);
+}
+
+} // namespace depthMap
+} // namespace aliceVision
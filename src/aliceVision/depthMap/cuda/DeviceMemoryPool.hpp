@@ -0,0 +1,127 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Memory statistics of a device pool (device memory or pinned host memory).
+ */
+struct DeviceMemoryPoolStats
+{
+    /// bytes of the blocks in use
+    std::size_t usedBytes = 0;
+    /// bytes of the released blocks kept for the next allocations
+    std::size_t cachedBytes = 0;
+    /// high-water mark of the used bytes
+    std::size_t peakUsedBytes = 0;
+    /// high-water mark of the bytes allocated from the driver (used + cached)
+    std::size_t peakReservedBytes = 0;
+    /// number of allocation requests
+    std::size_t nbAllocations = 0;
+    /// number of allocation requests served by a cached block
+    std::size_t nbCacheHits = 0;
+};
+
+/**
+ * @brief Caching allocator of the device memory and of the pinned host memory, used by
+ *        CudaDeviceMemoryPitched, CudaDeviceMemory and CudaHostMemoryHeap.
+ *
+ * cudaMalloc/cudaFree synchronize the device and fragment its memory when the buffers of each
+ * rc/tc are reallocated. The released blocks are kept per device and per size class instead,
+ * and given back to the next allocation of the same size class on the same device.
+ * A block released while kernels may still use it is reused once the work issued on the
+ * default stream before its release is done, as cudaFree did.
+ * The cached blocks are freed when an allocation fails, or with clear().
+ */
+class DeviceMemoryPool
+{
+public:
+    /**
+     * @brief Get the pool instance, shared by the device threads
+     */
+    static DeviceMemoryPool& get();
+
+    DeviceMemoryPool(const DeviceMemoryPool&) = delete;
+    DeviceMemoryPool& operator=(const DeviceMemoryPool&) = delete;
+
+    /**
+     * @brief Allocate device memory on the current device
+     * @param[out] ptr The allocated memory (nullptr for 0 bytes)
+     * @param[in] bytes The number of bytes
+     * @return the error of the driver allocation (cudaSuccess if served from the cache)
+     */
+    cudaError_t allocateDevice(void** ptr, std::size_t bytes);
+
+    /**
+     * @brief Release device memory allocated with allocateDevice, it is kept in the cache
+     * @param[in] ptr The memory (nothing is done for nullptr)
+     * @return the error of the release
+     */
+    cudaError_t deallocateDevice(void* ptr);
+
+    /**
+     * @brief Allocate pinned host memory for the current device
+     * @param[out] ptr The allocated memory (nullptr for 0 bytes)
+     * @param[in] bytes The number of bytes
+     * @return the error of the driver allocation (cudaSuccess if served from the cache)
+     */
+    cudaError_t allocateHost(void** ptr, std::size_t bytes);
+
+    /**
+     * @brief Release pinned host memory allocated with allocateHost, it is kept in the cache
+     * @param[in] ptr The memory (nothing is done for nullptr)
+     * @return the error of the release
+     */
+    cudaError_t deallocateHost(void* ptr);
+
+    /**
+     * @brief Get the pitch of the rows of a pitched allocation on the current device,
+     *        aligned as cudaMallocPitch does
+     * @param[in] rowBytes The number of bytes of a row
+     * @return the number of bytes between two rows
+     */
+    std::size_t getPitch(std::size_t rowBytes);
+
+    /**
+     * @brief Get the statistics of a device pool
+     * @param[in] device The CUDA device
+     * @param[in] host The pinned host memory pool, instead of the device memory pool
+     */
+    DeviceMemoryPoolStats getStats(int device, bool host = false) const;
+
+    /**
+     * @brief Reset the high-water marks of the pools of a device to their current used and reserved bytes
+     * @param[in] device The CUDA device
+     */
+    void resetPeaks(int device);
+
+    /**
+     * @brief Free the cached blocks of all the devices
+     */
+    void clear();
+
+private:
+    struct Impl;
+
+    DeviceMemoryPool();
+    ~DeviceMemoryPool();
+
+    cudaError_t allocate(void** ptr, std::size_t bytes, bool host);
+    cudaError_t deallocate(void* ptr, bool host);
+
+    std::unique_ptr<Impl> _impl;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,144 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DeviceProfile.hpp"
+#include <aliceVision/depthMap/cuda/commonStructures.hpp>
+#include <aliceVision/system/nvtx.hpp>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace depthMap {
+
+namespace bpt = boost::property_tree;
+
+DeviceProfile::Stage::Stage(DeviceProfile& profile, const char* name, const char* file, int line)
+    : _profile(profile)
+    , _name(name)
+{
+    nvtxPushA(name, file, line);
+
+    if(!_profile._enabled)
+        return;
+
+    ++_profile._depth;
+
+    // the pending kernels belong to the previous stage
+    cudaDeviceSynchronize();
+    _profile.sampleUsedMemory();
+
+    DeviceTransferStats& transferStats = getDeviceTransferStats();
+    _startTransferMs = transferStats.timeMs;
+    _startTransferBytes = transferStats.bytes;
+    _previousPeakUsedMB = transferStats.peakUsedMB;
+    transferStats.peakUsedMB = 0.0f;
+
+    _start = std::chrono::steady_clock::now();
+}
+
+DeviceProfile::Stage::~Stage()
+{
+    if(_profile._enabled)
+    {
+        cudaDeviceSynchronize();
+        const double timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+        const float endUsedMB = _profile.sampleUsedMemory();
+
+        DeviceTransferStats& transferStats = getDeviceTransferStats();
+        const double transferMs = transferStats.timeMs - _startTransferMs;
+        const float peakUsedMB = std::max(endUsedMB, transferStats.peakUsedMB);
+
+        StageStats& stats = _profile.getStage(_name);
+        stats.nbCalls += 1;
+        stats.timeMs += timeMs;
+        stats.transferMs += transferMs;
+        stats.transferMB += (transferStats.bytes - _startTransferBytes) / (1024.0 * 1024.0);
+        stats.peakUsedMB = std::max(stats.peakUsedMB, peakUsedMB);
+
+        _profile._peakUsedMB = std::max(_profile._peakUsedMB, peakUsedMB);
+        transferStats.peakUsedMB = std::max(_previousPeakUsedMB, peakUsedMB);
+
+        // the nested stages are already counted in the total of their parent
+        if(--_profile._depth == 0)
+        {
+            _profile._timeMs += timeMs;
+            _profile._transferMs += transferMs;
+        }
+    }
+
+    nvtxPop(_name);
+}
+
+void DeviceProfile::setEnabled(bool enabled)
+{
+    _enabled = enabled;
+    getDeviceTransferStats().enabled = enabled;
+}
+
+void DeviceProfile::reset()
+{
+    _timeMs = 0.0;
+    _transferMs = 0.0;
+    _peakUsedMB = 0.0f;
+    _stages.clear();
+}
+
+void DeviceProfile::save(const std::string& filepath, int viewId) const
+{
+    bpt::ptree tree;
+    tree.put("viewId", viewId);
+
+    bpt::ptree stagesTree;
+    for(const auto& stage : _stages)
+    {
+        const StageStats& stats = stage.second;
+        bpt::ptree stageTree;
+        stageTree.put("nbCalls", stats.nbCalls);
+        stageTree.put("timeMs", stats.timeMs);
+        stageTree.put("computeMs", std::max(0.0, stats.timeMs - stats.transferMs));
+        stageTree.put("transferMs", stats.transferMs);
+        stageTree.put("transferMB", stats.transferMB);
+        stageTree.put("peakUsedMemoryMB", stats.peakUsedMB);
+        stagesTree.add_child(stage.first, stageTree);
+    }
+
+    tree.put("timeMs", _timeMs);
+    tree.put("computeMs", std::max(0.0, _timeMs - _transferMs));
+    tree.put("transferMs", _transferMs);
+    tree.put("peakUsedMemoryMB", _peakUsedMB);
+    tree.add_child("stages", stagesTree);
+
+    bpt::write_json(filepath, tree);
+}
+
+DeviceProfile::StageStats& DeviceProfile::getStage(const char* name)
+{
+    for(auto& stage : _stages)
+    {
+        if(stage.first == name)
+            return stage.second;
+    }
+    _stages.emplace_back(name, StageStats());
+    return _stages.back().second;
+}
+
+float DeviceProfile::sampleUsedMemory()
+{
+    size_t freeBytes = 0;
+    size_t totalBytes = 0;
+    if(cudaMemGetInfo(&freeBytes, &totalBytes) != cudaSuccess)
+        return 0.0f;
+
+    const float usedMB = static_cast<float>(totalBytes - freeBytes) / (1024.0f * 1024.0f);
+    _peakUsedMB = std::max(_peakUsedMB, usedMB);
+    return usedMB;
+}
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -0,0 +1,100 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Profile a device stage in the scope: NVTX range and, if the profile is enabled, time and memory statistics
+#define deviceStage(profile, name) aliceVision::depthMap::DeviceProfile::Stage deviceStage_##name(profile, #name, __FILE__, __LINE__)
+
+namespace aliceVision {
+namespace depthMap {
+
+/**
+ * @brief Statistics of the device stages (sweep, SGM, refine, fuse, filter...) of a reference camera.
+ *
+ * Each stage is an NVTX range, visible in Nsight. When the profile is enabled, the device is
+ * synchronized at the stage boundaries and at each host/device transfer (see DeviceTransferScope):
+ * the stage time is split into the transfer time and the compute time, and the used device memory
+ * is sampled at each transfer and boundary to get its peak.
+ */
+class DeviceProfile
+{
+public:
+    struct StageStats
+    {
+        int nbCalls = 0;
+        double timeMs = 0.0;
+        double transferMs = 0.0;
+        double transferMB = 0.0;
+        float peakUsedMB = 0.0f;
+    };
+
+    /**
+     * @brief Stage of a profile, from construction to destruction.
+     */
+    class Stage
+    {
+    public:
+        Stage(DeviceProfile& profile, const char* name, const char* file, int line);
+        ~Stage();
+
+        Stage(const Stage&) = delete;
+        Stage& operator=(const Stage&) = delete;
+
+    private:
+        DeviceProfile& _profile;
+        const char* _name;
+        std::chrono::steady_clock::time_point _start;
+        double _startTransferMs = 0.0;
+        double _startTransferBytes = 0.0;
+        /// peak of the transfers before the stage, restored at the end of the stage
+        float _previousPeakUsedMB = 0.0f;
+    };
+
+    /**
+     * @brief Enable the statistics of the calling thread, it must be the device thread.
+     */
+    void setEnabled(bool enabled);
+
+    bool isEnabled() const
+    {
+        return _enabled;
+    }
+
+    /**
+     * @brief Clear the statistics, before the next reference camera.
+     */
+    void reset();
+
+    /**
+     * @brief Write the statistics as JSON.
+     * @param[in] filepath the output file
+     * @param[in] viewId the reference camera view id
+     */
+    void save(const std::string& filepath, int viewId) const;
+
+private:
+    StageStats& getStage(const char* name);
+    float sampleUsedMemory();
+
+    bool _enabled = false;
+    /// number of open stages
+    int _depth = 0;
+    /// totals of the top-level stages
+    double _timeMs = 0.0;
+    double _transferMs = 0.0;
+    float _peakUsedMB = 0.0f;
+    /// stages by first call
+    std::vector<std::pair<std::string, StageStats>> _stages;
+};
+
+} // namespace depthMap
+} // namespace aliceVision
@@ -6,15 +6,19 @@
 
 #include "PlaneSweepingCuda.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/mvsData/Matrix3x3.hpp>
 #include <aliceVision/mvsData/Matrix3x4.hpp>
-#include <aliceVision/mvsData/OrientedPoint.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/depthMap/cuda/DeviceMemoryPool.hpp>
 #include <aliceVision/depthMap/cuda/planeSweeping/plane_sweeping_cuda.hpp>
 #include <aliceVision/depthMap/cuda/planeSweeping/host_utils.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 
 namespace aliceVision {
@@ -170,17 +174,12 @@ PlaneSweepingCuda::PlaneSweepingCuda( int CUDADeviceNo,
                                       mvsUtils::ImagesCache&     ic,
                                       mvsUtils::MultiViewParams* _mp,
                                       int scales )
-    : _scales( scales )
+    : PlaneSweeping( ic, _mp, scales )
     , _nbest( 1 ) // TODO remove nbest ... now must be 1
     , _CUDADeviceNo( CUDADeviceNo )
-    , _verbose( _mp->verbose )
     , _nbestkernelSizeHalf( 1 )
     , _nImgsInGPUAtTime( 2 )
-    , _ic( ic )
 {
-
-    mp = _mp;
-
     const int maxImageWidth = mp->getMaxImageWidth();
     const int maxImageHeight = mp->getMaxImageHeight();
 
@@ -189,9 +188,28 @@ PlaneSweepingCuda::PlaneSweepingCuda( int CUDADeviceNo,
     {
         oneimagemb += 4.0 * (((float)((maxImageWidth / scale) * (maxImageHeight / scale)) / 1024.0) / 1024.0);
     }
-    float maxmbGPU = 100.0f;
+
+    // the images stay in the device memory from one reference camera to the next,
+    // the cache takes a part of the free device memory, the rest is left for the volumes
+    ps_setDevice(_CUDADeviceNo);
+
+    // memory allocated from the driver by the device memory pool (used and cached blocks)
+    const int device = _CUDADeviceNo;
+    _memoryProviderId = system::MemoryTracker::get().addGpuMemoryProvider([device]()
+    {
+        const DeviceMemoryPoolStats stats = DeviceMemoryPool::get().getStats(device);
+        return stats.usedBytes + stats.cachedBytes;
+    });
+
+    _profile.setEnabled(mp->userParams.get<bool>("depthMap.deviceProfile", false));
+    const float imagesCacheMemoryRatio =
+        static_cast<float>(mp->userParams.get<double>("images_cache.gpuMemoryRatio", 0.3));
+    const float maxmbGPU = imagesCacheMemoryRatio * getDeviceMemoryInfo().x;
     _nImgsInGPUAtTime = (int)(maxmbGPU / oneimagemb);
     _nImgsInGPUAtTime = std::max(2, std::min(mp->ncams, _nImgsInGPUAtTime));
+    // one camera parameters slot in the device constant memory per cached camera,
+    // the two slots after them are used by the cameras out of the cache
+    _nImgsInGPUAtTime = std::min(MAX_CONSTANT_CAMERA_PARAM_SETS - 2, _nImgsInGPUAtTime);
 
     doVizualizePartialDepthMaps = mp->userParams.get<bool>("grow.visualizePartialDepthMaps", false);
     useRcDepthsOrRcTcDepths = mp->userParams.get<bool>("grow.useRcDepthsOrRcTcDepths", false);
@@ -202,7 +220,7 @@ PlaneSweepingCuda::PlaneSweepingCuda( int CUDADeviceNo,
     subPixel = mp->userParams.get<bool>("global.subPixel", true);
 
     ALICEVISION_LOG_INFO("PlaneSweepingCuda:" << std::endl
-                         << "\t- _nImgsInGPUAtTime: " << _nImgsInGPUAtTime << std::endl
+                         << "\t- _nImgsInGPUAtTime: " << _nImgsInGPUAtTime << " (" << _nImgsInGPUAtTime * oneimagemb << " MB)" << std::endl
                          << "\t- scales: " << _scales << std::endl
                          << "\t- subPixel: " << (subPixel ? "Yes" : "No") << std::endl
                          << "\t- varianceWSH: " << varianceWSH);
@@ -221,23 +239,30 @@ PlaneSweepingCuda::PlaneSweepingCuda( int CUDADeviceNo,
     {
         (*cams)[rc] = new cameraStruct();
         (*camsRcs)[rc] = -1;
-        (*camsTimes)[rc] = clock();
+        (*camsTimes)[rc] = 0;
     }
 }
 
 int PlaneSweepingCuda::addCam(int camIndex, float** H, int scale)
 {
-    // first is oldest
+    deviceStage(_profile, upload);
+
+    // the slot of a camera holds its images at all the scales,
+    // only the camera parameters depend on the requested scale
     int id = camsRcs->indexOf(camIndex);
     if(id == -1)
     {
-        // get oldest id
+        ++_nbImagesCacheMisses;
+
+        // get the least recently used slot
         int oldestId = camsTimes->minValId();
         cameraStruct* cam = (*cams)[oldestId];
 
         long t1 = clock();
 
         cps_fillCamera(cam, camIndex, mp, H, scale);
+        cam->camId = oldestId;
+        ps_deviceUpdateCamParams(*cam, oldestId);
 
         if(cam->tex_rgba_hmh == nullptr)
         {
@@ -252,21 +277,53 @@ int PlaneSweepingCuda::addCam(int camIndex, float** H, int scale)
             mvsUtils::printfElapsedTime(t1, "copy image from disk to GPU ");
 
         (*camsRcs)[oldestId] = camIndex;
-        (*camsTimes)[oldestId] = clock();
+        (*camsTimes)[oldestId] = ++_imagesCacheAccess;
         id = oldestId;
     }
     else
     {
-        cps_fillCamera((cameraStruct*)(*cams)[id], camIndex, mp, H, scale);
+        ++_nbImagesCacheHits;
+
+        cameraStruct* cam = (*cams)[id];
+        const int previousScale = cam->scale;
+
+        cps_fillCamera(cam, camIndex, mp, H, scale);
+
+        // the camera matrices depend on the scale
+        if(scale != previousScale)
+            ps_deviceUpdateCamParams(*cam, id);
 
-        (*camsTimes)[id] = clock();
+        (*camsTimes)[id] = ++_imagesCacheAccess;
         cps_updateCamH((cameraStruct*)(*cams)[id], H);
     }
     return id;
 }
 
+float PlaneSweepingCuda::getImagesCacheHitRate() const
+{
+    const long nbAccesses = _nbImagesCacheHits + _nbImagesCacheMisses;
+    return (nbAccesses > 0) ? static_cast<float>(_nbImagesCacheHits) / static_cast<float>(nbAccesses) : 0.0f;
+}
+
 PlaneSweepingCuda::~PlaneSweepingCuda(void)
 {
+    system::MemoryTracker::get().removeGpuMemoryProvider(_memoryProviderId);
+
+    ALICEVISION_LOG_INFO("PlaneSweepingCuda images cache on device " << _CUDADeviceNo << ":" << std::endl
+                         << "\t- hits: " << _nbImagesCacheHits << std::endl
+                         << "\t- misses (uploads): " << _nbImagesCacheMisses << std::endl
+                         << "\t- hit rate: " << 100.0f * getImagesCacheHitRate() << " %");
+
+    for(const bool host : {false, true})
+    {
+        const DeviceMemoryPoolStats stats = DeviceMemoryPool::get().getStats(_CUDADeviceNo, host);
+        ALICEVISION_LOG_INFO("PlaneSweepingCuda " << (host ? "pinned host" : "device") << " memory pool on device " << _CUDADeviceNo << ":" << std::endl
+                             << "\t- peak used: " << stats.peakUsedBytes / (1024.0 * 1024.0) << " MB" << std::endl
+                             << "\t- peak reserved: " << stats.peakReservedBytes / (1024.0 * 1024.0) << " MB" << std::endl
+                             << "\t- cached: " << stats.cachedBytes / (1024.0 * 1024.0) << " MB" << std::endl
+                             << "\t- hit rate: " << ((stats.nbAllocations > 0) ? 100.0 * stats.nbCacheHits / stats.nbAllocations : 0.0) << " %");
+    }
+
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     // deallocate global on the device
     ps_deviceDeallocate((CudaArray<uchar4, 2>***)&ps_texs_arr, _CUDADeviceNo, _nImgsInGPUAtTime, _scales);
@@ -283,342 +340,14 @@ PlaneSweepingCuda::~PlaneSweepingCuda(void)
     delete cams;
     delete camsRcs;
     delete camsTimes;
-
-    mp = NULL;
-}
-
-void PlaneSweepingCuda::getMinMaxdepths(int rc, const StaticVector<int>& tcams, float& minDepth, float& midDepth,
-                                          float& maxDepth)
-{
-  const bool minMaxDepthDontUseSeeds = mp->userParams.get<bool>("prematching.minMaxDepthDontUseSeeds", false);
-  const float maxDepthScale = static_cast<float>(mp->userParams.get<double>("prematching.maxDepthScale", 1.5f));
-
-  if(minMaxDepthDontUseSeeds)
-  {
-    const float minCamDist = static_cast<float>(mp->userParams.get<double>("prematching.minCamDist", 0.0f));
-    const float maxCamDist = static_cast<float>(mp->userParams.get<double>("prematching.maxCamDist", 15.0f));
-
-    minDepth = 0.0f;
-    maxDepth = 0.0f;
-    for(int c = 0; c < tcams.size(); c++)
-    {
-        int tc = tcams[c];
-        minDepth += (mp->CArr[rc] - mp->CArr[tc]).size() * minCamDist;
-        maxDepth += (mp->CArr[rc] - mp->CArr[tc]).size() * maxCamDist;
-    }
-    minDepth /= static_cast<float>(tcams.size());
-    maxDepth /= static_cast<float>(tcams.size());
-    midDepth = (minDepth + maxDepth) / 2.0f;
-  }
-  else
-  {
-    std::size_t nbDepths;
-    mp->getMinMaxMidNbDepth(rc, minDepth, maxDepth, midDepth, nbDepths);
-    maxDepth = maxDepth * maxDepthScale;
-  }
-}
-
-StaticVector<float>* PlaneSweepingCuda::getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth,
-                                                               int scale, int step, int maxDepthsHalf)
-{
-    float d = (float)step;
-
-    OrientedPoint rcplane;
-    rcplane.p = mp->CArr[rc];
-    rcplane.n = mp->iRArr[rc] * Point3d(0.0, 0.0, 1.0);
-    rcplane.n = rcplane.n.normalize();
-
-    int ndepthsMidMax = 0;
-    float maxdepth = midDepth;
-    while((maxdepth < maxDepth) && (ndepthsMidMax < maxDepthsHalf))
-    {
-        Point3d p = rcplane.p + rcplane.n * maxdepth;
-        float pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
-        maxdepth += pixSize;
-        ndepthsMidMax++;
-    }
-
-    int ndepthsMidMin = 0;
-    float mindepth = midDepth;
-    while((mindepth > minDepth) && (ndepthsMidMin < maxDepthsHalf * 2 - ndepthsMidMax))
-    {
-        Point3d p = rcplane.p + rcplane.n * mindepth;
-        float pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
-        mindepth -= pixSize;
-        ndepthsMidMin++;
-    }
-
-    // getNumberOfDepths
-    float depth = mindepth;
-    int ndepths = 0;
-    float pixSize = 1.0f;
-    while((depth < maxdepth) && (pixSize > 0.0f) && (ndepths < 2 * maxDepthsHalf))
-    {
-        Point3d p = rcplane.p + rcplane.n * depth;
-        pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
-        depth += pixSize;
-        ndepths++;
-    }
-
-    StaticVector<float>* out = new StaticVector<float>();
-    out->reserve(ndepths);
-
-    // fill
-    depth = mindepth;
-    pixSize = 1.0f;
-    ndepths = 0;
-    while((depth < maxdepth) && (pixSize > 0.0f) && (ndepths < 2 * maxDepthsHalf))
-    {
-        out->push_back(depth);
-        Point3d p = rcplane.p + rcplane.n * depth;
-        pixSize = mp->getCamPixelSize(p, rc, (float)scale * d);
-        depth += pixSize;
-        ndepths++;
-    }
-
-    // check if it is asc
-    for(int i = 0; i < out->size() - 1; i++)
-    {
-        if((*out)[i] >= (*out)[i + 1])
-        {
-
-            for(int j = 0; j <= i + 1; j++)
-            {
-                ALICEVISION_LOG_TRACE("getDepthsByPixelSize: check if it is asc: " << (*out)[j]);
-            }
-            throw std::runtime_error("getDepthsByPixelSize not asc.");
-        }
-    }
-
-    return out;
-}
-
-StaticVector<float>* PlaneSweepingCuda::getDepthsRcTc(int rc, int tc, int scale, float midDepth,
-                                                        int maxDepthsHalf)
-{
-    OrientedPoint rcplane;
-    rcplane.p = mp->CArr[rc];
-    rcplane.n = mp->iRArr[rc] * Point3d(0.0, 0.0, 1.0);
-    rcplane.n = rcplane.n.normalize();
-
-    Point2d rmid = Point2d((float)mp->getWidth(rc) / 2.0f, (float)mp->getHeight(rc) / 2.0f);
-    Point2d pFromTar, pToTar; // segment of epipolar line of the principal point of the rc camera to the tc camera
-    getTarEpipolarDirectedLine(&pFromTar, &pToTar, rmid, rc, tc, mp);
-
-    int allDepths = static_cast<int>((pToTar - pFromTar).size());
-    if(_verbose == true)
-    {
-        ALICEVISION_LOG_DEBUG("allDepths: " << allDepths);
-    }
-
-    Point2d pixelVect = ((pToTar - pFromTar).normalize()) * std::max(1.0f, (float)scale);
-    // printf("%f %f %i %i\n",pixelVect.size(),((float)(scale*step)/3.0f),scale,step);
-
-    Point2d cg = Point2d(0.0f, 0.0f);
-    Point3d cg3 = Point3d(0.0f, 0.0f, 0.0f);
-    int ncg = 0;
-    // navigate through all pixels of the epilolar segment
-    // Compute the middle of the valid pixels of the epipolar segment (in rc camera) of the principal point (of the rc camera)
-    for(int i = 0; i < allDepths; i++)
-    {
-        Point2d tpix = pFromTar + pixelVect * (float)i;
-        Point3d p;
-        if(triangulateMatch(p, rmid, tpix, rc, tc, mp)) // triangulate principal point from rc with tpix
-        {
-            float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n); // todo: can compute the distance to the camera (as it's the principal point it's the same)
-            if( mp->isPixelInImage(tpix, tc)
-                && (depth > 0.0f)
-                && checkPair(p, rc, tc, mp, mp->getMinViewAngle(), mp->getMaxViewAngle()) )
-            {
-                cg = cg + tpix;
-                cg3 = cg3 + p;
-                ncg++;
-            }
-        }
-    }
-    if(ncg == 0)
-    {
-        return new StaticVector<float>();
-    }
-    cg = cg / (float)ncg;
-    cg3 = cg3 / (float)ncg;
-    allDepths = ncg;
-
-    if(_verbose == true)
-    {
-        ALICEVISION_LOG_DEBUG("All correct depths: " << allDepths);
-    }
-
-    Point2d midpoint = cg;
-    if(midDepth > 0.0f)
-    {
-        Point3d midPt = rcplane.p + rcplane.n * midDepth;
-        mp->getPixelFor3DPoint(&midpoint, midPt, tc);
-    }
-
-    // compute the direction
-    float direction = 1.0f;
-    {
-        Point3d p;
-        if(!triangulateMatch(p, rmid, midpoint, rc, tc, mp))
-        {
-            StaticVector<float>* out = new StaticVector<float>();
-            return out;
-        }
-
-        float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
-
-        if(!triangulateMatch(p, rmid, midpoint + pixelVect, rc, tc, mp))
-        {
-            StaticVector<float>* out = new StaticVector<float>();
-            return out;
-        }
-
-        float depthP1 = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
-        if(depth > depthP1)
-        {
-            direction = -1.0f;
-        }
-    }
-
-    StaticVector<float>* out1 = new StaticVector<float>();
-    out1->reserve(2 * maxDepthsHalf);
-
-    Point2d tpix = midpoint;
-    float depthOld = -1.0f;
-    int istep = 0;
-    bool ok = true;
-
-    // compute depths for all pixels from the middle point to on one side of the epipolar line
-    while((out1->size() < maxDepthsHalf) && (mp->isPixelInImage(tpix, tc) == true) && (ok == true))
-    {
-        tpix = tpix + pixelVect * direction;
-
-        Point3d refvect = mp->iCamArr[rc] * rmid;
-        Point3d tarvect = mp->iCamArr[tc] * tpix;
-        float rptpang = angleBetwV1andV2(refvect, tarvect);
-
-        Point3d p;
-        ok = triangulateMatch(p, rmid, tpix, rc, tc, mp);
-
-        float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
-        if (mp->isPixelInImage(tpix, tc)
-            && (depth > 0.0f) && (depth > depthOld)
-            && checkPair(p, rc, tc, mp, mp->getMinViewAngle(), mp->getMaxViewAngle())
-            && (rptpang > mp->getMinViewAngle())  // WARNING if vects are near parallel thaen this results to strange angles ...
-            && (rptpang < mp->getMaxViewAngle())) // this is the propper angle ... beacause is does not depend on the triangluated p
-        {
-            out1->push_back(depth);
-            // if ((tpix.x!=tpixold.x)||(tpix.y!=tpixold.y)||(depthOld>=depth))
-            //{
-            // printf("after %f %f %f %f %i %f %f\n",tpix.x,tpix.y,depth,depthOld,istep,ang,kk);
-            //};
-        }
-        else
-        {
-            ok = false;
-        }
-        depthOld = depth;
-        istep++;
-    }
-
-    StaticVector<float>* out2 = new StaticVector<float>();
-    out2->reserve(2 * maxDepthsHalf);
-    tpix = midpoint;
-    istep = 0;
-    ok = true;
-
-    // compute depths for all pixels from the middle point to the other side of the epipolar line
-    while((out2->size() < maxDepthsHalf) && (mp->isPixelInImage(tpix, tc) == true) && (ok == true))
-    {
-        Point3d refvect = mp->iCamArr[rc] * rmid;
-        Point3d tarvect = mp->iCamArr[tc] * tpix;
-        float rptpang = angleBetwV1andV2(refvect, tarvect);
-
-        Point3d p;
-        ok = triangulateMatch(p, rmid, tpix, rc, tc, mp);
-
-        float depth = orientedPointPlaneDistance(p, rcplane.p, rcplane.n);
-        if(mp->isPixelInImage(tpix, tc)
-            && (depth > 0.0f) && (depth < depthOld) 
-            && checkPair(p, rc, tc, mp, mp->getMinViewAngle(), mp->getMaxViewAngle())
-            && (rptpang > mp->getMinViewAngle())  // WARNING if vects are near parallel thaen this results to strange angles ...
-            && (rptpang < mp->getMaxViewAngle())) // this is the propper angle ... beacause is does not depend on the triangluated p
-        {
-            out2->push_back(depth);
-            // printf("%f %f\n",tpix.x,tpix.y);
-        }
-        else
-        {
-            ok = false;
-        }
-
-        depthOld = depth;
-        tpix = tpix - pixelVect * direction;
-    }
-
-    // printf("out2\n");
-    StaticVector<float>* out = new StaticVector<float>();
-    out->reserve(2 * maxDepthsHalf);
-    for(int i = out2->size() - 1; i >= 0; i--)
-    {
-        out->push_back((*out2)[i]);
-        // printf("%f\n",(*out2)[i]);
-    }
-    // printf("out1\n");
-    for(int i = 0; i < out1->size(); i++)
-    {
-        out->push_back((*out1)[i]);
-        // printf("%f\n",(*out1)[i]);
-    }
-
-    delete out2;
-    delete out1;
-
-    // we want to have it in ascending order
-    if(out->size() > 0 && (*out)[0] > (*out)[out->size() - 1])
-    {
-        StaticVector<float>* outTmp = new StaticVector<float>();
-        outTmp->reserve(out->size());
-        for(int i = out->size() - 1; i >= 0; i--)
-        {
-            outTmp->push_back((*out)[i]);
-        }
-        delete out;
-        out = outTmp;
-    }
-
-    // check if it is asc
-    for(int i = 0; i < out->size() - 1; i++)
-    {
-        if((*out)[i] > (*out)[i + 1])
-        {
-
-            for(int j = 0; j <= i + 1; j++)
-            {
-                ALICEVISION_LOG_TRACE("getDepthsRcTc: check if it is asc: " << (*out)[j]);
-            }
-            ALICEVISION_LOG_WARNING("getDepthsRcTc: not asc");
-
-            if(out->size() > 1)
-            {
-                qsort(&(*out)[0], out->size(), sizeof(float), qSortCompareFloatAsc);
-            }
-        }
-    }
-
-    if(_verbose == true)
-    {
-        ALICEVISION_LOG_DEBUG("used depths: " << out->size());
-    }
-
-    return out;
 }
 
 bool PlaneSweepingCuda::refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
                                              StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh,
                                              float gammaC, float gammaP, float epipShift, int xFrom, int wPart)
 {
+    deviceStage(_profile, refine);
+
     // int w = mp->getWidth(rc)/scale;
     int w = wPart;
     int h = mp->getHeight(rc) / scale;
@@ -690,6 +419,8 @@ float PlaneSweepingCuda::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<u
                                                int volLUZ, const std::vector<float>* depths, int rc, int wsh, float gammaC,
                                                float gammaP, StaticVector<Voxel>* pixels, int scale, int step,
                                                StaticVector<int>* tcams, float epipShift) {
+    deviceStage(_profile, sweep);
+
     if(_verbose)
         ALICEVISION_LOG_DEBUG("sweepPixelsVolume:" << std::endl
                               << "\t- scale: " << scale << std::endl
@@ -801,12 +532,16 @@ float PlaneSweepingCuda::sweepPixelsToVolume(int nDepthsToSearch, StaticVector<u
 
 /**
  * @param[inout] volume input similarity volume (after Z reduction)
+ * @param[in] streamVolume stream the similarity volume by slabs for each path instead of keeping it on the device,
+ *            the device holds two volumes instead of three at the cost of four uploads
  */
 bool PlaneSweepingCuda::SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, 
                                                int volDimX, int volDimY, int volDimZ, 
                                                int volStepXY, int volLUX, int volLUY, int scale,
-                                               unsigned char P1, unsigned char P2)
+                                               unsigned char P1, unsigned char P2, bool streamVolume)
 {
+    deviceStage(_profile, SGM);
+
     if(_verbose)
         ALICEVISION_LOG_DEBUG("SGM optimizing volume:" << std::endl
                               << "\t- volDimX: " << volDimX << std::endl
@@ -817,7 +552,7 @@ bool PlaneSweepingCuda::SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>
 
     ps_SGMoptimizeSimVolume((CudaArray<uchar4, 2>**)ps_texs_arr, (cameraStruct*)(*cams)[addCam(rc, NULL, scale)],
                             volume->getDataWritable().data(), volDimX, volDimY, volDimZ, volStepXY, volLUX, volLUY, _verbose, P1, P2, scale - 1, // TODO: move the '- 1' inside the function
-                            _CUDADeviceNo, _nImgsInGPUAtTime, _scales);
+                            _CUDADeviceNo, _nImgsInGPUAtTime, _scales, streamVolume);
 
     if(_verbose)
         mvsUtils::printfElapsedTime(t1);
@@ -836,6 +571,8 @@ bool PlaneSweepingCuda::fuseDepthSimMapsGaussianKernelVoting(int w, int h, Stati
                                                                const StaticVector<StaticVector<DepthSim>*>* dataMaps,
                                                                int nSamplesHalf, int nDepthsToRefine, float sigma)
 {
+    deviceStage(_profile, fuse);
+
     long t1 = clock();
 
     // sweep
@@ -888,6 +625,8 @@ bool PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim
                                                              int nSamplesHalf, int nDepthsToRefine, float sigma,
                                                              int nIters, int yFrom, int hPart)
 {
+    deviceStage(_profile, optimize);
+
     if(_verbose)
         ALICEVISION_LOG_DEBUG("optimizeDepthSimMapGradientDescent.");
 
@@ -968,9 +707,79 @@ bool PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(StaticVector<DepthSim
     return true;
 }
 
+void PlaneSweepingCuda::refineRcTcDepthSimMap(bool useTcOrRcPixSize, int nStepsToRefine,
+                                              CudaDeviceMemoryPitched<float2, 2>& oDepthSimMap_dmp,
+                                              CudaDeviceMemoryPitched<float2, 2>& rcDepthSimMap_dmp, int rc, int tc,
+                                              int wsh, float gammaC, float gammaP, float epipShift)
+{
+    deviceStage(_profile, refine);
+
+    const int scale = 1;
+    const long t1 = clock();
+
+    cameraStruct* ttcams[2];
+    const int camsIds[2] = {addCam(rc, NULL, scale), addCam(tc, NULL, scale)};
+
+    for(int i = 0; i < 2; i++)
+    {
+        ttcams[i] = (cameraStruct*)(*cams)[camsIds[i]];
+        ttcams[i]->camId = camsIds[i];
+        ttcams[i]->rc = (i == 0) ? rc : tc;
+    }
+
+    ps_refineRcTcDepthSimMap((CudaArray<uchar4, 2>**)ps_texs_arr, oDepthSimMap_dmp, rcDepthSimMap_dmp, nStepsToRefine,
+                             ttcams, 2, scale - 1, _CUDADeviceNo, _nImgsInGPUAtTime, _scales, _verbose, wsh,
+                             gammaC, gammaP, epipShift, useTcOrRcPixSize, 1.0f);
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1);
+}
+
+void PlaneSweepingCuda::fuseDepthSimMapsGaussianKernelVoting(CudaDeviceMemoryPitched<float2, 2>& oDepthSimMap_dmp,
+                                                             std::vector<CudaDeviceMemoryPitched<float2, 2>*>& dataMaps_dmp,
+                                                             int nSamplesHalf, int nDepthsToRefine, float sigma)
+{
+    deviceStage(_profile, fuse);
+
+    const long t1 = clock();
+
+    ps_fuseDepthSimMapsGaussianKernelVoting(oDepthSimMap_dmp, dataMaps_dmp.data(), dataMaps_dmp.size(), nSamplesHalf,
+                                            nDepthsToRefine, sigma, oDepthSimMap_dmp.getUnitsInDim(0),
+                                            oDepthSimMap_dmp.getUnitsInDim(1), _verbose);
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1);
+}
+
+void PlaneSweepingCuda::optimizeDepthSimMapGradientDescent(CudaDeviceMemoryPitched<float2, 2>& oDepthSimMap_dmp,
+                                                           std::vector<CudaDeviceMemoryPitched<float2, 2>*>& dataMaps_dmp,
+                                                           int rc, int nSamplesHalf, int nDepthsToRefine, float sigma,
+                                                           int nIters)
+{
+    deviceStage(_profile, optimize);
+
+    const int scale = 1;
+    const long t1 = clock();
+
+    const int camId = addCam(rc, NULL, scale);
+    cameraStruct* ttcam = (cameraStruct*)(*cams)[camId];
+    ttcam->camId = camId;
+    ttcam->rc = rc;
+
+    ps_optimizeDepthSimMapGradientDescent((CudaArray<uchar4, 2>**)ps_texs_arr, oDepthSimMap_dmp, dataMaps_dmp.data(),
+                                          dataMaps_dmp.size(), nSamplesHalf, nDepthsToRefine, nIters, sigma, &ttcam, 1,
+                                          oDepthSimMap_dmp.getUnitsInDim(0), oDepthSimMap_dmp.getUnitsInDim(1),
+                                          scale - 1, _CUDADeviceNo, _nImgsInGPUAtTime, _scales, _verbose, 0);
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1);
+}
+
 bool PlaneSweepingCuda::computeNormalMap(StaticVector<float>* depthMap, StaticVector<Color>* normalMap, int rc,
   int scale, float igammaC, float igammaP, int wsh)
 {
+    deviceStage(_profile, normals);
+
   const int w = mp->getWidth(rc) / scale;
   const int h = mp->getHeight(rc) / scale;
 
@@ -978,8 +787,10 @@ bool PlaneSweepingCuda::computeNormalMap(StaticVector<float>* depthMap, StaticVe
 
   ALICEVISION_LOG_DEBUG("computeNormalMap rc: " << rc);
   cameraStruct camera;
-  camera.camId = rc;
+  // the camera is not in the cache, use the constant memory slot after the cached cameras
+  camera.camId = _nImgsInGPUAtTime;
   cps_fillCamera(&camera, rc, mp, nullptr, scale);
+  ps_deviceUpdateCamParams(camera, camera.camId);
 
   CudaHostMemoryHeap<float3, 2> normalMap_hmh(CudaSize<2>(w, h));
   CudaHostMemoryHeap<float, 2> depthMap_hmh(CudaSize<2>(w, h));
@@ -1005,6 +816,69 @@ bool PlaneSweepingCuda::computeNormalMap(StaticVector<float>* depthMap, StaticVe
   return true;
 }
 
+void PlaneSweepingCuda::computeNbConsistentCamsMap(int rc, StaticVector<float>& depthMap, StaticVector<float>& simMap,
+                                                   const StaticVector<int>& tcams,
+                                                   const std::function<bool(int, StaticVector<float>&)>& loadTcDepthMap,
+                                                   int pixSizeBall, int pixSizeBallWSP,
+                                                   std::vector<unsigned char>& nmodMap)
+{
+    deviceStage(_profile, filter);
+
+    const int w = mp->getWidth(rc);
+    const int h = mp->getHeight(rc);
+
+    const long t1 = clock();
+
+    // the cameras are not in the cache, use the constant memory slots after the cached cameras
+    cameraStruct rcCamera;
+    rcCamera.camId = _nImgsInGPUAtTime;
+    cps_fillCamera(&rcCamera, rc, mp, nullptr, 1);
+    ps_deviceUpdateCamParams(rcCamera, rcCamera.camId);
+
+    CudaDeviceMemoryPitched<float, 2> rcDepthMap_dmp(CudaSize<2>(w, h));
+    CudaDeviceMemoryPitched<float, 2> rcSimMap_dmp(CudaSize<2>(w, h));
+    copy(rcDepthMap_dmp, depthMap.getData().data(), w, h);
+    copy(rcSimMap_dmp, simMap.getData().data(), w, h);
+
+    CudaDeviceMemoryPitched<int, 2> numOfPtsMap_dmp(CudaSize<2>(w, h));
+    CudaDeviceMemoryPitched<unsigned char, 2> nmodMap_dmp(CudaSize<2>(w, h));
+    cudaMemset2D(numOfPtsMap_dmp.getBuffer(), numOfPtsMap_dmp.getPitch(), 0, w * sizeof(int), h);
+    cudaMemset2D(nmodMap_dmp.getBuffer(), nmodMap_dmp.getPitch(), 0, w * sizeof(unsigned char), h);
+
+    std::unique_ptr<CudaDeviceMemoryPitched<float, 2>> tcDepthMap_dmp;
+    StaticVector<float> tcDepthMap;
+
+    for(int c = 0; c < tcams.size(); ++c)
+    {
+        const int tc = tcams[c];
+
+        if(!loadTcDepthMap(tc, tcDepthMap) || tcDepthMap.empty())
+            continue;
+
+        const int tcWidth = mp->getWidth(tc);
+        const int tcHeight = mp->getHeight(tc);
+
+        if(tcDepthMap_dmp == nullptr || tcDepthMap_dmp->getUnitsInDim(0) != tcWidth || tcDepthMap_dmp->getUnitsInDim(1) != tcHeight)
+            tcDepthMap_dmp.reset(new CudaDeviceMemoryPitched<float, 2>(CudaSize<2>(tcWidth, tcHeight)));
+        copy(*tcDepthMap_dmp, tcDepthMap.getData().data(), tcWidth, tcHeight);
+
+        cameraStruct tcCamera;
+        tcCamera.camId = _nImgsInGPUAtTime + 1;
+        cps_fillCamera(&tcCamera, tc, mp, nullptr, 1);
+        ps_deviceUpdateCamParams(tcCamera, tcCamera.camId);
+
+        ps_countConsistentPoints(numOfPtsMap_dmp, rcDepthMap_dmp, rcSimMap_dmp, *tcDepthMap_dmp,
+                                 rcCamera.camId, tcCamera.camId, mp->g_border, pixSizeBall, pixSizeBallWSP);
+        ps_updateNbConsistentCamsMap(nmodMap_dmp, numOfPtsMap_dmp);
+    }
+
+    nmodMap.resize(w * h);
+    copy(nmodMap.data(), w, h, nmodMap_dmp);
+
+    if(_verbose)
+        mvsUtils::printfElapsedTime(t1, "computeNbConsistentCamsMap");
+}
+
 bool PlaneSweepingCuda::getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc)
 {
     if(_verbose)
@@ -1039,6 +913,18 @@ bool PlaneSweepingCuda::getSilhoueteMap(StaticVectorBool* oMap, int scale, int s
     return true;
 }
 
+static_assert(sizeof(DepthSim) == sizeof(float2), "DepthSim and float2 maps are copied as is");
+
+void copy(CudaDeviceMemoryPitched<float2, 2>& dst, const DepthSimMap& src)
+{
+    copy(dst, reinterpret_cast<const float2*>(src.dsm->getData().data()), src.w, src.h);
+}
+
+void copy(DepthSimMap& dst, const CudaDeviceMemoryPitched<float2, 2>& src)
+{
+    copy(reinterpret_cast<float2*>(dst.dsm->getDataWritable().data()), dst.w, dst.h, src);
+}
+
 int listCUDADevices(bool verbose)
 {
     return ps_listCUDADevices(verbose);
@@ -17,12 +17,17 @@
 #include <aliceVision/mvsData/Voxel.hpp>
 #include <aliceVision/mvsUtils/ImagesCache.hpp>
 #include <aliceVision/depthMap/DepthSimMap.hpp>
+#include <aliceVision/depthMap/PlaneSweeping.hpp>
 #include <aliceVision/depthMap/cuda/commonStructures.hpp>
+#include <aliceVision/depthMap/cuda/DeviceProfile.hpp>
+
+#include <functional>
+#include <vector>
 
 namespace aliceVision {
 namespace depthMap {
 
-class PlaneSweepingCuda
+class PlaneSweepingCuda : public PlaneSweeping
 {
 public:
     struct parameters
@@ -47,11 +52,8 @@ public:
         }
     };
 
-    const int _scales;
     const int _nbest; // == 1
 
-    mvsUtils::MultiViewParams* mp;
-
     const int _CUDADeviceNo;
     void** ps_texs_arr;
 
@@ -59,7 +61,6 @@ public:
     StaticVector<int>* camsRcs;
     StaticVector<long>* camsTimes;
 
-    const bool _verbose;
     bool doVizualizePartialDepthMaps;
     const int  _nbestkernelSizeHalf;
 
@@ -71,18 +72,42 @@ public:
     int  varianceWSH;
 
     // float gammaC,gammaP;
-    mvsUtils::ImagesCache& _ic;
 
-    PlaneSweepingCuda(int CUDADeviceNo, mvsUtils::ImagesCache& _ic, mvsUtils::MultiViewParams* _mp, int scales);
-    ~PlaneSweepingCuda(void);
+private:
+    /// last access of the device images cache, the slot with the smallest access in camsTimes is evicted first
+    long _imagesCacheAccess = 0;
+    long _nbImagesCacheHits = 0;
+    long _nbImagesCacheMisses = 0;
+    /// statistics of the device stages of the current rc
+    DeviceProfile _profile;
+    /// id of the device memory pool in the system::MemoryTracker GPU memory
+    int _memoryProviderId = -1;
+
+public:
 
+    PlaneSweepingCuda(int CUDADeviceNo, mvsUtils::ImagesCache& _ic, mvsUtils::MultiViewParams* _mp, int scales);
+    ~PlaneSweepingCuda(void) override;
+
+    /**
+     * @brief Get the slot of a camera in the device images cache, upload its images if they are not cached.
+     * @param[in] rc the camera index
+     * @param[in] H the homography to store in the camera structure or NULL
+     * @param[in] scale the scale of the camera parameters
+     * @return the slot of the camera, index in cams and in the device camera parameters
+     */
     int addCam(int rc, float** H, int scale);
 
-    void getMinMaxdepths(int rc, const StaticVector<int>& tcams, float& minDepth, float& midDepth, float& maxDepth);
+    /// Number of addCam calls that found the camera images in the device memory
+    long getNbImagesCacheHits() const { return _nbImagesCacheHits; }
+    /// Number of addCam calls that uploaded the camera images to the device memory
+    long getNbImagesCacheMisses() const { return _nbImagesCacheMisses; }
+    /// Ratio of the addCam calls that found the camera images in the device memory
+    float getImagesCacheHitRate() const;
+
+    /// Statistics of the device stages, enabled by the depthMap.deviceProfile parameter
+    DeviceProfile& getProfile() { return _profile; }
+
     void getAverageMinMaxdepths(float& avMinDist, float& avMaxDist);
-    StaticVector<float>* getDepthsByPixelSize(int rc, float minDepth, float midDepth, float maxDepth, int scale,
-                                              int step, int maxDepthsHalf = 1024);
-    StaticVector<float>* getDepthsRcTc(int rc, int tc, int scale, float midDepth, int maxDepthsHalf = 1024);
 
     bool refinePixelsAll(bool useTcOrRcPixSize, int ndepthsToRefine, StaticVector<float>* pxsdepths,
                          StaticVector<float>* pxssims, int rc, int wsh, float igammaC, float igammaP,
@@ -94,6 +119,20 @@ public:
     bool filterDepthMap(StaticVector<float>* depthMap, int rc, int scale, float igammaC, float minCostThr, int wsh);
     bool computeNormalMap(StaticVector<float>* depthMap, StaticVector<Color>* normalMap, int rc, int scale,
                           float igammaC, float igammaP, int wsh);
+
+    /**
+     * @brief Count for each pixel of the rc depth map the tc depth maps consistent with its depth,
+     *        same as fuseCut::Fuser::filterGroupsRC on the GPU. The maps are at scale 1.
+     * @param[in] depthMap, simMap the rc depth and similarity maps
+     * @param[in] tcams the neighbor cameras
+     * @param[in] loadTcDepthMap loads the depth map of a tc, returns false if it is not available
+     * @param[in] pixSizeBall, pixSizeBallWSP the neighborhood radius, for the weakly supported pixels (sim >= 1)
+     * @param[out] nmodMap the number of consistent tcams of each pixel
+     */
+    void computeNbConsistentCamsMap(int rc, StaticVector<float>& depthMap, StaticVector<float>& simMap,
+                                    const StaticVector<int>& tcams,
+                                    const std::function<bool(int, StaticVector<float>&)>& loadTcDepthMap,
+                                    int pixSizeBall, int pixSizeBallWSP, std::vector<unsigned char>& nmodMap);
     void alignSourceDepthMapToTarget(StaticVector<float>* sourceDepthMap, StaticVector<float>* targetDepthMap, int rc,
                                      int scale, float igammaC, int wsh, float maxPixelSizeDist);
     bool refineDepthMapReproject(StaticVector<float>* depthMap, StaticVector<float>* simMap, int rc, int tc, int wsh,
@@ -107,16 +146,17 @@ public:
                                       int wsh, float gammaC, float gammaP, float epipShift);
     bool refineRcTcDepthMap(bool useTcOrRcPixSize, int nStepsToRefine, StaticVector<float>* simMap,
                             StaticVector<float>* rcDepthMap, int rc, int tc, int scale, int wsh, float gammaC,
-                            float gammaP, float epipShift, int xFrom, int wPart);
+                            float gammaP, float epipShift, int xFrom, int wPart) override;
 
     float sweepPixelsToVolume(int nDepthsToSearch, StaticVector<unsigned char>* volume, int volDimX, int volDimY,
                               int volDimZ, int volStepXY, int volLUX, int volLUY, int volLUZ,
                               const std::vector<float>* depths, int rc, int wsh, float gammaC, float gammaP,
                               StaticVector<Voxel>* pixels, int scale, int step, StaticVector<int>* tcams,
-                              float epipShift);
+                              float epipShift) override;
     bool SGMoptimizeSimVolume(int rc, StaticVector<unsigned char>* volume, int volDimX, int volDimY, int volDimZ,
-                              int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1, unsigned char P2);
-    Point3d getDeviceMemoryInfo();
+                              int volStepXY, int volLUX, int volLUY, int scale, unsigned char P1, unsigned char P2,
+                              bool streamVolume) override;
+    Point3d getDeviceMemoryInfo() override;
     bool transposeVolume(StaticVector<unsigned char>* volume, const Voxel& dimIn, const Voxel& dimTrn, Voxel& dimOut);
 
     bool computeRcVolumeForRcTcsDepthSimMaps(StaticVector<unsigned int>* volume,
@@ -137,10 +177,37 @@ public:
 
     bool fuseDepthSimMapsGaussianKernelVoting(int w, int h, StaticVector<DepthSim> *oDepthSimMap,
                                               const StaticVector<StaticVector<DepthSim> *> *dataMaps, int nSamplesHalf,
-                                              int nDepthsToRefine, float sigma);
+                                              int nDepthsToRefine, float sigma) override;
     bool optimizeDepthSimMapGradientDescent(StaticVector<DepthSim> *oDepthSimMap,
                                             StaticVector<StaticVector<DepthSim> *> *dataMaps, int rc, int nSamplesHalf,
-                                            int nDepthsToRefine, float sigma, int nIters, int yFrom, int hPart);
+                                            int nDepthsToRefine, float sigma, int nIters, int yFrom, int hPart) override;
+
+    /**
+     * @brief Refine the depths of a whole rc depth/sim map with tc, the maps stay in the device memory
+     *        (same as RcTc::refineRcTcDepthSimMap with DepthSimMap::initJustFromDepthMap(depthMap, 1.0f)).
+     * @param[out] oDepthSimMap_dmp the refined map, same size as rcDepthSimMap_dmp
+     * @param[in] rcDepthSimMap_dmp the depths to refine around, at scale 1
+     */
+    void refineRcTcDepthSimMap(bool useTcOrRcPixSize, int nStepsToRefine, CudaDeviceMemoryPitched<float2, 2>& oDepthSimMap_dmp,
+                               CudaDeviceMemoryPitched<float2, 2>& rcDepthSimMap_dmp, int rc, int tc, int wsh,
+                               float gammaC, float gammaP, float epipShift);
+    /**
+     * @brief Same as fuseDepthSimMapsGaussianKernelVoting for the whole maps in the device memory
+     * @param[out] oDepthSimMap_dmp the fused map, same size as the data maps
+     * @param[in] dataMaps_dmp the depth/pixSize map to fuse around, then the maps of each tc
+     */
+    void fuseDepthSimMapsGaussianKernelVoting(CudaDeviceMemoryPitched<float2, 2>& oDepthSimMap_dmp,
+                                              std::vector<CudaDeviceMemoryPitched<float2, 2>*>& dataMaps_dmp,
+                                              int nSamplesHalf, int nDepthsToRefine, float sigma);
+    /**
+     * @brief Same as optimizeDepthSimMapGradientDescent for the whole maps in the device memory
+     * @param[out] oDepthSimMap_dmp the optimized map, same size as the data maps
+     * @param[in] dataMaps_dmp the depth/pixSize map and the fused depth/sim map
+     */
+    void optimizeDepthSimMapGradientDescent(CudaDeviceMemoryPitched<float2, 2>& oDepthSimMap_dmp,
+                                            std::vector<CudaDeviceMemoryPitched<float2, 2>*>& dataMaps_dmp, int rc,
+                                            int nSamplesHalf, int nDepthsToRefine, float sigma, int nIters);
+
     bool computeDP1Volume(StaticVector<int>* ovolume, StaticVector<unsigned int>* ivolume, int _volDimX, int volDimY,
                           int volDimZ, int xFrom, int xTo);
 
@@ -149,10 +216,13 @@ public:
                                                      bool moveByTcOrRc, float moveStep);
     bool computeRcTcdepthMap(StaticVector<float>* iRcDepthMap_oRcTcDepthMap, StaticVector<float>* tcDdepthMap, int rc,
                              int tc, float pixSizeRatioThr);
-    bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc);
+    bool getSilhoueteMap(StaticVectorBool* oMap, int scale, int step, const rgb maskColor, int rc) override;
 };
 
-int listCUDADevices(bool verbose);
+/// Upload a depth/sim map into a device map of the same size
+void copy(CudaDeviceMemoryPitched<float2, 2>& dst, const DepthSimMap& src);
+/// Download a device map into a depth/sim map of the same size
+void copy(DepthSimMap& dst, const CudaDeviceMemoryPitched<float2, 2>& src);
 
 } // namespace depthMap
 } // namespace aliceVision
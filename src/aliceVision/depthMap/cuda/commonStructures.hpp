@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <aliceVision/depthMap/cuda/DeviceMemoryPool.hpp>
+
 #include <cuda_runtime.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -14,6 +16,9 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <chrono>
+#include <algorithm>
+#include <memory>
 
 #define THROW_ON_CUDA_ERROR(rcode, message) \
   if (rcode != cudaSuccess) {  \
@@ -25,6 +30,66 @@
 namespace aliceVision {
 namespace depthMap {
 
+/*********************************************************************************
+ * host/device transfers statistics
+ *********************************************************************************/
+
+/**
+ * @brief Time and size of the synchronous host/device transfers of the calling thread
+ *        (there is one thread per device), only measured when enabled.
+ *        The used device memory is sampled at each transfer.
+ */
+struct DeviceTransferStats
+{
+    bool enabled = false;
+    double timeMs = 0.0;
+    double bytes = 0.0;
+    float peakUsedMB = 0.0f;
+};
+
+inline DeviceTransferStats& getDeviceTransferStats()
+{
+    static thread_local DeviceTransferStats stats;
+    return stats;
+}
+
+/**
+ * @brief Measure a host/device transfer in the DeviceTransferStats of the thread.
+ *        The device is synchronized first so that the pending kernels are not counted.
+ */
+class DeviceTransferScope
+{
+public:
+    explicit DeviceTransferScope(size_t bytes)
+        : _bytes(bytes)
+        , _enabled(getDeviceTransferStats().enabled)
+    {
+        if(!_enabled)
+            return;
+        cudaDeviceSynchronize();
+        _start = std::chrono::steady_clock::now();
+    }
+
+    ~DeviceTransferScope()
+    {
+        if(!_enabled)
+            return;
+        DeviceTransferStats& stats = getDeviceTransferStats();
+        stats.timeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+        stats.bytes += _bytes;
+
+        size_t freeBytes = 0;
+        size_t totalBytes = 0;
+        if(cudaMemGetInfo(&freeBytes, &totalBytes) == cudaSuccess)
+            stats.peakUsedMB = std::max(stats.peakUsedMB, static_cast<float>(totalBytes - freeBytes) / (1024.0f * 1024.0f));
+    }
+
+private:
+    const size_t _bytes;
+    const bool _enabled;
+    std::chrono::steady_clock::time_point _start;
+};
+
 /*********************************************************************************
  * forward declarations
  *********************************************************************************/
@@ -371,7 +436,9 @@ public:
     {
         this->setSize( size, true );
 
-        cudaError_t err = cudaMallocHost( &buffer, this->getBytesUnpadded() );
+        void* ptr = nullptr;
+        cudaError_t err = DeviceMemoryPool::get().allocateHost( &ptr, this->getBytesUnpadded() );
+        buffer = static_cast<Type*>(ptr);
 
         THROW_ON_CUDA_ERROR( err, "Could not allocate pinned host memory in " << __FILE__ << ":" << __LINE__ << ", " << cudaGetErrorString(err) );
     }
@@ -379,9 +446,22 @@ public:
     void deallocate( )
     {
         if( buffer == nullptr ) return;
-        cudaFreeHost(buffer);
+        DeviceMemoryPool::get().deallocateHost(buffer);
         buffer = nullptr;
     }
+
+    /* Allocate count buffers of the given size in the memory pool of the current device
+     * and release them, the next allocations of this size are served from the pool.
+     */
+    static void reserve( const CudaSize<Dim> &size, int count = 1 )
+    {
+        std::vector<std::unique_ptr<CudaHostMemoryHeap<Type, Dim>>> buffers;
+        for( int i = 0; i < count; ++i )
+        {
+            buffers.emplace_back( new CudaHostMemoryHeap<Type, Dim>() );
+            buffers.back()->allocate( size );
+        }
+    }
 };
 
 /*********************************************************************************
@@ -489,12 +569,15 @@ public:
     {
         this->setSize( size, false );
 
+        // the rows are padded as cudaMallocPitch/cudaMalloc3D do, the block comes from the memory pool
+        DeviceMemoryPool& memoryPool = DeviceMemoryPool::get();
+        this->setPitch( memoryPool.getPitch( this->getUnpaddedBytesInRow() ) );
+
         if(Dim == 2)
         {
-            cudaError_t err = cudaMallocPitch<Type>(&buffer,
-                                                    &this->getPitchRef(),
-                                                    this->getUnpaddedBytesInRow(),
-                                                    this->getUnitsInDim(1) );
+            void* ptr = nullptr;
+            cudaError_t err = memoryPool.allocateDevice( &ptr, this->getBytesPadded() );
+            buffer = static_cast<Type*>(ptr);
             if( err != cudaSuccess )
             {
                 int devid;
@@ -507,12 +590,9 @@ public:
         }
         else if(Dim == 3)
         {
-            cudaExtent extent;
-            extent.width  = this->getUnpaddedBytesInRow();
-            extent.height = this->getUnitsInDim(1);
-            extent.depth  = this->getUnitsInDim(2);
-            cudaPitchedPtr pitchDevPtr;
-            cudaError_t err = cudaMalloc3D(&pitchDevPtr, extent);
+            void* ptr = nullptr;
+            cudaError_t err = memoryPool.allocateDevice( &ptr, this->getBytesPadded() );
+            buffer = static_cast<Type*>(ptr);
             if( err != cudaSuccess )
             {
                 int devid;
@@ -529,9 +609,6 @@ public:
                 << (int)(bytes/1024.0f/1024.0f) << " MB) failed in " << __FILE__ << ":" << __LINE__ << ", " << cudaGetErrorString(err);
                 throw std::runtime_error(ss.str());
             }
-
-            buffer = (Type*)pitchDevPtr.ptr;
-            this->setPitch( pitchDevPtr.pitch );
         }
     }
 
@@ -539,7 +616,7 @@ public:
     {
         if( buffer == nullptr ) return;
 
-        cudaError_t err = cudaFree(buffer);
+        cudaError_t err = DeviceMemoryPool::get().deallocateDevice(buffer);
         if( err != cudaSuccess )
         {
             std::stringstream ss;
@@ -549,6 +626,20 @@ public:
 
         buffer = nullptr;
     }
+
+    /* Allocate count buffers of the given size in the memory pool of the current device
+     * and release them, the next allocations of this size are served from the pool.
+     * It reserves the working set before the allocations of other sizes fragment the device memory.
+     */
+    static void reserve( const CudaSize<Dim>& size, int count = 1 )
+    {
+        std::vector<std::unique_ptr<CudaDeviceMemoryPitched<Type, Dim>>> buffers;
+        for( int i = 0; i < count; ++i )
+        {
+            buffers.emplace_back( new CudaDeviceMemoryPitched<Type, Dim>() );
+            buffers.back()->allocate( size );
+        }
+    }
 };
 
 /*********************************************************************************
@@ -626,7 +717,9 @@ public:
     {
         this->setSize( size, true );
 
-        cudaError_t err = cudaMalloc(&buffer, this->getBytesUnpadded() );
+        void* ptr = nullptr;
+        cudaError_t err = DeviceMemoryPool::get().allocateDevice( &ptr, this->getBytesUnpadded() );
+        buffer = static_cast<Type*>(ptr);
 
         THROW_ON_CUDA_ERROR( err, "Could not allocate pinned host memory in " << __FILE__ << ":" << __LINE__ << ", " << cudaGetErrorString(err) );
     }
@@ -639,7 +732,7 @@ public:
     {
         if( buffer == nullptr ) return;
 
-        cudaError_t err = cudaFree(buffer);
+        cudaError_t err = DeviceMemoryPool::get().deallocateDevice(buffer);
         if( err != cudaSuccess )
         {
             std::stringstream ss;
@@ -652,6 +745,7 @@ public:
 
     void copyFrom( const Type* inbuf, const size_t num )
     {
+        DeviceTransferScope transfer(num * sizeof(Type));
         cudaMemcpyKind kind = cudaMemcpyHostToDevice;
         cudaError_t err = cudaMemcpy( buffer,
                                       inbuf,
@@ -758,6 +852,7 @@ public:
 template<class Type, unsigned Dim>
 void CudaDeviceMemoryPitched<Type, Dim>::copyFrom( const CudaHostMemoryHeap<Type, Dim>& src )
 {
+    DeviceTransferScope transfer(src.getBytesUnpadded());
     const cudaMemcpyKind kind = cudaMemcpyHostToDevice;
     if(Dim == 1)
     {
@@ -786,6 +881,7 @@ void CudaDeviceMemoryPitched<Type, Dim>::copyFrom( const CudaHostMemoryHeap<Type
 template<class Type, unsigned Dim>
 void CudaDeviceMemoryPitched<Type, Dim>::copyFrom( const Type* src, size_t sx, size_t sy )
 {
+    DeviceTransferScope transfer(sx * sy * sizeof(Type));
     if(Dim == 2)
     {
         const size_t src_pitch  = sx * sizeof(Type);
@@ -834,6 +930,7 @@ void CudaDeviceMemoryPitched<Type, Dim>::copyFrom(const CudaDeviceMemoryPitched<
 template<class Type, unsigned Dim>
 void CudaHostMemoryHeap<Type, Dim>::copyFrom( const CudaDeviceMemoryPitched<Type, Dim>& src )
 {
+    DeviceTransferScope transfer(this->getBytesUnpadded());
     const cudaMemcpyKind kind = cudaMemcpyDeviceToHost;
     if(Dim == 1)
     {
@@ -871,6 +968,7 @@ template<class Type, unsigned Dim> void copy(CudaHostMemoryHeap<Type, Dim>& dst,
 
 template<class Type> void copy(CudaHostMemoryHeap<Type,1>& _dst, const CudaDeviceMemory<Type>& _src)
 {
+  DeviceTransferScope transfer(_dst.getBytesUnpadded());
   cudaMemcpyKind kind = cudaMemcpyDeviceToHost;
   cudaError_t err = cudaMemcpy(_dst.getBytePtr(),
                                _src.getBytePtr(),
@@ -881,6 +979,7 @@ template<class Type> void copy(CudaHostMemoryHeap<Type,1>& _dst, const CudaDevic
 
 template<class Type, unsigned Dim> void copy(CudaHostMemoryHeap<Type, Dim>& _dst, const CudaArray<Type, Dim>& _src)
 {
+  DeviceTransferScope transfer(_dst.getBytesUnpadded());
   cudaMemcpyKind kind = cudaMemcpyDeviceToHost;
   if(Dim == 1) {
     cudaError_t err = cudaMemcpyFromArray(_dst.getBytePtr(),
@@ -938,6 +1037,7 @@ template<class Type, unsigned Dim> void copy(CudaDeviceMemoryPitched<Type, Dim>&
 
 template<class Type> void copy(CudaDeviceMemory<Type>& _dst, const CudaHostMemoryHeap<Type,1>& _src)
 {
+  DeviceTransferScope transfer(_src.getBytesUnpadded());
   const cudaMemcpyKind kind = cudaMemcpyHostToDevice;
   cudaError_t err = cudaMemcpy(_dst.getBytePtr(),
                                _src.getBytePtr(),
@@ -997,6 +1097,7 @@ template<class Type, unsigned Dim> void copy(CudaDeviceMemoryPitched<Type, Dim>&
 
 template<class Type, unsigned Dim> void copy(CudaArray<Type, Dim>& _dst, const CudaHostMemoryHeap<Type, Dim>& _src)
 {
+  DeviceTransferScope transfer(_src.getBytesUnpadded());
   const cudaMemcpyKind kind = cudaMemcpyHostToDevice;
   if(Dim == 1) {
     cudaError_t err = cudaMemcpyToArray(_dst.getArray(),
@@ -1093,6 +1194,7 @@ template<class Type, unsigned Dim> void copy(CudaArray<Type, Dim>& _dst, const C
 
 template<class Type, unsigned Dim> void copy(Type* _dst, size_t sx, size_t sy, const CudaDeviceMemoryPitched<Type, Dim>& _src)
 {
+  DeviceTransferScope transfer(sx * sy * sizeof(Type));
   if(Dim == 2) {
     cudaError_t err = cudaMemcpy2D(_dst,
                                    sx * sizeof (Type),
@@ -1112,6 +1214,7 @@ template<class Type, unsigned Dim> void copy(CudaDeviceMemoryPitched<Type, Dim>&
 
 template<class Type, unsigned Dim> void copy(Type* _dst, size_t sx, size_t sy, size_t sz, const CudaDeviceMemoryPitched<Type, Dim>& _src)
 {
+    DeviceTransferScope transfer(sx * sy * sz * sizeof(Type));
     if(Dim >= 3)
     {
       cudaError_t err = cudaMemcpy2D( _dst,
@@ -1127,6 +1230,7 @@ template<class Type, unsigned Dim> void copy(Type* _dst, size_t sx, size_t sy, s
 
 template<class Type, unsigned Dim> void copy(CudaDeviceMemoryPitched<Type, Dim>& _dst, const Type* _src, size_t sx, size_t sy, size_t sz)
 {
+    DeviceTransferScope transfer(sx * sy * sz * sizeof(Type));
     if(Dim >= 3)
     {
       cudaError_t err = cudaMemcpy2D( _dst.getBytePtr(),
@@ -1176,5 +1280,8 @@ struct ps_parameters
 #define MAX_PTS 500           // 500
 #define MAX_PATCH_PIXELS 2500 // 50*50
 
+// number of camera parameters slots in the device constant memory (276 bytes each)
+#define MAX_CONSTANT_CAMERA_PARAM_SETS 100
+
 } // namespace depthMap
 } // namespace aliceVision
@@ -90,27 +90,28 @@ __device__ __constant__ unsigned char distFcnConst3[3] = {0, 94, 125};
 
 #define BLOCK_DIM 8
 
-__device__ __constant__ float sg_s_rP[12];  // 12*4 bytes
-__device__ __constant__ float sg_s_riP[9];  // 12*4 bytes
-__device__ __constant__ float sg_s_rR[9];   // 9*4 bytes
-__device__ __constant__ float sg_s_riR[9];  // 9*4 bytes
-__device__ __constant__ float sg_s_rK[9];   // 9*4 bytes
-__device__ __constant__ float sg_s_riK[9];  // 9*4 bytes
-__device__ __constant__ float3 sg_s_rC;     // 3*4 bytes
-__device__ __constant__ float3 sg_s_rXVect; // 3*4 bytes
-__device__ __constant__ float3 sg_s_rYVect; // 3*4 bytes
-__device__ __constant__ float3 sg_s_rZVect; // 3*4 bytes
-
-__device__ __constant__ float sg_s_tP[12];  // 12*4 bytes
-__device__ __constant__ float sg_s_tiP[12]; // 12*4 bytes
-__device__ __constant__ float sg_s_tR[9];   // 9*4 bytes
-__device__ __constant__ float sg_s_tiR[9];  // 9*4 bytes
-__device__ __constant__ float sg_s_tK[9];   // 9*4 bytes
-__device__ __constant__ float sg_s_tiK[9];  // 9*4 bytes
-__device__ __constant__ float3 sg_s_tC;     // 3*4 bytes
-__device__ __constant__ float3 sg_s_tXVect; // 3*4 bytes
-__device__ __constant__ float3 sg_s_tYVect; // 3*4 bytes
-__device__ __constant__ float3 sg_s_tZVect; // 3*4 bytes
+/**
+ * @brief Camera parameters in constant memory.
+ * The parameters of each camera of the PlaneSweepingCuda images cache are uploaded once in its own slot,
+ * the kernels get the slots of their reference and target cameras as arguments.
+ * So the kernels working on different camera pairs don't overwrite each other's parameters.
+ */
+struct CameraStructBase
+{
+    float P[12];   // 12*4 bytes
+    float iP[9];   // 9*4 bytes
+    float R[9];    // 9*4 bytes
+    float iR[9];   // 9*4 bytes
+    float K[9];    // 9*4 bytes
+    float iK[9];   // 9*4 bytes
+    float3 C;      // 3*4 bytes
+    float3 XVect;  // 3*4 bytes
+    float3 YVect;  // 3*4 bytes
+    float3 ZVect;  // 3*4 bytes
+};
+
+// total bytes 276*MAX_CONSTANT_CAMERA_PARAM_SETS
+__device__ __constant__ CameraStructBase constantCameraParametersArray_d[MAX_CONSTANT_CAMERA_PARAM_SETS];
 
 /*
 __device__ __constant__ struct shared_rCam_tCam
@@ -16,14 +16,15 @@
 namespace aliceVision {
 namespace depthMap {
 
-__device__ void computeRotCSEpip(patch& ptch, const float3& p)
+__device__ void computeRotCSEpip(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                 patch& ptch, const float3& p)
 {
     ptch.p = p;
 
     // Vector from the reference camera to the 3d point
-    float3 v1 = sg_s_rC - p;
+    float3 v1 = rcCam.C - p;
     // Vector from the target camera to the 3d point
-    float3 v2 = sg_s_tC - p;
+    float3 v2 = tcCam.C - p;
     normalize(v1);
     normalize(v2);
 
@@ -36,7 +37,7 @@ __device__ void computeRotCSEpip(patch& ptch, const float3& p)
 
     ptch.n = (v1 + v2) / 2.0f; // IMPORTANT !!!
     normalize(ptch.n);
-    // ptch.n = sg_s_rZVect; //IMPORTANT !!!
+    // ptch.n = rcCam.ZVect; //IMPORTANT !!!
 
     ptch.x = cross(ptch.y, ptch.n);
     normalize(ptch.x);
@@ -47,17 +48,17 @@ __device__ int angleBetwUnitV1andUnitV2(float3& V1, float3& V2)
     return (int)fabs(acos(V1.x * V2.x + V1.y * V2.y + V1.z * V2.z) / (CUDART_PI_F / 180.0f));
 }
 
-__device__ bool checkPatch(patch& ptch, int angThr)
+__device__ bool checkPatch(const CameraStructBase& rcCam, const CameraStructBase& tcCam, patch& ptch, int angThr)
 {
 
-    float3 rv = (sg_s_rC - ptch.p);
-    float3 tv = (sg_s_tC - ptch.p);
+    float3 rv = (rcCam.C - ptch.p);
+    float3 tv = (tcCam.C - ptch.p);
     normalize(rv);
     normalize(tv);
 
     float3 n = ptch.n;
 
-    if(size(sg_s_rC - (ptch.p + ptch.n)) > size(sg_s_rC - (ptch.p - ptch.n)))
+    if(size(rcCam.C - (ptch.p + ptch.n)) > size(rcCam.C - (ptch.p - ptch.n)))
     {
         n.x = -n.x;
         n.y = -n.y;
@@ -70,7 +71,7 @@ __device__ bool checkPatch(patch& ptch, int angThr)
 /*
 __device__ float getRefCamPixSize(patch &ptch)
 {
-        float2 rp = project3DPoint(sg_s_rP,ptch.p);
+        float2 rp = project3DPoint(rcCam.P,ptch.p);
 
         float minstep=10000000.0f;
         for (int i=0;i<4;i++) {
@@ -79,8 +80,8 @@ __device__ float getRefCamPixSize(patch &ptch)
                 if (i==1) {pix.x -= 1.0f;};
                 if (i==2) {pix.y += 1.0f;};
                 if (i==3) {pix.y -= 1.0f;};
-                float3 vect = M3x3mulV2(sg_s_riP,pix);
-                float3 lpi = linePlaneIntersect(sg_s_rC, vect, ptch.p, ptch.n);
+                float3 vect = M3x3mulV2(rcCam.iP,pix);
+                float3 lpi = linePlaneIntersect(rcCam.C, vect, ptch.p, ptch.n);
                 float step = dist(lpi,ptch.p);
                 minstep = fminf(minstep,step);
         };
@@ -91,7 +92,7 @@ __device__ float getRefCamPixSize(patch &ptch)
 
 __device__ float getTarCamPixSize(patch &ptch)
 {
-        float2 tp = project3DPoint(sg_s_tP,ptch.p);
+        float2 tp = project3DPoint(tcCam.P,ptch.p);
 
         float minstep=10000000.0f;
         for (int i=0;i<4;i++) {
@@ -100,8 +101,8 @@ __device__ float getTarCamPixSize(patch &ptch)
                 if (i==1) {pix.x -= 1.0f;};
                 if (i==2) {pix.y += 1.0f;};
                 if (i==3) {pix.y -= 1.0f;};
-                float3 vect = M3x3mulV2(sg_s_tiP,pix);
-                float3 lpi = linePlaneIntersect(sg_s_tC, vect, ptch.p, ptch.n);
+                float3 vect = M3x3mulV2(tcCam.iP,pix);
+                float3 lpi = linePlaneIntersect(tcCam.C, vect, ptch.p, ptch.n);
                 float step = dist(lpi,ptch.p);
                 minstep = fminf(minstep,step);
         };
@@ -116,30 +117,31 @@ __device__ float getPatchPixSize(patch &ptch)
 }
 */
 
-__device__ void computeHomography(float* _H, float3& _p, float3& _n)
+__device__ void computeHomography(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                  float* _H, float3& _p, float3& _n)
 {
     // hartley zisserman second edition p.327 (13.2)
-    float3 _tl = make_float3(0.0, 0.0, 0.0) - M3x3mulV3(sg_s_rR, sg_s_rC);
-    float3 _tr = make_float3(0.0, 0.0, 0.0) - M3x3mulV3(sg_s_tR, sg_s_tC);
+    float3 _tl = make_float3(0.0, 0.0, 0.0) - M3x3mulV3(rcCam.R, rcCam.C);
+    float3 _tr = make_float3(0.0, 0.0, 0.0) - M3x3mulV3(tcCam.R, tcCam.C);
 
-    float3 p = M3x3mulV3(sg_s_rR, (_p - sg_s_rC));
-    float3 n = M3x3mulV3(sg_s_rR, _n);
+    float3 p = M3x3mulV3(rcCam.R, (_p - rcCam.C));
+    float3 n = M3x3mulV3(rcCam.R, _n);
     normalize(n);
     float d = -dot(n, p);
 
     float RrT[9];
-    M3x3transpose(RrT, sg_s_rR);
+    M3x3transpose(RrT, rcCam.R);
 
     float tmpRr[9];
-    M3x3mulM3x3(tmpRr, sg_s_tR, RrT);
+    M3x3mulM3x3(tmpRr, tcCam.R, RrT);
     float3 tr = _tr - M3x3mulV3(tmpRr, _tl);
 
     float tmp[9];
     float tmp1[9];
     outerMultiply(tmp, tr, n / d);
     M3x3minusM3x3(tmp, tmpRr, tmp);
-    M3x3mulM3x3(tmp1, sg_s_tK, tmp);
-    M3x3mulM3x3(tmp, tmp1, sg_s_riK);
+    M3x3mulM3x3(tmp1, tcCam.K, tmp);
+    M3x3mulM3x3(tmp, tmp1, rcCam.iK);
 
     for(int i = 0; i < 9; i++)
     {
@@ -233,13 +235,13 @@ __device__ simStat compSimStat(float2& rpix, float2& tpix, int wsh)
     return sst;
 }
 
-__device__ float compNCCbyH(patch& ptch, int wsh)
+__device__ float compNCCbyH(const CameraStructBase& rcCam, const CameraStructBase& tcCam, patch& ptch, int wsh)
 {
-    float2 rpix = project3DPoint(sg_s_rP, ptch.p);
-    float2 tpix = project3DPoint(sg_s_tP, ptch.p);
+    float2 rpix = project3DPoint(rcCam.P, ptch.p);
+    float2 tpix = project3DPoint(tcCam.P, ptch.p);
 
     float H[9];
-    computeHomography(H, ptch.p, ptch.n);
+    computeHomography(rcCam, tcCam, H, ptch.p, ptch.n);
 
     simStat sst = simStat();
     for(int xp = -wsh; xp <= wsh; xp++)
@@ -265,6 +267,50 @@ __device__ float compNCCbyH(patch& ptch, int wsh)
     return sst.sim;
 }
 
+/**
+ * @brief Fetch of the reference image from the r4tex texture.
+ */
+struct RcTextureFetch
+{
+    __device__ float4 operator()(float x, float y) const
+    {
+        // see CUDA_C_Programming_Guide.pdf ... E.2 pp132-133 ... adding 0.5 caises that tex2D return for point i,j
+        // exactly value od I(i,j) ... it is what we want
+        return tex2D(r4tex, x + 0.5f, y + 0.5f);
+    }
+};
+
+/**
+ * @brief Fetch of the reference image from a tile of r4tex staged in shared memory,
+ *        with the bilinear interpolation of the texture. The samples out of the tile are fetched from r4tex.
+ */
+struct RcTileFetch
+{
+    const float4* tile; // r4tex texels of [x0, x0 + width[ x [y0, y0 + height[
+    int x0;
+    int y0;
+    int width;
+    int height;
+
+    __device__ float4 operator()(float x, float y) const
+    {
+        const float fx = floorf(x);
+        const float fy = floorf(y);
+        const int tx = (int)fx - x0;
+        const int ty = (int)fy - y0;
+
+        if((tx < 0) || (ty < 0) || (tx + 1 >= width) || (ty + 1 >= height))
+            return tex2D(r4tex, x + 0.5f, y + 0.5f);
+
+        const float ax = x - fx;
+        const float ay = y - fy;
+        const float4* row0 = tile + ty * width + tx;
+        const float4* row1 = row0 + width;
+        return (1.0f - ay) * ((1.0f - ax) * row0[0] + ax * row0[1]) +
+               ay * ((1.0f - ax) * row1[0] + ax * row1[1]);
+    }
+};
+
 /**
  * @brief Compute Normalized Cross-Correlation
  * 
@@ -275,18 +321,21 @@ __device__ float compNCCbyH(patch& ptch, int wsh)
  * @param[in] _gammaC
  * @param[in] _gammaP
  * @param[in] epipShift
+ * @param[in] rcFetch the fetch of the reference image (RcTextureFetch or RcTileFetch)
  * 
  * @return similarity value
  */
-__device__ float compNCCby3DptsYK(patch& ptch, int wsh, int width, int height, const float _gammaC, const float _gammaP,
-                                  const float epipShift)
+template <class RcFetch>
+__device__ float compNCCby3DptsYK(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                  patch& ptch, int wsh, int width, int height, const float _gammaC, const float _gammaP,
+                                  const float epipShift, const RcFetch& rcFetch)
 {
     float3 p = ptch.p;
-    float2 rp = project3DPoint(sg_s_rP, p);
-    float2 tp = project3DPoint(sg_s_tP, p);
+    float2 rp = project3DPoint(rcCam.P, p);
+    float2 tp = project3DPoint(tcCam.P, p);
 
     float3 pUp = p + ptch.y * (ptch.d * 10.0f); // assuming that ptch.y is ortogonal to epipolar plane
-    float2 tvUp = project3DPoint(sg_s_tP, pUp);
+    float2 tvUp = project3DPoint(tcCam.P, pUp);
     tvUp = tvUp - tp;
     normalize(tvUp);
     float2 vEpipShift = tvUp * epipShift;
@@ -303,7 +352,7 @@ __device__ float compNCCby3DptsYK(patch& ptch, int wsh, int width, int height, c
 
     // see CUDA_C_Programming_Guide.pdf ... E.2 pp132-133 ... adding 0.5 caises that tex2D return for point i,j exactly
     // value od I(i,j) ... it is what we want
-    float4 gcr = 255.0f * tex2D(r4tex, rp.x + 0.5f, rp.y + 0.5f);
+    float4 gcr = 255.0f * rcFetch(rp.x, rp.y);
     float4 gct = 255.0f * tex2D(t4tex, tp.x + 0.5f, tp.y + 0.5f);
     // gcr = 255.0f*tex2D(r4tex, rp.x, rp.y);
     // gct = 255.0f*tex2D(t4tex, tp.x, tp.y);
@@ -319,14 +368,14 @@ __device__ float compNCCby3DptsYK(patch& ptch, int wsh, int width, int height, c
         for(int xp = -wsh; xp <= wsh; xp++)
         {
             p = ptch.p + ptch.x * (float)(ptch.d * (float)xp) + ptch.y * (float)(ptch.d * (float)yp);
-            float2 rp1 = project3DPoint(sg_s_rP, p);
-            float2 tp1 = project3DPoint(sg_s_tP, p) + vEpipShift;
+            float2 rp1 = project3DPoint(rcCam.P, p);
+            float2 tp1 = project3DPoint(tcCam.P, p) + vEpipShift;
             // float2 rp1 = rp + rvLeft*(float)xp + rvUp*(float)yp;
             // float2 tp1 = tp + tvLeft*(float)xp + tvUp*((float)yp+epipShift);
 
             // see CUDA_C_Programming_Guide.pdf ... E.2 pp132-133 ... adding 0.5 caises that tex2D return for point i,j
             // exactly value od I(i,j) ... it is what we want
-            float4 gcr1f = tex2D(r4tex, rp1.x + 0.5f, rp1.y + 0.5f);
+            float4 gcr1f = rcFetch(rp1.x, rp1.y);
             float4 gct1f = tex2D(t4tex, tp1.x + 0.5f, tp1.y + 0.5f);
             float4 gcr1 = 255.0f * gcr1f;
             float4 gct1 = 255.0f * gct1f;
@@ -350,14 +399,21 @@ __device__ float compNCCby3DptsYK(patch& ptch, int wsh, int width, int height, c
     return sst.sim;
 }
 
+__device__ float compNCCby3DptsYK(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                  patch& ptch, int wsh, int width, int height, const float gammaC, const float gammaP,
+                                  const float epipShift)
+{
+    return compNCCby3DptsYK(rcCam, tcCam, ptch, wsh, width, height, gammaC, gammaP, epipShift, RcTextureFetch());
+}
+
 /*
 __device__ float compNCCby3DptsYK(patch &ptch, int wsh, int width, int height, const float gammaC, const float gammaP,
 const float epipShift)
 {
         float3 p =  ptch.p;
-        float2 rp = project3DPoint(sg_s_rP, p);
-        float2 tp = project3DPoint(sg_s_tP, p);
-        float2 tpUp = project3DPoint(sg_s_tP, p+ptch.y*(ptch.d*10.0f)); //assuming that ptch.y is ortogonal to epipolar
+        float2 rp = project3DPoint(rcCam.P, p);
+        float2 tp = project3DPoint(tcCam.P, p);
+        float2 tpUp = project3DPoint(tcCam.P, p+ptch.y*(ptch.d*10.0f)); //assuming that ptch.y is ortogonal to epipolar
 plane
         float2 vEpipShift = tpUp-tp;
         normalize(vEpipShift);
@@ -399,8 +455,8 @@ plane
                                 {
                                         p =
 ptch.p+ptch.x*(float)(ptch.d*(float)(xp+xpp))+ptch.y*(float)(ptch.d*(float)(yp+ypp));
-                                        rp = project3DPoint(sg_s_rP, p);
-                                        tp = project3DPoint(sg_s_tP, p)+vEpipShift;
+                                        rp = project3DPoint(rcCam.P, p);
+                                        tp = project3DPoint(tcCam.P, p)+vEpipShift;
                                         gcr1.x = 255.0f*tex2D(rtex0, rp.x+0.5f, rp.y+0.5f);
                                         gct1.x = 255.0f*tex2D(ttex0, tp.x+0.5f, tp.y+0.5f);
                                         sst.update((float)gcr1.x, (float)gct1.x, 1.0f);
@@ -410,8 +466,8 @@ ptch.p+ptch.x*(float)(ptch.d*(float)(xp+xpp))+ptch.y*(float)(ptch.d*(float)(yp+y
 
 
                         p = ptch.p+ptch.x*(float)(ptch.d*(float)xp)+ptch.y*(float)(ptch.d*(float)yp);
-                        rp = project3DPoint(sg_s_rP, p);
-                        tp = project3DPoint(sg_s_tP, p)+vEpipShift;
+                        rp = project3DPoint(rcCam.P, p);
+                        tp = project3DPoint(tcCam.P, p)+vEpipShift;
                         gcr1.x = 255.0f*tex2D(rtex0, rp.x+0.5f, rp.y+0.5f);
                         gcr1.y = 255.0f*tex2D(rtex1, rp.x+0.5f, rp.y+0.5f);
                         gcr1.z = 255.0f*tex2D(rtex2, rp.x+0.5f, rp.y+0.5f);
@@ -438,11 +494,12 @@ gammaC, gammaP);
  * @param[in] width
  * @param[in] height
  */
-__device__ float compNCCby3Dpts(patch& ptch, int wsh, int width, int height)
+__device__ float compNCCby3Dpts(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                patch& ptch, int wsh, int width, int height)
 {
     float3 p = ptch.p;
-    float2 rp = project3DPoint(sg_s_rP, p);
-    float2 tp = project3DPoint(sg_s_tP, p);
+    float2 rp = project3DPoint(rcCam.P, p);
+    float2 tp = project3DPoint(tcCam.P, p);
 
     float dd = (float)(wsh + 2);
     if((rp.x < dd) || (rp.x > (float)width  - 1 - dd) ||
@@ -459,8 +516,8 @@ __device__ float compNCCby3Dpts(patch& ptch, int wsh, int width, int height)
         for(int yp = -wsh; yp <= wsh; yp++)
         {
             p = ptch.p + ptch.x * (float)(ptch.d * (float)xp) + ptch.y * (float)(ptch.d * (float)yp);
-            rp = project3DPoint(sg_s_rP, p);
-            tp = project3DPoint(sg_s_tP, p);
+            rp = project3DPoint(rcCam.P, p);
+            tp = project3DPoint(tcCam.P, p);
             float2 g;
             g.x = 255.0f * tex2D(rtex, rp.x + 0.5f, rp.y + 0.5f);
             g.y = 255.0f * tex2D(ttex, tp.x + 0.5f, tp.y + 0.5f);
@@ -471,11 +528,12 @@ __device__ float compNCCby3Dpts(patch& ptch, int wsh, int width, int height)
     return sst.sim;
 }
 
-__device__ float compNCCby3DptsEpipOpt(patch& ptch, int width, int height)
+__device__ float compNCCby3DptsEpipOpt(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                       patch& ptch, int width, int height)
 {
     float3 p = ptch.p;
-    float2 rp = project3DPoint(sg_s_rP, p);
-    float2 tp = project3DPoint(sg_s_tP, p);
+    float2 rp = project3DPoint(rcCam.P, p);
+    float2 tp = project3DPoint(tcCam.P, p);
 
     float dd = (float)(2 + 2);
     if(!((rp.x > dd) && (rp.x < (float)width - dd) && (rp.y > dd) && (rp.y < (float)height - dd) && (tp.x > dd) &&
@@ -494,16 +552,16 @@ __device__ float compNCCby3DptsEpipOpt(patch& ptch, int width, int height)
         for(int yp = -wsh; yp <= wsh; yp++)
         {
             p = ptch.p + ptch.x * (float)(ptch.d * (float)xp) + ptch.y * (float)(ptch.d * (float)yp);
-            rp = project3DPoint(sg_s_rP, p);
+            rp = project3DPoint(rcCam.P, p);
             lim[xp + wsh][yp + wsh] = 255.0f * tex2D(rtex, rp.x + 0.5f, rp.y + 0.5f);
         };
     };
 
     float2 v;
     p = ptch.p;
-    tp = project3DPoint(sg_s_tP, p);
+    tp = project3DPoint(tcCam.P, p);
     p = ptch.p + ptch.y * (float)(ptch.d * 5.0f); // ptch.y - normal to epipolar plane
-    v = tp - project3DPoint(sg_s_tP, p);
+    v = tp - project3DPoint(tcCam.P, p);
     normalize(v);
     v = v / 2.0f; // step by 0.5 pixel
 
@@ -518,7 +576,7 @@ __device__ float compNCCby3DptsEpipOpt(patch& ptch, int width, int height)
             for(int yp = -wsh; yp <= wsh; yp++)
             {
                 p = ptch.p + ptch.x * (float)(ptch.d * (float)xp) + ptch.y * (float)(ptch.d * (float)yp);
-                tp = project3DPoint(sg_s_tP, p);
+                tp = project3DPoint(tcCam.P, p);
                 tp = tp + v * (float(i - neer));
                 float2 g;
                 g.x = lim[xp + wsh][yp + wsh];
@@ -544,9 +602,9 @@ __device__ float compNCCby3DptsEpipOpt(patch& ptch, int width, int height)
     // return minsim;
 }
 
-__device__ void getPixelFor3DPointRC(float2& out, float3& X)
+__device__ void getPixelFor3DPointRC(const CameraStructBase& rcCam, float2& out, float3& X)
 {
-    float3 p = M3x4mulV3(sg_s_rP, X);
+    float3 p = M3x4mulV3(rcCam.P, X);
     out = make_float2(p.x / p.z, p.y / p.z);
 
     if(p.z < 0.0f)
@@ -556,9 +614,9 @@ __device__ void getPixelFor3DPointRC(float2& out, float3& X)
     };
 }
 
-__device__ void getPixelFor3DPointTC(float2& out, float3& X)
+__device__ void getPixelFor3DPointTC(const CameraStructBase& tcCam, float2& out, float3& X)
 {
-    float3 p = M3x4mulV3(sg_s_tP, X);
+    float3 p = M3x4mulV3(tcCam.P, X);
     out = make_float2(p.x / p.z, p.y / p.z);
 
     if(p.z < 0.0f)
@@ -568,117 +626,120 @@ __device__ void getPixelFor3DPointTC(float2& out, float3& X)
     };
 }
 
-__device__ float frontoParellePlaneRCDepthFor3DPoint(const float3& p)
+__device__ float frontoParellePlaneRCDepthFor3DPoint(const CameraStructBase& rcCam, const float3& p)
 {
-    return fabsf(orientedPointPlaneDistanceNormalizedNormal(p, sg_s_rC, sg_s_rZVect));
+    return fabsf(orientedPointPlaneDistanceNormalizedNormal(p, rcCam.C, rcCam.ZVect));
 }
 
-__device__ float frontoParellePlaneTCDepthFor3DPoint(const float3& p)
+__device__ float frontoParellePlaneTCDepthFor3DPoint(const CameraStructBase& tcCam, const float3& p)
 {
-    return fabsf(orientedPointPlaneDistanceNormalizedNormal(p, sg_s_tC, sg_s_tZVect));
+    return fabsf(orientedPointPlaneDistanceNormalizedNormal(p, tcCam.C, tcCam.ZVect));
 }
 
-__device__ float3 get3DPointForPixelAndFrontoParellePlaneRC(float2& pix, float fpPlaneDepth)
+__device__ float3 get3DPointForPixelAndFrontoParellePlaneRC(const CameraStructBase& rcCam,
+                                                            float2& pix, float fpPlaneDepth)
 {
-    float3 planep = sg_s_rC + sg_s_rZVect * fpPlaneDepth;
-    float3 v = M3x3mulV2(sg_s_riP, pix);
+    float3 planep = rcCam.C + rcCam.ZVect * fpPlaneDepth;
+    float3 v = M3x3mulV2(rcCam.iP, pix);
     normalize(v);
-    return linePlaneIntersect(sg_s_rC, v, planep, sg_s_rZVect);
+    return linePlaneIntersect(rcCam.C, v, planep, rcCam.ZVect);
 }
 
-__device__ float3 get3DPointForPixelAndFrontoParellePlaneRC(int2& pixi, float fpPlaneDepth)
+__device__ float3 get3DPointForPixelAndFrontoParellePlaneRC(const CameraStructBase& rcCam,
+                                                            int2& pixi, float fpPlaneDepth)
 {
     float2 pix;
     pix.x = (float)pixi.x;
     pix.y = (float)pixi.y;
-    return get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth);
+    return get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepth);
 }
 
-__device__ float3 get3DPointForPixelAndDepthFromRC(const float2& pix, float depth)
+__device__ float3 get3DPointForPixelAndDepthFromRC(const CameraStructBase& rcCam, const float2& pix, float depth)
 {
-    float3 rpv = M3x3mulV2(sg_s_riP, pix);
+    float3 rpv = M3x3mulV2(rcCam.iP, pix);
     normalize(rpv);
-    return sg_s_rC + rpv * depth;
+    return rcCam.C + rpv * depth;
 }
 
-__device__ float3 get3DPointForPixelAndDepthFromTC(const float2& pix, float depth)
+__device__ float3 get3DPointForPixelAndDepthFromTC(const CameraStructBase& tcCam, const float2& pix, float depth)
 {
-    float3 tpv = M3x3mulV2(sg_s_tiP, pix);
+    float3 tpv = M3x3mulV2(tcCam.iP, pix);
     normalize(tpv);
-    return sg_s_tC + tpv * depth;
+    return tcCam.C + tpv * depth;
 }
 
-__device__ float3 get3DPointForPixelAndDepthFromRC(const int2& pixi, float depth)
+__device__ float3 get3DPointForPixelAndDepthFromRC(const CameraStructBase& rcCam, const int2& pixi, float depth)
 {
     float2 pix;
     pix.x = (float)pixi.x;
     pix.y = (float)pixi.y;
-    return get3DPointForPixelAndDepthFromRC(pix, depth);
+    return get3DPointForPixelAndDepthFromRC(rcCam, pix, depth);
 }
 
-__device__ float3 triangulateMatchRef(float2& refpix, float2& tarpix)
+__device__ float3 triangulateMatchRef(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                      float2& refpix, float2& tarpix)
 {
-    float3 refvect = M3x3mulV2(sg_s_riP, refpix);
+    float3 refvect = M3x3mulV2(rcCam.iP, refpix);
     normalize(refvect);
-    float3 refpoint = refvect + sg_s_rC;
+    float3 refpoint = refvect + rcCam.C;
 
-    float3 tarvect = M3x3mulV2(sg_s_tiP, tarpix);
+    float3 tarvect = M3x3mulV2(tcCam.iP, tarpix);
     normalize(tarvect);
-    float3 tarpoint = tarvect + sg_s_tC;
+    float3 tarpoint = tarvect + tcCam.C;
 
     float k, l;
     float3 lli1, lli2;
 
-    lineLineIntersect(&k, &l, &lli1, &lli2, sg_s_rC, refpoint, sg_s_tC, tarpoint);
+    lineLineIntersect(&k, &l, &lli1, &lli2, rcCam.C, refpoint, tcCam.C, tarpoint);
 
-    return sg_s_rC + refvect * k;
+    return rcCam.C + refvect * k;
 }
 
-__device__ float computeRcPixSize(const float3& p)
+__device__ float computeRcPixSize(const CameraStructBase& rcCam, const float3& p)
 {
     /*
     patch ptcho;
     ptcho.p = p;
     computeRotCSEpip(ptcho,p);
-    float2 rp = project3DPoint(sg_s_rP, p);
+    float2 rp = project3DPoint(rcCam.P, p);
 
-    float dRcTc = size(sg_s_rC-sg_s_tC)/100.0f;
+    float dRcTc = size(rcCam.C-tcCam.C)/100.0f;
     float3 pLeft = ptcho.p+ptcho.x*dRcTc; //assuming that ptch.x on epipolar plane
-    float2 rvLeft = project3DPoint(sg_s_rP, pLeft); rvLeft = rvLeft-rp; normalize(rvLeft);
+    float2 rvLeft = project3DPoint(rcCam.P, pLeft); rvLeft = rvLeft-rp; normalize(rvLeft);
 
-    float depth = size(sg_s_rC-p);
+    float depth = size(rcCam.C-p);
     float2 rp1 = rp + rvLeft;
 
     //float3 p1 = get3DPointForPixelAndDepthFromRC(rp1,depth);
     //float pixSize = size(p-p1);
     //return pixSize;
 
-    float3 refvect = M3x3mulV2(sg_s_riP,rp1);
+    float3 refvect = M3x3mulV2(rcCam.iP,rp1);
     normalize(refvect);
-    return pointLineDistance3D(p, sg_s_rC, refvect);
+    return pointLineDistance3D(p, rcCam.C, refvect);
     */
 
-    float2 rp = project3DPoint(sg_s_rP, p);
+    float2 rp = project3DPoint(rcCam.P, p);
     float2 rp1 = rp + make_float2(1.0f, 0.0f);
 
-    float3 refvect = M3x3mulV2(sg_s_riP, rp1);
+    float3 refvect = M3x3mulV2(rcCam.iP, rp1);
     normalize(refvect);
-    return pointLineDistance3D(p, sg_s_rC, refvect);
+    return pointLineDistance3D(p, rcCam.C, refvect);
 }
 
-__device__ float computePixSize(const float3& p)
+__device__ float computePixSize(const CameraStructBase& rcCam, const float3& p)
 {
-    return computeRcPixSize(p);
+    return computeRcPixSize(rcCam, p);
 }
 
-__device__ float computeTcPixSize(const float3& p)
+__device__ float computeTcPixSize(const CameraStructBase& tcCam, const float3& p)
 {
-    float2 tp = project3DPoint(sg_s_tP, p);
+    float2 tp = project3DPoint(tcCam.P, p);
     float2 tp1 = tp + make_float2(1.0f, 0.0f);
 
-    float3 tarvect = M3x3mulV2(sg_s_tiP, tp1);
+    float3 tarvect = M3x3mulV2(tcCam.iP, tp1);
     normalize(tarvect);
-    return pointLineDistance3D(p, sg_s_tC, tarvect);
+    return pointLineDistance3D(p, tcCam.C, tarvect);
 }
 
 __device__ float refineDepthSubPixel(const float3& depths, const float3& sims)
@@ -89,66 +89,69 @@ __global__ void compute_varLofLABtoW_kernel(uchar4* labMap, int labMap_p, int wi
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////
 
-__device__ void move3DPointByRcPixSize(float3& p, float rcPixSize)
+__device__ void move3DPointByRcPixSize(const CameraStructBase& rcCam, float3& p, float rcPixSize)
 {
-    float3 rpv = p - sg_s_rC;
+    float3 rpv = p - rcCam.C;
     normalize(rpv);
     p = p + rpv * rcPixSize;
 }
 
-__device__ void move3DPointByTcPixStep(float3& p, float tcPixStep)
+__device__ void move3DPointByTcPixStep(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                       float3& p, float tcPixStep)
 
 {
-    float3 rpv = sg_s_rC - p;
+    float3 rpv = rcCam.C - p;
     float3 prp = p;
     float3 prp1 = p + rpv / 2.0f;
 
     float2 rp;
-    getPixelFor3DPointRC(rp, prp);
+    getPixelFor3DPointRC(rcCam, rp, prp);
 
     float2 tpo;
-    getPixelFor3DPointTC(tpo, prp);
+    getPixelFor3DPointTC(tcCam, tpo, prp);
 
     float2 tpv;
-    getPixelFor3DPointTC(tpv, prp1);
+    getPixelFor3DPointTC(tcCam, tpv, prp1);
 
     tpv = tpv - tpo;
     normalize(tpv);
 
     float2 tpd = tpo + tpv * tcPixStep;
 
-    p = triangulateMatchRef(rp, tpd);
+    p = triangulateMatchRef(rcCam, tcCam, rp, tpd);
 }
 
-__device__ float move3DPointByTcOrRcPixStep(int2& pix, float3& p, float pixStep, bool moveByTcOrRc)
+__device__ float move3DPointByTcOrRcPixStep(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                            int2& pix, float3& p, float pixStep, bool moveByTcOrRc)
 {
     if(moveByTcOrRc == true)
     {
-        move3DPointByTcPixStep(p, pixStep);
+        move3DPointByTcPixStep(rcCam, tcCam, p, pixStep);
         return 0.0f;
     }
     else
     {
-        float pixSize = pixStep * computePixSize(p);
-        move3DPointByRcPixSize(p, pixSize);
+        float pixSize = pixStep * computePixSize(rcCam, p);
+        move3DPointByRcPixSize(rcCam, p, pixSize);
 
         return pixSize;
     }
 }
 
-__device__ float3 computeDepthPoint_fine(float& pixSize, int depthid, int ndepths, int2& pix, int pixid, int t)
+__device__ float3 computeDepthPoint_fine(const CameraStructBase& rcCam,
+                                         float& pixSize, int depthid, int ndepths, int2& pix, int pixid, int t)
 {
     float depth = tex2D(depthsTex, pixid, t);
     float2 rp = make_float2((float)pix.x, (float)pix.y);
-    float3 rpv = M3x3mulV2(sg_s_riP, rp);
+    float3 rpv = M3x3mulV2(rcCam.iP, rp);
     normalize(rpv);
 
-    float3 prp = sg_s_rC + rpv * depth;
-    pixSize = computePixSize(prp);
+    float3 prp = rcCam.C + rpv * depth;
+    pixSize = computePixSize(rcCam, prp);
 
     float jump = (float)(depthid - ((ndepths - 1) / 2));
 
-    return sg_s_rC + rpv * (depth + pixSize * jump);
+    return rcCam.C + rpv * (depth + pixSize * jump);
 }
 
 __global__ void locmin_kernel(float* slice, int slice_p, int ndepths, int slicesAtTime,
@@ -252,8 +255,12 @@ __global__ void getTarTexLAB_kernel(uchar4* texs, int texs_p, int width, int hei
     }
 }
 
-__global__ void reprojTarTexLAB_kernel(uchar4* texs, int texs_p, int width, int height, float fpPlaneDepth)
+__global__ void reprojTarTexLAB_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                       uchar4* texs, int texs_p, int width, int height, float fpPlaneDepth)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
 
@@ -263,8 +270,8 @@ __global__ void reprojTarTexLAB_kernel(uchar4* texs, int texs_p, int width, int
 
     if((x < width) && (y < height))
     {
-        float3 p = get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth);
-        float2 tpc = project3DPoint(sg_s_tP, p);
+        float3 p = get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepth);
+        float2 tpc = project3DPoint(tcCam.P, p);
         uchar4* tex = get2DBufferAt(texs, texs_p, x, y);
         if(((tpc.x + 0.5f) > 0.0f) && ((tpc.y + 0.5f) > 0.0f) &&
            ((tpc.x + 0.5f) < (float)width - 1.0f) && ((tpc.y + 0.5f) < (float)height - 1.0f))
@@ -281,8 +288,12 @@ __global__ void reprojTarTexLAB_kernel(uchar4* texs, int texs_p, int width, int
     }
 }
 
-__global__ void reprojTarTexRgb_kernel(uchar4* texs, int texs_p, int width, int height, float fpPlaneDepth)
+__global__ void reprojTarTexRgb_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                       uchar4* texs, int texs_p, int width, int height, float fpPlaneDepth)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
 
@@ -292,8 +303,8 @@ __global__ void reprojTarTexRgb_kernel(uchar4* texs, int texs_p, int width, int
 
     if((x < width) && (y < height))
     {
-        float3 p = get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth);
-        float2 tpc = project3DPoint(sg_s_tP, p);
+        float3 p = get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepth);
+        float2 tpc = project3DPoint(tcCam.P, p);
         uchar4* tex = get2DBufferAt(texs, texs_p, x, y);
         if(((tpc.x + 0.5f) > 0.0f) && ((tpc.y + 0.5f) > 0.0f) &&
            ((tpc.x + 0.5f) < (float)width - 1.0f) && ((tpc.y + 0.5f) < (float)height - 1.0f))
@@ -578,11 +589,14 @@ __global__ void aggrYKNCCSim_kernel(float* osim, int osim_p, int width, int heig
 }
 
 __global__ void updateBestDepth_kernel(
+    int rcCamCacheIdx,
     float* osim, int osim_p,
     float* odpt, int odpt_p,
     float* isim, int isim_p,
     int width, int height, int step, float fpPlaneDepth, int d)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
 
@@ -594,8 +608,8 @@ __global__ void updateBestDepth_kernel(
         if((is < os) || (d == 0))
         {
             int2 pix = make_int2(x * step, y * step);
-            float3 p = get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth);
-            float depth = size(sg_s_rC - p);
+            float3 p = get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepth);
+            float depth = size(rcCam.C - p);
 
             *get2DBufferAt(osim, osim_p, x, y) = is;
             *get2DBufferAt(odpt, odpt_p, x, y) = depth;
@@ -649,9 +663,12 @@ __global__ void getSilhoueteMap_kernel(bool* out, int out_p, int step, int width
 }
 
 __global__ void computeNormalMap_kernel(
+  int rcCamCacheIdx,
   float3* nmap, int nmap_p,
   int width, int height, int wsh, const float gammaC, const float gammaP)
 {
+  const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+
   int x = blockIdx.x * blockDim.x + threadIdx.x;
   int y = blockIdx.y * blockDim.y + threadIdx.y;
 
@@ -666,11 +683,11 @@ __global__ void computeNormalMap_kernel(
   }
 
   int2 pix1 = make_int2(x, y);
-  float3 p = get3DPointForPixelAndDepthFromRC(pix1, depth);
+  float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix1, depth);
   float pixSize = 0.0f;
   {
     int2 pix2 = make_int2(x + 1, y);
-    float3 p2 = get3DPointForPixelAndDepthFromRC(pix2, depth);
+    float3 p2 = get3DPointForPixelAndDepthFromRC(rcCam, pix2, depth);
     pixSize = size(p - p2);
   }
 
@@ -685,7 +702,7 @@ __global__ void computeNormalMap_kernel(
       {
         float w = 1.0f;
         float2 pixn = make_float2(x + xp, y + yp);
-        float3 pn = get3DPointForPixelAndDepthFromRC(pixn, depthn);
+        float3 pn = get3DPointForPixelAndDepthFromRC(rcCam, pixn, depthn);
         s3d.update(pn, w);
       }
     }
@@ -699,7 +716,7 @@ __global__ void computeNormalMap_kernel(
     return;
   }
 
-  float3 nc = sg_s_rC - p;
+  float3 nc = rcCam.C - p;
   normalize(nc);
   if (orientedPointPlaneDistanceNormalizedNormal(pp + nn, pp, nc) < 0.0f)
   {
@@ -93,7 +93,7 @@ __global__ void fuse_getOptDeptMapFromOPtDepthSimMap_kernel(float* optDepthMap,
 /**
  * @return (smoothStep, energy)
  */
-__device__ float2 getCellSmoothStepEnergy(const int2& cell0)
+__device__ float2 getCellSmoothStepEnergy(const CameraStructBase& rcCam, const int2& cell0)
 {
     float2 out = make_float2(0.0f, 180.0f);
 
@@ -117,11 +117,11 @@ __device__ float2 getCellSmoothStepEnergy(const int2& cell0)
     float dB = tex2D(depthsTex, cellB.x, cellB.y);
 
     // Get associated 3D points
-    float3 p0 = get3DPointForPixelAndDepthFromRC(cell0, d0);
-    float3 pL = get3DPointForPixelAndDepthFromRC(cellL, dL);
-    float3 pR = get3DPointForPixelAndDepthFromRC(cellR, dR);
-    float3 pU = get3DPointForPixelAndDepthFromRC(cellU, dU);
-    float3 pB = get3DPointForPixelAndDepthFromRC(cellB, dB);
+    float3 p0 = get3DPointForPixelAndDepthFromRC(rcCam, cell0, d0);
+    float3 pL = get3DPointForPixelAndDepthFromRC(rcCam, cellL, dL);
+    float3 pR = get3DPointForPixelAndDepthFromRC(rcCam, cellR, dR);
+    float3 pU = get3DPointForPixelAndDepthFromRC(rcCam, cellU, dU);
+    float3 pB = get3DPointForPixelAndDepthFromRC(rcCam, cellB, dB);
 
     // Compute the average point based on neighbors (cg)
     float3 cg = make_float3(0.0f, 0.0f, 0.0f);
@@ -136,12 +136,12 @@ __device__ float2 getCellSmoothStepEnergy(const int2& cell0)
     if(n > 1.0f)
     {
         cg = cg / n; // average of x, y, depth
-        float3 vcn = sg_s_rC - p0;
+        float3 vcn = rcCam.C - p0;
         normalize(vcn);
         // pS: projection of cg on the line from p0 to camera
         float3 pS = closestPointToLine3D(cg, p0, vcn);
         // keep the depth difference between pS and p0 as the smoothing step
-        out.x = size(sg_s_rC - pS) - d0;
+        out.x = size(rcCam.C - pS) - d0;
     }
 
     float e = 0.0f;
@@ -166,11 +166,13 @@ __device__ float2 getCellSmoothStepEnergy(const int2& cell0)
     return out;
 }
 
-__global__ void fuse_optimizeDepthSimMap_kernel(float2* out_optDepthSimMap, int optDepthSimMap_p,
+__global__ void fuse_optimizeDepthSimMap_kernel(int rcCamCacheIdx, float2* out_optDepthSimMap, int optDepthSimMap_p,
                                                 float2* midDepthPixSizeMap, int midDepthPixSizeMap_p,
                                                 float2* fusedDepthSimMap, int fusedDepthSimMap_p, int width, int height,
                                                 int iter, float samplesPerPixSize, int yFrom)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix = make_int2(x, y);
@@ -186,7 +188,7 @@ __global__ void fuse_optimizeDepthSimMap_kernel(float2* out_optDepthSimMap, int
 
         if(depthOpt > 0.0f)
         {
-            float2 depthSmoothStepEnergy = getCellSmoothStepEnergy(pix);
+            float2 depthSmoothStepEnergy = getCellSmoothStepEnergy(rcCam, pix);
             float depthSmoothStep = depthSmoothStepEnergy.x;
             if(depthSmoothStep < 0.0f)
             {
@@ -246,5 +248,85 @@ __global__ void fuse_optimizeDepthSimMap_kernel(float2* out_optDepthSimMap, int
     };
 }
 
+/**
+ * @brief For each point of the tc depth map, count the rc depth map pixels around its projection in rc
+ *        with the same depth up to the plane sweeping pixel size (see fuseCut::Fuser::updateInSurr).
+ * @param[in,out] numOfPtsMap number of consistent tc points for each rc pixel
+ * @param[in] rcSimMap the ball size is pixSizeBallWSP for the weakly supported rc pixels (sim >= 1)
+ * @param[in] border margin of the rc image without projections
+ */
+__global__ void fuse_countConsistentPoints_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                  int* numOfPtsMap, int numOfPtsMap_p,
+                                                  float* rcDepthMap, int rcDepthMap_p,
+                                                  float* rcSimMap, int rcSimMap_p,
+                                                  int rcWidth, int rcHeight, int border,
+                                                  float* tcDepthMap, int tcDepthMap_p,
+                                                  int tcWidth, int tcHeight,
+                                                  int pixSizeBall, int pixSizeBallWSP)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if((x >= tcWidth) || (y >= tcHeight))
+        return;
+
+    const float tcDepth = *get2DBufferAt(tcDepthMap, tcDepthMap_p, x, y);
+    if(tcDepth <= 0.0f)
+        return;
+
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
+    const float3 p = get3DPointForPixelAndDepthFromTC(tcCam, make_float2((float)x, (float)y), tcDepth);
+
+    // nearest rc pixel
+    const float3 rp = M3x4mulV3(rcCam.P, p);
+    if(rp.z <= 0.0f)
+        return;
+    const int rx = (int)floorf(rp.x / rp.z + 0.5f);
+    const int ry = (int)floorf(rp.y / rp.z + 0.5f);
+    if((rx < border) || (rx >= rcWidth - border) || (ry < border) || (ry >= rcHeight - border))
+        return;
+
+    const float pixDepth = size(rcCam.C - p);
+    const float sim = *get2DBufferAt(rcSimMap, rcSimMap_p, rx, ry);
+    const int d = (sim >= 1.0f) ? pixSizeBallWSP : pixSizeBall;
+
+    // twice the plane sweeping pixel size: the rc pixel size plus the size of one tc pixel along the epipolar line
+    float3 p1 = p;
+    move3DPointByTcPixStep(rcCam, tcCam, p1, 1.0f);
+    const float pixSize = size(p - p1) + computeRcPixSize(rcCam, p);
+
+    for(int ny = max(0, ry - d); ny <= min(rcHeight - 1, ry + d); ++ny)
+    {
+        for(int nx = max(0, rx - d); nx <= min(rcWidth - 1, rx + d); ++nx)
+        {
+            const float depth = *get2DBufferAt(rcDepthMap, rcDepthMap_p, nx, ny);
+            if(fabsf(pixDepth - depth) < pixSize)
+                atomicAdd(get2DBufferAt(numOfPtsMap, numOfPtsMap_p, nx, ny), 1);
+        }
+    }
+}
+
+/**
+ * @brief Count one more consistent tc for the rc pixels with at least one consistent point,
+ *        and reset the number of points for the next tc.
+ */
+__global__ void fuse_updateNbConsistentCamsMap_kernel(unsigned char* nmodMap, int nmodMap_p,
+                                                      int* numOfPtsMap, int numOfPtsMap_p,
+                                                      int width, int height)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if((x >= width) || (y >= height))
+        return;
+
+    int* numOfPts = get2DBufferAt(numOfPtsMap, numOfPtsMap_p, x, y);
+    if(*numOfPts > 0)
+        *get2DBufferAt(nmodMap, nmodMap_p, x, y) += 1;
+    *numOfPts = 0;
+}
+
 } // namespace depthMap
 } // namespace aliceVision
@@ -7,12 +7,15 @@
 namespace aliceVision {
 namespace depthMap {
 
-__global__ void refine_selectPartOfDepthMapNearFPPlaneDepth_kernel(float* o0depthMap, int o0depthMap_p,
+__global__ void refine_selectPartOfDepthMapNearFPPlaneDepth_kernel(int rcCamCacheIdx,
+                                                                   float* o0depthMap, int o0depthMap_p,
                                                                    float* o1depthMap, int o1depthMap_p,
                                                                    float* idepthMap, int idepthMap_p, int width,
                                                                    int height, float fpPlaneDepth,
                                                                    float fpPlaneDepthNext)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -28,12 +31,12 @@ __global__ void refine_selectPartOfDepthMapNearFPPlaneDepth_kernel(float* o0dept
         if(idepth > 0.0f)
         {
             float step = (fpPlaneDepthNext - fpPlaneDepth) / 2.0f;
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, idepth);
-            float fpPlaneDepthPix = frontoParellePlaneRCDepthFor3DPoint(p);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, idepth);
+            float fpPlaneDepthPix = frontoParellePlaneRCDepthFor3DPoint(rcCam, p);
             if((fpPlaneDepthPix >= fpPlaneDepth - step) && (fpPlaneDepthPix < fpPlaneDepthNext))
             {
-                o0depth = size(get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth) - sg_s_rC);
-                o1depth = size(get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepthNext) - sg_s_rC);
+                o0depth = size(get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepth) - rcCam.C);
+                o1depth = size(get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepthNext) - rcCam.C);
             };
         };
 
@@ -91,9 +94,12 @@ __global__ void refine_dilateFPPlaneDepthMapXpYp_kernel(float* fpPlaneDepthMap,
     };
 }
 
-__global__ void refine_convertFPPlaneDepthMapToDepthMap_kernel(float* depthMap, int depthMap_p, float* fpPlaneDepthMap,
+__global__ void refine_convertFPPlaneDepthMapToDepthMap_kernel(int rcCamCacheIdx,
+                                                               float* depthMap, int depthMap_p, float* fpPlaneDepthMap,
                                                                int fpPlaneDepthMap_p, int width, int height)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -106,16 +112,20 @@ __global__ void refine_convertFPPlaneDepthMapToDepthMap_kernel(float* depthMap,
         float depth = -1.0f;
         if(fpPlaneDepth > 0.0f)
         {
-            depth = size(get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth) - sg_s_rC);
+            depth = size(get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepth) - rcCam.C);
         };
         depthMap[y * depthMap_p + x] = depth;
     };
 }
 
-__global__ void refine_computeDepthsMapFromDepthMap_kernel(float3* depthsMap, int depthsMap_p, float* depthMap,
+__global__ void refine_computeDepthsMapFromDepthMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                           float3* depthsMap, int depthsMap_p, float* depthMap,
                                                            int depthMap_p, int width, int height, bool moveByTcOrRc,
                                                            float step)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -127,32 +137,36 @@ __global__ void refine_computeDepthsMapFromDepthMap_kernel(float3* depthsMap, in
         float depth = depthMap[y * depthMap_p + x];
         if(depth > 0.0f)
         {
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, depth);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, depth);
             float3 pm1 = p;
             float3 pp1 = p;
 
             if(moveByTcOrRc == true)
             {
-                move3DPointByTcPixStep(pm1, -step);
-                move3DPointByTcPixStep(pp1, +step);
+                move3DPointByTcPixStep(rcCam, tcCam, pm1, -step);
+                move3DPointByTcPixStep(rcCam, tcCam, pp1, +step);
             }
             else
             {
-                float pixSize = step * computePixSize(p);
-                move3DPointByRcPixSize(pm1, -pixSize);
-                move3DPointByRcPixSize(pp1, +pixSize);
+                float pixSize = step * computePixSize(rcCam, p);
+                move3DPointByRcPixSize(rcCam, pm1, -pixSize);
+                move3DPointByRcPixSize(rcCam, pp1, +pixSize);
             };
 
-            depthsMap[y * depthsMap_p + x].x = size(pm1 - sg_s_rC);
-            depthsMap[y * depthsMap_p + x].y = size(p - sg_s_rC);
-            depthsMap[y * depthsMap_p + x].z = size(pp1 - sg_s_rC);
+            depthsMap[y * depthsMap_p + x].x = size(pm1 - rcCam.C);
+            depthsMap[y * depthsMap_p + x].y = size(p - rcCam.C);
+            depthsMap[y * depthsMap_p + x].z = size(pp1 - rcCam.C);
         };
     };
 }
 
-__global__ void refine_reprojTarTexLABByDepthsMap_kernel(float3* depthsMap, int depthsMap_p, uchar4* tex, int tex_p,
+__global__ void refine_reprojTarTexLABByDepthsMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                         float3* depthsMap, int depthsMap_p, uchar4* tex, int tex_p,
                                                          int width, int height, int id)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -177,8 +191,8 @@ __global__ void refine_reprojTarTexLABByDepthsMap_kernel(float3* depthsMap, int
 
         if(depth > 0.0f)
         {
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, depth);
-            float2 tpc = project3DPoint(sg_s_tP, p);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, depth);
+            float2 tpc = project3DPoint(tcCam.P, p);
 
             if(((tpc.x + 0.5f) > 0.0f) && ((tpc.y + 0.5f) > 0.0f) && ((tpc.x + 0.5f) < (float)width - 1.0f) &&
                ((tpc.y + 0.5f) < (float)height - 1.0f))
@@ -196,9 +210,13 @@ __global__ void refine_reprojTarTexLABByDepthsMap_kernel(float3* depthsMap, int
     };
 }
 
-__global__ void refine_reprojTarTexLABByDepthMap_kernel(float* depthMap, int depthMap_p, uchar4* tex, int tex_p,
+__global__ void refine_reprojTarTexLABByDepthMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                        float* depthMap, int depthMap_p, uchar4* tex, int tex_p,
                                                         int width, int height)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -212,8 +230,8 @@ __global__ void refine_reprojTarTexLABByDepthMap_kernel(float* depthMap, int dep
 
         if(depth > 0.0f)
         {
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, depth);
-            float2 tpc = project3DPoint(sg_s_tP, p);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, depth);
+            float2 tpc = project3DPoint(tcCam.P, p);
             if(((tpc.x + 0.5f) > 0.0f) && ((tpc.y + 0.5f) > 0.0f) && ((tpc.x + 0.5f) < (float)width - 1.0f) &&
                ((tpc.y + 0.5f) < (float)height - 1.0f))
             {
@@ -225,10 +243,14 @@ __global__ void refine_reprojTarTexLABByDepthMap_kernel(float* depthMap, int dep
     };
 }
 
-__global__ void refine_reprojTarTexLABByDepthMapMovedByStep_kernel(float* depthMap, int depthMap_p, uchar4* tex,
+__global__ void refine_reprojTarTexLABByDepthMapMovedByStep_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                                   float* depthMap, int depthMap_p, uchar4* tex,
                                                                    int tex_p, int width, int height, bool moveByTcOrRc,
                                                                    float step)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -242,24 +264,24 @@ __global__ void refine_reprojTarTexLABByDepthMapMovedByStep_kernel(float* depthM
 
         if(depth > 0.0f)
         {
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, depth);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, depth);
 
             if(step != 0.0f)
             {
                 if(moveByTcOrRc == true)
                 {
-                    move3DPointByTcPixStep(p, step);
+                    move3DPointByTcPixStep(rcCam, tcCam, p, step);
                 }
                 else
                 {
-                    float pixSize = step * computePixSize(p);
-                    move3DPointByRcPixSize(p, pixSize);
+                    float pixSize = step * computePixSize(rcCam, p);
+                    move3DPointByRcPixSize(rcCam, p, pixSize);
                 };
 
-                depth = size(p - sg_s_rC);
+                depth = size(p - rcCam.C);
             };
 
-            float2 tpc = project3DPoint(sg_s_tP, p);
+            float2 tpc = project3DPoint(tcCam.P, p);
             if(((tpc.x + 0.5f) > 0.0f) && ((tpc.y + 0.5f) > 0.0f) && ((tpc.x + 0.5f) < (float)width - 1.0f) &&
                ((tpc.y + 0.5f) < (float)height - 1.0f))
             {
@@ -490,12 +512,16 @@ __global__ void refine_fuseThreeDepthSimMaps_kernel(float* osim, int osim_p, flo
     };
 }
 
-__global__ void refine_compUpdateYKNCCSimMapPatch_kernel(float* osimMap, int osimMap_p, float* odptMap, int odptMap_p,
+__global__ void refine_compUpdateYKNCCSimMapPatch_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                         float* osimMap, int osimMap_p, float* odptMap, int odptMap_p,
                                                          float* depthMap, int depthMap_p, int width, int height,
                                                          int wsh, const float gammaC, const float gammaP,
                                                          const float epipShift, const float tcStep, int id,
                                                          bool moveByTcOrRc, int xFrom, int imWidth, int imHeight)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -511,18 +537,18 @@ __global__ void refine_compUpdateYKNCCSimMapPatch_kernel(float* osimMap, int osi
         // If we have an initial depth value, we can refine it
         if(odpt > 0.0f)
         {
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, odpt);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, odpt);
             // move3DPointByTcPixStep(p, tcStep);
-            move3DPointByTcOrRcPixStep(pix, p, tcStep, moveByTcOrRc);
+            move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, p, tcStep, moveByTcOrRc);
 
-            odpt = size(p - sg_s_rC);
+            odpt = size(p - rcCam.C);
 
             patch ptch;
             ptch.p = p;
-            ptch.d = computePixSize(p);
+            ptch.d = computePixSize(rcCam, p);
             // TODO: we could compute the orientation of the path from the input depth map instead of relying on the cameras orientations
-            computeRotCSEpip(ptch, p);
-            osim = compNCCby3DptsYK(ptch, wsh, imWidth, imHeight, gammaC, gammaP, epipShift);
+            computeRotCSEpip(rcCam, tcCam, ptch, p);
+            osim = compNCCby3DptsYK(rcCam, tcCam, ptch, wsh, imWidth, imHeight, gammaC, gammaP, epipShift);
         }
 
         float* osim_ptr = get2DBufferAt(osimMap, osimMap_p, x, y);
@@ -546,9 +572,93 @@ __global__ void refine_compUpdateYKNCCSimMapPatch_kernel(float* osimMap, int osi
     }
 }
 
-__global__ void refine_coputeDepthStepMap_kernel(float* depthStepMap, int depthStepMap_p, float* depthMap,
+/**
+ * @brief Same as refine_compUpdateYKNCCSimMapPatch_kernel for all the depth steps in one launch.
+ *
+ * The reference image around the block, with a margin of tileRadius pixels for the patches, is staged
+ * once in shared memory (blockDim.x + 2 * tileRadius + 1) x (blockDim.y + 2 * tileRadius + 1) float4
+ * and read by all the depth steps. The best similarity and depth are kept in registers.
+ */
+__global__ void refine_compUpdateYKNCCSimMapPatchSteps_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                              float* osimMap, int osimMap_p, float* odptMap, int odptMap_p,
+                                                              float* depthMap, int depthMap_p, int width, int height,
+                                                              int wsh, const float gammaC, const float gammaP,
+                                                              const float epipShift, int ntcsteps,
+                                                              bool moveByTcOrRc, int xFrom, int imWidth, int imHeight,
+                                                              int tileRadius)
+{
+    extern __shared__ float4 refine_rcTile[];
+
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
+    RcTileFetch rcFetch;
+    rcFetch.tile = refine_rcTile;
+    rcFetch.x0 = blockIdx.x * blockDim.x + xFrom - tileRadius;
+    rcFetch.y0 = blockIdx.y * blockDim.y - tileRadius;
+    rcFetch.width = blockDim.x + 2 * tileRadius + 1;
+    rcFetch.height = blockDim.y + 2 * tileRadius + 1;
+
+    // load the tile, the texture clamps the coordinates out of the image
+    const int nbThreads = blockDim.x * blockDim.y;
+    for(int i = threadIdx.y * blockDim.x + threadIdx.x; i < rcFetch.width * rcFetch.height; i += nbThreads)
+    {
+        const int tx = i % rcFetch.width;
+        const int ty = i / rcFetch.width;
+        refine_rcTile[i] = tex2D(r4tex, (float)(rcFetch.x0 + tx) + 0.5f, (float)(rcFetch.y0 + ty) + 0.5f);
+    }
+    __syncthreads();
+
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if((x >= width) || (y >= height))
+        return;
+
+    int2 pix;
+    pix.x = x + xFrom;
+    pix.y = y;
+
+    const float idpt = *get2DBufferAt(depthMap, depthMap_p, x, y);
+    float bestSim = 1.0f;
+    float bestDpt = idpt;
+
+    // If we have an initial depth value, we can refine it
+    if(idpt > 0.0f)
+    {
+        for(int i = 0; i < ntcsteps; ++i)
+        {
+            const float tcStep = (float)(i - (ntcsteps - 1) / 2);
+
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, idpt);
+            move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, p, tcStep, moveByTcOrRc);
+
+            patch ptch;
+            ptch.p = p;
+            ptch.d = computePixSize(rcCam, p);
+            computeRotCSEpip(rcCam, tcCam, ptch, p);
+            const float osim = compNCCby3DptsYK(rcCam, tcCam, ptch, wsh, imWidth, imHeight, gammaC, gammaP, epipShift, rcFetch);
+
+            // the first step initializes the values, then they are updated if the similarity is better
+            if((i == 0) || (osim < bestSim))
+            {
+                bestSim = osim;
+                bestDpt = size(p - rcCam.C);
+            }
+        }
+    }
+
+    *get2DBufferAt(osimMap, osimMap_p, x, y) = bestSim;
+    *get2DBufferAt(odptMap, odptMap_p, x, y) = bestDpt;
+}
+
+__global__ void refine_coputeDepthStepMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                 float* depthStepMap, int depthStepMap_p, float* depthMap,
                                                  int depthMap_p, int width, int height, bool moveByTcOrRc)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -562,20 +672,24 @@ __global__ void refine_coputeDepthStepMap_kernel(float* depthStepMap, int depthS
 
         if(depth > 0.0f)
         {
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, depth);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, depth);
             float3 p1 = p;
-            move3DPointByTcOrRcPixStep(pix, p1, 1.0f, moveByTcOrRc);
+            move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, p1, 1.0f, moveByTcOrRc);
             depthStep = size(p - p1);
         };
         depthStepMap[y * depthStepMap_p + x] = depthStep;
     };
 }
 
-__global__ void refine_compYKNCCDepthSimMapPatch_kernel(float2* oDepthSimMap, int oDepthSimMap_p, float* depthMap,
+__global__ void refine_compYKNCCDepthSimMapPatch_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                        float2* oDepthSimMap, int oDepthSimMap_p, float* depthMap,
                                                         int depthMap_p, int width, int height, int wsh,
                                                         const float gammaC, const float gammaP, const float epipShift,
                                                         const float tcStep, bool moveByTcOrRc)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -589,28 +703,32 @@ __global__ void refine_compYKNCCDepthSimMapPatch_kernel(float2* oDepthSimMap, in
 
         if(depth > 0.0f)
         {
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, depth);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, depth);
             // move3DPointByTcPixStep(p, tcStep);
-            move3DPointByTcOrRcPixStep(pix, p, tcStep, moveByTcOrRc);
+            move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, p, tcStep, moveByTcOrRc);
 
             patch ptch;
             ptch.p = p;
-            ptch.d = computePixSize(p);
-            computeRotCSEpip(ptch, p);
+            ptch.d = computePixSize(rcCam, p);
+            computeRotCSEpip(rcCam, tcCam, ptch, p);
 
-            oDepthSim.x = size(sg_s_rC - ptch.p);
-            oDepthSim.y = compNCCby3DptsYK(ptch, wsh, width, height, gammaC, gammaP, epipShift);
+            oDepthSim.x = size(rcCam.C - ptch.p);
+            oDepthSim.y = compNCCby3DptsYK(rcCam, tcCam, ptch, wsh, width, height, gammaC, gammaP, epipShift);
         };
 
         oDepthSimMap[y * oDepthSimMap_p + x] = oDepthSim;
     };
 }
 
-__global__ void refine_compYKNCCSimMapPatch_kernel(float* osimMap, int osimMap_p, float* depthMap, int depthMap_p,
+__global__ void refine_compYKNCCSimMapPatch_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                   float* osimMap, int osimMap_p, float* depthMap, int depthMap_p,
                                                    int width, int height, int wsh, const float gammaC,
                                                    const float gammaP, const float epipShift, const float tcStep,
                                                    bool moveByTcOrRc, int xFrom, int imWidth, int imHeight)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -625,25 +743,29 @@ __global__ void refine_compYKNCCSimMapPatch_kernel(float* osimMap, int osimMap_p
 
         if(depth > 0.0f)
         {
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, depth);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, depth);
             // move3DPointByTcPixStep(p, tcStep);
-            move3DPointByTcOrRcPixStep(pix, p, tcStep, moveByTcOrRc);
+            move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, p, tcStep, moveByTcOrRc);
 
             patch ptch;
             ptch.p = p;
-            ptch.d = computePixSize(p);
-            computeRotCSEpip(ptch, p);
-            osim = compNCCby3DptsYK(ptch, wsh, imWidth, imHeight, gammaC, gammaP, epipShift);
+            ptch.d = computePixSize(rcCam, p);
+            computeRotCSEpip(rcCam, tcCam, ptch, p);
+            osim = compNCCby3DptsYK(rcCam, tcCam, ptch, wsh, imWidth, imHeight, gammaC, gammaP, epipShift);
         };
         *get2DBufferAt(osimMap, osimMap_p, x, y) = osim;
     };
 }
 
-__global__ void refine_compYKNCCSimMapPatchDMS_kernel(float* osimMap, int osimMap_p, float* depthMap, int depthMap_p,
+__global__ void refine_compYKNCCSimMapPatchDMS_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                      float* osimMap, int osimMap_p, float* depthMap, int depthMap_p,
                                                       int width, int height, int wsh, const float gammaC,
                                                       const float gammaP, const float epipShift,
                                                       const float depthMapShift)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -657,13 +779,13 @@ __global__ void refine_compYKNCCSimMapPatchDMS_kernel(float* osimMap, int osimMa
 
         if(depth > 0.0f)
         {
-            float3 p = get3DPointForPixelAndDepthFromRC(pix, depth + depthMapShift);
+            float3 p = get3DPointForPixelAndDepthFromRC(rcCam, pix, depth + depthMapShift);
 
             patch ptch;
             ptch.p = p;
-            ptch.d = computePixSize(p);
-            computeRotCSEpip(ptch, p);
-            osim = compNCCby3DptsYK(ptch, wsh, width, height, gammaC, gammaP, epipShift);
+            ptch.d = computePixSize(rcCam, p);
+            computeRotCSEpip(rcCam, tcCam, ptch, p);
+            osim = compNCCby3DptsYK(rcCam, tcCam, ptch, wsh, width, height, gammaC, gammaP, epipShift);
         };
 
         osimMap[y * osimMap_p + x] = osim;
@@ -696,11 +818,15 @@ __global__ void refine_setLastThreeSimsMap_kernel(float3* lastThreeSimsMap, int
     }
 }
 
-__global__ void refine_computeDepthSimMapFromLastThreeSimsMap_kernel(float* osimMap, int osimMap_p, float* iodepthMap,
+__global__ void refine_computeDepthSimMapFromLastThreeSimsMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                                     float* osimMap, int osimMap_p, float* iodepthMap,
                                                                      int iodepthMap_p, float3* lastThreeSimsMap,
                                                                      int lastThreeSimsMap_p, int width, int height,
                                                                      bool moveByTcOrRc, int xFrom)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -716,16 +842,16 @@ __global__ void refine_computeDepthSimMapFromLastThreeSimsMap_kernel(float* osim
 
         if(outDepth > 0.0f)
         {
-            float3 pMid = get3DPointForPixelAndDepthFromRC(pix, midDepth);
+            float3 pMid = get3DPointForPixelAndDepthFromRC(rcCam, pix, midDepth);
             float3 pm1 = pMid;
             float3 pp1 = pMid;
-            move3DPointByTcOrRcPixStep(pix, pm1, -1.0f, moveByTcOrRc);
-            move3DPointByTcOrRcPixStep(pix, pp1, +1.0f, moveByTcOrRc);
+            move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, pm1, -1.0f, moveByTcOrRc);
+            move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, pp1, +1.0f, moveByTcOrRc);
 
             float3 depths;
-            depths.x = size(pm1 - sg_s_rC);
+            depths.x = size(pm1 - rcCam.C);
             depths.y = midDepth;
-            depths.z = size(pp1 - sg_s_rC);
+            depths.z = size(pp1 - rcCam.C);
 
             float refinedDepth = refineDepthSubPixel(depths, sims);
             if(refinedDepth > 0.0f)
@@ -739,6 +865,31 @@ __global__ void refine_computeDepthSimMapFromLastThreeSimsMap_kernel(float* osim
     };
 }
 
+/**
+ * @brief Keep the refined depth and similarity of the pixels where the similarity is better than the default one,
+ *        else the input depth with the default similarity (same as RcTc::refineRcTcDepthSimMap on the host).
+ */
+__global__ void refine_setRefinedDepthSimMap_kernel(float2* oDepthSimMap, int oDepthSimMap_p,
+                                                    const float* rcDepthMap, int rcDepthMap_p,
+                                                    const float* refinedDepthMap, int refinedDepthMap_p,
+                                                    const float* refinedSimMap, int refinedSimMap_p,
+                                                    int width, int height, float defaultSim)
+{
+    const int x = blockIdx.x * blockDim.x + threadIdx.x;
+    const int y = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if((x < width) && (y < height))
+    {
+        const float depth = *get2DBufferAt(refinedDepthMap, refinedDepthMap_p, x, y);
+        const float sim = *get2DBufferAt(refinedSimMap, refinedSimMap_p, x, y);
+
+        if((depth > 0.0f) && (sim < defaultSim))
+            *get2DBufferAt(oDepthSimMap, oDepthSimMap_p, x, y) = make_float2(depth, sim);
+        else
+            *get2DBufferAt(oDepthSimMap, oDepthSimMap_p, x, y) = make_float2(*get2DBufferAt(rcDepthMap, rcDepthMap_p, x, y), defaultSim);
+    }
+}
+
 __global__ void refine_updateLastThreeSimsMap_kernel(float3* lastThreeSimsMap, int lastThreeSimsMap_p, float* simMap,
                                                      int simMap_p, int width, int height, int id)
 {
@@ -807,10 +958,14 @@ __global__ void refine_updateBestStatMap_kernel(float4* bestStatMap, int bestSta
     };
 }
 
-__global__ void refine_computeDepthSimMapFromBestStatMap_kernel(float* simMap, int simMap_p, float* depthMap,
+__global__ void refine_computeDepthSimMapFromBestStatMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                                float* simMap, int simMap_p, float* depthMap,
                                                                 int depthMap_p, float4* bestStatMap, int bestStatMap_p,
                                                                 int width, int height, bool moveByTcOrRc)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 pix;
@@ -826,11 +981,11 @@ __global__ void refine_computeDepthSimMapFromBestStatMap_kernel(float* simMap, i
         if(outDepth > 0.0f)
         {
             float tcStep = stat.w;
-            float3 porig = get3DPointForPixelAndDepthFromRC(pix, outDepth);
+            float3 porig = get3DPointForPixelAndDepthFromRC(rcCam, pix, outDepth);
             float3 p = porig;
             // move3DPointByTcPixStep(p, tcStep);
-            move3DPointByTcOrRcPixStep(pix, p, tcStep, moveByTcOrRc);
-            outDepth = size(p - sg_s_rC);
+            move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, p, tcStep, moveByTcOrRc);
+            outDepth = size(p - rcCam.C);
 
             if((stat.x < 1.1f) && (stat.z < 1.1f))
             {
@@ -838,13 +993,13 @@ __global__ void refine_computeDepthSimMapFromBestStatMap_kernel(float* simMap, i
                 float3 pm1 = porig;
                 float3 pp1 = porig;
                 // move3DPointByTcPixStep(pm1, tcStep-1.0f);
-                move3DPointByTcOrRcPixStep(pix, pm1, tcStep - 1.0f, moveByTcOrRc);
+                move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, pm1, tcStep - 1.0f, moveByTcOrRc);
                 // move3DPointByTcPixStep(pp1, tcStep+1.0f);
-                move3DPointByTcOrRcPixStep(pix, pp1, tcStep + 1.0f, moveByTcOrRc);
+                move3DPointByTcOrRcPixStep(rcCam, tcCam, pix, pp1, tcStep + 1.0f, moveByTcOrRc);
 
-                depths.x = size(pm1 - sg_s_rC);
+                depths.x = size(pm1 - rcCam.C);
                 depths.y = outDepth;
-                depths.z = size(pp1 - sg_s_rC);
+                depths.z = size(pp1 - rcCam.C);
 
                 float3 sims;
                 sims.x = stat.x;
@@ -883,10 +1038,14 @@ __global__ void refine_computeDepthSimMapFromBestStatMap_kernel(float* simMap, i
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-__global__ void refine_reprojTarTexLABByRcTcDepthsMap_kernel(uchar4* tex, int tex_p, float* rcDepthMap,
+__global__ void refine_reprojTarTexLABByRcTcDepthsMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                             uchar4* tex, int tex_p, float* rcDepthMap,
                                                              int rcDepthMap_p, int width, int height,
                                                              float depthMapShift)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 rpix;
@@ -900,11 +1059,11 @@ __global__ void refine_reprojTarTexLABByRcTcDepthsMap_kernel(uchar4* tex, int te
 
         if(rcDepth > 0.0f)
         {
-            float3 rp = get3DPointForPixelAndDepthFromRC(rpix, rcDepth);
-            float3 rpS = get3DPointForPixelAndDepthFromRC(rpix, rcDepth + depthMapShift);
+            float3 rp = get3DPointForPixelAndDepthFromRC(rcCam, rpix, rcDepth);
+            float3 rpS = get3DPointForPixelAndDepthFromRC(rcCam, rpix, rcDepth + depthMapShift);
 
-            float2 tpc = project3DPoint(sg_s_tP, rp);
-            float2 tpcS = project3DPoint(sg_s_tP, rpS);
+            float2 tpc = project3DPoint(tcCam.P, rp);
+            float2 tpcS = project3DPoint(tcCam.P, rpS);
 
             int2 tpix = make_int2((int)(tpc.x + 0.5f), (int)(tpc.y + 0.5f));
             float tcDepth = tex2D(depthsTex, tpix.x, tpix.y);
@@ -912,8 +1071,8 @@ __global__ void refine_reprojTarTexLABByRcTcDepthsMap_kernel(uchar4* tex, int te
             if((tcDepth > 0.0f) && ((tpc.x + 0.5f) > 0.0f) && ((tpc.y + 0.5f) > 0.0f) &&
                ((tpc.x + 0.5f) < (float)width - 1.0f) && ((tpc.y + 0.5f) < (float)height - 1.0f))
             {
-                float pixSize = computePixSize(rp);
-                float3 tp = get3DPointForPixelAndDepthFromTC(tpc, tcDepth);
+                float pixSize = computePixSize(rcCam, rp);
+                float3 tp = get3DPointForPixelAndDepthFromTC(tcCam, tpc, tcDepth);
                 float dist = size(rp - tp);
                 if(dist < pixSize)
                 {
@@ -1212,38 +1371,38 @@ __device__ float2 ComputeSobelTarIm(int x, int y)
 }
 */
 
-__device__ float2 DPIXTCDRC(const float3& P)
+__device__ float2 DPIXTCDRC(const CameraStructBase& rcCam, const CameraStructBase& tcCam, const float3& P)
 {
-    float M3P = sg_s_tP[2] * P.x + sg_s_tP[5] * P.y + sg_s_tP[8] * P.z + sg_s_tP[11];
+    float M3P = tcCam.P[2] * P.x + tcCam.P[5] * P.y + tcCam.P[8] * P.z + tcCam.P[11];
     float M3P2 = M3P * M3P;
 
-    float m11 = ((sg_s_tP[0] * sg_s_tP[5] - sg_s_tP[2] * sg_s_tP[3]) * P.y +
-                 (sg_s_tP[0] * sg_s_tP[8] - sg_s_tP[2] * sg_s_tP[6]) * P.z +
-                 (sg_s_tP[0] * sg_s_tP[11] - sg_s_tP[2] * sg_s_tP[9])) /
+    float m11 = ((tcCam.P[0] * tcCam.P[5] - tcCam.P[2] * tcCam.P[3]) * P.y +
+                 (tcCam.P[0] * tcCam.P[8] - tcCam.P[2] * tcCam.P[6]) * P.z +
+                 (tcCam.P[0] * tcCam.P[11] - tcCam.P[2] * tcCam.P[9])) /
                 M3P2;
-    float m12 = ((sg_s_tP[3] * sg_s_tP[2] - sg_s_tP[5] * sg_s_tP[0]) * P.x +
-                 (sg_s_tP[3] * sg_s_tP[8] - sg_s_tP[5] * sg_s_tP[6]) * P.z +
-                 (sg_s_tP[3] * sg_s_tP[11] - sg_s_tP[5] * sg_s_tP[9])) /
+    float m12 = ((tcCam.P[3] * tcCam.P[2] - tcCam.P[5] * tcCam.P[0]) * P.x +
+                 (tcCam.P[3] * tcCam.P[8] - tcCam.P[5] * tcCam.P[6]) * P.z +
+                 (tcCam.P[3] * tcCam.P[11] - tcCam.P[5] * tcCam.P[9])) /
                 M3P2;
-    float m13 = ((sg_s_tP[6] * sg_s_tP[2] - sg_s_tP[8] * sg_s_tP[0]) * P.x +
-                 (sg_s_tP[6] * sg_s_tP[5] - sg_s_tP[8] * sg_s_tP[3]) * P.y +
-                 (sg_s_tP[6] * sg_s_tP[11] - sg_s_tP[8] * sg_s_tP[9])) /
+    float m13 = ((tcCam.P[6] * tcCam.P[2] - tcCam.P[8] * tcCam.P[0]) * P.x +
+                 (tcCam.P[6] * tcCam.P[5] - tcCam.P[8] * tcCam.P[3]) * P.y +
+                 (tcCam.P[6] * tcCam.P[11] - tcCam.P[8] * tcCam.P[9])) /
                 M3P2;
 
-    float m21 = ((sg_s_tP[1] * sg_s_tP[5] - sg_s_tP[2] * sg_s_tP[4]) * P.y +
-                 (sg_s_tP[1] * sg_s_tP[8] - sg_s_tP[2] * sg_s_tP[7]) * P.z +
-                 (sg_s_tP[1] * sg_s_tP[11] - sg_s_tP[2] * sg_s_tP[10])) /
+    float m21 = ((tcCam.P[1] * tcCam.P[5] - tcCam.P[2] * tcCam.P[4]) * P.y +
+                 (tcCam.P[1] * tcCam.P[8] - tcCam.P[2] * tcCam.P[7]) * P.z +
+                 (tcCam.P[1] * tcCam.P[11] - tcCam.P[2] * tcCam.P[10])) /
                 M3P2;
-    float m22 = ((sg_s_tP[4] * sg_s_tP[2] - sg_s_tP[5] * sg_s_tP[1]) * P.x +
-                 (sg_s_tP[4] * sg_s_tP[8] - sg_s_tP[5] * sg_s_tP[7]) * P.z +
-                 (sg_s_tP[4] * sg_s_tP[11] - sg_s_tP[5] * sg_s_tP[10])) /
+    float m22 = ((tcCam.P[4] * tcCam.P[2] - tcCam.P[5] * tcCam.P[1]) * P.x +
+                 (tcCam.P[4] * tcCam.P[8] - tcCam.P[5] * tcCam.P[7]) * P.z +
+                 (tcCam.P[4] * tcCam.P[11] - tcCam.P[5] * tcCam.P[10])) /
                 M3P2;
-    float m23 = ((sg_s_tP[7] * sg_s_tP[2] - sg_s_tP[8] * sg_s_tP[1]) * P.x +
-                 (sg_s_tP[7] * sg_s_tP[5] - sg_s_tP[8] * sg_s_tP[4]) * P.y +
-                 (sg_s_tP[7] * sg_s_tP[11] - sg_s_tP[8] * sg_s_tP[10])) /
+    float m23 = ((tcCam.P[7] * tcCam.P[2] - tcCam.P[8] * tcCam.P[1]) * P.x +
+                 (tcCam.P[7] * tcCam.P[5] - tcCam.P[8] * tcCam.P[4]) * P.y +
+                 (tcCam.P[7] * tcCam.P[11] - tcCam.P[8] * tcCam.P[10])) /
                 M3P2;
 
-    float3 _drc = P - sg_s_rC;
+    float3 _drc = P - rcCam.C;
 
     float2 op;
     op.x = m11 * _drc.x + m12 * _drc.y + m13;
@@ -1275,7 +1434,7 @@ __global__ void refine_reprojTarSobelAndDPIXTCDRCRcTcDepthsMap_kernel(float4* te
             float3 rp = get3DPointForPixelAndDepthFromRC(rpix, rcDepth);
             float3 rpS = get3DPointForPixelAndDepthFromRC(rpix, rcDepth + depthMapShift);
 
-            float2 tpc = project3DPoint(sg_s_tP, rp);
+            float2 tpc = project3DPoint(tcCam.P, rp);
             int2 tpix = make_int2((int)(tpc.x + 0.5f), (int)(tpc.y + 0.5f));
             float tcDepth = tex2D(depthsTex, tpix.x, tpix.y);
 
@@ -1301,9 +1460,13 @@ __global__ void refine_reprojTarSobelAndDPIXTCDRCRcTcDepthsMap_kernel(float4* te
 }
 */
 
-__global__ void refine_computeRcTcDepthMap_kernel(float* rcDepthMap, int rcDepthMap_p, int width, int height,
+__global__ void refine_computeRcTcDepthMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                  float* rcDepthMap, int rcDepthMap_p, int width, int height,
                                                   float pixSizeRatioThr)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int x = blockIdx.x * blockDim.x + threadIdx.x;
     int y = blockIdx.y * blockDim.y + threadIdx.y;
     int2 rpix;
@@ -1316,16 +1479,16 @@ __global__ void refine_computeRcTcDepthMap_kernel(float* rcDepthMap, int rcDepth
         float rcDepthOut = -1.0f;
         if(rcDepth > 0.0f)
         {
-            float3 rp = get3DPointForPixelAndDepthFromRC(rpix, rcDepth);
-            float2 tpc = project3DPoint(sg_s_tP, rp);
+            float3 rp = get3DPointForPixelAndDepthFromRC(rcCam, rpix, rcDepth);
+            float2 tpc = project3DPoint(tcCam.P, rp);
             int2 tpix = make_int2((int)(tpc.x + 0.5f), (int)(tpc.y + 0.5f));
             float tcDepth = tex2D(depthsTex, tpc.x + 0.5f, tpc.y + 0.5f);
 
             if((tcDepth > 0.0f) && (tpix.x > 0) && (tpix.y > 0) && (tpix.x < width) && (tpix.y < height))
             {
-                float3 tp = get3DPointForPixelAndDepthFromTC(tpc, tcDepth);
-                float rPixSize = computeRcPixSize(rp);
-                float tPixSize = computeTcPixSize(tp);
+                float3 tp = get3DPointForPixelAndDepthFromTC(tcCam, tpc, tcDepth);
+                float rPixSize = computeRcPixSize(rcCam, rp);
+                float tPixSize = computeTcPixSize(tcCam, tp);
                 float pixSizeRatio = fmaxf(rPixSize, tPixSize) / fminf(rPixSize, tPixSize);
                 float dist = size(rp - tp);
 
@@ -7,25 +7,29 @@
 namespace aliceVision {
 namespace depthMap {
 
-__device__ void volume_computePatch(patch& ptch, int depthid, int2& pix)
+__device__ void volume_computePatch(const CameraStructBase& rcCam, const CameraStructBase& tcCam,
+                                    patch& ptch, int depthid, int2& pix)
 {
     float3 p;
     float pixSize;
 
     float fpPlaneDepth = tex2D(depthsTex, depthid, 0);
-    p = get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth);
-    pixSize = computePixSize(p);
+    p = get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepth);
+    pixSize = computePixSize(rcCam, p);
 
     ptch.p = p;
     ptch.d = pixSize;
-    computeRotCSEpip(ptch, p);
+    computeRotCSEpip(rcCam, tcCam, ptch, p);
 }
 
-__global__ void volume_slice_kernel(unsigned char* slice, int slice_p,
+__global__ void volume_slice_kernel(int rcCamCacheIdx, int tcCamCacheIdx, unsigned char* slice, int slice_p,
                                     // float3* slicePts, int slicePts_p,
                                     int nsearchdepths, int ndepths, int slicesAtTime, int width, int height, int wsh,
                                     int t, int npixs, const float gammaC, const float gammaP, const float epipShift)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int sdptid = blockIdx.x * blockDim.x + threadIdx.x;
     int pixid = blockIdx.y * blockDim.y + threadIdx.y;
 
@@ -38,9 +42,9 @@ __global__ void volume_slice_kernel(unsigned char* slice, int slice_p,
         if(depthid < ndepths)
         {
             patch ptcho;
-            volume_computePatch(ptcho, depthid, pix);
+            volume_computePatch(rcCam, tcCam, ptcho, depthid, pix);
 
-            float fsim = compNCCby3DptsYK(ptcho, wsh, width, height, gammaC, gammaP, epipShift);
+            float fsim = compNCCby3DptsYK(rcCam, tcCam, ptcho, wsh, width, height, gammaC, gammaP, epipShift);
             // unsigned char sim = (unsigned char)(((fsim+1.0f)/2.0f)*255.0f);
 
             float fminVal = -1.0f;
@@ -128,7 +132,7 @@ __global__ void volume_transposeVolume_kernel(T* volumeT, int volumeT_s, int vol
                                               const T* volume, int volume_s, int volume_p, 
                                               int volDimX, int volDimY, int volDimZ, 
                                               int dimTrnX, int dimTrnY, int dimTrnZ, 
-                                              int z)
+                                              int z, int volumeZ0)
 {
     int vx = blockIdx.x * blockDim.x + threadIdx.x;
     int vy = blockIdx.y * blockDim.y + threadIdx.y;
@@ -151,7 +155,8 @@ __global__ void volume_transposeVolume_kernel(T* volumeT, int volumeT_s, int vol
         int vTz = v[dimsTrn[2]];
 
         T* oldVal_ptr = get3DBufferAt(volumeT, volumeT_s, volumeT_p, vTx, vTy, vTz);
-        T newVal = *get3DBufferAt(volume, volume_s, volume_p, vx, vy, vz);
+        // the input volume holds the slices from volumeZ0
+        T newVal = *get3DBufferAt(volume, volume_s, volume_p, vx, vy, vz - volumeZ0);
         *oldVal_ptr = newVal;
     }
 }
@@ -313,10 +318,10 @@ __global__ void volume_agregateCostVolumeAtZinSlices_kernel(unsigned int* xySlic
         {
             int z = doInvZ ? volDimZ - vz : vz;
             int z1 = doInvZ ? z + 1 : z - 1; // M1
-            int imX0 = volLUX + (dimTrnX == 0) ? vx : z; // current
-            int imY0 = volLUY + (dimTrnX == 0) ?  z : vx;
-            int imX1 = volLUX + (dimTrnX == 0) ? vx : z1; // M1
-            int imY1 = volLUY + (dimTrnX == 0) ? z1 : vx;
+            int imX0 = volLUX + ((dimTrnX == 0) ? vx : z); // current
+            int imY0 = volLUY + ((dimTrnX == 0) ?  z : vx);
+            int imX1 = volLUX + ((dimTrnX == 0) ? vx : z1); // M1
+            int imY1 = volLUY + ((dimTrnX == 0) ? z1 : vx);
             float4 gcr0 = 255.0f * tex2D(r4tex, (float)imX0 + 0.5f, (float)imY0 + 0.5f);
             float4 gcr1 = 255.0f * tex2D(r4tex, (float)imX1 + 0.5f, (float)imY1 + 0.5f);
             float deltaC = Euclidean3(gcr0, gcr1);
@@ -347,7 +352,8 @@ __global__ void volume_agregateCostVolumeAtZinSlices_kernel(unsigned int* xySlic
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-__global__ void volume_updateRcVolumeForTcDepthMap_kernel(unsigned int* volume, int volume_s, int volume_p,
+__global__ void volume_updateRcVolumeForTcDepthMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                          unsigned int* volume, int volume_s, int volume_p,
                                                           const int volDimX, const int volDimY, const int volDimZ,
                                                           const int vz, const int volStepXY, const int tcDepthMapStep,
                                                           const int width, const int height, const float fpPlaneDepth,
@@ -356,6 +362,9 @@ __global__ void volume_updateRcVolumeForTcDepthMap_kernel(unsigned int* volume,
                                                           const bool considerNegativeDepthAsInfinity,
                                                           const float2 tcMinMaxFpDepth, const bool useSimilarity)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int vx = blockIdx.x * blockDim.x + threadIdx.x;
     int vy = blockIdx.y * blockDim.y + threadIdx.y;
 
@@ -363,20 +372,20 @@ __global__ void volume_updateRcVolumeForTcDepthMap_kernel(unsigned int* volume,
     {
         int2 pixi = make_int2(vx * volStepXY, vy * volStepXY);
         // float2 pixf = make_float2(vx*volStepXY+0.5f,vy*volStepXY+0.5f);
-        float3 p = get3DPointForPixelAndFrontoParellePlaneRC(pixi, fpPlaneDepth);
+        float3 p = get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pixi, fpPlaneDepth);
 
-        float depthTcP = size(sg_s_tC - p);
-        float fpDepthTcP = frontoParellePlaneTCDepthFor3DPoint(p);
+        float depthTcP = size(tcCam.C - p);
+        float fpDepthTcP = frontoParellePlaneTCDepthFor3DPoint(tcCam, p);
 
         float2 tpixf;
-        getPixelFor3DPointTC(tpixf, p);
+        getPixelFor3DPointTC(tcCam, tpixf, p);
         int2 tpix = make_int2((int)(tpixf.x + 0.5f), (int)(tpixf.y + 0.5f));
         // int2 tpix = make_int2((int)(tpixf.x),(int)(tpixf.y));
         int2 tpixMap =
             make_int2((int)(tpixf.x / (float)tcDepthMapStep + 0.5f), (int)(tpixf.y / (float)tcDepthMapStep + 0.5f));
 
-        float rcPixSize = computeRcPixSize(p);
-        float tcPixSize = computeTcPixSize(p);
+        float rcPixSize = computeRcPixSize(rcCam, p);
+        float tcPixSize = computeTcPixSize(tcCam, p);
 
         if(tcPixSize < rcPixSize * maxTcRcPixSizeInVoxRatio)
         {
@@ -434,7 +443,8 @@ __global__ void volume_updateRcVolumeForTcDepthMap_kernel(unsigned int* volume,
     }
 }
 
-__global__ void volume_updateRcVolumeForTcDepthMap2_kernel(unsigned int* volume, int volume_s, int volume_p,
+__global__ void volume_updateRcVolumeForTcDepthMap2_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                           unsigned int* volume, int volume_s, int volume_p,
                                                            const int volDimX, const int volDimY, const int volDimZ,
                                                            const int vz, const int volStepXY, const int tcDepthMapStep,
                                                            const int width, const int height, const float fpPlaneDepth,
@@ -443,6 +453,9 @@ __global__ void volume_updateRcVolumeForTcDepthMap2_kernel(unsigned int* volume,
                                                            const bool considerNegativeDepthAsInfinity,
                                                            const float2 tcMinMaxFpDepth, const bool useSimilarity)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int vx = blockIdx.x * blockDim.x + threadIdx.x;
     int vy = blockIdx.y * blockDim.y + threadIdx.y;
 
@@ -450,11 +463,11 @@ __global__ void volume_updateRcVolumeForTcDepthMap2_kernel(unsigned int* volume,
     {
 
         int2 pixi = make_int2(vx * volStepXY, vy * volStepXY);
-        float3 p = get3DPointForPixelAndFrontoParellePlaneRC(pixi, fpPlaneDepth);
-        float depthTcP = size(sg_s_tC - p);
-        float fpDepthTcP = frontoParellePlaneTCDepthFor3DPoint(p);
+        float3 p = get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pixi, fpPlaneDepth);
+        float depthTcP = size(tcCam.C - p);
+        float fpDepthTcP = frontoParellePlaneTCDepthFor3DPoint(tcCam, p);
         float2 tpixf;
-        getPixelFor3DPointTC(tpixf, p);
+        getPixelFor3DPointTC(tcCam, tpixf, p);
         int2 tpix = make_int2((int)(tpixf.x + 0.5f), (int)(tpixf.y + 0.5f));
         int2 tpixMap =
             make_int2((int)(tpixf.x / (float)tcDepthMapStep + 0.5f), (int)(tpixf.y / (float)tcDepthMapStep + 0.5f));
@@ -488,9 +501,9 @@ __global__ void volume_updateRcVolumeForTcDepthMap2_kernel(unsigned int* volume,
                     simWeightTc = depthSimTc.y;
                 };
                 float3 tp =
-                    get3DPointForPixelAndDepthFromTC(make_float2(tpixMapAct.x + 0.5f, tpixMapAct.y + 0.5f), depthTc);
-                float rcPixSize = computeRcPixSize(tp);
-                float tcPixSize = computeTcPixSize(tp);
+                    get3DPointForPixelAndDepthFromTC(tcCam, make_float2(tpixMapAct.x + 0.5f, tpixMapAct.y + 0.5f), depthTc);
+                float rcPixSize = computeRcPixSize(rcCam, tp);
+                float tcPixSize = computeTcPixSize(tcCam, tp);
 
                 if((tcPixSize < rcPixSize * 1.2f) && (rcPixSize < tcPixSize * 1.2f))
                 {
@@ -536,11 +549,15 @@ __global__ void volume_updateRcVolumeForTcDepthMap2_kernel(unsigned int* volume,
     }
 }
 
-__global__ void volume_update_nModalsMap_kernel(unsigned short* nModalsMap, int nModalsMap_p,
+__global__ void volume_update_nModalsMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                unsigned short* nModalsMap, int nModalsMap_p,
                                                 unsigned short* rcIdDepthMap, int rcIdDepthMap_p, int volDimX,
                                                 int volDimY, int volDimZ, int volStepXY, int tcDepthMapStep, int width,
                                                 int height, int distLimit, int id)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int vx = blockIdx.x * blockDim.x + threadIdx.x;
     int vy = blockIdx.y * blockDim.y + threadIdx.y;
 
@@ -561,13 +578,13 @@ __global__ void volume_update_nModalsMap_kernel(unsigned short* nModalsMap, int
                 float fpPlaneDepthP = tex2D(depthsTex, vz - 1, 0);
                 float step = fabsf(fpPlaneDepthP - fpPlaneDepth);
 
-                float3 p = get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth);
+                float3 p = get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepth);
                 float2 tpixf;
-                getPixelFor3DPointTC(tpixf, p);
+                getPixelFor3DPointTC(tcCam, tpixf, p);
                 int2 tpix = make_int2((int)(tpixf.x + 0.5f), (int)(tpixf.y + 0.5f));
 
                 float depthTc = tex2D(sliceTex, tpix.x / tcDepthMapStep, tpix.y / tcDepthMapStep);
-                float depthTcP = size(sg_s_tC - p);
+                float depthTcP = size(tcCam.C - p);
                 int distid = (int)(fabsf(depthTc - depthTcP) / step + 0.5f);
 
                 if((depthTc > 0.0f)
@@ -580,10 +597,14 @@ __global__ void volume_update_nModalsMap_kernel(unsigned short* nModalsMap, int
     }
 }
 
-__global__ void volume_filterRcIdDepthMapByTcDepthMap_kernel(unsigned short* rcIdDepthMap, int rcIdDepthMap_p,
+__global__ void volume_filterRcIdDepthMapByTcDepthMap_kernel(int rcCamCacheIdx, int tcCamCacheIdx,
+                                                             unsigned short* rcIdDepthMap, int rcIdDepthMap_p,
                                                              int volDimX, int volDimY, int volDimZ, int volStepXY,
                                                              int tcDepthMapStep, int width, int height, int distLimit)
 {
+    const CameraStructBase& rcCam = constantCameraParametersArray_d[rcCamCacheIdx];
+    const CameraStructBase& tcCam = constantCameraParametersArray_d[tcCamCacheIdx];
+
     int vx = blockIdx.x * blockDim.x + threadIdx.x;
     int vy = blockIdx.y * blockDim.y + threadIdx.y;
 
@@ -598,13 +619,13 @@ __global__ void volume_filterRcIdDepthMapByTcDepthMap_kernel(unsigned short* rcI
             float fpPlaneDepthP = tex2D(depthsTex, vz - 1, 0);
             float step = fabsf(fpPlaneDepthP - fpPlaneDepth);
 
-            float3 p = get3DPointForPixelAndFrontoParellePlaneRC(pix, fpPlaneDepth);
+            float3 p = get3DPointForPixelAndFrontoParellePlaneRC(rcCam, pix, fpPlaneDepth);
             float2 tpixf;
-            getPixelFor3DPointTC(tpixf, p);
+            getPixelFor3DPointTC(tcCam, tpixf, p);
             int2 tpix = make_int2((int)(tpixf.x + 0.5f), (int)(tpixf.y + 0.5f));
 
             float depthTc = tex2D(sliceTex, tpix.x / tcDepthMapStep, tpix.y / tcDepthMapStep);
-            float depthTcP = size(sg_s_tC - p);
+            float depthTcP = size(tcCam.C - p);
             int distid = (int)(fabsf(depthTc - depthTcP) / step + 0.5f);
 
             * rcIdDepthMap_yx =
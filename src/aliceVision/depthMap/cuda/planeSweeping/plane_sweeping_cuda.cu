@@ -19,6 +19,9 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
 
 namespace aliceVision {
 namespace depthMap {
@@ -72,6 +75,11 @@ float3 ps_getDeviceMemoryInfo()
     size_t iavail;
     size_t itotal;
     cudaMemGetInfo(&iavail, &itotal);
+
+    // the blocks cached by the memory pool are available for the next allocations
+    int CUDAdeviceNo = 0;
+    cudaGetDevice(&CUDAdeviceNo);
+    iavail = std::min(itotal, iavail + DeviceMemoryPool::get().getStats(CUDAdeviceNo).cachedBytes);
     size_t iused = itotal - iavail;
 
     float avail = (float)iavail / (1024.0f * 1024.0f);
@@ -81,77 +89,38 @@ float3 ps_getDeviceMemoryInfo()
     return make_float3(avail, total, used);
 }
 
-__host__ void ps_init_reference_camera_matrices(const float* _P, const float* _iP, const float* _R, const float* _iR, const float* _K, const float* _iK, const float* _C)
+__host__ void ps_deviceUpdateCamParams(const cameraStruct& cam, int camId)
 {
-    cudaMemcpyToSymbol(sg_s_rP, _P, sizeof(float) * 3 * 4);
-    cudaMemcpyToSymbol(sg_s_riP, _iP, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_rR, _R, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_riR, _iR, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_rK, _K, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_riK, _iK, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_rC, _C, sizeof(float) * 3);
-
-    float3 z;
-    z.x = 0.0f;
-    z.y = 0.0f;
-    z.z = 1.0f;
-    float3 _rZVect = ps_M3x3mulV3(_iR, z);
-    ps_normalize(_rZVect);
-
-    float3 y;
-    y.x = 0.0f;
-    y.y = 1.0f;
-    y.z = 0.0f;
-    float3 _rYVect = ps_M3x3mulV3(_iR, y);
-    ps_normalize(_rYVect);
-
-    float3 x;
-    x.x = 1.0f;
-    x.y = 0.0f;
-    x.z = 0.0f;
-    float3 _rXVect = ps_M3x3mulV3(_iR, x);
-    ps_normalize(_rXVect);
-
-    cudaMemcpyToSymbol(sg_s_rXVect, &_rXVect, sizeof(float) * 3);
-    cudaMemcpyToSymbol(sg_s_rYVect, &_rYVect, sizeof(float) * 3);
-    cudaMemcpyToSymbol(sg_s_rZVect, &_rZVect, sizeof(float) * 3);
-}
+    if(camId < 0 || camId >= MAX_CONSTANT_CAMERA_PARAM_SETS)
+    {
+        std::stringstream ss;
+        ss << "Camera cache index " << camId << " out of the " << MAX_CONSTANT_CAMERA_PARAM_SETS
+           << " camera parameters slots of the device constant memory.";
+        throw std::runtime_error(ss.str());
+    }
 
-__host__ void ps_init_target_camera_matrices(float* _P, float* _iP, float* _R, float* _iR, float* _K, float* _iK,
-                                             float* _C)
-{
-    cudaMemcpyToSymbol(sg_s_tP, _P, sizeof(float) * 3 * 4);
-    cudaMemcpyToSymbol(sg_s_tiP, _iP, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_tR, _R, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_tiR, _iR, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_tK, _K, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_tiK, _iK, sizeof(float) * 3 * 3);
-    cudaMemcpyToSymbol(sg_s_tC, _C, sizeof(float) * 3);
-
-    float3 z;
-    z.x = 0.0f;
-    z.y = 0.0f;
-    z.z = 1.0f;
-    float3 _tZVect = ps_M3x3mulV3(_iR, z);
-    ps_normalize(_tZVect);
-
-    float3 y;
-    y.x = 0.0f;
-    y.y = 1.0f;
-    y.z = 0.0f;
-    float3 _tYVect = ps_M3x3mulV3(_iR, y);
-    ps_normalize(_tYVect);
-
-    float3 x;
-    x.x = 1.0f;
-    x.y = 0.0f;
-    x.z = 0.0f;
-    float3 _tXVect = ps_M3x3mulV3(_iR, x);
-    ps_normalize(_tXVect);
-
-    cudaMemcpyToSymbol(sg_s_tXVect, &_tXVect, sizeof(float) * 3);
-    cudaMemcpyToSymbol(sg_s_tYVect, &_tYVect, sizeof(float) * 3);
-    cudaMemcpyToSymbol(sg_s_tZVect, &_tZVect, sizeof(float) * 3);
+    CameraStructBase camParams;
+    memcpy(camParams.P, cam.P, sizeof(float) * 3 * 4);
+    memcpy(camParams.iP, cam.iP, sizeof(float) * 3 * 3);
+    memcpy(camParams.R, cam.R, sizeof(float) * 3 * 3);
+    memcpy(camParams.iR, cam.iR, sizeof(float) * 3 * 3);
+    memcpy(camParams.K, cam.K, sizeof(float) * 3 * 3);
+    memcpy(camParams.iK, cam.iK, sizeof(float) * 3 * 3);
+    camParams.C = make_float3(cam.C[0], cam.C[1], cam.C[2]);
+
+    camParams.XVect = ps_M3x3mulV3(cam.iR, make_float3(1.0f, 0.0f, 0.0f));
+    ps_normalize(camParams.XVect);
+
+    camParams.YVect = ps_M3x3mulV3(cam.iR, make_float3(0.0f, 1.0f, 0.0f));
+    ps_normalize(camParams.YVect);
+
+    camParams.ZVect = ps_M3x3mulV3(cam.iR, make_float3(0.0f, 0.0f, 1.0f));
+    ps_normalize(camParams.ZVect);
+
+    cudaError_t err = cudaMemcpyToSymbol(constantCameraParametersArray_d, &camParams, sizeof(CameraStructBase),
+                                         camId * sizeof(CameraStructBase));
+    THROW_ON_CUDA_ERROR(err, "Failed to copy the camera parameters of the camera cache index " << camId
+                             << " to the constant memory (" << __FILE__ << " " << __LINE__ << ")");
 }
 
 /*
@@ -314,6 +283,12 @@ void ps_deviceAllocate(CudaArray<uchar4, 2>*** ps_texs_arr, int ncams, int width
     // printf("ps_deviceAllocate - done\n");
 }
 
+void ps_setDevice(int deviceId)
+{
+    cudaSetDevice(deviceId);
+    CHECK_CUDA_ERROR();
+}
+
 void testCUDAdeviceNo(int CUDAdeviceNo)
 {
     int myCUDAdeviceNo;
@@ -550,17 +525,254 @@ void ps_aggregatePathVolume(CudaDeviceMemoryPitched<unsigned char, 3>& d_volSimT
         printf("ps_aggregatePathVolume done\n");
 }
 
+/// Maximum size of the slabs of Z slices in which the volumes are transferred between the host and the device
+static const size_t volumeSlabMaxBytes = 16 * 1024 * 1024;
+
+/**
+ * @brief Upload of a volume from pageable host memory to the device by slabs of Z slices.
+ *
+ * The slabs go through two pinned staging buffers: the host copy of a slab to one buffer
+ * overlaps the DMA transfer of the previous slab from the other buffer. The transfers run
+ * on a non-blocking stream, so the kernels of the default stream on the slices already
+ * uploaded overlap the transfer of the next slabs.
+ *
+ * The volume is either uploaded to a device volume (see waitSlice()), or streamed through
+ * two device slab buffers so that it is never resident on the device (see waitSlab()).
+ */
+class VolumeSlabsUpload
+{
+public:
+    /// Upload the volume to the device volume dst.
+    VolumeSlabsUpload(CudaDeviceMemoryPitched<unsigned char, 3>& dst, const unsigned char* src,
+                      int volDimX, int volDimY, int volDimZ)
+        : _dst(&dst)
+        , _src(src)
+        , _volDimX(volDimX)
+        , _volDimY(volDimY)
+        , _volDimZ(volDimZ)
+    {
+        init();
+    }
+
+    /// Stream the volume through two device slab buffers.
+    VolumeSlabsUpload(const unsigned char* src, int volDimX, int volDimY, int volDimZ)
+        : _src(src)
+        , _volDimX(volDimX)
+        , _volDimY(volDimY)
+        , _volDimZ(volDimZ)
+    {
+        init();
+        for(int b = 0; b < 2; ++b)
+            _deviceSlabs[b].allocate(CudaSize<3>(volDimX, volDimY, _slabDimZ));
+    }
+
+    ~VolumeSlabsUpload()
+    {
+        // the staging buffers are in use until the last transfer is done
+        cudaStreamSynchronize(_stream);
+        for(cudaEvent_t& event : _uploaded)
+            cudaEventDestroy(event);
+        for(cudaEvent_t& event : _consumed)
+            cudaEventDestroy(event);
+        cudaStreamDestroy(_stream);
+    }
+
+    int getNbSlabs() const { return _nbSlabs; }
+    int getSlabZBegin(int slab) const { return slab * _slabDimZ; }
+    int getSlabZEnd(int slab) const { return std::min(_volDimZ, (slab + 1) * _slabDimZ); }
+
+    /**
+     * @brief Make a stream wait until slice z is on the device volume.
+     *        The slabs up to the next one are issued if they are not already.
+     * @param[in] z The slice needed by the next kernel of the stream
+     * @param[in] stream The stream of this kernel
+     */
+    void waitSlice(int z, cudaStream_t stream = 0)
+    {
+        const int slab = z / _slabDimZ;
+        issueUpTo(slab + 1);
+        cudaStreamWaitEvent(stream, _uploaded[slab], 0);
+    }
+
+    /**
+     * @brief Make a stream wait until a slab is on its device slab buffer (streamed upload).
+     *        The slabs must be used in order and released with releaseSlab() once their kernels are issued.
+     * @param[in] slab The slab needed by the next kernels of the stream
+     * @param[in] stream The stream of these kernels
+     * @return the device slab buffer holding the slices [getSlabZBegin(slab), getSlabZEnd(slab)[
+     */
+    const CudaDeviceMemoryPitched<unsigned char, 3>& waitSlab(int slab, cudaStream_t stream = 0)
+    {
+        issueUpTo(slab + 1);
+        cudaStreamWaitEvent(stream, _uploaded[slab], 0);
+        return _deviceSlabs[slab % 2];
+    }
+
+    /**
+     * @brief The device slab buffer can be overwritten once the kernels already issued on the stream are done.
+     * @param[in] slab The slab used by these kernels
+     * @param[in] stream The stream of these kernels
+     */
+    void releaseSlab(int slab, cudaStream_t stream = 0)
+    {
+        cudaEventRecord(_consumed[slab], stream);
+    }
+
+private:
+    void init()
+    {
+        const size_t sliceBytes = size_t(_volDimX) * size_t(_volDimY);
+        _slabDimZ = std::max(1, std::min(_volDimZ, int(volumeSlabMaxBytes / std::max(size_t(1), sliceBytes))));
+        _nbSlabs = divUp(_volDimZ, _slabDimZ);
+
+        for(int b = 0; b < 2; ++b)
+            _buffers[b].allocate(CudaSize<2>(_volDimX, _volDimY * _slabDimZ));
+
+        cudaError_t err = cudaStreamCreateWithFlags(&_stream, cudaStreamNonBlocking);
+        THROW_ON_CUDA_ERROR(err, "Could not create the volume upload stream");
+
+        _uploaded.resize(_nbSlabs);
+        _consumed.resize(_nbSlabs);
+        for(int slab = 0; slab < _nbSlabs; ++slab)
+        {
+            err = cudaEventCreateWithFlags(&_uploaded[slab], cudaEventDisableTiming);
+            THROW_ON_CUDA_ERROR(err, "Could not create the volume upload events");
+            err = cudaEventCreateWithFlags(&_consumed[slab], cudaEventDisableTiming);
+            THROW_ON_CUDA_ERROR(err, "Could not create the volume upload events");
+        }
+    }
+
+    void issueUpTo(int slab)
+    {
+        while(_nbIssued <= std::min(slab, _nbSlabs - 1))
+            issueSlab(_nbIssued++);
+    }
+
+    void issueSlab(int slab)
+    {
+        CudaHostMemoryHeap<unsigned char, 2>& buffer = _buffers[slab % 2];
+
+        // the buffers are free once the slab issued two steps before is transferred
+        // and, for a streamed upload, once its kernels are done
+        if(slab >= 2)
+        {
+            cudaEventSynchronize(_uploaded[slab - 2]);
+            if(_dst == nullptr)
+                cudaStreamWaitEvent(_stream, _consumed[slab - 2], 0);
+        }
+
+        const int z0 = getSlabZBegin(slab);
+        const int nz = getSlabZEnd(slab) - z0;
+        const size_t sliceBytes = size_t(_volDimX) * size_t(_volDimY);
+        memcpy(buffer.getBuffer(), _src + z0 * sliceBytes, nz * sliceBytes);
+
+        CudaDeviceMemoryPitched<unsigned char, 3>& dst = (_dst != nullptr) ? *_dst : _deviceSlabs[slab % 2];
+        const int dstZ0 = (_dst != nullptr) ? z0 : 0;
+
+        cudaError_t err = cudaMemcpy2DAsync(dst.getBytePtr() + size_t(dstZ0) * _volDimY * dst.getPitch(),
+                                            dst.getPitch(),
+                                            buffer.getBuffer(),
+                                            _volDimX,
+                                            _volDimX,
+                                            _volDimY * nz,
+                                            cudaMemcpyHostToDevice,
+                                            _stream);
+        THROW_ON_CUDA_ERROR(err, "Failed to upload the volume slab " << slab);
+        cudaEventRecord(_uploaded[slab], _stream);
+    }
+
+    CudaDeviceMemoryPitched<unsigned char, 3>* _dst = nullptr;
+    const unsigned char* _src;
+    int _volDimX, _volDimY, _volDimZ;
+    int _slabDimZ;
+    int _nbSlabs;
+    int _nbIssued = 0;
+    CudaHostMemoryHeap<unsigned char, 2> _buffers[2];
+    CudaDeviceMemoryPitched<unsigned char, 3> _deviceSlabs[2];
+    cudaStream_t _stream;
+    std::vector<cudaEvent_t> _uploaded;
+    std::vector<cudaEvent_t> _consumed;
+};
+
+/**
+ * @brief Download a volume from the device to pageable host memory by slabs of Z slices.
+ *
+ * The slabs go through two pinned staging buffers: the host copy of a slab out of one buffer
+ * overlaps the DMA transfer of the next slab to the other buffer.
+ * The transfers start once the kernels already issued on the default stream are done.
+ */
+void ps_downloadVolumeBySlabs(unsigned char* dst, const CudaDeviceMemoryPitched<unsigned char, 3>& src,
+                              int volDimX, int volDimY, int volDimZ)
+{
+    const size_t sliceBytes = size_t(volDimX) * size_t(volDimY);
+    const int slabDimZ = std::max(1, std::min(volDimZ, int(volumeSlabMaxBytes / std::max(size_t(1), sliceBytes))));
+    const int nbSlabs = divUp(volDimZ, slabDimZ);
+
+    CudaHostMemoryHeap<unsigned char, 2> buffers[2];
+    for(int b = 0; b < 2; ++b)
+        buffers[b].allocate(CudaSize<2>(volDimX, volDimY * slabDimZ));
+
+    cudaStream_t stream;
+    cudaError_t err = cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking);
+    THROW_ON_CUDA_ERROR(err, "Could not create the volume download stream");
+
+    cudaEvent_t computed;
+    cudaEvent_t downloaded[2];
+    cudaEventCreateWithFlags(&computed, cudaEventDisableTiming);
+    for(int b = 0; b < 2; ++b)
+        cudaEventCreateWithFlags(&downloaded[b], cudaEventDisableTiming);
+
+    // the download stream doesn't synchronize with the default stream
+    cudaEventRecord(computed, 0);
+    cudaStreamWaitEvent(stream, computed, 0);
+
+    const auto issueSlab = [&](int slab)
+    {
+        const int z0 = slab * slabDimZ;
+        const int nz = std::min(slabDimZ, volDimZ - z0);
+        cudaError_t err = cudaMemcpy2DAsync(buffers[slab % 2].getBuffer(),
+                                            volDimX,
+                                            src.getBytePtr() + size_t(z0) * volDimY * src.getPitch(),
+                                            src.getPitch(),
+                                            volDimX,
+                                            volDimY * nz,
+                                            cudaMemcpyDeviceToHost,
+                                            stream);
+        THROW_ON_CUDA_ERROR(err, "Failed to download the volume slab " << slab);
+        cudaEventRecord(downloaded[slab % 2], stream);
+    };
+
+    issueSlab(0);
+    for(int slab = 0; slab < nbSlabs; ++slab)
+    {
+        if(slab + 1 < nbSlabs)
+            issueSlab(slab + 1);
+
+        const int z0 = slab * slabDimZ;
+        const int nz = std::min(slabDimZ, volDimZ - z0);
+        cudaEventSynchronize(downloaded[slab % 2]);
+        memcpy(dst + z0 * sliceBytes, buffers[slab % 2].getBuffer(), nz * sliceBytes);
+    }
+
+    cudaEventDestroy(computed);
+    for(int b = 0; b < 2; ++b)
+        cudaEventDestroy(downloaded[b]);
+    cudaStreamDestroy(stream);
+}
+
 /**
  * @param[out] volAgr_dmp output volume where we will aggregate the best XXX
- * @param[in] d_volSim input similarity volume
+ * @param[in] d_volSim input similarity volume, null if it is streamed by volSimUpload
+ * @param[in] volSimUpload if not null, the slices of the similarity volume are transposed as soon as they are uploaded
  */
 void ps_updateAggrVolume(CudaDeviceMemoryPitched<unsigned char, 3>& volAgr_dmp,
-                         const CudaDeviceMemoryPitched<unsigned char, 3>& d_volSim,
+                         const CudaDeviceMemoryPitched<unsigned char, 3>* d_volSim,
                          int volDimX, int volDimY, int volDimZ,
                          int volStepXY, int volLUX, int volLUY,
                          int dimTrnX, int dimTrnY, int dimTrnZ,
                          unsigned char P1, unsigned char P2, 
-                         bool verbose, bool doInvZ, int lastN)
+                         bool verbose, bool doInvZ, int lastN,
+                         VolumeSlabsUpload* volSimUpload = nullptr)
 {
     if(verbose)
         printf("ps_updateAggrVolume\n");
@@ -593,18 +805,48 @@ void ps_updateAggrVolume(CudaDeviceMemoryPitched<unsigned char, 3>& volAgr_dmp,
     // clock_t tall = tic();
     CudaDeviceMemoryPitched<unsigned char, 3> d_volSimT(
         CudaSize<3>(volDims[dimsTrn[0]], volDims[dimsTrn[1]], volDims[dimsTrn[2]]));
-    for(int z = 0; z < volDimZ; z++)
+    if(d_volSim != nullptr)
     {
-        volume_transposeVolume_kernel<<<grid, block>>>(
-            d_volSimT.getBuffer(),
-            d_volSimT.getBytesPaddedUpToDim(1),
-            d_volSimT.getBytesPaddedUpToDim(0), // output
-            d_volSim.getBuffer(),
-            d_volSim.getBytesPaddedUpToDim(1),
-            d_volSim.getBytesPaddedUpToDim(0), // input
-            volDimX, volDimY, volDimZ,
-            dimTrnX, dimTrnY, dimTrnZ,
-            z);
+        for(int z = 0; z < volDimZ; z++)
+        {
+            if(volSimUpload != nullptr)
+                volSimUpload->waitSlice(z);
+
+            volume_transposeVolume_kernel<<<grid, block>>>(
+                d_volSimT.getBuffer(),
+                d_volSimT.getBytesPaddedUpToDim(1),
+                d_volSimT.getBytesPaddedUpToDim(0), // output
+                d_volSim->getBuffer(),
+                d_volSim->getBytesPaddedUpToDim(1),
+                d_volSim->getBytesPaddedUpToDim(0), // input
+                volDimX, volDimY, volDimZ,
+                dimTrnX, dimTrnY, dimTrnZ,
+                z, 0);
+        }
+    }
+    else
+    {
+        // the similarity volume is not resident on the device, transpose it slab by slab
+        for(int slab = 0; slab < volSimUpload->getNbSlabs(); slab++)
+        {
+            const CudaDeviceMemoryPitched<unsigned char, 3>& d_volSimSlab = volSimUpload->waitSlab(slab);
+            const int z0 = volSimUpload->getSlabZBegin(slab);
+
+            for(int z = z0; z < volSimUpload->getSlabZEnd(slab); z++)
+            {
+                volume_transposeVolume_kernel<<<grid, block>>>(
+                    d_volSimT.getBuffer(),
+                    d_volSimT.getBytesPaddedUpToDim(1),
+                    d_volSimT.getBytesPaddedUpToDim(0), // output
+                    d_volSimSlab.getBuffer(),
+                    d_volSimSlab.getBytesPaddedUpToDim(1),
+                    d_volSimSlab.getBytesPaddedUpToDim(0), // input
+                    volDimX, volDimY, volDimZ,
+                    dimTrnX, dimTrnY, dimTrnZ,
+                    z, z0);
+            }
+            volSimUpload->releaseSlab(slab);
+        }
     }
     CHECK_CUDA_ERROR();
     // if (verbose) printf("transpose volume gpu elapsed time: %f ms \n", toc(tall));
@@ -679,6 +921,7 @@ void ps_updateAggrVolume(CudaDeviceMemoryPitched<unsigned char, 3>& volAgr_dmp,
 * @param[in] ps_texs_arr table of image (in Lab colorspace) for all scales
 * @param[in] rccam RC camera
 * @param[inout] iovol_hmh input similarity volume (after Z reduction)
+* @param[in] streamVolume stream the similarity volume from the host for each path instead of keeping it on the device
 */
 void ps_SGMoptimizeSimVolume(CudaArray<uchar4, 2>** ps_texs_arr,
                              cameraStruct* rccam,
@@ -686,20 +929,24 @@ void ps_SGMoptimizeSimVolume(CudaArray<uchar4, 2>** ps_texs_arr,
                              int volDimX, int volDimY, int volDimZ,
                              int volStepXY, int volLUX, int volLUY,
                              bool verbose, unsigned char P1, unsigned char P2,
-                             int scale, int CUDAdeviceNo, int ncamsAllocated, int scales)
+                             int scale, int CUDAdeviceNo, int ncamsAllocated, int scales,
+                             bool streamVolume)
 {
     if(verbose)
         printf("ps_SGMoptimizeSimVolume\n");
 
-    ps_init_reference_camera_matrices(rccam->P, rccam->iP, rccam->R, rccam->iR, rccam->K, rccam->iK, rccam->C);
-
     // bind 'r4tex' from the image in Lab colorspace at the scale used
     cudaBindTextureToArray(r4tex, ps_texs_arr[rccam->camId * scales + scale]->getArray(),
                            cudaCreateChannelDesc<uchar4>());
 
-    //CudaDeviceMemoryPitched<unsigned char, 3> volSim_dmp(*iovol_hmh);
-    CudaDeviceMemoryPitched<unsigned char, 3> volSim_dmp(CudaSize<3>(volDimX, volDimY, volDimZ));
-    copy(volSim_dmp, iovol_hmh, volDimX, volDimY, volDimZ);
+    // the volume is uploaded by slabs, the first transposition starts on the slices already uploaded
+    std::unique_ptr<CudaDeviceMemoryPitched<unsigned char, 3>> volSim_dmp;
+    std::unique_ptr<VolumeSlabsUpload> volSimUpload;
+    if(!streamVolume)
+    {
+        volSim_dmp.reset(new CudaDeviceMemoryPitched<unsigned char, 3>(CudaSize<3>(volDimX, volDimY, volDimZ)));
+        volSimUpload.reset(new VolumeSlabsUpload(*volSim_dmp, iovol_hmh, volDimX, volDimY, volDimZ));
+    }
 
     clock_t tall = tic();
 
@@ -720,14 +967,21 @@ void ps_SGMoptimizeSimVolume(CudaArray<uchar4, 2>** ps_texs_arr,
 
     const auto updateAggrVolume = [&](int dimTrnX, int dimTrnY, int dimTrnZ, bool invZ) 
                                   {
+                                      // without the resident volume, each path streams it again from the host
+                                      std::unique_ptr<VolumeSlabsUpload> volSimSlabs;
+                                      if(streamVolume)
+                                          volSimSlabs.reset(new VolumeSlabsUpload(iovol_hmh, volDimX, volDimY, volDimZ));
+
                                       ps_updateAggrVolume(volAgr_dmp,
-                                                          volSim_dmp,
+                                                          volSim_dmp.get(),
                                                           volDimX, volDimY, volDimZ,
                                                           volStepXY, volLUX, volLUY,
                                                           dimTrnX, dimTrnY, dimTrnZ,
                                                           P1, P2, verbose,
                                                           invZ,
-                                                          npaths);
+                                                          npaths,
+                                                          streamVolume ? volSimSlabs.get()
+                                                                       : ((npaths == 0) ? volSimUpload.get() : nullptr));
                                       npaths++;
                                   };
 
@@ -746,8 +1000,7 @@ void ps_SGMoptimizeSimVolume(CudaArray<uchar4, 2>** ps_texs_arr,
 
     //--------------------------------------------------------------------------------------------------
     // copy to host
-    //copy((*iovol_hmh), volAgr_dmp);
-    copy(iovol_hmh, volDimX, volDimY, volDimZ, volAgr_dmp);
+    ps_downloadVolumeBySlabs(iovol_hmh, volAgr_dmp, volDimX, volDimY, volDimZ);
 
     cudaUnbindTexture(r4tex);
 
@@ -788,7 +1041,7 @@ void ps_transposeVolume(CudaHostMemoryHeap<unsigned char, 3>* ovol_hmh,
                                                        volSim_dmp.getBytesPaddedUpToDim(0),
                                                        volDimX, volDimY, volDimZ,
                                                        dimTrnX, dimTrnY, dimTrnZ,
-                                                       z);
+                                                       z, 0);
         CHECK_CUDA_ERROR();
     }
 
@@ -825,15 +1078,11 @@ void ps_computeSimilarityVolume(CudaArray<uchar4, 2>** ps_texs_arr,
     dim3 blockvol(block_size, block_size, 1);
     dim3 gridvol(divUp(volDimX, block_size), divUp(volDimY, block_size), 1);
 
-    // setup cameras matrices to the constant memory
-    ps_init_reference_camera_matrices(cams[0]->P, cams[0]->iP, cams[0]->R, cams[0]->iR, cams[0]->K, cams[0]->iK,
-                                      cams[0]->C);
+    // the cameras matrices are in the constant memory slots of the cameras cache
     cudaBindTextureToArray(r4tex, ps_texs_arr[cams[0]->camId * scales + scale]->getArray(),
                            cudaCreateChannelDesc<uchar4>());
 
     int c = 1;
-    ps_init_target_camera_matrices(cams[c]->P, cams[c]->iP, cams[c]->R, cams[c]->iR, cams[c]->K, cams[c]->iK,
-                                   cams[c]->C);
     cudaBindTextureToArray(t4tex, ps_texs_arr[cams[c]->camId * scales + scale]->getArray(),
                            cudaCreateChannelDesc<uchar4>());
 
@@ -853,7 +1102,8 @@ void ps_computeSimilarityVolume(CudaArray<uchar4, 2>** ps_texs_arr,
     CudaDeviceMemoryPitched<unsigned char, 2> slice_dmp(CudaSize<2>(nDepthsToSearch, slicesAtTime));
     for(int t = 0; t < ntimes; t++)
     {
-        volume_slice_kernel<<<grid, block>>>(slice_dmp.getBuffer(),
+        volume_slice_kernel<<<grid, block>>>(cams[0]->camId, cams[c]->camId,
+                                             slice_dmp.getBuffer(),
                                              slice_dmp.getPitch(),
                                              nDepthsToSearch, nDepths,
                                              slicesAtTime, width, height, wsh, t, npixs, gammaC, gammaP, epipShift);
@@ -906,7 +1156,7 @@ float ps_planeSweepingGPUPixelsVolume(CudaArray<uchar4, 2>** ps_texs_arr,
 
     //--------------------------------------------------------------------------------------------------
     // copy to host
-    copy(ovol_hmh, volDimX, volDimY, volDimZ, volSim_dmp);
+    ps_downloadVolumeBySlabs(ovol_hmh, volSim_dmp, volDimX, volDimY, volDimZ);
 
     return (float)volSim_dmp.getBytesPadded() / (1024.0f * 1024.0f);
 }
@@ -1100,8 +1350,8 @@ void ps_dilateDepthMap(CudaDeviceMemoryPitched<float, 2>& odepthMap_dmp,
     }
 }
 
-void ps_dilateMaskMap(CudaDeviceMemoryPitched<float, 2>& depthMap_dmp, int width, int height, bool verbose,
-                      int niters, float fpPlaneDepth)
+void ps_dilateMaskMap(int rcCamCacheIdx, CudaDeviceMemoryPitched<float, 2>& depthMap_dmp, int width, int height,
+                      bool verbose, int niters, float fpPlaneDepth)
 {
     ///////////////////////////////////////////////////////////////////////////////
     // setup block and grid
@@ -1134,12 +1384,14 @@ void ps_dilateMaskMap(CudaDeviceMemoryPitched<float, 2>& depthMap_dmp, int width
     }
 
     refine_convertFPPlaneDepthMapToDepthMap_kernel<<<grid, block>>>(
+        rcCamCacheIdx,
         depthMap_dmp.getBuffer(), depthMap_dmp.getPitch(),
         depthMap_dmp.getBuffer(), depthMap_dmp.getPitch(),
         width, height);
 }
 
-void ps_refineDepthMapInternal(CudaDeviceMemoryPitched<float, 2>& osimMap_dmp,
+void ps_refineDepthMapInternal(int rcCamCacheIdx, int tcCamCacheIdx,
+                               CudaDeviceMemoryPitched<float, 2>& osimMap_dmp,
                                CudaDeviceMemoryPitched<float, 2>& odepthMap_dmp,
                                CudaDeviceMemoryPitched<float, 2>& idepthMap_dmp,
                                CudaDeviceMemoryPitched<float, 2>& idepthMapMask_dmp, int width, int height,
@@ -1156,6 +1408,7 @@ void ps_refineDepthMapInternal(CudaDeviceMemoryPitched<float, 2>& osimMap_dmp,
 
     // computed three depths map ... -1,0,1 ... from dilated input depth map .. and add last
     refine_computeDepthsMapFromDepthMap_kernel<<<grid, block>>>(
+        rcCamCacheIdx, tcCamCacheIdx,
         dsm_dmp.getBuffer(), dsm_dmp.getPitch(),
         idepthMap_dmp.getBuffer(), idepthMap_dmp.getPitch(),
         width, height, moveByTcOrRc, step);
@@ -1165,6 +1418,7 @@ void ps_refineDepthMapInternal(CudaDeviceMemoryPitched<float, 2>& osimMap_dmp,
     for(int id = 0; id < 3; id++)
     {
         refine_reprojTarTexLABByDepthsMap_kernel<<<grid, block>>>(
+            rcCamCacheIdx, tcCamCacheIdx,
             dsm_dmp.getBuffer(), dsm_dmp.getPitch(),
             timg_dmp.getBuffer(), timg_dmp.getPitch(),
             width, height, id);
@@ -1190,7 +1444,8 @@ void ps_refineDepthMapInternal(CudaDeviceMemoryPitched<float, 2>& osimMap_dmp,
         width, height, simThr);
 }
 
-void ps_computeSimMapForDepthMapInternal(CudaDeviceMemoryPitched<float, 2>& osimMap_dmp,
+void ps_computeSimMapForDepthMapInternal(int rcCamCacheIdx, int tcCamCacheIdx,
+                                         CudaDeviceMemoryPitched<float, 2>& osimMap_dmp,
                                          CudaDeviceMemoryPitched<float, 2>& idepthMapMask_dmp, int width, int height,
                                          bool verbose, int wsh, float gammaC, float gammaP,
                                          CudaArray<uchar4, 2>& tTexU4_arr,
@@ -1203,6 +1458,7 @@ void ps_computeSimMapForDepthMapInternal(CudaDeviceMemoryPitched<float, 2>& osim
     dim3 grid(divUp(width, block_size), divUp(height, block_size), 1);
 
     reprojTarTexLAB_kernel<<<grid, block>>>(
+        rcCamCacheIdx, tcCamCacheIdx,
         timg_dmp.getBuffer(), timg_dmp.getPitch(),
         width, height, fpPlaneDepth);
 
@@ -1217,8 +1473,10 @@ void ps_computeSimMapForDepthMapInternal(CudaDeviceMemoryPitched<float, 2>& osim
         wsh, gammaC, gammaP);
 }
 
-void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, float* osimMap_hmh,
-                         float* rcDepthMap_hmh, int ntcsteps,
+void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr,
+                         CudaDeviceMemoryPitched<float, 2>& bestSimMap_dmp,
+                         CudaDeviceMemoryPitched<float, 2>& bestDptMap_dmp,
+                         CudaDeviceMemoryPitched<float, 2>& rcDepthMap_dmp, int ntcsteps,
                          cameraStruct** cams, int ncams, int width,
                          int height, int imWidth, int imHeight, int scale, int CUDAdeviceNo, int ncamsAllocated,
                          int scales, bool verbose, int wsh, float gammaC, float gammaP, float epipShift,
@@ -1230,34 +1488,50 @@ void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, float* osimMap_hmh,
     dim3 block(block_size, block_size, 1);
     dim3 grid(divUp(width, block_size), divUp(height, block_size), 1);
 
-    ps_init_reference_camera_matrices(cams[0]->P, cams[0]->iP, cams[0]->R, cams[0]->iR, cams[0]->K, cams[0]->iK,
-                                      cams[0]->C);
     cudaBindTextureToArray(r4tex, ps_texs_arr[cams[0]->camId * scales + scale]->getArray(),
                            cudaCreateChannelDesc<uchar4>());
 
     int c = 1;
-    ps_init_target_camera_matrices(cams[c]->P, cams[c]->iP, cams[c]->R, cams[c]->iR, cams[c]->K, cams[c]->iK,
-                                   cams[c]->C);
     cudaBindTextureToArray(t4tex, ps_texs_arr[cams[c]->camId * scales + scale]->getArray(),
                            cudaCreateChannelDesc<uchar4>());
 
+    const int rcCamCacheIdx = cams[0]->camId;
+    const int tcCamCacheIdx = cams[c]->camId;
+
     CudaDeviceMemoryPitched<float3, 2> lastThreeSimsMap(CudaSize<2>(width, height));
     CudaDeviceMemoryPitched<float, 2> simMap_dmp(CudaSize<2>(width, height));
-    CudaDeviceMemoryPitched<float, 2> rcDepthMap_dmp(CudaSize<2>(width, height));
-    copy(rcDepthMap_dmp, rcDepthMap_hmh, width, height);
-    CudaDeviceMemoryPitched<float, 2> bestSimMap_dmp(CudaSize<2>(width, height));
-    CudaDeviceMemoryPitched<float, 2> bestDptMap_dmp(CudaSize<2>(width, height));
 
     clock_t tall = tic();
 
-    for(int i = 0; i < ntcsteps; i++) // Default ntcsteps = 31
+    // the patches project around their rc pixel, the tile margin covers them with a rounding margin,
+    // the samples out of the tile are read from the texture
+    const int tileRadius = wsh * 3 / 2 + 2;
+    const int tileSide = block_size + 2 * tileRadius + 1;
+    const size_t tileBytes = tileSide * tileSide * sizeof(float4);
+
+    if(tileBytes <= 48 * 1024)
     {
-        refine_compUpdateYKNCCSimMapPatch_kernel<<<grid, block>>>(
+        // all the depth steps in one launch, sharing the rc tile
+        refine_compUpdateYKNCCSimMapPatchSteps_kernel<<<grid, block, tileBytes>>>(
+            rcCamCacheIdx, tcCamCacheIdx,
             bestSimMap_dmp.getBuffer(), bestSimMap_dmp.getPitch(),
             bestDptMap_dmp.getBuffer(), bestDptMap_dmp.getPitch(),
             rcDepthMap_dmp.getBuffer(), rcDepthMap_dmp.getPitch(),
             width, height, wsh, gammaC, gammaP, epipShift,
-            (float)(i - (ntcsteps - 1) / 2), i, moveByTcOrRc, xFrom, imWidth, imHeight);
+            ntcsteps, moveByTcOrRc, xFrom, imWidth, imHeight, tileRadius);
+    }
+    else
+    {
+        for(int i = 0; i < ntcsteps; i++) // Default ntcsteps = 31
+        {
+            refine_compUpdateYKNCCSimMapPatch_kernel<<<grid, block>>>(
+                rcCamCacheIdx, tcCamCacheIdx,
+                bestSimMap_dmp.getBuffer(), bestSimMap_dmp.getPitch(),
+                bestDptMap_dmp.getBuffer(), bestDptMap_dmp.getPitch(),
+                rcDepthMap_dmp.getBuffer(), rcDepthMap_dmp.getPitch(),
+                width, height, wsh, gammaC, gammaP, epipShift,
+                (float)(i - (ntcsteps - 1) / 2), i, moveByTcOrRc, xFrom, imWidth, imHeight);
+        }
     }
 
     refine_setLastThreeSimsMap_kernel<<<grid, block>>>(
@@ -1266,6 +1540,7 @@ void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, float* osimMap_hmh,
         width, height, 1);
 
     refine_compYKNCCSimMapPatch_kernel<<<grid, block>>>(
+        rcCamCacheIdx, tcCamCacheIdx,
         simMap_dmp.getBuffer(), simMap_dmp.getPitch(),
         bestDptMap_dmp.getBuffer(), bestDptMap_dmp.getPitch(),
         width,
@@ -1278,6 +1553,7 @@ void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, float* osimMap_hmh,
         width, height, 0);
 
     refine_compYKNCCSimMapPatch_kernel<<<grid, block>>>(
+        rcCamCacheIdx, tcCamCacheIdx,
         simMap_dmp.getBuffer(), simMap_dmp.getPitch(),
         bestDptMap_dmp.getBuffer(), bestDptMap_dmp.getPitch(),
         width,
@@ -1290,16 +1566,71 @@ void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, float* osimMap_hmh,
         width, height, 2);
 
     refine_computeDepthSimMapFromLastThreeSimsMap_kernel<<<grid, block>>>(
+        rcCamCacheIdx, tcCamCacheIdx,
         bestSimMap_dmp.getBuffer(), bestSimMap_dmp.getPitch(),
         bestDptMap_dmp.getBuffer(), bestDptMap_dmp.getPitch(),
         lastThreeSimsMap.getBuffer(), lastThreeSimsMap.getPitch(),
         width, height, moveByTcOrRc, xFrom);
 
+    if(verbose)
+        printf("gpu elapsed time: %f ms \n", toc(tall));
+}
+
+void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, float* osimMap_hmh,
+                         float* rcDepthMap_hmh, int ntcsteps,
+                         cameraStruct** cams, int ncams, int width,
+                         int height, int imWidth, int imHeight, int scale, int CUDAdeviceNo, int ncamsAllocated,
+                         int scales, bool verbose, int wsh, float gammaC, float gammaP, float epipShift,
+                         bool moveByTcOrRc, int xFrom)
+{
+    CudaDeviceMemoryPitched<float, 2> rcDepthMap_dmp(CudaSize<2>(width, height));
+    copy(rcDepthMap_dmp, rcDepthMap_hmh, width, height);
+    CudaDeviceMemoryPitched<float, 2> bestSimMap_dmp(CudaSize<2>(width, height));
+    CudaDeviceMemoryPitched<float, 2> bestDptMap_dmp(CudaSize<2>(width, height));
+
+    ps_refineRcDepthMap(ps_texs_arr, bestSimMap_dmp, bestDptMap_dmp, rcDepthMap_dmp, ntcsteps, cams, ncams,
+                        width, height, imWidth, imHeight, scale, CUDAdeviceNo, ncamsAllocated, scales, verbose,
+                        wsh, gammaC, gammaP, epipShift, moveByTcOrRc, xFrom);
+
     copy(osimMap_hmh, width, height, bestSimMap_dmp);
     copy(rcDepthMap_hmh, width, height, bestDptMap_dmp);
+}
 
-    if(verbose)
-        printf("gpu elapsed time: %f ms \n", toc(tall));
+void ps_refineRcTcDepthSimMap(CudaArray<uchar4, 2>** ps_texs_arr,
+                              CudaDeviceMemoryPitched<float2, 2>& odepthSimMap_dmp,
+                              CudaDeviceMemoryPitched<float2, 2>& rcDepthSimMap_dmp, int ntcsteps,
+                              cameraStruct** cams, int ncams, int scale, int CUDAdeviceNo, int ncamsAllocated,
+                              int scales, bool verbose, int wsh, float gammaC, float gammaP, float epipShift,
+                              bool moveByTcOrRc, float defaultSim)
+{
+    const int width = rcDepthSimMap_dmp.getUnitsInDim(0);
+    const int height = rcDepthSimMap_dmp.getUnitsInDim(1);
+
+    const int block_size = 16;
+    const dim3 block(block_size, block_size, 1);
+    const dim3 grid(divUp(width, block_size), divUp(height, block_size), 1);
+
+    CudaDeviceMemoryPitched<float, 2> rcDepthMap_dmp(CudaSize<2>(width, height));
+    CudaDeviceMemoryPitched<float, 2> bestSimMap_dmp(CudaSize<2>(width, height));
+    CudaDeviceMemoryPitched<float, 2> bestDptMap_dmp(CudaSize<2>(width, height));
+
+    fuse_getOptDeptMapFromOPtDepthSimMap_kernel<<<grid, block>>>(
+        rcDepthMap_dmp.getBuffer(), rcDepthMap_dmp.getPitch(),
+        rcDepthSimMap_dmp.getBuffer(), rcDepthSimMap_dmp.getPitch(),
+        width, height);
+
+    ps_refineRcDepthMap(ps_texs_arr, bestSimMap_dmp, bestDptMap_dmp, rcDepthMap_dmp, ntcsteps, cams, ncams,
+                        width, height, width, height, scale, CUDAdeviceNo, ncamsAllocated, scales, verbose,
+                        wsh, gammaC, gammaP, epipShift, moveByTcOrRc, 0);
+
+    refine_setRefinedDepthSimMap_kernel<<<grid, block>>>(
+        odepthSimMap_dmp.getBuffer(), odepthSimMap_dmp.getPitch(),
+        rcDepthMap_dmp.getBuffer(), rcDepthMap_dmp.getPitch(),
+        bestDptMap_dmp.getBuffer(), bestDptMap_dmp.getPitch(),
+        bestSimMap_dmp.getBuffer(), bestSimMap_dmp.getPitch(),
+        width, height, defaultSim);
+
+    CHECK_CUDA_ERROR();
 }
 
 /**
@@ -1314,8 +1645,8 @@ void ps_refineRcDepthMap(CudaArray<uchar4, 2>** ps_texs_arr, float* osimMap_hmh,
  * @param height
  * @param verbose
  */
-void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
-                                             CudaHostMemoryHeap<float2, 2>** depthSimMaps_hmh, int ndepthSimMaps,
+void ps_fuseDepthSimMapsGaussianKernelVoting(CudaDeviceMemoryPitched<float2, 2>& odepthSimMap_dmp,
+                                             CudaDeviceMemoryPitched<float2, 2>** depthSimMaps_dmp, int ndepthSimMaps,
                                              int nSamplesHalf, int nDepthsToRefine, float sigma, int width, int height,
                                              bool verbose)
 {
@@ -1330,17 +1661,8 @@ void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2>* odep
     dim3 block(block_size, block_size, 1);
     dim3 grid(divUp(width, block_size), divUp(height, block_size), 1);
 
-    CudaDeviceMemoryPitched<float2, 2> bestDepthSimMap_dmp(CudaSize<2>(width, height));
     CudaDeviceMemoryPitched<float2, 2> bestGsvSampleMap_dmp(CudaSize<2>(width, height));
     CudaDeviceMemoryPitched<float, 2> gsvSampleMap_dmp(CudaSize<2>(width, height));
-    CudaDeviceMemoryPitched<float2, 2>** depthSimMaps_dmp;
-
-    depthSimMaps_dmp = new CudaDeviceMemoryPitched<float2, 2>*[ndepthSimMaps];
-    for(int i = 0; i < ndepthSimMaps; i++)
-    {
-        depthSimMaps_dmp[i] = new CudaDeviceMemoryPitched<float2, 2>(CudaSize<2>(width, height));
-        copy((*depthSimMaps_dmp[i]), (*depthSimMaps_hmh[i]));
-    }
 
     for(int s = -nSamplesHalf; s <= nSamplesHalf; s++) // (-150, 150)
     {
@@ -1359,26 +1681,40 @@ void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2>* odep
     }
 
     fuse_computeFusedDepthSimMapFromBestGaussianKernelVotingSampleMap_kernel<<<grid, block>>>(
-        bestDepthSimMap_dmp.getBuffer(), bestDepthSimMap_dmp.getPitch(),
+        odepthSimMap_dmp.getBuffer(), odepthSimMap_dmp.getPitch(),
         bestGsvSampleMap_dmp.getBuffer(), bestGsvSampleMap_dmp.getPitch(),
         depthSimMaps_dmp[0]->getBuffer(), depthSimMaps_dmp[0]->getPitch(),
         width, height, samplesPerPixSize);
 
-    copy((*odepthSimMap_hmh), bestDepthSimMap_dmp);
+    if(verbose)
+        printf("gpu elapsed time: %f ms \n", toc(tall));
+}
 
+void ps_fuseDepthSimMapsGaussianKernelVoting(CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
+                                             CudaHostMemoryHeap<float2, 2>** depthSimMaps_hmh, int ndepthSimMaps,
+                                             int nSamplesHalf, int nDepthsToRefine, float sigma, int width, int height,
+                                             bool verbose)
+{
+    std::vector<std::unique_ptr<CudaDeviceMemoryPitched<float2, 2>>> depthSimMaps(ndepthSimMaps);
+    std::vector<CudaDeviceMemoryPitched<float2, 2>*> depthSimMaps_dmp(ndepthSimMaps);
     for(int i = 0; i < ndepthSimMaps; i++)
     {
-        delete depthSimMaps_dmp[i];
+        depthSimMaps[i].reset(new CudaDeviceMemoryPitched<float2, 2>(CudaSize<2>(width, height)));
+        copy((*depthSimMaps[i]), (*depthSimMaps_hmh[i]));
+        depthSimMaps_dmp[i] = depthSimMaps[i].get();
     }
-    delete[] depthSimMaps_dmp;
 
-    if(verbose)
-        printf("gpu elapsed time: %f ms \n", toc(tall));
+    CudaDeviceMemoryPitched<float2, 2> bestDepthSimMap_dmp(CudaSize<2>(width, height));
+
+    ps_fuseDepthSimMapsGaussianKernelVoting(bestDepthSimMap_dmp, depthSimMaps_dmp.data(), ndepthSimMaps,
+                                            nSamplesHalf, nDepthsToRefine, sigma, width, height, verbose);
+
+    copy((*odepthSimMap_hmh), bestDepthSimMap_dmp);
 }
 
 void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
-                                           CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
-                                           CudaHostMemoryHeap<float2, 2>** dataMaps_hmh, int ndataMaps,
+                                           CudaDeviceMemoryPitched<float2, 2>& optDepthSimMap_dmp,
+                                           CudaDeviceMemoryPitched<float2, 2>** dataMaps_dmp, int ndataMaps,
                                            int nSamplesHalf, int nDepthsToRefine, int nIters, float sigma,
                                            cameraStruct** cams, int ncams, int width, int height, int scale,
                                            int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose, int yFrom)
@@ -1393,21 +1729,10 @@ void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
     dim3 block(block_size, block_size, 1);
     dim3 grid(divUp(width, block_size), divUp(height, block_size), 1);
 
-    ps_init_reference_camera_matrices(cams[0]->P, cams[0]->iP, cams[0]->R, cams[0]->iR, cams[0]->K, cams[0]->iK,
-                                      cams[0]->C);
     cudaBindTextureToArray(r4tex, ps_texs_arr[cams[0]->camId * scales + scale]->getArray(),
                            cudaCreateChannelDesc<uchar4>());
 
-    CudaDeviceMemoryPitched<float2, 2>** dataMaps_dmp;
-    dataMaps_dmp = new CudaDeviceMemoryPitched<float2, 2>*[ndataMaps];
-    for(int i = 0; i < ndataMaps; i++)
-    {
-        dataMaps_dmp[i] = new CudaDeviceMemoryPitched<float2, 2>(CudaSize<2>(width, height));
-        copy((*dataMaps_dmp[i]), (*dataMaps_hmh[i]));
-    }
-
     CudaDeviceMemoryPitched<float, 2> optDepthMap_dmp(CudaSize<2>(width, height));
-    CudaDeviceMemoryPitched<float2, 2> optDepthSimMap_dmp(CudaSize<2>(width, height));
     CudaArray<float, 2> optDepthMap_arr(CudaSize<2>(width, height));
     copy(optDepthSimMap_dmp, (*dataMaps_dmp[0]));
 
@@ -1424,6 +1749,7 @@ void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
 
         // Adjust depth/sim by using previously computed depths (depthTex is accessed inside this kernel)
         fuse_optimizeDepthSimMap_kernel<<<grid, block>>>(
+            cams[0]->camId,
             optDepthSimMap_dmp.getBuffer(), optDepthSimMap_dmp.getPitch(),
             dataMaps_dmp[0]->getBuffer(), dataMaps_dmp[0]->getPitch(),
             dataMaps_dmp[1]->getBuffer(), dataMaps_dmp[1]->getPitch(),
@@ -1432,18 +1758,82 @@ void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
         cudaUnbindTexture(depthsTex);
     }
 
-    copy((*odepthSimMap_hmh), optDepthSimMap_dmp);
+    cudaUnbindTexture(r4tex);
 
+    if(verbose)
+        printf("gpu elapsed time: %f ms \n", toc(tall));
+}
+
+void ps_optimizeDepthSimMapGradientDescent(CudaArray<uchar4, 2>** ps_texs_arr,
+                                           CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
+                                           CudaHostMemoryHeap<float2, 2>** dataMaps_hmh, int ndataMaps,
+                                           int nSamplesHalf, int nDepthsToRefine, int nIters, float sigma,
+                                           cameraStruct** cams, int ncams, int width, int height, int scale,
+                                           int CUDAdeviceNo, int ncamsAllocated, int scales, bool verbose, int yFrom)
+{
+    std::vector<std::unique_ptr<CudaDeviceMemoryPitched<float2, 2>>> dataMaps(ndataMaps);
+    std::vector<CudaDeviceMemoryPitched<float2, 2>*> dataMaps_dmp(ndataMaps);
     for(int i = 0; i < ndataMaps; i++)
     {
-        delete dataMaps_dmp[i];
+        dataMaps[i].reset(new CudaDeviceMemoryPitched<float2, 2>(CudaSize<2>(width, height)));
+        copy((*dataMaps[i]), (*dataMaps_hmh[i]));
+        dataMaps_dmp[i] = dataMaps[i].get();
     }
-    delete[] dataMaps_dmp;
 
-    cudaUnbindTexture(r4tex);
+    CudaDeviceMemoryPitched<float2, 2> optDepthSimMap_dmp(CudaSize<2>(width, height));
 
-    if(verbose)
-        printf("gpu elapsed time: %f ms \n", toc(tall));
+    ps_optimizeDepthSimMapGradientDescent(ps_texs_arr, optDepthSimMap_dmp, dataMaps_dmp.data(), ndataMaps,
+                                          nSamplesHalf, nDepthsToRefine, nIters, sigma, cams, ncams, width, height,
+                                          scale, CUDAdeviceNo, ncamsAllocated, scales, verbose, yFrom);
+
+    copy((*odepthSimMap_hmh), optDepthSimMap_dmp);
+}
+
+void ps_countConsistentPoints(CudaDeviceMemoryPitched<int, 2>& numOfPtsMap_dmp,
+                              CudaDeviceMemoryPitched<float, 2>& rcDepthMap_dmp,
+                              CudaDeviceMemoryPitched<float, 2>& rcSimMap_dmp,
+                              CudaDeviceMemoryPitched<float, 2>& tcDepthMap_dmp,
+                              int rcCamCacheIdx, int tcCamCacheIdx, int border,
+                              int pixSizeBall, int pixSizeBallWSP)
+{
+    const int rcWidth = rcDepthMap_dmp.getUnitsInDim(0);
+    const int rcHeight = rcDepthMap_dmp.getUnitsInDim(1);
+    const int tcWidth = tcDepthMap_dmp.getUnitsInDim(0);
+    const int tcHeight = tcDepthMap_dmp.getUnitsInDim(1);
+
+    const int block_size = 16;
+    const dim3 block(block_size, block_size, 1);
+    const dim3 grid(divUp(tcWidth, block_size), divUp(tcHeight, block_size), 1);
+
+    fuse_countConsistentPoints_kernel<<<grid, block>>>(
+        rcCamCacheIdx, tcCamCacheIdx,
+        numOfPtsMap_dmp.getBuffer(), numOfPtsMap_dmp.getPitch(),
+        rcDepthMap_dmp.getBuffer(), rcDepthMap_dmp.getPitch(),
+        rcSimMap_dmp.getBuffer(), rcSimMap_dmp.getPitch(),
+        rcWidth, rcHeight, border,
+        tcDepthMap_dmp.getBuffer(), tcDepthMap_dmp.getPitch(),
+        tcWidth, tcHeight,
+        pixSizeBall, pixSizeBallWSP);
+
+    CHECK_CUDA_ERROR();
+}
+
+void ps_updateNbConsistentCamsMap(CudaDeviceMemoryPitched<unsigned char, 2>& nmodMap_dmp,
+                                  CudaDeviceMemoryPitched<int, 2>& numOfPtsMap_dmp)
+{
+    const int width = nmodMap_dmp.getUnitsInDim(0);
+    const int height = nmodMap_dmp.getUnitsInDim(1);
+
+    const int block_size = 16;
+    const dim3 block(block_size, block_size, 1);
+    const dim3 grid(divUp(width, block_size), divUp(height, block_size), 1);
+
+    fuse_updateNbConsistentCamsMap_kernel<<<grid, block>>>(
+        nmodMap_dmp.getBuffer(), nmodMap_dmp.getPitch(),
+        numOfPtsMap_dmp.getBuffer(), numOfPtsMap_dmp.getPitch(),
+        width, height);
+
+    CHECK_CUDA_ERROR();
 }
 
 void ps_getSilhoueteMap(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<bool, 2>* omap_hmh, int width,
@@ -1493,8 +1883,6 @@ void ps_computeNormalMap(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<
   CudaArray<float, 2> depthMap_arr(*depthMap_hmh);
   cudaBindTextureToArray(depthsTex, depthMap_arr.getArray(), cudaCreateChannelDesc<float>());
 
-  ps_init_reference_camera_matrices(camera.P, camera.iP, camera.R, camera.iR, camera.K, camera.iK, camera.C);
-
   CudaDeviceMemoryPitched<float3, 2> normalMap_dmp(*normalMap_hmh);
 
   int block_size = 8;
@@ -1507,6 +1895,7 @@ void ps_computeNormalMap(CudaArray<uchar4, 2>** ps_texs_arr, CudaHostMemoryHeap<
   //------------------------------------------------------------------------------------------------
   // compute normal map
   computeNormalMap_kernel<<<grid, block>>>(
+    camera.camId,
     normalMap_dmp.getBuffer(),
     normalMap_dmp.getPitch(),
     width, height, wsh,
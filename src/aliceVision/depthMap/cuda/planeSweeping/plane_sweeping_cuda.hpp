@@ -58,12 +58,18 @@ void ps_SGMoptimizeSimVolume(
     int scale,
     int CUDAdeviceNo,
     int ncamsAllocated,
-    int scales);
+    int scales,
+    bool streamVolume);
 
 
 
 int ps_listCUDADevices(bool verbose);
 
+/**
+ * @brief Select the CUDA device used by the calling thread.
+ */
+void ps_setDevice(int deviceId);
+
 void ps_deviceAllocate(
     CudaArray<uchar4, 2>*** ps_texs_arr,
     int ncams,
@@ -81,6 +87,15 @@ void ps_deviceUpdateCam(
     int w, int h,
     int varianceWsh);
 
+/**
+ * @brief Upload the camera parameters in its slot of the device constant memory.
+ * @param[in] cam the camera, with its matrices at the scale used
+ * @param[in] camId the camera slot, index of the camera in the cameras cache (< MAX_CONSTANT_CAMERA_PARAM_SETS)
+ */
+void ps_deviceUpdateCamParams(
+    const cameraStruct& cam,
+    int camId);
+
 void ps_deviceDeallocate(
     CudaArray<uchar4, 2>*** ps_texs_arr,
     int CUDAdeviceNo,
@@ -107,6 +122,41 @@ void ps_refineRcDepthMap(
     bool moveByTcOrRc,
     int xFrom);
 
+/**
+ * @brief Refine the depths of a whole depth/sim map on the device, without host transfers
+ *        (see ps_refineRcDepthMap and RcTc::refineRcTcDepthSimMap).
+ * @param[out] odepthSimMap_dmp the refined depth and sim where the sim is better than defaultSim,
+ *             else the input depth with defaultSim
+ * @param[in] rcDepthSimMap_dmp the depths to refine around
+ */
+void ps_refineRcTcDepthSimMap(
+    CudaArray<uchar4, 2>** ps_texs_arr,
+    CudaDeviceMemoryPitched<float2, 2>& odepthSimMap_dmp,
+    CudaDeviceMemoryPitched<float2, 2>& rcDepthSimMap_dmp,
+    int ntcsteps,
+    cameraStruct** cams,
+    int ncams,
+    int scale,
+    int CUDAdeviceNo,
+    int ncamsAllocated,
+    int scales,
+    bool verbose,
+    int wsh,
+    float gammaC, float gammaP,
+    float epipShift,
+    bool moveByTcOrRc,
+    float defaultSim);
+
+void ps_fuseDepthSimMapsGaussianKernelVoting(
+    CudaDeviceMemoryPitched<float2, 2>& odepthSimMap_dmp,
+    CudaDeviceMemoryPitched<float2, 2>** depthSimMaps_dmp,
+    int ndepthSimMaps,
+    int nSamplesHalf,
+    int nDepthsToRefine,
+    float sigma,
+    int width, int height,
+    bool verbose);
+
 void ps_fuseDepthSimMapsGaussianKernelVoting(
     CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
     CudaHostMemoryHeap<float2, 2>** depthSimMaps_hmh,
@@ -117,6 +167,28 @@ void ps_fuseDepthSimMapsGaussianKernelVoting(
     int width, int height,
     bool verbose);
 
+/**
+ * @brief Optimize a depth/sim map on the device, without host transfers (optDepthSimMap_dmp is allocated by the caller)
+ */
+void ps_optimizeDepthSimMapGradientDescent(
+    CudaArray<uchar4, 2>** ps_texs_arr,
+    CudaDeviceMemoryPitched<float2, 2>& optDepthSimMap_dmp,
+    CudaDeviceMemoryPitched<float2, 2>** dataMaps_dmp,
+    int ndataMaps,
+    int nSamplesHalf,
+    int nDepthsToRefine,
+    int nIters,
+    float sigma,
+    cameraStruct** cams,
+    int ncams,
+    int width, int height,
+    int scale,
+    int CUDAdeviceNo,
+    int ncamsAllocated,
+    int scales,
+    bool verbose,
+    int yFrom);
+
 void ps_optimizeDepthSimMapGradientDescent(
     CudaArray<uchar4, 2>** ps_texs_arr,
     CudaHostMemoryHeap<float2, 2>* odepthSimMap_hmh,
@@ -136,6 +208,27 @@ void ps_optimizeDepthSimMapGradientDescent(
     bool verbose,
     int yFrom);
 
+/**
+ * @brief Add to each rc pixel the number of points of the tc depth map consistent with its depth,
+ *        around the projection of the points in rc (see fuseCut::Fuser::updateInSurr).
+ * @param[in,out] numOfPtsMap_dmp the number of consistent points of each rc pixel
+ * @param[in] rcCamCacheIdx, tcCamCacheIdx the camera parameters slots of rc and tc
+ * @param[in] border the margin of the rc image without projections
+ * @param[in] pixSizeBall, pixSizeBallWSP the radius of the neighborhood, for the weakly supported rc pixels (sim >= 1)
+ */
+void ps_countConsistentPoints(CudaDeviceMemoryPitched<int, 2>& numOfPtsMap_dmp,
+                              CudaDeviceMemoryPitched<float, 2>& rcDepthMap_dmp,
+                              CudaDeviceMemoryPitched<float, 2>& rcSimMap_dmp,
+                              CudaDeviceMemoryPitched<float, 2>& tcDepthMap_dmp,
+                              int rcCamCacheIdx, int tcCamCacheIdx, int border,
+                              int pixSizeBall, int pixSizeBallWSP);
+
+/**
+ * @brief Count one more consistent camera for the pixels with consistent points, and reset their number of points.
+ */
+void ps_updateNbConsistentCamsMap(CudaDeviceMemoryPitched<unsigned char, 2>& nmodMap_dmp,
+                                  CudaDeviceMemoryPitched<int, 2>& numOfPtsMap_dmp);
+
 void ps_getSilhoueteMap(
     CudaArray<uchar4, 2>** ps_texs_arr,
     CudaHostMemoryHeap<bool, 2>* omap_hmh,
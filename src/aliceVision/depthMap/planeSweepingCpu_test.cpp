@@ -0,0 +1,289 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/depthMap/cpu/planeSweepingKernels.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+#define BOOST_TEST_MODULE depthMapPlaneSweepingCpu
+
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+#include <aliceVision/unitTest.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::depthMap;
+
+namespace {
+
+const int imWidth = 96;
+const int imHeight = 48;
+const double focal = 100.0;
+const double baseline = 1.0;
+const double planeDepth = 5.0;
+
+/// Camera of identity rotation with the center C
+CameraStruct makeCamera(const Point3d& C)
+{
+    Matrix3x3 K = diag3x3(focal, focal, 1.0);
+    K.m13 = imWidth / 2.0;
+    K.m23 = imHeight / 2.0;
+    const Matrix3x3 R = diag3x3(1.0, 1.0, 1.0);
+
+    CameraStruct cam;
+    cam.C = C;
+    cam.P = K * (R | (Point3d(0.0, 0.0, 0.0) - R * C));
+    cam.iP = R * K.inverse();
+    cam.ZVect = Point3d(0.0, 0.0, 1.0);
+    return cam;
+}
+
+/// Smooth random texture (random values every 3 pixels, linearly interpolated), shifted by disparity pixels along x
+LabImage makeTexture(int disparity)
+{
+    const int cell = 3;
+    const int maxDisparity = 32;
+    const int gridWidth = (imWidth + maxDisparity) / cell + 2;
+    const int gridHeight = imHeight / cell + 2;
+
+    std::vector<float> grid(gridWidth * gridHeight);
+    unsigned int seed = 12345u;
+    for(float& v : grid)
+    {
+        seed = seed * 1103515245u + 12345u;
+        v = (float)((seed >> 16) & 0xff);
+    }
+
+    LabImage image;
+    image.width = imWidth;
+    image.height = imHeight;
+    image.texels.resize(imWidth * imHeight);
+
+    for(int y = 0; y < imHeight; ++y)
+    {
+        for(int x = 0; x < imWidth; ++x)
+        {
+            const int gx = (x + disparity) / cell;
+            const int gy = y / cell;
+            const float fx = (float)((x + disparity) % cell) / cell;
+            const float fy = (float)(y % cell) / cell;
+            const float v = (1.0f - fy) * ((1.0f - fx) * grid[gy * gridWidth + gx] + fx * grid[gy * gridWidth + gx + 1]) +
+                            fy * ((1.0f - fx) * grid[(gy + 1) * gridWidth + gx] + fx * grid[(gy + 1) * gridWidth + gx + 1]);
+
+            LabTexel& t = image.texels[y * imWidth + x];
+            t.x = (unsigned char)v;
+            t.y = 128;
+            t.z = 128;
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_simStat)
+{
+    SimStat same;
+    SimStat constant;
+    for(int i = 0; i < 10; ++i)
+    {
+        same.update(i * 3.0, i * 3.0, 1.0);
+        constant.update(5.0, i * 3.0, 1.0);
+    }
+    BOOST_CHECK_CLOSE(same.computeWSim(), -1.0f, 1e-3);
+    // null variance
+    BOOST_CHECK_EQUAL(constant.computeWSim(), 1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_refineDepthSubPixel)
+{
+    // symmetric similarities, the middle depth
+    BOOST_CHECK_CLOSE(refineDepthSubPixel(Point3d(1.0, 2.0, 3.0), Point3d(0.0, -0.5, 0.0)), 2.0f, 1e-4);
+    // the minimum of the parabola is on the side of the best neighbor
+    BOOST_CHECK_CLOSE(refineDepthSubPixel(Point3d(1.0, 2.0, 3.0), Point3d(-0.2, -0.5, 0.0)), 1.875f, 1e-4);
+    // the middle similarity is not the minimum
+    BOOST_CHECK_EQUAL(refineDepthSubPixel(Point3d(1.0, 2.0, 3.0), Point3d(-0.8, -0.5, 0.0)), -1.0f);
+}
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_labImageSample)
+{
+    LabImage image;
+    image.width = 2;
+    image.height = 2;
+    image.texels.resize(4);
+    image.texels[0].x = 0;
+    image.texels[1].x = 100;
+    image.texels[2].x = 200;
+    image.texels[3].x = 60;
+
+    BOOST_CHECK_CLOSE(image.sample(0.0f, 0.0f).x, 0.0, 1e-4);
+    BOOST_CHECK_CLOSE(image.sample(0.5f, 0.0f).x, 50.0, 1e-4);
+    BOOST_CHECK_CLOSE(image.sample(0.0f, 0.5f).x, 100.0, 1e-4);
+    BOOST_CHECK_CLOSE(image.sample(0.5f, 0.5f).x, 90.0, 1e-4);
+    // clamped to the borders
+    BOOST_CHECK_CLOSE(image.sample(5.0f, 5.0f).x, 60.0, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_sweepPixelsToVolume)
+{
+    const CameraStruct rcCam = makeCamera(Point3d(0.0, 0.0, 0.0));
+    const CameraStruct tcCam = makeCamera(Point3d(baseline, 0.0, 0.0));
+    const int trueDisparity = (int)(focal * baseline / planeDepth);
+    const LabImage rcImage = makeTexture(0);
+    const LabImage tcImage = makeTexture(trueDisparity);
+
+    // fronto-parallel planes of the integer disparities, in ascending depth order
+    std::vector<float> depths;
+    for(int d = trueDisparity + 4; d >= trueDisparity - 4; --d)
+        depths.push_back((float)(focal * baseline / d));
+    const int trueDepthId =
+        std::distance(depths.begin(), std::find(depths.begin(), depths.end(), (float)(planeDepth)));
+
+    const int volLUX = 40;
+    const int volLUY = 16;
+    const int volDimX = 16;
+    const int volDimY = 16;
+    const int volDimZ = depths.size();
+
+    std::vector<Voxel> pixels;
+    for(int y = 0; y < volDimY; ++y)
+        for(int x = 0; x < volDimX; ++x)
+            pixels.push_back(Voxel(volLUX + x, volLUY + y, 0));
+
+    std::vector<unsigned char> volume;
+    sweepPixelsToVolume(volume, volDimX, volDimY, volDimZ, 1, volLUX, volLUY, 0, depths, pixels, volDimZ, rcCam,
+                        tcCam, rcImage, tcImage, 3, imWidth, imHeight, 15.5f, 8.0f, 0.0f);
+
+    BOOST_REQUIRE_EQUAL(volume.size(), volDimX * volDimY * volDimZ);
+    for(int y = 0; y < volDimY; ++y)
+    {
+        for(int x = 0; x < volDimX; ++x)
+        {
+            int bestZ = 0;
+            for(int z = 1; z < volDimZ; ++z)
+            {
+                if(volume[z * volDimX * volDimY + y * volDimX + x] < volume[bestZ * volDimX * volDimY + y * volDimX + x])
+                    bestZ = z;
+            }
+            BOOST_CHECK_EQUAL(bestZ, trueDepthId);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_refineDepthMap)
+{
+    const CameraStruct rcCam = makeCamera(Point3d(0.0, 0.0, 0.0));
+    const CameraStruct tcCam = makeCamera(Point3d(baseline, 0.0, 0.0));
+    const LabImage rcImage = makeTexture(0);
+    const int trueDisparity = (int)(focal * baseline / planeDepth);
+    const LabImage tcImage = makeTexture(trueDisparity);
+
+    // part of the depth map in the middle of the image, the depths are one tc pixel behind the plane
+    const int xFrom = 40;
+    const int width = 16;
+    std::vector<float> depthMap(width * imHeight);
+    std::vector<float> simMap(width * imHeight);
+    for(int y = 0; y < imHeight; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const Point3d ray = (rcCam.iP * Point2d((double)(x + xFrom), (double)y)).normalize();
+            depthMap[y * width + x] = (float)(focal * baseline / (trueDisparity - 1) / ray.z);
+        }
+    }
+
+    refineDepthMap(simMap, depthMap, width, imHeight, xFrom, rcCam, tcCam, rcImage, tcImage, imWidth, imHeight, 15, 3,
+                   15.5f, 8.0f, 0.0f, true);
+
+    for(int y = 16; y < imHeight - 16; ++y)
+    {
+        for(int x = 0; x < width; ++x)
+        {
+            const Point3d ray = (rcCam.iP * Point2d((double)(x + xFrom), (double)y)).normalize();
+            // the parabola of the sub-pixel refinement is fitted on the asymmetric depths of the tc pixel steps
+            BOOST_CHECK_CLOSE(depthMap[y * width + x], planeDepth / ray.z, 2.0);
+            BOOST_CHECK_LT(simMap[y * width + x], -0.5f);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_optimizeSimVolumeSGM)
+{
+    const int volDimX = 5;
+    const int volDimY = 5;
+    const int volDimZ = 7;
+    const int center = 2 * volDimX + 2;
+
+    // uniform rc image, the depth jumps have the highest penalty
+    LabImage rcImage;
+    rcImage.width = volDimX;
+    rcImage.height = volDimY;
+    rcImage.texels.resize(volDimX * volDimY);
+
+    // all the pixels have their best similarity at the depth 4, except a weak mismatch at the depth 1 in the center
+    std::vector<unsigned char> volume(volDimX * volDimY * volDimZ, 200);
+    for(int i = 0; i < volDimX * volDimY; ++i)
+        volume[4 * volDimX * volDimY + i] = 10;
+    volume[1 * volDimX * volDimY + center] = 100;
+    volume[4 * volDimX * volDimY + center] = 120;
+
+    optimizeSimVolumeSGM(volume, volDimX, volDimY, volDimZ, 0, 0, rcImage, 10);
+
+    for(int i = 0; i < volDimX * volDimY; ++i)
+    {
+        if((i % volDimX == 0) || (i % volDimX == volDimX - 1) || (i / volDimX == 0) || (i / volDimX == volDimY - 1))
+            continue;
+
+        int bestZ = 0;
+        for(int z = 1; z < volDimZ; ++z)
+        {
+            if(volume[z * volDimX * volDimY + i] < volume[bestZ * volDimX * volDimY + i])
+                bestZ = z;
+        }
+        BOOST_CHECK_EQUAL(bestZ, 4);
+    }
+    // the best similarity of the consistent pixels is kept
+    BOOST_CHECK_EQUAL(volume[4 * volDimX * volDimY + volDimX + 1], 10);
+}
+
+BOOST_AUTO_TEST_CASE(planeSweepingCpu_fuseDepthSimMapsGaussianKernelVoting)
+{
+    const int w = 2;
+    const int h = 1;
+    const int nSamplesHalf = 150;
+    const int nDepthsToRefine = 31;
+
+    // middle depth and pixel size
+    StaticVector<DepthSim> midDepthPixSizeMap;
+    midDepthPixSizeMap.push_back(DepthSim(10.0f, 1.0f));
+    midDepthPixSizeMap.push_back(DepthSim(-1.0f, 1.0f));
+
+    // three maps agree on the depth 10.5, one is an outlier
+    std::vector<StaticVector<DepthSim>> depthSimMaps(4);
+    for(int c = 0; c < 4; ++c)
+    {
+        depthSimMaps[c].push_back(DepthSim((c == 3) ? 9.0f : 10.5f, -1.0f));
+        depthSimMaps[c].push_back(DepthSim(10.0f, -1.0f));
+    }
+
+    std::vector<const StaticVector<DepthSim>*> dataMaps;
+    dataMaps.push_back(&midDepthPixSizeMap);
+    for(const StaticVector<DepthSim>& depthSimMap : depthSimMaps)
+        dataMaps.push_back(&depthSimMap);
+
+    StaticVector<DepthSim> fusedMap;
+    fusedMap.resize(w * h);
+    fuseDepthSimMapsGaussianKernelVoting(w, h, fusedMap, dataMaps, nSamplesHalf, nDepthsToRefine, 2.0f);
+
+    BOOST_CHECK_CLOSE(fusedMap[0].depth, 10.5f, 1e-3);
+    BOOST_CHECK_LT(fusedMap[0].sim, 0.0f);
+    // no middle depth
+    BOOST_CHECK_EQUAL(fusedMap[1].depth, -1.0f);
+    BOOST_CHECK_EQUAL(fusedMap[1].sim, 1.0f);
+}
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/feature/regionsContainer.hpp>
 
 #include <iostream>
 #include <iterator>
@@ -234,6 +235,48 @@ void convertDesc(
 }
 
 
+/**
+ * @brief Load the descriptors of a regions container file (.regions), without its features.
+ * \p DescriptorT and \p FileDescriptorT are the same as in loadDescsFromBinFile.
+ *
+ * @param[in] sfileNameContainer The regions container file name
+ * @param[out] vec_desc A vector of descriptors that stores the descriptors to load
+ * @param[in] append If true, the loaded descriptors will be appended at the end
+ * of the vector \p vec_desc
+ * @param[in] Nmax Limit the number of descriptors to load
+ *            (default value is 0 which means all descriptors).
+ */
+template<typename DescriptorT, typename FileDescriptorT = DescriptorT>
+inline void loadDescsFromContainer(
+  const std::string & sfileNameContainer,
+  std::vector<DescriptorT> & vec_desc,
+  bool append = false,
+  const int Nmax = 0)
+{
+  if(!append)
+    vec_desc.clear();
+
+  const RegionsContainerMapping mapping(sfileNameContainer);
+  const RegionsContainerHeader& header = mapping.header();
+
+  if(header.descriptorSize != sizeof(FileDescriptorT) ||
+     header.descriptorBinSize != sizeof(typename FileDescriptorT::bin_type) ||
+     header.descriptorLength != FileDescriptorT::static_size)
+    throw std::runtime_error("Can't load regions container file, '" + sfileNameContainer + "' does not match the expected descriptor type !");
+
+  const std::size_t cardDesc = (Nmax != 0) ? std::min<std::size_t>(header.count, Nmax) : header.count;
+  const std::size_t previousSize = vec_desc.size();
+  vec_desc.resize(previousSize + cardDesc);
+
+  const char* data = static_cast<const char*>(mapping.descriptors());
+  FileDescriptorT fileDescriptor;
+  for(std::size_t i = 0; i < cardDesc; ++i)
+  {
+    std::memcpy(fileDescriptor.getData(), data + i * header.descriptorSize, sizeof(FileDescriptorT));
+    convertDesc<FileDescriptorT, DescriptorT>(fileDescriptor, vec_desc[previousSize + i]);
+  }
+}
+
 /**
  * @brief It load descriptors from a given binary file (.desc). \p DescriptorT is 
  * the type of descriptor in which to store the data loaded from the file. \p FileDescriptorT is
@@ -243,7 +286,8 @@ void convertDesc(
  * stored as uchar (the default type) and we want to cast these into SIFT descriptors
  * stored in memory as floats.
  * 
- * @param[in] sfileNameDescs The file name (usually .desc)
+ * @param[in] sfileNameDescs The file name (usually .desc), the descriptors of a regions
+ *            container (.regions) are read with loadDescsFromContainer
  * @param[out] vec_desc A vector of descriptors that stores the descriptors to load
  * @param[in] append If true, the loaded descriptors will be appended at the end 
  * of the vector \p vec_desc
@@ -258,6 +302,12 @@ inline void loadDescsFromBinFile(
   bool append = false,
   const int Nmax = 0)
 {
+  if(isRegionsContainerFile(sfileNameDescs))
+  {
+    loadDescsFromContainer<DescriptorT, FileDescriptorT>(sfileNameDescs, vec_desc, append, Nmax);
+    return;
+  }
+
   if( !append ) // for compatibility
     vec_desc.clear();
 
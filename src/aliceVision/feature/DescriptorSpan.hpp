@@ -0,0 +1,101 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/feature/Regions.hpp>
+
+#include <cassert>
+#include <cstddef>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Non-owning view on a flat array of descriptors.
+ *
+ * Descriptors are stored row by row: the descriptor i starts at data() + i * dimension().
+ * The memory is owned by someone else (a Regions container, a memory-mapped file, ...)
+ * and must outlive the span.
+ */
+template<typename T>
+class DescriptorSpan
+{
+public:
+  typedef T value_type;
+  typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> MatrixT;
+  typedef Eigen::Map<const MatrixT> ConstMapT;
+
+  DescriptorSpan() = default;
+
+  DescriptorSpan(const T* data, std::size_t count, std::size_t dimension)
+    : _data(data)
+    , _count(count)
+    , _dimension(dimension)
+  {}
+
+  /// Pointer to the first value of the first descriptor
+  inline const T* data() const { return _data; }
+
+  /// Number of descriptors
+  inline std::size_t count() const { return _count; }
+
+  /// Number of values of one descriptor
+  inline std::size_t dimension() const { return _dimension; }
+
+  inline bool empty() const { return _count == 0 || _data == nullptr; }
+
+  /// Pointer to the first value of the i-th descriptor
+  inline const T* operator[](std::size_t i) const
+  {
+    assert(i < _count);
+    return _data + i * _dimension;
+  }
+
+  /**
+   * @brief Return a sub-span of the descriptors [first, first + count[
+   */
+  inline DescriptorSpan subspan(std::size_t first, std::size_t count) const
+  {
+    assert(first + count <= _count);
+    return DescriptorSpan(_data + first * _dimension, count, _dimension);
+  }
+
+  /**
+   * @brief Return a read-only Eigen row-major matrix mapped on the descriptors (no copy)
+   */
+  inline ConstMapT asMatrix() const
+  {
+    return ConstMapT(_data, _count, _dimension);
+  }
+
+private:
+  const T* _data = nullptr;
+  std::size_t _count = 0;
+  std::size_t _dimension = 0;
+};
+
+/**
+ * @brief Get a non-owning view on the descriptors of the given Regions.
+ * @note ScalarT must match the Regions descriptor type (Regions::Type_id).
+ * @param[in] regions The regions
+ * @return the descriptor span
+ */
+template<typename ScalarT>
+inline DescriptorSpan<ScalarT> getDescriptorSpan(const Regions& regions)
+{
+  if(regions.RegionCount() == 0)
+    return DescriptorSpan<ScalarT>();
+
+  assert(regions.Type_id() == typeid(ScalarT).name());
+  return DescriptorSpan<ScalarT>(reinterpret_cast<const ScalarT*>(regions.DescriptorRawData()),
+                                 regions.RegionCount(),
+                                 regions.DescriptorLength());
+}
+
+} // namespace feature
+} // namespace aliceVision
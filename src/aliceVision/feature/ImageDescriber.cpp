@@ -85,6 +85,17 @@ void ImageDescriber::Save(const Regions* regions, const std::string& sfileNameFe
   fs::rename(tmpDescsPath, sfileNameDescs);
 }
 
+void ImageDescriber::SaveContainer(const Regions* regions, const std::string& sfileNameContainer) const
+{
+  const fs::path bContainerPath = fs::path(sfileNameContainer);
+  const std::string tmpContainerPath = (bContainerPath.parent_path() / bContainerPath.stem()).string() + "." + fs::unique_path().string() + bContainerPath.extension().string();
+
+  regions->SaveContainer(tmpContainerPath);
+
+  // rename temporay filename
+  fs::rename(tmpContainerPath, sfileNameContainer);
+}
+
 std::unique_ptr<ImageDescriber> createImageDescriber(EImageDescriberType imageDescriberType)
 {
   std::unique_ptr<ImageDescriber> describerPtr;
@@ -97,6 +108,7 @@ std::unique_ptr<ImageDescriber> createImageDescriber(EImageDescriberType imageDe
     case EImageDescriberType::AKAZE:          describerPtr.reset(new ImageDescriber_AKAZE(AKAZEParams(AKAZEOptions(), feature::AKAZE_MSURF))); break;
     case EImageDescriberType::AKAZE_MLDB:     describerPtr.reset(new ImageDescriber_AKAZE(AKAZEParams(AKAZEOptions(), feature::AKAZE_MLDB))); break;
     case EImageDescriberType::AKAZE_LIOP:     describerPtr.reset(new ImageDescriber_AKAZE(AKAZEParams(AKAZEOptions(), feature::AKAZE_LIOP))); break;
+    case EImageDescriberType::AKAZE_UCHAR:    describerPtr.reset(new ImageDescriber_AKAZE(AKAZEParams(AKAZEOptions(), feature::AKAZE_MSURF_UCHAR))); break;
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
     case EImageDescriberType::CCTAG3:      describerPtr.reset(new ImageDescriber_CCTAG(3)); break;
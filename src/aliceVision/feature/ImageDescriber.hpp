@@ -61,6 +61,23 @@ std::ostream& operator<<(std::ostream& os, EImageDescriberPreset p);
  */
 std::istream& operator>>(std::istream& in, EImageDescriberPreset& p);
 
+/**
+ * @brief Wall time in seconds spent in each stage of the feature extraction,
+ *        accumulated over the described images.
+ * @note Only filled by the image describers with separate stages (vlfeat SIFT, AKAZE).
+ */
+struct ExtractionStagesTimings
+{
+  /// scale space computation
+  double pyramid = 0.0;
+  /// keypoints detection and filtering
+  double detection = 0.0;
+  /// keypoints orientation
+  double orientation = 0.0;
+  /// keypoints description
+  double description = 0.0;
+};
+
 /**
  * @brief A pure virtual class for image description computation
  */
@@ -98,6 +115,12 @@ public:
    */
   virtual std::size_t getMemoryConsumption(std::size_t width, std::size_t height) const = 0;
 
+  /**
+   * @brief Get the maximum number of regions extracted from one image
+   * @return the maximum number of regions, 0 if there is no limit
+   */
+  virtual std::size_t getMaxTotalKeypoints() const { return 0; }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -116,6 +139,12 @@ public:
    */
   virtual void setCudaPipe(int pipe) {}
 
+  /**
+   * @brief Set the CUDA device
+   * @param[in] device The CUDA device id
+   */
+  virtual void setCudaDevice(int device) {}
+
   /**
    * @brief Use a preset to control the number of detected regions
    * @param[in] preset The preset configuration
@@ -185,6 +214,30 @@ public:
   {
     regions->LoadFeatures(sfileNameFeats);
   }
+
+  // IO - one binary container file for region features and descriptors
+
+  void LoadContainer(Regions* regions,
+    const std::string& sfileNameContainer) const
+  {
+    regions->LoadContainer(sfileNameContainer);
+  }
+
+  void SaveContainer(const Regions* regions,
+    const std::string& sfileNameContainer) const;
+
+  /**
+   * @brief Accumulate the wall time of the extraction stages in the given timings
+   * @param[in] timings The timings to fill, nullptr to disable the stages timing
+   */
+  void setStagesTimings(ExtractionStagesTimings* timings)
+  {
+    _stagesTimings = timings;
+  }
+
+protected:
+  /// optional extraction stages timings, see setStagesTimings
+  ExtractionStagesTimings* _stagesTimings = nullptr;
 };
 
 /**
@@ -11,12 +11,14 @@
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/feature/PointFeature.hpp>
 #include <aliceVision/feature/Descriptor.hpp>
+#include <aliceVision/feature/regionsContainer.hpp>
 #include <aliceVision/matching/metric.hpp>
 
 #include <string>
 #include <cstddef>
 #include <typeinfo>
 #include <memory>
+#include <stdexcept>
 
 
 namespace aliceVision {
@@ -66,6 +68,25 @@ public:
   virtual void LoadFeatures(
     const std::string& sfileNameFeats) = 0;
 
+  //--
+  // IO - one binary container file for region features and descriptors
+  //--
+
+  virtual void LoadContainer(const std::string& sfileNameContainer) = 0;
+
+  virtual void SaveContainer(const std::string& sfileNameContainer) const = 0;
+
+  /**
+   * @brief Read the features from a binary container file and keep the descriptors
+   *        in the memory-mapped file: the OS page cache is the only copy of the descriptors.
+   * @note Mapped descriptors are read-only and only accessible through DescriptorRawData(),
+   *       any mutable access to the descriptors makes an in-memory copy.
+   */
+  virtual void MapContainer(const std::string& sfileNameContainer) = 0;
+
+  /// Return true if the descriptors are stored in a memory-mapped file
+  virtual bool isDescriptorsMapped() const = 0;
+
   //--
   //- Basic description of a descriptor [Type, Length]
   //--
@@ -83,10 +104,17 @@ public:
   /// Return the number of defined regions
   virtual std::size_t RegionCount() const = 0;
 
+  /// Return the memory used by the features and the descriptors (in memory or memory-mapped) in bytes
+  virtual std::size_t MemorySize() const = 0;
+
+  /// Move all the region positions by the given offset
+  virtual void translateRegions(const Vec2f& offset) = 0;
+
   /**
    * @brief Return a blind pointer to the container of the descriptors array.
    *
    * @note: Descriptors are always stored as an std::vector<DescType>.
+   * @warning: Not available if the descriptors are memory-mapped.
    */
   virtual const void* blindDescriptors() const = 0;
 
@@ -108,6 +136,13 @@ public:
   /// Add the Inth region to another Region container
   virtual void CopyRegion(std::size_t i, Regions *) const = 0;
 
+  /// Set the Jth region of another Region container to the Inth region,
+  /// the output regions must be allocated (see resizeRegions) and in memory
+  virtual void CopyRegion(std::size_t i, Regions *, std::size_t j) const = 0;
+
+  /// Resize the features and the descriptors (in memory) to the given number of regions
+  virtual void resizeRegions(std::size_t nbRegions) = 0;
+
   virtual Regions * EmptyClone() const = 0;
 
   virtual std::unique_ptr<Regions> createFilteredRegions(
@@ -152,6 +187,12 @@ public:
   /// Return the number of defined regions
   std::size_t RegionCount() const {return _vec_feats.size();}
 
+  void translateRegions(const Vec2f& offset)
+  {
+    for(FeatureT& feat : _vec_feats)
+      feat.coords() += offset;
+  }
+
   /// Mutable and non-mutable FeatureT getters.
   inline std::vector<FeatureT> & Features() { return _vec_feats; }
   inline const std::vector<FeatureT> & Features() const { return _vec_feats; }
@@ -203,6 +244,7 @@ public:
 
 protected:
   std::vector<DescriptorT> _vec_descs; // region descriptions
+  std::shared_ptr<const RegionsContainerMapping> _descsMapping; // memory-mapped region descriptions
 
 public:
   std::string Type_id() const override {return typeid(T).name();}
@@ -221,6 +263,7 @@ public:
     const std::string& sfileNameFeats,
     const std::string& sfileNameDescs) override
   {
+    _descsMapping.reset();
     loadFeatsFromFile(sfileNameFeats, this->_vec_feats);
     loadDescsFromBinFile(sfileNameDescs, _vec_descs);
   }
@@ -231,40 +274,104 @@ public:
     const std::string& sfileNameDescs) const override
   {
     saveFeatsToFile(sfileNameFeats, this->_vec_feats);
-    saveDescsToBinFile(sfileNameDescs, _vec_descs);
+    SaveDesc(sfileNameDescs);
   }
 
   void SaveDesc(const std::string& sfileNameDescs) const override
   {
+    if(isDescriptorsMapped())
+    {
+      const std::vector<DescriptorT> descs(descriptorsData(), descriptorsData() + this->_vec_feats.size());
+      saveDescsToBinFile(sfileNameDescs, descs);
+      return;
+    }
     saveDescsToBinFile(sfileNameDescs, _vec_descs);
   }
 
-  /// Mutable and non-mutable DescriptorT getters.
-  inline std::vector<DescriptorT> & Descriptors() { return _vec_descs; }
-  inline const std::vector<DescriptorT> & Descriptors() const { return _vec_descs; }
+  /// Read from a binary container file the regions and their corresponding descriptors.
+  void LoadContainer(const std::string& sfileNameContainer) override
+  {
+    _descsMapping.reset();
+    loadRegionsFromContainer(sfileNameContainer, this->_vec_feats, _vec_descs);
+  }
+
+  /// Export in one binary container file the regions and their corresponding descriptors.
+  void SaveContainer(const std::string& sfileNameContainer) const override
+  {
+    saveRegionsToContainer(sfileNameContainer, this->_vec_feats, descriptorsData(), this->_vec_feats.size());
+  }
 
-  inline const void* blindDescriptors() const override { return &_vec_descs; }
+  /// Read from a binary container file the regions, the descriptors stay in the memory-mapped file.
+  void MapContainer(const std::string& sfileNameContainer) override
+  {
+    _vec_descs.clear();
+    _vec_descs.shrink_to_fit();
+    _descsMapping = mapRegionsFromContainer<FeatT, DescriptorT>(sfileNameContainer, this->_vec_feats);
+  }
 
-  inline const void* DescriptorRawData() const override { return &_vec_descs[0];}
+  inline bool isDescriptorsMapped() const override { return _descsMapping != nullptr; }
 
-  inline void clearDescriptors() override { _vec_descs.clear(); }
+  /**
+   * @brief Mutable DescriptorT getter.
+   * @note Memory-mapped descriptors are copied in memory first.
+   */
+  inline std::vector<DescriptorT> & Descriptors()
+  {
+    materializeDescriptors();
+    return _vec_descs;
+  }
+
+  /**
+   * @brief Non-mutable DescriptorT getter.
+   * @warning Not available if the descriptors are memory-mapped, use descriptor(i) or DescriptorRawData().
+   */
+  inline const std::vector<DescriptorT> & Descriptors() const
+  {
+    if(isDescriptorsMapped())
+      throw std::logic_error("Regions descriptors are memory-mapped and can't be accessed as a std::vector.");
+    return _vec_descs;
+  }
+
+  /// Non-mutable access to the i-th descriptor, valid for in-memory and memory-mapped descriptors.
+  inline const DescriptorT& descriptor(std::size_t i) const
+  {
+    assert(i < this->_vec_feats.size());
+    return descriptorsData()[i];
+  }
+
+  inline const void* blindDescriptors() const override { return &Descriptors(); }
+
+  inline const void* DescriptorRawData() const override { return descriptorsData(); }
+
+  inline void clearDescriptors() override
+  {
+    DescsT().swap(_vec_descs);
+    _descsMapping.reset();
+  }
+
+  std::size_t MemorySize() const override
+  {
+    const std::size_t nbDescs = isDescriptorsMapped() ? this->_vec_feats.size() : _vec_descs.size();
+    return this->_vec_feats.size() * sizeof(FeatT) + nbDescs * sizeof(DescriptorT);
+  }
 
   inline void swap(This& other)
   {
     this->_vec_feats.swap(other._vec_feats);
     _vec_descs.swap(other._vec_descs);
+    _descsMapping.swap(other._descsMapping);
   }
 
   // Return the distance between two descriptors
   double SquaredDescriptorDistance(std::size_t i, const Regions * genericRegions, std::size_t j) const override
   {
-    assert(i < this->_vec_descs.size());
+    assert(i < this->_vec_feats.size());
     assert(genericRegions);
     assert(j < genericRegions->RegionCount());
 
     const This * regionsT = dynamic_cast<const This*>(genericRegions);
     static typename SquaredMetric<T, regionType>::Metric metric;
-    return metric(this->_vec_descs[i].getData(), regionsT->_vec_descs[j].getData(), DescriptorT::static_size);
+    return metric(descriptor(i).getData(), regionsT->descriptor(j).getData(), DescriptorT::static_size);
   }
 
   /**
@@ -274,9 +381,32 @@ public:
    */
   void CopyRegion(std::size_t i, Regions * outRegionContainer) const override
   {
-    assert(i < this->_vec_feats.size() && i < this->_vec_descs.size());
+    assert(i < this->_vec_feats.size());
     static_cast<This*>(outRegionContainer)->_vec_feats.push_back(this->_vec_feats[i]);
-    static_cast<This*>(outRegionContainer)->_vec_descs.push_back(this->_vec_descs[i]);
+    static_cast<This*>(outRegionContainer)->Descriptors().push_back(descriptor(i));
+  }
+
+  /**
+   * @brief Set the Jth region of another Region container to the Inth region,
+   * the regions can be copied in parallel to distinct indexes.
+   * @param[in] i: index of the region to copy
+   * @param[out] outRegionContainer: the output region group, with at least j+1 regions in memory
+   * @param[in] j: index of the region in the output region group
+   */
+  void CopyRegion(std::size_t i, Regions * outRegionContainer, std::size_t j) const override
+  {
+    assert(i < this->_vec_feats.size());
+    This* outRegions = static_cast<This*>(outRegionContainer);
+    assert(!outRegions->isDescriptorsMapped());
+    assert(j < outRegions->_vec_feats.size() && j < outRegions->_vec_descs.size());
+    outRegions->_vec_feats[j] = this->_vec_feats[i];
+    outRegions->_vec_descs[j] = descriptor(i);
+  }
+
+  void resizeRegions(std::size_t nbRegions) override
+  {
+    this->_vec_feats.resize(nbRegions);
+    Descriptors().resize(nbRegions);
   }
 
   /**
@@ -302,7 +432,7 @@ public:
     {
       const FeatureInImage & feat = featuresInImage[i];
       regionsPtr->Features().push_back(this->_vec_feats[feat._featureIndex]);
-      regionsPtr->Descriptors().push_back(this->_vec_descs[feat._featureIndex]);
+      regionsPtr->Descriptors().push_back(descriptor(feat._featureIndex));
 
       // This assert should be valid in theory, but in the context of CameraLocalization
       // we can have the same 2D feature associated to different 3D points (2 in practice).
@@ -315,6 +445,26 @@ public:
     }
     return regions;
   }
+
+protected:
+
+  /// Pointer to the first descriptor (in memory or memory-mapped)
+  inline const DescriptorT* descriptorsData() const
+  {
+    if(isDescriptorsMapped())
+      return static_cast<const DescriptorT*>(_descsMapping->descriptors());
+    return _vec_descs.data();
+  }
+
+  /// Copy memory-mapped descriptors in memory and release the file mapping
+  inline void materializeDescriptors()
+  {
+    if(!isDescriptorsMapped())
+      return;
+    const DescriptorT* data = descriptorsData();
+    _vec_descs.assign(data, data + this->_vec_feats.size());
+    _descsMapping.reset();
+  }
 };
 
 
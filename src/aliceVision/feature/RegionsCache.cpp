@@ -0,0 +1,87 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "RegionsCache.hpp"
+
+namespace aliceVision {
+namespace feature {
+
+RegionsCache::RegionsCache(std::size_t capacity, const Loader& loader)
+  : _capacity(capacity)
+  , _loader(loader)
+{}
+
+std::shared_ptr<const Regions> RegionsCache::getRegions(IndexT viewId, EImageDescriberType descType)
+{
+  const Key key(viewId, descType);
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _entries.find(key);
+    if(it != _entries.end())
+    {
+      _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+      ++_nbHits;
+      return it->second.regions;
+    }
+  }
+
+  // load without holding the lock, so several views can be loaded concurrently
+  std::shared_ptr<const Regions> regions(_loader(viewId, descType));
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  // loaded by another thread in the meantime
+  const auto it = _entries.find(key);
+  if(it != _entries.end())
+  {
+    _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+    return it->second.regions;
+  }
+
+  _lru.push_front(key);
+  Entry& entry = _entries[key];
+  entry.regions = regions;
+  entry.size = regions->MemorySize();
+  entry.lruIt = _lru.begin();
+  _used += entry.size;
+  ++_nbLoads;
+
+  evict();
+  return regions;
+}
+
+std::size_t RegionsCache::usedMemory() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _used;
+}
+
+std::size_t RegionsCache::nbLoads() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbLoads;
+}
+
+std::size_t RegionsCache::nbHits() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbHits;
+}
+
+void RegionsCache::evict()
+{
+  while(_used > _capacity && _lru.size() > 1)
+  {
+    const auto it = _entries.find(_lru.back());
+    _used -= it->second.size;
+    _entries.erase(it);
+    _lru.pop_back();
+  }
+}
+
+} // namespace feature
+} // namespace aliceVision
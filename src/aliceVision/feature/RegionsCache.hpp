@@ -0,0 +1,99 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/Regions.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Thread safe cache of the regions of each view, with a memory budget.
+ *
+ * Regions are loaded on demand and the least recently used ones are evicted
+ * once the memory budget is exceeded, so the memory depends on the budget
+ * and not on the number of views.
+ * Returned regions stay valid as long as the caller keeps the shared pointer,
+ * even if they are evicted in the meantime.
+ * The most recently used regions are never evicted, even if they are bigger than the whole budget.
+ */
+class RegionsCache
+{
+public:
+
+  /// Load the regions of a view for a describer type, throw if the regions can't be loaded
+  using Loader = std::function<std::unique_ptr<Regions>(IndexT viewId, EImageDescriberType descType)>;
+
+  /**
+   * @brief Build a regions cache
+   * @param[in] capacity The memory budget (in bytes)
+   * @param[in] loader The regions loader
+   */
+  RegionsCache(std::size_t capacity, const Loader& loader);
+
+  RegionsCache(const RegionsCache&) = delete;
+  RegionsCache& operator=(const RegionsCache&) = delete;
+
+  /**
+   * @brief Get the regions of a view, load them if they are not in the cache
+   * @param[in] viewId The view id
+   * @param[in] descType The describer type
+   * @return the regions
+   */
+  std::shared_ptr<const Regions> getRegions(IndexT viewId, EImageDescriberType descType);
+
+  std::size_t capacity() const
+  {
+    return _capacity;
+  }
+
+  /// Memory used by the regions in the cache (in bytes)
+  std::size_t usedMemory() const;
+
+  /// Number of regions loaded since the creation of the cache
+  std::size_t nbLoads() const;
+
+  /// Number of requests served from the cache
+  std::size_t nbHits() const;
+
+private:
+  using Key = std::pair<IndexT, EImageDescriberType>;
+
+  struct Entry
+  {
+    std::shared_ptr<const Regions> regions;
+    std::size_t size;
+    /// position in the LRU list
+    std::list<Key>::iterator lruIt;
+  };
+
+  /// Evict the least recently used regions until the budget is respected
+  void evict();
+
+  const std::size_t _capacity;
+  const Loader _loader;
+  std::map<Key, Entry> _entries;
+  /// keys from the most to the least recently used
+  std::list<Key> _lru;
+  std::size_t _used = 0;
+  std::size_t _nbLoads = 0;
+  std::size_t _nbHits = 0;
+  mutable std::mutex _mutex;
+};
+
+} // namespace feature
+} // namespace aliceVision
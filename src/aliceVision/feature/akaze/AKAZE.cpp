@@ -176,12 +176,12 @@ void computeAKAZESlice(const image::Image<float>& src,
 
     // compute diffusion coefficient
     image::Image<float> & diff = smoothed; // diffusivity image (reuse existing memory)
-    image::ImagePeronaMalikG2DiffusionCoef(Lx, Ly, contrastFactor, diff) ;
+    image::ImagePeronaMalikG2DiffusionCoefTiled(Lx, Ly, contrastFactor, diff) ;
 
     // compute FED cycles
     std::vector<float> tau ;
     image::FEDCycleTimings(total_cycle_time, 0.25f, tau);
-    image::ImageFEDCycle(in, diff, tau);
+    image::ImageFEDCycleTiled(in, diff, tau);
     Li = in ; // evolution image
   }
 
@@ -7,6 +7,8 @@
 
 #include "ImageDescriber_AKAZE.hpp"
 
+#include <aliceVision/system/Timer.hpp>
+
 namespace aliceVision {
 namespace feature {
 
@@ -18,6 +20,7 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
 {
   _params.options.descFactor =
     (_params.akazeDescriptorType == AKAZE_MSURF ||
+     _params.akazeDescriptorType == AKAZE_MSURF_UCHAR ||
      _params.akazeDescriptorType == AKAZE_LIOP) ? 10.f * sqrtf(2.f)
     : 11.f * sqrtf(2.f); // MLDB
 
@@ -25,12 +28,47 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
   std::vector<AKAZEKeypoint> keypoints;
   keypoints.reserve(_params.options.maxTotalKeypoints * 2);
 
+  system::Timer timer;
+
   AKAZE akaze(image, _params.options);
   akaze.computeScaleSpace();
+
+  if(_stagesTimings)
+    _stagesTimings->pyramid += timer.elapsed();
+
+  timer.reset();
   akaze.featureDetection(keypoints);
   akaze.subpixelRefinement(keypoints);
   akaze.gridFiltering(keypoints);
 
+  if(_stagesTimings)
+    _stagesTimings->detection += timer.elapsed();
+
+  // keypoints orientation, common to all the descriptor types
+  timer.reset();
+
+#pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(keypoints.size()); ++i)
+  {
+    AKAZEKeypoint& point = keypoints[i];
+
+    // masked keypoints are not described
+    if(mask && (*mask)(point.y, point.x) > 0)
+      continue;
+
+    if(_isOriented)
+    {
+      const AKAZE::TEvolution& cur_slice = akaze.getSlices()[point.class_id];
+      akaze.computeMainOrientation(point, cur_slice.Lx, cur_slice.Ly);
+    }
+    else
+      point.angle = 0.0f;
+  }
+
+  if(_stagesTimings)
+    _stagesTimings->orientation += timer.elapsed();
+
+  timer.reset();
   allocate(regions);
 
   switch(_params.akazeDescriptorType)
@@ -45,7 +83,7 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
 #pragma omp parallel for
       for(int i = 0; i < static_cast<int>(keypoints.size()); ++i)
       {
-        AKAZEKeypoint point = keypoints.at(i);
+        const AKAZEKeypoint& point = keypoints.at(i);
 
         // feature masking
         if(mask)
@@ -57,11 +95,6 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
 
         const AKAZE::TEvolution& cur_slice = akaze.getSlices()[point.class_id];
 
-        if(_isOriented)
-          akaze.computeMainOrientation(point, cur_slice.Lx, cur_slice.Ly);
-        else
-          point.angle = 0.0f;
-
         regionsCasted->Features()[i] =
           SIOPointFeature(point.x, point.y, point.size, point.angle);
 
@@ -71,20 +104,17 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
       }
     }
     break;
-    case AKAZE_LIOP:
+    case AKAZE_MSURF_UCHAR:
     {
       // build alias to cached data
-      AKAZE_Liop_Regions* regionsCasted = dynamic_cast<AKAZE_Liop_Regions*>(regions.get());
+      AKAZE_Uchar_Regions* regionsCasted = dynamic_cast<AKAZE_Uchar_Regions*>(regions.get());
       regionsCasted->Features().resize(keypoints.size());
       regionsCasted->Descriptors().resize(keypoints.size());
 
-      // init LIOP extractor
-      DescriptorExtractor_LIOP liop_extractor;
-
 #pragma omp parallel for
       for(int i = 0; i < static_cast<int>(keypoints.size()); ++i)
       {
-        AKAZEKeypoint point = keypoints[i];
+        const AKAZEKeypoint& point = keypoints.at(i);
 
         // feature masking
         if(mask)
@@ -96,23 +126,53 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
 
         const AKAZE::TEvolution& cur_slice = akaze.getSlices()[point.class_id];
 
-        if(_isOriented)
-          akaze.computeMainOrientation(point, cur_slice.Lx, cur_slice.Ly);
-        else
-          point.angle = 0.0f;
-
         regionsCasted->Features()[i] =
           SIOPointFeature(point.x, point.y, point.size, point.angle);
 
-        // compute LIOP descriptor (do not need rotation computation, since
-        // LIOP descriptor is rotation invariant).
-        // rescale for LIOP patch extraction
-        const SIOPointFeature fp = SIOPointFeature(point.x, point.y, point.size/2.0, point.angle);
+        ComputeMSURFDescriptor(cur_slice.Lx, cur_slice.Ly, point.octave,
+          regionsCasted->Features()[i],
+          regionsCasted->Descriptors()[i]);
+      }
+    }
+    break;
+    case AKAZE_LIOP:
+    {
+      // build alias to cached data
+      AKAZE_Liop_Regions* regionsCasted = dynamic_cast<AKAZE_Liop_Regions*>(regions.get());
+      regionsCasted->Features().resize(keypoints.size());
+      regionsCasted->Descriptors().resize(keypoints.size());
+
+#pragma omp parallel
+      {
+        // the LIOP extractor holds the patch buffers, one extractor per thread
+        DescriptorExtractor_LIOP liop_extractor;
 
-        float desc[144];
-        liop_extractor.extract(image, fp, desc);
-        for(int j=0; j < 144; ++j)
-          regionsCasted->Descriptors()[i][j] = static_cast<unsigned char>(desc[j] * 255.f + .5f);
+#pragma omp for
+        for(int i = 0; i < static_cast<int>(keypoints.size()); ++i)
+        {
+          const AKAZEKeypoint& point = keypoints[i];
+
+          // feature masking
+          if(mask)
+          {
+            const image::Image<unsigned char>& maskIma = *mask;
+            if(maskIma(point.y, point.x) > 0)
+              continue;
+          }
+
+          regionsCasted->Features()[i] =
+            SIOPointFeature(point.x, point.y, point.size, point.angle);
+
+          // compute LIOP descriptor (do not need rotation computation, since
+          // LIOP descriptor is rotation invariant).
+          // rescale for LIOP patch extraction
+          const SIOPointFeature fp = SIOPointFeature(point.x, point.y, point.size/2.0, point.angle);
+
+          float desc[144];
+          liop_extractor.extract(image, fp, desc);
+          for(int j=0; j < 144; ++j)
+            regionsCasted->Descriptors()[i][j] = static_cast<unsigned char>(desc[j] * 255.f + .5f);
+        }
       }
     }
     break;
@@ -126,7 +186,7 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
 #pragma omp parallel for
       for (int i = 0; i < static_cast<int>(keypoints.size()); ++i)
       {
-        AKAZEKeypoint point = keypoints[i];
+        const AKAZEKeypoint& point = keypoints[i];
 
         // Feature masking
         if(mask)
@@ -138,11 +198,6 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
 
         const AKAZE::TEvolution& cur_slice = akaze.getSlices()[point.class_id];
 
-        if(_isOriented)
-          akaze.computeMainOrientation(point, cur_slice.Lx, cur_slice.Ly);
-        else
-          point.angle = 0.0f;
-
         regionsCasted->Features()[i] = SIOPointFeature(point.x, point.y, point.size, point.angle);
 
         // compute MLDB descriptor
@@ -164,6 +219,10 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
     }
     break;
   }
+
+  if(_stagesTimings)
+    _stagesTimings->description += timer.elapsed();
+
   return true;
 }
 
@@ -23,7 +23,9 @@ enum EAKAZE_DESCRIPTOR
 {
   AKAZE_MSURF,
   AKAZE_LIOP,
-  AKAZE_MLDB
+  AKAZE_MLDB,
+  /// MSURF descriptor quantized in 8 bits
+  AKAZE_MSURF_UCHAR
 };
 
 struct AKAZEParams
@@ -76,6 +78,7 @@ public:
       case AKAZE_MSURF: return EImageDescriberType::AKAZE;
       case AKAZE_LIOP:  return EImageDescriberType::AKAZE_LIOP;
       case AKAZE_MLDB:  return EImageDescriberType::AKAZE_MLDB;
+      case AKAZE_MSURF_UCHAR: return EImageDescriberType::AKAZE_UCHAR;
     }
     throw std::logic_error("Unknown AKAZE type.");
   }
@@ -101,6 +104,15 @@ public:
     return 4 * memoryConsuption + (3 * width * height * sizeof(float)) + 1.5 * std::pow(2,30); // add arbitrary 1.5 GB
   }
 
+  /**
+   * @brief Get the maximum number of regions extracted from one image
+   * @return the maximum number of regions, 0 if there is no limit
+   */
+  std::size_t getMaxTotalKeypoints() const override
+  {
+    return _params.options.maxTotalKeypoints;
+  }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -173,6 +185,7 @@ public:
       case AKAZE_MSURF: regions.reset(new AKAZE_Float_Regions); break;
       case AKAZE_LIOP:  regions.reset(new AKAZE_Liop_Regions);  break;
       case AKAZE_MLDB:  regions.reset(new AKAZE_BinaryRegions); break;
+      case AKAZE_MSURF_UCHAR: regions.reset(new AKAZE_Uchar_Regions); break;
     }
   }
 
@@ -14,64 +14,85 @@ namespace aliceVision {
 namespace feature {
 
 DescriptorExtractor_LIOP::DescriptorExtractor_LIOP()
+  : _samplePatch(_outPatchWidth, _outPatchWidth, true, 0)
+  , _outPatch(_outPatchWidth, _outPatchWidth, true, 0)
+  , _flagPatch(_outPatchWidth, _outPatchWidth, true, 0)
 {
   GeneratePatternMap( m_LiopPatternMap, m_LiopPosWeight, _liopNum);
-}
 
-struct Pixel{
-  float x, y; // position
-  float f_gray; // color value
-  float weight;
-  int l_pattern;
-};
+  // direct lookup table of the patterns, keys are small integers
+  _liopPatternLut.assign(m_LiopPatternMap.rbegin()->first + 1, 255);
+  for(const auto& pattern : m_LiopPatternMap)
+    _liopPatternLut[pattern.first] = pattern.second;
 
-inline bool fGrayComp(const Pixel & p1, const Pixel & p2)
-{
-  return p1.f_gray < p2.f_gray;
-}
+  // The patch is always rescaled to the same size, so the position of the LIOP
+  // neighbours of each pixel and their bilinear weights do not depend on the keypoint.
+  const int inRadius = _scalePatchWidth / 2;
+  const float inRadius2 = float(inRadius*inRadius);
+  const int outRadius = _outPatchWidth / 2;
 
-bool BilinearInterpolation_BorderCheck(
-  float& val,
-  float x, float y,
-  const image::Image<float> & image,
-  const image::Image<unsigned char> & flagImage)
-{
-  val = 0.0f;
-  if(!(x >= 0 && y >= 0 && x<=image.Width()-1 && y<=image.Height()-1))
-    return false;
+  const int lsRadius = 6;
+  const float theta = 2.0f*M_PI/(float)_liopNum;
 
-  const int x1 = (int)x;
-  const int y1 = (int)y;
+  _samplings.reserve(_maxPixelNum);
+  _pixels.reserve(_maxPixelNum);
 
-  int x2, y2;
-  if( x1 == image.Width()-1)
-    x2  = x1;
-  else
-    x2 = x1+1;
+  for (int y=-inRadius; y<=inRadius; ++y)
+  {
+    for (int x=-inRadius; x<=inRadius; ++x)
+    {
+      float dis2 = (float)(x*x + y*y);
+      if(dis2 > inRadius2)
+        continue;
 
-  if(y1 == image.Height()-1 )
-    y2 = y1;
-  else
-    y2 = y1+1;
+      const float nDirX = static_cast<float>(x);
+      const float nDirY = static_cast<float>(y);
+      float nOri = atan2(nDirY, nDirX);
+      if (fabs(nOri - M_PI) < FLT_EPSILON)	//[-M_PI, M_PI)
+      {
+        nOri = static_cast<float>(-M_PI);
+      }
 
-  const int step = image.Width();
-  const float* data = image.data();
+      LiopSampling sampling;
+      sampling.x = x;
+      sampling.y = y;
+      sampling.center = (y+outRadius)*_outPatchWidth + x+outRadius;
 
-  const int flag_step = flagImage.Width();
-  const unsigned char* flag_data = flagImage.data();
+      bool isInBound = true;
+      for (int k=0; k<_liopNum; k++)
+      {
+        const float deltaX = lsRadius * cos(nOri+k*theta);
+        const float deltaY = lsRadius * sin(nOri+k*theta);
 
-  if(flag_data[y1*flag_step+x1] == 0 ||
-     flag_data[y1*flag_step+x2] == 0 ||
-     flag_data[y2*flag_step+x1] == 0 ||
-     flag_data[y2*flag_step+x2] == 0)
-    return false;
+        const float sampleX = x+deltaX+outRadius;
+        const float sampleY = y+deltaY+outRadius;
 
-  val =
-    (x2 - x) * (y2 - y) * data[y1*step+x1] +
-    (x - x1) * (y2 - y) * data[y1*step+x2] +
-    (x2 - x) * (y - y1) * data[y2*step+x1] +
-    (x - x1) * (y - y1) * data[y2*step+x2];
-  return true;
+        if(!(sampleX >= 0 && sampleY >= 0 && sampleX <= _outPatchWidth-1 && sampleY <= _outPatchWidth-1))
+        {
+          isInBound = false;
+          break;
+        }
+
+        const int x1 = (int)sampleX;
+        const int y1 = (int)sampleY;
+        const int x2 = (x1 == _outPatchWidth-1) ? x1 : x1+1;
+        const int y2 = (y1 == _outPatchWidth-1) ? y1 : y1+1;
+
+        LiopNeighbour& neighbour = sampling.neighbours[k];
+        neighbour.corners[0] = y1*_outPatchWidth+x1;
+        neighbour.corners[1] = y1*_outPatchWidth+x2;
+        neighbour.corners[2] = y2*_outPatchWidth+x1;
+        neighbour.corners[3] = y2*_outPatchWidth+x2;
+        neighbour.weights[0] = (x2 - sampleX) * (y2 - sampleY);
+        neighbour.weights[1] = (sampleX - x1) * (y2 - sampleY);
+        neighbour.weights[2] = (x2 - sampleX) * (sampleY - y1);
+        neighbour.weights[3] = (sampleX - x1) * (sampleY - y1);
+      }
+
+      if(isInBound)
+        _samplings.push_back(sampling);
+    }
+  }
 }
 
 //non descend
@@ -158,90 +179,81 @@ void DescriptorExtractor_LIOP::CreateLIOP_GOrder(
   const image::Image<float> & outPatch,
   const image::Image<unsigned char> & flagPatch,
   const int inRadius,
-  float desc[144]) const
+  float desc[144])
 {
+  // the precomputed samplings only match the extracted patch geometry
+  assert(outPatch.Width() == _outPatchWidth && outPatch.Height() == _outPatchWidth);
+  assert(flagPatch.Width() == _outPatchWidth && flagPatch.Height() == _outPatchWidth);
+  assert(inRadius == _scalePatchWidth / 2);
+
   const float* out_data = outPatch.data();
-  const int out_step = outPatch.Width();
   const unsigned char* flag_data = flagPatch.data();
-  const int flag_step = flagPatch.Width();
-
-  const float inRadius2 = float(inRadius*inRadius);
-  const int outRadius = outPatch.Width() / 2;
-
-  const int lsRadius = 6;
-  const float theta = 2.0f*M_PI/(float)_liopNum;
 
-  Pixel pixel[_maxPixelNum];
-  int pixelCount = 0;
   int idx[_maxSampleNum];
   float dst[_maxSampleNum];
   float src[_maxSampleNum];
 
-  for (int y=-inRadius; y<=inRadius; ++y)
+  _pixels.clear();
+
+  for(const LiopSampling& sampling : _samplings)
   {
-    for (int x=-inRadius; x<=inRadius; ++x)
-    {
-      float dis2 = (float)(x*x + y*y);
-      if(dis2 > inRadius2)
-        continue;
+    if(flag_data[sampling.center] == 0)
+      continue;
 
-      const float cur_gray = out_data [(y+outRadius)*out_step +x+outRadius];
-      const unsigned char cur_flag = flag_data[(y+outRadius)*flag_step+x+outRadius];
-      if (cur_flag == 0)
-        continue;
+    bool isInBound = true;
+    for (int k=0; k<_liopNum; k++)
+    {
+      const LiopNeighbour& neighbour = sampling.neighbours[k];
 
-      const float nDirX = static_cast<float>(x);
-      const float nDirY = static_cast<float>(y);
-      float nOri = atan2(nDirY, nDirX);
-      if (fabs(nOri - M_PI) < FLT_EPSILON)	//[-M_PI, M_PI)
+      if(flag_data[neighbour.corners[0]] == 0 ||
+         flag_data[neighbour.corners[1]] == 0 ||
+         flag_data[neighbour.corners[2]] == 0 ||
+         flag_data[neighbour.corners[3]] == 0)
       {
-        nOri = static_cast<float>(-M_PI);
+        isInBound = false;
+        break;
       }
 
-      bool isInBound = true;
-      for (int k=0; k<_liopNum; k++)
-      {
-        const float deltaX = lsRadius * cos(nOri+k*theta);
-        const float deltaY = lsRadius * sin(nOri+k*theta);
-
-        const float sampleX = x+deltaX+outRadius;
-        const float sampleY = y+deltaY+outRadius;
-        float gray;
+      src[k] =
+        neighbour.weights[0] * out_data[neighbour.corners[0]] +
+        neighbour.weights[1] * out_data[neighbour.corners[1]] +
+        neighbour.weights[2] * out_data[neighbour.corners[2]] +
+        neighbour.weights[3] * out_data[neighbour.corners[3]];
+    }
 
-        if (!BilinearInterpolation_BorderCheck(gray, sampleX, sampleY, outPatch, flagPatch))
-        {
-          isInBound = false;
-          break;
-        }
-        src[k] = gray;
-      }
+    if (!isInBound)
+    {
+      continue;
+    }
 
-      if (!isInBound)
-      {
-        continue;
-      }
+    int key = 0;
+    SortGray(dst, idx, src, _liopNum);
+    for (int k=0; k<_liopNum; ++k)
+    {
+      key += (idx[k]+1)* m_LiopPosWeight[_liopNum-k-1];
+    }
 
-      int key = 0;
-      SortGray(dst, idx, src, _liopNum);
-      for (int k=0; k<_liopNum; ++k)
-      {
-        key += (idx[k]+1)* m_LiopPosWeight[_liopNum-k-1];
-      }
-      std::map<int, unsigned char>::const_iterator iter = m_LiopPatternMap.find(key);
-      if (iter != m_LiopPatternMap.end())
-      {
-        Pixel pix;
-        pix.x = x;
-        pix.y = y;
-        pix.f_gray = cur_gray;
-        pix.weight = 1;
-        pix.l_pattern = iter->second;
-        pixel[pixelCount++] = pix;
-      }
+    const unsigned char pattern = _liopPatternLut[key];
+    if (pattern != 255)
+    {
+      LiopPixel pix;
+      pix.x = sampling.x;
+      pix.y = sampling.y;
+      pix.f_gray = out_data[sampling.center];
+      pix.weight = 1;
+      pix.l_pattern = pattern;
+      _pixels.push_back(pix);
     }
   }
 
-  std::sort(pixel, pixel+pixelCount, fGrayComp);	//sort by gray
+  //sort by gray
+  std::sort(_pixels.begin(), _pixels.end(), [](const LiopPixel& p1, const LiopPixel& p2)
+  {
+    return p1.f_gray < p2.f_gray;
+  });
+
+  const int pixelCount = static_cast<int>(_pixels.size());
+  const std::vector<LiopPixel>& pixel = _pixels;
 
   const int l_patternWidth = _liopNum == 3 ? 6 : 24;
   const int dim = l_patternWidth*_regionNum;
@@ -293,21 +305,18 @@ void DescriptorExtractor_LIOP::extract(
   memset(desc, 0, sizeof(float)*144);
 
   //a. extract the local patch
-  const int scalePatchWidth = 31;
-
-  const int outPatchWidth = scalePatchWidth+6;
-  const int outRadius = outPatchWidth/2;
+  const int outRadius = _outPatchWidth/2;
   const int outRadius2 = outRadius*outRadius;
   const float scale = feat.scale();
 
-  image::Image<float> outPatch(outPatchWidth,outPatchWidth, true, 0);
-  image::Image<unsigned char> flagPatch(outPatchWidth, outPatchWidth, true, 0);
+  _samplePatch.fill(0.f);
+  _flagPatch.fill(0);
 
   const image::Sampler2d<image::SamplerLinear> sampler;
 
   // pointer alias
-  unsigned char * flagPatch_data = flagPatch.data();
-  float * outPatch_data = outPatch.data();
+  unsigned char * flagPatch_data = _flagPatch.data();
+  float * samplePatch_data = _samplePatch.data();
 
   for(int y=-outRadius; y<=outRadius; ++y)
   {
@@ -325,15 +334,17 @@ void DescriptorExtractor_LIOP::extract(
       if(xs<0 || xs>I.Width()-1)
         continue;
 
-      outPatch_data[(y+outRadius)*outPatchWidth+x+outRadius] = sampler(I, ys, xs);
-      flagPatch_data[(y+outRadius)*outPatchWidth+x+outRadius] = 1;
+      samplePatch_data[(y+outRadius)*_outPatchWidth+x+outRadius] = sampler(I, ys, xs);
+      flagPatch_data[(y+outRadius)*_outPatchWidth+x+outRadius] = 1;
     }
   }
-  image::ImageGaussianFilter(image::Image<float>(outPatch), 1.2, outPatch);
+
+  // the filter can't work in place, smooth the sampled patch into the output patch
+  image::ImageGaussianFilter(_samplePatch, 1.2, _outPatch);
 
   //b. creation of the LIOP ordering
-  const int inRadius = scalePatchWidth/2;
-  CreateLIOP_GOrder(outPatch, flagPatch, inRadius, desc);
+  const int inRadius = _scalePatchWidth/2;
+  CreateLIOP_GOrder(_outPatch, _flagPatch, inRadius, desc);
 }
 
 template<typename T>
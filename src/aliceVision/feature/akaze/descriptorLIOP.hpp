@@ -39,20 +39,84 @@ private:
   static const int _maxSampleNum = 10;
   static const int _liopNum = 4;
   static const int _regionNum = 6;
+
+  /// width of the scaled patch
+  static const int _scalePatchWidth = 31;
+  /// width of the extracted patch (scaled patch and the LIOP sampling radius)
+  static const int _outPatchWidth = _scalePatchWidth + 6;
+
+  /**
+   * @brief Precomputed bilinear sampling of one LIOP neighbour in the extracted patch
+   */
+  struct LiopNeighbour
+  {
+    /// indices of the 4 bilinear corners in the patch
+    int corners[4];
+    /// bilinear weights of the 4 corners
+    float weights[4];
+  };
+
+  /**
+   * @brief Precomputed LIOP sampling of one pixel of the inner disk of the patch
+   */
+  struct LiopSampling
+  {
+    float x, y;
+    /// index of the pixel in the patch
+    int center;
+    LiopNeighbour neighbours[_liopNum];
+  };
+
+  /**
+   * @brief A pixel of the inner disk with its gray value and its LIOP pattern
+   */
+  struct LiopPixel
+  {
+    float x, y; // position
+    float f_gray; // color value
+    float weight;
+    int l_pattern;
+  };
+
+  /// LIOP pattern index for each key of m_LiopPatternMap (255 if the key is not a pattern)
+  std::vector<unsigned char> _liopPatternLut;
+  /// sampling of the inner disk of the patch, it only depends on the patch geometry
+  std::vector<LiopSampling> _samplings;
+
+  // extraction buffers, reused from one keypoint to the next
+  image::Image<float> _samplePatch;
+  image::Image<float> _outPatch;
+  image::Image<unsigned char> _flagPatch;
+  std::vector<LiopPixel> _pixels;
+
 public:
 
   DescriptorExtractor_LIOP();
 
+  /**
+   * @brief Compute the LIOP descriptor of the given feature
+   * @note The extractor holds the extraction buffers, use one extractor per thread.
+   * @param[in] I The input image
+   * @param[in] feat The feature to describe
+   * @param[out] desc The LIOP descriptor
+   */
   void extract(
     const image::Image<float> & I,
     const SIOPointFeature & feat,
     float desc[144]);
 
+  /**
+   * @brief Compute the LIOP descriptor from an extracted and smoothed patch
+   * @param[in] outPatch The extracted patch (_outPatchWidth x _outPatchWidth)
+   * @param[in] flagPatch The validity of each pixel of the extracted patch
+   * @param[in] inRadius The radius of the described disk (_scalePatchWidth / 2)
+   * @param[out] desc The LIOP descriptor
+   */
   void CreateLIOP_GOrder(
     const image::Image<float> & outPatch,
     const image::Image<unsigned char> & flagPatch,
     const int inRadius,
-    float desc[144]) const;
+    float desc[144]);
 
   void GeneratePatternMap(
     std::map<int,unsigned char> & pattern_map,
@@ -9,8 +9,12 @@
 
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/feature/PointFeature.hpp>
+#include <aliceVision/image/Sampler.hpp>
 #include <aliceVision/numeric/MathTrait.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace aliceVision {
 namespace feature {
 
@@ -26,6 +30,78 @@ namespace feature {
     return MathTrait<Real>::exp( - ( ( x * x ) + ( y * y ) ) / ( static_cast<Real>( 2 ) * sigma * sigma ) ) ;
   }
 
+  /**
+   * @brief Precomputed gaussian weights of the MSURF descriptor
+   * @note The distance between a sample and the center of its subregion is a multiple of the scale,
+   * so the sample weights don't depend on the keypoint and are computed once.
+   */
+  template <typename Real>
+  struct MSURFGaussianWeights
+  {
+    /// weight of the samples, indexed by the sample offset from the subregion center (-5 to 3)
+    Real samples[9][9];
+    /// weight of the 4x4 subregions
+    Real subregions[4][4];
+
+    MSURFGaussianWeights()
+    {
+      for( int dk = 0 ; dk < 9 ; ++dk )
+        for( int dl = 0 ; dl < 9 ; ++dl )
+          samples[dk][dl] = gaussian( static_cast<Real>( dl - 5 ) , static_cast<Real>( dk - 5 ) , static_cast<Real>( 2.5 ) ) ;
+
+      for( int si = 0 ; si < 4 ; ++si )
+        for( int sj = 0 ; sj < 4 ; ++sj )
+          subregions[si][sj] = gaussian( static_cast<Real>( si ) - static_cast<Real>( 1.5 ) ,
+                                         static_cast<Real>( sj ) - static_cast<Real>( 1.5 ) ,
+                                         static_cast<Real>( 1.5 ) ) ;
+    }
+  };
+
+  /**
+   * @brief Bilinear sampling of both derivatives at the same position
+   * @note The bilinear weights are shared by the two derivatives. Near the image borders,
+   * the generic sampler is used to keep its border handling.
+   * @param Lx Input X-derivative
+   * @param Ly Input Y-derivative
+   * @param sampler The generic sampler
+   * @param y Y-coordinate of sampling
+   * @param x X-coordinate of sampling
+   * @param[out] rx Sampled X-derivative
+   * @param[out] ry Sampled Y-derivative
+   */
+  template<typename ImageT, typename Real>
+  inline void sampleMSURFDerivatives(
+    const ImageT & Lx ,
+    const ImageT & Ly ,
+    const image::Sampler2d<image::SamplerLinear> & sampler ,
+    const Real y ,
+    const Real x ,
+    Real & rx ,
+    Real & ry )
+  {
+    const Real xFloor = std::floor( x ) ;
+    const Real yFloor = std::floor( y ) ;
+    const int x0 = static_cast<int>( xFloor ) ;
+    const int y0 = static_cast<int>( yFloor ) ;
+
+    if( x0 < 0 || y0 < 0 || x0 + 1 >= Lx.Width() || y0 + 1 >= Lx.Height() )
+    {
+      rx = sampler( Lx, y, x );
+      ry = sampler( Ly, y, x );
+      return;
+    }
+
+    const Real fx = x - xFloor ;
+    const Real fy = y - yFloor ;
+    const Real w00 = ( 1 - fx ) * ( 1 - fy ) ;
+    const Real w01 = fx * ( 1 - fy ) ;
+    const Real w10 = ( 1 - fx ) * fy ;
+    const Real w11 = fx * fy ;
+
+    rx = w00 * Lx( y0 , x0 ) + w01 * Lx( y0 , x0 + 1 ) + w10 * Lx( y0 + 1 , x0 ) + w11 * Lx( y0 + 1 , x0 + 1 ) ;
+    ry = w00 * Ly( y0 , x0 ) + w01 * Ly( y0 , x0 + 1 ) + w10 * Ly( y0 + 1 , x0 ) + w11 * Ly( y0 + 1 , x0 + 1 ) ;
+  }
+
   /**
    * @brief This method computes the descriptor of the provided keypoint given the main orientation of the keypoint
    * @param Lx Input X-derivative
@@ -45,14 +121,15 @@ namespace feature {
     const SIOPointFeature & ipt ,
     Descriptor< Real , 64 > & desc )
   {
+    static const MSURFGaussianWeights<Real> weights;
 
     Real dx = 0, dy = 0, mdx = 0, mdy = 0, gauss_s1 = 0, gauss_s2 = 0;
-    Real rx = 0, ry = 0, rrx = 0, rry = 0, ys = 0, xs = 0;
+    Real rx = 0, ry = 0, rrx = 0, rry = 0;
     Real sample_x = 0, sample_y = 0;
     int kx = 0, ky = 0, i = 0, j = 0, dcount = 0;
 
-    // Subregion centers for the 4x4 gaussian weighting
-    Real cx = - static_cast<Real>( 0.5 ) , cy = static_cast<Real>( 0.5 ) ;
+    // Subregion indices for the 4x4 gaussian weighting
+    int si = -1, sj = -1;
 
     // Set the descriptor size and the sample and pattern sizes
     const int sample_step = 5;
@@ -65,7 +142,11 @@ namespace feature {
     const Real yf = ipt.y() / ratio;
     const Real xf = ipt.x() / ratio;
     const Real co = MathTrait<Real>::cos( angle );
-    const Real si = MathTrait<Real>::sin( angle );
+    const Real si_angle = MathTrait<Real>::sin( angle );
+
+    // rotated axis scaled to the keypoint scale
+    const Real sco = scale * co;
+    const Real ssi = scale * si_angle;
 
     i = -8;
 
@@ -78,38 +159,36 @@ namespace feature {
       j = -8;
       i = i - 4;
 
-      cx += 1.0;
-      cy = -0.5;
+      ++si;
+      sj = -1;
 
       while ( j < pattern_size )
       {
         dx = dy = mdx = mdy = 0.0;
-        cy += 1.0;
+        ++sj;
         j = j - 4;
 
         ky = i + sample_step;
         kx = j + sample_step;
 
-        xs = xf + ( -kx * scale * si + ky * scale * co );
-        ys = yf + ( kx * scale * co + ky * scale * si );
-
         for ( int k = i; k < i + 9; ++k )
         {
+          const Real* gaussRow = weights.samples[k - ky + 5];
+
           for ( int l = j; l < j + 9; ++l )
           {
             // Get coords of sample point on the rotated axis
-            sample_y = yf + ( l * scale * co + k * scale * si );
-            sample_x = xf + ( -l * scale * si + k * scale * co );
+            sample_y = yf + ( l * sco + k * ssi );
+            sample_x = xf + ( -l * ssi + k * sco );
 
             // Get the gaussian weighted x and y responses
-            gauss_s1 = gaussian( xs - sample_x, ys - sample_y, static_cast<Real>( 2.5 ) * static_cast<Real>( scale ) );
+            gauss_s1 = gaussRow[l - kx + 5];
 
-            rx = sampler( Lx, sample_y, sample_x );
-            ry = sampler( Ly, sample_y, sample_x );
+            sampleMSURFDerivatives( Lx, Ly, sampler, sample_y, sample_x, rx, ry );
 
             // Get the x and y derivatives on the rotated axis
-            rry = gauss_s1 * ( rx * co + ry * si );
-            rrx = gauss_s1 * ( -rx * si + ry * co );
+            rry = gauss_s1 * ( rx * co + ry * si_angle );
+            rrx = gauss_s1 * ( -rx * si_angle + ry * co );
 
             // Sum the derivatives to the cumulative descriptor
             dx += rrx;
@@ -120,7 +199,7 @@ namespace feature {
         }
 
         // Add the values to the descriptor vector
-        gauss_s2 = gaussian( cx - static_cast<Real>( 2.0 ) , cy - static_cast<Real>( 2.0 ) , static_cast<Real>( 1.5 ) ) ;
+        gauss_s2 = weights.subregions[si][sj];
         desc[dcount++] = dx * gauss_s2;
         desc[dcount++] = dy * gauss_s2;
         desc[dcount++] = mdx * gauss_s2;
@@ -139,6 +218,24 @@ namespace feature {
     //ALICEVISION_LOG_DEBUG(dataMap.transpose()));
   }
 
+  /**
+   * @brief Quantize a MSURF descriptor in 8 bits
+   * @param descFloat Input unit descriptor
+   * @param desc Ouput quantized descriptor
+   * @note The values of a unit descriptor of length 64 are small, [-0.5, 0.5] is mapped on [0, 255]
+   * and the few bigger values are clamped. L2 distances are scaled by 256, so ratio tests are not affected.
+   */
+  inline void QuantizeMSURFDescriptor(
+    const Descriptor< float , 64 > & descFloat ,
+    Descriptor< unsigned char , 64 > & desc )
+  {
+    for( int k = 0 ; k < 64 ; ++k )
+    {
+      const float value = 128.f + 256.f * descFloat[k] ;
+      desc[k] = static_cast<unsigned char>( std::min( 255.f , std::max( 0.f , std::round( value ) ) ) ) ;
+    }
+  }
+
   template<typename ImageT>
   inline void ComputeMSURFDescriptor(
     const ImageT & Lx ,
@@ -154,6 +251,7 @@ namespace feature {
       id_octave ,
       ipt ,
       descFloat);
+    QuantizeMSURFDescriptor( descFloat , desc );
   }
 
 } // namespace feature
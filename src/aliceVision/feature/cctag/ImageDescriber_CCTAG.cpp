@@ -11,6 +11,9 @@
 
 #include <cctag/ICCTag.hpp>
 #include <cctag/utils/LogTime.hpp>
+
+#include <memory>
+#include <sstream>
 //#define CPU_ADAPT_OF_GPU_PART //todo: #ifdef depreciated
 #ifdef CPU_ADAPT_OF_GPU_PART    
   #include "cctag/progBase/MemoryPool.hpp"
@@ -110,22 +113,33 @@ bool ImageDescriber_CCTAG::describe(const image::Image<unsigned char>& image,
   regionsCasted->Descriptors().reserve(regionsCasted->Descriptors().size() + 50);
 
   boost::ptr_list<cctag::ICCTag> cctags;
-  cctag::logtime::Mgmt* durations = new cctag::logtime::Mgmt( 25 );
+  std::unique_ptr<cctag::logtime::Mgmt> durations(new cctag::logtime::Mgmt( 25 ));
   // cctag::CCTagMarkersBank bank(_params._nCrowns);
 
+  // the CUDA pipe keeps its device buffers between the images,
+  // the detection must run on the device of the pipe
+  if(useCuda() && !gpu::gpuSetDeviceCUDA(_cudaDevice))
+    ALICEVISION_LOG_WARNING("CCTag: cannot select the CUDA device " << _cudaDevice << ", use the current device.");
+
+  ++_frameId;
+
 #ifndef CPU_ADAPT_OF_GPU_PART
   const cv::Mat graySrc(cv::Size(image.Width(), image.Height()), CV_8UC1, (unsigned char *) image.data(), cv::Mat::AUTO_STEP);
   //// Invert the image
   //cv::Mat invertImg;
   //cv::bitwise_not(graySrc,invertImg);
-  cctag::cctagDetection(cctags, _cudaPipe, 1,graySrc, *_params._internalParams, durations);
+  cctag::cctagDetection(cctags, _cudaPipe, _frameId, graySrc, *_params._internalParams, durations.get());
 #else //todo: #ifdef depreciated
   cctag::MemoryPool::instance().updateMemoryAuthorizedWithRAM();
   cctag::View cctagView((const unsigned char *) image.data(), image.Width(), image.Height(), image.Depth()*image.Width());
   boost::ptr_list<cctag::ICCTag> cctags;
-  cctag::cctagDetection(cctags, _cudaPipe, 1 ,cctagView._grayView ,*_params._internalParams, durations );
+  cctag::cctagDetection(cctags, _cudaPipe, _frameId, cctagView._grayView ,*_params._internalParams, durations.get());
 #endif
-  durations->print( std::cerr );
+  {
+    std::ostringstream os;
+    durations->print(os);
+    ALICEVISION_LOG_TRACE("CCTag detection durations:\n" << os.str());
+  }
 
   for (const auto & cctag : cctags)
   {
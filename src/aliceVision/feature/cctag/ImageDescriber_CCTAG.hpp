@@ -72,6 +72,8 @@ public:
 
   /**
    * @brief set the CUDA pipe
+   * @note Each CUDA pipe keeps its own device buffers between images,
+   *       the images of a pipe should be described by the same thread.
    * @param[in] pipe The CUDA pipe id
    */
   void setCudaPipe(int pipe) override
@@ -79,6 +81,15 @@ public:
     _cudaPipe = pipe;
   }
 
+  /**
+   * @brief Set the CUDA device used by the CCTag detection
+   * @param[in] device The CUDA device id
+   */
+  void setCudaDevice(int device) override
+  {
+    _cudaDevice = device;
+  }
+
   /**
    * @brief Use a preset to control the number of detected regions
    * @param[in] preset The preset configuration
@@ -120,6 +131,9 @@ private:
   CCTagParameters _params;
   bool _doAppend = false;
   int _cudaPipe = 0;
+  int _cudaDevice = 0;
+  /// index of the described image, used by the CCTag detection logs
+  int _frameId = 0;
 };
 
 /**
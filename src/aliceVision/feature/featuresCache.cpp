@@ -0,0 +1,138 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "featuresCache.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+/// 64-bit FNV-1a hash
+const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+inline void hashBytes(std::uint64_t& hash, const char* data, std::size_t size)
+{
+  for(std::size_t i = 0; i < size; ++i)
+  {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= FNV_PRIME;
+  }
+}
+
+inline std::string toHex(std::uint64_t value)
+{
+  std::ostringstream os;
+  os << std::hex << std::setw(16) << std::setfill('0') << value;
+  return os.str();
+}
+
+} // namespace
+
+std::string computeFileContentHash(const std::string& filename)
+{
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+  if(!file.is_open())
+    return "";
+
+  std::uint64_t hash = FNV_OFFSET_BASIS;
+  std::vector<char> buffer(1 << 20);
+
+  while(file)
+  {
+    file.read(buffer.data(), buffer.size());
+    hashBytes(hash, buffer.data(), static_cast<std::size_t>(file.gcount()));
+  }
+
+  if(file.bad())
+    return "";
+
+  return toHex(hash);
+}
+
+FeaturesCache::FeaturesCache(const std::string& folder)
+  : _folder(folder)
+{
+  if(!fs::exists(_folder) && !fs::create_directories(_folder))
+    throw std::runtime_error("Can't create features cache folder '" + _folder + "' !");
+}
+
+std::string FeaturesCache::getKey(const std::string& imageHash, const std::string& describerSettings)
+{
+  std::uint64_t settingsHash = FNV_OFFSET_BASIS;
+  hashBytes(settingsHash, describerSettings.data(), describerSettings.size());
+  return imageHash + "_" + toHex(settingsHash);
+}
+
+std::string FeaturesCache::getEntryPath(const std::string& key, const std::string& extension) const
+{
+  return (fs::path(_folder) / fs::path(key + extension)).string();
+}
+
+bool FeaturesCache::has(const std::string& key, const std::vector<std::string>& extensions) const
+{
+  for(const std::string& extension : extensions)
+    if(!fs::exists(getEntryPath(key, extension)))
+      return false;
+  return !extensions.empty();
+}
+
+bool FeaturesCache::restore(const std::string& key, const std::vector<std::string>& extensions, const std::string& outputBasename) const
+{
+  boost::system::error_code ec;
+
+  for(const std::string& extension : extensions)
+  {
+    fs::copy_file(getEntryPath(key, extension), outputBasename + extension, fs::copy_option::overwrite_if_exists, ec);
+    if(ec)
+    {
+      ALICEVISION_LOG_WARNING("Can't restore '" << outputBasename + extension << "' from the features cache: " << ec.message());
+      return false;
+    }
+  }
+  return true;
+}
+
+bool FeaturesCache::store(const std::string& key, const std::vector<std::string>& extensions, const std::string& inputBasename) const
+{
+  boost::system::error_code ec;
+
+  for(const std::string& extension : extensions)
+  {
+    // copy in a temporary file first, an entry file is always complete
+    const std::string entryPath = getEntryPath(key, extension);
+    const std::string tmpEntryPath = entryPath + "." + fs::unique_path().string() + ".tmp";
+
+    fs::copy_file(inputBasename + extension, tmpEntryPath, fs::copy_option::overwrite_if_exists, ec);
+    if(!ec)
+      fs::rename(tmpEntryPath, entryPath, ec);
+
+    if(ec)
+    {
+      ALICEVISION_LOG_WARNING("Can't store '" << inputBasename + extension << "' in the features cache: " << ec.message());
+      fs::remove(tmpEntryPath, ec);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace feature
+} // namespace aliceVision
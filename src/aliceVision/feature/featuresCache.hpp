@@ -0,0 +1,83 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Compute a hash of the content of a file
+ * @param[in] filename The file to hash
+ * @return the hash as a 16 characters hexadecimal string, empty if the file can't be read
+ */
+std::string computeFileContentHash(const std::string& filename);
+
+/**
+ * @brief Folder of extracted features indexed by image content and describer settings.
+ *
+ * An entry is identified by a key built from the image content hash and a string
+ * describing all the settings that change the extraction result (describer type, preset, ...).
+ * Each entry is a set of files sharing the same key, one for each given extension
+ * (for example ".sift.feat" and ".sift.desc").
+ * Entries don't depend on the view ids, so they can be reused by another SfMData.
+ */
+class FeaturesCache
+{
+public:
+
+  /**
+   * @brief Open a features cache folder, the folder is created if needed
+   * @param[in] folder The cache folder
+   */
+  explicit FeaturesCache(const std::string& folder);
+
+  const std::string& getFolder() const { return _folder; }
+
+  /**
+   * @brief Get the key of a cache entry
+   * @param[in] imageHash The image content hash (see computeFileContentHash)
+   * @param[in] describerSettings The settings of the extraction
+   * @return the entry key
+   */
+  static std::string getKey(const std::string& imageHash, const std::string& describerSettings);
+
+  /**
+   * @brief Check if all the files of an entry are in the cache
+   * @param[in] key The entry key
+   * @param[in] extensions The extensions of the entry files
+   */
+  bool has(const std::string& key, const std::vector<std::string>& extensions) const;
+
+  /**
+   * @brief Copy the files of an entry from the cache
+   * @param[in] key The entry key
+   * @param[in] extensions The extensions of the entry files
+   * @param[in] outputBasename The output path without extension
+   * @return false if a file can't be copied
+   */
+  bool restore(const std::string& key, const std::vector<std::string>& extensions, const std::string& outputBasename) const;
+
+  /**
+   * @brief Copy the files of an entry in the cache
+   * @param[in] key The entry key
+   * @param[in] extensions The extensions of the entry files
+   * @param[in] inputBasename The input path without extension
+   * @return false if a file can't be copied
+   */
+  bool store(const std::string& key, const std::vector<std::string>& extensions, const std::string& inputBasename) const;
+
+private:
+  std::string getEntryPath(const std::string& key, const std::string& extension) const;
+
+  std::string _folder;
+};
+
+} // namespace feature
+} // namespace aliceVision
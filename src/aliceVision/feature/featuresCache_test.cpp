@@ -0,0 +1,103 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/featuresCache.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iterator>
+
+#define BOOST_TEST_MODULE FeaturesCache
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+void writeFile(const std::string& filename, const std::string& content)
+{
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+  file << content;
+}
+
+std::string readFile(const std::string& filename)
+{
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(FeaturesCache_contentHash)
+{
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path();
+  fs::create_directories(folder);
+
+  const std::string fileA = (folder / "a.jpg").string();
+  const std::string fileB = (folder / "b.jpg").string();
+  const std::string fileC = (folder / "c.jpg").string();
+
+  writeFile(fileA, "image content");
+  writeFile(fileB, "image content");
+  writeFile(fileC, "image contenT");
+
+  const std::string hashA = computeFileContentHash(fileA);
+
+  BOOST_CHECK_EQUAL(hashA.size(), 16);
+  BOOST_CHECK_EQUAL(hashA, computeFileContentHash(fileB));
+  BOOST_CHECK_NE(hashA, computeFileContentHash(fileC));
+  BOOST_CHECK(computeFileContentHash((folder / "missing.jpg").string()).empty());
+
+  fs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(FeaturesCache_key)
+{
+  const std::string hash = "0123456789abcdef";
+
+  BOOST_CHECK_EQUAL(FeaturesCache::getKey(hash, "sift;preset=normal"), FeaturesCache::getKey(hash, "sift;preset=normal"));
+  BOOST_CHECK_NE(FeaturesCache::getKey(hash, "sift;preset=normal"), FeaturesCache::getKey(hash, "sift;preset=high"));
+  BOOST_CHECK_NE(FeaturesCache::getKey(hash, "sift;preset=normal"), FeaturesCache::getKey("fedcba9876543210", "sift;preset=normal"));
+}
+
+BOOST_AUTO_TEST_CASE(FeaturesCache_storeRestore)
+{
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path();
+  const fs::path cacheFolder = folder / "cache";
+  fs::create_directories(folder);
+
+  FeaturesCache cache(cacheFolder.string());
+  BOOST_CHECK(fs::is_directory(cacheFolder));
+
+  const std::vector<std::string> extensions = {".sift.feat", ".sift.desc"};
+  const std::string key = FeaturesCache::getKey("0123456789abcdef", "sift");
+
+  BOOST_CHECK(!cache.has(key, extensions));
+
+  // outputs of the view 12
+  const std::string inputBasename = (folder / "12").string();
+  writeFile(inputBasename + ".sift.feat", "features");
+  writeFile(inputBasename + ".sift.desc", "descriptors");
+
+  BOOST_CHECK(cache.store(key, extensions, inputBasename));
+  BOOST_CHECK(cache.has(key, extensions));
+  BOOST_CHECK(!cache.has(key, {".akaze.feat"}));
+
+  // same image with another view id
+  const std::string outputBasename = (folder / "34").string();
+  BOOST_CHECK(cache.restore(key, extensions, outputBasename));
+  BOOST_CHECK_EQUAL(readFile(outputBasename + ".sift.feat"), "features");
+  BOOST_CHECK_EQUAL(readFile(outputBasename + ".sift.desc"), "descriptors");
+
+  // no temporary file left in the cache
+  BOOST_CHECK_EQUAL(std::distance(fs::directory_iterator(cacheFolder), fs::directory_iterator()), 2);
+
+  fs::remove_all(folder);
+}
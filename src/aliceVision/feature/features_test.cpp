@@ -6,6 +6,8 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/feature/feature.hpp"
+#include "aliceVision/feature/DescriptorSpan.hpp"
+#include "aliceVision/feature/akaze/descriptorMSURF.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -122,3 +124,191 @@ BOOST_AUTO_TEST_CASE(descriptorIO_BINARY) {
       BOOST_CHECK_EQUAL(vec_descs[i][j], vec_descs_read[i][j]);
   }
 }
+
+//Test binary regions container export of features and descriptors
+BOOST_AUTO_TEST_CASE(regionsIO_CONTAINER) {
+  // Create an input series of regions
+  SIFT_Regions regions;
+  for(int i = 0; i < CARD; ++i)
+  {
+    regions.Features().push_back(SIOPointFeature(i, i*2, i*3, i*4));
+    SIFT_Regions::DescriptorT desc;
+    for (int j = 0; j < 128; ++j)
+      desc[j] = (i*128+j) % 256;
+    regions.Descriptors().push_back(desc);
+  }
+
+  //Save them to a file
+  BOOST_CHECK_NO_THROW(regions.SaveContainer("tempRegions.regions"));
+
+  //Read the saved data and compare to input (to check write/read IO)
+  SIFT_Regions regions_read;
+  BOOST_CHECK_NO_THROW(regions_read.LoadContainer("tempRegions.regions"));
+  BOOST_CHECK_EQUAL(CARD, regions_read.RegionCount());
+
+  for(int i = 0; i < CARD; ++i) {
+    BOOST_CHECK_EQUAL(regions.Features()[i], regions_read.Features()[i]);
+    BOOST_CHECK(regions.Descriptors()[i] == regions_read.Descriptors()[i]);
+  }
+
+  // A container can't be loaded with a different regions type
+  AKAZE_Float_Regions regions_akaze;
+  BOOST_CHECK_THROW(regions_akaze.LoadContainer("tempRegions.regions"), std::exception);
+
+  // A legacy descriptor file is not a valid container
+  BOOST_CHECK_THROW(regions_read.LoadContainer("tempDescsBin.desc"), std::exception);
+}
+
+//Test memory-mapped descriptors from a regions container
+BOOST_AUTO_TEST_CASE(regionsIO_CONTAINER_MAPPED) {
+  SIFT_Regions regions;
+  for(int i = 0; i < CARD; ++i)
+  {
+    regions.Features().push_back(SIOPointFeature(i, i*2, i*3, i*4));
+    SIFT_Regions::DescriptorT desc;
+    for (int j = 0; j < 128; ++j)
+      desc[j] = (i+j) % 256;
+    regions.Descriptors().push_back(desc);
+  }
+  BOOST_CHECK_NO_THROW(regions.SaveContainer("tempRegionsMapped.regions"));
+
+  SIFT_Regions regions_mapped;
+  BOOST_CHECK_NO_THROW(regions_mapped.MapContainer("tempRegionsMapped.regions"));
+  BOOST_CHECK(regions_mapped.isDescriptorsMapped());
+  BOOST_CHECK_EQUAL(CARD, regions_mapped.RegionCount());
+
+  // mapped descriptors are accessible without copy
+  const DescriptorSpan<unsigned char> span = getDescriptorSpan<unsigned char>(regions_mapped);
+  BOOST_CHECK_EQUAL(CARD, span.count());
+  BOOST_CHECK_EQUAL(128, span.dimension());
+  for(int i = 0; i < CARD; ++i)
+  {
+    BOOST_CHECK_EQUAL(regions.Features()[i], regions_mapped.Features()[i]);
+    BOOST_CHECK(regions.Descriptors()[i] == regions_mapped.descriptor(i));
+    BOOST_CHECK(std::equal(span[i], span[i] + 128, regions.Descriptors()[i].getData()));
+    BOOST_CHECK_EQUAL(regions.SquaredDescriptorDistance(i, &regions_mapped, i), 0.0);
+  }
+
+  // const std::vector access is not available on mapped descriptors
+  const SIFT_Regions& regions_mapped_const = regions_mapped;
+  BOOST_CHECK_THROW(regions_mapped_const.Descriptors(), std::logic_error);
+
+  // mutable access copies the descriptors in memory
+  BOOST_CHECK_EQUAL(CARD, regions_mapped.Descriptors().size());
+  BOOST_CHECK(!regions_mapped.isDescriptorsMapped());
+  BOOST_CHECK(regions.Descriptors()[CARD-1] == regions_mapped.Descriptors()[CARD-1]);
+}
+
+//Test reading the descriptors of a regions container as a descriptors file
+BOOST_AUTO_TEST_CASE(regionsIO_CONTAINER_DESCRIPTORS) {
+  SIFT_Regions regions;
+  for(int i = 0; i < CARD; ++i)
+  {
+    regions.Features().push_back(SIOPointFeature(i, i*2, i*3, i*4));
+    SIFT_Regions::DescriptorT desc;
+    for (int j = 0; j < 128; ++j)
+      desc[j] = (i*5+j) % 256;
+    regions.Descriptors().push_back(desc);
+  }
+  BOOST_CHECK_NO_THROW(regions.SaveContainer("tempRegionsDescs.regions"));
+
+  // converted to float and appended
+  typedef Descriptor<float, 128> DescriptorFloat;
+  std::vector<DescriptorFloat> descs(1);
+  BOOST_CHECK_NO_THROW((loadDescsFromBinFile<DescriptorFloat, SIFT_Regions::DescriptorT>("tempRegionsDescs.regions", descs, true)));
+  BOOST_CHECK_EQUAL(CARD + 1, descs.size());
+  for(int i = 0; i < CARD; ++i)
+    for(int j = 0; j < 128; ++j)
+      BOOST_CHECK_EQUAL(descs[i + 1][j], static_cast<float>(regions.Descriptors()[i][j]));
+
+  // limited number of descriptors
+  BOOST_CHECK_NO_THROW((loadDescsFromBinFile<DescriptorFloat, SIFT_Regions::DescriptorT>("tempRegionsDescs.regions", descs, false, 5)));
+  BOOST_CHECK_EQUAL(5, descs.size());
+
+  // the descriptors of the file must have the expected type
+  std::vector<Descriptor<float, 64>> descsAkaze;
+  BOOST_CHECK_THROW(loadDescsFromBinFile("tempRegionsDescs.regions", descsAkaze), std::exception);
+}
+
+//Test the copy of regions at given indexes of an allocated container
+BOOST_AUTO_TEST_CASE(regions_COPY_AT_INDEX) {
+  SIFT_Regions regions;
+  for(int i = 0; i < CARD; ++i)
+  {
+    regions.Features().push_back(SIOPointFeature(i, i*2, i*3, i*4));
+    SIFT_Regions::DescriptorT desc;
+    for (int j = 0; j < 128; ++j)
+      desc[j] = (i*3+j) % 256;
+    regions.Descriptors().push_back(desc);
+  }
+
+  // copy the regions in the reverse order
+  std::unique_ptr<Regions> regions_copy(regions.EmptyClone());
+  regions_copy->resizeRegions(CARD);
+  BOOST_CHECK_EQUAL(CARD, regions_copy->RegionCount());
+
+  for(int i = 0; i < CARD; ++i)
+    regions.CopyRegion(i, regions_copy.get(), CARD - 1 - i);
+
+  const SIFT_Regions& regions_copySIFT = dynamic_cast<const SIFT_Regions&>(*regions_copy);
+  for(int i = 0; i < CARD; ++i)
+  {
+    BOOST_CHECK_EQUAL(regions.Features()[i], regions_copySIFT.Features()[CARD - 1 - i]);
+    BOOST_CHECK(regions.Descriptors()[i] == regions_copySIFT.Descriptors()[CARD - 1 - i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(descriptor_quantizeMSURF)
+{
+  std::srand(0);
+
+  // random unit descriptors
+  std::vector<Descriptor<float, 64>> descsFloat(CARD);
+  std::vector<Descriptor<unsigned char, 64>> descsUChar(CARD);
+  for(int i = 0; i < CARD; ++i)
+  {
+    Eigen::Map<Eigen::VectorXf> data(descsFloat[i].getData(), 64);
+    data = Eigen::VectorXf::Random(64).normalized();
+    QuantizeMSURFDescriptor(descsFloat[i], descsUChar[i]);
+  }
+
+  // quantized L2 distances are the float distances scaled by 256
+  for(int i = 1; i < CARD; ++i)
+  {
+    double distFloat = 0.0;
+    double distUChar = 0.0;
+    for(int k = 0; k < 64; ++k)
+    {
+      distFloat += Square(descsFloat[0][k] - descsFloat[i][k]);
+      distUChar += Square(static_cast<double>(descsUChar[0][k]) - descsUChar[i][k]);
+    }
+    BOOST_CHECK_CLOSE(std::sqrt(distUChar) / 256.0, std::sqrt(distFloat), 2.0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(descriptor_MSURFSampling)
+{
+  std::srand(0);
+
+  const int width = 32;
+  const int height = 24;
+  image::Image<float> Lx(width, height);
+  image::Image<float> Ly(width, height);
+  Lx.setRandom();
+  Ly.setRandom();
+
+  const image::Sampler2d<image::SamplerLinear> sampler;
+
+  // the shared bilinear sampling matches the generic sampler, inside the image and on its borders
+  for(int i = 0; i < 1000; ++i)
+  {
+    const float x = (std::rand() / static_cast<float>(RAND_MAX)) * (width + 2) - 1.f;
+    const float y = (std::rand() / static_cast<float>(RAND_MAX)) * (height + 2) - 1.f;
+
+    float rx, ry;
+    sampleMSURFDerivatives(Lx, Ly, sampler, y, x, rx, ry);
+
+    BOOST_CHECK_SMALL(rx - sampler(Lx, y, x), 1e-5f);
+    BOOST_CHECK_SMALL(ry - sampler(Ly, y, x), 1e-5f);
+  }
+}
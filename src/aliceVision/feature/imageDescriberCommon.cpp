@@ -25,6 +25,7 @@ std::string EImageDescriberType_informations()
           "* akaze: A-KAZE with floating point descriptors.\n"
           "* akaze_liop: A-KAZE with Local Intensity Order Pattern descriptors.\n"
           "* akaze_mldb: A-KAZE with Modified-Local Difference Binary descriptors.\n"
+          "* akaze_uchar: A-KAZE with floating point descriptors stored in 8 bits (4 times smaller).\n"
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
           "* cctag3: Concentric circles markers with 3 crowns.\n"
           "* cctag4: Concentric circles markers with 4 crowns.\n"
@@ -48,6 +49,7 @@ std::string EImageDescriberType_enumToString(EImageDescriberType imageDescriberT
     case EImageDescriberType::AKAZE:         return "akaze";
     case EImageDescriberType::AKAZE_LIOP:    return "akaze_liop";
     case EImageDescriberType::AKAZE_MLDB:    return "akaze_mldb";
+    case EImageDescriberType::AKAZE_UCHAR:   return "akaze_uchar";
     
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
     case EImageDescriberType::CCTAG3:        return "cctag3";
@@ -78,6 +80,7 @@ EImageDescriberType EImageDescriberType_stringToEnum(const std::string& imageDes
   if(type == "akaze")         return EImageDescriberType::AKAZE;
   if(type == "akaze_liop")    return EImageDescriberType::AKAZE_LIOP;
   if(type == "akaze_mldb")    return EImageDescriberType::AKAZE_MLDB;
+  if(type == "akaze_uchar")   return EImageDescriberType::AKAZE_UCHAR;
   
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
   if(type == "cctag3")        return EImageDescriberType::CCTAG3;
@@ -26,6 +26,7 @@ enum class EImageDescriberType: unsigned char
   , AKAZE = 20
   , AKAZE_LIOP = 21
   , AKAZE_MLDB = 22
+  , AKAZE_UCHAR = 23
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
   , CCTAG3 = 30
@@ -91,6 +92,7 @@ inline float getStrongSupportCoeff(EImageDescriberType imageDescriberType)
     case EImageDescriberType::AKAZE:         return 0.14f;
     case EImageDescriberType::AKAZE_LIOP:    return 0.14f;
     case EImageDescriberType::AKAZE_MLDB:    return 0.14f;
+    case EImageDescriberType::AKAZE_UCHAR:   return 0.14f;
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
     case EImageDescriberType::CCTAG3:        return 1.0f;
@@ -0,0 +1,154 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "memoryProfile.hpp"
+
+#include <aliceVision/image/resampling.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace bpt = boost::property_tree;
+
+namespace aliceVision {
+namespace feature {
+
+std::size_t ImageDescriberMemoryProfile::getMemoryConsumption(const ImageDescriber& imageDescriber, std::size_t width, std::size_t height) const
+{
+  const auto it = _models.find(imageDescriber.getDescriberType());
+  if(it == _models.end())
+    return imageDescriber.getMemoryConsumption(width, height);
+  return it->second.getMemoryConsumption(width, height);
+}
+
+void ImageDescriberMemoryProfile::load(const std::string& filename)
+{
+  bpt::ptree fileTree;
+
+  try
+  {
+    bpt::read_json(filename, fileTree);
+  }
+  catch(const bpt::ptree_error& e)
+  {
+    throw std::runtime_error("Can't load memory profile file '" + filename + "' : " + e.what());
+  }
+
+  _describerPreset = fileTree.get<std::string>("describerPreset", "");
+  _models.clear();
+
+  for(const auto& describerNode : fileTree.get_child("describers", bpt::ptree()))
+  {
+    const bpt::ptree& describerTree = describerNode.second;
+    DescriberMemoryModel model;
+    model.bytesPerPixel = describerTree.get<double>("bytesPerPixel");
+    model.overhead = describerTree.get<std::size_t>("overhead");
+    _models[EImageDescriberType_stringToEnum(describerTree.get<std::string>("describerType"))] = model;
+  }
+}
+
+void ImageDescriberMemoryProfile::save(const std::string& filename) const
+{
+  bpt::ptree fileTree;
+  bpt::ptree describersTree;
+
+  fileTree.put("version", 1);
+  fileTree.put("describerPreset", _describerPreset);
+
+  for(const auto& modelPair : _models)
+  {
+    bpt::ptree describerTree;
+    describerTree.put("describerType", EImageDescriberType_enumToString(modelPair.first));
+    describerTree.put("bytesPerPixel", modelPair.second.bytesPerPixel);
+    describerTree.put("overhead", modelPair.second.overhead);
+    describersTree.push_back(std::make_pair("", describerTree));
+  }
+  fileTree.add_child("describers", describersTree);
+
+  try
+  {
+    bpt::write_json(filename, fileTree);
+  }
+  catch(const bpt::ptree_error& e)
+  {
+    throw std::runtime_error("Can't save memory profile file '" + filename + "' : " + e.what());
+  }
+}
+
+/**
+ * @brief Measure the peak memory needed to describe the given image
+ * @return the memory in bytes, 0 if it can't be measured
+ */
+static std::size_t measureDescribeMemory(ImageDescriber& imageDescriber, const image::Image<float>& image)
+{
+  if(!system::resetProcessPeakMemory())
+    return 0;
+
+  const std::size_t startMemory = system::getProcessMemory();
+  {
+    std::unique_ptr<Regions> regions;
+    if(imageDescriber.useFloatImage())
+    {
+      imageDescriber.describe(image, regions);
+    }
+    else
+    {
+      // the 8-bit buffer is built from the float image during the feature extraction, count it too
+      const image::Image<unsigned char> imageUChar((image.GetMat() * 255.f).cast<unsigned char>());
+      imageDescriber.describe(imageUChar, regions);
+    }
+  }
+  const std::size_t peakMemory = system::getProcessPeakMemory();
+
+  return (peakMemory > startMemory) ? (peakMemory - startMemory) : 0;
+}
+
+bool measureDescriberMemoryModel(ImageDescriber& imageDescriber,
+                                 const image::Image<float>& image,
+                                 DescriberMemoryModel& model)
+{
+  image::Image<float> halfImage;
+  image::ImageHalfSample(image, halfImage);
+
+  const double pixels = static_cast<double>(image.Width()) * image.Height();
+  const double halfPixels = static_cast<double>(halfImage.Width()) * halfImage.Height();
+
+  // the full image first: memory kept by the allocator after a run is reused by the next one,
+  // so the second measure is under-estimated and the per-pixel cost is over-estimated (conservative)
+  const std::size_t memory = measureDescribeMemory(imageDescriber, image);
+  const std::size_t halfMemory = measureDescribeMemory(imageDescriber, halfImage);
+
+  if(memory == 0 || pixels <= halfPixels)
+    return false;
+
+  ALICEVISION_LOG_DEBUG("Memory used by " << EImageDescriberType_enumToString(imageDescriber.getDescriberType()) << ": "
+                        << halfMemory << " B (" << halfImage.Width() << "x" << halfImage.Height() << "), "
+                        << memory << " B (" << image.Width() << "x" << image.Height() << ")");
+
+  model.bytesPerPixel = (static_cast<double>(memory) - static_cast<double>(halfMemory)) / (pixels - halfPixels);
+
+  if(model.bytesPerPixel <= 0.0)
+  {
+    // the memory doesn't grow with the image size (allocator caches, ...), keep a per-pixel model
+    model.bytesPerPixel = memory / pixels;
+    model.overhead = 0;
+  }
+  else
+  {
+    const double overhead = static_cast<double>(memory) - model.bytesPerPixel * pixels;
+    model.overhead = static_cast<std::size_t>(std::max(0.0, overhead));
+  }
+  return true;
+}
+
+} // namespace feature
+} // namespace aliceVision
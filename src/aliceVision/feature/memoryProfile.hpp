@@ -0,0 +1,117 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/image/Image.hpp>
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Measured memory consumption of an image describer:
+ *        memory = overhead + bytesPerPixel * width * height
+ */
+struct DescriberMemoryModel
+{
+  /// memory needed per image pixel (in bytes)
+  double bytesPerPixel = 0.0;
+  /// memory needed independently of the image size (in bytes)
+  std::size_t overhead = 0;
+
+  std::size_t getMemoryConsumption(std::size_t width, std::size_t height) const
+  {
+    return overhead + static_cast<std::size_t>(bytesPerPixel * static_cast<double>(width * height));
+  }
+};
+
+/**
+ * @brief Measured memory models of the image describers for one describer preset.
+ *
+ * A profile is computed once per machine with measureDescriberMemoryModel()
+ * and saved as a JSON file. Describers without a measured model use their
+ * own estimation (ImageDescriber::getMemoryConsumption).
+ */
+class ImageDescriberMemoryProfile
+{
+public:
+
+  ImageDescriberMemoryProfile() = default;
+
+  explicit ImageDescriberMemoryProfile(const std::string& describerPreset)
+    : _describerPreset(describerPreset)
+  {}
+
+  const std::string& getDescriberPreset() const { return _describerPreset; }
+
+  bool empty() const { return _models.empty(); }
+
+  bool hasModel(EImageDescriberType describerType) const
+  {
+    return _models.count(describerType) > 0;
+  }
+
+  const DescriberMemoryModel& getModel(EImageDescriberType describerType) const
+  {
+    return _models.at(describerType);
+  }
+
+  void setModel(EImageDescriberType describerType, const DescriberMemoryModel& model)
+  {
+    _models[describerType] = model;
+  }
+
+  /**
+   * @brief Get the total amount of RAM needed for a feature extraction of an image of the given dimension
+   * @param[in] imageDescriber The image describer
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @return the measured memory consumption if available, the describer estimation otherwise
+   */
+  std::size_t getMemoryConsumption(const ImageDescriber& imageDescriber, std::size_t width, std::size_t height) const;
+
+  /**
+   * @brief Load a memory profile from a JSON file
+   * @param[in] filename The memory profile file
+   */
+  void load(const std::string& filename);
+
+  /**
+   * @brief Save the memory profile in a JSON file
+   * @param[in] filename The memory profile file
+   */
+  void save(const std::string& filename) const;
+
+private:
+  std::string _describerPreset;
+  std::map<EImageDescriberType, DescriberMemoryModel> _models;
+};
+
+/**
+ * @brief Measure the memory model of an image describer
+ *
+ * The describer is run on the image and on the image downscaled by 2,
+ * the process peak memory of both runs gives the per-pixel cost and the fixed overhead.
+ *
+ * @note Needs to reset the process peak memory (see system::resetProcessPeakMemory),
+ *       no other memory intensive task should run at the same time.
+ * @param[in] imageDescriber The image describer
+ * @param[in] image The calibration image (should be representative of the dataset)
+ * @param[out] model The measured memory model
+ * @return false if the process peak memory can't be measured on this system
+ */
+bool measureDescriberMemoryModel(ImageDescriber& imageDescriber,
+                                 const image::Image<float>& image,
+                                 DescriberMemoryModel& model);
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,54 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/memoryProfile.hpp>
+
+#define BOOST_TEST_MODULE MemoryProfile
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+BOOST_AUTO_TEST_CASE(MemoryProfile_model)
+{
+  DescriberMemoryModel model;
+  model.bytesPerPixel = 10.0;
+  model.overhead = 1000;
+  BOOST_CHECK_EQUAL(model.getMemoryConsumption(100, 50), 1000 + 10 * 100 * 50);
+}
+
+BOOST_AUTO_TEST_CASE(MemoryProfile_saveLoad)
+{
+  ImageDescriberMemoryProfile profile("high");
+  BOOST_CHECK(profile.empty());
+
+  DescriberMemoryModel siftModel;
+  siftModel.bytesPerPixel = 123.5;
+  siftModel.overhead = 4096;
+  profile.setModel(EImageDescriberType::SIFT, siftModel);
+
+  DescriberMemoryModel akazeModel;
+  akazeModel.bytesPerPixel = 321.25;
+  akazeModel.overhead = 0;
+  profile.setModel(EImageDescriberType::AKAZE, akazeModel);
+
+  const std::string filename = "memoryProfile_test.json";
+  profile.save(filename);
+
+  ImageDescriberMemoryProfile loaded;
+  loaded.load(filename);
+
+  BOOST_CHECK_EQUAL(loaded.getDescriberPreset(), "high");
+  BOOST_CHECK(loaded.hasModel(EImageDescriberType::SIFT));
+  BOOST_CHECK(loaded.hasModel(EImageDescriberType::AKAZE));
+  BOOST_CHECK(!loaded.hasModel(EImageDescriberType::SIFT_UPRIGHT));
+  BOOST_CHECK_CLOSE(loaded.getModel(EImageDescriberType::SIFT).bytesPerPixel, 123.5, 1e-6);
+  BOOST_CHECK_EQUAL(loaded.getModel(EImageDescriberType::SIFT).overhead, 4096);
+  BOOST_CHECK_CLOSE(loaded.getModel(EImageDescriberType::AKAZE).bytesPerPixel, 321.25, 1e-6);
+
+  BOOST_CHECK_THROW(loaded.load("memoryProfile_test_missing.json"), std::runtime_error);
+}
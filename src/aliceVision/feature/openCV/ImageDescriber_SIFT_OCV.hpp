@@ -90,6 +90,15 @@ public:
     return 3 * width * height * sizeof(unsigned char) + (_params.maxTotalKeypoints * 128 * sizeof(unsigned char));
   }
 
+  /**
+   * @brief Get the maximum number of regions extracted from one image
+   * @return the maximum number of regions, 0 if there is no limit
+   */
+  std::size_t getMaxTotalKeypoints() const override
+  {
+    return _params.maxTotalKeypoints;
+  }
+
   /**
    * @brief Use a preset to control the number of detected regions
    * @param[in] preset The preset configuration
@@ -0,0 +1,90 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/RegionsCache.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <map>
+
+#define BOOST_TEST_MODULE RegionsCache
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+namespace {
+
+/// Create SIFT regions with viewId features, so each view has a different size
+std::unique_ptr<Regions> createRegions(IndexT viewId)
+{
+  std::unique_ptr<SIFT_Regions> regions(new SIFT_Regions);
+  regions->Features().resize(viewId);
+  regions->Descriptors().resize(viewId);
+  return std::unique_ptr<Regions>(regions.release());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(RegionsCache_lru)
+{
+  const std::size_t viewSize = sizeof(SIOPointFeature) + sizeof(SIFT_Regions::DescriptorT);
+  std::map<IndexT, int> nbLoads;
+
+  // budget for 10 features: views 1, 2, 3 and 4 fit, not 5
+  RegionsCache cache(10 * viewSize, [&nbLoads](IndexT viewId, EImageDescriberType)
+  {
+    ++nbLoads[viewId];
+    return createRegions(viewId);
+  });
+
+  const EImageDescriberType descType = EImageDescriberType::SIFT;
+
+  for(IndexT viewId = 1; viewId <= 4; ++viewId)
+    BOOST_CHECK_EQUAL(viewId, cache.getRegions(viewId, descType)->RegionCount());
+
+  BOOST_CHECK_EQUAL(10 * viewSize, cache.usedMemory());
+  BOOST_CHECK_EQUAL(4, cache.nbLoads());
+
+  // view 1 becomes the most recently used
+  cache.getRegions(1, descType);
+  BOOST_CHECK_EQUAL(1, cache.nbHits());
+
+  // loading view 5 evicts the least recently used views 2 and 3
+  const std::shared_ptr<const Regions> regions5 = cache.getRegions(5, descType);
+  BOOST_CHECK_EQUAL(10 * viewSize, cache.usedMemory());
+
+  cache.getRegions(1, descType);
+  cache.getRegions(4, descType);
+  BOOST_CHECK_EQUAL(1, nbLoads[1]);
+  BOOST_CHECK_EQUAL(1, nbLoads[4]);
+
+  cache.getRegions(2, descType);
+  BOOST_CHECK_EQUAL(2, nbLoads[2]);
+
+  // evicted regions stay valid while they are used
+  cache.getRegions(3, descType);
+  cache.getRegions(4, descType);
+  BOOST_CHECK_EQUAL(5, regions5->RegionCount());
+}
+
+BOOST_AUTO_TEST_CASE(RegionsCache_biggerThanBudget)
+{
+  RegionsCache cache(1, [](IndexT viewId, EImageDescriberType)
+  {
+    return createRegions(viewId);
+  });
+
+  // the most recently used regions are kept even if they don't fit
+  BOOST_CHECK_EQUAL(10, cache.getRegions(10, EImageDescriberType::SIFT)->RegionCount());
+  BOOST_CHECK_EQUAL(10, cache.getRegions(10, EImageDescriberType::SIFT)->RegionCount());
+  BOOST_CHECK_EQUAL(1, cache.nbLoads());
+  BOOST_CHECK_EQUAL(1, cache.nbHits());
+
+  cache.getRegions(20, EImageDescriberType::SIFT);
+  BOOST_CHECK_EQUAL(2, cache.nbLoads());
+  cache.getRegions(10, EImageDescriberType::SIFT);
+  BOOST_CHECK_EQUAL(3, cache.nbLoads());
+}
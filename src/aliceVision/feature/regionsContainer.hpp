@@ -0,0 +1,263 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Binary regions container (.regions)
+ *
+ * A single file storing both keypoints and descriptors of one view for one describer type.
+ * The layout is:
+ *  - a fixed size header (RegionsContainerHeader)
+ *  - the features section, starting at featuresOffset
+ *  - the descriptors section, starting at descriptorsOffset
+ *
+ * Both sections are raw arrays aligned on REGIONS_CONTAINER_ALIGNMENT bytes,
+ * so the file can be memory-mapped and read without any per-feature parsing.
+ */
+
+/// Magic number identifying a regions container ("AVRG")
+constexpr std::uint32_t REGIONS_CONTAINER_MAGIC = 0x47525641;
+/// Current version of the regions container format
+constexpr std::uint32_t REGIONS_CONTAINER_VERSION = 1;
+/// Alignment of each section of the regions container (in bytes)
+constexpr std::uint64_t REGIONS_CONTAINER_ALIGNMENT = 64;
+
+/**
+ * @brief Fixed size header of a regions container file
+ */
+struct RegionsContainerHeader
+{
+  std::uint32_t magic = REGIONS_CONTAINER_MAGIC;
+  std::uint32_t version = REGIONS_CONTAINER_VERSION;
+  /// size in bytes of one feature
+  std::uint32_t featureSize = 0;
+  /// size in bytes of one descriptor
+  std::uint32_t descriptorSize = 0;
+  /// size in bytes of one descriptor element
+  std::uint32_t descriptorBinSize = 0;
+  /// number of elements of one descriptor
+  std::uint32_t descriptorLength = 0;
+  /// number of regions stored in the container
+  std::uint64_t count = 0;
+  /// offset in bytes from the beginning of the file of the features section
+  std::uint64_t featuresOffset = 0;
+  /// offset in bytes from the beginning of the file of the descriptors section
+  std::uint64_t descriptorsOffset = 0;
+};
+
+static_assert(sizeof(RegionsContainerHeader) == 48, "Unexpected RegionsContainerHeader size.");
+
+/**
+ * @brief Round the given offset up to the container section alignment
+ * @param[in] offset The offset in bytes
+ * @return the aligned offset
+ */
+inline std::uint64_t alignRegionsContainerOffset(std::uint64_t offset)
+{
+  return (offset + REGIONS_CONTAINER_ALIGNMENT - 1) / REGIONS_CONTAINER_ALIGNMENT * REGIONS_CONTAINER_ALIGNMENT;
+}
+
+/**
+ * @brief Whether the given file name is a regions container (.regions extension)
+ */
+inline bool isRegionsContainerFile(const std::string& filename)
+{
+  const std::string extension = ".regions";
+  return filename.size() >= extension.size() &&
+         filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+/**
+ * @brief Read-only memory mapping of a regions container file
+ */
+class RegionsContainerMapping
+{
+public:
+
+  /**
+   * @brief Map the given regions container file and check its header
+   * @param[in] filename The regions container file (usually .regions)
+   */
+  explicit RegionsContainerMapping(const std::string& filename)
+  {
+    try
+    {
+      _file = boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+      _region = boost::interprocess::mapped_region(_file, boost::interprocess::read_only);
+    }
+    catch(const boost::interprocess::interprocess_exception& e)
+    {
+      throw std::runtime_error("Can't load regions container file, can't map '" + filename + "' : " + e.what());
+    }
+
+    if(_region.get_size() < sizeof(RegionsContainerHeader))
+      throw std::runtime_error("Can't load regions container file, '" + filename + "' is incorrect !");
+
+    std::memcpy(&_header, _region.get_address(), sizeof(RegionsContainerHeader));
+
+    if(_header.magic != REGIONS_CONTAINER_MAGIC)
+      throw std::runtime_error("Can't load regions container file, '" + filename + "' is not a regions container !");
+
+    if(_header.version != REGIONS_CONTAINER_VERSION)
+      throw std::runtime_error("Can't load regions container file, '" + filename + "' has an unsupported version (" + std::to_string(_header.version) + ") !");
+
+    if(_header.featuresOffset + _header.count * _header.featureSize > _region.get_size() ||
+       _header.descriptorsOffset + _header.count * _header.descriptorSize > _region.get_size())
+      throw std::runtime_error("Can't load regions container file, '" + filename + "' is truncated !");
+  }
+
+  inline const RegionsContainerHeader& header() const { return _header; }
+
+  /// Pointer to the first feature of the mapped file
+  inline const void* features() const
+  {
+    return static_cast<const char*>(_region.get_address()) + _header.featuresOffset;
+  }
+
+  /// Pointer to the first descriptor of the mapped file
+  inline const void* descriptors() const
+  {
+    return static_cast<const char*>(_region.get_address()) + _header.descriptorsOffset;
+  }
+
+private:
+  boost::interprocess::file_mapping _file;
+  boost::interprocess::mapped_region _region;
+  RegionsContainerHeader _header;
+};
+
+/**
+ * @brief Check that a mapped regions container matches the expected feature and descriptor types
+ */
+template<typename FeatureT, typename DescriptorT>
+inline void checkRegionsContainer(const RegionsContainerHeader& header, const std::string& filename)
+{
+  if(header.featureSize != sizeof(FeatureT) ||
+     header.descriptorSize != sizeof(DescriptorT) ||
+     header.descriptorBinSize != sizeof(typename DescriptorT::bin_type) ||
+     header.descriptorLength != DescriptorT::static_size)
+    throw std::runtime_error("Can't load regions container file, '" + filename + "' does not match the expected regions type !");
+}
+
+/**
+ * @brief Load features and descriptors from a regions container file (.regions)
+ * @param[in] filename The regions container file
+ * @param[out] vec_feats The loaded features
+ * @param[out] vec_descs The loaded descriptors
+ */
+template<typename FeatureT, typename DescriptorT>
+inline void loadRegionsFromContainer(const std::string& filename,
+                                     std::vector<FeatureT>& vec_feats,
+                                     std::vector<DescriptorT>& vec_descs)
+{
+  const RegionsContainerMapping mapping(filename);
+  const RegionsContainerHeader& header = mapping.header();
+
+  checkRegionsContainer<FeatureT, DescriptorT>(header, filename);
+
+  vec_feats.resize(header.count);
+  vec_descs.resize(header.count);
+
+  if(header.count == 0)
+    return;
+
+  std::memcpy(static_cast<void*>(vec_feats.data()), mapping.features(), header.count * sizeof(FeatureT));
+  std::memcpy(static_cast<void*>(vec_descs.data()), mapping.descriptors(), header.count * sizeof(DescriptorT));
+}
+
+/**
+ * @brief Load features from a regions container file (.regions) and keep
+ *        the descriptors in the memory-mapped file (no copy)
+ * @param[in] filename The regions container file
+ * @param[out] vec_feats The loaded features
+ * @return the file mapping, the descriptors are accessible through RegionsContainerMapping::descriptors()
+ *         as long as the mapping is alive
+ */
+template<typename FeatureT, typename DescriptorT>
+inline std::shared_ptr<const RegionsContainerMapping> mapRegionsFromContainer(const std::string& filename,
+                                                                              std::vector<FeatureT>& vec_feats)
+{
+  std::shared_ptr<const RegionsContainerMapping> mapping = std::make_shared<RegionsContainerMapping>(filename);
+  const RegionsContainerHeader& header = mapping->header();
+
+  checkRegionsContainer<FeatureT, DescriptorT>(header, filename);
+
+  vec_feats.resize(header.count);
+
+  if(header.count != 0)
+    std::memcpy(static_cast<void*>(vec_feats.data()), mapping->features(), header.count * sizeof(FeatureT));
+
+  return mapping;
+}
+
+/**
+ * @brief Save features and descriptors into a regions container file (.regions)
+ * @param[in] filename The regions container file
+ * @param[in] vec_feats The features to save
+ * @param[in] vec_descs The descriptors to save
+ */
+template<typename FeatureT, typename DescriptorT>
+inline void saveRegionsToContainer(const std::string& filename,
+                                   const std::vector<FeatureT>& vec_feats,
+                                   const DescriptorT* descs,
+                                   std::size_t descsCount)
+{
+  if(vec_feats.size() != descsCount)
+    throw std::runtime_error("Can't save regions container file '" + filename + "', features and descriptors count mismatch !");
+
+  RegionsContainerHeader header;
+  header.featureSize = sizeof(FeatureT);
+  header.descriptorSize = sizeof(DescriptorT);
+  header.descriptorBinSize = sizeof(typename DescriptorT::bin_type);
+  header.descriptorLength = DescriptorT::static_size;
+  header.count = vec_feats.size();
+  header.featuresOffset = alignRegionsContainerOffset(sizeof(RegionsContainerHeader));
+  header.descriptorsOffset = alignRegionsContainerOffset(header.featuresOffset + header.count * header.featureSize);
+
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+
+  if(!file.is_open())
+    throw std::runtime_error("Can't save regions container file, can't open '" + filename + "' !");
+
+  const std::vector<char> padding(REGIONS_CONTAINER_ALIGNMENT, 0);
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(RegionsContainerHeader));
+  file.write(padding.data(), header.featuresOffset - sizeof(RegionsContainerHeader));
+  file.write(reinterpret_cast<const char*>(vec_feats.data()), header.count * header.featureSize);
+  file.write(padding.data(), header.descriptorsOffset - (header.featuresOffset + header.count * header.featureSize));
+  file.write(reinterpret_cast<const char*>(descs), header.count * header.descriptorSize);
+
+  if(!file.good())
+    throw std::runtime_error("Can't save regions container file, '" + filename + "' is incorrect !");
+
+  file.close();
+}
+
+template<typename FeatureT, typename DescriptorT>
+inline void saveRegionsToContainer(const std::string& filename,
+                                   const std::vector<FeatureT>& vec_feats,
+                                   const std::vector<DescriptorT>& vec_descs)
+{
+  saveRegionsToContainer(filename, vec_feats, vec_descs.data(), vec_descs.size());
+}
+
+} // namespace feature
+} // namespace aliceVision
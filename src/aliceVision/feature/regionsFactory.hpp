@@ -21,6 +21,8 @@ typedef ScalarRegions<SIOPointFeature,float,128> SIFT_Float_Regions;
 typedef ScalarRegions<SIOPointFeature,unsigned char,128> CCTAG_Regions;
 /// Define the AKAZE Keypoint (with a float descriptor)
 typedef ScalarRegions<SIOPointFeature,float,64> AKAZE_Float_Regions;
+/// Define the AKAZE Keypoint (with a float descriptor quantized in an uchar array)
+typedef ScalarRegions<SIOPointFeature,unsigned char,64> AKAZE_Uchar_Regions;
 /// Define the AKAZE Keypoint (with a LIOP descriptor)
 typedef ScalarRegions<SIOPointFeature,unsigned char,144> AKAZE_Liop_Regions;
 
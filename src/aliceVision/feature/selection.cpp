@@ -9,6 +9,9 @@
 
 #include <aliceVision/numeric/numeric.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace aliceVision {
 namespace feature {
 
@@ -27,30 +30,50 @@ void sortMatches_byFeaturesScale(
 	const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsJ,
 	aliceVision::matching::IndMatches& outputMatches)
 {
-	const std::vector<aliceVision::feature::SIOPointFeature>& vecFeatureI = regionsI.Features();
-	const std::vector<aliceVision::feature::SIOPointFeature>& vecFeatureJ = regionsJ.Features();
+  MatchesSelectionBuffers buffers;
+  sortMatches_byFeaturesScale(inputMatches, regionsI, regionsJ, outputMatches, buffers);
+}
 
-	//outputMatches will contain the sorted matches if inputMatches.
-	outputMatches.reserve(inputMatches.size());
+void sortMatches_byFeaturesScale(
+  const aliceVision::matching::IndMatches& inputMatches,
+  const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsI,
+  const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsJ,
+  aliceVision::matching::IndMatches& outputMatches,
+  MatchesSelectionBuffers& buffers,
+  std::size_t maxMatches)
+{
+  const std::vector<aliceVision::feature::SIOPointFeature>& vecFeatureI = regionsI.Features();
+  const std::vector<aliceVision::feature::SIOPointFeature>& vecFeatureJ = regionsJ.Features();
 
-	//This vector is just a temporary container to link the index of the matches in the original vector inputMatches.
-	//It will be used to retrieve the correct matches after the sort.
-	std::vector<std::pair<float, size_t>> vecFeatureScale;
+  // temporary container to link the index of the matches in the original vector inputMatches.
+  // It will be used to retrieve the correct matches after the sort.
+  std::vector<std::pair<float, size_t>>& vecFeatureScale = buffers.matchesScale;
+  vecFeatureScale.resize(inputMatches.size());
 
-	for (size_t i = 0; i < inputMatches.size(); i++)
+  for(size_t i = 0; i < inputMatches.size(); ++i)
   {
-		float scale1 = vecFeatureI[inputMatches[i]._i].scale();
-		float scale2 = vecFeatureJ[inputMatches[i]._j].scale();
-		vecFeatureScale.emplace_back((scale1 + scale2) / 2.0, i);
-	}
+    const float scale1 = vecFeatureI[inputMatches[i]._i].scale();
+    const float scale2 = vecFeatureJ[inputMatches[i]._j].scale();
+    vecFeatureScale[i] = std::make_pair((scale1 + scale2) / 2.0f, i);
+  }
 
-	std::sort(vecFeatureScale.begin(), vecFeatureScale.end(), matchCompare);
+  const std::size_t nbMatches = (maxMatches > 0) ? std::min(maxMatches, vecFeatureScale.size()) : vecFeatureScale.size();
 
-	//The sorted match vector is filled according to the result of the sorting above.
-	for (size_t i = 0; i < vecFeatureScale.size(); i++)
+  // only the first nbMatches best matches need to be sorted
+  if(nbMatches < vecFeatureScale.size())
   {
-		outputMatches.push_back(inputMatches[vecFeatureScale[i].second]);
-	}
+    std::nth_element(vecFeatureScale.begin(), vecFeatureScale.begin() + nbMatches, vecFeatureScale.end(), matchCompare);
+    std::sort(vecFeatureScale.begin(), vecFeatureScale.begin() + nbMatches, matchCompare);
+  }
+  else
+  {
+    std::sort(vecFeatureScale.begin(), vecFeatureScale.end(), matchCompare);
+  }
+
+  // outputMatches will contain the sorted matches of inputMatches.
+  outputMatches.resize(nbMatches);
+  for(size_t i = 0; i < nbMatches; ++i)
+    outputMatches[i] = inputMatches[vecFeatureScale[i].second];
 }
 
 void sortMatches_byDistanceRatio(aliceVision::matching::IndMatches& matches) 
@@ -99,76 +122,101 @@ void thresholdMatches(aliceVision::matching::IndMatches& outputMatches, const st
 void matchesGridFiltering(const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& lRegions, 
         const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& rRegions, 
         const aliceVision::Pair& indexImagePair,
-        const aliceVision::sfmData::SfMData sfm_data, 
+        const aliceVision::sfmData::SfMData& sfm_data, 
         aliceVision::matching::IndMatches& outMatches)
 {
-  const std::size_t lWidth = sfm_data.getViews().at(indexImagePair.first)->getWidth();
-  const std::size_t lHeight = sfm_data.getViews().at(indexImagePair.first)->getHeight();
-  const std::size_t rWidth = sfm_data.getViews().at(indexImagePair.second)->getWidth();
-  const std::size_t rHeight = sfm_data.getViews().at(indexImagePair.second)->getHeight();
-  
-  const size_t leftCellHeight = std::ceil(lHeight / (float)gridSize);
-  const size_t leftCellWidth = std::ceil(lWidth / (float)gridSize);
-  const size_t rightCellHeight = std::ceil(rHeight / (float)gridSize);
-  const size_t rightCellWidth = std::ceil(rWidth / (float)gridSize);
-
-  std::vector< aliceVision::matching::IndMatches > completeGrid(gridSize*gridSize*2);
-  // Reserve all cells
-  for(aliceVision::matching::IndMatches& cell: completeGrid)
-  {
-    cell.reserve(outMatches.size()/completeGrid.size());
-  }
-  // Split matches in grid cells
-  for(const auto& match: outMatches)
+  const sfmData::View& lView = *sfm_data.getViews().at(indexImagePair.first);
+  const sfmData::View& rView = *sfm_data.getViews().at(indexImagePair.second);
+
+  MatchesSelectionBuffers buffers;
+  matchesGridFiltering(lRegions, lView.getWidth(), lView.getHeight(),
+                       rRegions, rView.getWidth(), rView.getHeight(),
+                       outMatches, buffers);
+}
+
+/**
+ * @brief Get the grid cell of a feature
+ * @param[in] point The feature
+ * @param[in] cellWidth The grid cell width
+ * @param[in] cellHeight The grid cell height
+ * @return the grid cell index
+ */
+inline std::size_t getGridCell(const aliceVision::feature::SIOPointFeature& point, std::size_t cellWidth, std::size_t cellHeight)
+{
+  // clamp the values if we have feature/marker centers outside the image size.
+  const std::size_t cellX = clamp(std::floor(point.x() / float(cellWidth)), 0.f, float(gridSize - 1));
+  const std::size_t cellY = clamp(std::floor(point.y() / float(cellHeight)), 0.f, float(gridSize - 1));
+  return cellX + cellY * gridSize;
+}
+
+void matchesGridFiltering(const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& lRegions,
+                          std::size_t lWidth,
+                          std::size_t lHeight,
+                          const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& rRegions,
+                          std::size_t rWidth,
+                          std::size_t rHeight,
+                          aliceVision::matching::IndMatches& outMatches,
+                          MatchesSelectionBuffers& buffers,
+                          std::size_t maxMatches)
+{
+  const std::size_t leftCellHeight = std::max(std::size_t(1), std::size_t(std::ceil(lHeight / (float)gridSize)));
+  const std::size_t leftCellWidth = std::max(std::size_t(1), std::size_t(std::ceil(lWidth / (float)gridSize)));
+  const std::size_t rightCellHeight = std::max(std::size_t(1), std::size_t(std::ceil(rHeight / (float)gridSize)));
+  const std::size_t rightCellWidth = std::max(std::size_t(1), std::size_t(std::ceil(rWidth / (float)gridSize)));
+
+  // gridSize*gridSize cells on the left picture, followed by gridSize*gridSize cells on the right picture
+  const std::size_t nbCells = gridSize * gridSize * 2;
+
+  std::vector<std::size_t>& matchesCell = buffers.matchesCell;
+  std::vector<std::size_t>& cellsCount = buffers.cellsCount;
+  std::vector<std::size_t>& cellsOffset = buffers.cellsOffset;
+  aliceVision::matching::IndMatches& cellsMatches = buffers.cellsMatches;
+
+  matchesCell.resize(outMatches.size());
+  cellsCount.assign(nbCells, 0);
+
+  // assign each match to the less filled of its left and right cells
+  for(std::size_t i = 0; i < outMatches.size(); ++i)
   {
-    const aliceVision::feature::SIOPointFeature& leftPoint = lRegions.Features()[match._i];
-    const aliceVision::feature::SIOPointFeature& rightPoint = rRegions.Features()[match._j];
-    
-    const float leftGridIndex_f = std::floor(leftPoint.x() / (float)leftCellWidth) + std::floor(leftPoint.y() / (float)leftCellHeight) * gridSize;
-    const float rightGridIndex_f = std::floor(rightPoint.x() / (float)rightCellWidth) + std::floor(rightPoint.y() / (float)rightCellHeight) * gridSize;
-    // clamp the values if we have feature/marker centers outside the image size.
-    const std::size_t leftGridIndex = clamp(leftGridIndex_f, 0.f, float(gridSize-1));
-    const std::size_t rightGridIndex = clamp(rightGridIndex_f, 0.f, float(gridSize-1));
-
-    aliceVision::matching::IndMatches& currentCaseL = completeGrid[leftGridIndex];
-    aliceVision::matching::IndMatches& currentCaseR = completeGrid[rightGridIndex + gridSize*gridSize];
-    
-    if(currentCaseL.size() <= currentCaseR.size())
-    {
-      currentCaseL.push_back(match);
-    }
-    else
-    {
-      currentCaseR.push_back(match);
-    }
+    const aliceVision::matching::IndMatch& match = outMatches[i];
+    const std::size_t leftCell = getGridCell(lRegions.Features()[match._i], leftCellWidth, leftCellHeight);
+    const std::size_t rightCell = getGridCell(rRegions.Features()[match._j], rightCellWidth, rightCellHeight) + gridSize * gridSize;
+    const std::size_t cell = (cellsCount[leftCell] <= cellsCount[rightCell]) ? leftCell : rightCell;
+
+    matchesCell[i] = cell;
+    ++cellsCount[cell];
   }
-  
-  // max Size of the cells:
-  int maxSize = 0;
-  for (const auto& cell: completeGrid)
+
+  // counting sort of the matches by cell, the matches order is kept inside each cell
+  cellsOffset.resize(nbCells);
+  std::size_t maxCellSize = 0;
+  for(std::size_t cell = 0, offset = 0; cell < nbCells; ++cell)
   {
-    if(cell.size() > maxSize)
-    {
-      maxSize = cell.size();
-    }
+    cellsOffset[cell] = offset;
+    offset += cellsCount[cell];
+    maxCellSize = std::max(maxCellSize, cellsCount[cell]);
   }
-  
-  aliceVision::matching::IndMatches finalMatches;
-  finalMatches.reserve(outMatches.size());
-  
+
+  cellsMatches.resize(outMatches.size());
+  for(std::size_t i = 0; i < outMatches.size(); ++i)
+    cellsMatches[cellsOffset[matchesCell[i]]++] = outMatches[i];
+
+  // cellsOffset is now the end of each cell, move it back to the beginning
+  for(std::size_t cell = 0; cell < nbCells; ++cell)
+    cellsOffset[cell] -= cellsCount[cell];
+
+  const std::size_t nbMatches = (maxMatches > 0) ? std::min(maxMatches, outMatches.size()) : outMatches.size();
+  outMatches.clear();
+
   // Combine all cells into a global ordered vector
-  for (int cmpt = 0; cmpt < maxSize; ++cmpt)
+  for(std::size_t rank = 0; rank < maxCellSize && outMatches.size() < nbMatches; ++rank)
   {
-    for(const auto& cell: completeGrid)
+    for(std::size_t cell = 0; cell < nbCells && outMatches.size() < nbMatches; ++cell)
     {
-      if(cmpt < cell.size())
-      {
-        finalMatches.push_back(cell[cmpt]);
-      }
+      if(rank < cellsCount[cell])
+        outMatches.push_back(cellsMatches[cellsOffset[cell] + rank]);
     }
   }
-  
-  outMatches.swap(finalMatches);
 }
 
 }
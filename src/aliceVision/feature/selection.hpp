@@ -20,6 +20,24 @@
 namespace aliceVision {
 namespace feature {
 
+/**
+ * @brief Scratch buffers of the matches sorting and grid filtering.
+ *        Reusing the same buffers between calls (one per thread) avoids the allocations.
+ */
+struct MatchesSelectionBuffers
+{
+  /// scale and index of each match
+  std::vector<std::pair<float, std::size_t>> matchesScale;
+  /// grid cell of each match
+  std::vector<std::size_t> matchesCell;
+  /// number of matches in each grid cell
+  std::vector<std::size_t> cellsCount;
+  /// index of the first match of each grid cell in cellsMatches
+  std::vector<std::size_t> cellsOffset;
+  /// matches grouped by grid cell
+  aliceVision::matching::IndMatches cellsMatches;
+};
+
 /**
 * @brief Compute the n best matches ('best' = mean of features' scale)
 * @param[in] inputMatches Set of indices for (putative) matches.
@@ -33,6 +51,23 @@ void sortMatches_byFeaturesScale(
 	const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsJ,
 	aliceVision::matching::IndMatches& outputMatches);
 
+/**
+ * @brief Compute the n best matches ('best' = mean of features' scale)
+ * @param[in] inputMatches Set of indices for (putative) matches.
+ * @param[in] regionsI Reference to the regions of the left image.
+ * @param[in] regionsJ Reference to the regions of the right image.
+ * @param[out] outputMatches Subset of inputMatches containing the best n matches, sorted.
+ * @param[in,out] buffers The scratch buffers
+ * @param[in] maxMatches If not 0, only the maxMatches best matches are sorted and kept
+ */
+void sortMatches_byFeaturesScale(
+  const aliceVision::matching::IndMatches& inputMatches,
+  const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsI,
+  const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& regionsJ,
+  aliceVision::matching::IndMatches& outputMatches,
+  MatchesSelectionBuffers& buffers,
+  std::size_t maxMatches = 0);
+
 /** 
  * @brief Sort matches according to their Lowe ratio (ascending order). 
  * @param[in,out] matches Set of indices for (putative) matches. 
@@ -65,8 +100,35 @@ void thresholdMatches(aliceVision::matching::IndMatches& outputMatches, const st
 void matchesGridFiltering(const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& lRegions, 
         const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& rRegions, 
         const aliceVision::Pair& indexImagePair,
-        const aliceVision::sfmData::SfMData sfm_data, 
+        const aliceVision::sfmData::SfMData& sfm_data, 
         aliceVision::matching::IndMatches& outMatches);
 
+/**
+ * @brief Perform the grid filtering on the matches
+ *
+ * The matches are spread in the cells of a grid on each picture, then interleaved
+ * cell by cell so that the first matches cover the whole pictures.
+ * The input matches order is kept inside each cell.
+ *
+ * @param[in] lRegions The regions of the first picture
+ * @param[in] lWidth The width of the first picture
+ * @param[in] lHeight The height of the first picture
+ * @param[in] rRegions The regions of the second picture
+ * @param[in] rWidth The width of the second picture
+ * @param[in] rHeight The height of the second picture
+ * @param[in,out] outMatches The matches, sorted by decreasing priority, replaced by the remaining matches
+ * @param[in,out] buffers The scratch buffers
+ * @param[in] maxMatches If not 0, only the maxMatches first remaining matches are kept
+ */
+void matchesGridFiltering(const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& lRegions,
+                          std::size_t lWidth,
+                          std::size_t lHeight,
+                          const aliceVision::feature::FeatRegions<aliceVision::feature::SIOPointFeature>& rRegions,
+                          std::size_t rWidth,
+                          std::size_t rHeight,
+                          aliceVision::matching::IndMatches& outMatches,
+                          MatchesSelectionBuffers& buffers,
+                          std::size_t maxMatches = 0);
+
 }
 }
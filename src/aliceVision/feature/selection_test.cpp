@@ -0,0 +1,108 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/selection.hpp>
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+#define BOOST_TEST_MODULE FeaturesSelection
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+namespace {
+
+SIFT_Regions makeRandomRegions(std::mt19937& generator, std::size_t nbFeatures, float width, float height)
+{
+  std::uniform_real_distribution<float> distX(-10.f, width + 10.f);
+  std::uniform_real_distribution<float> distY(-10.f, height + 10.f);
+  std::uniform_real_distribution<float> distScale(1.f, 20.f);
+
+  SIFT_Regions regions;
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+    regions.Features().emplace_back(distX(generator), distY(generator), distScale(generator), 0.f);
+  return regions;
+}
+
+matching::IndMatches makeRandomMatches(std::mt19937& generator, std::size_t nbMatches, std::size_t nbFeatures)
+{
+  std::uniform_int_distribution<IndexT> distIndex(0, nbFeatures - 1);
+
+  matching::IndMatches matches;
+  for(std::size_t i = 0; i < nbMatches; ++i)
+    matches.emplace_back(distIndex(generator), distIndex(generator));
+  return matches;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(FeaturesSelection_sortByScale_maxMatches)
+{
+  std::mt19937 generator(42);
+  const SIFT_Regions lRegions = makeRandomRegions(generator, 1000, 640, 480);
+  const SIFT_Regions rRegions = makeRandomRegions(generator, 1000, 640, 480);
+  const matching::IndMatches inputMatches = makeRandomMatches(generator, 2000, 1000);
+
+  matching::IndMatches allMatches;
+  sortMatches_byFeaturesScale(inputMatches, lRegions, rRegions, allMatches);
+  BOOST_CHECK_EQUAL(allMatches.size(), inputMatches.size());
+
+  MatchesSelectionBuffers buffers;
+  matching::IndMatches bestMatches;
+  sortMatches_byFeaturesScale(inputMatches, lRegions, rRegions, bestMatches, buffers, 100);
+  BOOST_REQUIRE_EQUAL(bestMatches.size(), 100);
+
+  for(std::size_t i = 0; i < bestMatches.size(); ++i)
+  {
+    const float bestScale = lRegions.Features()[bestMatches[i]._i].scale() + rRegions.Features()[bestMatches[i]._j].scale();
+    const float scale = lRegions.Features()[allMatches[i]._i].scale() + rRegions.Features()[allMatches[i]._j].scale();
+    BOOST_CHECK_EQUAL(bestScale, scale);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FeaturesSelection_gridFiltering)
+{
+  std::mt19937 generator(42);
+  const std::size_t width = 640;
+  const std::size_t height = 480;
+  const SIFT_Regions lRegions = makeRandomRegions(generator, 1000, width, height);
+  const SIFT_Regions rRegions = makeRandomRegions(generator, 1000, width, height);
+  const matching::IndMatches inputMatches = makeRandomMatches(generator, 2000, 1000);
+
+  MatchesSelectionBuffers buffers;
+  matching::IndMatches filteredMatches = inputMatches;
+  matchesGridFiltering(lRegions, width, height, rRegions, width, height, filteredMatches, buffers);
+
+  // all the matches are kept, only the order changes
+  BOOST_REQUIRE_EQUAL(filteredMatches.size(), inputMatches.size());
+  {
+    matching::IndMatches sortedInput = inputMatches;
+    matching::IndMatches sortedFiltered = filteredMatches;
+    std::sort(sortedInput.begin(), sortedInput.end());
+    std::sort(sortedFiltered.begin(), sortedFiltered.end());
+    BOOST_CHECK(sortedInput == sortedFiltered);
+  }
+
+  // the first matches cover all the left picture cells
+  {
+    std::set<std::pair<int, int>> cells;
+    for(std::size_t i = 0; i < 18; ++i)
+    {
+      const SIOPointFeature& point = lRegions.Features()[filteredMatches[i]._i];
+      cells.emplace(clamp(int(point.x() / (width / 3.f)), 0, 2), clamp(int(point.y() / (height / 3.f)), 0, 2));
+    }
+    BOOST_CHECK_EQUAL(cells.size(), 9);
+  }
+
+  // same result with a maximum number of matches and reused buffers
+  matching::IndMatches bestMatches = inputMatches;
+  matchesGridFiltering(lRegions, width, height, rRegions, width, height, bestMatches, buffers, 100);
+  BOOST_REQUIRE_EQUAL(bestMatches.size(), 100);
+  BOOST_CHECK(std::equal(bestMatches.begin(), bestMatches.end(), filteredMatches.begin()));
+}
@@ -77,6 +77,15 @@ public:
     return _imageDescriberImpl->getMemoryConsumption(width, height);
   }
 
+  /**
+   * @brief Get the maximum number of regions extracted from one image
+   * @return the maximum number of regions, 0 if there is no limit
+   */
+  std::size_t getMaxTotalKeypoints() const override
+  {
+    return _imageDescriberImpl->getMaxTotalKeypoints();
+  }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -100,6 +109,7 @@ public:
     {
       _imageDescriberImpl.release(); // release first to ensure that we don't create the new ImageDescriber before destroying the previous one
       _imageDescriberImpl.reset(new ImageDescriber_SIFT_popSIFT(_params, _isOriented));
+      _imageDescriberImpl->setCudaDevice(_cudaDevice);
       return;
     }
 #endif
@@ -117,6 +127,16 @@ public:
     _imageDescriberImpl->setCudaPipe(pipe);
   }
 
+  /**
+   * @brief Set the CUDA device
+   * @param[in] device The CUDA device id
+   */
+  void setCudaDevice(int device) override
+  {
+    _cudaDevice = device;
+    _imageDescriberImpl->setCudaDevice(device);
+  }
+
   /**
    * @brief Use a preset to control the number of detected regions
    * @param[in] preset The preset configuration
@@ -170,6 +190,7 @@ private:
   SiftParams _params;
   std::unique_ptr<ImageDescriber> _imageDescriberImpl = nullptr;
   bool _isOriented = true;
+  int _cudaDevice = 0;
 };
 
 } // namespace feature
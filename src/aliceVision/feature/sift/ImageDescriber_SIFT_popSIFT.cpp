@@ -17,22 +17,25 @@
 namespace aliceVision {
 namespace feature {
 
-std::unique_ptr<PopSift> ImageDescriber_SIFT_popSIFT::_popSift = nullptr;
+std::map<int, std::unique_ptr<PopSift>> ImageDescriber_SIFT_popSIFT::_popSift;
+std::mutex ImageDescriber_SIFT_popSIFT::_popSiftMutex;
 
 void ImageDescriber_SIFT_popSIFT::setConfigurationPreset(EImageDescriberPreset preset)
 {
     _params.setPreset(preset);
-    _popSift.reset(nullptr); // reset by describe method
+    std::lock_guard<std::mutex> lock(_popSiftMutex);
+    _popSift.clear(); // reset by describe method
 }
 
 bool ImageDescriber_SIFT_popSIFT::describe(const image::Image<float>& image,
                                       std::unique_ptr<Regions>& regions,
                                       const image::Image<unsigned char>* mask)
 {
-  if(_popSift == nullptr)
-    resetConfiguration();
+  PopSift& popSift = getPopSift();
 
-  std::unique_ptr<SiftJob> job(_popSift->enqueue(image.Width(), image.Height(), &image(0,0)));
+  // the image is uploaded and processed asynchronously by the PopSift pipeline,
+  // other threads can enqueue their images while this one waits for its features
+  std::unique_ptr<SiftJob> job(popSift.enqueue(image.Width(), image.Height(), &image(0,0)));
   std::unique_ptr<popsift::Features> popFeatures(job->get());
 
   allocate(regions);
@@ -71,14 +74,25 @@ bool ImageDescriber_SIFT_popSIFT::describe(const image::Image<float>& image,
   return true;
 }
 
+PopSift& ImageDescriber_SIFT_popSIFT::getPopSift()
+{
+  std::lock_guard<std::mutex> lock(_popSiftMutex);
+
+  if(_popSift[_cudaDevice] == nullptr)
+    resetConfiguration();
+
+  return *_popSift.at(_cudaDevice);
+}
+
 void ImageDescriber_SIFT_popSIFT::resetConfiguration()
 {
   // destroy all allocations and reset all state
   // on the current device in the current process
+  cudaSetDevice(_cudaDevice);
   cudaDeviceReset();
 
   popsift::cuda::device_prop_t deviceInfo;
-  deviceInfo.set(0, true); // use only the first device & print informations
+  deviceInfo.set(_cudaDevice, true); // use only the selected device & print informations
 
   // reset configuration
   popsift::Config config;
@@ -92,7 +106,7 @@ void ImageDescriber_SIFT_popSIFT::resetConfiguration()
   config.setFilterMaxExtrema(_params._maxTotalKeypoints);
   config.setFilterSorting(popsift::Config::LargestScaleFirst);
 
-  _popSift.reset(new PopSift(config, popsift::Config::ExtractingMode, PopSift::FloatImages));
+  _popSift[_cudaDevice].reset(new PopSift(config, popsift::Config::ExtractingMode, PopSift::FloatImages, _cudaDevice));
 }
 
 } // namespace feature
@@ -13,6 +13,8 @@
 #include <aliceVision/feature/sift/SIFT.hpp>
 
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <numeric>
 
 class PopSift;
@@ -73,6 +75,15 @@ public:
     return 3 * width * height * sizeof(float); //  GPU only
   }
 
+  /**
+   * @brief Get the maximum number of regions extracted from one image
+   * @return the maximum number of regions, 0 if there is no limit
+   */
+  std::size_t getMaxTotalKeypoints() const override
+  {
+    return _params._maxTotalKeypoints;
+  }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -82,6 +93,15 @@ public:
     _isOriented = !upRight;
   }
 
+  /**
+   * @brief Set the CUDA device used by PopSIFT
+   * @param[in] device The CUDA device id
+   */
+  void setCudaDevice(int device) override
+  {
+    _cudaDevice = device;
+  }
+
   /**
    * @brief Use a preset to control the number of detected regions
    * @param[in] preset The preset configuration
@@ -111,11 +131,21 @@ public:
 
 private:
 
+  /**
+   * @brief Get the PopSift instance of the current CUDA device, create it if needed
+   * @note Thread safe, the PopSift instance can be shared by several threads
+   *       to keep several images in its upload/extraction pipeline.
+   */
+  PopSift& getPopSift();
+
   void resetConfiguration();
 
   SiftParams _params;
   bool _isOriented = true;
-  static std::unique_ptr<PopSift> _popSift;
+  int _cudaDevice = 0;
+  /// one PopSift instance per CUDA device
+  static std::map<int, std::unique_ptr<PopSift>> _popSift;
+  static std::mutex _popSiftMutex;
 };
 
 } // namespace feature
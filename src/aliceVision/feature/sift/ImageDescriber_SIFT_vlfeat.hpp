@@ -83,6 +83,15 @@ public:
     return getMemoryConsumptionVLFeat(width, height, _params);
   }
 
+  /**
+   * @brief Get the maximum number of regions extracted from one image
+   * @return the maximum number of regions, 0 if there is no limit
+   */
+  std::size_t getMaxTotalKeypoints() const override
+  {
+    return (_params._gridSize && _params._maxTotalKeypoints) ? _params._maxTotalKeypoints : 0;
+  }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -113,7 +122,7 @@ public:
     std::unique_ptr<Regions>& regions,
     const image::Image<unsigned char>* mask = nullptr) override
   {
-    return extractSIFT<unsigned char>(image, regions, _params, _isOriented, mask);
+    return extractSIFT<unsigned char>(image, regions, _params, _isOriented, mask, _stagesTimings);
   }
 
 
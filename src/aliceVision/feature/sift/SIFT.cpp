@@ -36,7 +36,10 @@ void VLFeatInstance::initialize()
 {
   assert(nbInstances >= 0);
   if(nbInstances <= 0)
+  {
     vl_constructor();
+    ALICEVISION_LOG_DEBUG("VLFeat SIFT scale space: " << (system::cpu_has_avx2() ? "AVX2" : "default") << " code path.");
+  }
   ++nbInstances;
 }
 
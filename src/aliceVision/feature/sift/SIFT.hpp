@@ -12,6 +12,8 @@
 #include <aliceVision/feature/regionsFactory.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cpu.hpp>
+#include <aliceVision/system/Timer.hpp>
 
 extern "C" {
 #include "nonFree/sift/vl/sift.h"
@@ -190,6 +192,7 @@ std::size_t getMemoryConsumptionVLFeat(std::size_t width, std::size_t height, co
  * @param params
  * @param orientation
  * @param mask
+ * @param timings Optional extraction stages timings
  * @return
  */
 template <typename T>
@@ -197,7 +200,8 @@ bool extractSIFT(const image::Image<float>& image,
     std::unique_ptr<Regions>& regions,
     const SiftParams& params,
     bool orientation,
-    const image::Image<unsigned char>* mask)
+    const image::Image<unsigned char>* mask,
+    ExtractionStagesTimings* timings = nullptr)
 {
   const int w = image.Width(), h = image.Height();
   VlSiftFilt *filt = vl_sift_new(w, h, params._numOctaves, params._numScales, params._firstOctave);
@@ -205,13 +209,20 @@ bool extractSIFT(const image::Image<float>& image,
     vl_sift_set_edge_thresh(filt, params._edgeThreshold);
   if (params._peakThreshold >= 0)
     vl_sift_set_peak_thresh(filt, params._peakThreshold/params._numScales);
+  // Use the vectorized scale space if the CPU allows it
+  vl_sift_set_avx2_enabled(filt, system::cpu_has_avx2());
 
   Descriptor<vl_sift_pix, 128> vlFeatDescriptor;
   Descriptor<T, 128> descriptor;
 
+  system::Timer timer;
+
   // Process SIFT computation
   vl_sift_process_first_octave(filt, image.data());
 
+  if(timings)
+    timings->pyramid += timer.elapsed();
+
   typedef ScalarRegions<SIOPointFeature,T,128> SIFT_Region_T;
   regions.reset( new SIFT_Region_T );
   
@@ -222,20 +233,36 @@ bool extractSIFT(const image::Image<float>& image,
   regionsCasted->Features().reserve(reserveSize);
   regionsCasted->Descriptors().reserve(reserveSize);
 
+  // from 1 to 4 orientations per keypoint, 0 for the masked keypoints
+  std::vector<double> keysAngles;
+  std::vector<int> keysNbAngles;
+
   while (true)
   {
+    timer.reset();
     vl_sift_detect(filt);
 
     VlSiftKeypoint const *keys  = vl_sift_get_keypoints(filt);
     const int nkeys = vl_sift_get_nkeypoints(filt);
 
+    if(timings)
+      timings->detection += timer.elapsed();
+
+    timer.reset();
+
     // Update gradient before launching parallel extraction
     vl_sift_update_gradient(filt);
 
-    #pragma omp parallel for private(vlFeatDescriptor, descriptor)
+    if(timings)
+      timings->pyramid += timer.elapsed();
+
+    timer.reset();
+    keysAngles.assign(4 * nkeys, 0.0);
+    keysNbAngles.assign(nkeys, 0);
+
+    #pragma omp parallel for
     for (int i = 0; i < nkeys; ++i)
     {
-
       // Feature masking
       if (mask)
       {
@@ -244,18 +271,30 @@ bool extractSIFT(const image::Image<float>& image,
           continue;
       }
 
-      double angles [4] = {0.0, 0.0, 0.0, 0.0};
-      int nangles = 1; // by default (1 upright feature)
       if (orientation)
       { // compute from 1 to 4 orientations
-        nangles = vl_sift_calc_keypoint_orientations(filt, angles, keys+i);
+        keysNbAngles[i] = vl_sift_calc_keypoint_orientations(filt, &keysAngles[4 * i], keys+i);
       }
+      else
+      { // 1 upright feature
+        keysNbAngles[i] = 1;
+      }
+    }
 
-      for (int q=0 ; q < nangles ; ++q)
+    if(timings)
+      timings->orientation += timer.elapsed();
+
+    timer.reset();
+
+    #pragma omp parallel for private(vlFeatDescriptor, descriptor)
+    for (int i = 0; i < nkeys; ++i)
+    {
+      for (int q=0 ; q < keysNbAngles[i] ; ++q)
       {
-        vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptor[0], keys+i, angles[q]);
+        const double angle = keysAngles[4 * i + q];
+        vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptor[0], keys+i, angle);
         const SIOPointFeature fp(keys[i].x, keys[i].y,
-          keys[i].sigma, static_cast<float>(angles[q]));
+          keys[i].sigma, static_cast<float>(angle));
 
         convertSIFT<T>(&vlFeatDescriptor[0], descriptor, params._rootSift);
         
@@ -267,8 +306,17 @@ bool extractSIFT(const image::Image<float>& image,
         
       }
     }
-    
-    if (vl_sift_process_next_octave(filt))
+
+    if(timings)
+      timings->description += timer.elapsed();
+
+    timer.reset();
+    const bool lastOctave = vl_sift_process_next_octave(filt);
+
+    if(timings)
+      timings->pyramid += timer.elapsed();
+
+    if (lastOctave)
       break; // Last octave
   }
   vl_sift_delete(filt);
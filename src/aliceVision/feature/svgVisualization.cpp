@@ -28,6 +28,7 @@ std::string describerTypeColor(feature::EImageDescriberType descType )
     case feature::EImageDescriberType::AKAZE:          return "purple";
     case feature::EImageDescriberType::AKAZE_LIOP:     return "purple";
     case feature::EImageDescriberType::AKAZE_MLDB:     return "purple";
+    case feature::EImageDescriberType::AKAZE_UCHAR:    return "purple";
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
     case feature::EImageDescriberType::CCTAG3:         return "blue";
     case feature::EImageDescriberType::CCTAG4:         return "blue";
@@ -0,0 +1,200 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "tiledExtraction.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace aliceVision {
+namespace feature {
+
+std::vector<ImageTile> computeImageTiles(int width, int height, int tileSize, int tileOverlap)
+{
+  std::vector<ImageTile> tiles;
+
+  if(width <= 0 || height <= 0)
+    return tiles;
+
+  // no tiling or the image fits in one tile
+  if(tileSize <= 0 || (width <= tileSize && height <= tileSize))
+  {
+    ImageTile tile;
+    tile.width = tile.coreWidth = width;
+    tile.height = tile.coreHeight = height;
+    tiles.push_back(tile);
+    return tiles;
+  }
+
+  const int overlap = std::max(0, tileOverlap);
+  const int nbTilesX = (width + tileSize - 1) / tileSize;
+  const int nbTilesY = (height + tileSize - 1) / tileSize;
+
+  tiles.reserve(nbTilesX * nbTilesY);
+
+  for(int ty = 0; ty < nbTilesY; ++ty)
+  {
+    for(int tx = 0; tx < nbTilesX; ++tx)
+    {
+      ImageTile tile;
+      tile.coreX = tx * tileSize;
+      tile.coreY = ty * tileSize;
+      tile.coreWidth = std::min(tileSize, width - tile.coreX);
+      tile.coreHeight = std::min(tileSize, height - tile.coreY);
+
+      tile.x = std::max(0, tile.coreX - overlap);
+      tile.y = std::max(0, tile.coreY - overlap);
+      tile.width = std::min(width, tile.coreX + tile.coreWidth + overlap) - tile.x;
+      tile.height = std::min(height, tile.coreY + tile.coreHeight + overlap) - tile.y;
+
+      tiles.push_back(tile);
+    }
+  }
+  return tiles;
+}
+
+std::unique_ptr<Regions> selectTileCoreRegions(const Regions& tileRegions, const ImageTile& tile)
+{
+  std::unique_ptr<Regions> coreRegions(tileRegions.EmptyClone());
+
+  // core rectangle in the tile coordinates
+  const double coreMinX = tile.coreX - tile.x;
+  const double coreMinY = tile.coreY - tile.y;
+  const double coreMaxX = coreMinX + tile.coreWidth;
+  const double coreMaxY = coreMinY + tile.coreHeight;
+
+  for(std::size_t i = 0; i < tileRegions.RegionCount(); ++i)
+  {
+    const Vec2 position = tileRegions.GetRegionPosition(i);
+
+    if(position.x() >= coreMinX && position.x() < coreMaxX &&
+       position.y() >= coreMinY && position.y() < coreMaxY)
+      tileRegions.CopyRegion(i, coreRegions.get());
+  }
+
+  coreRegions->translateRegions(Vec2f(tile.x, tile.y));
+  return coreRegions;
+}
+
+void mergeTilesRegions(const std::vector<std::unique_ptr<Regions>>& tilesRegions,
+                       const std::vector<ImageTile>& tiles,
+                       std::size_t maxTotalKeypoints,
+                       std::unique_ptr<Regions>& regions)
+{
+  assert(tilesRegions.size() == tiles.size());
+  assert(!tilesRegions.empty());
+
+  const std::size_t nbTiles = tilesRegions.size();
+
+  std::size_t nbRegions = 0;
+  for(const auto& tileRegions : tilesRegions)
+    nbRegions += tileRegions->RegionCount();
+
+  // number of regions taken from each tile
+  std::vector<std::size_t> nbSelected(nbTiles, 0);
+
+  if(maxTotalKeypoints == 0 || nbRegions <= maxTotalKeypoints)
+  {
+    for(std::size_t t = 0; t < nbTiles; ++t)
+      nbSelected[t] = tilesRegions[t]->RegionCount();
+  }
+  else
+  {
+    double imageArea = 0.0;
+    for(const ImageTile& tile : tiles)
+      imageArea += static_cast<double>(tile.coreWidth) * tile.coreHeight;
+
+    // budget proportional to the tile core area
+    std::size_t budget = maxTotalKeypoints;
+    for(std::size_t t = 0; t < nbTiles; ++t)
+    {
+      const std::size_t tileBudget = static_cast<std::size_t>(maxTotalKeypoints * (tiles[t].coreWidth * static_cast<double>(tiles[t].coreHeight)) / imageArea);
+      nbSelected[t] = std::min(tileBudget, tilesRegions[t]->RegionCount());
+      budget -= nbSelected[t];
+    }
+
+    // share the budget left by the tiles with few regions between the tiles with remaining regions
+    while(budget > 0)
+    {
+      std::size_t nbTilesLeft = 0;
+      for(std::size_t t = 0; t < nbTiles; ++t)
+        if(nbSelected[t] < tilesRegions[t]->RegionCount())
+          ++nbTilesLeft;
+
+      if(nbTilesLeft == 0)
+        break;
+
+      const std::size_t tileBudget = std::max(std::size_t(1), budget / nbTilesLeft);
+      for(std::size_t t = 0; t < nbTiles && budget > 0; ++t)
+      {
+        const std::size_t extra = std::min({tileBudget, budget, tilesRegions[t]->RegionCount() - nbSelected[t]});
+        nbSelected[t] += extra;
+        budget -= extra;
+      }
+    }
+  }
+
+  regions.reset(tilesRegions.front()->EmptyClone());
+
+  for(std::size_t t = 0; t < nbTiles; ++t)
+    for(std::size_t i = 0; i < nbSelected[t]; ++i)
+      tilesRegions[t]->CopyRegion(i, regions.get());
+}
+
+std::size_t getTiledMemoryConsumption(const ImageDescriber& imageDescriber,
+                                      std::size_t width,
+                                      std::size_t height,
+                                      int tileSize,
+                                      int tileOverlap,
+                                      const ImageDescriberMemoryProfile* memoryProfile)
+{
+  const auto describerMemoryConsumption = [&](std::size_t w, std::size_t h)
+  {
+    if(memoryProfile != nullptr)
+      return memoryProfile->getMemoryConsumption(imageDescriber, w, h);
+    return imageDescriber.getMemoryConsumption(w, h);
+  };
+
+  const std::vector<ImageTile> tiles = computeImageTiles(width, height, tileSize, tileOverlap);
+
+  if(tiles.size() <= 1)
+    return describerMemoryConsumption(width, height);
+
+  std::size_t tileMaxWidth = 0;
+  std::size_t tileMaxHeight = 0;
+  for(const ImageTile& tile : tiles)
+  {
+    tileMaxWidth = std::max(tileMaxWidth, static_cast<std::size_t>(tile.width));
+    tileMaxHeight = std::max(tileMaxHeight, static_cast<std::size_t>(tile.height));
+  }
+
+  // the full image stays in memory (float and 8-bit buffers) during the extraction of the tiles
+  const std::size_t imageMemory = width * height * (sizeof(float) + sizeof(unsigned char));
+
+  return imageMemory + describerMemoryConsumption(tileMaxWidth, tileMaxHeight);
+}
+
+bool describeImage(ImageDescriber& imageDescriber,
+                   const image::Image<float>& imageGrayFloat,
+                   image::Image<unsigned char>& imageGrayUChar,
+                   std::unique_ptr<Regions>& regions,
+                   int tileSize,
+                   int tileOverlap)
+{
+  const int describerTileSize = useTiledExtraction(imageDescriber.getDescriberType(), tileSize) ? tileSize : 0;
+
+  // image buffer use float image, use the read buffer
+  if(imageDescriber.useFloatImage())
+    return describeTiled(imageDescriber, imageGrayFloat, regions, describerTileSize, tileOverlap);
+
+  // image buffer can't use float image
+  if(imageGrayUChar.Width() == 0) // the first time, convert the float buffer to uchar
+    imageGrayUChar = (imageGrayFloat.GetMat() * 255.f).cast<unsigned char>();
+  return describeTiled(imageDescriber, imageGrayUChar, regions, describerTileSize, tileOverlap);
+}
+
+} // namespace feature
+} // namespace aliceVision
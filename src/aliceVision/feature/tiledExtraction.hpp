@@ -0,0 +1,175 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/memoryProfile.hpp>
+#include <aliceVision/feature/Regions.hpp>
+#include <aliceVision/image/Image.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief An overlapping tile of an image used for tiled feature extraction.
+ *
+ * The image is split into non-overlapping cores, each tile is its core
+ * extended by the overlap on each side (clamped to the image).
+ * A region detected in a tile is kept only if it lies in the tile core,
+ * so a region detected twice in the overlap of two tiles is kept once.
+ */
+struct ImageTile
+{
+  /// tile rectangle in the image [x, x + width[ x [y, y + height[
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+  /// tile core rectangle in the image [coreX, coreX + coreWidth[ x [coreY, coreY + coreHeight[
+  int coreX = 0;
+  int coreY = 0;
+  int coreWidth = 0;
+  int coreHeight = 0;
+};
+
+/**
+ * @brief Split an image into overlapping tiles
+ * @param[in] width The image width
+ * @param[in] height The image height
+ * @param[in] tileSize The size of a tile core (in pixels), 0 to disable tiling
+ * @param[in] tileOverlap The overlap added on each side of a tile core (in pixels)
+ * @return the image tiles, a single tile covering the whole image if no tiling is needed
+ */
+std::vector<ImageTile> computeImageTiles(int width, int height, int tileSize, int tileOverlap);
+
+/**
+ * @brief Keep the regions of a tile that lie in its core and move them in the image coordinates
+ * @param[in] tileRegions The regions extracted from the tile image
+ * @param[in] tile The image tile
+ * @return the regions of the tile core in the image coordinates
+ */
+std::unique_ptr<Regions> selectTileCoreRegions(const Regions& tileRegions, const ImageTile& tile);
+
+/**
+ * @brief Merge the regions of all the tiles of an image
+ *
+ * If maxTotalKeypoints is set, each tile gets a part of the budget proportional to its core area
+ * and the budget not used by the tiles with few regions is shared between the others.
+ * The regions of each tile are taken in the order given by the image describer.
+ *
+ * @param[in] tilesRegions The regions of each tile core (see selectTileCoreRegions)
+ * @param[in] tiles The image tiles
+ * @param[in] maxTotalKeypoints The maximum number of regions, 0 if there is no limit
+ * @param[out] regions The merged regions
+ */
+void mergeTilesRegions(const std::vector<std::unique_ptr<Regions>>& tilesRegions,
+                       const std::vector<ImageTile>& tiles,
+                       std::size_t maxTotalKeypoints,
+                       std::unique_ptr<Regions>& regions);
+
+/**
+ * @brief Get the memory needed to extract the features of an image with tiles
+ * @param[in] imageDescriber The image describer
+ * @param[in] width The image width
+ * @param[in] height The image height
+ * @param[in] tileSize The size of a tile core (in pixels), 0 to disable tiling
+ * @param[in] tileOverlap The overlap added on each side of a tile core (in pixels)
+ * @param[in] memoryProfile The measured memory profile of the describers (optional)
+ * @return total amount of memory needed
+ */
+std::size_t getTiledMemoryConsumption(const ImageDescriber& imageDescriber,
+                                      std::size_t width,
+                                      std::size_t height,
+                                      int tileSize,
+                                      int tileOverlap,
+                                      const ImageDescriberMemoryProfile* memoryProfile = nullptr);
+
+/**
+ * @brief Detect regions on the image tile by tile and compute their attributes (description)
+ *
+ * Only one tile image and its pyramid are in memory at a time, so the peak memory
+ * of the image describer depends on the tile size instead of the image size.
+ *
+ * @param[in] imageDescriber The image describer
+ * @param[in] image The image (8-bit or float)
+ * @param[out] regions The detected regions and attributes
+ * @param[in] tileSize The size of a tile core (in pixels), 0 to disable tiling
+ * @param[in] tileOverlap The overlap added on each side of a tile core (in pixels)
+ * @param[in] mask 8-bit grayscale image for keypoint filtering (optional)
+ */
+template<typename T>
+bool describeTiled(ImageDescriber& imageDescriber,
+                   const image::Image<T>& image,
+                   std::unique_ptr<Regions>& regions,
+                   int tileSize,
+                   int tileOverlap,
+                   const image::Image<unsigned char>* mask = nullptr)
+{
+  const std::vector<ImageTile> tiles = computeImageTiles(image.Width(), image.Height(), tileSize, tileOverlap);
+
+  if(tiles.size() <= 1)
+    return imageDescriber.describe(image, regions, mask);
+
+  std::vector<std::unique_ptr<Regions>> tilesRegions;
+  tilesRegions.reserve(tiles.size());
+
+  for(const ImageTile& tile : tiles)
+  {
+    const image::Image<T> tileImage(image.block(tile.y, tile.x, tile.height, tile.width));
+    image::Image<unsigned char> tileMask;
+
+    if(mask != nullptr)
+      tileMask = mask->block(tile.y, tile.x, tile.height, tile.width);
+
+    std::unique_ptr<Regions> tileRegions;
+    if(!imageDescriber.describe(tileImage, tileRegions, (mask != nullptr) ? &tileMask : nullptr))
+      return false;
+
+    tilesRegions.push_back(selectTileCoreRegions(*tileRegions, tile));
+  }
+
+  mergeTilesRegions(tilesRegions, tiles, imageDescriber.getMaxTotalKeypoints(), regions);
+  return true;
+}
+
+/**
+ * @brief Check if the features of the given describer type are extracted tile by tile
+ * @param[in] imageDescriberType The image describer type
+ * @param[in] tileSize The size of a tile (0 if tiled extraction is disabled)
+ * @return true if the tiled extraction is used
+ */
+inline bool useTiledExtraction(EImageDescriberType imageDescriberType, int tileSize)
+{
+  // markers can be larger than the tile overlap, they are always extracted on the full image
+  return tileSize > 0 && !isMarker(imageDescriberType);
+}
+
+/**
+ * @brief Detect and describe the regions of a grayscale image, as featureExtraction does:
+ *        on the float image or its 8-bit conversion depending on the image describer,
+ *        tile by tile if useTiledExtraction
+ * @param[in] imageDescriber The image describer
+ * @param[in] imageGrayFloat The grayscale image (0..1)
+ * @param[in,out] imageGrayUChar The 8-bit conversion of imageGrayFloat, computed on the first use if empty,
+ *                so that it is shared by the image describers of the same image
+ * @param[out] regions The detected regions and attributes
+ * @param[in] tileSize The size of a tile core (in pixels), 0 to disable tiling
+ * @param[in] tileOverlap The overlap added on each side of a tile core (in pixels)
+ */
+bool describeImage(ImageDescriber& imageDescriber,
+                   const image::Image<float>& imageGrayFloat,
+                   image::Image<unsigned char>& imageGrayUChar,
+                   std::unique_ptr<Regions>& regions,
+                   int tileSize,
+                   int tileOverlap);
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,93 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/tiledExtraction.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <vector>
+
+#define BOOST_TEST_MODULE TiledExtraction
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+BOOST_AUTO_TEST_CASE(TiledExtraction_noTiling)
+{
+  const std::vector<ImageTile> tiles = computeImageTiles(640, 480, 0, 32);
+  BOOST_CHECK_EQUAL(tiles.size(), 1);
+  BOOST_CHECK_EQUAL(tiles.front().width, 640);
+  BOOST_CHECK_EQUAL(tiles.front().height, 480);
+
+  // image smaller than a tile
+  BOOST_CHECK_EQUAL(computeImageTiles(640, 480, 1000, 32).size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(TiledExtraction_tilesCoverImage)
+{
+  const int width = 1030;
+  const int height = 700;
+  const int tileSize = 256;
+  const int overlap = 40;
+
+  const std::vector<ImageTile> tiles = computeImageTiles(width, height, tileSize, overlap);
+  BOOST_CHECK_EQUAL(tiles.size(), 5 * 3);
+
+  // each pixel belongs to exactly one tile core
+  std::vector<int> coverage(width * height, 0);
+  for(const ImageTile& tile : tiles)
+  {
+    BOOST_CHECK(tile.x >= 0 && tile.y >= 0);
+    BOOST_CHECK(tile.x + tile.width <= width);
+    BOOST_CHECK(tile.y + tile.height <= height);
+    BOOST_CHECK(tile.coreX - tile.x <= overlap);
+    BOOST_CHECK(tile.coreY - tile.y <= overlap);
+
+    for(int y = tile.coreY; y < tile.coreY + tile.coreHeight; ++y)
+      for(int x = tile.coreX; x < tile.coreX + tile.coreWidth; ++x)
+        ++coverage[y * width + x];
+  }
+
+  for(int count : coverage)
+    BOOST_CHECK_EQUAL(count, 1);
+}
+
+BOOST_AUTO_TEST_CASE(TiledExtraction_mergeRegions)
+{
+  const std::vector<ImageTile> tiles = computeImageTiles(200, 100, 100, 20);
+  BOOST_CHECK_EQUAL(tiles.size(), 2);
+
+  // the same regions are detected in both tiles, in the tile coordinates
+  std::vector<std::unique_ptr<Regions>> tilesRegions;
+  for(const ImageTile& tile : tiles)
+  {
+    SIFT_Regions tileRegions;
+    for(int i = 0; i < tile.width; i += 2)
+    {
+      tileRegions.Features().emplace_back(i + 0.5f, 50.f, 1.f, 0.f);
+      tileRegions.Descriptors().emplace_back();
+    }
+    tilesRegions.push_back(selectTileCoreRegions(tileRegions, tile));
+  }
+
+  // a region in an overlap is only kept by the tile owning it
+  std::unique_ptr<Regions> regions;
+  mergeTilesRegions(tilesRegions, tiles, 0, regions);
+  BOOST_CHECK_EQUAL(regions->RegionCount(), 100);
+
+  const std::vector<SIOPointFeature>& features = getSIOPointFeatures(*regions);
+  for(std::size_t i = 0; i < features.size(); ++i)
+    BOOST_CHECK_CLOSE(features.at(i).x(), 2 * i + 0.5f, 1e-4);
+
+  // the budget is shared between the tiles
+  mergeTilesRegions(tilesRegions, tiles, 30, regions);
+  BOOST_CHECK_EQUAL(regions->RegionCount(), 30);
+
+  // the budget left by an empty tile goes to the other tiles
+  tilesRegions.front().reset(tilesRegions.front()->EmptyClone());
+  mergeTilesRegions(tilesRegions, tiles, 30, regions);
+  BOOST_CHECK_EQUAL(regions->RegionCount(), 30);
+}
@@ -7,16 +7,22 @@
 #include "DelaunayGraphCut.hpp"
 // #include <aliceVision/fuseCut/MaxFlow_CSR.hpp>
 #include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_PushRelabel.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/jetColorMap.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
-#include <aliceVision/mvsData/Universe.hpp>
+#include <aliceVision/mvsData/ParallelUniverse.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/mvsData/imageAlgo.hpp>
+#include <aliceVision/stl/hash.hpp>
+#include <aliceVision/system/Timer.hpp>
 #include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
+#include <aliceVision/system/ParallelReduce.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include "nanoflann.hpp"
 
@@ -25,6 +31,14 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
 // OpenMP >= 3.1 for advanced atomic clauses (https://software.intel.com/en-us/node/608160)
 // OpenMP preprocessor version: https://github.com/jeffhammond/HPCInfo/wiki/Preprocessor-Macros
 #if defined _OPENMP && _OPENMP >= 201107 
@@ -41,6 +55,68 @@ namespace fuseCut {
 
 namespace bfs = boost::filesystem;
 
+/**
+ * @brief Add a weight to a cell attribute, or record it if weights is not null.
+ */
+inline void addWeight(float& attribute, float weight, DelaunayGraphCut::WeightAdditions* weights)
+{
+    if(weights != nullptr)
+    {
+        weights->emplace_back(&attribute, weight);
+        return;
+    }
+    OMP_ATOMIC_UPDATE
+    attribute += weight;
+}
+
+/**
+ * @brief Call processVertex(vertexIndex, weights) on all the vertices in parallel.
+ *
+ * By default, the vertices are processed in a random order (to prevent waiting) and weights is null:
+ * the weights are added atomically, in an order depending on the threads scheduling.
+ * If deterministic, the weights recorded in weights by a block of vertices are added in the order of
+ * the vertices, the floating point sums do not depend on the number of threads.
+ */
+template <class ProcessVertex>
+void processVerticesWeights(int nbVertices, bool deterministic, const ProcessVertex& processVertex)
+{
+    if(!deterministic)
+    {
+        // choose random order to prevent waiting
+        StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(nbVertices);
+
+        #pragma omp parallel for
+        for(int i = 0; i < vetexesToProcessIdsRand->size(); ++i)
+            processVertex((*vetexesToProcessIdsRand)[i], nullptr);
+
+        delete vetexesToProcessIdsRand;
+        return;
+    }
+
+    // bound the memory of the recorded weights
+    const int blockSize = 16384;
+    std::vector<DelaunayGraphCut::WeightAdditions> weightsPerVertex(std::min(blockSize, nbVertices));
+
+    for(int blockStart = 0; blockStart < nbVertices; blockStart += blockSize)
+    {
+        const int blockEnd = std::min(nbVertices, blockStart + blockSize);
+
+        #pragma omp parallel for schedule(dynamic, 64)
+        for(int vi = blockStart; vi < blockEnd; ++vi)
+        {
+            DelaunayGraphCut::WeightAdditions& weights = weightsPerVertex[vi - blockStart];
+            weights.clear();
+            processVertex(vi, &weights);
+        }
+
+        for(int i = 0; i < blockEnd - blockStart; ++i)
+        {
+            for(const auto& weight : weightsPerVertex[i])
+                *weight.first += weight.second;
+        }
+    }
+}
+
 // #define USE_GEOGRAM_KDTREE 1
 
 #ifdef USE_GEOGRAM_KDTREE
@@ -290,9 +366,10 @@ void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<P
 
     omp_set_nested(1);
     #pragma omp parallel for num_threads(3)
-    for(int c = 0; c < cams.size(); ++c)
+    for(int ci = 0; ci < cams.size(); ++ci)
     {
-        ALICEVISION_LOG_INFO("Create visibilities (" << c << "/" << cams.size() << ")");
+        const int c = cams[ci];
+        ALICEVISION_LOG_INFO("Create visibilities (" << ci << "/" << cams.size() << ")");
         std::vector<float> depthMap;
         std::vector<float> simMap;
         int width, height;
@@ -388,6 +465,345 @@ void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<P
 }
 
 
+/// cell of the multi-resolution spatial hash: the scale level of the cell size and the cell coordinates
+struct SpatialHashKey
+{
+    int level;
+    int x;
+    int y;
+    int z;
+
+    bool operator==(const SpatialHashKey& other) const
+    {
+        return level == other.level && x == other.x && y == other.y && z == other.z;
+    }
+};
+
+struct SpatialHashKeyHasher
+{
+    std::size_t operator()(const SpatialHashKey& key) const
+    {
+        std::size_t seed = 0;
+        stl::hash_combine(seed, key.level);
+        stl::hash_combine(seed, key.x);
+        stl::hash_combine(seed, key.y);
+        stl::hash_combine(seed, key.z);
+        return seed;
+    }
+};
+
+/// depths merged in a cell of the spatial hash
+struct SpatialHashCell
+{
+    Point3d sumCoords;
+    double minPixSize = std::numeric_limits<double>::max();
+    float minSimScore = std::numeric_limits<float>::max();
+    int nbDepths = 0;
+    StaticVector<int> cams;
+};
+
+/**
+ * @brief Fuse the depth maps in a 3D spatial hash: each depth is merged in a cell of the size of its pixel (multiplied by the step),
+ *        at the scale level of this size. Replaces the initial filtering and the visibilities computation, without kd-tree
+ *        and with a single read of the depth maps.
+ */
+void fuseDepthMapsBySpatialHash(const StaticVector<int>& cams, const Point3d voxel[8], mvsUtils::MultiViewParams* mp, int step,
+                                float simFactor, float simGaussianSize,
+                                std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, std::vector<float>& simScorePrepare,
+                                std::vector<GC_vertexInfo>& verticesAttrPrepare)
+{
+    using SpatialHash = std::unordered_map<SpatialHashKey, SpatialHashCell, SpatialHashKeyHasher>;
+
+    // the hash is split in independent parts, locked separately
+    static const std::size_t nbParts = 4096;
+    std::vector<SpatialHash> hashParts(nbParts);
+    std::vector<omp_lock_t> locks(nbParts);
+    for(auto& lock: locks)
+        omp_init_lock(&lock);
+
+    omp_set_nested(1);
+    #pragma omp parallel for num_threads(3)
+    for(int ci = 0; ci < cams.size(); ++ci)
+    {
+        const int c = cams[ci];
+        ALICEVISION_LOG_INFO("Fuse depth map (" << ci << "/" << cams.size() << ")");
+        std::vector<float> depthMap;
+        std::vector<float> simMap;
+        int width, height;
+        {
+            const std::string depthMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::depthMap, 0);
+            imageIO::readImage(depthMapFilepath, width, height, depthMap, imageIO::EImageColorSpace::NO_CONVERSION);
+            if(depthMap.empty())
+            {
+                ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
+                continue;
+            }
+            int wTmp, hTmp;
+            const std::string simMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::simMap, 0);
+            imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap, imageIO::EImageColorSpace::NO_CONVERSION);
+            if(wTmp != width || hTmp != height)
+                throw std::runtime_error("Similarity map size doesn't match the depth map size: " + simMapFilepath + ", " + depthMapFilepath);
+            {
+                std::vector<float> simMapTmp(simMap.size());
+                imageAlgo::convolveImage(width, height, simMap, simMapTmp, "gaussian", simGaussianSize, simGaussianSize);
+                simMap.swap(simMapTmp);
+            }
+        }
+
+        #pragma omp parallel for
+        for(int y = 0; y < height; ++y)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                const std::size_t index = y * width + x;
+                const float depth = depthMap[index];
+                if(depth <= 0.0f)
+                    continue;
+
+                const Point3d p = mp->backproject(c, Point2d(x, y), depth);
+                if(voxel != nullptr && !mvsUtils::isPointInHexahedron(p, voxel))
+                    continue;
+
+                const double pixSize = mp->getCamPixelSize(p, c);
+                if(pixSize <= 0.0)
+                    continue;
+                const float simValue = simMap[index];
+                // remap similarity values from [-1;+1] to [+1;+simFactor]
+                // interpretation is [goodSimilarity;badSimilarity]
+                const float simScore = simValue < -1.0f ? 1.0f : 1.0f + (1.0f + simValue) * simFactor;
+
+                // the cells of a level have a size of 2^level
+                SpatialHashKey key;
+                key.level = static_cast<int>(std::floor(std::log2(pixSize * step)));
+                const double cellSize = std::ldexp(1.0, key.level);
+                key.x = static_cast<int>(std::floor(p.x / cellSize));
+                key.y = static_cast<int>(std::floor(p.y / cellSize));
+                key.z = static_cast<int>(std::floor(p.z / cellSize));
+
+                const std::size_t part = SpatialHashKeyHasher()(key) % nbParts;
+                omp_set_lock(&locks[part]);
+                {
+                    SpatialHashCell& cell = hashParts[part][key];
+                    cell.sumCoords = cell.sumCoords + p;
+                    cell.minPixSize = std::min(cell.minPixSize, pixSize);
+                    cell.minSimScore = std::min(cell.minSimScore, simScore);
+                    ++cell.nbDepths;
+                    cell.cams.push_back_distinct(c);
+                }
+                omp_unset_lock(&locks[part]);
+            }
+        }
+    }
+    omp_set_nested(0);
+
+    for(auto& lock: locks)
+        omp_destroy_lock(&lock);
+
+    std::size_t nbCells = 0;
+    for(const SpatialHash& hashPart: hashParts)
+        nbCells += hashPart.size();
+
+    verticesCoordsPrepare.clear();
+    verticesCoordsPrepare.reserve(nbCells);
+    pixSizePrepare.clear();
+    pixSizePrepare.reserve(nbCells);
+    simScorePrepare.clear();
+    simScorePrepare.reserve(nbCells);
+    verticesAttrPrepare.clear();
+    verticesAttrPrepare.reserve(nbCells);
+
+    for(SpatialHash& hashPart: hashParts)
+    {
+        for(auto& keyCell: hashPart)
+        {
+            SpatialHashCell& cell = keyCell.second;
+            verticesCoordsPrepare.push_back(cell.sumCoords / double(cell.nbDepths));
+            pixSizePrepare.push_back(cell.minPixSize);
+            simScorePrepare.push_back(cell.minSimScore);
+
+            GC_vertexInfo v;
+            v.nrc = cell.nbDepths;
+            v.cams.swap(cell.cams);
+            verticesAttrPrepare.push_back(std::move(v));
+        }
+        SpatialHash().swap(hashPart);
+    }
+    ALICEVISION_LOG_INFO("Depth maps fused in " << nbCells << " points.");
+}
+
+/**
+ * @brief Kd-tree of the vertices coordinates.
+ */
+struct DelaunayGraphCut::VerticesKdTree
+{
+#ifdef USE_GEOGRAM_KDTREE
+    explicit VerticesKdTree(const std::vector<Point3d>& verticesCoords)
+        : coords(verticesCoords)
+        , kdTree(3)
+    {
+        // geogram keeps a pointer to the coordinates, they are copied as new vertices can be added
+        kdTree.set_exact(false);
+        kdTree.set_points(coords.size(), coords[0].m);
+    }
+
+    const std::vector<Point3d> coords;
+    GEO::AdaptiveKdTree kdTree;
+#else
+    explicit VerticesKdTree(const std::vector<Point3d>& verticesCoords)
+        : pointCloudRef(verticesCoords)
+        , kdTree(3 /*dim*/, pointCloudRef, nanoflann::KDTreeSingleIndexAdaptorParams(MAX_LEAF_ELEMENTS))
+    {
+        kdTree.buildIndex();
+    }
+
+    PointVectorAdaptator pointCloudRef;
+    KdTree kdTree;
+#endif
+};
+
+/// stages of the checkpoints files
+enum ECheckpointStage
+{
+    eCheckpointDensePointCloud = 0,
+    eCheckpointTetrahedralization = 1,
+    eCheckpointGraph = 2,
+};
+
+static const std::uint32_t CHECKPOINT_MAGIC = 0x4B434744; // "DGCK"
+static const std::uint32_t CHECKPOINT_VERSION = 1;
+
+/**
+ * @brief Checkpoint content, serialized in memory so it can be written in the background
+ *        while the reconstruction modifies the data.
+ */
+class CheckpointWriter
+{
+public:
+    explicit CheckpointWriter(ECheckpointStage stage)
+    {
+        write(CHECKPOINT_MAGIC);
+        write(CHECKPOINT_VERSION);
+        write(std::uint32_t(stage));
+    }
+
+    template <class T>
+    void write(const T& value)
+    {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        _data.insert(_data.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <class T>
+    void writeArray(const std::vector<T>& values)
+    {
+        write(std::uint64_t(values.size()));
+        const char* bytes = reinterpret_cast<const char*>(values.data());
+        _data.insert(_data.end(), bytes, bytes + values.size() * sizeof(T));
+    }
+
+    /// write to a temporary file renamed at the end, so an interrupted writing never leaves a truncated checkpoint
+    bool save(const std::string& filepath) const
+    {
+        const std::string tmpFilepath = filepath + "." + bfs::unique_path().string();
+        FILE* f = fopen(tmpFilepath.c_str(), "wb");
+        if(f == nullptr)
+            return false;
+        const bool written = (fwrite(_data.data(), 1, _data.size(), f) == _data.size());
+        if(fclose(f) != 0 || !written)
+        {
+            bfs::remove(tmpFilepath);
+            return false;
+        }
+        bfs::rename(tmpFilepath, filepath);
+        return true;
+    }
+
+private:
+    std::vector<char> _data;
+};
+
+/**
+ * @brief Read a checkpoint file written by CheckpointWriter, throw std::runtime_error if it is invalid.
+ */
+class CheckpointReader
+{
+public:
+    CheckpointReader(const std::string& filepath, ECheckpointStage stage)
+    {
+        FILE* f = fopen(filepath.c_str(), "rb");
+        if(f == nullptr)
+            throw std::runtime_error("Unable to open the checkpoint: " + filepath);
+        _data.resize(bfs::file_size(filepath));
+        const bool isRead = (fread(_data.data(), 1, _data.size(), f) == _data.size());
+        fclose(f);
+        if(!isRead)
+            throw std::runtime_error("Unable to read the checkpoint: " + filepath);
+
+        if(read<std::uint32_t>() != CHECKPOINT_MAGIC || read<std::uint32_t>() != CHECKPOINT_VERSION ||
+           read<std::uint32_t>() != std::uint32_t(stage))
+            throw std::runtime_error("Invalid checkpoint: " + filepath);
+    }
+
+    template <class T>
+    T read()
+    {
+        T value;
+        readBytes(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+
+    template <class T>
+    void readArray(std::vector<T>& out_values)
+    {
+        const std::uint64_t size = read<std::uint64_t>();
+        if(size > (_data.size() - _offset) / sizeof(T))
+            throw std::runtime_error("Truncated checkpoint.");
+        out_values.resize(size);
+        readBytes(reinterpret_cast<char*>(out_values.data()), size * sizeof(T));
+    }
+
+    bool isEnd() const
+    {
+        return _offset == _data.size();
+    }
+
+private:
+    void readBytes(char* out_bytes, std::size_t size)
+    {
+        if(size > _data.size() - _offset)
+            throw std::runtime_error("Truncated checkpoint.");
+        std::copy(_data.begin() + _offset, _data.begin() + _offset + size, out_bytes);
+        _offset += size;
+    }
+
+    std::vector<char> _data;
+    std::size_t _offset = 0;
+};
+
+/**
+ * @brief Tetrahedralization restored from a checkpoint, with the cells in the same order as the saved one,
+ *        so the saved cells attributes stay valid.
+ */
+class PrecomputedDelaunay : public GEO::Delaunay
+{
+public:
+    PrecomputedDelaunay(std::vector<GEO::signed_index_t>&& cellsVertices, std::vector<GEO::signed_index_t>&& cellsAdjacents)
+        : GEO::Delaunay(3)
+        , _cellsVertices(std::move(cellsVertices))
+        , _cellsAdjacents(std::move(cellsAdjacents))
+    {}
+
+    void set_vertices(GEO::index_t nbVertices, const double* vertices) override
+    {
+        GEO::Delaunay::set_vertices(nbVertices, vertices);
+        set_arrays(_cellsVertices.size() / 4, _cellsVertices.data(), _cellsAdjacents.data());
+    }
+
+private:
+    std::vector<GEO::signed_index_t> _cellsVertices;
+    std::vector<GEO::signed_index_t> _cellsAdjacents;
+};
+
 DelaunayGraphCut::DelaunayGraphCut(mvsUtils::MultiViewParams* _mp)
 {
     mp = _mp;
@@ -397,7 +813,12 @@ DelaunayGraphCut::DelaunayGraphCut(mvsUtils::MultiViewParams* _mp)
     saveTemporaryBinFiles = mp->userParams.get<bool>("LargeScale.saveTemporaryBinFiles", false);
 
     GEO::initialize();
-    _tetrahedralization = GEO::Delaunay::create(3, "BDEL");
+
+    // the parallel Delaunay is only registered if geogram is built with it
+    const bool parallelDelaunay = mp->userParams.get<bool>("delaunaycut.parallelDelaunay", true) &&
+                                  GEO::DelaunayFactory::has_creator("PDEL");
+    _tetrahedralization = GEO::Delaunay::create(3, parallelDelaunay ? "PDEL" : "BDEL");
+    ALICEVISION_LOG_INFO("Delaunay tetrahedralization: " << (parallelDelaunay ? "parallel (PDEL)" : "sequential (BDEL)") << ".");
     // _tetrahedralization->set_keeps_infinite(true);
     _tetrahedralization->set_stores_neighbors(true);
     // _tetrahedralization->set_stores_cicl(true);
@@ -405,6 +826,7 @@ DelaunayGraphCut::DelaunayGraphCut(mvsUtils::MultiViewParams* _mp)
 
 DelaunayGraphCut::~DelaunayGraphCut()
 {
+    waitCheckpoint();
 }
 
 void DelaunayGraphCut::saveDhInfo(const std::string& fileNameInfo)
@@ -413,9 +835,15 @@ void DelaunayGraphCut::saveDhInfo(const std::string& fileNameInfo)
 
     int npts = getNbVertices();
     fwrite(&npts, sizeof(int), 1, f);
-    for(const GC_vertexInfo& v: _verticesAttr)
+    for(int vi = 0; vi < npts; ++vi)
     {
-        v.fwriteinfo(f);
+        _verticesAttr[vi].fwriteinfo(f);
+        int n = getNbVertexCameras(vi);
+        fwrite(&n, sizeof(int), 1, f);
+        if(n > 0)
+        {
+            fwrite(&_verticesCams[_verticesCamsOffsets[vi]], sizeof(int), n, f);
+        }
     }
 
     int ncells = _cellsAttr.size();
@@ -441,18 +869,281 @@ void DelaunayGraphCut::saveDh(const std::string& fileNameDh, const std::string&
     mvsUtils::printfElapsedTime(t1);
 }
 
+void DelaunayGraphCut::setCheckpoints(const std::string& checkpointsFolder, bool resume)
+{
+    _checkpointsFolder = checkpointsFolder;
+    _resumeFromCheckpoints = resume && !checkpointsFolder.empty();
+    if(!_checkpointsFolder.empty())
+        bfs::create_directories(_checkpointsFolder);
+}
+
+std::string DelaunayGraphCut::getCheckpointFilepath(const std::string& name) const
+{
+    return (bfs::path(_checkpointsFolder) / (name + ".bin")).string();
+}
+
+bool DelaunayGraphCut::hasCheckpoint(const std::string& name) const
+{
+    return _resumeFromCheckpoints && bfs::exists(getCheckpointFilepath(name));
+}
+
+void DelaunayGraphCut::writeCheckpointAsync(const std::string& name, std::shared_ptr<const CheckpointWriter> checkpoint)
+{
+    waitCheckpoint();
+
+    const std::string filepath = getCheckpointFilepath(name);
+    _checkpointSaving = std::async(std::launch::async, [checkpoint, filepath]()
+    {
+        system::Timer timer;
+        try
+        {
+            if(!checkpoint->save(filepath))
+                return false;
+        }
+        catch(const std::exception& e)
+        {
+            ALICEVISION_LOG_WARNING("Checkpoint export failed: " << e.what());
+            return false;
+        }
+        ALICEVISION_LOG_INFO("Checkpoint saved in " << timer.elapsed() << " s: " << filepath);
+        return true;
+    });
+}
+
+void DelaunayGraphCut::waitCheckpoint()
+{
+    if(_checkpointSaving.valid() && !_checkpointSaving.get())
+        ALICEVISION_LOG_WARNING("Unable to save the checkpoint in: " << _checkpointsFolder);
+}
+
+void DelaunayGraphCut::writeVertices(CheckpointWriter& checkpoint) const
+{
+    checkpoint.writeArray(_verticesCoords);
+    checkpoint.write(std::uint64_t(_verticesAttr.size()));
+    for(const GC_vertexInfo& v: _verticesAttr)
+    {
+        checkpoint.write(v.pixSize);
+        checkpoint.write(v.nrc);
+        checkpoint.write(v.segSize);
+        checkpoint.write(v.segId);
+        checkpoint.write(v.isOnSurface);
+    }
+    checkpoint.writeArray(_verticesCams);
+    checkpoint.writeArray(_verticesCamsOffsets);
+    checkpoint.writeArray(_camsVertexes);
+}
+
+void DelaunayGraphCut::readVertices(CheckpointReader& checkpoint)
+{
+    checkpoint.readArray(_verticesCoords);
+    const std::uint64_t nbVertices = checkpoint.read<std::uint64_t>();
+    if(nbVertices != _verticesCoords.size())
+        throw std::runtime_error("Invalid number of vertices attributes.");
+    _verticesAttr.resize(nbVertices);
+    for(GC_vertexInfo& v: _verticesAttr)
+    {
+        v.pixSize = checkpoint.read<float>();
+        v.nrc = checkpoint.read<int>();
+        v.segSize = checkpoint.read<int>();
+        v.segId = checkpoint.read<int>();
+        v.isOnSurface = checkpoint.read<bool>();
+    }
+    checkpoint.readArray(_verticesCams);
+    checkpoint.readArray(_verticesCamsOffsets);
+    checkpoint.readArray(_camsVertexes);
+    if(_verticesCamsOffsets.size() != nbVertices + 1 || _verticesCamsOffsets.back() != _verticesCams.size())
+        throw std::runtime_error("Invalid vertices cameras.");
+}
+
+void DelaunayGraphCut::saveDensePointCloudCheckpoint()
+{
+    if(_checkpointsFolder.empty())
+        return;
+
+    auto checkpoint = std::make_shared<CheckpointWriter>(eCheckpointDensePointCloud);
+    writeVertices(*checkpoint);
+    writeCheckpointAsync("densePointCloud", checkpoint);
+}
+
+bool DelaunayGraphCut::loadDensePointCloudCheckpoint()
+{
+    if(!hasCheckpoint("densePointCloud"))
+        return false;
+
+    const std::string filepath = getCheckpointFilepath("densePointCloud");
+    try
+    {
+        CheckpointReader checkpoint(filepath, eCheckpointDensePointCloud);
+        readVertices(checkpoint);
+    }
+    catch(const std::exception& e)
+    {
+        ALICEVISION_LOG_WARNING("Unable to load the checkpoint " << filepath << ": " << e.what());
+        _verticesCoords.clear();
+        _verticesAttr.clear();
+        _verticesCams.clear();
+        _verticesCamsOffsets.assign(1, 0);
+        _camsVertexes.assign(mp->ncams, -1);
+        return false;
+    }
+    ALICEVISION_LOG_INFO("Dense point cloud loaded from the checkpoint: " << _verticesCoords.size() << " points.");
+    return true;
+}
+
+void DelaunayGraphCut::saveTetrahedralizationCheckpoint()
+{
+    if(_checkpointsFolder.empty())
+        return;
+
+    const std::size_t nbCells = _tetrahedralization->nb_cells();
+    std::vector<GEO::signed_index_t> cellsVertices(nbCells * 4);
+    std::vector<GEO::signed_index_t> cellsAdjacents(nbCells * 4);
+    #pragma omp parallel for
+    for(int ci = 0; ci < nbCells; ++ci)
+    {
+        for(int k = 0; k < 4; ++k)
+        {
+            cellsVertices[ci * 4 + k] = _tetrahedralization->cell_vertex(ci, k);
+            cellsAdjacents[ci * 4 + k] = _tetrahedralization->cell_adjacent(ci, k);
+        }
+    }
+
+    auto checkpoint = std::make_shared<CheckpointWriter>(eCheckpointTetrahedralization);
+    writeVertices(*checkpoint);
+    checkpoint->writeArray(cellsVertices);
+    checkpoint->writeArray(cellsAdjacents);
+    writeCheckpointAsync("tetrahedralization", checkpoint);
+}
+
+bool DelaunayGraphCut::loadTetrahedralizationCheckpoint()
+{
+    if(!hasCheckpoint("tetrahedralization"))
+        return false;
+
+    const std::string filepath = getCheckpointFilepath("tetrahedralization");
+    std::vector<GEO::signed_index_t> cellsVertices;
+    std::vector<GEO::signed_index_t> cellsAdjacents;
+    try
+    {
+        CheckpointReader checkpoint(filepath, eCheckpointTetrahedralization);
+        readVertices(checkpoint);
+        checkpoint.readArray(cellsVertices);
+        checkpoint.readArray(cellsAdjacents);
+        if(cellsVertices.size() % 4 != 0 || cellsAdjacents.size() != cellsVertices.size() || !checkpoint.isEnd())
+            throw std::runtime_error("Invalid cells.");
+    }
+    catch(const std::exception& e)
+    {
+        ALICEVISION_LOG_WARNING("Unable to load the checkpoint " << filepath << ": " << e.what());
+        return false;
+    }
+
+    _tetrahedralization = new PrecomputedDelaunay(std::move(cellsVertices), std::move(cellsAdjacents));
+    _tetrahedralization->set_stores_neighbors(true);
+    _tetrahedralization->set_vertices(_verticesCoords.size(), _verticesCoords.front().m);
+
+    _verticesKdTree.reset();
+    _nbIndexedVertices = 0;
+
+    initCells();
+
+    updateVertexToCellsCache();
+
+    ALICEVISION_LOG_INFO("Tetrahedralization loaded from the checkpoint: " << _verticesCoords.size() << " vertices, "
+                         << _cellsAttr.size() << " cells.");
+    return true;
+}
+
+void DelaunayGraphCut::saveGraphCheckpoint(const std::string& method)
+{
+    if(_checkpointsFolder.empty())
+        return;
+
+    auto checkpoint = std::make_shared<CheckpointWriter>(eCheckpointGraph);
+    checkpoint->write(std::uint64_t(_cellsAttr.size()));
+    for(const GC_cellInfo& c: _cellsAttr)
+    {
+        checkpoint->write(c.cellSWeight);
+        checkpoint->write(c.cellTWeight);
+        checkpoint->write(c.gEdgeVisWeight);
+        checkpoint->write(c.in);
+        checkpoint->write(c.out);
+        checkpoint->write(c.on);
+    }
+    writeCheckpointAsync("graph_" + method, checkpoint);
+}
+
+bool DelaunayGraphCut::loadGraphCheckpoint(const std::string& method)
+{
+    if(!hasCheckpoint("graph_" + method))
+        return false;
+
+    const std::string filepath = getCheckpointFilepath("graph_" + method);
+    try
+    {
+        CheckpointReader checkpoint(filepath, eCheckpointGraph);
+        if(checkpoint.read<std::uint64_t>() != _cellsAttr.size())
+            throw std::runtime_error("The number of cells is not the one of the tetrahedralization.");
+        decltype(_cellsAttr) cellsAttr(_cellsAttr.size());
+        for(GC_cellInfo& c: cellsAttr)
+        {
+            c.cellSWeight = checkpoint.read<float>();
+            c.cellTWeight = checkpoint.read<float>();
+            c.gEdgeVisWeight = checkpoint.read<std::array<float, 4>>();
+            c.in = checkpoint.read<float>();
+            c.out = checkpoint.read<float>();
+            c.on = checkpoint.read<float>();
+        }
+        _cellsAttr.swap(cellsAttr);
+    }
+    catch(const std::exception& e)
+    {
+        ALICEVISION_LOG_WARNING("Unable to load the checkpoint " << filepath << ": " << e.what());
+        return false;
+    }
+    ALICEVISION_LOG_INFO("Graph weights loaded from the checkpoint: " << filepath);
+    return true;
+}
+
+void DelaunayGraphCut::compactVerticesCams()
+{
+    // the cameras of the previous vertices are already compacted
+    const std::size_t firstVertex = _verticesCamsOffsets.size() - 1;
+    const std::size_t nbVertices = _verticesAttr.size();
+    _verticesCamsOffsets.resize(nbVertices + 1);
+
+    for(std::size_t vi = firstVertex; vi < nbVertices; ++vi)
+        _verticesCamsOffsets[vi + 1] = _verticesCamsOffsets[vi] + _verticesAttr[vi].cams.size();
+    _verticesCams.resize(_verticesCamsOffsets.back());
+
+    #pragma omp parallel for
+    for(int vi = firstVertex; vi < nbVertices; ++vi)
+    {
+        StaticVector<int>& cams = _verticesAttr[vi].cams;
+        std::copy(cams.begin(), cams.end(), _verticesCams.begin() + _verticesCamsOffsets[vi]);
+        // release the memory of the vertex cameras
+        std::vector<int>().swap(cams.getDataWritable());
+    }
+}
+
 void DelaunayGraphCut::initVertices()
 {
     ALICEVISION_LOG_DEBUG("initVertices ...\n");
 
+    compactVerticesCams();
+
     // Re-assign ids to the vertices to go one after another
+    #pragma omp parallel for
     for(int vi = 0; vi < _verticesAttr.size(); ++vi)
     {
         GC_vertexInfo& v = _verticesAttr[vi];
         // fit->info().point = convertPointToPoint3d(fit->point());
         v.isOnSurface = false;
         // v.id = nVertices;
-        v.pixSize = mp->getCamsMinPixelSize(_verticesCoords[vi], v.cams);
+        double minPixSize = isVirtualVertex(vi) ? 0.0 : std::numeric_limits<double>::max();
+        for(int c = 0; c < getNbVertexCameras(vi); ++c)
+            minPixSize = std::min(minPixSize, mp->getCamPixelSize(_verticesCoords[vi], getVertexCamera(vi, c)));
+        v.pixSize = minPixSize;
     }
 
     ALICEVISION_LOG_DEBUG("initVertices done\n");
@@ -460,6 +1151,9 @@ void DelaunayGraphCut::initVertices()
 
 void DelaunayGraphCut::computeDelaunay()
 {
+    ALICEVISION_PROFILE_SCOPE("DelaunayGraphCut::computeDelaunay");
+    const system::MemoryStage memoryStage("DelaunayGraphCut::computeDelaunay");
+
     ALICEVISION_LOG_DEBUG("computeDelaunay GEOGRAM ...\n");
 
     assert(_verticesCoords.size() == _verticesAttr.size());
@@ -468,6 +1162,9 @@ void DelaunayGraphCut::computeDelaunay()
     _tetrahedralization->set_vertices(_verticesCoords.size(), _verticesCoords.front().m);
     mvsUtils::printfElapsedTime(tall, "GEOGRAM Delaunay tetrahedralization ");
 
+    _verticesKdTree.reset();
+    _nbIndexedVertices = 0;
+
     initCells();
 
     updateVertexToCellsCache();
@@ -482,6 +1179,7 @@ void DelaunayGraphCut::initCells()
     _cellsAttr.resize(_tetrahedralization->nb_cells()); // or nb_finite_cells() if keeps_infinite()
 
     ALICEVISION_LOG_INFO(_cellsAttr.size() << " cells created by tetrahedralization.");
+    #pragma omp parallel for
     for(int i = 0; i < _cellsAttr.size(); ++i)
     {
         GC_cellInfo& c = _cellsAttr[i];
@@ -500,6 +1198,69 @@ void DelaunayGraphCut::initCells()
     ALICEVISION_LOG_DEBUG("initCells done\n");
 }
 
+void DelaunayGraphCut::updateVertexToCellsCache()
+{
+    const std::size_t nbVertices = _verticesCoords.size();
+    const std::int64_t nbCells = _tetrahedralization->nb_cells();
+
+    // count the cells of each vertex, then reuse the counters as the insertion positions
+    std::vector<std::atomic<std::size_t>> nbCellsPerVertex(nbVertices);
+    int coutInvalidVertices = 0;
+
+    #pragma omp parallel for reduction(+:coutInvalidVertices)
+    for(std::int64_t ci = 0; ci < nbCells; ++ci)
+    {
+        for(VertexIndex k = 0; k < 4; ++k)
+        {
+            const VertexIndex vi = _tetrahedralization->cell_vertex(ci, k);
+            if(vi == GEO::NO_VERTEX || vi >= nbVertices)
+            {
+                ++coutInvalidVertices;
+                continue;
+            }
+            nbCellsPerVertex[vi].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    int nbVerticesWithCells = 0;
+    _neighboringCellsPerVertexOffsets.resize(nbVertices + 1);
+    _neighboringCellsPerVertexOffsets[0] = 0;
+    for(std::size_t vi = 0; vi < nbVertices; ++vi)
+    {
+        const std::size_t nbVertexCells = nbCellsPerVertex[vi].exchange(0, std::memory_order_relaxed);
+        _neighboringCellsPerVertexOffsets[vi + 1] = _neighboringCellsPerVertexOffsets[vi] + nbVertexCells;
+        if(nbVertexCells > 0)
+            ++nbVerticesWithCells;
+    }
+
+    _neighboringCellsPerVertex.resize(_neighboringCellsPerVertexOffsets[nbVertices]);
+
+    #pragma omp parallel for
+    for(std::int64_t ci = 0; ci < nbCells; ++ci)
+    {
+        for(VertexIndex k = 0; k < 4; ++k)
+        {
+            const VertexIndex vi = _tetrahedralization->cell_vertex(ci, k);
+            if(vi == GEO::NO_VERTEX || vi >= nbVertices)
+                continue;
+            const std::size_t lvi = nbCellsPerVertex[vi].fetch_add(1, std::memory_order_relaxed);
+            _neighboringCellsPerVertex[_neighboringCellsPerVertexOffsets[vi] + lvi] = CellIndex(ci);
+        }
+    }
+
+    // the insertion order depends on the threads scheduling
+    #pragma omp parallel for
+    for(std::int64_t vi = 0; vi < nbVertices; ++vi)
+    {
+        std::sort(_neighboringCellsPerVertex.begin() + _neighboringCellsPerVertexOffsets[vi],
+                  _neighboringCellsPerVertex.begin() + _neighboringCellsPerVertexOffsets[vi + 1]);
+    }
+
+    ALICEVISION_LOG_INFO("coutInvalidVertices: " << coutInvalidVertices);
+    ALICEVISION_LOG_INFO("neighboringCellsPerVertex: " << nbVerticesWithCells);
+    ALICEVISION_LOG_INFO("verticesCoords: " << _verticesCoords.size());
+}
+
 void DelaunayGraphCut::displayStatistics()
 {
     // Display some statistics
@@ -525,13 +1286,13 @@ StaticVector<StaticVector<int>*>* DelaunayGraphCut::createPtsCams()
     StaticVector<StaticVector<int>*>* out = new StaticVector<StaticVector<int>*>();
     out->reserve(npts);
 
-    for(const GC_vertexInfo& v: _verticesAttr)
+    for(int vi = 0; vi < npts; ++vi)
     {
         StaticVector<int>* cams = new StaticVector<int>();
-        cams->reserve(v.getNbCameras());
-        for(int c = 0; c < v.getNbCameras(); c++)
+        cams->reserve(getNbVertexCameras(vi));
+        for(int c = 0; c < getNbVertexCameras(vi); c++)
         {
-            cams->push_back(v.cams[c]);
+            cams->push_back(getVertexCamera(vi, c));
         }
         out->push_back(cams);
     } // for i
@@ -545,9 +1306,9 @@ StaticVector<StaticVector<int>*>* DelaunayGraphCut::createPtsCams()
 StaticVector<int>* DelaunayGraphCut::getPtsCamsHist()
 {
     int maxnCams = 0;
-    for(const GC_vertexInfo& v: _verticesAttr)
+    for(int vi = 0; vi < getNbVertices(); ++vi)
     {
-        maxnCams = std::max(maxnCams, (int)v.getNbCameras());
+        maxnCams = std::max(maxnCams, (int)getNbVertexCameras(vi));
     }
     maxnCams++;
     ALICEVISION_LOG_DEBUG("maxnCams: " << maxnCams);
@@ -556,9 +1317,9 @@ StaticVector<int>* DelaunayGraphCut::getPtsCamsHist()
     ncamsHist->reserve(maxnCams);
     ncamsHist->resize_with(maxnCams, 0);
 
-    for(const GC_vertexInfo& v: _verticesAttr)
+    for(int vi = 0; vi < getNbVertices(); ++vi)
     {
-        (*ncamsHist)[v.getNbCameras()] += 1;
+        (*ncamsHist)[getNbVertexCameras(vi)] += 1;
     }
 
     return ncamsHist;
@@ -598,19 +1359,9 @@ StaticVector<int> DelaunayGraphCut::getIsUsedPerCamera() const
     StaticVector<int> cams;
     cams.resize_with(mp->getNbCameras(), 0);
 
-//#pragma omp parallel for
-    for(int vi = 0; vi < _verticesAttr.size(); ++vi)
+    for(const int obsCam : _verticesCams)
     {
-        const GC_vertexInfo& v = _verticesAttr[vi];
-        for(int c = 0; c < v.cams.size(); ++c)
-        {
-            const int obsCam = v.cams[c];
-
-//#pragma OMP_ATOMIC_WRITE
-            {
-                cams[obsCam] = 1;
-            }
-        }
+        cams[obsCam] = 1;
     }
 
     mvsUtils::printfElapsedTime(timer, "getIsUsedPerCamera ");
@@ -671,6 +1422,61 @@ void DelaunayGraphCut::addPointsFromSfM(const Point3d hexah[8], const StaticVect
   _verticesAttr.shrink_to_fit();
 }
 
+void DelaunayGraphCut::updateVerticesKdTree()
+{
+    _verticesKdTree.reset();
+    _nbIndexedVertices = 0;
+    if(_verticesCoords.empty())
+        return;
+
+    _verticesKdTree.reset(new VerticesKdTree(_verticesCoords));
+    _nbIndexedVertices = _verticesCoords.size();
+    ALICEVISION_LOG_DEBUG("Vertices KdTree created for " << _nbIndexedVertices << " points.");
+}
+
+GEO::index_t DelaunayGraphCut::locateNearestVertex(const Point3d& p) const
+{
+    GEO::index_t nearestVertex = GEO::NO_VERTEX;
+    if(_verticesKdTree != nullptr)
+    {
+#ifdef USE_GEOGRAM_KDTREE
+        nearestVertex = GEO::index_t(_verticesKdTree->kdTree.get_nearest_neighbor(p.m));
+#else
+        nanoflann::KNNResultSet<double, std::size_t> resultSet(1);
+        std::size_t nearestVertexIndex = std::numeric_limits<std::size_t>::max();
+        double dist = std::numeric_limits<double>::max();
+        resultSet.init(&nearestVertexIndex, &dist);
+        if(_verticesKdTree->kdTree.findNeighbors(resultSet, p.m, nanoflann::SearchParams()))
+            nearestVertex = GEO::index_t(nearestVertexIndex);
+#endif
+    }
+    return nearestVertexFrom(p, _nbIndexedVertices, nearestVertex);
+}
+
+void DelaunayGraphCut::locateNearestVertices(const std::vector<Point3d>& points, std::vector<GEO::index_t>& out_vertices) const
+{
+    out_vertices.resize(points.size());
+
+    #pragma omp parallel for
+    for(int i = 0; i < points.size(); ++i)
+        out_vertices[i] = locateNearestVertex(points[i]);
+}
+
+GEO::index_t DelaunayGraphCut::nearestVertexFrom(const Point3d& p, std::size_t firstVertex, GEO::index_t nearestVertex) const
+{
+    double nearestDist = (nearestVertex == GEO::NO_VERTEX) ? std::numeric_limits<double>::max() : (_verticesCoords[nearestVertex] - p).size2();
+    for(std::size_t vi = firstVertex; vi < _verticesCoords.size(); ++vi)
+    {
+        const double dist = (_verticesCoords[vi] - p).size2();
+        if(dist < nearestDist)
+        {
+            nearestDist = dist;
+            nearestVertex = GEO::index_t(vi);
+        }
+    }
+    return nearestVertex;
+}
+
 void DelaunayGraphCut::addPointsFromCameraCenters(const StaticVector<int>& cams, float minDist)
 {
     for(int camid = 0; camid < cams.size(); camid++)
@@ -771,6 +1577,8 @@ void DelaunayGraphCut::addHelperPoints(int nGridHelperVolumePointsDim, const Poi
     float maxSize = 2.0f * (O - voxel[0]).size();
     Point3d CG = (voxel[0] + voxel[1] + voxel[2] + voxel[3] + voxel[4] + voxel[5] + voxel[6] + voxel[7]) / 8.0f;
 
+    std::vector<Point3d> helperPoints;
+    helperPoints.reserve((ns + 1) * (ns + 1) * (ns + 1));
     for(int x = 0; x <= ns; x++)
     {
         for(int y = 0; y <= ns; y++)
@@ -780,28 +1588,31 @@ void DelaunayGraphCut::addHelperPoints(int nGridHelperVolumePointsDim, const Poi
                 Point3d pt = voxel[0] + vx * ((float)x / (float)ns) + vy * ((float)y / (float)ns) +
                              vz * ((float)z / (float)ns);
                 pt = pt + (CG - pt).normalize() * (maxSize * ((float)rand() / (float)RAND_MAX));
+                helperPoints.push_back(pt);
+            }
+        }
+    }
 
-                Point3d p(pt.x, pt.y, pt.z);
-                GEO::index_t vi = locateNearestVertex(p);
-                Point3d npp;
+    // nearest vertices among the current ones, the helper points are then added one by one
+    updateVerticesKdTree();
+    std::vector<GEO::index_t> nearestVertices;
+    locateNearestVertices(helperPoints, nearestVertices);
 
-                if(vi != GEO::NO_VERTEX)
-                {
-                    npp = _verticesCoords[vi];
-                }
+    for(std::size_t i = 0; i < helperPoints.size(); ++i)
+    {
+        const Point3d& pt = helperPoints[i];
+        const GEO::index_t vi = nearestVertexFrom(pt, _nbIndexedVertices, nearestVertices[i]);
 
-                // if there is no nearest vertex or the nearest vertex is not too close
-                if((vi == GEO::NO_VERTEX) || ((npp - pt).size() > minDist))
-                {
-                    _verticesCoords.push_back(p);
-                    GC_vertexInfo newv;
-                    newv.nrc = 0;
-                    newv.segSize = 0;
-                    newv.segId = -1;
+        // if there is no nearest vertex or the nearest vertex is not too close
+        if((vi == GEO::NO_VERTEX) || ((_verticesCoords[vi] - pt).size() > minDist))
+        {
+            _verticesCoords.push_back(pt);
+            GC_vertexInfo newv;
+            newv.nrc = 0;
+            newv.segSize = 0;
+            newv.segId = -1;
 
-                    _verticesAttr.push_back(newv);
-                }
-            }
+            _verticesAttr.push_back(newv);
         }
     }
 
@@ -811,6 +1622,9 @@ void DelaunayGraphCut::addHelperPoints(int nGridHelperVolumePointsDim, const Poi
 
 void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Point3d voxel[8], const FuseParams& params)
 {
+    ALICEVISION_PROFILE_SCOPE("DelaunayGraphCut::fuseFromDepthMaps");
+    const system::MemoryStage memoryStage("DelaunayGraphCut::fuseFromDepthMaps");
+
     ALICEVISION_LOG_INFO("fuseFromDepthMaps, maxVertices: " << params.maxPoints);
 
     std::vector<Point3d> verticesCoordsPrepare;
@@ -822,162 +1636,178 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
     // unsigned long nbValidDepths = computeNumberOfAllPoints(mp, 0);
     // int stepPts = std::ceil((double)nbValidDepths / (double)maxPoints);
     std::size_t nbPixels = 0;
-    for(const auto& imgParams: mp->getImagesParams())
+    for(int ci = 0; ci < cams.size(); ++ci)
     {
-        nbPixels += imgParams.size;
+        nbPixels += mp->getImageParams(cams[ci]).size;
     }
     int step = std::floor(std::sqrt(double(nbPixels) / double(params.maxInputPoints)));
     step = std::max(step, params.minStep);
-    std::size_t realMaxVertices = 0;
-    std::vector<int> startIndex(mp->getNbCameras(), 0);
-    for(int i = 0; i < mp->getNbCameras(); ++i)
-    {
-        const auto& imgParams = mp->getImageParams(i);
-        startIndex[i] = realMaxVertices;
-        realMaxVertices += std::ceil(imgParams.width / step) * std::ceil(imgParams.height / step);
-    }
-    verticesCoordsPrepare.resize(realMaxVertices);
-    std::vector<double> pixSizePrepare(realMaxVertices);
-    std::vector<float> simScorePrepare(realMaxVertices);
 
     ALICEVISION_LOG_INFO("simFactor: " << params.simFactor);
     ALICEVISION_LOG_INFO("nbPixels: " << nbPixels);
     ALICEVISION_LOG_INFO("maxVertices: " << params.maxPoints);
     ALICEVISION_LOG_INFO("step: " << step);
-    ALICEVISION_LOG_INFO("realMaxVertices: " << realMaxVertices);
 
-    ALICEVISION_LOG_INFO("Load depth maps and add points.");
+    std::vector<double> pixSizePrepare;
+    std::vector<float> simScorePrepare;
+    std::vector<GC_vertexInfo> verticesAttrPrepare;
+
+    if(params.spatialHashFusion)
+    {
+        fuseDepthMapsBySpatialHash(cams, voxel, mp, step, params.simFactor, params.simGaussianSize,
+                                   verticesCoordsPrepare, pixSizePrepare, simScorePrepare, verticesAttrPrepare);
+    }
+    else
     {
-        omp_set_nested(1);
-        #pragma omp parallel for num_threads(3)
-        for(int c = 0; c < cams.size(); c++)
+        std::size_t realMaxVertices = 0;
+        std::vector<int> startIndex(mp->getNbCameras(), 0);
+        for(int ci = 0; ci < cams.size(); ++ci)
+        {
+            const int i = cams[ci];
+            const auto& imgParams = mp->getImageParams(i);
+            startIndex[i] = realMaxVertices;
+            realMaxVertices += std::ceil(imgParams.width / step) * std::ceil(imgParams.height / step);
+        }
+        verticesCoordsPrepare.resize(realMaxVertices);
+        pixSizePrepare.resize(realMaxVertices);
+        simScorePrepare.resize(realMaxVertices);
+
+        ALICEVISION_LOG_INFO("realMaxVertices: " << realMaxVertices);
+
+        ALICEVISION_LOG_INFO("Load depth maps and add points.");
         {
-            std::vector<float> depthMap;
-            std::vector<float> simMap;
-            std::vector<unsigned char> numOfModalsMap;
-            int width, height;
+            omp_set_nested(1);
+            #pragma omp parallel for num_threads(3)
+            for(int ci = 0; ci < cams.size(); ci++)
             {
-                const std::string depthMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::depthMap, 0);
-                imageIO::readImage(depthMapFilepath, width, height, depthMap, imageIO::EImageColorSpace::NO_CONVERSION);
-                if(depthMap.empty())
-                {
-                    ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
-                    continue;
-                }
-                int wTmp, hTmp;
-                const std::string simMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::simMap, 0);
-                imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap, imageIO::EImageColorSpace::NO_CONVERSION);
-                if(wTmp != width || hTmp != height)
-                    throw std::runtime_error("Wrong sim map dimensions: " + simMapFilepath);
+                const int c = cams[ci];
+                std::vector<float> depthMap;
+                std::vector<float> simMap;
+                std::vector<unsigned char> numOfModalsMap;
+                int width, height;
                 {
-                    std::vector<float> simMapTmp(simMap.size());
-                    imageAlgo::convolveImage(width, height, simMap, simMapTmp, "gaussian", params.simGaussianSizeInit, params.simGaussianSizeInit);
-                    simMap.swap(simMapTmp);
-                }
+                    const std::string depthMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::depthMap, 0);
+                    imageIO::readImage(depthMapFilepath, width, height, depthMap, imageIO::EImageColorSpace::NO_CONVERSION);
+                    if(depthMap.empty())
+                    {
+                        ALICEVISION_LOG_WARNING("Empty depth map: " << depthMapFilepath);
+                        continue;
+                    }
+                    int wTmp, hTmp;
+                    const std::string simMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::simMap, 0);
+                    imageIO::readImage(simMapFilepath, wTmp, hTmp, simMap, imageIO::EImageColorSpace::NO_CONVERSION);
+                    if(wTmp != width || hTmp != height)
+                        throw std::runtime_error("Wrong sim map dimensions: " + simMapFilepath);
+                    {
+                        std::vector<float> simMapTmp(simMap.size());
+                        imageAlgo::convolveImage(width, height, simMap, simMapTmp, "gaussian", params.simGaussianSizeInit, params.simGaussianSizeInit);
+                        simMap.swap(simMapTmp);
+                    }
 
-                const std::string nmodMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::nmodMap, 0);
-                imageIO::readImage(nmodMapFilepath, wTmp, hTmp, numOfModalsMap, imageIO::EImageColorSpace::NO_CONVERSION);
-                if(wTmp != width || hTmp != height)
-                    throw std::runtime_error("Wrong nmod map dimensions: " + nmodMapFilepath);
-            }
+                    const std::string nmodMapFilepath = getFileNameFromIndex(mp, c, mvsUtils::EFileType::nmodMap, 0);
+                    imageIO::readImage(nmodMapFilepath, wTmp, hTmp, numOfModalsMap, imageIO::EImageColorSpace::NO_CONVERSION);
+                    if(wTmp != width || hTmp != height)
+                        throw std::runtime_error("Wrong nmod map dimensions: " + nmodMapFilepath);
+                }
 
-            int syMax = std::ceil(height/step);
-            int sxMax = std::ceil(width/step);
-            #pragma omp parallel for
-            for(int sy = 0; sy < syMax; ++sy)
-            {
-                for(int sx = 0; sx < sxMax; ++sx)
+                int syMax = std::ceil(height/step);
+                int sxMax = std::ceil(width/step);
+                #pragma omp parallel for
+                for(int sy = 0; sy < syMax; ++sy)
                 {
-                    int index = startIndex[c] + sy * sxMax + sx;
-                    float bestDepth = std::numeric_limits<float>::max();
-                    float bestScore = 0;
-                    float bestSimScore = 0;
-                    int bestX = 0;
-                    int bestY = 0;
-                    for(int y = sy * step, ymax = std::min((sy+1) * step, height);
-                        y < ymax; ++y)
+                    for(int sx = 0; sx < sxMax; ++sx)
                     {
-                        for(int x = sx * step, xmax = std::min((sx+1) * step, width);
-                            x < xmax; ++x)
+                        int index = startIndex[c] + sy * sxMax + sx;
+                        float bestDepth = std::numeric_limits<float>::max();
+                        float bestScore = 0;
+                        float bestSimScore = 0;
+                        int bestX = 0;
+                        int bestY = 0;
+                        for(int y = sy * step, ymax = std::min((sy+1) * step, height);
+                            y < ymax; ++y)
                         {
-                            const std::size_t index = y * width + x;
-                            const float depth = depthMap[index];
-                            if(depth <= 0.0f)
-                                continue;
-
-                            int numOfModals = 0;
-                            const int scoreKernelSize = 1;
-                            for(int ly = std::max(y-scoreKernelSize, 0), lyMax = std::min(y+scoreKernelSize, height-1); ly < lyMax; ++ly)
+                            for(int x = sx * step, xmax = std::min((sx+1) * step, width);
+                                x < xmax; ++x)
                             {
-                                for(int lx = std::max(x-scoreKernelSize, 0), lxMax = std::min(x+scoreKernelSize, width-1); lx < lxMax; ++lx)
+                                const std::size_t index = y * width + x;
+                                const float depth = depthMap[index];
+                                if(depth <= 0.0f)
+                                    continue;
+
+                                int numOfModals = 0;
+                                const int scoreKernelSize = 1;
+                                for(int ly = std::max(y-scoreKernelSize, 0), lyMax = std::min(y+scoreKernelSize, height-1); ly < lyMax; ++ly)
                                 {
-                                    if(depthMap[ly * width + lx] > 0.0f)
+                                    for(int lx = std::max(x-scoreKernelSize, 0), lxMax = std::min(x+scoreKernelSize, width-1); lx < lxMax; ++lx)
                                     {
-                                        numOfModals += 10 + int(numOfModalsMap[ly * width + lx]);
+                                        if(depthMap[ly * width + lx] > 0.0f)
+                                        {
+                                            numOfModals += 10 + int(numOfModalsMap[ly * width + lx]);
+                                        }
                                     }
                                 }
-                            }
-                            float sim = simMap[index];
-                            sim = sim < 0.0f ?  0.0f : sim; // clamp values < 0
-                            // remap similarity values from [-1;+1] to [+1;+simScale]
-                            // interpretation is [goodSimilarity;badSimilarity]
-                            const float simScore = 1.0f + sim * params.simFactor;
-
-                            const float score = numOfModals + (1.0f / simScore);
-                            if(score > bestScore)
-                            {
-                                bestDepth = depth;
-                                bestScore = score;
-                                bestSimScore = simScore;
-                                bestX = x;
-                                bestY = y;
+                                float sim = simMap[index];
+                                sim = sim < 0.0f ?  0.0f : sim; // clamp values < 0
+                                // remap similarity values from [-1;+1] to [+1;+simScale]
+                                // interpretation is [goodSimilarity;badSimilarity]
+                                const float simScore = 1.0f + sim * params.simFactor;
+
+                                const float score = numOfModals + (1.0f / simScore);
+                                if(score > bestScore)
+                                {
+                                    bestDepth = depth;
+                                    bestScore = score;
+                                    bestSimScore = simScore;
+                                    bestX = x;
+                                    bestY = y;
+                                }
                             }
                         }
-                    }
-                    if(bestScore < 3*13)
-                    {
-                        // discard the point
-                        pixSizePrepare[index] = -1.0;
-                    }
-                    else
-                    {
-                        Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)bestX, (float)bestY)).normalize() * bestDepth;
-                        
-                        // TODO: isPointInHexahedron: here or in the previous loop per pixel to not loose point?
-                        if(voxel == nullptr || mvsUtils::isPointInHexahedron(p, voxel)) 
+                        if(bestScore < 3*13)
                         {
-                            verticesCoordsPrepare[index] = p;
-                            simScorePrepare[index] = bestSimScore;
-                            pixSizePrepare[index] = mp->getCamPixelSize(p, c);
+                            // discard the point
+                            pixSizePrepare[index] = -1.0;
                         }
                         else
                         {
-                            // discard the point
-                            // verticesCoordsPrepare[index] = p;
-                            pixSizePrepare[index] = -1.0;
+                            Point3d p = mp->CArr[c] + (mp->iCamArr[c] * Point2d((float)bestX, (float)bestY)).normalize() * bestDepth;
+                        
+                            // TODO: isPointInHexahedron: here or in the previous loop per pixel to not loose point?
+                            if(voxel == nullptr || mvsUtils::isPointInHexahedron(p, voxel)) 
+                            {
+                                verticesCoordsPrepare[index] = p;
+                                simScorePrepare[index] = bestSimScore;
+                                pixSizePrepare[index] = mp->getCamPixelSize(p, c);
+                            }
+                            else
+                            {
+                                // discard the point
+                                // verticesCoordsPrepare[index] = p;
+                                pixSizePrepare[index] = -1.0;
+                            }
                         }
                     }
                 }
             }
+            omp_set_nested(0);
         }
-        omp_set_nested(0);
-    }
 
-    ALICEVISION_LOG_INFO("Filter initial 3D points by pixel size to remove duplicates.");
+        ALICEVISION_LOG_INFO("Filter initial 3D points by pixel size to remove duplicates.");
 
-    filterByPixSize(verticesCoordsPrepare, pixSizePrepare, params.pixSizeMarginInitCoef, simScorePrepare);
-    // remove points if pixSize == -1
-    removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
+        filterByPixSize(verticesCoordsPrepare, pixSizePrepare, params.pixSizeMarginInitCoef, simScorePrepare);
+        // remove points if pixSize == -1
+        removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
 
-    ALICEVISION_LOG_INFO("3D points loaded and filtered to " << verticesCoordsPrepare.size() << " points.");
+        ALICEVISION_LOG_INFO("3D points loaded and filtered to " << verticesCoordsPrepare.size() << " points.");
 
-    ALICEVISION_LOG_INFO("Init visibilities to compute angle scores");
-    std::vector<GC_vertexInfo> verticesAttrPrepare(verticesCoordsPrepare.size());
+        ALICEVISION_LOG_INFO("Init visibilities to compute angle scores");
+        verticesAttrPrepare.resize(verticesCoordsPrepare.size());
 
-    // Compute the vertices positions and simScore from all input depthMap/simMap images,
-    // and declare the visibility information (the cameras indexes seeing the vertex).
-    createVerticesWithVisibilities(cams, verticesCoordsPrepare, pixSizePrepare, simScorePrepare,
-                                   verticesAttrPrepare, mp, params.simFactor, params.voteMarginFactor, params.contributeMarginFactor, params.simGaussianSize);
+        // Compute the vertices positions and simScore from all input depthMap/simMap images,
+        // and declare the visibility information (the cameras indexes seeing the vertex).
+        createVerticesWithVisibilities(cams, verticesCoordsPrepare, pixSizePrepare, simScorePrepare,
+                                       verticesAttrPrepare, mp, params.simFactor, params.voteMarginFactor, params.contributeMarginFactor, params.simGaussianSize);
+    }
 
     ALICEVISION_LOG_INFO("Compute max angle per point");
 
@@ -1066,7 +1896,8 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
     }
     ALICEVISION_LOG_INFO("3D points loaded and filtered to " << verticesCoordsPrepare.size() << " points (maxVertices is " << params.maxPoints << ").");
 
-    if(params.refineFuse)
+    // the visibilities of the spatial hash are already complete
+    if(params.refineFuse && !params.spatialHashFusion)
     {
         ALICEVISION_LOG_INFO("Create final visibilities");
         // Initialize the vertice attributes and declare the visibility information
@@ -1158,24 +1989,24 @@ void DelaunayGraphCut::computeVerticesSegSize(bool allPoints, float alpha) // al
     float pointToJoinPixSizeDist = (float)mp->userParams.get<double>("delaunaycut.pointToJoinPixSizeDist", 2.0) *
                                    (float)scalePS * (float)step * 2.0f;
 
-    std::vector<Pixel> edges;
-    edges.reserve(_verticesAttr.size());
-
     if(alpha < 1.0f)
     {
         alpha = 2.0f * std::max(2.0f, pointToJoinPixSizeDist);
     }
 
-    // long t1 = mvsUtils::initEstimate();
     assert(_verticesCoords.size() == _verticesAttr.size());
 
-    for(VertexIndex vi = 0; vi < _verticesAttr.size(); ++vi)
+    const int nbVertices = _verticesAttr.size();
+    ParallelUniverse u(nbVertices);
+
+    #pragma omp parallel for
+    for(int vi = 0; vi < nbVertices; ++vi)
     {
         const GC_vertexInfo& v = _verticesAttr[vi];
         const Point3d& p = _verticesCoords[vi];
-        if((v.getNbCameras() > 0) && ((allPoints) || (v.isOnSurface)))
+        if(isRealVertex(vi) && ((allPoints) || (v.isOnSurface)))
         {
-            int rc = v.getCamera(0);
+            int rc = getVertexCamera(vi, 0);
 
             // go thru all neighbour points
             GEO::vector<VertexIndex> adjVertices;
@@ -1192,72 +2023,56 @@ void DelaunayGraphCut::computeVerticesSegSize(bool allPoints, float alpha) // al
                     {
                         if(vi < nvi) // to remove duplicates
                         {
-                            edges.emplace_back(vi, nvi);
+                            u.join(vi, nvi);
                         }
                     }
                 }
             }
         }
-        // mvsUtils::printfEstimate(vi, _verticesAttr.size(), t1);
     }
-    // mvsUtils::finishEstimate();
 
-    Universe* u = new Universe(_verticesAttr.size());
-
-    // t1 = mvsUtils::initEstimate();
-    int s = (int)edges.size(); // Fuse all edges collected to be merged
-    for(int i = 0; i < s; i++)
+    std::vector<int> segIds;
+    const int nbSegments = u.computeLabels(std::vector<bool>(), segIds);
+    std::vector<int> segSizes(nbSegments, 0);
+    for(int vi = 0; vi < nbVertices; ++vi)
     {
-        int a = u->find(edges[i].x);
-        int b = u->find(edges[i].y);
-        if(a != b) // TODO FACA: Are they not different in all cases?
-        {
-            u->join(a, b);
-        }
-        // mvsUtils::printfEstimate(i, s, t1);
+        ++segSizes[segIds[vi]];
     }
-    // mvsUtils::finishEstimate();
 
     // Last loop over vertices to update segId
-    for(int vi = 0; vi < _verticesAttr.size(); ++vi)
+    #pragma omp parallel for
+    for(int vi = 0; vi < nbVertices; ++vi)
     {
-        GC_vertexInfo& v = _verticesAttr[vi];
-        if(v.isVirtual())
+        if(isVirtualVertex(vi))
             continue;
 
-        int a = u->find(vi);
-        v.segSize = u->elts[a].size;
-        v.segId = a;
+        GC_vertexInfo& v = _verticesAttr[vi];
+        v.segSize = segSizes[segIds[vi]];
+        v.segId = segIds[vi];
     }
 
-    delete u;
     ALICEVISION_LOG_DEBUG("creating universe done.");
 }
 
 void DelaunayGraphCut::removeSmallSegs(int minSegSize)
 {
     ALICEVISION_LOG_DEBUG("removeSmallSegs: " << minSegSize);
-    StaticVector<int>* toRemove = new StaticVector<int>();
-    toRemove->reserve(getNbVertices());
-
-    for(int i = 0; i < _verticesAttr.size(); ++i)
+    // remove the cameras of the vertices of the small segments, in place in the contiguous cameras array
+    std::size_t camsEnd = 0;
+    for(int vi = 0; vi < _verticesAttr.size(); ++vi)
     {
-        const GC_vertexInfo& v = _verticesAttr[i];
-        if(v.isReal() && v.segSize < minSegSize)
-        {
-            toRemove->push_back(i);
-        }
-    }
+        const std::size_t camsBegin = _verticesCamsOffsets[vi];
+        const std::size_t nbCams = _verticesCamsOffsets[vi + 1] - camsBegin;
+        _verticesCamsOffsets[vi] = camsEnd;
 
-    for(int i = 0; i < toRemove->size(); i++)
-    {
-        int iR = (*toRemove)[i];
-        GC_vertexInfo& v = _verticesAttr[iR];
+        if(nbCams > 0 && _verticesAttr[vi].segSize < minSegSize)
+            continue; // T.remove(fit); // TODO GEOGRAM
 
-        v.cams.clear();
-        // T.remove(fit); // TODO GEOGRAM
+        std::copy(_verticesCams.begin() + camsBegin, _verticesCams.begin() + camsBegin + nbCams, _verticesCams.begin() + camsEnd);
+        camsEnd += nbCams;
     }
-    delete toRemove;
+    _verticesCamsOffsets.back() = camsEnd;
+    _verticesCams.resize(camsEnd);
 
     initVertices();
 }
@@ -1589,8 +2404,7 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
         }
     }
 
-    // choose random order to prevent waiting
-    StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
+    const bool deterministic = mp->userParams.get<bool>("delaunaycut.deterministic", system::isDeterministic());
 
     int64_t avStepsFront = 0;
     int64_t aAvStepsFront = 0;
@@ -1599,39 +2413,48 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
     int avCams = 0;
     int nAvCams = 0;
 
-#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
-    for(int i = 0; i < vetexesToProcessIdsRand->size(); i++)
+    processVerticesWeights(_verticesAttr.size(), deterministic, [&](int iV, WeightAdditions* weights)
     {
-        int iV = (*vetexesToProcessIdsRand)[i];
         const GC_vertexInfo& v = _verticesAttr[iV];
 
-        if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
+        const int nbCams = getNbVertexCameras(iV);
+        if((nbCams > 0) && (allPoints || v.isOnSurface) && (v.nrc > 0))
         {
-            for(int c = 0; c < v.cams.size(); c++)
+            int64_t vStepsFront = 0;
+            int64_t vStepsBehind = 0;
+            const int* vCams = &_verticesCams[_verticesCamsOffsets[iV]];
+
+            for(int c = 0; c < nbCams; c++)
             {
                 // "weight" is called alpha(p) in the paper
-                float weight = weightFcn((float)v.nrc, labatutWeights, v.getNbCameras()); // number of cameras
+                float weight = weightFcn((float)v.nrc, labatutWeights, nbCams); // number of cameras
 
-                assert(v.cams[c] >= 0);
-                assert(v.cams[c] < mp->ncams);
+                assert(vCams[c] >= 0);
+                assert(vCams[c] < mp->ncams);
 
                 int nstepsFront = 0;
                 int nstepsBehind = 0;
-                fillGraphPartPtRc(nstepsFront, nstepsBehind, iV, v.cams[c], weight, fixesSigma, nPixelSizeBehind,
-                                  allPoints, behind, fillOut, distFcnHeight);
+                fillGraphPartPtRc(nstepsFront, nstepsBehind, iV, vCams[c], weight, fixesSigma, nPixelSizeBehind,
+                                  allPoints, behind, fillOut, distFcnHeight, weights);
 
-                avStepsFront += nstepsFront;
-                aAvStepsFront += 1;
-                avStepsBehind += nstepsBehind;
-                nAvStepsBehind += 1;
+                vStepsFront += nstepsFront;
+                vStepsBehind += nstepsBehind;
             } // for c
 
-            avCams += v.cams.size();
+            OMP_ATOMIC_UPDATE
+            avStepsFront += vStepsFront;
+            OMP_ATOMIC_UPDATE
+            aAvStepsFront += nbCams;
+            OMP_ATOMIC_UPDATE
+            avStepsBehind += vStepsBehind;
+            OMP_ATOMIC_UPDATE
+            nAvStepsBehind += nbCams;
+            OMP_ATOMIC_UPDATE
+            avCams += nbCams;
+            OMP_ATOMIC_UPDATE
             nAvCams += 1;
         }
-    }
-
-    delete vetexesToProcessIdsRand;
+    });
 
     ALICEVISION_LOG_DEBUG("avStepsFront " << avStepsFront);
     ALICEVISION_LOG_DEBUG("avStepsFront = " << mvsUtils::num2str(avStepsFront) << " // " << mvsUtils::num2str(aAvStepsFront));
@@ -1643,7 +2466,7 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
 
 void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam,
                                        float weight, bool fixesSigma, float nPixelSizeBehind, bool allPoints,
-                                       bool behind, bool fillOut, float distFcnHeight)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
+                                       bool behind, bool fillOut, float distFcnHeight, WeightAdditions* out_weights)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
 {
     out_nstepsFront = 0;
     out_nstepsBehind = 0;
@@ -1676,10 +2499,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         bool ok = ci != GEO::NO_CELL;
         while(ok)
         {
-            {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].out += weight;
-            }
+            addWeight(_cellsAttr[ci].out, weight, out_weights);
 
             ++out_nstepsFront;
             ++nsteps;
@@ -1696,10 +2516,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
             {
                 float dist = distFcn(maxDist, (po - pold).size(), distFcnHeight);
 
-                {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f1.cellIndex].gEdgeVisWeight[f1.localVertexIndex] += weight * dist;
-                }
+                addWeight(_cellsAttr[f1.cellIndex].gEdgeVisWeight[f1.localVertexIndex], weight * dist, out_weights);
 
                 if(f2.cellIndex == GEO::NO_CELL)
                     ok = false;
@@ -1711,7 +2528,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         // get the outer tetrahedron of camera c for the ray to p = the last tetrahedron
         if(lastFinite != GEO::NO_CELL)
         {
-#pragma OMP_ATOMIC_WRITE
+            OMP_ATOMIC_WRITE
             _cellsAttr[lastFinite].cellSWeight = (float)maxint;
         }
     }
@@ -1724,10 +2541,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
 
         CellIndex ci = f1.cellIndex;
         if(ci != GEO::NO_CELL)
-        {
-#pragma OMP_ATOMIC_UPDATE
-            _cellsAttr[ci].on += weight;
-        }
+            addWeight(_cellsAttr[ci].on, weight, out_weights);
 
         Point3d p = po; // HAS TO BE HERE !!!
 
@@ -1737,12 +2551,8 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
             GC_cellInfo& c = _cellsAttr[ci];
             {
                 if(behind)
-                {
-#pragma OMP_ATOMIC_UPDATE
-                    c.cellTWeight += weight;
-                }
-#pragma OMP_ATOMIC_UPDATE
-                c.in += weight;
+                    addWeight(c.cellTWeight, weight, out_weights);
+                addWeight(c.in, weight, out_weights);
             }
 
             ++out_nstepsBehind;
@@ -1772,8 +2582,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
                 }
                 else
                 {
-#pragma OMP_ATOMIC_UPDATE
-                    _cellsAttr[f2.cellIndex].gEdgeVisWeight[f2.localVertexIndex] += weight * dist;
+                    addWeight(_cellsAttr[f2.cellIndex].gEdgeVisWeight[f2.localVertexIndex], weight * dist, out_weights);
                 }
                 ci = f2.cellIndex;
             }
@@ -1783,10 +2592,7 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         if(!behind)
         {
             if(ci != GEO::NO_CELL)
-            {
-#pragma OMP_ATOMIC_UPDATE
-                _cellsAttr[ci].cellTWeight += weight;
-            }
+                addWeight(_cellsAttr[ci].cellTWeight, weight, out_weights);
         }
     }
 }
@@ -1807,21 +2613,18 @@ void DelaunayGraphCut::forceTedgesByGradientCVPR11(bool fixesSigma, float nPixel
         c.on = 0.0f;
     }
 
-    // choose random order to prevent waiting
-    StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
+    const bool deterministic = mp->userParams.get<bool>("delaunaycut.deterministic", system::isDeterministic());
 
-#pragma omp parallel for
-    for(int i = 0; i < vetexesToProcessIdsRand->size(); ++i)
+    processVerticesWeights(_verticesAttr.size(), deterministic, [&](int vi, WeightAdditions* weights)
     {
-        int vi = (*vetexesToProcessIdsRand)[i];
-        GC_vertexInfo& v = _verticesAttr[vi];
-        if(v.isVirtual())
-            continue;
+        const int nbCams = getNbVertexCameras(vi);
+        if(nbCams == 0)
+            return;
 
         const Point3d& po = _verticesCoords[vi];
-        for(int c = 0; c < v.cams.size(); ++c)
+        for(int c = 0; c < nbCams; ++c)
         {
-            int cam = v.cams[c];
+            int cam = getVertexCamera(vi, c);
 
             Facet fFirst = getFacetInFrontVertexOnTheRayToTheCam(vi, cam);
 
@@ -1871,17 +2674,14 @@ void DelaunayGraphCut::forceTedgesByGradientCVPR11(bool fixesSigma, float nPixel
                     float eLast = _cellsAttr[f2.cellIndex].out;
                     if((eFirst > eLast) && (eFirst < beta) && (eLast / eFirst < delta))
                     {
-#pragma OMP_ATOMIC_UPDATE
-                        _cellsAttr[ci].on += (eFirst - eLast);
+                        addWeight(_cellsAttr[ci].on, eFirst - eLast, weights);
                     }
                 }
             }
 
         } // for c
 
-    } // for i
-
-    delete vetexesToProcessIdsRand;
+    });
 
     for(GC_cellInfo& c: _cellsAttr)
     {
@@ -1922,29 +2722,29 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSi
         // c.out = c.gEdgeVisWeight[0] + c.gEdgeVisWeight[1] + c.gEdgeVisWeight[2] + c.gEdgeVisWeight[3];
     }
 
-    // choose random order to prevent waiting
-    StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
+    const bool deterministic = mp->userParams.get<bool>("delaunaycut.deterministic", system::isDeterministic());
 
     int64_t avStepsFront = 0;
     int64_t aAvStepsFront = 0;
     int64_t avStepsBehind = 0;
     int64_t nAvStepsBehind = 0;
 
-#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind)
-    for(int i = 0; i < vetexesToProcessIdsRand->size(); ++i)
+    processVerticesWeights(_verticesAttr.size(), deterministic, [&](int vi, WeightAdditions* weights)
     {
-        int vi = (*vetexesToProcessIdsRand)[i];
-        GC_vertexInfo& v = _verticesAttr[vi];
-        if(v.isVirtual())
-            continue;
+        const int nbCams = getNbVertexCameras(vi);
+        if(nbCams == 0)
+            return;
+
+        int64_t vStepsFront = 0;
+        int64_t vStepsBehind = 0;
 
         const Point3d& po = _verticesCoords[vi];
-        for(int c = 0; c < v.cams.size(); ++c)
+        for(int c = 0; c < nbCams; ++c)
         {
             int nstepsFront = 0;
             int nstepsBehind = 0;
 
-            int cam = v.cams[c];
+            int cam = getVertexCamera(vi, c);
             float maxDist = 0.0f;
             if(fixesSigma)
             {
@@ -2053,20 +2853,24 @@ void DelaunayGraphCut::forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSi
                        (maxSilent < maxSilentPartRange)) // g < k_outl                  //// k_outl=100  // 400 in the paper
                         //(maxSilent-minSilent<maxSilentPartRange))
                     {
-#pragma OMP_ATOMIC_UPDATE
-                        _cellsAttr[ci].on += (maxJump - midSilent);
+                        addWeight(_cellsAttr[ci].on, maxJump - midSilent, weights);
                     }
                 }
             }
 
-            avStepsFront += nstepsFront;
-            aAvStepsFront += 1;
-            avStepsBehind += nstepsBehind;
-            nAvStepsBehind += 1;
+            vStepsFront += nstepsFront;
+            vStepsBehind += nstepsBehind;
         }
-    }
 
-    delete vetexesToProcessIdsRand;
+        OMP_ATOMIC_UPDATE
+        avStepsFront += vStepsFront;
+        OMP_ATOMIC_UPDATE
+        aAvStepsFront += nbCams;
+        OMP_ATOMIC_UPDATE
+        avStepsBehind += vStepsBehind;
+        OMP_ATOMIC_UPDATE
+        nAvStepsBehind += nbCams;
+    });
 
     for(GC_cellInfo& c: _cellsAttr)
     {
@@ -2155,7 +2959,7 @@ void DelaunayGraphCut::updateGraphFromTmpPtsCamsHexahRC(int rc, Point3d hexah[8]
                 while(ok)
                 {
                     {
-#pragma OMP_ATOMIC_UPDATE
+                        OMP_ATOMIC_UPDATE
                         _cellsAttr[tmp_ci].out += weight;
                     }
 
@@ -2175,7 +2979,7 @@ void DelaunayGraphCut::updateGraphFromTmpPtsCamsHexahRC(int rc, Point3d hexah[8]
                         }
                         else
                         {
-#pragma OMP_ATOMIC_UPDATE
+                            OMP_ATOMIC_UPDATE
                             _cellsAttr[f2.cellIndex].gEdgeVisWeight[f2.localVertexIndex] += weight;
                         }
                         tmp_ci = f2.cellIndex;
@@ -2239,6 +3043,9 @@ int DelaunayGraphCut::setIsOnSurface()
 
 void DelaunayGraphCut::graphCutPostProcessing()
 {
+    ALICEVISION_PROFILE_SCOPE("DelaunayGraphCut::graphCutPostProcessing");
+    const system::MemoryStage memoryStage("DelaunayGraphCut::graphCutPostProcessing");
+
     long timer = std::clock();
     ALICEVISION_LOG_INFO("Graph cut post-processing.");
     invertFullStatusForSmallLabels();
@@ -2433,13 +3240,21 @@ void DelaunayGraphCut::createDensePointCloudFromPrecomputedDensePoints(Point3d h
 
   // add volume points to prevent singularities
   addHelperPoints(nGridHelperVolumePointsDim, hexah, minDist);
+
+  compactVerticesCams();
 }
 
 
 void DelaunayGraphCut::createDensePointCloud(Point3d hexah[8], const StaticVector<int>& cams, const sfmData::SfMData* sfmData, const FuseParams* depthMapsFuseParams)
 {
+  ALICEVISION_PROFILE_SCOPE("DelaunayGraphCut::createDensePointCloud");
+  const system::MemoryStage memoryStage("DelaunayGraphCut::createDensePointCloud");
+
   assert(sfmData != nullptr || depthMapsFuseParams != nullptr);
 
+  if(loadDensePointCloudCheckpoint())
+    return;
+
   ALICEVISION_LOG_INFO("Creating dense point cloud.");
 
   float minDist = hexah ? (hexah[0] - hexah[1]).size() / 1000.0f : 0.00001f;
@@ -2465,17 +3280,29 @@ void DelaunayGraphCut::createDensePointCloud(Point3d hexah[8], const StaticVecto
 
   // add volume points to prevent singularities
   addHelperPoints(nGridHelperVolumePointsDim, hexah, minDist);
+
+  compactVerticesCams();
+
+  saveDensePointCloudCheckpoint();
 }
 
 void DelaunayGraphCut::createGraphCut(Point3d hexah[8], const StaticVector<int>& cams, VoxelsGrid* ls, const std::string& folderName, const std::string& tmpCamsPtsFolderName, bool removeSmallSegments, const Point3d& spaceSteps)
 {
-  initVertices();
+  ALICEVISION_PROFILE_SCOPE("DelaunayGraphCut::createGraphCut");
+  const system::MemoryStage memoryStage("DelaunayGraphCut::createGraphCut");
 
-  // Create tetrahedralization
-  computeDelaunay();
-  displayStatistics();
+  if(!loadTetrahedralizationCheckpoint())
+  {
+    initVertices();
 
-  computeVerticesSegSize(true, 0.0f); // TODO: could go into the "if(removeSmallSegments)"?
+    // Create tetrahedralization
+    computeDelaunay();
+
+    computeVerticesSegSize(true, 0.0f); // TODO: could go into the "if(removeSmallSegments)"?
+
+    saveTetrahedralizationCheckpoint();
+  }
+  displayStatistics();
 
   if(removeSmallSegments) // false
     removeSmallSegs(2500); // TODO FACA: to decide
@@ -2523,11 +3350,34 @@ void DelaunayGraphCut::reconstructGC(const Point3d* hexah)
 
 void DelaunayGraphCut::maxflow()
 {
-    long t_maxflow = clock();
+    // the parallel push-relabel is slower than Boykov-Kolmogorov on a single thread and on small graphs,
+    // and its flow depends on the threads scheduling
+    const std::size_t parallelMinNbCells = mp->userParams.get<int>("delaunaycut.maxflowParallelMinNbCells", 2000000);
+    const bool deterministic = mp->userParams.get<bool>("delaunaycut.deterministic", system::isDeterministic());
 
     ALICEVISION_LOG_INFO("Maxflow: start allocation.");
-    // MaxFlow_CSR maxFlowGraph(_cellsAttr.size());
-    MaxFlow_AdjList maxFlowGraph(_cellsAttr.size());
+    if(!deterministic && omp_get_max_threads() > 1 && _cellsAttr.size() >= parallelMinNbCells)
+    {
+        ALICEVISION_LOG_INFO("Maxflow: parallel push-relabel.");
+        MaxFlow_PushRelabel maxFlowGraph(_cellsAttr.size());
+        maxflow(maxFlowGraph);
+    }
+    else
+    {
+        ALICEVISION_LOG_INFO("Maxflow: Boykov-Kolmogorov.");
+        // MaxFlow_CSR maxFlowGraph(_cellsAttr.size());
+        MaxFlow_AdjList maxFlowGraph(_cellsAttr.size());
+        maxflow(maxFlowGraph);
+    }
+}
+
+template <class MaxFlowGraph>
+void DelaunayGraphCut::maxflow(MaxFlowGraph& maxFlowGraph)
+{
+    ALICEVISION_PROFILE_SCOPE("DelaunayGraphCut::maxflow");
+    const system::MemoryStage memoryStage("DelaunayGraphCut::maxflow");
+
+    long t_maxflow = clock();
 
     ALICEVISION_LOG_INFO("Maxflow: add nodes.");
     // fill s-t edges
@@ -2584,7 +3434,7 @@ void DelaunayGraphCut::maxflow()
 
     ALICEVISION_LOG_INFO("Maxflow: clear cells info.");
     const std::size_t nbCells = _cellsAttr.size();
-    std::vector<GC_cellInfo>().swap(_cellsAttr); // force clear
+    decltype(_cellsAttr)().swap(_cellsAttr); // force clear
 
     long t_maxflow_compute = clock();
     // Find graph-cut solution
@@ -2641,26 +3491,31 @@ void DelaunayGraphCut::reconstructExpetiments(const StaticVector<int>& cams, con
 
         ALICEVISION_LOG_INFO("Jancosek CVPR 2011 method ( delta*100 = " << static_cast<int>(delta * 100.0f) << "):");
 
-        fillGraph(fixesSigma, sigma, true, false, false, true, distFcnHeight);
-
-        if(update)
+        if(!loadGraphCheckpoint("jancosekCVPR11"))
         {
-            t1 = clock();
-            updateGraphFromTmpPtsCamsHexah(cams, hexahInflated, tmpCamsPtsFolderName, false, distFcnHeight);
-            mvsUtils::printfElapsedTime(t1);
-        }
-        addToInfiniteSw((float)maxint);
+            fillGraph(fixesSigma, sigma, true, false, false, true, distFcnHeight);
 
-        if(saveTemporaryBinFiles)
-            saveDhInfo(folderName + "delaunayTriangulationInfoInit.bin");
+            if(update)
+            {
+                t1 = clock();
+                updateGraphFromTmpPtsCamsHexah(cams, hexahInflated, tmpCamsPtsFolderName, false, distFcnHeight);
+                mvsUtils::printfElapsedTime(t1);
+            }
+            addToInfiniteSw((float)maxint);
 
-        if((delta > 0.0f) && (delta < 1.0f))
-        {
-            forceTedgesByGradientCVPR11(fixesSigma, sigma);
-        }
+            if(saveTemporaryBinFiles)
+                saveDhInfo(folderName + "delaunayTriangulationInfoInit.bin");
 
-        if(saveTemporaryBinFiles)
-            saveDhInfo(folderName + "delaunayTriangulationInfoAfterForce.bin");
+            if((delta > 0.0f) && (delta < 1.0f))
+            {
+                forceTedgesByGradientCVPR11(fixesSigma, sigma);
+            }
+
+            if(saveTemporaryBinFiles)
+                saveDhInfo(folderName + "delaunayTriangulationInfoAfterForce.bin");
+
+            saveGraphCheckpoint("jancosekCVPR11");
+        }
 
         reconstructGC(hexahInflated);
 
@@ -2674,27 +3529,32 @@ void DelaunayGraphCut::reconstructExpetiments(const StaticVector<int>& cams, con
 
         ALICEVISION_LOG_INFO("Jancosek IJCV method ( delta*100 = " << static_cast<int>(delta * 100.0f) << " ): ");
 
-        // compute weights on edge between tetrahedra
-        fillGraph(fixesSigma, sigma, true, false, false, true, distFcnHeight);
-
-        if(update) // true by default
+        if(!loadGraphCheckpoint("jancosekIJCV"))
         {
-            t1 = clock();
-            updateGraphFromTmpPtsCamsHexah(cams, hexahInflated, tmpCamsPtsFolderName, false, distFcnHeight);
-            mvsUtils::printfElapsedTime(t1);
-        }
-        addToInfiniteSw((float)maxint);
+            // compute weights on edge between tetrahedra
+            fillGraph(fixesSigma, sigma, true, false, false, true, distFcnHeight);
 
-        if(saveTemporaryBinFiles)
-            saveDhInfo(folderName + "delaunayTriangulationInfoInit.bin");
+            if(update) // true by default
+            {
+                t1 = clock();
+                updateGraphFromTmpPtsCamsHexah(cams, hexahInflated, tmpCamsPtsFolderName, false, distFcnHeight);
+                mvsUtils::printfElapsedTime(t1);
+            }
+            addToInfiniteSw((float)maxint);
 
-        if((delta > 0.0f) && (delta < 1.0f))
-        {
-            forceTedgesByGradientIJCV(fixesSigma, sigma);
-        }
+            if(saveTemporaryBinFiles)
+                saveDhInfo(folderName + "delaunayTriangulationInfoInit.bin");
 
-        if(saveTemporaryBinFiles)
-            saveDhInfo(folderName + "delaunayTriangulationInfoAfterForce.bin");
+            if((delta > 0.0f) && (delta < 1.0f))
+            {
+                forceTedgesByGradientIJCV(fixesSigma, sigma);
+            }
+
+            if(saveTemporaryBinFiles)
+                saveDhInfo(folderName + "delaunayTriangulationInfoAfterForce.bin");
+
+            saveGraphCheckpoint("jancosekIJCV");
+        }
 
         reconstructGC(hexahInflated);
 
@@ -2705,16 +3565,21 @@ void DelaunayGraphCut::reconstructExpetiments(const StaticVector<int>& cams, con
     if(labatutCFG09)
     {
         ALICEVISION_LOG_INFO("Labatut CFG 2009 method:");
-        fillGraph(fixesSigma, sigma, true, false, true, true, distFcnHeight);
-        if(update)
+        if(!loadGraphCheckpoint("labatutCFG09"))
         {
-            t1 = clock();
-            updateGraphFromTmpPtsCamsHexah(cams, hexahInflated, tmpCamsPtsFolderName, distFcnHeight != 0.0f);
-            mvsUtils::printfElapsedTime(t1);
-        }
+            fillGraph(fixesSigma, sigma, true, false, true, true, distFcnHeight);
+            if(update)
+            {
+                t1 = clock();
+                updateGraphFromTmpPtsCamsHexah(cams, hexahInflated, tmpCamsPtsFolderName, distFcnHeight != 0.0f);
+                mvsUtils::printfElapsedTime(t1);
+            }
 
-        if(saveTemporaryBinFiles)
-            saveDhInfo(folderName + "delaunayTriangulationInfoInit.bin");
+            if(saveTemporaryBinFiles)
+                saveDhInfo(folderName + "delaunayTriangulationInfoInit.bin");
+
+            saveGraphCheckpoint("labatutCFG09");
+        }
 
         reconstructGC(hexahInflated);
 
@@ -2900,49 +3765,30 @@ void DelaunayGraphCut::segmentFullOrFree(bool full, StaticVector<int>** out_full
 {
     ALICEVISION_LOG_DEBUG("segmentFullOrFree: segmenting connected space.");
 
-    StaticVector<int>* colors = new StaticVector<int>();
-    colors->reserve(_cellIsFull.size());
-    colors->resize_with(_cellIsFull.size(), -1);
-
-    StaticVector<CellIndex>* buff = new StaticVector<CellIndex>();
-    buff->reserve(_cellIsFull.size());
-    int col = 0;
+    const int nbCells = _cellIsFull.size();
+    std::vector<bool> isSegmented(nbCells);
+    for(int ci = 0; ci < nbCells; ++ci)
+        isSegmented[ci] = (!isInfiniteCell(ci)) && (_cellIsFull[ci] == full);
 
-    // segment connected free space
-    for(CellIndex ci = 0; ci < _cellIsFull.size(); ++ci)
+    // connect the adjacent cells, the segments are numbered in the order of their first cell
+    ParallelUniverse u(nbCells);
+    #pragma omp parallel for
+    for(int ci = 0; ci < nbCells; ++ci)
     {
-        if((!isInfiniteCell(ci)) && ((*colors)[ci] == -1) && (_cellIsFull[ci] == full))
+        if(!isSegmented[ci])
+            continue;
+        for(int k = 0; k < 4; ++k)
         {
-            // backtrack all connected interior cells
-            buff->resize(0);
-            buff->push_back(ci);
-
-            while(buff->size() > 0)
-            {
-                CellIndex tmp_ci = buff->pop();
-
-                (*colors)[tmp_ci] = col;
-
-                for(int k = 0; k < 4; ++k)
-                {
-                    const CellIndex nci = _tetrahedralization->cell_adjacent(tmp_ci, k);
-                    if(nci == GEO::NO_CELL)
-                        continue;
-                    if((!isInfiniteCell(nci)) && ((*colors)[nci] == -1) &&
-                       (_cellIsFull[nci] == full))
-                    {
-                        buff->push_back(nci);
-                    }
-                }
-            }
-            ++col;
+            const CellIndex nci = _tetrahedralization->cell_adjacent(ci, k);
+            if(nci != GEO::NO_CELL && nci < ci && isSegmented[nci])
+                u.join(ci, nci);
         }
     }
 
-    delete buff;
+    StaticVector<int>* colors = new StaticVector<int>();
+    out_nsegments = u.computeLabels(isSegmented, colors->getDataWritable());
 
     *out_fullSegsColor = colors;
-    out_nsegments = col;
 }
 
 int DelaunayGraphCut::removeBubbles()
@@ -2964,11 +3810,10 @@ int DelaunayGraphCut::removeBubbles()
         if(isInfiniteCell(ci) || (*emptySegColors)[ci] < 0)
             continue;
 
-        const GC_vertexInfo& a = _verticesAttr[_tetrahedralization->cell_vertex(ci, 0)];
-        const GC_vertexInfo& b = _verticesAttr[_tetrahedralization->cell_vertex(ci, 1)];
-        const GC_vertexInfo& c = _verticesAttr[_tetrahedralization->cell_vertex(ci, 2)];
-        const GC_vertexInfo& d = _verticesAttr[_tetrahedralization->cell_vertex(ci, 3)];
-        if( a.isVirtual() || b.isVirtual() || c.isVirtual() || d.isVirtual())
+        if(isVirtualVertex(_tetrahedralization->cell_vertex(ci, 0)) ||
+           isVirtualVertex(_tetrahedralization->cell_vertex(ci, 1)) ||
+           isVirtualVertex(_tetrahedralization->cell_vertex(ci, 2)) ||
+           isVirtualVertex(_tetrahedralization->cell_vertex(ci, 3)))
         {
             // TODO FACA: check helper points are not connected to cameras?
             (*colorsToFill)[(*emptySegColors)[ci]] = false;
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <aliceVision/system/FirstTouchAllocator.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
@@ -21,8 +22,13 @@
 #include <geogram/mesh/mesh.h>
 #include <geogram/basic/geometry_nd.h>
 
+#include <future>
 #include <map>
+#include <memory>
 #include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace aliceVision {
 
@@ -32,6 +38,8 @@ class SfMData;
 
 namespace fuseCut {
 
+class CheckpointWriter;
+class CheckpointReader;
 
 struct FuseParams
 {
@@ -53,6 +61,8 @@ struct FuseParams
     float simGaussianSize = 10.0f;
     double minAngleThreshold = 0.1;
     bool refineFuse = true;
+    /// Fuse all the depths in a multi-resolution 3D spatial hash at pixel size resolution, instead of the kd-tree based filtering and visibilities
+    bool spatialHashFusion = false;
 };
 
 
@@ -61,6 +71,8 @@ class DelaunayGraphCut
 public:
     using VertexIndex = GEO::index_t;
     using CellIndex = GEO::index_t;
+    /// weights to add to the cells attributes, in the order of the rays
+    using WeightAdditions = std::vector<std::pair<float*, float>>;
 
     struct Facet
     {
@@ -82,16 +94,33 @@ public:
     std::vector<Point3d> _verticesCoords;
     /// Information attached to each vertex
     std::vector<GC_vertexInfo> _verticesAttr;
-    /// Information attached to each cell
-    std::vector<GC_cellInfo> _cellsAttr;
+    /// cameras seeing each vertex, contiguous: from _verticesCamsOffsets[vi] to [vi + 1]
+    std::vector<int> _verticesCams;
+    std::vector<std::size_t> _verticesCamsOffsets{0};
+    /// Information attached to each cell (spread on the NUMA nodes of the threads processing the cells)
+    std::vector<GC_cellInfo, system::FirstTouchAllocator<GC_cellInfo>> _cellsAttr;
     /// isFull info per cell: true is full / false is empty
     std::vector<bool> _cellIsFull;
 
     std::vector<int> _camsVertexes;
-    std::vector<std::vector<CellIndex>> _neighboringCellsPerVertex;
+    /// cells around each vertex, in ascending order: from _neighboringCellsPerVertexOffsets[vi] to [vi + 1]
+    std::vector<CellIndex, system::FirstTouchAllocator<CellIndex>> _neighboringCellsPerVertex;
+    std::vector<std::size_t> _neighboringCellsPerVertexOffsets;
+
+    struct VerticesKdTree;
+    /// kd-tree of the _nbIndexedVertices first vertices, released by computeDelaunay
+    std::unique_ptr<VerticesKdTree> _verticesKdTree;
+    std::size_t _nbIndexedVertices = 0;
 
     bool saveTemporaryBinFiles;
 
+    /// folder of the binary checkpoints of the reconstruction stages, no checkpoint if empty
+    std::string _checkpointsFolder;
+    /// load the existing checkpoints instead of recomputing their stages
+    bool _resumeFromCheckpoints = false;
+    /// checkpoint being saved in the background
+    std::future<bool> _checkpointSaving;
+
     static const GEO::index_t NO_TETRAHEDRON = GEO::NO_CELL;
 
     DelaunayGraphCut(mvsUtils::MultiViewParams* _mp);
@@ -113,6 +142,28 @@ public:
         return _verticesAttr.size();
     }
 
+    /**
+     * @brief Is the vertex a virtual point without associated camera? Like helper points or camera points.
+     */
+    inline bool isVirtualVertex(VertexIndex vi) const
+    {
+        return getNbVertexCameras(vi) == 0;
+    }
+    inline bool isRealVertex(VertexIndex vi) const
+    {
+        return getNbVertexCameras(vi) != 0;
+    }
+
+    inline std::size_t getNbVertexCameras(VertexIndex vi) const
+    {
+        return _verticesCamsOffsets[vi + 1] - _verticesCamsOffsets[vi];
+    }
+
+    inline int getVertexCamera(VertexIndex vi, std::size_t index) const
+    {
+        return _verticesCams[_verticesCamsOffsets[vi] + index];
+    }
+
     inline GEO::index_t nearestVertexInCell(GEO::index_t cellIndex, const Point3d& p) const
     {
         GEO::signed_index_t result = NO_TETRAHEDRON;
@@ -132,19 +183,27 @@ public:
         return result;
     }
 
-    inline GEO::index_t locateNearestVertex(const Point3d& p) const
-    {
-        if(_tetrahedralization->nb_vertices() == 0)
-            return GEO::NO_VERTEX;
-        /*
-        GEO::index_t cellIndex = ((const GEO::Delaunay3d*)_tetrahedralization.get())->locate(p.m); // TODO GEOGRAM: how to??
-        if(cellIndex == NO_TETRAHEDRON)
-            return GEO::NO_VERTEX;
-
-        return nearestVertexInCell(cellIndex, p);
-        */
-        return _tetrahedralization->nearest_vertex(p.m); // TODO GEOGRAM: this is a brute force approach!
-    }
+    /**
+     * @brief Index the current vertices in a kd-tree for locateNearestVertex,
+     *        the vertices added afterwards are searched linearly.
+     */
+    void updateVerticesKdTree();
+
+    /**
+     * @brief Get the nearest vertex of a point.
+     * @return GEO::NO_VERTEX if there is no vertex
+     */
+    GEO::index_t locateNearestVertex(const Point3d& p) const;
+
+    /**
+     * @brief Get the nearest vertex of each point, in parallel.
+     */
+    void locateNearestVertices(const std::vector<Point3d>& points, std::vector<GEO::index_t>& out_vertices) const;
+
+    /**
+     * @brief Get the nearest vertex of a point among nearestVertex and the vertices from firstVertex.
+     */
+    GEO::index_t nearestVertexFrom(const Point3d& p, std::size_t firstVertex, GEO::index_t nearestVertex) const;
 
     /**
      * @brief A cell is infinite if one of its vertices is infinite.
@@ -186,36 +245,10 @@ public:
         return out;
     }
 
-    void updateVertexToCellsCache()
-    {
-        _neighboringCellsPerVertex.clear();
-
-        std::map<VertexIndex, std::set<CellIndex>> neighboringCellsPerVertexTmp;
-        int coutInvalidVertices = 0;
-        for(CellIndex ci = 0, nbCells = _tetrahedralization->nb_cells(); ci < nbCells; ++ci)
-        {
-            for(VertexIndex k = 0; k < 4; ++k)
-            {
-                CellIndex vi = _tetrahedralization->cell_vertex(ci, k);
-                if(vi == GEO::NO_VERTEX || vi >= _verticesCoords.size())
-                {
-                    ++coutInvalidVertices;
-                    continue;
-                }
-                neighboringCellsPerVertexTmp[vi].insert(ci);
-            }
-        }
-        ALICEVISION_LOG_INFO("coutInvalidVertices: " << coutInvalidVertices);
-        ALICEVISION_LOG_INFO("neighboringCellsPerVertexTmp: " << neighboringCellsPerVertexTmp.size());
-        _neighboringCellsPerVertex.resize(_verticesCoords.size());
-        ALICEVISION_LOG_INFO("verticesCoords: " << _verticesCoords.size());
-        for(const auto& it: neighboringCellsPerVertexTmp)
-        {
-            const std::set<CellIndex>& input = it.second;
-            std::vector<CellIndex>& output = _neighboringCellsPerVertex[it.first];
-            output.assign(input.begin(), input.end());
-        }
-    }
+    /**
+     * @brief Build the compressed sparse row lists of the cells around each vertex.
+     */
+    void updateVertexToCellsCache();
 
     /**
      * @brief vertexToCells
@@ -228,12 +261,17 @@ public:
      */
     CellIndex vertexToCells(VertexIndex vi, int lvi) const
     {
-        const std::vector<CellIndex>& localCells = _neighboringCellsPerVertex.at(vi);
-        if(lvi >= localCells.size())
+        const std::size_t cellsEnd = _neighboringCellsPerVertexOffsets.at(vi + 1);
+        const std::size_t cell = _neighboringCellsPerVertexOffsets[vi] + lvi;
+        if(cell >= cellsEnd)
             return GEO::NO_CELL;
-        return localCells[lvi];
+        return _neighboringCellsPerVertex[cell];
     }
 
+    /**
+     * @brief Move the cameras of the new vertices from GC_vertexInfo::cams to the contiguous cameras array.
+     */
+    void compactVerticesCams();
     void initVertices();
     void computeDelaunay();
     void initCells();
@@ -242,6 +280,28 @@ public:
     void saveDhInfo(const std::string& fileNameInfo);
     void saveDh(const std::string& fileNameDh, const std::string& fileNameInfo);
 
+    /**
+     * @brief Save binary checkpoints of the dense point cloud, the tetrahedralization and the graph weights
+     *        in the background, and resume from them: createDensePointCloud, createGraphCut and reconstructExpetiments
+     *        load the last existing checkpoint instead of recomputing the previous stages.
+     * @param[in] checkpointsFolder the checkpoints folder, no checkpoint if empty
+     * @param[in] resume load the existing checkpoints of a previous run with the same inputs
+     */
+    void setCheckpoints(const std::string& checkpointsFolder, bool resume);
+    std::string getCheckpointFilepath(const std::string& name) const;
+    /// Is there a checkpoint to resume from?
+    bool hasCheckpoint(const std::string& name) const;
+    /// Wait for the checkpoint being saved in the background
+    void waitCheckpoint();
+
+    void saveDensePointCloudCheckpoint();
+    bool loadDensePointCloudCheckpoint();
+    void saveTetrahedralizationCheckpoint();
+    bool loadTetrahedralizationCheckpoint();
+    /// Save the cells weights filled by the given method, before the max-flow
+    void saveGraphCheckpoint(const std::string& method);
+    bool loadGraphCheckpoint(const std::string& method);
+
     StaticVector<StaticVector<int>*>* createPtsCams();
     StaticVector<int>* getPtsCamsHist();
     StaticVector<int>* getPtsNrcHist();
@@ -290,9 +350,13 @@ public:
 
     virtual void fillGraph(bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool labatutWeights,
                            bool fillOut, float distFcnHeight = 0.0f);
+    /**
+     * @brief Cast the ray from a vertex to a camera and add its weights to the cells attributes.
+     * @param[out] out_weights if not null, receives the weights instead of adding them atomically to the cells
+     */
     void fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam, float weight,
                            bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool fillOut,
-                           float distFcnHeight);
+                           float distFcnHeight, WeightAdditions* out_weights = nullptr);
 
     void forceTedgesByGradientCVPR11(bool fixesSigma, float nPixelSizeBehind);
     void forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSizeBehind);
@@ -311,6 +375,11 @@ public:
     void reconstructGC(const Point3d* hexah);
 
     void maxflow();
+    /**
+     * @brief Fill the graph of the cells, find the minimum cut and set the full cells.
+     */
+    template <class MaxFlowGraph>
+    void maxflow(MaxFlowGraph& maxFlowGraph);
 
     void reconstructExpetiments(const StaticVector<int>& cams, const std::string& folderName,
                                 bool update, Point3d hexahInflated[8], const std::string& tmpCamsPtsFolderName,
@@ -342,6 +411,11 @@ public:
     void leaveLargestFullSegmentOnly();
 
     mesh::Mesh* createMesh(bool filterHelperPointsTriangles = true);
+
+private:
+    void writeCheckpointAsync(const std::string& name, std::shared_ptr<const CheckpointWriter> checkpoint);
+    void writeVertices(CheckpointWriter& checkpoint) const;
+    void readVertices(CheckpointReader& checkpoint);
 };
 
 
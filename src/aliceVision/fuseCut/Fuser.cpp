@@ -6,6 +6,7 @@
 
 #include "Fuser.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
@@ -15,6 +16,7 @@
 #include <aliceVision/mvsUtils/fileIO.hpp>
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/mvsData/imageAlgo.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/accumulators/accumulators.hpp>
@@ -134,6 +136,8 @@ bool Fuser::updateInSurr(int pixSizeBall, int pixSizeBallWSP, Point3d& p, int rc
 // minNumOfModals number of other cams including this cam ... minNumOfModals /in 2,3,...
 void Fuser::filterGroups(const StaticVector<int>& cams, int pixSizeBall, int pixSizeBallWSP, int nNearestCams)
 {
+    ALICEVISION_PROFILE_SCOPE("Fuser::filterGroups");
+
     ALICEVISION_LOG_INFO("Precomputing groups.");
     long t1 = clock();
 #pragma omp parallel for
@@ -186,7 +190,8 @@ bool Fuser::filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNea
 
     for(int c = 0; c < tcams.size(); c++)
     {
-        numOfPtsMap->resize_with(w * h, 0);
+        // reset the number of points of the previous tc
+        numOfPtsMap->getDataWritable().assign(w * h, 0);
         int tc = tcams[c];
 
         StaticVector<float> tcdepthMap;
@@ -235,6 +240,9 @@ bool Fuser::filterGroupsRC(int rc, int pixSizeBall, int pixSizeBallWSP, int nNea
 // minNumOfModals number of other cams including this cam ... minNumOfModals /in 2,3,...
 void Fuser::filterDepthMaps(const StaticVector<int>& cams, int minNumOfModals, int minNumOfModalsWSP2SSP)
 {
+    ALICEVISION_PROFILE_SCOPE("Fuser::filterDepthMaps");
+    const system::MemoryStage memoryStage("Fuser::filterDepthMaps");
+
     ALICEVISION_LOG_INFO("Filtering depth maps.");
     long t1 = clock();
 
@@ -309,9 +317,17 @@ bool Fuser::filterDepthMapsRC(int rc, int minNumOfModals, int minNumOfModalsWSP2
     }
 
     using namespace imageIO;
-    OutputFileColorSpace colorspace(EImageColorSpace::NO_CONVERSION);
-    writeImage(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::depthMap, 0), w, h, depthMap, EImageQuality::LOSSLESS,  colorspace, metadata);
-    writeImage(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::simMap, 0), w, h, simMap, EImageQuality::OPTIMIZED,  colorspace, metadata);
+    if(mp->userParams.get<bool>("global.tiledHalfMaps", false))
+    {
+        writeImageTiled(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::depthMap, 0), w, h, depthMap, EImageQuality::OPTIMIZED, metadata);
+        writeImageTiled(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::simMap, 0), w, h, simMap, EImageQuality::OPTIMIZED, metadata);
+    }
+    else
+    {
+        OutputFileColorSpace colorspace(EImageColorSpace::NO_CONVERSION);
+        writeImage(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::depthMap, 0), w, h, depthMap, EImageQuality::LOSSLESS,  colorspace, metadata);
+        writeImage(getFileNameFromIndex(mp, rc, mvsUtils::EFileType::simMap, 0), w, h, simMap, EImageQuality::OPTIMIZED,  colorspace, metadata);
+    }
 
     if(mp->verbose)
         ALICEVISION_LOG_DEBUG(rc << " solved.");
@@ -0,0 +1,351 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MaxFlow_PushRelabel.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace fuseCut {
+
+namespace {
+
+/// work of a relabel in addition to the scanned arcs (values of the paper)
+const std::size_t relabelWork = 12;
+/// a global relabeling is done after globalRelabelFrequency * (6 * nbNodes + nbArcs) work
+const double globalRelabelFrequency = 0.5;
+
+inline void atomicAdd(std::atomic<float>& value, float delta)
+{
+    float current = value.load(std::memory_order_relaxed);
+    while(!value.compare_exchange_weak(current, current + delta, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * @brief Concatenate the nodes found by each thread.
+ */
+inline void appendNodes(std::vector<MaxFlow_PushRelabel::NodeType>& nodes,
+                        const std::vector<MaxFlow_PushRelabel::NodeType>& threadNodes)
+{
+#pragma omp critical(maxFlowPushRelabelAppendNodes)
+    nodes.insert(nodes.end(), threadNodes.begin(), threadNodes.end());
+}
+
+} // namespace
+
+MaxFlow_PushRelabel::MaxFlow_PushRelabel(std::size_t numNodes)
+    : _numNodes(numNodes+2)
+    , _S(NodeType(numNodes))
+    , _T(NodeType(numNodes+1))
+{
+    ALICEVISION_LOG_INFO("MaxFlow constructor.");
+    const std::size_t nbArcsEstimation = numNodes * 9 + numNodes * 2;
+    _arcsTail.reserve(nbArcsEstimation);
+    _arcsCapacity.reserve(nbArcsEstimation);
+}
+
+void MaxFlow_PushRelabel::buildGraph()
+{
+    const std::size_t nbArcs = _arcsTail.size();
+
+    _firstArc.assign(_numNodes + 1, 0);
+    for(const NodeType tail : _arcsTail)
+        ++_firstArc[tail + 1];
+    for(std::size_t n = 0; n < _numNodes; ++n)
+        _firstArc[n + 1] += _firstArc[n];
+
+    _arcHead.resize(nbArcs);
+    _arcReverse.resize(nbArcs);
+    _arcResidual.reset(new std::atomic<ValueType>[nbArcs]);
+
+    std::vector<std::size_t> nextArc(_firstArc.begin(), _firstArc.end() - 1);
+    for(std::size_t i = 0; i < nbArcs; i += 2)
+    {
+        const NodeType n1 = _arcsTail[i];
+        const NodeType n2 = _arcsTail[i + 1];
+        const std::size_t a1 = nextArc[n1]++;
+        const std::size_t a2 = nextArc[n2]++;
+
+        _arcHead[a1] = n2;
+        _arcHead[a2] = n1;
+        _arcReverse[a1] = a2;
+        _arcReverse[a2] = a1;
+        _arcResidual[a1].store(_arcsCapacity[i], std::memory_order_relaxed);
+        _arcResidual[a2].store(_arcsCapacity[i + 1], std::memory_order_relaxed);
+    }
+
+    // force clear
+    std::vector<NodeType>().swap(_arcsTail);
+    std::vector<ValueType>().swap(_arcsCapacity);
+
+    _height.reset(new std::atomic<int>[_numNodes]);
+    _newHeight.assign(_numNodes, 0);
+    _excess.assign(_numNodes, 0.0f);
+    _addedExcess.reset(new std::atomic<ValueType>[_numNodes]);
+    _pulse.reset(new std::atomic<int>[_numNodes]);
+
+#pragma omp parallel for
+    for(std::int64_t n = 0; n < static_cast<std::int64_t>(_numNodes); ++n)
+    {
+        _height[n].store(0, std::memory_order_relaxed);
+        _addedExcess[n].store(0.0f, std::memory_order_relaxed);
+        _pulse[n].store(-1, std::memory_order_relaxed);
+    }
+}
+
+void MaxFlow_PushRelabel::initPreflow()
+{
+    for(std::size_t a = _firstArc[_S]; a < _firstArc[_S + 1]; ++a)
+    {
+        const ValueType delta = _arcResidual[a].load(std::memory_order_relaxed);
+        if(delta <= 0)
+            continue;
+
+        _arcResidual[a].store(0.0f, std::memory_order_relaxed);
+        atomicAdd(_arcResidual[_arcReverse[a]], delta);
+
+        const NodeType w = _arcHead[a];
+        if(w == _T)
+            atomicAdd(_addedExcess[_T], delta);
+        else
+            _excess[w] += delta;
+    }
+}
+
+void MaxFlow_PushRelabel::globalRelabel()
+{
+    const int maxHeight = static_cast<int>(_numNodes);
+
+#pragma omp parallel for
+    for(std::int64_t n = 0; n < static_cast<std::int64_t>(_numNodes); ++n)
+        _height[n].store(maxHeight, std::memory_order_relaxed);
+    _height[_T].store(0, std::memory_order_relaxed);
+
+    // the source keeps the max height, it is never reached
+    std::vector<NodeType> frontier(1, _T);
+    std::vector<NodeType> nextFrontier;
+    for(int level = 1; !frontier.empty(); ++level)
+    {
+        nextFrontier.clear();
+
+#pragma omp parallel
+        {
+            std::vector<NodeType> threadFrontier;
+
+#pragma omp for schedule(dynamic, 256) nowait
+            for(std::int64_t i = 0; i < static_cast<std::int64_t>(frontier.size()); ++i)
+            {
+                const NodeType w = frontier[i];
+                for(std::size_t a = _firstArc[w]; a < _firstArc[w + 1]; ++a)
+                {
+                    const NodeType u = _arcHead[a];
+                    // residual arc from u to w
+                    if(u == _S || _arcResidual[_arcReverse[a]].load(std::memory_order_relaxed) <= 0)
+                        continue;
+                    int unvisited = maxHeight;
+                    if(_height[u].compare_exchange_strong(unvisited, level, std::memory_order_relaxed))
+                        threadFrontier.push_back(u);
+                }
+            }
+            appendNodes(nextFrontier, threadFrontier);
+        }
+        frontier.swap(nextFrontier);
+    }
+}
+
+void MaxFlow_PushRelabel::getActiveNodes(std::vector<NodeType>& activeNodes) const
+{
+    const int maxHeight = static_cast<int>(_numNodes);
+    activeNodes.clear();
+
+#pragma omp parallel
+    {
+        std::vector<NodeType> threadActiveNodes;
+
+#pragma omp for nowait
+        for(std::int64_t n = 0; n < static_cast<std::int64_t>(_numNodes); ++n)
+        {
+            if(n != _S && n != _T && _excess[n] > 0 && _height[n].load(std::memory_order_relaxed) < maxHeight)
+                threadActiveNodes.push_back(NodeType(n));
+        }
+        appendNodes(activeNodes, threadActiveNodes);
+    }
+}
+
+std::size_t MaxFlow_PushRelabel::discharge(NodeType v, int pulse, std::vector<NodeType>& discoveredNodes)
+{
+    const int maxHeight = static_cast<int>(_numNodes);
+    const int height = _height[v].load(std::memory_order_relaxed);
+    int newHeight = height;
+    ValueType excess = _excess[v];
+    std::size_t work = 0;
+
+    while(excess > 0)
+    {
+        int minHeight = maxHeight;
+        bool skipped = false;
+
+        for(std::size_t a = _firstArc[v]; a < _firstArc[v + 1]; ++a)
+        {
+            if(excess <= 0)
+                break;
+            ++work;
+
+            const ValueType residual = _arcResidual[a].load(std::memory_order_relaxed);
+            if(residual <= 0)
+                continue;
+
+            const NodeType w = _arcHead[a];
+            const int wHeight = _height[w].load(std::memory_order_relaxed);
+
+            // only one of two active neighbors can push to the other, from the heights of the pulse
+            if(_excess[w] > 0)
+            {
+                const bool win = (height == wHeight + 1) || (height < wHeight - 1) || (height == wHeight && v < w);
+                if(!win)
+                {
+                    skipped = true;
+                    continue;
+                }
+            }
+
+            if(newHeight == wHeight + 1)
+            {
+                // push
+                const ValueType delta = std::min(residual, excess);
+                atomicAdd(_arcResidual[a], -delta);
+                atomicAdd(_arcResidual[_arcReverse[a]], delta);
+                atomicAdd(_addedExcess[w], delta);
+                excess -= delta;
+
+                if(w != _T && _pulse[w].exchange(pulse, std::memory_order_relaxed) != pulse)
+                    discoveredNodes.push_back(w);
+            }
+            // the remaining residual arcs to a lower node are not admissible
+            if(_arcResidual[a].load(std::memory_order_relaxed) > 0 && wHeight >= newHeight)
+                minHeight = std::min(minHeight, wHeight + 1);
+        }
+
+        if(excess <= 0 || skipped)
+            break;
+
+        // relabel
+        newHeight = std::min(minHeight, maxHeight);
+        work += relabelWork;
+        if(newHeight == maxHeight)
+            break;
+    }
+
+    _newHeight[v] = newHeight;
+    atomicAdd(_addedExcess[v], excess - _excess[v]);
+    return work;
+}
+
+MaxFlow_PushRelabel::ValueType MaxFlow_PushRelabel::compute()
+{
+    ALICEVISION_LOG_INFO("Compute parallel push-relabel max flow.");
+
+    buildGraph();
+    ALICEVISION_LOG_INFO("# vertices: " << _numNodes);
+    ALICEVISION_LOG_INFO("# edges: " << _arcHead.size());
+
+    initPreflow();
+    globalRelabel();
+
+    const int maxHeight = static_cast<int>(_numNodes);
+    const double globalRelabelWork = globalRelabelFrequency * (6.0 * _numNodes + _arcHead.size());
+
+    std::vector<NodeType> activeNodes;
+    std::vector<NodeType> discoveredNodes;
+    getActiveNodes(activeNodes);
+
+    int pulse = 0;
+    int nbGlobalRelabels = 1;
+    double workSinceGlobalRelabel = 0.0;
+
+    while(true)
+    {
+        if(activeNodes.empty())
+        {
+            // the maximum preflow is reached if no node with excess can reach the sink
+            globalRelabel();
+            ++nbGlobalRelabels;
+            getActiveNodes(activeNodes);
+            if(activeNodes.empty())
+                break;
+            workSinceGlobalRelabel = 0.0;
+        }
+
+        ++pulse;
+        discoveredNodes.clear();
+        std::size_t pulseWork = 0;
+
+#pragma omp parallel for
+        for(std::int64_t i = 0; i < static_cast<std::int64_t>(activeNodes.size()); ++i)
+            _pulse[activeNodes[i]].store(pulse, std::memory_order_relaxed);
+
+#pragma omp parallel reduction(+:pulseWork)
+        {
+            std::vector<NodeType> threadDiscoveredNodes;
+
+#pragma omp for schedule(dynamic, 64) nowait
+            for(std::int64_t i = 0; i < static_cast<std::int64_t>(activeNodes.size()); ++i)
+                pulseWork += discharge(activeNodes[i], pulse, threadDiscoveredNodes);
+
+            appendNodes(discoveredNodes, threadDiscoveredNodes);
+        }
+
+        // apply the new heights and excesses of the pulse
+#pragma omp parallel for
+        for(std::int64_t i = 0; i < static_cast<std::int64_t>(activeNodes.size()); ++i)
+        {
+            const NodeType v = activeNodes[i];
+            _height[v].store(_newHeight[v], std::memory_order_relaxed);
+            _excess[v] += _addedExcess[v].exchange(0.0f, std::memory_order_relaxed);
+        }
+#pragma omp parallel for
+        for(std::int64_t i = 0; i < static_cast<std::int64_t>(discoveredNodes.size()); ++i)
+        {
+            const NodeType w = discoveredNodes[i];
+            _excess[w] += _addedExcess[w].exchange(0.0f, std::memory_order_relaxed);
+        }
+
+        workSinceGlobalRelabel += pulseWork;
+        if(workSinceGlobalRelabel > globalRelabelWork)
+        {
+            globalRelabel();
+            ++nbGlobalRelabels;
+            getActiveNodes(activeNodes);
+            workSinceGlobalRelabel = 0.0;
+            continue;
+        }
+
+        activeNodes.erase(std::remove_if(activeNodes.begin(), activeNodes.end(), [&](NodeType v) {
+            return _excess[v] <= 0 || _newHeight[v] >= maxHeight;
+        }), activeNodes.end());
+        for(const NodeType w : discoveredNodes)
+        {
+            if(_excess[w] > 0 && _height[w].load(std::memory_order_relaxed) < maxHeight)
+                activeNodes.push_back(w);
+        }
+    }
+
+    ALICEVISION_LOG_INFO("Push-relabel: " << pulse << " pulses, " << nbGlobalRelabels << " global relabelings.");
+
+    // the nodes which can reach the sink in the residual graph of the maximum preflow
+    _isTarget.resize(_numNodes);
+    for(std::size_t n = 0; n < _numNodes; ++n)
+        _isTarget[n] = (_height[n].load(std::memory_order_relaxed) < maxHeight);
+
+    return _addedExcess[_T].load(std::memory_order_relaxed);
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
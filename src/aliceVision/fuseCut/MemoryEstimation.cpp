@@ -0,0 +1,144 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MemoryEstimation.hpp"
+#include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+#include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_PushRelabel.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/// average number of cells per vertex of a 3D Delaunay tetrahedralization
+static const double CELLS_PER_VERTEX = 6.7;
+/// average number of neighboring vertices per vertex of a 3D Delaunay tetrahedralization
+static const double NEIGHBORS_PER_VERTEX = 15.5;
+/// directed arcs of the max-flow graph per cell: 2 per facet and the source or sink arc with its reverse
+static const double ARCS_PER_CELL = 10.0;
+/// the cells arrays are reallocated while the tetrahedralization is built
+static const double DELAUNAY_CONSTRUCTION_OVERHEAD = 2.0;
+/// per heap allocation, for the edge properties of the boost graph
+static const std::size_t MALLOC_OVERHEAD = 16;
+
+std::size_t MeshingMemoryEstimation::getFusionPeak() const
+{
+    return fusion;
+}
+
+std::size_t MeshingMemoryEstimation::getTetrahedralizationPeak() const
+{
+    return densePointCloud + tetrahedralization;
+}
+
+std::size_t MeshingMemoryEstimation::getGraphCutPeak() const
+{
+    // the construction buffers of the tetrahedralization are released
+    const std::size_t cells = std::size_t(double(tetrahedralization) / DELAUNAY_CONSTRUCTION_OVERHEAD);
+    return densePointCloud + cells + cellsAttributes + maxflow;
+}
+
+std::size_t MeshingMemoryEstimation::getPeak() const
+{
+    return std::max({getFusionPeak(), getTetrahedralizationPeak(), getGraphCutPeak()});
+}
+
+MeshingMemoryEstimation estimateMeshingMemory(std::size_t nbPoints, std::size_t nbInputPoints,
+                                              double nbCamerasPerPoint, bool parallelMaxflow)
+{
+    using CellIndex = DelaunayGraphCut::CellIndex;
+
+    MeshingMemoryEstimation e;
+    e.nbPoints = nbPoints;
+    e.nbCells = std::size_t(std::ceil(double(nbPoints) * CELLS_PER_VERTEX));
+
+    const double camsBytes = nbCamerasPerPoint * sizeof(int);
+
+    // coordinates, pixel size, similarity, attributes with cameras, kd-tree index
+    const double inputPointBytes = sizeof(Point3d) + sizeof(double) + sizeof(float) + sizeof(GC_vertexInfo) + camsBytes + sizeof(std::size_t);
+    e.fusion = std::size_t(double(nbInputPoints) * inputPointBytes);
+
+    const double pointBytes = sizeof(Point3d) + sizeof(GC_vertexInfo) + camsBytes + sizeof(std::size_t);
+    e.densePointCloud = std::size_t(double(nbPoints) * pointBytes);
+
+    // cell vertices and adjacent cells
+    const double cellBytes = 8.0 * sizeof(GEO::signed_index_t) * DELAUNAY_CONSTRUCTION_OVERHEAD;
+    const double neighborsBytes = (NEIGHBORS_PER_VERTEX + 1.0) * sizeof(GEO::index_t);
+    e.tetrahedralization = std::size_t(double(e.nbCells) * cellBytes + double(nbPoints) * neighborsBytes);
+
+    // cells around each vertex: 4 per cell
+    e.cellsAttributes = std::size_t(double(e.nbCells) * (sizeof(GC_cellInfo) + 4.0 * sizeof(CellIndex)) +
+                                    double(nbPoints) * sizeof(std::size_t));
+
+    if(parallelMaxflow)
+    {
+        using NodeType = MaxFlow_PushRelabel::NodeType;
+        using ValueType = MaxFlow_PushRelabel::ValueType;
+        // added arcs (tail, capacity) and compressed sparse row arcs (head, reverse, residual)
+        const double arcBytes = 2.0 * sizeof(NodeType) + 2.0 * sizeof(ValueType) + sizeof(std::size_t);
+        // first arc, heights, excesses and pulse
+        const double nodeBytes = sizeof(std::size_t) + 3.0 * sizeof(int) + 2.0 * sizeof(ValueType);
+        e.maxflow = std::size_t(double(e.nbCells) * (ARCS_PER_CELL * arcBytes + nodeBytes));
+    }
+    else
+    {
+        using Edge = MaxFlow_AdjList::Edge;
+        using EdgeDescriptor = MaxFlow_AdjList::edge_descriptor;
+        // stored edge (target and property pointer) and its property allocated on the heap
+        const double arcBytes = 2.0 * sizeof(std::size_t) + sizeof(Edge) + MALLOC_OVERHEAD;
+        // out edges vector, predecessor, color and distance of the Boykov-Kolmogorov algorithm
+        const double nodeBytes = 3.0 * sizeof(void*) + sizeof(EdgeDescriptor) + sizeof(int) + sizeof(std::size_t);
+        e.maxflow = std::size_t(double(e.nbCells) * (ARCS_PER_CELL * arcBytes + nodeBytes));
+    }
+
+    return e;
+}
+
+std::size_t computeMaxPointsForMemory(std::size_t maxMemory, std::size_t nbInputPoints,
+                                      double nbCamerasPerPoint, bool parallelMaxflow)
+{
+    if(estimateMeshingMemory(0, nbInputPoints, nbCamerasPerPoint, parallelMaxflow).getPeak() > maxMemory)
+        return 0;
+
+    // the peak memory increases with the number of points
+    std::size_t minPoints = 0;
+    std::size_t maxPoints = 1;
+    while(estimateMeshingMemory(maxPoints, nbInputPoints, nbCamerasPerPoint, parallelMaxflow).getPeak() <= maxMemory)
+    {
+        minPoints = maxPoints;
+        maxPoints *= 2;
+    }
+    while(maxPoints - minPoints > 1)
+    {
+        const std::size_t nbPoints = minPoints + (maxPoints - minPoints) / 2;
+        if(estimateMeshingMemory(nbPoints, nbInputPoints, nbCamerasPerPoint, parallelMaxflow).getPeak() <= maxMemory)
+            minPoints = nbPoints;
+        else
+            maxPoints = nbPoints;
+    }
+    return minPoints;
+}
+
+std::ostream& operator<<(std::ostream& os, const MeshingMemoryEstimation& e)
+{
+    const auto toMB = [](std::size_t bytes) { return std::size_t(std::ceil(double(bytes) / (1024.0 * 1024.0))); };
+
+    os << "Meshing memory estimation for " << e.nbPoints << " points (" << e.nbCells << " cells):" << std::endl
+       << "\t- fusion of the depth maps: " << toMB(e.fusion) << " MB" << std::endl
+       << "\t- dense point cloud: " << toMB(e.densePointCloud) << " MB" << std::endl
+       << "\t- tetrahedralization: " << toMB(e.tetrahedralization) << " MB" << std::endl
+       << "\t- cells attributes: " << toMB(e.cellsAttributes) << " MB" << std::endl
+       << "\t- max-flow graph: " << toMB(e.maxflow) << " MB" << std::endl
+       << "\t- peak: " << toMB(e.getPeak()) << " MB (fusion: " << toMB(e.getFusionPeak())
+       << " MB, tetrahedralization: " << toMB(e.getTetrahedralizationPeak())
+       << " MB, graph cut: " << toMB(e.getGraphCutPeak()) << " MB)";
+    return os;
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
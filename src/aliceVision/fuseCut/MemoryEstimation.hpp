@@ -0,0 +1,68 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Predicted memory of the meshing of one block, in bytes.
+ *
+ * The model uses the sizes of the data structures of DelaunayGraphCut and of the max-flow graphs,
+ * and the average number of cells of a 3D Delaunay tetrahedralization per vertex.
+ * It is an estimation: the number of cells and of cameras per point depend on the scene.
+ */
+struct MeshingMemoryEstimation
+{
+    std::size_t nbPoints = 0;
+    std::size_t nbCells = 0;
+
+    /// input points of the depth maps fusion, with their visibilities and kd-tree
+    std::size_t fusion = 0;
+    /// coordinates, attributes and cameras of the fused points
+    std::size_t densePointCloud = 0;
+    /// cells with their adjacency, the neighbors of the vertices and the construction buffers
+    std::size_t tetrahedralization = 0;
+    /// weights of the cells and cells around each vertex
+    std::size_t cellsAttributes = 0;
+    /// nodes and edges of the max-flow graph, with the solver buffers
+    std::size_t maxflow = 0;
+
+    /// Peak of the fusion stage
+    std::size_t getFusionPeak() const;
+    /// Peak of the tetrahedralization stage
+    std::size_t getTetrahedralizationPeak() const;
+    /// Peak of the graph cut stage: the max-flow graph is filled from the cells attributes
+    std::size_t getGraphCutPeak() const;
+    /// Peak of the whole meshing
+    std::size_t getPeak() const;
+};
+
+/**
+ * @brief Predict the memory of the meshing of one block.
+ * @param[in] nbPoints the number of points after the fusion (maxPoints)
+ * @param[in] nbInputPoints the number of depths loaded by the fusion (maxInputPoints)
+ * @param[in] nbCamerasPerPoint the average number of cameras seeing each point
+ * @param[in] parallelMaxflow the parallel push-relabel is used instead of Boykov-Kolmogorov
+ */
+MeshingMemoryEstimation estimateMeshingMemory(std::size_t nbPoints, std::size_t nbInputPoints,
+                                              double nbCamerasPerPoint, bool parallelMaxflow);
+
+/**
+ * @brief Find the largest number of points after the fusion with a meshing peak memory lower than maxMemory.
+ * @return the number of points, 0 if even the fusion does not fit in maxMemory
+ */
+std::size_t computeMaxPointsForMemory(std::size_t maxMemory, std::size_t nbInputPoints,
+                                      double nbCamerasPerPoint, bool parallelMaxflow);
+
+std::ostream& operator<<(std::ostream& os, const MeshingMemoryEstimation& estimation);
+
+} // namespace fuseCut
+} // namespace aliceVision
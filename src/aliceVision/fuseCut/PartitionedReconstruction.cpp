@@ -0,0 +1,198 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PartitionedReconstruction.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/mesh/meshPostProcessing.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <map>
+#include <stdexcept>
+#include <tuple>
+
+namespace aliceVision {
+namespace fuseCut {
+
+namespace bfs = boost::filesystem;
+
+std::vector<std::array<Point3d, 8>> computePartitions(const Point3d hexah[8], int nbPartitions)
+{
+    const double sizes[3] = {(hexah[1] - hexah[0]).size(), (hexah[3] - hexah[0]).size(), (hexah[4] - hexah[0]).size()};
+
+    Voxel dimensions(1, 1, 1);
+    while(dimensions.x * dimensions.y * dimensions.z < nbPartitions)
+    {
+        // split the axis with the longest partitions
+        int axis = 0;
+        for(int k = 1; k < 3; ++k)
+        {
+            if(sizes[k] / dimensions[k] > sizes[axis] / dimensions[axis])
+                axis = k;
+        }
+        ++dimensions[axis];
+    }
+    ALICEVISION_LOG_INFO("Partitions grid: " << dimensions.x << "x" << dimensions.y << "x" << dimensions.z << ".");
+
+    StaticVector<Point3d>* voxels = mvsUtils::computeVoxels(hexah, dimensions);
+    std::vector<std::array<Point3d, 8>> partitions(voxels->size() / 8);
+    for(int i = 0; i < partitions.size(); ++i)
+    {
+        for(int k = 0; k < 8; ++k)
+            partitions[i][k] = (*voxels)[i * 8 + k];
+    }
+    delete voxels;
+
+    return partitions;
+}
+
+std::string getPartitionFolder(const std::string& outDirectory, int partitionIndex)
+{
+    return outDirectory + "partition" + mvsUtils::num2strFourDecimal(partitionIndex) + "/";
+}
+
+void reconstructPartition(mvsUtils::MultiViewParams& mp, const std::array<Point3d, 8>& partition, float overlap,
+                          const FuseParams& fuseParams, const sfmData::SfMData* sfmData,
+                          const Point3d& spaceSteps, const std::string& folder,
+                          const std::string& checkpointsFolder, bool resume)
+{
+    bfs::create_directories(folder);
+
+    std::array<Point3d, 8> hexah;
+    mvsUtils::inflateHexahedron(partition.data(), hexah.data(), 1.0f + 2.0f * overlap);
+
+    const StaticVector<int> cams = mp.findCamsWhichIntersectsHexahedron(hexah.data());
+
+    DelaunayGraphCut delaunayGC(&mp);
+    delaunayGC.setCheckpoints(checkpointsFolder, resume);
+    bool isEmpty = cams.empty();
+    if(!isEmpty)
+    {
+        try
+        {
+            delaunayGC.createDensePointCloud(hexah.data(), cams, sfmData, &fuseParams);
+        }
+        catch(const std::runtime_error& e)
+        {
+            ALICEVISION_LOG_WARNING("No point in the partition " << folder << ": " << e.what());
+            isEmpty = true;
+        }
+    }
+
+    mesh::Mesh* mesh = nullptr;
+    StaticVector<StaticVector<int>*>* ptsCams = nullptr;
+    if(isEmpty)
+    {
+        mesh = new mesh::Mesh();
+        mesh->pts = new StaticVector<Point3d>();
+        mesh->tris = new StaticVector<mesh::Mesh::triangle>();
+        ptsCams = new StaticVector<StaticVector<int>*>();
+    }
+    else
+    {
+        delaunayGC.createGraphCut(hexah.data(), cams, nullptr, folder, folder + "SpaceCamsTracks/", false, spaceSteps);
+        delaunayGC.graphCutPostProcessing();
+        mesh = delaunayGC.createMesh();
+        ptsCams = delaunayGC.createPtsCams();
+        mesh::meshPostProcessing(mesh, ptsCams, mp, folder, nullptr, hexah.data());
+    }
+
+    // the mesh is saved last: it tells that the partition is done
+    saveArrayOfArraysToFile<int>(folder + "meshPtsCamsFromDGC.bin", ptsCams);
+    mesh->saveToBin(folder + "mesh.bin");
+
+    deleteArrayOfArrays<int>(&ptsCams);
+    delete mesh;
+}
+
+void joinPartitionsMeshes(const std::vector<std::array<Point3d, 8>>& partitions, float overlap,
+                          const std::vector<std::string>& partitionsFolders,
+                          mesh::Mesh*& out_mesh, StaticVector<StaticVector<int>*>*& out_ptsCams)
+{
+    ALICEVISION_LOG_INFO("Join the meshes of " << partitions.size() << " partitions.");
+
+    out_mesh = new mesh::Mesh();
+    out_mesh->pts = new StaticVector<Point3d>();
+    out_mesh->tris = new StaticVector<mesh::Mesh::triangle>();
+    out_ptsCams = new StaticVector<StaticVector<int>*>();
+
+    // points near the borders of the partitions: only them can be found by two partitions
+    std::map<std::tuple<double, double, double>, int> borderPoints;
+
+    for(int i = 0; i < partitions.size(); ++i)
+    {
+        const std::string meshFilepath = partitionsFolders[i] + "mesh.bin";
+        mesh::Mesh partMesh;
+        if(!partMesh.loadFromBin(meshFilepath))
+            throw std::runtime_error("Missing mesh of the partition: " + meshFilepath);
+        StaticVector<StaticVector<int>*>* partPtsCams = loadArrayOfArraysFromFile<int>(partitionsFolders[i] + "meshPtsCamsFromDGC.bin");
+
+        // keep the triangles with the center in the partition, the others belong to the neighboring partitions
+        const Point3d* partition = partitions[i].data();
+        StaticVector<int> trisIdsToStay;
+        trisIdsToStay.reserve(partMesh.tris->size());
+        for(int t = 0; t < partMesh.tris->size(); ++t)
+        {
+            const mesh::Mesh::triangle& tri = (*partMesh.tris)[t];
+            const Point3d center = ((*partMesh.pts)[tri.v[0]] + (*partMesh.pts)[tri.v[1]] + (*partMesh.pts)[tri.v[2]]) / 3.0;
+            if(mvsUtils::isPointInHexahedron(center, partition))
+                trisIdsToStay.push_back(t);
+        }
+
+        Point3d partitionInterior[8];
+        mvsUtils::inflateHexahedron(partition, partitionInterior, 1.0f - 2.0f * overlap);
+
+        // index of each point of the partition in the joined mesh
+        std::vector<int> ptIdToJoinedPtId(partMesh.pts->size(), -1);
+        for(int t: trisIdsToStay)
+        {
+            mesh::Mesh::triangle tri = (*partMesh.tris)[t];
+            for(int k = 0; k < 3; ++k)
+            {
+                int& joinedPtId = ptIdToJoinedPtId[tri.v[k]];
+                if(joinedPtId == -1)
+                {
+                    const Point3d& p = (*partMesh.pts)[tri.v[k]];
+                    StaticVector<int>* cams = (*partPtsCams)[tri.v[k]];
+                    (*partPtsCams)[tri.v[k]] = nullptr;
+                    if(cams == nullptr)
+                        cams = new StaticVector<int>();
+
+                    if(!mvsUtils::isPointInHexahedron(p, partitionInterior))
+                    {
+                        const auto it = borderPoints.emplace(std::make_tuple(p.x, p.y, p.z), out_mesh->pts->size());
+                        if(!it.second)
+                        {
+                            // already added by a neighboring partition
+                            joinedPtId = it.first->second;
+                            StaticVector<int>* joinedCams = (*out_ptsCams)[joinedPtId];
+                            for(int c = 0; c < cams->size(); ++c)
+                                joinedCams->push_back_distinct((*cams)[c]);
+                            delete cams;
+                        }
+                    }
+                    if(joinedPtId == -1)
+                    {
+                        joinedPtId = out_mesh->pts->size();
+                        out_mesh->pts->push_back(p);
+                        out_ptsCams->push_back(cams);
+                    }
+                }
+                tri.v[k] = joinedPtId;
+            }
+            out_mesh->tris->push_back(tri);
+        }
+
+        deleteArrayOfArrays<int>(&partPtsCams);
+        ALICEVISION_LOG_INFO("Partition " << i << ": " << trisIdsToStay.size() << " triangles added, joined mesh: "
+                             << out_mesh->pts->size() << " points, " << out_mesh->tris->size() << " triangles.");
+    }
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
@@ -0,0 +1,75 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+#include <aliceVision/mesh/Mesh.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Split the space into a regular grid of at least nbPartitions partitions,
+ *        the longest side of the partitions is split first.
+ * @param[in] hexah the space to split
+ * @param[in] nbPartitions the minimal number of partitions
+ * @return the 8 corners of each partition, in the order of mvsUtils::computeVoxels
+ */
+std::vector<std::array<Point3d, 8>> computePartitions(const Point3d hexah[8], int nbPartitions);
+
+/**
+ * @brief Folder of the reconstruction of a partition.
+ */
+std::string getPartitionFolder(const std::string& outDirectory, int partitionIndex);
+
+/**
+ * @brief Reconstruct the mesh of one partition from the depth maps, independently of the other partitions.
+ *
+ * The partition is inflated by the overlap on each side, so the border artefacts are outside of the partition.
+ * The mesh and the visibilities of its points are saved in the partition folder ("mesh.bin" and "meshPtsCamsFromDGC.bin"),
+ * they are empty if no point is found in the partition. Only the memory of one partition is used.
+ *
+ * @param[in] mp the multi-view parameters
+ * @param[in] partition the 8 corners of the partition
+ * @param[in] overlap the size added on each side of the partition, relatively to the partition size
+ * @param[in] fuseParams the depth maps fusion parameters
+ * @param[in] sfmData the SfM landmarks to add to the dense point cloud, or nullptr
+ * @param[in] spaceSteps the steps of the octree
+ * @param[in] folder the output folder of the partition
+ * @param[in] checkpointsFolder the folder of the checkpoints of the partition, no checkpoint if empty
+ * @param[in] resume continue from the existing checkpoints
+ */
+void reconstructPartition(mvsUtils::MultiViewParams& mp, const std::array<Point3d, 8>& partition, float overlap,
+                          const FuseParams& fuseParams, const sfmData::SfMData* sfmData,
+                          const Point3d& spaceSteps, const std::string& folder,
+                          const std::string& checkpointsFolder = "", bool resume = false);
+
+/**
+ * @brief Stitch the meshes of the partitions into one mesh.
+ *
+ * Each triangle is kept by the partition containing its center, so the overlaps are not duplicated.
+ * The points found by two neighboring partitions at the same position are merged, with the union of their visibilities.
+ *
+ * @param[in] partitions the 8 corners of each partition
+ * @param[in] overlap the overlap used for the reconstruction of the partitions
+ * @param[in] partitionsFolders the folder of each partition
+ * @param[out] out_mesh the stitched mesh
+ * @param[out] out_ptsCams the visibilities of the points of the stitched mesh
+ */
+void joinPartitionsMeshes(const std::vector<std::array<Point3d, 8>>& partitions, float overlap,
+                          const std::vector<std::string>& partitionsFolders,
+                          mesh::Mesh*& out_mesh, StaticVector<StaticVector<int>*>*& out_ptsCams);
+
+} // namespace fuseCut
+} // namespace aliceVision
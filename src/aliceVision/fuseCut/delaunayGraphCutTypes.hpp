@@ -63,25 +63,13 @@ struct GC_vertexInfo
     int segSize = 0;
     int segId = -1;
     bool isOnSurface = false;
-    /// All cameras having a visibility of this vertex. Some of them may not have contributed to the vertex position
-    StaticVector<int> cams;
-
     /**
-     * @brief Is the vertex a virtual point without associated camera? Like helper points or camera points.
+     * @brief All cameras having a visibility of this vertex. Some of them may not have contributed to the vertex position.
+     *        Only used while the points are created, then moved to the cameras of DelaunayGraphCut, stored contiguously.
      */
-    inline bool isVirtual() const { return cams.empty(); }
-    inline bool isReal() const { return !cams.empty(); }
-
-    inline std::size_t getNbCameras() const
-    {
-        return cams.size();
-    }
-
-    inline int getCamera(std::size_t index) const
-    {
-        return cams[index];
-    }
+    StaticVector<int> cams;
 
+    /// write the attributes, without the cameras
     void fwriteinfo(FILE* f) const
     {
         fwrite(&pixSize, sizeof(float), 1, f);
@@ -89,14 +77,9 @@ struct GC_vertexInfo
         fwrite(&segSize, sizeof(int), 1, f);
         fwrite(&segId, sizeof(int), 1, f);
         fwrite(&isOnSurface, sizeof(bool), 1, f);
-        int n = cams.size();
-        fwrite(&n, sizeof(int), 1, f);
-        if(n > 0)
-        {
-            fwrite(&cams[0], sizeof(int), n, f);
-        }
     }
 
+    /// read the attributes, without the cameras
     void freadinfo(FILE* f)
     {
         fread(&pixSize, sizeof(float), 1, f);
@@ -104,13 +87,6 @@ struct GC_vertexInfo
         fread(&segSize, sizeof(int), 1, f);
         fread(&segId, sizeof(int), 1, f);
         fread(&isOnSurface, sizeof(bool), 1, f);
-        int n;
-        fread(&n, sizeof(int), 1, f);
-        if(n > 0)
-        {
-            cams.resize(n);
-            fread(&cams[0], sizeof(int), n, f);
-        }
     }
 };
 
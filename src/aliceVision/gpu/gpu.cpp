@@ -17,6 +17,20 @@ bool gpuSupportCUDA(int minComputeCapabilityMajor,
     int minComputeCapabilityMinor,
     int minTotalDeviceMemory)
 {
+    const std::vector<int> devices = gpuSupportedDevicesCUDA(minComputeCapabilityMajor, minComputeCapabilityMinor, minTotalDeviceMemory);
+    if(!devices.empty())
+    {
+        ALICEVISION_LOG_INFO("Supported CUDA-Enabled GPU detected.");
+        return true;
+    }
+    return false;
+}
+
+std::vector<int> gpuSupportedDevicesCUDA(int minComputeCapabilityMajor,
+    int minComputeCapabilityMinor,
+    int minTotalDeviceMemory)
+{
+    std::vector<int> devices;
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
     int nbDevices = 0;
     cudaError_t success;
@@ -44,8 +58,7 @@ bool gpuSupportCUDA(int minComputeCapabilityMajor,
                     deviceProperties.minor >= minComputeCapabilityMinor)) &&
                 deviceProperties.totalGlobalMem >= (minTotalDeviceMemory*1024*1024))
             {
-                ALICEVISION_LOG_INFO("Supported CUDA-Enabled GPU detected.");
-                return true;
+                devices.push_back(i);
             }
             else
             {
@@ -55,14 +68,30 @@ bool gpuSupportCUDA(int minComputeCapabilityMajor,
                 );
             }
         }
-        ALICEVISION_LOG_INFO("CUDA-Enabled GPU not supported.");
+        if(devices.empty())
+            ALICEVISION_LOG_INFO("CUDA-Enabled GPU not supported.");
     }
     else
     {
         ALICEVISION_LOG_INFO("Can't find CUDA-Enabled GPU.");
     }
 #endif
+    return devices;
+}
+
+bool gpuSetDeviceCUDA(int device)
+{
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    const cudaError_t success = cudaSetDevice(device);
+    if(success != cudaSuccess)
+    {
+        ALICEVISION_LOG_ERROR("cudaSetDevice(" << device << ") failed: " << cudaGetErrorString(success));
+        return false;
+    }
+    return true;
+#else
     return false;
+#endif
 }
 
 std::string gpuInformationCUDA()
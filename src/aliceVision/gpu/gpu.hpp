@@ -7,6 +7,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace gpu {
@@ -22,6 +23,23 @@ bool gpuSupportCUDA(int minComputeCapabilityMajor,
                     int minComputeCapabilityMinor,
                     int minTotalDeviceMemory = 0);
 
+/**
+ * @brief Get all the CUDA devices supporting the given parameters
+ * @param[in] minComputeCapabilityMajor The minimum compute capability major
+ * @param[in] minComputeCapabilityMinor The minimum compute capability minor
+ * @param[in] minTotalDeviceMemory The minimum device total memory in MB
+ * @return the CUDA device ids, empty if the system has no supported device
+ */
+std::vector<int> gpuSupportedDevicesCUDA(int minComputeCapabilityMajor,
+                                         int minComputeCapabilityMinor,
+                                         int minTotalDeviceMemory = 0);
+
+/**
+ * @brief Set the CUDA device used by the calling thread
+ * @param[in] device The CUDA device id
+ * @return True if the device is selected
+ */
+bool gpuSetDeviceCUDA(int device);
 
 /**
  * @brief gpuInformationCUDA
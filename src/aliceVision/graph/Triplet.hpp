@@ -9,10 +9,12 @@
 
 #include <aliceVision/types.hpp>
 #include <aliceVision/graph/graph.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <lemon/list_graph.h>
 
 #include <algorithm>
+#include <tuple>
 #include <vector>
 
 namespace aliceVision {
@@ -119,29 +121,131 @@ bool List_Triplets(const GraphT & g, std::vector< Triplet > & vec_triplets)
   return (!vec_triplets.empty());
 }
 
-/// Return triplets contained in the graph build from IterablePairs
+/**
+ * @brief Return the triplets contained in the graph build from IterablePairs.
+ *
+ * The graph is stored in a compressed sparse row (CSR) layout where each undirected edge
+ * is oriented from its node of lower degree to its node of higher degree.
+ * Each triplet is then found exactly once, from its node of lowest rank, by the intersection
+ * of the sorted adjacency lists of the two extremities of its first oriented edge.
+ * The nodes are processed in parallel with per-thread triplet lists.
+ *
+ * @param[in] pairs The edges of the graph (pairs of node ids)
+ * @return The triplets (sorted node ids), sorted in lexicographic order
+ */
 template <typename IterablePairs>
 inline std::vector< graph::Triplet > tripletListing(
   const IterablePairs & pairs)
 {
-  std::vector< graph::Triplet > vec_triplets;
+  // contiguous node index
+  std::vector<IndexT> nodeIds;
+  for(const auto& pair : pairs)
+  {
+    nodeIds.push_back(pair.first);
+    nodeIds.push_back(pair.second);
+  }
+  std::sort(nodeIds.begin(), nodeIds.end());
+  nodeIds.erase(std::unique(nodeIds.begin(), nodeIds.end()), nodeIds.end());
+
+  const auto nodeIndex = [&nodeIds](IndexT id) -> std::size_t
+  {
+    return std::lower_bound(nodeIds.begin(), nodeIds.end(), id) - nodeIds.begin();
+  };
+
+  // unique undirected edges
+  std::vector<std::pair<std::size_t, std::size_t>> edges;
+  for(const auto& pair : pairs)
+  {
+    if(pair.first == pair.second)
+      continue;
+    const std::size_t a = nodeIndex(pair.first);
+    const std::size_t b = nodeIndex(pair.second);
+    edges.emplace_back(std::min(a, b), std::max(a, b));
+  }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  std::vector<std::size_t> degrees(nodeIds.size(), 0);
+  for(const auto& edge : edges)
+  {
+    ++degrees[edge.first];
+    ++degrees[edge.second];
+  }
+
+  // orient the edges by (degree, index) to bound the size of the adjacency lists
+  const auto lowerRank = [&degrees](std::size_t a, std::size_t b)
+  {
+    return (degrees[a] < degrees[b]) || (degrees[a] == degrees[b] && a < b);
+  };
+
+  for(auto& edge : edges)
+  {
+    if(!lowerRank(edge.first, edge.second))
+      std::swap(edge.first, edge.second);
+  }
+  std::sort(edges.begin(), edges.end());
+
+  // CSR graph, the adjacency lists are sorted by node index
+  std::vector<std::size_t> offsets(nodeIds.size() + 1, 0);
+  std::vector<std::size_t> targets(edges.size());
+  for(std::size_t i = 0; i < edges.size(); ++i)
+  {
+    ++offsets[edges[i].first + 1];
+    targets[i] = edges[i].second;
+  }
+  for(std::size_t i = 0; i < nodeIds.size(); ++i)
+    offsets[i + 1] += offsets[i];
 
-  indexedGraph putativeGraph(pairs);
+  std::vector<std::vector<graph::Triplet>> tripletsPerThread(omp_get_max_threads());
 
-  graph::List_Triplets<indexedGraph::GraphT>(putativeGraph.g, vec_triplets);
+  #pragma omp parallel for schedule(dynamic)
+  for(int u = 0; u < static_cast<int>(nodeIds.size()); ++u)
+  {
+    std::vector<graph::Triplet>& triplets = tripletsPerThread[omp_get_thread_num()];
+    const std::size_t* uBegin = &targets[0] + offsets[u];
+    const std::size_t* uEnd = &targets[0] + offsets[u + 1];
+
+    for(const std::size_t* v = uBegin; v != uEnd; ++v)
+    {
+      const std::size_t* vIt = &targets[0] + offsets[*v];
+      const std::size_t* vEnd = &targets[0] + offsets[*v + 1];
+      const std::size_t* uIt = uBegin;
 
-  //Change triplets to ImageIds
-  for (size_t i = 0; i < vec_triplets.size(); ++i)
+      // sorted lists intersection
+      while(uIt != uEnd && vIt != vEnd)
+      {
+        if(*uIt < *vIt)
+          ++uIt;
+        else if(*vIt < *uIt)
+          ++vIt;
+        else
+        {
+          IndexT triplet[3] = {nodeIds[u], nodeIds[*v], nodeIds[*uIt]};
+          std::sort(&triplet[0], &triplet[3]);
+          triplets.emplace_back(triplet[0], triplet[1], triplet[2]);
+          ++uIt;
+          ++vIt;
+        }
+      }
+    }
+  }
+
+  std::vector< graph::Triplet > vec_triplets;
   {
-    graph::Triplet & triplet = vec_triplets[i];
-    IndexT I = triplet.i, J = triplet.j , K = triplet.k;
-    I = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(I)];
-    J = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(J)];
-    K = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(K)];
-    IndexT triplet_[3] = { I, J, K };
-    std::sort(&triplet_[0], &triplet_[3]);
-    triplet = graph::Triplet(triplet_[0],triplet_[1],triplet_[2]);
+    std::size_t nbTriplets = 0;
+    for(const auto& triplets : tripletsPerThread)
+      nbTriplets += triplets.size();
+    vec_triplets.reserve(nbTriplets);
   }
+  for(const auto& triplets : tripletsPerThread)
+    vec_triplets.insert(vec_triplets.end(), triplets.begin(), triplets.end());
+
+  // deterministic order, whatever the number of threads
+  std::sort(vec_triplets.begin(), vec_triplets.end(), [](const graph::Triplet& a, const graph::Triplet& b)
+  {
+    return std::tie(a.i, a.j, a.k) < std::tie(b.i, b.j, b.k);
+  });
+
   return vec_triplets;
 }
 
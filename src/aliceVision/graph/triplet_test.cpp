@@ -268,3 +268,38 @@ BOOST_AUTO_TEST_CASE(test_for_triplet) {
     BOOST_CHECK_EQUAL(4, vec_triplets.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(test_tripletListing) {
+
+  // complete graph of 6 nodes with sparse ids, duplicated and self edges
+  aliceVision::PairSet pairs;
+  const std::vector<aliceVision::IndexT> ids = {3, 7, 12, 20, 21, 50};
+  for (std::size_t i = 0; i < ids.size(); ++i)
+  {
+    pairs.insert(std::make_pair(ids[i], ids[i]));
+    for (std::size_t j = i + 1; j < ids.size(); ++j)
+    {
+      pairs.insert(std::make_pair(ids[i], ids[j]));
+      pairs.insert(std::make_pair(ids[j], ids[i]));
+    }
+  }
+
+  const std::vector< Triplet > vec_triplets = tripletListing(pairs);
+  BOOST_CHECK_EQUAL(20, vec_triplets.size()); // C(6,3)
+
+  for (std::size_t t = 0; t < vec_triplets.size(); ++t)
+  {
+    BOOST_CHECK_LT(vec_triplets[t].i, vec_triplets[t].j);
+    BOOST_CHECK_LT(vec_triplets[t].j, vec_triplets[t].k);
+    for (std::size_t u = t + 1; u < vec_triplets.size(); ++u)
+      BOOST_CHECK(vec_triplets[t] != vec_triplets[u]);
+  }
+
+  // a fan of triangles around the node 2, sorted in lexicographic order
+  aliceVision::PairSet fan = {{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 0}, {2, 4}, {0, 2}};
+  const std::vector< Triplet > vec_fanTriplets = tripletListing(fan);
+  BOOST_CHECK_EQUAL(3, vec_fanTriplets.size());
+  BOOST_CHECK(vec_fanTriplets[0] == Triplet(0, 1, 2));
+  BOOST_CHECK(vec_fanTriplets[1] == Triplet(0, 2, 4));
+  BOOST_CHECK(vec_fanTriplets[2] == Triplet(2, 3, 4));
+}
@@ -25,9 +25,31 @@ void DebevecCalibrate::process(const std::vector< std::vector< image::Image<imag
                                const float lambda,
                                rgbCurve &response)
 {
-  const int nbGroups = ldrImageGroups.size();
-  const int nbImages = ldrImageGroups.front().size();
-  const int samplesPerImage = nbPoints / (nbGroups*nbImages);
+  std::vector<LDRSamples> samples;
+  extractSamples(ldrImageGroups, nbPoints, fisheye, samples);
+  process(samples, channelQuantization, times, weight, lambda, response);
+}
+
+void DebevecCalibrate::process(const std::vector<LDRSamples> &samples,
+                               const std::size_t channelQuantization,
+                               const std::vector< std::vector<float> > &times,
+                               const rgbCurve &weight,
+                               const float lambda,
+                               rgbCurve &response)
+{
+  const int nbGroups = samples.size();
+
+  // unknowns: the response curve then the log irradiance of each sample
+  std::vector<std::size_t> groupsFirstUnknown(nbGroups);
+  std::size_t nbUnknowns = channelQuantization;
+  std::size_t nbEquations = channelQuantization - 1;
+
+  for(unsigned int g=0; g<nbGroups; ++g)
+  {
+    groupsFirstUnknown[g] = nbUnknowns;
+    nbUnknowns += samples[g].size();
+    nbEquations += samples[g].size() * samples[g].values.size();
+  }
 
   //set channels count always RGB
   static const std::size_t channels = 3;
@@ -35,84 +57,38 @@ void DebevecCalibrate::process(const std::vector< std::vector< image::Image<imag
   //initialize response
   response = rgbCurve(channelQuantization);
 
-  for(unsigned int channel=0; channel<channels; ++channel)
+  #pragma omp parallel for
+  for(int channel=0; channel<channels; ++channel)
   {
-    Vec b = Vec::Zero(nbPoints + channelQuantization + 1);
+    Vec b = Vec::Zero(nbEquations);
     int count = 0;
 
     std::vector<T> tripletList;
-    tripletList.reserve(2 * nbPoints + 1 + 3 * channelQuantization);
+    tripletList.reserve(2 * nbEquations + 3 * channelQuantization);
 
     ALICEVISION_LOG_TRACE("filling A and b matrices");
 
+    // include the data-fitting equations
     for(unsigned int g=0; g<nbGroups; ++g)
     {
-      const std::vector< image::Image<image::RGBfColor> > &ldrImagesGroup = ldrImageGroups[g];
+      const LDRSamples &groupSamples = samples[g];
       const std::vector<float> &ldrTimes = times[g];
-      const std::size_t width = ldrImagesGroup.front().Width();
-      const std::size_t height = ldrImagesGroup.front().Height();
 
-      // include the data-fitting equations
-      // if images are fisheye, we take only pixels inside a disk with a radius of image's minimum side
-      if(fisheye)
+      for(unsigned int j=0; j<groupSamples.values.size(); ++j)
       {
-        const std::size_t minSize = std::min(width, height) * 0.97;
-        const Vec2i center(width/2, height/2);
-
-        const int xMin = std::ceil(center(0) - minSize/2);
-        const int yMin = std::ceil(center(1) - minSize/2);
-        const int xMax = std::floor(center(0) + minSize/2);
-        const int yMax = std::floor(center(1) + minSize/2);
-        const std::size_t maxDist2 = pow(minSize * 0.5, 2);
+        const float time = std::log(ldrTimes.at(j));
 
-        const int step = std::ceil(minSize / sqrt(samplesPerImage));
-        for(unsigned int j=0; j<nbImages; ++j)
+        for(std::size_t i=0; i<groupSamples.size(); ++i)
         {
-          int countValidPixels = 0;
-
-          const image::Image<image::RGBfColor> &image = ldrImagesGroup.at(j);
-          const float time = std::log(ldrTimes.at(j));
-          for(int y = yMin; y < yMax-step; y+=step)
-          {
-            for(int x = xMin; x < xMax-step; x+=step)
-            {
-              std::size_t dist2 = pow(center(0)-x, 2) + pow(center(1)-y, 2);
-              if(dist2 > maxDist2)
-                continue;
-
-              float sample = clamp(image(y, x)(channel), 0.f, 1.f);
-              float w_ij = weight(sample, channel);
-              std::size_t index = std::round(sample * (channelQuantization - 1));
-
-              tripletList.push_back(T(count, index, w_ij));
-              tripletList.push_back(T(count, channelQuantization + g*samplesPerImage + countValidPixels, -w_ij));
-
-              b(count) = w_ij * time;
-              count += 1;
-              countValidPixels += 1;
-            }
-          }
-        }
-      }
-      else
-      {
-        const int step = std::floor(width*height / samplesPerImage);
-        for(unsigned int j=0; j<nbImages; ++j)
-        {
-          const image::Image<image::RGBfColor> &image = ldrImagesGroup.at(j);
-          const float time = std::log(ldrTimes.at(j));
-          for(unsigned int i=0; i<samplesPerImage; ++i)
-          {
-            float sample = clamp(image(step*i)(channel), 0.f, 1.f);
-            float w_ij = weight(sample, channel);
-            std::size_t index = std::round(sample * (channelQuantization - 1));
-
-            tripletList.push_back(T(count, index, w_ij));
-            tripletList.push_back(T(count, channelQuantization + g*samplesPerImage + i, -w_ij));
-
-            b(count) = w_ij * time;
-            count += 1;
-          }
+          float sample = clamp(groupSamples.values[j][i](channel), 0.f, 1.f);
+          float w_ij = weight(sample, channel);
+          std::size_t index = std::round(sample * (channelQuantization - 1));
+
+          tripletList.push_back(T(count, index, w_ij));
+          tripletList.push_back(T(count, groupsFirstUnknown[g] + i, -w_ij));
+
+          b(count) = w_ij * time;
+          count += 1;
         }
       }
     }
@@ -133,18 +109,34 @@ void DebevecCalibrate::process(const std::vector< std::vector< image::Image<imag
       count += 1;
     }
 
-    sMat A(count, channelQuantization + samplesPerImage*nbGroups);
+    sMat A(count, nbUnknowns);
     A.setFromTriplets(tripletList.begin(), tripletList.end());
 
     b.conservativeResize(count);
-
-    // solve the system using SVD decomposition
     A.makeCompressed();
-    Eigen::SparseQR<sMat, Eigen::COLAMDOrdering<int>> solver;
-    solver.compute(A);
-    if(solver.info() != Eigen::Success)  return; // decomposition failed
-    Vec x = solver.solve(b);
-    if(solver.info() != Eigen::Success)  return; // solving failed
+
+    // solve the sparse normal equations
+    // the unknowns without any equation (samples of null weight) are kept at zero by a small damping
+    const sMat At = A.transpose();
+    sMat AtA = At * A;
+    for(std::size_t k = 0; k < nbUnknowns; ++k)
+      AtA.coeffRef(k, k) += 1e-10;
+
+    Vec x;
+    Eigen::SimplicialLDLT<sMat> solver(AtA);
+    if(solver.info() == Eigen::Success)
+      x = solver.solve(At * b);
+
+    if(solver.info() != Eigen::Success)
+    {
+      // fallback on the QR decomposition of the system
+      ALICEVISION_LOG_DEBUG("normal equations failed, solve with a QR decomposition");
+      Eigen::SparseQR<sMat, Eigen::COLAMDOrdering<int>> solverQR;
+      solverQR.compute(A);
+      if(solverQR.info() != Eigen::Success)  continue; // decomposition failed
+      x = solverQR.solve(b);
+      if(solverQR.info() != Eigen::Success)  continue; // solving failed
+    }
 
     ALICEVISION_LOG_TRACE("system solved");
 
@@ -7,8 +7,10 @@
 #pragma once
 #include <aliceVision/image/all.hpp>
 #include "rgbCurve.hpp"
+#include "sampling.hpp"
 #include <aliceVision/numeric/numeric.hpp>
 #include <Eigen/SparseQR>
+#include <Eigen/SparseCholesky>
 
 namespace aliceVision {
 namespace hdr {
@@ -36,6 +38,22 @@ public:
                const float lambda,
                rgbCurve &response);
 
+  /**
+   * @brief
+   * @param[in] LDR images groups samples (see extractSamples)
+   * @param[in] channel quantization
+   * @param[in] exposure times
+   * @param[in] calibration weight function
+   * @param[in] lambda (parameter of smoothness)
+   * @param[out] camera response function
+   */
+  void process(const std::vector<LDRSamples> &samples,
+               const std::size_t channelQuantization,
+               const std::vector< std::vector<float> > &times,
+               const rgbCurve &weight,
+               const float lambda,
+               rgbCurve &response);
+
 };
 
 } // namespace hdr
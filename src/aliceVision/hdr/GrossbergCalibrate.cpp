@@ -28,9 +28,17 @@ void GrossbergCalibrate::process(const std::vector< std::vector< image::Image<im
                                  const bool fisheye,
                                  rgbCurve &response)
 {
-    const int nbGroups = ldrImageGroups.size();
-    const int nbImages = ldrImageGroups.front().size();
-    const int samplesPerImage = nbPoints / (nbGroups*nbImages);
+    std::vector<LDRSamples> samples;
+    extractSamples(ldrImageGroups, nbPoints, fisheye, samples);
+    process(samples, channelQuantization, times, response);
+}
+
+void GrossbergCalibrate::process(const std::vector<LDRSamples> &samples,
+                                 const std::size_t channelQuantization,
+                                 const std::vector< std::vector<float> > &times,
+                                 rgbCurve &response)
+{
+    const int nbGroups = samples.size();
 
     //set channels count always RGB
     static const std::size_t channels = 3;
@@ -94,110 +102,50 @@ void GrossbergCalibrate::process(const std::vector< std::vector< image::Image<im
         H.col(i) = Eigen::Map<Vec>(hCurves[i].data(), channelQuantization);
     }
 
-    Mat A = Mat::Zero(samplesPerImage*(nbImages-1)*nbGroups*channels, _dimension);
-    Vec b = Vec::Zero(samplesPerImage*(nbImages-1)*nbGroups*channels);
-
-    if(fisheye)
-    {
-      int count = 0;
+    // one equation per sample, channel and pair of consecutive images
+    std::size_t nbEquations = 0;
+    for(unsigned int g=0; g<nbGroups; ++g)
+      nbEquations += samples[g].size() * (samples[g].values.size() - 1) * channels;
 
-      for(unsigned int g=0; g<nbGroups; ++g)
-      {
-        const std::vector< image::Image<image::RGBfColor> > &ldrImagesGroup = ldrImageGroups[g];
-        const std::vector<float> &ldrTimes= times[g];
-
-        const std::size_t width = ldrImagesGroup.front().Width();
-        const std::size_t height = ldrImagesGroup.front().Height();
-
-        const std::size_t minSize = std::min(width, height) * 0.97;
-        const Vec2i center(width/2, height/2);
-
-        const int xMin = std::ceil(center(0) - minSize/2);
-        const int yMin = std::ceil(center(1) - minSize/2);
-        const int xMax = std::floor(center(0) + minSize/2);
-        const int yMax = std::floor(center(1) + minSize/2);
-        const std::size_t maxDist2 = pow(minSize * 0.5, 2);
-
-        ALICEVISION_LOG_TRACE("filling A and b matrices");
-
-        for(unsigned int channel=0; channel<channels; ++channel)
-        {
-          const int step = std::ceil(minSize / sqrt(samplesPerImage));
-          for(unsigned int j=0; j<nbImages-1; ++j)
-          {
-            const image::Image<image::RGBfColor> &image1 = ldrImagesGroup.at(j);
-            const image::Image<image::RGBfColor> &image2 = ldrImagesGroup.at(j+1);
-            const double k = ldrTimes.at(j+1)/ldrTimes.at(j);
-
-            // fill A and b matrices with the equations
-            for(int y = yMin; y <= yMax-step; y+=step)
-            {
-              for(int x = xMin; x <= xMax-step; x+=step)
-              {
-                std::size_t dist2 = pow(center(0)-x, 2) + pow(center(1)-y, 2);
-                if(dist2 > maxDist2)
-                  continue;
+    Mat A = Mat::Zero(nbEquations, _dimension);
+    Vec b = Vec::Zero(nbEquations);
 
-                double sample1 = clamp(image1(y, x)(channel), 0.f, 1.f);
-                double sample2 = clamp(image2(y, x)(channel), 0.f, 1.f);
+    ALICEVISION_LOG_TRACE("filling A and b matrices");
 
-                std::size_t index1 = std::round((channelQuantization-1) * sample1);
-                std::size_t index2 = std::round((channelQuantization-1) * sample2);
+    int count = 0;
 
-                b(count) = response.getCurve(channel).at(index2) - k * response.getCurve(channel).at(index1);
-                for(unsigned int i=0; i<_dimension; ++i)
-                  A(count, i) = k * H(index1, i) - H(index2, i);
-
-                count += 1;
-              }
-            }
-          }
-        }
-      }
-
-      A.conservativeResize(count, Eigen::NoChange_t::NoChange);
-      b.conservativeResize(count);
-    }
-
-    else
+    for(unsigned int g=0; g<nbGroups; ++g)
     {
-      for(unsigned int g=0; g<nbGroups; ++g)
-      {
-        const std::vector< image::Image<image::RGBfColor> > &ldrImagesGroup = ldrImageGroups[g];
-        const std::vector<float> &ldrTimes= times[g];
+      const LDRSamples &groupSamples = samples[g];
+      const std::vector<float> &ldrTimes= times[g];
 
-        const std::size_t width = ldrImagesGroup.front().Width();
-        const std::size_t height = ldrImagesGroup.front().Height();
-
-        for(unsigned int channel=0; channel<channels; ++channel)
+      for(unsigned int channel=0; channel<channels; ++channel)
+      {
+        for(unsigned int j=0; j<groupSamples.values.size()-1; ++j)
         {
-          const int step = std::floor(width*height / samplesPerImage);
-          for(unsigned int j=0; j<nbImages-1; ++j)
-          {
-            const image::Image<image::RGBfColor> &image1 = ldrImagesGroup.at(j);
-            const image::Image<image::RGBfColor> &image2 = ldrImagesGroup.at(j+1);
-            const double k = ldrTimes.at(j+1)/ldrTimes.at(j);
+          const std::vector<image::RGBfColor> &samples1 = groupSamples.values.at(j);
+          const std::vector<image::RGBfColor> &samples2 = groupSamples.values.at(j+1);
+          const double k = ldrTimes.at(j+1)/ldrTimes.at(j);
 
-            // fill A and b matrices with the equations
-            for(unsigned int l=0; l<samplesPerImage; ++l)
-            {
-                double sample1 = std::max(0.f, std::min(1.f, image1(step*l)(channel)));
-                double sample2 = std::max(0.f, std::min(1.f, image2(step*l)(channel)));
+          // fill A and b matrices with the equations
+          for(std::size_t l=0; l<groupSamples.size(); ++l)
+          {
+            double sample1 = clamp(samples1[l](channel), 0.f, 1.f);
+            double sample2 = clamp(samples2[l](channel), 0.f, 1.f);
 
+            std::size_t index1 = std::round((channelQuantization-1) * sample1);
+            std::size_t index2 = std::round((channelQuantization-1) * sample2);
 
-                std::size_t index1 = std::round((channelQuantization-1) * sample1);
-                std::size_t index2 = std::round((channelQuantization-1) * sample2);
+            b(count) = response.getCurve(channel).at(index2) - k * response.getCurve(channel).at(index1);
+            for(unsigned int i=0; i<_dimension; ++i)
+              A(count, i) = k * H(index1, i) - H(index2, i);
 
-                b(g*channels*(nbImages-1)*samplesPerImage + channel*(nbImages-1)*samplesPerImage + j*samplesPerImage + l) = response.getCurve(channel).at(index2) - k * response.getCurve(channel).at(index1);
-                for(unsigned int i=0; i<_dimension; ++i)
-                  A(g*channels*(nbImages-1)*samplesPerImage + channel*(nbImages-1)*samplesPerImage + j*samplesPerImage + l, i) = k * H(index1, i) - H(index2, i);
-            }
+            count += 1;
           }
         }
       }
     }
 
-
     ALICEVISION_LOG_TRACE("solving Ax=b system");
 
     // solve the system using QR decomposition
@@ -22,14 +22,28 @@ void RobertsonCalibrate::process(const std::vector< std::vector< image::Image<im
                                  const rgbCurve &weight,
                                  rgbCurve &response)
 {
-  const int nbGroups = ldrImageGroups.size();
-  const int nbImages = ldrImageGroups.front().size();
-  const int samplesPerImage = nbPoints / (nbGroups*nbImages);
+  std::vector<LDRSamples> samples;
+  extractSamples(ldrImageGroups, nbPoints, fisheye, samples);
+  process(samples, channelQuantization, times, weight, response);
+}
+
+void RobertsonCalibrate::process(const std::vector<LDRSamples> &samples,
+                                 const std::size_t channelQuantization,
+                                 const std::vector< std::vector<float> > &times,
+                                 const rgbCurve &weight,
+                                 rgbCurve &response)
+{
+  const int nbGroups = samples.size();
 
   //set channels count always RGB
   static const std::size_t channels = 3;
 
-  //create radiance vector of image
+  const auto getIndex = [channelQuantization](float value) -> std::size_t
+  {
+    return std::round(clamp(value, 0.f, 1.f) * (channelQuantization - 1));
+  };
+
+  //create radiance vector of the samples
   _radiance = std::vector< image::Image<image::RGBfColor> >(nbGroups);
 
   //initialize response
@@ -44,66 +58,16 @@ void RobertsonCalibrate::process(const std::vector< std::vector< image::Image<im
   //compute cardinal curve
   for(unsigned int g = 0; g < nbGroups; ++g)
   {
-    const std::vector< image::Image<image::RGBfColor> > &ldrImagesGroup = ldrImageGroups[g];
-    const std::size_t width = ldrImagesGroup.front().Width();
-    const std::size_t height = ldrImagesGroup.front().Height();
+    _radiance[g].resize(samples[g].size(), 1, false);
 
-    _radiance[g].resize(width, height, false);
-
-    // if images are fisheye, we take only pixels inside a disk with a radius of image's minimum side
-    if(fisheye)
+    for(const std::vector<image::RGBfColor> &values : samples[g].values)
     {
-      const std::size_t minSize = std::min(width, height) * 0.97;
-      const Vec2i center(width/2, height/2);
-      const std::size_t maxDist2 = pow(minSize * 0.5, 2);
-
-      const int xMin = std::ceil(center(0) - minSize/2);
-      const int yMin = std::ceil(center(1) - minSize/2);
-      const int xMax = std::floor(center(0) + minSize/2);
-      const int yMax = std::floor(center(1) + minSize/2);
-
-      const int step = std::ceil(minSize / sqrt(samplesPerImage));
-
-      for(unsigned int j=0; j<nbImages; ++j)
+      for(const image::RGBfColor &pixelValue : values)
       {
-        const image::Image<image::RGBfColor> &image = ldrImagesGroup.at(j);
-        for(int y = yMin; y <= yMax-step; y+=step)
+        for(std::size_t channel = 0; channel < channels; ++channel)
         {
-          for(int x = xMin; x <= xMax-step; x+=step)
-          {
-            std::size_t dist2 = pow(center(0)-x, 2) + pow(center(1)-y, 2);
-            if(dist2 > maxDist2)
-              continue;
-
-            const image::RGBfColor &pixelValue = image(y, x);
-
-            for(std::size_t channel = 0; channel < channels; ++channel)
-            {
-              //number of pixel with the same value
-              std::size_t index = std::round(clamp(pixelValue(channel), 0.f, 1.f) * (channelQuantization - 1));
-              card.getValue(index, channel) += 1;
-            }
-          }
-        }
-      }
-    }
-    else
-    {
-      const int step = std::floor(width * height / samplesPerImage);
-      for(unsigned int j=0; j<nbImages; ++j)
-      {
-        const image::Image<image::RGBfColor> &image = ldrImagesGroup.at(j);
-
-        for(std::size_t i=0; i<nbPoints; ++i)
-        {
-            const image::RGBfColor &pixelValue = image(step*i);
-
-            for(std::size_t channel = 0; channel < channels; ++channel)
-            {
-              //number of pixel with the same value
-              std::size_t index = std::round(clamp(pixelValue(channel), 0.f, 1.f) * (channelQuantization - 1));
-              card.getValue(index, channel) += 1;
-            }
+          //number of pixel with the same value
+          card.getValue(getIndex(pixelValue(channel)), channel) += 1;
         }
       }
     }
@@ -121,10 +85,14 @@ void RobertsonCalibrate::process(const std::vector< std::vector< image::Image<im
     ALICEVISION_LOG_TRACE("--> iteration : "<< iter);
 
     ALICEVISION_LOG_TRACE("1) compute radiance ");
-    //initialize radiance
+    //merge the samples
     for(std::size_t g = 0; g < nbGroups; ++g)
     {
-      merge.process(ldrImageGroups[g], times[g], weight, response, _radiance[g], 1.f, true);
+      std::vector<const image::RGBfColor*> rows;
+      for(const std::vector<image::RGBfColor> &values : samples[g].values)
+        rows.push_back(values.data());
+
+      merge.processRow(rows, samples[g].size(), times[g], weight, response, _radiance[g].data(), 1.f, true);
     }
 
     ALICEVISION_LOG_TRACE("2) initialization new response ");
@@ -133,73 +101,40 @@ void RobertsonCalibrate::process(const std::vector< std::vector< image::Image<im
     newResponse.setZero();
 
     ALICEVISION_LOG_TRACE("3) compute new response ");
-    //compute new response
-    for(unsigned int g = 0; g < nbGroups; ++g)
+    //compute new response, accumulated by each thread then summed
+    #pragma omp parallel
     {
-      const std::vector< image::Image<image::RGBfColor> > &ldrImagesGroup = ldrImageGroups[g];
-      const std::vector<float> &ldrTimes = times[g];
-      const int nbImages = ldrImagesGroup.size();
-      const std::size_t width = ldrImagesGroup.front().Width();
-      const std::size_t height = ldrImagesGroup.front().Height();
-
-      const image::Image<image::RGBfColor> &radiance = _radiance[g];
+      std::vector<double> threadResponse(channels * channelQuantization, 0.0);
 
-      if(fisheye)
+      for(unsigned int g = 0; g < nbGroups; ++g)
       {
-        const std::size_t minSize = std::min(width, height) * 0.97;
-        const Vec2i center(width/2, height/2);
-        const std::size_t maxDist2 = pow(minSize * 0.5, 2);
-
-        const int xMin = std::ceil(center(0) - minSize/2);
-        const int yMin = std::ceil(center(1) - minSize/2);
-        const int xMax = std::floor(center(0) + minSize/2);
-        const int yMax = std::floor(center(1) + minSize/2);
-
-        const int step = std::ceil(minSize / sqrt(samplesPerImage));
+        const std::vector<float> &ldrTimes = times[g];
+        const LDRSamples &groupSamples = samples[g];
+        const image::Image<image::RGBfColor> &radiance = _radiance[g];
 
-        for(unsigned int j=0; j<nbImages; ++j)
+        for(std::size_t j = 0; j < groupSamples.values.size(); ++j)
         {
-          const image::Image<image::RGBfColor> &image = ldrImagesGroup.at(j);
-          #pragma omp parallel for
-          for(int y = yMin; y <= yMax-step; y+=step)
-          {
-            for(int x = xMin; x <= xMax-step; x+=step)
-            {
-              std::size_t dist2 = pow(center(0)-x, 2) + pow(center(1)-y, 2);
-              if(dist2 > maxDist2)
-                continue;
-
-              const image::RGBfColor &pixelValue = image(y, x);
-              const image::RGBfColor &radianceValue = radiance(y, x);
-
-              for(std::size_t channel = 0; channel < channels; ++channel)
-              {
-                  std::size_t index = std::round(clamp(pixelValue(channel), 0.f, 1.f) * (channelQuantization - 1));
-                  newResponse.getValue(index, channel) += ldrTimes.at(j) * (radianceValue(channel));
-              }
-            }
-          }
-        }
-      }
-      else
-      {
-        const int step = std::floor(width * height / samplesPerImage);
-        for(unsigned int j=0; j<nbImages; ++j)
-        {
-          #pragma omp parallel for
-          for(int i=0; i<nbPoints; ++i)
+          const std::vector<image::RGBfColor> &values = groupSamples.values[j];
+          const int nbSamples = groupSamples.size();
+
+          #pragma omp for nowait
+          for(int i = 0; i < nbSamples; ++i)
           {
-            const image::RGBfColor &pixelValue = ldrImagesGroup.at(j)(step*i);
-            const image::RGBfColor &radianceValue = radiance(step*i);
+            const image::RGBfColor &pixelValue = values[i];
+            const image::RGBfColor &radianceValue = radiance(i);
 
             for(std::size_t channel = 0; channel < channels; ++channel)
-            {
-                std::size_t index = std::round(clamp(pixelValue(channel), 0.f, 1.f) * (channelQuantization - 1));
-                newResponse.getValue(index, channel) += ldrTimes.at(j) * (radianceValue(channel));
-            }
+              threadResponse[channel * channelQuantization + getIndex(pixelValue(channel))] += ldrTimes.at(j) * (radianceValue(channel));
           }
         }
       }
+
+      #pragma omp critical
+      {
+        for(std::size_t channel = 0; channel < channels; ++channel)
+          for(std::size_t k = 0; k < channelQuantization; ++k)
+            newResponse.getValue(k, channel) += threadResponse[channel * channelQuantization + k];
+      }
     }
     newResponse.interpolateMissingValues();
     //dividing the response by the cardinal curve
@@ -8,6 +8,7 @@
 #include <aliceVision/image/all.hpp>
 #include "rgbCurve.hpp"
 #include "hdrMerge.hpp"
+#include "sampling.hpp"
 
 
 namespace aliceVision {
@@ -44,6 +45,20 @@ public:
                const rgbCurve &weight,
                rgbCurve &response);
 
+  /**
+   * @brief Calculate the camera response function according to Robertson method
+   * @param[in] LDR images groups samples (see extractSamples)
+   * @param[in] channel quantization
+   * @param[in] exposure times
+   * @param[in] calibration weight function
+   * @param[out] camera response function
+   */
+  void process(const std::vector<LDRSamples> &samples,
+               const std::size_t channelQuantization,
+               const std::vector< std::vector<float> > &times,
+               const rgbCurve &weight,
+               rgbCurve &response);
+
 
   int getMaxIteration() const
   {
@@ -65,6 +80,11 @@ public:
     _threshold = value;
   }
 
+  /**
+   * @brief Get the radiance of the samples of a group, as a row (see LDRSamples)
+   * @param[in] group
+   * @return the radiance of the samples
+   */
   const image::Image<image::RGBfColor>& getRadiance(std::size_t group) const
   {
     assert(group < _radiance.size());
@@ -73,7 +93,7 @@ public:
   }
 
 private:
-  /// Vector containing the HDR images for each group
+  /// Vector containing the HDR samples for each group
   std::vector< image::Image<image::RGBfColor> > _radiance;
   /// If the difference between responses is below the threshold we stop the iteration
   double _threshold;
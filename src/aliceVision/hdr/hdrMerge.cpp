@@ -10,12 +10,132 @@
 #include <limits>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <stdexcept>
 #include <aliceVision/alicevision_omp.hpp>
 
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+
+#include <boost/filesystem.hpp>
+
 
 namespace aliceVision {
 namespace hdr {
-  
+
+namespace fs = boost::filesystem;
+
+void hdrMerge::processRow(const std::vector<const image::RGBfColor*> &rows,
+                          int width,
+                          const std::vector<float> &times,
+                          const rgbCurve &weight,
+                          const rgbCurve &response,
+                          image::RGBfColor* radianceRow,
+                          float targetTime,
+                          bool robCalibrate,
+                          float clampedValueCorrection)
+{
+  // each curve is evaluated over the contiguous pixels, for one channel and one image at a time
+  const float maxLum = 1000.0;
+  const float minLum = 0.0001;
+
+  const std::size_t weightSize = weight.getSize();
+  const std::size_t responseSize = response.getSize();
+  const float weightOffset = weight(0.05, 0);
+
+  std::vector<float> wsum(width);
+  std::vector<float> wdiv(width);
+
+  for(std::size_t channel = 0; channel < 3; ++channel)
+  {
+    const float* weightCurve = weight.getCurve(channel).data();
+    const float* responseCurve = response.getCurve(channel).data();
+
+    std::fill(wsum.begin(), wsum.end(), 0.f);
+    std::fill(wdiv.begin(), wdiv.end(), 0.f);
+
+    for(std::size_t i = 0; i < rows.size(); ++i)
+    {
+      //for each images
+      const image::RGBfColor* row = rows[i];
+      const float time = times[i];
+
+      for(int x = 0; x < width; ++x)
+      {
+        const float value = row[x](channel);
+        const float w = std::max(0.f, rgbCurve::interpolate(weightCurve, weightSize, value) - weightOffset);
+        const float r = rgbCurve::interpolate(responseCurve, responseSize, value);
+
+        wsum[x] += w * r / time;
+        wdiv[x] += w;
+      }
+    }
+
+    const image::RGBfColor* highRow = rows.front();
+    const image::RGBfColor* lowRow = rows.back();
+
+    for(int x = 0; x < width; ++x)
+    {
+      const float radiance = wsum[x] / std::max(0.001f, wdiv[x]) * targetTime;
+
+      if(!robCalibrate && clampedValueCorrection != 0.f)
+      {
+        const float clampedHighValue = 1.f - (1.f / (1.f + std::exp(10.f * ((highRow[x](channel) - 0.9f) / 0.2f))));
+        const float clampedLowValue = 1.f / (1.f + std::exp(10.f * ((lowRow[x](channel) - 0.005f) / 0.01f)));
+
+        radianceRow[x](channel) = (1.f - clampedHighValue - clampedLowValue) * radiance + clampedHighValue * maxLum * clampedValueCorrection + clampedLowValue * minLum * clampedValueCorrection;
+      }
+      else
+      {
+        radianceRow[x](channel) = radiance;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Read a block of rows of an image as RGB float values, in the requested color space
+ * @param path The image path
+ * @param in The opened image
+ * @param colorSpace The image color space
+ * @param toColorSpace The requested color space
+ * @param yBegin The first row
+ * @param nbRows The number of rows
+ * @param rows The output rows
+ */
+static void readRows(const std::string &path,
+                     oiio::ImageInput &in,
+                     const std::string &colorSpace,
+                     image::EImageColorSpace toColorSpace,
+                     int yBegin,
+                     int nbRows,
+                     std::vector<image::RGBfColor> &rows)
+{
+  const oiio::ImageSpec &spec = in.spec();
+  const int nbChannels = (spec.nchannels >= 3) ? 3 : 1;
+  const std::size_t nbPixels = static_cast<std::size_t>(spec.width) * nbRows;
+
+  // the grayscale values are read at the end of the buffer, then duplicated for RGB
+  float* data = reinterpret_cast<float*>(rows.data()) + (nbChannels == 3 ? 0 : 2 * nbPixels);
+
+  if(!in.read_scanlines(spec.y + yBegin, spec.y + yBegin + nbRows, 0, 0, nbChannels, oiio::TypeDesc::FLOAT, data))
+    throw std::runtime_error("Can't read image file '" + path + "' (" + in.geterror() + ").");
+
+  oiio::ImageBuf rowsBuf(oiio::ImageSpec(spec.width, nbRows, nbChannels, oiio::TypeDesc::FLOAT), data);
+
+  if(toColorSpace == image::EImageColorSpace::SRGB && colorSpace != "sRGB")
+    oiio::ImageBufAlgo::colorconvert(rowsBuf, rowsBuf, colorSpace, "sRGB");
+  else if(toColorSpace == image::EImageColorSpace::LINEAR && colorSpace != "Linear")
+    oiio::ImageBufAlgo::colorconvert(rowsBuf, rowsBuf, colorSpace, "Linear");
+
+  if(nbChannels == 1)
+  {
+    for(std::size_t p = 0; p < nbPixels; ++p)
+      rows[p] = image::RGBfColor(data[p]);
+  }
+}
+
 void hdrMerge::process(const std::vector< image::Image<image::RGBfColor> > &images,
                               const std::vector<float> &times,
                               const rgbCurve &weight,
@@ -30,101 +150,128 @@ void hdrMerge::process(const std::vector< image::Image<image::RGBfColor> > &imag
   assert(!images.empty());
   assert(images.size() == times.size());
 
-  //reset radiance image
-  radiance.fill(image::RGBfColor(0.f, 0.f, 0.f));
-
   //get images width, height
-  const std::size_t width = images.front().Width();
-  const std::size_t height = images.front().Height();
+  const int width = images.front().Width();
+  const int height = images.front().Height();
 
-//  //min and max trusted values
-//  const float minTrustedValue = 0.0f - std::numeric_limits<float>::epsilon();
-//  const float maxTrustedValue = 1.0f + std::numeric_limits<float>::epsilon();
-
-  const float maxLum = 1000.0;
-  const float minLum = 0.0001;
+  radiance.resize(width, height, false);
 
   #pragma omp parallel for
   for(int y = 0; y < height; ++y)
   {
-    for(int x = 0; x < width; ++x)
-    {
-      //for each pixels
-      image::RGBfColor &radianceColor = radiance(y, x);
+    std::vector<const image::RGBfColor*> rows(images.size());
+    for(std::size_t i = 0; i < images.size(); ++i)
+      rows[i] = &images[i](y, 0);
 
-//      double highValue = images.at(0)(y, x).maxCoeff();
-//      double lowValue = images.at(images.size()-1)(y, x).minCoeff();
+    processRow(rows, width, times, weight, response, &radiance(y, 0), targetTime, robCalibrate, clampedValueCorrection);
+  }
+}
 
-      for(std::size_t channel = 0; channel < 3; ++channel)
-      {
-        double wsum = 0.0;
-        double wdiv = 0.0;
-        double highValue = images.at(0)(y, x)(channel);
-        double lowValue = images.at(images.size()-1)(y, x)(channel);
-
-//        float minTimeSaturation = std::numeric_limits<float>::max();
-//        float maxTimeSaturation = std::numeric_limits<float>::min();
-
-
-        for(std::size_t i = 0; i < images.size(); ++i)
-        {
-          //for each images
-          const double value = images[i](y, x)(channel);
-          const double time = times[i];
-          double w = std::max(0.f, weight(value, channel) - weight(0.05, 0));
-
-          const double r = response(value, channel);
-
-          wsum += w * r / time;
-          wdiv += w;
-        }
-
-        double clampedHighValue = 1.0 - (1.0 / (1.0 + expf(10.0 * ((highValue - 0.9) / 0.2))));
-        double clampedLowValue = 1.0 / (1.0 + expf(10.0 * ((lowValue - 0.005) / 0.01)));
-
-
-        if(!robCalibrate && clampedValueCorrection != 0.f)
-        {
-          radianceColor(channel) = (1.0 - clampedHighValue - clampedLowValue) * wsum / std::max(0.001, wdiv) * targetTime + clampedHighValue * maxLum * clampedValueCorrection + clampedLowValue * minLum * clampedValueCorrection;
-//          radianceColor(channel) = (1.0 - clampedHighValue - clampedLowValue) * wsum / std::max(0.001, wdiv) + clampedHighValue * maxLum * clampedValueCorrection + clampedLowValue * minLum * clampedValueCorrection;
-        }
-        else
-        {
-          radianceColor(channel) = wsum / std::max(0.001, wdiv) * targetTime;
-//          radianceColor(channel) = wsum / std::max(0.001, wdiv);
-        }
-
-
-//          //saturation detection
-//          if(value > maxTrustedValue)
-//          {
-//            minTimeSaturation = std::min(minTimeSaturation, time);
-//          }
-//
-//          if(value < minTrustedValue)
-//          {
-//            maxTimeSaturation = std::max(maxTimeSaturation, time);
-//          }
-
-//        //saturation correction
-//        if((wdiv == 0.0f) &&
-//               (maxTimeSaturation > std::numeric_limits<float>::min()))
-//        {
-//          wsum = minTrustedValue;
-//          wdiv = maxTimeSaturation;
-//        }
-//2
-//        if((wdiv == 0.0f) &&
-//               (minTimeSaturation < std::numeric_limits<float>::max()))
-//        {
-//          wsum = maxTrustedValue;
-//          wdiv = minTimeSaturation;
-//        }
+void hdrMerge::process(const std::vector<std::string> &imagePaths,
+                              const std::vector<float> &times,
+                              const rgbCurve &weight,
+                              const rgbCurve &response,
+                              image::EImageColorSpace imagesColorSpace,
+                              const std::string &outputPath,
+                              const oiio::ParamValueList &metadata,
+                              float targetTime,
+                              bool robCalibrate,
+                              float clampedValueCorrection,
+                              int nbBlockRows)
+{
+  //checks
+  assert(!response.isEmpty());
+  assert(!imagePaths.empty());
+  assert(imagePaths.size() == times.size());
+  assert(nbBlockRows > 0);
 
-      }
+  if(imagesColorSpace == image::EImageColorSpace::AUTO)
+    throw std::runtime_error("You must specify a requested color space for the HDR merge.");
+
+  // open the images
+  std::vector<std::unique_ptr<oiio::ImageInput>> inputs;
+  std::vector<std::string> colorSpaces;
+
+  for(const std::string &path : imagePaths)
+  {
+    std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(path));
+
+    if(!in)
+      throw std::runtime_error("Can't find/open image file '" + path + "'.");
+
+    const oiio::ImageSpec &spec = in->spec();
+
+    if(spec.nchannels != 1 && spec.nchannels < 3)
+      throw std::runtime_error("Can't load channels of image file '" + path + "'.");
 
+    if(!inputs.empty() && (spec.width != inputs.front()->spec().width || spec.height != inputs.front()->spec().height))
+      throw std::runtime_error("Image file '" + path + "' doesn't have the size of the other images.");
+
+    colorSpaces.push_back(spec.get_string_attribute("oiio:ColorSpace", "sRGB")); // default image color space is sRGB
+    inputs.push_back(std::move(in));
+  }
+
+  const int width = inputs.front()->spec().width;
+  const int height = inputs.front()->spec().height;
+
+  // open the output image, written in a temporary file as image::writeImage
+  const fs::path bPath = fs::path(outputPath);
+  const std::string extension = bPath.extension().string();
+  const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + extension;
+
+  std::unique_ptr<oiio::ImageOutput> out(oiio::ImageOutput::create(tmpPath));
+
+  if(!out)
+    throw std::runtime_error("Can't create output image file '" + outputPath + "'.");
+
+  oiio::ImageSpec outSpec(width, height, 3, (extension == ".exr") ? oiio::TypeDesc::HALF : oiio::TypeDesc::FLOAT);
+  outSpec.extra_attribs = metadata;
+  outSpec.attribute("compression", (extension == ".exr") ? "piz" : "none");
+
+  if(!out->open(tmpPath, outSpec))
+    throw std::runtime_error("Can't write output image file '" + outputPath + "'.");
+
+  // buffers of a block of rows
+  const std::size_t blockSize = static_cast<std::size_t>(width) * nbBlockRows;
+  std::vector<std::vector<image::RGBfColor>> blocks(inputs.size(), std::vector<image::RGBfColor>(blockSize));
+  std::vector<image::RGBfColor> radianceBlock(blockSize);
+
+  for(int yBegin = 0; yBegin < height; yBegin += nbBlockRows)
+  {
+    const int nbRows = std::min(nbBlockRows, height - yBegin);
+
+    for(std::size_t i = 0; i < inputs.size(); ++i)
+      readRows(imagePaths[i], *inputs[i], colorSpaces[i], imagesColorSpace, yBegin, nbRows, blocks[i]);
+
+    #pragma omp parallel for
+    for(int r = 0; r < nbRows; ++r)
+    {
+      std::vector<const image::RGBfColor*> rows(blocks.size());
+      for(std::size_t i = 0; i < blocks.size(); ++i)
+        rows[i] = &blocks[i][static_cast<std::size_t>(r) * width];
+
+      processRow(rows, width, times, weight, response, &radianceBlock[static_cast<std::size_t>(r) * width], targetTime, robCalibrate, clampedValueCorrection);
     }
+
+    if(!out->write_scanlines(yBegin, yBegin + nbRows, 0, oiio::TypeDesc::FLOAT, radianceBlock.data()))
+      throw std::runtime_error("Can't write output image file '" + outputPath + "' (" + out->geterror() + ").");
   }
+
+  for(auto &in : inputs)
+    in->close();
+
+  if(!out->close())
+    throw std::runtime_error("Can't write output image file '" + outputPath + "'.");
+
+  // rename temporay filename
+  fs::rename(tmpPath, outputPath);
+}
+
+bool hdrMerge::isStreamable(const std::string &imagePath)
+{
+  // the plugin is chosen from the file extension, the file is not opened
+  std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::create(imagePath));
+  return in && std::string(in->format_name()) != "raw";
 }
 
 
@@ -8,6 +8,8 @@
 #include "rgbCurve.hpp"
 #include <aliceVision/image/all.hpp>
 #include <cmath>
+#include <string>
+#include <vector>
 
 
 namespace aliceVision {
@@ -32,6 +34,63 @@ public:
                 float targetTime,
                 bool robCalibrate = false,
                 float clampedValueCorrection = 1.f);
+
+  /**
+   * @brief Merge the pixels at the same positions in the images (a row of the images or pixels samples)
+   * @param rows The pixels of each image, sorted by exposure time
+   * @param width The number of pixels
+   * @param times The images exposure times
+   * @param weight The fusion weight function
+   * @param response The camera response function
+   * @param radianceRow The merged pixels
+   * @param targetTime The exposure time of the HDR pixels
+   * @param robCalibrate
+   * @param clampedValueCorrection
+   */
+  void processRow(const std::vector<const image::RGBfColor*> &rows,
+                  int width,
+                  const std::vector<float> &times,
+                  const rgbCurve &weight,
+                  const rgbCurve &response,
+                  image::RGBfColor* radianceRow,
+                  float targetTime,
+                  bool robCalibrate = false,
+                  float clampedValueCorrection = 1.f);
+
+  /**
+   * @brief Merge the images by blocks of rows, streamed from their files to the output file:
+   *        the memory doesn't depend on the number of images.
+   * @param imagePaths The images paths, sorted by exposure time (decoded by scanlines, see isStreamable)
+   * @param times The images exposure times
+   * @param weight The fusion weight function
+   * @param response The camera response function
+   * @param imagesColorSpace The color space of the images for the merge
+   * @param outputPath The HDR image path (written in half floats for EXR)
+   * @param metadata The HDR image metadata
+   * @param targetTime The exposure time of the HDR image
+   * @param robCalibrate
+   * @param clampedValueCorrection
+   * @param nbBlockRows The number of rows merged at a time
+   */
+  void process(const std::vector<std::string> &imagePaths,
+                const std::vector<float> &times,
+                const rgbCurve &weight,
+                const rgbCurve &response,
+                image::EImageColorSpace imagesColorSpace,
+                const std::string &outputPath,
+                const oiio::ParamValueList &metadata,
+                float targetTime,
+                bool robCalibrate = false,
+                float clampedValueCorrection = 1.f,
+                int nbBlockRows = 64);
+
+  /**
+   * @brief Check if an image can be merged from its file by blocks of rows
+   *        (the RAW files are decoded as a whole by the RAW plugin)
+   * @param imagePath The image path
+   * @return true if the image can be streamed
+   */
+  static bool isStreamable(const std::string &imagePath);
   
   /**
    * @brief This function obtains the "average scene luminance" EV value
@@ -6,6 +6,7 @@
 
 #include "rgbCurve.hpp"
 #include <functional>
+#include <limits>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -272,9 +273,8 @@ void rgbCurve::exponential()
 float rgbCurve::operator() (float sample, std::size_t channel) const
 {
   assert(channel < _data.size());
-  float fractionalPart = 0.0;
-  std::size_t infIndex = getIndex(sample, fractionalPart);
-  return fractionalPart * _data[channel][infIndex] + (1.0f - fractionalPart) * _data[channel][infIndex + 1];
+  assert(getSize() > 1);
+  return interpolate(_data[channel].data(), getSize(), sample);
 }
 
 const rgbCurve rgbCurve::operator+(const rgbCurve &other) const
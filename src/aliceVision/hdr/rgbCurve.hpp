@@ -227,6 +227,22 @@ public:
     */
   float operator() (float sample , std::size_t channel) const;
 
+  /**
+    * @brief Evaluate a channel curve as operator(), from its raw values (for the loops over pixels)
+    * @param[in] curve The channel curve values
+    * @param[in] size The number of values of the curve
+    * @param[in] sample between 0 and 1
+    * @return the interpolated value of the curve
+    */
+  static inline float interpolate(const float* curve, std::size_t size, float sample)
+  {
+    // index of getIndex, clamped to the first value for the samples below 2/size
+    const float position = std::max(0.f, std::max(0.f, std::min(1.f, sample)) * size - 2);
+    const std::size_t infIndex = static_cast<std::size_t>(position);
+    const float fractionalPart = position - infIndex;
+    return fractionalPart * curve[infIndex] + (1.0f - fractionalPart) * curve[infIndex + 1];
+  }
+
   /**
     * @brief Operator+ Call sum method
     * @param[in] other
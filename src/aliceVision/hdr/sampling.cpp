@@ -0,0 +1,90 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "sampling.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <aliceVision/alicevision_omp.hpp>
+
+namespace aliceVision {
+namespace hdr {
+
+void extractSamples(const std::vector< std::vector< image::Image<image::RGBfColor> > > &ldrImageGroups,
+                    const int nbPoints,
+                    const bool fisheye,
+                    std::vector<LDRSamples> &samples)
+{
+  const int nbGroups = ldrImageGroups.size();
+  const int nbImages = ldrImageGroups.front().size();
+  const int samplesPerImage = std::max(1, nbPoints / (nbGroups*nbImages));
+
+  samples.assign(nbGroups, LDRSamples());
+
+  for(int g = 0; g < nbGroups; ++g)
+  {
+    const std::vector< image::Image<image::RGBfColor> > &ldrImagesGroup = ldrImageGroups[g];
+    const int width = ldrImagesGroup.front().Width();
+    const int height = ldrImagesGroup.front().Height();
+    LDRSamples &groupSamples = samples[g];
+
+    // sampled area: the whole image or the square around the fisheye disk
+    int xMin = 0;
+    int yMin = 0;
+    int areaSize[2] = {width, height};
+    const double radius = std::min(width, height) * 0.97 * 0.5;
+
+    if(fisheye)
+    {
+      xMin = std::ceil(width / 2 - radius);
+      yMin = std::ceil(height / 2 - radius);
+      areaSize[0] = areaSize[1] = std::floor(2 * radius);
+    }
+
+    const int cellSize = std::max(1, static_cast<int>(std::sqrt(double(areaSize[0]) * areaSize[1] / samplesPerImage)));
+    const int nbCellsX = std::max(1, areaSize[0] / cellSize);
+    const int nbCellsY = std::max(1, areaSize[1] / cellSize);
+
+    std::mt19937 generator(g);
+    std::uniform_int_distribution<int> distribution(0, cellSize - 1);
+
+    groupSamples.offsets.reserve(nbCellsX * nbCellsY);
+
+    for(int cy = 0; cy < nbCellsY; ++cy)
+    {
+      for(int cx = 0; cx < nbCellsX; ++cx)
+      {
+        const int x = std::min(width - 1, xMin + cx * cellSize + distribution(generator));
+        const int y = std::min(height - 1, yMin + cy * cellSize + distribution(generator));
+
+        if(fisheye && std::pow(x - width / 2, 2) + std::pow(y - height / 2, 2) > radius * radius)
+          continue;
+
+        groupSamples.offsets.push_back(static_cast<std::size_t>(y) * width + x);
+      }
+    }
+
+    // gather the sampled values of each image
+    groupSamples.values.resize(nbImages);
+
+    #pragma omp parallel for
+    for(int j = 0; j < nbImages; ++j)
+    {
+      const image::Image<image::RGBfColor> &image = ldrImagesGroup.at(j);
+      assert(image.Width() == width && image.Height() == height);
+
+      std::vector<image::RGBfColor> &values = groupSamples.values[j];
+      values.resize(groupSamples.size());
+
+      for(std::size_t i = 0; i < groupSamples.size(); ++i)
+        values[i] = image(groupSamples.offsets[i]);
+    }
+  }
+}
+
+} // namespace hdr
+} // namespace aliceVision
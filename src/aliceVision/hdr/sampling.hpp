@@ -0,0 +1,48 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+#include <aliceVision/image/all.hpp>
+#include <vector>
+
+namespace aliceVision {
+namespace hdr {
+
+/**
+ * @brief Values of the pixels sampled at the same positions in all the LDR images of a group
+ */
+struct LDRSamples
+{
+  /// sampled pixels offsets in the images (row major)
+  std::vector<std::size_t> offsets;
+  /// sampled values of each image of the group: values[image][sample]
+  std::vector< std::vector<image::RGBfColor> > values;
+
+  std::size_t size() const
+  {
+    return offsets.size();
+  }
+};
+
+/**
+ * @brief Sample the pixels of the LDR images groups, shared by the calibration methods
+ *
+ * The images are divided into square cells of the same area, with one sample at a random position in each cell:
+ * the samples cover the whole images without the aliasing of a regular grid.
+ * The random positions are seeded, the samples are the same for the same images.
+ *
+ * @param[in] ldrImageGroups LDR images groups
+ * @param[in] nbPoints number of samples of all the images
+ * @param[in] fisheye only sample the pixels inside a disk with a radius of the images minimum side
+ * @param[out] samples samples of each group
+ */
+void extractSamples(const std::vector< std::vector< image::Image<image::RGBfColor> > > &ldrImageGroups,
+                    const int nbPoints,
+                    const bool fisheye,
+                    std::vector<LDRSamples> &samples);
+
+} // namespace hdr
+} // namespace aliceVision
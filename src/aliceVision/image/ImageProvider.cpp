@@ -0,0 +1,186 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ImageProvider.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace image {
+
+ImageProvider::ImageProvider(float maxMemory, bool shared)
+  : _cache(oiio::ImageCache::create(shared))
+{
+  _cache->attribute("max_memory_MB", maxMemory);
+  _cache->attribute("autotile", 64); // read the untiled files by tiles of 64x64 pixels
+  _cache->attribute("automip", 1);   // build the mipmap of the files without one
+}
+
+ImageProvider::~ImageProvider()
+{
+  // the process-wide cache is kept alive for the other providers
+  oiio::ImageCache::destroy(_cache);
+}
+
+void ImageProvider::setMaxMemory(float maxMemory)
+{
+  _cache->attribute("max_memory_MB", maxMemory);
+}
+
+float ImageProvider::getMaxMemory() const
+{
+  float maxMemory = 0.f;
+  _cache->getattribute("max_memory_MB", maxMemory);
+  return maxMemory;
+}
+
+int ImageProvider::getNbLevels(const std::string& path) const
+{
+  int nbLevels = 0;
+  if(!_cache->get_image_info(oiio::ustring(path), 0, 0, oiio::ustring("miplevels"), oiio::TypeDesc::INT, &nbLevels))
+    throw std::runtime_error("Cannot find/open image file '" + path + "' (" + _cache->geterror() + ").");
+  return nbLevels;
+}
+
+void ImageProvider::getSize(const std::string& path, int& width, int& height, int level) const
+{
+  const oiio::ImageSpec* spec = _cache->imagespec(oiio::ustring(path), 0, level);
+  if(spec == nullptr)
+    throw std::runtime_error("Cannot find/open image file '" + path + "' at level " + std::to_string(level) + " (" + _cache->geterror() + ").");
+  width = spec->width;
+  height = spec->height;
+}
+
+template<typename T>
+void ImageProvider::readImage(const std::string& path, oiio::TypeDesc format, int nchannels, Image<T>& image,
+                              EImageColorSpace imageColorSpace, int level, const oiio::ROI& roi) const
+{
+  // check requested channels number
+  assert(nchannels == 1 || nchannels >= 3);
+
+  const oiio::ustring filename(path);
+  const oiio::ImageSpec* spec = _cache->imagespec(filename, 0, level);
+
+  if(spec == nullptr)
+    throw std::runtime_error("Cannot find/open image file '" + path + "' at level " + std::to_string(level) + " (" + _cache->geterror() + ").");
+
+  // check picture channels number
+  if(spec->nchannels != 1 && spec->nchannels < 3)
+    throw std::runtime_error("Can't load channels of image file '" + path + "'.");
+
+  if(imageColorSpace == EImageColorSpace::AUTO)
+    throw std::runtime_error("You must specify a requested color space for image file '" + path + "'.");
+
+  // requested region, clamped to the image
+  const oiio::ROI imageROI(spec->x, spec->x + spec->width, spec->y, spec->y + spec->height);
+  const oiio::ROI region = roi.defined() ? oiio::roi_intersection(roi, imageROI) : imageROI;
+
+  if(!region.defined() || region.npixels() == 0)
+    throw std::runtime_error("The requested region is out of the image file '" + path + "'.");
+
+  // decoded channels: the color channels for a grayscale conversion, the requested ones otherwise
+  const int nbDecodedChannels = std::min(spec->nchannels, std::max(nchannels, 3));
+
+  oiio::ImageBuf inBuf(oiio::ImageSpec(region.width(), region.height(), nbDecodedChannels, oiio::TypeDesc::FLOAT));
+
+  if(!_cache->get_pixels(filename, 0, level,
+                         region.xbegin, region.xend, region.ybegin, region.yend, 0, 1,
+                         0, nbDecodedChannels, oiio::TypeDesc::FLOAT, inBuf.localpixels()))
+    throw std::runtime_error("Cannot read image file '" + path + "' (" + _cache->geterror() + ").");
+
+  // color conversion
+  const std::string& colorSpace = spec->get_string_attribute("oiio:ColorSpace", "sRGB"); // default image color space is sRGB
+  ALICEVISION_LOG_TRACE("Read image " << path << " level " << level << " (encoded in " << colorSpace << " colorspace).");
+
+  if(imageColorSpace == EImageColorSpace::SRGB && colorSpace != "sRGB")
+    oiio::ImageBufAlgo::colorconvert(inBuf, inBuf, colorSpace, "sRGB");
+  else if(imageColorSpace == EImageColorSpace::LINEAR && colorSpace != "Linear")
+    oiio::ImageBufAlgo::colorconvert(inBuf, inBuf, colorSpace, "Linear");
+
+  const oiio::ImageBuf* outBuf = &inBuf;
+  oiio::ImageBuf channelsBuf;
+
+  if(nchannels == 1 && nbDecodedChannels >= 3)
+  {
+    // compute luminance via a weighted sum of R,G,B
+    // (assuming Rec709 primaries and a linear scale)
+    oiio::ROI convertionROI = inBuf.roi();
+    convertionROI.chbegin = 0;
+    convertionROI.chend = 3;
+
+    const float weights[3] = {.2126, .7152, .0722};
+    oiio::ImageBufAlgo::channel_sum(channelsBuf, inBuf, weights, convertionROI);
+    outBuf = &channelsBuf;
+  }
+  else if(nchannels != nbDecodedChannels)
+  {
+    // duplicate a grayscale channel for RGB, add an opaque alpha channel if needed
+    int channelOrder[4];
+    float channelValues[4];
+    for(int c = 0; c < nchannels; ++c)
+    {
+      channelOrder[c] = (c < 3) ? ((nbDecodedChannels < 3) ? 0 : c) : ((c < nbDecodedChannels) ? c : -1);
+      channelValues[c] = 1.f;
+    }
+    oiio::ImageBufAlgo::channels(channelsBuf, inBuf, nchannels, channelOrder, channelValues);
+    outBuf = &channelsBuf;
+  }
+
+  // copy pixels from oiio to eigen
+  image.resize(region.width(), region.height(), false);
+  {
+    oiio::ROI exportROI = outBuf->roi();
+    exportROI.chbegin = 0;
+    exportROI.chend = nchannels;
+
+    outBuf->get_pixels(exportROI, format, image.data());
+  }
+}
+
+void ImageProvider::readImage(const std::string& path, Image<float>& image, EImageColorSpace imageColorSpace, int level, const oiio::ROI& roi) const
+{
+  readImage(path, oiio::TypeDesc::FLOAT, 1, image, imageColorSpace, level, roi);
+}
+
+void ImageProvider::readImage(const std::string& path, Image<unsigned char>& image, EImageColorSpace imageColorSpace, int level, const oiio::ROI& roi) const
+{
+  readImage(path, oiio::TypeDesc::UINT8, 1, image, imageColorSpace, level, roi);
+}
+
+void ImageProvider::readImage(const std::string& path, Image<RGBAColor>& image, EImageColorSpace imageColorSpace, int level, const oiio::ROI& roi) const
+{
+  readImage(path, oiio::TypeDesc::UINT8, 4, image, imageColorSpace, level, roi);
+}
+
+void ImageProvider::readImage(const std::string& path, Image<RGBfColor>& image, EImageColorSpace imageColorSpace, int level, const oiio::ROI& roi) const
+{
+  readImage(path, oiio::TypeDesc::FLOAT, 3, image, imageColorSpace, level, roi);
+}
+
+void ImageProvider::readImage(const std::string& path, Image<RGBColor>& image, EImageColorSpace imageColorSpace, int level, const oiio::ROI& roi) const
+{
+  readImage(path, oiio::TypeDesc::UINT8, 3, image, imageColorSpace, level, roi);
+}
+
+void ImageProvider::invalidate(const std::string& path)
+{
+  _cache->invalidate(oiio::ustring(path));
+}
+
+void ImageProvider::invalidateAll()
+{
+  _cache->invalidate_all(true);
+}
+
+} // namespace image
+} // namespace aliceVision
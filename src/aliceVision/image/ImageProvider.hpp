@@ -0,0 +1,110 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/pixelTypes.hpp>
+#include <aliceVision/image/io.hpp>
+
+#include <OpenImageIO/imagecache.h>
+
+#include <string>
+
+namespace aliceVision {
+namespace image {
+
+/**
+ * @brief Images provider backed by an OpenImageIO ImageCache.
+ *
+ * The images are decoded by tiles, kept in a memory budget and reused by all the requests.
+ * A request can be a region of the image at a level of its mipmap (each level halves the resolution):
+ * the untiled or unmipmapped files are tiled and mipmapped in memory.
+ * All the methods are thread safe.
+ *
+ * @note the RAW files are decoded with the default settings of the RAW plugin, use readImage() for them.
+ */
+class ImageProvider
+{
+public:
+
+  /**
+   * @brief Build an images provider
+   * @param[in] maxMemory The memory budget of the decoded tiles (in MB)
+   * @param[in] shared Use the process-wide OpenImageIO cache: the providers built with it share their tiles and budget
+   */
+  explicit ImageProvider(float maxMemory = 1024.f, bool shared = true);
+
+  ~ImageProvider();
+
+  ImageProvider(const ImageProvider&) = delete;
+  ImageProvider& operator=(const ImageProvider&) = delete;
+
+  /**
+   * @brief Set the memory budget of the decoded tiles
+   * @param[in] maxMemory The memory budget (in MB)
+   */
+  void setMaxMemory(float maxMemory);
+
+  /**
+   * @brief Get the memory budget of the decoded tiles
+   * @return The memory budget (in MB)
+   */
+  float getMaxMemory() const;
+
+  /**
+   * @brief Get the number of levels of the image mipmap
+   * @param[in] path The image path
+   * @return The number of levels, the level 0 being the full resolution
+   */
+  int getNbLevels(const std::string& path) const;
+
+  /**
+   * @brief Get the size of an image at a mipmap level
+   * @param[in] path The image path
+   * @param[out] width The image width at this level
+   * @param[out] height The image height at this level
+   * @param[in] level The mipmap level
+   */
+  void getSize(const std::string& path, int& width, int& height, int level = 0) const;
+
+  /**
+   * @brief Read an image or a region of it at a mipmap level
+   * @param[in] path The image path
+   * @param[out] image The output image buffer, of the size of the region
+   * @param[in] imageColorSpace The output image color space
+   * @param[in] level The mipmap level
+   * @param[in] roi The region in the pixels of the level, clamped to the image (undefined for the whole image)
+   */
+  void readImage(const std::string& path, Image<float>& image, EImageColorSpace imageColorSpace, int level = 0, const oiio::ROI& roi = oiio::ROI()) const;
+  void readImage(const std::string& path, Image<unsigned char>& image, EImageColorSpace imageColorSpace, int level = 0, const oiio::ROI& roi = oiio::ROI()) const;
+  void readImage(const std::string& path, Image<RGBAColor>& image, EImageColorSpace imageColorSpace, int level = 0, const oiio::ROI& roi = oiio::ROI()) const;
+  void readImage(const std::string& path, Image<RGBfColor>& image, EImageColorSpace imageColorSpace, int level = 0, const oiio::ROI& roi = oiio::ROI()) const;
+  void readImage(const std::string& path, Image<RGBColor>& image, EImageColorSpace imageColorSpace, int level = 0, const oiio::ROI& roi = oiio::ROI()) const;
+
+  /**
+   * @brief Release the tiles of an image, to read it again if the file has changed
+   * @param[in] path The image path
+   */
+  void invalidate(const std::string& path);
+
+  /**
+   * @brief Release the tiles of all the images
+   */
+  void invalidateAll();
+
+private:
+
+  template<typename T>
+  void readImage(const std::string& path, oiio::TypeDesc format, int nchannels, Image<T>& image,
+                 EImageColorSpace imageColorSpace, int level, const oiio::ROI& roi) const;
+
+  /// OpenImageIO cache of the decoded tiles
+  oiio::ImageCache* _cache = nullptr;
+};
+
+} // namespace image
+} // namespace aliceVision
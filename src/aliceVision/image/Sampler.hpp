@@ -438,38 +438,59 @@ struct Sampler2d
 
     // Sample a grid around specified grid point
     double total_weight = 0.0 ;
-    for( int i = 0 ; i < SamplerFunc::neighbor_width ; ++i )
-    {
-      // Get current i value
-      // +1 for correct scheme (draw it to be conviced)
-      const int cur_i = grid_y + 1 + i - _half_width ;
 
-      // handle out of range
-      if( cur_i < 0 || cur_i >= im_height )
+    // the whole grid is inside the image: no out of range test per pixel
+    const int first_i = grid_y + 1 - _half_width ;
+    const int first_j = grid_x + 1 - _half_width ;
+    if( first_i >= 0 && first_i + SamplerFunc::neighbor_width <= im_height &&
+        first_j >= 0 && first_j + SamplerFunc::neighbor_width <= im_width )
+    {
+      for( int i = 0 ; i < SamplerFunc::neighbor_width ; ++i )
       {
-        continue ;
+        const T* row = &src( first_i + i , first_j ) ;
+        for( int j = 0 ; j < SamplerFunc::neighbor_width ; ++j )
+        {
+          const double w = coefs_x[ j ] * coefs_y[ i ] ;
+          res += RealPixel<T>::convert_to_real( row[ j ] ) * w ;
+          total_weight += w ;
+        }
       }
-
-      for( int j = 0 ; j < SamplerFunc::neighbor_width ; ++j )
+    }
+    else
+    {
+      for( int i = 0 ; i < SamplerFunc::neighbor_width ; ++i )
       {
-        // Get current j value
-        // +1 for the same reason
-        const int cur_j = grid_x + 1 + j - _half_width ;
+        // Get current i value
+        // +1 for correct scheme (draw it to be conviced)
+        const int cur_i = grid_y + 1 + i - _half_width ;
 
         // handle out of range
-        if( cur_j < 0 || cur_j >= im_width )
+        if( cur_i < 0 || cur_i >= im_height )
         {
           continue ;
         }
 
+        for( int j = 0 ; j < SamplerFunc::neighbor_width ; ++j )
+        {
+          // Get current j value
+          // +1 for the same reason
+          const int cur_j = grid_x + 1 + j - _half_width ;
+
+          // handle out of range
+          if( cur_j < 0 || cur_j >= im_width )
+          {
+            continue ;
+          }
 
-        // sample input image and weight according to sampler
-        const double w = coefs_x[ j ] * coefs_y[ i ] ;
-        const typename RealPixel<T>::real_type pix = RealPixel<T>::convert_to_real( src( cur_i , cur_j ) ) ;
-        const typename RealPixel<T>::real_type wp = pix * w ;
-        res += wp ;
 
-        total_weight += w ;
+          // sample input image and weight according to sampler
+          const double w = coefs_x[ j ] * coefs_y[ i ] ;
+          const typename RealPixel<T>::real_type pix = RealPixel<T>::convert_to_real( src( cur_i , cur_j ) ) ;
+          const typename RealPixel<T>::real_type wp = pix * w ;
+          res += wp ;
+
+          total_weight += w ;
+        }
       }
     }
 
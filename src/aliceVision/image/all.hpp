@@ -21,6 +21,7 @@
 #include "aliceVision/image/diffusion.hpp"
 #include "aliceVision/image/concat.hpp"
 #include "aliceVision/image/io.hpp"
+#include "aliceVision/image/ImageProvider.hpp"
 #include "aliceVision/image/convolutionBase.hpp"
 #include "aliceVision/image/convolution.hpp"
 #include "aliceVision/image/Sampler.hpp"
@@ -0,0 +1,86 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "convertion.hpp"
+
+#include <OpenImageIO/imageio.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace oiio = OIIO;
+
+namespace aliceVision {
+namespace image {
+
+static_assert(sizeof(RGBhColor) == 3 * sizeof(half), "RGBhColor must be packed to be converted as an array of half");
+static_assert(sizeof(RGBfColor) == 3 * sizeof(float), "RGBfColor must be packed to be converted as an array of float");
+
+/**
+ * @brief Convert a buffer of values by blocks, with the vectorized OpenImageIO conversion
+ * @param[in] srcType The source values type
+ * @param[in] src The source values
+ * @param[in] dstType The destination values type
+ * @param[out] dst The destination values
+ * @param[in] srcSize The size of a source value (in bytes)
+ * @param[in] dstSize The size of a destination value (in bytes)
+ * @param[in] nbValues The number of values
+ */
+static void convertValues(oiio::TypeDesc srcType, const void* src,
+                          oiio::TypeDesc dstType, void* dst,
+                          std::size_t srcSize, std::size_t dstSize,
+                          std::ptrdiff_t nbValues)
+{
+  // blocks of values large enough for the threads overhead, small enough to stay in cache
+  const std::ptrdiff_t blockSize = 1 << 16;
+  const std::ptrdiff_t nbBlocks = (nbValues + blockSize - 1) / blockSize;
+  bool success = true;
+
+  #pragma omp parallel for reduction(&&:success)
+  for(std::ptrdiff_t b = 0; b < nbBlocks; ++b)
+  {
+    const std::ptrdiff_t first = b * blockSize;
+    const int n = static_cast<int>(std::min(blockSize, nbValues - first));
+    success = oiio::convert_types(srcType, static_cast<const char*>(src) + first * srcSize,
+                                  dstType, static_cast<char*>(dst) + first * dstSize, n) && success;
+  }
+
+  if(!success)
+    throw std::runtime_error("Cannot convert the image pixel type.");
+}
+
+template<typename Tin, typename Tout>
+static void convertImage(const Image<Tin>& imaIn, Image<Tout>* imaOut,
+                         oiio::TypeDesc inType, oiio::TypeDesc outType, int nbChannels)
+{
+  (*imaOut) = Image<Tout>(imaIn.Width(), imaIn.Height());
+  const std::ptrdiff_t nbValues = static_cast<std::ptrdiff_t>(imaIn.Width()) * imaIn.Height() * nbChannels;
+  convertValues(inType, imaIn.data(), outType, imaOut->data(),
+                sizeof(Tin) / nbChannels, sizeof(Tout) / nbChannels, nbValues);
+}
+
+void ConvertPixelType(const Image<float>& imaIn, Image<half>* imaOut)
+{
+  convertImage(imaIn, imaOut, oiio::TypeDesc::FLOAT, oiio::TypeDesc::HALF, 1);
+}
+
+void ConvertPixelType(const Image<half>& imaIn, Image<float>* imaOut)
+{
+  convertImage(imaIn, imaOut, oiio::TypeDesc::HALF, oiio::TypeDesc::FLOAT, 1);
+}
+
+void ConvertPixelType(const Image<RGBfColor>& imaIn, Image<RGBhColor>* imaOut)
+{
+  convertImage(imaIn, imaOut, oiio::TypeDesc::FLOAT, oiio::TypeDesc::HALF, 3);
+}
+
+void ConvertPixelType(const Image<RGBhColor>& imaIn, Image<RGBfColor>* imaOut)
+{
+  convertImage(imaIn, imaOut, oiio::TypeDesc::HALF, oiio::TypeDesc::FLOAT, 3);
+}
+
+} // namespace image
+} // namespace aliceVision
@@ -121,5 +121,16 @@ inline void rgbFloat2rgbInt(
       convertFloatToInt( imaIn( j, i ), (*imaOut)( j, i ), factor  );
 }
 
+//--------------------------------------------------------------------------
+// Float to half float and back
+// The values are converted by blocks with the vectorized OpenImageIO conversions.
+// Half floats keep 3 significant digits, the values above 65504 become infinite.
+//--------------------------------------------------------------------------
+
+void ConvertPixelType(const Image<float>& imaIn, Image<half>* imaOut);
+void ConvertPixelType(const Image<half>& imaIn, Image<float>* imaOut);
+void ConvertPixelType(const Image<RGBfColor>& imaIn, Image<RGBhColor>* imaOut);
+void ConvertPixelType(const Image<RGBhColor>& imaIn, Image<RGBfColor>* imaOut);
+
 } // namespace image
 } // namespace aliceVision
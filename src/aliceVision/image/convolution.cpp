@@ -22,7 +22,11 @@ void SeparableConvolution2d(const RowMatrixXf& image,
   // each row. However, care must be taken at the top and bottom borders.
   const Eigen::Matrix<float, 1, Eigen::Dynamic> reverse_kernel_y = kernel_y.reverse();
 
-  #pragma omp parallel for schedule(dynamic)
+  // Small images (e.g. descriptor patches) are filtered by the calling thread,
+  // spawning a thread team would cost more than the convolution itself.
+  const bool useThreads = (image.size() >= 128 * 128);
+
+  #pragma omp parallel for if(useThreads) schedule(dynamic)
   for (int i = 0; i < half_sigma_y; i++)
   {
     const int forward_size = i + half_sigma_y + 1;
@@ -42,7 +46,7 @@ void SeparableConvolution2d(const RowMatrixXf& image,
   }
 
   // Applying the rest of the y filter.
-  #pragma omp parallel for schedule(dynamic)
+  #pragma omp parallel for if(useThreads) schedule(dynamic)
   for (int row = half_sigma_y; row < image.rows() - half_sigma_y; row++)
   {
     out->row(row) =  kernel_y * image.block(row - half_sigma_y, 0, sigma_y, out->cols());
@@ -57,7 +61,7 @@ void SeparableConvolution2d(const RowMatrixXf& image,
   // to end up with the correct convolved values.
   Eigen::RowVectorXf temp_row(image.cols() + sigma_x - 1);
 
-  #pragma omp parallel for firstprivate(temp_row), schedule(dynamic)
+  #pragma omp parallel for if(useThreads) firstprivate(temp_row), schedule(dynamic)
   for (int row = 0; row < out->rows(); row++)
   {
     temp_row.head(half_sigma_x) =
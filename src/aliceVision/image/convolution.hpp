@@ -13,6 +13,7 @@
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/config.hpp>
 
+#include <algorithm>
 #include <vector>
 #include <cassert>
 
@@ -91,27 +92,35 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
+  // Small images (e.g. descriptor patches) are filtered by the calling thread,
+  // spawning a thread team would cost more than the convolution itself.
+  const bool useThreads = (img.size() >= 128 * 128);
 
-  for( int row = 0 ; row < rows ; ++row )
+  #pragma omp parallel if(useThreads)
   {
-    // Copy line
-    const pix_t start_pix = img.coeffRef( row , 0 ) ;
-    for( int k = 0 ; k < half_kernel_width ; ++k ) // pad before
-    {
-      line[ k ] = start_pix ;
-    }
-    memcpy(&line[0] + half_kernel_width, img.data() + row * cols, sizeof(pix_t) * cols);
-    const pix_t end_pix = img.coeffRef( row , cols - 1 ) ;
-    for( int k = 0 ; k < half_kernel_width ; ++k ) // pad after
+    std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
+
+    #pragma omp for schedule(static)
+    for( int row = 0 ; row < rows ; ++row )
     {
-      line[ k + half_kernel_width + cols ] = end_pix ;
-    }
+      // Copy line
+      const pix_t start_pix = img.coeffRef( row , 0 ) ;
+      for( int k = 0 ; k < half_kernel_width ; ++k ) // pad before
+      {
+        line[ k ] = start_pix ;
+      }
+      memcpy(&line[0] + half_kernel_width, img.data() + row * cols, sizeof(pix_t) * cols);
+      const pix_t end_pix = img.coeffRef( row , cols - 1 ) ;
+      for( int k = 0 ; k < half_kernel_width ; ++k ) // pad after
+      {
+        line[ k + half_kernel_width + cols ] = end_pix ;
+      }
 
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
+      // Apply convolution
+      conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
 
-    memcpy(out.data() + row * cols, &line[0], sizeof(pix_t) * cols);
+      memcpy(out.data() + row * cols, &line[0], sizeof(pix_t) * cols);
+    }
   }
 }
 
@@ -120,12 +129,13 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
  ** assume kernel has odd size
  ** @param img Input image
  ** @param kernel convolution kernel
- ** @param out Output image
+ ** @param out Output image (can be the input image)
  **/
 template< typename ImageTypeIn , typename ImageTypeOut, typename Kernel >
 void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel , ImageTypeOut & out)
 {
   typedef typename ImageTypeIn::Tpixel pix_t ;
+  typedef typename Kernel::Scalar kernel_t ;
 
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
@@ -133,32 +143,46 @@ void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel ,
   const int rows = img.rows() ;
   const int cols = img.cols() ;
 
+  // the rows are read while the output is written
+  ImageTypeIn imgCopy ;
+  const ImageTypeIn* src = &img ;
+  if( static_cast<const void*>( &img ) == static_cast<const void*>( &out ) )
+  {
+    imgCopy = img ;
+    src = &imgCopy ;
+  }
+
   out.resize( cols , rows ) ;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( rows + kernel_width );
+  // Small images (e.g. descriptor patches) are filtered by the calling thread,
+  // spawning a thread team would cost more than the convolution itself.
+  const bool useThreads = (img.size() >= 128 * 128);
 
-  for( int col = 0 ; col < cols ; ++col )
+  // Each output row is the weighted sum of the input rows, read in memory order instead of by columns.
+  // The sums are accumulated in the kernel order, the border rows are repeated.
+  #pragma omp parallel if(useThreads)
   {
-    // Copy column
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k ] = img.coeffRef( 0 , col ) ;
-    }
-    for( int k = 0 ; k < rows ; ++k )
-    {
-      line[ k + half_kernel_width ] = img.coeffRef( k , col ) ;
-    }
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k + half_kernel_width + rows ] = img.coeffRef( rows - 1 , col ) ;
-    }
-
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , rows , kernel_width );
+    std::vector<kernel_t, Eigen::aligned_allocator<kernel_t> > sums( cols );
 
+    #pragma omp for schedule(static)
     for( int row = 0 ; row < rows ; ++row )
     {
-      out.coeffRef( row , col ) = line[row];
+      std::fill( sums.begin() , sums.end() , kernel_t( 0 ) ) ;
+      for( int k = 0 ; k < kernel_width ; ++k )
+      {
+        const int src_row = std::min( std::max( row + k - half_kernel_width , 0 ) , rows - 1 ) ;
+        const pix_t* src_line = src->data() + src_row * cols ;
+        const kernel_t weight = kernel.data()[ k ] ;
+        for( int col = 0 ; col < cols ; ++col )
+        {
+          sums[ col ] += src_line[ col ] * weight ;
+        }
+      }
+
+      for( int col = 0 ; col < cols ; ++col )
+      {
+        out.coeffRef( row , col ) = static_cast<pix_t>( sums[ col ] ) ;
+      }
     }
   }
 }
@@ -0,0 +1,89 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/image/all.hpp>
+
+#include <cstdlib>
+
+#define BOOST_TEST_MODULE ImageDiffusion
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::image;
+
+namespace {
+
+Image<float> randomImage(int width, int height)
+{
+  std::srand(0);
+  Image<float> img(width, height);
+  for(int i = 0; i < height; ++i)
+    for(int j = 0; j < width; ++j)
+      img(i, j) = static_cast<float>(std::rand()) / RAND_MAX;
+  return img;
+}
+
+void diffusionCoef(const Image<float>& in, Image<float>& diff, bool tiled)
+{
+  Image<float> smoothed, Lx, Ly;
+  ImageGaussianFilter(in, 1.f, smoothed, 0, 0);
+  ImageScharrXDerivative(smoothed, Lx, false);
+  ImageScharrYDerivative(smoothed, Ly, false);
+
+  if(tiled)
+    ImagePeronaMalikG2DiffusionCoefTiled(Lx, Ly, 0.05f, diff);
+  else
+    ImagePeronaMalikG2DiffusionCoef(Lx, Ly, 0.05f, diff);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Diffusion_PeronaMalikTiled)
+{
+  const Image<float> in = randomImage(253, 117);
+
+  Image<float> diffRef, diffTiled;
+  diffusionCoef(in, diffRef, false);
+  diffusionCoef(in, diffTiled, true);
+
+  BOOST_CHECK_EQUAL(diffRef.Width(), diffTiled.Width());
+  BOOST_CHECK_EQUAL(diffRef.Height(), diffTiled.Height());
+
+  for(int i = 0; i < in.Height(); ++i)
+    for(int j = 0; j < in.Width(); ++j)
+      BOOST_CHECK_SMALL(diffRef(i, j) - diffTiled(i, j), 1e-6f);
+}
+
+BOOST_AUTO_TEST_CASE(Diffusion_FEDCycleTiled)
+{
+  const Image<float> in = randomImage(253, 117);
+
+  Image<float> diff;
+  diffusionCoef(in, diff, false);
+
+  std::vector<float> tau;
+  FEDCycleTimings(2.f, 0.25f, tau);
+
+  Image<float> ref = in;
+  Image<float> tiled = in;
+  ImageFEDCycle(ref, diff, tau);
+  ImageFEDCycleTiled(tiled, diff, tau);
+
+  // ImageFEDCycle never updates the 4 corners, they are left out of the comparison
+  // along with their direct neighbors that depend on them after the first step
+  for(int i = 0; i < in.Height(); ++i)
+  {
+    for(int j = 0; j < in.Width(); ++j)
+    {
+      const int di = std::min(i, in.Height() - 1 - i);
+      const int dj = std::min(j, in.Width() - 1 - j);
+      if(di + dj < static_cast<int>(tau.size()))
+        continue;
+      BOOST_CHECK_SMALL(ref(i, j) - tiled(i, j), 1e-5f);
+    }
+  }
+}
@@ -0,0 +1,111 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/system/Logger.hpp>
+#include "aliceVision/image/all.hpp"
+
+#define BOOST_TEST_MODULE imageProvider
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cstdio>
+#include <string>
+
+using namespace aliceVision;
+using namespace aliceVision::image;
+
+// image with constant 2x2 blocks, so its mipmap levels are exact
+static Image<RGBColor> blocksImage(int width, int height)
+{
+  Image<RGBColor> image(width, height);
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+      image(y, x) = RGBColor(16 * (x / 2), 32 * (y / 2), 255 - 16 * (x / 2));
+  return image;
+}
+
+BOOST_AUTO_TEST_CASE(imageProvider_read_unexisting) {
+  const ImageProvider provider(16.f, false);
+  Image<RGBColor> image;
+  BOOST_CHECK_THROW(provider.readImage("unexisting.png", image, image::EImageColorSpace::NO_CONVERSION), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(imageProvider_read_levels_and_regions) {
+  const std::string filename = "test_imageProvider.png";
+  const Image<RGBColor> image = blocksImage(16, 8);
+  BOOST_CHECK_NO_THROW(writeImage(filename, image, image::EImageColorSpace::NO_CONVERSION));
+
+  ImageProvider provider(16.f, false);
+
+  // full image, as readImage
+  {
+    Image<RGBColor> readImg, providedImg;
+    readImage(filename, readImg, image::EImageColorSpace::NO_CONVERSION);
+    provider.readImage(filename, providedImg, image::EImageColorSpace::NO_CONVERSION);
+    BOOST_CHECK_EQUAL(providedImg.Width(), readImg.Width());
+    BOOST_CHECK_EQUAL(providedImg.Height(), readImg.Height());
+    for(int y = 0; y < readImg.Height(); ++y)
+      for(int x = 0; x < readImg.Width(); ++x)
+        BOOST_CHECK(providedImg(y, x) == readImg(y, x));
+  }
+
+  // mipmap level 1: half resolution
+  {
+    BOOST_CHECK(provider.getNbLevels(filename) > 1);
+
+    int width, height;
+    provider.getSize(filename, width, height, 1);
+    BOOST_CHECK_EQUAL(width, 8);
+    BOOST_CHECK_EQUAL(height, 4);
+
+    Image<RGBColor> providedImg;
+    provider.readImage(filename, providedImg, image::EImageColorSpace::NO_CONVERSION, 1);
+    BOOST_CHECK_EQUAL(providedImg.Width(), 8);
+    BOOST_CHECK_EQUAL(providedImg.Height(), 4);
+    for(int y = 0; y < 4; ++y)
+      for(int x = 0; x < 8; ++x)
+        BOOST_CHECK(providedImg(y, x) == image(2 * y, 2 * x));
+  }
+
+  // region of the image, clamped to the image
+  {
+    Image<RGBColor> providedImg;
+    provider.readImage(filename, providedImg, image::EImageColorSpace::NO_CONVERSION, 0, oiio::ROI(10, 20, 3, 5));
+    BOOST_CHECK_EQUAL(providedImg.Width(), 6);
+    BOOST_CHECK_EQUAL(providedImg.Height(), 2);
+    for(int y = 0; y < 2; ++y)
+      for(int x = 0; x < 6; ++x)
+        BOOST_CHECK(providedImg(y, x) == image(3 + y, 10 + x));
+
+    BOOST_CHECK_THROW(provider.readImage(filename, providedImg, image::EImageColorSpace::NO_CONVERSION, 0, oiio::ROI(20, 30, 0, 8)), std::exception);
+  }
+
+  // grayscale conversion, as readImage
+  {
+    Image<float> readImg, providedImg;
+    readImage(filename, readImg, image::EImageColorSpace::LINEAR);
+    provider.readImage(filename, providedImg, image::EImageColorSpace::LINEAR);
+    BOOST_CHECK_EQUAL(providedImg.Width(), readImg.Width());
+    BOOST_CHECK_EQUAL(providedImg.Height(), readImg.Height());
+    for(int y = 0; y < readImg.Height(); ++y)
+      for(int x = 0; x < readImg.Width(); ++x)
+        BOOST_CHECK_SMALL(providedImg(y, x) - readImg(y, x), 1e-5f);
+  }
+
+  // the file is read again once invalidated
+  {
+    const Image<RGBColor> otherImage = blocksImage(4, 4);
+    BOOST_CHECK_NO_THROW(writeImage(filename, otherImage, image::EImageColorSpace::NO_CONVERSION));
+    provider.invalidate(filename);
+
+    Image<RGBColor> providedImg;
+    provider.readImage(filename, providedImg, image::EImageColorSpace::NO_CONVERSION);
+    BOOST_CHECK_EQUAL(providedImg.Width(), 4);
+    BOOST_CHECK_EQUAL(providedImg.Height(), 4);
+  }
+
+  remove(filename.c_str());
+}
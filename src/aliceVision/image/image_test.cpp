@@ -86,3 +86,39 @@ BOOST_AUTO_TEST_CASE(Image_ImageConverter)
   imaColorRGBA.fill(RGBAColor(10,10,10, 255));
   ConvertPixelType(imaColorRGBA, &imaGray);
 }
+
+BOOST_AUTO_TEST_CASE(Image_HalfConverter)
+{
+  // more pixels than a conversion block
+  Image<float> imaFloat(300, 300);
+  for(int j = 0; j < imaFloat.Height(); ++j)
+    for(int i = 0; i < imaFloat.Width(); ++i)
+      imaFloat(j, i) = (i - 150) * 0.37f + j * 12.5f;
+
+  Image<half> imaHalf;
+  ConvertPixelType(imaFloat, &imaHalf);
+  BOOST_CHECK_EQUAL(imaHalf.Width(), imaFloat.Width());
+  BOOST_CHECK_EQUAL(imaHalf.Height(), imaFloat.Height());
+
+  Image<float> imaFloatBack;
+  ConvertPixelType(imaHalf, &imaFloatBack);
+  for(int j = 0; j < imaFloat.Height(); ++j)
+    for(int i = 0; i < imaFloat.Width(); ++i)
+    {
+      BOOST_CHECK_EQUAL(static_cast<float>(imaHalf(j, i)), imaFloatBack(j, i));
+      // half floats keep 11 significant bits
+      BOOST_CHECK_SMALL(imaFloatBack(j, i) - imaFloat(j, i), std::abs(imaFloat(j, i)) / 1024.f + 1e-6f);
+    }
+
+  Image<RGBfColor> imaColor(7, 5);
+  imaColor.fill(RGBfColor(0.5f, -2.25f, 1024.f)); // values exact in half
+  Image<RGBhColor> imaColorHalf;
+  ConvertPixelType(imaColor, &imaColorHalf);
+  Image<RGBfColor> imaColorBack;
+  ConvertPixelType(imaColorHalf, &imaColorBack);
+  BOOST_CHECK_EQUAL(imaColorBack.Width(), imaColor.Width());
+  BOOST_CHECK_EQUAL(imaColorBack.Height(), imaColor.Height());
+  for(int j = 0; j < imaColor.Height(); ++j)
+    for(int i = 0; i < imaColor.Width(); ++i)
+      BOOST_CHECK(imaColorBack(j, i) == imaColor(j, i));
+}
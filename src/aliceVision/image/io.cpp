@@ -7,6 +7,8 @@
 
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/system/Profiler.hpp>
+#include <aliceVision/system/Storage.hpp>
 
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/imagebuf.h>
@@ -85,7 +87,7 @@ oiio::ParamValueList getMetadataFromMap(const std::map<std::string, std::string>
 
 oiio::ParamValueList readImageMetadata(const std::string& path, int& width, int& height)
 {
-  std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(path));
+  std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(system::Storage::get().getLocalPath(path)));
   oiio::ImageSpec spec = in->spec();
 
   if(!in)
@@ -162,13 +164,26 @@ void getBufferFromImage(Image<RGBColor>& image, oiio::ImageBuf& buffer)
   getBufferFromImage(image, oiio::TypeDesc::UINT8, 3, buffer);
 }
 
+void getBufferFromImage(Image<half>& image, oiio::ImageBuf& buffer)
+{
+  getBufferFromImage(image, oiio::TypeDesc::HALF, 1, buffer);
+}
+
+void getBufferFromImage(Image<RGBhColor>& image, oiio::ImageBuf& buffer)
+{
+  getBufferFromImage(image, oiio::TypeDesc::HALF, 3, buffer);
+}
+
 template<typename T>
 void readImage(const std::string& path,
                oiio::TypeDesc format,
                int nchannels,
                Image<T>& image,
-               EImageColorSpace imageColorSpace)
+               EImageColorSpace imageColorSpace,
+               const oiio::ParamValueList& inputSettings)
 {
+  ALICEVISION_PROFILE_SCOPE("image::readImage");
+
   // check requested channels number
   assert(nchannels == 1 || nchannels >= 3);
 
@@ -185,7 +200,12 @@ void readImage(const std::string& path,
   configSpec.attribute("raw:ColorSpace", "Linear");   // want linear colorspace with sRGB primaries
 #endif
 
-  oiio::ImageBuf inBuf(path, 0, 0, NULL, &configSpec);
+  // caller settings
+  for(const oiio::ParamValue& setting : inputSettings)
+    configSpec.attribute(setting.name().string(), setting.type(), setting.data());
+
+  // local copy of a remote image
+  oiio::ImageBuf inBuf(system::Storage::get().getLocalPath(path), 0, 0, NULL, &configSpec);
 
   inBuf.read(0, 0, true, oiio::TypeDesc::FLOAT); // force image convertion to float (for grayscale and color space convertion)
 
@@ -290,6 +310,8 @@ void writeImage(const std::string& path,
                 EImageColorSpace imageColorSpace,
                 const oiio::ParamValueList& metadata = oiio::ParamValueList())
 {
+  ALICEVISION_PROFILE_SCOPE_BYTES("image::writeImage", static_cast<std::uint64_t>(image.Width()) * image.Height() * sizeof(T));
+
   const fs::path bPath = fs::path(path);
   const std::string extension = bPath.extension().string();
   const std::string tmpPath =  (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + extension;
@@ -338,29 +360,39 @@ void writeImage(const std::string& path,
   fs::rename(tmpPath, path);
 }
 
-void readImage(const std::string& path, Image<float>& image, EImageColorSpace imageColorSpace)
+void readImage(const std::string& path, Image<float>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings)
 {
-  readImage(path, oiio::TypeDesc::FLOAT, 1, image, imageColorSpace);
+  readImage(path, oiio::TypeDesc::FLOAT, 1, image, imageColorSpace, inputSettings);
 }
 
-void readImage(const std::string& path, Image<unsigned char>& image, EImageColorSpace imageColorSpace)
+void readImage(const std::string& path, Image<unsigned char>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings)
 {
-  readImage(path, oiio::TypeDesc::UINT8, 1, image, imageColorSpace);
+  readImage(path, oiio::TypeDesc::UINT8, 1, image, imageColorSpace, inputSettings);
 }
 
-void readImage(const std::string& path, Image<RGBAColor>& image, EImageColorSpace imageColorSpace)
+void readImage(const std::string& path, Image<RGBAColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings)
 {
-  readImage(path, oiio::TypeDesc::UINT8, 4, image, imageColorSpace);
+  readImage(path, oiio::TypeDesc::UINT8, 4, image, imageColorSpace, inputSettings);
 }
 
-void readImage(const std::string& path, Image<RGBfColor>& image, EImageColorSpace imageColorSpace)
+void readImage(const std::string& path, Image<RGBfColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings)
 {
-  readImage(path, oiio::TypeDesc::FLOAT, 3, image, imageColorSpace);
+  readImage(path, oiio::TypeDesc::FLOAT, 3, image, imageColorSpace, inputSettings);
 }
 
-void readImage(const std::string& path, Image<RGBColor>& image, EImageColorSpace imageColorSpace)
+void readImage(const std::string& path, Image<RGBColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings)
 {
-  readImage(path, oiio::TypeDesc::UINT8, 3, image, imageColorSpace);
+  readImage(path, oiio::TypeDesc::UINT8, 3, image, imageColorSpace, inputSettings);
+}
+
+void readImage(const std::string& path, Image<half>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings)
+{
+  readImage(path, oiio::TypeDesc::HALF, 1, image, imageColorSpace, inputSettings);
+}
+
+void readImage(const std::string& path, Image<RGBhColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings)
+{
+  readImage(path, oiio::TypeDesc::HALF, 3, image, imageColorSpace, inputSettings);
 }
 
 void writeImage(const std::string& path, const Image<unsigned char>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& metadata)
@@ -383,5 +415,15 @@ void writeImage(const std::string& path, const Image<RGBColor>& image, EImageCol
   writeImage(path, oiio::TypeDesc::UINT8, 3, image, imageColorSpace, metadata);
 }
 
+void writeImage(const std::string& path, const Image<half>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& metadata)
+{
+  writeImage(path, oiio::TypeDesc::HALF, 1, image, imageColorSpace, metadata);
+}
+
+void writeImage(const std::string& path, const Image<RGBhColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& metadata)
+{
+  writeImage(path, oiio::TypeDesc::HALF, 3, image, imageColorSpace, metadata);
+}
+
 }  // namespace image
 }  // namespace aliceVision
@@ -120,18 +120,23 @@ void getBufferFromImage(Image<unsigned char>& image, oiio::ImageBuf& buffer);
 void getBufferFromImage(Image<RGBAColor>& image, oiio::ImageBuf& buffer);
 void getBufferFromImage(Image<RGBfColor>& image, oiio::ImageBuf& buffer);
 void getBufferFromImage(Image<RGBColor>& image, oiio::ImageBuf& buffer);
+void getBufferFromImage(Image<half>& image, oiio::ImageBuf& buffer);
+void getBufferFromImage(Image<RGBhColor>& image, oiio::ImageBuf& buffer);
 
 /**
  * @brief read an image with a given path and buffer
  * @param[in] path The given path to the image
  * @param[out] image The output image buffer
  * @param[in] image color space
+ * @param[in] inputSettings The input plugin settings, overriding the defaults (eg. "raw:half_size" to demosaic RAW files at half resolution)
  */
-void readImage(const std::string& path, Image<float>& image, EImageColorSpace imageColorSpace);
-void readImage(const std::string& path, Image<unsigned char>& image, EImageColorSpace imageColorSpace);
-void readImage(const std::string& path, Image<RGBAColor>& image, EImageColorSpace imageColorSpace);
-void readImage(const std::string& path, Image<RGBfColor>& image, EImageColorSpace imageColorSpace);
-void readImage(const std::string& path, Image<RGBColor>& image, EImageColorSpace imageColorSpace);
+void readImage(const std::string& path, Image<float>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings = oiio::ParamValueList());
+void readImage(const std::string& path, Image<unsigned char>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings = oiio::ParamValueList());
+void readImage(const std::string& path, Image<RGBAColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings = oiio::ParamValueList());
+void readImage(const std::string& path, Image<RGBfColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings = oiio::ParamValueList());
+void readImage(const std::string& path, Image<RGBColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings = oiio::ParamValueList());
+void readImage(const std::string& path, Image<half>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings = oiio::ParamValueList());
+void readImage(const std::string& path, Image<RGBhColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& inputSettings = oiio::ParamValueList());
 
 /**
  * @brief write an image with a given path and buffer
@@ -142,6 +147,8 @@ void writeImage(const std::string& path, const Image<unsigned char>& image, EIma
 void writeImage(const std::string& path, const Image<RGBAColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 void writeImage(const std::string& path, const Image<RGBfColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 void writeImage(const std::string& path, const Image<RGBColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
+void writeImage(const std::string& path, const Image<half>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
+void writeImage(const std::string& path, const Image<RGBhColor>& image, EImageColorSpace imageColorSpace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 
 }  // namespace image
 }  // namespace aliceVision
@@ -257,3 +257,35 @@ BOOST_AUTO_TEST_CASE(read_write_from_grayscale_to_rgb) {
     remove(filename.c_str());
   }
 }
+
+BOOST_AUTO_TEST_CASE(read_write_half) {
+  Image<half> image(1,2);
+  image(0,0) = 0.25f;
+  image(1,0) = 1000.f;
+
+  Image<RGBhColor> imageRGB(1,2);
+  imageRGB(0,0) = RGBhColor(half(0.5f), half(1.f), half(2.f));
+  imageRGB(1,0) = RGBhColor(half(-1.f), half(0.f), half(4096.f));
+
+  for(const std::string extension : {"exr", "tiff"})
+  {
+    const std::string filename = "test_write_half." + extension;
+    BOOST_CHECK_NO_THROW(writeImage(filename, image, image::EImageColorSpace::NO_CONVERSION));
+
+    Image<half> read_image;
+    BOOST_CHECK_NO_THROW(readImage(filename, read_image, image::EImageColorSpace::NO_CONVERSION));
+    BOOST_CHECK_EQUAL(read_image(0,0), image(0,0));
+    BOOST_CHECK_EQUAL(read_image(1,0), image(1,0));
+
+    const std::string filenameRGB = "test_write_half_rgb." + extension;
+    BOOST_CHECK_NO_THROW(writeImage(filenameRGB, imageRGB, image::EImageColorSpace::NO_CONVERSION));
+
+    Image<RGBhColor> read_imageRGB;
+    BOOST_CHECK_NO_THROW(readImage(filenameRGB, read_imageRGB, image::EImageColorSpace::NO_CONVERSION));
+    BOOST_CHECK(read_imageRGB(0,0) == imageRGB(0,0));
+    BOOST_CHECK(read_imageRGB(1,0) == imageRGB(1,0));
+
+    remove(filename.c_str());
+    remove(filenameRGB.c_str());
+  }
+}
@@ -9,6 +9,8 @@
 
 #include "aliceVision/numeric/numeric.hpp"
 
+#include <OpenEXR/half.h>
+
 namespace aliceVision
 {
   namespace image
@@ -180,6 +182,8 @@ namespace aliceVision
     typedef Rgb<unsigned char> RGBColor;
     /// Instantiation for float color component
     typedef Rgb<float> RGBfColor;
+    /// Instantiation for half float color component (half the memory of RGBfColor, 3 significant digits)
+    typedef Rgb<half> RGBhColor;
 
     /**
     * @brief RGBA templated pixel type
@@ -23,16 +23,16 @@ namespace image {
     const int new_width  = src.Width() / 2 ;
     const int new_height = src.Height() / 2 ;
 
-    out.resize( new_width , new_height ) ;
-
-    const Sampler2d<SamplerLinear> sampler;
+    out.resize( new_width , new_height , false ) ;
 
+    // The bilinear sampling at the mid pixel 2*(i+.5) falls on the pixel 2*i+1
+    // with a null weight for its neighbors: the rows are decimated.
     for( int i = 0 ; i < new_height ; ++i )
     {
+      const typename Image::Tpixel* srcRow = &src( 2 * i + 1 , 0 ) ;
       for( int j = 0 ; j < new_width ; ++j )
       {
-        // Use .5f offset to ensure mid pixel and correct bilinear sampling
-        out( i , j ) =  sampler( src, 2.f * (i+.5f), 2.f * (j+.5f) );
+        out( i , j ) = srcRow[ 2 * j + 1 ] ;
       }
     }
   }
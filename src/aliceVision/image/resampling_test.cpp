@@ -122,3 +122,41 @@ BOOST_AUTO_TEST_CASE(Ressampling_SampleRotate)
   BOOST_CHECK_NO_THROW(ImageRotation(image, Sampler2d< SamplerSpline16 >(), "SamplerSpline16"));
   BOOST_CHECK_NO_THROW(ImageRotation(image, Sampler2d< SamplerSpline64 >(), "SamplerSpline64"));
 }
+
+// The half sampling must give the bilinear samples at the mid pixels
+template<typename T>
+void checkHalfSample(const Image<T>& image)
+{
+  Image<T> halfImage;
+  ImageHalfSample(image, halfImage);
+
+  BOOST_CHECK_EQUAL(halfImage.Width(), image.Width() / 2);
+  BOOST_CHECK_EQUAL(halfImage.Height(), image.Height() / 2);
+
+  const Sampler2d<SamplerLinear> sampler;
+  for(int i = 0; i < halfImage.Height(); ++i)
+    for(int j = 0; j < halfImage.Width(); ++j)
+      BOOST_CHECK(halfImage(i, j) == sampler(image, 2.f * (i + .5f), 2.f * (j + .5f)));
+}
+
+BOOST_AUTO_TEST_CASE(Ressampling_HalfSample)
+{
+  const int width = 33;
+  const int height = 18;
+  Image<unsigned char> imageGray(width, height);
+  Image<float> imageFloat(width, height);
+  Image<RGBfColor> imageRGB(width, height);
+  for(int i = 0; i < height; ++i)
+  {
+    for(int j = 0; j < width; ++j)
+    {
+      imageGray(i, j) = static_cast<unsigned char>((i * 31 + j * 17) % 256);
+      imageFloat(i, j) = std::sin(0.3f * i) + std::cos(0.7f * j);
+      imageRGB(i, j) = RGBfColor(imageFloat(i, j), 0.5f * i, 0.25f * j);
+    }
+  }
+
+  checkHalfSample(imageGray);
+  checkHalfSample(imageFloat);
+  checkHalfSample(imageRGB);
+}
@@ -33,8 +33,8 @@ void Warp(const Image &im, const Mat3 & H, Image &out)
   const int hOut = static_cast<int>(out.Height());
 
   const Sampler2d<SamplerLinear> sampler;
+  #pragma omp parallel for
   for (int j = 0; j < hOut; ++j)
-    #pragma omp parallel for
     for (int i = 0; i < wOut; ++i)
     {
       double xT = i, yT = j;
@@ -9,6 +9,8 @@
 #include <aliceVision/sensorDB/parseDatabase.hpp>
 #include <aliceVision/feature/sift/ImageDescriber_SIFT.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/RingBuffer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/filesystem.hpp>
 
@@ -176,29 +178,35 @@ void KeyframeSelector::process()
     ALICEVISION_LOG_INFO("frame : " << frameIndex);
     bool frameSelected = true;
     auto& frameData = _framesData.at(frameIndex);
-    frameData.mediasData.resize(_feeds.size());
+
+    // compute the sharpness and sparse histograms of the next frames without them
+    if(!frameData.hasFeatures)
+    {
+      std::size_t nbBatchFrames = 1;
+      while(nbBatchFrames < _maxFrameStep &&
+            frameIndex + nbBatchFrames < _framesData.size() &&
+            !_framesData.at(frameIndex + nbBatchFrames).hasFeatures)
+        ++nbBatchFrames;
+
+      computeFramesFeatures(frameIndex, nbBatchFrames, tileSharpSubset);
+    }
+
+    // the frame can be evaluated again after a keyframe choice
+    frameData.selected = false;
+    frameData.maxDistScore = 0;
 
     for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
     {
       ALICEVISION_LOG_DEBUG("media : " << _mediaPaths.at(mediaIndex));
-      auto& feed = *_feeds.at(mediaIndex);
 
       if(frameSelected) // false if a camera of a rig is not selected
       {
-        if(!feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics))
-        {
-          ALICEVISION_LOG_ERROR("Cannot read frame '" << currentImgName << "' !");
-          throw std::invalid_argument("Cannot read frame '" + currentImgName + "' !");
-        }
-
-        // compute sharpness and sparse distance
-        if(!computeFrameData(image, frameIndex, mediaIndex, tileSharpSubset))
+        // compute sparse distance
+        if(!computeFrameData(frameIndex, mediaIndex))
         {
           frameSelected = false;
         }
       }
-
-      feed.goToNextFrame();
     }
 
     {
@@ -213,6 +221,7 @@ void KeyframeSelector::process()
       {
         ALICEVISION_LOG_INFO(" > skipped" << std::endl);
         frameData.mediasData.clear(); // remove unselected mediasData
+        frameData.hasFeatures = false;
       }
     }
 
@@ -335,18 +344,19 @@ float KeyframeSelector::computeSharpness(const image::Image<float>& imageGray,
   image::ImageScharrXDerivative(imageGray, scharrXDer); // normalized
   image::ImageScharrYDerivative(imageGray, scharrYDer); // normalized
 
-  scharrXDer = scharrXDer.cwiseAbs(); // absolute value
-  scharrYDer = scharrYDer.cwiseAbs(); // absolute value
+  // absolute value of the gradient, summed once per tile
+  scharrXDer = scharrXDer.cwiseAbs() + scharrYDer.cwiseAbs();
 
   // image tiles
   std::vector<float> averageTileIntensity;
+  averageTileIntensity.reserve(_nbTileSide * _nbTileSide);
   const float tileSizeInv = 1 / static_cast<float>(tileHeight * tileWidth);
 
   for(std::size_t y =  0; y < (_nbTileSide * tileHeight); y += tileHeight)
   {
     for(std::size_t x =  0; x < (_nbTileSide * tileWidth); x += tileWidth)
     {
-      const auto sum = scharrXDer.block(y, x, tileHeight, tileWidth).sum() + scharrYDer.block(y, x, tileHeight, tileWidth).sum();
+      const auto sum = scharrXDer.block(y, x, tileHeight, tileWidth).sum();
       averageTileIntensity.push_back(sum * tileSizeInv);
     }
   }
@@ -359,20 +369,15 @@ float KeyframeSelector::computeSharpness(const image::Image<float>& imageGray,
 }
 
 
-bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& image,
-                                        std::size_t frameIndex,
-                                        std::size_t mediaIndex,
-                                        unsigned int tileSharpSubset)
+void KeyframeSelector::computeMediaFeatures(const image::Image<image::RGBColor>& image,
+                                            std::size_t mediaIndex,
+                                            unsigned int tileSharpSubset,
+                                            MediaData& mediaData) const
 {
-  if(!_hasSharpnessSelection && !_hasSparseDistanceSelection)
-    return true; // nothing to do
-
   image::Image<float> imageGray;           // grayscale image
   image::Image<float> imageGrayHalfSample; // half resolution grayscale image
-  
+
   const auto& currMediaInfo = _mediasInfo.at(mediaIndex);
-  auto& currframeData = _framesData.at(frameIndex);
-  auto& currMediaData = currframeData.mediasData.at(mediaIndex);
 
   // get grayscale image and resize
   image::ConvertPixelType(image, &imageGray);
@@ -381,27 +386,155 @@ bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& ima
   // compute sharpness
   if(_hasSharpnessSelection)
   {
-    currMediaData.sharpness = computeSharpness(imageGrayHalfSample,
-                                               currMediaInfo.tileHeight,
-                                               currMediaInfo.tileWidth,
-                                               tileSharpSubset);
-    ALICEVISION_LOG_DEBUG( " - sharpness : " << currMediaData.sharpness);
+    mediaData.sharpness = computeSharpness(imageGrayHalfSample,
+                                           currMediaInfo.tileHeight,
+                                           currMediaInfo.tileWidth,
+                                           tileSharpSubset);
+  }
+
+  // compute sparse histogram, only used by the sparse distance
+  if(_hasSparseDistanceSelection && ((mediaData.sharpness > _sharpnessThreshold) || !_hasSharpnessSelection))
+  {
+    std::unique_ptr<feature::Regions> regions;
+
+    if(_imageDescriber->useCuda())
+    {
+      // the GPU image describer can't be used by concurrent threads
+      #pragma omp critical(keyframeSelectorDescribe)
+      _imageDescriber->describe(imageGrayHalfSample, regions);
+    }
+    else
+    {
+      _imageDescriber->describe(imageGrayHalfSample, regions);
+    }
+
+    mediaData.histogram = voctree::SparseHistogram(_voctree->quantizeToSparse(dynamic_cast<feature::SIFT_Regions*>(regions.get())->Descriptors()));
+  }
+}
+
+void KeyframeSelector::computeFramesFeatures(std::size_t firstFrame,
+                                             std::size_t nbFrames,
+                                             unsigned int tileSharpSubset)
+{
+  for(std::size_t frameIndex = firstFrame; frameIndex < firstFrame + nbFrames; ++frameIndex)
+  {
+    auto& frameData = _framesData.at(frameIndex);
+    frameData.mediasData.assign(_feeds.size(), MediaData());
+    frameData.hasFeatures = true;
+  }
+
+  if(!_hasSharpnessSelection && !_hasSparseDistanceSelection)
+    return; // nothing to do
+
+  // decoded image of a media at a frame
+  struct MediaImage
+  {
+    std::size_t frameIndex = 0;
+    std::size_t mediaIndex = 0;
+    image::Image<image::RGBColor> image;
+  };
+
+  // feeds are read in frames order, from the first frame of the batch
+  for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
+    _feeds.at(mediaIndex)->goToFrame(firstFrame + _cameraInfos.at(mediaIndex).frameOffset);
+
+  std::string errorImgName;
+  bool readSucceeded = true;
+
+  const auto readMediaImage = [&](MediaImage& mediaImage)
+  {
+    auto& feed = *_feeds.at(mediaImage.mediaIndex);
+    camera::PinholeRadialK3 queryIntrinsics;
+    bool hasIntrinsics = false;
+    std::string currentImgName;
+
+    if(!feed.readImage(mediaImage.image, queryIntrinsics, currentImgName, hasIntrinsics))
+    {
+      errorImgName = currentImgName;
+      readSucceeded = false;
+    }
+    feed.goToNextFrame();
+    return readSucceeded;
+  };
+
+  const int nbThreads = std::max(2, omp_get_max_threads());
+  system::RingBuffer<std::shared_ptr<MediaImage>> decodedQueue(nbThreads);
+
+  #pragma omp parallel num_threads(nbThreads)
+  {
+    if(omp_get_num_threads() < 2)
+    {
+      // the decoding can't run with the computation, process the images one by one
+      MediaImage mediaImage;
+      for(std::size_t frameIndex = firstFrame; readSucceeded && frameIndex < firstFrame + nbFrames; ++frameIndex)
+      {
+        for(std::size_t mediaIndex = 0; readSucceeded && mediaIndex < _feeds.size(); ++mediaIndex)
+        {
+          mediaImage.frameIndex = frameIndex;
+          mediaImage.mediaIndex = mediaIndex;
+          if(readMediaImage(mediaImage))
+            computeMediaFeatures(mediaImage.image, mediaIndex, tileSharpSubset, _framesData.at(frameIndex).mediasData.at(mediaIndex));
+        }
+      }
+    }
+    else if(omp_get_thread_num() == 0)
+    {
+      // decode stage
+      for(std::size_t frameIndex = firstFrame; readSucceeded && frameIndex < firstFrame + nbFrames; ++frameIndex)
+      {
+        for(std::size_t mediaIndex = 0; readSucceeded && mediaIndex < _feeds.size(); ++mediaIndex)
+        {
+          std::shared_ptr<MediaImage> mediaImage = std::make_shared<MediaImage>();
+          mediaImage->frameIndex = frameIndex;
+          mediaImage->mediaIndex = mediaIndex;
+          if(readMediaImage(*mediaImage))
+            decodedQueue.push(mediaImage);
+        }
+      }
+      decodedQueue.close();
+    }
+    else
+    {
+      // compute stage, each image writes its own media data
+      std::shared_ptr<MediaImage> mediaImage;
+      while(decodedQueue.pop(mediaImage))
+      {
+        computeMediaFeatures(mediaImage->image, mediaImage->mediaIndex, tileSharpSubset,
+                             _framesData.at(mediaImage->frameIndex).mediasData.at(mediaImage->mediaIndex));
+        mediaImage.reset(); // release the image before waiting for the next one
+      }
+    }
+  }
+
+  if(!readSucceeded)
+  {
+    ALICEVISION_LOG_ERROR("Cannot read frame '" << errorImgName << "' !");
+    throw std::invalid_argument("Cannot read frame '" + errorImgName + "' !");
   }
+}
+
+bool KeyframeSelector::computeFrameData(std::size_t frameIndex,
+                                        std::size_t mediaIndex)
+{
+  if(!_hasSharpnessSelection && !_hasSparseDistanceSelection)
+    return true; // nothing to do
+
+  auto& currframeData = _framesData.at(frameIndex);
+  auto& currMediaData = currframeData.mediasData.at(mediaIndex);
+
+  if(_hasSharpnessSelection)
+    ALICEVISION_LOG_DEBUG( " - sharpness : " << currMediaData.sharpness);
 
   if((currMediaData.sharpness > _sharpnessThreshold) || !_hasSharpnessSelection)
   {
     bool noKeyframe = (_keyframeIndexes.empty());
 
-    // compute current frame sparse histogram
-    std::unique_ptr<feature::Regions> regions;
-    _imageDescriber->describe(imageGrayHalfSample, regions);
-    currMediaData.histogram = voctree::SparseHistogram(_voctree->quantizeToSparse(dynamic_cast<feature::SIFT_Regions*>(regions.get())->Descriptors()));
-
     // compute sparseDistance
     if(!noKeyframe && _hasSparseDistanceSelection)
     {
       unsigned int nbKeyframetoCompare = (_keyframeIndexes.size() < _nbKeyFrameDist)? _keyframeIndexes.size() : _nbKeyFrameDist;
 
+      currMediaData.distScore = 0;
       for(std::size_t i = _keyframeIndexes.size() - nbKeyframetoCompare; i < _keyframeIndexes.size(); ++i)
       {
         for(auto& media : _framesData.at(_keyframeIndexes.at(i)).mediasData)
@@ -295,6 +295,8 @@ private:
     bool selected = false;
     /// frame is a keyframe
     bool keyframe = false;
+    /// medias sharpness and sparse histograms are computed
+    bool hasFeatures = false;
     /// medias process data
     std::vector<MediaData> mediasData;
 
@@ -303,6 +305,7 @@ private:
      */
     void computeAvgSharpness()
     {
+      avgSharpness = 0;
       for(const auto& media : mediasData)
         avgSharpness += media.sharpness;
       avgSharpness /= mediasData.size();
@@ -330,17 +333,37 @@ private:
                          const unsigned int tileSharpSubset) const;
 
   /**
-   * @brief Compute sharpness and distance score for a given image
+   * @brief Compute sharpness and sparse histogram of a given image
+   * @note thread safe
    * @param[in] image an image of the media
-   * @param[in] frameIndex the image index in the media sequence
    * @param[in] mediaIndex the media index
    * @param[in] tileSharpSubset number of sharp tiles
+   * @param[out] mediaData the media data of the image
+   */
+  void computeMediaFeatures(const image::Image<image::RGBColor>& image,
+                            std::size_t mediaIndex,
+                            unsigned int tileSharpSubset,
+                            MediaData& mediaData) const;
+
+  /**
+   * @brief Compute sharpness and sparse histograms of consecutive frames of all the medias
+   * @note the frames are decoded by one thread while the others compute them
+   * @param[in] firstFrame the first frame index in the media sequence
+   * @param[in] nbFrames the number of frames
+   * @param[in] tileSharpSubset number of sharp tiles
+   */
+  void computeFramesFeatures(std::size_t firstFrame,
+                             std::size_t nbFrames,
+                             unsigned int tileSharpSubset);
+
+  /**
+   * @brief Compute distance score of a given frame media from its features
+   * @param[in] frameIndex the image index in the media sequence
+   * @param[in] mediaIndex the media index
    * @return true if the frame is selected
    */
-  bool computeFrameData(const image::Image<image::RGBColor>& image,
-                        std::size_t frameIndex,
-                        std::size_t mediaIndex,
-                        unsigned int tileSharpSubset);
+  bool computeFrameData(std::size_t frameIndex,
+                        std::size_t mediaIndex);
 
   /**
    * @brief Write a keyframe and metadata
@@ -7,78 +7,172 @@
 #include "lightingEstimation.hpp"
 #include "augmentedNormals.hpp"
 
+#include <aliceVision/alicevision_omp.hpp>
+
 #include <Eigen/Dense>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <iostream>
+#include <stdexcept>
+#include <vector>
 
 
 namespace aliceVision {
 namespace lightingEstimation {
 
+/// number of pixels stored by component before their accumulation
+const int tileSize = 256;
+
+/// number of sampled rows accumulated by the same task
+const int blockRows = 16;
+
 /**
- * @brief Evaluate albedo and normal product for one channel
+ * @brief Normal equations of the lighting estimation problem of the 3 channels
+ * Only the lower part of the symmetric matrices is accumulated
  */
-void albedoNormalsProduct(MatrixXf& rhoTimesN, const MatrixXf& albedoChannel, const image::Image<AugmentedNormal>& augmentedNormals)
+struct NormalEquations
 {
-    for (int i = 0; i < augmentedNormals.size(); ++i)
+    std::array<Eigen::Matrix<double, 9, 9>, 3> AtA;
+    std::array<Eigen::Matrix<double, 9, 1>, 3> Atb;
+
+    NormalEquations()
     {
-        rhoTimesN(i, 0) = albedoChannel(i) * augmentedNormals(i).nx();
-        rhoTimesN(i, 1) = albedoChannel(i) * augmentedNormals(i).ny();
-        rhoTimesN(i, 2) = albedoChannel(i) * augmentedNormals(i).nz();
-        rhoTimesN(i, 3) = albedoChannel(i) * augmentedNormals(i).nambiant();
-        rhoTimesN(i, 4) = albedoChannel(i) * augmentedNormals(i).nx_ny();
-        rhoTimesN(i, 5) = albedoChannel(i) * augmentedNormals(i).nx_nz();
-        rhoTimesN(i, 6) = albedoChannel(i) * augmentedNormals(i).ny_nz();
-        rhoTimesN(i, 7) = albedoChannel(i) * augmentedNormals(i).nx2_ny2();
-        rhoTimesN(i, 8) = albedoChannel(i) * augmentedNormals(i).nz2();
+        for(int c = 0; c < 3; ++c)
+        {
+            AtA[c].setZero();
+            Atb[c].setZero();
+        }
+    }
+
+    NormalEquations& operator+=(const NormalEquations& other)
+    {
+        for(int c = 0; c < 3; ++c)
+        {
+            AtA[c] += other.AtA[c];
+            Atb[c] += other.Atb[c];
+        }
+        return *this;
+    }
+};
+
+/**
+ * @brief Accumulate the normal equations of a tile of pixels
+ * The augmented normals, the albedo and the picture values are stored by component (structure of arrays).
+ * The normal equations square the condition number of the problem, they are accumulated in double precision.
+ */
+void accumulateTile(NormalEquations& equations, int nbPixels, const float (&augNormals)[9][tileSize], const float (&albedo)[3][tileSize], const float (&picture)[3][tileSize])
+{
+    double rhoTimesN[9][tileSize];
+
+    for(int c = 0; c < 3; ++c)
+    {
+        // rows of the least squares system: albedo and normal product
+        for(int k = 0; k < 9; ++k)
+            for(int p = 0; p < nbPixels; ++p)
+                rhoTimesN[k][p] = double(albedo[c][p]) * augNormals[k][p];
+
+        for(int k = 0; k < 9; ++k)
+        {
+            for(int l = 0; l <= k; ++l)
+            {
+                double sum = 0.0;
+                for(int p = 0; p < nbPixels; ++p)
+                    sum += rhoTimesN[k][p] * rhoTimesN[l][p];
+                equations.AtA[c](k, l) += sum;
+            }
+
+            double sum = 0.0;
+            for(int p = 0; p < nbPixels; ++p)
+                sum += rhoTimesN[k][p] * picture[c][p];
+            equations.Atb[c](k) += sum;
+        }
     }
 }
 
 /**
- * @brief Resolve lighting estimation problem for one channel
+ * @brief Accumulate the normal equations of the sampled pixels of a block of rows
  */
- 
-void estimateLigthingOneChannel(Eigen::Matrix<float, 9, 1>& lighting, const MatrixXf& albedoChannel, const MatrixXf& pictureChannel, const image::Image<AugmentedNormal>& augNormals)
+void accumulateRows(NormalEquations& equations, int yBegin, int yEnd, int subsampling, const image::Image<image::RGBfColor>& albedo, const image::Image<image::RGBfColor>& picture, const image::Image<image::RGBfColor>& normals)
 {
-    const auto nbPoints = augNormals.size();
+    float augNormals[9][tileSize];
+    float albedoTile[3][tileSize];
+    float pictureTile[3][tileSize];
+    int nbTilePixels = 0;
 
-    MatrixXf rhoTimesN(nbPoints, 9);
-    albedoNormalsProduct(rhoTimesN, albedoChannel, augNormals);
+    for(int y = yBegin; y < yEnd; y += subsampling)
+    {
+        for(int x = 0; x < albedo.Width(); x += subsampling)
+        {
+            const image::RGBfColor& n = normals(y, x);
+            const float nx = n.r();
+            const float ny = n.g();
+            const float nz = n.b();
+
+            // augmented normal, as AugmentedNormal
+            augNormals[0][nbTilePixels] = nx;
+            augNormals[1][nbTilePixels] = ny;
+            augNormals[2][nbTilePixels] = nz;
+            augNormals[3][nbTilePixels] = 1.f;
+            augNormals[4][nbTilePixels] = nx * ny;
+            augNormals[5][nbTilePixels] = nx * nz;
+            augNormals[6][nbTilePixels] = ny * nz;
+            augNormals[7][nbTilePixels] = nx * nx - ny * ny;
+            augNormals[8][nbTilePixels] = 3 * nz * nz - 1;
+
+            for(int c = 0; c < 3; ++c)
+            {
+                albedoTile[c][nbTilePixels] = albedo(y, x)(c);
+                pictureTile[c][nbTilePixels] = picture(y, x)(c);
+            }
+
+            if(++nbTilePixels == tileSize)
+            {
+                accumulateTile(equations, nbTilePixels, augNormals, albedoTile, pictureTile);
+                nbTilePixels = 0;
+            }
+        }
+    }
 
-    lighting = rhoTimesN.colPivHouseholderQr().solve(pictureChannel);
+    if(nbTilePixels > 0)
+        accumulateTile(equations, nbTilePixels, augNormals, albedoTile, pictureTile);
 }
 
-void estimateLigthing(LightingVector& lighting, const image::Image<image::RGBfColor>& albedo, const image::Image<image::RGBfColor>& picture, const image::Image<image::RGBfColor>& normals)
+void estimateLigthing(LightingVector& lighting, const image::Image<image::RGBfColor>& albedo, const image::Image<image::RGBfColor>& picture, const image::Image<image::RGBfColor>& normals, int subsampling)
 {
-    using namespace Eigen;
+    assert(albedo.Width() == picture.Width() && albedo.Height() == picture.Height());
+    assert(albedo.Width() == normals.Width() && albedo.Height() == normals.Height());
 
-    // Map albedo, image
-    const std::size_t nbPixels = albedo.Width() * albedo.Height();
+    if(subsampling < 1)
+        throw std::invalid_argument("The lighting estimation subsampling must be at least 1.");
 
-    Map<MatrixXf, 0, InnerStride<3>> albedoR((float*)&albedo.data()->r(), nbPixels, 1);
-    Map<MatrixXf, 0, InnerStride<3>> albedoG((float*)&albedo.data()->g(), nbPixels, 1);
-    Map<MatrixXf, 0, InnerStride<3>> albedoB((float*)&albedo.data()->b(), nbPixels, 1);
+    // the blocks of rows are accumulated in parallel, then summed in order
+    // so that the result does not depend on the number of threads
+    const int blockHeight = blockRows * subsampling;
+    const int nbBlocks = (albedo.Height() + blockHeight - 1) / blockHeight;
 
-    Map<MatrixXf, 0, InnerStride<3>> pictureR((float*)&picture.data()->r(), nbPixels, 1);
-    Map<MatrixXf, 0, InnerStride<3>> pictureG((float*)&picture.data()->g(), nbPixels, 1);
-    Map<MatrixXf, 0, InnerStride<3>> pictureB((float*)&picture.data()->b(), nbPixels, 1);
+    std::vector<NormalEquations> blocksEquations(nbBlocks);
 
-    Eigen::Matrix<float, 9, 1> lightingR;
-    Eigen::Matrix<float, 9, 1> lightingG;
-    Eigen::Matrix<float, 9, 1> lightingB;
-
-    // Augmented normales
-    image::Image<AugmentedNormal> augNormals(normals.cast<AugmentedNormal>());
+    #pragma omp parallel for schedule(dynamic)
+    for(int b = 0; b < nbBlocks; ++b)
+    {
+        const int yBegin = b * blockHeight;
+        const int yEnd = std::min(yBegin + blockHeight, albedo.Height());
+        accumulateRows(blocksEquations[b], yBegin, yEnd, subsampling, albedo, picture, normals);
+    }
 
-    // EstimateLightingOneChannel
-    estimateLigthingOneChannel(lightingR, albedoR, pictureR, augNormals);
-    estimateLigthingOneChannel(lightingG, albedoG, pictureG, augNormals);
-    estimateLigthingOneChannel(lightingB, albedoB, pictureB, augNormals);
+    NormalEquations equations;
+    for(const NormalEquations& blockEquations : blocksEquations)
+        equations += blockEquations;
 
-    // lighting vectors fusion
-    lighting.col(0) = lightingR;
-    lighting.col(1) = lightingG;
-    lighting.col(2) = lightingB;
+    // Resolve lighting estimation problem for each channel
+    for(int c = 0; c < 3; ++c)
+    {
+        const Eigen::Matrix<double, 9, 9> AtA = equations.AtA[c].selfadjointView<Eigen::Lower>();
+        const Eigen::Matrix<double, 9, 1> lightingChannel = AtA.colPivHouseholderQr().solve(equations.Atb[c]);
+        lighting.col(c) = lightingChannel.cast<float>();
+    }
 }
 
 
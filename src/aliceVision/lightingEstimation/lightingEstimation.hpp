@@ -29,8 +29,13 @@ using LightingVector = Eigen::Matrix<float, 9, 3>;
 
 /**
  * @brief Lighting estimation from picture, albedo and geometry
+ * @param[out] lighting The estimated lighting
+ * @param[in] albedo The albedo map
+ * @param[in] picture The picture, with the size of the albedo map
+ * @param[in] normals The normal map, with the size of the albedo map
+ * @param[in] subsampling Only use one pixel out of subsampling in each direction of the maps
  */ 
-void estimateLigthing(LightingVector& lighting, const image::Image<image::RGBfColor>& albedo, const image::Image<image::RGBfColor>& picture, const image::Image<image::RGBfColor>& normals);
+void estimateLigthing(LightingVector& lighting, const image::Image<image::RGBfColor>& albedo, const image::Image<image::RGBfColor>& picture, const image::Image<image::RGBfColor>& normals, int subsampling = 1);
 
 
 }
@@ -124,5 +124,50 @@ BOOST_AUTO_TEST_CASE(LIGHTING_ESTIMATION_Lambertian_noise)
 }
 
 
+BOOST_AUTO_TEST_CASE(LIGHTING_ESTIMATION_Lambertian_subsampling)
+{
+  const std::size_t sx = 201;
+  const std::size_t sy = 103;
+
+  // Random initialization of lighting, albedo and normals
+  LightingVector lightingSynt = MatrixXf::Random(9, 3).cwiseAbs();
+
+  Image<RGBfColor> albedoSynt(sy, sx);
+  Image<RGBfColor> normalsSynt(sy, sx);
+
+  for(std::size_t y = 0; y < sy; ++y)
+  {
+    for(std::size_t x = 0; x < sx; ++x)
+    {
+      albedoSynt(x, y) = RGBfColor(zeroOneRand(), zeroOneRand(), zeroOneRand());
+      RGBfColor n(zeroOneRand(), zeroOneRand(), std::abs(zeroOneRand()));
+      n.normalize();
+      normalsSynt(x, y) = n;
+    }
+  }
 
+  Image<AugmentedNormal> agmNormalsSynt(normalsSynt.cast<AugmentedNormal>());
 
+  // Create simulated image
+  Image<RGBfColor> pictureGenerated(sy, sx);
+
+  for(std::size_t y = 0; y < sy; ++y)
+  {
+    for(std::size_t x = 0; x < sx; ++x)
+    {
+      for(std::size_t ch = 0; ch < 3; ++ch)
+      {
+        pictureGenerated(x,y)(ch) = albedoSynt(x,y)(ch) * agmNormalsSynt(x,y).dot(lightingSynt.col(ch));
+      }
+    }
+  }
+
+  // Retrieve unknown lighting from one pixel out of 3 in each direction
+  LightingVector lightingEst;
+  estimateLigthing(lightingEst, albedoSynt, pictureGenerated, normalsSynt, 3);
+
+  const float epsilon = 1e-3f;
+  EXPECT_MATRIX_NEAR(lightingEst, lightingSynt, epsilon);
+
+  BOOST_CHECK_THROW(estimateLigthing(lightingEst, albedoSynt, pictureGenerated, normalsSynt, 0), std::invalid_argument);
+}
@@ -81,6 +81,8 @@ public:
 
   ISolver(int nbParams):_nbParams(nbParams){};
 
+  virtual ~ISolver() {}
+
   /// Setup constraint for the given library.
   virtual bool setup(const LPConstraints & constraints) = 0;
   virtual bool setup(const LPConstraintsSparse & constraints) = 0;
@@ -91,8 +93,13 @@ public:
   /// Get back solution. Call it after solve.
   virtual bool getSolution(std::vector<double> & estimatedParams) = 0;
 
+  /// Start the next solves from the previous optimal solution,
+  ///  for a sequence of problems with the same layout (if supported by the library).
+  void setWarmStart(bool warmStart) { _warmStart = warmStart; }
+
 protected :
   int _nbParams; // The number of parameter considered in constraint formulation.
+  bool _warmStart = false; // Start from the previous optimal solution.
 };
 
 } // namespace linearProgramming
@@ -18,7 +18,7 @@
 #include "aliceVision/linearProgramming/ISolver.hpp"
 
 #include "CoinPackedMatrix.hpp"
-#include "CoinPackedVector.hpp"
+#include "CoinWarmStartBasis.hpp"
 
 #include <vector>
 
@@ -46,7 +46,18 @@ public :
   bool getSolution(std::vector<double> & estimatedParams);
 
 private :
+
+  /// Load the packed constraints and the variables in the solver
+  bool loadProblem(const CoinPackedMatrix & matrix,
+                   const Vec & Cst_objective,
+                   const std::vector<LPConstraints::eLP_SIGN> & vec_sign,
+                   const std::vector< std::pair<double, double> > & vec_bounds,
+                   const std::vector<double> & vec_cost,
+                   bool bminimize);
+
   SOLVERINTERFACE *si;
+  /// Basis of the last optimal solution (used to warm start the next solve)
+  CoinWarmStart *_basis = nullptr;
 };
 
 
@@ -77,6 +88,8 @@ template<typename SOLVERINTERFACE>
 OSIXSolver<SOLVERINTERFACE>::~OSIXSolver()
 {
   // Memory cleaning.
+  delete _basis;
+  _basis = nullptr;
   if ( si != nullptr )
   {
     delete si;
@@ -87,194 +100,155 @@ OSIXSolver<SOLVERINTERFACE>::~OSIXSolver()
 template<typename SOLVERINTERFACE>
 bool OSIXSolver<SOLVERINTERFACE>::setup(const LPConstraints & cstraints) //cstraints <-> constraints
 {
-  bool bOk = true;
   if ( si == nullptr )
   {
     return false;
   }
   assert(_nbParams == cstraints._nbParams);
 
-  const unsigned int NUMVAR = cstraints._constraintMat.cols();
-  std::vector<double> col_lb(NUMVAR);//the column lower bounds
-  std::vector<double> col_ub(NUMVAR);//the column upper bounds
-
-  this->_nbParams = NUMVAR;
-
-  si->setObjSense( ((cstraints._bminimize) ? 1 : -1) );
-
   const Mat & A = cstraints._constraintMat;
 
-  //Equality constraint will be done by two constraints due to the API limitation ( >= & <=).
-  const size_t nbLine = A.rows() +
-    std::count(cstraints._vec_sign.begin(), cstraints._vec_sign.end(), LPConstraints::LP_EQUAL);
+  //-- Pack the non zero coefficients row by row
+  std::vector<double> vec_value;
+  std::vector<int> vec_colno;
+  std::vector<CoinBigIndex> vec_start(A.rows() + 1, 0);
+  std::vector<int> vec_length(A.rows(), 0);
 
-  std::vector<double> row_lb(nbLine);//the row lower bounds
-  std::vector<double> row_ub(nbLine);//the row upper bounds
-
-  CoinPackedMatrix * matrix = new CoinPackedMatrix(false,0,0);
-  matrix->setDimensions(0, NUMVAR);
-
-  //-- Add row-wise constraint
-  size_t indexRow = 0;
   for (int i=0; i < A.rows(); ++i)
   {
-    Vec temp = A.row(i);
-
-    CoinPackedVector row;
-    if ( cstraints._vec_sign[i] == LPConstraints::LP_EQUAL || cstraints._vec_sign[i] == LPConstraints::LP_LESS_OR_EQUAL )
-    {
-      int coef = 1;
-      for ( int j = 0; j < A.cols() ; j++ )
-      {
-        row.insert(j, coef * temp.data()[j]);
-      }
-      row_lb[indexRow] = -1.0 * si->getInfinity();
-      row_ub[indexRow] = coef * cstraints._Cst_objective(i);
-      matrix->appendRow(row);
-      indexRow++;
-    }
-    if ( cstraints._vec_sign[i] == LPConstraints::LP_EQUAL || cstraints._vec_sign[i] == LPConstraints::LP_GREATER_OR_EQUAL )
+    for ( int j = 0; j < A.cols() ; j++ )
     {
-      int coef = -1;
-      for ( int j = 0; j < A.cols() ; j++ )
+      if ( A(i,j) != 0.0 )
       {
-	      row.insert(j, coef * temp.data()[j]);
+        vec_colno.push_back(j);
+        vec_value.push_back(A(i,j));
       }
-      row_lb[indexRow] = -1.0 * si->getInfinity();
-      row_ub[indexRow] = coef * cstraints._Cst_objective(i);
-      matrix->appendRow(row);
-      indexRow++;
-    }
-  }
-
-  //-- Setup bounds for all the parameters
-  if (cstraints._vec_bounds.size() == 1)
-  {
-    // Setup the same bound for all the parameters
-    for (int i=0; i < this->_nbParams; ++i)
-    {
-      col_lb[i] = cstraints._vec_bounds[0].first;
-      col_ub[i] = cstraints._vec_bounds[0].second;
-    }
-  }
-  else // each parameter have it's own bounds
-  {
-    for (int i=0; i < this->_nbParams; ++i)
-    {
-      col_lb[i] = cstraints._vec_bounds[i].first;
-      col_ub[i] = cstraints._vec_bounds[i].second;
     }
+    vec_start[i+1] = vec_value.size();
+    vec_length[i] = vec_start[i+1] - vec_start[i];
   }
 
-  si->loadProblem(*matrix, &col_lb[0], &col_ub[0], cstraints._vec_cost.empty() ? nullptr : &cstraints._vec_cost[0], &row_lb[0], &row_ub[0] );
-
-  delete matrix;
+  const CoinPackedMatrix matrix(false, A.cols(), A.rows(), vec_value.size(),
+    vec_value.data(), vec_colno.data(), vec_start.data(), vec_length.data());
 
-  return bOk;
+  return loadProblem(matrix, cstraints._Cst_objective, cstraints._vec_sign,
+    cstraints._vec_bounds, cstraints._vec_cost, cstraints._bminimize);
 }
 
 template<typename SOLVERINTERFACE>
 bool OSIXSolver<SOLVERINTERFACE>::setup(const LPConstraintsSparse & cstraints) //cstraints <-> constraints
 {
-  bool bOk = true;
   if ( si == nullptr )
   {
     return false;
   }
   assert(_nbParams == cstraints._nbParams);
 
-  const int NUMVAR = cstraints._constraintMat.cols();
-  std::vector<double> col_lb(NUMVAR);//the column lower bounds
-  std::vector<double> col_ub(NUMVAR);//the column upper bounds
-
-  this->_nbParams = NUMVAR;
-
-  si->setObjSense( ((cstraints._bminimize) ? 1 : -1) );
-
   const sRMat & A = cstraints._constraintMat;
 
-  //Equality constraint will be done by two constraints due to the API limitation (>= & <=)
-  const size_t nbLine = A.rows() +
-    std::count(cstraints._vec_sign.begin(), cstraints._vec_sign.end(), LPConstraints::LP_EQUAL);
+  //-- Pack the sparse rows, without any copy by row
+  std::vector<double> vec_value;
+  std::vector<int> vec_colno;
+  std::vector<CoinBigIndex> vec_start(A.rows() + 1, 0);
+  std::vector<int> vec_length(A.rows(), 0);
 
-  std::vector<double> row_lb(nbLine);//the row lower bounds
-  std::vector<double> row_ub(nbLine);//the row upper bounds
+  vec_value.reserve(A.nonZeros());
+  vec_colno.reserve(A.nonZeros());
 
-  CoinPackedMatrix * matrix = new CoinPackedMatrix(false,0,0);
-  matrix->setDimensions(0, NUMVAR);
-
-  //-- Add row-wise constraint
-  size_t rowindex = 0;
   for (int i=0; i < A.rows(); ++i)
   {
-    std::vector<int> vec_colno;
-    std::vector<double> vec_value;
     for (sRMat::InnerIterator it(A,i); it; ++it)
     {
       vec_colno.push_back(it.col());
       vec_value.push_back(it.value());
     }
+    vec_start[i+1] = vec_value.size();
+    vec_length[i] = vec_start[i+1] - vec_start[i];
+  }
 
+  const CoinPackedMatrix matrix(false, A.cols(), A.rows(), vec_value.size(),
+    vec_value.data(), vec_colno.data(), vec_start.data(), vec_length.data());
 
-    if ( cstraints._vec_sign[i] == LPConstraints::LP_EQUAL || cstraints._vec_sign[i] == LPConstraints::LP_LESS_OR_EQUAL )
-    {
-      int coef = 1;
-      row_lb[rowindex] = -1.0 * si->getInfinity();
-      row_ub[rowindex] = coef * cstraints._Cst_objective(i);
-      matrix->appendRow( vec_colno.size(),
-	                 &vec_colno[0],
-	                 &vec_value[0] );
-      rowindex++;
-    }
+  return loadProblem(matrix, cstraints._Cst_objective, cstraints._vec_sign,
+    cstraints._vec_bounds, cstraints._vec_cost, cstraints._bminimize);
+}
+
+template<typename SOLVERINTERFACE>
+bool OSIXSolver<SOLVERINTERFACE>::loadProblem(
+  const CoinPackedMatrix & matrix,
+  const Vec & Cst_objective,
+  const std::vector<LPConstraints::eLP_SIGN> & vec_sign,
+  const std::vector< std::pair<double, double> > & vec_bounds,
+  const std::vector<double> & vec_cost,
+  bool bminimize)
+{
+  const int NUMVAR = matrix.getNumCols();
+  const int NUMROW = matrix.getNumRows();
+
+  this->_nbParams = NUMVAR;
 
-    if ( cstraints._vec_sign[i] == LPConstraints::LP_EQUAL || cstraints._vec_sign[i] == LPConstraints::LP_GREATER_OR_EQUAL )
+  si->setObjSense( ((bminimize) ? 1 : -1) );
+
+  //-- Row bounds: the constraint signs are given by the row bounds,
+  // the rows are neither duplicated nor negated
+  const double infinity = si->getInfinity();
+  std::vector<double> row_lb(NUMROW);//the row lower bounds
+  std::vector<double> row_ub(NUMROW);//the row upper bounds
+
+  for (int i=0; i < NUMROW; ++i)
+  {
+    switch (vec_sign[i])
     {
-      int coef = -1;
-      for ( std::vector<double>::iterator iter_val = vec_value.begin();
-	      iter_val != vec_value.end();
-	      iter_val++)
-      {
-  	    *iter_val *= coef;
-      }
-      row_lb[rowindex] = -1.0 * si->getInfinity();
-      row_ub[rowindex] = coef * cstraints._Cst_objective(i);
-      matrix->appendRow( vec_colno.size(),
-	                 &vec_colno[0],
-	                 &vec_value[0] );
-      rowindex++;
+      case LPConstraints::LP_LESS_OR_EQUAL:
+        row_lb[i] = -infinity;
+        row_ub[i] = Cst_objective(i);
+        break;
+      case LPConstraints::LP_GREATER_OR_EQUAL:
+        row_lb[i] = Cst_objective(i);
+        row_ub[i] = infinity;
+        break;
+      case LPConstraints::LP_EQUAL:
+        row_lb[i] = Cst_objective(i);
+        row_ub[i] = Cst_objective(i);
+        break;
+      case LPConstraints::LP_FREE:
+        row_lb[i] = -infinity;
+        row_ub[i] = infinity;
+        break;
     }
   }
 
   //-- Setup bounds for all the parameters
-  if (cstraints._vec_bounds.size() == 1)
+  std::vector<double> col_lb(NUMVAR);//the column lower bounds
+  std::vector<double> col_ub(NUMVAR);//the column upper bounds
+
+  if (vec_bounds.size() == 1)
   {
     // Setup the same bound for all the parameters
-    for (int i=0; i < this->_nbParams; ++i)
+    for (int i=0; i < NUMVAR; ++i)
     {
-      col_lb[i] = cstraints._vec_bounds[0].first;
-      col_ub[i] = cstraints._vec_bounds[0].second;
+      col_lb[i] = vec_bounds[0].first;
+      col_ub[i] = vec_bounds[0].second;
     }
   }
-  else  // each parameter have it's own bounds
+  else // each parameter have it's own bounds
   {
-    for (int i=0; i < this->_nbParams; ++i)
+    for (int i=0; i < NUMVAR; ++i)
     {
-      col_lb[i] = cstraints._vec_bounds[i].first;
-      col_ub[i] = cstraints._vec_bounds[i].second;
+      col_lb[i] = vec_bounds[i].first;
+      col_ub[i] = vec_bounds[i].second;
     }
   }
 
   si->loadProblem(
-    *matrix,
-    &col_lb[0],
-    &col_ub[0],
-    cstraints._vec_cost.empty() ? nullptr : &cstraints._vec_cost[0],
-    &row_lb[0],
-    &row_ub[0]);
-
-  delete matrix;
-
-  return bOk;
+    matrix,
+    col_lb.data(),
+    col_ub.data(),
+    vec_cost.empty() ? nullptr : vec_cost.data(),
+    row_lb.data(),
+    row_ub.data());
+
+  return true;
 }
 
 template<typename SOLVERINTERFACE>
@@ -284,8 +258,28 @@ bool OSIXSolver<SOLVERINTERFACE>::solve()
   if ( si != nullptr )
   {
     si->getModelPtr()->setPerturbation(50);
-    si->initialSolve();
-    return si->isProvenOptimal();
+
+    // restart from the previous basis if the new problem has the same layout
+    const CoinWarmStartBasis * basis = dynamic_cast<const CoinWarmStartBasis *>(_basis);
+    if ( _warmStart && basis != nullptr &&
+         basis->getNumStructural() == si->getNumCols() &&
+         basis->getNumArtificial() == si->getNumRows() &&
+         si->setWarmStart(basis) )
+    {
+      si->resolve();
+    }
+    else
+    {
+      si->initialSolve();
+    }
+
+    const bool bOptimal = si->isProvenOptimal();
+    if ( _warmStart && bOptimal )
+    {
+      delete _basis;
+      _basis = si->getWarmStart();
+    }
+    return bOptimal;
   }
   return false;
 }
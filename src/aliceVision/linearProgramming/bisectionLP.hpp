@@ -22,6 +22,8 @@ namespace linearProgramming  {
 /// http://en.wikipedia.org/wiki/Bisection_method
 /// The bisection algorithm continue as long as
 ///  precision or max iteration number is not reach.
+/// The problems of the iterations have the same layout,
+///  each one is warm started from the last feasible solution.
 ///
 template <typename ConstraintBuilder, typename ConstraintType>
 bool BisectionLP(
@@ -38,6 +40,7 @@ bool BisectionLP(
   int k = 0;
   bool bModelFound = false;
   ConstraintType constraint;
+  solver.setWarmStart(true);
   do
   {
     ++k; // One more iteration
@@ -73,6 +76,8 @@ bool BisectionLP(
     }
   } while (k < maxIteration && gammaUp - gammaLow > eps);
 
+  solver.setWarmStart(false);
+
   return bModelFound;
 }
 
@@ -5,6 +5,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "CCTagLocalizer.hpp"
+#include "LocalizationDatabase.hpp"
 #include "reconstructed_regions.hpp"
 #include "optimization.hpp"
 #include "rigResection.hpp"
@@ -18,6 +19,7 @@
 
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <cctag/ICCTag.hpp>
 
@@ -31,12 +33,16 @@ namespace aliceVision {
 namespace localization {
 
 CCTagLocalizer::CCTagLocalizer(const sfmData::SfMData &sfmData,
-                               const std::string &descriptorsFolder)
+                               const std::string &descriptorsFolder,
+                               const std::string &localizationDatabaseFolder)
     : _cudaPipe( 0 )
 {
   _sfm_data = sfmData;
 
-  bool loadSuccessful = loadReconstructionDescriptors(_sfm_data, descriptorsFolder);
+  // the CCTag descriptors are accessed as a vector: copy them from the localization database
+  bool loadSuccessful = localizationDatabaseFolder.empty() ?
+        loadReconstructionDescriptors(_sfm_data, descriptorsFolder) :
+        loadLocalizationDatabase(localizationDatabaseFolder, {_imageDescriber.getDescriberType()}, false, _regionsPerView, _reconstructedRegionsMappingPerView);
   
   if(!loadSuccessful)
   {
@@ -65,9 +71,74 @@ CCTagLocalizer::CCTagLocalizer(const sfmData::SfMData &sfmData,
 //    }
 //  }
   
+  buildCCTagIndex();
+
   _isInit = true;
 }
 
+void CCTagLocalizer::buildCCTagIndex()
+{
+  _cctagIndexPerView.clear();
+
+  for(const auto& viewRegions : _regionsPerView.getData())
+  {
+    CCTagViewIndex& viewIndex = _cctagIndexPerView[viewRegions.first];
+    viewIndex.regionPerCCTagId.fill(UndefinedIndexT);
+
+    const auto regionsIt = viewRegions.second.find(_cctagDescType);
+    if(regionsIt == viewRegions.second.end())
+      continue;
+
+    const feature::CCTAG_Regions& regions = dynamic_cast<const feature::CCTAG_Regions&>(*regionsIt->second);
+    for(std::size_t j = 0; j < regions.Descriptors().size(); ++j)
+    {
+      const IndexT cctagId = feature::getCCTagId(regions.Descriptors()[j]);
+
+      // keep the first region of each marker, as viewMatching
+      if(cctagId >= viewIndex.regionPerCCTagId.size() || viewIndex.regionPerCCTagId[cctagId] != UndefinedIndexT)
+        continue;
+
+      viewIndex.regionPerCCTagId[cctagId] = j;
+      viewIndex.viewDescriptor.set(cctagId, true);
+    }
+  }
+  ALICEVISION_LOG_DEBUG("Reconstructed CCTags indexed for " << _cctagIndexPerView.size() << " views");
+}
+
+void CCTagLocalizer::kNearestKeyFrames(const std::bitset<128>& queryViewDescriptor,
+                                       std::size_t nNearestKeyFrames,
+                                       std::vector<IndexT>& out_kNearestFrames) const
+{
+  out_kNearestFrames.clear();
+
+  // only the keyframes having at least a marker in common with the query
+  const std::size_t similarityThreshold = 1;
+
+  // A std::multimap is used instead of a std::map because is very likely that the
+  // similarity measure is equal for a subset of views in the CCTag regions case.
+  std::multimap<std::size_t, IndexT> sortedViewSimilarities;
+
+  for(const auto& viewIndex : _cctagIndexPerView)
+  {
+    // The similarity is the sum of all the cctags sharing the same id visible in both views.
+    sortedViewSimilarities.emplace((queryViewDescriptor & viewIndex.second.viewDescriptor).count(), viewIndex.first);
+  }
+
+  out_kNearestFrames.reserve(nNearestKeyFrames);
+  for(auto rit = sortedViewSimilarities.crbegin(); rit != sortedViewSimilarities.crend(); ++rit)
+  {
+    if(rit->first < similarityThreshold)
+      // since it is ordered, the first having smaller similarity guarantees that
+      // there won't be other useful kframes
+      break;
+
+    out_kNearestFrames.push_back(rit->second);
+
+    if(out_kNearestFrames.size() == nNearestKeyFrames)
+      break;
+  }
+}
+
 
 bool CCTagLocalizer::loadReconstructionDescriptors(const sfmData::SfMData & sfm_data,
                                                    const std::string & feat_directory)
@@ -405,21 +476,25 @@ bool CCTagLocalizer::localizeRig(const std::vector<image::Image<float>> & vec_im
   assert(numCams == vec_subPoses.size() + 1);
 
   std::vector<feature::MapRegionsPerDesc> vec_queryRegions(numCams);
-  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize;
+  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize(numCams);
   
-  //@todo parallelize?
-  for(size_t i = 0; i < numCams; ++i)
+  // extract the features of all the cameras at the same time, each camera has
+  // its own image describer and CUDA pipe
+#pragma omp parallel for
+  for(int i = 0; i < numCams; ++i)
   {
     image::Image<unsigned char> imageGrayUChar; // cctag image describer don't support float image
     imageGrayUChar = (vec_imageGrey.at(i).GetMat() * 255.f).cast<unsigned char>();
 
     // extract descriptors and features from each image
     ALICEVISION_LOG_DEBUG("[features]\tExtract CCTag from query image...");
-    _imageDescriber.setConfigurationPreset(param->_featurePreset);
-    _imageDescriber.describe(imageGrayUChar, vec_queryRegions[i][_imageDescriber.getDescriberType()]);
-    ALICEVISION_LOG_DEBUG("[features]\tExtract CCTAG done: found " <<  vec_queryRegions[i].at(_imageDescriber.getDescriberType())->RegionCount() << " features");
+    feature::ImageDescriber_CCTAG imageDescriber;
+    imageDescriber.setCudaPipe(_cudaPipe + i);
+    imageDescriber.setConfigurationPreset(param->_featurePreset);
+    imageDescriber.describe(imageGrayUChar, vec_queryRegions[i][imageDescriber.getDescriberType()]);
+    ALICEVISION_LOG_DEBUG("[features]\tExtract CCTAG done: found " <<  vec_queryRegions[i].at(imageDescriber.getDescriberType())->RegionCount() << " features");
     // add the image size for this image
-    vec_imageSize.emplace_back(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
+    vec_imageSize[i] = std::make_pair(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
   }
   assert(vec_imageSize.size() == vec_queryRegions.size());
           
@@ -497,10 +572,10 @@ bool CCTagLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsPer
   std::vector<Mat> vec_pts2D(numCams);
   std::vector<std::vector<voctree::DocMatch> > vec_matchedImages(numCams);
 
-  // for each camera retrieve the associations
-  //@todo parallelize?
+  // for each camera retrieve the associations, all the cameras at the same time
   size_t numAssociations = 0;
-  for( size_t i = 0; i < numCams; ++i )
+#pragma omp parallel for reduction(+:numAssociations)
+  for(int i = 0; i < numCams; ++i)
   {
     // this map is used to collect the 2d-3d associations as we go through the images
     // the key is a pair <Id3D, Id2d>
@@ -676,10 +751,10 @@ bool CCTagLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPerD
 
   vec_localizationResults.resize(numCams);
     
-  // this is basic, just localize each camera alone
-  //@todo parallelize?
-  std::vector<bool> isLocalized(numCams, false);
-  for(size_t i = 0; i < numCams; ++i)
+  // this is basic, just localize each camera alone, all the cameras at the same time
+  std::vector<char> isLocalized(numCams, false);
+#pragma omp parallel for
+  for(int i = 0; i < numCams; ++i)
   {
     isLocalized[i] = localize(vec_queryRegions[i], imageSize[i], param, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
     if(!isLocalized[i])
@@ -766,12 +841,16 @@ void CCTagLocalizer::getAllAssociations(const feature::CCTAG_Regions &queryRegio
                                         std::vector<voctree::DocMatch>& out_matchedImages,
                                         const std::string& imagePath) const
 {
+  // the marker id of each query region
+  std::vector<IndexT> queryCCTagIds;
+  queryCCTagIds.reserve(queryRegions.Descriptors().size());
+  for(const auto& descriptor : queryRegions.Descriptors())
+    queryCCTagIds.push_back(feature::getCCTagId(descriptor));
+
   std::vector<IndexT> nearestKeyFrames;
   nearestKeyFrames.reserve(param._nNearestKeyFrames);
   
-  kNearestKeyFrames(queryRegions,
-                    _cctagDescType,
-                    _regionsPerView,
+  kNearestKeyFrames(constructCCTagViewDescriptor(queryRegions.Descriptors()),
                     param._nNearestKeyFrames,
                     nearestKeyFrames);
   
@@ -783,13 +862,17 @@ void CCTagLocalizer::getAllAssociations(const feature::CCTAG_Regions &queryRegio
   {
     ALICEVISION_LOG_DEBUG(keyframeId);
     ALICEVISION_LOG_DEBUG(_sfm_data.getViews().at(keyframeId)->getImagePath());
-    const feature::Regions& matchedRegions = _regionsPerView.getRegions(keyframeId, _cctagDescType);
     const ReconstructedRegionsMapping& regionsMapping = _reconstructedRegionsMappingPerView.at(keyframeId).at(_cctagDescType);
-    const feature::CCTAG_Regions & matchedCCtagRegions = dynamic_cast<const feature::CCTAG_Regions &>(matchedRegions);
+    const CCTagViewIndex& viewIndex = _cctagIndexPerView.at(keyframeId);
 
-    // Matching
+    // Matching: the region of the keyframe with the same marker id as the query region
     std::vector<matching::IndMatch> vec_featureMatches;
-    viewMatching(queryRegions, matchedCCtagRegions, vec_featureMatches);
+    for(std::size_t i = 0; i < queryCCTagIds.size(); ++i)
+    {
+      const IndexT cctagId = queryCCTagIds[i];
+      if(cctagId < viewIndex.regionPerCCTagId.size() && viewIndex.regionPerCCTagId[cctagId] != UndefinedIndexT)
+        vec_featureMatches.emplace_back(i, viewIndex.regionPerCCTagId[cctagId]);
+    }
     ALICEVISION_LOG_DEBUG("[matching]\tFound "<< vec_featureMatches.size() <<" matches.");
     
     out_matchedImages.emplace_back(keyframeId, vec_featureMatches.size());
@@ -797,6 +880,7 @@ void CCTagLocalizer::getAllAssociations(const feature::CCTAG_Regions &queryRegio
     if(!param._visualDebug.empty() && !imagePath.empty())
     {
       namespace bfs = boost::filesystem;
+      const feature::CCTAG_Regions& matchedCCtagRegions = dynamic_cast<const feature::CCTAG_Regions&>(_regionsPerView.getRegions(keyframeId, _cctagDescType));
       const sfmData::View *mview = _sfm_data.getViews().at(keyframeId).get();
       const std::string queryImage = bfs::path(imagePath).stem().string();
       const std::string matchedImage = bfs::path(mview->getImagePath()).stem().string();
@@ -17,8 +17,10 @@
 #include <aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp>
 #include <aliceVision/voctree/Database.hpp>
 
+#include <array>
 #include <iostream>
 #include <bitset>
+#include <map>
 
 namespace aliceVision {
 namespace localization {
@@ -42,8 +44,15 @@ class CCTagLocalizer : public ILocalizer
   
 public:
   
+  /**
+   * @param[in] sfmData The sfmdata containing the scene reconstruction.
+   * @param[in] descriptorsFolder The path to the directory containing the features of the scene.
+   * @param[in] localizationDatabaseFolder Optional path to a localization database, if provided
+   * the reconstructed regions are loaded from it instead of the features of the scene.
+   */
   CCTagLocalizer(const sfmData::SfMData &sfmData,
-                 const std::string &descriptorsFolder);
+                 const std::string &descriptorsFolder,
+                 const std::string &localizationDatabaseFolder = std::string());
    
   void setCudaPipe(int i) override;
 
@@ -153,11 +162,41 @@ private:
   bool loadReconstructionDescriptors(
     const sfmData::SfMData & sfm_data,
     const std::string & feat_directory);
+
+  /**
+   * @brief The reconstructed CCTag regions of a view indexed by marker id
+   */
+  struct CCTagViewIndex
+  {
+    /// the markers seen by the view, @see constructCCTagViewDescriptor
+    std::bitset<128> viewDescriptor;
+    /// the reconstructed region of each marker id, UndefinedIndexT if the marker is not seen
+    std::array<IndexT, 128> regionPerCCTagId;
+  };
+
+  /**
+   * @brief Index the reconstructed regions of each view by marker id, once the
+   * reconstructed regions are loaded.
+   */
+  void buildCCTagIndex();
+
+  /**
+   * @brief Retrieve the k nearest views of the query, the views sharing the most markers with it.
+   * @param[in] queryViewDescriptor The markers seen by the query, @see constructCCTagViewDescriptor
+   * @param[in] nNearestKeyFrames Number of nearest neighbours to return.
+   * @param[out] out_kNearestFrames Set of computed indices associated to the k nearest views.
+   * @see kNearestKeyFrames
+   */
+  void kNearestKeyFrames(const std::bitset<128>& queryViewDescriptor,
+                         std::size_t nNearestKeyFrames,
+                         std::vector<IndexT>& out_kNearestFrames) const;
   
   // for each view index, it contains the cctag features and descriptors that have an
   // associated 3D point
   feature::RegionsPerView _regionsPerView;
   ReconstructedRegionsMappingPerView _reconstructedRegionsMappingPerView;
+  /// for each view index, its reconstructed cctag regions indexed by marker id
+  std::map<IndexT, CCTagViewIndex> _cctagIndexPerView;
 
   // the feature extractor
   feature::ImageDescriber_CCTAG _imageDescriber;
@@ -0,0 +1,305 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationDatabase.hpp"
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+
+namespace fs = boost::filesystem;
+namespace bi = boost::interprocess;
+
+namespace aliceVision {
+namespace localization {
+
+namespace {
+
+const char databaseMagic[8] = {'A', 'V', 'L', 'O', 'C', 'D', 'B', '\0'};
+const std::uint32_t databaseVersion = 1;
+
+const std::size_t headerSize = sizeof(databaseMagic) + 2 * sizeof(std::uint32_t);
+const std::size_t recordHeaderSize = 4 * sizeof(std::uint32_t);
+
+/**
+ * @brief A (view, describer type) record of the reconstructed regions index
+ */
+struct RegionsRecord
+{
+  IndexT viewId;
+  feature::EImageDescriberType descType;
+  std::uint32_t nbRegions;
+  std::uint32_t nbMappingEntries;
+  /// associated landmark ids, then mapping entries, in the mapped index
+  const char* data;
+};
+
+template<typename T>
+inline void writeValue(std::ostream& stream, const T& value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+inline T readValue(const char* data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+std::string getRegionsFilename(const std::string& folder, IndexT viewId, feature::EImageDescriberType descType)
+{
+  return (fs::path(folder) / (std::to_string(viewId) + "." + feature::EImageDescriberType_enumToString(descType) + ".regions")).string();
+}
+
+} // namespace
+
+const std::string& getLocalizationDatabaseIndexFilename()
+{
+  static const std::string filename = "reconstructedRegions.bin";
+  return filename;
+}
+
+const std::string& getLocalizationDatabaseDocumentsFilename()
+{
+  static const std::string filename = "documents.db";
+  return filename;
+}
+
+bool isLocalizationDatabase(const std::string& folder)
+{
+  return !folder.empty() && fs::exists(fs::path(folder) / getLocalizationDatabaseIndexFilename());
+}
+
+void saveLocalizationDatabase(const std::string& folder,
+                              const feature::RegionsPerView& regionsPerView,
+                              const ReconstructedRegionsMappingPerView& mappingPerView)
+{
+  if(!fs::exists(folder))
+    fs::create_directories(folder);
+
+  const std::string indexFilename = (fs::path(folder) / getLocalizationDatabaseIndexFilename()).string();
+  std::ofstream stream(indexFilename, std::ios::out | std::ios::binary);
+
+  if(!stream.is_open())
+    throw std::runtime_error("Can't save the localization database, can't open '" + indexFilename + "' !");
+
+  std::uint32_t nbRecords = 0;
+  for(const auto& viewRegions : regionsPerView.getData())
+    nbRecords += viewRegions.second.size();
+
+  stream.write(databaseMagic, sizeof(databaseMagic));
+  writeValue(stream, databaseVersion);
+  writeValue(stream, nbRecords);
+
+  for(const auto& viewRegions : regionsPerView.getData())
+  {
+    const IndexT viewId = viewRegions.first;
+
+    for(const auto& regionsPerDesc : viewRegions.second)
+    {
+      const feature::EImageDescriberType descType = regionsPerDesc.first;
+      const feature::Regions& regions = *regionsPerDesc.second;
+
+      // views without reconstructed regions of this type have an empty mapping
+      static const ReconstructedRegionsMapping emptyMapping;
+      const ReconstructedRegionsMapping* mapping = &emptyMapping;
+      const auto mappingViewIt = mappingPerView.find(viewId);
+      if(mappingViewIt != mappingPerView.end())
+      {
+        const auto mappingIt = mappingViewIt->second.find(descType);
+        if(mappingIt != mappingViewIt->second.end())
+          mapping = &mappingIt->second;
+      }
+
+      if(mapping->_associated3dPoint.size() != regions.RegionCount())
+        throw std::runtime_error("Can't save the localization database, the regions of view " + std::to_string(viewId) + " don't match their landmarks !");
+
+      writeValue(stream, static_cast<std::uint32_t>(viewId));
+      writeValue(stream, static_cast<std::int32_t>(descType));
+      writeValue(stream, static_cast<std::uint32_t>(regions.RegionCount()));
+      writeValue(stream, static_cast<std::uint32_t>(mapping->_mapFullToLocal.size()));
+
+      for(const IndexT landmarkId : mapping->_associated3dPoint)
+        writeValue(stream, static_cast<std::uint32_t>(landmarkId));
+
+      for(const auto& entry : mapping->_mapFullToLocal)
+      {
+        writeValue(stream, static_cast<std::uint32_t>(entry.first));
+        writeValue(stream, static_cast<std::uint32_t>(entry.second));
+      }
+
+      regions.SaveContainer(getRegionsFilename(folder, viewId, descType));
+    }
+  }
+
+  if(!stream.good())
+    throw std::runtime_error("Can't save the localization database, '" + indexFilename + "' is incorrect !");
+
+  ALICEVISION_LOG_INFO("Localization database saved in '" << folder << "': " << nbRecords << " reconstructed regions.");
+}
+
+bool loadLocalizationDatabase(const std::string& folder,
+                              const std::vector<feature::EImageDescriberType>& descTypes,
+                              bool mapDescriptors,
+                              feature::RegionsPerView& regionsPerView,
+                              ReconstructedRegionsMappingPerView& mappingPerView)
+{
+  const std::string indexFilename = (fs::path(folder) / getLocalizationDatabaseIndexFilename()).string();
+
+  bi::file_mapping file;
+  bi::mapped_region region;
+  try
+  {
+    file = bi::file_mapping(indexFilename.c_str(), bi::read_only);
+    region = bi::mapped_region(file, bi::read_only);
+  }
+  catch(const bi::interprocess_exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Cannot map the localization database index: " << indexFilename << std::endl << e.what());
+    return false;
+  }
+
+  const char* data = static_cast<const char*>(region.get_address());
+  const char* end = data + region.get_size();
+
+  if(region.get_size() < headerSize || !std::equal(databaseMagic, databaseMagic + sizeof(databaseMagic), data))
+  {
+    ALICEVISION_LOG_ERROR("Invalid localization database index: " << indexFilename);
+    return false;
+  }
+
+  const std::uint32_t version = readValue<std::uint32_t>(data + sizeof(databaseMagic));
+  if(version != databaseVersion)
+  {
+    ALICEVISION_LOG_ERROR("Unsupported localization database version " << version << ": " << indexFilename);
+    return false;
+  }
+
+  const std::uint32_t nbRecords = readValue<std::uint32_t>(data + sizeof(databaseMagic) + sizeof(std::uint32_t));
+
+  // index of the records of the requested describer types
+  std::vector<RegionsRecord> records;
+  records.reserve(nbRecords);
+
+  const char* recordData = data + headerSize;
+  for(std::uint32_t i = 0; i < nbRecords; ++i)
+  {
+    if(static_cast<std::size_t>(end - recordData) < recordHeaderSize)
+    {
+      ALICEVISION_LOG_ERROR("Truncated localization database index: " << indexFilename);
+      return false;
+    }
+
+    RegionsRecord record;
+    record.viewId = readValue<std::uint32_t>(recordData);
+    record.descType = static_cast<feature::EImageDescriberType>(readValue<std::int32_t>(recordData + sizeof(std::uint32_t)));
+    record.nbRegions = readValue<std::uint32_t>(recordData + 2 * sizeof(std::uint32_t));
+    record.nbMappingEntries = readValue<std::uint32_t>(recordData + 3 * sizeof(std::uint32_t));
+    record.data = recordData + recordHeaderSize;
+
+    const std::size_t recordSize = (std::size_t(record.nbRegions) + 2 * std::size_t(record.nbMappingEntries)) * sizeof(std::uint32_t);
+    if(static_cast<std::size_t>(end - record.data) < recordSize)
+    {
+      ALICEVISION_LOG_ERROR("Truncated localization database index: " << indexFilename);
+      return false;
+    }
+    recordData = record.data + recordSize;
+
+    if(std::find(descTypes.begin(), descTypes.end(), record.descType) != descTypes.end())
+      records.push_back(record);
+  }
+
+  // one image describer per describer type to allocate the regions
+  std::map<feature::EImageDescriberType, std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+  for(const RegionsRecord& record : records)
+  {
+    if(imageDescribers.count(record.descType) == 0)
+      imageDescribers[record.descType] = feature::createImageDescriber(record.descType);
+  }
+
+  // insert all the records first, then fill them in parallel
+  std::vector<std::unique_ptr<feature::Regions>*> recordsRegions(records.size());
+  std::vector<ReconstructedRegionsMapping*> recordsMappings(records.size());
+  for(std::size_t i = 0; i < records.size(); ++i)
+  {
+    const RegionsRecord& record = records[i];
+    recordsRegions[i] = &regionsPerView.getData()[record.viewId][record.descType];
+    recordsMappings[i] = &mappingPerView[record.viewId][record.descType];
+  }
+
+  bool loaded = true;
+
+#pragma omp parallel for
+  for(int i = 0; i < records.size(); ++i)
+  {
+    const RegionsRecord& record = records[i];
+    const std::string regionsFilename = getRegionsFilename(folder, record.viewId, record.descType);
+
+    std::unique_ptr<feature::Regions>& regions = *recordsRegions[i];
+    imageDescribers.at(record.descType)->allocate(regions);
+
+    try
+    {
+      if(mapDescriptors)
+        regions->MapContainer(regionsFilename);
+      else
+        regions->LoadContainer(regionsFilename);
+    }
+    catch(const std::exception& e)
+    {
+#pragma omp critical
+      {
+        ALICEVISION_LOG_ERROR(e.what());
+        loaded = false;
+      }
+      continue;
+    }
+
+    if(regions->RegionCount() != record.nbRegions)
+    {
+#pragma omp critical
+      {
+        ALICEVISION_LOG_ERROR("The regions of view " << record.viewId << " don't match the localization database index: " << regionsFilename);
+        loaded = false;
+      }
+      continue;
+    }
+
+    ReconstructedRegionsMapping& mapping = *recordsMappings[i];
+    mapping._associated3dPoint.resize(record.nbRegions);
+    if(record.nbRegions > 0)
+      std::memcpy(mapping._associated3dPoint.data(), record.data, record.nbRegions * sizeof(std::uint32_t));
+
+    // the entries are sorted by full feature index
+    const char* entryData = record.data + record.nbRegions * sizeof(std::uint32_t);
+    for(std::uint32_t e = 0; e < record.nbMappingEntries; ++e, entryData += 2 * sizeof(std::uint32_t))
+    {
+      mapping._mapFullToLocal.emplace_hint(mapping._mapFullToLocal.end(),
+                                           readValue<std::uint32_t>(entryData),
+                                           readValue<std::uint32_t>(entryData + sizeof(std::uint32_t)));
+    }
+  }
+
+  if(loaded)
+    ALICEVISION_LOG_INFO("Localization database loaded from '" << folder << "': " << records.size() << " reconstructed regions.");
+
+  return loaded;
+}
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,73 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/localization/reconstructed_regions.hpp>
+
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+// Localization database folder, prebuilt from a reconstruction for the localizers:
+// -- reconstructedRegions.bin
+// magic "AVLOCDB" (8 bytes), version (uint32), #records (uint32)
+// per record (view, describer type):
+//   viewId (uint32) descType (int32) #regions (uint32) #mapping entries (uint32)
+//   associated landmark id of each region (#regions x uint32)
+//   mapping entries [full feature index (uint32) region index (uint32)]
+// -- <viewId>.<describerType>.regions
+// regions container of the reconstructed regions of the view, in the records order
+// -- documents.db
+// optional voctree::Database of the reconstructed views
+// --
+// The regions containers are memory-mapped: the descriptors are only in the OS page cache,
+// shared by all the localization processes using the same database.
+
+/// Filename of the reconstructed regions index of a localization database
+const std::string& getLocalizationDatabaseIndexFilename();
+
+/// Filename of the voctree documents of a localization database
+const std::string& getLocalizationDatabaseDocumentsFilename();
+
+/**
+ * @brief Check if the given folder contains a localization database.
+ * @param[in] folder The localization database folder
+ * @return true if the folder has a reconstructed regions index
+ */
+bool isLocalizationDatabase(const std::string& folder);
+
+/**
+ * @brief Save the reconstructed regions of a localizer in a localization database folder.
+ * @param[in] folder The localization database folder (created if needed)
+ * @param[in] regionsPerView The reconstructed regions of each view
+ * @param[in] mappingPerView The associated landmarks of the regions of each view
+ */
+void saveLocalizationDatabase(const std::string& folder,
+                              const feature::RegionsPerView& regionsPerView,
+                              const ReconstructedRegionsMappingPerView& mappingPerView);
+
+/**
+ * @brief Load the reconstructed regions of a localization database folder.
+ * @param[in] folder The localization database folder
+ * @param[in] descTypes The describer types to load
+ * @param[in] mapDescriptors Keep the descriptors in the memory-mapped regions containers
+ * @param[out] regionsPerView The reconstructed regions of each view
+ * @param[out] mappingPerView The associated landmarks of the regions of each view
+ * @return false if the database is incorrect
+ */
+bool loadLocalizationDatabase(const std::string& folder,
+                              const std::vector<feature::EImageDescriberType>& descTypes,
+                              bool mapDescriptors,
+                              feature::RegionsPerView& regionsPerView,
+                              ReconstructedRegionsMappingPerView& mappingPerView);
+
+} // namespace localization
+} // namespace aliceVision
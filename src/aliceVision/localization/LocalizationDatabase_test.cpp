@@ -0,0 +1,96 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationDatabase.hpp"
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE LocalizationDatabase
+#include <boost/test/included/unit_test.hpp>
+
+namespace fs = boost::filesystem;
+using namespace aliceVision;
+
+BOOST_AUTO_TEST_CASE(LocalizationDatabase_saveLoad)
+{
+  std::mt19937 randomNumberGenerator(42);
+  std::uniform_int_distribution<int> bins(0, 255);
+
+  feature::RegionsPerView regionsPerView;
+  localization::ReconstructedRegionsMappingPerView mappingPerView;
+
+  // two views with reconstructed regions, one view without
+  const std::vector<std::size_t> nbRegionsPerView = {100, 30, 0};
+
+  for(std::size_t v = 0; v < nbRegionsPerView.size(); ++v)
+  {
+    const IndexT viewId = 10 + v;
+    std::unique_ptr<feature::SIFT_Regions> regions(new feature::SIFT_Regions());
+    localization::ReconstructedRegionsMapping& mapping = mappingPerView[viewId][feature::EImageDescriberType::SIFT];
+
+    for(std::size_t i = 0; i < nbRegionsPerView[v]; ++i)
+    {
+      regions->Features().emplace_back(float(i), float(2 * i), 1.f, 0.f);
+      feature::SIFT_Regions::DescriptorT descriptor;
+      for(std::size_t k = 0; k < descriptor.size(); ++k)
+        descriptor[k] = static_cast<unsigned char>(bins(randomNumberGenerator));
+      regions->Descriptors().push_back(descriptor);
+
+      mapping._associated3dPoint.push_back(1000 + i);
+      mapping._mapFullToLocal[3 * i] = i;
+    }
+    regionsPerView.getData()[viewId][feature::EImageDescriberType::SIFT] = std::move(regions);
+  }
+
+  const std::string folder = (fs::temp_directory_path() / fs::unique_path("localizationDatabase_%%%%%%")).string();
+  localization::saveLocalizationDatabase(folder, regionsPerView, mappingPerView);
+  BOOST_CHECK(localization::isLocalizationDatabase(folder));
+
+  for(const bool mapDescriptors : {true, false})
+  {
+    feature::RegionsPerView loadedRegionsPerView;
+    localization::ReconstructedRegionsMappingPerView loadedMappingPerView;
+    BOOST_CHECK(localization::loadLocalizationDatabase(folder, {feature::EImageDescriberType::SIFT}, mapDescriptors, loadedRegionsPerView, loadedMappingPerView));
+
+    BOOST_CHECK_EQUAL(loadedRegionsPerView.getData().size(), nbRegionsPerView.size());
+
+    for(const auto& viewRegions : regionsPerView.getData())
+    {
+      const IndexT viewId = viewRegions.first;
+      const feature::Regions& regions = regionsPerView.getRegions(viewId, feature::EImageDescriberType::SIFT);
+      const feature::Regions& loadedRegions = loadedRegionsPerView.getRegions(viewId, feature::EImageDescriberType::SIFT);
+
+      BOOST_CHECK_EQUAL(loadedRegions.isDescriptorsMapped(), mapDescriptors);
+      BOOST_REQUIRE_EQUAL(loadedRegions.RegionCount(), regions.RegionCount());
+      for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+        BOOST_CHECK(loadedRegions.GetRegionPosition(i) == regions.GetRegionPosition(i));
+
+      if(regions.RegionCount() > 0)
+        BOOST_CHECK_EQUAL(std::memcmp(loadedRegions.DescriptorRawData(), regions.DescriptorRawData(), regions.RegionCount() * 128), 0);
+
+      const localization::ReconstructedRegionsMapping& mapping = mappingPerView.at(viewId).at(feature::EImageDescriberType::SIFT);
+      const localization::ReconstructedRegionsMapping& loadedMapping = loadedMappingPerView.at(viewId).at(feature::EImageDescriberType::SIFT);
+      BOOST_CHECK(loadedMapping._associated3dPoint == mapping._associated3dPoint);
+      BOOST_CHECK(loadedMapping._mapFullToLocal == mapping._mapFullToLocal);
+    }
+  }
+
+  // the records of the other describer types are skipped
+  {
+    feature::RegionsPerView loadedRegionsPerView;
+    localization::ReconstructedRegionsMappingPerView loadedMappingPerView;
+    BOOST_CHECK(localization::loadLocalizationDatabase(folder, {feature::EImageDescriberType::AKAZE}, true, loadedRegionsPerView, loadedMappingPerView));
+    BOOST_CHECK(loadedRegionsPerView.getData().empty());
+    BOOST_CHECK(loadedMappingPerView.empty());
+  }
+
+  fs::remove_all(folder);
+}
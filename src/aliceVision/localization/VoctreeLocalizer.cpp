@@ -5,6 +5,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "VoctreeLocalizer.hpp"
+#include "LocalizationDatabase.hpp"
 #include "rigResection.hpp"
 #include "optimization.hpp"
 #include <aliceVision/config.hpp>
@@ -21,14 +22,20 @@
 #include <aliceVision/matchingImageCollection/GeometricFilterMatrix.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/robustEstimation/guidedMatching.hpp>
+#include <aliceVision/system/RingBuffer.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 #include <boost/filesystem.hpp>
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
 
 namespace aliceVision {
 namespace localization {
@@ -121,7 +128,8 @@ VoctreeLocalizer::VoctreeLocalizer(const sfmData::SfMData &sfmData,
                                    const std::string &descriptorsFolder,
                                    const std::string &vocTreeFilepath,
                                    const std::string &weightsFilepath,
-                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes)
+                                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                                   const std::string &localizationDatabaseFolder)
   : ILocalizer()
   , _frameBuffer(5)
 {
@@ -141,9 +149,59 @@ VoctreeLocalizer::VoctreeLocalizer(const sfmData::SfMData &sfmData,
   // then we can store only those associated to 3D points
   //? can we use Feature_Provider to load the features and filter them later?
 
+  if(!localizationDatabaseFolder.empty())
+  {
+    // Load vocabulary tree
+    voctree::load(_voctree, _voctreeDescType, vocTreeFilepath, true);
+    _isInit = loadLocalizationDatabase(weightsFilepath, localizationDatabaseFolder);
+    return;
+  }
+
   _isInit = initDatabase(vocTreeFilepath, weightsFilepath, descriptorsFolder);
 }
 
+void VoctreeLocalizer::saveLocalizationDatabase(const std::string& folder) const
+{
+  localization::saveLocalizationDatabase(folder, _regionsPerView, _reconstructedRegionsMappingPerView);
+  _database.save((boost::filesystem::path(folder) / getLocalizationDatabaseDocumentsFilename()).string());
+}
+
+bool VoctreeLocalizer::loadLocalizationDatabase(const std::string & weightsFilepath,
+                                                const std::string & localizationDatabaseFolder)
+{
+  const std::string documentsFilepath = (boost::filesystem::path(localizationDatabaseFolder) / getLocalizationDatabaseDocumentsFilename()).string();
+
+  if(!isLocalizationDatabase(localizationDatabaseFolder) || !boost::filesystem::exists(documentsFilepath))
+  {
+    ALICEVISION_LOG_ERROR("Invalid localization database folder: " << localizationDatabaseFolder);
+    return false;
+  }
+
+  std::vector<feature::EImageDescriberType> descTypes;
+  for(const auto& imageDescriber : _imageDescribers)
+    descTypes.push_back(imageDescriber->getDescriberType());
+
+  // the descriptors stay in the memory-mapped regions containers
+  if(!localization::loadLocalizationDatabase(localizationDatabaseFolder, descTypes, true, _regionsPerView, _reconstructedRegionsMappingPerView))
+    return false;
+
+  ALICEVISION_LOG_DEBUG("Loading the database documents...");
+  _database.load(documentsFilepath);
+
+  if(_database.size() == 0)
+  {
+    ALICEVISION_LOG_ERROR("The localization database has no document: " << documentsFilepath);
+    return false;
+  }
+
+  if(!weightsFilepath.empty())
+  {
+    ALICEVISION_LOG_DEBUG("Loading weights...");
+    _database.loadWeights(weightsFilepath);
+  }
+  return true;
+}
+
 bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
                                 const std::pair<std::size_t, std::size_t> &imageSize,
                                 const LocalizerParameters *param,
@@ -191,35 +249,63 @@ bool VoctreeLocalizer::localize(const image::Image<float>& imageGrey,
                                 const std::string& imagePath /* = std::string() */)
 {
   // A. extract descriptors and features from image
-  ALICEVISION_LOG_DEBUG("[features]\tExtract Regions from query image");
   feature::MapRegionsPerDesc queryRegionsPerDesc;
+  extractRegions(imageGrey, param, queryRegionsPerDesc, imagePath);
+
+  const std::pair<std::size_t, std::size_t> queryImageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
+
+  return localize(queryRegionsPerDesc,
+                  queryImageSize,
+                  param,
+                  useInputIntrinsics,
+                  queryIntrinsics,
+                  localizationResult,
+                  imagePath);
+}
+
+void VoctreeLocalizer::extractRegions(const image::Image<float>& imageGrey,
+                                      const LocalizerParameters* param,
+                                      feature::MapRegionsPerDesc& queryRegions,
+                                      const std::string& imagePath)
+{
+  extractRegions(imageGrey, param, _imageDescribers, _cudaPipe, queryRegions, imagePath);
+}
+
+void VoctreeLocalizer::extractRegions(const image::Image<float>& imageGrey,
+                                      const LocalizerParameters* param,
+                                      const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                                      int cudaPipe,
+                                      feature::MapRegionsPerDesc& queryRegions,
+                                      const std::string& imagePath)
+{
+  ALICEVISION_LOG_DEBUG("[features]\tExtract Regions from query image");
 
   image::Image<unsigned char> imageGrayUChar; // uchar image copy for uchar image describer
 
-  for(const auto& imageDescriber : _imageDescribers)
+  for(const auto& imageDescriber : imageDescribers)
   {
     const auto descType = imageDescriber->getDescriberType();
-    auto & queryRegions = queryRegionsPerDesc[descType];
+    auto & regions = queryRegions[descType];
 
-    imageDescriber->allocate(queryRegions);
+    imageDescriber->allocate(regions);
 
     system::Timer timer;
-    imageDescriber->setCudaPipe(_cudaPipe);
+    imageDescriber->setCudaPipe(cudaPipe);
     imageDescriber->setConfigurationPreset(param->_featurePreset);
 
     if(imageDescriber->useFloatImage())
     {
-      imageDescriber->describe(imageGrey, queryRegions, nullptr);
+      imageDescriber->describe(imageGrey, regions, nullptr);
     }
     else
     {
       // image descriptor can't use float image
       if(imageGrayUChar.Width() == 0) // the first time, convert the float buffer to uchar
         imageGrayUChar = (imageGrey.GetMat() * 255.f).cast<unsigned char>();
-      imageDescriber->describe(imageGrayUChar, queryRegions, nullptr);
+      imageDescriber->describe(imageGrayUChar, regions, nullptr);
     }
 
-    ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(descType) << " done: found " << queryRegions->RegionCount() << " features in " << timer.elapsedMs() << " [ms]");
+    ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(descType) << " done: found " << regions->RegionCount() << " features in " << timer.elapsedMs() << " [ms]");
   }
 
   const std::pair<std::size_t, std::size_t> queryImageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
@@ -229,10 +315,10 @@ bool VoctreeLocalizer::localize(const image::Image<float>& imageGrey,
   {
     feature::MapFeaturesPerDesc extractedFeatures;
 
-    for(const auto& imageDescriber : _imageDescribers)
+    for(const auto& imageDescriber : imageDescribers)
     {
       const auto descType = imageDescriber->getDescriberType();
-      extractedFeatures[descType] = queryRegionsPerDesc.at(descType)->GetRegionsPositions();
+      extractedFeatures[descType] = queryRegions.at(descType)->GetRegionsPositions();
     }
 
     namespace bfs = boost::filesystem;
@@ -241,14 +327,149 @@ bool VoctreeLocalizer::localize(const image::Image<float>& imageGrey,
                      extractedFeatures,
                      param->_visualDebug + "/" + bfs::path(imagePath).stem().string() + ".svg");
   }
+}
 
-  return localize(queryRegionsPerDesc,
-                  queryImageSize,
-                  param,
-                  useInputIntrinsics,
-                  queryIntrinsics,
-                  localizationResult,
-                  imagePath);
+/**
+ * @brief A frame in the stages of VoctreeLocalizer::localizeSequence
+ */
+struct PipelineFrame
+{
+  SequenceFrame frame;
+  std::pair<std::size_t, std::size_t> imageSize;
+  feature::MapRegionsPerDesc queryRegions;
+  /// the associations are computed in the matching stage
+  bool hasAssociations = false;
+  OccurenceMap occurences;
+  sfm::ImageLocalizerMatchData resectionData;
+  std::vector<voctree::DocMatch> matchedImages;
+};
+
+void VoctreeLocalizer::localizeSequence(const std::function<bool(SequenceFrame&)>& readFrame,
+                                        const LocalizerParameters* param,
+                                        const std::function<void(const SequenceFrame&, const LocalizationResult&)>& onLocalized,
+                                        std::size_t queueSize)
+{
+  const Parameters* voctreeParam = static_cast<const Parameters*>(param);
+  if(!voctreeParam)
+  {
+    // error!
+    throw std::invalid_argument("The parameters are not in the right format!!");
+  }
+
+  // only AllResults can split the matching and the pose estimation,
+  // the tracking needs the pose of the previous frame
+  const bool matchingStage = (voctreeParam->_algorithm == Algorithm::AllResults) && !voctreeParam->_useTracking;
+
+  system::RingBuffer<std::shared_ptr<PipelineFrame>> extractedQueue(queueSize);
+  system::RingBuffer<std::shared_ptr<PipelineFrame>> matchedQueue(queueSize);
+
+  // pose estimation stage
+  const auto localizeFrame = [&](PipelineFrame& pipelineFrame)
+  {
+    SequenceFrame& frame = pipelineFrame.frame;
+    LocalizationResult localizationResult;
+
+    if(pipelineFrame.hasAssociations)
+    {
+      localizeFromAssociations(pipelineFrame.queryRegions,
+                               pipelineFrame.imageSize,
+                               *voctreeParam,
+                               frame.useInputIntrinsics,
+                               frame.queryIntrinsics,
+                               pipelineFrame.occurences,
+                               pipelineFrame.resectionData,
+                               pipelineFrame.matchedImages,
+                               localizationResult,
+                               frame.imagePath);
+      addToFrameBuffer(*voctreeParam, localizationResult, pipelineFrame.queryRegions);
+    }
+    else
+    {
+      localize(pipelineFrame.queryRegions,
+               pipelineFrame.imageSize,
+               param,
+               frame.useInputIntrinsics,
+               frame.queryIntrinsics,
+               localizationResult,
+               frame.imagePath);
+    }
+    onLocalized(frame, localizationResult);
+  };
+
+#pragma omp parallel num_threads(3)
+  {
+    if(omp_get_num_threads() < 3)
+    {
+      // the stages can't run at the same time, localize the frames one by one
+#pragma omp single
+      {
+        ALICEVISION_LOG_WARNING("Cannot run the localization pipeline, localize the frames sequentially.");
+        PipelineFrame pipelineFrame;
+        while(readFrame(pipelineFrame.frame))
+        {
+          const image::Image<float>& imageGrey = pipelineFrame.frame.imageGrey;
+          pipelineFrame.imageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
+          extractRegions(imageGrey, param, pipelineFrame.queryRegions, pipelineFrame.frame.imagePath);
+          localizeFrame(pipelineFrame);
+          pipelineFrame = PipelineFrame();
+        }
+      }
+    }
+    else if(omp_get_thread_num() == 0)
+    {
+      // extraction stage
+      for(;;)
+      {
+        std::shared_ptr<PipelineFrame> pipelineFrame = std::make_shared<PipelineFrame>();
+        if(!readFrame(pipelineFrame->frame))
+          break;
+
+        image::Image<float>& imageGrey = pipelineFrame->frame.imageGrey;
+        pipelineFrame->imageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
+        extractRegions(imageGrey, param, pipelineFrame->queryRegions, pipelineFrame->frame.imagePath);
+        imageGrey = image::Image<float>(); // release the image before waiting for the next stage
+        extractedQueue.push(pipelineFrame);
+      }
+      extractedQueue.close();
+    }
+    else if(omp_get_thread_num() == 1)
+    {
+      // matching stage
+      std::shared_ptr<PipelineFrame> pipelineFrame;
+      while(extractedQueue.pop(pipelineFrame))
+      {
+        if(matchingStage)
+        {
+          const SequenceFrame& frame = pipelineFrame->frame;
+          getAllAssociations(pipelineFrame->queryRegions,
+                             pipelineFrame->imageSize,
+                             *voctreeParam,
+                             frame.useInputIntrinsics,
+                             frame.queryIntrinsics,
+                             pipelineFrame->occurences,
+                             pipelineFrame->resectionData.pt2D,
+                             pipelineFrame->resectionData.pt3D,
+                             pipelineFrame->resectionData.vec_descType,
+                             pipelineFrame->matchedImages,
+                             frame.imagePath);
+          pipelineFrame->hasAssociations = true;
+        }
+        matchedQueue.push(pipelineFrame);
+        pipelineFrame.reset();
+      }
+      matchedQueue.close();
+    }
+    else if(omp_get_thread_num() == 2)
+    {
+      // pose estimation stage
+      std::shared_ptr<PipelineFrame> pipelineFrame;
+      while(matchedQueue.pop(pipelineFrame))
+      {
+        localizeFrame(*pipelineFrame);
+        pipelineFrame.reset();
+      }
+    }
+  }
 }
 
 bool VoctreeLocalizer::loadReconstructionDescriptors(const sfmData::SfMData & sfm_data,
@@ -273,7 +494,7 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
   // Load vocabulary tree
   ALICEVISION_LOG_DEBUG("Loading vocabulary tree...");
 
-  voctree::load(_voctree, _voctreeDescType, vocTreeFilepath);
+  voctree::load(_voctree, _voctreeDescType, vocTreeFilepath, true);
 
   ALICEVISION_LOG_DEBUG("tree loaded with " << _voctree->levels() << " levels and "
           << _voctree->splits() << " branching factors");
@@ -382,6 +603,8 @@ bool VoctreeLocalizer::initDatabase(const std::string & vocTreeFilepath,
       ++my_progress_bar;
     }
   }
+
+  _database.buildInvertedIndex();
   return true;
 }
 
@@ -612,6 +835,40 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                                           const std::string& imagePath)
 {
   
+  if(param._useTracking)
+  {
+    // try to localize the frame from the landmarks of the previous frame
+    sfm::ImageLocalizerMatchData trackingResectionData;
+    OccurenceMap trackingOccurences;
+    camera::PinholeRadialK3 trackingIntrinsics = queryIntrinsics;
+
+    if(getAssociationsFromTracking(queryRegions,
+                                   queryImageSize,
+                                   param,
+                                   trackingOccurences,
+                                   trackingResectionData.pt2D,
+                                   trackingResectionData.pt3D,
+                                   trackingResectionData.vec_descType) &&
+       localizeFromAssociations(queryRegions,
+                                queryImageSize,
+                                param,
+                                useInputIntrinsics,
+                                trackingIntrinsics,
+                                trackingOccurences,
+                                trackingResectionData,
+                                std::vector<voctree::DocMatch>(),
+                                localizationResult,
+                                imagePath) &&
+       localizationResult.getInliers().size() >= param._trackingMinInliers)
+    {
+      ALICEVISION_LOG_DEBUG("[tracking]\tFrame localized with " << localizationResult.getInliers().size() << " tracked landmarks");
+      queryIntrinsics = trackingIntrinsics;
+      addToFrameBuffer(param, localizationResult, queryRegions);
+      return true;
+    }
+    ALICEVISION_LOG_DEBUG("[tracking]\tTracking failed, localize the frame with the database");
+  }
+
   sfm::ImageLocalizerMatchData resectionData;
   // a map containing for each pair <pt3D_id, pt2D_id> the number of times that 
   // the association has been seen
@@ -631,6 +888,31 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                      matchedImages,
                      imagePath);
 
+  const bool isLocalized = localizeFromAssociations(queryRegions,
+                                                    queryImageSize,
+                                                    param,
+                                                    useInputIntrinsics,
+                                                    queryIntrinsics,
+                                                    occurences,
+                                                    resectionData,
+                                                    matchedImages,
+                                                    localizationResult,
+                                                    imagePath);
+  addToFrameBuffer(param, localizationResult, queryRegions);
+  return isLocalized;
+}
+
+bool VoctreeLocalizer::localizeFromAssociations(const feature::MapRegionsPerDesc& queryRegions,
+                                                const std::pair<std::size_t, std::size_t>& queryImageSize,
+                                                const Parameters& param,
+                                                bool useInputIntrinsics,
+                                                camera::PinholeRadialK3& queryIntrinsics,
+                                                const OccurenceMap& occurences,
+                                                sfm::ImageLocalizerMatchData& resectionData,
+                                                const std::vector<voctree::DocMatch>& matchedImages,
+                                                LocalizationResult& localizationResult,
+                                                const std::string& imagePath)
+{
   const std::size_t numCollectedPts = occurences.size();
   std::vector<IndMatch3D2D> associationIDs;
   associationIDs.reserve(numCollectedPts);
@@ -730,13 +1012,19 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                 << " max = " << std::sqrt(sqrErrors.maxCoeff()));
   }
 
-  if(param._nbFrameBufferMatching > 0)
+  return localizationResult.isValid();
+}
+
+void VoctreeLocalizer::addToFrameBuffer(const Parameters& param,
+                                        const LocalizationResult& localizationResult,
+                                        const feature::MapRegionsPerDesc& queryRegions)
+{
+  if(param._nbFrameBufferMatching > 0 || param._useTracking)
   {
     // add everything to the buffer
+    std::lock_guard<std::mutex> lock(_frameBufferMutex);
     _frameBuffer.emplace_back(localizationResult, queryRegions);
   }
-
-  return localizationResult.isValid();
 }
 
 void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &queryRegions,
@@ -780,144 +1068,183 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
 //            << " features with 3D points");
 //  }
 
+  // the candidates are matched in parallel, by batches of one image per thread,
+  // each thread has its own matchers of the query regions
+  const int nbThreads = omp_get_max_threads();
+  std::vector<std::unique_ptr<matching::RegionsDatabaseMatcherPerDesc>> threadMatchers(nbThreads);
+
   ALICEVISION_LOG_DEBUG("[matching]\tBuilding the matcher");
-  matching::RegionsDatabaseMatcherPerDesc matchers(_matcherType, queryRegions);
+  threadMatchers.front().reset(new matching::RegionsDatabaseMatcherPerDesc(_matcherType, queryRegions));
+  matching::RegionsDatabaseMatcherPerDesc& matchers = *threadMatchers.front();
 
   std::map< std::pair<IndexT, IndexT>, std::size_t > repeated;
   
+  // minimum number of points that allows a reliable 3D reconstruction
+  const size_t minNum3DPoints = 5;
+
   // B. for each found similar image, try to find the correspondences between the 
   // query image adn the similar image
   // stop when param._maxResults successful matches have been found
   std::size_t goodMatches = 0;
-  for(const voctree::DocMatch& matchedImage : out_matchedImages)
+  std::size_t candidate = 0;
+  bool enoughMatches = false;
+  while(candidate < out_matchedImages.size() && !enoughMatches)
   {
-    // minimum number of points that allows a reliable 3D reconstruction
-    const size_t minNum3DPoints = 5;
+    // select the next batch of candidates
+    std::vector<IndexT> batchViewIds;
+    std::vector<const camera::Pinhole*> batchIntrinsics;
+    batchViewIds.reserve(nbThreads);
+    batchIntrinsics.reserve(nbThreads);
 
-    const auto matchedViewId = matchedImage.id;
-    // the handler to the current view
-    const std::shared_ptr<sfmData::View> matchedView = _sfm_data.views.at(matchedViewId);
-    // its associated reconstructed regions
-    const feature::MapRegionsPerDesc& matchedRegions = _regionsPerView.getRegionsPerDesc(matchedViewId);
-    
-    // safeguard: we should match the query image with an image that has at least
-    // some 3D points visible --> if this is not true it is likely that it is an
-    // image of the dataset that was not reconstructed
-    if(matchedRegions.getNbAllRegions() < minNum3DPoints)
-    {
-      ALICEVISION_LOG_DEBUG("[matching]\tSkipping matching with " << matchedView->getImagePath() << " as it has too few visible 3D points");
-      continue;
-    }
-    ALICEVISION_LOG_TRACE("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
-    ALICEVISION_LOG_TRACE("[matching]\tIt has " << matchedRegions.getNbAllRegions() << " available features to match");
-    
-    // its associated intrinsics
-    // this is just ugly!
-    const camera::IntrinsicBase *matchedIntrinsicsBase = _sfm_data.intrinsics.at(matchedView->getIntrinsicId()).get();
-    if ( !isPinhole(matchedIntrinsicsBase->getType()) )
+    for(; candidate < out_matchedImages.size() && batchViewIds.size() < nbThreads; ++candidate)
     {
-      //@fixme maybe better to throw something here
-      ALICEVISION_CERR("Only Pinhole cameras are supported!");
-      return;
+      const auto matchedViewId = out_matchedImages[candidate].id;
+      // the handler to the current view
+      const std::shared_ptr<sfmData::View> matchedView = _sfm_data.views.at(matchedViewId);
+      // its associated reconstructed regions
+      const feature::MapRegionsPerDesc& matchedRegions = _regionsPerView.getRegionsPerDesc(matchedViewId);
+
+      // safeguard: we should match the query image with an image that has at least
+      // some 3D points visible --> if this is not true it is likely that it is an
+      // image of the dataset that was not reconstructed
+      if(matchedRegions.getNbAllRegions() < minNum3DPoints)
+      {
+        ALICEVISION_LOG_DEBUG("[matching]\tSkipping matching with " << matchedView->getImagePath() << " as it has too few visible 3D points");
+        continue;
+      }
+      ALICEVISION_LOG_TRACE("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
+      ALICEVISION_LOG_TRACE("[matching]\tIt has " << matchedRegions.getNbAllRegions() << " available features to match");
+
+      // its associated intrinsics
+      // this is just ugly!
+      const camera::IntrinsicBase *matchedIntrinsicsBase = _sfm_data.intrinsics.at(matchedView->getIntrinsicId()).get();
+      if ( !isPinhole(matchedIntrinsicsBase->getType()) )
+      {
+        //@fixme maybe better to throw something here
+        ALICEVISION_CERR("Only Pinhole cameras are supported!");
+        return;
+      }
+      batchViewIds.push_back(matchedViewId);
+      batchIntrinsics.push_back((const camera::Pinhole*)(matchedIntrinsicsBase));
     }
-    const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(matchedIntrinsicsBase);
 
-    matching::MatchesPerDescType featureMatches;
-    const bool matchWorked = robustMatching(matchers,
-                                      // pass the input intrinsic if they are valid, null otherwise
-                                      (useInputIntrinsics) ? &queryIntrinsics : nullptr,
-                                      matchedRegions,
-                                      matchedIntrinsics,
-                                      param._fDistRatio,
-                                      param._matchingError,
-                                      param._useRobustMatching,
-                                      param._useGuidedMatching,
-                                      imageSize,
-                                      std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
-                                      featureMatches,
-                                      param._matchingEstimator);
-    if (!matchWorked)
+    std::vector<matching::MatchesPerDescType> batchFeatureMatches(batchViewIds.size());
+    std::vector<char> batchMatchWorked(batchViewIds.size(), false);
+
+    // match and geometrically validate the candidates of the batch
+#pragma omp parallel for num_threads(nbThreads)
+    for(int i = 0; i < batchViewIds.size(); ++i)
     {
-//      ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
-      continue;
+      std::unique_ptr<matching::RegionsDatabaseMatcherPerDesc>& localMatchers = threadMatchers.at(omp_get_thread_num());
+      if(!localMatchers)
+        localMatchers.reset(new matching::RegionsDatabaseMatcherPerDesc(_matcherType, queryRegions));
+
+      const std::shared_ptr<sfmData::View> matchedView = _sfm_data.views.at(batchViewIds[i]);
+
+      batchMatchWorked[i] = robustMatching(*localMatchers,
+                                           // pass the input intrinsic if they are valid, null otherwise
+                                           (useInputIntrinsics) ? &queryIntrinsics : nullptr,
+                                           _regionsPerView.getRegionsPerDesc(batchViewIds[i]),
+                                           batchIntrinsics[i],
+                                           param._fDistRatio,
+                                           param._matchingError,
+                                           param._useRobustMatching,
+                                           param._useGuidedMatching,
+                                           imageSize,
+                                           std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
+                                           batchFeatureMatches[i],
+                                           param._matchingEstimator);
     }
 
-    ALICEVISION_LOG_DEBUG("[matching]\tFound " << featureMatches.getNbAllMatches() << " geometrically validated matches");
-    assert(featureMatches.getNbAllMatches() > 0);
-
-    // if debug is enable save the matches between the query image and the current matching image
-    // It saves the feature matches in a folder with the same name as the query
-    // image, if it does not exist it will create it. The final svg file will have
-    // a name like this: queryImage_matchedImage.svg placed in the following directory:
-    // param._visualDebug/queryImage/
-    if(!param._visualDebug.empty() && !imagePath.empty())
+    // merge the associations of the batch in the order of the retrieved images
+    for(std::size_t i = 0; i < batchViewIds.size(); ++i)
     {
-      namespace bfs = boost::filesystem;
-      const sfmData::View *mview = _sfm_data.getViews().at(matchedViewId).get();
-      // the current query image without extension
-      const auto queryImage = bfs::path(imagePath).stem();
-      // the matching image without extension
-      const auto matchedImage = bfs::path(mview->getImagePath()).stem();
-      // the full path of the matching image
-      const auto matchedPath = mview->getImagePath();
-
-      // the directory where to save the feature matches
-      const auto baseDir = bfs::path(param._visualDebug) / queryImage;
-      if((!bfs::exists(baseDir)))
+      if(!batchMatchWorked[i])
       {
-        ALICEVISION_LOG_DEBUG("created " << baseDir.string());
-        bfs::create_directories(baseDir);
+        continue;
       }
-      
-      // damn you, boost, what does it take to make the operator "+"?
-      // the final filename for the output svg file as a composition of the query
-      // image and the matched image
-      auto outputName = baseDir / queryImage;
-      outputName += "_";
-      outputName += matchedImage;
-      outputName += ".svg";
 
-      feature::saveMatches2SVG(imagePath,
-                                imageSize,
-                                queryRegions,
-                                matchedPath,
-                                std::make_pair(mview->getWidth(), mview->getHeight()),
-                                _regionsPerView.getRegionsPerDesc(matchedViewId),
-                                featureMatches,
-                                outputName.string()); 
-    }
+      const IndexT matchedViewId = batchViewIds[i];
+      const matching::MatchesPerDescType& featureMatches = batchFeatureMatches[i];
 
-    const auto& matchedRegionsMapping = _reconstructedRegionsMappingPerView.at(matchedViewId);
+      ALICEVISION_LOG_DEBUG("[matching]\tFound " << featureMatches.getNbAllMatches() << " geometrically validated matches");
+      assert(featureMatches.getNbAllMatches() > 0);
 
-    // C. recover the 2D-3D associations from the matches 
-    // Each matched feature in the current similar image is associated to a 3D point
-    for(const auto& featureMatchesIt : featureMatches)
-    {
-      feature::EImageDescriberType descType = featureMatchesIt.first;
-      const auto& matchedRegionsMappingType = matchedRegionsMapping.at(descType);
-      for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
+      // if debug is enable save the matches between the query image and the current matching image
+      // It saves the feature matches in a folder with the same name as the query
+      // image, if it does not exist it will create it. The final svg file will have
+      // a name like this: queryImage_matchedImage.svg placed in the following directory:
+      // param._visualDebug/queryImage/
+      if(!param._visualDebug.empty() && !imagePath.empty())
       {
-        // the ID of the 3D point
-        const IndexT pt3D_id = matchedRegionsMappingType._associated3dPoint[featureMatch._j];
-        const IndexT pt2D_id = featureMatch._i;
-
-        const OccurenceKey key(pt3D_id, descType, pt2D_id);
-        if(out_occurences.count(key))
+        namespace bfs = boost::filesystem;
+        const sfmData::View *mview = _sfm_data.getViews().at(matchedViewId).get();
+        // the current query image without extension
+        const auto queryImage = bfs::path(imagePath).stem();
+        // the matching image without extension
+        const auto matchedImage = bfs::path(mview->getImagePath()).stem();
+        // the full path of the matching image
+        const auto matchedPath = mview->getImagePath();
+
+        // the directory where to save the feature matches
+        const auto baseDir = bfs::path(param._visualDebug) / queryImage;
+        if((!bfs::exists(baseDir)))
         {
-          out_occurences[key]++;
+          ALICEVISION_LOG_DEBUG("created " << baseDir.string());
+          bfs::create_directories(baseDir);
         }
-        else
+
+        // damn you, boost, what does it take to make the operator "+"?
+        // the final filename for the output svg file as a composition of the query
+        // image and the matched image
+        auto outputName = baseDir / queryImage;
+        outputName += "_";
+        outputName += matchedImage;
+        outputName += ".svg";
+
+        feature::saveMatches2SVG(imagePath,
+                                  imageSize,
+                                  queryRegions,
+                                  matchedPath,
+                                  std::make_pair(mview->getWidth(), mview->getHeight()),
+                                  _regionsPerView.getRegionsPerDesc(matchedViewId),
+                                  featureMatches,
+                                  outputName.string());
+      }
+
+      const auto& matchedRegionsMapping = _reconstructedRegionsMappingPerView.at(matchedViewId);
+
+      // C. recover the 2D-3D associations from the matches 
+      // Each matched feature in the current similar image is associated to a 3D point
+      for(const auto& featureMatchesIt : featureMatches)
+      {
+        feature::EImageDescriberType descType = featureMatchesIt.first;
+        const auto& matchedRegionsMappingType = matchedRegionsMapping.at(descType);
+        for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
         {
-          out_occurences[key] = 1;
+          // the ID of the 3D point
+          const IndexT pt3D_id = matchedRegionsMappingType._associated3dPoint[featureMatch._j];
+          const IndexT pt2D_id = featureMatch._i;
+
+          const OccurenceKey key(pt3D_id, descType, pt2D_id);
+          if(out_occurences.count(key))
+          {
+            out_occurences[key]++;
+          }
+          else
+          {
+            out_occurences[key] = 1;
+          }
         }
       }
-    }
-    ++goodMatches;
-    if((param._maxResults !=0) && (goodMatches == param._maxResults))
-    { 
-      // let's say we have enough features
-      ALICEVISION_LOG_DEBUG("[matching]\tgot enough point from " << param._maxResults << " images");
-      break;
+      ++goodMatches;
+      if((param._maxResults !=0) && (goodMatches == param._maxResults))
+      { 
+        // let's say we have enough features
+        ALICEVISION_LOG_DEBUG("[matching]\tgot enough point from " << param._maxResults << " images");
+        enoughMatches = true;
+        break;
+      }
     }
   }
   
@@ -952,14 +1279,25 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
     }
   }
   
+  getAssociationsPoints(queryRegions, out_occurences, out_pt2D, out_pt3D, out_descTypes);
+}
+
+void VoctreeLocalizer::getAssociationsPoints(const feature::MapRegionsPerDesc& queryRegions,
+                                             const OccurenceMap& occurences,
+                                             Mat& out_pt2D,
+                                             Mat& out_pt3D,
+                                             std::vector<feature::EImageDescriberType>& out_descTypes) const
+{
+  const std::size_t numCollectedPts = occurences.size();
+
   out_pt2D = Mat2X(2, numCollectedPts);
   out_pt3D = Mat3X(3, numCollectedPts);
   
 
-  out_descTypes.resize(out_occurences.size());
+  out_descTypes.resize(occurences.size());
 
   std::size_t index = 0;
-  for(const auto &idx : out_occurences)
+  for(const auto &idx : occurences)
   {
      // recopy all the points in the matching structure
     const IndexT pt2D_id = idx.first.featId;
@@ -972,7 +1310,126 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
     out_descTypes.at(index) = landmark.descType;
      ++index;
   }
-  
+}
+
+bool VoctreeLocalizer::getAssociationsFromTracking(const feature::MapRegionsPerDesc& queryRegions,
+                                                   const std::pair<std::size_t, std::size_t>& queryImageSize,
+                                                   const Parameters& param,
+                                                   OccurenceMap& out_occurences,
+                                                   Mat& out_pt2D,
+                                                   Mat& out_pt3D,
+                                                   std::vector<feature::EImageDescriberType>& out_descTypes) const
+{
+  assert(out_descTypes.size() == 0);
+
+  std::lock_guard<std::mutex> lock(_frameBufferMutex);
+
+  // the previous frame of the sequence
+  const FrameData* previousFrame = nullptr;
+  for(const auto& frame : _frameBuffer)
+    previousFrame = &frame;
+
+  if(previousFrame == nullptr || !previousFrame->_locResult.isValid())
+  {
+    ALICEVISION_LOG_DEBUG("[tracking]\tThe previous frame is not localized");
+    return false;
+  }
+
+  // the camera motion between two frames is assumed small, the landmarks are
+  // projected with the pose of the previous frame
+  const geometry::Pose3& pose = previousFrame->_locResult.getPose();
+  const camera::PinholeRadialK3& intrinsics = previousFrame->_locResult.getIntrinsics();
+  const double window = param._trackingWindow;
+  const double squaredWindow = window * window;
+  const double squaredDistRatio = param._fDistRatio * param._fDistRatio;
+
+  // grid of the query features, with cells of the size of the search window
+  const int gridWidth = std::max(1, static_cast<int>(std::ceil(queryImageSize.first / window)));
+  const int gridHeight = std::max(1, static_cast<int>(std::ceil(queryImageSize.second / window)));
+  const auto toCell = [window](double x, int size)
+  {
+    return std::min(std::max(static_cast<int>(std::floor(x / window)), 0), size - 1);
+  };
+
+  for(const auto& frameRegionsIt : previousFrame->_regions)
+  {
+    const feature::EImageDescriberType descType = frameRegionsIt.first;
+    if(queryRegions.count(descType) == 0)
+      continue;
+
+    const feature::Regions& frameRegions = *frameRegionsIt.second;
+    const feature::Regions& descQueryRegions = *queryRegions.at(descType);
+    const ReconstructedRegionsMapping& frameMapping = previousFrame->_regionsWith3D.at(descType);
+
+    std::vector<std::vector<IndexT>> grid(gridWidth * gridHeight);
+    for(std::size_t i = 0; i < descQueryRegions.RegionCount(); ++i)
+    {
+      const Vec2 position = descQueryRegions.GetRegionPosition(i);
+      grid[toCell(position(1), gridHeight) * gridWidth + toCell(position(0), gridWidth)].push_back(i);
+    }
+
+    // best tracked landmark of each query feature <squared descriptor distance, frame region>
+    std::map<IndexT, std::pair<double, IndexT>> bestMatches;
+
+    for(std::size_t j = 0; j < frameRegions.RegionCount(); ++j)
+    {
+      const auto landmarkIt = _sfm_data.getLandmarks().find(frameMapping._associated3dPoint.at(j));
+      if(landmarkIt == _sfm_data.getLandmarks().end() || pose.depth(landmarkIt->second.X) <= 0)
+        continue;
+
+      const Vec2 projection = intrinsics.project(pose, landmarkIt->second.X);
+      if(projection(0) < -window || projection(1) < -window ||
+         projection(0) > queryImageSize.first + window || projection(1) > queryImageSize.second + window)
+        continue;
+
+      // guided matching in the window, with the distance ratio test
+      double bestDistance = std::numeric_limits<double>::infinity();
+      double secondBestDistance = std::numeric_limits<double>::infinity();
+      IndexT bestFeature = UndefinedIndexT;
+
+      for(int y = toCell(projection(1) - window, gridHeight); y <= toCell(projection(1) + window, gridHeight); ++y)
+      {
+        for(int x = toCell(projection(0) - window, gridWidth); x <= toCell(projection(0) + window, gridWidth); ++x)
+        {
+          for(const IndexT i : grid[y * gridWidth + x])
+          {
+            if((descQueryRegions.GetRegionPosition(i) - projection).squaredNorm() > squaredWindow)
+              continue;
+
+            const double distance = frameRegions.SquaredDescriptorDistance(j, &descQueryRegions, i);
+            if(distance < bestDistance)
+            {
+              secondBestDistance = bestDistance;
+              bestDistance = distance;
+              bestFeature = i;
+            }
+            else if(distance < secondBestDistance)
+            {
+              secondBestDistance = distance;
+            }
+          }
+        }
+      }
+
+      if(bestFeature == UndefinedIndexT || bestDistance > squaredDistRatio * secondBestDistance)
+        continue;
+
+      const auto bestMatchIt = bestMatches.find(bestFeature);
+      if(bestMatchIt == bestMatches.end() || bestDistance < bestMatchIt->second.first)
+        bestMatches[bestFeature] = std::make_pair(bestDistance, static_cast<IndexT>(j));
+    }
+
+    for(const auto& bestMatch : bestMatches)
+      out_occurences[OccurenceKey(frameMapping._associated3dPoint.at(bestMatch.second.second), descType, bestMatch.first)] = 1;
+  }
+
+  ALICEVISION_LOG_DEBUG("[tracking]\tFound " << out_occurences.size() << " associations with the previous frame");
+
+  if(out_occurences.size() < param._trackingMinInliers)
+    return false;
+
+  getAssociationsPoints(queryRegions, out_occurences, out_pt2D, out_pt3D, out_descTypes);
+  return true;
 }
 
 void VoctreeLocalizer::getAssociationsFromBuffer(matching::RegionsDatabaseMatcherPerDesc & matchers,
@@ -984,6 +1441,7 @@ void VoctreeLocalizer::getAssociationsFromBuffer(matching::RegionsDatabaseMatche
                                                  const std::string& imagePath) const
 {
   std::size_t frameCounter = 0;
+  std::lock_guard<std::mutex> lock(_frameBufferMutex);
   // for all the past frames
   for(const auto& frame : _frameBuffer)
   {
@@ -1160,35 +1618,23 @@ bool VoctreeLocalizer::localizeRig(const std::vector<image::Image<float>> & vec_
   assert(numCams == vec_subPoses.size() + 1);
 
   std::vector<feature::MapRegionsPerDesc> vec_queryRegions(numCams);
-  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize;
+  std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize(numCams);
 
-  //@todo parallelize?
-  for(size_t i = 0; i < numCams; ++i)
+  // extract the features of all the cameras at the same time, each camera has
+  // its own image describers and CUDA pipe
+#pragma omp parallel for
+  for(int i = 0; i < numCams; ++i)
   {
     // add the image size for this image
-    vec_imageSize.emplace_back(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
+    vec_imageSize[i] = std::make_pair(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
 
-    image::Image<unsigned char> imageGrayUChar; // uchar image copy for uchar image describer
+    std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+    imageDescribers.reserve(_imageDescribers.size());
+    for(const auto& imageDescriber : _imageDescribers)
+      imageDescribers.push_back(feature::createImageDescriber(imageDescriber->getDescriberType()));
 
     // extract descriptors and features from each image
-    for(auto& imageDescriber: _imageDescribers)
-    {
-      ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType()) << " from query image...");
-      imageDescriber->describe(vec_imageGrey[i], vec_queryRegions[i][imageDescriber->getDescriberType()]);
-
-      if(imageDescriber->useFloatImage())
-      {
-        imageDescriber->describe(vec_imageGrey[i], vec_queryRegions[i][imageDescriber->getDescriberType()]);
-      }
-      else
-      {
-        // image descriptor can't use float image
-        if(imageGrayUChar.Width() == 0) // the first time, convert the float buffer to uchar
-          imageGrayUChar = (vec_imageGrey.at(i).GetMat() * 255.f).cast<unsigned char>();
-        imageDescriber->describe(imageGrayUChar, vec_queryRegions[i][imageDescriber->getDescriberType()]);
-      }
-      ALICEVISION_LOG_DEBUG("[features]\tExtract done: found " <<  vec_queryRegions[i][imageDescriber->getDescriberType()]->RegionCount() << " features");
-    }
+    extractRegions(vec_imageGrey[i], parameters, imageDescribers, _cudaPipe + i, vec_queryRegions[i]);
     ALICEVISION_LOG_DEBUG("[features]\tAll descriptors extracted. Found " <<  vec_queryRegions[i].getNbAllRegions() << " features");
   }
   assert(vec_imageSize.size() == vec_queryRegions.size());
@@ -1269,10 +1715,10 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
   std::vector<Mat> vec_pts3D(numCams);
   std::vector<Mat> vec_pts2D(numCams);
 
-  // for each camera retrieve the associations
-  //@todo parallelize?
-  size_t numAssociations = 0;
-  for(std::size_t camID = 0; camID < numCams; ++camID)
+  // for each camera retrieve the associations, all the cameras at the same time
+  std::size_t numAssociations = 0;
+#pragma omp parallel for reduction(+:numAssociations)
+  for(int camID = 0; camID < numCams; ++camID)
   {
 
     // this map is used to collect the 2d-3d associations as we go through the images
@@ -1516,13 +1962,24 @@ bool VoctreeLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPe
   assert(numCams==vec_imageSize.size());
 
   vec_localizationResults.resize(numCams);
+
+  const Parameters *param = static_cast<const Parameters *>(parameters);
+  if(!param)
+  {
+    // error!
+    throw std::invalid_argument("The parameters are not in the right format!!");
+  }
+
+  // the previous frame of the frame buffer belongs to another camera of the rig
+  Parameters cameraParam = *param;
+  cameraParam._useTracking = false;
     
-  // this is basic, just localize each camera alone
-  //@todo parallelize?
-  std::vector<bool> isLocalized(numCams, false);
-  for(size_t i = 0; i < numCams; ++i)
+  // this is basic, just localize each camera alone, all the cameras at the same time
+  std::vector<char> isLocalized(numCams, false);
+#pragma omp parallel for
+  for(int i = 0; i < numCams; ++i)
   {
-    isLocalized[i] = localize(vec_queryRegions[i], vec_imageSize[i], parameters, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
+    isLocalized[i] = localize(vec_queryRegions[i], vec_imageSize[i], &cameraParam, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
     assert(isLocalized[i] == vec_localizationResults[i].isValid());
     if(!isLocalized[i])
     {
@@ -22,6 +22,9 @@
 
 #include <flann/algorithms/dist.h>
 
+#include <functional>
+#include <mutex>
+
 namespace aliceVision {
 namespace localization {
 
@@ -34,6 +37,23 @@ struct FrameData
   feature::MapRegionsPerDesc _regions;
 };
 
+/**
+ * @brief A frame of a sequence to localize with VoctreeLocalizer::localizeSequence
+ */
+struct SequenceFrame
+{
+  /// index of the frame in the sequence
+  std::size_t frameId = 0;
+  /// the input greyscale image
+  image::Image<float> imageGrey;
+  /// the camera intrinsics, estimated or refined by the localization
+  camera::PinholeRadialK3 queryIntrinsics;
+  /// use the queryIntrinsics as known calibration
+  bool useInputIntrinsics = false;
+  /// complete path to the image, used only for debugging purposes
+  std::string imagePath;
+};
+
 class VoctreeLocalizer : public ILocalizer
 {
 public:
@@ -55,6 +75,9 @@ public:
       , _ccTagUseCuda(true)
       , _matchingError(std::numeric_limits<double>::infinity())
       , _nbFrameBufferMatching(10)
+      , _useTracking(false)
+      , _trackingWindow(20.0)
+      , _trackingMinInliers(50)
     {}
     
     /// Enable/disable guided matching when matching images
@@ -75,6 +98,13 @@ public:
     double _matchingError;
     /// maximum capacity of the frame buffer
     std::size_t _nbFrameBufferMatching;
+    /// for algorithm AllResults, localize the frames of a sequence by tracking the
+    /// landmarks of the previous frame, the database is queried only if the tracking fails
+    bool _useTracking;
+    /// radius (in pixels) of the search window around the projection of a tracked landmark
+    double _trackingWindow;
+    /// minimum number of inliers to accept a frame localized by tracking
+    std::size_t _trackingMinInliers;
   };
   
 public:
@@ -92,6 +122,9 @@ public:
    * when all the documents are added.
    * @param[in] matchingDescTypes List of descriptor types to use for feature matching.
    * @param[in] voctreeDescType Descriptor type used for image matching with voctree.
+   * @param[in] localizationDatabaseFolder Optional path to a localization database
+   * prebuilt with saveLocalizationDatabase, if provided the reconstructed regions and the
+   * voctree documents are loaded from it instead of the features of the scene.
    *
    * It enable the use of combined SIFT and CCTAG features.
    */
@@ -99,13 +132,23 @@ public:
                    const std::string &descriptorsFolder,
                    const std::string &vocTreeFilepath,
                    const std::string &weightsFilepath,
-                   const std::vector<feature::EImageDescriberType>& matchingDescTypes
+                   const std::vector<feature::EImageDescriberType>& matchingDescTypes,
+                   const std::string &localizationDatabaseFolder = std::string()
                   );
   
   void setCudaPipe( int i ) override
   {
       _cudaPipe = i;
   }
+
+  /**
+   * @brief Save the reconstructed regions and the voctree documents of the localizer
+   * in a localization database folder, to initialize the next localizers of the scene.
+   *
+   * @param[in] folder The localization database folder.
+   * @see localization::saveLocalizationDatabase
+   */
+  void saveLocalizationDatabase(const std::string& folder) const;
   
   /**
    * @brief Just a wrapper around the different localization algorithm, the algorithm
@@ -152,6 +195,43 @@ public:
                 const std::string& imagePath = std::string()) override;
   
   
+  /**
+   * @brief Localize the frames of a sequence with a pipeline of three stages running
+   * at the same time: the features extraction of a frame, the matching of the previous
+   * frame with the database and the pose estimation and refinement of the frame before.
+   *
+   * The stages are connected by bounded queues, so at most \p queueSize frames wait
+   * between two stages, and the frames are delivered in the sequence order.
+   * The matching of a frame with the frame buffer does not use the frames that are
+   * still in the pose estimation stage.
+   * For the algorithms other than AllResults, the matching and the pose estimation
+   * are done in the last stage.
+   *
+   * @param[in] readFrame Called from the extraction stage to read the next frame,
+   * returns false at the end of the sequence.
+   * @param[in] param The parameters for the localization.
+   * @param[in] onLocalized Called from the pose estimation stage for each frame, in order,
+   * with the frame (and its estimated intrinsics) and the localization result.
+   * @param[in] queueSize The maximum number of frames waiting between two stages.
+   */
+  void localizeSequence(const std::function<bool(SequenceFrame&)>& readFrame,
+                        const LocalizerParameters* param,
+                        const std::function<void(const SequenceFrame&, const LocalizationResult&)>& onLocalized,
+                        std::size_t queueSize = 2);
+
+  /**
+   * @brief Extract the features of a query image with the image describers of the localizer.
+   *
+   * @param[in] imageGrey The input greyscale image.
+   * @param[in] param The parameters for the localization.
+   * @param[out] queryRegions The features of the query image.
+   * @param[in] imagePath Optional complete path to the image, used only for debugging purposes.
+   */
+  void extractRegions(const image::Image<float>& imageGrey,
+                      const LocalizerParameters* param,
+                      feature::MapRegionsPerDesc& queryRegions,
+                      const std::string& imagePath = std::string());
+
   bool localizeRig(const std::vector<image::Image<float>> & vec_imageGrey,
                    const LocalizerParameters *param,
                    std::vector<camera::PinholeRadialK3 > &vec_queryIntrinsics,
@@ -265,6 +345,83 @@ public:
                           const std::string& imagePath = std::string()) const;
 
 private:
+  /**
+   * @brief Retrieve the 2D-3D associations of the query image by tracking the landmarks
+   * of the last localized frame of the frame buffer: the landmarks are projected with
+   * the pose of this frame and matched with the query features in a window around
+   * their projection.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] imageSize The size of the input image
+   * @param[in] param The parameters for the localization
+   * @param[out] out_occurences The 2D-3D associations
+   * @param[out] out_pt2D output matrix of 2D points
+   * @param[out] out_pt3D output matrix of 3D points
+   * @param[out] out_descTypes output vector of describerType
+   * @return true if there are enough associations to estimate the pose
+   */
+  bool getAssociationsFromTracking(const feature::MapRegionsPerDesc& queryRegions,
+                                   const std::pair<std::size_t, std::size_t>& imageSize,
+                                   const Parameters& param,
+                                   OccurenceMap& out_occurences,
+                                   Mat& out_pt2D,
+                                   Mat& out_pt3D,
+                                   std::vector<feature::EImageDescriberType>& out_descTypes) const;
+
+  /**
+   * @brief Recopy the 2D and 3D points of the 2D-3D associations in the matching structure.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] occurences The 2D-3D associations
+   * @param[out] out_pt2D output matrix of 2D points
+   * @param[out] out_pt3D output matrix of 3D points
+   * @param[out] out_descTypes output vector of describerType
+   */
+  void getAssociationsPoints(const feature::MapRegionsPerDesc& queryRegions,
+                             const OccurenceMap& occurences,
+                             Mat& out_pt2D,
+                             Mat& out_pt3D,
+                             std::vector<feature::EImageDescriberType>& out_descTypes) const;
+
+  /**
+   * @brief Add a localized frame to the frame buffer, used for the frame buffer
+   * matching and the tracking of the next frames.
+   *
+   * @param[in] param The parameters for the localization
+   * @param[in] localizationResult The localization result of the frame
+   * @param[in] queryRegions The features of the frame
+   */
+  void addToFrameBuffer(const Parameters& param,
+                        const LocalizationResult& localizationResult,
+                        const feature::MapRegionsPerDesc& queryRegions);
+
+  /**
+   * @brief Estimate and refine the pose of the query image from its 2D-3D associations,
+   * the second part of localizeAllResults.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] imageSize The size of the input image
+   * @param[in] param The parameters for the localization
+   * @param[in] useInputIntrinsics Uses the \p queryIntrinsics as known calibration
+   * @param[in,out] queryIntrinsics Intrinsic parameters of the camera
+   * @param[in] occurences The 2D-3D associations
+   * @param[in,out] resectionData The 2D-3D correspondences of the associations
+   * @param[in] matchedImages The matched images of the database
+   * @param[out] localizationResult The localization result
+   * @param[in] imagePath Optional complete path to the image, used only for debugging purposes
+   * @return true if the localization is successful
+   */
+  bool localizeFromAssociations(const feature::MapRegionsPerDesc& queryRegions,
+                                const std::pair<std::size_t, std::size_t>& imageSize,
+                                const Parameters& param,
+                                bool useInputIntrinsics,
+                                camera::PinholeRadialK3& queryIntrinsics,
+                                const OccurenceMap& occurences,
+                                sfm::ImageLocalizerMatchData& resectionData,
+                                const std::vector<voctree::DocMatch>& matchedImages,
+                                LocalizationResult& localizationResult,
+                                const std::string& imagePath = std::string());
+
   /**
    * @brief Load the vocabulary tree.
 
@@ -281,6 +438,34 @@ private:
                     const std::string & weightsFilepath,
                     const std::string & featFolder);
 
+  /**
+   * @brief Load the reconstructed regions and the voctree documents from a localization database,
+   * the vocabulary tree must be loaded.
+   * @param[in] weightsFilepath Optional path to the weights of the vocabulary tree,
+   * if not provided the weights of the localization database are used.
+   * @param[in] localizationDatabaseFolder The localization database folder.
+   * @return true if everything went ok
+   */
+  bool loadLocalizationDatabase(const std::string & weightsFilepath,
+                                const std::string & localizationDatabaseFolder);
+
+  /**
+   * @brief Extract the features of a query image with the given image describers.
+   *
+   * @param[in] imageGrey The input greyscale image.
+   * @param[in] param The parameters for the localization.
+   * @param[in] imageDescribers The image describers to use.
+   * @param[in] cudaPipe The CUDA pipe of the image describers.
+   * @param[out] queryRegions The features of the query image.
+   * @param[in] imagePath Optional complete path to the image, used only for debugging purposes.
+   */
+  static void extractRegions(const image::Image<float>& imageGrey,
+                             const LocalizerParameters* param,
+                             const std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                             int cudaPipe,
+                             feature::MapRegionsPerDesc& queryRegions,
+                             const std::string& imagePath = std::string());
+
   /**
    * @brief robustMatching
    *
@@ -353,6 +538,8 @@ public:
   
   /// Last frames buffer
   BoundedBuffer<FrameData> _frameBuffer;
+  /// Last frames buffer mutex, the frames are added and matched in different stages of localizeSequence
+  mutable std::mutex _frameBufferMutex;
 
   matching::EMatcherType _matcherType = matching::ANN_L2;
 };
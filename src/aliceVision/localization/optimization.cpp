@@ -20,6 +20,8 @@
 #include <boost/accumulators/statistics/max.hpp>
 #include <boost/accumulators/statistics/sum.hpp>
 
+#include <algorithm>
+
 namespace aliceVision{
 namespace localization{
 
@@ -337,6 +339,122 @@ bool refineSequence(std::vector<LocalizationResult> & vec_localizationResult,
   return b_BA_Status;
 }
 
+SequenceRefiner::SequenceRefiner(std::size_t windowSize, std::size_t nbConstantFrames, bool refineIntrinsics)
+  : _windowSize(std::max(windowSize, std::size_t(1)))
+  , _nbConstantFrames(nbConstantFrames)
+  , _refineIntrinsics(refineIntrinsics)
+{
+  sfm::BundleAdjustmentCeres::CeresOptions options(false /*verbose*/, false /*multithreaded*/);
+  // only the blocks of the new and removed frames change between two refinements
+  options.usePersistentProblem = true;
+  _bundleAdjustment.reset(new sfm::BundleAdjustmentCeres(options));
+}
+
+SequenceRefiner::~SequenceRefiner() = default;
+
+bool SequenceRefiner::refineFrame(std::size_t frameId, LocalizationResult& localizationResult)
+{
+  if(!localizationResult.isValid())
+    return false;
+
+  assert(_frames.empty() || _frames.back() < frameId);
+
+  // the id for the instrinsic group
+  const IndexT intrinsicID = 0;
+
+  // the intrinsics of the first frame, refined with the sequence
+  if(_scene.intrinsics.empty())
+    _scene.intrinsics[intrinsicID] = std::make_shared<camera::PinholeRadialK3>(localizationResult.getIntrinsics());
+
+  const IndexT viewID = static_cast<IndexT>(frameId);
+
+  // view
+  std::shared_ptr<sfmData::View> view = std::make_shared<sfmData::View>("", viewID, intrinsicID, viewID);
+  _scene.views.insert(std::make_pair(viewID, view));
+  // pose
+  _scene.setPose(*view, sfmData::CameraPose(localizationResult.getPose()));
+
+  // structure data (2D-3D correspondences)
+  const std::vector<IndMatch3D2D>& matches = localizationResult.getIndMatch3D2D();
+
+  for(const std::size_t idx : localizationResult.getInliers())
+  {
+    assert(idx < localizationResult.getPt3D().cols());
+    const IndMatch3D2D& match = matches[idx];
+    const Vec2& feature = localizationResult.getPt2D().col(idx);
+
+    sfmData::Landmark& landmark = _scene.structure[match.landmarkId];
+
+    if(landmark.observations.empty())
+    {
+      landmark.descType = match.descType;
+      landmark.X = localizationResult.getPt3D().col(idx);
+    }
+    else if(landmark.observations.count(viewID) != 0)
+    {
+      // multiple features of the frame associated to the same 3D point
+      continue;
+    }
+    landmark.observations[viewID] = sfmData::Observation(feature, match.featId);
+  }
+
+  _frames.push_back(frameId);
+
+  // the frame leaving the window is constant, it anchors the refined frames
+  if(_frames.size() > _windowSize)
+    _scene.getPoses().at(static_cast<IndexT>(_frames.at(_frames.size() - _windowSize - 1))).lock();
+
+  while(_frames.size() > _windowSize + _nbConstantFrames)
+    removeOldestFrame();
+
+  sfm::BundleAdjustment::ERefineOptions refineOptions = sfm::BundleAdjustment::REFINE_ROTATION | sfm::BundleAdjustment::REFINE_TRANSLATION;
+  if(_refineIntrinsics)
+    refineOptions |= sfm::BundleAdjustment::REFINE_INTRINSICS_ALL;
+
+  if(!_bundleAdjustment->adjust(_scene, refineOptions))
+  {
+    ALICEVISION_LOG_DEBUG("Sequence refinement failed for frame " << frameId);
+    return false;
+  }
+
+  localizationResult.setPose(_scene.getPoses().at(viewID).getTransform());
+  if(_refineIntrinsics)
+    localizationResult.updateIntrinsics(_scene.intrinsics.at(intrinsicID)->getParams());
+
+  ALICEVISION_LOG_DEBUG("Frame " << frameId << " refined with " << std::min(_frames.size(), _windowSize) << " frames, "
+                        << _scene.structure.size() << " points");
+  return true;
+}
+
+void SequenceRefiner::getWindowPoses(std::map<std::size_t, geometry::Pose3>& poses) const
+{
+  poses.clear();
+  for(const std::size_t frameId : _frames)
+  {
+    const sfmData::CameraPose& cameraPose = _scene.getPoses().at(static_cast<IndexT>(frameId));
+    if(!cameraPose.isLocked())
+      poses[frameId] = cameraPose.getTransform();
+  }
+}
+
+void SequenceRefiner::removeOldestFrame()
+{
+  const IndexT viewID = static_cast<IndexT>(_frames.front());
+  _frames.pop_front();
+
+  for(auto landmarkIt = _scene.structure.begin(); landmarkIt != _scene.structure.end();)
+  {
+    landmarkIt->second.observations.erase(viewID);
+    if(landmarkIt->second.observations.empty())
+      landmarkIt = _scene.structure.erase(landmarkIt);
+    else
+      ++landmarkIt;
+  }
+
+  _scene.getPoses().erase(viewID);
+  _scene.views.erase(viewID);
+}
+
 bool refineRigPose(const std::vector<geometry::Pose3 > &vec_subPoses,
                    const std::vector<localization::LocalizationResult> & vec_localizationResults,
                    geometry::Pose3 & rigPose)
@@ -9,12 +9,21 @@
 #include "LocalizationResult.hpp"
 #include <aliceVision/camera/PinholeRadial.hpp>
 #include <aliceVision/geometry/Pose3.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
 
+#include <deque>
+#include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <tuple>
 
 namespace aliceVision{
+
+namespace sfm {
+class BundleAdjustmentCeres;
+}
+
 namespace localization{
 
 /**
@@ -49,6 +58,59 @@ bool refineSequence(std::vector<LocalizationResult> & vec_localizationResult,
                     const std::string & outputFilename = "",
                     std::size_t minPointVisibility = 0);
 
+/**
+ * @brief Sliding window refinement of a sequence of camera poses, to refine online
+ * the poses of a long sequence: each new localized frame is refined with the last
+ * \p windowSize frames and their 2D-3D associations, with a single camera having
+ * the same internal parameters for the whole sequence.
+ * The frames leaving the window are kept constant for \p nbConstantFrames more frames
+ * to anchor the window, then they are removed. The bundle adjustment problem is kept
+ * between the frames, so the refinement cost of a frame is bounded by the window size
+ * and not by the length of the sequence.
+ */
+class SequenceRefiner
+{
+public:
+
+  /**
+   * @param[in] windowSize The number of frames refined with each new frame.
+   * @param[in] nbConstantFrames The number of constant frames kept before the window.
+   * @param[in] refineIntrinsics Whether to refine the camera parameters.
+   */
+  SequenceRefiner(std::size_t windowSize, std::size_t nbConstantFrames = 3, bool refineIntrinsics = true);
+
+  ~SequenceRefiner();
+
+  /**
+   * @brief Add a localized frame to the window and refine the frames of the window.
+   * @param[in] frameId The index of the frame in the sequence, increasing.
+   * @param[in,out] localizationResult The localization result of the frame, its pose
+   * (and intrinsics) are updated if the refinement succeeds.
+   * @return true if the refinement succeeds.
+   */
+  bool refineFrame(std::size_t frameId, LocalizationResult& localizationResult);
+
+  /**
+   * @brief Get the refined poses of the frames of the window, including the new frame.
+   * @param[out] poses The pose of each frame of the window.
+   */
+  void getWindowPoses(std::map<std::size_t, geometry::Pose3>& poses) const;
+
+private:
+  /// remove the oldest frame of the scene and its observations
+  void removeOldestFrame();
+
+  std::size_t _windowSize;
+  std::size_t _nbConstantFrames;
+  bool _refineIntrinsics;
+  /// the frames of the window and the constant frames, one view and pose per frame
+  sfmData::SfMData _scene;
+  /// the frames of the scene, oldest first
+  std::deque<std::size_t> _frames;
+  /// the bundle adjustment with its persistent problem
+  std::unique_ptr<sfm::BundleAdjustmentCeres> _bundleAdjustment;
+};
+
 /**
  * @brief refine the pose of a camera rig by minimizing the reprojection error in
  * each camera with the bundle adjustment.
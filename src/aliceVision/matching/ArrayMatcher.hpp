@@ -9,6 +9,7 @@
 
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
+#include "aliceVision/feature/DescriptorSpan.hpp"
 
 #include <vector>
 
@@ -38,6 +39,19 @@ class ArrayMatcher
    */
   virtual bool Build( const Scalar * dataset, int nbRows, int dimension)=0;
 
+  /**
+   * Build the matching structure from a non-owning descriptor view.
+   * The descriptors memory is not copied and must outlive the matcher.
+   *
+   * \param[in] dataset   Input descriptors.
+   *
+   * \return True if success.
+   */
+  bool Build( const feature::DescriptorSpan<Scalar> & dataset)
+  {
+    return Build(dataset.data(), static_cast<int>(dataset.count()), static_cast<int>(dataset.dimension()));
+  }
+
   /**
    * Search the nearest Neighbor of the scalar array query.
    *
@@ -68,6 +82,25 @@ class ArrayMatcher
                                   IndMatches * indices,
                                   std::vector<DistanceType> * distances,
                                   size_t NN)=0;
+
+  /**
+   * Search the N nearest Neighbor of each descriptor of a non-owning descriptor view.
+   *
+   * \param[in]   query     The query descriptors
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[out]  NN        The number of maximal neighbor that could
+   *  will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours( const feature::DescriptorSpan<Scalar> & query,
+                         IndMatches * indices,
+                         std::vector<DistanceType> * distances,
+                         size_t NN)
+  {
+    return SearchNeighbours(query.data(), static_cast<int>(query.count()), indices, distances, NN);
+  }
 };
 
 }  // namespace matching
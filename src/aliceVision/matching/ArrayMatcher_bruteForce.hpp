@@ -25,6 +25,9 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
   public:
   typedef typename Metric::ResultType DistanceType;
 
+  using ArrayMatcher<Scalar, Metric>::Build;
+  using ArrayMatcher<Scalar, Metric>::SearchNeighbours;
+
   ArrayMatcher_bruteForce()   {}
   virtual ~ArrayMatcher_bruteForce() {
     memMapping.reset();
@@ -0,0 +1,200 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/config.hpp>
+#include <aliceVision/matching/ArrayMatcher.hpp>
+#include <aliceVision/matching/ArrayMatcher_bruteForce.hpp>
+#include <aliceVision/matching/metric.hpp>
+#include <aliceVision/matching/Hamming.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/matching/cuda/bruteForceMatching.hpp>
+#endif
+
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Metric traits of the GPU brute force matcher
+ * @note supported is false if the scalar and metric types have no GPU implementation.
+ */
+template<typename Scalar, typename Metric>
+struct BruteForceCudaMetric
+{
+  static const bool supported = false;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  /// not used, unsupported types are matched on the CPU
+  static constexpr cuda::EDeviceMetric metric = cuda::EDeviceMetric::L2_FLOAT;
+#endif
+};
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+
+template<>
+struct BruteForceCudaMetric<float, L2_Simple<float>>
+{
+  static const bool supported = true;
+  static constexpr cuda::EDeviceMetric metric = cuda::EDeviceMetric::L2_FLOAT;
+};
+
+template<>
+struct BruteForceCudaMetric<float, L2_Vectorized<float>>
+{
+  static const bool supported = true;
+  static constexpr cuda::EDeviceMetric metric = cuda::EDeviceMetric::L2_FLOAT;
+};
+
+template<>
+struct BruteForceCudaMetric<unsigned char, L2_Simple<unsigned char>>
+{
+  static const bool supported = true;
+  static constexpr cuda::EDeviceMetric metric = cuda::EDeviceMetric::L2_UCHAR;
+};
+
+template<>
+struct BruteForceCudaMetric<unsigned char, L2_Vectorized<unsigned char>>
+{
+  static const bool supported = true;
+  static constexpr cuda::EDeviceMetric metric = cuda::EDeviceMetric::L2_UCHAR;
+};
+
+template<>
+struct BruteForceCudaMetric<unsigned char, Hamming<unsigned char>>
+{
+  static const bool supported = true;
+  static constexpr cuda::EDeviceMetric metric = cuda::EDeviceMetric::HAMMING;
+};
+
+#endif
+
+/**
+ * @brief Brute force matcher computing the 2 nearest neighbours on the GPU.
+ *
+ * The dataset descriptors are copied once on the current CUDA device in Build(),
+ * all the queries of a Regions are then matched with a single kernel call.
+ * Without CUDA device, with more than 2 neighbours or with an unsupported metric,
+ * the CPU brute force matcher is used.
+ */
+template < typename Scalar = float, typename Metric = L2_Simple<Scalar> >
+class ArrayMatcher_bruteForceCuda : public ArrayMatcher<Scalar, Metric>
+{
+  public:
+  typedef typename Metric::ResultType DistanceType;
+
+  using ArrayMatcher<Scalar, Metric>::Build;
+  using ArrayMatcher<Scalar, Metric>::SearchNeighbours;
+
+  ArrayMatcher_bruteForceCuda() {}
+  virtual ~ArrayMatcher_bruteForceCuda() {}
+
+  /**
+   * Build the matching structure
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build(const Scalar * dataset, int nbRows, int dimension)
+  {
+    _nbRows = nbRows;
+
+    if(!_cpuMatcher.Build(dataset, nbRows, dimension))
+      return false;
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    _deviceDataset.clear();
+
+    const std::size_t rowSize = dimension * sizeof(Scalar);
+    if(BruteForceCudaMetric<Scalar, Metric>::supported && cuda::supportBruteForceMatching(rowSize))
+    {
+      if(!_deviceDataset.upload(dataset, nbRows, rowSize))
+        ALICEVISION_LOG_DEBUG("Can't upload the descriptors on the GPU, use CPU brute force matching.");
+    }
+#endif
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour( const Scalar * query,
+                        int * indice, DistanceType * distance)
+  {
+    return _cpuMatcher.SearchNeighbour(query, indice, distance);
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[out]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  )
+  {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    if(!_deviceDataset.empty() && NN <= 2 && NN <= static_cast<size_t>(_nbRows) && nbQuery > 0)
+    {
+      std::vector<int> indices(2 * nbQuery);
+      std::vector<float> distances(2 * nbQuery);
+
+      if(cuda::bruteForceMatching2NN(_deviceDataset, query, nbQuery, BruteForceCudaMetric<Scalar, Metric>::metric, indices.data(), distances.data()))
+      {
+        pvec_distances->resize(nbQuery * NN);
+        pvec_indices->resize(nbQuery * NN);
+
+        for(int queryIndex = 0; queryIndex < nbQuery; ++queryIndex)
+        {
+          for(size_t i = 0; i < NN; ++i)
+          {
+            (*pvec_distances)[queryIndex * NN + i] = static_cast<DistanceType>(distances[2 * queryIndex + i]);
+            (*pvec_indices)[queryIndex * NN + i] = IndMatch(queryIndex, indices[2 * queryIndex + i]);
+          }
+        }
+        return true;
+      }
+      ALICEVISION_LOG_WARNING("GPU brute force matching failed, use CPU brute force matching.");
+    }
+#endif
+    return _cpuMatcher.SearchNeighbours(query, nbQuery, pvec_indices, pvec_distances, NN);
+  }
+
+private:
+  /// CPU matcher, used when the GPU can't be used
+  ArrayMatcher_bruteForce<Scalar, Metric> _cpuMatcher;
+  int _nbRows = 0;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  /// dataset descriptors on the GPU
+  cuda::DeviceDescriptors _deviceDataset;
+#endif
+};
+
+}  // namespace matching
+}  // namespace aliceVision
@@ -38,6 +38,9 @@ class ArrayMatcher_cascadeHashing  : public ArrayMatcher<Scalar, Metric>
   public:
   typedef typename Metric::ResultType DistanceType;
 
+  using ArrayMatcher<Scalar, Metric>::Build;
+  using ArrayMatcher<Scalar, Metric>::SearchNeighbours;
+
   ArrayMatcher_cascadeHashing()   {}
   virtual ~ArrayMatcher_cascadeHashing() {
     memMapping.reset();
@@ -10,14 +10,44 @@
 #include <aliceVision/matching/ArrayMatcher.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
 
 #include "flann/flann.hpp"
 
+#include <cstdint>
+#include <cstdio>
 #include <memory>
+#include <random>
+#include <sstream>
+#include <string>
 
 namespace aliceVision {
 namespace matching  {
 
+/**
+ * @brief Get the file storing the kd-tree index of a dataset.
+ *
+ * The file name is the given prefix followed by a key of the descriptors
+ * (FNV-1a hash of the values), so a saved index is never used with other descriptors.
+ *
+ * @param[in] prefix The path prefix (e.g. folder/viewId.descType)
+ * @param[in] dataset The indexed descriptors
+ * @return The kd-tree index file
+ */
+template <typename Scalar>
+std::string getKdTreeIndexFilename(const std::string& prefix, const feature::DescriptorSpan<Scalar>& dataset)
+{
+  std::uint64_t key = 14695981039346656037ULL;
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(dataset.data());
+  const std::size_t size = dataset.count() * dataset.dimension() * sizeof(Scalar);
+  for (std::size_t i = 0; i < size; ++i)
+    key = (key ^ bytes[i]) * 1099511628211ULL;
+
+  std::ostringstream filename;
+  filename << prefix << "." << std::hex << key << ".kdtree";
+  return filename.str();
+}
+
 /// Implement ArrayMatcher as a FLANN KDtree matcher.
 // http://www.cs.ubc.ca/~mariusm/index.php/FLANN/FLANN
 // David G. Lowe and Marius Muja
@@ -31,6 +61,9 @@ class ArrayMatcher_kdtreeFlann : public ArrayMatcher<Scalar, Metric>
   public:
   typedef typename Metric::ResultType DistanceType;
 
+  using ArrayMatcher<Scalar, Metric>::Build;
+  using ArrayMatcher<Scalar, Metric>::SearchNeighbours;
+
   ArrayMatcher_kdtreeFlann() = default;
 
   virtual ~ArrayMatcher_kdtreeFlann() = default;
@@ -63,6 +96,61 @@ class ArrayMatcher_kdtreeFlann : public ArrayMatcher<Scalar, Metric>
     return true;
   }
 
+  /**
+   * Build the matching structure, reusing the index saved in the given file.
+   * If the file does not exist or can't be used, the index is built and saved
+   * in the file for the next builds (in this process or in another one).
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the each
+   *  row of the dataset.
+   * \param[in] indexFilename The kd-tree index file (see getKdTreeIndexFilename), disabled if empty.
+   *
+   * \return True if success.
+   */
+  bool Build( const Scalar * dataset, int nbRows, int dimension, const std::string& indexFilename)
+  {
+    if (indexFilename.empty())
+      return Build(dataset, nbRows, dimension);
+
+    if (nbRows <= 0)
+      return false;
+
+    _dimension = dimension;
+    //-- Build Flann Matrix container (map to already allocated memory)
+    _datasetM.reset(
+        new flann::Matrix<Scalar>((Scalar*)dataset, nbRows, dimension));
+
+    if (loadIndex(indexFilename))
+      return true;
+
+    //-- Build FLANN index
+    _index.reset(
+        new flann::Index<Metric> (*_datasetM, flann::KDTreeIndexParams(4)));
+    _index->buildIndex();
+
+    saveIndex(indexFilename);
+    return true;
+  }
+
+  /**
+   * Build the matching structure from a non-owning descriptor view,
+   * the index is persisted in the file getKdTreeIndexFilename(indexPrefix, dataset).
+   *
+   * \param[in] dataset     Input data.
+   * \param[in] indexPrefix Path prefix of the kd-tree index file, disabled if empty.
+   *
+   * \return True if success.
+   */
+  bool Build( const feature::DescriptorSpan<Scalar> & dataset, const std::string& indexPrefix)
+  {
+    if (indexPrefix.empty())
+      return Build(dataset);
+    return Build(dataset.data(), static_cast<int>(dataset.count()), static_cast<int>(dataset.dimension()),
+                 getKdTreeIndexFilename(indexPrefix, dataset));
+  }
+
   /**
    * Search the nearest Neighbor of the scalar array query.
    *
@@ -142,6 +230,67 @@ class ArrayMatcher_kdtreeFlann : public ArrayMatcher<Scalar, Metric>
 
   private:
 
+  /**
+   * Load the index saved for the current dataset.
+   * \return false if the file does not exist or does not match the dataset.
+   */
+  bool loadIndex(const std::string& filename)
+  {
+    // flann does not report a missing file
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+      return false;
+    std::fclose(file);
+
+    try
+    {
+      _index.reset(
+          new flann::Index<Metric> (*_datasetM, flann::SavedIndexParams(filename)));
+    }
+    catch (const flann::FLANNException& e)
+    {
+      ALICEVISION_LOG_WARNING("Invalid kd-tree index file '" << filename << "': " << e.what());
+      _index.reset();
+      return false;
+    }
+
+    if (_index->size() != _datasetM->rows || _index->veclen() != _datasetM->cols)
+    {
+      ALICEVISION_LOG_WARNING("Kd-tree index file '" << filename << "' does not match the dataset.");
+      _index.reset();
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Save the index in a temporary file renamed at the end,
+   * so concurrent readers never see a partial file.
+   * A failure is not fatal: the index will be built again next time.
+   */
+  void saveIndex(const std::string& filename) const
+  {
+    std::random_device randomDevice;
+    std::ostringstream tmpFilename;
+    tmpFilename << filename << "." << std::hex << randomDevice() << randomDevice() << ".tmp";
+
+    try
+    {
+      _index->save(tmpFilename.str());
+    }
+    catch (const flann::FLANNException& e)
+    {
+      ALICEVISION_LOG_WARNING("Can't save kd-tree index file '" << tmpFilename.str() << "': " << e.what());
+      return;
+    }
+
+    if (std::rename(tmpFilename.str().c_str(), filename.c_str()) != 0)
+    {
+      ALICEVISION_LOG_WARNING("Can't save kd-tree index file '" << filename << "'.");
+      std::remove(tmpFilename.str().c_str());
+    }
+  }
+
   std::unique_ptr< flann::Matrix<Scalar> > _datasetM;
   std::unique_ptr< flann::Index<Metric> > _index;
   std::size_t _dimension;
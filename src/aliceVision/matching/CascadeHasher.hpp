@@ -10,10 +10,12 @@
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/metric.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
+#include "aliceVision/feature/DescriptorSpan.hpp"
 #include "aliceVision/stl/DynamicBitset.hpp"
 #include <iostream>
 #include <random>
 #include <cmath>
+#include <cstdint>
 
 namespace aliceVision {
 namespace matching {
@@ -74,12 +76,27 @@ public:
   CascadeHasher() {}
 
   // Creates the hashing projections (cascade of two level of hash codes)
+  // from a random seed.
   bool Init
   (
     const uint8_t nb_hash_code = 128,
     const uint8_t nb_bucket_groups = 6,
     const uint8_t nb_bits_per_bucket = 10)
   {
+    std::random_device rd;
+    return InitWithSeed(rd(), nb_hash_code, nb_bucket_groups, nb_bits_per_bucket);
+  }
+
+  // Creates the hashing projections (cascade of two level of hash codes)
+  // from the given seed, the same seed gives the same projections.
+  bool InitWithSeed
+  (
+    const uint32_t seed,
+    const uint8_t nb_hash_code = 128,
+    const uint8_t nb_bucket_groups = 6,
+    const uint8_t nb_bits_per_bucket = 10)
+  {
+    seed_ = seed;
     nb_bucket_groups_= nb_bucket_groups;
     nb_hash_code_ = nb_hash_code;
     nb_bits_per_bucket_ = nb_bits_per_bucket;
@@ -89,8 +106,7 @@ public:
     // Box Muller transform is used in the original paper to get fast random number
     // from a normal distribution with <mean = 0> and <variance = 1>.
     // Here we use C++11 normal distribution random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed);
     std::normal_distribution<> d(0,1);
 
     primary_hash_projection_.resize(nb_hash_code, nb_hash_code);
@@ -117,6 +133,35 @@ public:
     return true;
   }
 
+  uint32_t GetSeed() const { return seed_; }
+  int GetNbHashCode() const { return nb_hash_code_; }
+  int GetNbBucketGroups() const { return nb_bucket_groups_; }
+  int GetNbBitsPerBucket() const { return nb_bits_per_bucket_; }
+
+  // Returns a key identifying the hash codes created with these projections
+  // and the given zero mean descriptor (FNV-1a hash of all the parameters).
+  // Hashed descriptions created with the same key are interchangeable.
+  uint64_t GetKey
+  (
+    const Eigen::VectorXf & zero_mean_descriptor
+  ) const
+  {
+    uint64_t key = 14695981039346656037ULL;
+    const auto hashBytes = [&key](const void* data, std::size_t size)
+    {
+      const unsigned char* bytes = static_cast<const unsigned char*>(data);
+      for (std::size_t i = 0; i < size; ++i)
+        key = (key ^ bytes[i]) * 1099511628211ULL;
+    };
+    const int32_t params[] = {nb_hash_code_, nb_bucket_groups_, nb_bits_per_bucket_};
+    hashBytes(params, sizeof(params));
+    hashBytes(primary_hash_projection_.data(), primary_hash_projection_.size() * sizeof(float));
+    for (const Eigen::MatrixXf & projection : secondary_hash_projection_)
+      hashBytes(projection.data(), projection.size() * sizeof(float));
+    hashBytes(zero_mean_descriptor.data(), zero_mean_descriptor.size() * sizeof(float));
+    return key;
+  }
+
   template <typename MatrixT>
   static Eigen::VectorXf GetZeroMeanDescriptor
   (
@@ -139,6 +184,15 @@ public:
   }
 
 
+  template <typename Scalar>
+  static Eigen::VectorXf GetZeroMeanDescriptor
+  (
+    const feature::DescriptorSpan<Scalar> & descriptions
+  )
+  {
+    return GetZeroMeanDescriptor(descriptions.asMatrix());
+  }
+
   template <typename MatrixT>
   HashedDescriptions CreateHashedDescriptions
   (
@@ -197,22 +251,39 @@ public:
         }
       }
     }
-    // Build the Buckets
+    BuildBuckets(hashed_descriptions);
+    return hashed_descriptions;
+  }
+
+  // Builds the buckets from the bucket ids of each hashed description.
+  void BuildBuckets
+  (
+    HashedDescriptions & hashed_descriptions
+  ) const
+  {
+    hashed_descriptions.buckets.clear();
+    hashed_descriptions.buckets.resize(nb_bucket_groups_);
+    for (int i = 0; i < nb_bucket_groups_; ++i)
     {
-      hashed_descriptions.buckets.resize(nb_bucket_groups_);
-      for (int i = 0; i < nb_bucket_groups_; ++i)
-      {
-        hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
+      hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
 
-        // Add the descriptor ID to the proper bucket group and id.
-        for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
-        {
-          const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
-          hashed_descriptions.buckets[i][bucket_id].push_back(j);
-        }
+      // Add the descriptor ID to the proper bucket group and id.
+      for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
+      {
+        const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
+        hashed_descriptions.buckets[i][bucket_id].push_back(j);
       }
     }
-    return hashed_descriptions;
+  }
+
+  template <typename Scalar>
+  HashedDescriptions CreateHashedDescriptions
+  (
+    const feature::DescriptorSpan<Scalar> & descriptions,
+    const Eigen::VectorXf & zero_mean_descriptor
+  ) const
+  {
+    return CreateHashedDescriptions(descriptions.asMatrix(), zero_mean_descriptor);
   }
 
   // Matches two collection of hashed descriptions with a fast matching scheme
@@ -338,7 +409,30 @@ public:
     }
   }
 
+  // Matches two collection of hashed descriptions stored in non-owning descriptor views.
+  template <typename Scalar, typename DistanceType>
+  void Match_HashedDescriptions
+  (
+    const HashedDescriptions& hashed_descriptions1,
+    const feature::DescriptorSpan<Scalar> & descriptions1,
+    const HashedDescriptions& hashed_descriptions2,
+    const feature::DescriptorSpan<Scalar> & descriptions2,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    const int NN = 2
+  ) const
+  {
+    typedef typename feature::DescriptorSpan<Scalar>::ConstMapT MatrixT;
+    Match_HashedDescriptions<MatrixT, DistanceType>(
+      hashed_descriptions1, descriptions1.asMatrix(),
+      hashed_descriptions2, descriptions2.asMatrix(),
+      pvec_indices, pvec_distances, NN);
+  }
+
   private:
+  // The seed of the hashing projections.
+  uint32_t seed_ = 0;
+
   // Primary hashing function.
   Eigen::MatrixXf primary_hash_projection_;
 
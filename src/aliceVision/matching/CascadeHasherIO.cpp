@@ -0,0 +1,247 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CascadeHasherIO.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace matching {
+
+namespace {
+
+/// Fixed size header of a cascade hasher file, followed by the zero mean descriptor
+struct CascadeHasherFileHeader
+{
+  std::uint32_t magic = CASCADE_HASHER_FILE_MAGIC;
+  std::uint32_t version = CASCADE_HASHING_FILE_VERSION;
+  std::uint32_t seed = 0;
+  std::uint32_t nbHashCode = 0;
+  std::uint32_t nbBucketGroups = 0;
+  std::uint32_t nbBitsPerBucket = 0;
+  /// number of values of the zero mean descriptor
+  std::uint32_t dimension = 0;
+  std::uint32_t reserved = 0;
+};
+
+static_assert(sizeof(CascadeHasherFileHeader) == 32, "Unexpected CascadeHasherFileHeader size.");
+
+/// Fixed size header of a hashed descriptions file, followed by
+/// the hash codes (count * hashCodeSize bytes) and the bucket ids (count * nbBucketGroups uint16)
+struct HashedDescriptionsFileHeader
+{
+  std::uint32_t magic = HASHED_DESCRIPTIONS_FILE_MAGIC;
+  std::uint32_t version = CASCADE_HASHING_FILE_VERSION;
+  /// key of the hasher used to create the hash codes
+  std::uint64_t key = 0;
+  /// number of hashed descriptions
+  std::uint64_t count = 0;
+  /// size in bytes of one hash code
+  std::uint32_t hashCodeSize = 0;
+  std::uint32_t nbBucketGroups = 0;
+};
+
+static_assert(sizeof(HashedDescriptionsFileHeader) == 32, "Unexpected HashedDescriptionsFileHeader size.");
+
+/// Write the buffer in a temporary file renamed at the end, so concurrent readers never see a partial file
+void writeFileAtomically(const std::string& filename, const std::vector<char>& buffer)
+{
+  const fs::path bPath = fs::path(filename);
+  const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+  {
+    std::ofstream file(tmpPath, std::ios::out | std::ios::binary);
+
+    if(!file.is_open())
+      throw std::runtime_error("Can't save cascade hashing file, can't open '" + tmpPath + "' !");
+
+    file.write(buffer.data(), buffer.size());
+
+    if(!file.good())
+      throw std::runtime_error("Can't save cascade hashing file, '" + tmpPath + "' is incorrect !");
+  }
+
+  fs::rename(tmpPath, filename);
+}
+
+/// Read the whole file, return false if it does not exist or can't be read
+bool readFile(const std::string& filename, std::vector<char>& buffer)
+{
+  std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+
+  if(!file.is_open())
+    return false;
+
+  buffer.resize(static_cast<std::size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(buffer.data(), buffer.size());
+  return file.good();
+}
+
+template<typename T>
+void append(std::vector<char>& buffer, const T* data, std::size_t count)
+{
+  const char* bytes = reinterpret_cast<const char*>(data);
+  buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+}
+
+} // namespace
+
+void saveCascadeHasher(const std::string& filename,
+                       const CascadeHasher& hasher,
+                       const Eigen::VectorXf& zeroMeanDescriptor)
+{
+  CascadeHasherFileHeader header;
+  header.seed = hasher.GetSeed();
+  header.nbHashCode = hasher.GetNbHashCode();
+  header.nbBucketGroups = hasher.GetNbBucketGroups();
+  header.nbBitsPerBucket = hasher.GetNbBitsPerBucket();
+  header.dimension = zeroMeanDescriptor.size();
+
+  std::vector<char> buffer;
+  append(buffer, &header, 1);
+  append(buffer, zeroMeanDescriptor.data(), zeroMeanDescriptor.size());
+
+  writeFileAtomically(filename, buffer);
+}
+
+bool loadCascadeHasher(const std::string& filename,
+                       std::size_t dimension,
+                       CascadeHasher& hasher,
+                       Eigen::VectorXf& zeroMeanDescriptor)
+{
+  std::vector<char> buffer;
+  if(!readFile(filename, buffer))
+    return false;
+
+  CascadeHasherFileHeader header;
+  if(buffer.size() < sizeof(header))
+  {
+    ALICEVISION_LOG_WARNING("Invalid cascade hasher file: " << filename);
+    return false;
+  }
+  std::memcpy(&header, buffer.data(), sizeof(header));
+
+  if(header.magic != CASCADE_HASHER_FILE_MAGIC ||
+     header.version != CASCADE_HASHING_FILE_VERSION ||
+     buffer.size() != sizeof(header) + header.dimension * sizeof(float))
+  {
+    ALICEVISION_LOG_WARNING("Invalid cascade hasher file: " << filename);
+    return false;
+  }
+
+  if(header.dimension != dimension || header.nbHashCode != dimension)
+  {
+    ALICEVISION_LOG_WARNING("Cascade hasher file '" << filename << "' does not match the descriptor dimension (" << dimension << ").");
+    return false;
+  }
+
+  hasher.InitWithSeed(header.seed, header.nbHashCode, header.nbBucketGroups, header.nbBitsPerBucket);
+
+  zeroMeanDescriptor.resize(header.dimension);
+  std::memcpy(zeroMeanDescriptor.data(), buffer.data() + sizeof(header), header.dimension * sizeof(float));
+  return true;
+}
+
+void saveHashedDescriptions(const std::string& filename,
+                            const HashedDescriptions& hashedDescriptions,
+                            std::uint64_t key)
+{
+  const std::vector<HashedDescription>& hashedDesc = hashedDescriptions.hashed_desc;
+
+  HashedDescriptionsFileHeader header;
+  header.key = key;
+  header.count = hashedDesc.size();
+  if(!hashedDesc.empty())
+  {
+    header.hashCodeSize = hashedDesc.front().hash_code.num_blocks();
+    header.nbBucketGroups = hashedDesc.front().bucket_ids.size();
+  }
+
+  std::vector<char> buffer;
+  buffer.reserve(sizeof(header) + header.count * (header.hashCodeSize + header.nbBucketGroups * sizeof(std::uint16_t)));
+  append(buffer, &header, 1);
+  for(const HashedDescription& desc : hashedDesc)
+    append(buffer, desc.hash_code.data(), header.hashCodeSize);
+  for(const HashedDescription& desc : hashedDesc)
+    append(buffer, desc.bucket_ids.data(), header.nbBucketGroups);
+
+  writeFileAtomically(filename, buffer);
+}
+
+bool loadHashedDescriptions(const std::string& filename,
+                            const CascadeHasher& hasher,
+                            std::uint64_t key,
+                            std::size_t count,
+                            HashedDescriptions& hashedDescriptions)
+{
+  std::vector<char> buffer;
+  if(!readFile(filename, buffer))
+    return false;
+
+  HashedDescriptionsFileHeader header;
+  if(buffer.size() < sizeof(header))
+  {
+    ALICEVISION_LOG_WARNING("Invalid hashed descriptions file: " << filename);
+    return false;
+  }
+  std::memcpy(&header, buffer.data(), sizeof(header));
+
+  const std::size_t nbBits = hasher.GetNbHashCode();
+  const std::size_t hashCodeSize = stl::dynamic_bitset(nbBits).num_blocks();
+  const std::size_t nbBucketGroups = hasher.GetNbBucketGroups();
+
+  if(header.magic != HASHED_DESCRIPTIONS_FILE_MAGIC ||
+     header.version != CASCADE_HASHING_FILE_VERSION)
+  {
+    ALICEVISION_LOG_WARNING("Invalid hashed descriptions file: " << filename);
+    return false;
+  }
+
+  // created with another hasher or for other regions: recompute
+  if(header.key != key || header.count != count)
+    return false;
+
+  if(count == 0)
+  {
+    hashedDescriptions = HashedDescriptions();
+    return true;
+  }
+
+  if(header.hashCodeSize != hashCodeSize ||
+     header.nbBucketGroups != nbBucketGroups ||
+     buffer.size() != sizeof(header) + count * (hashCodeSize + nbBucketGroups * sizeof(std::uint16_t)))
+  {
+    ALICEVISION_LOG_WARNING("Invalid hashed descriptions file: " << filename);
+    return false;
+  }
+
+  const char* hashCodes = buffer.data() + sizeof(header);
+  const char* bucketIds = hashCodes + count * hashCodeSize;
+
+  hashedDescriptions.hashed_desc.resize(count);
+  for(std::size_t i = 0; i < count; ++i)
+  {
+    HashedDescription& desc = hashedDescriptions.hashed_desc[i];
+    desc.hash_code = stl::dynamic_bitset(nbBits);
+    std::memcpy(desc.hash_code.data(), hashCodes + i * hashCodeSize, hashCodeSize);
+    desc.bucket_ids.resize(nbBucketGroups);
+    std::memcpy(desc.bucket_ids.data(), bucketIds + i * nbBucketGroups * sizeof(std::uint16_t), nbBucketGroups * sizeof(std::uint16_t));
+  }
+  hasher.BuildBuckets(hashedDescriptions);
+  return true;
+}
+
+} // namespace matching
+} // namespace aliceVision
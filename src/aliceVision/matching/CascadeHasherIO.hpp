@@ -0,0 +1,84 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/matching/CascadeHasher.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Persistence of the cascade hashing data.
+ *
+ * Two kinds of binary files:
+ *  - the hasher file stores the seed and the sizes of the hashing projections
+ *    with the zero mean descriptor, so another process can rebuild the same hasher.
+ *  - the hashed descriptions file stores the hash codes and the bucket ids of one view,
+ *    tagged with the key of the hasher (CascadeHasher::GetKey) that created them.
+ */
+
+/// Magic number identifying a cascade hasher file ("AVCS")
+constexpr std::uint32_t CASCADE_HASHER_FILE_MAGIC = 0x53435641;
+/// Magic number identifying a hashed descriptions file ("AVCH")
+constexpr std::uint32_t HASHED_DESCRIPTIONS_FILE_MAGIC = 0x48435641;
+/// Current version of the cascade hashing files
+constexpr std::uint32_t CASCADE_HASHING_FILE_VERSION = 1;
+
+/**
+ * @brief Save the hasher parameters and the zero mean descriptor
+ * @param[in] filename The hasher file
+ * @param[in] hasher The initialized cascade hasher
+ * @param[in] zeroMeanDescriptor The zero mean descriptor used for hashing
+ */
+void saveCascadeHasher(const std::string& filename,
+                       const CascadeHasher& hasher,
+                       const Eigen::VectorXf& zeroMeanDescriptor);
+
+/**
+ * @brief Load a hasher file and rebuild the corresponding cascade hasher
+ * @param[in] filename The hasher file
+ * @param[in] dimension The expected descriptor dimension
+ * @param[out] hasher The cascade hasher, initialized with the stored seed
+ * @param[out] zeroMeanDescriptor The stored zero mean descriptor
+ * @return false if the file does not exist, is invalid or does not match the descriptor dimension
+ */
+bool loadCascadeHasher(const std::string& filename,
+                       std::size_t dimension,
+                       CascadeHasher& hasher,
+                       Eigen::VectorXf& zeroMeanDescriptor);
+
+/**
+ * @brief Save the hashed descriptions of one view (the buckets are not stored)
+ * @param[in] filename The hashed descriptions file
+ * @param[in] hashedDescriptions The hashed descriptions
+ * @param[in] key The key of the hasher used to create them (CascadeHasher::GetKey)
+ */
+void saveHashedDescriptions(const std::string& filename,
+                            const HashedDescriptions& hashedDescriptions,
+                            std::uint64_t key);
+
+/**
+ * @brief Load the hashed descriptions of one view and rebuild the buckets
+ * @param[in] filename The hashed descriptions file
+ * @param[in] hasher The cascade hasher used for matching
+ * @param[in] key The expected hasher key
+ * @param[in] count The expected number of descriptions
+ * @param[out] hashedDescriptions The hashed descriptions
+ * @return false if the file does not exist, is invalid or has been created with another hasher
+ */
+bool loadHashedDescriptions(const std::string& filename,
+                            const CascadeHasher& hasher,
+                            std::uint64_t key,
+                            std::size_t count,
+                            HashedDescriptions& hashedDescriptions);
+
+} // namespace matching
+} // namespace aliceVision
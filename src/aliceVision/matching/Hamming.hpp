@@ -112,6 +112,13 @@ struct Hamming
   inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
   {
     ResultType result = 0;
+#ifdef ALICEVISION_HAVE_AVX2
+    if(size%32 == 0 && system::use_avx2_kernels())
+    {
+      return optim_avx2::hamming_avx2(reinterpret_cast<const unsigned char*>(a),
+                                      reinterpret_cast<const unsigned char*>(b), size);
+    }
+#endif
 // Windows & generic platforms:
 
 #ifdef PLATFORM_64_BIT
@@ -8,6 +8,7 @@
 #include "aliceVision/matching/matcherType.hpp"
 #include "aliceVision/matching/RegionsMatcher.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceCuda.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
 
@@ -49,21 +50,22 @@ RegionsDatabaseMatcher::RegionsDatabaseMatcher():
 
 RegionsDatabaseMatcher::RegionsDatabaseMatcher(
   matching::EMatcherType matcherType,
-  const feature::Regions & databaseRegions)
+  const feature::Regions & databaseRegions,
+  const std::string& indexPrefix)
   : _matcherType(matcherType)
 {
-  _regionsMatcher = createRegionsMatcher(databaseRegions, matcherType);
+  _regionsMatcher = createRegionsMatcher(databaseRegions, matcherType, indexPrefix);
 }
 
 
-std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & regions, matching::EMatcherType matcherType)
+std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & regions, matching::EMatcherType matcherType, const std::string& indexPrefix)
 {
   std::unique_ptr<IRegionsMatcher> out;
 
   // Handle invalid request
-  if (regions.IsScalar() && matcherType == BRUTE_FORCE_HAMMING)
+  if (regions.IsScalar() && (matcherType == BRUTE_FORCE_HAMMING || matcherType == BRUTE_FORCE_HAMMING_CUDA))
     return out;
-  if (regions.IsBinary() && matcherType != BRUTE_FORCE_HAMMING)
+  if (regions.IsBinary() && matcherType != BRUTE_FORCE_HAMMING && matcherType != BRUTE_FORCE_HAMMING_CUDA)
     return out;
 
   // Switch regions type ID, matcher & Metric: initialize the Matcher interface
@@ -81,10 +83,17 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BRUTE_FORCE_L2_CUDA:
+        {
+          typedef L2_Vectorized<unsigned char> MetricT;
+          typedef ArrayMatcher_bruteForceCuda<unsigned char, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<unsigned char> MatcherT;
-          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true, indexPrefix));
         }
         break;
         case CASCADE_HASHING_L2:
@@ -110,10 +119,17 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BRUTE_FORCE_L2_CUDA:
+        {
+          typedef L2_Vectorized<float> MetricT;
+          typedef ArrayMatcher_bruteForceCuda<float, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<float> MatcherT;
-          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true, indexPrefix));
         }
         break;
         case CASCADE_HASHING_L2:
@@ -139,10 +155,17 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
           out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
         }
         break;
+        case BRUTE_FORCE_L2_CUDA:
+        {
+          typedef L2_Vectorized<double> MetricT;
+          typedef ArrayMatcher_bruteForceCuda<double, MetricT> MatcherT;
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+        }
+        break;
         case ANN_L2:
         {
           typedef ArrayMatcher_kdtreeFlann<double> MatcherT;
-          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true));
+          out.reset(new matching::RegionsMatcher<MatcherT>(regions, true, indexPrefix));
         }
         break;
         case CASCADE_HASHING_L2:
@@ -166,6 +189,13 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
         out.reset(new matching::RegionsMatcher<MatcherT>(regions, false));
       }
       break;
+      case BRUTE_FORCE_HAMMING_CUDA:
+      {
+        typedef Hamming<unsigned char> Metric;
+        typedef ArrayMatcher_bruteForceCuda<unsigned char, Metric> MatcherT;
+        out.reset(new matching::RegionsMatcher<MatcherT>(regions, false));
+      }
+      break;
       default:
           ALICEVISION_LOG_WARNING("Using unknown matcher type");
     }
@@ -14,8 +14,10 @@
 
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/feature/Regions.hpp"
+#include "aliceVision/feature/DescriptorSpan.hpp"
 #include "aliceVision/feature/RegionsPerView.hpp"
 
+#include <string>
 #include <vector>
 
 namespace aliceVision {
@@ -116,8 +118,26 @@ public:
     if (regions_.RegionCount() == 0)
       return;
 
-    const Scalar * tab = reinterpret_cast<const Scalar *>(regions_.DescriptorRawData());
-    matcher_.Build(tab, regions_.RegionCount(), regions_.DescriptorLength());
+    // the matcher only keeps a view on the database descriptors (no copy)
+    matcher_.Build(feature::getDescriptorSpan<Scalar>(regions_));
+  }
+
+  /**
+   * @brief Initialize the matcher with a Regions that will be used as database,
+   * the index of the matcher is persisted in a file (only for ArrayMatcher_kdtreeFlann).
+   *
+   * @param regions The Regions to be used as database.
+   * @param b_squared_metric Whether to use a squared metric for the ratio test
+   * when matching two Regions.
+   * @param indexPrefix Path prefix of the index file (see getKdTreeIndexFilename), disabled if empty.
+   */
+  RegionsMatcher(const feature::Regions& regions, bool b_squared_metric, const std::string& indexPrefix)
+    : IRegionsMatcher(regions), b_squared_metric_(b_squared_metric)
+  {
+    if (regions_.RegionCount() == 0)
+      return;
+
+    matcher_.Build(feature::getDescriptorSpan<Scalar>(regions_), indexPrefix);
   }
 
   /**
@@ -135,14 +155,14 @@ public:
              matching::IndMatches & vec_putative_matches)
   {
 
-    const Scalar * queries = reinterpret_cast<const Scalar *>(queryregions_.DescriptorRawData());
+    const feature::DescriptorSpan<Scalar> queries = feature::getDescriptorSpan<Scalar>(queryregions_);
 
     const size_t NNN__ = 2;
     matching::IndMatches vec_nIndice;
     std::vector<DistanceType> vec_fDistance;
 
     // Search the 2 closest features neighbours for each query descriptor
-    if (!matcher_.SearchNeighbours(queries, queryregions_.RegionCount(), &vec_nIndice, &vec_fDistance, NNN__))
+    if (!matcher_.SearchNeighbours(queries, &vec_nIndice, &vec_fDistance, NNN__))
       return false;
 
     assert(vec_nIndice.size() == vec_fDistance.size());
@@ -206,10 +226,13 @@ class RegionsDatabaseMatcher
      * @param[in] matcherType The type of matcher to use to match the Regions.
      * @param[in] database_regions The Regions that will be used as database to
      * match other Regions (query).
+     * @param[in] indexPrefix Path prefix of the file used by ANN_L2 to persist
+     * the kd-tree index of the database (see getKdTreeIndexFilename), disabled if empty.
      */
     RegionsDatabaseMatcher(
       matching::EMatcherType matcherType,
-      const feature::Regions & database_regions);
+      const feature::Regions & database_regions,
+      const std::string& indexPrefix = "");
 
     /**
      * @brief Find corresponding points between the query Regions and the database one
@@ -276,7 +299,14 @@ private:
   std::map<feature::EImageDescriberType, RegionsDatabaseMatcher> _mapMatchers;
 };
 
-std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & regions, matching::EMatcherType matcherType);
+/**
+ * @brief Create the matcher of the given type with the Regions as database.
+ * @param[in] regions The Regions used as database
+ * @param[in] matcherType The type of matcher
+ * @param[in] indexPrefix Path prefix of the file used by ANN_L2 to persist the kd-tree index, disabled if empty
+ * @return The matcher, nullptr if the matcher type is not compatible with the Regions
+ */
+std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & regions, matching::EMatcherType matcherType, const std::string& indexPrefix = "");
 
 }  // namespace matching
 }  // namespace aliceVision
@@ -0,0 +1,308 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "bruteForceMatching.hpp"
+
+#include <cuda_runtime.h>
+
+#include <cfloat>
+#include <climits>
+
+namespace aliceVision {
+namespace matching {
+namespace cuda {
+
+namespace {
+
+/// number of query descriptors processed by one block (one thread per query)
+constexpr int QUERY_TILE = 64;
+/// number of dataset descriptors loaded at once in shared memory
+constexpr int DATA_TILE = 16;
+/// shared memory available for one block
+constexpr std::size_t MAX_SHARED_MEMORY = 48 * 1024;
+
+/// Round a / b to nearest higher integer value.
+inline unsigned int divUp(unsigned int a, unsigned int b)
+{
+  return (a % b != 0) ? (a / b + 1) : (a / b);
+}
+
+/**
+ * @brief Shared memory needed by one block, the query rows are padded by one word
+ * @param[in] rowWords The number of 32 bits words of one descriptor
+ */
+inline std::size_t sharedMemorySize(std::size_t rowWords)
+{
+  return (QUERY_TILE * (rowWords + 1) + DATA_TILE * rowWords) * sizeof(unsigned int);
+}
+
+/**
+ * @brief Distance between two 32 bits words of two descriptors, summed over the descriptors
+ */
+template<EDeviceMetric metric>
+struct WordDistance;
+
+template<>
+struct WordDistance<EDeviceMetric::L2_FLOAT>
+{
+  typedef float AccumulatorT;
+
+  __device__ static inline AccumulatorT maxValue() { return FLT_MAX; }
+
+  __device__ static inline AccumulatorT compute(unsigned int a, unsigned int b)
+  {
+    const float diff = __int_as_float(a) - __int_as_float(b);
+    return diff * diff;
+  }
+};
+
+template<>
+struct WordDistance<EDeviceMetric::L2_UCHAR>
+{
+  typedef unsigned int AccumulatorT;
+
+  __device__ static inline AccumulatorT maxValue() { return UINT_MAX; }
+
+  __device__ static inline AccumulatorT compute(unsigned int a, unsigned int b)
+  {
+    AccumulatorT result = 0;
+    for(int shift = 0; shift < 32; shift += 8)
+    {
+      const int diff = static_cast<int>((a >> shift) & 0xff) - static_cast<int>((b >> shift) & 0xff);
+      result += diff * diff;
+    }
+    return result;
+  }
+};
+
+template<>
+struct WordDistance<EDeviceMetric::HAMMING>
+{
+  typedef unsigned int AccumulatorT;
+
+  __device__ static inline AccumulatorT maxValue() { return UINT_MAX; }
+
+  __device__ static inline AccumulatorT compute(unsigned int a, unsigned int b)
+  {
+    return __popc(a ^ b);
+  }
+};
+
+/**
+ * @brief Find the 2 nearest neighbours of a tile of queries, one thread per query.
+ *
+ * The queries of the block stay in shared memory (rows padded to avoid bank conflicts),
+ * the dataset is streamed tile by tile in shared memory where each word is read by all
+ * the threads at once (broadcast).
+ */
+template<EDeviceMetric metric>
+__global__ void bruteForce2NNKernel(const unsigned int* dataset,
+                                    int nbData,
+                                    const unsigned int* query,
+                                    int nbQuery,
+                                    int rowWords,
+                                    int2* indices,
+                                    float2* distances)
+{
+  typedef WordDistance<metric> DistanceT;
+  typedef typename DistanceT::AccumulatorT AccumulatorT;
+
+  extern __shared__ unsigned int sharedMemory[];
+
+  const int queryStride = rowWords + 1;
+  unsigned int* queryTile = sharedMemory;
+  unsigned int* dataTile = sharedMemory + QUERY_TILE * queryStride;
+
+  const int firstQuery = blockIdx.x * QUERY_TILE;
+  const int queryIndex = firstQuery + threadIdx.x;
+  const int tileQueries = min(QUERY_TILE, nbQuery - firstQuery);
+
+  // coalesced load of the queries of the block
+  for(int w = threadIdx.x; w < tileQueries * rowWords; w += blockDim.x)
+    queryTile[(w / rowWords) * queryStride + (w % rowWords)] = query[firstQuery * rowWords + w];
+
+  const unsigned int* queryRow = queryTile + threadIdx.x * queryStride;
+
+  AccumulatorT best = DistanceT::maxValue();
+  AccumulatorT second = DistanceT::maxValue();
+  int bestIndex = -1;
+  int secondIndex = -1;
+
+  for(int firstData = 0; firstData < nbData; firstData += DATA_TILE)
+  {
+    const int tileData = min(DATA_TILE, nbData - firstData);
+
+    // wait for the previous tile to be consumed (and the queries to be loaded)
+    __syncthreads();
+    for(int w = threadIdx.x; w < tileData * rowWords; w += blockDim.x)
+      dataTile[w] = dataset[firstData * rowWords + w];
+    __syncthreads();
+
+    if(queryIndex >= nbQuery)
+      continue;
+
+    for(int d = 0; d < tileData; ++d)
+    {
+      const unsigned int* dataRow = dataTile + d * rowWords;
+
+      AccumulatorT distance = 0;
+      for(int w = 0; w < rowWords; ++w)
+        distance += DistanceT::compute(queryRow[w], dataRow[w]);
+
+      if(distance < best)
+      {
+        second = best;
+        secondIndex = bestIndex;
+        best = distance;
+        bestIndex = firstData + d;
+      }
+      else if(distance < second)
+      {
+        second = distance;
+        secondIndex = firstData + d;
+      }
+    }
+  }
+
+  if(queryIndex < nbQuery)
+  {
+    indices[queryIndex] = make_int2(bestIndex, secondIndex);
+    distances[queryIndex] = make_float2(static_cast<float>(best), static_cast<float>(second));
+  }
+}
+
+/**
+ * @brief Device buffer released at the end of the scope
+ */
+struct DeviceBuffer
+{
+  void* data = nullptr;
+
+  ~DeviceBuffer()
+  {
+    if(data != nullptr)
+      cudaFree(data);
+  }
+
+  bool allocate(std::size_t size)
+  {
+    return cudaMalloc(&data, size) == cudaSuccess;
+  }
+};
+
+} // namespace
+
+bool supportBruteForceMatching(std::size_t rowSize)
+{
+  if(rowSize == 0 || rowSize % sizeof(unsigned int) != 0)
+    return false;
+
+  if(sharedMemorySize(rowSize / sizeof(unsigned int)) > MAX_SHARED_MEMORY)
+    return false;
+
+  int nbDevices = 0;
+  return (cudaGetDeviceCount(&nbDevices) == cudaSuccess) && (nbDevices > 0);
+}
+
+DeviceDescriptors::~DeviceDescriptors()
+{
+  clear();
+}
+
+bool DeviceDescriptors::upload(const void* data, int count, std::size_t rowSize)
+{
+  clear();
+
+  if(count <= 0 || cudaMalloc(&_data, count * rowSize) != cudaSuccess)
+  {
+    _data = nullptr;
+    return false;
+  }
+
+  if(cudaMemcpy(_data, data, count * rowSize, cudaMemcpyHostToDevice) != cudaSuccess)
+  {
+    clear();
+    return false;
+  }
+
+  _count = count;
+  _rowSize = rowSize;
+  return true;
+}
+
+void DeviceDescriptors::clear()
+{
+  if(_data != nullptr)
+    cudaFree(_data);
+
+  _data = nullptr;
+  _count = 0;
+  _rowSize = 0;
+}
+
+bool bruteForceMatching2NN(const DeviceDescriptors& dataset,
+                           const void* query,
+                           int nbQuery,
+                           EDeviceMetric metric,
+                           int* indices,
+                           float* distances)
+{
+  if(dataset.empty() || nbQuery <= 0)
+    return false;
+
+  const std::size_t rowSize = dataset.rowSize();
+  if(rowSize % sizeof(unsigned int) != 0)
+    return false;
+
+  const int rowWords = static_cast<int>(rowSize / sizeof(unsigned int));
+  const std::size_t sharedSize = sharedMemorySize(rowWords);
+  if(sharedSize > MAX_SHARED_MEMORY)
+    return false;
+
+  DeviceBuffer deviceQuery;
+  DeviceBuffer deviceIndices;
+  DeviceBuffer deviceDistances;
+
+  if(!deviceQuery.allocate(nbQuery * rowSize) ||
+     !deviceIndices.allocate(nbQuery * sizeof(int2)) ||
+     !deviceDistances.allocate(nbQuery * sizeof(float2)))
+    return false;
+
+  if(cudaMemcpy(deviceQuery.data, query, nbQuery * rowSize, cudaMemcpyHostToDevice) != cudaSuccess)
+    return false;
+
+  const dim3 grid(divUp(nbQuery, QUERY_TILE));
+  const dim3 block(QUERY_TILE);
+
+  const unsigned int* datasetPtr = static_cast<const unsigned int*>(dataset.data());
+  const unsigned int* queryPtr = static_cast<const unsigned int*>(deviceQuery.data);
+  int2* indicesPtr = static_cast<int2*>(deviceIndices.data);
+  float2* distancesPtr = static_cast<float2*>(deviceDistances.data);
+
+  switch(metric)
+  {
+    case EDeviceMetric::L2_FLOAT:
+      bruteForce2NNKernel<EDeviceMetric::L2_FLOAT><<<grid, block, sharedSize>>>(datasetPtr, dataset.count(), queryPtr, nbQuery, rowWords, indicesPtr, distancesPtr);
+      break;
+    case EDeviceMetric::L2_UCHAR:
+      bruteForce2NNKernel<EDeviceMetric::L2_UCHAR><<<grid, block, sharedSize>>>(datasetPtr, dataset.count(), queryPtr, nbQuery, rowWords, indicesPtr, distancesPtr);
+      break;
+    case EDeviceMetric::HAMMING:
+      bruteForce2NNKernel<EDeviceMetric::HAMMING><<<grid, block, sharedSize>>>(datasetPtr, dataset.count(), queryPtr, nbQuery, rowWords, indicesPtr, distancesPtr);
+      break;
+  }
+
+  if(cudaGetLastError() != cudaSuccess)
+    return false;
+
+  // synchronous copies, wait for the kernel
+  return (cudaMemcpy(indices, deviceIndices.data, nbQuery * sizeof(int2), cudaMemcpyDeviceToHost) == cudaSuccess) &&
+         (cudaMemcpy(distances, deviceDistances.data, nbQuery * sizeof(float2), cudaMemcpyDeviceToHost) == cudaSuccess);
+}
+
+} // namespace cuda
+} // namespace matching
+} // namespace aliceVision
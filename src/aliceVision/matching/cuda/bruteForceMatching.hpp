@@ -0,0 +1,93 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+
+namespace aliceVision {
+namespace matching {
+namespace cuda {
+
+/**
+ * @brief Distance computed on the GPU by the brute force matcher
+ */
+enum class EDeviceMetric
+{
+  /// squared L2 distance between float descriptors
+  L2_FLOAT,
+  /// squared L2 distance between unsigned char descriptors
+  L2_UCHAR,
+  /// Hamming distance between binary descriptors
+  HAMMING
+};
+
+/**
+ * @brief Check if the brute force matcher can run on the GPU with the given descriptors.
+ * @param[in] rowSize The size in bytes of one descriptor
+ * @return true if a CUDA device is available and the descriptor size is supported
+ */
+bool supportBruteForceMatching(std::size_t rowSize);
+
+/**
+ * @brief Descriptors stored on the current CUDA device
+ */
+class DeviceDescriptors
+{
+public:
+  DeviceDescriptors() = default;
+  ~DeviceDescriptors();
+
+  DeviceDescriptors(const DeviceDescriptors&) = delete;
+  DeviceDescriptors& operator=(const DeviceDescriptors&) = delete;
+
+  /**
+   * @brief Copy the descriptors on the current CUDA device
+   * @param[in] data The descriptors, stored row by row
+   * @param[in] count The number of descriptors
+   * @param[in] rowSize The size in bytes of one descriptor
+   * @return false if the device memory can't be allocated
+   */
+  bool upload(const void* data, int count, std::size_t rowSize);
+
+  /// Release the device memory
+  void clear();
+
+  inline bool empty() const { return _data == nullptr; }
+  inline const void* data() const { return _data; }
+  inline int count() const { return _count; }
+  inline std::size_t rowSize() const { return _rowSize; }
+
+private:
+  void* _data = nullptr;
+  int _count = 0;
+  std::size_t _rowSize = 0;
+};
+
+/**
+ * @brief Find the 2 nearest neighbours in the dataset of each query descriptor on the GPU.
+ *
+ * The distances between a tile of queries and a tile of the dataset are computed in shared memory,
+ * only the 2 best candidates of each query are kept and copied back to the host.
+ *
+ * @param[in] dataset The dataset descriptors, already on the device
+ * @param[in] query The query descriptors (host memory), with the same row size as the dataset
+ * @param[in] nbQuery The number of query descriptors
+ * @param[in] metric The distance to compute
+ * @param[out] indices The dataset index of the nearest and second nearest neighbours (2 * nbQuery)
+ * @param[out] distances The distance to the nearest and second nearest neighbours (2 * nbQuery)
+ * @return false if the computation can't run on the device
+ */
+bool bruteForceMatching2NN(const DeviceDescriptors& dataset,
+                           const void* query,
+                           int nbQuery,
+                           EDeviceMetric metric,
+                           int* indices,
+                           float* distances);
+
+} // namespace cuda
+} // namespace matching
+} // namespace aliceVision
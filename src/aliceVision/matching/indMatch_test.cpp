@@ -107,6 +107,56 @@ BOOST_AUTO_TEST_CASE(IndMatch_IO)
   boost::filesystem::remove_all(testFolder);
 }
 
+BOOST_AUTO_TEST_CASE(IndMatch_IO_binary)
+{
+  const std::string testFolder = "matchingBinaryTest";
+
+  // unordered matches with large feature indices, the order must be kept
+  PairwiseMatches matches;
+  matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}};
+  matches[std::make_pair(0,1)][EImageDescriberType::SIFT] = {{5,3}};
+  matches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{10,2},{3,400000},{4000000000,7},{0,0}};
+  matches[std::make_pair(2,3)][EImageDescriberType::UNKNOWN] = {};
+
+  for(const bool compression : {true, false})
+  {
+    for(const bool matchFilePerImage : {true, false})
+    {
+      boost::filesystem::remove_all(testFolder);
+      boost::filesystem::create_directory(testFolder);
+
+      BOOST_CHECK(Save(matches, testFolder, "bin", matchFilePerImage, "", compression));
+
+      PairwiseMatches loadedMatches;
+      BOOST_CHECK(Load(loadedMatches, {}, {testFolder}, {}));
+      BOOST_CHECK(loadedMatches == matches);
+    }
+  }
+
+  // random access to a single pair
+  boost::filesystem::remove_all(testFolder);
+  boost::filesystem::create_directory(testFolder);
+  BOOST_CHECK(Save(matches, testFolder, "bin", false));
+
+  const std::string filepath = (fs::path(testFolder) / "matches.bin").string();
+
+  std::vector<MatchFileIndexEntry> index;
+  BOOST_CHECK(LoadMatchFileIndex(index, filepath));
+  BOOST_CHECK_EQUAL(4, index.size());
+
+  MatchesPerDescType pairMatches;
+  BOOST_CHECK(LoadMatchFilePair(pairMatches, filepath, std::make_pair(1,2)));
+  BOOST_CHECK(pairMatches == matches.at(std::make_pair(1,2)));
+
+  BOOST_CHECK(LoadMatchFilePair(pairMatches, filepath, std::make_pair(0,1)));
+  BOOST_CHECK(pairMatches == matches.at(std::make_pair(0,1)));
+
+  BOOST_CHECK(LoadMatchFilePair(pairMatches, filepath, std::make_pair(5,6)));
+  BOOST_CHECK(pairMatches.empty());
+
+  boost::filesystem::remove_all(testFolder);
+}
+
 BOOST_AUTO_TEST_CASE(IndMatch_DuplicateRemoval_NoRemoval)
 {
   std::vector<IndMatch> vec_indMatch;
@@ -9,13 +9,19 @@
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Storage.hpp>
+#include <aliceVision/system/TaskPool.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/range/iterator_range.hpp>
 
+#include <cstdint>
+#include <cstring>
 #include <map>
+#include <mutex>
 #include <fstream>
 #include <iterator>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -24,13 +30,207 @@ namespace fs = boost::filesystem;
 namespace aliceVision {
 namespace matching {
 
-bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
+namespace {
+
+/// Append an unsigned integer to the buffer as a varint (LEB128)
+void writeVarint(std::vector<unsigned char>& buffer, std::uint64_t value)
 {
-  const std::string ext = fs::extension(filepath);
+  while(value >= 0x80)
+  {
+    buffer.push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<unsigned char>(value));
+}
+
+/// Read a varint (LEB128), return false if the data is truncated or invalid
+bool readVarint(const unsigned char*& data, const unsigned char* end, std::uint64_t& value)
+{
+  value = 0;
+  for(int shift = 0; shift < 64 && data != end; shift += 7)
+  {
+    const unsigned char byte = *data++;
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+/// Map signed deltas on unsigned integers, small magnitudes give small values
+inline std::uint64_t zigzagEncode(std::int64_t value)
+{
+  return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t zigzagDecode(std::uint64_t value)
+{
+  return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+void encodeMatches(const IndMatches& matches, EMatchFileEncoding encoding, std::vector<unsigned char>& buffer)
+{
+  buffer.clear();
+
+  if(encoding == EMatchFileEncoding::RAW)
+  {
+    buffer.resize(matches.size() * 2 * sizeof(std::uint32_t));
+    unsigned char* data = buffer.data();
+    for(const IndMatch& match : matches)
+    {
+      const std::uint32_t indices[2] = {match._i, match._j};
+      std::memcpy(data, indices, sizeof(indices));
+      data += sizeof(indices);
+    }
+    return;
+  }
+
+  // delta with the previous match, the matches order is kept
+  buffer.reserve(matches.size() * 4);
+  std::int64_t previousI = 0;
+  std::int64_t previousJ = 0;
+  for(const IndMatch& match : matches)
+  {
+    writeVarint(buffer, zigzagEncode(static_cast<std::int64_t>(match._i) - previousI));
+    writeVarint(buffer, zigzagEncode(static_cast<std::int64_t>(match._j) - previousJ));
+    previousI = match._i;
+    previousJ = match._j;
+  }
+}
+
+bool decodeMatches(const unsigned char* data, std::size_t size, std::uint64_t count, EMatchFileEncoding encoding, IndMatches& matches)
+{
+  const unsigned char* end = data + size;
+
+  if(encoding == EMatchFileEncoding::RAW)
+  {
+    if(size != count * 2 * sizeof(std::uint32_t))
+      return false;
+
+    matches.resize(count);
+    for(IndMatch& match : matches)
+    {
+      std::uint32_t indices[2];
+      std::memcpy(indices, data, sizeof(indices));
+      match._i = indices[0];
+      match._j = indices[1];
+      data += sizeof(indices);
+    }
+    return true;
+  }
+
+  if(encoding != EMatchFileEncoding::DELTA_VARINT || count > size)
+    return false;
+
+  matches.resize(count);
+  std::int64_t previousI = 0;
+  std::int64_t previousJ = 0;
+  for(IndMatch& match : matches)
+  {
+    std::uint64_t deltaI, deltaJ;
+    if(!readVarint(data, end, deltaI) || !readVarint(data, end, deltaJ))
+      return false;
+
+    const std::int64_t i = previousI + zigzagDecode(deltaI);
+    const std::int64_t j = previousJ + zigzagDecode(deltaJ);
+
+    if(i < 0 || j < 0 || i > std::numeric_limits<IndexT>::max() || j > std::numeric_limits<IndexT>::max())
+      return false;
+
+    match._i = static_cast<IndexT>(i);
+    match._j = static_cast<IndexT>(j);
+    previousI = i;
+    previousJ = j;
+  }
+  return data == end;
+}
+
+bool readMatchFileIndex(std::ifstream& stream, const std::string& filepath, MatchFileHeader& header, std::vector<MatchFileIndexEntry>& index)
+{
+  const std::uint64_t fileSize = fs::file_size(filepath);
+
+  if(!stream.read(reinterpret_cast<char*>(&header), sizeof(MatchFileHeader)) ||
+     header.magic != MATCH_FILE_MAGIC)
+  {
+    ALICEVISION_LOG_WARNING("Invalid binary match file: " << filepath);
+    return false;
+  }
+
+  if(header.version != MATCH_FILE_VERSION)
+  {
+    ALICEVISION_LOG_WARNING("Unsupported binary match file version (" << header.version << "): " << filepath);
+    return false;
+  }
+
+  if(header.indexSize > (fileSize - sizeof(MatchFileHeader)) / sizeof(MatchFileIndexEntry))
+  {
+    ALICEVISION_LOG_WARNING("Truncated binary match file: " << filepath);
+    return false;
+  }
+
+  index.resize(header.indexSize);
+  if(!stream.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(MatchFileIndexEntry)))
+  {
+    ALICEVISION_LOG_WARNING("Truncated binary match file: " << filepath);
+    return false;
+  }
+
+  for(const MatchFileIndexEntry& entry : index)
+  {
+    if(entry.offset > fileSize || entry.size > fileSize - entry.offset)
+    {
+      ALICEVISION_LOG_WARNING("Truncated binary match file: " << filepath);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool loadBinMatchFile(PairwiseMatches& matches, const std::string& filepath)
+{
+  std::ifstream stream(filepath.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  MatchFileHeader header;
+  std::vector<MatchFileIndexEntry> index;
+  if(!readMatchFileIndex(stream, filepath, header, index))
+    return false;
+
+  // the matches data follows the index, read it at once
+  const std::uint64_t dataOffset = sizeof(MatchFileHeader) + index.size() * sizeof(MatchFileIndexEntry);
+  std::vector<unsigned char> data(fs::file_size(filepath) - dataOffset);
+  if(!stream.read(reinterpret_cast<char*>(data.data()), data.size()))
+    return false;
+
+  const EMatchFileEncoding encoding = static_cast<EMatchFileEncoding>(header.encoding);
 
-  if(!fs::exists(filepath))
+  for(const MatchFileIndexEntry& entry : index)
+  {
+    IndMatches matchesPerDesc;
+    if(entry.offset < dataOffset ||
+       !decodeMatches(data.data() + (entry.offset - dataOffset), entry.size, entry.count, encoding, matchesPerDesc))
+    {
+      ALICEVISION_LOG_WARNING("Invalid matches in binary match file: " << filepath);
+      return false;
+    }
+    matches[std::make_pair(entry.I, entry.J)][static_cast<feature::EImageDescriberType>(entry.descType)] = std::move(matchesPerDesc);
+  }
+  return true;
+}
+
+} // namespace
+
+bool LoadMatchFile(PairwiseMatches& matches, const std::string& path)
+{
+  system::Storage& storage = system::Storage::get();
+  if(!storage.exists(path))
     return false;
 
+  // local copy of a remote file
+  const std::string filepath = storage.getLocalPath(path);
+  const std::string ext = fs::extension(filepath);
+
   if(ext == ".txt")
   {
     std::ifstream stream(filepath.c_str());
@@ -71,6 +271,10 @@ bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
     stream.close();
     return true;
   }
+  else if(ext == ".bin")
+  {
+    return loadBinMatchFile(matches, filepath);
+  }
   else
   {
     ALICEVISION_LOG_WARNING("Unknown matching file format: " << ext);
@@ -78,6 +282,76 @@ bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
   return false;
 }
 
+bool LoadMatchFileIndex(std::vector<MatchFileIndexEntry>& index, const std::string& path)
+{
+  system::Storage& storage = system::Storage::get();
+  if(!storage.exists(path))
+    return false;
+
+  const std::string filepath = storage.getLocalPath(path);
+
+  std::ifstream stream(filepath.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  MatchFileHeader header;
+  return readMatchFileIndex(stream, filepath, header, index);
+}
+
+bool LoadMatchFilePair(MatchesPerDescType& matches, const std::string& path, const Pair& pair)
+{
+  matches.clear();
+
+  system::Storage& storage = system::Storage::get();
+  if(!storage.exists(path))
+    return false;
+
+  const std::string filepath = storage.getLocalPath(path);
+
+  if(fs::extension(filepath) != ".bin")
+  {
+    // no index, parse the whole file
+    PairwiseMatches fileMatches;
+    if(!LoadMatchFile(fileMatches, filepath))
+      return false;
+
+    const auto it = fileMatches.find(pair);
+    if(it != fileMatches.end())
+      matches = std::move(it->second);
+    return true;
+  }
+
+  std::ifstream stream(filepath.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    return false;
+
+  MatchFileHeader header;
+  std::vector<MatchFileIndexEntry> index;
+  if(!readMatchFileIndex(stream, filepath, header, index))
+    return false;
+
+  const EMatchFileEncoding encoding = static_cast<EMatchFileEncoding>(header.encoding);
+  std::vector<unsigned char> data;
+
+  for(const MatchFileIndexEntry& entry : index)
+  {
+    if(entry.I != pair.first || entry.J != pair.second)
+      continue;
+
+    data.resize(entry.size);
+    IndMatches matchesPerDesc;
+    if(!stream.seekg(entry.offset) ||
+       !stream.read(reinterpret_cast<char*>(data.data()), data.size()) ||
+       !decodeMatches(data.data(), data.size(), entry.count, encoding, matchesPerDesc))
+    {
+      ALICEVISION_LOG_WARNING("Invalid matches in binary match file: " << filepath);
+      matches.clear();
+      return false;
+    }
+    matches[static_cast<feature::EImageDescriberType>(entry.descType)] = std::move(matchesPerDesc);
+  }
+  return true;
+}
 
 void filterMatchesByViews(
   PairwiseMatches & matches,
@@ -141,33 +415,39 @@ std::size_t LoadMatchFilePerImage(
   const std::string& basename)
 {
   int nbLoadedMatchFiles = 0;
+  const std::vector<IndexT> viewsIds(viewsKeys.begin(), viewsKeys.end());
+
+  std::vector<std::string> matchFilepaths;
+  matchFilepaths.reserve(viewsIds.size());
+  for(const IndexT idView : viewsIds)
+    matchFilepaths.push_back((fs::path(folder) / (std::to_string(idView) + "." + basename)).string());
+
+  // read ahead the remote files
+  system::Storage::get().prefetch(matchFilepaths);
+
+  system::ParallelForOptions options;
+  options.taskClass = system::ETaskClass::DiskRead;
+  options.grainSize = 1;
+
+  std::mutex mutex;
+
   // Load one match file per image
-  #pragma omp parallel for num_threads(3)
-  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(viewsKeys.size()); ++i)
+  system::parallelFor(std::size_t(0), viewsIds.size(), [&](std::size_t i)
   {
-    std::set<IndexT>::const_iterator it = viewsKeys.begin();
-    std::advance(it, i);
-    const IndexT idView = *it;
-    const std::string matchFilename = std::to_string(idView) + "." + basename;
     PairwiseMatches fileMatches;
-    if(!LoadMatchFile(fileMatches, (fs::path(folder) / matchFilename).string() ))
+    if(!LoadMatchFile(fileMatches, matchFilepaths[i]))
     {
-      #pragma omp critical
-      {
-        ALICEVISION_LOG_DEBUG("Unable to load match file: " << matchFilename << " in: " << folder);
-      }
-      continue;
+      ALICEVISION_LOG_DEBUG("Unable to load match file: " << matchFilepaths[i]);
+      return;
     }
-    #pragma omp critical
+    std::lock_guard<std::mutex> lock(mutex);
+    ++nbLoadedMatchFiles;
+    // merge the loaded matches into the output
+    for(const auto& v: fileMatches)
     {
-      ++nbLoadedMatchFiles;
-      // merge the loaded matches into the output
-      for(const auto& v: fileMatches)
-      {
-        matches[v.first] = v.second;
-      }
+      matches[v.first] = v.second;
     }
-  }
+  }, options);
   return nbLoadedMatchFiles;
 }
 
@@ -190,8 +470,13 @@ std::size_t loadMatchesFromFolder(PairwiseMatches& matches, const std::string& f
     }
   }
 
-  #pragma omp parallel for num_threads(3)
-  for(int i = 0; i < matchFiles.size(); ++i)
+  system::ParallelForOptions options;
+  options.taskClass = system::ETaskClass::DiskRead;
+  options.grainSize = 1;
+
+  std::mutex mutex;
+
+  system::parallelFor(std::size_t(0), matchFiles.size(), [&](std::size_t i)
   {
     const std::string& matchFile = matchFiles[i];
     PairwiseMatches fileMatches;
@@ -199,10 +484,9 @@ std::size_t loadMatchesFromFolder(PairwiseMatches& matches, const std::string& f
     if(!LoadMatchFile(fileMatches, matchFile))
     {
       ALICEVISION_LOG_WARNING("Unable to load match file: " << matchFile);
-      continue;
+      return;
     }
-    #pragma omp critical
-    {
+    std::lock_guard<std::mutex> lock(mutex);
     for(const auto& matchesPerView: fileMatches)
     {
       const Pair& pair = matchesPerView.first;
@@ -220,10 +504,7 @@ std::size_t loadMatchesFromFolder(PairwiseMatches& matches, const std::string& f
       }
     }
     ++nbLoadedMatchFiles;
-    }   
-  }
-  if(!nbLoadedMatchFiles)
-    ALICEVISION_LOG_WARNING("No matches file loaded in: " << folder);
+  }, options);
   return nbLoadedMatchFiles;
 }
 
@@ -235,7 +516,8 @@ bool Load(
   const int maxNbMatches)
 {
   std::size_t nbLoadedMatchFiles = 0;
-  const std::string pattern = "matches.txt";
+  // text and binary match files
+  const std::vector<std::string> patterns = {"matches.txt", "matches.bin"};
 
   // build up a set with normalized paths to remove duplicates
   std::set<std::string> foldersSet;
@@ -244,7 +526,14 @@ bool Load(
 
   for(const auto& folder : foldersSet)
   {
-    nbLoadedMatchFiles += loadMatchesFromFolder(matches, folder, pattern);
+    std::size_t nbLoadedFolderMatchFiles = 0;
+    for(const auto& pattern : patterns)
+      nbLoadedFolderMatchFiles += loadMatchesFromFolder(matches, folder, pattern);
+
+    if(!nbLoadedFolderMatchFiles)
+      ALICEVISION_LOG_WARNING("No matches file loaded in: " << folder);
+
+    nbLoadedMatchFiles += nbLoadedFolderMatchFiles;
   }
 
   if(!nbLoadedMatchFiles)
@@ -316,15 +605,92 @@ private:
     fs::rename(tmpPath, filepath);
   }
 
+  void saveBin(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    const fs::path bPath = fs::path(filepath);
+    const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+    const EMatchFileEncoding encoding = m_binaryCompression ? EMatchFileEncoding::DELTA_VARINT : EMatchFileEncoding::RAW;
+
+    // encode the matches of each pair and describer type, and build the index
+    std::vector<MatchFileIndexEntry> index;
+    std::vector<std::vector<unsigned char>> data;
+    for(PairwiseMatches::const_iterator match = matchBegin;
+      match != matchEnd;
+      ++match)
+    {
+      for(const auto& m: match->second)
+      {
+        MatchFileIndexEntry entry;
+        entry.I = match->first.first;
+        entry.J = match->first.second;
+        entry.descType = static_cast<std::uint32_t>(m.first);
+        entry.count = m.second.size();
+        index.push_back(entry);
+
+        data.emplace_back();
+        encodeMatches(m.second, encoding, data.back());
+      }
+    }
+
+    MatchFileHeader header;
+    header.encoding = static_cast<std::uint32_t>(encoding);
+    header.indexSize = index.size();
+
+    std::uint64_t offset = sizeof(MatchFileHeader) + index.size() * sizeof(MatchFileIndexEntry);
+    for(std::size_t i = 0; i < index.size(); ++i)
+    {
+      index[i].offset = offset;
+      index[i].size = data[i].size();
+      offset += data[i].size();
+    }
+
+    // write temporary file
+    {
+      std::ofstream stream(tmpPath.c_str(), std::ios::out | std::ios::binary);
+      if(!stream.is_open())
+        throw std::runtime_error("Can't save binary match file, can't open '" + tmpPath + "' !");
+
+      stream.write(reinterpret_cast<const char*>(&header), sizeof(MatchFileHeader));
+      stream.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(MatchFileIndexEntry));
+      for(const auto& d : data)
+        stream.write(reinterpret_cast<const char*>(d.data()), d.size());
+
+      if(!stream.good())
+        throw std::runtime_error("Can't save binary match file, '" + tmpPath + "' is incorrect !");
+    }
+
+    // rename temporary file
+    fs::rename(tmpPath, filepath);
+  }
+
+  void saveFile(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    if(m_ext == ".txt")
+      saveTxt(filepath, matchBegin, matchEnd);
+    else if(m_ext == ".bin")
+      saveBin(filepath, matchBegin, matchEnd);
+    else
+      throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
+  }
+
 public:
   MatchExporter(
     const PairwiseMatches& matches,
     const std::string& folder,
-    const std::string& filename)
+    const std::string& filename,
+    bool binaryCompression = true)
     : m_matches(matches)
     , m_directory(folder)
     , m_filename(filename)
     , m_ext(fs::extension(filename))
+    , m_binaryCompression(binaryCompression)
   {}
 
   ~MatchExporter()
@@ -333,11 +699,7 @@ public:
   void saveGlobalFile()
   {
     const std::string filepath = (fs::path(m_directory) / m_filename).string();
-
-    if(m_ext == ".txt")
-      saveTxt(filepath, m_matches.begin(), m_matches.end());
-    else
-      throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
+    saveFile(filepath, m_matches.begin(), m_matches.end());
   }
 
   /// Export matches into separate files, one for each image.
@@ -359,10 +721,7 @@ public:
       const std::string filepath = (fs::path(m_directory) / (std::to_string(key) + "." + m_filename)).string();
       ALICEVISION_LOG_DEBUG("Export Matches in: " << filepath);
       
-      if(m_ext == ".txt")
-        saveTxt(filepath, matchBegin, match);
-      else
-        throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
+      saveFile(filepath, matchBegin, match);
 
       matchBegin = match;
     }
@@ -373,6 +732,8 @@ public:
   const std::string m_ext;
   std::string m_directory;
   std::string m_filename;
+  /// compress the feature indices of binary match files
+  bool m_binaryCompression;
 };
 
 
@@ -381,11 +742,12 @@ bool Save(
   const std::string & folder,
   const std::string & extension,
   bool matchFilePerImage,
-  const std::string& prefix
+  const std::string& prefix,
+  bool binaryCompression
   )
 {
   const std::string filename = prefix + "matches." + extension;
-  MatchExporter exporter(matches, folder, filename);
+  MatchExporter exporter(matches, folder, filename, binaryCompression);
 
   if(matchFilePerImage)
     exporter.saveOneFilePerImage();
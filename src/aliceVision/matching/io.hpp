@@ -9,12 +9,103 @@
 
 #include <aliceVision/matching/IndMatch.hpp>
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace aliceVision {
 namespace matching {
 
-  
+/**
+ * @brief Binary match file (.bin)
+ *
+ * The layout is:
+ *  - a fixed size header (MatchFileHeader)
+ *  - the index, one MatchFileIndexEntry per pair and describer type
+ *  - the matches data of each index entry, starting at MatchFileIndexEntry::offset
+ *
+ * The matches of one index entry are either stored as raw (I, J) feature indices,
+ * or as zigzag encoded deltas with the previous match, written as varints (LEB128).
+ * Deltas keep the matches order and are small since features indices are close.
+ */
+
+/// Magic number identifying a binary match file ("AVMA")
+constexpr std::uint32_t MATCH_FILE_MAGIC = 0x414d5641;
+/// Current version of the binary match file format
+constexpr std::uint32_t MATCH_FILE_VERSION = 1;
+
+/**
+ * @brief Encoding of the matches data in a binary match file
+ */
+enum class EMatchFileEncoding : std::uint32_t
+{
+  RAW = 0,
+  DELTA_VARINT = 1
+};
+
+/**
+ * @brief Fixed size header of a binary match file
+ */
+struct MatchFileHeader
+{
+  std::uint32_t magic = MATCH_FILE_MAGIC;
+  std::uint32_t version = MATCH_FILE_VERSION;
+  /// encoding of the matches data (EMatchFileEncoding)
+  std::uint32_t encoding = static_cast<std::uint32_t>(EMatchFileEncoding::RAW);
+  std::uint32_t reserved = 0;
+  /// number of entries of the index
+  std::uint64_t indexSize = 0;
+};
+
+static_assert(sizeof(MatchFileHeader) == 24, "Unexpected MatchFileHeader size.");
+
+/**
+ * @brief Index entry of a binary match file, locates the matches of one pair and one describer type
+ */
+struct MatchFileIndexEntry
+{
+  std::uint32_t I = 0;
+  std::uint32_t J = 0;
+  /// describer type (feature::EImageDescriberType)
+  std::uint32_t descType = 0;
+  std::uint32_t reserved = 0;
+  /// number of matches
+  std::uint64_t count = 0;
+  /// offset in bytes from the beginning of the file of the matches data
+  std::uint64_t offset = 0;
+  /// size in bytes of the matches data
+  std::uint64_t size = 0;
+};
+
+static_assert(sizeof(MatchFileIndexEntry) == 40, "Unexpected MatchFileIndexEntry size.");
+
+/**
+ * @brief Load the index of a binary match file.
+ *
+ * @param[out] index: the index entries of the file
+ * @param[in] filepath: the binary match file (.bin)
+ * @return false if the file can't be read or is not a binary match file
+ */
+bool LoadMatchFileIndex(
+  std::vector<MatchFileIndexEntry>& index,
+  const std::string& filepath);
+
+/**
+ * @brief Load the matches of a single pair from a match file.
+ *
+ * Binary match files are randomly accessed through their index, only the matches of the pair are read.
+ * Text match files are fully parsed.
+ *
+ * @param[out] matches: the matches of the pair for each describer type (empty if the pair is not in the file)
+ * @param[in] filepath: the match file (.txt or .bin)
+ * @param[in] pair: the pair of views
+ * @return false if the file can't be read
+ */
+bool LoadMatchFilePair(
+  MatchesPerDescType& matches,
+  const std::string& filepath,
+  const Pair& pair);
+
 /**
  * @brief Load a match file.
  *
@@ -76,13 +167,15 @@ void filterTopMatches(
  * @param[in] matchFilePerImage: do we store a global match file
  *            or one match file per image
  * @param[in] prefix: optional prefix for the output file(s)
+ * @param[in] binaryCompression: compress the feature indices of binary match files (delta + varint)
  */
 bool Save(
   const PairwiseMatches& matches,
   const std::string& folder,
   const std::string& extension,
   bool matchFilePerImage,
-  const std::string& prefix="");
+  const std::string& prefix="",
+  bool binaryCompression=true);
 
 }  // namespace matching
 }  // namespace aliceVision
@@ -17,8 +17,14 @@
 #include "algorithm.h"
 #include <functional>
 #include <numeric>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <unordered_map>
 #include <aliceVision/image/all.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 using namespace std;
 using namespace aliceVision;
@@ -146,12 +152,22 @@ VLD::VLD( const ImageScale& series, T const& P1, T const& P2 ) : contrast( 0.0 )
     xi /= float( ratio );
     yi /= float( ratio );
 
-    for( int y = int( yi - r ); y <= int( yi + r + 0.5 ); y++ )
+    // pixels of the disc inside the image borders (c.f. inside( w, h, x, y, 1 ))
+    const int yMin = max( int( yi - r ), 1 ), yMax = min( int( yi + r + 0.5 ), h - 2 );
+    const int xMin = max( int( xi - r ), 1 ), xMax = min( int( xi + r + 0.5 ), w - 2 );
+    // conservative bound of the squared distance, to skip the corners of the square without computing the distance
+    const float r2Bound = sigma2 * 1.001f + 1.f;
+
+    for( int y = yMin; y <= yMax; y++ )
     {
-      for( int x = int( xi - r ); x <= int( xi + r + 0.5 ); x++ )
+      const float ey = yi - float( y );
+      for( int x = xMin; x <= xMax; x++ )
       {
+        const float ex = xi - float( x );
+        if( ex * ex + ey * ey > r2Bound )
+          continue;
         float d = point_distance( xi, yi, float( x ), float( y ) );
-        if( d <= r && inside( w, h, x, y, 1 ) )
+        if( d <= r )
         {
           //================angle and magnitude==========================//
           double angle;
@@ -198,8 +214,73 @@ VLD::VLD( const ImageScale& series, T const& P1, T const& P2 ) : contrast( 0.0 )
   normalize_weight( weight );
 }
 
+namespace {
+
+//====== spatial grid of the matched points, to find the neighbor matches ======//
+class MatchesGrid
+{
+public:
+  MatchesGrid( const std::vector< std::pair< float, float > >& points, float cellSize )
+    : _cellSize( ( std::isfinite( cellSize ) && cellSize > 0 ) ? cellSize : std::numeric_limits< float >::infinity() )
+  {
+    for( int i = 0; i < points.size(); ++i )
+      _cells[ key( cell( points[ i ].first ), cell( points[ i ].second ) ) ].push_back( i );
+  }
+
+  /// append the indexes of the points in the square of half size radius around (x, y)
+  void query( float x, float y, float radius, std::vector< int >& indexes ) const
+  {
+    const long long xMin = cell( x - radius ), xMax = cell( x + radius );
+    const long long yMin = cell( y - radius ), yMax = cell( y + radius );
+    for( long long cy = yMin; cy <= yMax; ++cy )
+      for( long long cx = xMin; cx <= xMax; ++cx )
+      {
+        const auto it = _cells.find( key( cx, cy ) );
+        if( it != _cells.end() )
+          indexes.insert( indexes.end(), it->second.begin(), it->second.end() );
+      }
+  }
+
+private:
+  long long cell( float v ) const
+  {
+    return std::isfinite( _cellSize ) ? static_cast< long long >( std::floor( v / _cellSize ) ) : 0;
+  }
+
+  static long long key( long long cx, long long cy )
+  {
+    return ( cx << 32 ) ^ ( cy & 0xffffffffLL );
+  }
+
+  float _cellSize;
+  std::unordered_map< long long, std::vector< int > > _cells;
+};
+
+} // namespace
+
+float KVLD( const Image< float >& I1,
+            const Image< float >& I2,
+            const std::vector<feature::SIOPointFeature> & F1,
+            const std::vector<feature::SIOPointFeature> & F2,
+            const vector< Pair >& matches,
+            vector< Pair >& matchesFiltered,
+            vector< double >& score,
+            aliceVision::Mat& E,
+            vector< bool >& valide,
+            KvldParameters& kvldParameters )
+{
+  const ImageScale Chaine1( I1 );
+  const ImageScale Chaine2( I2 );
+
+  cout << "Image scale-space complete..." << endl;
+
+  return KVLD( I1, I2, Chaine1, Chaine2, F1, F2, matches, matchesFiltered, score, E, valide, kvldParameters );
+}
+
 float KVLD( const Image< float >& I1,
             const Image< float >& I2,
+            const ImageScale& Chaine1,
+            const ImageScale& Chaine2,
             const std::vector<feature::SIOPointFeature> & F1,
             const std::vector<feature::SIOPointFeature> & F2,
             const vector< Pair >& matches,
@@ -211,43 +292,80 @@ float KVLD( const Image< float >& I1,
 {
   matchesFiltered.clear();
   score.clear();
-  ImageScale Chaine1( I1 );
-  ImageScale Chaine2( I2 );
 
-  cout << "Image scale-space complete..." << endl;
+  const size_t size = matches.size();
+  if( size == 0 )
+    return 0.f;
 
   const float range1 = getRange( I1, min( F1.size(), matches.size() ), kvldParameters.inlierRate );
   const float range2 = getRange( I2, min( F2.size(), matches.size() ), kvldParameters.inlierRate );
 
-  const size_t size = matches.size();
+  //================spatial grids construction, for use of selecting neighbors===============//
+  // a neighbor match is closer than range1 in the first image or closer than range2 in the second image
+  cout << "computing neighbors grids" << endl;
 
-  //================distance map construction, foruse of selecting neighbors===============//
-  cout << "computing distance maps" << endl;
+  vector< pair< float, float > > points1( size ), points2( size );
+  for( int it = 0; it < size; it++ )
+  {
+    const feature::SIOPointFeature& f1 = F1[ matches[ it ].first ];
+    const feature::SIOPointFeature& f2 = F2[ matches[ it ].second ];
+    points1[ it ] = make_pair( f1.x(), f1.y() );
+    points2[ it ] = make_pair( f2.x(), f2.y() );
+  }
+  const MatchesGrid grid1( points1, range1 );
+  const MatchesGrid grid2( points2, range2 );
 
-  bool bPrecomputedDist = false;
+  // candidate neighbors of each match, by increasing index
+  vector< vector< int > > neighbors( size );
+  #pragma omp parallel for schedule(dynamic, 64)
+  for( int it = 0; it < size; it++ )
+  {
+    vector< int >& candidates = neighbors[ it ];
+    grid1.query( points1[ it ].first, points1[ it ].second, range1, candidates );
+    grid2.query( points2[ it ].first, points2[ it ].second, range2, candidates );
+    sort( candidates.begin(), candidates.end() );
+    candidates.erase( unique( candidates.begin(), candidates.end() ), candidates.end() );
+  }
 
-  aliceVision::Matf dist1, dist2;
-  if( bPrecomputedDist )
+  const auto isNeighbor = [&]( size_t a1, size_t b1, size_t a2, size_t b2 )
   {
-    dist1 = aliceVision::Matf::Zero( F1.size(), F1.size() );
-    dist2 = aliceVision::Matf::Zero( F2.size(), F2.size() );
+    const float d1 = point_distance( F1[ a1 ], F1[ a2 ] );
+    const float d2 = point_distance( F2[ b1 ], F2[ b2 ] );
+    return ( d1 > min_dist && d2 > min_dist && ( d1 < range1 || d2 < range2 ) );
+  };
 
-    for( int a1 = 0; a1 < F1.size(); ++a1 )
-      for( int a2 = a1; a2 < F1.size(); ++a2 )
-        dist1( a1, a2 ) = dist1( a2, a1 ) = point_distance( F1[ a1 ], F1[ a2 ] );
+  // update E(it1, it2) if unknown, return true if the matches are gvld-consistent (or vld-consistent)
+  const auto updateConsistency = [&]( int it1, int it2 )
+  {
+    if( E( it1, it2 ) == -1 )
+    {
+      const size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
+      const size_t a2 = matches[ it2 ].first, b2 = matches[ it2 ].second;
 
-    for( int b1 = 0; b1 < F2.size(); ++b1 )
-      for( int b2 = b1; b2 < F2.size(); ++b2 )
-        dist2( b1, b2 ) = dist2( b2, b1 ) = point_distance( F2[ b1 ], F2[ b2 ] );
-  }
+      E( it1, it2 ) = -2;
+      E( it2, it1 ) = -2;
+
+      if( !kvldParameters.geometry || consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] ) < distance_thres )
+      {
+        const VLD vld1( Chaine1, F1[ a1 ], F1[ a2 ] );
+        const VLD vld2( Chaine2, F2[ b1 ], F2[ b2 ] );
+        const double error = vld1.difference( vld2 );
+        if( error < juge )
+        {
+          E( it1, it2 ) = ( float ) error;
+          E( it2, it1 ) = ( float ) error;
+        }
+      }
+    }
+    return E( it1, it2 ) >= 0;
+  };
 
   fill( valide.begin(), valide.end(), true );
   vector< double > scoretable( size, 0.0 );
   vector< size_t > result( size, 0 );
-
+  vector< char > switching( size, false );
 
 //============main iteration formatch verification==========//
-//    cout<<"main iteration";
   bool change = true;
 
   while( change )
@@ -256,58 +374,49 @@ float KVLD( const Image< float >& I1,
 
     fill( scoretable.begin(), scoretable.end(), 0.0 );
     fill( result.begin(), result.end(), 0 );
+
     //========substep 1: search foreach match its neighbors and verify if they are gvld-consistent ============//
-    for( int it1 = 0; it1 < size - 1; it1++ )
+    // the vld of the neighbor matches are first computed in parallel: each match computes the upper part of its row of E,
+    // up to the max_connection consistent neighbors, which is never less than what the sequential vote below needs
+    // (the extra vld are only worth it with several threads)
+    if( omp_get_max_threads() > 1 )
     {
-      if( valide[ it1 ] )
+      #pragma omp parallel for schedule(dynamic, 16)
+      for( int it1 = 0; it1 < size - 1; it1++ )
       {
-        size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
-
-        for( int it2 = it1 + 1; it2 < size; it2++ )
-          if(valide[ it2 ])
-          {
-            size_t a2 = matches[ it2 ].first, b2 = matches[ it2 ].second;
-
-            bool bOk = false;
-            if( bPrecomputedDist )
-              bOk = ( dist1( a1, a2 ) > min_dist && dist2( b1, b2 ) > min_dist
-                 && ( dist1( a1, a2 ) < range1   || dist2( b1, b2 ) < range2 ) );
-            else
-              bOk = ( point_distance( F1[ a1 ], F1[ a2 ] ) > min_dist && point_distance( F2[ b1 ], F2[ b2 ] ) > min_dist &&
-                    ( point_distance( F1[ a1 ], F1[ a2 ] ) < range1   || point_distance( F2[ b1 ], F2[ b2 ] ) < range2 ) );
-            if( bOk )
-            {
-              if( E( it1, it2 ) == -1 )
-              { //update E ifunknow
-                E( it1, it2 ) = -2;
-                E( it2, it1 ) = -2;
+        if( !valide[ it1 ] )
+          continue;
+        const size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
+        size_t connections = 0;
+        for( const int it2 : neighbors[ it1 ] )
+        {
+          if( it2 <= it1 || !valide[ it2 ] || !isNeighbor( a1, b1, matches[ it2 ].first, matches[ it2 ].second ) )
+            continue;
+          if( updateConsistency( it1, it2 ) && ++connections >= max_connection )
+            break;
+        }
+      }
+    }
 
-                if( !kvldParameters.geometry || consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] ) < distance_thres )
-                {
-                  VLD vld1( Chaine1, F1[ a1 ], F1[ a2 ] );
-                  VLD vld2( Chaine2, F2[ b1 ], F2[ b2 ] );
-                  //vld1.test();
-                  double error = vld1.difference( vld2 );
-                  //cout<<endl<<it1<<" "<<it2<<" "<<dist1(a1,a2)<<" "<< dist2(b1,b2)<<" "<<error<<endl;
-                  if( error < juge )
-                  {
-                    E( it1, it2 ) = ( float ) error;
-                    E( it2, it1 ) = ( float ) error;
-                    //cout<<E(it2,it1)<<endl;
-                  }
-                }
-              }
-              if( E( it1, it2 ) >= 0 )
-              {
-                result[ it1 ] += 1;
-                result[ it2 ] += 1;
-                scoretable[ it1 ] += double( E( it1, it2 ) );
-                scoretable[ it2 ] += double( E( it1, it2 ) );
-                if( result[ it1 ] >= max_connection )
-                  break;
-              }
-            }
-          }
+    // vote of the consistent neighbors
+    for( int it1 = 0; it1 < size - 1; it1++ )
+    {
+      if( !valide[ it1 ] )
+        continue;
+      const size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
+      for( const int it2 : neighbors[ it1 ] )
+      {
+        if( it2 <= it1 || !valide[ it2 ] || !isNeighbor( a1, b1, matches[ it2 ].first, matches[ it2 ].second ) )
+          continue;
+        if( updateConsistency( it1, it2 ) )
+        {
+          result[ it1 ] += 1;
+          result[ it2 ] += 1;
+          scoretable[ it1 ] += double( E( it1, it2 ) );
+          scoretable[ it2 ] += double( E( it1, it2 ) );
+          if( result[ it1 ] >= max_connection )
+            break;
+        }
       }
     }
 
@@ -321,14 +430,36 @@ float KVLD( const Image< float >& I1,
       }
     }
     //========substep 3: remove multiple matches to a same point by keeping the one with the best average gvld-consistency score ============//
+    // the multiple matches share a point position in the first or in the second image
     if( uniqueMatch )
+    {
+      map< pair< float, float >, vector< int > > samePoint1, samePoint2;
+      for( int it = 0; it < size; it++ )
+      {
+        if( valide[ it ] )
+        {
+          samePoint1[ points1[ it ] ].push_back( it );
+          samePoint2[ points2[ it ] ].push_back( it );
+        }
+      }
+
+      vector< int > candidates;
       for( int it1 = 0; it1 < size - 1; it1++ )
-        if( valide[ it1 ]) {
+        if( valide[ it1 ] )
+        {
+          const vector< int >& same1 = samePoint1.at( points1[ it1 ] );
+          const vector< int >& same2 = samePoint2.at( points2[ it1 ] );
+          if( same1.size() == 1 && same2.size() == 1 )
+            continue;
+
           size_t a1 = matches[ it1 ].first;
           size_t b1 = matches[ it1 ].second;
 
-          for( int it2 = it1 + 1; it2 < size; it2++ )
-            if( valide[ it2 ] )
+          candidates.clear();
+          set_union( same1.begin(), same1.end(), same2.begin(), same2.end(), back_inserter( candidates ) );
+
+          for( const int it2 : candidates )
+            if( it2 > it1 && valide[ it2 ] )
             {
               size_t a2 = matches[ it2 ].first;
               size_t b2 = matches[ it2 ].second;
@@ -367,16 +498,14 @@ float KVLD( const Image< float >& I1,
               }
             }
         }
+    }
     //========substep 4: ifgeometric verification is set, re-score matches by geometric-consistency, and remove poorly scored ones ============================//
     if( uniqueMatch && kvldParameters.geometry )
     {
-      for( int i = 0; i < size; i++ )
-        scoretable[ i ]=0;
-
-      vector< bool > switching;
-      for( int i = 0; i < size; i++ )
-        switching.push_back( false );
+      fill( scoretable.begin(), scoretable.end(), 0.0 );
+      fill( switching.begin(), switching.end(), false );
 
+      #pragma omp parallel for schedule(dynamic, 64)
       for( int it1 = 0; it1 < size; it1++ )
       {
         if( valide[ it1 ] )
@@ -384,21 +513,14 @@ float KVLD( const Image< float >& I1,
           size_t a1 = matches[ it1 ].first, b1 = matches[ it1 ].second;
           float index = 0.0f;
           int good_index = 0;
-          for( int it2 = 0; it2 < size; it2++ )
+          for( const int it2 : neighbors[ it1 ] )
           {
             if( it1 != it2 && valide[ it2 ] )
             {
               size_t a2 = matches[ it2 ].first;
               size_t b2 = matches[ it2 ].second;
 
-              bool bOk = false;
-              if( bPrecomputedDist )
-                bOk = ( dist1( a1, a2 ) > min_dist && dist2( b1, b2 ) > min_dist &&
-                      ( dist1( a1, a2 ) < range1   || dist2( b1, b2 ) < range2 ) );
-              else
-                bOk = ( point_distance( F1[ a1 ], F1[ a2 ] ) > min_dist && point_distance( F2[ b1 ], F2[ b2 ] ) > min_dist &&
-                      ( point_distance( F1[ a1 ], F1[ a2 ] ) < range1   || point_distance( F2[ b1 ], F2[ b2 ] ) < range2 ) );
-              if( bOk )
+              if( isNeighbor( a1, b1, a2, b2 ) )
               {
                 float d = consistent( F1[ a1 ], F1[ a2 ], F2[ b1 ], F2[ b2 ] );
                 scoretable[ it1 ] += d;
@@ -410,15 +532,15 @@ float KVLD( const Image< float >& I1,
           }
           scoretable[ it1 ] /= index;
           if( good_index < 0.3f * float( index ) && scoretable[ it1 ] > 1.2 )
-          {
             switching[ it1 ] = true;
-            change = true;
-          }
         }
       }
       for( int it1 = 0; it1 < size; it1++ )
         if( switching[ it1 ] )
+        {
           valide[ it1 ] = false;
+          change = true;
+        }
     }
   }
   //=============== generating output list ===================//
@@ -430,4 +552,3 @@ float KVLD( const Image< float >& I1,
     }
   return float( matchesFiltered.size() ) / matches.size();
 }
-
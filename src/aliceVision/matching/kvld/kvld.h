@@ -174,4 +174,19 @@ float KVLD(const aliceVision::image::Image< float >& I1,
   std::vector< bool >& valide,
   KvldParameters& kvldParameters );
 
+//Same as above, with the pyramids of scale images Chaine1 and Chaine2 of I1 and I2 already computed,
+//so they can be shared by all the image pairs of a view or by successive KVLD calls with other parameters.
+float KVLD(const aliceVision::image::Image< float >& I1,
+  const aliceVision::image::Image< float >& I2,
+  const ImageScale& Chaine1,
+  const ImageScale& Chaine2,
+  const std::vector<aliceVision::feature::SIOPointFeature> & F1,
+  const std::vector<aliceVision::feature::SIOPointFeature> & F2,
+  const std::vector< aliceVision::Pair >& matches,
+  std::vector< aliceVision::Pair >& matchesFiltered,
+  std::vector< double >& score,
+  aliceVision::Mat& E,
+  std::vector< bool >& valide,
+  KvldParameters& kvldParameters );
+
 #endif //KVLD_H
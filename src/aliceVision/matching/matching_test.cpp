@@ -7,9 +7,15 @@
 
 #include "aliceVision/numeric/numeric.hpp"
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
+#include "aliceVision/matching/ArrayMatcher_bruteForceCuda.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
+#include "aliceVision/matching/CascadeHasherIO.hpp"
+
+#include <boost/filesystem.hpp>
+
 #include <iostream>
+#include <random>
 
 #define BOOST_TEST_MODULE matching
 #include <boost/test/included/unit_test.hpp>
@@ -114,6 +120,56 @@ BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_Simple__NN)
   BOOST_CHECK_EQUAL(IndMatch(0,4), vec_nIndice[4]);
 }
 
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_IndexFile)
+{
+  namespace fs = boost::filesystem;
+
+  const int dimension = 16;
+  const int count = 500;
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::vector<float> descriptors(count * dimension);
+  for(float& value : descriptors)
+    value = dist(gen);
+  std::vector<float> otherDescriptors = descriptors;
+  otherDescriptors.front() += 1.f;
+
+  const feature::DescriptorSpan<float> span(descriptors.data(), count, dimension);
+  const feature::DescriptorSpan<float> otherSpan(otherDescriptors.data(), count, dimension);
+  const std::string prefix = (fs::temp_directory_path() / fs::unique_path("%%%%-%%%%")).string();
+  const std::string filename = getKdTreeIndexFilename(prefix, span);
+
+  // the file name depends on the descriptors
+  BOOST_CHECK_EQUAL(filename, getKdTreeIndexFilename(prefix, span));
+  BOOST_CHECK_NE(filename, getKdTreeIndexFilename(prefix, otherSpan));
+
+  // the first build saves the index, the second one loads it
+  ArrayMatcher_kdtreeFlann<float> builtMatcher;
+  BOOST_CHECK(builtMatcher.Build(span, prefix));
+  BOOST_CHECK(fs::exists(filename));
+  ArrayMatcher_kdtreeFlann<float> loadedMatcher;
+  BOOST_CHECK(loadedMatcher.Build(span, prefix));
+
+  const feature::DescriptorSpan<float> queries(descriptors.data(), 50, dimension);
+  IndMatches builtIndices, loadedIndices;
+  std::vector<float> builtDistances, loadedDistances;
+  BOOST_CHECK(builtMatcher.SearchNeighbours(queries, &builtIndices, &builtDistances, 2));
+  BOOST_CHECK(loadedMatcher.SearchNeighbours(queries, &loadedIndices, &loadedDistances, 2));
+  BOOST_CHECK(builtIndices == loadedIndices);
+  BOOST_CHECK(builtDistances == loadedDistances);
+
+  // an index saved for another dataset size is not used
+  ArrayMatcher_kdtreeFlann<float> smallerMatcher;
+  BOOST_CHECK(smallerMatcher.Build(descriptors.data(), count - 1, dimension, filename));
+  IndMatches smallerIndices;
+  std::vector<float> smallerDistances;
+  BOOST_CHECK(smallerMatcher.SearchNeighbours(queries, &smallerIndices, &smallerDistances, 1));
+  BOOST_CHECK_EQUAL(IndMatch(0, 0), smallerIndices.front());
+
+  fs::remove(filename);
+}
+
 //-- Test LIMIT case (empty arrays)
 
 BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Simple_EmptyArrays)
@@ -148,3 +204,128 @@ BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_Simple_EmptyArrays)
   float fDistance = -1.0f;
   BOOST_CHECK(! matcher.SearchNeighbour( &array[0], &nIndice, &fDistance) );
 }
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_DescriptorSpan)
+{
+  const float array[] = {
+    0, 1, 2, 3,
+    4, 5, 6, 7,
+    8, 9, 10, 11};
+  const feature::DescriptorSpan<float> dataset(array, 3, 4);
+  BOOST_CHECK_EQUAL(dataset[1], &array[4]);
+  BOOST_CHECK_EQUAL(dataset.asMatrix()(2, 1), 9.0f);
+
+  const float query[] = {4, 5, 6, 7};
+  const feature::DescriptorSpan<float> queries(query, 1, 4);
+
+  ArrayMatcher_bruteForce<float> matcherBrute;
+  ArrayMatcher_kdtreeFlann<float> matcherFlann;
+  BOOST_CHECK( matcherBrute.Build(dataset) );
+  BOOST_CHECK( matcherFlann.Build(dataset) );
+
+  IndMatches vec_nIndiceBrute, vec_nIndiceFlann;
+  vector<float> vec_fDistanceBrute, vec_fDistanceFlann;
+  BOOST_CHECK( matcherBrute.SearchNeighbours(queries, &vec_nIndiceBrute, &vec_fDistanceBrute, 1) );
+  BOOST_CHECK( matcherFlann.SearchNeighbours(queries, &vec_nIndiceFlann, &vec_fDistanceFlann, 1) );
+
+  BOOST_CHECK_EQUAL(IndMatch(0,1), vec_nIndiceBrute[0]);
+  BOOST_CHECK_EQUAL(IndMatch(0,1), vec_nIndiceFlann[0]);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistanceBrute[0]), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistanceFlann[0]), 1e-6);
+
+  // empty span
+  ArrayMatcher_bruteForce<float> matcherEmpty;
+  BOOST_CHECK(! matcherEmpty.Build(feature::DescriptorSpan<float>()) );
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForceCuda_2NN)
+{
+  std::srand(0);
+
+  // without CUDA device, the CPU brute force matcher is used
+  const int dimension = 128;
+  const int nbData = 100;
+  const int nbQuery = 70;
+  std::vector<unsigned char> dataset(nbData * dimension);
+  std::vector<unsigned char> queries(nbQuery * dimension);
+  for(auto& value : dataset)
+    value = static_cast<unsigned char>(std::rand() % 256);
+  for(auto& value : queries)
+    value = static_cast<unsigned char>(std::rand() % 256);
+
+  typedef L2_Vectorized<unsigned char> MetricT;
+  ArrayMatcher_bruteForce<unsigned char, MetricT> matcher;
+  ArrayMatcher_bruteForceCuda<unsigned char, MetricT> matcherCuda;
+  BOOST_CHECK(matcher.Build(dataset.data(), nbData, dimension));
+  BOOST_CHECK(matcherCuda.Build(dataset.data(), nbData, dimension));
+
+  IndMatches indices, indicesCuda;
+  std::vector<MetricT::ResultType> distances, distancesCuda;
+  BOOST_CHECK(matcher.SearchNeighbours(queries.data(), nbQuery, &indices, &distances, 2));
+  BOOST_CHECK(matcherCuda.SearchNeighbours(queries.data(), nbQuery, &indicesCuda, &distancesCuda, 2));
+
+  BOOST_CHECK_EQUAL_COLLECTIONS(distances.begin(), distances.end(), distancesCuda.begin(), distancesCuda.end());
+  BOOST_CHECK(indices == indicesCuda);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_CascadeHasher_IO)
+{
+  namespace fs = boost::filesystem;
+
+  const int dimension = 128;
+  const int count = 200;
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(0, 255);
+  std::vector<unsigned char> descriptors(count * dimension);
+  for(unsigned char& value : descriptors)
+    value = dist(gen);
+
+  const feature::DescriptorSpan<unsigned char> span(descriptors.data(), count, dimension);
+  const Eigen::VectorXf zeroMean = CascadeHasher::GetZeroMeanDescriptor(span);
+
+  // the same seed gives the same hasher
+  CascadeHasher hasher;
+  hasher.InitWithSeed(42, dimension);
+  CascadeHasher sameHasher;
+  sameHasher.InitWithSeed(42, dimension);
+  CascadeHasher otherHasher;
+  otherHasher.InitWithSeed(43, dimension);
+  const std::uint64_t key = hasher.GetKey(zeroMean);
+  BOOST_CHECK_EQUAL(key, sameHasher.GetKey(zeroMean));
+  BOOST_CHECK_NE(key, otherHasher.GetKey(zeroMean));
+
+  const HashedDescriptions hashed = hasher.CreateHashedDescriptions(span, zeroMean);
+
+  const std::string hasherFilename = (fs::temp_directory_path() / fs::unique_path("%%%%-%%%%.hasher")).string();
+  const std::string hashFilename = (fs::temp_directory_path() / fs::unique_path("%%%%-%%%%.hash")).string();
+
+  saveCascadeHasher(hasherFilename, hasher, zeroMean);
+  saveHashedDescriptions(hashFilename, hashed, key);
+
+  // rebuild the hasher from the file
+  CascadeHasher loadedHasher;
+  Eigen::VectorXf loadedZeroMean;
+  BOOST_CHECK(!loadCascadeHasher(hasherFilename, 64, loadedHasher, loadedZeroMean));
+  BOOST_CHECK(loadCascadeHasher(hasherFilename, dimension, loadedHasher, loadedZeroMean));
+  BOOST_CHECK_EQUAL(key, loadedHasher.GetKey(loadedZeroMean));
+
+  // reload the hash codes and the buckets
+  HashedDescriptions loaded;
+  BOOST_CHECK(!loadHashedDescriptions(hashFilename, loadedHasher, key + 1, count, loaded));
+  BOOST_CHECK(!loadHashedDescriptions(hashFilename, loadedHasher, key, count + 1, loaded));
+  BOOST_CHECK(loadHashedDescriptions(hashFilename, loadedHasher, key, count, loaded));
+
+  BOOST_CHECK_EQUAL(hashed.hashed_desc.size(), loaded.hashed_desc.size());
+  for(std::size_t i = 0; i < hashed.hashed_desc.size(); ++i)
+  {
+    const HashedDescription& a = hashed.hashed_desc[i];
+    const HashedDescription& b = loaded.hashed_desc[i];
+    BOOST_CHECK(std::equal(a.hash_code.data(), a.hash_code.data() + a.hash_code.num_blocks(), b.hash_code.data()));
+    BOOST_CHECK(a.bucket_ids == b.bucket_ids);
+  }
+  BOOST_CHECK(hashed.buckets == loaded.buckets);
+
+  fs::remove(hasherFilename);
+  fs::remove(hashFilename);
+}
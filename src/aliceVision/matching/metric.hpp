@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "aliceVision/matching/metricSimd.hpp"
 #include "aliceVision/matching/Hamming.hpp"
 #include "aliceVision/numeric/Accumulator.hpp"
 #include <aliceVision/config.hpp>
@@ -41,6 +42,33 @@ struct L2_Simple
   }
 };
 
+/// Squared Euclidean distance, 4 items by loop (see L2_Vectorized)
+template <typename ResultType, typename Iterator1, typename Iterator2>
+inline ResultType l2Unrolled(Iterator1 a, Iterator2 b, size_t size)
+{
+  ResultType result = ResultType();
+  ResultType diff0, diff1, diff2, diff3;
+  Iterator1 last = a + size;
+  Iterator1 lastgroup = last - 3;
+
+  // Process 4 items with each loop for efficiency.
+  while (a < lastgroup) {
+    diff0 = a[0] - b[0];
+    diff1 = a[1] - b[1];
+    diff2 = a[2] - b[2];
+    diff3 = a[3] - b[3];
+    result += diff0 * diff0 + diff1 * diff1 + diff2 * diff2 + diff3 * diff3;
+    a += 4;
+    b += 4;
+  }
+  // Process last 0-3 pixels.  Not needed for standard vector lengths.
+  while (a < last) {
+    diff0 = *a++ - *b++;
+    result += diff0 * diff0;
+  }
+  return result;
+}
+
 /// Squared Euclidean distance functor (vectorized version)
 template<class T>
 struct L2_Vectorized
@@ -51,30 +79,33 @@ struct L2_Vectorized
   template <typename Iterator1, typename Iterator2>
   inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
   {
-    ResultType result = ResultType();
-    ResultType diff0, diff1, diff2, diff3;
-    Iterator1 last = a + size;
-    Iterator1 lastgroup = last - 3;
-
-    // Process 4 items with each loop for efficiency.
-    while (a < lastgroup) {
-      diff0 = a[0] - b[0];
-      diff1 = a[1] - b[1];
-      diff2 = a[2] - b[2];
-      diff3 = a[3] - b[3];
-      result += diff0 * diff0 + diff1 * diff1 + diff2 * diff2 + diff3 * diff3;
-      a += 4;
-      b += 4;
-    }
-    // Process last 0-3 pixels.  Not needed for standard vector lengths.
-    while (a < last) {
-      diff0 = *a++ - *b++;
-      result += diff0 * diff0;
-    }
-    return result;
+    return l2Unrolled<ResultType>(a, b, size);
   }
 };
 
+#ifdef ALICEVISION_HAVE_AVX2
+
+// Template specification to run AVX2 L2 squared distance
+//  on unsigned char vector
+template<>
+struct L2_Vectorized<unsigned char>
+{
+  typedef unsigned char ElementType;
+  typedef Accumulator<unsigned char>::Type ResultType;
+
+  template <typename Iterator1, typename Iterator2>
+  inline ResultType operator()(Iterator1 a, Iterator2 b, size_t size) const
+  {
+    // The integer sum gives the same float result than l2Unrolled
+    // as long as it is exactly representable (< 2^24, i.e. up to 256 items).
+    if(size % 16 == 0 && size <= 256 && system::use_avx2_kernels())
+      return static_cast<ResultType>(optim_avx2::l2_avx2(&a[0], &b[0], size));
+    return l2Unrolled<ResultType>(a, b, size);
+  }
+};
+
+#endif // ALICEVISION_HAVE_AVX2
+
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_SSE)
 
 namespace optim_ss2{
@@ -0,0 +1,78 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/cpu.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+// AVX2 distance kernels, selected at runtime (see system::use_avx2_kernels)
+#ifdef ALICEVISION_HAVE_AVX2
+#include <immintrin.h>
+
+namespace aliceVision {
+namespace matching {
+namespace optim_avx2 {
+
+/**
+ * @brief Squared Euclidean distance between two unsigned char vectors (AVX2).
+ * @note The result is an exact integer, size must be a multiple of 16.
+ */
+ALICEVISION_AVX2_TARGET
+inline std::uint32_t l2_avx2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  __m256i cumSum = _mm256_setzero_si256();
+  for(std::size_t i = 0; i < size; i += 16)
+  {
+    //-- Widen to 16 bits
+    const __m256i srcA = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+    const __m256i srcB = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+    //-- Subtract
+    const __m256i diff = _mm256_sub_epi16(srcA, srcB);
+    //-- Multiply and sum by pairs in 32 bits
+    cumSum = _mm256_add_epi32(cumSum, _mm256_madd_epi16(diff, diff));
+  }
+  std::uint32_t res[8];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(res), cumSum);
+  return res[0] + res[1] + res[2] + res[3] + res[4] + res[5] + res[6] + res[7];
+}
+
+/**
+ * @brief Hamming distance between two binary descriptors (AVX2).
+ *
+ * Count the bits of the XOR with a 4 bits lookup table (pshufb),
+ * the byte counts are then summed by groups of 8 (psadbw).
+ * @note size is in bytes and must be a multiple of 32.
+ */
+ALICEVISION_AVX2_TARGET
+inline unsigned int hamming_avx2(const unsigned char* a, const unsigned char* b, std::size_t size)
+{
+  const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i lowMask = _mm256_set1_epi8(0x0f);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i cumSum = zero;
+  for(std::size_t i = 0; i < size; i += 32)
+  {
+    const __m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    const __m256i low = _mm256_and_si256(x, lowMask);
+    const __m256i high = _mm256_and_si256(_mm256_srli_epi16(x, 4), lowMask);
+    const __m256i count = _mm256_add_epi8(_mm256_shuffle_epi8(lut, low), _mm256_shuffle_epi8(lut, high));
+    cumSum = _mm256_add_epi64(cumSum, _mm256_sad_epu8(count, zero));
+  }
+  std::uint64_t res[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(res), cumSum);
+  return static_cast<unsigned int>(res[0] + res[1] + res[2] + res[3]);
+}
+
+} // namespace optim_avx2
+} // namespace matching
+} // namespace aliceVision
+
+#endif // ALICEVISION_HAVE_AVX2
@@ -6,8 +6,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/matching/metric.hpp"
+#include <bitset>
 #include <iostream>
+#include <random>
 #include <string>
+#include <vector>
 
 #define BOOST_TEST_MODULE matchingMetric
 #include <boost/test/included/unit_test.hpp>
@@ -133,3 +136,53 @@ BOOST_AUTO_TEST_CASE(Metric_HAMMING_BITSET_RAW_MEMORY_32BITS)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(Metric_L2_Vectorized_uchar_random)
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 255);
+
+  for(const size_t size : {8, 64, 128, 256, 264})
+  {
+    for(int t = 0; t < 100; ++t)
+    {
+      std::vector<unsigned char> a(size), b(size);
+      for(size_t i = 0; i < size; ++i)
+      {
+        a[i] = dist(gen);
+        b[i] = dist(gen);
+      }
+      // worst case distance
+      if(t == 0)
+      {
+        std::fill(a.begin(), a.end(), 0);
+        std::fill(b.begin(), b.end(), 255);
+      }
+      const float expected = l2Unrolled<float>(a.data(), b.data(), size);
+      BOOST_CHECK_EQUAL(expected, L2_Vectorized<unsigned char>()(a.data(), b.data(), size));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Metric_HAMMING_RAW_MEMORY_random)
+{
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 255);
+
+  // 256 bits (ORB like), 486 bits (AKAZE MLDB) stored on 64 bytes, and sizes without SIMD code path
+  for(const size_t size : {32, 61, 64, 96, 100})
+  {
+    for(int t = 0; t < 100; ++t)
+    {
+      std::vector<unsigned char> a(size), b(size);
+      unsigned int expected = 0;
+      for(size_t i = 0; i < size; ++i)
+      {
+        a[i] = dist(gen);
+        b[i] = dist(gen);
+        expected += std::bitset<8>(a[i] ^ b[i]).count();
+      }
+      BOOST_CHECK_EQUAL(expected, Hamming<unsigned char>()(a.data(), b.data(), size));
+    }
+  }
+}
@@ -12,9 +12,17 @@
 #include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilterMatrix.hpp>
+#include <aliceVision/matchingImageCollection/matchingStats.hpp>
+#include <aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp>
+#include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <map>
 
@@ -28,6 +36,13 @@ using namespace aliceVision::matching;
  * or all the pairs and regions correspondences contained in the putativeMatches set.
  * Allow to keep only geometrically coherent matches.
  * It discards pairs that do not lead to a valid robust model estimation.
+ *
+ * Pairs without enough putative matches to get a strong support are rejected before
+ * the robust estimation. The other pairs are processed from the largest to the smallest,
+ * so the heavy pairs do not delay the end of the parallel loop, and the random number
+ * generator of the robust estimation is seeded for each pair (reproducible results
+ * whatever the number of threads).
+ *
  * @param[out] geometricMatches
  * @param[in] sfmData
  * @param[in] regionsPerView
@@ -35,6 +50,7 @@ using namespace aliceVision::matching;
  * @param[in] putativeMatches
  * @param[in] guidedMatching
  * @param[in] distanceRatio
+ * @param[out] stats optional statistics, filled with the duration, inliers and iterations of each pair
  */
 template<typename GeometryFunctor>
 void robustModelEstimation(
@@ -44,24 +60,54 @@ void robustModelEstimation(
   const GeometryFunctor& functor,
   const PairwiseMatches& putativeMatches,
   const bool guidedMatching = false,
-  const double distanceRatio = 0.6)
+  const double distanceRatio = 0.6,
+  MatchingStats* stats = nullptr)
 {
+  ALICEVISION_PROFILE_SCOPE("matchingImageCollection::robustModelEstimation");
+
   out_geometricMatches.clear();
 
+  // early rejection: the inliers are a subset of the putative matches
+  const std::size_t minimumSamples = functor.getMinimumSamples();
+  std::vector<std::pair<std::size_t, PairwiseMatches::const_iterator>> sortedMatches;
+  sortedMatches.reserve(putativeMatches.size());
+  for(PairwiseMatches::const_iterator iter = putativeMatches.begin(); iter != putativeMatches.end(); ++iter)
+  {
+    if(minimumSamples > 0 && !robustEstimation::hasStrongSupport(iter->second, minimumSamples))
+      continue;
+    sortedMatches.emplace_back(iter->second.getNbAllMatches(), iter);
+  }
+
+  // largest pairs first, pair order for equal sizes
+  std::sort(sortedMatches.begin(), sortedMatches.end(),
+            [](const std::pair<std::size_t, PairwiseMatches::const_iterator>& a,
+               const std::pair<std::size_t, PairwiseMatches::const_iterator>& b)
+            {
+              return (a.first != b.first) ? (a.first > b.first) : (a.second->first < b.second->first);
+            });
+
+  if(sortedMatches.size() != putativeMatches.size())
+    ALICEVISION_LOG_INFO("Robust model estimation: " << putativeMatches.size() - sortedMatches.size()
+                         << " pairs without enough putative matches rejected.");
+
   boost::progress_display progressBar(putativeMatches.size(), std::cout, "Robust Model Estimation\n");
-  
-#pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < (int)putativeMatches.size(); ++i)
+  progressBar += putativeMatches.size() - sortedMatches.size();
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int i = 0; i < (int)sortedMatches.size(); ++i)
   {
-    PairwiseMatches::const_iterator iter = putativeMatches.begin();
-    std::advance(iter, i);
+    PairwiseMatches::const_iterator iter = sortedMatches[i].second;
 
     const Pair currentPair = iter->first;
     const MatchesPerDescType& putativeMatchesPerType = iter->second;
     const Pair& imagePair = iter->first;
 
+    // same random samples for a given pair whatever the thread
+    robustEstimation::seedRandomNumberGenerator(static_cast<std::uint32_t>(imagePair.first * 73856093u ^ imagePair.second * 19349663u));
+
     // apply the geometric filter (robust model estimation)
     {
+      system::Timer timer;
       MatchesPerDescType inliers;
       GeometryFunctor geometricFilter = functor; // use a copy since we are in a multi-thread context
       const EstimationStatus state = geometricFilter.geometricEstimation(sfmData, regionsPerView, imagePair, putativeMatchesPerType, inliers);
@@ -74,12 +120,27 @@ void robustModelEstimation(
           //ALICEVISION_LOG_DEBUG("#before/#after: " << putative_inliers.size() << "/" << guided_geometric_inliers.size());
           std::swap(inliers, guidedGeometricInliers);
         }
+      }
 
+      const std::size_t nbInliers = state.hasStrongSupport ? inliers.getNbAllMatches() : 0;
+      if(state.hasStrongSupport)
+      {
 #pragma omp critical
         {
           out_geometricMatches.emplace(currentPair, std::move(inliers));
         }
+      }
 
+      if(stats)
+      {
+        const double durationMs = timer.elapsedMs();
+#pragma omp critical
+        {
+          PairMatchingStats& pairStats = stats->pairs[currentPair];
+          pairStats.geometricFilteringMs += durationMs;
+          pairStats.nbInliers += nbInliers;
+          pairStats.nbRansacIterations += geometricFilter.getNbIterations();
+        }
       }
     }
 
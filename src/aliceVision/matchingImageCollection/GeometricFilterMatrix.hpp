@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 namespace aliceVision {
 
 
@@ -54,10 +56,34 @@ struct GeometricFilterMatrix
     matching::MatchesPerDescType & matches
   ) = 0;
 
+  /**
+   * @brief The minimum support of a valid model (see robustEstimation::hasStrongSupport).
+   * Pairs with less putative matches can be rejected before any robust estimation.
+   * @return the minimum number of samples, 0 if the filter has its own acceptance criterion
+   */
+  virtual std::size_t getMinimumSamples() const
+  {
+    return 0;
+  }
+
+
+  /**
+   * @brief The number of iterations of the last robust estimation
+   * @return the number of iterations, 0 if the filter does not report it
+   */
+  std::size_t getNbIterations() const
+  {
+    return m_nbIterations;
+  }
+
 
   double m_dPrecision;  //upper_bound precision used for robust estimation
   double m_dPrecision_robust;
   std::size_t m_stIteration; //maximal number of iteration for robust estimation
+  std::size_t m_nbIterations = 0; //number of iterations of the last robust estimation
+  bool m_useProsac = false; //draw the samples of the robust estimation by distance ratio of the matches first (PROSAC)
+  bool m_useSprt = false; //reject the bad models of the robust estimation before the end of their verification (SPRT)
+  std::size_t m_nbHistogramBins = 0; //find the best NFA of ACRANSAC from a histogram of the residuals with this number of bins (0 to sort the residuals)
 };
 
 
@@ -37,6 +37,11 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
     , m_estimator(estimator)
   {}
 
+  std::size_t getMinimumSamples() const override
+  {
+    return aliceVision::fundamental::kernel::SevenPointSolver::MINIMUM_SAMPLES;
+  }
+
   /**
    * @brief Given two sets of image points, it estimates the fundamental matrix
    * relating them using a robust method (like A Contrario Ransac).
@@ -105,11 +110,15 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
                      descTypes, xI, xJ);
     std::vector<size_t> inliers;
 
+    std::vector<std::size_t> sortedIndices;
+    const bool useProsac = m_useProsac && getMatchesSortedByQuality(putativeMatchesPerType, descTypes, sortedIndices);
+
     std::pair<bool, std::size_t> estimationPair = geometricEstimation_Mat(
         xI, xJ,
         imageSizeI,
         imageSizeJ,
-        inliers);
+        inliers,
+        useProsac ? &sortedIndices : nullptr);
 
     if (!estimationPair.first) // estimation is not valid
     {
@@ -139,6 +148,7 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
    * @param[in] imageSizeI The size of the first image (used for normalizing the points)
    * @param[in] imageSizeJ The size of the second image
    * @param[out] geometric_inliers A vector containing the indices of the inliers
+   * @param[in] sortedIndices Optional indices of the points sorted from the best to the worst match (PROSAC)
    * @return true if geometric_inliers is not empty
    */
   std::pair<bool, std::size_t> geometricEstimation_Mat(
@@ -146,7 +156,8 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
     const Mat& xJ,       // points of the second image
     const std::pair<size_t,size_t> & imageSizeI,     // size of the first image  
     const std::pair<size_t,size_t> & imageSizeJ,     // size of the first image
-    std::vector<size_t> & out_inliers)
+    std::vector<size_t> & out_inliers,
+    const std::vector<std::size_t> * sortedIndices = nullptr)
   {
     using namespace aliceVision;
     using namespace aliceVision::robustEstimation;
@@ -172,7 +183,8 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
         // Robustly estimate the Fundamental matrix with A Contrario ransac
         const double upper_bound_precision = Square(m_dPrecision);
         const std::pair<double,double> ACRansacOut =
-          ACRANSAC(kernel, out_inliers, m_stIteration, &m_F, upper_bound_precision);
+          ACRANSAC(kernel, out_inliers, m_stIteration, &m_F, upper_bound_precision, &m_nbIterations, sortedIndices, m_useSprt,
+                   m_nbHistogramBins);
 
         if(out_inliers.empty())
           return std::make_pair(false, KernelType::MINIMUM_SAMPLES);
@@ -204,7 +216,7 @@ struct GeometricFilterMatrix_F_AC: public GeometricFilterMatrix
         const double normalizedThreshold = Square(m_dPrecision * kernel.normalizer2()(0, 0));
         ScoreEvaluator<KernelType> scorer(normalizedThreshold);
 
-        m_F = LO_RANSAC(kernel, scorer, &out_inliers);
+        m_F = LO_RANSAC(kernel, scorer, &out_inliers, nullptr, false, 100, 1e-2, sortedIndices, m_useSprt);
 
         if(out_inliers.empty())
           return std::make_pair(false, KernelType::MINIMUM_SAMPLES);
@@ -67,8 +67,21 @@ bool growHomography(const std::vector<feature::SIOPointFeature> &featuresI,
                     const IndexT &seedMatchId,
                     std::set<IndexT> &planarMatchesIndices, Mat3 &transformation,
                     const GrowParameters& param)
+{
+  const MatchesGrid matchesGrid(featuresI, featuresJ, matches);
+  return growHomography(featuresI, featuresJ, matches, matchesGrid, seedMatchId, planarMatchesIndices, transformation, param);
+}
+
+bool growHomography(const std::vector<feature::SIOPointFeature> &featuresI,
+                    const std::vector<feature::SIOPointFeature> &featuresJ,
+                    const matching::IndMatches &matches,
+                    const MatchesGrid &matchesGrid,
+                    const IndexT &seedMatchId,
+                    std::set<IndexT> &planarMatchesIndices, Mat3 &transformation,
+                    const GrowParameters& param)
 {
   assert(seedMatchId <= matches.size());
+  assert(matchesGrid.size() == matches.size());
 
   planarMatchesIndices.clear();
   transformation = Mat3::Identity();
@@ -97,7 +110,7 @@ bool growHomography(const std::vector<feature::SIOPointFeature> &featuresI,
       currTolerance = param._homographyTolerance;
     }
 
-    findTransformationInliers(featuresI, featuresJ, matches, transformation, currTolerance, planarMatchesIndices);
+    matchesGrid.findTransformationInliers(transformation, currTolerance, planarMatchesIndices);
 
     if (planarMatchesIndices.size() < param._minInliersToRefine)
       return false;
@@ -123,27 +136,37 @@ void filterMatchesByHGrowing(const std::vector<feature::SIOPointFeature>& siofea
   using namespace aliceVision::matching;
 
   IndMatches remainingMatches = putativeMatches;
-  GeometricFilterMatrix_HGrowing dummy;
 
   for(IndexT iH = 0; iH < param._maxNbHomographies; ++iH)
   {
-    std::set<IndexT> usedMatchesId, bestMatchesId;
-    Mat3 bestHomography;
+    // spatial index of the remaining matches, shared by all the seeds
+    const MatchesGrid matchesGrid(siofeatures_I, siofeatures_J, remainingMatches);
+
+    // matches already in a grown plane (written and read concurrently)
+    std::vector<unsigned char> usedMatches(remainingMatches.size(), 0);
+    std::set<IndexT> bestMatchesId;
+    Mat3 bestHomography = Mat3::Identity();
+    int bestSeedId = -1;
 
     // -- Estimate H using homography-growing approach
-    #pragma omp parallel for // (huge optimization but modify results a little)
-    for(int iMatch = 0; iMatch < remainingMatches.size(); ++iMatch)
+    #pragma omp parallel for schedule(dynamic) // (huge optimization but modify results a little)
+    for(int iMatch = 0; iMatch < (int)remainingMatches.size(); ++iMatch)
     {
       // Growing a homography from one match ([F.Srajer, 2016] algo. 1, p. 20)
       // each match is used once only per homography estimation (increases computation time) [1st improvement ([F.Srajer, 2016] p. 20) ]
-      if (usedMatchesId.find(iMatch) != usedMatchesId.end())
+      unsigned char used;
+      #pragma omp atomic read
+      used = usedMatches[iMatch];
+      if (used)
         continue;
+
       std::set<IndexT> planarMatchesId; // be careful: it contains the id. in the 'remainingMatches' vector not 'putativeMatches' vector.
       Mat3 homography;
 
       if (!growHomography(siofeatures_I,
                           siofeatures_J,
                           remainingMatches,
+                          matchesGrid,
                           iMatch,
                           planarMatchesId,
                           homography,
@@ -152,16 +175,21 @@ void filterMatchesByHGrowing(const std::vector<feature::SIOPointFeature>& siofea
         continue;
       }
 
-      #pragma omp critical
-      usedMatchesId.insert(planarMatchesId.begin(), planarMatchesId.end());
+      for (IndexT id : planarMatchesId)
+      {
+        #pragma omp atomic write
+        usedMatches[id] = 1;
+      }
 
-      if (planarMatchesId.size() > bestMatchesId.size())
+      #pragma omp critical
       {
-        #pragma omp critical
+        // the largest plane, the first seed for equal sizes
+        if (planarMatchesId.size() > bestMatchesId.size() ||
+            (planarMatchesId.size() == bestMatchesId.size() && iMatch < bestSeedId))
         {
-          // if(iH == 3) { std::cout << "best iMatch" << iMatch << std::endl; }
-          bestMatchesId = planarMatchesId; // be careful: it contains the id. in the 'remainingMatches' vector not 'putativeMatches' vector.
+          bestMatchesId.swap(planarMatchesId); // be careful: it contains the id. in the 'remainingMatches' vector not 'putativeMatches' vector.
           bestHomography = homography;
+          bestSeedId = iMatch;
         }
       }
     } // 'iMatch'
@@ -176,26 +204,28 @@ void filterMatchesByHGrowing(const std::vector<feature::SIOPointFeature>& siofea
     // Store validated results:
     {
       IndMatches matches;
-      Mat3 H = bestHomography;
+      matches.reserve(bestMatchesId.size());
       for (IndexT id : bestMatchesId)
       {
         matches.push_back(remainingMatches.at(id));
       }
-      homographiesAndMatches.emplace_back(H, matches);
+      outGeometricInliers.insert(outGeometricInliers.end(), matches.begin(), matches.end());
+      homographiesAndMatches.emplace_back(bestHomography, std::move(matches));
     }
 
-    // -- Update not used matches & Save geometrically verified matches
-    for (IndexT id : bestMatchesId)
+    // update remaining matches in a single pass (/!\ Keep ordering)
     {
-      outGeometricInliers.push_back(remainingMatches.at(id));
-    }
-
-    // update remaining matches (/!\ Keep ordering)
-    std::size_t cpt = 0;
-    for (IndexT id : bestMatchesId)
-    {
-      remainingMatches.erase(remainingMatches.begin() + id - cpt);
-      ++cpt;
+      IndMatches notUsedMatches;
+      notUsedMatches.reserve(remainingMatches.size() - bestMatchesId.size());
+      std::set<IndexT>::const_iterator bestIt = bestMatchesId.begin();
+      for (IndexT id = 0; id < remainingMatches.size(); ++id)
+      {
+        if (bestIt != bestMatchesId.end() && *bestIt == id)
+          ++bestIt;
+        else
+          notUsedMatches.push_back(remainingMatches[id]);
+      }
+      remainingMatches.swap(notUsedMatches);
     }
 
     // stop when the number of remaining matches is too small
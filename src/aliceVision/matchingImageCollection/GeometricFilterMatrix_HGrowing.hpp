@@ -90,6 +90,20 @@ bool growHomography(const std::vector<feature::SIOPointFeature> &featuresI,
                     Mat3 &transformation,
                     const GrowParameters& param);
 
+/**
+ * @brief Return all the matches in the same plane as the match \c seedMatchId with the corresponding homography.
+ * @see growHomography
+ * @param[in] matchesGrid The spatial index of \c matches, used to find the inliers of the transformations.
+ */
+bool growHomography(const std::vector<feature::SIOPointFeature> &featuresI,
+                    const std::vector<feature::SIOPointFeature> &featuresJ,
+                    const matching::IndMatches &matches,
+                    const MatchesGrid &matchesGrid,
+                    const IndexT &seedMatchId,
+                    std::set<IndexT> &planarMatchesIndices,
+                    Mat3 &transformation,
+                    const GrowParameters& param);
+
 struct HGrowingFilteringParam
 {
     HGrowingFilteringParam() = default;
@@ -17,6 +17,7 @@
 #include "aliceVision/sfmData/SfMData.hpp"
 #include "aliceVision/feature/RegionsPerView.hpp"
 #include "aliceVision/matchingImageCollection/GeometricFilterMatrix.hpp"
+#include "aliceVision/matchingImageCollection/geometricFilterUtils.hpp"
 
 namespace aliceVision {
 namespace matchingImageCollection {
@@ -31,6 +32,11 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
     , m_H(Mat3::Identity())
   {}
 
+  std::size_t getMinimumSamples() const override
+  {
+    return aliceVision::homography::kernel::FourPointSolver::MINIMUM_SAMPLES;
+  }
+
   /**
    * @brief Given two sets of image points, it estimates the homography matrix
    * relating them using a robust method (like A Contrario Ransac).
@@ -75,8 +81,12 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
     // Robustly estimate the Homography matrix with A Contrario ransac
     const double upper_bound_precision = Square(m_dPrecision);
 
+    std::vector<std::size_t> sortedIndices;
+    const bool useProsac = m_useProsac && getMatchesSortedByQuality(putativeMatchesPerType, descTypes, sortedIndices);
+
     std::vector<size_t> inliers;
-    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_H, upper_bound_precision);
+    const std::pair<double,double> ACRansacOut = ACRANSAC(kernel, inliers, m_stIteration, &m_H, upper_bound_precision, &m_nbIterations,
+                                                          useProsac ? &sortedIndices : nullptr, m_useSprt, m_nbHistogramBins);
 
     if (inliers.empty())
       return EstimationStatus(false, false);
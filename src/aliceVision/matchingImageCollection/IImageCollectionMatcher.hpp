@@ -12,6 +12,8 @@
 #include "aliceVision/matching/IndMatch.hpp"
 #include "aliceVision/matchingImageCollection/pairBuilder.hpp"
 #include "aliceVision/feature/RegionsPerView.hpp"
+#include "aliceVision/feature/RegionsCache.hpp"
+#include "aliceVision/matchingImageCollection/matchingStats.hpp"
 
 #include <string>
 #include <vector>
@@ -38,6 +40,34 @@ class IImageCollectionMatcher
     feature::EImageDescriberType descType,
     matching::PairwiseMatches & map_putatives_matches // the output pairwise photometric corresponding points
     ) const = 0;
+
+  /**
+   * @brief Find corresponding points between some pair of view Ids,
+   *        the regions are loaded on demand through the given regions cache.
+   * @return false if the matcher needs all the regions in memory (use the RegionsPerView version)
+   */
+  virtual bool Match(
+    feature::RegionsCache& regionsCache,
+    const PairSet & pairs, // list of pair to consider for matching
+    feature::EImageDescriberType descType,
+    matching::PairwiseMatches & map_putatives_matches // the output pairwise photometric corresponding points
+    ) const
+  {
+    return false;
+  }
+
+  /**
+   * @brief Record the putative matching duration of each pair and the indexing duration of each view
+   * @param[in] stats The statistics to fill, disabled if nullptr
+   */
+  void setMatchingStats(MatchingStats* stats)
+  {
+    _stats = stats;
+  }
+
+  protected:
+  /// Statistics of the matching (disabled if nullptr)
+  MatchingStats* _stats = nullptr;
 };
 
 } // namespace aliceVision
@@ -7,12 +7,19 @@
 
 #include <aliceVision/matchingImageCollection/ImageCollectionMatcher_cascadeHashing.hpp>
 #include <aliceVision/matching/ArrayMatcher_cascadeHashing.hpp>
+#include <aliceVision/matching/CascadeHasherIO.hpp>
 #include <aliceVision/matching/IndMatchDecorator.hpp>
 #include <aliceVision/matching/filters.hpp>
+#include <aliceVision/feature/DescriptorSpan.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/config.hpp>
 
+#include <boost/filesystem.hpp>
 #include <boost/progress.hpp>
 
+namespace fs = boost::filesystem;
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -22,8 +29,9 @@ using namespace aliceVision::feature;
 ImageCollectionMatcher_cascadeHashing
 ::ImageCollectionMatcher_cascadeHashing
 (
-  float distRatio
-):IImageCollectionMatcher(), f_dist_ratio_(distRatio)
+  float distRatio,
+  const std::string& hashFolder
+):IImageCollectionMatcher(), f_dist_ratio_(distRatio), hash_folder_(hashFolder)
 {
 }
 
@@ -36,6 +44,8 @@ void Match
   const PairSet & pairs,
   EImageDescriberType descType,
   float fDistRatio,
+  const std::string& hashFolder,
+  MatchingStats* stats,
   PairwiseMatches & map_PutativesMatches // the pairwise photometric corresponding points
 )
 {
@@ -53,23 +63,26 @@ void Match
     used_index.insert(iter->second);
   }
 
-  typedef Eigen::Matrix<ScalarT, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> BaseMat;
+  if (used_index.empty())
+    return;
+
+  const std::string descTypeName = EImageDescriberType_enumToString(descType);
+  const bool useHashFolder = !hashFolder.empty();
 
   // Init the cascade hasher
   CascadeHasher cascade_hasher;
-  if (!used_index.empty())
-  {
-    const IndexT I = *used_index.begin();
-    const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
-    const size_t dimension = regionsI.DescriptorLength();
-    cascade_hasher.Init(dimension);
-  }
-
-  std::map<IndexT, HashedDescriptions> hashed_base_;
+  const size_t dimension = regionsPerView.getRegions(*used_index.begin(), descType).DescriptorLength();
 
-  // Compute the zero mean descriptor that will be used for hashing (one for all the image regions)
+  // The zero mean descriptor that will be used for hashing (one for all the image regions)
   Eigen::VectorXf zero_mean_descriptor;
+
+  // Reuse the hasher of a previous run, so the saved hash codes stay valid
+  const std::string hasherFilename = (fs::path(hashFolder) / ("cascadeHashing." + descTypeName + ".hasher")).string();
+  if (!useHashFolder || !loadCascadeHasher(hasherFilename, dimension, cascade_hasher, zero_mean_descriptor))
   {
+    cascade_hasher.Init(dimension);
+
+    // Compute the zero mean descriptor
     Eigen::MatrixXf matForZeroMean;
     for (int i =0; i < used_index.size(); ++i)
     {
@@ -77,9 +90,6 @@ void Match
       std::advance(iter, i);
       const IndexT I = *iter;
       const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
-      const ScalarT * tabI =
-        reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
-      const size_t dimension = regionsI.DescriptorLength();
       if (i==0)
       {
         matForZeroMean.resize(used_index.size(), dimension);
@@ -87,13 +97,29 @@ void Match
       }
       if (regionsI.RegionCount() > 0)
       {
-        Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
-        matForZeroMean.row(i) = CascadeHasher::GetZeroMeanDescriptor(mat_I);
+        const DescriptorSpan<ScalarT> descriptorsI = getDescriptorSpan<ScalarT>(regionsI);
+        matForZeroMean.row(i) = CascadeHasher::GetZeroMeanDescriptor(descriptorsI);
       }
     }
     zero_mean_descriptor = CascadeHasher::GetZeroMeanDescriptor(matForZeroMean);
+
+    if (useHashFolder)
+    {
+      try
+      {
+        saveCascadeHasher(hasherFilename, cascade_hasher, zero_mean_descriptor);
+      }
+      catch (const std::exception& e)
+      {
+        ALICEVISION_LOG_WARNING(e.what());
+      }
+    }
   }
 
+  const std::uint64_t hasherKey = cascade_hasher.GetKey(zero_mean_descriptor);
+  std::map<IndexT, HashedDescriptions> hashed_base_;
+  int nbLoadedViews = 0;
+
   // Index the input regions
   #pragma omp parallel for schedule(dynamic)
   for (int i =0; i < used_index.size(); ++i)
@@ -102,19 +128,43 @@ void Match
     std::advance(iter, i);
     const IndexT I = *iter;
     const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
-    const ScalarT * tabI =
-      reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
-    const size_t dimension = regionsI.DescriptorLength();
+    const std::string hashFilename = (fs::path(hashFolder) / (std::to_string(I) + "." + descTypeName + ".hash")).string();
 
-    Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
-    HashedDescriptions hashed_description = cascade_hasher.CreateHashedDescriptions(mat_I,
-      zero_mean_descriptor);
+    system::Timer indexTimer;
+    HashedDescriptions hashed_description;
+    const bool loaded = useHashFolder &&
+      loadHashedDescriptions(hashFilename, cascade_hasher, hasherKey, regionsI.RegionCount(), hashed_description);
+
+    if (!loaded)
+    {
+      const DescriptorSpan<ScalarT> descriptorsI = getDescriptorSpan<ScalarT>(regionsI);
+      hashed_description = cascade_hasher.CreateHashedDescriptions(descriptorsI, zero_mean_descriptor);
+
+      if (useHashFolder)
+      {
+        try
+        {
+          saveHashedDescriptions(hashFilename, hashed_description, hasherKey);
+        }
+        catch (const std::exception& e)
+        {
+          ALICEVISION_LOG_WARNING(e.what());
+        }
+      }
+    }
+    const double indexMs = indexTimer.elapsedMs();
     #pragma omp critical
     {
+      nbLoadedViews += loaded;
       hashed_base_[I] = std::move(hashed_description);
+      if (stats)
+        stats->views[I].indexingMs += indexMs;
     }
   }
 
+  if (useHashFolder)
+    ALICEVISION_LOG_INFO("Cascade hashing: " << nbLoadedViews << " / " << used_index.size() << " hashed views loaded from '" << hashFolder << "'.");
+
   // Perform matching between all the pairs
   for (Map_vectorT::const_iterator iter = map_Pairs.begin();
     iter != map_Pairs.end(); ++iter)
@@ -130,27 +180,24 @@ void Match
     }
 
     const std::vector<feature::PointFeature> pointFeaturesI = regionsI.GetRegionsPositions();
-    const ScalarT * tabI =
-      reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
-    const size_t dimension = regionsI.DescriptorLength();
-    Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
+    const DescriptorSpan<ScalarT> descriptorsI = getDescriptorSpan<ScalarT>(regionsI);
     #pragma omp parallel for schedule(dynamic)
     for (int j = 0; j < (int)indexToCompare.size(); ++j)
     {
       size_t J = indexToCompare[j];
-      const feature::Regions &regionsJ = regionsPerView.getRegions(I, descType);
-
       if (!regionsPerView.viewExist(J)
-          || regionsI.Type_id() != regionsJ.Type_id())
+          || regionsI.Type_id() != regionsPerView.getRegions(J, descType).Type_id())
       {
         #pragma omp critical
         ++my_progress_bar;
         continue;
       }
 
-      // Matrix representation of the query input data;
-      const ScalarT * tabJ = reinterpret_cast<const ScalarT*>(regionsJ.DescriptorRawData());
-      Eigen::Map<BaseMat> mat_J( (ScalarT*)tabJ, regionsJ.RegionCount(), dimension);
+      const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
+      system::Timer pairTimer;
+
+      // Non-owning view on the query input data
+      const DescriptorSpan<ScalarT> descriptorsJ = getDescriptorSpan<ScalarT>(regionsJ);
 
       IndMatches pvec_indices;
       typedef typename Accumulator<ScalarT>::Type ResultType;
@@ -159,9 +206,9 @@ void Match
       pvec_indices.reserve(regionsJ.RegionCount() * 2);
 
       // Match the query descriptors to the database
-      cascade_hasher.Match_HashedDescriptions<BaseMat, ResultType>(
-        hashed_base_[J], mat_J,
-        hashed_base_[I], mat_I,
+      cascade_hasher.Match_HashedDescriptions<ScalarT, ResultType>(
+        hashed_base_.at(J), descriptorsJ,
+        hashed_base_.at(I), descriptorsI,
         &pvec_indices, &pvec_distances);
 
       std::vector<int> vec_nn_ratio_idx;
@@ -193,9 +240,12 @@ void Match
         pointFeaturesI, pointFeaturesJ);
       matchDeduplicator.getDeduplicated(vec_putative_matches);
 
+      const double pairMs = pairTimer.elapsedMs();
       #pragma omp critical
       {
         ++my_progress_bar;
+        if (stats)
+          stats->addPutativeMatching(std::make_pair(I, J), pairMs, regionsI.RegionCount(), regionsJ.RegionCount(), vec_putative_matches.size());
         if (!vec_putative_matches.empty())
         {
           assert(map_PutativesMatches.count(std::make_pair(I,J)) == 0);
@@ -215,6 +265,8 @@ void ImageCollectionMatcher_cascadeHashing::Match
   PairwiseMatches & map_PutativesMatches // the pairwise photometric corresponding points
 ) const
 {
+  ALICEVISION_PROFILE_SCOPE("ImageCollectionMatcher_cascadeHashing::Match");
+
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENMP)
   ALICEVISION_LOG_DEBUG("Using the OPENMP thread interface");
 #endif
@@ -234,6 +286,8 @@ void ImageCollectionMatcher_cascadeHashing::Match
       pairs,
       descType,
       f_dist_ratio_,
+      hash_folder_,
+      _stats,
       map_PutativesMatches);
   }
   else
@@ -244,6 +298,8 @@ void ImageCollectionMatcher_cascadeHashing::Match
       pairs,
       descType,
       f_dist_ratio_,
+      hash_folder_,
+      _stats,
       map_PutativesMatches);
   }
   else
@@ -9,6 +9,8 @@
 
 #include "aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp"
 
+#include <string>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -19,14 +21,23 @@ namespace matchingImageCollection {
  * a threshold over the distance ratio of the 2 nearest neighbours.
  *
  * @note: Cascade hashing tables are computed once and used for all the regions.
+ *        With a hash folder, the hasher (seed and zero mean descriptor) and the hashed descriptions
+ *        of each view are saved, so other processes (e.g. the other chunks of a distributed matching)
+ *        reuse them instead of recomputing the same hash codes.
  * @warning: all descriptors are loaded in memory. You need to ensure that it can fit in RAM.
  */
 class ImageCollectionMatcher_cascadeHashing : public IImageCollectionMatcher
 {
   public:
+  /**
+   * @param[in] dist_ratio The distance ratio
+   * @param[in] hashFolder Folder used to persist the hashed descriptions of each view,
+   *            the hash codes are loaded from it instead of being recomputed (disabled if empty)
+   */
   ImageCollectionMatcher_cascadeHashing
   (
-    float dist_ratio
+    float dist_ratio,
+    const std::string& hashFolder = ""
   );
 
   /// Find corresponding points between some pair of view Ids
@@ -40,6 +51,8 @@ class ImageCollectionMatcher_cascadeHashing : public IImageCollectionMatcher
   private:
   // Distance ratio used to discard spurious correspondence
   float f_dist_ratio_;
+  // Folder used to persist the hashed descriptions (disabled if empty)
+  std::string hash_folder_;
 };
 
 } // namespace aliceVision
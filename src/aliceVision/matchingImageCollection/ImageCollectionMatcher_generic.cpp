@@ -11,30 +11,47 @@
 #include <aliceVision/matching/ArrayMatcher_cascadeHashing.hpp>
 #include <aliceVision/matching/RegionsMatcher.hpp>
 #include <aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp>
+#include <aliceVision/matchingImageCollection/pairScheduler.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/config.hpp>
 
+#include <boost/filesystem.hpp>
 #include <boost/progress.hpp>
 
+#include <algorithm>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
+namespace fs = boost::filesystem;
 using namespace aliceVision::matching;
 using namespace aliceVision::feature;
 
 ImageCollectionMatcher_generic::ImageCollectionMatcher_generic(
-  float distRatio, EMatcherType matcherType)
+  float distRatio, EMatcherType matcherType, const std::string& kdtreeIndexFolder)
   : IImageCollectionMatcher()
   , _f_dist_ratio(distRatio)
   , _matcherType(matcherType)
+  , _kdtreeIndexFolder(kdtreeIndexFolder)
 {
 }
 
+std::string ImageCollectionMatcher_generic::getIndexPrefix(IndexT viewId, feature::EImageDescriberType descType) const
+{
+  if (_matcherType != ANN_L2 || _kdtreeIndexFolder.empty())
+    return "";
+  return (fs::path(_kdtreeIndexFolder) / (std::to_string(viewId) + "." + EImageDescriberType_enumToString(descType))).string();
+}
+
 void ImageCollectionMatcher_generic::Match(
   const feature::RegionsPerView& regionsPerView,
   const PairSet & pairs,
   feature::EImageDescriberType descType,
   matching::PairwiseMatches & map_PutativesMatches)const // the pairwise photometric corresponding points
 {
+  ALICEVISION_PROFILE_SCOPE("ImageCollectionMatcher_generic::Match");
+
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENMP)
   ALICEVISION_LOG_DEBUG("Using the OPENMP thread interface");
 #endif
@@ -43,6 +60,76 @@ void ImageCollectionMatcher_generic::Match(
 
   boost::progress_display my_progress_bar( pairs.size() );
 
+  if (b_multithreaded_pair_search)
+  {
+    // Each thread matches the pairs of one block of the pair matrix,
+    // so the regions it uses (2 * PAIR_BLOCK_SIZE views) stay in the CPU caches
+    const std::vector<PairBlock> blocks = getPairBlocks(pairs, PAIR_BLOCK_SIZE);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int b = 0; b < (int)blocks.size(); ++b)
+    {
+      const std::vector<Pair>& blockPairs = blocks[b].pairs;
+
+      // Consecutive pairs with the same first view use the same MatcherT
+      std::size_t begin = 0;
+      while (begin < blockPairs.size())
+      {
+        const IndexT I = blockPairs[begin].first;
+        std::size_t end = begin + 1;
+        while (end < blockPairs.size() && blockPairs[end].first == I)
+          ++end;
+
+        const feature::Regions & regionsI = regionsPerView.getRegions(I, descType);
+        if (regionsI.RegionCount() == 0)
+        {
+          #pragma omp critical
+          my_progress_bar += end - begin;
+          begin = end;
+          continue;
+        }
+
+        // Initialize the matching interface
+        system::Timer indexTimer;
+        matching::RegionsDatabaseMatcher matcher(_matcherType, regionsI, getIndexPrefix(I, descType));
+
+        if (_stats)
+        {
+          #pragma omp critical
+          _stats->views[I].indexingMs += indexTimer.elapsedMs();
+        }
+
+        for (std::size_t j = begin; j < end; ++j)
+        {
+          const IndexT J = blockPairs[j].second;
+
+          const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
+          IndMatches vec_putatives_matches;
+          system::Timer pairTimer;
+          if (regionsJ.RegionCount() != 0
+              && regionsI.Type_id() == regionsJ.Type_id())
+          {
+            matcher.Match(_f_dist_ratio, regionsJ, vec_putatives_matches);
+          }
+          const double pairMs = pairTimer.elapsedMs();
+          #pragma omp critical
+          {
+            ++my_progress_bar;
+            if (_stats)
+              _stats->addPutativeMatching(std::make_pair(I, J), pairMs, regionsI.RegionCount(), regionsJ.RegionCount(), vec_putatives_matches.size());
+            if (!vec_putatives_matches.empty())
+            {
+              map_PutativesMatches[std::make_pair(I,J)].emplace(descType, std::move(vec_putatives_matches));
+            }
+          }
+        }
+        begin = end;
+      }
+    }
+    return;
+  }
+
+  // The other matchers are multithreaded internally.
   // Sort pairs according the first index to minimize the MatcherT build operations
   typedef std::map<size_t, std::vector<size_t> > Map_vectorT;
   Map_vectorT map_Pairs;
@@ -66,9 +153,12 @@ void ImageCollectionMatcher_generic::Match(
     }
 
     // Initialize the matching interface
-    matching::RegionsDatabaseMatcher matcher(_matcherType, regionsI);
+    system::Timer indexTimer;
+    matching::RegionsDatabaseMatcher matcher(_matcherType, regionsI, getIndexPrefix(I, descType));
+
+    if (_stats)
+      _stats->views[I].indexingMs += indexTimer.elapsedMs();
 
-    #pragma omp parallel for schedule(dynamic) if(b_multithreaded_pair_search)
     for (int j = 0; j < (int)indexToCompare.size(); ++j)
     {
       const size_t J = indexToCompare[j];
@@ -83,10 +173,14 @@ void ImageCollectionMatcher_generic::Match(
       }
 
       IndMatches vec_putatives_matches;
+      system::Timer pairTimer;
       matcher.Match(_f_dist_ratio, regionsJ, vec_putatives_matches);
+      const double pairMs = pairTimer.elapsedMs();
       #pragma omp critical
       {
         ++my_progress_bar;
+        if (_stats)
+          _stats->addPutativeMatching(std::make_pair(I, J), pairMs, regionsI.RegionCount(), regionsJ.RegionCount(), vec_putatives_matches.size());
         if (!vec_putatives_matches.empty())
         {
           map_PutativesMatches[std::make_pair(I,J)].emplace(descType, std::move(vec_putatives_matches));
@@ -96,5 +190,87 @@ void ImageCollectionMatcher_generic::Match(
   }
 }
 
+bool ImageCollectionMatcher_generic::Match(
+  feature::RegionsCache& regionsCache,
+  const PairSet & pairs,
+  feature::EImageDescriberType descType,
+  matching::PairwiseMatches & map_PutativesMatches)const // the pairwise photometric corresponding points
+{
+  const bool b_multithreaded_pair_search = (_matcherType == CASCADE_HASHING_L2);
+  // -> set to true for CASCADE_HASHING_L2, since OpenMP instructions are not used in this matcher
+
+  if (pairs.empty())
+    return true;
+
+  // Use the first regions to estimate how many views fit in the cache,
+  // a block of pairs uses 2 * blockSize views.
+  const std::size_t viewSize = std::max<std::size_t>(regionsCache.getRegions(pairs.begin()->first, descType)->MemorySize(), 1);
+  const std::size_t blockSize = std::max<std::size_t>(regionsCache.capacity() / (2 * viewSize), 1);
+  const std::vector<Pair> orderedPairs = getBlockOrderedPairs(pairs, blockSize);
+
+  ALICEVISION_LOG_INFO("Matching by blocks of " << blockSize << " views (regions cache of " << (regionsCache.capacity() / (1024 * 1024)) << " MB).");
+
+  boost::progress_display my_progress_bar( pairs.size() );
+
+  // Consecutive pairs with the same first view use the same MatcherT
+  std::size_t begin = 0;
+  while (begin < orderedPairs.size())
+  {
+    const IndexT I = orderedPairs[begin].first;
+    std::size_t end = begin + 1;
+    while (end < orderedPairs.size() && orderedPairs[end].first == I)
+      ++end;
+
+    const std::shared_ptr<const feature::Regions> regionsI = regionsCache.getRegions(I, descType);
+    if (regionsI->RegionCount() == 0)
+    {
+      my_progress_bar += end - begin;
+      begin = end;
+      continue;
+    }
+
+    // Initialize the matching interface
+    system::Timer indexTimer;
+    matching::RegionsDatabaseMatcher matcher(_matcherType, *regionsI, getIndexPrefix(I, descType));
+
+    if (_stats)
+      _stats->views[I].indexingMs += indexTimer.elapsedMs();
+
+    #pragma omp parallel for schedule(dynamic) if(b_multithreaded_pair_search)
+    for (int j = begin; j < (int)end; ++j)
+    {
+      const IndexT J = orderedPairs[j].second;
+
+      const std::shared_ptr<const feature::Regions> regionsJ = regionsCache.getRegions(J, descType);
+      if (regionsJ->RegionCount() == 0
+          || regionsI->Type_id() != regionsJ->Type_id())
+      {
+        #pragma omp critical
+        ++my_progress_bar;
+        continue;
+      }
+
+      IndMatches vec_putatives_matches;
+      system::Timer pairTimer;
+      matcher.Match(_f_dist_ratio, *regionsJ, vec_putatives_matches);
+      const double pairMs = pairTimer.elapsedMs();
+      #pragma omp critical
+      {
+        ++my_progress_bar;
+        if (_stats)
+          _stats->addPutativeMatching(std::make_pair(I, J), pairMs, regionsI->RegionCount(), regionsJ->RegionCount(), vec_putatives_matches.size());
+        if (!vec_putatives_matches.empty())
+        {
+          map_PutativesMatches[std::make_pair(I,J)].emplace(descType, std::move(vec_putatives_matches));
+        }
+      }
+    }
+    begin = end;
+  }
+
+  ALICEVISION_LOG_INFO("Regions cache: " << regionsCache.nbLoads() << " loads, " << regionsCache.nbHits() << " hits.");
+  return true;
+}
+
 } // namespace aliceVision
 } // namespace matchingImageCollection
@@ -9,6 +9,8 @@
 
 #include "aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp"
 
+#include <string>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -18,14 +20,22 @@ namespace matchingImageCollection {
  * Spurious correspondences are discarded by using the
  * a threshold over the distance ratio of the 2 nearest neighbours.
  *
- * @warning: all descriptors are loaded in memory. You need to ensure that it can fit in RAM.
+ * @warning: with a RegionsPerView, all descriptors are loaded in memory. You need to ensure that it can fit in RAM.
+ *           With a RegionsCache, the memory is bounded by the cache budget.
  */
 class ImageCollectionMatcher_generic : public IImageCollectionMatcher
 {
   public:
+  /**
+   * @param[in] dist_ratio The distance ratio
+   * @param[in] matcherType The type of matcher
+   * @param[in] kdtreeIndexFolder Folder used by ANN_L2 to persist the kd-tree index of each view,
+   *            the indexes are loaded from it instead of being rebuilt (disabled if empty)
+   */
   ImageCollectionMatcher_generic(
     float dist_ratio,
-    matching::EMatcherType matcherType
+    matching::EMatcherType matcherType,
+    const std::string& kdtreeIndexFolder = ""
   );
 
   /// Find corresponding points between some pair of view Ids
@@ -36,11 +46,28 @@ class ImageCollectionMatcher_generic : public IImageCollectionMatcher
     matching::PairwiseMatches & map_PutativesMatches // the pairwise photometric corresponding points
     ) const;
 
+  /**
+   * @brief Find corresponding points between some pair of view Ids,
+   *        the regions are loaded on demand through the given regions cache.
+   * @note Pairs are matched by blocks of views fitting in the cache budget (see getBlockOrderedPairs).
+   */
+  bool Match(
+    feature::RegionsCache& regionsCache,
+    const PairSet & pairs,
+    feature::EImageDescriberType descType,
+    matching::PairwiseMatches & map_PutativesMatches // the pairwise photometric corresponding points
+    ) const override;
+
   private:
   // Distance ratio used to discard spurious correspondence
   float _f_dist_ratio;
   // Matcher Type
   matching::EMatcherType _matcherType;
+  // Folder used to persist the kd-tree indexes (disabled if empty)
+  std::string _kdtreeIndexFolder;
+
+  /// Path prefix of the kd-tree index file of a view, empty if disabled
+  std::string getIndexPrefix(IndexT viewId, feature::EImageDescriberType descType) const;
 };
 
 } // namespace aliceVision
@@ -5,8 +5,12 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "geometricFilterUtils.hpp"
+#include <aliceVision/robustEstimation/prosacSampling.hpp>
 #include <ceres/ceres.h>
 
+#include <algorithm>
+#include <limits>
+
 namespace aliceVision {
 namespace matchingImageCollection {
 
@@ -36,6 +40,34 @@ void copyInlierMatches(const std::vector<size_t> &inliers,
   }
 }
 
+bool getMatchesSortedByQuality(const matching::MatchesPerDescType &putativeMatchesPerType,
+                               const std::vector<feature::EImageDescriberType> &descTypes,
+                               std::vector<std::size_t> &sortedIndices)
+{
+  sortedIndices.clear();
+
+  // same order as fillMatricesWithUndistortFeaturesMatches
+  std::vector<float> distanceRatios;
+  distanceRatios.reserve(putativeMatchesPerType.getNbAllMatches());
+  for(const auto& descType : descTypes)
+  {
+    if(!putativeMatchesPerType.count(descType))
+      continue;
+
+    for(const matching::IndMatch& match : putativeMatchesPerType.at(descType))
+      distanceRatios.push_back(match._distanceRatio);
+  }
+
+  // the distance ratios are not saved in the match files
+  const bool hasQuality = std::any_of(distanceRatios.begin(), distanceRatios.end(),
+                                      [](float ratio) { return ratio > 0.0f; });
+  if(!hasQuality)
+    return false;
+
+  sortedIndices = robustEstimation::sortByQuality(distanceRatios);
+  return true;
+}
+
 void centerMatrix(const Eigen::Matrix2Xf & points2d, Mat3 & t)
 {
   t = Mat3::Identity();
@@ -294,6 +326,131 @@ void findTransformationInliers(const Mat2X& featuresI,
   }
 }
 
+MatchesGrid::MatchesGrid(const std::vector<feature::SIOPointFeature> &featuresI,
+                         const std::vector<feature::SIOPointFeature> &featuresJ,
+                         const matching::IndMatches &matches,
+                         std::size_t gridSize)
+{
+  gridSize = std::max<std::size_t>(gridSize, 1);
+  const std::size_t nbMatches = matches.size();
+
+  Mat2X pointsI(2, nbMatches);
+  Mat2X pointsJ(2, nbMatches);
+  for(std::size_t i = 0; i < nbMatches; ++i)
+  {
+    const feature::SIOPointFeature & featI = featuresI.at(matches[i]._i);
+    const feature::SIOPointFeature & featJ = featuresJ.at(matches[i]._j);
+    pointsI.col(i) << featI.x(), featI.y();
+    pointsJ.col(i) << featJ.x(), featJ.y();
+  }
+
+  // cell index of a point along each axis
+  const auto getCellIndexer = [gridSize](const Mat2X& points)
+  {
+    const Vec2 minPt = (points.cols() > 0) ? Vec2(points.rowwise().minCoeff()) : Vec2::Zero();
+    const Vec2 maxPt = (points.cols() > 0) ? Vec2(points.rowwise().maxCoeff()) : Vec2::Zero();
+    const Vec2 cellSize = ((maxPt - minPt) / gridSize).cwiseMax(Vec2::Constant(1e-6));
+    return [minPt, cellSize, gridSize](const Vec2& pt)
+    {
+      const Vec2 cell = (pt - minPt).cwiseQuotient(cellSize);
+      const std::size_t x = std::min<std::size_t>(static_cast<std::size_t>(cell.x()), gridSize - 1);
+      const std::size_t y = std::min<std::size_t>(static_cast<std::size_t>(cell.y()), gridSize - 1);
+      return y * gridSize + x;
+    };
+  };
+  const auto cellIndexerI = getCellIndexer(pointsI);
+  const auto cellIndexerJ = getCellIndexer(pointsJ);
+
+  // sort the matches by bucket: (cell in I, cell in J)
+  std::vector<std::pair<std::size_t, IndexT>> keyedMatches(nbMatches);
+  for(std::size_t i = 0; i < nbMatches; ++i)
+  {
+    const std::size_t key = cellIndexerI(pointsI.col(i)) * gridSize * gridSize + cellIndexerJ(pointsJ.col(i));
+    keyedMatches[i] = std::make_pair(key, static_cast<IndexT>(i));
+  }
+  std::sort(keyedMatches.begin(), keyedMatches.end());
+
+  _pointsI.resize(2, nbMatches);
+  _pointsJ.resize(2, nbMatches);
+  _matchesId.resize(nbMatches);
+
+  for(std::size_t i = 0; i < nbMatches; ++i)
+  {
+    const IndexT matchId = keyedMatches[i].second;
+    _pointsI.col(i) = pointsI.col(matchId);
+    _pointsJ.col(i) = pointsJ.col(matchId);
+    _matchesId[i] = matchId;
+
+    if(i == 0 || keyedMatches[i].first != keyedMatches[i - 1].first)
+    {
+      Bucket bucket;
+      bucket.minI = bucket.maxI = _pointsI.col(i);
+      bucket.minJ = bucket.maxJ = _pointsJ.col(i);
+      bucket.begin = i;
+      bucket.end = i + 1;
+      _buckets.push_back(bucket);
+      continue;
+    }
+    Bucket& bucket = _buckets.back();
+    bucket.minI = bucket.minI.cwiseMin(_pointsI.col(i));
+    bucket.maxI = bucket.maxI.cwiseMax(_pointsI.col(i));
+    bucket.minJ = bucket.minJ.cwiseMin(_pointsJ.col(i));
+    bucket.maxJ = bucket.maxJ.cwiseMax(_pointsJ.col(i));
+    bucket.end = i + 1;
+  }
+}
+
+void MatchesGrid::findTransformationInliers(const Mat3 &transformation,
+                                            double tolerance,
+                                            std::set<IndexT> &inliersId) const
+{
+  inliersId.clear();
+  const double squaredTolerance = Square(tolerance);
+
+  for(const Bucket& bucket : _buckets)
+  {
+    // The image of the box by the transformation is the convex hull of its transformed corners
+    // (the transformation has no point at infinity over the box when the corners have the same sign in w).
+    const Vec3 corners[4] = {
+      transformation * Vec3(bucket.minI.x(), bucket.minI.y(), 1.0),
+      transformation * Vec3(bucket.maxI.x(), bucket.minI.y(), 1.0),
+      transformation * Vec3(bucket.minI.x(), bucket.maxI.y(), 1.0),
+      transformation * Vec3(bucket.maxI.x(), bucket.maxI.y(), 1.0)};
+
+    bool canSkip = true;
+    Vec2 minPt = Vec2::Constant(std::numeric_limits<double>::max());
+    Vec2 maxPt = Vec2::Constant(std::numeric_limits<double>::lowest());
+    for(const Vec3& corner : corners)
+    {
+      if(corner.z() * corners[0].z() <= 0.0)
+      {
+        canSkip = false;
+        break;
+      }
+      const Vec2 pt = corner.hnormalized();
+      minPt = minPt.cwiseMin(pt);
+      maxPt = maxPt.cwiseMax(pt);
+    }
+
+    if(canSkip)
+    {
+      // distance between the transformed box and the box in the second image
+      const Vec2 gap = (minPt - bucket.maxJ).cwiseMax(bucket.minJ - maxPt).cwiseMax(Vec2::Zero());
+      if(gap.squaredNorm() >= squaredTolerance)
+        continue;
+    }
+
+    for(std::size_t i = bucket.begin; i < bucket.end; ++i)
+    {
+      const Vec3 ptIp_hom = transformation * _pointsI.col(i).homogeneous();
+      const double dist = (_pointsJ.col(i) - ptIp_hom.hnormalized()).squaredNorm();
+
+      if(dist < squaredTolerance)
+        inliersId.insert(_matchesId[i]);
+    }
+  }
+}
+
 /**
  * @brief This functor allows to optimize an Homography.
  * @details It is based on [F.Srajer, 2016] p.20, 21 and its C++ implementation: https://github.com/fsrajer/yasfm/blob/master/YASFM/relative_pose.cpp#L992
@@ -173,6 +173,18 @@ void copyInlierMatches(const std::vector<size_t> &inliers,
                        const std::vector<feature::EImageDescriberType> &descTypes,
                        matching::MatchesPerDescType &out_geometricInliersPerType);
 
+/**
+ * @brief Sort the putative matches from the best to the worst distance ratio,
+ * with the indices of the matrices filled by fillMatricesWithUndistortFeaturesMatches.
+ * @param[in] putativeMatchesPerType Matches of the pair
+ * @param[in] descTypes The describer types used to fill the matrices
+ * @param[out] sortedIndices The indices of the matches sorted by increasing distance ratio
+ * @return false if the matches have no distance ratio (e.g. loaded from a file)
+ */
+bool getMatchesSortedByQuality(const matching::MatchesPerDescType &putativeMatchesPerType,
+                               const std::vector<feature::EImageDescriberType> &descTypes,
+                               std::vector<std::size_t> &sortedIndices);
+
 /**
  * @brief Compute the transformation that standardize the input points so that
  * they are z-scores (i.e. zero mean and unit standard deviation).
@@ -269,6 +281,61 @@ void findTransformationInliers(const Mat2X& featuresI,
                                double tolerance,
                                std::set<IndexT> &inliersId);
 
+/**
+ * @brief Spatial index of a set of matches, to find the inliers of a transformation
+ * without testing all the matches.
+ * @details The matches are grouped in buckets according to the grid cells of their points
+ * in the two images. A bucket is skipped when the transformation of the bounding box of its
+ * points in the first image is further than the tolerance from the bounding box of its points
+ * in the second image.
+ */
+class MatchesGrid
+{
+public:
+  /**
+   * @param[in] featuresI
+   * @param[in] featuresJ
+   * @param[in] matches The indexed matches.
+   * @param[in] gridSize The number of cells of the grid along each image axis.
+   */
+  MatchesGrid(const std::vector<feature::SIOPointFeature> & featuresI,
+              const std::vector<feature::SIOPointFeature> & featuresJ,
+              const matching::IndMatches & matches,
+              std::size_t gridSize = 8);
+
+  /**
+   * @brief Return the id. of the matches with a reprojection error < to the desirered \c tolerance.
+   * @see findTransformationInliers
+   * @param[in] transformation The 3x3 transformation matrix.
+   * @param[in] tolerance The tolerated pixel error.
+   * @param[out] inliersId The index in the indexed matches vector.
+   */
+  void findTransformationInliers(const Mat3 & transformation,
+                                 double tolerance,
+                                 std::set<IndexT> & inliersId) const;
+
+  /// The number of indexed matches
+  std::size_t size() const { return _matchesId.size(); }
+
+private:
+  struct Bucket
+  {
+    /// Bounding box of the points in the first image
+    Vec2 minI, maxI;
+    /// Bounding box of the points in the second image
+    Vec2 minJ, maxJ;
+    /// Range of the bucket matches in the sorted points
+    std::size_t begin, end;
+  };
+
+  /// Points of the matches, sorted by bucket
+  Mat2X _pointsI;
+  Mat2X _pointsJ;
+  /// Index in the indexed matches vector of each sorted point
+  std::vector<IndexT> _matchesId;
+  std::vector<Bucket> _buckets;
+};
+
 
 bool refineHomography(const std::vector<feature::SIOPointFeature> &featuresI,
                       const std::vector<feature::SIOPointFeature> &featuresJ,
@@ -75,4 +75,45 @@ BOOST_AUTO_TEST_CASE(matchingImageCollection_similarityEstimation)
 //    std::cout << result.isZero() << std::endl;
 //    std::cout <<  point.cast<double>() - ptIp_hom.hnormalized() << std::endl;
   }
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE(matchingImageCollection_matchesGrid)
+{
+  const std::size_t numMatches{500};
+  const std::size_t numTrials{50};
+  const double tolerance{20.0};
+
+  std::vector<feature::SIOPointFeature> featuresI;
+  std::vector<feature::SIOPointFeature> featuresJ;
+  matching::IndMatches matches;
+
+  // homography relating the two images, with some outliers
+  Mat3 H;
+  H << 0.9, 0.1, 30.0,
+      -0.05, 1.1, -20.0,
+       1e-4, -2e-4, 1.0;
+
+  for(std::size_t i = 0; i < numMatches; ++i)
+  {
+    const Vec2 ptI = 500.0 * (Vec2::Random() + Vec2::Ones());
+    Vec2 ptJ = (H * ptI.homogeneous()).hnormalized() + Vec2::Random();
+    if(i % 3 == 0)
+      ptJ = 500.0 * (Vec2::Random() + Vec2::Ones());
+    featuresI.emplace_back(ptI.x(), ptI.y());
+    featuresJ.emplace_back(ptJ.x(), ptJ.y());
+    matches.emplace_back(i, i);
+  }
+
+  const matchingImageCollection::MatchesGrid matchesGrid(featuresI, featuresJ, matches);
+  BOOST_CHECK_EQUAL(matchesGrid.size(), numMatches);
+
+  // same inliers as the linear search
+  for(std::size_t i = 0; i < numTrials; ++i)
+  {
+    const Mat3 transformation = (i == 0) ? H : Mat3(H + 0.01 * Mat3::Random().cwiseProduct(H));
+    std::set<IndexT> gridInliers;
+    std::set<IndexT> inliers;
+    matchesGrid.findTransformationInliers(transformation, tolerance, gridInliers);
+    matchingImageCollection::findTransformationInliers(featuresI, featuresJ, matches, transformation, tolerance, inliers);
+    BOOST_CHECK(gridInliers == inliers);
+  }
+}
@@ -17,17 +17,19 @@ namespace aliceVision {
 namespace matchingImageCollection {
   
 
-std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio)
+std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio, const std::string& cascadeHashingFolder, const std::string& kdtreeIndexFolder)
 {
   std::unique_ptr<IImageCollectionMatcher> matcherPtr;
   
   switch(matcherType)
   {
     case matching::BRUTE_FORCE_L2:          matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::BRUTE_FORCE_L2)); break;
-    case matching::ANN_L2:                  matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::ANN_L2)); break;
+    case matching::ANN_L2:                  matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::ANN_L2, kdtreeIndexFolder)); break;
     case matching::CASCADE_HASHING_L2:      matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::CASCADE_HASHING_L2)); break;
-    case matching::FAST_CASCADE_HASHING_L2: matcherPtr.reset(new ImageCollectionMatcher_cascadeHashing(distRatio)); break;
+    case matching::FAST_CASCADE_HASHING_L2: matcherPtr.reset(new ImageCollectionMatcher_cascadeHashing(distRatio, cascadeHashingFolder)); break;
     case matching::BRUTE_FORCE_HAMMING:     matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::BRUTE_FORCE_HAMMING)); break;
+    case matching::BRUTE_FORCE_L2_CUDA:      matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::BRUTE_FORCE_L2_CUDA)); break;
+    case matching::BRUTE_FORCE_HAMMING_CUDA: matcherPtr.reset(new ImageCollectionMatcher_generic(distRatio, matching::BRUTE_FORCE_HAMMING_CUDA)); break;
     
     default: throw std::out_of_range("Invalid matcherType enum");
   }
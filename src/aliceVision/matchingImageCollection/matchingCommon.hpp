@@ -10,15 +10,21 @@
 #include "aliceVision/matching/matcherType.hpp"
 #include "aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp"
 
+#include <memory>
+#include <string>
+
 namespace aliceVision {
 namespace matchingImageCollection {
   
 /**
  * 
  * @param matcherType
+ * @param distRatio
+ * @param cascadeHashingFolder Folder used by FAST_CASCADE_HASHING_L2 to persist the hashed descriptions (disabled if empty)
+ * @param kdtreeIndexFolder Folder used by ANN_L2 to persist the kd-tree indexes (disabled if empty)
  * @return 
  */
-std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio);
+std::unique_ptr<IImageCollectionMatcher> createImageCollectionMatcher(matching::EMatcherType matcherType, float distRatio, const std::string& cascadeHashingFolder = "", const std::string& kdtreeIndexFolder = "");
 
 
 } // namespace matching
@@ -0,0 +1,280 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "matchingStats.hpp"
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+void MatchingStats::addPutativeMatching(const Pair& pair, double durationMs,
+                                        std::size_t nbFeaturesI, std::size_t nbFeaturesJ,
+                                        std::size_t nbPutativeMatches)
+{
+  PairMatchingStats& s = pairs[pair];
+  s.putativeMatchingMs += durationMs;
+  s.nbFeaturesI += nbFeaturesI;
+  s.nbFeaturesJ += nbFeaturesJ;
+  s.nbPutativeMatches += nbPutativeMatches;
+}
+
+void MatchingStats::merge(const MatchingStats& other)
+{
+  for(const auto& pairStats : other.pairs)
+  {
+    PairMatchingStats& s = pairs[pairStats.first];
+    s.putativeMatchingMs += pairStats.second.putativeMatchingMs;
+    s.geometricFilteringMs += pairStats.second.geometricFilteringMs;
+    s.nbFeaturesI = std::max(s.nbFeaturesI, pairStats.second.nbFeaturesI);
+    s.nbFeaturesJ = std::max(s.nbFeaturesJ, pairStats.second.nbFeaturesJ);
+    s.nbPutativeMatches += pairStats.second.nbPutativeMatches;
+    s.nbInliers += pairStats.second.nbInliers;
+    s.nbRansacIterations += pairStats.second.nbRansacIterations;
+  }
+  for(const auto& viewStats : other.views)
+  {
+    ViewMatchingStats& s = views[viewStats.first];
+    s.loadingMs += viewStats.second.loadingMs;
+    s.indexingMs += viewStats.second.indexingMs;
+  }
+  for(const auto& step : other.steps)
+    steps[step.first] += step.second;
+}
+
+void saveMatchingStats(const std::string& filename, const MatchingStats& stats)
+{
+  std::ofstream file(filename);
+
+  if(!file.is_open())
+    throw std::runtime_error("Can't save matching statistics file, can't open '" + filename + "' !");
+
+  file << std::fixed << std::setprecision(3);
+
+  for(const auto& step : stats.steps)
+    file << "step," << step.first << "," << step.second << "\n";
+
+  for(const auto& viewStats : stats.views)
+  {
+    const ViewMatchingStats& s = viewStats.second;
+    file << "view," << viewStats.first << "," << s.loadingMs << "," << s.indexingMs << "\n";
+  }
+
+  for(const auto& pairStats : stats.pairs)
+  {
+    const PairMatchingStats& s = pairStats.second;
+    file << "pair," << pairStats.first.first << "," << pairStats.first.second << ","
+         << s.putativeMatchingMs << "," << s.geometricFilteringMs << ","
+         << s.nbFeaturesI << "," << s.nbFeaturesJ << ","
+         << s.nbPutativeMatches << "," << s.nbInliers << "," << s.nbRansacIterations << "\n";
+  }
+
+  if(!file.good())
+    throw std::runtime_error("Can't save matching statistics file, '" + filename + "' is incorrect !");
+}
+
+bool loadMatchingStats(const std::string& filename, MatchingStats& stats)
+{
+  std::ifstream file(filename);
+  if(!file.is_open())
+  {
+    ALICEVISION_LOG_WARNING("Can't read the matching statistics file: " << filename);
+    return false;
+  }
+
+  MatchingStats loaded;
+  std::string line;
+  std::vector<std::string> fields;
+  std::size_t nbLine = 0;
+
+  try
+  {
+    for(; std::getline(file, line); ++nbLine)
+    {
+      boost::trim(line);
+      if(line.empty())
+        continue;
+      boost::split(fields, line, boost::is_any_of(","));
+
+      if(fields[0] == "step" && fields.size() == 3)
+      {
+        loaded.steps[fields[1]] += std::stod(fields[2]);
+      }
+      else if(fields[0] == "view" && fields.size() == 4)
+      {
+        ViewMatchingStats& s = loaded.views[std::stoul(fields[1])];
+        s.loadingMs += std::stod(fields[2]);
+        s.indexingMs += std::stod(fields[3]);
+      }
+      else if(fields[0] == "pair" && fields.size() == 10)
+      {
+        PairMatchingStats& s = loaded.pairs[std::make_pair(std::stoul(fields[1]), std::stoul(fields[2]))];
+        s.putativeMatchingMs = std::stod(fields[3]);
+        s.geometricFilteringMs = std::stod(fields[4]);
+        s.nbFeaturesI = std::stoul(fields[5]);
+        s.nbFeaturesJ = std::stoul(fields[6]);
+        s.nbPutativeMatches = std::stoul(fields[7]);
+        s.nbInliers = std::stoul(fields[8]);
+        s.nbRansacIterations = std::stoul(fields[9]);
+      }
+      else
+      {
+        ALICEVISION_LOG_WARNING("Invalid matching statistics file '" << filename << "' at line " << nbLine + 1 << ".");
+        return false;
+      }
+    }
+  }
+  catch(const std::logic_error&)
+  {
+    ALICEVISION_LOG_WARNING("Invalid matching statistics file '" << filename << "' at line " << nbLine + 1 << ".");
+    return false;
+  }
+
+  stats.merge(loaded);
+  return true;
+}
+
+namespace {
+
+/// Regressors of the pair cost model: constant, features product, putative matches
+Vec3 getCostRegressors(const PairMatchingStats& pairStats)
+{
+  return Vec3(1.0,
+              static_cast<double>(pairStats.nbFeaturesI) * pairStats.nbFeaturesJ / 1e6,
+              pairStats.nbPutativeMatches / 1e3);
+}
+
+} // namespace
+
+double PairCostModel::predict(const PairMatchingStats& pairStats) const
+{
+  const Vec3 x = getCostRegressors(pairStats);
+  return std::max(0.0, constantMs * x(0) + featuresProductMs * x(1) + putativeMatchesMs * x(2));
+}
+
+PairCostModel fitPairCostModel(const MatchingStats& stats)
+{
+  PairCostModel model;
+  const std::size_t nbPairs = stats.pairs.size();
+  if(nbPairs < 3)
+    return model;
+
+  Mat A(nbPairs, 3);
+  Vec b(nbPairs);
+  std::size_t i = 0;
+  for(const auto& pairStats : stats.pairs)
+  {
+    A.row(i) = getCostRegressors(pairStats.second).transpose();
+    b(i) = pairStats.second.totalMs();
+    ++i;
+  }
+
+  const Vec3 x = A.colPivHouseholderQr().solve(b);
+  model.constantMs = x(0);
+  model.featuresProductMs = x(1);
+  model.putativeMatchesMs = x(2);
+
+  const double mean = b.mean();
+  const double totalSquares = (b.array() - mean).square().sum();
+  const double residualSquares = (A * x - b).squaredNorm();
+  model.r2 = (totalSquares > 0.0) ? 1.0 - residualSquares / totalSquares : 1.0;
+  return model;
+}
+
+std::map<IndexT, double> getMeasuredViewCosts(const MatchingStats& stats)
+{
+  std::map<IndexT, std::size_t> nbPairsPerView;
+  for(const auto& pairStats : stats.pairs)
+  {
+    ++nbPairsPerView[pairStats.first.first];
+    ++nbPairsPerView[pairStats.first.second];
+  }
+
+  const auto getSharedViewMs = [&](IndexT viewId)
+  {
+    const auto it = stats.views.find(viewId);
+    if(it == stats.views.end())
+      return 0.0;
+    return (it->second.loadingMs + it->second.indexingMs) / nbPairsPerView.at(viewId);
+  };
+
+  std::map<IndexT, double> sumPairsMs;
+  for(const auto& pairStats : stats.pairs)
+  {
+    const Pair& pair = pairStats.first;
+    const double pairMs = pairStats.second.totalMs() + getSharedViewMs(pair.first) + getSharedViewMs(pair.second);
+    sumPairsMs[pair.first] += pairMs;
+    sumPairsMs[pair.second] += pairMs;
+  }
+
+  std::map<IndexT, double> viewCosts;
+  for(const auto& viewMs : sumPairsMs)
+  {
+    // strictly positive, so a fast view still weights its pairs
+    viewCosts[viewMs.first] = std::max(std::sqrt(viewMs.second / nbPairsPerView.at(viewMs.first)), 1e-3);
+  }
+  return viewCosts;
+}
+
+void saveViewCosts(const std::string& filename, const std::map<IndexT, double>& viewCosts)
+{
+  std::ofstream file(filename);
+
+  if(!file.is_open())
+    throw std::runtime_error("Can't save view costs file, can't open '" + filename + "' !");
+
+  for(const auto& viewCost : viewCosts)
+    file << viewCost.first << "," << viewCost.second << "\n";
+
+  if(!file.good())
+    throw std::runtime_error("Can't save view costs file, '" + filename + "' is incorrect !");
+}
+
+bool loadViewCosts(const std::string& filename, std::map<IndexT, double>& viewCosts)
+{
+  std::ifstream file(filename);
+  if(!file.is_open())
+  {
+    ALICEVISION_LOG_WARNING("Can't read the view costs file: " << filename);
+    return false;
+  }
+
+  std::string line;
+  std::vector<std::string> fields;
+  try
+  {
+    while(std::getline(file, line))
+    {
+      boost::trim(line);
+      if(line.empty())
+        continue;
+      boost::split(fields, line, boost::is_any_of(","));
+      if(fields.size() != 2)
+      {
+        ALICEVISION_LOG_WARNING("Invalid view costs file: " << filename);
+        return false;
+      }
+      viewCosts[std::stoul(fields[0])] = std::stod(fields[1]);
+    }
+  }
+  catch(const std::logic_error&)
+  {
+    ALICEVISION_LOG_WARNING("Invalid view costs file: " << filename);
+    return false;
+  }
+  return true;
+}
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
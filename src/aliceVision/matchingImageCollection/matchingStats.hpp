@@ -0,0 +1,133 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+/**
+ * @brief Measured cost of the matching of one image pair (summed over the describer types).
+ */
+struct PairMatchingStats
+{
+  /// time of the putative (photometric) matching in milliseconds
+  double putativeMatchingMs = 0.0;
+  /// time of the geometric filtering (robust estimation and guided matching) in milliseconds
+  double geometricFilteringMs = 0.0;
+  std::size_t nbFeaturesI = 0;
+  std::size_t nbFeaturesJ = 0;
+  std::size_t nbPutativeMatches = 0;
+  std::size_t nbInliers = 0;
+  /// number of iterations of the robust estimation (0 if not reported by the geometric filter)
+  std::size_t nbRansacIterations = 0;
+
+  double totalMs() const { return putativeMatchingMs + geometricFilteringMs; }
+};
+
+/**
+ * @brief Measured cost of one view, shared by all the pairs of the view.
+ */
+struct ViewMatchingStats
+{
+  /// time of the regions loading in milliseconds (only measured with a regions cache)
+  double loadingMs = 0.0;
+  /// time of the build of the matcher database (kd-tree, hashed descriptions) in milliseconds
+  double indexingMs = 0.0;
+};
+
+/**
+ * @brief Per pair and per view instrumentation of the feature matching.
+ */
+struct MatchingStats
+{
+  std::map<Pair, PairMatchingStats> pairs;
+  std::map<IndexT, ViewMatchingStats> views;
+  /// total time of each step of the matching (e.g. loadRegions, saveMatches) in milliseconds
+  std::map<std::string, double> steps;
+
+  /// Add the putative matching of one pair for one describer type
+  void addPutativeMatching(const Pair& pair, double durationMs,
+                           std::size_t nbFeaturesI, std::size_t nbFeaturesJ,
+                           std::size_t nbPutativeMatches);
+
+  /// Add the measures of another run (e.g. another shard of the same matching)
+  void merge(const MatchingStats& other);
+};
+
+/**
+ * @brief Save the matching statistics in a CSV file, one line per step, view and pair:
+ *  - step,<name>,<ms>
+ *  - view,<viewId>,<loadingMs>,<indexingMs>
+ *  - pair,<I>,<J>,<putativeMatchingMs>,<geometricFilteringMs>,<nbFeaturesI>,<nbFeaturesJ>,<nbPutativeMatches>,<nbInliers>,<nbRansacIterations>
+ * @param[in] filename The CSV file
+ * @param[in] stats The statistics
+ */
+void saveMatchingStats(const std::string& filename, const MatchingStats& stats);
+
+/**
+ * @brief Load a matching statistics file and merge it in the given statistics
+ * @param[in] filename The CSV file (see saveMatchingStats)
+ * @param[in,out] stats The statistics
+ * @return false if the file can't be read or is invalid
+ */
+bool loadMatchingStats(const std::string& filename, MatchingStats& stats);
+
+/**
+ * @brief Linear model of the cost of the matching of one pair, fitted on measured statistics:
+ *        cost = constantMs + featuresProductMs * nbFeaturesI * nbFeaturesJ / 1e6 + putativeMatchesMs * nbPutativeMatches / 1e3
+ */
+struct PairCostModel
+{
+  double constantMs = 0.0;
+  /// cost of one million couples of features
+  double featuresProductMs = 0.0;
+  /// cost of one thousand putative matches
+  double putativeMatchesMs = 0.0;
+  /// coefficient of determination of the fit
+  double r2 = 0.0;
+
+  double predict(const PairMatchingStats& pairStats) const;
+};
+
+/**
+ * @brief Fit the cost model on the measured pairs (least squares)
+ * @param[in] stats The statistics
+ * @return the cost model, with zero coefficients if there are less than 3 pairs
+ */
+PairCostModel fitPairCostModel(const MatchingStats& stats);
+
+/**
+ * @brief Get a measured matching cost of each view, usable to balance the pairs of future runs
+ *        (see getPairBlocks, the cost of a pair is the product of the costs of its views).
+ *
+ * The cost of a view is the square root of the mean measured duration (in ms) of its pairs,
+ * its loading and indexing durations being shared by its pairs.
+ * @param[in] stats The statistics
+ * @return the cost of each view of the measured pairs
+ */
+std::map<IndexT, double> getMeasuredViewCosts(const MatchingStats& stats);
+
+/**
+ * @brief Save view costs in a CSV file (one "<viewId>,<cost>" line per view)
+ */
+void saveViewCosts(const std::string& filename, const std::map<IndexT, double>& viewCosts);
+
+/**
+ * @brief Load view costs from a CSV file (one "<viewId>,<cost>" line per view)
+ * @return false if the file can't be read or is invalid
+ */
+bool loadViewCosts(const std::string& filename, std::map<IndexT, double>& viewCosts);
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
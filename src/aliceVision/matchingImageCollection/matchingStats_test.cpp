@@ -0,0 +1,104 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/matchingImageCollection/matchingStats.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <cmath>
+
+#define BOOST_TEST_MODULE matchingImageCollectionMatchingStats
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matchingImageCollection;
+
+namespace fs = boost::filesystem;
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_matchingStats_IO)
+{
+  MatchingStats stats;
+  stats.steps["putativeMatching"] = 1234.5;
+  stats.views[3].loadingMs = 10.0;
+  stats.views[3].indexingMs = 20.0;
+  stats.addPutativeMatching(Pair(3, 7), 5.0, 1000, 2000, 300);
+  stats.addPutativeMatching(Pair(3, 7), 1.0, 100, 200, 30);
+  stats.pairs[Pair(3, 7)].geometricFilteringMs = 2.5;
+  stats.pairs[Pair(3, 7)].nbInliers = 100;
+  stats.pairs[Pair(3, 7)].nbRansacIterations = 512;
+
+  // the describer types of a pair are summed
+  BOOST_CHECK_EQUAL(stats.pairs.at(Pair(3, 7)).nbFeaturesI, 1100);
+  BOOST_CHECK_EQUAL(stats.pairs.at(Pair(3, 7)).nbPutativeMatches, 330);
+  BOOST_CHECK_CLOSE(stats.pairs.at(Pair(3, 7)).totalMs(), 8.5, 1e-6);
+
+  const std::string filename = (fs::temp_directory_path() / fs::unique_path("%%%%-%%%%.csv")).string();
+  saveMatchingStats(filename, stats);
+
+  MatchingStats loaded;
+  BOOST_CHECK(loadMatchingStats(filename, loaded));
+  BOOST_CHECK_CLOSE(loaded.steps.at("putativeMatching"), 1234.5, 1e-6);
+  BOOST_CHECK_CLOSE(loaded.views.at(3).indexingMs, 20.0, 1e-6);
+  const PairMatchingStats& s = loaded.pairs.at(Pair(3, 7));
+  BOOST_CHECK_CLOSE(s.putativeMatchingMs, 6.0, 1e-6);
+  BOOST_CHECK_CLOSE(s.geometricFilteringMs, 2.5, 1e-6);
+  BOOST_CHECK_EQUAL(s.nbFeaturesJ, 2200);
+  BOOST_CHECK_EQUAL(s.nbInliers, 100);
+  BOOST_CHECK_EQUAL(s.nbRansacIterations, 512);
+
+  // the steps of several runs are summed
+  BOOST_CHECK(loadMatchingStats(filename, loaded));
+  BOOST_CHECK_CLOSE(loaded.steps.at("putativeMatching"), 2 * 1234.5, 1e-6);
+
+  fs::remove(filename);
+  BOOST_CHECK(!loadMatchingStats(filename, loaded));
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_matchingStats_costModel)
+{
+  // cost = 2 + 3 * nbFeaturesI * nbFeaturesJ / 1e6 + 5 * nbPutativeMatches / 1e3
+  MatchingStats stats;
+  for(IndexT i = 0; i < 10; ++i)
+  {
+    PairMatchingStats& s = stats.pairs[Pair(i, i + 1)];
+    s.nbFeaturesI = 1000 + 500 * i;
+    s.nbFeaturesJ = 2000 + 100 * (i % 3);
+    s.nbPutativeMatches = 100 + 70 * ((i * 7) % 5);
+    s.putativeMatchingMs = 2.0 + 3.0 * s.nbFeaturesI * s.nbFeaturesJ / 1e6;
+    s.geometricFilteringMs = 5.0 * s.nbPutativeMatches / 1e3;
+  }
+
+  const PairCostModel model = fitPairCostModel(stats);
+  BOOST_CHECK_CLOSE(model.constantMs, 2.0, 1e-4);
+  BOOST_CHECK_CLOSE(model.featuresProductMs, 3.0, 1e-4);
+  BOOST_CHECK_CLOSE(model.putativeMatchesMs, 5.0, 1e-4);
+  BOOST_CHECK_CLOSE(model.r2, 1.0, 1e-4);
+  BOOST_CHECK_CLOSE(model.predict(stats.pairs.at(Pair(4, 5))), stats.pairs.at(Pair(4, 5)).totalMs(), 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_matchingStats_viewCosts)
+{
+  MatchingStats stats;
+  stats.pairs[Pair(0, 1)].putativeMatchingMs = 4.0;
+  stats.pairs[Pair(0, 2)].putativeMatchingMs = 16.0;
+  stats.views[2].indexingMs = 8.0;
+
+  const std::map<IndexT, double> viewCosts = getMeasuredViewCosts(stats);
+  BOOST_CHECK_EQUAL(viewCosts.size(), 3);
+  // the indexing of view 2 is shared by its only pair
+  BOOST_CHECK_CLOSE(viewCosts.at(0), std::sqrt((4.0 + 24.0) / 2.0), 1e-6);
+  BOOST_CHECK_CLOSE(viewCosts.at(1), 2.0, 1e-6);
+  BOOST_CHECK_CLOSE(viewCosts.at(2), std::sqrt(24.0), 1e-6);
+
+  const std::string filename = (fs::temp_directory_path() / fs::unique_path("%%%%-%%%%.csv")).string();
+  saveViewCosts(filename, viewCosts);
+  std::map<IndexT, double> loaded;
+  BOOST_CHECK(loadViewCosts(filename, loaded));
+  BOOST_CHECK_EQUAL(loaded.size(), 3);
+  BOOST_CHECK_CLOSE(loaded.at(1), 2.0, 1e-3);
+  fs::remove(filename);
+}
@@ -11,6 +11,12 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <boost/filesystem.hpp>
+
+#include "nanoflann.hpp"
+
+#include <cassert>
+#include <cmath>
 #include <set>
 #include <iostream>
 #include <fstream>
@@ -45,6 +51,210 @@ PairSet exhaustivePairs(const sfmData::Views& views, int rangeStart, int rangeSi
   return pairs;
 }
 
+std::size_t exhaustivePairsCount(std::size_t nbViews)
+{
+  return nbViews * (nbViews - std::min(nbViews, std::size_t(1))) / 2;
+}
+
+void forEachExhaustivePair(const std::vector<IndexT>& viewIds,
+                           std::size_t pairRangeStart,
+                           std::size_t pairRangeSize,
+                           const std::function<void(const Pair&)>& processPair)
+{
+  assert(std::is_sorted(viewIds.begin(), viewIds.end()));
+  const std::size_t nbViews = viewIds.size();
+  const std::size_t pairRangeEnd = std::min(exhaustivePairsCount(nbViews), pairRangeStart + std::min(pairRangeSize, exhaustivePairsCount(nbViews)));
+
+  // find the row of the first pair
+  std::size_t i = 0;
+  std::size_t rowStart = 0;
+  while(i < nbViews && rowStart + (nbViews - 1 - i) <= pairRangeStart)
+  {
+    rowStart += nbViews - 1 - i;
+    ++i;
+  }
+
+  std::size_t j = i + 1 + (pairRangeStart - rowStart);
+  for(std::size_t p = pairRangeStart; p < pairRangeEnd; ++p)
+  {
+    if(j >= nbViews)
+    {
+      ++i;
+      j = i + 1;
+    }
+    processPair(std::make_pair(viewIds[i], viewIds[j]));
+    ++j;
+  }
+}
+
+std::vector<IndexT> sequenceOrder(const sfmData::Views& views)
+{
+  std::vector<const sfmData::View*> sortedViews;
+  sortedViews.reserve(views.size());
+  for(const auto& viewPair : views)
+    sortedViews.push_back(viewPair.second.get());
+
+  std::stable_sort(sortedViews.begin(), sortedViews.end(), [](const sfmData::View* a, const sfmData::View* b)
+  {
+    // undefined frame ids are sorted after the defined ones
+    if(a->getFrameId() != b->getFrameId())
+      return a->getFrameId() < b->getFrameId();
+    return a->getImagePath() < b->getImagePath();
+  });
+
+  std::vector<IndexT> viewIds;
+  viewIds.reserve(sortedViews.size());
+  for(const sfmData::View* view : sortedViews)
+    viewIds.push_back(view->getViewId());
+  return viewIds;
+}
+
+PairSet sequentialPairs(const sfmData::Views& views, std::size_t windowSize)
+{
+  const std::vector<IndexT> viewIds = sequenceOrder(views);
+
+  PairSet pairs;
+  for(std::size_t i = 0; i < viewIds.size(); ++i)
+  {
+    for(std::size_t j = i + 1; j < std::min(viewIds.size(), i + 1 + windowSize); ++j)
+      pairs.insert(std::make_pair(std::min(viewIds[i], viewIds[j]), std::max(viewIds[i], viewIds[j])));
+  }
+  return pairs;
+}
+
+Vec3 WGS84ToCartesian(double latitude, double longitude, double altitude)
+{
+  // WGS84 ellipsoid
+  constexpr double a = 6378137.0;
+  constexpr double e2 = 6.69437999014e-3;
+
+  const double lat = latitude * M_PI / 180.0;
+  const double lon = longitude * M_PI / 180.0;
+  const double sinLat = std::sin(lat);
+  const double n = a / std::sqrt(1.0 - e2 * sinLat * sinLat);
+
+  return Vec3((n + altitude) * std::cos(lat) * std::cos(lon),
+              (n + altitude) * std::cos(lat) * std::sin(lon),
+              (n * (1.0 - e2) + altitude) * sinLat);
+}
+
+namespace {
+
+/**
+ * @brief nanoflann dataset adaptor on the positions of the views.
+ */
+struct PositionsAdaptator
+{
+  using Derived = PositionsAdaptator;
+  using T = double;
+
+  const std::vector<Vec3>& _data;
+  explicit PositionsAdaptator(const std::vector<Vec3>& data)
+    : _data(data)
+  {}
+
+  inline const Derived& derived() const { return *this; }
+  inline size_t kdtree_get_point_count() const { return _data.size(); }
+  inline T kdtree_get_pt(const size_t idx, int dim) const { return _data[idx](dim); }
+  template <class BBOX>
+  bool kdtree_get_bbox(BBOX&) const { return false; }
+};
+
+using PositionsKdTree = nanoflann::KDTreeSingleIndexAdaptor<
+    nanoflann::L2_Simple_Adaptor<double, PositionsAdaptator>,
+    PositionsAdaptator,
+    3 /* dim */
+    >;
+
+/// views in the same frame, the directions are null if unknown
+struct PositionedViews
+{
+  std::vector<IndexT> viewIds;
+  std::vector<Vec3> positions;
+  std::vector<Vec3> directions;
+};
+
+void addSpatialPairs(const PositionedViews& views, std::size_t nbNeighbors, double maxViewAngle, PairSet& pairs)
+{
+  if(views.viewIds.size() < 2 || nbNeighbors == 0)
+    return;
+
+  const PositionsAdaptator points(views.positions);
+  PositionsKdTree kdTree(3 /*dim*/, points, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+  kdTree.buildIndex();
+
+  const double minCosAngle = std::cos(maxViewAngle * M_PI / 180.0);
+  const bool filterDirections = (maxViewAngle > 0.0 && maxViewAngle < 180.0);
+  // with the direction filter, more candidates than neighbors are needed
+  const std::size_t nbCandidates = std::min(views.viewIds.size(), (filterDirections ? 4 : 1) * nbNeighbors + 1);
+
+  std::vector<std::vector<Pair>> pairsPerView(views.viewIds.size());
+
+  #pragma omp parallel for schedule(dynamic, 64)
+  for(int i = 0; i < views.viewIds.size(); ++i)
+  {
+    std::vector<std::size_t> indexes(nbCandidates);
+    std::vector<double> dist2(nbCandidates);
+    nanoflann::KNNResultSet<double, std::size_t> resultSet(nbCandidates);
+    resultSet.init(indexes.data(), dist2.data());
+    kdTree.findNeighbors(resultSet, views.positions[i].data(), nanoflann::SearchParams());
+
+    const Vec3& direction = views.directions[i];
+    std::size_t nbSelected = 0;
+    for(std::size_t c = 0; c < resultSet.size() && nbSelected < nbNeighbors; ++c)
+    {
+      const std::size_t j = indexes[c];
+      if(j == i)
+        continue;
+      if(filterDirections && !direction.isZero() && !views.directions[j].isZero() &&
+         direction.dot(views.directions[j]) < minCosAngle)
+        continue;
+      pairsPerView[i].emplace_back(std::min(views.viewIds[i], views.viewIds[j]), std::max(views.viewIds[i], views.viewIds[j]));
+      ++nbSelected;
+    }
+  }
+
+  for(const std::vector<Pair>& viewPairs : pairsPerView)
+    pairs.insert(viewPairs.begin(), viewPairs.end());
+}
+
+} // namespace
+
+PairSet spatialPairs(const sfmData::SfMData& sfmData, std::size_t nbNeighbors, double maxViewAngle, std::size_t* nbPositionedViews)
+{
+  PositionedViews posedViews;
+  PositionedViews gpsViews;
+
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    const sfmData::View& view = *viewPair.second;
+    double latitude, longitude, altitude;
+
+    if(sfmData.existsPose(view))
+    {
+      // pose prior: the optical axis is the third row of the rotation
+      const geometry::Pose3 pose = sfmData.getPose(view).getTransform();
+      posedViews.viewIds.push_back(view.getViewId());
+      posedViews.positions.push_back(pose.center());
+      posedViews.directions.push_back(pose.rotation().row(2).transpose().normalized());
+    }
+    else if(view.getMetadataGpsPosition(latitude, longitude, altitude))
+    {
+      gpsViews.viewIds.push_back(view.getViewId());
+      gpsViews.positions.push_back(WGS84ToCartesian(latitude, longitude, altitude));
+      gpsViews.directions.push_back(Vec3::Zero());
+    }
+  }
+
+  if(nbPositionedViews)
+    *nbPositionedViews = posedViews.viewIds.size() + gpsViews.viewIds.size();
+
+  PairSet pairs;
+  addSpatialPairs(posedViews, nbNeighbors, maxViewAngle, pairs);
+  addSpatialPairs(gpsViews, nbNeighbors, maxViewAngle, pairs);
+  return pairs;
+}
+
 bool loadPairs(const std::string &sFileName,
                PairSet & pairs,
                int rangeStart,
@@ -123,4 +333,164 @@ bool savePairs(const std::string &sFileName, const PairSet & pairs)
   return bOk;
 }
 
+namespace {
+
+bool writePairsBinary(const std::string& sFileName, const PairsFileHeader& header, const std::vector<std::uint32_t>& imageIds,
+                      const std::vector<std::uint64_t>& offsets, const std::vector<std::uint32_t>& secondIds)
+{
+  std::ofstream stream(sFileName.c_str(), std::ios::out | std::ios::binary);
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_WARNING("savePairsBinary: Impossible to open the output specified file: \"" << sFileName << "\".");
+    return false;
+  }
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(PairsFileHeader));
+  stream.write(reinterpret_cast<const char*>(imageIds.data()), imageIds.size() * sizeof(std::uint32_t));
+  stream.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+  stream.write(reinterpret_cast<const char*>(secondIds.data()), secondIds.size() * sizeof(std::uint32_t));
+  return !stream.bad();
+}
+
+} // namespace
+
+bool savePairsBinary(const std::string& sFileName, PairVec pairs)
+{
+  for(Pair& pair : pairs)
+  {
+    if(pair.first > pair.second)
+      std::swap(pair.first, pair.second);
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+  std::vector<std::uint32_t> imageIds;
+  imageIds.reserve(2 * pairs.size());
+  for(const Pair& pair : pairs)
+  {
+    imageIds.push_back(pair.first);
+    imageIds.push_back(pair.second);
+  }
+  std::sort(imageIds.begin(), imageIds.end());
+  imageIds.erase(std::unique(imageIds.begin(), imageIds.end()), imageIds.end());
+  imageIds.shrink_to_fit();
+
+  std::vector<std::uint64_t> offsets(imageIds.size() + 1, 0);
+  std::vector<std::uint32_t> secondIds;
+  secondIds.reserve(pairs.size());
+  std::size_t row = 0;
+  for(const Pair& pair : pairs)
+  {
+    while(imageIds[row] < pair.first)
+      offsets[++row] = secondIds.size();
+    secondIds.push_back(pair.second);
+  }
+  while(row < imageIds.size())
+    offsets[++row] = secondIds.size();
+
+  PairsFileHeader header;
+  header.nbImages = imageIds.size();
+  header.nbPairs = secondIds.size();
+  return writePairsBinary(sFileName, header, imageIds, offsets, secondIds);
+}
+
+bool saveExhaustivePairsBinary(const std::string& sFileName, std::vector<IndexT> viewIds)
+{
+  std::sort(viewIds.begin(), viewIds.end());
+  viewIds.erase(std::unique(viewIds.begin(), viewIds.end()), viewIds.end());
+
+  PairsFileHeader header;
+  header.flags = PAIRS_FILE_EXHAUSTIVE;
+  header.nbImages = viewIds.size();
+  header.nbPairs = exhaustivePairsCount(viewIds.size());
+  return writePairsBinary(sFileName, header, std::vector<std::uint32_t>(viewIds.begin(), viewIds.end()), {}, {});
+}
+
+bool loadPairsBinary(const std::string& sFileName,
+                     PairSet& pairs,
+                     std::size_t shardIndex,
+                     std::size_t nbShards,
+                     std::size_t* nbPairsTotal)
+{
+  std::ifstream stream(sFileName.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_WARNING("loadPairsBinary: Impossible to read the specified file: \"" << sFileName << "\".");
+    return false;
+  }
+
+  PairsFileHeader header;
+  if(!stream.read(reinterpret_cast<char*>(&header), sizeof(PairsFileHeader)) || header.magic != PAIRS_FILE_MAGIC)
+  {
+    ALICEVISION_LOG_WARNING("loadPairsBinary: Invalid binary pairs file: \"" << sFileName << "\".");
+    return false;
+  }
+  if(header.version != PAIRS_FILE_VERSION)
+  {
+    ALICEVISION_LOG_WARNING("loadPairsBinary: Unsupported binary pairs file version (" << header.version << "): \"" << sFileName << "\".");
+    return false;
+  }
+
+  const bool exhaustive = (header.flags & PAIRS_FILE_EXHAUSTIVE);
+  const std::uint64_t fileSize = boost::filesystem::file_size(sFileName);
+  const std::uint64_t dataSize = header.nbImages * sizeof(std::uint32_t) +
+                                 (exhaustive ? 0 : (header.nbImages + 1) * sizeof(std::uint64_t) + header.nbPairs * sizeof(std::uint32_t));
+  if(header.nbImages > fileSize || header.nbPairs > fileSize || sizeof(PairsFileHeader) + dataSize != fileSize ||
+     (exhaustive && header.nbPairs != exhaustivePairsCount(header.nbImages)))
+  {
+    ALICEVISION_LOG_WARNING("loadPairsBinary: Truncated binary pairs file: \"" << sFileName << "\".");
+    return false;
+  }
+
+  if(nbPairsTotal)
+    *nbPairsTotal = header.nbPairs;
+
+  // pairs range of the shard
+  nbShards = std::max(nbShards, std::size_t(1));
+  const std::uint64_t pairRangeStart = header.nbPairs * shardIndex / nbShards;
+  const std::uint64_t pairRangeEnd = (shardIndex < nbShards) ? header.nbPairs * (shardIndex + 1) / nbShards : pairRangeStart;
+  if(pairRangeStart >= pairRangeEnd)
+    return true;
+
+  std::vector<std::uint32_t> imageIds(header.nbImages);
+  if(!stream.read(reinterpret_cast<char*>(imageIds.data()), imageIds.size() * sizeof(std::uint32_t)))
+  {
+    ALICEVISION_LOG_WARNING("loadPairsBinary: Truncated binary pairs file: \"" << sFileName << "\".");
+    return false;
+  }
+
+  if(exhaustive)
+  {
+    forEachExhaustivePair(std::vector<IndexT>(imageIds.begin(), imageIds.end()), pairRangeStart, pairRangeEnd - pairRangeStart,
+                          [&pairs](const Pair& pair){ pairs.insert(pair); });
+    return true;
+  }
+
+  std::vector<std::uint64_t> offsets(header.nbImages + 1);
+  std::vector<std::uint32_t> secondIds(pairRangeEnd - pairRangeStart);
+  const std::uint64_t secondIdsOffset = sizeof(PairsFileHeader) + header.nbImages * sizeof(std::uint32_t) + offsets.size() * sizeof(std::uint64_t);
+
+  if(!stream.read(reinterpret_cast<char*>(offsets.data()), offsets.size() * sizeof(std::uint64_t)) ||
+     !stream.seekg(secondIdsOffset + pairRangeStart * sizeof(std::uint32_t)) ||
+     !stream.read(reinterpret_cast<char*>(secondIds.data()), secondIds.size() * sizeof(std::uint32_t)))
+  {
+    ALICEVISION_LOG_WARNING("loadPairsBinary: Truncated binary pairs file: \"" << sFileName << "\".");
+    return false;
+  }
+  if(offsets.front() != 0 || offsets.back() != header.nbPairs || !std::is_sorted(offsets.begin(), offsets.end()))
+  {
+    ALICEVISION_LOG_WARNING("loadPairsBinary: Invalid binary pairs file: \"" << sFileName << "\".");
+    return false;
+  }
+
+  // row of the first pair of the shard
+  std::size_t row = std::upper_bound(offsets.begin(), offsets.end(), pairRangeStart) - offsets.begin() - 1;
+  for(std::uint64_t p = pairRangeStart; p < pairRangeEnd; ++p)
+  {
+    while(offsets[row + 1] <= p)
+      ++row;
+    pairs.insert(pairs.end(), std::make_pair(imageIds[row], secondIds[p - pairRangeStart]));
+  }
+  return true;
+}
+
 }; // namespace aliceVision
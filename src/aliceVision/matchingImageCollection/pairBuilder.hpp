@@ -11,12 +11,57 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
 
 namespace aliceVision {
 
 /// Generate all the (I,J) pairs of the upper diagonal of the NxN matrix
 PairSet exhaustivePairs(const sfmData::Views& views, int rangeStart=-1, int rangeSize=0);
 
+/// Number of the (I,J) pairs of the upper diagonal of the NxN matrix, without generating them
+std::size_t exhaustivePairsCount(std::size_t nbViews);
+
+/**
+ * @brief Generate on the fly the exhaustive pairs of index [pairRangeStart, pairRangeStart + pairRangeSize),
+ *        the pairs are never stored.
+ * The pairs (viewIds[i], viewIds[j]) with i < j are indexed row by row, as in a binary pairs file.
+ * @param[in] viewIds the sorted view ids
+ * @param[in] pairRangeStart the index of the first pair
+ * @param[in] pairRangeSize the number of pairs
+ * @param[in] processPair the function called for each pair
+ */
+void forEachExhaustivePair(const std::vector<IndexT>& viewIds,
+                           std::size_t pairRangeStart,
+                           std::size_t pairRangeSize,
+                           const std::function<void(const Pair&)>& processPair);
+
+/// Sort the view ids in the acquisition order of a sequence (video frames):
+/// by frame id when defined, then by image path
+std::vector<IndexT> sequenceOrder(const sfmData::Views& views);
+
+/// Generate the (I,J) pairs between each view and the windowSize next views of the sequence (see sequenceOrder)
+PairSet sequentialPairs(const sfmData::Views& views, std::size_t windowSize);
+
+/// Geodetic WGS84 position (latitude, longitude in degrees, altitude in meters) to the WGS84 cartesian frame (ECEF, in meters)
+Vec3 WGS84ToCartesian(double latitude, double longitude, double altitude);
+
+/**
+ * @brief Generate the (I,J) pairs between each view and its nbNeighbors nearest views, from a kd-tree of the view positions.
+ * The positions are the centers of the defined poses of the SfMData (e.g. pose priors),
+ * or else the GPS positions from the metadata of the views (see View::getMetadataGpsPosition).
+ * These two kinds of views are not in the same frame, they are only paired with views of the same kind.
+ * @param[in] sfmData the SfMData with the views
+ * @param[in] nbNeighbors the number of nearest views of each view
+ * @param[in] maxViewAngle the max angle in degrees between the viewing directions of a pair,
+ *            only for the views with a pose (disabled if <= 0)
+ * @param[out] nbPositionedViews the number of views with a position (optional)
+ */
+PairSet spatialPairs(const sfmData::SfMData& sfmData, std::size_t nbNeighbors, double maxViewAngle = 0.0,
+                     std::size_t* nbPositionedViews = nullptr);
+
 /// Load a set of PairSet from a file
 /// I J K L (pair that link I)
 bool loadPairs(
@@ -30,4 +75,68 @@ bool loadPairs(
 /// I K
 bool savePairs(const std::string &sFileName, const PairSet & pairs);
 
+/// Magic number of the binary pairs files ("AVPL")
+constexpr std::uint32_t PAIRS_FILE_MAGIC = 0x4c505641;
+/// Current version of the binary pairs file format
+constexpr std::uint32_t PAIRS_FILE_VERSION = 1;
+/// The binary pairs file only lists the images, all their pairs are implicit
+constexpr std::uint32_t PAIRS_FILE_EXHAUSTIVE = 1;
+
+/**
+ * @brief Header of a binary pairs file.
+ *
+ * The pairs (I,J) with I < J are stored sorted in a compressed sparse row layout:
+ * - header
+ * - image ids (uint32 x nbImages), sorted
+ * - row offsets (uint64 x nbImages + 1): the pairs of the image k are the pairs [offsets[k], offsets[k+1])
+ * - J image ids (uint32 x nbPairs), sorted in each row
+ * With the PAIRS_FILE_EXHAUSTIVE flag, the file stops after the image ids:
+ * all the pairs of the images are implicit and generated on the fly (see forEachExhaustivePair).
+ * The pairs of a range are read with a single seek in the J image ids, so a pairs file
+ * can be sharded by byte ranges without loading the other pairs.
+ */
+struct PairsFileHeader
+{
+  std::uint32_t magic = PAIRS_FILE_MAGIC;
+  std::uint32_t version = PAIRS_FILE_VERSION;
+  /// PAIRS_FILE_EXHAUSTIVE or 0
+  std::uint32_t flags = 0;
+  std::uint32_t reserved = 0;
+  std::uint64_t nbImages = 0;
+  std::uint64_t nbPairs = 0;
+};
+
+/**
+ * @brief Save pairs to a binary pairs file (see PairsFileHeader)
+ * @param[in] sFileName the binary pairs file
+ * @param[in] pairs the pairs, in any order, (I,J) and (J,I) are the same pair
+ * @return true if the file is written
+ */
+bool savePairsBinary(const std::string& sFileName, PairVec pairs);
+
+/**
+ * @brief Save the exhaustive pairs of some images to a binary pairs file, only the image ids are stored
+ * @param[in] sFileName the binary pairs file
+ * @param[in] viewIds the image ids
+ * @return true if the file is written
+ */
+bool saveExhaustivePairsBinary(const std::string& sFileName, std::vector<IndexT> viewIds);
+
+/**
+ * @brief Load a shard of the pairs of a binary pairs file (see PairsFileHeader)
+ * The pairs are split into nbShards ranges of the same size, only the pairs
+ * of the range shardIndex are read.
+ * @param[in] sFileName the binary pairs file
+ * @param[out] pairs the pairs of the shard
+ * @param[in] shardIndex the index of the shard to load
+ * @param[in] nbShards the number of shards
+ * @param[out] nbPairsTotal the number of pairs of the whole file (optional)
+ * @return true if the file is valid
+ */
+bool loadPairsBinary(const std::string& sFileName,
+                     PairSet& pairs,
+                     std::size_t shardIndex = 0,
+                     std::size_t nbShards = 1,
+                     std::size_t* nbPairsTotal = nullptr);
+
 }; // namespace aliceVision
@@ -61,6 +61,34 @@ BOOST_AUTO_TEST_CASE(matchingImageCollection_exhaustivePairs)
   }
 }
 
+BOOST_AUTO_TEST_CASE(matchingImageCollection_sequentialPairs)
+{
+  sfmData::Views views;
+  // view ids unrelated to the frame order
+  const std::vector<std::string> paths = {{ "frame_03.jpg", "frame_00.jpg", "frame_04.jpg", "frame_01.jpg", "frame_02.jpg" }};
+  for(IndexT i = 0; i < paths.size(); ++i)
+  {
+    views[i] = std::make_shared<sfmData::View>(paths[i], i);
+  }
+
+  const std::vector<IndexT> order = sequenceOrder(views);
+  BOOST_CHECK( order == std::vector<IndexT>({{ 1, 3, 4, 0, 2 }}) );
+
+  const PairSet pairSet = sequentialPairs(views, 2);
+  BOOST_CHECK( checkPairOrder(pairSet) );
+  // frames: (0,1) (0,2) (1,2) (1,3) (2,3) (2,4) (3,4)
+  BOOST_CHECK_EQUAL( 7, pairSet.size());
+  BOOST_CHECK( pairSet.find(std::make_pair(1,3)) != pairSet.end() );
+  BOOST_CHECK( pairSet.find(std::make_pair(1,4)) != pairSet.end() );
+  BOOST_CHECK( pairSet.find(std::make_pair(0,4)) != pairSet.end() );
+  BOOST_CHECK( pairSet.find(std::make_pair(0,2)) != pairSet.end() );
+  BOOST_CHECK( pairSet.find(std::make_pair(1,0)) == pairSet.end() );
+  BOOST_CHECK( pairSet.find(std::make_pair(0,1)) == pairSet.end() );
+
+  BOOST_CHECK_EQUAL( 0, sequentialPairs(views, 0).size());
+  BOOST_CHECK( sequentialPairs(views, 10) == exhaustivePairs(views) );
+}
+
 BOOST_AUTO_TEST_CASE(matchingImageCollection_IO)
 {
   PairSet pairSetGT;
@@ -79,3 +107,138 @@ BOOST_AUTO_TEST_CASE(matchingImageCollection_IO)
   BOOST_CHECK( loadPairs("pairsT_IO.txt", loaded_Pairs));
   BOOST_CHECK( std::equal(loaded_Pairs.begin(), loaded_Pairs.end(), pairSetGTsorted.begin()) );
 }
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_forEachExhaustivePair)
+{
+  sfmData::Views views;
+  std::vector<IndexT> viewIds = {{ 3, 7, 12, 54, 65, 89 }};
+  for(IndexT i : viewIds)
+    views[i] = std::make_shared<sfmData::View>("filepath", i);
+
+  const PairSet pairSetGT = exhaustivePairs(views);
+  BOOST_CHECK_EQUAL( exhaustivePairsCount(viewIds.size()), pairSetGT.size() );
+  BOOST_CHECK_EQUAL( 0, exhaustivePairsCount(0) );
+  BOOST_CHECK_EQUAL( 0, exhaustivePairsCount(1) );
+
+  // any range of pairs, in the order of exhaustivePairs
+  const PairVec pairsGT(pairSetGT.begin(), pairSetGT.end());
+  for(std::size_t start = 0; start <= pairsGT.size(); ++start)
+  {
+    for(std::size_t size = 0; size <= pairsGT.size() + 1; ++size)
+    {
+      PairVec pairs;
+      forEachExhaustivePair(viewIds, start, size, [&pairs](const Pair& pair){ pairs.push_back(pair); });
+      const PairVec expected(pairsGT.begin() + start, pairsGT.begin() + std::min(pairsGT.size(), start + size));
+      BOOST_CHECK( pairs == expected );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_binaryIO)
+{
+  PairVec pairsGT = {{ {5, 1}, {1, 2}, {2, 9}, {1, 9}, {9, 3}, {2, 5}, {1, 2} }};
+  const PairSet pairSetGTsorted = {{ {1, 2}, {1, 5}, {1, 9}, {2, 5}, {2, 9}, {3, 9} }};
+
+  BOOST_CHECK( savePairsBinary("pairsT_IO.bin", pairsGT) );
+
+  PairSet loadedPairs;
+  std::size_t nbPairs = 0;
+  BOOST_CHECK( loadPairsBinary("pairsT_IO.bin", loadedPairs, 0, 1, &nbPairs) );
+  BOOST_CHECK_EQUAL( pairSetGTsorted.size(), nbPairs );
+  BOOST_CHECK( loadedPairs == pairSetGTsorted );
+
+  // the shards split the pairs in ranges of the same size
+  for(std::size_t nbShards = 1; nbShards <= 8; ++nbShards)
+  {
+    PairSet allShards;
+    for(std::size_t shard = 0; shard < nbShards; ++shard)
+    {
+      PairSet shardPairs;
+      BOOST_CHECK( loadPairsBinary("pairsT_IO.bin", shardPairs, shard, nbShards) );
+      BOOST_CHECK( shardPairs.size() <= (pairSetGTsorted.size() + nbShards - 1) / nbShards );
+      for(const Pair& pair : shardPairs)
+        BOOST_CHECK( allShards.insert(pair).second );
+    }
+    BOOST_CHECK( allShards == pairSetGTsorted );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_binaryIO_exhaustive)
+{
+  sfmData::Views views;
+  std::vector<IndexT> viewIds = {{ 65, 12, 54, 89, 3 }};
+  for(IndexT i : viewIds)
+    views[i] = std::make_shared<sfmData::View>("filepath", i);
+
+  BOOST_CHECK( saveExhaustivePairsBinary("pairsT_IO_exhaustive.bin", viewIds) );
+
+  PairSet loadedPairs;
+  BOOST_CHECK( loadPairsBinary("pairsT_IO_exhaustive.bin", loadedPairs) );
+  BOOST_CHECK( loadedPairs == exhaustivePairs(views) );
+
+  PairSet allShards;
+  for(std::size_t shard = 0; shard < 3; ++shard)
+  {
+    PairSet shardPairs;
+    BOOST_CHECK( loadPairsBinary("pairsT_IO_exhaustive.bin", shardPairs, shard, 3) );
+    allShards.insert(shardPairs.begin(), shardPairs.end());
+  }
+  BOOST_CHECK( allShards == exhaustivePairs(views) );
+
+  // not a binary pairs file
+  PairSet invalidPairs;
+  BOOST_CHECK( savePairs("pairsT_IO.txt", exhaustivePairs(views)) );
+  BOOST_CHECK( !loadPairsBinary("pairsT_IO.txt", invalidPairs) );
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_spatialPairs)
+{
+  sfmData::SfMData sfmData;
+
+  // GPS views on a line, 10 meters apart (about 9e-5 degrees of latitude)
+  for(IndexT i = 0; i < 6; ++i)
+  {
+    auto view = std::make_shared<sfmData::View>("filepath", i);
+    view->addMetadata("GPS:Latitude", std::to_string(45.0 + i * 9e-5));
+    view->addMetadata("GPS:Longitude", "5.0");
+    view->addMetadata("GPS:Altitude", "100");
+    sfmData.views[i] = view;
+  }
+  // a view without position
+  sfmData.views[6] = std::make_shared<sfmData::View>("filepath", 6);
+
+  std::size_t nbPositionedViews = 0;
+  const PairSet gpsPairs = spatialPairs(sfmData, 1, 0.0, &nbPositionedViews);
+  BOOST_CHECK_EQUAL( 6, nbPositionedViews );
+  BOOST_CHECK( checkPairOrder(gpsPairs) );
+  BOOST_CHECK( gpsPairs == PairSet({{ {0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5} }}) );
+  BOOST_CHECK_EQUAL( 0, spatialPairs(sfmData, 0).size() );
+  // more neighbors than views: all the pairs of the positioned views
+  PairSet gpsExhaustivePairs = exhaustivePairs(sfmData.views);
+  for(IndexT i = 0; i < 6; ++i)
+    gpsExhaustivePairs.erase(std::make_pair(i, 6));
+  BOOST_CHECK( spatialPairs(sfmData, 10) == gpsExhaustivePairs );
+
+  // posed views (pose priors) at the same position, looking in opposite directions
+  const Mat3 R0 = Mat3::Identity();
+  const Mat3 R1 = RotationAroundY(M_PI);
+  for(IndexT i = 10; i < 14; ++i)
+  {
+    auto view = std::make_shared<sfmData::View>("filepath", i, UndefinedIndexT, i);
+    sfmData.views[i] = view;
+    sfmData.setPose(*view, sfmData::CameraPose(geometry::Pose3((i % 2) ? R1 : R0, Vec3(i * 0.1, 0.0, 0.0))));
+  }
+
+  // the posed views are only paired together, the GPS views are unchanged
+  const PairSet allPairs = spatialPairs(sfmData, 3);
+  BOOST_CHECK( std::includes(allPairs.begin(), allPairs.end(), gpsPairs.begin(), gpsPairs.end()) );
+  BOOST_CHECK( allPairs.count(std::make_pair(10, 11)) );
+  BOOST_CHECK( !allPairs.count(std::make_pair(5, 10)) );
+
+  // the direction filter removes the views looking in opposite directions
+  const PairSet filteredPairs = spatialPairs(sfmData, 3, 30.0);
+  BOOST_CHECK( filteredPairs.count(std::make_pair(10, 12)) );
+  BOOST_CHECK( filteredPairs.count(std::make_pair(11, 13)) );
+  BOOST_CHECK( !filteredPairs.count(std::make_pair(10, 11)) );
+  BOOST_CHECK( !filteredPairs.count(std::make_pair(12, 13)) );
+}
@@ -0,0 +1,100 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "pairScheduler.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+std::vector<PairBlock> getPairBlocks(const PairSet& pairs,
+                                     std::size_t blockSize,
+                                     const std::map<IndexT, double>& viewCosts)
+{
+  blockSize = std::max<std::size_t>(blockSize, 1);
+
+  // rank of each view
+  std::map<IndexT, std::size_t> ranks;
+  for(const Pair& pair : pairs)
+  {
+    ranks.emplace(pair.first, 0);
+    ranks.emplace(pair.second, 0);
+  }
+  std::size_t rank = 0;
+  for(auto& it : ranks)
+    it.second = rank++;
+
+  const auto getViewCost = [&viewCosts](IndexT viewId)
+  {
+    const auto it = viewCosts.find(viewId);
+    return (it == viewCosts.end()) ? 1.0 : it->second;
+  };
+
+  // sort by (I block, J block, I, J), J blocks are visited back and forth
+  // so the last J block of a row is the first one of the next row
+  typedef std::tuple<std::size_t, long long, IndexT, IndexT> SortKey;
+  std::vector<std::pair<SortKey, Pair>> keyedPairs;
+  keyedPairs.reserve(pairs.size());
+  for(const Pair& pair : pairs)
+  {
+    const std::size_t blockI = ranks.at(pair.first) / blockSize;
+    const long long blockJ = ranks.at(pair.second) / blockSize;
+    keyedPairs.emplace_back(SortKey(blockI, (blockI % 2) ? -blockJ : blockJ, pair.first, pair.second), pair);
+  }
+  std::sort(keyedPairs.begin(), keyedPairs.end());
+
+  std::vector<PairBlock> blocks;
+  for(std::size_t i = 0; i < keyedPairs.size(); ++i)
+  {
+    const SortKey& key = keyedPairs[i].first;
+    if(i == 0 ||
+       std::get<0>(key) != std::get<0>(keyedPairs[i - 1].first) ||
+       std::get<1>(key) != std::get<1>(keyedPairs[i - 1].first))
+      blocks.emplace_back();
+
+    const Pair& pair = keyedPairs[i].second;
+    blocks.back().pairs.push_back(pair);
+    blocks.back().cost += getViewCost(pair.first) * getViewCost(pair.second);
+  }
+  return blocks;
+}
+
+std::vector<Pair> getBlockOrderedPairs(const PairSet& pairs, std::size_t blockSize)
+{
+  std::vector<Pair> orderedPairs;
+  orderedPairs.reserve(pairs.size());
+  for(const PairBlock& block : getPairBlocks(pairs, blockSize))
+    orderedPairs.insert(orderedPairs.end(), block.pairs.begin(), block.pairs.end());
+  return orderedPairs;
+}
+
+PairSet getPairBlocksShard(const std::vector<PairBlock>& blocks, std::size_t shardIndex, std::size_t nbShards)
+{
+  PairSet pairs;
+  if(nbShards == 0 || shardIndex >= nbShards)
+    return pairs;
+
+  double totalCost = 0.0;
+  for(const PairBlock& block : blocks)
+    totalCost += block.cost;
+
+  // each block goes to the shard containing the middle of its cost range
+  double cost = 0.0;
+  for(const PairBlock& block : blocks)
+  {
+    const double middle = cost + block.cost / 2.0;
+    cost += block.cost;
+    const std::size_t blockShard = (totalCost > 0.0) ? std::min(static_cast<std::size_t>(middle / totalCost * nbShards), nbShards - 1) : 0;
+    if(blockShard == shardIndex)
+      pairs.insert(block.pairs.begin(), block.pairs.end());
+  }
+  return pairs;
+}
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
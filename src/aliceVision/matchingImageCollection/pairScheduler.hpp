@@ -0,0 +1,68 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+/// Default number of views of a block of the pair matrix:
+/// the regions of 2 * PAIR_BLOCK_SIZE views usually fit in the CPU caches
+constexpr std::size_t PAIR_BLOCK_SIZE = 16;
+
+/**
+ * @brief A tile of the pair matrix: pairs (I, J) with I and J in two ranges of blockSize views.
+ */
+struct PairBlock
+{
+  /// Pairs of the block sorted by (I, J)
+  std::vector<Pair> pairs;
+  /// Estimated matching cost of the pairs of the block
+  double cost = 0.0;
+};
+
+/**
+ * @brief Split the pairs into blocks of blockSize x blockSize views of the pair matrix (views are ranked by id).
+ *
+ * The pairs of a block only use 2 * blockSize views: a query view is matched against
+ * many train views while its descriptors are still in memory (regions cache or CPU caches).
+ * Blocks are returned row by row, the blocks of a row are visited back and forth
+ * so consecutive blocks share their views.
+ *
+ * @param[in] pairs The pairs
+ * @param[in] blockSize The number of views of a block side
+ * @param[in] viewCosts Optional estimated cost of each view (e.g. its number of features),
+ *            the cost of a pair (I, J) is viewCosts[I] * viewCosts[J] (1 for missing views)
+ * @return the blocks of pairs, empty blocks are skipped
+ */
+std::vector<PairBlock> getPairBlocks(const PairSet& pairs,
+                                     std::size_t blockSize = PAIR_BLOCK_SIZE,
+                                     const std::map<IndexT, double>& viewCosts = std::map<IndexT, double>());
+
+/**
+ * @brief Sort the pairs by blocks of the pair matrix (see getPairBlocks),
+ *        the pairs of a block can be matched with the regions of 2 * blockSize views in memory.
+ */
+std::vector<Pair> getBlockOrderedPairs(const PairSet& pairs, std::size_t blockSize = PAIR_BLOCK_SIZE);
+
+/**
+ * @brief Select the pairs of one shard: the blocks are split in nbShards ranges
+ *        of consecutive blocks with a similar total cost.
+ * @param[in] blocks The blocks of pairs (see getPairBlocks)
+ * @param[in] shardIndex The index of the shard in [0, nbShards[
+ * @param[in] nbShards The number of shards
+ * @return the pairs of the shard
+ */
+PairSet getPairBlocksShard(const std::vector<PairBlock>& blocks, std::size_t shardIndex, std::size_t nbShards);
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
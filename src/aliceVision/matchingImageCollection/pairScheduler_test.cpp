@@ -0,0 +1,104 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/matchingImageCollection/pairScheduler.hpp"
+#include "aliceVision/matchingImageCollection/pairBuilder.hpp"
+#include "aliceVision/sfmData/SfMData.hpp"
+#include "aliceVision/sfmData/View.hpp"
+
+#include <memory>
+#include <set>
+
+#define BOOST_TEST_MODULE matchingImageCollectionPairScheduler
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matchingImageCollection;
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_blockOrderedPairs)
+{
+  sfmData::Views views;
+  for(IndexT i = 0; i < 10; ++i)
+    views[i * 10] = std::make_shared<sfmData::View>("filepath", i * 10);
+
+  const PairSet pairSet = exhaustivePairs(views);
+  const std::size_t blockSize = 3;
+  const std::vector<Pair> orderedPairs = getBlockOrderedPairs(pairSet, blockSize);
+
+  // same pairs
+  BOOST_CHECK_EQUAL(pairSet.size(), orderedPairs.size());
+  BOOST_CHECK(PairSet(orderedPairs.begin(), orderedPairs.end()) == pairSet);
+
+  // each block of pairs uses at most 2 * blockSize views
+  std::size_t nbBlocks = 0;
+  std::size_t i = 0;
+  while(i < orderedPairs.size())
+  {
+    const std::size_t blockI = orderedPairs[i].first / 10 / blockSize;
+    const std::size_t blockJ = orderedPairs[i].second / 10 / blockSize;
+    std::set<IndexT> blockViews;
+    while(i < orderedPairs.size() &&
+          orderedPairs[i].first / 10 / blockSize == blockI &&
+          orderedPairs[i].second / 10 / blockSize == blockJ)
+    {
+      blockViews.insert(orderedPairs[i].first);
+      blockViews.insert(orderedPairs[i].second);
+      ++i;
+    }
+    BOOST_CHECK_LE(blockViews.size(), 2 * blockSize);
+    ++nbBlocks;
+  }
+  // 4 blocks of views (the last one with a single view, so without any pair on the diagonal):
+  // 3 diagonal blocks and 6 upper blocks, each one visited once
+  BOOST_CHECK_EQUAL(9, nbBlocks);
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_pairBlocksShard)
+{
+  sfmData::Views views;
+  std::map<IndexT, double> viewCosts;
+  for(IndexT i = 0; i < 40; ++i)
+  {
+    views[i] = std::make_shared<sfmData::View>("filepath", i);
+    // a few expensive views
+    viewCosts[i] = (i % 10 == 0) ? 10.0 : 1.0;
+  }
+
+  const PairSet pairSet = exhaustivePairs(views);
+  const std::vector<PairBlock> blocks = getPairBlocks(pairSet, 4, viewCosts);
+
+  double totalCost = 0.0;
+  double maxBlockCost = 0.0;
+  for(const PairBlock& block : blocks)
+  {
+    totalCost += block.cost;
+    maxBlockCost = std::max(maxBlockCost, block.cost);
+  }
+
+  const std::size_t nbShards = 5;
+  PairSet allShardsPairs;
+  std::size_t nbShardsPairs = 0;
+  for(std::size_t s = 0; s < nbShards; ++s)
+  {
+    const PairSet shardPairs = getPairBlocksShard(blocks, s, nbShards);
+    double shardCost = 0.0;
+    for(const Pair& pair : shardPairs)
+      shardCost += viewCosts.at(pair.first) * viewCosts.at(pair.second);
+
+    // balanced up to one block
+    BOOST_CHECK_LE(std::abs(shardCost - totalCost / nbShards), maxBlockCost);
+
+    nbShardsPairs += shardPairs.size();
+    allShardsPairs.insert(shardPairs.begin(), shardPairs.end());
+  }
+
+  // each pair in exactly one shard
+  BOOST_CHECK_EQUAL(pairSet.size(), nbShardsPairs);
+  BOOST_CHECK(allShardsPairs == pairSet);
+
+  BOOST_CHECK(getPairBlocksShard(blocks, nbShards, nbShards).empty());
+}
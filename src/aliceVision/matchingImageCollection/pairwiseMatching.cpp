@@ -0,0 +1,267 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "pairwiseMatching.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/feature/selection.hpp>
+#include <aliceVision/matchingImageCollection/matchingCommon.hpp>
+#include <aliceVision/matchingImageCollection/GeometricFilter.hpp>
+#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_F_AC.hpp>
+#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_E_AC.hpp>
+#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_H_AC.hpp>
+#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_HGrowing.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <limits>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+void computePutativeMatches(matching::PairwiseMatches& putativeMatches,
+                            const feature::RegionsPerView& regionsPerView,
+                            const PairSet& pairs,
+                            const std::vector<feature::EImageDescriberType>& describerTypes,
+                            const PairwiseMatchingParams& params,
+                            MatchingStats* stats)
+{
+  std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(params.matcherType, params.distRatio, params.cascadeHashingFolder, params.kdtreeIndexFolder);
+  imageCollectionMatcher->setMatchingStats(stats);
+
+  for(const feature::EImageDescriberType descType : describerTypes)
+  {
+    assert(descType != feature::EImageDescriberType::UNINITIALIZED);
+    ALICEVISION_LOG_INFO(feature::EImageDescriberType_enumToString(descType) + " Regions Matching");
+    imageCollectionMatcher->Match(regionsPerView, pairs, descType, putativeMatches);
+  }
+}
+
+void sortPutativeMatches(matching::PairwiseMatches& putativeMatches, EGeometricFilterType geometricFilterType)
+{
+  if(geometricFilterType != EGeometricFilterType::HOMOGRAPHY_GROWING)
+    return;
+
+  // sort putative matches according to their Lowe ratio
+  // This is suggested by [F.Srajer, 2016]: the matches used to be the seeds of the homographies growing are chosen according
+  // to the putative matches order. This modification should improve recall.
+  for(auto& imgPair: putativeMatches)
+  {
+    for(auto& descType: imgPair.second)
+    {
+      matching::IndMatches& matches = descType.second;
+      feature::sortMatches_byDistanceRatio(matches);
+    }
+  }
+}
+
+void geometricFiltering(matching::PairwiseMatches& geometricMatches,
+                        const sfmData::SfMData& sfmData,
+                        const feature::RegionsPerView& regionsPerView,
+                        const matching::PairwiseMatches& putativeMatches,
+                        const PairwiseMatchingParams& params,
+                        MatchingStats* stats)
+{
+  ALICEVISION_LOG_INFO("Geometric filtering: using " << EGeometricFilterType_enumToString(params.geometricFilterType));
+
+  switch(params.geometricFilterType)
+  {
+
+    case EGeometricFilterType::NO_FILTERING:
+      geometricMatches = putativeMatches;
+    break;
+
+    case EGeometricFilterType::FUNDAMENTAL_MATRIX:
+    {
+      GeometricFilterMatrix_F_AC filter(params.geometricErrorMax, params.maxIteration, params.geometricEstimator);
+      filter.m_useProsac = params.useProsac;
+      filter.m_useSprt = params.useSprt;
+      filter.m_nbHistogramBins = params.nbHistogramBins;
+      robustModelEstimation(geometricMatches,
+        &sfmData,
+        regionsPerView,
+        filter,
+        putativeMatches,
+        params.guidedMatching,
+        0.6,
+        stats);
+    }
+    break;
+
+    case EGeometricFilterType::ESSENTIAL_MATRIX:
+    {
+      GeometricFilterMatrix_E_AC filter(std::numeric_limits<double>::infinity(), params.maxIteration);
+      filter.m_useProsac = params.useProsac;
+      filter.m_useSprt = params.useSprt;
+      filter.m_nbHistogramBins = params.nbHistogramBins;
+      robustModelEstimation(geometricMatches,
+        &sfmData,
+        regionsPerView,
+        filter,
+        putativeMatches,
+        params.guidedMatching,
+        0.6,
+        stats);
+
+      // perform an additional check to remove pairs with poor overlap
+      std::vector<matching::PairwiseMatches::key_type> toRemoveVec;
+      for(matching::PairwiseMatches::const_iterator iterMap = geometricMatches.begin();
+        iterMap != geometricMatches.end(); ++iterMap)
+      {
+        const size_t putativePhotometricCount = putativeMatches.find(iterMap->first)->second.getNbAllMatches();
+        const size_t putativeGeometricCount = iterMap->second.getNbAllMatches();
+        const float ratio = putativeGeometricCount / (float)putativePhotometricCount;
+        if (putativeGeometricCount < 50 || ratio < .3f)
+          toRemoveVec.push_back(iterMap->first); // the image pair will be removed
+      }
+
+      // remove discarded pairs
+      for(std::vector<matching::PairwiseMatches::key_type>::const_iterator iter = toRemoveVec.begin();
+          iter != toRemoveVec.end(); ++iter)
+        geometricMatches.erase(*iter);
+    }
+    break;
+
+    case EGeometricFilterType::HOMOGRAPHY_MATRIX:
+    {
+      const bool onlyGuidedMatching = true;
+      GeometricFilterMatrix_H_AC filter(std::numeric_limits<double>::infinity(), params.maxIteration);
+      filter.m_useProsac = params.useProsac;
+      filter.m_useSprt = params.useSprt;
+      filter.m_nbHistogramBins = params.nbHistogramBins;
+      robustModelEstimation(geometricMatches,
+        &sfmData,
+        regionsPerView,
+        filter,
+        putativeMatches, params.guidedMatching,
+        onlyGuidedMatching ? -1.0 : 0.6,
+        stats);
+    }
+    break;
+
+    case EGeometricFilterType::HOMOGRAPHY_GROWING:
+    {
+      robustModelEstimation(geometricMatches,
+        &sfmData,
+        regionsPerView,
+        GeometricFilterMatrix_HGrowing(std::numeric_limits<double>::infinity(), params.maxIteration),
+        putativeMatches,
+        params.guidedMatching,
+        0.6,
+        stats);
+    }
+    break;
+  }
+
+  ALICEVISION_LOG_INFO(std::to_string(geometricMatches.size()) + " geometric image pair matches:");
+  for(const auto& matchGeo: geometricMatches)
+    ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGeo.first.first) + ", " + std::to_string(matchGeo.first.second) + ") contains " + std::to_string(matchGeo.second.getNbAllMatches()) + " geometric matches.");
+}
+
+void gridFiltering(matching::PairwiseMatches& finalMatches,
+                   const sfmData::SfMData& sfmData,
+                   const feature::RegionsPerView& regionsPerView,
+                   const matching::PairwiseMatches& geometricMatches,
+                   const PairwiseMatchingParams& params)
+{
+  ALICEVISION_LOG_INFO("Grid filtering");
+
+  // list the matches of each image pair and describer type, to process them in parallel
+  struct GridFilteringJob
+  {
+    Pair indexImagePair;
+    feature::EImageDescriberType descType;
+    const matching::IndMatches* inputMatches;
+    matching::IndMatches outMatches;
+    bool valid;
+  };
+
+  std::vector<GridFilteringJob> gridFilteringJobs;
+  for(const auto& geometricMatch: geometricMatches)
+  {
+    for(const auto& match: geometricMatch.second)
+    {
+      assert(match.first != feature::EImageDescriberType::UNINITIALIZED);
+      gridFilteringJobs.push_back({geometricMatch.first, match.first, &match.second, {}, false});
+    }
+  }
+
+#pragma omp parallel
+  {
+    // scratch buffers reused by all the jobs of the thread
+    feature::MatchesSelectionBuffers buffers;
+
+#pragma omp for schedule(dynamic)
+    for(int i = 0; i < gridFilteringJobs.size(); ++i)
+    {
+      //Get the image pair and their matches.
+      GridFilteringJob& job = gridFilteringJobs.at(i);
+      const Pair& indexImagePair = job.indexImagePair;
+
+      const feature::FeatRegions<feature::SIOPointFeature>* rRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionsPerView.getRegions(indexImagePair.second, job.descType));
+      const feature::FeatRegions<feature::SIOPointFeature>* lRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionsPerView.getRegions(indexImagePair.first, job.descType));
+
+      // get the regions for the current view pair:
+      if(!rRegions || !lRegions)
+        continue;
+
+      job.valid = true;
+
+      // sorting function:
+      // without grid filtering, only the numMatchesToKeep best matches need to be sorted
+      feature::sortMatches_byFeaturesScale(*job.inputMatches, *lRegions, *rRegions, job.outMatches, buffers, params.useGridSort ? 0 : params.numMatchesToKeep);
+
+      if(params.useGridSort)
+      {
+        // TODO: rename as matchesGridOrdering
+        const sfmData::View& lView = sfmData.getView(indexImagePair.first);
+        const sfmData::View& rView = sfmData.getView(indexImagePair.second);
+        feature::matchesGridFiltering(*lRegions, lView.getWidth(), lView.getHeight(),
+                                      *rRegions, rView.getWidth(), rView.getHeight(),
+                                      job.outMatches, buffers, params.numMatchesToKeep);
+      }
+    }
+  }
+
+  for(GridFilteringJob& job: gridFilteringJobs)
+  {
+    if(job.valid)
+      finalMatches[job.indexImagePair].insert(std::make_pair(job.descType, std::move(job.outMatches)));
+    else
+      ALICEVISION_LOG_INFO("You cannot perform the grid filtering with these regions");
+  }
+
+  ALICEVISION_LOG_INFO("After grid filtering:");
+  for(const auto& matchGridFiltering: finalMatches)
+    ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGridFiltering.first.first) + ", " + std::to_string(matchGridFiltering.first.second) + ") contains " + std::to_string(matchGridFiltering.second.getNbAllMatches()) + " geometric matches.");
+}
+
+void computePairwiseMatches(matching::PairwiseMatches& matches,
+                            const sfmData::SfMData& sfmData,
+                            const feature::RegionsPerView& regionsPerView,
+                            const PairSet& pairs,
+                            const std::vector<feature::EImageDescriberType>& describerTypes,
+                            const PairwiseMatchingParams& params,
+                            MatchingStats* stats)
+{
+  matches.clear();
+
+  matching::PairwiseMatches putativeMatches;
+  computePutativeMatches(putativeMatches, regionsPerView, pairs, describerTypes, params, stats);
+  if(putativeMatches.empty())
+  {
+    ALICEVISION_LOG_INFO("No putative matches.");
+    return;
+  }
+  sortPutativeMatches(putativeMatches, params.geometricFilterType);
+
+  matching::PairwiseMatches geometricMatches;
+  geometricFiltering(geometricMatches, sfmData, regionsPerView, putativeMatches, params, stats);
+  putativeMatches.clear();
+
+  gridFiltering(matches, sfmData, regionsPerView, geometricMatches, params);
+}
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
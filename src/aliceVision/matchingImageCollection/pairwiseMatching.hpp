@@ -0,0 +1,136 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/matching/matcherType.hpp>
+#include <aliceVision/matchingImageCollection/GeometricFilterType.hpp>
+#include <aliceVision/matchingImageCollection/matchingStats.hpp>
+#include <aliceVision/robustEstimation/estimators.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+/**
+ * @brief Parameters of the feature matching of image pairs (see the featureMatching options)
+ */
+struct PairwiseMatchingParams
+{
+  /// nearest neighbor matching method of the putative matches
+  matching::EMatcherType matcherType = matching::EMatcherType::ANN_L2;
+  /// distance ratio to discard non meaningful matches
+  float distRatio = 0.8f;
+  /// folder of the hashed descriptions of FAST_CASCADE_HASHING_L2 (disabled if empty)
+  std::string cascadeHashingFolder;
+  /// folder of the kd-tree indexes of ANN_L2 (disabled if empty)
+  std::string kdtreeIndexFolder;
+
+  EGeometricFilterType geometricFilterType = EGeometricFilterType::FUNDAMENTAL_MATRIX;
+  robustEstimation::ERobustEstimator geometricEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  /// maximum error of the geometric validation (0 for the adaptive threshold of ACRANSAC)
+  double geometricErrorMax = 0.0;
+  int maxIteration = 2048;
+  bool useProsac = false;
+  bool useSprt = false;
+  /// number of bins of the residual histogram of the ACRANSAC NFA (0 to sort the residuals)
+  std::size_t nbHistogramBins = 0;
+  bool guidedMatching = false;
+
+  /// keep the matches well spread in the images, instead of the largest scales only
+  bool useGridSort = true;
+  /// maximum number of matches kept per pair (0 for all)
+  std::size_t numMatchesToKeep = 0;
+};
+
+/**
+ * @brief Compute the putative (photometric) matches of the image pairs
+ * @param[out] putativeMatches The matches of each pair and describer type
+ * @param[in] regionsPerView The regions of the views of the pairs
+ * @param[in] pairs The image pairs to match
+ * @param[in] describerTypes The describer types to match
+ * @param[in] params The matching parameters
+ * @param[out] stats Optional matching statistics
+ */
+void computePutativeMatches(matching::PairwiseMatches& putativeMatches,
+                            const feature::RegionsPerView& regionsPerView,
+                            const PairSet& pairs,
+                            const std::vector<feature::EImageDescriberType>& describerTypes,
+                            const PairwiseMatchingParams& params,
+                            MatchingStats* stats = nullptr);
+
+/**
+ * @brief Sort the putative matches as expected by the geometric filter
+ *        (by distance ratio for HOMOGRAPHY_GROWING, the seeds of the homographies)
+ * @param[in,out] putativeMatches The putative matches
+ * @param[in] geometricFilterType The geometric filter
+ */
+void sortPutativeMatches(matching::PairwiseMatches& putativeMatches, EGeometricFilterType geometricFilterType);
+
+/**
+ * @brief Keep the geometrically coherent putative matches, see robustModelEstimation
+ * @param[out] geometricMatches The matches of the pairs with a valid model
+ * @param[in] sfmData The views and intrinsics of the pairs
+ * @param[in] regionsPerView The regions of the views (the descriptors are only used by the guided matching)
+ * @param[in] putativeMatches The putative matches, sorted by sortPutativeMatches
+ * @param[in] params The matching parameters
+ * @param[out] stats Optional matching statistics
+ */
+void geometricFiltering(matching::PairwiseMatches& geometricMatches,
+                        const sfmData::SfMData& sfmData,
+                        const feature::RegionsPerView& regionsPerView,
+                        const matching::PairwiseMatches& putativeMatches,
+                        const PairwiseMatchingParams& params,
+                        MatchingStats* stats = nullptr);
+
+/**
+ * @brief Sort the matches of each pair by features scale and keep params.numMatchesToKeep of them,
+ *        spread in the images if params.useGridSort
+ * @param[out] finalMatches The selected matches
+ * @param[in] sfmData The views of the pairs
+ * @param[in] regionsPerView The regions of the views
+ * @param[in] geometricMatches The matches to select
+ * @param[in] params The matching parameters
+ */
+void gridFiltering(matching::PairwiseMatches& finalMatches,
+                   const sfmData::SfMData& sfmData,
+                   const feature::RegionsPerView& regionsPerView,
+                   const matching::PairwiseMatches& geometricMatches,
+                   const PairwiseMatchingParams& params);
+
+/**
+ * @brief Match the image pairs in memory: putative matches, geometric filtering and grid filtering,
+ *        as the featureMatching pipeline does, without reading or writing files.
+ *
+ * The result can be given directly to the reconstruction engines (setMatches), with the
+ * features of sfm::getFeaturesPerView(regionsPerView), and saved with matching::Save if needed.
+ *
+ * @param[out] matches The matches of each pair and describer type
+ * @param[in] sfmData The views and intrinsics of the pairs
+ * @param[in] regionsPerView The regions of the views of the pairs
+ * @param[in] pairs The image pairs to match
+ * @param[in] describerTypes The describer types to match
+ * @param[in] params The matching parameters
+ * @param[out] stats Optional matching statistics
+ */
+void computePairwiseMatches(matching::PairwiseMatches& matches,
+                            const sfmData::SfMData& sfmData,
+                            const feature::RegionsPerView& regionsPerView,
+                            const PairSet& pairs,
+                            const std::vector<feature::EImageDescriberType>& describerTypes,
+                            const PairwiseMatchingParams& params,
+                            MatchingStats* stats = nullptr);
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
@@ -0,0 +1,77 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/matchingImageCollection/pairwiseMatching.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <memory>
+#include <random>
+
+#define BOOST_TEST_MODULE matchingImageCollectionPairwiseMatching
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_computePairwiseMatches)
+{
+  const std::size_t nbFeatures = 100;
+  const std::size_t width = 1000;
+  const std::size_t height = 800;
+
+  sfmData::SfMData sfmData;
+  for(IndexT viewId = 0; viewId < 2; ++viewId)
+    sfmData.views[viewId] = std::make_shared<sfmData::View>("", viewId, 0, viewId, width, height);
+
+  // same random descriptors in both views, in the reverse order in the second view
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> positions(50.f, 700.f);
+  std::uniform_int_distribution<int> bins(0, 255);
+
+  std::unique_ptr<feature::SIFT_Regions> regionsI(new feature::SIFT_Regions);
+  std::unique_ptr<feature::SIFT_Regions> regionsJ(new feature::SIFT_Regions);
+  regionsI->Features().resize(nbFeatures);
+  regionsI->Descriptors().resize(nbFeatures);
+  regionsJ->Features().resize(nbFeatures);
+  regionsJ->Descriptors().resize(nbFeatures);
+
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+  {
+    const float x = positions(generator);
+    const float y = positions(generator);
+    const std::size_t j = nbFeatures - 1 - i;
+    regionsI->Features()[i] = feature::SIOPointFeature(x, y, 1.f + i, 0.f);
+    regionsJ->Features()[j] = feature::SIOPointFeature(x + 10.f, y + 5.f, 1.f + i, 0.f);
+    for(std::size_t b = 0; b < 128; ++b)
+      regionsI->Descriptors()[i][b] = regionsJ->Descriptors()[j][b] = static_cast<unsigned char>(bins(generator));
+  }
+
+  feature::RegionsPerView regionsPerView;
+  regionsPerView.addRegions(0, feature::EImageDescriberType::SIFT, regionsI.release());
+  regionsPerView.addRegions(1, feature::EImageDescriberType::SIFT, regionsJ.release());
+
+  matchingImageCollection::PairwiseMatchingParams params;
+  params.matcherType = matching::EMatcherType::BRUTE_FORCE_L2;
+  params.geometricFilterType = matchingImageCollection::EGeometricFilterType::NO_FILTERING;
+  params.useGridSort = false;
+
+  const PairSet pairs = {Pair(0, 1)};
+  matching::PairwiseMatches matches;
+  matchingImageCollection::computePairwiseMatches(matches, sfmData, regionsPerView, pairs, {feature::EImageDescriberType::SIFT}, params);
+
+  BOOST_REQUIRE_EQUAL(matches.size(), 1);
+  const matching::IndMatches& pairMatches = matches.at(Pair(0, 1)).at(feature::EImageDescriberType::SIFT);
+  BOOST_CHECK_EQUAL(pairMatches.size(), nbFeatures);
+  for(const matching::IndMatch& match : pairMatches)
+    BOOST_CHECK_EQUAL(match._j, nbFeatures - 1 - match._i);
+
+  // sorted by features scale: the largest scale first
+  BOOST_CHECK_EQUAL(pairMatches.front()._i, nbFeatures - 1);
+
+  // keep the best matches only
+  params.numMatchesToKeep = 10;
+  matchingImageCollection::computePairwiseMatches(matches, sfmData, regionsPerView, pairs, {feature::EImageDescriberType::SIFT}, params);
+  BOOST_CHECK_EQUAL(matches.at(Pair(0, 1)).at(feature::EImageDescriberType::SIFT).size(), 10);
+}
@@ -5,15 +5,24 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Mesh.hpp"
+#include "meshVisibility.hpp"
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
 
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
 
 namespace aliceVision {
 namespace mesh {
@@ -82,14 +91,18 @@ bool Mesh::loadFromBin(std::string binFileName)
     fread(&npts, sizeof(int), 1, f);
     pts = new StaticVector<Point3d>();
     pts->resize(npts);
-    fread(&(*pts)[0], sizeof(Point3d), npts, f);
+    if(npts > 0)
+        fread(&(*pts)[0], sizeof(Point3d), npts, f);
     int ntris;
     fread(&ntris, sizeof(int), 1, f);
     tris = new StaticVector<Mesh::triangle>();
     tris->resize(ntris);
-    fread(&(*tris)[0], sizeof(Mesh::triangle), ntris, f);
+    if(ntris > 0)
+        fread(&(*tris)[0], sizeof(Mesh::triangle), ntris, f);
     fclose(f);
 
+    invalidateConnectivity();
+
     return true;
 }
 
@@ -103,18 +116,514 @@ void Mesh::saveToBin(std::string binFileName)
     // printf("write npts %i\n",npts);
     fwrite(&npts, sizeof(int), 1, f);
     // printf("write pts\n");
-    fwrite(&(*pts)[0], sizeof(Point3d), npts, f);
+    if(npts > 0)
+        fwrite(&(*pts)[0], sizeof(Point3d), npts, f);
     int ntris = tris->size();
     // printf("write ntris %i\n",ntris);
     fwrite(&ntris, sizeof(int), 1, f);
     // printf("write tris\n");
-    fwrite(&(*tris)[0], sizeof(Mesh::triangle), ntris, f);
+    if(ntris > 0)
+        fwrite(&(*tris)[0], sizeof(Mesh::triangle), ntris, f);
     // printf("close\n");
     fclose(f);
     // printf("done\n");
     mvsUtils::printfElapsedTime(t, "Save mesh to bin ");
 }
 
+bool isPlyFile(const std::string& filename)
+{
+    return boost::algorithm::to_lower_copy(bfs::path(filename).extension().string()) == ".ply";
+}
+
+namespace {
+
+/// number of elements converted in parallel between two reads or writes of a PLY file
+const int PLY_CHUNK_ELEMENTS = 1 << 20;
+
+enum class EPlyType
+{
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    FLOAT32,
+    FLOAT64
+};
+
+EPlyType EPlyType_stringToEnum(const std::string& type)
+{
+    if(type == "char" || type == "int8")
+        return EPlyType::INT8;
+    if(type == "uchar" || type == "uint8")
+        return EPlyType::UINT8;
+    if(type == "short" || type == "int16")
+        return EPlyType::INT16;
+    if(type == "ushort" || type == "uint16")
+        return EPlyType::UINT16;
+    if(type == "int" || type == "int32")
+        return EPlyType::INT32;
+    if(type == "uint" || type == "uint32")
+        return EPlyType::UINT32;
+    if(type == "float" || type == "float32")
+        return EPlyType::FLOAT32;
+    if(type == "double" || type == "float64")
+        return EPlyType::FLOAT64;
+    throw std::runtime_error("Unknown PLY property type: " + type);
+}
+
+std::size_t getPlyTypeSize(EPlyType type)
+{
+    switch(type)
+    {
+        case EPlyType::INT8:
+        case EPlyType::UINT8:
+            return 1;
+        case EPlyType::INT16:
+        case EPlyType::UINT16:
+            return 2;
+        case EPlyType::INT32:
+        case EPlyType::UINT32:
+        case EPlyType::FLOAT32:
+            return 4;
+        case EPlyType::FLOAT64:
+            return 8;
+    }
+    return 0;
+}
+
+template <typename T>
+inline T readBinary(const char* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+double readPlyValue(EPlyType type, const char* data)
+{
+    switch(type)
+    {
+        case EPlyType::INT8:    return readBinary<std::int8_t>(data);
+        case EPlyType::UINT8:   return readBinary<std::uint8_t>(data);
+        case EPlyType::INT16:   return readBinary<std::int16_t>(data);
+        case EPlyType::UINT16:  return readBinary<std::uint16_t>(data);
+        case EPlyType::INT32:   return readBinary<std::int32_t>(data);
+        case EPlyType::UINT32:  return readBinary<std::uint32_t>(data);
+        case EPlyType::FLOAT32: return readBinary<float>(data);
+        case EPlyType::FLOAT64: return readBinary<double>(data);
+    }
+    return 0.0;
+}
+
+struct PlyProperty
+{
+    std::string name;
+    /// type of the value, or of the items of a list
+    EPlyType type = EPlyType::FLOAT32;
+    bool isList = false;
+    EPlyType countType = EPlyType::UINT8;
+};
+
+struct PlyElement
+{
+    std::string name;
+    std::size_t count = 0;
+    std::vector<PlyProperty> properties;
+
+    /// size of one element in bytes, 0 if it has a list property
+    std::size_t getRecordSize() const
+    {
+        std::size_t size = 0;
+        for(const PlyProperty& property : properties)
+        {
+            if(property.isList)
+                return 0;
+            size += getPlyTypeSize(property.type);
+        }
+        return size;
+    }
+
+    /// index of the property, -1 if the element does not have it
+    int findProperty(const std::string& name) const
+    {
+        for(int i = 0; i < properties.size(); ++i)
+        {
+            if(properties[i].name == name)
+                return i;
+        }
+        return -1;
+    }
+
+    /// offset of the property in the record, the element must not have list properties
+    std::size_t getPropertyOffset(int propertyIndex) const
+    {
+        std::size_t offset = 0;
+        for(int i = 0; i < propertyIndex; ++i)
+            offset += getPlyTypeSize(properties[i].type);
+        return offset;
+    }
+};
+
+/// the binary PLY files are read and written in little endian, as the host
+bool isLittleEndian()
+{
+    const std::uint16_t value = 1;
+    return readBinary<std::uint8_t>(reinterpret_cast<const char*>(&value)) == 1;
+}
+
+/// Binary file read by chunks of the buffer size
+class ChunkedFileReader
+{
+public:
+    explicit ChunkedFileReader(FILE* file, std::size_t chunkSize = 64 * 1024 * 1024)
+        : _file(file)
+        , _buffer(chunkSize)
+    {}
+
+    /// Get the n next bytes of the file, the pointer is valid until the next read
+    const char* read(std::size_t n)
+    {
+        if(_end - _pos < n)
+        {
+            // keep the remaining bytes and fill the rest of the buffer
+            const std::size_t remaining = _end - _pos;
+            std::memmove(_buffer.data(), _buffer.data() + _pos, remaining);
+            if(_buffer.size() < n)
+                _buffer.resize(n);
+            _end = remaining + std::fread(_buffer.data() + remaining, 1, _buffer.size() - remaining, _file);
+            _pos = 0;
+            if(_end < n)
+                throw std::runtime_error("Unexpected end of the PLY file.");
+        }
+        const char* data = _buffer.data() + _pos;
+        _pos += n;
+        return data;
+    }
+
+private:
+    FILE* _file;
+    std::vector<char> _buffer;
+    std::size_t _pos = 0;
+    std::size_t _end = 0;
+};
+
+/// Binary file written by chunks of the buffer size
+class ChunkedFileWriter
+{
+public:
+    explicit ChunkedFileWriter(FILE* file, std::size_t chunkSize = 64 * 1024 * 1024)
+        : _file(file)
+        , _buffer(chunkSize)
+    {}
+
+    /// Get n bytes to fill, written to the file at the next flush
+    char* reserve(std::size_t n)
+    {
+        if(_size + n > _buffer.size())
+        {
+            flush();
+            if(_buffer.size() < n)
+                _buffer.resize(n);
+        }
+        char* data = _buffer.data() + _size;
+        _size += n;
+        return data;
+    }
+
+    void flush()
+    {
+        if(std::fwrite(_buffer.data(), 1, _size, _file) != _size)
+            throw std::runtime_error("Unable to write the PLY file.");
+        _size = 0;
+    }
+
+private:
+    FILE* _file;
+    std::vector<char> _buffer;
+    std::size_t _size = 0;
+};
+
+using FilePtr = std::unique_ptr<FILE, int (*)(FILE*)>;
+
+} // namespace
+
+void Mesh::saveToPly(const std::string& filename) const
+{
+    ALICEVISION_LOG_INFO("Save mesh to ply: " << filename);
+    ALICEVISION_LOG_INFO("Nb points: " << pts->size());
+    ALICEVISION_LOG_INFO("Nb triangles: " << tris->size());
+
+    if(!isLittleEndian())
+        throw std::runtime_error("Binary PLY files are only written on little endian systems.");
+
+    FilePtr f(fopen(filename.c_str(), "wb"), &fclose);
+    if(f == nullptr)
+        throw std::runtime_error("Unable to open the file to save the mesh: " + filename);
+
+    const bool useColors = (_colors.size() == pts->size());
+
+    fprintf(f.get(), "ply\n");
+    fprintf(f.get(), "format binary_little_endian 1.0\n");
+    fprintf(f.get(), "comment Created with AliceVision\n");
+    fprintf(f.get(), "element vertex %i\n", pts->size());
+    fprintf(f.get(), "property double x\nproperty double y\nproperty double z\n");
+    if(useColors)
+        fprintf(f.get(), "property uchar red\nproperty uchar green\nproperty uchar blue\n");
+    fprintf(f.get(), "element face %i\n", tris->size());
+    fprintf(f.get(), "property list uchar int vertex_indices\n");
+    fprintf(f.get(), "end_header\n");
+
+    ChunkedFileWriter writer(f.get());
+
+    const std::size_t vertexSize = 3 * sizeof(double) + (useColors ? 3 : 0);
+    for(int begin = 0; begin < pts->size(); begin += PLY_CHUNK_ELEMENTS)
+    {
+        const int end = std::min(begin + PLY_CHUNK_ELEMENTS, pts->size());
+        char* data = writer.reserve((end - begin) * vertexSize);
+
+        #pragma omp parallel for
+        for(int i = begin; i < end; ++i)
+        {
+            char* vertex = data + (i - begin) * vertexSize;
+            const Point3d& p = (*pts)[i];
+            std::memcpy(vertex, &p.x, sizeof(double));
+            std::memcpy(vertex + sizeof(double), &p.y, sizeof(double));
+            std::memcpy(vertex + 2 * sizeof(double), &p.z, sizeof(double));
+            if(useColors)
+            {
+                vertex[3 * sizeof(double)] = _colors[i].r;
+                vertex[3 * sizeof(double) + 1] = _colors[i].g;
+                vertex[3 * sizeof(double) + 2] = _colors[i].b;
+            }
+        }
+    }
+
+    const std::size_t faceSize = 1 + 3 * sizeof(std::int32_t);
+    for(int begin = 0; begin < tris->size(); begin += PLY_CHUNK_ELEMENTS)
+    {
+        const int end = std::min(begin + PLY_CHUNK_ELEMENTS, tris->size());
+        char* data = writer.reserve((end - begin) * faceSize);
+
+        #pragma omp parallel for
+        for(int i = begin; i < end; ++i)
+        {
+            char* face = data + (i - begin) * faceSize;
+            face[0] = 3;
+            for(int k = 0; k < 3; ++k)
+            {
+                const std::int32_t v = (*tris)[i].v[k];
+                std::memcpy(face + 1 + k * sizeof(std::int32_t), &v, sizeof(std::int32_t));
+            }
+        }
+    }
+
+    writer.flush();
+    ALICEVISION_LOG_INFO("Save mesh to ply done.");
+}
+
+void Mesh::save(const std::string& filename)
+{
+    if(isPlyFile(filename))
+        saveToPly(filename);
+    else
+        saveToObj(filename);
+}
+
+bool Mesh::loadFromPly(const std::string& filename)
+{
+    ALICEVISION_LOG_INFO("Loading mesh from ply file: " << filename);
+
+    FilePtr f(fopen(filename.c_str(), "rb"), &fclose);
+    if(f == nullptr)
+        return false;
+
+    // text header
+    std::vector<PlyElement> elements;
+    {
+        char lineBuffer[1024];
+        if(fgets(lineBuffer, sizeof(lineBuffer), f.get()) == nullptr || std::strncmp(lineBuffer, "ply", 3) != 0)
+            throw std::runtime_error("Not a PLY file: " + filename);
+
+        bool isHeaderEnded = false;
+        while(!isHeaderEnded && fgets(lineBuffer, sizeof(lineBuffer), f.get()) != nullptr)
+        {
+            std::istringstream line(lineBuffer);
+            std::string keyword;
+            line >> keyword;
+
+            if(keyword == "format")
+            {
+                std::string format;
+                line >> format;
+                if(format != "binary_little_endian")
+                    throw std::runtime_error("Unsupported PLY format '" + format + "', only binary_little_endian is supported: " + filename);
+                if(!isLittleEndian())
+                    throw std::runtime_error("Binary PLY files are only read on little endian systems.");
+            }
+            else if(keyword == "element")
+            {
+                PlyElement element;
+                line >> element.name >> element.count;
+                elements.push_back(element);
+            }
+            else if(keyword == "property")
+            {
+                if(elements.empty())
+                    throw std::runtime_error("PLY property without element: " + filename);
+                PlyProperty property;
+                std::string type;
+                line >> type;
+                if(type == "list")
+                {
+                    std::string countType;
+                    line >> countType >> type;
+                    property.isList = true;
+                    property.countType = EPlyType_stringToEnum(countType);
+                }
+                property.type = EPlyType_stringToEnum(type);
+                line >> property.name;
+                elements.back().properties.push_back(property);
+            }
+            else if(keyword == "end_header")
+            {
+                isHeaderEnded = true;
+            }
+        }
+        if(!isHeaderEnded)
+            throw std::runtime_error("Invalid PLY header: " + filename);
+    }
+
+    delete pts;
+    delete tris;
+    pts = new StaticVector<Point3d>();
+    tris = new StaticVector<Mesh::triangle>();
+    _colors.clear();
+
+    ChunkedFileReader reader(f.get());
+
+    for(const PlyElement& element : elements)
+    {
+        const std::size_t recordSize = element.getRecordSize();
+
+        if(element.name == "vertex")
+        {
+            const int xId = element.findProperty("x");
+            const int yId = element.findProperty("y");
+            const int zId = element.findProperty("z");
+            if(recordSize == 0 || xId < 0 || yId < 0 || zId < 0)
+                throw std::runtime_error("PLY vertices without x, y, z coordinates or with lists: " + filename);
+            const int colorIds[3] = {element.findProperty("red"), element.findProperty("green"), element.findProperty("blue")};
+            const bool useColors = (colorIds[0] >= 0 && colorIds[1] >= 0 && colorIds[2] >= 0);
+
+            const int coordIds[3] = {xId, yId, zId};
+            std::size_t coordOffsets[3], colorOffsets[3];
+            EPlyType coordTypes[3], colorTypes[3];
+            for(int k = 0; k < 3; ++k)
+            {
+                coordOffsets[k] = element.getPropertyOffset(coordIds[k]);
+                coordTypes[k] = element.properties[coordIds[k]].type;
+                if(useColors)
+                {
+                    colorOffsets[k] = element.getPropertyOffset(colorIds[k]);
+                    colorTypes[k] = element.properties[colorIds[k]].type;
+                }
+            }
+
+            const int nbPts = element.count;
+            pts->resize(nbPts);
+            if(useColors)
+                _colors.resize(nbPts);
+
+            for(int begin = 0; begin < nbPts; begin += PLY_CHUNK_ELEMENTS)
+            {
+                const int end = std::min(begin + PLY_CHUNK_ELEMENTS, nbPts);
+                const char* data = reader.read((end - begin) * recordSize);
+
+                #pragma omp parallel for
+                for(int i = begin; i < end; ++i)
+                {
+                    const char* vertex = data + (i - begin) * recordSize;
+                    Point3d& p = (*pts)[i];
+                    p.x = readPlyValue(coordTypes[0], vertex + coordOffsets[0]);
+                    p.y = readPlyValue(coordTypes[1], vertex + coordOffsets[1]);
+                    p.z = readPlyValue(coordTypes[2], vertex + coordOffsets[2]);
+                    if(useColors)
+                    {
+                        unsigned char col[3];
+                        for(int k = 0; k < 3; ++k)
+                        {
+                            const double c = readPlyValue(colorTypes[k], vertex + colorOffsets[k]);
+                            // the floating point colors are in [0, 1]
+                            col[k] = static_cast<unsigned char>((colorTypes[k] == EPlyType::FLOAT32 || colorTypes[k] == EPlyType::FLOAT64) ? c * 255.0 : c);
+                        }
+                        _colors[i] = rgb(col[0], col[1], col[2]);
+                    }
+                }
+            }
+        }
+        else if(element.name == "face" || recordSize == 0)
+        {
+            int indicesId = -1;
+            if(element.name == "face")
+            {
+                indicesId = element.findProperty("vertex_indices");
+                if(indicesId < 0)
+                    indicesId = element.findProperty("vertex_index");
+                if(indicesId < 0 || !element.properties[indicesId].isList)
+                    throw std::runtime_error("PLY faces without vertex_indices list: " + filename);
+                tris->reserve(element.count);
+            }
+
+            // the records have a variable size
+            std::vector<int> polygon;
+            for(std::size_t i = 0; i < element.count; ++i)
+            {
+                for(int propertyId = 0; propertyId < element.properties.size(); ++propertyId)
+                {
+                    const PlyProperty& property = element.properties[propertyId];
+                    std::size_t nbValues = 1;
+                    if(property.isList)
+                        nbValues = std::size_t(readPlyValue(property.countType, reader.read(getPlyTypeSize(property.countType))));
+                    const std::size_t valueSize = getPlyTypeSize(property.type);
+                    const char* values = reader.read(nbValues * valueSize);
+
+                    if(propertyId == indicesId)
+                    {
+                        polygon.resize(nbValues);
+                        for(std::size_t k = 0; k < nbValues; ++k)
+                            polygon[k] = int(readPlyValue(property.type, values + k * valueSize));
+                    }
+                }
+                if(indicesId < 0)
+                    continue;
+
+                // triangle fan
+                for(std::size_t k = 2; k < polygon.size(); ++k)
+                {
+                    Mesh::triangle t;
+                    t.v[0] = polygon[0];
+                    t.v[1] = polygon[k - 1];
+                    t.v[2] = polygon[k];
+                    t.alive = true;
+                    tris->push_back(t);
+                }
+            }
+        }
+        else
+        {
+            // unused element with a fixed size
+            for(std::size_t begin = 0; begin < element.count; begin += PLY_CHUNK_ELEMENTS)
+                reader.read((std::min(begin + PLY_CHUNK_ELEMENTS, element.count) - begin) * recordSize);
+        }
+    }
+
+    invalidateConnectivity();
+    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << pts->size() << "\n\t- # triangles: " << tris->size());
+    return !pts->empty() && !tris->empty();
+}
+
 void Mesh::addMesh(Mesh* me)
 {
     // initialize data members if required
@@ -151,6 +660,8 @@ void Mesh::addMesh(Mesh* me)
             ALICEVISION_LOG_WARNING("addMesh: bad triangle index: " << t.v[0] << " " << t.v[1] << " " << t.v[2] << ", npts: " << me->pts->size());
         }
     }
+
+    invalidateConnectivity();
 }
 
 Mesh::triangle_proj Mesh::getTriangleProjection(int triid, const mvsUtils::MultiViewParams* mp, int rc, int w, int h) const
@@ -213,98 +724,95 @@ int Mesh::getTriangleNbVertexInImage(const mvsUtils::MultiViewParams& mp, const
     return nbVertexInImage;
 }
 
-StaticVector<Point2d>* Mesh::getTrianglePixelIntersectionsAndInternalPoints(Mesh::triangle_proj* tp,
-                                                                               Mesh::rectangle* re)
+void Mesh::getTrianglePixelIntersectionsAndInternalPoints(StaticVector<Point2d>& out, Mesh::triangle_proj* tp, Mesh::rectangle* re)
 {
-    StaticVector<Point2d>* out = new StaticVector<Point2d>();
-    out->reserve(20);
+    out.clear();
+    out.reserve(20);
 
     if(isPointInTriangle(tp->tp2ds[0], tp->tp2ds[1], tp->tp2ds[2], re->P[0]))
     {
-        out->push_back(re->P[0]);
+        out.push_back(re->P[0]);
     }
     if(isPointInTriangle(tp->tp2ds[0], tp->tp2ds[1], tp->tp2ds[2], re->P[1]))
     {
-        out->push_back(re->P[1]);
+        out.push_back(re->P[1]);
     }
     if(isPointInTriangle(tp->tp2ds[0], tp->tp2ds[1], tp->tp2ds[2], re->P[2]))
     {
-        out->push_back(re->P[2]);
+        out.push_back(re->P[2]);
     }
     if(isPointInTriangle(tp->tp2ds[0], tp->tp2ds[1], tp->tp2ds[2], re->P[3]))
     {
-        out->push_back(re->P[3]);
+        out.push_back(re->P[3]);
     }
     if((isPointInTriangle(re->P[0], re->P[1], re->P[2], tp->tp2ds[0])) ||
        (isPointInTriangle(re->P[2], re->P[3], re->P[0], tp->tp2ds[0])))
     {
-        out->push_back(tp->tp2ds[0]);
+        out.push_back(tp->tp2ds[0]);
     }
     if((isPointInTriangle(re->P[0], re->P[1], re->P[2], tp->tp2ds[1])) ||
        (isPointInTriangle(re->P[2], re->P[3], re->P[0], tp->tp2ds[1])))
     {
-        out->push_back(tp->tp2ds[1]);
+        out.push_back(tp->tp2ds[1]);
     }
     if((isPointInTriangle(re->P[0], re->P[1], re->P[2], tp->tp2ds[2])) ||
        (isPointInTriangle(re->P[2], re->P[3], re->P[0], tp->tp2ds[2])))
     {
-        out->push_back(tp->tp2ds[2]);
+        out.push_back(tp->tp2ds[2]);
     }
 
     Point2d lli;
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[0], &tp->tp2ds[1], &re->P[0], &re->P[1]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[1], &tp->tp2ds[2], &re->P[0], &re->P[1]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[2], &tp->tp2ds[0], &re->P[0], &re->P[1]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
 
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[0], &tp->tp2ds[1], &re->P[1], &re->P[2]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[1], &tp->tp2ds[2], &re->P[1], &re->P[2]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[2], &tp->tp2ds[0], &re->P[1], &re->P[2]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
 
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[0], &tp->tp2ds[1], &re->P[2], &re->P[3]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[1], &tp->tp2ds[2], &re->P[2], &re->P[3]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[2], &tp->tp2ds[0], &re->P[2], &re->P[3]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
 
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[0], &tp->tp2ds[1], &re->P[3], &re->P[0]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[1], &tp->tp2ds[2], &re->P[3], &re->P[0]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
     if(lineSegmentsIntersect2DTest(&lli, &tp->tp2ds[2], &tp->tp2ds[0], &re->P[3], &re->P[0]))
     {
-        out->push_back(lli);
+        out.push_back(lli);
     }
-
-    return out;
 }
 
 StaticVector<Point3d>* Mesh::getTrianglePixelIntersectionsAndInternalPoints(const mvsUtils::MultiViewParams* mp, int idTri,
@@ -465,158 +973,199 @@ bool Mesh::doesTriangleIntersectsRectangle(Mesh::triangle_proj* tp, Mesh::rectan
     */
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getPtsNeighborTriangles() const
+const MeshAdjacency& Mesh::getPtsNeighTris() const
 {
-    // array of tuples <x: vertexIndex, y: triangleIndex, z: numberOfNeighbors>
-    StaticVector<Voxel> vertexNeighborhoodPairs;
-    vertexNeighborhoodPairs.reserve(tris->size() * 3);
-    for(int i = 0; i < tris->size(); ++i)
+    const int nbPts = pts->size();
+    const int nbTris = tris->size();
+    if(_isPtsNeighTrisValid && _ptsNeighTris.getNbElements() == nbPts && _ptsNeighTris.values.size() == 3 * std::size_t(nbTris))
+        return _ptsNeighTris;
+
+    _isPtsNeighPtsValid = false;
+
+    std::unique_ptr<std::atomic<int>[]> counts(new std::atomic<int>[nbPts]);
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+        counts[i].store(0, std::memory_order_relaxed);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
     {
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[0], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[1], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[2], i, 0));
+        for(int k = 0; k < 3; ++k)
+            counts[(*tris)[i].v[k]].fetch_add(1, std::memory_order_relaxed);
     }
-    qsort(&vertexNeighborhoodPairs[0], vertexNeighborhoodPairs.size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
 
-    int i = 0; // index of the unique pair of <vertex, neighborhood>
-    int j = 0; // index of the vertex
-    int k = 0; // number of neighbors
-    int firstid = 0;
-    while(i < vertexNeighborhoodPairs.size())
+    _ptsNeighTris.offsets.resize(nbPts + 1);
+    _ptsNeighTris.offsets[0] = 0;
+    for(int i = 0; i < nbPts; ++i)
     {
-        k++;
-        // (*vertexNeighborhoodPairs)[i].z = j;
-        if((i == vertexNeighborhoodPairs.size() - 1) || (vertexNeighborhoodPairs[i].x != vertexNeighborhoodPairs[i + 1].x))
-        {
-            vertexNeighborhoodPairs[firstid].z = k; // store the number of neighbors
-            ++j;
-            firstid = i + 1;
-            k = 0;
-        }
-        ++i;
+        _ptsNeighTris.offsets[i + 1] = _ptsNeighTris.offsets[i] + counts[i].load(std::memory_order_relaxed);
+        counts[i].store(0, std::memory_order_relaxed);
     }
-    int npts = j;
-
-    StaticVector<StaticVector<int>*>* out_ptsNeighTris = new StaticVector<StaticVector<int>*>();
-    out_ptsNeighTris->reserve(pts->size());
-    out_ptsNeighTris->resize_with(pts->size(), nullptr);
+    _ptsNeighTris.values.resize(_ptsNeighTris.offsets.back());
 
-    i = 0;
-    for(j = 0; j < npts; ++j)
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
     {
-        int middlePtId = vertexNeighborhoodPairs[i].x;
-        int nbNeighbors = vertexNeighborhoodPairs[i].z;
-        int i0 = i;
-        int i1 = i + nbNeighbors;
-        i = i1;
-
-        StaticVector<int>* triTmp = new StaticVector<int>();
-        triTmp->reserve(nbNeighbors);
-        for(int l = i0; l < i1; ++l)
+        for(int k = 0; k < 3; ++k)
         {
-            triTmp->push_back(vertexNeighborhoodPairs[l].y); // index of triangle
+            const int ptId = (*tris)[i].v[k];
+            _ptsNeighTris.values[_ptsNeighTris.offsets[ptId] + counts[ptId].fetch_add(1, std::memory_order_relaxed)] = i;
         }
-
-        (*out_ptsNeighTris)[middlePtId] = triTmp;
     }
 
-    return out_ptsNeighTris;
+    // the triangles are added in any order by the threads
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+        std::sort(_ptsNeighTris.values.begin() + _ptsNeighTris.offsets[i], _ptsNeighTris.values.begin() + _ptsNeighTris.offsets[i + 1]);
+
+    _isPtsNeighTrisValid = true;
+    return _ptsNeighTris;
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getPtsNeighPtsOrdered() const
+const MeshAdjacency& Mesh::getPtsNeighPts() const
 {
-    StaticVector<StaticVector<int>*>* ptsNeighborTriangles = getPtsNeighborTriangles();
+    const MeshAdjacency& ptsNeighTris = getPtsNeighTris();
+    if(_isPtsNeighPtsValid)
+        return _ptsNeighPts;
 
-    StaticVector<StaticVector<int>*>* out_ptsNeighPts = new StaticVector<StaticVector<int>*>();
-    out_ptsNeighPts->resize_with(pts->size(), nullptr);
+    const int nbPts = pts->size();
 
-    for(int middlePtId = 0; middlePtId < pts->size(); ++middlePtId)
-    {
-        StaticVector<int>* neighborTriangles = (*ptsNeighborTriangles)[middlePtId];
-        if((neighborTriangles == nullptr) || neighborTriangles->empty())
-            continue;
+    // each triangle adds at most one point to the path around the point: at most nbNeighTris + 1 neighbors
+    std::vector<int> nbNeighPts(nbPts, 0);
+    std::vector<int> neighPtsBuffer(ptsNeighTris.values.size() + nbPts);
 
-        StaticVector<int> vhid;
-        vhid.reserve(neighborTriangles->size() * 2);
-        int currentTriPtId = (*tris)[(*neighborTriangles)[0]].v[0];
-        int firstTriPtId = currentTriPtId;
-        vhid.push_back(currentTriPtId);
+    #pragma omp parallel
+    {
+        std::vector<int> neighborTriangles;
+        std::vector<int> vhid;
 
-        bool isThereTWithCurrentTriPtId = true;
-        while(!neighborTriangles->empty() && isThereTWithCurrentTriPtId)
+        #pragma omp for
+        for(int middlePtId = 0; middlePtId < nbPts; ++middlePtId)
         {
-            isThereTWithCurrentTriPtId = false;
+            if(ptsNeighTris.size(middlePtId) == 0)
+                continue;
+
+            neighborTriangles.assign(ptsNeighTris.begin(middlePtId), ptsNeighTris.end(middlePtId));
+            vhid.clear();
+
+            int currentTriPtId = (*tris)[neighborTriangles[0]].v[0];
+            const int firstTriPtId = currentTriPtId;
+            vhid.push_back(currentTriPtId);
 
-            // find triangle with middlePtId and currentTriPtId and get remaining point id
-            for(int n = 0; n < neighborTriangles->size(); ++n)
+            bool isThereTWithCurrentTriPtId = true;
+            while(!neighborTriangles.empty() && isThereTWithCurrentTriPtId)
             {
-                bool ok_middlePtId = false;
-                bool ok_actTriPtId = false;
-                int remainingPtId = -1; // remaining pt id
-                for(int k = 0; k < 3; ++k)
+                isThereTWithCurrentTriPtId = false;
+
+                // find triangle with middlePtId and currentTriPtId and get remaining point id
+                for(int n = 0; n < neighborTriangles.size(); ++n)
                 {
-                    int triPtId = (*tris)[(*neighborTriangles)[n]].v[k];
-                    double length = ((*pts)[middlePtId] - (*pts)[triPtId]).size();
-                    if((triPtId != middlePtId) && (triPtId != currentTriPtId) && (length > 0.0) && (!std::isnan(length)))
-                    {
-                        remainingPtId = triPtId;
-                    }
-                    if(triPtId == middlePtId)
+                    bool ok_middlePtId = false;
+                    bool ok_actTriPtId = false;
+                    int remainingPtId = -1; // remaining pt id
+                    for(int k = 0; k < 3; ++k)
                     {
-                        ok_middlePtId = true;
+                        int triPtId = (*tris)[neighborTriangles[n]].v[k];
+                        double length = ((*pts)[middlePtId] - (*pts)[triPtId]).size();
+                        if((triPtId != middlePtId) && (triPtId != currentTriPtId) && (length > 0.0) && (!std::isnan(length)))
+                        {
+                            remainingPtId = triPtId;
+                        }
+                        if(triPtId == middlePtId)
+                        {
+                            ok_middlePtId = true;
+                        }
+                        if(triPtId == currentTriPtId)
+                        {
+                            ok_actTriPtId = true;
+                        }
                     }
-                    if(triPtId == currentTriPtId)
+
+                    if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
                     {
-                        ok_actTriPtId = true;
+                        currentTriPtId = remainingPtId;
+                        neighborTriangles.erase(neighborTriangles.begin() + n);
+                        vhid.push_back(currentTriPtId);
+                        isThereTWithCurrentTriPtId = true; // we removed one, so we try again
+                        break;
                     }
                 }
-
-                if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
-                {
-                    currentTriPtId = remainingPtId;
-                    neighborTriangles->remove(n);
-                    vhid.push_back(currentTriPtId);
-                    isThereTWithCurrentTriPtId = true; // we removed one, so we try again
-                    break;
-                }
             }
-        }
 
-        if(!vhid.empty())
-        {
             if(currentTriPtId == firstTriPtId)
             {
-                vhid.pop(); // remove last ... which is first
+                vhid.pop_back(); // remove last ... which is first
             }
 
             // remove duplicates
-            StaticVector<int>* vhid1 = new StaticVector<int>();
-            vhid1->reserve(vhid.size());
-            for(int k1 = 0; k1 < vhid.size(); k1++)
+            int* neighPts = &neighPtsBuffer[ptsNeighTris.offsets[middlePtId] + middlePtId];
+            int nbNeighs = 0;
+            for(int ptId: vhid)
             {
-                if(vhid1->indexOf(vhid[k1]) == -1)
-                {
-                    vhid1->push_back(vhid[k1]);
-                }
+                if(std::find(neighPts, neighPts + nbNeighs, ptId) == neighPts + nbNeighs)
+                    neighPts[nbNeighs++] = ptId;
             }
-
-            (*out_ptsNeighPts)[middlePtId] = vhid1;
+            nbNeighPts[middlePtId] = nbNeighs;
         }
     }
 
-    deleteArrayOfArrays<int>(&ptsNeighborTriangles);
+    _ptsNeighPts.offsets.resize(nbPts + 1);
+    _ptsNeighPts.offsets[0] = 0;
+    for(int i = 0; i < nbPts; ++i)
+        _ptsNeighPts.offsets[i + 1] = _ptsNeighPts.offsets[i] + nbNeighPts[i];
+    _ptsNeighPts.values.resize(_ptsNeighPts.offsets.back());
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const auto neighPts = neighPtsBuffer.begin() + ptsNeighTris.offsets[i] + i;
+        std::copy(neighPts, neighPts + nbNeighPts[i], _ptsNeighPts.values.begin() + _ptsNeighPts.offsets[i]);
+    }
+
+    _isPtsNeighPtsValid = true;
+    return _ptsNeighPts;
+}
+
+void Mesh::invalidateConnectivity()
+{
+    _isPtsNeighTrisValid = false;
+    _isPtsNeighPtsValid = false;
+}
+
+/// copy the lists of a compressed sparse row array into arrays of arrays, nullptr for the empty lists
+static StaticVector<StaticVector<int>*>* toArrayOfArrays(const MeshAdjacency& adjacency)
+{
+    StaticVector<StaticVector<int>*>* out = new StaticVector<StaticVector<int>*>();
+    out->resize_with(adjacency.getNbElements(), nullptr);
+
+    #pragma omp parallel for
+    for(int i = 0; i < out->size(); ++i)
+    {
+        if(adjacency.size(i) == 0)
+            continue;
+        StaticVector<int>* list = new StaticVector<int>();
+        list->getDataWritable().assign(adjacency.begin(i), adjacency.end(i));
+        (*out)[i] = list;
+    }
+    return out;
+}
+
+StaticVector<StaticVector<int>*>* Mesh::getPtsNeighborTriangles() const
+{
+    return toArrayOfArrays(getPtsNeighTris());
+}
 
-    return out_ptsNeighPts;
+StaticVector<StaticVector<int>*>* Mesh::getPtsNeighPtsOrdered() const
+{
+    return toArrayOfArrays(getPtsNeighPts());
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getTrisMap(const mvsUtils::MultiViewParams* mp, int rc, int  /*scale*/, int w, int h)
+void Mesh::getTrisMap(TrisMap& out, MonotonicArena& arena, const mvsUtils::MultiViewParams* mp, int rc, int  /*scale*/, int w, int h)
 {
     long tstart = clock();
 
     ALICEVISION_LOG_INFO("getTrisMap.");
-    StaticVector<int>* nmap = new StaticVector<int>();
-    nmap->reserve(w * h);
-    nmap->resize_with(w * h, 0);
+    StaticVector<int> nmap(w * h, 0);
 
     long t1 = mvsUtils::initEstimate();
     for(int i = 0; i < tris->size(); i++)
@@ -632,7 +1181,7 @@ StaticVector<StaticVector<int>*>* Mesh::getTrisMap(const mvsUtils::MultiViewPara
                     Mesh::rectangle re = Mesh::rectangle(pix, 1);
                     if(doesTriangleIntersectsRectangle(&tp, &re))
                     {
-                        (*nmap)[pix.x * h + pix.y] += 1;
+                        nmap[pix.x * h + pix.y] += 1;
                     }
                 } // for y
             }     // for x
@@ -641,21 +1190,14 @@ StaticVector<StaticVector<int>*>* Mesh::getTrisMap(const mvsUtils::MultiViewPara
     } // for i ntris
     mvsUtils::finishEstimate();
 
-    // allocate
-    StaticVector<StaticVector<int>*>* tmp = new StaticVector<StaticVector<int>*>();
-    tmp->reserve(w * h);
-    tmp->resize_with(w * h, nullptr);
-    StaticVector<int>** ptmp = &(*tmp)[0];
+    // allocate the lists of the pixels in the arena
+    out.clear();
+    out.resize(w * h, StaticVector<int, ArenaAllocator<int>>(ArenaAllocator<int>(arena)));
     for(int i = 0; i < w * h; i++)
     {
-        if((*nmap)[i] > 0)
-        {
-            *ptmp = new StaticVector<int>();
-            (*ptmp)->reserve((*nmap)[i]);
-        }
-        ptmp++;
+        if(nmap[i] > 0)
+            out[i].reserve(nmap[i]);
     }
-    delete nmap;
 
     // fill
     t1 = mvsUtils::initEstimate();
@@ -672,7 +1214,7 @@ StaticVector<StaticVector<int>*>* Mesh::getTrisMap(const mvsUtils::MultiViewPara
                     Mesh::rectangle re = Mesh::rectangle(pix, 1);
                     if(doesTriangleIntersectsRectangle(&tp, &re))
                     {
-                        (*tmp)[pix.x * h + pix.y]->push_back(i);
+                        out[pix.x * h + pix.y].push_back(i);
                     }
                 } // for y
             }     // for x
@@ -682,19 +1224,15 @@ StaticVector<StaticVector<int>*>* Mesh::getTrisMap(const mvsUtils::MultiViewPara
     mvsUtils::finishEstimate();
 
     mvsUtils::printfElapsedTime(tstart);
-
-    return tmp;
 }
 
-StaticVector<StaticVector<int>*>* Mesh::getTrisMap(StaticVector<int>* visTris, const mvsUtils::MultiViewParams* mp, int rc,
-                                                      int  /*scale*/, int w, int h)
+void Mesh::getTrisMap(TrisMap& out, MonotonicArena& arena, StaticVector<int>* visTris, const mvsUtils::MultiViewParams* mp,
+                      int rc, int  /*scale*/, int w, int h)
 {
     long tstart = clock();
 
     ALICEVISION_LOG_INFO("getTrisMap.");
-    StaticVector<int>* nmap = new StaticVector<int>();
-    nmap->reserve(w * h);
-    nmap->resize_with(w * h, 0);
+    StaticVector<int> nmap(w * h, 0);
 
     long t1 = mvsUtils::initEstimate();
     for(int m = 0; m < visTris->size(); m++)
@@ -711,7 +1249,7 @@ StaticVector<StaticVector<int>*>* Mesh::getTrisMap(StaticVector<int>* visTris, c
                     Mesh::rectangle re = Mesh::rectangle(pix, 1);
                     if(doesTriangleIntersectsRectangle(&tp, &re))
                     {
-                        (*nmap)[pix.x * h + pix.y] += 1;
+                        nmap[pix.x * h + pix.y] += 1;
                     }
                 } // for y
             }     // for x
@@ -720,21 +1258,14 @@ StaticVector<StaticVector<int>*>* Mesh::getTrisMap(StaticVector<int>* visTris, c
     } // for i ntris
     mvsUtils::finishEstimate();
 
-    // allocate
-    StaticVector<StaticVector<int>*>* tmp = new StaticVector<StaticVector<int>*>();
-    tmp->reserve(w * h);
-    tmp->resize_with(w * h, nullptr);
-    StaticVector<int>** ptmp = &(*tmp)[0];
+    // allocate the lists of the pixels in the arena
+    out.clear();
+    out.resize(w * h, StaticVector<int, ArenaAllocator<int>>(ArenaAllocator<int>(arena)));
     for(int i = 0; i < w * h; i++)
     {
-        if((*nmap)[i] > 0)
-        {
-            *ptmp = new StaticVector<int>();
-            (*ptmp)->reserve((*nmap)[i]);
-        }
-        ptmp++;
+        if(nmap[i] > 0)
+            out[i].reserve(nmap[i]);
     }
-    delete nmap;
 
     // fill
     t1 = mvsUtils::initEstimate();
@@ -752,7 +1283,7 @@ StaticVector<StaticVector<int>*>* Mesh::getTrisMap(StaticVector<int>* visTris, c
                     Mesh::rectangle re = Mesh::rectangle(pix, 1);
                     if(doesTriangleIntersectsRectangle(&tp, &re))
                     {
-                        (*tmp)[pix.x * h + pix.y]->push_back(i);
+                        out[pix.x * h + pix.y].push_back(i);
                     }
                 } // for y
             }     // for x
@@ -762,30 +1293,32 @@ StaticVector<StaticVector<int>*>* Mesh::getTrisMap(StaticVector<int>* visTris, c
     mvsUtils::finishEstimate();
 
     mvsUtils::printfElapsedTime(tstart);
-
-    return tmp;
 }
 
 void Mesh::getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h)
 {
-    StaticVector<StaticVector<int>*>* tmp = getTrisMap(mp, rc, scale, w, h);
-    getDepthMap(depthMap, tmp, mp, rc, scale, w, h);
-    deleteArrayOfArrays<int>(&tmp);
+    MonotonicArena arena;
+    TrisMap trisMap;
+    getTrisMap(trisMap, arena, mp, rc, scale, w, h);
+    getDepthMap(depthMap, trisMap, mp, rc, scale, w, h);
 }
 
-void Mesh::getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<int>*>* tmp, const mvsUtils::MultiViewParams* mp,
+void Mesh::getDepthMap(StaticVector<float>* depthMap, const TrisMap& trisMap, const mvsUtils::MultiViewParams* mp,
                           int rc, int scale, int w, int h)
 {
     depthMap->resize_with(w * h, -1.0f);
 
+    // intersections of the current triangle and pixel, reused over the pixels
+    StaticVector<Point2d> tpis;
+
     Pixel pix;
     for(pix.x = 0; pix.x < w; pix.x++)
     {
         for(pix.y = 0; pix.y < h; pix.y++)
         {
 
-            StaticVector<int>* ti = (*tmp)[pix.x * h + pix.y];
-            if((ti != nullptr) && (ti->size() > 0))
+            const StaticVector<int, ArenaAllocator<int>>& ti = trisMap[pix.x * h + pix.y];
+            if(!ti.empty())
             {
                 Point2d p;
                 p.x = (double)pix.x;
@@ -793,9 +1326,9 @@ void Mesh::getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<
 
                 double mindepth = 10000000.0;
 
-                for(int i = 0; i < ti->size(); i++)
+                for(int i = 0; i < ti.size(); i++)
                 {
-                    int idTri = (*ti)[i];
+                    int idTri = ti[i];
                     OrientedPoint tri;
                     tri.p = (*pts)[(*tris)[idTri].v[0]];
                     tri.n = cross(((*pts)[(*tris)[idTri].v[1]] - (*pts)[(*tris)[idTri].v[0]]).normalize(),
@@ -822,13 +1355,13 @@ void Mesh::getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<
                     }
                     */
 
-                    StaticVector<Point2d>* tpis = getTrianglePixelIntersectionsAndInternalPoints(&tp, &re);
+                    getTrianglePixelIntersectionsAndInternalPoints(tpis, &tp, &re);
 
                     double maxd = -1.0;
-                    for(int k = 0; k < tpis->size(); k++)
+                    for(int k = 0; k < tpis.size(); k++)
                     {
                         Point3d lpi = linePlaneIntersect(
-                            mp->CArr[rc], (mp->iCamArr[rc] * ((*tpis)[k] * (float)scale)).normalize(), tri.p, tri.n);
+                            mp->CArr[rc], (mp->iCamArr[rc] * (tpis[k] * (float)scale)).normalize(), tri.p, tri.n);
                         if(!std::isnan(angleBetwV1andV2((mp->CArr[rc] - tri.p).normalize(), tri.n)))
                         {
                             maxd = std::max(maxd, (mp->CArr[rc] - lpi).size());
@@ -864,7 +1397,6 @@ void Mesh::getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<
                     }
                     mindepth = std::min(mindepth, maxd);
 
-                    delete tpis;
                 }
 
                 /*
@@ -1193,25 +1725,29 @@ void Mesh::getNotOrientedEdges(StaticVector<StaticVector<int>*>** edgesNeighTris
     delete edges;
 }
 
-StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVector<int>*>* ptsNeighPts,
+StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(const MeshAdjacency& ptsNeighPts,
                                                              double maximalNeighDist)
 {
     StaticVector<Point3d>* nms = new StaticVector<Point3d>();
-    nms->reserve(pts->size());
+    getLaplacianSmoothingVectors(ptsNeighPts, nms->getDataWritable(), maximalNeighDist);
+    return nms;
+}
+
+void Mesh::getLaplacianSmoothingVectors(const MeshAdjacency& ptsNeighPts, std::vector<Point3d>& out_nms,
+                                        double maximalNeighDist) const
+{
+    std::vector<Point3d>& nms = out_nms;
+    nms.resize(pts->size());
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
         Point3d p = (*pts)[i];
-        StaticVector<int>* nei = (*ptsNeighPts)[i];
-        int nneighs = 0;
-        if(nei != nullptr)
-        {
-            nneighs = nei->size();
-        }
+        const int nneighs = ptsNeighPts.size(i);
 
         if(nneighs == 0)
         {
-            nms->push_back(Point3d(0.0, 0.0, 0.0));
+            nms[i] = Point3d(0.0, 0.0, 0.0);
         }
         else
         {
@@ -1220,8 +1756,8 @@ StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVec
             Point3d n = Point3d(0.0, 0.0, 0.0);
             for(int j = 0; j < nneighs; j++)
             {
-                n = n + (*pts)[(*nei)[j]];
-                maxNeighDist = std::max(maxNeighDist, (p - (*pts)[(*nei)[j]]).size());
+                n = n + (*pts)[ptsNeighPts(i, j)];
+                maxNeighDist = std::max(maxNeighDist, (p - (*pts)[ptsNeighPts(i, j)]).size());
             }
             n = ((n / (float)nneighs) - p);
 
@@ -1249,34 +1785,36 @@ StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVec
                 n = Point3d(0.0, 0.0, 0.0);
             }
 
-            nms->push_back(n);
+            nms[i] = n;
         }
     }
-
-    return nms;
 }
 
 void Mesh::laplacianSmoothPts(float maximalNeighDist)
 {
-    StaticVector<StaticVector<int>*>* ptsNei = getPtsNeighPtsOrdered();
-    laplacianSmoothPts(ptsNei, maximalNeighDist);
-    deleteArrayOfArrays<int>(&ptsNei);
+    laplacianSmoothPts(getPtsNeighPts(), maximalNeighDist);
+}
+
+void Mesh::laplacianSmoothPts(const MeshAdjacency& ptsNeighPts, double maximalNeighDist)
+{
+    std::vector<Point3d> nms;
+    laplacianSmoothPts(ptsNeighPts, nms, maximalNeighDist);
 }
 
-void Mesh::laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist)
+void Mesh::laplacianSmoothPts(const MeshAdjacency& ptsNeighPts, std::vector<Point3d>& buffer, double maximalNeighDist)
 {
-    StaticVector<Point3d>* nms = getLaplacianSmoothingVectors(ptsNeighPts, maximalNeighDist);
+    // the smoothing vectors of all the points are computed before moving them
+    getLaplacianSmoothingVectors(ptsNeighPts, buffer, maximalNeighDist);
 
     // smooth
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
-        (*pts)[i] = (*pts)[i] + (*nms)[i];
+        (*pts)[i] = (*pts)[i] + buffer[i];
     }
-
-    delete nms;
 }
 
-Point3d Mesh::computeTriangleNormal(int idTri)
+Point3d Mesh::computeTriangleNormal(int idTri) const
 {
     return cross(((*pts)[(*tris)[idTri].v[1]] - (*pts)[(*tris)[idTri].v[0]]).normalize(),
                  ((*pts)[(*tris)[idTri].v[2]] - (*pts)[(*tris)[idTri].v[0]]).normalize())
@@ -1304,28 +1842,32 @@ double Mesh::computeTriangleMinEdgeLength(int idTri) const
 
 StaticVector<Point3d>* Mesh::computeNormalsForPts()
 {
-    StaticVector<StaticVector<int>*>* ptsNeighTris = getPtsNeighborTriangles();
-    StaticVector<Point3d>* nms = computeNormalsForPts(ptsNeighTris);
-    deleteArrayOfArrays<int>(&ptsNeighTris);
-    return nms;
+    return computeNormalsForPts(getPtsNeighTris());
 }
 
-StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>*>* ptsNeighTris)
+StaticVector<Point3d>* Mesh::computeNormalsForPts(const MeshAdjacency& ptsNeighTris)
 {
     StaticVector<Point3d>* nms = new StaticVector<Point3d>();
-    nms->reserve(pts->size());
-    nms->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.0f));
+    computeNormalsForPts(ptsNeighTris, nms->getDataWritable());
+    return nms;
+}
+
+void Mesh::computeNormalsForPts(const MeshAdjacency& ptsNeighTris, std::vector<Point3d>& out_nms) const
+{
+    std::vector<Point3d>& nms = out_nms;
+    nms.resize(pts->size());
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
-        StaticVector<int>* triTmp = (*ptsNeighTris)[i];
-        if((triTmp != nullptr) && (triTmp->size() > 0))
+        nms[i] = Point3d(0.0f, 0.0f, 0.0f);
+        if(ptsNeighTris.size(i) > 0)
         {
             Point3d n = Point3d(0.0f, 0.0f, 0.0f);
             float nn = 0.0f;
-            for(int j = 0; j < triTmp->size(); j++)
+            for(int j = 0; j < ptsNeighTris.size(i); j++)
             {
-                Point3d n1 = computeTriangleNormal((*triTmp)[j]);
+                Point3d n1 = computeTriangleNormal(ptsNeighTris(i, j));
                 n1 = n1.normalize();
                 if(std::isnan(n1.x) || std::isnan(n1.y) || std::isnan(n1.z) || (n1.x != n1.x) || (n1.y != n1.y) ||
                    (n1.z != n1.z)) // check if is not NaN
@@ -1334,7 +1876,7 @@ StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>
                 }
                 else
                 {
-                    n = n + computeTriangleNormal((*triTmp)[j]);
+                    n = n + computeTriangleNormal(ptsNeighTris(i, j));
                     nn += 1.0f;
                 }
             }
@@ -1347,42 +1889,42 @@ StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>
                 n = Point3d(0.0f, 0.0f, 0.0f);
             }
 
-            (*nms)[i] = n;
+            nms[i] = n;
         }
     }
+}
 
-    return nms;
+void Mesh::smoothNormals(StaticVector<Point3d>* nms, const MeshAdjacency& ptsNeighPts)
+{
+    std::vector<Point3d> buffer;
+    smoothNormals(nms->getDataWritable(), buffer, ptsNeighPts);
 }
 
-void Mesh::smoothNormals(StaticVector<Point3d>* nms, StaticVector<StaticVector<int>*>* ptsNeighPts)
+void Mesh::smoothNormals(std::vector<Point3d>& nms, std::vector<Point3d>& buffer, const MeshAdjacency& ptsNeighPts) const
 {
-    StaticVector<Point3d>* nmss = new StaticVector<Point3d>();
-    nmss->reserve(pts->size());
-    nmss->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.0f));
+    buffer.resize(pts->size());
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
-        Point3d n = (*nms)[i];
-        for(int j = 0; j < sizeOfStaticVector<int>((*ptsNeighPts)[i]); j++)
+        Point3d n = nms[i];
+        for(int j = 0; j < ptsNeighPts.size(i); j++)
         {
-            n = n + (*nms)[(*(*ptsNeighPts)[i])[j]];
+            n = n + nms[ptsNeighPts(i, j)];
         }
-        if(sizeOfStaticVector<int>((*ptsNeighPts)[i]) > 0)
+        if(ptsNeighPts.size(i) > 0)
         {
-            n = n / (float)sizeOfStaticVector<int>((*ptsNeighPts)[i]);
+            n = n / (float)ptsNeighPts.size(i);
         }
         n = n.normalize();
         if(std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (n.x != n.x) || (n.y != n.y) || (n.z != n.z))
         {
             n = Point3d(0.0f, 0.0f, 0.0f);
         }
-        (*nmss)[i] = n;
+        buffer[i] = n;
     }
-    for(int i = 0; i < pts->size(); i++)
-    {
-        (*nms)[i] = (*nmss)[i];
-    }
-    delete nmss;
+    // the smoothed normals are in the buffer, the buffer gets the previous normals
+    std::swap(nms, buffer);
 }
 
 void Mesh::removeFreePointsFromMesh(StaticVector<int>** out_ptIdToNewPtId)
@@ -1404,6 +1946,8 @@ void Mesh::removeFreePointsFromMesh(StaticVector<int>** out_ptIdToNewPtId)
     std::swap(cleanedMesh->_colors, _colors);
 
     delete cleanedMesh;
+
+    invalidateConnectivity();
 }
 
 double Mesh::computeTriangleProjectionArea(const triangle_proj& tp) const
@@ -1596,9 +2140,9 @@ void Mesh::subdivideMeshCase3(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdE
     }
 }
 
-void Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, std::string tmpDir, int maxMeshPts)
+void Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, int maxMeshPts)
 {
-    StaticVector<StaticVector<int>*>* trisCams = computeTrisCams(mp, tmpDir);
+    StaticVector<StaticVector<int>*>* trisCams = computeTrisCams(*this, *mp);
     StaticVector<StaticVector<int>*>* trisCams1 = subdivideMesh(mp, maxTriArea, 0.0f, true, trisCams, maxMeshPts);
     deleteArrayOfArrays<int>(&trisCams);
     deleteArrayOfArrays<int>(&trisCams1);
@@ -1937,6 +2481,8 @@ int Mesh::subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, f
     delete trisToSubdivide;
     delete edgesToSubdivide;
 
+    invalidateConnectivity();
+
     return nTrisToSubdivide;
 }
 
@@ -1971,69 +2517,8 @@ void Mesh::letJustTringlesIdsInMesh(StaticVector<int>* trisIdsToStay)
 
     delete tris;
     tris = trisTmp;
-}
-
-StaticVector<StaticVector<int>*>* Mesh::computeTrisCams(const mvsUtils::MultiViewParams* mp, std::string tmpDir)
-{
-    if(mp->verbose)
-        ALICEVISION_LOG_DEBUG("Computing tris cams.");
-
-    StaticVector<int>* ntrisCams = new StaticVector<int>();
-    ntrisCams->reserve(tris->size());
-    ntrisCams->resize_with(tris->size(), 0);
-
-    long t1 = mvsUtils::initEstimate();
-    for(int rc = 0; rc < mp->ncams; ++rc)
-    {
-        std::string visTrisFileName = tmpDir + "visTris" + std::to_string(mp->getViewId(rc)) + ".bin";
-        StaticVector<int>* visTris = loadArrayFromFile<int>(visTrisFileName);
-        if(visTris != nullptr)
-        {
-            for(int i = 0; i < visTris->size(); ++i)
-            {
-                int idTri = (*visTris)[i];
-                (*ntrisCams)[idTri]++;
-            }
-            delete visTris;
-        }
-        mvsUtils::printfEstimate(rc, mp->ncams, t1);
-    }
-    mvsUtils::finishEstimate();
-
-    StaticVector<StaticVector<int>*>* trisCams = new StaticVector<StaticVector<int>*>();
-    trisCams->reserve(tris->size());
-
-    for(int i = 0; i < tris->size(); ++i)
-    {
-        StaticVector<int>* cams = nullptr;
-        if((*ntrisCams)[i] > 0)
-        {
-            cams = new StaticVector<int>();
-            cams->reserve((*ntrisCams)[i]);
-        }
-        trisCams->push_back(cams);
-    }
 
-    t1 = mvsUtils::initEstimate();
-    for(int rc = 0; rc < mp->ncams; ++rc)
-    {
-        std::string visTrisFileName = tmpDir + "visTris" + std::to_string(mp->getViewId(rc)) + ".bin";
-        StaticVector<int>* visTris = loadArrayFromFile<int>(visTrisFileName);
-        if(visTris != nullptr)
-        {
-            for(int i = 0; i < visTris->size(); ++i)
-            {
-                int idTri = (*visTris)[i];
-                (*trisCams)[idTri]->push_back(rc);
-            }
-            delete visTris;
-        }
-        mvsUtils::printfEstimate(rc, mp->ncams, t1);
-    }
-    mvsUtils::finishEstimate();
-
-    delete ntrisCams;
-    return trisCams;
+    invalidateConnectivity();
 }
 
 StaticVector<StaticVector<int>*>* Mesh::computeTrisCamsFromPtsCams(StaticVector<StaticVector<int>*>* ptsCams) const
@@ -2249,6 +2734,8 @@ void Mesh::invertTriangleOrientations()
         Mesh::triangle& t = (*tris)[i];
         std::swap(t.v[1], t.v[2]);
     }
+
+    invalidateConnectivity();
 }
 
 void Mesh::changeTriPtId(int triId, int oldPtId, int newPtId)
@@ -2260,6 +2747,8 @@ void Mesh::changeTriPtId(int triId, int oldPtId, int newPtId)
             (*tris)[triId].v[k] = newPtId;
         }
     }
+
+    invalidateConnectivity();
 }
 
 int Mesh::getTriPtIndex(int triId, int ptId, bool failIfDoesNotExists) const
@@ -2327,7 +2816,7 @@ bool Mesh::isTriangleObtuse(int triId) const
 
 StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds() const
 {
-    StaticVector<StaticVector<int>*>* ptsNeighPtsOrdered = getPtsNeighPtsOrdered();
+    const MeshAdjacency& ptsNeighPts = getPtsNeighPts();
 
     StaticVector<int>* colorLabels = new StaticVector<int>();
     colorLabels->reserve(pts->size());
@@ -2359,13 +2848,12 @@ StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds() const
                 {
                     delete colorLabels;
                     delete buff;
-                    deleteArrayOfArrays<int>(&ptsNeighPtsOrdered);
                     throw std::runtime_error("getLargestConnectedComponentTrisIds: bad condition.");
                 }
             }
-            for(int j = 0; j < sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[ptid]); ++j)
+            for(int j = 0; j < ptsNeighPts.size(ptid); ++j)
             {
-                int nptid = (*(*ptsNeighPtsOrdered)[ptid])[j];
+                int nptid = ptsNeighPts(ptid, j);
                 if((nptid > -1) && ((*colorLabels)[nptid] == -1))
                 {
                     if(buff->size() >= buff->capacity()) // should not happen but no problem
@@ -2401,279 +2889,440 @@ StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds() const
 
     delete colorLabels;
     delete buff;
-    deleteArrayOfArrays<int>(&ptsNeighPtsOrdered);
 
     return out;
 }
 
+namespace {
+
+/// number of non-overlapping occurrences of val in the null-terminated line, as mvsUtils::findNSubstrsInString
+int findNSubstrsInLine(const char* line, const char* val)
+{
+    const std::size_t length = std::strlen(val);
+    int n = 0;
+    for(const char* pos = std::strstr(line, val); pos != nullptr; pos = std::strstr(pos + length, val))
+        ++n;
+    return n;
+}
+
+enum class EObjLine
+{
+    IGNORED,
+    MATERIAL,
+    VERTEX,
+    NORMAL,
+    UV,
+    FACET
+};
+
+EObjLine getObjLineType(const char* line, std::size_t length)
+{
+    if(length < 3 || line[0] == '#')
+        return EObjLine::IGNORED;
+    if(findNSubstrsInLine(line, "usemtl") == 1)
+        return EObjLine::MATERIAL;
+    if((line[0] == 'v') && (line[1] == ' '))
+        return EObjLine::VERTEX;
+    if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
+        return EObjLine::NORMAL;
+    if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
+        return EObjLine::UV;
+    if((line[0] == 'f') && (line[1] == ' '))
+        return EObjLine::FACET;
+    return EObjLine::IGNORED;
+}
+
+/// @return the number of triangles of the facet line: 1 for a triangle, 2 for a quad, 0 if the syntax is unknown
+int getObjFacetTriangles(const char* line, bool& withUV, bool& withNormal)
+{
+    const int n1 = findNSubstrsInLine(line, "/");
+    const int n2 = findNSubstrsInLine(line, "//");
+    if(n2 == 0)
+    {
+        withUV = (n1 == 3) || (n1 == 4) || (n1 == 6) || (n1 == 8);
+        withNormal = (n1 == 6) || (n1 == 8);
+        if((n1 == 0) || (n1 == 3) || (n1 == 6))
+            return 1;
+        if((n1 == 4) || (n1 == 8))
+            return 2;
+        return 0;
+    }
+    withUV = false;
+    withNormal = true;
+    if(n2 == 3)
+        return 1;
+    if(n2 == 4)
+        return 2;
+    return 0;
+}
+
+/// consecutive lines of an OBJ file, parsed by one thread
+struct ObjChunk
+{
+    /// range of the chunk in the file buffer
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    /// number of '.' on the first vertex line, -1 if the chunk has no vertex
+    int firstVertexDots = -1;
+    bool hasUnknownFacet = false;
+
+    /// number of elements in the chunk
+    int nbPts = 0;
+    int nbNormals = 0;
+    int nbUvs = 0;
+    int nbTris = 0;
+    int nbTrisUvs = 0;
+    int nbTrisNormals = 0;
+
+    /// index of the first element of the chunk in the mesh arrays
+    int ptsOffset = 0;
+    int normalsOffset = 0;
+    int uvsOffset = 0;
+    int trisOffset = 0;
+    int trisUvsOffset = 0;
+    int trisNormalsOffset = 0;
+
+    /// materials of the usemtl lines, in order, and their ids
+    std::vector<std::string> materials;
+    std::vector<int> materialIds;
+    /// material of the triangles before the first usemtl line of the chunk
+    int initialMtlId = -1;
+};
+
+/// size of the chunks of an OBJ file parsed in parallel
+const std::size_t OBJ_CHUNK_SIZE = 4 * 1024 * 1024;
+
+} // namespace
+
 bool Mesh::loadFromObjAscii(int& nmtls, StaticVector<int>& trisMtlIds, StaticVector<Point3d>& normals,
                                StaticVector<Voxel>& trisNormalsIds, StaticVector<Point2d>& uvCoords,
                                StaticVector<Voxel>& trisUvIds, std::string objAsciiFileName)
 {
     ALICEVISION_LOG_INFO("Loading mesh from obj file: " << objAsciiFileName);
-    // read number of points, triangles, uvcoords
-    int npts = 0;
-    int ntris = 0;
-    int nuvs = 0;
-    int nnorms = 0;
-    int nlines = 0;
-    bool useColors = false;
 
+    // the whole file is read, then the lines end with '\0' to be parsed in place
+    std::vector<char> buffer;
+    {
+        std::ifstream in(objAsciiFileName.c_str(), std::ios::binary | std::ios::ate);
+        if(in.is_open())
+        {
+            const std::streamsize size = in.tellg();
+            in.seekg(0);
+            buffer.resize(size + 1);
+            in.read(buffer.data(), size);
+        }
+        else
+        {
+            buffer.resize(1);
+        }
+        buffer.back() = '\0';
+    }
+    const std::size_t fileSize = buffer.size() - 1;
+
+    // chunks starting at the beginning of a line
+    std::vector<ObjChunk> chunks;
+    for(std::size_t begin = 0; begin < fileSize;)
     {
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
-        while(getline(in, line))
+        std::size_t end = std::min(begin + OBJ_CHUNK_SIZE, fileSize);
+        if(end < fileSize)
         {
-            if((line[0] == 'v') && (line[1] == ' '))
+            const char* eol = static_cast<const char*>(std::memchr(&buffer[end], '\n', fileSize - end));
+            end = (eol == nullptr) ? fileSize : (eol - buffer.data()) + 1;
+        }
+        ObjChunk chunk;
+        chunk.begin = begin;
+        chunk.end = end;
+        chunks.push_back(chunk);
+        begin = end;
+    }
+
+    // count the elements of each chunk
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0; c < chunks.size(); ++c)
+    {
+        ObjChunk& chunk = chunks[c];
+        for(std::size_t lineBegin = chunk.begin; lineBegin < chunk.end;)
+        {
+            char* line = &buffer[lineBegin];
+            char* eol = static_cast<char*>(std::memchr(line, '\n', chunk.end - lineBegin));
+            if(eol == nullptr)
+                eol = &buffer[chunk.end]; // last line of the file, followed by '\0'
+            *eol = '\0';
+            const std::size_t length = eol - line;
+            lineBegin += length + 1;
+
+            switch(getObjLineType(line, length))
             {
-                if(npts == 0)
+                case EObjLine::MATERIAL:
                 {
-                  useColors = mvsUtils::findNSubstrsInString(line, ".") == 6;
+                    char buff[5000];
+                    buff[0] = '\0';
+                    sscanf(line, "usemtl %4999s", buff);
+                    chunk.materials.emplace_back(buff);
+                    break;
                 }
-                npts += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                nnorms += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                nuvs += 1;
-            }
-            if((line[0] == 'f') && (line[1] == ' '))
-            {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                if((n1 == 3 && n2 == 0) || 
-                   (n1 == 6 && n2 == 0) ||
-                   (n1 == 0 && n2 == 3) ||
-                   (n1 == 0 && n2 == 0))
-                    ntris += 1;
-                else if((n1 == 4 && n2 == 0) ||
-                        (n1 == 8 && n2 == 0) ||
-                        (n1 == 0 && n2 == 4))
-                    ntris += 2;
+                case EObjLine::VERTEX:
+                    if(chunk.nbPts == 0)
+                        chunk.firstVertexDots = findNSubstrsInLine(line, ".");
+                    ++chunk.nbPts;
+                    break;
+                case EObjLine::NORMAL:
+                    ++chunk.nbNormals;
+                    break;
+                case EObjLine::UV:
+                    ++chunk.nbUvs;
+                    break;
+                case EObjLine::FACET:
+                {
+                    bool withUV, withNormal;
+                    const int nbTris = getObjFacetTriangles(line, withUV, withNormal);
+                    chunk.hasUnknownFacet |= (nbTris == 0);
+                    chunk.nbTris += nbTris;
+                    chunk.nbTrisUvs += withUV ? nbTris : 0;
+                    chunk.nbTrisNormals += withNormal ? nbTris : 0;
+                    break;
+                }
+                case EObjLine::IGNORED:
+                    break;
             }
-            nlines++;
         }
-        in.close();
     }
 
+    // offsets of the chunks in the arrays, the materials ids in the order of the file
+    bool useColors = false;
+    bool isColorsSet = false;
+    int npts = 0;
+    int ntris = 0;
+    int nuvs = 0;
+    int nnorms = 0;
+    int ntrisUvs = trisUvIds.size();
+    int ntrisNormals = trisNormalsIds.size();
+    const int normalsBegin = normals.size();
+    const int uvsBegin = uvCoords.size();
+    const int trisMtlBegin = trisMtlIds.size();
+    std::map<std::string, int> materialCache;
+    int mtlId = -1;
+    for(ObjChunk& chunk : chunks)
+    {
+        if(chunk.hasUnknownFacet)
+            throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file: " + objAsciiFileName);
+        if(!isColorsSet && chunk.firstVertexDots >= 0)
+        {
+            useColors = (chunk.firstVertexDots == 6);
+            isColorsSet = true;
+        }
+        chunk.ptsOffset = npts;
+        chunk.normalsOffset = normalsBegin + nnorms;
+        chunk.uvsOffset = uvsBegin + nuvs;
+        chunk.trisOffset = ntris;
+        chunk.trisUvsOffset = ntrisUvs;
+        chunk.trisNormalsOffset = ntrisNormals;
+        npts += chunk.nbPts;
+        nnorms += chunk.nbNormals;
+        nuvs += chunk.nbUvs;
+        ntris += chunk.nbTris;
+        ntrisUvs += chunk.nbTrisUvs;
+        ntrisNormals += chunk.nbTrisNormals;
+
+        chunk.initialMtlId = mtlId;
+        for(const std::string& material : chunk.materials)
+        {
+            auto it = materialCache.find(material);
+            if(it == materialCache.end())
+                materialCache.emplace(material, ++mtlId); // new material
+            else
+                mtlId = it->second;                       // already known material
+            chunk.materialIds.push_back(mtlId);
+        }
+    }
+    nmtls = materialCache.size();
+
     ALICEVISION_LOG_INFO("\t- # vertices: " << npts << std::endl
       << "\t- # normals: " << nnorms << std::endl
       << "\t- # uv coordinates: " << nuvs << std::endl
       << "\t- # triangles: " << ntris);
 
     pts = new StaticVector<Point3d>();
-    pts->reserve(npts);
+    pts->resize(npts);
     tris = new StaticVector<Mesh::triangle>();
-    tris->reserve(ntris);
-    uvCoords.reserve(nuvs);
-    trisUvIds.reserve(ntris);
-    normals.reserve(nnorms);
-    trisNormalsIds.reserve(ntris);
-    trisMtlIds.reserve(ntris);
+    tris->resize(ntris);
+    uvCoords.resize(uvsBegin + nuvs);
+    trisUvIds.resize(ntrisUvs);
+    normals.resize(normalsBegin + nnorms);
+    trisNormalsIds.resize(ntrisNormals);
+    trisMtlIds.resize(trisMtlBegin + ntris);
     if(useColors)
     {
-        _colors.reserve(npts);
+        _colors.resize(npts);
     }
 
-    std::map<std::string, int> materialCache;
-
+    // parse the lines of each chunk into its part of the arrays
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0; c < chunks.size(); ++c)
     {
-        int mtlId = -1;
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
+        const ObjChunk& chunk = chunks[c];
+        int ptId = chunk.ptsOffset;
+        int normalId = chunk.normalsOffset;
+        int uvId = chunk.uvsOffset;
+        int triId = chunk.trisOffset;
+        int triUvId = chunk.trisUvsOffset;
+        int triNormalId = chunk.trisNormalsOffset;
+        int chunkMtlId = chunk.initialMtlId;
+        int materialId = 0;
 
-        long t1 = mvsUtils::initEstimate();
-        int idline = 0;
-        while(getline(in, line))
+        for(std::size_t lineBegin = chunk.begin; lineBegin < chunk.end;)
         {
-            if(line.size() < 3 || line[0] == '#')
-            {
-                // nothing to do
-            }
-            else if(mvsUtils::findNSubstrsInString(line, "usemtl") == 1)
-            {
-                char buff[5000];
-                sscanf(line.c_str(), "usemtl %s", buff);
-                auto it = materialCache.find(buff);
-                if(it == materialCache.end())
-                    materialCache.emplace(buff, ++mtlId); // new material
-                else
-                    mtlId = it->second;                   // already known material
-            }
-            else if((line[0] == 'v') && (line[1] == ' '))
-            {
-                Point3d pt;
-                if(useColors)
-                {
-                    float r, g, b;
-                    sscanf(line.c_str(), "v %lf %lf %lf %f %f %f", &pt.x, &pt.y, &pt.z, &r, &g, &b);
-                    // convert float color data to uchar
-                    _colors.emplace_back(
-                      static_cast<unsigned char>(r*255.0f),
-                      static_cast<unsigned char>(g*255.0f),
-                      static_cast<unsigned char>(b*255.0f)
-                    );
-                }
-                else
-                {
-                    sscanf(line.c_str(), "v %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                }
-                pts->push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                Point3d pt;
-                sscanf(line.c_str(), "vn %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                // printf("%f %f %f\n", pt.x, pt.y, pt.z);
-                normals.push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                Point2d pt;
-                sscanf(line.c_str(), "vt %lf %lf", &pt.x, &pt.y);
-                uvCoords.push_back(pt);
-            }
-            else if((line[0] == 'f') && (line[1] == ' '))
+            const char* line = &buffer[lineBegin];
+            const std::size_t length = std::strlen(line);
+            lineBegin += length + 1;
+
+            switch(getObjLineType(line, length))
             {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                Voxel vertex, uvCoord, vertexNormal;
-                Voxel vertex2, uvCoord2, vertexNormal2;
-                bool ok = false;
-                bool withNormal = false;
-                bool withUV = false;
-                bool withQuad = false;
-                if(n2 == 0)
+                case EObjLine::MATERIAL:
+                    chunkMtlId = chunk.materialIds[materialId++];
+                    break;
+                case EObjLine::VERTEX:
                 {
-                    if(n1 == 0)
+                    Point3d& pt = (*pts)[ptId];
+                    if(useColors)
                     {
-                        sscanf(line.c_str(), "f %i %i %i", &vertex.x, &vertex.y, &vertex.z);
-                        ok = true;
+                        float r, g, b;
+                        sscanf(line, "v %lf %lf %lf %f %f %f", &pt.x, &pt.y, &pt.z, &r, &g, &b);
+                        // convert float color data to uchar
+                        _colors[ptId] = rgb(
+                          static_cast<unsigned char>(r*255.0f),
+                          static_cast<unsigned char>(g*255.0f),
+                          static_cast<unsigned char>(b*255.0f)
+                        );
                     }
-                    else if(n1 == 3)
+                    else
                     {
-                        sscanf(line.c_str(), "f %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z);
-                        ok = true;
-                        withUV = true;
+                        sscanf(line, "v %lf %lf %lf", &pt.x, &pt.y, &pt.z);
                     }
-                    else if(n1 == 6)
+                    ++ptId;
+                    break;
+                }
+                case EObjLine::NORMAL:
+                {
+                    Point3d& pt = normals[normalId++];
+                    sscanf(line, "vn %lf %lf %lf", &pt.x, &pt.y, &pt.z);
+                    break;
+                }
+                case EObjLine::UV:
+                {
+                    Point2d& pt = uvCoords[uvId++];
+                    sscanf(line, "vt %lf %lf", &pt.x, &pt.y);
+                    break;
+                }
+                case EObjLine::FACET:
+                {
+                    bool withUV, withNormal;
+                    const int nbTris = getObjFacetTriangles(line, withUV, withNormal);
+                    const bool withQuad = (nbTris == 2);
+                    const int n1 = findNSubstrsInLine(line, "/");
+                    const int n2 = findNSubstrsInLine(line, "//");
+                    Voxel vertex, uvCoord, vertexNormal;
+                    Voxel vertex2, uvCoord2, vertexNormal2;
+                    if(n2 == 0)
                     {
-                        sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i", &vertex.x, &uvCoord.x, &vertexNormal.x, &vertex.y, &uvCoord.y, &vertexNormal.y,
-                               &vertex.z, &uvCoord.z, &vertexNormal.z);
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
+                        if(n1 == 0)
+                        {
+                            sscanf(line, "f %i %i %i", &vertex.x, &vertex.y, &vertex.z);
+                        }
+                        else if(n1 == 3)
+                        {
+                            sscanf(line, "f %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z);
+                        }
+                        else if(n1 == 6)
+                        {
+                            sscanf(line, "f %i/%i/%i %i/%i/%i %i/%i/%i", &vertex.x, &uvCoord.x, &vertexNormal.x, &vertex.y, &uvCoord.y, &vertexNormal.y,
+                                   &vertex.z, &uvCoord.z, &vertexNormal.z);
+                        }
+                        else if(n1 == 4)
+                        {
+                            sscanf(line, "f %i/%i %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z, &vertex2.z, &uvCoord2.z);
+                        }
+                        else if(n1 == 8)
+                        {
+                            sscanf(line, "f %i/%i/%i %i/%i/%i %i/%i/%i %i/%i/%i",
+                                   &vertex.x, &uvCoord.x, &vertexNormal.x,
+                                   &vertex.y, &uvCoord.y, &vertexNormal.y,
+                                   &vertex.z, &uvCoord.z, &vertexNormal.z,
+                                   &vertex2.z, &uvCoord2.z, &vertexNormal2.z);
+                        }
                     }
-                    else if(n1 == 4)
+                    else
                     {
-                        sscanf(line.c_str(), "f %i/%i %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z, &vertex2.z, &uvCoord2.z);
-                        vertex2.x = vertex.x; // same first point
-                        uvCoord2.x = uvCoord.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        uvCoord2.y = uvCoord.z;
-                        ok = true;
-                        withUV = true;
-                        withQuad = true;
+                        if(n2 == 3)
+                        {
+                            sscanf(line, "f %i//%i %i//%i %i//%i", &vertex.x, &vertexNormal.x, &vertex.y, &vertexNormal.y, &vertex.z, &vertexNormal.z);
+                        }
+                        else if(n2 == 4)
+                        {
+                            sscanf(line, "f %i//%i %i//%i %i//%i %i//%i",
+                                   &vertex.x, &vertexNormal.x,
+                                   &vertex.y, &vertexNormal.y,
+                                   &vertex.z, &vertexNormal.z,
+                                   &vertex2.z, &vertexNormal2.z);
+                        }
                     }
-                    else if(n1 == 8)
+                    if(withQuad)
                     {
-                        sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i %i/%i/%i",
-                               &vertex.x, &uvCoord.x, &vertexNormal.x,
-                               &vertex.y, &uvCoord.y, &vertexNormal.y,
-                               &vertex.z, &uvCoord.z, &vertexNormal.z,
-                               &vertex2.z, &uvCoord2.z, &vertexNormal2.z);
                         vertex2.x = vertex.x; // same first point
                         uvCoord2.x = uvCoord.x;
                         vertexNormal2.x = vertexNormal.x;
                         vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
                         uvCoord2.y = uvCoord.z;
                         vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
-                        withQuad = true;
-                    }
-                }
-                else
-                {
-                    if(n2 == 3)
-                    {
-                        sscanf(line.c_str(), "f %i//%i %i//%i %i//%i", &vertex.x, &vertexNormal.x, &vertex.y, &vertexNormal.y, &vertex.z, &vertexNormal.z);
-                        ok = true;
-                        withNormal = true;
-                    }
-                    else if(n2 == 4)
-                    {
-                        sscanf(line.c_str(), "f %i//%i %i//%i %i//%i %i//%i",
-                               &vertex.x, &vertexNormal.x,
-                               &vertex.y, &vertexNormal.y,
-                               &vertex.z, &vertexNormal.z,
-                               &vertex2.z, &vertexNormal2.z);
-                        vertex2.x = vertex.x; // same first point
-                        vertexNormal2.x = vertexNormal.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withNormal = true;
-                        withQuad = true;
                     }
-                }
-                if(!ok)
-                {
-                    throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file: " + objAsciiFileName);
-                }
 
-                // 1st triangle
-                {
-                    triangle t;
-                    t.v[0] = vertex.x - 1;
-                    t.v[1] = vertex.y - 1;
-                    t.v[2] = vertex.z - 1;
-                    t.alive = true;
-                    tris->push_back(t);
-                    trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
+                    // 1st triangle
                     {
-                        trisNormalsIds.push_back(vertexNormal - Voxel(1, 1, 1));
+                        triangle& t = (*tris)[triId];
+                        t.v[0] = vertex.x - 1;
+                        t.v[1] = vertex.y - 1;
+                        t.v[2] = vertex.z - 1;
+                        t.alive = true;
+                        trisMtlIds[trisMtlBegin + triId] = chunkMtlId;
+                        ++triId;
+                        if(withUV)
+                        {
+                            trisUvIds[triUvId++] = uvCoord - Voxel(1, 1, 1);
+                        }
+                        if(withNormal)
+                        {
+                            trisNormalsIds[triNormalId++] = vertexNormal - Voxel(1, 1, 1);
+                        }
                     }
-                }
 
-                // potential 2nd triangle
-                if(withQuad)
-                {
-                    triangle t;
-                    t.v[0] = vertex2.x - 1;
-                    t.v[1] = vertex2.y - 1;
-                    t.v[2] = vertex2.z - 1;
-                    t.alive = true;
-                    tris->push_back(t);
-                    trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord2 - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
+                    // potential 2nd triangle
+                    if(withQuad)
                     {
-                        trisNormalsIds.push_back(vertexNormal2 - Voxel(1, 1, 1));
+                        triangle& t = (*tris)[triId];
+                        t.v[0] = vertex2.x - 1;
+                        t.v[1] = vertex2.y - 1;
+                        t.v[2] = vertex2.z - 1;
+                        t.alive = true;
+                        trisMtlIds[trisMtlBegin + triId] = chunkMtlId;
+                        ++triId;
+                        if(withUV)
+                        {
+                            trisUvIds[triUvId++] = uvCoord2 - Voxel(1, 1, 1);
+                        }
+                        if(withNormal)
+                        {
+                            trisNormalsIds[triNormalId++] = vertexNormal2 - Voxel(1, 1, 1);
+                        }
                     }
+                    break;
                 }
+                case EObjLine::IGNORED:
+                    break;
             }
-
-            mvsUtils::printfEstimate(idline, nlines, t1);
-            idline++;
         }
-        mvsUtils::finishEstimate();
-
-        in.close();
-        nmtls = materialCache.size();
     }
+
+    invalidateConnectivity();
     ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << npts << "\n\t- # triangles: " << ntris);
     return npts != 0 && ntris != 0;
 }
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <aliceVision/mvsData/Matrix3x3.hpp>
+#include <aliceVision/mvsData/MonotonicArena.hpp>
 #include <aliceVision/mvsData/Point2d.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
@@ -14,9 +15,45 @@
 #include <aliceVision/mvsData/Voxel.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
+/// Whether the file has the ".ply" extension (case insensitive)
+bool isPlyFile(const std::string& filename);
+
+/**
+ * @brief Lists of indexes per element, stored contiguously (compressed sparse row):
+ *        the list of the element i is from offsets[i] to offsets[i + 1].
+ */
+struct MeshAdjacency
+{
+    std::vector<std::size_t> offsets{0};
+    std::vector<int> values;
+
+    inline std::size_t getNbElements() const
+    {
+        return offsets.size() - 1;
+    }
+    inline int size(int i) const
+    {
+        return int(offsets[i + 1] - offsets[i]);
+    }
+    inline const int* begin(int i) const
+    {
+        return values.data() + offsets[i];
+    }
+    inline const int* end(int i) const
+    {
+        return values.data() + offsets[i + 1];
+    }
+    inline int operator()(int i, int k) const
+    {
+        return values[offsets[i] + k];
+    }
+};
+
 class Mesh
 {
 public:
@@ -106,6 +143,12 @@ protected:
     /// Per-vertex color data
     std::vector<rgb> _colors;
 
+    /// cached connectivity, see getPtsNeighTris and getPtsNeighPts
+    mutable MeshAdjacency _ptsNeighTris;
+    mutable MeshAdjacency _ptsNeighPts;
+    mutable bool _isPtsNeighTrisValid = false;
+    mutable bool _isPtsNeighPtsValid = false;
+
 public:
     StaticVector<Point3d>* pts = nullptr;
     StaticVector<Mesh::triangle>* tris = nullptr;
@@ -114,9 +157,20 @@ public:
     ~Mesh();
 
     void saveToObj(const std::string& filename);
+    /// Save the points, the colors and the triangles in a binary PLY file, written by chunks
+    void saveToPly(const std::string& filename) const;
+    /// Save in binary PLY if the file extension is ".ply", in OBJ otherwise
+    void save(const std::string& filename);
 
     bool loadFromBin(std::string binFileName);
     void saveToBin(std::string binFileName);
+    /**
+     * @brief Load the points, the colors and the faces of a binary little endian PLY file, read by chunks.
+     *        The polygons are triangulated.
+     * @return false if the file cannot be opened or the mesh is empty
+     */
+    bool loadFromPly(const std::string& filename);
+    /// Load an OBJ file, the lines are parsed in parallel
     bool loadFromObjAscii(int& nmtls, StaticVector<int>& trisMtlIds, StaticVector<Point3d>& normals,
                           StaticVector<Voxel>& trisNormalsIds, StaticVector<Point2d>& uvCoords,
                           StaticVector<Voxel>& trisUvIds, std::string objAsciiFileName);
@@ -128,14 +182,40 @@ public:
     /// Per-vertex color data accessor
     std::vector<rgb>& colors() { return _colors; }
 
-    StaticVector<StaticVector<int>*>* getTrisMap(const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h);
-    StaticVector<StaticVector<int>*>* getTrisMap(StaticVector<int>* visTris, const mvsUtils::MultiViewParams* mp, int rc, int scale,
-                                                 int w, int h);
+    /// Triangles projected in each pixel (x * h + y) of a camera, the lists are allocated in a MonotonicArena
+    using TrisMap = StaticVector<StaticVector<int, ArenaAllocator<int>>>;
+
+    /**
+     * @brief Fill the triangles projected in each pixel of rc
+     * @param[out] out The triangles map, its lists are allocated in arena (valid until arena.release())
+     * @param[in,out] arena The memory of the lists
+     */
+    void getTrisMap(TrisMap& out, MonotonicArena& arena, const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h);
+    void getTrisMap(TrisMap& out, MonotonicArena& arena, StaticVector<int>* visTris, const mvsUtils::MultiViewParams* mp, int rc,
+                    int scale, int w, int h);
     void getDepthMap(StaticVector<float>* depthMap, const mvsUtils::MultiViewParams* mp, int rc, int scale, int w, int h);
-    void getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<int>*>* tmp, const mvsUtils::MultiViewParams* mp, int rc,
+    void getDepthMap(StaticVector<float>* depthMap, const TrisMap& trisMap, const mvsUtils::MultiViewParams* mp, int rc,
                      int scale, int w, int h);
 
+    /**
+     * @brief Get the triangles around each point, in ascending order.
+     *        Built in parallel on the first call, then cached until the topology changes.
+     * @note The first call after a change is not thread-safe.
+     */
+    const MeshAdjacency& getPtsNeighTris() const;
+    /**
+     * @brief Get the neighboring points of each point, ordered around the point. Cached as getPtsNeighTris.
+     */
+    const MeshAdjacency& getPtsNeighPts() const;
+    /**
+     * @brief Release the cached connectivity after a change of the triangles.
+     *        The changes of the number of points or triangles are detected without it.
+     */
+    void invalidateConnectivity();
+
+    /// Copy of getPtsNeighTris in arrays that can be edited
     StaticVector<StaticVector<int>*>* getPtsNeighborTriangles() const;
+    /// Copy of getPtsNeighPts in arrays that can be edited
     StaticVector<StaticVector<int>*>* getPtsNeighPtsOrdered() const;
 
     StaticVector<int>* getVisibleTrianglesIndexes(std::string tmpDir, const mvsUtils::MultiViewParams* mp, int rc, int w, int h);
@@ -152,14 +232,26 @@ public:
     void getNotOrientedEdges(StaticVector<StaticVector<int>*>** edgesNeighTris, StaticVector<Pixel>** edgesPointsPairs);
     StaticVector<Voxel>* getTrianglesEdgesIds(StaticVector<StaticVector<int>*>* edgesNeighTris) const;
 
-    StaticVector<Point3d>* getLaplacianSmoothingVectors(StaticVector<StaticVector<int>*>* ptsNeighPts,
+    StaticVector<Point3d>* getLaplacianSmoothingVectors(const MeshAdjacency& ptsNeighPts,
                                                         double maximalNeighDist = -1.0f);
+    /// Same as above, in out_nms resized to the number of points: no allocation when it is reused
+    void getLaplacianSmoothingVectors(const MeshAdjacency& ptsNeighPts, std::vector<Point3d>& out_nms,
+                                      double maximalNeighDist = -1.0f) const;
     void laplacianSmoothPts(float maximalNeighDist = -1.0f);
-    void laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist = -1.0f);
+    void laplacianSmoothPts(const MeshAdjacency& ptsNeighPts, double maximalNeighDist = -1.0f);
+    /// Same as above, with the smoothing vectors in buffer, to reuse it between the iterations
+    void laplacianSmoothPts(const MeshAdjacency& ptsNeighPts, std::vector<Point3d>& buffer, double maximalNeighDist = -1.0f);
     StaticVector<Point3d>* computeNormalsForPts();
-    StaticVector<Point3d>* computeNormalsForPts(StaticVector<StaticVector<int>*>* ptsNeighTris);
-    void smoothNormals(StaticVector<Point3d>* nms, StaticVector<StaticVector<int>*>* ptsNeighPts);
-    Point3d computeTriangleNormal(int idTri);
+    StaticVector<Point3d>* computeNormalsForPts(const MeshAdjacency& ptsNeighTris);
+    void computeNormalsForPts(const MeshAdjacency& ptsNeighTris, std::vector<Point3d>& out_nms) const;
+    void smoothNormals(StaticVector<Point3d>* nms, const MeshAdjacency& ptsNeighPts);
+    /**
+     * @brief Average the normals with the normals of the neighboring points.
+     * @param[in,out] nms the normals of the points
+     * @param[in,out] buffer the other buffer of the double buffering, gets the previous normals
+     */
+    void smoothNormals(std::vector<Point3d>& nms, std::vector<Point3d>& buffer, const MeshAdjacency& ptsNeighPts) const;
+    Point3d computeTriangleNormal(int idTri) const;
     Point3d computeTriangleCenterOfGravity(int idTri) const;
     double computeTriangleMaxEdgeLength(int idTri) const;
     double computeTriangleMinEdgeLength(int idTri) const;
@@ -180,15 +272,15 @@ public:
     bool isTriangleProjectionInImage(const mvsUtils::MultiViewParams& mp, const Mesh::triangle_proj& tp, int camId, int margin) const;
     int getTriangleNbVertexInImage(const mvsUtils::MultiViewParams& mp, const Mesh::triangle_proj& tp, int camId, int margin) const;
     bool doesTriangleIntersectsRectangle(Mesh::triangle_proj* tp, Mesh::rectangle* re);
-    StaticVector<Point2d>* getTrianglePixelIntersectionsAndInternalPoints(Mesh::triangle_proj* tp,
-                                                                          Mesh::rectangle* re);
+    /// Fill out with the corners of the pixel in the triangle, the vertices of the triangle in the pixel and their intersections
+    void getTrianglePixelIntersectionsAndInternalPoints(StaticVector<Point2d>& out, Mesh::triangle_proj* tp, Mesh::rectangle* re);
     StaticVector<Point3d>* getTrianglePixelIntersectionsAndInternalPoints(const mvsUtils::MultiViewParams* mp, int idTri, Pixel& pix,
                                                                           int rc, Mesh::triangle_proj* tp,
                                                                           Mesh::rectangle* re);
 
     Point2d getTrianglePixelInternalPoint(Mesh::triangle_proj* tp, Mesh::rectangle* re);
 
-    void subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, std::string tmpDir, int maxMeshPts);
+    void subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, int maxMeshPts);
     void subdivideMeshMaxEdgeLengthUpdatePtsCams(const mvsUtils::MultiViewParams* mp, float maxEdgeLength,
                                                  StaticVector<StaticVector<int>*>* ptsCams, int maxMeshPts);
     StaticVector<StaticVector<int>*>* subdivideMesh(const mvsUtils::MultiViewParams* mp, float maxTriArea, float maxEdgeLength,
@@ -203,7 +295,6 @@ public:
     void subdivideMeshCase3(int i, StaticVector<Pixel>* edgesi, Pixel& neptIdEdgeId1, Pixel& neptIdEdgeId2,
                             Pixel& neptIdEdgeId3, StaticVector<Mesh::triangle>* tris1);
 
-    StaticVector<StaticVector<int>*>* computeTrisCams(const mvsUtils::MultiViewParams* mp, std::string tmpDir);
     StaticVector<StaticVector<int>*>* computeTrisCamsFromPtsCams(StaticVector<StaticVector<int>*>* ptsCams) const;
 
     void initFromDepthMap(const mvsUtils::MultiViewParams* mp, float* depthMap, int rc, int scale, int step, float alpha);
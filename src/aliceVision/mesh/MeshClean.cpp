@@ -7,6 +7,10 @@
 #include "MeshClean.hpp"
 #include <aliceVision/system/Logger.hpp>
 
+#include <exception>
+#include <set>
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
@@ -537,6 +541,11 @@ int MeshClean::path::deployAll()
 
 bool MeshClean::path::isWrongPt()
 {
+    if(sizeOfStaticVector<int>((*m_me->ptsNeighTrisSortedAsc)[m_ptId]) == 0)
+    {
+        return false;
+    }
+
     int nNewPtsNeededToAdd = 0;
     StaticVector<int>* ptNeighTrisSortedAscToProcess = new StaticVector<int>();
     ptNeighTrisSortedAscToProcess->reserve(sizeOfStaticVector<int>((*m_me->ptsNeighTrisSortedAsc)[m_ptId]));
@@ -761,6 +770,7 @@ void MeshClean::testPtsNeighTrisSortedAsc()
 {
     ALICEVISION_LOG_DEBUG("Testing if each point of each triangle has the triangleid in ptsNeighTris array.");
     int n = 0;
+    #pragma omp parallel for reduction(+:n)
     for(int i = 0; i < tris->size(); i++)
     {
         for(int k = 0; k < 3; k++)
@@ -784,6 +794,7 @@ void MeshClean::testPtsNeighTrisSortedAsc()
 
     ALICEVISION_LOG_DEBUG("Testing for each pt if all neigh triangles are sorted by id in asc");
     n = 0;
+    #pragma omp parallel for reduction(+:n)
     for(int i = 0; i < pts->size(); i++)
     {
         StaticVector<int>* ptNeighTris = (*ptsNeighTrisSortedAsc)[i];
@@ -811,6 +822,7 @@ void MeshClean::testEdgesNeighTris()
 {
     ALICEVISION_LOG_DEBUG("Testing if each edge of each triangle has the triangleid in edgeNeighTris array");
     int n = 0;
+    #pragma omp parallel for reduction(+:n)
     for(int i = 0; i < tris->size(); i++)
     {
         for(int k = 0; k < 3; k++)
@@ -851,6 +863,7 @@ void MeshClean::testPtsNeighPtsOrdered()
 {
     ALICEVISION_LOG_DEBUG("Testing if each edge of each triangle has both pts in ptsNeighPtsOrdered");
     int n = 0;
+    #pragma omp parallel for reduction(+:n)
     for(int i = 0; i < tris->size(); i++)
     {
         for(int k = 0; k < 3; k++)
@@ -892,11 +905,87 @@ int MeshClean::cleanMesh()
 {
     int nWrongPts = 0;
     int nv = pts->size();
+
+    // the wrong points are found in parallel: the paths are only read
+    std::vector<char> isWrong(nv, 0);
+    #pragma omp parallel for schedule(dynamic, 1024)
     for(int i = 0; i < nv; i++)
     {
         path pth(this, i);
-        nWrongPts += static_cast<int>(pth.deployAll() > 0);
+        isWrong[i] = static_cast<char>(pth.isWrongPt());
+    }
+
+    // the deployment of a wrong point changes the triangles of its neighbors,
+    // so the wrong points and their neighbors are processed sequentially
+    std::vector<char> isSequential(isWrong);
+    for(int i = 0; i < nv; i++)
+    {
+        if(!isWrong[i])
+            continue;
+        StaticVector<int>* ptNeighTris = (*ptsNeighTrisSortedAsc)[i];
+        for(int t = 0; t < sizeOfStaticVector<int>(ptNeighTris); t++)
+        {
+            for(int k = 0; k < 3; k++)
+                isSequential[(*tris)[(*ptNeighTris)[t]].v[k]] = 1;
+        }
     }
+
+    // the other points have one path: they only update their own boundary flag and ordered neighbors
+    std::exception_ptr exception;
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int i = 0; i < nv; i++)
+    {
+        if(isSequential[i])
+            continue;
+        try
+        {
+            path pth(this, i);
+            pth.deployAll();
+        }
+        catch(...)
+        {
+            #pragma omp critical
+            exception = std::current_exception();
+        }
+    }
+    if(exception)
+        std::rethrow_exception(exception);
+
+    // in increasing order, with the neighbors of the deployed points: their triangles have changed
+    std::set<int> toProcess;
+    for(int i = 0; i < nv; i++)
+    {
+        if(isSequential[i])
+            toProcess.insert(i);
+    }
+    std::vector<char> isProcessed(nv, 0);
+    std::vector<int> neighPts;
+    while(!toProcess.empty())
+    {
+        const int i = *toProcess.begin();
+        toProcess.erase(toProcess.begin());
+        isProcessed[i] = 1;
+
+        neighPts.clear();
+        StaticVector<int>* ptNeighTris = (*ptsNeighTrisSortedAsc)[i];
+        for(int t = 0; t < sizeOfStaticVector<int>(ptNeighTris); t++)
+        {
+            for(int k = 0; k < 3; k++)
+                neighPts.push_back((*tris)[(*ptNeighTris)[t]].v[k]);
+        }
+
+        path pth(this, i);
+        if(pth.deployAll() > 0)
+        {
+            nWrongPts++;
+            for(int ptId : neighPts)
+            {
+                if(ptId < nv && !isProcessed[ptId])
+                    toProcess.insert(ptId);
+            }
+        }
+    }
+
     // update vertex color data (if any) if points were modified
     if(_colors.size() > 0 && newPtsOldPtId->size() != 0)
     {
@@ -909,6 +998,9 @@ int MeshClean::cleanMesh()
         std::swap(_colors, newColors);
     }
 
+    // the points and triangles have been edited through the lists of MeshClean
+    invalidateConnectivity();
+
     ALICEVISION_LOG_INFO("cleanMesh:" << std::endl
                       << "\t- # wrong points: " << nWrongPts << std::endl
                       << "\t- # new points: " << (pts->size() - nv));
@@ -9,6 +9,9 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace aliceVision {
 namespace mesh {
 
@@ -23,58 +26,149 @@ MeshEnergyOpt::MeshEnergyOpt(mvsUtils::MultiViewParams* _mp)
 
 MeshEnergyOpt::~MeshEnergyOpt() = default;
 
-StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel()
+/**
+ * @brief Flat copy of the neighbors of the points edited by MeshClean.
+ *        The points without triangles get no neighbor.
+ */
+static MeshAdjacency getPtsNeighPtsAdjacency(const StaticVector<StaticVector<int>*>& ptsNeighPtsOrdered,
+                                             const StaticVector<StaticVector<int>*>& ptsNeighTrisSortedAsc)
 {
-    StaticVector<Point3d>* lapPts = new StaticVector<Point3d>();
-    lapPts->reserve(pts->size());
-    lapPts->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.f));
-    int nlabpts = 0;
+    const int nbPts = ptsNeighPtsOrdered.size();
+    MeshAdjacency adjacency;
+    adjacency.offsets.resize(nbPts + 1);
+    adjacency.offsets[0] = 0;
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const int nbNeighs = (ptsNeighTrisSortedAsc[i] == nullptr) ? 0 : sizeOfStaticVector<int>(ptsNeighPtsOrdered[i]);
+        adjacency.offsets[i + 1] = adjacency.offsets[i] + nbNeighs;
+    }
+    adjacency.values.resize(adjacency.offsets.back());
 
-#pragma omp parallel for
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        if(adjacency.size(i) > 0)
+            std::copy(ptsNeighPtsOrdered[i]->getData().begin(), ptsNeighPtsOrdered[i]->getData().end(),
+                      adjacency.values.begin() + adjacency.offsets[i]);
+    }
+    return adjacency;
+}
+
+/// the smoothing vectors with a null or NaN length are not applied (as Point3d::normalize would fail on them)
+static inline bool isValidSmoothingVector(const Point3d& v)
+{
+    const double d = v.size();
+    return (d > 0.0) && std::isfinite(d);
+}
+
+MeshEnergyOpt::LaplacianMatrix MeshEnergyOpt::computeLaplacianMatrix() const
+{
+    LaplacianMatrix laplacian;
+    laplacian.neighbors = getPtsNeighPtsAdjacency(*ptsNeighPtsOrdered, *ptsNeighTrisSortedAsc);
+
+    const MeshAdjacency& neighbors = laplacian.neighbors;
+    const int nbPts = neighbors.getNbElements();
+    laplacian.invValences.resize(nbPts);
+    laplacian.biLaplacianFactors.resize(nbPts);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const int valence = neighbors.size(i);
+        laplacian.invValences[i] = (valence > 0) ? 1.0f / (float)valence : 0.0f;
+    }
+
+    // kobbelt kampagna 98 Interactive Multi-Resolution Modeling on Arbitrary Meshes, page 6 eq (8)
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        float sum = 0.0f;
+        for(int j = 0; j < neighbors.size(i); ++j)
+            sum += laplacian.invValences[neighbors(i, j)];
+        const float v = 1.0f + laplacian.invValences[i] * sum;
+        laplacian.biLaplacianFactors[i] = -1.0f / v;
+    }
+
+    return laplacian;
+}
+
+int MeshEnergyOpt::computeLaplacianPtsParallel(const LaplacianMatrix& laplacian, std::vector<Point3d>& out_lapPts) const
+{
+    const MeshAdjacency& neighbors = laplacian.neighbors;
+    out_lapPts.resize(pts->size());
+    int nbInvalid = 0;
+
+#pragma omp parallel for reduction(+:nbInvalid)
     for(int i = 0; i < pts->size(); i++)
     {
-        Point3d lapPt;
-        if(getLaplacianSmoothingVector(i, lapPt))
+        // row i of L * pts
+        const int* cols = neighbors.begin(i);
+        const int nbCols = neighbors.size(i);
+        Point3d sum(0.0, 0.0, 0.0);
+        bool isValid = (nbCols > 0);
+        for(int j = 0; isValid && (j < nbCols); ++j)
         {
-            (*lapPts)[i] = lapPt;
-            nlabpts++;
+            const Point3d& npt = (*pts)[cols[j]];
+            // the points at the origin are not initialized
+            isValid = (npt.x != 0.0) || (npt.y != 0.0) || (npt.z != 0.0);
+            sum = sum + npt;
         }
-    }
+        const Point3d lapPt = sum * laplacian.invValences[i] - (*pts)[i];
 
-    return lapPts;
+        if(isValid && isValidSmoothingVector(lapPt))
+        {
+            out_lapPts[i] = lapPt;
+        }
+        else
+        {
+            out_lapPts[i] = Point3d(0.0, 0.0, 0.0);
+            nbInvalid += (nbCols > 0) ? 1 : 0;
+        }
+    }
+    return nbInvalid;
 }
 
-void MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU,
-                                                const Point3d& RD, StaticVectorBool* ptsCanMove)
+int MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool* ptsCanMove,
+                                          const LaplacianMatrix& laplacian, std::vector<Point3d>& lapPts,
+                                          StaticVector<Point3d>& newPts) const
 {
-    // printf("nlabpts %i of %i\n",nlabpts,pts->size());
-    StaticVector<Point3d>* lapPts = computeLaplacianPtsParallel();
-
-    StaticVector<Point3d>* newPts = new StaticVector<Point3d>();
-    newPts->reserve(pts->size());
-    newPts->push_back_arr(pts);
+    const MeshAdjacency& neighbors = laplacian.neighbors;
+    int nbInvalid = computeLaplacianPtsParallel(laplacian, lapPts);
 
+    // row i of L * lapPts, the bi-Laplacian smoothing vector and the gradient step in one pass
 #pragma omp parallel for
     for(int i = 0; i < pts->size(); ++i)
     {
-        if((ptsCanMove == nullptr) || ((*ptsCanMove)[i]))
+        const Point3d& pt = (*pts)[i];
+        newPts[i] = pt;
+        if((ptsCanMove != nullptr) && !(*ptsCanMove)[i])
+            continue;
+
+        const int* cols = neighbors.begin(i);
+        const int nbCols = neighbors.size(i);
+        Point3d sum(0.0, 0.0, 0.0);
+        bool isValid = (nbCols > 0);
+        for(int j = 0; isValid && (j < nbCols); ++j)
         {
-            Point3d n;
-
-            if(getBiLaplacianSmoothingVector(i, lapPts, n))
-            {
-                Point3d p = (*newPts)[i] + n * lambda;
-                if((p.x > LU.x) && (p.y > LU.y) && (p.z > LU.z) && (p.x < RD.x) && (p.y < RD.y) && (p.z < RD.z))
-                {
-                    (*newPts)[i] = p;
-                }
-            }
+            const Point3d& nlapPt = lapPts[cols[j]];
+            // the Laplacian could not be computed on this neighbor
+            isValid = (nlapPt.x != 0.0) || (nlapPt.y != 0.0) || (nlapPt.z != 0.0);
+            sum = sum + nlapPt;
         }
-    }
+        if(!isValid)
+            continue;
 
-    delete pts;
-    pts = newPts;
-    delete lapPts;
+        const Point3d n = (sum * laplacian.invValences[i] - lapPts[i]) * laplacian.biLaplacianFactors[i];
+        if(!isValidSmoothingVector(n))
+            continue;
+
+        const Point3d p = pt + n * lambda;
+        if((p.x > LU.x) && (p.y > LU.y) && (p.z > LU.z) && (p.x < RD.x) && (p.y < RD.y) && (p.z < RD.z))
+        {
+            newPts[i] = p;
+        }
+    }
+    return nbInvalid;
 }
 
 bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool* ptsCanMove)
@@ -103,13 +197,25 @@ bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool* pt
                          << "\t- lamda: " << lambda << std::endl
                          << "\t- niters: " << niter << std::endl);
 
+    // the topology does not change: the Laplacian matrix is computed once
+    const LaplacianMatrix laplacian = computeLaplacianMatrix();
+
+    // double buffering of the points: each iteration reads pts and writes newPts, then they are swapped
+    std::vector<Point3d> lapPts;
+    StaticVector<Point3d>* newPts = new StaticVector<Point3d>();
+    newPts->resize(pts->size());
+
     for(int i = 0; i < niter; i++)
     {
         ALICEVISION_LOG_INFO("Optimizing mesh smooth: iteration " << i);
-        updateGradientParallel(lambda, LU, RD, ptsCanMove);
+        const int nbInvalid = updateGradientParallel(lambda, LU, RD, ptsCanMove, laplacian, lapPts, *newPts);
+        std::swap(pts, newPts);
+        if(nbInvalid > 0)
+            ALICEVISION_LOG_WARNING("Optimizing mesh smooth: invalid Laplacian on " << nbInvalid << " points.");
         //if(saveDebug)
         //    saveToObj(folder + "mesh_smoothed_" + std::to_string(i) + ".obj");
     }
+    delete newPts;
 
     return true;
 }
@@ -10,6 +10,8 @@
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mesh/MeshAnalyze.hpp>
 
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
@@ -22,8 +24,35 @@ public:
     bool optimizeSmooth(float lambda, int niter, StaticVectorBool* ptsCanMove);
 
 private:
-    StaticVector<Point3d>* computeLaplacianPtsParallel();
-    void updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool* ptsCanMove);
+    /**
+     * @brief Uniform Laplacian operator of the mesh as a sparse matrix in compressed sparse row:
+     *        row i of L * x is the mean of x on the neighbors of the point i minus x_i.
+     */
+    struct LaplacianMatrix
+    {
+        /// column indexes of each row, the neighbors of the points with triangles
+        MeshAdjacency neighbors;
+        /// weight of the neighbors in each row: 1 / valence, 0 for the points without neighbor
+        std::vector<float> invValences;
+        /// scale of row i of L * L * x to get the bi-Laplacian smoothing vector
+        std::vector<float> biLaplacianFactors;
+    };
+
+    LaplacianMatrix computeLaplacianMatrix() const;
+    /**
+     * @brief Compute the Laplacian of the points: out_lapPts = L * pts, zero where it cannot be computed.
+     * @return the number of points with neighbors and an invalid Laplacian
+     */
+    int computeLaplacianPtsParallel(const LaplacianMatrix& laplacian, std::vector<Point3d>& out_lapPts) const;
+    /**
+     * @brief Move the points along their bi-Laplacian, from pts into newPts.
+     * @param[in,out] lapPts buffer of the Laplacian of the points
+     * @param[out] newPts the moved points, same size as pts
+     * @return the number of points with neighbors and an invalid Laplacian
+     */
+    int updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool* ptsCanMove,
+                               const LaplacianMatrix& laplacian, std::vector<Point3d>& lapPts,
+                               StaticVector<Point3d>& newPts) const;
 };
 
 } // namespace mesh
@@ -8,7 +8,10 @@
 #include "geoMesh.hpp"
 #include "UVAtlas.hpp"
 
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/MemoryInfo.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/mvsData/Color.hpp>
@@ -17,6 +20,7 @@
 #include <aliceVision/mvsData/Image.hpp>
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/mvsData/imageAlgo.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include <geogram/basic/common.h>
 #include <geogram/basic/geometry_nd.h>
@@ -26,8 +30,15 @@
 
 #include <boost/algorithm/string/case_conv.hpp> 
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/mesh/cuda/textureRasterization.hpp>
+#endif
+
+#include <exception>
 #include <map>
+#include <memory>
 #include <set>
+#include <tuple>
 
 // Debug mode: save atlases decomposition in frequency bands and
 // the number of contribution in each band (if useScore is set to false)
@@ -36,6 +47,9 @@
 namespace aliceVision {
 namespace mesh {
 
+/// images loaded ahead by the images cache while the cameras are processed
+static const int NB_PREFETCHED_IMAGES = 2;
+
 EUnwrapMethod EUnwrapMethod_stringToEnum(const std::string& method)
 {
     std::string m = method;
@@ -259,6 +273,9 @@ void Texturing::generateUVsBasicMethod(mvsUtils::MultiViewParams& mp)
 void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
                                  const boost::filesystem::path &outPath, imageIO::EImageFileType textureFileType)
 {
+    ALICEVISION_PROFILE_SCOPE("Texturing::generateTextures");
+    const system::MemoryStage memoryStage("Texturing::generateTextures");
+
     // Ensure that contribution levels do not contain 0 and are sorted (as each frequency band contributes to lower bands).
     auto& m = texParams.multiBandNbContrib;
     m.erase(std::remove(std::begin(m), std::end(m), 0), std::end(m));
@@ -278,31 +295,34 @@ void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
 
     ALICEVISION_LOG_INFO("Texturing in " + imageIO::EImageColorSpace_enumToString(texParams.processColorspace) + " colorspace.");
     mvsUtils::ImagesCache imageCache(&mp, texParams.processColorspace, texParams.correctEV);
-    imageCache.setCacheSize(2);
     ALICEVISION_LOG_INFO("Images loaded from cache with: " + imageCache.ECorrectEV_enumToString(texParams.correctEV));
 
-    //calculate the maximum number of atlases in memory in MB
-    system::MemoryInfo memInfo = system::getMemoryInfo();
-    const std::size_t imageMaxMemSize =  mp.getMaxImageWidth() * mp.getMaxImageHeight() * sizeof(Color) / std::pow(2,20); //MB
-    const std::size_t imagePyramidMaxMemSize = texParams.nbBand * imageMaxMemSize;
-    const std::size_t atlasContribMemSize = texParams.textureSide * texParams.textureSide * (sizeof(Color)+sizeof(float)) / std::pow(2,20); //MB
-    const std::size_t atlasPyramidMaxMemSize = texParams.nbBand * atlasContribMemSize;
-
-    const int freeRam = int(memInfo.freeRam / std::pow(2,20));
-    const int availableMem = freeRam - 2 * imageMaxMemSize - imagePyramidMaxMemSize; // keep some memory for the 2 input images in cache and one laplacian pyramid
+    // memory budget of the atlases pyramids, of the cameras processed together and of the prefetched images
+    const std::size_t budget = (texParams.maxMemory > 0) ? std::size_t(texParams.maxMemory) * 1024 * 1024
+                                                         : system::getMemoryInfo().availableRam;
+    const std::size_t imageMaxBytes = std::size_t(mp.getMaxImageWidth()) * std::size_t(mp.getMaxImageHeight()) * sizeof(Color);
+    // image and laplacian pyramid of a camera
+    const std::size_t cameraMaxBytes = (1 + texParams.nbBand) * imageMaxBytes;
+    const std::size_t atlasPyramidBytes = std::size_t(texParams.nbBand) * texParams.textureSide * texParams.textureSide * (sizeof(Color) + sizeof(float));
+    const std::size_t minCamerasBytes = cameraMaxBytes + NB_PREFETCHED_IMAGES * imageMaxBytes;
 
+    // the atlases come first: each subset of atlases reads all its cameras again
     const int nbAtlas = _atlases.size();
-    int nbAtlasMax = std::floor(availableMem / atlasPyramidMaxMemSize); //maximum number of textures laplacian pyramid in RAM
-    nbAtlasMax = std::min(nbAtlas, nbAtlasMax); //if enough memory, do it with all atlases
-    if (availableMem - nbAtlasMax*atlasPyramidMaxMemSize < 1000) //keep 1 GB margin in memory
-        nbAtlasMax -= 1;
-    nbAtlasMax = std::max(1, nbAtlasMax); //if not enough memory, do it one by one
-
-    ALICEVISION_LOG_INFO("Total amount of free RAM  : " << freeRam << " MB.");
-    ALICEVISION_LOG_INFO("Total amount of memory available : " << availableMem << " MB.");
-    ALICEVISION_LOG_INFO("Total amount of an image in memory  : " << imageMaxMemSize << " MB.");
-    ALICEVISION_LOG_INFO("Total amount of an atlas pyramid in memory: " << atlasPyramidMaxMemSize << " MB.");
-    ALICEVISION_LOG_INFO("Processing " << nbAtlas << " atlases by chunks of " << nbAtlasMax);
+    int nbAtlasMax = (budget > minCamerasBytes) ? int((budget - minCamerasBytes) / atlasPyramidBytes) : 0;
+    nbAtlasMax = std::max(1, std::min(nbAtlas, nbAtlasMax)); //if not enough memory, do it one by one
+
+    const std::size_t atlasesBytes = std::size_t(nbAtlasMax) * atlasPyramidBytes;
+    const std::size_t camerasBudget = (budget > atlasesBytes + NB_PREFETCHED_IMAGES * imageMaxBytes) ? budget - atlasesBytes - NB_PREFETCHED_IMAGES * imageMaxBytes : 0;
+    // more cameras than threads do not load faster
+    const int nbCamerasMax = std::max(1, std::min(omp_get_max_threads(), int(camerasBudget / cameraMaxBytes)));
+    imageCache.setCacheSize(nbCamerasMax + NB_PREFETCHED_IMAGES);
+
+    ALICEVISION_LOG_INFO("Memory budget: " << budget / (1024 * 1024) << " MB.");
+    ALICEVISION_LOG_INFO("Memory of a camera image and its pyramid: " << cameraMaxBytes / (1024 * 1024) << " MB.");
+    ALICEVISION_LOG_INFO("Memory of an atlas pyramid: " << atlasPyramidBytes / (1024 * 1024) << " MB.");
+    ALICEVISION_LOG_INFO("Processing " << nbAtlas << " atlases by chunks of " << nbAtlasMax << ", with " << nbCamerasMax << " cameras at once.");
+    if(minCamerasBytes + atlasPyramidBytes > budget)
+        ALICEVISION_LOG_WARNING("The memory budget is lower than the memory of one atlas and one camera.");
 
     //generateTexture for the maximum number of atlases, and iterate
     const std::div_t divresult = div(nbAtlas, nbAtlasMax);
@@ -320,13 +340,16 @@ void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
             atlasIDs.push_back(atlasID);
         }
         ALICEVISION_LOG_INFO("Generating texture for atlases " << n*nbAtlasMax + 1 << " to " << n*nbAtlasMax+imax );
-        generateTexturesSubSet(mp, atlasIDs, imageCache, outPath, textureFileType);
+        generateTexturesSubSet(mp, atlasIDs, imageCache, nbCamerasMax, outPath, textureFileType);
     }
 }
 
 void Texturing::generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
-                                const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, imageIO::EImageFileType textureFileType)
+                                const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache, int nbCamerasMax,
+                                const bfs::path& outPath, imageIO::EImageFileType textureFileType)
 {
+    ALICEVISION_PROFILE_SCOPE("Texturing::generateTexturesSubSet");
+
     if(atlasIDs.size() > _atlases.size())
         throw std::runtime_error("Invalid atlas IDs ");
 
@@ -344,8 +367,13 @@ void Texturing::generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
         ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasID + 1 << "/" << _atlases.size()
                   << " (" << _atlases[atlasID].size() << " triangles).");
 
+        // contributions of each triangle: <camId, band, score>, the triangles are scored in parallel
+        using TriangleContribution = std::tuple<int, int, int>;
+        std::vector<std::vector<TriangleContribution>> trianglesContributions(_atlases[atlasID].size());
+
         // iterate over atlas' triangles
-        for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
+        #pragma omp parallel for schedule(dynamic, 256)
+        for(int i = 0; i < _atlases[atlasID].size(); ++i)
         {
             int triangleID = _atlases[atlasID][i];
 
@@ -452,10 +480,7 @@ void Texturing::generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
                 //for the camera camId : add triangle score to the corresponding texture, at the right frequency band
                 const int camId = std::get<2>(scorePerCamId[contrib]);
                 const int triangleScore = std::get<1>(scorePerCamId[contrib]);
-                auto& camContribution = contributionsPerCamera[camId];
-                if(camContribution.find(atlasID) == camContribution.end())
-                    camContribution[atlasID].resize(texParams.nbBand);
-                camContribution.at(atlasID)[band].emplace_back(triangleID, triangleScore);
+                trianglesContributions[i].emplace_back(camId, band, triangleScore);
 
                 if(contrib + 1 == texParams.multiBandNbContrib[band])
                 {
@@ -463,234 +488,413 @@ void Texturing::generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
                 }
             }
         }
+
+        // in the order of the triangles
+        for(int i = 0; i < _atlases[atlasID].size(); ++i)
+        {
+            const int triangleID = _atlases[atlasID][i];
+            for(const TriangleContribution& contribution : trianglesContributions[i])
+            {
+                auto& camContribution = contributionsPerCamera[std::get<0>(contribution)];
+                if(camContribution.find(atlasID) == camContribution.end())
+                    camContribution[atlasID].resize(texParams.nbBand);
+                camContribution.at(atlasID)[std::get<1>(contribution)].emplace_back(triangleID, std::get<2>(contribution));
+            }
+        }
     }
 
     ALICEVISION_LOG_INFO("Reading pixel color.");
 
+    const int texSide = static_cast<int>(texParams.textureSide);
+
     //pyramid of atlases frequency bands
     std::map<AtlasIndex, AccuPyramid> accuPyramids;
     for(std::size_t atlasID: atlasIDs)
         accuPyramids[atlasID].init(texParams.nbBand, texParams.textureSide, texParams.textureSide);
 
-    //for each camera, for each texture, iterate over triangles and fill the accuPyramids map
-    for(int camId = 0; camId < contributionsPerCamera.size(); ++camId)
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    // the atlases pyramids stay on the device while the cameras are rasterized
+    std::map<AtlasIndex, std::unique_ptr<cuda::DeviceAtlasPyramid>> deviceAtlases;
+    cuda::DeviceCamera deviceCamera;
+    static_assert(sizeof(Color) == 3 * sizeof(float), "the device images are RGB floats");
+    if(texParams.useGpu)
     {
-        const std::map<AtlasIndex, std::vector<ScorePerTriangle>>& cameraContributions = contributionsPerCamera[camId];
-
-        if(cameraContributions.empty())
+        if(!cuda::supportTextureRasterization(texParams.nbBand))
         {
-            ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") unused.");
-            continue;
+            ALICEVISION_LOG_WARNING("No CUDA device for " << texParams.nbBand << " frequency bands, the textures are computed on the CPU.");
         }
-        ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") with contributions to " << cameraContributions.size() << " texture files:");
+        else
+        {
+            for(std::size_t atlasID: atlasIDs)
+            {
+                std::unique_ptr<cuda::DeviceAtlasPyramid> deviceAtlas(new cuda::DeviceAtlasPyramid());
+                if(!deviceAtlas->allocate(texParams.nbBand, texSide))
+                {
+                    ALICEVISION_LOG_WARNING("Not enough device memory for " << atlasIDs.size() << " atlases, the textures are computed on the CPU.");
+                    deviceAtlases.clear();
+                    break;
+                }
+                deviceAtlases[atlasID] = std::move(deviceAtlas);
+            }
+        }
+    }
+#endif
+
+    // the cameras with contributions are loaded ahead by the images cache, in order of use
+    std::vector<int> usedCams;
+    for(int camId = 0; camId < contributionsPerCamera.size(); ++camId)
+    {
+        if(contributionsPerCamera[camId].empty())
+            ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") unused.");
+        else
+            usedCams.push_back(camId);
+    }
+    imageCache.setSchedule(usedCams);
 
-        // Load camera image from cache
-        mvsUtils::ImagesCache::ImgSharedPtr imgPtr = imageCache.getImg_sync(camId);
-        const Image& camImg = *imgPtr;
+    // each row of the atlases is filled by one thread, in the order of the cameras, bands and triangles
+    const int nbRowsTiles = std::max(1, std::min(texSide, (2 * omp_get_max_threads() + int(atlasIDs.size()) - 1) / int(atlasIDs.size())));
 
-        // Calculate laplacianPyramid
-        std::vector<Image> pyramidL; //laplacian pyramid
-        camImg.laplacianPyramid(pyramidL, texParams.nbBand, texParams.multiBandDownscale);
+    // laplacian pyramids, their buffers are reused by the next windows
+    std::vector<std::vector<Image>> camPyramidsL(std::min(std::size_t(nbCamerasMax), usedCams.size()));
 
-        // for each output texture file
-        for(const auto& c : cameraContributions)
+    // for each window of cameras, load the images and their laplacian pyramids, then fill the accuPyramids map
+    for(std::size_t windowBegin = 0; windowBegin < usedCams.size(); windowBegin += nbCamerasMax)
+    {
+        const int windowSize = std::min(std::size_t(nbCamerasMax), usedCams.size() - windowBegin);
+        std::vector<mvsUtils::ImagesCache::ImgSharedPtr> camImgs(windowSize);
+
+        std::exception_ptr exception;
+        #pragma omp parallel for schedule(dynamic)
+        for(int w = 0; w < windowSize; ++w)
         {
-            AtlasIndex atlasID = c.first;
-            ALICEVISION_LOG_INFO("  - Texture file: " << atlasID + 1);
-            //for each frequency band
-            for(int band = 0; band < c.second.size(); ++band)
+            const int camId = usedCams[windowBegin + w];
+            try
             {
-                const ScorePerTriangle& trianglesId = c.second[band];
-                ALICEVISION_LOG_INFO("      - band " << band + 1 << ": " << trianglesId.size() << " triangles.");
+                // Load camera image from cache
+                camImgs[w] = imageCache.getImg_sync(camId);
+                camImgs[w]->laplacianPyramid(camPyramidsL[w], texParams.nbBand, texParams.multiBandDownscale);
+            }
+            catch(...)
+            {
+                #pragma omp critical
+                exception = std::current_exception();
+            }
+            ALICEVISION_LOG_INFO("- camera " << mp.getViewId(camId) << " (" << camId + 1 << "/" << mp.ncams << ") with contributions to " << contributionsPerCamera[camId].size() << " texture files.");
+        }
+        if(exception)
+            std::rethrow_exception(exception);
 
-                // for each triangle
-                #pragma omp parallel for
-                for(int ti = 0; ti < trianglesId.size(); ++ti)
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+        if(!deviceAtlases.empty())
+        {
+            for(int w = 0; w < windowSize; ++w)
+            {
+                const int camId = usedCams[windowBegin + w];
+                const Matrix3x4& P = mp.camArr[camId];
+
+                // the camera image, then the levels of its laplacian pyramid
+                std::vector<const float*> images{reinterpret_cast<const float*>(camImgs[w]->data().data())};
+                std::vector<int> widths{camImgs[w]->width()};
+                std::vector<int> heights{camImgs[w]->height()};
+                for(const Image& level : camPyramidsL[w])
                 {
-                    const unsigned int triangleId = std::get<0>(trianglesId[ti]);
-                    const float triangleScore = texParams.useScore ? std::get<1>(trianglesId[ti]) : 1.0f;
-                    // retrieve triangle 3D and UV coordinates
-                    Point2d triPixs[3];
-                    Point3d triPts[3];
-                    auto triangleUvIds = trisUvIds[triangleId];
-                    // compute the Bottom-Left minima of the current UDIM for [0,1] range remapping
-                    Point2d udimBL;
-                    udimBL.x = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].x, uvCoords[triangleUvIds[1]].x), uvCoords[triangleUvIds[2]].x));
-                    udimBL.y = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].y, uvCoords[triangleUvIds[1]].y), uvCoords[triangleUvIds[2]].y));
-
-                    for(int k = 0; k < 3; k++)
+                    images.push_back(reinterpret_cast<const float*>(level.data().data()));
+                    widths.push_back(level.width());
+                    heights.push_back(level.height());
+                }
+                if(!deviceCamera.upload(images, widths, heights))
+                    throw std::runtime_error("Failed to copy the camera " + std::to_string(mp.getViewId(camId)) + " on the device.");
+
+                for(const auto& c : contributionsPerCamera[camId])
+                {
+                    for(int band = 0; band < c.second.size(); ++band)
                     {
-                       const int pointIndex = (*me->tris)[triangleId].v[k];
-                       triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
-                       const int uvPointIndex = triangleUvIds.m[k];
-                       Point2d uv = uvCoords[uvPointIndex];
-                       // UDIM: remap coordinates between [0,1]
-                       uv = uv - udimBL;
-
-                       triPixs[k] = uv * texParams.textureSide;   // UV coordinates
+                        const ScorePerTriangle& trianglesId = c.second[band];
+                        std::vector<cuda::DeviceTriangle> triangles(trianglesId.size());
+                        for(int ti = 0; ti < trianglesId.size(); ++ti)
+                        {
+                            const unsigned int triangleId = std::get<0>(trianglesId[ti]);
+                            auto triangleUvIds = trisUvIds[triangleId];
+                            cuda::DeviceTriangle& triangle = triangles[ti];
+                            triangle.score = texParams.useScore ? std::get<1>(trianglesId[ti]) : 1.0f;
+
+                            // UDIM: remap coordinates between [0,1]
+                            Point2d udimBL;
+                            udimBL.x = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].x, uvCoords[triangleUvIds[1]].x), uvCoords[triangleUvIds[2]].x));
+                            udimBL.y = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].y, uvCoords[triangleUvIds[1]].y), uvCoords[triangleUvIds[2]].y));
+
+                            Point2d triPixs[3];
+                            for(int k = 0; k < 3; ++k)
+                            {
+                                triPixs[k] = (uvCoords[triangleUvIds.m[k]] - udimBL) * texParams.textureSide;
+                                triangle.uv[k][0] = static_cast<float>(triPixs[k].x);
+                                triangle.uv[k][1] = static_cast<float>(triPixs[k].y);
+
+                                const Point3d proj = P * (*me->pts)[(*me->tris)[triangleId].v[k]];
+                                triangle.proj[k][0] = static_cast<float>(proj.x);
+                                triangle.proj[k][1] = static_cast<float>(proj.y);
+                                triangle.proj[k][2] = static_cast<float>(proj.z);
+                            }
+
+                            // triangle bounding box in pixel indexes, clamped to [0; textureSide]
+                            triangle.bbox[0] = clamp(static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x))), 0, texSide);
+                            triangle.bbox[1] = clamp(static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y))), 0, texSide);
+                            triangle.bbox[2] = clamp(static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x))), 0, texSide);
+                            triangle.bbox[3] = clamp(static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y))), 0, texSide);
+                        }
+
+                        if(!cuda::rasterizeTriangles(deviceCamera, mp.g_border, triangles.data(), static_cast<int>(triangles.size()),
+                                                     band, texParams.multiBandDownscale, *deviceAtlases.at(c.first)))
+                            throw std::runtime_error("Failed to rasterize the triangles of the atlas " + std::to_string(c.first) + " on the device.");
                     }
+                }
+            }
+            continue;
+        }
+#endif
 
-                    // compute triangle bounding box in pixel indexes
-                    // min values: floor(value)
-                    // max values: ceil(value)
-                    Pixel LU, RD;
-                    LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-                    LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-                    RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-                    RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-
-                    // sanity check: clamp values to [0; textureSide]
-                    int texSide = static_cast<int>(texParams.textureSide);
-                    LU.x = clamp(LU.x, 0, texSide);
-                    LU.y = clamp(LU.y, 0, texSide);
-                    RD.x = clamp(RD.x, 0, texSide);
-                    RD.y = clamp(RD.y, 0, texSide);
-
-                    // iterate over pixels of the triangle's bounding box
-                    for(int y = LU.y; y < RD.y; y++)
+        #pragma omp parallel for schedule(dynamic)
+        for(int tile = 0; tile < int(atlasIDs.size()) * nbRowsTiles; ++tile)
+        {
+            const AtlasIndex atlasID = atlasIDs[tile / nbRowsTiles];
+            const int rowsBegin = (tile % nbRowsTiles) * texSide / nbRowsTiles;
+            const int rowsEnd = (tile % nbRowsTiles + 1) * texSide / nbRowsTiles;
+            AccuPyramid& accuPyramid = accuPyramids.at(atlasID);
+
+            for(int w = 0; w < windowSize; ++w)
+            {
+                const int camId = usedCams[windowBegin + w];
+                const auto c = contributionsPerCamera[camId].find(atlasID);
+                if(c == contributionsPerCamera[camId].end())
+                    continue;
+                const Image& camImg = *camImgs[w];
+                const std::vector<Image>& pyramidL = camPyramidsL[w];
+
+                //for each frequency band
+                for(int band = 0; band < c->second.size(); ++band)
+                {
+                    const ScorePerTriangle& trianglesId = c->second[band];
+
+                    // for each triangle
+                    for(int ti = 0; ti < trianglesId.size(); ++ti)
                     {
-                       for(int x = LU.x; x < RD.x; x++)
-                       {
-                           Pixel pix(x, y); // top-left corner of the pixel
-                           Point2d barycCoords;
-
-                           // test if the pixel is inside triangle
-                           // and retrieve its barycentric coordinates
-                           if(!isPixelInTriangle(triPixs, pix, barycCoords))
-                           {
-                               continue;
-                           }
+                        const unsigned int triangleId = std::get<0>(trianglesId[ti]);
+                        const float triangleScore = texParams.useScore ? std::get<1>(trianglesId[ti]) : 1.0f;
+                        // retrieve triangle 3D and UV coordinates
+                        Point2d triPixs[3];
+                        Point3d triPts[3];
+                        auto triangleUvIds = trisUvIds[triangleId];
+                        // compute the Bottom-Left minima of the current UDIM for [0,1] range remapping
+                        Point2d udimBL;
+                        udimBL.x = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].x, uvCoords[triangleUvIds[1]].x), uvCoords[triangleUvIds[2]].x));
+                        udimBL.y = std::floor(std::min(std::min(uvCoords[triangleUvIds[0]].y, uvCoords[triangleUvIds[1]].y), uvCoords[triangleUvIds[2]].y));
+
+                        for(int k = 0; k < 3; k++)
+                        {
+                           const int pointIndex = (*me->tris)[triangleId].v[k];
+                           triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
+                           const int uvPointIndex = triangleUvIds.m[k];
+                           Point2d uv = uvCoords[uvPointIndex];
+                           // UDIM: remap coordinates between [0,1]
+                           uv = uv - udimBL;
+
+                           triPixs[k] = uv * texParams.textureSide;   // UV coordinates
+                        }
 
-                           // remap 'y' to image coordinates system (inverted Y axis)
-                           const unsigned int y_ = (texParams.textureSide - 1) - y;
-                           // 1D pixel index
-                           unsigned int xyoffset = y_ * texParams.textureSide + x;
-                           // get 3D coordinates
-                           Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
-                           // get 2D coordinates in source image
-                           Point2d pixRC;
-                           mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
-                           // exclude out of bounds pixels
-                           if(!mp.isPixelInImage(pixRC, camId))
-                               continue;
-
-                           // If the color is pure zero (ie. no contributions), we consider it as an invalid pixel.
-                           if(camImg.getInterpolateColor(pixRC) == Color(0.f, 0.f, 0.f))
-                               continue;
-
-                           // Fill the accumulated pyramid for this pixel
-                           // each frequency band also contributes to lower frequencies (higher band indexes)
-                           AccuPyramid& accuPyramid = accuPyramids.at(atlasID);
-                           for(std::size_t bandContrib = band; bandContrib < pyramidL.size(); ++bandContrib)
+                        // compute triangle bounding box in pixel indexes
+                        // min values: floor(value)
+                        // max values: ceil(value)
+                        Pixel LU, RD;
+                        LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+                        LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+                        RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+                        RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+
+                        // sanity check: clamp values to [0; textureSide], only the rows of the tile are filled
+                        LU.x = clamp(LU.x, 0, texSide);
+                        LU.y = clamp(LU.y, rowsBegin, rowsEnd);
+                        RD.x = clamp(RD.x, 0, texSide);
+                        RD.y = clamp(RD.y, rowsBegin, rowsEnd);
+
+                        // iterate over pixels of the triangle's bounding box
+                        for(int y = LU.y; y < RD.y; y++)
+                        {
+                           for(int x = LU.x; x < RD.x; x++)
                            {
-                               int downscaleCoef = std::pow(texParams.multiBandDownscale, bandContrib);
-                               AccuImage& accuImage = accuPyramid.pyramid[bandContrib];
-
-                               // fill the accumulated color map for this pixel
-                               accuImage.img[xyoffset] += pyramidL[bandContrib].getInterpolateColor(pixRC/downscaleCoef) * triangleScore;
-                               accuImage.imgCount[xyoffset] += triangleScore;
+                               Pixel pix(x, y); // top-left corner of the pixel
+                               Point2d barycCoords;
+
+                               // test if the pixel is inside triangle
+                               // and retrieve its barycentric coordinates
+                               if(!isPixelInTriangle(triPixs, pix, barycCoords))
+                               {
+                                   continue;
+                               }
+
+                               // remap 'y' to image coordinates system (inverted Y axis)
+                               const unsigned int y_ = (texParams.textureSide - 1) - y;
+                               // 1D pixel index
+                               unsigned int xyoffset = y_ * texParams.textureSide + x;
+                               // get 3D coordinates
+                               Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
+                               // get 2D coordinates in source image
+                               Point2d pixRC;
+                               mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
+                               // exclude out of bounds pixels
+                               if(!mp.isPixelInImage(pixRC, camId))
+                                   continue;
+
+                               // If the color is pure zero (ie. no contributions), we consider it as an invalid pixel.
+                               if(camImg.getInterpolateColor(pixRC) == Color(0.f, 0.f, 0.f))
+                                   continue;
+
+                               // Fill the accumulated pyramid for this pixel
+                               // each frequency band also contributes to lower frequencies (higher band indexes)
+                               for(std::size_t bandContrib = band; bandContrib < pyramidL.size(); ++bandContrib)
+                               {
+                                   int downscaleCoef = std::pow(texParams.multiBandDownscale, bandContrib);
+                                   AccuImage& accuImage = accuPyramid.pyramid[bandContrib];
+
+                                   // fill the accumulated color map for this pixel
+                                   accuImage.img[xyoffset] += pyramidL[bandContrib].getInterpolateColor(pixRC/downscaleCoef) * triangleScore;
+                                   accuImage.imgCount[xyoffset] += triangleScore;
+                               }
                            }
-                       }
+                        }
                     }
                 }
             }
         }
     }
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    for(const auto& deviceAtlas : deviceAtlases)
+    {
+        AccuPyramid& accuPyramid = accuPyramids.at(deviceAtlas.first);
+        for(int band = 0; band < accuPyramid.pyramid.size(); ++band)
+        {
+            AccuImage& accuImage = accuPyramid.pyramid[band];
+            if(!deviceAtlas.second->download(band, reinterpret_cast<float*>(accuImage.img.data().data()), accuImage.imgCount.data()))
+                throw std::runtime_error("Failed to copy the atlas " + std::to_string(deviceAtlas.first) + " from the device.");
+        }
+    }
+    deviceAtlases.clear();
+    deviceCamera.clear();
+#endif
+
     //calculate atlas texture in the first level of the pyramid (avoid creating a new buffer)
     //debug mode : write all the frequencies levels for each texture
-    for(std::size_t atlasID : atlasIDs)
+    //the atlases are finalized and written in parallel, the pixels of a single atlas are processed in parallel
+    std::exception_ptr exception;
+    #pragma omp parallel for schedule(dynamic) if(atlasIDs.size() > 1)
+    for(int a = 0; a < atlasIDs.size(); ++a)
     {
-        AccuPyramid& accuPyramid = accuPyramids.at(atlasID);
-        AccuImage& atlasTexture = accuPyramid.pyramid[0];
-        ALICEVISION_LOG_INFO("Create texture " << atlasID + 1);
+        const std::size_t atlasID = atlasIDs[a];
+        try
+        {
+            AccuPyramid& accuPyramid = accuPyramids.at(atlasID);
+            AccuImage& atlasTexture = accuPyramid.pyramid[0];
+            ALICEVISION_LOG_INFO("Create texture " << atlasID + 1);
 
 #if TEXTURING_MBB_DEBUG
-        {
-            // write the number of contribution per atlas frequency bands
-            if(!texParams.useScore)
             {
-                for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
+                // write the number of contribution per atlas frequency bands
+                if(!texParams.useScore)
                 {
-                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                    for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
+                    {
+                        AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
 
-                    //write the number of contributions for each texture
-                    std::vector<float> imgContrib(textureSize);
+                        //write the number of contributions for each texture
+                        std::vector<float> imgContrib(textureSize);
 
-                    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
-                    {
-                        unsigned int yoffset = yp * texParams.textureSide;
-                        for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
+                        for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
                         {
-                            unsigned int xyoffset = yoffset + xp;
-                            imgContrib[xyoffset] = atlasLevelTexture.imgCount[xyoffset];
+                            unsigned int yoffset = yp * texParams.textureSide;
+                            for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
+                            {
+                                unsigned int xyoffset = yoffset + xp;
+                                imgContrib[xyoffset] = atlasLevelTexture.imgCount[xyoffset];
+                            }
                         }
-                    }
 
-                    const std::string textureName = "contrib_" + std::to_string(1001 + atlasID) + std::string("_") + std::to_string(level) + std::string(".") + EImageFileType_enumToString(textureFileType); // starts at '1001' for UDIM compatibility
-                    bfs::path texturePath = outPath / textureName;
+                        const std::string textureName = "contrib_" + std::to_string(1001 + atlasID) + std::string("_") + std::to_string(level) + std::string(".") + EImageFileType_enumToString(textureFileType); // starts at '1001' for UDIM compatibility
+                        bfs::path texturePath = outPath / textureName;
 
-                    using namespace imageIO;
-                    OutputFileColorSpace colorspace(EImageColorSpace::SRGB, EImageColorSpace::AUTO);
-                    if(texParams.convertLAB)
-                        colorspace.from = EImageColorSpace::LAB;
-                    writeImage(texturePath.string(), texParams.textureSide, texParams.textureSide, imgContrib, EImageQuality::OPTIMIZED, colorspace);
+                        using namespace imageIO;
+                        OutputFileColorSpace colorspace(EImageColorSpace::SRGB, EImageColorSpace::AUTO);
+                        if(texParams.convertLAB)
+                            colorspace.from = EImageColorSpace::LAB;
+                        writeImage(texturePath.string(), texParams.textureSide, texParams.textureSide, imgContrib, EImageQuality::OPTIMIZED, colorspace);
+                    }
                 }
             }
-        }
 #endif
 
-        ALICEVISION_LOG_INFO("  - Computing final (average) color.");
-        for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
-        {
-            unsigned int yoffset = yp * texParams.textureSide;
-            for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
+            ALICEVISION_LOG_INFO("  - Computing final (average) color.");
+            #pragma omp parallel for
+            for(int yp = 0; yp < texSide; ++yp)
             {
-                unsigned int xyoffset = yoffset + xp;
+                unsigned int yoffset = yp * texParams.textureSide;
+                for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
+                {
+                    unsigned int xyoffset = yoffset + xp;
 
-                // If the imgCount is valid on the first band, it will be valid on all the other bands
-                if(atlasTexture.imgCount[xyoffset] == 0)
-                    continue;
+                    // If the imgCount is valid on the first band, it will be valid on all the other bands
+                    if(atlasTexture.imgCount[xyoffset] == 0)
+                        continue;
 
-                atlasTexture.img[xyoffset] /= atlasTexture.imgCount[xyoffset];
-                atlasTexture.imgCount[xyoffset] = 1;
+                    atlasTexture.img[xyoffset] /= atlasTexture.imgCount[xyoffset];
+                    atlasTexture.imgCount[xyoffset] = 1;
 
-                for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
-                {
-                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
-                    atlasLevelTexture.img[xyoffset] /= atlasLevelTexture.imgCount[xyoffset];
+                    for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
+                    {
+                        AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                        atlasLevelTexture.img[xyoffset] /= atlasLevelTexture.imgCount[xyoffset];
+                    }
                 }
             }
-        }
 
 #if TEXTURING_MBB_DEBUG
-        {
-            //write each frequency band, for each texture
-            for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
             {
-                AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
-                writeTexture(atlasLevelTexture, atlasID, outPath, textureFileType, level);
-            }
+                //write each frequency band, for each texture
+                for(std::size_t level = 0; level < accuPyramid.pyramid.size(); ++level)
+                {
+                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                    writeTexture(atlasLevelTexture, atlasID, outPath, textureFileType, level);
+                }
 
-        }
+            }
 #endif
 
-        // Fuse frequency bands into the first buffer, calculate final texture
-        for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
-        {
-            unsigned int yoffset = yp * texParams.textureSide;
-            for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
+            // Fuse frequency bands into the first buffer, calculate final texture
+            #pragma omp parallel for
+            for(int yp = 0; yp < texSide; ++yp)
             {
-                unsigned int xyoffset = yoffset + xp;
-                for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
+                unsigned int yoffset = yp * texParams.textureSide;
+                for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
                 {
-                    AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
-                    atlasTexture.img[xyoffset] += atlasLevelTexture.img[xyoffset];
+                    unsigned int xyoffset = yoffset + xp;
+                    for(std::size_t level = 1; level < accuPyramid.pyramid.size(); ++level)
+                    {
+                        AccuImage& atlasLevelTexture =  accuPyramid.pyramid[level];
+                        atlasTexture.img[xyoffset] += atlasLevelTexture.img[xyoffset];
+                    }
                 }
             }
+            // release the other bands before the padding and the writing
+            accuPyramid.pyramid.resize(1);
+            writeTexture(atlasTexture, atlasID, outPath, textureFileType, -1);
+            accuPyramid.pyramid.clear();
+        }
+        catch(...)
+        {
+            #pragma omp critical
+            exception = std::current_exception();
         }
-        writeTexture(atlasTexture, atlasID, outPath, textureFileType, -1);
     }
+    if(exception)
+        std::rethrow_exception(exception);
 }
 
 void Texturing::writeTexture(AccuImage& atlasTexture, const std::size_t atlasID, const boost::filesystem::path &outPath,
@@ -830,7 +1034,7 @@ void Texturing::writeTexture(AccuImage& atlasTexture, const std::size_t atlasID,
 
     using namespace imageIO;
     OutputFileColorSpace colorspace(texParams.processColorspace, EImageColorSpace::AUTO);
-    writeImage(texturePath.string(), atlasTexture.img, EImageQuality::OPTIMIZED, colorspace);
+    writeImageTiled(texturePath.string(), atlasTexture.img, EImageQuality::OPTIMIZED, colorspace);
 }
 
 
@@ -865,6 +1069,33 @@ void Texturing::loadFromOBJ(const std::string& filename, bool flipNormals)
         throw std::runtime_error("Unable to load: " + filename);
     }
 
+    initAfterLoading(flipNormals);
+}
+
+void Texturing::loadFromMeshFile(const std::string& filename, bool flipNormals)
+{
+    if(!isPlyFile(filename))
+    {
+        loadFromOBJ(filename, flipNormals);
+        return;
+    }
+
+    // Clear internal data
+    clear();
+    me = new Mesh();
+    // Load .ply, without materials nor UV coordinates
+    if(!me->loadFromPly(filename))
+    {
+        throw std::runtime_error("Unable to load: " + filename);
+    }
+    nmtls = 0;
+    trisMtlIds.resize_with(me->tris->size(), -1);
+
+    initAfterLoading(flipNormals);
+}
+
+void Texturing::initAfterLoading(bool flipNormals)
+{
     // Handle normals flipping
     if(flipNormals)
         me->invertTriangleOrientations();
@@ -904,8 +1135,8 @@ void Texturing::replaceMesh(const std::string& otherMeshPath, bool flipNormals)
     // set pointers to null to avoid deallocation by 'loadFromObj'
     me = nullptr;
     pointsVisibilities = nullptr;
-    // load input obj file
-    loadFromOBJ(otherMeshPath, flipNormals);
+    // load input mesh file
+    loadFromMeshFile(otherMeshPath, flipNormals);
     // allocate pointsVisibilities for new internal mesh
     pointsVisibilities = new PointsVisibility();
     // remap visibilities from reconstruction onto input mesh
@@ -923,6 +1154,9 @@ void Texturing::replaceMesh(const std::string& otherMeshPath, bool flipNormals)
 
 void Texturing::unwrap(mvsUtils::MultiViewParams& mp, EUnwrapMethod method)
 {
+    ALICEVISION_PROFILE_SCOPE("Texturing::unwrap");
+    const system::MemoryStage memoryStage("Texturing::unwrap");
+
     if(method == mesh::EUnwrapMethod::Basic)
     {
         // generate UV coordinates based on automatic uv atlas
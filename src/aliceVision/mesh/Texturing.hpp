@@ -81,6 +81,10 @@ struct TexturingParams
     unsigned int downscale = 1;
     bool fillHoles = false;
     bool useUDIM = true;
+    /// memory budget of the texture generation in MB, 0 for the available RAM
+    int maxMemory = 0;
+    /// accumulate the contributions of the cameras on the GPU (CUDA builds only)
+    bool useGpu = false;
 };
 
 struct Texturing
@@ -114,6 +118,9 @@ public:
     /// Load a mesh from a .obj file and initialize internal structures
     void loadFromOBJ(const std::string& filename, bool flipNormals=false);
 
+    /// Load a mesh from a binary .ply file (without UV coordinates) or from a .obj file
+    void loadFromMeshFile(const std::string& filename, bool flipNormals=false);
+
     /**
      * @brief Remap visibilities
      *
@@ -179,9 +186,13 @@ public:
     void generateTextures(const mvsUtils::MultiViewParams& mp,
                           const bfs::path &outPath, imageIO::EImageFileType textureFileType = imageIO::EImageFileType::PNG);
 
-    /// Generate texture files for the given sub-set of texture atlases
+    /**
+     * @brief Generate texture files for the given sub-set of texture atlases.
+     * The cameras are processed by windows of nbCamerasMax: their images and pyramids are computed in parallel,
+     * then the rows of the atlases are filled in parallel.
+     */
     void generateTexturesSubSet(const mvsUtils::MultiViewParams& mp,
-                         const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache,
+                         const std::vector<size_t>& atlasIDs, mvsUtils::ImagesCache& imageCache, int nbCamerasMax,
                          const bfs::path &outPath, imageIO::EImageFileType textureFileType = imageIO::EImageFileType::PNG);
 
     ///Fill holes and write texture files for the given texture atlas
@@ -190,6 +201,10 @@ public:
 
     /// Save textured mesh as an OBJ + MTL file
     void saveAsOBJ(const bfs::path& dir, const std::string& basename, imageIO::EImageFileType textureFileType = imageIO::EImageFileType::PNG);
+
+private:
+    /// Flip the loaded triangles if requested and fill the atlases from their materials
+    void initAfterLoading(bool flipNormals);
 };
 
 } // namespace mesh
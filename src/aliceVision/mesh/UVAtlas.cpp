@@ -92,64 +92,43 @@ void UVAtlas::packCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp)
 {
     ALICEVISION_LOG_INFO("Packing texture charts (" <<  charts.size() << " charts).");
 
-    function<int(int)> findChart = [&](int cid)
+    // find the chart of a triangle and compress the path of merged charts
+    const auto findChart = [&](int cid)
     {
-        Chart& c = charts[cid];
-        if(c.mergedWith >= 0)
+        int root = cid;
+        while(charts[root].mergedWith >= 0)
+            root = charts[root].mergedWith;
+        while(charts[cid].mergedWith >= 0)
         {
-            int r = findChart(c.mergedWith);
-            c.mergedWith = r;
-            return r;
+            const int next = charts[cid].mergedWith;
+            charts[cid].mergedWith = root;
+            cid = next;
         }
-        return cid;
+        return root;
     };
 
-    // list mesh edges (with duplicates)
-    vector<Edge> alledges;
-    for(int i = 0; i < _mesh.tris->size(); ++i)
-    {
-        int a = (*_mesh.tris)[i].v[0];
-        int b = (*_mesh.tris)[i].v[1];
-        int c = (*_mesh.tris)[i].v[2];
-        Edge e1;
-        e1.pointIDs = make_pair(min(a, b), max(a, b));
-        e1.triangleIDs.emplace_back(i);
-        alledges.emplace_back(e1);
-        Edge e2;
-        e2.pointIDs = make_pair(min(b, c), max(b, c));
-        e2.triangleIDs.emplace_back(i);
-        alledges.emplace_back(e2);
-        Edge e3;
-        e3.pointIDs = make_pair(min(c, a), max(c, a));
-        e3.triangleIDs.emplace_back(i);
-        alledges.emplace_back(e3);
-    }
-    sort(alledges.begin(), alledges.end());
-
-    // merge edges (no duplicate)
+    // list mesh edges with their triangle (with duplicates),
+    // once sorted the triangles sharing an edge are consecutive
     vector<Edge> edges;
-    auto eit = alledges.begin() + 1;
-    while(eit != alledges.end())
+    edges.reserve(3 * _mesh.tris->size());
+    for(int i = 0; i < _mesh.tris->size(); ++i)
     {
-        auto& a = *(eit-1);
-        auto& b = *eit;
-        if(a == b)
+        for(int k = 0; k < 3; ++k)
         {
-            a.triangleIDs.insert(a.triangleIDs.end(), b.triangleIDs.begin(), b.triangleIDs.end());
-            sort(a.triangleIDs.begin(), a.triangleIDs.end());
-            edges.push_back(a);
+            const int a = (*_mesh.tris)[i].v[k];
+            const int b = (*_mesh.tris)[i].v[(k + 1) % 3];
+            edges.push_back({make_pair(min(a, b), max(a, b)), i});
         }
-        ++eit;
     }
-    alledges.clear();
+    sort(edges.begin(), edges.end());
 
-    // merge charts
-    for(auto& e : edges)
+    // merge charts of the triangles sharing an edge
+    for(size_t e = 1; e < edges.size(); ++e)
     {
-        if(e.triangleIDs.size() != 2)
+        if(edges[e - 1].pointIDs != edges[e].pointIDs)
             continue;
-        int chartIDA = findChart(e.triangleIDs[0]);
-        int chartIDB = findChart(e.triangleIDs[1]);
+        int chartIDA = findChart(edges[e - 1].triangleID);
+        int chartIDB = findChart(edges[e].triangleID);
         if(chartIDA == chartIDB)
             continue;
         Chart& a = charts[chartIDA];
@@ -164,16 +143,20 @@ void UVAtlas::packCharts(vector<Chart>& charts, mvsUtils::MultiViewParams& mp)
         if(a.triangleIDs.size() > b.triangleIDs.size())
         {
             // merge b in a
-            a.commonCameraIDs = cameraIntersection;
+            a.commonCameraIDs = std::move(cameraIntersection);
             a.triangleIDs.insert(a.triangleIDs.end(), b.triangleIDs.begin(), b.triangleIDs.end());
             b.mergedWith = chartIDA;
+            vector<int>().swap(b.triangleIDs);
+            vector<int>().swap(b.commonCameraIDs);
         }
         else
         {
             // merge a in b
-            b.commonCameraIDs = cameraIntersection;
+            b.commonCameraIDs = std::move(cameraIntersection);
             b.triangleIDs.insert(b.triangleIDs.end(), a.triangleIDs.begin(), a.triangleIDs.end());
             a.mergedWith = chartIDB;
+            vector<int>().swap(a.triangleIDs);
+            vector<int>().swap(a.commonCameraIDs);
         }
     }
     edges.clear();
@@ -267,6 +250,7 @@ void UVAtlas::createTextureAtlases(vector<Chart>& charts, mvsUtils::MultiViewPar
         root->LU.y = 0;
         root->RD.x = _textureSide - 1;
         root->RD.y = _textureSide - 1;
+        root->updateFreeSpace();
 
         const auto insertChart = [&](size_t idx) -> bool
         {
@@ -279,8 +263,8 @@ void UVAtlas::createTextureAtlases(vector<Chart>& charts, mvsUtils::MultiViewPar
             chart.targetLU = rect->LU;
             chart.targetLU.x += _gutterSize;
             chart.targetLU.y += _gutterSize;
-            // add to the current texture atlas
-            atlas.emplace_back(chart);
+            // add to the current texture atlas, the chart is no longer read by the tree
+            atlas.emplace_back(std::move(chart));
             return true;
         };
         // insert as many charts as possible in forward direction (largest to smallest)
@@ -311,28 +295,55 @@ void UVAtlas::ChartRect::clear()
     delete child[1];
 }
 
+void UVAtlas::ChartRect::updateFreeSpace()
+{
+    if(child[0] || child[1]) // not a leaf
+    {
+        freeWidth = 0;
+        freeHeight = 0;
+        for(ChartRect* rect : child)
+        {
+            if(!rect)
+                continue;
+            freeWidth = std::max(freeWidth, rect->freeWidth);
+            freeHeight = std::max(freeHeight, rect->freeHeight);
+        }
+    }
+    else if(c)
+    {
+        freeWidth = 0;
+        freeHeight = 0;
+    }
+    else
+    {
+        freeWidth = RD.x - LU.x;
+        freeHeight = RD.y - LU.y;
+    }
+}
+
 UVAtlas::ChartRect* UVAtlas::ChartRect::insert(Chart& chart, size_t gutter)
 {
+    const int chartWidth = chart.targetWidth() + gutter * 2;
+    const int chartHeight = chart.targetHeight() + gutter * 2;
+    // no free rectangle large enough in this subtree
+    if(chartWidth > freeWidth || chartHeight > freeHeight)
+        return nullptr;
+
     if(child[0] || child[1]) // not a leaf
     {
+        ChartRect* rect = nullptr;
         if(child[0])
-            if(ChartRect* rect = child[0]->insert(chart, gutter))
-                return rect;
-        if(child[1])
-            if(ChartRect* rect = child[1]->insert(chart, gutter))
-                return rect;
-        return nullptr;
+            rect = child[0]->insert(chart, gutter);
+        if(!rect && child[1])
+            rect = child[1]->insert(chart, gutter);
+        if(rect)
+            updateFreeSpace();
+        return rect;
     }
     else
     {
-        size_t chartWidth = chart.targetWidth() + gutter * 2;
-        size_t chartHeight = chart.targetHeight() + gutter * 2;
         // if there is already a chart here
-        if(c) return nullptr;
-        // not enough space
-        if(chartWidth > (RD.x - LU.x))
-            return nullptr;
-        if(chartHeight > (RD.y - LU.y))
+        if(c)
             return nullptr;
         // split & create children
         if(chartWidth >= chartHeight)
@@ -373,8 +384,14 @@ UVAtlas::ChartRect* UVAtlas::ChartRect::insert(Chart& chart, size_t gutter)
                 child[1]->RD.y = RD.y;
             }
         }
+        for(ChartRect* rect : child)
+        {
+            if(rect)
+                rect->updateFreeSpace();
+        }
         // insert chart
         c = &chart;
+        updateFreeSpace();
         return this;
     }
 }
@@ -9,6 +9,7 @@
 #include <aliceVision/mvsData/StaticVector.hpp>
 #include <aliceVision/mesh/Mesh.hpp>
 
+#include <tuple>
 #include <vector>
 
 namespace aliceVision {
@@ -20,9 +21,8 @@ public:
     struct Edge
     {
         std::pair<int, int> pointIDs;
-        std::vector<int> triangleIDs;
-        bool operator<(const Edge& other) const { return pointIDs < other.pointIDs; }
-        bool operator==(const Edge& other) const { return pointIDs == other.pointIDs; }
+        int triangleID;
+        bool operator<(const Edge& other) const { return std::tie(pointIDs, triangleID) < std::tie(other.pointIDs, other.triangleID); }
     };
 
     struct Chart
@@ -52,7 +52,11 @@ public:
         ChartRect* child[2] {nullptr, nullptr};
         Pixel LU;
         Pixel RD;
+        int freeWidth = 0;                                      // largest free width in this subtree
+        int freeHeight = 0;                                     // largest free height in this subtree
         void clear();
+        /// Update the largest free sizes from the children, used to skip the full subtrees
+        void updateFreeSpace();
         ChartRect* insert(Chart& chart, size_t gutter);
     };
 
@@ -0,0 +1,378 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "textureRasterization.hpp"
+
+#include <cuda_runtime.h>
+
+#include <cfloat>
+
+namespace aliceVision {
+namespace mesh {
+namespace cuda {
+
+namespace {
+
+/// number of threads iterating over the pixels of one triangle
+constexpr int BLOCK_SIZE = 64;
+
+/**
+ * @brief Device pointers of the camera and atlas pyramids, given by value to the kernel
+ */
+struct PyramidsPointers
+{
+    /// camera image, used to discard the pixels without color
+    const float* image;
+    int imageWidth;
+    int imageHeight;
+
+    /// levels of the laplacian pyramid of the camera
+    const float* levels[MAX_DEVICE_BANDS];
+    int levelsWidths[MAX_DEVICE_BANDS];
+    int levelsHeights[MAX_DEVICE_BANDS];
+    float levelsScales[MAX_DEVICE_BANDS];
+
+    /// accumulated bands of the atlas
+    float* colors[MAX_DEVICE_BANDS];
+    float* weights[MAX_DEVICE_BANDS];
+    int nbBands;
+    int side;
+};
+
+/**
+ * @brief Bilinear interpolation of an RGB image, as Image::getInterpolateColor
+ */
+__device__ inline float3 interpolateColor(const float* image, int width, int height, float x, float y)
+{
+    const int xp = min(static_cast<int>(x), width - 2);
+    const int yp = min(static_cast<int>(y), height - 2);
+    const float ui = x - static_cast<float>(xp);
+    const float vi = y - static_cast<float>(yp);
+
+    const float* lu = image + 3 * (yp * width + xp);
+    const float* ru = lu + 3;
+    const float* ld = lu + 3 * width;
+    const float* rd = ld + 3;
+
+    float out[3];
+    for(int k = 0; k < 3; ++k)
+    {
+        const float u = lu[k] + (ru[k] - lu[k]) * ui;
+        const float d = ld[k] + (rd[k] - ld[k]) * ui;
+        out[k] = u + (d - u) * vi;
+    }
+    return make_float3(out[0], out[1], out[2]);
+}
+
+__device__ inline float dot2(float ax, float ay, float bx, float by)
+{
+    return ax * bx + ay * by;
+}
+
+/**
+ * @brief Closest point of a 2D triangle to a point, as GEO::Geom::point_triangle_squared_distance
+ * @param[out] l Barycentric coordinates of the closest point
+ * @return the squared distance to the closest point
+ */
+__device__ float pointTriangleSquaredDistance(float px, float py, const float uv[3][2], float l[3])
+{
+    const float abx = uv[1][0] - uv[0][0], aby = uv[1][1] - uv[0][1];
+    const float acx = uv[2][0] - uv[0][0], acy = uv[2][1] - uv[0][1];
+
+    const float d1 = dot2(abx, aby, px - uv[0][0], py - uv[0][1]);
+    const float d2 = dot2(acx, acy, px - uv[0][0], py - uv[0][1]);
+    const float d3 = dot2(abx, aby, px - uv[1][0], py - uv[1][1]);
+    const float d4 = dot2(acx, acy, px - uv[1][0], py - uv[1][1]);
+    const float d5 = dot2(abx, aby, px - uv[2][0], py - uv[2][1]);
+    const float d6 = dot2(acx, acy, px - uv[2][0], py - uv[2][1]);
+    const float va = d3 * d6 - d5 * d4;
+    const float vb = d5 * d2 - d1 * d6;
+    const float vc = d1 * d4 - d3 * d2;
+
+    if(d1 <= 0.f && d2 <= 0.f)
+    {
+        l[0] = 1.f; l[1] = 0.f; l[2] = 0.f;
+    }
+    else if(d3 >= 0.f && d4 <= d3)
+    {
+        l[0] = 0.f; l[1] = 1.f; l[2] = 0.f;
+    }
+    else if(d6 >= 0.f && d5 <= d6)
+    {
+        l[0] = 0.f; l[1] = 0.f; l[2] = 1.f;
+    }
+    else if(vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+    {
+        const float v = d1 / (d1 - d3);
+        l[0] = 1.f - v; l[1] = v; l[2] = 0.f;
+    }
+    else if(vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+    {
+        const float w = d2 / (d2 - d6);
+        l[0] = 1.f - w; l[1] = 0.f; l[2] = w;
+    }
+    else if(va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+    {
+        const float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        l[0] = 0.f; l[1] = 1.f - w; l[2] = w;
+    }
+    else
+    {
+        const float denom = 1.f / (va + vb + vc);
+        l[1] = vb * denom;
+        l[2] = vc * denom;
+        l[0] = 1.f - l[1] - l[2];
+    }
+
+    const float cx = l[0] * uv[0][0] + l[1] * uv[1][0] + l[2] * uv[2][0];
+    const float cy = l[0] * uv[0][1] + l[1] * uv[1][1] + l[2] * uv[2][1];
+    return (px - cx) * (px - cx) + (py - cy) * (py - cy);
+}
+
+/**
+ * @brief Rasterize one triangle per block, the threads iterate over the pixels of its bounding box.
+ */
+__global__ void rasterizeTrianglesKernel(const DeviceTriangle* triangles, int band, int border, PyramidsPointers pyramids)
+{
+    const DeviceTriangle& triangle = triangles[blockIdx.x];
+    const int bboxWidth = triangle.bbox[2] - triangle.bbox[0];
+    const int bboxHeight = triangle.bbox[3] - triangle.bbox[1];
+    if(bboxWidth <= 0 || bboxHeight <= 0)
+        return;
+
+    for(int p = threadIdx.x; p < bboxWidth * bboxHeight; p += blockDim.x)
+    {
+        const int x = triangle.bbox[0] + p % bboxWidth;
+        const int y = triangle.bbox[1] + p / bboxWidth;
+
+        // test if the pixel center is inside the triangle, with a tolerance for the pixels on the edges
+        float l[3];
+        if(!(pointTriangleSquaredDistance(x + 0.5f, y + 0.5f, triangle.uv, l) < 0.5f + FLT_EPSILON))
+            continue;
+
+        // the projection is linear before the perspective division
+        float proj[3];
+        for(int k = 0; k < 3; ++k)
+            proj[k] = l[0] * triangle.proj[0][k] + l[1] * triangle.proj[1][k] + l[2] * triangle.proj[2][k];
+        if(proj[2] <= 0.f)
+            continue;
+        const float camX = proj[0] / proj[2];
+        const float camY = proj[1] / proj[2];
+
+        // exclude out of bounds pixels
+        const int pixX = static_cast<int>(floorf(camX + 0.5f));
+        const int pixY = static_cast<int>(floorf(camY + 0.5f));
+        if(pixX < border || pixX >= pyramids.imageWidth - border || pixY < border || pixY >= pyramids.imageHeight - border)
+            continue;
+
+        // If the color is pure zero (ie. no contributions), we consider it as an invalid pixel.
+        const float3 color = interpolateColor(pyramids.image, pyramids.imageWidth, pyramids.imageHeight, camX, camY);
+        if(color.x == 0.f && color.y == 0.f && color.z == 0.f)
+            continue;
+
+        // remap 'y' to image coordinates system (inverted Y axis)
+        const int offset = (pyramids.side - 1 - y) * pyramids.side + x;
+
+        // each frequency band also contributes to lower frequencies (higher band indexes)
+        for(int b = band; b < pyramids.nbBands; ++b)
+        {
+            const float scale = pyramids.levelsScales[b];
+            const float3 bandColor = interpolateColor(pyramids.levels[b], pyramids.levelsWidths[b], pyramids.levelsHeights[b],
+                                                      camX / scale, camY / scale);
+            atomicAdd(&pyramids.colors[b][3 * offset], bandColor.x * triangle.score);
+            atomicAdd(&pyramids.colors[b][3 * offset + 1], bandColor.y * triangle.score);
+            atomicAdd(&pyramids.colors[b][3 * offset + 2], bandColor.z * triangle.score);
+            atomicAdd(&pyramids.weights[b][offset], triangle.score);
+        }
+    }
+}
+
+/**
+ * @brief Device buffer released at the end of the scope
+ */
+struct DeviceBuffer
+{
+    void* data = nullptr;
+
+    ~DeviceBuffer()
+    {
+        if(data != nullptr)
+            cudaFree(data);
+    }
+
+    bool allocate(std::size_t size)
+    {
+        return cudaMalloc(&data, size) == cudaSuccess;
+    }
+};
+
+} // namespace
+
+bool supportTextureRasterization(int nbBands)
+{
+    if(nbBands <= 0 || nbBands > MAX_DEVICE_BANDS)
+        return false;
+
+    int nbDevices = 0;
+    return (cudaGetDeviceCount(&nbDevices) == cudaSuccess) && (nbDevices > 0);
+}
+
+DeviceCamera::~DeviceCamera()
+{
+    clear();
+}
+
+bool DeviceCamera::upload(const std::vector<const float*>& images, const std::vector<int>& widths, const std::vector<int>& heights)
+{
+    if(images.size() > _images.size())
+    {
+        _images.resize(images.size(), nullptr);
+        _capacities.resize(images.size(), 0);
+    }
+    _widths = widths;
+    _heights = heights;
+
+    for(std::size_t i = 0; i < images.size(); ++i)
+    {
+        const std::size_t size = 3 * sizeof(float) * static_cast<std::size_t>(widths[i]) * static_cast<std::size_t>(heights[i]);
+        if(size > _capacities[i])
+        {
+            if(_images[i] != nullptr)
+                cudaFree(_images[i]);
+            _capacities[i] = 0;
+            if(cudaMalloc(&_images[i], size) != cudaSuccess)
+            {
+                _images[i] = nullptr;
+                clear();
+                return false;
+            }
+            _capacities[i] = size;
+        }
+        if(cudaMemcpy(_images[i], images[i], size, cudaMemcpyHostToDevice) != cudaSuccess)
+        {
+            clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+void DeviceCamera::clear()
+{
+    for(float* image : _images)
+    {
+        if(image != nullptr)
+            cudaFree(image);
+    }
+    _images.clear();
+    _capacities.clear();
+    _widths.clear();
+    _heights.clear();
+}
+
+DeviceAtlasPyramid::~DeviceAtlasPyramid()
+{
+    clear();
+}
+
+bool DeviceAtlasPyramid::allocate(int nbBands, int side)
+{
+    clear();
+
+    const std::size_t nbPixels = static_cast<std::size_t>(side) * static_cast<std::size_t>(side);
+    for(int b = 0; b < nbBands; ++b)
+    {
+        float* colors = nullptr;
+        float* weights = nullptr;
+        if(cudaMalloc(&colors, 3 * nbPixels * sizeof(float)) != cudaSuccess)
+        {
+            clear();
+            return false;
+        }
+        _colors.push_back(colors);
+        if(cudaMalloc(&weights, nbPixels * sizeof(float)) != cudaSuccess)
+        {
+            clear();
+            return false;
+        }
+        _weights.push_back(weights);
+
+        if(cudaMemset(colors, 0, 3 * nbPixels * sizeof(float)) != cudaSuccess ||
+           cudaMemset(weights, 0, nbPixels * sizeof(float)) != cudaSuccess)
+        {
+            clear();
+            return false;
+        }
+    }
+    _side = side;
+    return true;
+}
+
+bool DeviceAtlasPyramid::download(int band, float* colors, float* weights) const
+{
+    const std::size_t nbPixels = static_cast<std::size_t>(_side) * static_cast<std::size_t>(_side);
+    return (cudaMemcpy(colors, _colors[band], 3 * nbPixels * sizeof(float), cudaMemcpyDeviceToHost) == cudaSuccess) &&
+           (cudaMemcpy(weights, _weights[band], nbPixels * sizeof(float), cudaMemcpyDeviceToHost) == cudaSuccess);
+}
+
+void DeviceAtlasPyramid::clear()
+{
+    for(float* colors : _colors)
+        cudaFree(colors);
+    for(float* weights : _weights)
+        cudaFree(weights);
+    _colors.clear();
+    _weights.clear();
+    _side = 0;
+}
+
+bool rasterizeTriangles(const DeviceCamera& camera,
+                        int border,
+                        const DeviceTriangle* triangles,
+                        int nbTriangles,
+                        int band,
+                        unsigned int downscale,
+                        DeviceAtlasPyramid& atlas)
+{
+    if(nbTriangles <= 0)
+        return true;
+
+    // the camera image, then one level per band
+    if(atlas.nbBands() > MAX_DEVICE_BANDS || camera.nbImages() != atlas.nbBands() + 1)
+        return false;
+
+    PyramidsPointers pyramids;
+    pyramids.image = camera.image(0);
+    pyramids.imageWidth = camera.width(0);
+    pyramids.imageHeight = camera.height(0);
+    float scale = 1.f;
+    for(int b = 0; b < atlas.nbBands(); ++b)
+    {
+        pyramids.levels[b] = camera.image(b + 1);
+        pyramids.levelsWidths[b] = camera.width(b + 1);
+        pyramids.levelsHeights[b] = camera.height(b + 1);
+        pyramids.levelsScales[b] = scale;
+        pyramids.colors[b] = atlas.colors(b);
+        pyramids.weights[b] = atlas.weights(b);
+        scale *= static_cast<float>(downscale);
+    }
+    pyramids.nbBands = atlas.nbBands();
+    pyramids.side = atlas.side();
+
+    DeviceBuffer deviceTriangles;
+    if(!deviceTriangles.allocate(nbTriangles * sizeof(DeviceTriangle)))
+        return false;
+    if(cudaMemcpy(deviceTriangles.data, triangles, nbTriangles * sizeof(DeviceTriangle), cudaMemcpyHostToDevice) != cudaSuccess)
+        return false;
+
+    rasterizeTrianglesKernel<<<nbTriangles, BLOCK_SIZE>>>(static_cast<const DeviceTriangle*>(deviceTriangles.data), band, border, pyramids);
+
+    return (cudaGetLastError() == cudaSuccess) && (cudaDeviceSynchronize() == cudaSuccess);
+}
+
+} // namespace cuda
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,147 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+namespace cuda {
+
+/// maximum number of frequency bands of the multi-band blending on the GPU
+constexpr int MAX_DEVICE_BANDS = 16;
+
+/**
+ * @brief Check if the textures can be rasterized on the GPU.
+ * @param[in] nbBands The number of frequency bands of the multi-band blending
+ * @return true if a CUDA device is available and the number of bands is supported
+ */
+bool supportTextureRasterization(int nbBands);
+
+/**
+ * @brief Triangle to rasterize in an atlas
+ */
+struct DeviceTriangle
+{
+    /// UV coordinates of the vertices in the texture pixels (Y axis up)
+    float uv[3][2];
+    /// projection of the vertices in the camera, before the perspective division (P * X)
+    float proj[3][3];
+    /// pixels bounding box in the texture, clamped to the texture: x begin, y begin, x end, y end
+    int bbox[4];
+    /// weight of the contribution
+    float score;
+};
+
+/**
+ * @brief Camera image and its laplacian pyramid stored on the current CUDA device
+ */
+class DeviceCamera
+{
+public:
+    DeviceCamera() = default;
+    ~DeviceCamera();
+
+    DeviceCamera(const DeviceCamera&) = delete;
+    DeviceCamera& operator=(const DeviceCamera&) = delete;
+
+    /**
+     * @brief Copy the images on the current CUDA device, the buffers are reused between the cameras
+     * @param[in] images The camera image then the levels of its laplacian pyramid, 3 floats (RGB) per pixel row by row
+     * @param[in] widths The width of each image
+     * @param[in] heights The height of each image
+     * @return false if the device memory can't be allocated
+     */
+    bool upload(const std::vector<const float*>& images, const std::vector<int>& widths, const std::vector<int>& heights);
+
+    /// Release the device memory
+    void clear();
+
+    inline int nbImages() const { return static_cast<int>(_images.size()); }
+    inline const float* image(int i) const { return _images[i]; }
+    inline int width(int i) const { return _widths[i]; }
+    inline int height(int i) const { return _heights[i]; }
+
+private:
+    std::vector<float*> _images;
+    std::vector<std::size_t> _capacities;
+    std::vector<int> _widths;
+    std::vector<int> _heights;
+};
+
+/**
+ * @brief Accumulated colors and weights of the frequency bands of an atlas, stored on the current CUDA device
+ */
+class DeviceAtlasPyramid
+{
+public:
+    DeviceAtlasPyramid() = default;
+    ~DeviceAtlasPyramid();
+
+    DeviceAtlasPyramid(const DeviceAtlasPyramid&) = delete;
+    DeviceAtlasPyramid& operator=(const DeviceAtlasPyramid&) = delete;
+
+    /**
+     * @brief Allocate the zeroed buffers of the pyramid on the current CUDA device
+     * @param[in] nbBands The number of frequency bands
+     * @param[in] side The side of the texture in pixels
+     * @return false if the device memory can't be allocated
+     */
+    bool allocate(int nbBands, int side);
+
+    /**
+     * @brief Copy a frequency band to the host
+     * @param[in] band The frequency band
+     * @param[out] colors The accumulated colors, 3 floats (RGB) per pixel
+     * @param[out] weights The accumulated weights, one per pixel
+     * @return false if the copy failed
+     */
+    bool download(int band, float* colors, float* weights) const;
+
+    /// Release the device memory
+    void clear();
+
+    inline int nbBands() const { return static_cast<int>(_colors.size()); }
+    inline int side() const { return _side; }
+    inline float* colors(int band) const { return _colors[band]; }
+    inline float* weights(int band) const { return _weights[band]; }
+
+private:
+    std::vector<float*> _colors;
+    std::vector<float*> _weights;
+    int _side = 0;
+};
+
+/**
+ * @brief Rasterize triangles in the UV space of an atlas and accumulate the camera contributions on the GPU.
+ *
+ * One block per triangle iterates over the pixels of its bounding box, as the CPU rasterization does:
+ * a pixel is filled if its center is at less than 1/2 pixel of the triangle, the camera pixel is
+ * interpolated from the projections of the vertices, and each frequency band also contributes to the
+ * lower frequencies. The contributions are summed with atomic additions, their order is not fixed.
+ *
+ * @param[in] camera The camera image and its laplacian pyramid
+ * @param[in] border The margin of the camera images, the pixels out of it are not used
+ * @param[in] triangles The triangles (host memory)
+ * @param[in] nbTriangles The number of triangles
+ * @param[in] band The frequency band of the triangles
+ * @param[in] downscale The downscale factor between the levels of the pyramid
+ * @param[in,out] atlas The accumulated pyramid of the atlas
+ * @return false if the computation can't run on the device
+ */
+bool rasterizeTriangles(const DeviceCamera& camera,
+                        int border,
+                        const DeviceTriangle* triangles,
+                        int nbTriangles,
+                        int band,
+                        unsigned int downscale,
+                        DeviceAtlasPyramid& atlas);
+
+} // namespace cuda
+} // namespace mesh
+} // namespace aliceVision
@@ -9,28 +9,72 @@
 
 #include <aliceVision/system/Logger.hpp>
 
+#include "nanoflann.hpp"
+
 #include <geogram/basic/permutation.h>
 #include <geogram/basic/attributes.h>
-#include <geogram/points/kd_tree.h>
 #include <geogram/mesh/mesh_AABB.h>
 #include <geogram/mesh/mesh_reorder.h>
 
+#include <vector>
 
 namespace aliceVision {
 namespace mesh {
 
+namespace {
+
+/// maximum number of points in the leaves of the kd-tree
+const std::size_t MAX_LEAF_ELEMENTS = 10;
+
+/**
+ * @brief nanoflann dataset adaptor on the points of a mesh.
+ */
+struct MeshPointsAdaptator
+{
+    using Derived = MeshPointsAdaptator;
+    using T = double;
+
+    const StaticVector<Point3d>& _data;
+    explicit MeshPointsAdaptator(const StaticVector<Point3d>& data)
+        : _data(data)
+    {}
+
+    inline const Derived& derived() const { return *this; }
+    inline size_t kdtree_get_point_count() const { return _data.size(); }
+    inline T kdtree_get_pt(const size_t idx, int dim) const { return _data[idx].m[dim]; }
+    template <class BBOX>
+    bool kdtree_get_bbox(BBOX&) const { return false; }
+};
+
+using MeshPointsKdTree = nanoflann::KDTreeSingleIndexAdaptor<
+    nanoflann::L2_Simple_Adaptor<double, MeshPointsAdaptator>,
+    MeshPointsAdaptator,
+    3 /* dim */
+    >;
+
+} // namespace
+
 int getNearestVertices(const Mesh& refMesh, const Mesh& mesh, StaticVector<int>& out_nearestVertex)
 {
     ALICEVISION_LOG_DEBUG("getNearestVertices start.");
     out_nearestVertex.resize(mesh.pts->size(), -1);
+    if(refMesh.pts->empty())
+        return 0;
 
-    GEO::AdaptiveKdTree refMesh_kdTree(3);
-    refMesh_kdTree.set_points(refMesh.pts->size(), refMesh.pts->front().m);
+    const MeshPointsAdaptator refPoints(*refMesh.pts);
+    MeshPointsKdTree refMesh_kdTree(3 /*dim*/, refPoints, nanoflann::KDTreeSingleIndexAdaptorParams(MAX_LEAF_ELEMENTS));
+    refMesh_kdTree.buildIndex();
 
-    #pragma omp parallel for
+    // the queries only read the kd-tree and each one writes its own result
+    #pragma omp parallel for schedule(dynamic, 4096)
     for(int i = 0; i < mesh.pts->size(); ++i)
     {
-        out_nearestVertex[i] = refMesh_kdTree.get_nearest_neighbor((*mesh.pts)[i].m);
+        std::size_t nearestIndex = 0;
+        double dist2 = 0.0;
+        nanoflann::KNNResultSet<double, std::size_t> resultSet(1);
+        resultSet.init(&nearestIndex, &dist2);
+        if(refMesh_kdTree.findNeighbors(resultSet, (*mesh.pts)[i].m, nanoflann::SearchParams()))
+            out_nearestVertex[i] = int(nearestIndex);
     }
     ALICEVISION_LOG_DEBUG("getNearestVertices done.");
     return 0;
@@ -43,8 +87,8 @@ void remapMeshVisibilities_pullVerticesVisibility(
 {
     ALICEVISION_LOG_DEBUG("remapMeshVisibility based on closest vertex start.");
 
-    GEO::AdaptiveKdTree refMesh_kdTree(3);
-    refMesh_kdTree.set_points(refMesh.pts->size(), refMesh.pts->front().m);
+    StaticVector<int> nearestVertex;
+    getNearestVertices(refMesh, mesh, nearestVertex);
 
     out_ptsVisibilities.resize(mesh.pts->size(), nullptr);
 
@@ -57,8 +101,7 @@ void remapMeshVisibilities_pullVerticesVisibility(
             pOut = new StaticVector<int>();
             out_ptsVisibilities[i] = pOut; // give ownership
         }
-
-        int iRef = refMesh_kdTree.get_nearest_neighbor((*mesh.pts)[i].m);
+        const int iRef = nearestVertex[i];
         if(iRef == -1)
             continue;
         PointVisibility* pRef = refPtsVisibilities[iRef];
@@ -109,11 +152,14 @@ void remapMeshVisibilities_pushVerticesVisibilityToTriangles(
         }
     }
 
-    #pragma omp parallel for
-    for (int rvi = 0; rvi < refMesh.pts->size(); ++rvi)
+    // nearest facet of each reference vertex, NO_FACET if it is too far from the mesh
+    const int nbRefPts = refMesh.pts->size();
+    std::vector<GEO::index_t> refPtsFacet(nbRefPts, GEO::NO_FACET);
+
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for (int rvi = 0; rvi < nbRefPts; ++rvi)
     {
-        PointVisibility* rpVis = refPtsVisibilities[rvi];
-        if (rpVis == nullptr)
+        if (refPtsVisibilities[rvi] == nullptr)
             continue;
 
         const GEO::vec3 rp((*refMesh.pts)[rvi].m);
@@ -129,23 +175,130 @@ void remapMeshVisibilities_pushVerticesVisibilityToTriangles(
         if(std::sqrt(dist2) > avgEdgeLength)
             continue;
 
-        #pragma omp critical
+        refPtsFacet[rvi] = f;
+    }
+
+    // reference vertices pushed to each vertex of the mesh, so the vertices are filled without lock
+    MeshAdjacency pushedRefPts;
+    pushedRefPts.offsets.assign(mesh.pts->size() + 1, 0);
+    for (int rvi = 0; rvi < nbRefPts; ++rvi)
+    {
+        const GEO::index_t f = refPtsFacet[rvi];
+        if (f == GEO::NO_FACET)
+            continue;
+        for (int i = 0; i < 3; ++i)
         {
+            GEO::index_t v = meshG.facets.vertex(f, i);
+            if (v != GEO::NO_VERTEX)
+                ++pushedRefPts.offsets[reorderedVertices[v] + 1];
+        }
+    }
+    for (int vi = 0; vi < mesh.pts->size(); ++vi)
+        pushedRefPts.offsets[vi + 1] += pushedRefPts.offsets[vi];
+    pushedRefPts.values.resize(pushedRefPts.offsets.back());
+    {
+        std::vector<std::size_t> fillOffsets(pushedRefPts.offsets.begin(), pushedRefPts.offsets.end() - 1);
+        for (int rvi = 0; rvi < nbRefPts; ++rvi)
+        {
+            const GEO::index_t f = refPtsFacet[rvi];
+            if (f == GEO::NO_FACET)
+                continue;
             for (int i = 0; i < 3; ++i)
             {
                 GEO::index_t v = meshG.facets.vertex(f, i);
-                if (v == GEO::NO_VERTEX)
-                    continue;
-                PointVisibility* pOut = out_ptsVisibilities[reorderedVertices[v]];
-                
-                for(int j = 0; j < rpVis->size(); ++j)
-                    pOut->push_back_distinct((*rpVis)[j]);
+                if (v != GEO::NO_VERTEX)
+                    pushedRefPts.values[fillOffsets[reorderedVertices[v]]++] = rvi;
             }
         }
     }
 
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for (int vi = 0; vi < mesh.pts->size(); ++vi)
+    {
+        PointVisibility* pOut = out_ptsVisibilities[vi];
+        for (const int* rvi = pushedRefPts.begin(vi); rvi != pushedRefPts.end(vi); ++rvi)
+        {
+            const PointVisibility* rpVis = refPtsVisibilities[*rvi];
+            for(int j = 0; j < rpVis->size(); ++j)
+                pOut->push_back_distinct((*rpVis)[j]);
+        }
+    }
+
     ALICEVISION_LOG_INFO("remapMeshVisibility done.");
 }
 
+StaticVector<StaticVector<int>*>* computeTrisCams(const Mesh& mesh, const mvsUtils::MultiViewParams& mp)
+{
+    ALICEVISION_LOG_INFO("Compute the cameras of " << mesh.tris->size() << " triangles.");
+
+    const int nbTris = mesh.tris->size();
+    std::vector<Point3d> trisCenters(nbTris);
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
+        trisCenters[i] = mesh.computeTriangleCenterOfGravity(i);
+
+    // the AABB tree only reorders its own copy of the mesh, the triangles indexes are not used
+    GEO::initialize();
+    GEO::Mesh meshG;
+    toGeoMesh(mesh, meshG);
+    const GEO::MeshFacetsAABB meshAABB(meshG);
+
+    std::vector<std::vector<int>> camsVisTris(mp.ncams);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int rc = 0; rc < mp.ncams; ++rc)
+    {
+        const Point3d& cam = mp.CArr[rc];
+        const GEO::vec3 camG(cam.m);
+        std::vector<int>& visTris = camsVisTris[rc];
+        for(int i = 0; i < nbTris; ++i)
+        {
+            const Point3d& center = trisCenters[i];
+            if(!mp.is3DPointInFrontOfCam(&center, rc))
+                continue;
+            Pixel pix;
+            mp.getPixelFor3DPoint(&pix, center, rc);
+            if(!mp.isPixelInImage(pix, rc, 1))
+                continue;
+
+            // stop the segment before the triangle, so it does not intersect the triangle itself or its neighbors
+            const Point3d toCam = cam - center;
+            const double dist = toCam.size();
+            const double margin = 2.0 * mp.getCamPixelSize(center, rc);
+            if(dist <= margin)
+                continue;
+            const Point3d end = center + toCam * (margin / dist);
+            if(!meshAABB.segment_intersection(camG, GEO::vec3(end.m)))
+                visTris.push_back(i);
+        }
+    }
+
+    std::vector<int> nbTrisCams(nbTris, 0);
+    for(const std::vector<int>& visTris : camsVisTris)
+    {
+        for(int i : visTris)
+            ++nbTrisCams[i];
+    }
+
+    StaticVector<StaticVector<int>*>* trisCams = new StaticVector<StaticVector<int>*>();
+    trisCams->resize(nbTris, nullptr);
+    for(int i = 0; i < nbTris; ++i)
+    {
+        if(nbTrisCams[i] > 0)
+        {
+            (*trisCams)[i] = new StaticVector<int>();
+            (*trisCams)[i]->reserve(nbTrisCams[i]);
+        }
+    }
+    for(int rc = 0; rc < mp.ncams; ++rc)
+    {
+        for(int i : camsVisTris[rc])
+            (*trisCams)[i]->push_back(rc);
+    }
+
+    ALICEVISION_LOG_INFO("Compute the cameras of the triangles done.");
+    return trisCams;
+}
+
 } // namespace mesh
 } // namespace aliceVision
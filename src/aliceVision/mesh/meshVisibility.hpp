@@ -8,6 +8,7 @@
 
 #include <aliceVision/mesh/Mesh.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
 
 namespace aliceVision {
 namespace mesh {
@@ -52,6 +53,17 @@ void remapMeshVisibilities_pushVerticesVisibilityToTriangles(
     const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
     const Mesh& mesh, PointsVisibility& out_ptsVisibilities);
 
+/**
+ * @brief Compute the cameras seeing each triangle of the mesh.
+ * A camera sees a triangle if the center of the triangle projects in the image and if the segment
+ * from the camera center to the triangle does not cross the mesh.
+ * The occlusions are tested on one AABB tree of the triangles, shared by the cameras processed in parallel.
+ *
+ * @param[in] mesh input mesh
+ * @param[in] mp the cameras
+ * @return the list of cameras seeing each triangle, nullptr for the triangles seen by no camera
+ */
+StaticVector<StaticVector<int>*>* computeTrisCams(const Mesh& mesh, const mvsUtils::MultiViewParams& mp);
 
 } // namespace mesh
 } // namespace aliceVision
@@ -13,7 +13,7 @@
 
 namespace aliceVision {
 
-Mat FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2) {
+Mat94 FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2) {
   Eigen::Matrix<double,9, 9> A;
   A.setZero();  // Make A square until Eigen supports rectangular SVD.
   fundamental::kernel::EncodeEpipolarEquation(x1, x2, &A);
@@ -21,8 +21,8 @@ Mat FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2) {
   return svd.matrixV().topRightCorner<9,4>();
 }
 
-Vec o1(const Vec &a, const Vec &b) {
-  Vec res = Vec::Zero(20);
+Vec20 o1(const Vec20 &a, const Vec20 &b) {
+  Vec20 res = Vec20::Zero();
 
   res(coef_xx) = a(coef_x) * b(coef_x);
   res(coef_xy) = a(coef_x) * b(coef_y)
@@ -44,8 +44,8 @@ Vec o1(const Vec &a, const Vec &b) {
   return res;
 }
 
-Vec o2(const Vec &a, const Vec &b) {
-  Vec res(20);
+Vec20 o2(const Vec20 &a, const Vec20 &b) {
+  Vec20 res;
 
   res(coef_xxx) = a(coef_xx) * b(coef_x);
   res(coef_xxy) = a(coef_xx) * b(coef_y)
@@ -91,12 +91,12 @@ Vec o2(const Vec &a, const Vec &b) {
   return res;
 }
 
-Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
+Mat1020 FivePointsPolynomialConstraints(const Mat94 &E_basis) {
   // Build the polynomial form of E (equation (8) in Stewenius et al. [1])
-  Vec E[3][3];
+  Vec20 E[3][3];
   for (int i = 0; i < 3; ++i) {
     for (int j = 0; j < 3; ++j) {
-      E[i][j] = Vec::Zero(20);
+      E[i][j] = Vec20::Zero();
       E[i][j](coef_x) = E_basis(3 * i + j, 0);
       E[i][j](coef_y) = E_basis(3 * i + j, 1);
       E[i][j](coef_z) = E_basis(3 * i + j, 2);
@@ -105,7 +105,7 @@ Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
   }
 
   // The constraint matrix.
-  Mat M(10, 20);
+  Mat1020 M;
   int mrow = 0;
 
   // Determinant constraint det(E) = 0; equation (19) of Nister [2].
@@ -115,7 +115,7 @@ Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
 
   // Cubic singular values constraint.
   // Equation (20).
-  Vec EET[3][3];
+  Vec20 EET[3][3];
   for (int i = 0; i < 3; ++i) {    // Since EET is symmetric, we only compute
     for (int j = 0; j < 3; ++j) {  // its upper triangular part.
       if (i <= j) {
@@ -129,8 +129,8 @@ Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
   }
 
   // Equation (21).
-  Vec (&L)[3][3] = EET;
-  Vec trace  = 0.5 * (EET[0][0] + EET[1][1] + EET[2][2]);
+  Vec20 (&L)[3][3] = EET;
+  Vec20 trace  = 0.5 * (EET[0][0] + EET[1][1] + EET[2][2]);
   for (int i = 0; i < 3; ++i) {
     L[i][i] -= trace;
   }
@@ -138,7 +138,7 @@ Mat FivePointsPolynomialConstraints(const Mat &E_basis) {
   // Equation (23).
   for (int i = 0; i < 3; ++i) {
     for (int j = 0; j < 3; ++j) {
-      Vec LEij = o2(L[i][0], E[0][j])
+      Vec20 LEij = o2(L[i][0], E[0][j])
                + o2(L[i][1], E[1][j])
                + o2(L[i][2], E[2][j]);
       M.row(mrow++) = LEij;
@@ -152,10 +152,10 @@ void FivePointsRelativePose(const Mat2X &x1,
                             const Mat2X &x2,
                             std::vector<Mat3> *Es) {
   // Step 1: Nullspace Extraction.
-  const Eigen::Matrix<double, 9, 4> E_basis = FivePointsNullspaceBasis(x1, x2);
+  const Mat94 E_basis = FivePointsNullspaceBasis(x1, x2);
 
   // Step 2: Constraint Expansion.
-  const Eigen::Matrix<double, 10, 20> E_constraints = FivePointsPolynomialConstraints(E_basis);
+  const Mat1020 E_constraints = FivePointsPolynomialConstraints(E_basis);
 
   // Step 3: Gauss-Jordan Elimination (done thanks to a LU decomposition).
   typedef Eigen::Matrix<double, 10, 10> Mat10;
@@ -14,6 +14,13 @@
 
 namespace aliceVision {
 
+/// Coefficients of a polynomial of degree 3 in x, y, z (see the coef_ enum)
+typedef Eigen::Matrix<double, 20, 1> Vec20;
+/// Basis of the nullspace of the epipolar constraints, one basis matrix per column
+typedef Eigen::Matrix<double, 9, 4> Mat94;
+/// Polynomial constraints of the five point problem, one constraint per row
+typedef Eigen::Matrix<double, 10, 20> Mat1020;
+
 /** Computes the relative pose of two calibrated cameras from 5 correspondences.
  *
  * \param x1 Points in the first image.  One per column.
@@ -24,16 +31,16 @@ void FivePointsRelativePose(const Mat2X &x1, const Mat2X &x2,
                             std::vector<Mat3> *E);
 
 // Compute the nullspace of the linear constraints given by the matches.
-Mat FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2);
+Mat94 FivePointsNullspaceBasis(const Mat2X &x1, const Mat2X &x2);
 
 // Multiply two polynomials of degree 1.
-Vec o1(const Vec &a, const Vec &b);
+Vec20 o1(const Vec20 &a, const Vec20 &b);
 
 // Multiply a polynomial of degree 2, a, by a polynomial of degree 1, b.
-Vec o2(const Vec &a, const Vec &b);
+Vec20 o2(const Vec20 &a, const Vec20 &b);
 
 // Builds the polynomial constraint matrix M.
-Mat FivePointsPolynomialConstraints(const Mat &E_basis);
+Mat1020 FivePointsPolynomialConstraints(const Mat94 &E_basis);
 
 // In the following code, polynomials are expressed as vectors containing
 // their coeficients in the basis of monomials:
@@ -11,6 +11,7 @@
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/multiview/twoViewKernel.hpp>
 
+#include <utility>
 #include <vector>
 
 
@@ -86,6 +87,37 @@ inline void EncodeEpipolarEquation(const TMatX &x1, const TMatX &x2, TMatA *A, c
   }
 }
 
+/**
+ * @brief Epipolar terms of a batch of correspondences, as Eigen array expressions
+ * evaluated without temporary buffers (SIMD friendly).
+ * The points are stored one per row, so each coordinate is contiguous.
+ */
+struct EpipolarTerms
+{
+private:
+  typedef decltype(std::declval<const Mat&>().col(0).array()) Coordinates;
+
+  const Mat3 &F_;
+  const Coordinates x1_, y1_, x2_, y2_;
+
+public:
+  EpipolarTerms(const Mat3 &F, const Mat &x1, const Mat &x2)
+    : F_(F), x1_(x1.col(0).array()), y1_(x1.col(1).array()), x2_(x2.col(0).array()), y2_(x2.col(1).array())
+  {}
+
+  /// F * x (first two coordinates)
+  auto Fx0() const -> decltype(F_(0,0) * x1_ + F_(0,1) * y1_ + F_(0,2)) { return F_(0,0) * x1_ + F_(0,1) * y1_ + F_(0,2); }
+  auto Fx1() const -> decltype(F_(1,0) * x1_ + F_(1,1) * y1_ + F_(1,2)) { return F_(1,0) * x1_ + F_(1,1) * y1_ + F_(1,2); }
+  /// F^t * y (first two coordinates)
+  auto Fty0() const -> decltype(F_(0,0) * x2_ + F_(1,0) * y2_ + F_(2,0)) { return F_(0,0) * x2_ + F_(1,0) * y2_ + F_(2,0); }
+  auto Fty1() const -> decltype(F_(0,1) * x2_ + F_(1,1) * y2_ + F_(2,1)) { return F_(0,1) * x2_ + F_(1,1) * y2_ + F_(2,1); }
+  /// y^t * F * x
+  auto yFx() const -> decltype(x2_ * Fx0() + y2_ * Fx1() + (F_(2,0) * x1_ + F_(2,1) * y1_ + F_(2,2)))
+  {
+    return x2_ * Fx0() + y2_ * Fx1() + (F_(2,0) * x1_ + F_(2,1) * y1_ + F_(2,2));
+  }
+};
+
 /// Compute SampsonError related to the Fundamental matrix and 2 correspondences
 struct SampsonError {
   static double Error(const Mat3 &F, const Vec2 &x1, const Vec2 &x2) {
@@ -97,6 +129,18 @@ struct SampsonError {
     return Square(y.dot(F_x)) / (  F_x.head<2>().squaredNorm()
                                 + Ft_y.head<2>().squaredNorm());
   }
+
+  /**
+   * @brief Errors of all the correspondences at once.
+   * @param[in] x1 The points of the first image, one point per row
+   * @param[in] x2 The corresponding points of the second image, one point per row
+   * @param[out] errors The x1.rows() errors
+   */
+  static void Errors(const Mat3 &F, const Mat &x1, const Mat &x2, double *errors) {
+    const EpipolarTerms t(F, x1, x2);
+    Eigen::Map<Eigen::ArrayXd>(errors, x1.rows()) =
+      t.yFx().square() / (t.Fx0().square() + t.Fx1().square() + t.Fty0().square() + t.Fty1().square());
+  }
 };
 
 struct SymmetricEpipolarDistanceError {
@@ -110,6 +154,14 @@ struct SymmetricEpipolarDistanceError {
                                 + 1.0 / Ft_y.head<2>().squaredNorm())
       / 4.0;  // The divide by 4 is to make this match the Sampson distance.
   }
+
+  /// @see SampsonError::Errors
+  static void Errors(const Mat3 &F, const Mat &x1, const Mat &x2, double *errors) {
+    const EpipolarTerms t(F, x1, x2);
+    Eigen::Map<Eigen::ArrayXd>(errors, x1.rows()) =
+      t.yFx().square() * ((t.Fx0().square() + t.Fx1().square()).inverse() +
+                          (t.Fty0().square() + t.Fty1().square()).inverse()) / 4.0;
+  }
 };
 
 struct EpipolarDistanceError {
@@ -121,6 +173,12 @@ struct EpipolarDistanceError {
     Vec3 F_x = F * x;
     return Square(F_x.dot(y)) /  F_x.head<2>().squaredNorm();
   }
+
+  /// @see SampsonError::Errors
+  static void Errors(const Mat3 &F, const Mat &x1, const Mat &x2, double *errors) {
+    const EpipolarTerms t(F, x1, x2);
+    Eigen::Map<Eigen::ArrayXd>(errors, x1.rows()) = t.yFx().square() / (t.Fx0().square() + t.Fx1().square());
+  }
 };
 typedef EpipolarDistanceError SimpleError;
 
@@ -121,3 +121,25 @@ BOOST_AUTO_TEST_CASE(EightPointTest_Normalized_EasyCase) {
   typedef fundamental::kernel::NormalizedEightPointKernel Kernel;
   BOOST_CHECK(ExpectKernelProperties<Kernel>(x1, x2));
 }
+
+BOOST_AUTO_TEST_CASE(BatchErrors_MatchScalarErrors) {
+  Mat3 F;
+  F << 0.1, -0.3,  2.0,
+       0.4,  0.2, -1.5,
+      -1.0,  3.0,  0.5;
+  const Mat x1 = Mat::Random(2, 50) * 100.0;
+  const Mat x2 = Mat::Random(2, 50) * 100.0;
+  const Mat x1ByRow = x1.transpose();
+  const Mat x2ByRow = x2.transpose();
+
+  vector<double> sampson(x1.cols()), symmetric(x1.cols()), epipolar(x1.cols());
+  fundamental::kernel::SampsonError::Errors(F, x1ByRow, x2ByRow, sampson.data());
+  fundamental::kernel::SymmetricEpipolarDistanceError::Errors(F, x1ByRow, x2ByRow, symmetric.data());
+  fundamental::kernel::EpipolarDistanceError::Errors(F, x1ByRow, x2ByRow, epipolar.data());
+
+  for (Mat::Index i = 0; i < x1.cols(); ++i) {
+    BOOST_CHECK_CLOSE(fundamental::kernel::SampsonError::Error(F, x1.col(i), x2.col(i)), sampson[i], 1e-8);
+    BOOST_CHECK_CLOSE(fundamental::kernel::SymmetricEpipolarDistanceError::Error(F, x1.col(i), x2.col(i)), symmetric[i], 1e-8);
+    BOOST_CHECK_CLOSE(fundamental::kernel::EpipolarDistanceError::Error(F, x1.col(i), x2.col(i)), epipolar[i], 1e-8);
+  }
+}
@@ -42,6 +42,21 @@ struct AsymmetricError {
     Vec2 x2_est = x2h_est.head<2>() / x2h_est[2];
     return (x2 - x2_est).squaredNorm();
   }
+
+  /**
+   * @brief Errors of all the correspondences at once (SIMD friendly).
+   * @param[in] x1 The points of the first image, one point per row
+   * @param[in] x2 The corresponding points of the second image, one point per row
+   * @param[out] errors The x1.rows() errors
+   */
+  static void Errors(const Mat3 &H, const Mat &x1, const Mat &x2, double *errors) {
+    const auto X1 = x1.col(0).array();
+    const auto Y1 = x1.col(1).array();
+    const auto w = H(2,0) * X1 + H(2,1) * Y1 + H(2,2);
+    Eigen::Map<Eigen::ArrayXd>(errors, x1.rows()) =
+      (x2.col(0).array() - (H(0,0) * X1 + H(0,1) * Y1 + H(0,2)) / w).square() +
+      (x2.col(1).array() - (H(1,0) * X1 + H(1,1) * Y1 + H(1,2)) / w).square();
+  }
 };
 
 // Kernel that works on original data point
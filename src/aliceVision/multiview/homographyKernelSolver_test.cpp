@@ -90,3 +90,20 @@ BOOST_AUTO_TEST_CASE(HomographyKernelTest_Fitting_Normalized) {
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(HomographyKernelTest_BatchErrors) {
+  Mat3 H;
+  H << 1, -2,  3,
+       4,  5, -6,
+      -7,  8,  1;
+  const Mat x1 = Mat::Random(2, 50) * 10.0;
+  const Mat x2 = Mat::Random(2, 50) * 10.0;
+  const Mat x1ByRow = x1.transpose();
+  const Mat x2ByRow = x2.transpose();
+
+  vector<double> errors(x1.cols());
+  homography::kernel::AsymmetricError::Errors(H, x1ByRow, x2ByRow, errors.data());
+
+  for (Mat::Index i = 0; i < x1.cols(); ++i)
+    BOOST_CHECK_CLOSE(homography::kernel::AsymmetricError::Error(H, x1.col(i), x2.col(i)), errors[i], 1e-8);
+}
@@ -8,17 +8,23 @@
 
 #include <aliceVision/numeric/numeric.hpp>
 
+#include <complex>
 #include <iostream>
 
 namespace aliceVision {
 namespace resection {
 
+/// Eigenvectors of the P4Pf action matrix, without their first row
+typedef Eigen::Matrix<std::complex<double>, 4, 10> Mat410c;
+/// Up to 10 real solutions of the P4Pf polynomial system, one per column (fixed size storage)
+typedef Eigen::Matrix<double, 4, Eigen::Dynamic, Eigen::ColMajor, 4, 10> Mat4Xmax10;
+
 /**
  * @brief The structure p4fSolution contain one output model
  */
 struct p4fSolution
 {
-  p4fSolution(Mat R, Vec3 t, double f)
+  p4fSolution(const Mat3& R, const Vec3& t, double f)
     : _R(R)
     , _t(t)
     , _f(f)
@@ -27,7 +33,7 @@ struct p4fSolution
   Mat34 getP() const
   {
     Mat34 P;
-    Mat K = Mat(3, 3);
+    Mat3 K;
 
     K << _f, 0, 0,
          0, _f, 0,
@@ -39,7 +45,7 @@ struct p4fSolution
     return P;
   }
 
-  Mat _R;
+  Mat3 _R;
   Vec3 _t;
   double _f;
 };
@@ -139,15 +145,15 @@ void computeP4pfPoses(const double *glab,
  * @brief isNan
  * @param[in] A matrix
  */
-bool isNan(const Eigen::MatrixXcd &A);
+bool isNan(const Mat410c &A);
 
 /**
  * @brief validSol
  * @param[in] sol
  * @param[out] vSol
  */
-bool validSol(const Eigen::MatrixXcd &sol,
-              Mat &vSol);
+bool validSol(const Mat410c &sol,
+              Mat4Xmax10 &vSol);
 
 /**
  * @brief Get the rigid transformation
@@ -156,9 +162,9 @@ bool validSol(const Eigen::MatrixXcd &sol,
  * @param[out] R
  * @param[out] t
  */
-void getRigidTransform(const Mat &pp1,
-                       const Mat &pp2,
-                       Mat &R,
+void getRigidTransform(const Mat34 &pp1,
+                       const Mat34 &pp2,
+                       Mat3 &R,
                        Vec3 &t);
 
 } // namespace resection
@@ -86,11 +86,10 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
                             std::vector<p5pfrModel> *solutions)
 {
   // Eliminate all linear stuff
-  Mat A = Mat(5, 8);
+  Eigen::Matrix<double, 5, 8> A;
   for(Vec::Index i = 0; i < 5; ++i)
   {
-    Mat X = Mat(1, 8);
-    X << -featureVectors(1, i) * worldPoints(0, i),
+    A.row(i) << -featureVectors(1, i) * worldPoints(0, i),
          -featureVectors(1, i) * worldPoints(1, i),
          -featureVectors(1, i) * worldPoints(2, i),
          -featureVectors(1, i),
@@ -98,15 +97,13 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
           featureVectors(0, i) * worldPoints(1, i),
           featureVectors(0, i) * worldPoints(2, i),
           featureVectors(0, i);
-
-    A.block(i, 0, 1, 8) = X;
   }
 
   // 3D Nullspace    
   const Mat N = nullspace(A);
 
   // Construct the matrix C
-  Mat C = Mat(2, 6);
+  Eigen::Matrix<double, 2, 6> C;
   C << N.block(0, 0, 3, 1).transpose() * N.block(4, 0, 3, 1),
        N.block(0, 0, 3, 1).transpose() * N.block(4, 1, 3, 1) + N.block(0, 1, 3, 1).transpose() * N.block(4, 0, 3, 1),
        N.block(0, 0, 3, 1).transpose() * N.block(4, 2, 3, 1) + N.block(0, 2, 3, 1).transpose() * N.block(4, 0, 3, 1),
@@ -121,14 +118,12 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
        N.block(0, 2, 3, 1).transpose() * N.block(0, 2, 3, 1) - N.block(4, 2, 3, 1).transpose() * N.block(4, 2, 3, 1);
 
   // Normalize C to get reasonable numbers when computing d
-  const Vec &c1 = C.row(0);
-  const Vec &c2 = C.row(1);
-  Mat sC = Mat(2, 2);
-  sC << (6 / c1.norm()), 0, 0, (6 / c2.norm());
+  Eigen::Matrix2d sC;
+  sC << (6 / C.row(0).norm()), 0, 0, (6 / C.row(1).norm());
   C = sC * C;
 
   // Determinant coefficients
-  Mat d = Mat(5, 1);
+  Eigen::Matrix<double, 5, 1> d;
   d << C(0, 0) * C(0, 0) * C(1, 3) * C(1, 3) - C(0, 0) * C(0, 1) * C(1, 1) * C(1, 3) - 2 * C(0, 0) * C(0, 3) * C(1, 0) * C(1, 3) + C(0, 0) * C(0, 3) * C(1, 1) * C(1, 1) + C(0, 1) * C(0, 1) * C(1, 0) * C(1, 3) - C(0, 1) * C(0, 3) * C(1, 0) * C(1, 1) + C(0, 3) * C(0, 3) * C(1, 0) * C(1, 0),
       -C(0, 0) * C(0, 1) * C(1, 3) * C(1, 4) + 2 * C(0, 0) * C(0, 2) * C(1, 3) * C(1, 3) + 2 * C(0, 0) * C(0, 3) * C(1, 1) * C(1, 4) - 2 * C(0, 0) * C(0, 3) * C(1, 2) * C(1, 3) - C(0, 0) * C(0, 4) * C(1, 1) * C(1, 3) + C(0, 1) * C(0, 1) * C(1, 2) * C(1, 3) - C(0, 1) * C(0, 2) * C(1, 1) * C(1, 3) - C(0, 1) * C(0, 3) * C(1, 0) * C(1, 4) - C(0, 1) * C(0, 3) * C(1, 1) * C(1, 2) + 2 * C(0, 1) * C(0, 4) * C(1, 0) * C(1, 3) - 2 * C(0, 2) * C(0, 3) * C(1, 0) * C(1, 3) + C(0, 2) * C(0, 3) * C(1, 1) * C(1, 1) + 2 * C(0, 3) * C(0, 3) * C(1, 0) * C(1, 2) - C(0, 3) * C(0, 4) * C(1, 0) * C(1, 1),
       -2 * C(0, 0) * C(0, 3) * C(1, 3) * C(1, 5) + C(0, 0) * C(0, 3) * C(1, 4) * C(1, 4) - C(0, 0) * C(0, 4) * C(1, 3) * C(1, 4) + 2 * C(0, 0) * C(0, 5) * C(1, 3) * C(1, 3) + C(0, 1) * C(0, 1) * C(1, 3) * C(1, 5) - C(0, 1) * C(0, 2) * C(1, 3) * C(1, 4) - C(0, 1) * C(0, 3) * C(1, 1) * C(1, 5) - C(0, 1) * C(0, 3) * C(1, 2) * C(1, 4) + 2 * C(0, 1) * C(0, 4) * C(1, 2) * C(1, 3) - C(0, 1) * C(0, 5) * C(1, 1) * C(1, 3) + C(0, 2) * C(0, 2) * C(1, 3) * C(1, 3) + 2 * C(0, 2) * C(0, 3) * C(1, 1) * C(1, 4) - 2 * C(0, 2) * C(0, 3) * C(1, 2) * C(1, 3) - C(0, 2) * C(0, 4) * C(1, 1) * C(1, 3) + 2 * C(0, 3) * C(0, 3) * C(1, 0) * C(1, 5) + C(0, 3) * C(0, 3) * C(1, 2) * C(1, 2) - C(0, 3) * C(0, 4) * C(1, 0) * C(1, 4) - C(0, 3) * C(0, 4) * C(1, 1) * C(1, 2) - 2 * C(0, 3) * C(0, 5) * C(1, 0) * C(1, 3) + C(0, 3) * C(0, 5) * C(1, 1) * C(1, 1) + C(0, 4) * C(0, 4) * C(1, 0) * C(1, 3),
@@ -137,38 +132,41 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
 
   // Companion matrix
   d = d * (1.0 / d(0, 0));
-  Mat M = Mat(4, 4);
+  Mat4 M;
   M << 0, 0, 0, -d(4, 0),
        1, 0, 0, -d(3, 0),
        0, 1, 0, -d(2, 0),
        0, 0, 1, -d(1, 0);
 
   // solve it
-  Eigen::EigenSolver<Mat> es(M);
-  Mat g1_im = es.eigenvalues().imag();
-  Mat g1_re = es.eigenvalues().real();
+  Eigen::EigenSolver<Mat4> es(M);
+  const Vec4 g1_im = es.eigenvalues().imag();
+  const Vec4 g1_re = es.eigenvalues().real();
 
   // separate real solutions
   const double eps = 2.2204e-16;
-  std::vector<double> vec_g1_real;
+  typedef Eigen::Matrix<double, Eigen::Dynamic, 1, Eigen::ColMajor, 4, 1> Vecmax4;
+  Vecmax4 g1(0);
   for(Mat::Index i = 0; i < 4; ++i)
   {
-    if(std::abs(g1_im(i, 0)) < eps)
-      vec_g1_real.push_back(g1_re(i, 0));
+    if(std::abs(g1_im(i)) < eps)
+    {
+      g1.conservativeResize(g1.rows() + 1);
+      g1(g1.rows() - 1) = g1_re(i);
+    }
   }
-  if(vec_g1_real.size() == 0)
+  if(g1.rows() == 0)
     return false;
-  Vec g1 = Map<Vec>(vec_g1_real.data(), vec_g1_real.size());
 
   //get g2 : Sg1 * <g2 ^ 3, g2 ^ 2, g2, 1 >= 0
   //   SG1 : = << C14 | C12*g1 + C15  | C11*g1 ^ 2 + C13*g1 + C16 | 0              >,
   //             <  0 | C14      | C12*g1 + C15        | C11*g1 ^ 2 + C13*g1 + C16  >,
   //             <C24 | C22*g1 + C25  | C21*g1 ^ 2 + C23*g1 + C26 | 0              >,
   //             <  0 | C24      | C22*g1 + C25        | C21*g1 ^ 2 + C23*g1 + C26 >> ;
-  Mat g2 = Mat(g1.rows(), g1.cols());
+  Vecmax4 g2(g1.rows());
   for(Mat::Index i = 0; i < g1.rows(); ++i)
   {
-    Mat M2G = Mat(4, 4);
+    Mat4 M2G;
     M2G <<  C(0, 3),
             C(0, 1) * g1(i) + C(0, 4),
             C(0, 0) * g1(i) * g1(i) + C(0, 2) * g1(i) + C(0, 5),
@@ -202,7 +200,7 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
     P.row(2) << P(0, 1) * P(1, 2) - P(0, 2) * P(1, 1), -P(0, 0) * P(1, 2) + P(0, 2) * P(1, 0), P(0, 0) * P(1, 1) - P(0, 1) * P(1, 0), 0;
 
     // Form equations on k p34 and t = 1 / f: B <p34, t, k1, k2 ^ 2, k3 ^ 3, 1> = 0
-    Mat B = Mat(5, 6);
+    Eigen::Matrix<double, 5, 6> B;
     for(Mat::Index j = 0; j < 5; ++j)
     { // for all point pairs[u, X]
       const double r2 = featureVectors(0, j) * featureVectors(0, j) + featureVectors(1, j) * featureVectors(1, j); // temporary vals
@@ -223,11 +221,11 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
     }
 
     // select columns
-    Mat U;
+    Eigen::Matrix<double, 6, Eigen::Dynamic, Eigen::ColMajor, 6, 6> U;
     switch(numOfRadialCoeff)
     {
     case 1:
-      U = Mat(6, 4);
+      U.resize(6, 4);
       U << 1, 0, 0, 0,
            0, 1, 0, 0,
            0, 0, 1, 0,
@@ -237,7 +235,7 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
       break;
 
     case 2:
-      U = Mat(6, 5);
+      U.resize(6, 5);
       U << 1, 0, 0, 0, 0,
            0, 1, 0, 0, 0,
            0, 0, 1, 0, 0,
@@ -247,17 +245,17 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
       break;
 
     case 3:
-      U = Mat::Identity(6, 6);
+      U.setIdentity(6, 6);
       break;
 
       default:
         std::cerr << "\nError: the number of radial parameters must be between 1 to 3!\n";
       return false;
     }
-    B = B * U;
+    const Mat BU = B * U;
 
     // find the right 1D null space
-    const Mat NBfull = nullspace(B);
+    const Mat NBfull = nullspace(BU);
     const Mat NB = NBfull.col(NBfull.cols() - 1);
     const Mat V = NB.col(NB.cols() - 1);
     Mat tk = V * (1 / V(V.rows() - 1, V.cols() - 1));
@@ -270,9 +268,9 @@ bool computeP5PfrPosesRD(const Mat &featureVectors,
     }
 
     P(2, 3) = tk(0, 0) / tk(1, 0);
-    Mat K = Mat(3, 3);
+    Mat3 K;
     K << 1.0 / tk(1, 0), 0, 0, 0, 1.0 / tk(1, 0), 0, 0, 0, 1;
-    Mat R = P.block(0, 0, 3, 3);
+    const Mat3 R = P.block(0, 0, 3, 3);
 
     //Mat C = -R.transpose() * P.block(0, 3, 3, 1);
     Vec r = Vec(numOfRadialCoeff);
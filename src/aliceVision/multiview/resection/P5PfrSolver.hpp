@@ -18,14 +18,14 @@ namespace resection {
  */
 struct p5pfrModel
 {
-  p5pfrModel(Mat R, Vec3 t, Vec r, double f)
+  p5pfrModel(const Mat3& R, const Vec3& t, const Vec& r, double f)
     : _R(R)
     , _t(t)
     , _r(r)
     , _f(f)
   {}
 
-  Mat _R;
+  Mat3 _R;
   Vec3 _t;
   Vec _r;
   double _f;
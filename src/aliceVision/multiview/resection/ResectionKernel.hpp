@@ -37,6 +37,30 @@ struct SixPointResectionSolver {
   }
 };
 
+/// Squared reprojection error, for the robust estimation of the projection matrix
+struct ResectionSquaredResidualError
+{
+  // Compute the residual of the projection distance(pt2D, Project(P,pt3D))
+  // Return the squared error
+  static double Error(const Mat34& P, const Vec2& pt2D, const Vec3& pt3D)
+  {
+    const Vec2 x = Project(P, pt3D);
+    return (x - pt2D).squaredNorm();
+  }
+
+  // Compute the squared residuals of all the points at once, one point per row
+  static void Errors(const Mat34& P, const Mat& pt2D, const Mat& pt3D, double* errors)
+  {
+    const auto X = pt3D.col(0).array();
+    const auto Y = pt3D.col(1).array();
+    const auto Z = pt3D.col(2).array();
+    const auto w = P(2,0) * X + P(2,1) * Y + P(2,2) * Z + P(2,3);
+    Eigen::Map<Eigen::ArrayXd>(errors, pt2D.rows()) =
+      (pt2D.col(0).array() - (P(0,0) * X + P(0,1) * Y + P(0,2) * Z + P(0,3)) / w).square() +
+      (pt2D.col(1).array() - (P(1,0) * X + P(1,1) * Y + P(1,2) * Z + P(1,3)) / w).square();
+  }
+};
+
 //-- Generic Solver for the 6pt Resection algorithm using linear least squares.
 template<typename SolverArg,
   typename ErrorArg,
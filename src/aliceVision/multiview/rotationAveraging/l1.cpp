@@ -30,6 +30,9 @@
 #include "ceres/ceres.h"
 #include "ceres/rotation.h"
 
+#include <Eigen/SparseCholesky>
+#include <Eigen/IterativeLinearSolvers>
+
 #include <map>
 #include <queue>
 #include <stdint.h>
@@ -44,6 +47,73 @@ namespace aliceVision   {
 namespace rotationAveraging  {
 namespace l1  {
 
+// Minimum number of unknowns to solve the sparse normal equations with the conjugate gradient,
+// smaller systems are solved with a direct factorization
+const unsigned MIN_UNKNOWNS_ITERATIVE_SOLVER = 3000;
+
+// Solver of the normal equations H*x = rhs of the regressions,
+// dense version: direct factorization
+template<typename MATRIX_TYPE>
+struct TNormalEquationsSolver
+{
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
+
+  static bool solve(const Matrix& H, const Vector& rhs, Vector& x)
+  {
+    const Eigen::LDLT<Matrix> solver(H); // compute the Cholesky decomposition
+    if (solver.info() != Eigen::Success) {
+      ALICEVISION_LOG_WARNING("error: decomposing linear system failed");
+      return false;
+    }
+    x = solver.solve(rhs);
+    if (solver.info() != Eigen::Success) {
+      ALICEVISION_LOG_WARNING("error: solving linear system failed");
+      return false;
+    }
+    return true;
+  }
+};
+
+// sparse version: Jacobi preconditioned conjugate gradient warm-started from the input x,
+// with the sparse Cholesky factorization for the small systems and as fallback
+template<>
+struct TNormalEquationsSolver< Eigen::SparseMatrix<REAL, Eigen::ColMajor> >
+{
+  // row major storage: the conjugate gradient products are multithreaded (with Lower|Upper)
+  typedef Eigen::SparseMatrix<REAL, Eigen::RowMajor> Matrix;
+  typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
+
+  static bool solve(const Matrix& H, const Vector& rhs, Vector& x)
+  {
+    if (H.rows() >= MIN_UNKNOWNS_ITERATIVE_SOLVER) {
+      Eigen::ConjugateGradient<Matrix, Eigen::Lower|Eigen::Upper, Eigen::DiagonalPreconditioner<REAL> > solver;
+      solver.setTolerance(REAL(1e-10));
+      solver.compute(H);
+      if (x.size() != rhs.size())
+        x.setZero(rhs.size());
+      const Vector xs = solver.solveWithGuess(rhs, x);
+      if (solver.info() == Eigen::Success) {
+        x = xs;
+        return true;
+      }
+      ALICEVISION_LOG_DEBUG("conjugate gradient did not converge after " << solver.iterations()
+        << " iterations (error: " << solver.error() << "), fallback to the sparse Cholesky decomposition");
+    }
+    const Eigen::SimplicialLDLT< Eigen::SparseMatrix<REAL, Eigen::ColMajor> > solver(H);
+    if (solver.info() != Eigen::Success) {
+      ALICEVISION_LOG_WARNING("error: decomposing linear system failed");
+      return false;
+    }
+    x = solver.solve(rhs);
+    if (solver.info() != Eigen::Success) {
+      ALICEVISION_LOG_WARNING("error: solving linear system failed");
+      return false;
+    }
+    return true;
+  }
+};
+
 // Minimum l1 error approximation:
 //
 // Let A be a M x N matrix with full rank. Given y of R^M, the problem
@@ -67,7 +137,8 @@ inline bool TRobustRegressionL1PD(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& xp,
   REAL pdtol, unsigned pdmaxiter)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+  typedef TNormalEquationsSolver<MATRIX_TYPE> NormalEquationsSolver;
+  typedef typename NormalEquationsSolver::Matrix Matrix;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned M = (unsigned)y.size();
   const unsigned N = (unsigned)xp.size();
@@ -97,9 +168,9 @@ inline bool TRobustRegressionL1PD(
   Vector rdual((-lamu1-lamu2).array() + REAL(1));
   REAL rdualNormSq = rdual.squaredNorm();
 
-  Vector w2(M), sig1(M), sig2(M), sigx(M), dx(N), up(N), Atdv(N);
+  Vector w2(M), sig1(M), sig2(M), sigx(M), dx(Vector::Zero(N)), w1p(N), up(N), Atdv(N);
   Vector Axp(M), Atvp(M);
-  Vector &Adx(sigx), &du(w2), &w1p(dx);
+  Vector &Adx(sigx), &du(w2);
   Matrix H11p(N,N);
   Vector &dlamu1(tmpM3), &dlamu2(tmpM4);
   for (unsigned pditer=0; pditer<pdmaxiter; ++pditer) {
@@ -131,7 +202,9 @@ inline bool TRobustRegressionL1PD(
     w1p = At*(tmpM4 - tmpM3 - (sig2.cwiseQuotient(sig1).cwiseProduct(w2)));
 
     // optimized solver as A is positive definite and symmetric
-    dx = H11p.ldlt().solve(w1p);
+    // (the previous step is the initial guess of the iterative solver)
+    if (!NormalEquationsSolver::solve(H11p, w1p, dx))
+      return false;
 
     Adx = A*dx;
 
@@ -232,7 +305,8 @@ inline bool TIterativelyReweightedLeastSquares(
   Eigen::Matrix<REAL, Eigen::Dynamic, 1>& x,
   REAL sigma, REAL eps)
 {
-  typedef Eigen::Matrix<REAL, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Matrix;
+  typedef TNormalEquationsSolver<MATRIX_TYPE> NormalEquationsSolver;
+  typedef typename NormalEquationsSolver::Matrix Matrix;
   typedef Eigen::Matrix<REAL, Eigen::Dynamic, 1> Vector;
   const unsigned m = (unsigned)b.size();
   const unsigned n = (unsigned)x.size();
@@ -254,17 +328,12 @@ inline bool TIterativelyReweightedLeastSquares(
       err = sigmaSq / (errSq + sigmaSq);
     }
     // solve the linear system using l2 norm
+    // (the previous iterate is the initial guess of the iterative solver)
     const MATRIX_TYPE AtF(A.transpose()*e.asDiagonal());
-    const Eigen::LDLT<Matrix> solver(AtF*A); // compute the Cholesky decomposition
-    if (solver.info() != Eigen::Success) {
-      ALICEVISION_LOG_WARNING("error: decomposing linear system failed");
+    const Matrix H(AtF*A);
+    const Vector rhs(AtF*b);
+    if (!NormalEquationsSolver::solve(H, rhs, x))
       return false;
-    }
-    x = solver.solve(AtF*b);
-    if (solver.info() != Eigen::Success) {
-      ALICEVISION_LOG_WARNING("error: solving linear system failed");
-      return false;
-    }
     if (++iter > 32)
       break;
     deltap = delta; delta = (xp-x).norm();
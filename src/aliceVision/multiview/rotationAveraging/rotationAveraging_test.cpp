@@ -397,3 +397,41 @@ BOOST_AUTO_TEST_CASE ( rotationAveraging_RobustRegressionL1PD)
 }
 */
 
+
+// Test the sparse regressions on a chain large enough to use the iterative solver:
+// each unknown is observed with respect to the origin and to its neighbor
+BOOST_AUTO_TEST_CASE ( rotationAveraging_SparseRegressions_LargeChain)
+{
+  const unsigned n = 3600;
+  const unsigned m = 2*n-1;
+
+  Eigen::SparseMatrix<REAL, Eigen::ColMajor> A(m, n);
+  std::vector< Eigen::Triplet<REAL> > coefficients;
+  for (unsigned i = 0; i < n; ++i)
+  {
+    coefficients.emplace_back(i, i, REAL(1));
+    if (i+1 < n)
+    {
+      coefficients.emplace_back(n+i, i, REAL(-1));
+      coefficients.emplace_back(n+i, i+1, REAL(1));
+    }
+  }
+  A.setFromTriplets(coefficients.begin(), coefficients.end());
+  A.makeCompressed();
+
+  Vec xGT(n);
+  for (unsigned i = 0; i < n; ++i)
+    xGT(i) = std::sin(0.01*i);
+  const Vec b = A*xGT;
+
+  {
+    Vec x(Vec::Zero(n));
+    BOOST_CHECK(IterativelyReweightedLeastSquares(A, b, x, degreeToRadian(5.0)));
+    BOOST_CHECK_SMALL((x-xGT).lpNorm<Eigen::Infinity>(), 1e-6);
+  }
+  {
+    Vec x(Vec::Zero(n));
+    BOOST_CHECK(RobustRegressionL1PD(A, b, x));
+    BOOST_CHECK_SMALL((x-xGT).lpNorm<Eigen::Infinity>(), 1e-3);
+  }
+}
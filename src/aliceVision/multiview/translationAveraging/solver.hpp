@@ -7,13 +7,44 @@
 
 #pragma once
 
+#include <aliceVision/multiview/translationAveraging/common.hpp>
+
+#include <vector>
+
 namespace aliceVision {
 namespace translationAveraging {
 
+/**
+ * @brief Linear least squares estimation of the global translations of the nodes of a graph:
+ *        minimization of sum_ij w_ij^2 * ||X_j - R_ij * X_i - b_ij||^2 with X_0 = {0,0,0}.
+ *
+ * Cheap initialization of the non linear solvers: the relative translations b_ij are
+ * used with their given length (one for the translation directions).
+ *
+ * @param[in] edges the nodes (i,j) of each edge, in [0, num_nodes)
+ * @param[in] rotations the column major 3x3 rotation R_ij of each edge, nullptr for identities
+ * @param[in] poses the relative translation b_ij of each edge
+ * @param[in] weights the weight of each edge, nullptr for unit weights
+ * @param[in] num_edges the number of edges
+ * @param[in] num_nodes the number of nodes
+ * @param[out] X the 3 * num_nodes translations of the nodes
+ * @return False if the linear system can't be solved
+ */
+bool solve_translations_problem_linear(
+  const int* edges,
+  const double* rotations,
+  const double* poses,
+  const double* weights,
+  int num_edges,
+  int num_nodes,
+  double* X
+);
+
 /**
  * @brief Compute camera center positions from relative camera translations (translation directions).
  *
  * Implementation of [1] : "5. Solving the Translations Problem" equation (3)
+ * The solver starts from the linear solution of solve_translations_problem_linear.
  */
 bool solve_translations_problem_l2_chordal(
   const int* edges,
@@ -45,6 +76,9 @@ bool solve_translations_problem_l2_chordal(
  * Based on a BSD implementation from Kyle Wilson.
  * See http://github.com/wilsonkl/SfM_Init
  *
+ * The solver starts from the linear solution of solve_translations_problem_linear,
+ * the relative scales are eliminated by a Schur complement.
+ *
  * @param[in] vec_initial_estimates relative motion information
  * @param[in] b_translation_triplets tell if relative motion comes 3 or 2 views
  *   false: 2-view estimates -> 1 relativeInfo per 2 view estimates,
@@ -102,10 +102,56 @@ bool solve_translations_problem_softl1
   // - relative rotations
 
   std::vector<double> vec_translations(3*nb_poses, 1.0);
-  const unsigned nb_scales = vec_initial_estimates.size() / (b_translation_triplets ? 3 : 1);
+  const unsigned group_size = b_translation_triplets ? 3 : 1;
+  const unsigned nb_scales = vec_initial_estimates.size() / group_size;
   std::vector<double> vec_scales(nb_scales, 1.0);
 
-  if (!b_translation_triplets)
+  // Relative rotations array
+  std::vector<double> vec_relative_rotations(vec_initial_estimates.size()*3, 0.0);
+  size_t cpt = 0;
+  for (const relativeInfo& info : vec_initial_estimates)
+  {
+    ceres::RotationMatrixToAngleAxis(
+      (const double*)info.second.first.data(),
+      &vec_relative_rotations[cpt]);
+    cpt += 3;
+  }
+
+  // Warm start from the linear solution of t_j = R_ij t_i + t_ij (all the scales to one)
+  std::vector<int> vec_edges;
+  std::vector<double> vec_rotations, vec_poses;
+  vec_edges.reserve(vec_initial_estimates.size() * 2);
+  vec_rotations.reserve(vec_initial_estimates.size() * 9);
+  vec_poses.reserve(vec_initial_estimates.size() * 3);
+  for (const relativeInfo& info : vec_initial_estimates)
+  {
+    vec_edges.push_back(info.first.first);
+    vec_edges.push_back(info.first.second);
+    vec_rotations.insert(vec_rotations.end(), info.second.first.data(), info.second.first.data() + 9);
+    vec_poses.insert(vec_poses.end(), info.second.second.data(), info.second.second.data() + 3);
+  }
+
+  if (!vec_initial_estimates.empty() &&
+      solve_translations_problem_linear(&vec_edges[0], &vec_rotations[0], &vec_poses[0], nullptr,
+                                        vec_initial_estimates.size(), nb_poses, &vec_translations[0]))
+  {
+    // least squares scale of each group of relative translations, at least one
+    for (unsigned i = 0; i < nb_scales; ++i)
+    {
+      double dot = 0.0, norm2 = 0.0;
+      for (unsigned k = i * group_size; k < (i+1) * group_size; ++k)
+      {
+        const relativeInfo& info = vec_initial_estimates[k];
+        const Vec3 t_i = Eigen::Map<const Vec3>(&vec_translations[3*info.first.first]);
+        const Vec3 t_j = Eigen::Map<const Vec3>(&vec_translations[3*info.first.second]);
+        const Vec3& t_ij = info.second.second;
+        dot += t_ij.dot(t_j - info.second.first * t_i);
+        norm2 += t_ij.squaredNorm();
+      }
+      vec_scales[i] = (norm2 > 0.0) ? std::max(1.0, dot / norm2) : 1.0;
+    }
+  }
+  else if (!b_translation_triplets)
   {
     // use random initialization, since using only single bearing vector results
     //  in a is less conditionned system.
@@ -118,17 +164,6 @@ bool solve_translations_problem_softl1
     }
   }
 
-  // Relative rotations array
-  std::vector<double> vec_relative_rotations(vec_initial_estimates.size()*3, 0.0);
-  size_t cpt = 0;
-  for (const relativeInfo& info : vec_initial_estimates)
-  {
-    ceres::RotationMatrixToAngleAxis(
-      (const double*)info.second.first.data(),
-      &vec_relative_rotations[cpt]);
-    cpt += 3;
-  }
-
   ceres::LossFunction * loss =
     (d_l1_loss_threshold < 0) ? nullptr : new ceres::SoftLOneLoss(d_l1_loss_threshold);
 
@@ -136,9 +171,10 @@ bool solve_translations_problem_softl1
   //
   // A. Add cost functor from camera translation to the relative informations
   cpt = 0;
-  IndexT scale_idx = 0;
   for (const relativeInfo& info : vec_initial_estimates)
   {
+    // the relative translations of a group share the same scale
+    const IndexT scale_idx = cpt / group_size;
     const Pair & ids = info.first;
     const IndexT I = ids.first;
     const IndexT J = ids.second;
@@ -158,8 +194,6 @@ bool solve_translations_problem_softl1
        &vec_scales[scale_idx]);
     // the relative rotation is set as constant
     problem.SetParameterBlockConstant(&vec_relative_rotations[cpt*3]);
-    if (cpt % (b_translation_triplets ? 3 : 1) == 0 && cpt != 0)
-      scale_idx += 1;
     ++cpt;
   }
 
@@ -180,15 +214,30 @@ bool solve_translations_problem_softl1
   // Solve
   ceres::Solver::Options options;
   options.minimizer_progress_to_stdout = false;
+
+  // the scales are eliminated by a Schur complement (a scale is only linked to the translations of its group)
+  options.linear_solver_ordering.reset(new ceres::ParameterBlockOrdering);
+  for (double& scale : vec_scales)
+    options.linear_solver_ordering->AddElementToGroup(&scale, 0);
+  for (int i = 0; i < nb_poses; ++i)
+  {
+    if (problem.HasParameterBlock(&vec_translations[3*i]))
+      options.linear_solver_ordering->AddElementToGroup(&vec_translations[3*i], 1);
+  }
+  for (std::size_t i = 0; i < vec_initial_estimates.size(); ++i)
+    options.linear_solver_ordering->AddElementToGroup(&vec_relative_rotations[3*i], 1);
+
   if (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ||
       ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::CX_SPARSE) ||
       ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::EIGEN_SPARSE))
   {
-    options.linear_solver_type = ceres::SPARSE_NORMAL_CHOLESKY;
+    options.linear_solver_type = ceres::SPARSE_SCHUR;
   }
   else
   {
-    options.linear_solver_type = ceres::DENSE_NORMAL_CHOLESKY;
+    // the dense decomposition does not scale with the number of cameras
+    options.linear_solver_type = ceres::ITERATIVE_SCHUR;
+    options.preconditioner_type = ceres::SCHUR_JACOBI;
   }
   options.max_num_iterations = std::max(50, (int)(nb_scales * 2));
   options.minimizer_progress_to_stdout = false;
@@ -71,13 +71,18 @@ bool solve_translations_problem_l2_chordal(
   reindex_problem(&_edges[0], num_edges, reindex_lookup);
   const int num_nodes = reindex_lookup.size();
 
-  // Init with a random guess solution
+  // Init with the linear solution (unit length edges),
+  // or a random guess solution if the linear system can't be solved
   const std::size_t guessSize = 3*num_nodes;
   std::vector<double> x(guessSize);
-  Mat randGuesses = Mat::Random(1, guessSize);
-  for (std::size_t i = 0; i < guessSize; ++i)
+  if (!solve_translations_problem_linear(&_edges[0], nullptr, poses, weights, num_edges, num_nodes, &x[0]))
   {
-    x[i] = randGuesses(0, i);
+    ALICEVISION_LOG_DEBUG("L2 chordal translations: no linear initialization, use a random guess");
+    Mat randGuesses = Mat::Random(1, guessSize);
+    for (std::size_t i = 0; i < guessSize; ++i)
+    {
+      x[i] = randGuesses(0, i);
+    }
   }
 
   // add the parameter blocks (a 3-vector for each node)
@@ -115,6 +120,7 @@ bool solve_translations_problem_l2_chordal(
   options.max_num_iterations = max_iterations;
   options.function_tolerance = function_tolerance;
   options.parameter_tolerance = parameter_tolerance;
+  // the parameters are only the camera centers, there is no block to eliminate by a Schur complement
   if (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE) ||
       ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::CX_SPARSE) ||
       ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::EIGEN_SPARSE))
@@ -123,7 +129,9 @@ bool solve_translations_problem_l2_chordal(
   }
   else
   {
-    options.linear_solver_type = ceres::DENSE_NORMAL_CHOLESKY;
+    // the dense decomposition does not scale with the number of cameras
+    options.linear_solver_type = ceres::CGNR;
+    options.preconditioner_type = ceres::JACOBI;
   }
 
   Solver::Summary summary;
@@ -0,0 +1,95 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/multiview/translationAveraging/solver.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <Eigen/SparseCholesky>
+
+#include <vector>
+
+namespace aliceVision {
+namespace translationAveraging {
+
+bool solve_translations_problem_linear(
+  const int* edges,
+  const double* rotations,
+  const double* poses,
+  const double* weights,
+  int num_edges,
+  int num_nodes,
+  double* X)
+{
+  if(num_nodes < 2)
+    return false;
+
+  // normal equations of the residuals X_j - R_ij X_i - b_ij,
+  // the node 0 is fixed in {0,0,0} (its unknowns are removed)
+  const int num_unknowns = 3 * (num_nodes - 1);
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(num_edges * 4 * 9);
+  Vec rhs = Vec::Zero(num_unknowns);
+
+  const auto addBlock = [&triplets](int row, int col, const Mat3& block)
+  {
+    for(int r = 0; r < 3; ++r)
+      for(int c = 0; c < 3; ++c)
+        if(block(r, c) != 0.0)
+          triplets.emplace_back(3 * row + r, 3 * col + c, block(r, c));
+  };
+
+  for(int e = 0; e < num_edges; ++e)
+  {
+    // unknown index of the nodes, -1 for the fixed node
+    const int i = edges[2 * e + 0] - 1;
+    const int j = edges[2 * e + 1] - 1;
+    const double w2 = (weights ? weights[e] * weights[e] : 1.0);
+    const Mat3 R = rotations ? Mat3(Eigen::Map<const Mat3>(rotations + 9 * e)) : Mat3(Mat3::Identity());
+    const Vec3 b(poses[3 * e + 0], poses[3 * e + 1], poses[3 * e + 2]);
+
+    // R is a rotation: R^T R = I
+    if(j >= 0)
+    {
+      addBlock(j, j, w2 * Mat3::Identity());
+      rhs.segment<3>(3 * j) += w2 * b;
+    }
+    if(i >= 0)
+    {
+      addBlock(i, i, w2 * Mat3::Identity());
+      rhs.segment<3>(3 * i) -= w2 * R.transpose() * b;
+    }
+    if(i >= 0 && j >= 0)
+    {
+      addBlock(i, j, -w2 * R.transpose());
+      addBlock(j, i, -w2 * R);
+    }
+  }
+
+  sMat H(num_unknowns, num_unknowns);
+  H.setFromTriplets(triplets.begin(), triplets.end());
+
+  const Eigen::SimplicialLDLT<sMat> solver(H);
+  if(solver.info() != Eigen::Success)
+  {
+    ALICEVISION_LOG_DEBUG("Linear translations initialization: decomposing linear system failed");
+    return false;
+  }
+  const Vec x = solver.solve(rhs);
+  if(solver.info() != Eigen::Success || !x.allFinite())
+  {
+    ALICEVISION_LOG_DEBUG("Linear translations initialization: solving linear system failed");
+    return false;
+  }
+
+  X[0] = X[1] = X[2] = 0.0;
+  for(int i = 0; i < num_unknowns; ++i)
+    X[3 + i] = x(i);
+  return true;
+}
+
+} // namespace translationAveraging
+} // namespace aliceVision
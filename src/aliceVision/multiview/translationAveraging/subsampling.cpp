@@ -0,0 +1,138 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "subsampling.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <numeric>
+
+namespace aliceVision {
+namespace translationAveraging {
+
+namespace {
+
+/// disjoint sets of the poses, to build the spanning set
+class DisjointSets
+{
+public:
+  explicit DisjointSets(std::size_t size)
+    : _parent(size)
+  {
+    std::iota(_parent.begin(), _parent.end(), 0);
+  }
+
+  std::size_t find(std::size_t i)
+  {
+    while(_parent[i] != i)
+    {
+      _parent[i] = _parent[_parent[i]];
+      i = _parent[i];
+    }
+    return i;
+  }
+
+  /// merge the sets of i and j, return false if they are already in the same set
+  bool unite(std::size_t i, std::size_t j)
+  {
+    i = find(i);
+    j = find(j);
+    if(i == j)
+      return false;
+    _parent[std::max(i, j)] = std::min(i, j);
+    return true;
+  }
+
+private:
+  std::vector<std::size_t> _parent;
+};
+
+} // namespace
+
+void subsampleRelativeEstimates(const RelativeInfoVec& relativeEstimates,
+                                const std::vector<double>& groupScores,
+                                std::size_t groupSize,
+                                std::size_t maxGroupsPerPose,
+                                RelativeInfoVec& keptEstimates,
+                                std::vector<double>* keptScores)
+{
+  assert(groupSize > 0);
+  const std::size_t nbGroups = relativeEstimates.size() / groupSize;
+  assert(groupScores.size() == nbGroups);
+
+  // dense index of the poses
+  std::map<IndexT, std::size_t> poseIndexes;
+  for(const relativeInfo& info : relativeEstimates)
+  {
+    poseIndexes.emplace(info.first.first, poseIndexes.size());
+    poseIndexes.emplace(info.first.second, poseIndexes.size());
+  }
+
+  // poses of each group
+  std::vector<std::vector<std::size_t>> groupPoses(nbGroups);
+  for(std::size_t g = 0; g < nbGroups; ++g)
+  {
+    std::vector<std::size_t>& poses = groupPoses[g];
+    for(std::size_t k = g * groupSize; k < (g + 1) * groupSize; ++k)
+    {
+      poses.push_back(poseIndexes.at(relativeEstimates[k].first.first));
+      poses.push_back(poseIndexes.at(relativeEstimates[k].first.second));
+    }
+    std::sort(poses.begin(), poses.end());
+    poses.erase(std::unique(poses.begin(), poses.end()), poses.end());
+  }
+
+  // groups from the best score
+  std::vector<std::size_t> sortedGroups(nbGroups);
+  std::iota(sortedGroups.begin(), sortedGroups.end(), 0);
+  std::stable_sort(sortedGroups.begin(), sortedGroups.end(), [&](std::size_t a, std::size_t b)
+  {
+    return groupScores[a] > groupScores[b];
+  });
+
+  std::vector<bool> keptGroups(nbGroups, false);
+
+  // spanning set: the best groups connecting some poses
+  DisjointSets sets(poseIndexes.size());
+  for(const std::size_t g : sortedGroups)
+  {
+    bool connecting = false;
+    for(const std::size_t pose : groupPoses[g])
+      connecting |= sets.unite(groupPoses[g].front(), pose);
+    keptGroups[g] = connecting;
+  }
+
+  // best groups of each pose: a group is kept if it is among the maxGroupsPerPose best groups of one of its poses
+  std::vector<std::size_t> rankPerPose(poseIndexes.size(), 0);
+  for(const std::size_t g : sortedGroups)
+  {
+    for(const std::size_t pose : groupPoses[g])
+    {
+      if(rankPerPose[pose]++ < maxGroupsPerPose)
+        keptGroups[g] = true;
+    }
+  }
+
+  keptEstimates.clear();
+  if(keptScores)
+    keptScores->clear();
+  for(std::size_t g = 0; g < nbGroups; ++g)
+  {
+    if(!keptGroups[g])
+      continue;
+    keptEstimates.insert(keptEstimates.end(), relativeEstimates.begin() + g * groupSize, relativeEstimates.begin() + (g + 1) * groupSize);
+    if(keptScores)
+      keptScores->push_back(groupScores[g]);
+  }
+
+  ALICEVISION_LOG_INFO("Relative motions subsampling: " << keptEstimates.size() / groupSize << " groups kept out of " << nbGroups
+                       << " (max " << maxGroupsPerPose << " best groups per pose).");
+}
+
+} // namespace translationAveraging
+} // namespace aliceVision
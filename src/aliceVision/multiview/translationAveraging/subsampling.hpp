@@ -0,0 +1,42 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/multiview/translationAveraging/common.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace translationAveraging {
+
+/**
+ * @brief Select a subset of the relative motions of a highly redundant graph, to reduce the size
+ *        of the translation averaging problem.
+ *
+ * The relative motions are selected by groups sharing the same scale (a single relative motion,
+ * or the 3 relative motions of a triplet). The kept groups are:
+ * - a spanning set of the graph: the best groups linking some poses not yet connected
+ *   (as in a maximum spanning tree), so the connected components of the graph are kept.
+ * - the maxGroupsPerPose best groups of each pose.
+ *
+ * @param[in] relativeEstimates the relative motions, by consecutive groups of groupSize
+ * @param[in] groupScores the score of each group (higher is better, e.g. its number of inliers)
+ * @param[in] groupSize the number of relative motions per group (1 for pairs, 3 for triplets)
+ * @param[in] maxGroupsPerPose the number of best groups kept for each pose
+ * @param[out] keptEstimates the kept relative motions, by groups in their initial order
+ * @param[out] keptScores the score of each kept group (optional)
+ */
+void subsampleRelativeEstimates(const RelativeInfoVec& relativeEstimates,
+                                const std::vector<double>& groupScores,
+                                std::size_t groupSize,
+                                std::size_t maxGroupsPerPose,
+                                RelativeInfoVec& keptEstimates,
+                                std::vector<double>* keptScores = nullptr);
+
+} // namespace translationAveraging
+} // namespace aliceVision
@@ -7,10 +7,12 @@
 
 #include "aliceVision/multiview/translationAveraging/common.hpp"
 #include "aliceVision/multiview/translationAveraging/solver.hpp"
+#include "aliceVision/multiview/translationAveraging/subsampling.hpp"
 #include "aliceVision/multiview/translationAveraging/translationAveragingTest.hpp"
 
 #include <fstream>
 #include <map>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -206,3 +208,97 @@ BOOST_AUTO_TEST_CASE(translation_averaging_globalTi_from_tijs_Triplets_l2_chorda
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(translation_averaging_globalTi_from_tijs_linear) {
+
+  const int focal = 1000;
+  const int principal_Point = 500;
+  //-- Setup a circular camera rig or "cardiod".
+  const int iNviews = 12;
+  const int iNbPoints = 6;
+
+  const bool bCardiod = true;
+  const bool bRelative_Translation_PerTriplet = true;
+  std::vector<aliceVision::translationAveraging::relativeInfo > vec_relative_estimates;
+
+  const NViewDataSet d =
+    Setup_RelativeTranslations_AndNviewDataset
+    (
+      vec_relative_estimates,
+      focal, principal_Point, iNviews, iNbPoints,
+      bCardiod, bRelative_Translation_PerTriplet
+    );
+
+  //-- The linear solution is exact for consistent relative translations (C_j - C_i)
+  std::vector<int> vec_edges;
+  std::vector<double> vec_poses;
+  for (const aliceVision::translationAveraging::relativeInfo & rel : vec_relative_estimates)
+  {
+    vec_edges.push_back(rel.first.first);
+    vec_edges.push_back(rel.first.second);
+    const Vec3 t = d._C[rel.first.second] - d._C[rel.first.first];
+    vec_poses.insert(vec_poses.end(), t.data(), t.data() + 3);
+  }
+
+  std::vector<double> X(iNviews*3);
+  BOOST_CHECK(
+    solve_translations_problem_linear(
+      &vec_edges[0],
+      nullptr,
+      &vec_poses[0],
+      nullptr,
+      vec_relative_estimates.size(),
+      iNviews,
+      &X[0]));
+
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    const Vec3 C(X[i*3], X[i*3+1], X[i*3+2]);
+    EXPECT_MATRIX_NEAR(C, Vec3(d._C[i] - d._C[0]), 1e-8);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(translation_averaging_subsampling) {
+
+  //-- Complete graph of 10 poses: one relative motion per pair, scored by the pose distance
+  const int iNviews = 10;
+  RelativeInfoVec vec_relative_estimates;
+  std::vector<double> vec_scores;
+  for (int i = 0; i < iNviews; ++i)
+  {
+    for (int j = i+1; j < iNviews; ++j)
+    {
+      vec_relative_estimates.emplace_back(Pair(i, j), std::make_pair(Mat3(Mat3::Identity()), Vec3(Vec3::UnitX())));
+      vec_scores.push_back(-std::abs(i - j));
+    }
+  }
+
+  const std::size_t maxGroupsPerPose = 2;
+  RelativeInfoVec vec_kept;
+  std::vector<double> vec_keptScores;
+  subsampleRelativeEstimates(vec_relative_estimates, vec_scores, 1, maxGroupsPerPose, vec_kept, &vec_keptScores);
+
+  BOOST_CHECK_LT(vec_kept.size(), vec_relative_estimates.size());
+  BOOST_CHECK_EQUAL(vec_kept.size(), vec_keptScores.size());
+  // the best pairs (consecutive poses) form the spanning set
+  for (int i = 0; i+1 < iNviews; ++i)
+    BOOST_CHECK(getPairs(vec_kept).count(Pair(i, i+1)));
+  // each kept pair is one of the best pairs of one of its poses
+  for (const relativeInfo & rel : vec_kept)
+    BOOST_CHECK_LE(rel.first.second - rel.first.first, 2);
+  // all the poses are still connected
+  BOOST_CHECK_EQUAL(getIndexT(vec_kept).size(), iNviews);
+
+  //-- Triplets are kept together
+  RelativeInfoVec vec_triplets;
+  std::vector<double> vec_tripletScores;
+  for (int i = 0; i+2 < iNviews; ++i)
+  {
+    for (const Pair & pair : {Pair(i, i+1), Pair(i+1, i+2), Pair(i, i+2)})
+      vec_triplets.emplace_back(pair, std::make_pair(Mat3(Mat3::Identity()), Vec3(Vec3::UnitX())));
+    vec_tripletScores.push_back(i);
+  }
+  subsampleRelativeEstimates(vec_triplets, vec_tripletScores, 3, 1, vec_kept);
+  BOOST_CHECK_EQUAL(vec_kept.size() % 3, 0);
+  BOOST_CHECK_EQUAL(getIndexT(vec_kept).size(), iNviews);
+}
@@ -80,7 +80,7 @@ class NViewsTriangulationLORansac :
    */
   void Fit(const std::vector<std::size_t> &samples, std::vector<Model> *models) const override
   {
-    const Mat p2d = ExtractColumns(_pt2d, samples);
+    const Mat2X p2d = ExtractColumns(_pt2d, samples);
     std::vector< Mat34 > sampledMats;
     pick(sampledMats, _projMatrices, samples);
     Solver::Solve(p2d, sampledMats, *models);
@@ -96,7 +96,7 @@ class NViewsTriangulationLORansac :
               std::vector<Model> *models, 
               const std::vector<double> *weights = nullptr) const override
   {
-    const Mat p2d = ExtractColumns(_pt2d, inliers);
+    const Mat2X p2d = ExtractColumns(_pt2d, inliers);
     std::vector< Mat34 > sampledMats;
     pick(sampledMats, _projMatrices, inliers);
     SolverLS::Solve(p2d, sampledMats, *models, *weights);
@@ -35,6 +35,44 @@ void TriangulateNView(const Mat2X &x,
   *X = X_and_alphas.head(4);
 }
 
+namespace {
+
+/**
+ * @brief TriangulateNViewAlgebraic of the observations [begin, end), whatever their number.
+ * The design matrix is reduced in place to its 4x4 triangular factor R (Householder QR),
+ * which has the same singular values and right singular vectors: only R goes through the SVD.
+ * @param[in,out] design the workspace of the design matrix, enlarged if needed
+ */
+void triangulateNViewAlgebraicRange(const Mat2X &x,
+                                    const std::vector< Mat34 > &Ps,
+                                    std::size_t begin,
+                                    std::size_t end,
+                                    Mat &design,
+                                    Vec4 *X,
+                                    const std::vector<double> *weights)
+{
+  const Mat::Index nbRows = 2 * static_cast<Mat::Index>(end - begin);
+  if(design.rows() < nbRows)
+    design.resize(nbRows, 4);
+
+  Eigen::Block<Mat> rows = design.topRows(nbRows);
+  for(std::size_t i = begin; i < end; ++i)
+  {
+    const Mat::Index r = 2 * static_cast<Mat::Index>(i - begin);
+    rows.block<2, 4>(r, 0) = SkewMatMinimal(x.col(i)) * Ps[i];
+    if(weights != nullptr)
+    {
+      rows.block<2, 4>(r, 0) *= (*weights)[i];
+    }
+  }
+
+  const Eigen::HouseholderQR<Eigen::Ref<Mat>> qr(rows);
+  Mat4 R = qr.matrixQR().topRows<4>().triangularView<Eigen::Upper>();
+  Nullspace(&R, X);
+}
+
+} // namespace
+
 void TriangulateNViewAlgebraic(const Mat2X &x,
                                const std::vector< Mat34 > &Ps,
                                Vec4 *X, 
@@ -44,16 +82,47 @@ void TriangulateNViewAlgebraic(const Mat2X &x,
   Mat2X::Index nviews = x.cols();
   assert(static_cast<std::size_t>(nviews) == Ps.size());
 
-  Mat design(2 * nviews, 4);
-  for(Mat2X::Index i = 0; i < nviews; ++i)
+  // the minimal samples of the robust estimations have fixed size solvers
+  if(nviews == 2)
   {
-    design.block<2, 4>(2 * i, 0) = SkewMatMinimal(x.col(i)) * Ps[i];
-    if(weights != nullptr)
-    {
-      design.block<2, 4>(2 * i, 0) *= (*weights)[i];
-    }
+    TriangulateNViewAlgebraic<2>(x, Ps, X, weights);
+  }
+  else if(nviews == 3)
+  {
+    TriangulateNViewAlgebraic<3>(x, Ps, X, weights);
+  }
+  else
+  {
+    Mat design;
+    triangulateNViewAlgebraicRange(x, Ps, 0, nviews, design, X, weights);
+  }
+}
+
+void TriangulateNViewAlgebraicBatch(const Mat2X &x,
+                                    const std::vector< Mat34 > &Ps,
+                                    const std::vector<std::size_t> &offsets,
+                                    std::vector<Vec4> &Xs,
+                                    const std::vector<double> *weights)
+{
+  assert(!offsets.empty());
+  assert(static_cast<std::size_t>(x.cols()) == Ps.size());
+  assert(offsets.back() == Ps.size());
+
+  Mat design;
+  Xs.resize(offsets.size() - 1);
+
+  for(std::size_t p = 0; p + 1 < offsets.size(); ++p)
+  {
+    const std::size_t nviews = offsets[p + 1] - offsets[p];
+    assert(nviews >= 2);
+
+    if(nviews == 2)
+      detail::triangulateNViewAlgebraicFixed<2>(x, Ps, offsets[p], &Xs[p], weights);
+    else if(nviews == 3)
+      detail::triangulateNViewAlgebraicFixed<3>(x, Ps, offsets[p], &Xs[p], weights);
+    else
+      triangulateNViewAlgebraicRange(x, Ps, offsets[p], offsets[p + 1], design, &Xs[p], weights);
   }
-  Nullspace(&design, X);
 }
 
 void TriangulateNViewLORANSAC(const Mat2X &x, 
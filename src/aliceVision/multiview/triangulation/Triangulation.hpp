@@ -48,6 +48,74 @@ void TriangulateNViewAlgebraic(const Mat2X &x,
                                Vec4 *X, 
                                const std::vector<double> *weights = nullptr);
 
+namespace detail {
+
+/**
+ * @brief TriangulateNViewAlgebraic of the N observations from \p begin,
+ * with a design matrix and an SVD of fixed sizes.
+ */
+template <int N>
+void triangulateNViewAlgebraicFixed(const Mat2X &x,
+                                    const std::vector< Mat34 > &Ps,
+                                    std::size_t begin,
+                                    Vec4 *X,
+                                    const std::vector<double> *weights)
+{
+  static_assert(N >= 2, "The DLT triangulation needs at least 2 views.");
+
+  Eigen::Matrix<double, 2 * N, 4> design;
+  for(int i = 0; i < N; ++i)
+  {
+    design.template block<2, 4>(2 * i, 0) = SkewMatMinimal(x.col(begin + i)) * Ps[begin + i];
+    if(weights != nullptr)
+    {
+      design.template block<2, 4>(2 * i, 0) *= (*weights)[begin + i];
+    }
+  }
+  Nullspace(&design, X);
+}
+
+} // namespace detail
+
+/**
+ * @brief TriangulateNViewAlgebraic for a number of views known at compile time.
+ * The design matrix and its SVD have fixed sizes: nothing is allocated.
+ *
+ * @tparam N the number of views
+ * @param[in] x are 2D coordinates (x,y,1) in each image
+ * @param[in] Ps is the list of projective matrices for each camera
+ * @param[out] X is the estimated 3D point
+ * @param[in] weights a (optional) list of weights for each point
+ */
+template <int N>
+void TriangulateNViewAlgebraic(const Mat2X &x,
+                               const std::vector< Mat34 > &Ps,
+                               Vec4 *X,
+                               const std::vector<double> *weights = nullptr)
+{
+  assert(X != nullptr);
+  assert(x.cols() == N && Ps.size() == N);
+  detail::triangulateNViewAlgebraicFixed<N>(x, Ps, 0, X, weights);
+}
+
+/**
+ * @brief Compute the 3D positions of several points with TriangulateNViewAlgebraic,
+ * in a single call: the points seen by 2 or 3 views use the fixed size solvers and the
+ * design matrices of the others share the same workspace.
+ *
+ * @param[in] x are 2D coordinates (x,y,1) of all the points, the observations of a point are contiguous
+ * @param[in] Ps is the projective matrix of each observation
+ * @param[in] offsets is the index of the first observation of each point, followed by
+ *            the number of observations (size: number of points + 1)
+ * @param[out] Xs are the estimated 3D points
+ * @param[in] weights a (optional) weight for each observation
+ */
+void TriangulateNViewAlgebraicBatch(const Mat2X &x,
+                                    const std::vector< Mat34 > &Ps,
+                                    const std::vector<std::size_t> &offsets,
+                                    std::vector<Vec4> &Xs,
+                                    const std::vector<double> *weights = nullptr);
+
 /**
  * @brief Compute a 3D position of a point from several images of it. In particular,
  * compute the projective point X in R^4 such that x ~ PX.
@@ -226,3 +226,48 @@ BOOST_AUTO_TEST_CASE(Triangulate_NViewIterative_LORANSAC)
   }
 }
 
+BOOST_AUTO_TEST_CASE(Triangulate_NViewAlgebraic_Batch)
+{
+  const int nviews = 5;
+  const int npoints = 8;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints);
+
+  // each point is seen by a different number of views (2 to 5)
+  Mat2X xs(2, 0);
+  std::vector<Mat34> Ps;
+  std::vector<std::size_t> offsets(1, 0);
+  for(int i = 0; i < npoints; ++i)
+  {
+    const int pointViews = 2 + i % (nviews - 1);
+    xs.conservativeResize(2, xs.cols() + pointViews);
+    for(int j = 0; j < pointViews; ++j)
+    {
+      xs.col(offsets.back() + j) = d._x[j].col(i);
+      Ps.push_back(d.P(j));
+    }
+    offsets.push_back(offsets.back() + pointViews);
+  }
+
+  std::vector<Vec4> Xs;
+  TriangulateNViewAlgebraicBatch(xs, Ps, offsets, Xs);
+  BOOST_CHECK_EQUAL(Xs.size(), npoints);
+
+  for(int i = 0; i < npoints; ++i)
+  {
+    // same point as the triangulation of the point alone
+    const std::size_t pointViews = offsets[i + 1] - offsets[i];
+    const Mat2X pointXs = xs.middleCols(offsets[i], pointViews);
+    const std::vector<Mat34> pointPs(Ps.begin() + offsets[i], Ps.begin() + offsets[i + 1]);
+    Vec4 X;
+    TriangulateNViewAlgebraic(pointXs, pointPs, &X);
+    BOOST_CHECK_SMALL((X.hnormalized() - Xs[i].hnormalized()).norm(), 1e-9);
+
+    // Check reprojection error. Should be nearly zero.
+    for(std::size_t j = 0; j < pointViews; ++j)
+    {
+      const Vec2 x_reprojected = (pointPs[j] * Xs[i]).hnormalized();
+      const double error = (x_reprojected - pointXs.col(j)).norm();
+      BOOST_CHECK_SMALL(error, 1e-9);
+    }
+  }
+}
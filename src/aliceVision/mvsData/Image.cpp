@@ -9,6 +9,8 @@
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/mvsData/imageAlgo.hpp>
 
+#include <cmath>
+#include <vector>
 
 namespace aliceVision{
 
@@ -16,40 +18,146 @@ namespace aliceVision{
 void Image::imageDiff(const Image& inImgDownscaled, Image& outImg, unsigned int downscale) const
 {
     outImg.resize(_width, _height);
-    for(int i = 0; i < _width*_height; ++i)
+
+    const int inWidth = inImgDownscaled._width;
+    const int inHeight = inImgDownscaled._height;
+
+    // bilinear interpolation of each column, as getInterpolateColor
+    std::vector<int> xps(_width);
+    std::vector<float> uis(_width);
+    for(int x = 0; x < _width; ++x)
     {
-        Point2d pix(i%_width, static_cast<int>(i/_width));
-        Point2d pixd = pix/downscale;
+        const double xd = static_cast<double>(x) / downscale;
+        xps[x] = std::min(static_cast<int>(xd), inWidth - 2);
+        uis[x] = xd - static_cast<float>(xps[x]);
+    }
 
-        outImg._data[i] = _data[i] - inImgDownscaled.getInterpolateColor(pixd);
+    for(int y = 0; y < _height; ++y)
+    {
+        const double yd = static_cast<double>(y) / downscale;
+        const int yp = std::min(static_cast<int>(yd), inHeight - 2);
+        const float vi = yd - static_cast<float>(yp);
+
+        const float* up = inImgDownscaled._data[yp * inWidth].m;
+        const float* down = inImgDownscaled._data[(yp + 1) * inWidth].m;
+        const float* in = _data[y * _width].m;
+        float* out = outImg._data[y * _width].m;
+
+        for(int x = 0; x < _width; ++x)
+        {
+            const int xp = 3 * xps[x];
+            const float ui = uis[x];
+            for(int c = 0; c < 3; ++c)
+            {
+                const float u = up[xp + c] + (up[xp + 3 + c] - up[xp + c]) * ui;
+                const float d = down[xp + c] + (down[xp + 3 + c] - down[xp + c]) * ui;
+                out[3 * x + c] = in[3 * x + c] - (u + (d - u) * vi);
+            }
+        }
     }
+}
 
+namespace {
+
+/**
+ * @brief Normalized weights of the gaussian filter of 3*downscale pixels for each output pixel along an axis.
+ *        The input pixels out of the image are ignored.
+ * @param[out] begins the first input pixel of each output pixel
+ * @param[out] weights the 3*downscale weights of each output pixel
+ */
+void computeGaussianWeights(int inSize, int outSize, int downscale, std::vector<int>& begins, std::vector<float>& weights)
+{
+    const int nbTaps = 3 * downscale;
+    const float radius = 1.5f * downscale;
+    begins.resize(outSize);
+    weights.assign(outSize * nbTaps, 0.f);
+
+    for(int i = 0; i < outSize; ++i)
+    {
+        // the output pixel i is centered on the input pixel i*d+(d-1)/2
+        begins[i] = i * downscale - downscale;
+        float sum = 0.f;
+        for(int k = 0; k < nbTaps; ++k)
+        {
+            const int j = begins[i] + k;
+            if(j < 0 || j >= inSize)
+                continue;
+            const float dist = ((i + 0.5f) * downscale - (j + 0.5f)) / radius;
+            weights[i * nbTaps + k] = std::exp(-2.f * dist * dist);
+            sum += weights[i * nbTaps + k];
+        }
+        for(int k = 0; k < nbTaps; ++k)
+            weights[i * nbTaps + k] /= sum;
+    }
+}
+
+} // namespace
+
+void Image::downscaleGaussian(unsigned int downscale, Image& outImg) const
+{
+    const int d = static_cast<int>(downscale);
+    const int outWidth = _width / d;
+    const int outHeight = _height / d;
+    outImg.resize(outWidth, outHeight);
+
+    const int nbTaps = 3 * d;
+    std::vector<int> xBegins, yBegins;
+    std::vector<float> xWeights, yWeights;
+    computeGaussianWeights(_width, outWidth, d, xBegins, xWeights);
+    computeGaussianWeights(_height, outHeight, d, yBegins, yWeights);
+
+    // filter the columns in a row buffer, then the row
+    std::vector<float> row(3 * _width);
+    for(int y = 0; y < outHeight; ++y)
+    {
+        std::fill(row.begin(), row.end(), 0.f);
+        for(int k = 0; k < nbTaps; ++k)
+        {
+            const float w = yWeights[y * nbTaps + k];
+            if(w == 0.f)
+                continue;
+            const float* in = _data[(yBegins[y] + k) * _width].m;
+            for(int i = 0; i < 3 * _width; ++i)
+                row[i] += w * in[i];
+        }
+
+        float* out = outImg._data[y * outWidth].m;
+        for(int x = 0; x < outWidth; ++x)
+        {
+            const float* weights = &xWeights[x * nbTaps];
+            // the taps out of the image have null weights
+            const int kBegin = std::max(0, -xBegins[x]);
+            const int kEnd = std::min(nbTaps, _width - xBegins[x]);
+            float color[3] = {0.f, 0.f, 0.f};
+            for(int k = kBegin; k < kEnd; ++k)
+            {
+                const float* in = &row[3 * (xBegins[x] + k)];
+                for(int c = 0; c < 3; ++c)
+                    color[c] += weights[k] * in[c];
+            }
+            for(int c = 0; c < 3; ++c)
+                out[3 * x + c] = color[c];
+        }
+    }
 }
 
 void Image::laplacianPyramid(std::vector<Image>& out_pyramidL, int nbBand, unsigned int downscale) const
 {
     assert(nbBand >= 1);
 
-    Image img(*this);
-    int outW = static_cast<int>(img.width()/downscale);
-    int outH = static_cast<int>(img.height()/downscale);
-
-    Image imgDownscaled(outW, outH);
     out_pyramidL.resize(nbBand);
 
-    //Create Laplacian pyramid
+    // the gaussian level b+1 is computed in out_pyramidL[b+1],
+    // then the laplacian level b replaces the gaussian level b (in place)
+    const Image* gaussianLevel = this;
     for(int b = 0; b < nbBand-1; ++b)
     {
-        imageAlgo::resizeImage(static_cast<int>(downscale), img, imgDownscaled, "gaussian");
-        img.imageDiff(imgDownscaled, out_pyramidL[b], downscale);
-        img.swap(imgDownscaled);
-/*
-        outW = static_cast<int>(outW/downscale);
-        outH = static_cast<int>(outH/downscale);
-        imgDownscaled.resize(outW, outH);
-*/
+        gaussianLevel->downscaleGaussian(downscale, out_pyramidL[b+1]);
+        gaussianLevel->imageDiff(out_pyramidL[b+1], out_pyramidL[b], downscale);
+        gaussianLevel = &out_pyramidL[b+1];
     }
-    out_pyramidL[nbBand-1] = img;
+    if(nbBand == 1)
+        out_pyramidL[0] = *this;
 
     for(std::size_t i = 0; i < out_pyramidL.size(); ++i)
         ALICEVISION_LOG_DEBUG("laplacianDownscalePyramid: Size level " << i << " : " << out_pyramidL[i].width() << "x" << out_pyramidL[i].height());
@@ -94,16 +94,24 @@ public:
 
     /**
      * @brief Calculate the difference between images of different sizes
-     * @param [inImgDownscaled] the smaller image
-     * @param [outImg] the difference
+     * @param [inImgDownscaled] the smaller image, bilinearly upscaled
+     * @param [outImg] the difference, can be this image (in place)
      * @param [downscale] the downscale coefficient between image sizes
      */
     void imageDiff(const Image& inImgDownscaled, Image& outImg, unsigned int downscale) const;
 
+    /**
+     * @brief Downscale the image with a separable gaussian filter of 3*downscale pixels,
+     *        as the OpenImageIO "gaussian" resize filter
+     * @param [downscale] the downscale coefficient
+     * @param [outImg] the downscaled image, its buffer is reused if it has the right size
+     */
+    void downscaleGaussian(unsigned int downscale, Image& outImg) const;
+
     /**
     * @brief Calculate the laplacian pyramid of a given image,
     *        ie. its decomposition in frequency bands
-    * @param [out_pyramidL] the laplacian pyramid
+    * @param [out_pyramidL] the laplacian pyramid, the buffers of the levels with the right sizes are reused
     * @param [nbBand] the number of frequency bands
     * @param [downscale] the downscale coefficient between floors of the pyramid
     */
@@ -0,0 +1,62 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MonotonicArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace aliceVision {
+
+MonotonicArena::MonotonicArena(std::size_t blockBytes)
+    : _blockBytes(std::max(blockBytes, std::size_t(1024)))
+{}
+
+void* MonotonicArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    bytes = std::max(bytes, std::size_t(1));
+
+    // carve the allocation out of the current block, or of the next block large enough
+    for(; _currentBlock < _blocks.size(); ++_currentBlock, _offset = 0)
+    {
+        Block& block = _blocks[_currentBlock];
+        const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(block.data.get());
+        const std::uintptr_t aligned = (begin + _offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+        const std::size_t offset = aligned - begin;
+        if(offset + bytes <= block.bytes)
+        {
+            _offset = offset + bytes;
+            _usedBytes += bytes;
+            return block.data.get() + offset;
+        }
+    }
+
+    // no room left: allocate a new block (aligned as operator new for the default alignments)
+    Block block;
+    block.bytes = std::max(_blockBytes, bytes + alignment);
+    block.data.reset(static_cast<char*>(::operator new(block.bytes)));
+    _blocks.push_back(std::move(block));
+    _currentBlock = _blocks.size() - 1;
+    _offset = 0;
+    return allocate(bytes, alignment);
+}
+
+void MonotonicArena::release()
+{
+    _currentBlock = 0;
+    _offset = 0;
+    _usedBytes = 0;
+}
+
+std::size_t MonotonicArena::getReservedBytes() const
+{
+    std::size_t bytes = 0;
+    for(const Block& block : _blocks)
+        bytes += block.bytes;
+    return bytes;
+}
+
+} // namespace aliceVision
@@ -0,0 +1,127 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace aliceVision {
+
+/**
+ * @brief Monotonic memory arena for the temporary arrays of a processing step (a rc, a voxel).
+ *
+ * The allocations are carved out of large blocks and are never freed one by one:
+ * the whole arena is rewound with release(), keeping its blocks for the next step,
+ * so a loop over the steps stops allocating once the largest step has been seen.
+ * Not thread-safe: use one arena per thread.
+ */
+class MonotonicArena
+{
+public:
+    /**
+     * @param[in] blockBytes The minimum number of bytes of the blocks allocated from the system
+     */
+    explicit MonotonicArena(std::size_t blockBytes = 1024 * 1024);
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    /**
+     * @brief Allocate memory from the arena
+     * @param[in] bytes The number of bytes
+     * @param[in] alignment The alignment, a power of 2
+     * @return the memory, valid until the next release()
+     */
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * @brief Rewind the arena: all its allocations are invalidated, its blocks are kept
+     */
+    void release();
+
+    /// Number of bytes allocated since the last release()
+    std::size_t getUsedBytes() const { return _usedBytes; }
+    /// Number of bytes of the blocks allocated from the system
+    std::size_t getReservedBytes() const;
+
+private:
+    struct BlockDeleter
+    {
+        void operator()(char* p) const { ::operator delete(p); }
+    };
+
+    struct Block
+    {
+        std::unique_ptr<char, BlockDeleter> data;
+        std::size_t bytes = 0;
+    };
+
+    std::size_t _blockBytes;
+    std::vector<Block> _blocks;
+    /// block in which the allocations are carved out
+    std::size_t _currentBlock = 0;
+    /// offset of the next allocation in the current block
+    std::size_t _offset = 0;
+    std::size_t _usedBytes = 0;
+};
+
+/**
+ * @brief Standard allocator on a MonotonicArena, to use with StaticVector or std::vector.
+ *        deallocate() does nothing: the memory is given back by MonotonicArena::release().
+ *        Without arena (default constructed), it allocates from the heap.
+ */
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    ArenaAllocator() = default;
+
+    explicit ArenaAllocator(MonotonicArena& arena)
+        : _arena(&arena)
+    {}
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+        : _arena(other.getArena())
+    {}
+
+    T* allocate(std::size_t n)
+    {
+        if(_arena == nullptr)
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t)
+    {
+        if(_arena == nullptr)
+            ::operator delete(p);
+    }
+
+    MonotonicArena* getArena() const { return _arena; }
+
+private:
+    MonotonicArena* _arena = nullptr;
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.getArena() == b.getArena();
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return !(a == b);
+}
+
+} // namespace aliceVision
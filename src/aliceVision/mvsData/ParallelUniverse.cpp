@@ -0,0 +1,81 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ParallelUniverse.hpp"
+
+#include <utility>
+
+namespace aliceVision {
+
+ParallelUniverse::ParallelUniverse(int elements)
+    : _nbElements(elements)
+    , _parents(new std::atomic<int>[elements])
+{
+    #pragma omp parallel for
+    for(int i = 0; i < elements; ++i)
+        _parents[i].store(i, std::memory_order_relaxed);
+}
+
+int ParallelUniverse::find(int x)
+{
+    int parent = _parents[x].load(std::memory_order_relaxed);
+    while(parent != x)
+    {
+        // path halving: link x to its grand parent, another thread may have done it before
+        const int grandParent = _parents[parent].load(std::memory_order_relaxed);
+        if(grandParent != parent)
+            _parents[x].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+        x = grandParent;
+        parent = _parents[x].load(std::memory_order_relaxed);
+    }
+    return x;
+}
+
+void ParallelUniverse::join(int x, int y)
+{
+    while(true)
+    {
+        x = find(x);
+        y = find(y);
+        if(x == y)
+            return;
+        // the largest root is linked to the smallest one, so there is no cycle and the root is the smallest element
+        if(x < y)
+            std::swap(x, y);
+        int expected = x;
+        if(_parents[x].compare_exchange_strong(expected, y, std::memory_order_relaxed))
+            return;
+        // x is not a root anymore, retry
+    }
+}
+
+int ParallelUniverse::computeLabels(const std::vector<bool>& isLabeled, std::vector<int>& out_labels)
+{
+    std::vector<int> roots(_nbElements);
+    #pragma omp parallel for
+    for(int i = 0; i < _nbElements; ++i)
+        roots[i] = find(i);
+
+    // labels of the roots, in increasing order
+    out_labels.assign(_nbElements, -1);
+    int nbLabels = 0;
+    for(int i = 0; i < _nbElements; ++i)
+    {
+        if(roots[i] == i && (isLabeled.empty() || isLabeled[i]))
+            out_labels[i] = nbLabels++;
+    }
+
+    #pragma omp parallel for
+    for(int i = 0; i < _nbElements; ++i)
+    {
+        if(roots[i] != i && (isLabeled.empty() || isLabeled[i]))
+            out_labels[i] = out_labels[roots[i]];
+    }
+
+    return nbLabels;
+}
+
+} // namespace aliceVision
@@ -0,0 +1,51 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace aliceVision {
+
+/**
+ * @brief Labelling by connecting elements from multiple threads (lock-free union-find).
+ *
+ * The root of each set is its smallest element, so the sets and the labels do not depend
+ * on the order of the joins, nor on the number of threads.
+ *
+ * @see Universe, single-threaded.
+ */
+class ParallelUniverse
+{
+public:
+    explicit ParallelUniverse(int elements);
+
+    /// Retrieve the smallest element connected to x, thread-safe.
+    int find(int x);
+    /// Connect the sets of x and y, thread-safe.
+    void join(int x, int y);
+
+    /**
+     * @brief Label the sets in the order of their smallest element, once all the joins are done.
+     * @param[in] isLabeled the elements to label, the others get the label -1 (all if empty)
+     * @param[out] out_labels the label of each element
+     * @return the number of labels
+     */
+    int computeLabels(const std::vector<bool>& isLabeled, std::vector<int>& out_labels);
+
+    inline int getNbElements() const
+    {
+        return _nbElements;
+    }
+
+private:
+    const int _nbElements;
+    std::unique_ptr<std::atomic<int>[]> _parents;
+};
+
+} // namespace aliceVision
@@ -5,7 +5,9 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "StaticVector.hpp"
+#include <aliceVision/alicevision_omp.hpp>
 
+#include <cstdint>
 #include <cstdio>
 
 namespace aliceVision {
@@ -21,14 +23,14 @@ int getArrayLengthFromFile(std::string fileName)
 
     int n = 0;
     size_t retval = fread(&n, sizeof(int), 1, f);
-    if( retval != sizeof(int) )
+    if( retval != 1 )
     {
         ALICEVISION_LOG_WARNING("[IO] getArrayLengthFromFile: can't read array length (1)");
     }
-    if(n == -1)
+    if(n == -1 || n == -2)
     {
         retval = fread(&n, sizeof(int), 1, f);
-        if( retval != sizeof(int) )
+        if( retval != 1 )
         {
             ALICEVISION_LOG_WARNING("[IO] getArrayLengthFromFile: can't read array length (2)");
         }
@@ -37,4 +39,101 @@ int getArrayLengthFromFile(std::string fileName)
     return n;
 }
 
+namespace {
+
+/// number of uncompressed bytes of a chunk of the compressed array files
+const std::uint64_t compressedChunkBytes = 4 * 1024 * 1024;
+
+} // namespace
+
+void writeCompressedChunks(FILE* f, const std::string& fileName, const void* data, std::size_t bytes)
+{
+    const std::uint64_t chunkBytes = compressedChunkBytes;
+    const std::uint32_t nbChunks = static_cast<std::uint32_t>((bytes + chunkBytes - 1) / chunkBytes);
+
+    std::vector<std::vector<Bytef>> chunks(nbChunks);
+    std::vector<std::uint64_t> chunksCompressedBytes(nbChunks, 0);
+    std::vector<int> errors(nbChunks, Z_OK);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < static_cast<int>(nbChunks); ++i)
+    {
+        const std::size_t offset = i * chunkBytes;
+        const uLong sourceLen = static_cast<uLong>(std::min<std::size_t>(chunkBytes, bytes - offset));
+        uLongf destLen = compressBound(sourceLen);
+
+        chunks[i].resize(destLen);
+        errors[i] = compress2(chunks[i].data(), &destLen, static_cast<const Bytef*>(data) + offset, sourceLen, Z_BEST_SPEED);
+        chunksCompressedBytes[i] = destLen;
+    }
+
+    for(std::uint32_t i = 0; i < nbChunks; ++i)
+    {
+        if(errors[i] != Z_OK)
+            ALICEVISION_THROW_ERROR("[IO] compress error " << errors[i] << " on chunk " << i << " of " << fileName);
+    }
+
+    if(fwrite(&chunkBytes, sizeof(std::uint64_t), 1, f) != 1 ||
+       fwrite(&nbChunks, sizeof(std::uint32_t), 1, f) != 1 ||
+       fwrite(chunksCompressedBytes.data(), sizeof(std::uint64_t), nbChunks, f) != nbChunks)
+    {
+        ALICEVISION_THROW_ERROR("[IO] failed to write the chunks table to " << fileName << ", msg: " << strerror(errno));
+    }
+
+    for(std::uint32_t i = 0; i < nbChunks; ++i)
+    {
+        if(fwrite(chunks[i].data(), sizeof(Bytef), chunksCompressedBytes[i], f) != chunksCompressedBytes[i])
+            ALICEVISION_THROW_ERROR("[IO] failed to write chunk " << i << " to " << fileName << ", msg: " << strerror(errno));
+    }
+}
+
+void readCompressedChunks(FILE* f, const std::string& fileName, void* data, std::size_t bytes)
+{
+    std::uint64_t chunkBytes = 0;
+    std::uint32_t nbChunks = 0;
+    if(fread(&chunkBytes, sizeof(std::uint64_t), 1, f) != 1 ||
+       fread(&nbChunks, sizeof(std::uint32_t), 1, f) != 1)
+    {
+        ALICEVISION_THROW_ERROR("[IO] readCompressedChunks: can't read the chunks header from " << fileName);
+    }
+    if(chunkBytes == 0 || nbChunks != (bytes + chunkBytes - 1) / chunkBytes)
+    {
+        ALICEVISION_THROW_ERROR("[IO] readCompressedChunks: invalid chunks header in " << fileName
+                                << " (chunk size: " << chunkBytes << ", nb chunks: " << nbChunks << ", array bytes: " << bytes << ")");
+    }
+
+    std::vector<std::uint64_t> chunksCompressedBytes(nbChunks);
+    if(fread(chunksCompressedBytes.data(), sizeof(std::uint64_t), nbChunks, f) != nbChunks)
+        ALICEVISION_THROW_ERROR("[IO] readCompressedChunks: can't read the chunks table from " << fileName);
+
+    std::vector<std::size_t> chunksOffset(nbChunks + 1, 0);
+    for(std::uint32_t i = 0; i < nbChunks; ++i)
+        chunksOffset[i + 1] = chunksOffset[i] + chunksCompressedBytes[i];
+
+    // only the compressed chunks are buffered, they are decompressed in place in the array
+    std::vector<Bytef> compressed(chunksOffset.back());
+    if(fread(compressed.data(), sizeof(Bytef), compressed.size(), f) != compressed.size())
+        ALICEVISION_THROW_ERROR("[IO] readCompressedChunks: can't read the chunks from " << fileName);
+
+    std::vector<int> errors(nbChunks, Z_OK);
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < static_cast<int>(nbChunks); ++i)
+    {
+        const std::size_t offset = i * chunkBytes;
+        const uLongf expectedLen = static_cast<uLongf>(std::min<std::size_t>(chunkBytes, bytes - offset));
+        uLongf destLen = expectedLen;
+
+        errors[i] = uncompress(static_cast<Bytef*>(data) + offset, &destLen, compressed.data() + chunksOffset[i], static_cast<uLong>(chunksCompressedBytes[i]));
+        if(errors[i] == Z_OK && destLen != expectedLen)
+            errors[i] = Z_DATA_ERROR;
+    }
+
+    for(std::uint32_t i = 0; i < nbChunks; ++i)
+    {
+        if(errors[i] != Z_OK)
+            ALICEVISION_THROW_ERROR("[IO] readCompressedChunks: uncompress error " << errors[i] << " on chunk " << i << " of " << fileName);
+    }
+}
+
 } // namespace aliceVision
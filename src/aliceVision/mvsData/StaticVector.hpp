@@ -6,15 +6,18 @@
 
 #pragma once
 
+#include <aliceVision/mvsData/MonotonicArena.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #include <algorithm>
 #include <assert.h>
+#include <cstdio>
 #include <cstdlib>
 #include <sstream>
 #include <vector>
 #include <zlib.h>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 
 #include <boost/filesystem.hpp>
@@ -22,20 +25,29 @@
 
 namespace aliceVision {
 
-template <class T>
+/**
+ * @brief Array of the MVS modules.
+ *        The Allocator allows to put the temporary arrays of the hot loops in a MonotonicArena
+ *        (see ArenaAllocator).
+ */
+template <class T, class Allocator = std::allocator<T>>
 class StaticVector
 {
-    std::vector<T> _data;
+    std::vector<T, Allocator> _data;
 
-    typedef typename std::vector<T>::iterator Iterator;
-    typedef typename std::vector<T>::const_iterator ConstIterator;
-    typedef typename std::vector<T>::reference Reference;
-    typedef typename std::vector<T>::const_reference ConstReference;
+    typedef typename std::vector<T, Allocator>::iterator Iterator;
+    typedef typename std::vector<T, Allocator>::const_iterator ConstIterator;
+    typedef typename std::vector<T, Allocator>::reference Reference;
+    typedef typename std::vector<T, Allocator>::const_reference ConstReference;
 
 public:
     StaticVector()
     {}
 
+    explicit StaticVector( const Allocator& allocator )
+        : _data( allocator )
+    {}
+
     StaticVector( int n )
         : _data( n )
     {}
@@ -65,8 +77,8 @@ public:
     Reference front() { return _data.front(); }
     ConstReference front() const { return _data.front(); }
 
-    const std::vector<T>& getData() const { return _data; }
-    std::vector<T>& getDataWritable() { return _data; }
+    const std::vector<T, Allocator>& getData() const { return _data; }
+    std::vector<T, Allocator>& getDataWritable() { return _data; }
     int size() const { return _data.size(); }
     bool empty() const { return _data.empty(); }
     size_t capacity() const { return _data.capacity(); }
@@ -277,6 +289,27 @@ StaticVector<StaticVector<T>*>* loadArrayOfArraysFromFile(std::string fileName)
     return aa;
 }
 
+/**
+ * @brief Write a buffer in the chunked compressed array format.
+ *        The buffer is split in chunks of 4 MB, compressed in parallel with zlib at its fastest level.
+ *        Layout: chunk size (uint64), number of chunks (uint32), compressed size of each chunk (uint64), chunks.
+ * @param[in] f The file, positioned after the array marker (-2) and the number of elements
+ * @param[in] fileName The file name, for the error messages
+ * @param[in] data The buffer of the elements
+ * @param[in] bytes The number of bytes of the buffer
+ */
+void writeCompressedChunks(FILE* f, const std::string& fileName, const void* data, std::size_t bytes);
+
+/**
+ * @brief Read a buffer written by writeCompressedChunks.
+ *        The chunks are decompressed in parallel, directly into the buffer.
+ * @param[in] f The file, positioned after the array marker (-2) and the number of elements
+ * @param[in] fileName The file name, for the error messages
+ * @param[out] data The buffer of the elements, already allocated
+ * @param[in] bytes The number of bytes of the buffer
+ */
+void readCompressedChunks(FILE* f, const std::string& fileName, void* data, std::size_t bytes);
+
 template <class T>
 void saveArrayToFile(std::string fileName, const StaticVector<T>& a, bool docompress = true)
 {
@@ -332,97 +365,35 @@ void saveArrayToFile(std::string fileName, const StaticVector<T>* a, bool docomp
     }
     else
     {
-
-        /* ===========================================================================
-        //from zlib - compress.c
-             Compresses the source buffer into the destination buffer. The level
-           parameter has the same meaning as in deflateInit.  sourceLen is the byte
-           length of the source buffer. Upon entry, destLen is the total size of the
-           destination buffer, which must be at least 0.1% larger than sourceLen plus
-           12 bytes. Upon exit, destLen is the actual size of the compressed buffer.
-
-             compress2 returns Z_OK if success, Z_MEM_ERROR if there was not enough
-           memory, Z_BUF_ERROR if there was not enough room in the output buffer,
-           Z_STREAM_ERROR if the level parameter is invalid.
-        */
-
-        // uLong comprLen = sizeof(T)*a->size();
-        uLong comprLen = uLong((double)(sizeof(T) * a->size()) * 1.02) + 12;
-        Byte* compr = (Byte*)calloc((uInt)comprLen, 1);
-        int err = compress(compr, &comprLen, (const Bytef*)(&(*a)[0]), sizeof(T) * a->size());
-
-        if(err != Z_OK)
+        FILE* f = fopen(fileName.c_str(), "wb");
+        if( f == NULL )
+        {
+            ALICEVISION_THROW_ERROR( "[IO] file " << fileName << " could not be opened, msg: " << strerror(errno) );
+        }
+        int n = -2;
+        int items = fwrite(&n, sizeof(int), 1, f);
+        if( items < 1 && ferror(f) != 0 )
         {
-            ALICEVISION_LOG_ERROR("compress error " << err << " : " << (sizeof(T) * a->size()) << " -> " << comprLen << ", n " << a->size());
-
-            FILE* f = fopen(fileName.c_str(), "wb");
-            if( f == NULL )
-            {
-                free(compr);
-                ALICEVISION_THROW_ERROR( "[IO] file " << fileName << " could not be opened, msg: " << strerror(errno) );
-            }
-            int n = a->size();
-            if( n > 0 )
-            {
-                int items = fwrite(&n, sizeof(int), 1, f);
-                if( items < 1 && ferror(f) != 0 )
-                {
-                    fclose(f);
-                    free(compr);
-                    ALICEVISION_THROW_ERROR( "[IO] failed to write 1 int to " << fileName << ", msg: " << strerror(errno) );
-                }
-                items = fwrite(&(*a)[0], sizeof(T), n, f);
-                if( items < 1 && ferror(f) != 0 )
-                {
-                    fclose(f);
-                    free(compr);
-                    ALICEVISION_THROW_ERROR( "[IO] failed to write " << n << " items to " << fileName << ", msg: " << strerror(errno) );
-                }
-            }
             fclose(f);
+            ALICEVISION_THROW_ERROR( "[IO] failed to write 1 int to " << fileName << ", msg: " << strerror(errno) );
         }
-        else
+        n = a->size();
+        items = fwrite(&n, sizeof(int), 1, f);
+        if( items < 1 && ferror(f) != 0 )
         {
-            FILE* f = fopen(fileName.c_str(), "wb");
-            if( f == NULL )
-            {
-                free(compr);
-                ALICEVISION_THROW_ERROR( "[IO] file " << fileName << " could not be opened, msg: " << strerror(errno) );
-            }
-            int n = -1;
-            int items = fwrite(&n, sizeof(int), 1, f);
-            if( items < 1 && ferror(f) != 0 )
-            {
-                fclose(f);
-                free(compr);
-                ALICEVISION_THROW_ERROR( "[IO] failed to write 1 int to " << fileName << ", msg: " << strerror(errno) );
-            }
-            n = a->size();
-            items = fwrite(&n, sizeof(int), 1, f);
-            if( items < 1 && ferror(f) != 0 )
-            {
-                fclose(f);
-                free(compr);
-                ALICEVISION_THROW_ERROR( "[IO] failed to write 1 int to " << fileName << ", msg: " << strerror(errno) );
-            }
-            items = fwrite(&comprLen, sizeof(uLong), 1, f);
-            if( items < 1 && ferror(f) != 0 )
-            {
-                fclose(f);
-                free(compr);
-                ALICEVISION_THROW_ERROR( "[IO] failed to write 1 uLong to " << fileName << ", msg: " << strerror(errno) );
-            }
-            items = fwrite(compr, sizeof(Byte), comprLen, f);
-            if( items < 1 && ferror(f) != 0 )
-            {
-                fclose(f);
-                free(compr);
-                ALICEVISION_THROW_ERROR( "[IO] failed to write " << comprLen << " items to " << fileName << ", msg: " << strerror(errno) );
-            }
             fclose(f);
-        };
-
-        free(compr);
+            ALICEVISION_THROW_ERROR( "[IO] failed to write 1 int to " << fileName << ", msg: " << strerror(errno) );
+        }
+        try
+        {
+            writeCompressedChunks(f, fileName, &(*a)[0], sizeof(T) * a->size());
+        }
+        catch(...)
+        {
+            fclose(f);
+            throw;
+        }
+        fclose(f);
     };
 }
 
@@ -494,6 +465,27 @@ StaticVector<T>* loadArrayFromFile(std::string fileName, bool printfWarning = fa
 
             free(compr);
         }
+        else if(n == -2)
+        {
+            retval = fread(&n, sizeof(int), 1, f);
+            if( retval != 1 )
+            {
+                fclose(f);
+                ALICEVISION_THROW_ERROR("[IO] loadArrayFromFile: can't read array size (2)");
+            }
+            a = new StaticVector<T>();
+            a->resize(n);
+            try
+            {
+                readCompressedChunks(f, fileName, &(*a)[0], sizeof(T) * n);
+            }
+            catch(...)
+            {
+                delete a;
+                fclose(f);
+                throw;
+            }
+        }
         else
         {
             a = new StaticVector<T>();
@@ -563,6 +555,22 @@ bool loadArrayFromFile( StaticVector<T>& out, std::string fileName, bool printfW
 
             free(compr);
         }
+        else if(n == -2)
+        {
+            retval = fread(&n, sizeof(int), 1, f);
+            if( retval != 1 )
+                ALICEVISION_LOG_WARNING("[IO] loadArrayFromFile: can't read array size (2)");
+            out.resize(n);
+            try
+            {
+                readCompressedChunks(f, fileName, out.getDataWritable().data(), sizeof(T) * n);
+            }
+            catch(...)
+            {
+                fclose(f);
+                throw;
+            }
+        }
         else
         {
             out.resize(n);
@@ -621,6 +629,24 @@ void loadArrayFromFileIntoArray(StaticVector<T>* a, std::string fileName, bool p
  
         free(compr);
     }
+    else if(n == -2)
+    {
+        fread(&n, sizeof(int), 1, f);
+        if(a->size() != n)
+        {
+            fclose(f);
+            ALICEVISION_THROW_ERROR("loadArrayFromFileIntoArray: expected length " << a->size() << " loaded length " << n);
+        }
+        try
+        {
+            readCompressedChunks(f, fileName, &(*a)[0], sizeof(T) * n);
+        }
+        catch(...)
+        {
+            fclose(f);
+            throw;
+        }
+    }
     else
     {
         if(a->size() != n)
@@ -7,6 +7,7 @@
 #include "imageIO.hpp"
 
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Storage.hpp>
 #include <aliceVision/mvsData/Color.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
 #include <aliceVision/mvsData/Image.hpp>
@@ -16,8 +17,6 @@
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 
-#include <OpenEXR/half.h>
-
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
 
@@ -160,14 +159,18 @@ oiio::ParamValueList getMetadataFromMap(const std::map<std::string, std::string>
 void readImageSpec(const std::string& path,
                    int& width,
                    int& height,
-                   int& nchannels)
+                   int& nchannels,
+                   int mipLevel)
 {
   ALICEVISION_LOG_DEBUG("[IO] Read Image Spec: " << path);
-  std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(path));
+  std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(system::Storage::get().getLocalPath(path)));
 
   if(!in)
     throw std::runtime_error("Can't find/open image file '" + path + "'.");
 
+  if(mipLevel != 0 && !in->seek_subimage(0, mipLevel))
+    throw std::runtime_error("Can't find the MIP level " + std::to_string(mipLevel) + " of image file '" + path + "'.");
+
   const oiio::ImageSpec &spec = in->spec();
 
   width = spec.width;
@@ -180,7 +183,7 @@ void readImageSpec(const std::string& path,
 void readImageMetadata(const std::string& path, oiio::ParamValueList& metadata)
 {
   ALICEVISION_LOG_DEBUG("[IO] Read Image Metadata: " << path);
-  std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(path));
+  std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(system::Storage::get().getLocalPath(path)));
 
   if(!in)
     throw std::runtime_error("Can't find/open image file '" + path + "'.");
@@ -225,7 +228,8 @@ void readImage(const std::string& path,
     configSpec.attribute("raw:ColorSpace", "Linear");   // want linear colorspace with sRGB primaries
 #endif
 
-    oiio::ImageBuf inBuf(path, 0, 0, NULL, &configSpec);
+    // local copy of a remote image
+    oiio::ImageBuf inBuf(system::Storage::get().getLocalPath(path), 0, 0, NULL, &configSpec);
 
     inBuf.read(0, 0, true, oiio::TypeDesc::FLOAT); // force image convertion to float (for grayscale and color space convertion)
 
@@ -334,6 +338,11 @@ void readImage(const std::string& path, int& width, int& height, std::vector<flo
     readImage(path, oiio::TypeDesc::FLOAT, 1, width, height, buffer, toColorSpace);
 }
 
+void readImage(const std::string& path, int& width, int& height, std::vector<half>& buffer, EImageColorSpace toColorSpace)
+{
+    readImage(path, oiio::TypeDesc::HALF, 1, width, height, buffer, toColorSpace);
+}
+
 void readImage(const std::string& path, int& width, int& height, std::vector<Color>& buffer, EImageColorSpace toColorSpace)
 {
     readImage(path, oiio::TypeDesc::FLOAT, 3, width, height, buffer, toColorSpace);
@@ -347,6 +356,62 @@ void readImage(const std::string& path, Image& image, EImageColorSpace toColorSp
     image.setHeight(height);
 }
 
+void readImageRegion(const std::string& path, int mipLevel, int xBegin, int yBegin, int xEnd, int yEnd, std::vector<float>& buffer)
+{
+    ALICEVISION_LOG_DEBUG("[IO] Read Image Region: " << path << " (MIP level " << mipLevel << ")");
+    std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(system::Storage::get().getLocalPath(path)));
+
+    if(!in)
+        throw std::runtime_error("Can't find/open image file '" + path + "'.");
+
+    if(!in->seek_subimage(0, mipLevel))
+        throw std::runtime_error("Can't find the MIP level " + std::to_string(mipLevel) + " of image file '" + path + "'.");
+
+    const oiio::ImageSpec& spec = in->spec();
+
+    if(xBegin < 0 || yBegin < 0 || xEnd > spec.width || yEnd > spec.height || xBegin >= xEnd || yBegin >= yEnd)
+        throw std::out_of_range("Invalid region [" + std::to_string(xBegin) + ", " + std::to_string(xEnd) + "[ x [" +
+                                std::to_string(yBegin) + ", " + std::to_string(yEnd) + "[ of image file '" + path + "'.");
+
+    const int width = xEnd - xBegin;
+    const int height = yEnd - yBegin;
+    buffer.resize(width * height);
+
+    // the read area, aligned on the tiles of a tiled image or full rows of a scanline image
+    int areaXBegin = 0;
+    int areaXEnd = spec.width;
+    int areaYBegin = yBegin;
+    int areaYEnd = yEnd;
+
+    if(spec.tile_width > 0)
+    {
+        areaXBegin = (xBegin / spec.tile_width) * spec.tile_width;
+        areaXEnd = std::min(spec.width, ((xEnd + spec.tile_width - 1) / spec.tile_width) * spec.tile_width);
+        areaYBegin = (yBegin / spec.tile_height) * spec.tile_height;
+        areaYEnd = std::min(spec.height, ((yEnd + spec.tile_height - 1) / spec.tile_height) * spec.tile_height);
+    }
+
+    const int areaWidth = areaXEnd - areaXBegin;
+    std::vector<float> area(areaWidth * (areaYEnd - areaYBegin));
+
+    bool success;
+    if(spec.tile_width > 0)
+        success = in->read_tiles(spec.x + areaXBegin, spec.x + areaXEnd, spec.y + areaYBegin, spec.y + areaYEnd, 0, 1, 0, 1, oiio::TypeDesc::FLOAT, area.data());
+    else
+        success = in->read_scanlines(spec.y + areaYBegin, spec.y + areaYEnd, 0, 0, 1, oiio::TypeDesc::FLOAT, area.data());
+
+    if(!success)
+        throw std::runtime_error("Can't read the region of image file '" + path + "': " + in->geterror());
+
+    for(int y = 0; y < height; ++y)
+    {
+        const float* areaRow = area.data() + (y + yBegin - areaYBegin) * areaWidth + (xBegin - areaXBegin);
+        std::copy(areaRow, areaRow + width, buffer.begin() + y * width);
+    }
+
+    in->close();
+}
+
 template<typename T>
 void writeImage(const std::string& path,
                 oiio::TypeDesc typeDesc,
@@ -429,6 +494,11 @@ void writeImage(const std::string& path, int width, int height, const std::vecto
     writeImage(path, oiio::TypeDesc::FLOAT, width, height, 1, buffer, imageQuality, colorspace, metadata);
 }
 
+void writeImage(const std::string& path, int width, int height, const std::vector<half>& buffer, EImageQuality imageQuality, OutputFileColorSpace& colorspace, const oiio::ParamValueList& metadata)
+{
+    writeImage(path, oiio::TypeDesc::HALF, width, height, 1, buffer, imageQuality, colorspace, metadata);
+}
+
 void writeImage(const std::string& path, int width, int height, const std::vector<Color>& buffer, EImageQuality imageQuality, OutputFileColorSpace& colorspace, const oiio::ParamValueList& metadata)
 {
     writeImage(path, oiio::TypeDesc::FLOAT, width, height, 3, buffer, imageQuality, colorspace, metadata);
@@ -439,5 +509,138 @@ void writeImage(const std::string &path, Image &image, EImageQuality imageQualit
     writeImage(path, oiio::TypeDesc::FLOAT, image.width(), image.height(), 3, image.data(), imageQuality, colorspace, metadata);
 }
 
+void writeImageTiled(const std::string& path, int width, int height, const std::vector<float>& buffer, EImageQuality imageQuality, const oiio::ParamValueList& metadata)
+{
+    const fs::path bPath = fs::path(path);
+    const std::string extension = bPath.extension().string();
+
+    if(extension != ".exr")
+    {
+        OutputFileColorSpace colorspace(EImageColorSpace::NO_CONVERSION);
+        writeImage(path, width, height, buffer, imageQuality, colorspace, metadata);
+        return;
+    }
+
+    const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + extension;
+
+    ALICEVISION_LOG_DEBUG("[IO] Write Tiled Image: " << path << std::endl
+                       << "\t- width: " << width << std::endl
+                       << "\t- height: " << height);
+
+    // tile size of the EXR files, the readers of a region read the tiles covering it
+    const int tileSize = 64;
+
+    oiio::ImageSpec imageSpec(width, height, 1, (imageQuality == EImageQuality::OPTIMIZED) ? oiio::TypeDesc::HALF : oiio::TypeDesc::FLOAT);
+    imageSpec.extra_attribs = metadata; // add custom metadata
+    imageSpec.tile_width = tileSize;
+    imageSpec.tile_height = tileSize;
+    imageSpec.attribute("compression", "piz");
+    imageSpec.attribute("openexr:levelmode", 1);    // Imf::MIPMAP_LEVELS
+    imageSpec.attribute("openexr:roundingmode", 0); // Imf::ROUND_DOWN
+
+    std::unique_ptr<oiio::ImageOutput> out(oiio::ImageOutput::create(tmpPath));
+
+    if(!out || !out->supports("tiles") || !out->supports("mipmap"))
+        throw std::runtime_error("Can't write tiled image file '" + path + "'.");
+
+    if(!out->open(tmpPath, imageSpec))
+        throw std::runtime_error("Can't write output image file '" + path + "': " + out->geterror());
+
+    // the MIP levels are written down to 1x1, each one from the previous one
+    std::vector<float> level = buffer;
+    std::vector<float> nextLevel;
+    int levelWidth = width;
+    int levelHeight = height;
+
+    for(;;)
+    {
+        if(!out->write_image(oiio::TypeDesc::FLOAT, level.data()))
+            throw std::runtime_error("Can't write output image file '" + path + "': " + out->geterror());
+
+        if(levelWidth == 1 && levelHeight == 1)
+            break;
+
+        const int nextWidth = std::max(1, levelWidth / 2);
+        const int nextHeight = std::max(1, levelHeight / 2);
+        nextLevel.resize(nextWidth * nextHeight);
+
+        for(int y = 0; y < nextHeight; ++y)
+            for(int x = 0; x < nextWidth; ++x)
+                nextLevel[y * nextWidth + x] = level[(2 * y) * levelWidth + 2 * x];
+
+        level.swap(nextLevel);
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+
+        oiio::ImageSpec levelSpec = imageSpec;
+        levelSpec.width = levelSpec.full_width = levelWidth;
+        levelSpec.height = levelSpec.full_height = levelHeight;
+
+        if(!out->open(tmpPath, levelSpec, oiio::ImageOutput::AppendMIPLevel))
+            throw std::runtime_error("Can't write output image file '" + path + "': " + out->geterror());
+    }
+
+    out->close();
+    out.reset();
+
+    // rename temporay filename
+    fs::rename(tmpPath, path);
+}
+
+void writeImageTiled(const std::string& path, const Image& image, EImageQuality imageQuality, OutputFileColorSpace colorspace, const oiio::ParamValueList& metadata)
+{
+    const fs::path bPath = fs::path(path);
+    const std::string extension = bPath.extension().string();
+    const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + extension;
+    const bool isEXR = (extension == ".exr");
+
+    std::unique_ptr<oiio::ImageOutput> out(oiio::ImageOutput::create(tmpPath));
+    if(!out || !out->supports("tiles"))
+    {
+        writeImage(path, image.width(), image.height(), image.data(), imageQuality, colorspace, metadata);
+        return;
+    }
+
+    if(colorspace.to == EImageColorSpace::AUTO)
+        colorspace.to = EImageColorSpace::LINEAR;
+
+    ALICEVISION_LOG_DEBUG("[IO] Write Tiled Image: " << path << std::endl
+                       << "\t- width: " << image.width() << std::endl
+                       << "\t- height: " << image.height());
+
+    const int tileSize = 64;
+
+    oiio::ImageSpec imageSpec(image.width(), image.height(), 3, (imageQuality == EImageQuality::OPTIMIZED && isEXR) ? oiio::TypeDesc::HALF : oiio::TypeDesc::FLOAT);
+    imageSpec.extra_attribs = metadata; // add custom metadata
+    imageSpec.tile_width = tileSize;
+    imageSpec.tile_height = tileSize;
+    imageSpec.attribute("CompressionQuality", 100);             // if possible, best compression quality
+    imageSpec.attribute("compression", isEXR ? "piz" : "none"); // if possible, set compression (piz for EXR, none for the other)
+
+    if(!out->open(tmpPath, imageSpec))
+        throw std::runtime_error("Can't write output image file '" + path + "': " + out->geterror());
+
+    // the rows of tiles are converted in a buffer, the file format conversion is done by the writer
+    std::vector<Color> rows;
+    for(int y = 0; y < image.height(); y += tileSize)
+    {
+        const int nbRows = std::min(tileSize, image.height() - y);
+        const auto begin = image.data().begin() + std::size_t(y) * image.width();
+        rows.assign(begin, begin + std::size_t(nbRows) * image.width());
+
+        oiio::ImageBuf rowsBuf(oiio::ImageSpec(image.width(), nbRows, 3, oiio::TypeDesc::FLOAT), rows.data());
+        imageAlgo::colorconvert(rowsBuf, colorspace.from, colorspace.to);
+
+        if(!out->write_tiles(0, image.width(), y, y + nbRows, 0, 1, oiio::TypeDesc::FLOAT, rows.data()))
+            throw std::runtime_error("Can't write output image file '" + path + "': " + out->geterror());
+    }
+
+    out->close();
+    out.reset();
+
+    // rename temporay filename
+    fs::rename(tmpPath, path);
+}
+
 } // namespace imageIO
 } // namespace aliceVision
@@ -7,9 +7,12 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <OpenImageIO/paramlist.h>
 
+#include <OpenEXR/half.h>
+
 namespace oiio = OIIO;
 
 namespace aliceVision {
@@ -163,8 +166,9 @@ std::istream& operator>>(std::istream& in, EImageFileType& imageFileType);
  * @param[out] width The image width
  * @param[out] height The image height
  * @param[out] nchannels The image channel number
+ * @param[in] mipLevel The MIP level of the image, 0 for the full resolution
  */
-void readImageSpec(const std::string& path, int& width, int& height, int& nchannels);
+void readImageSpec(const std::string& path, int& width, int& height, int& nchannels, int mipLevel = 0);
 
 /**
  * @brief read image metadata from a given path
@@ -192,9 +196,21 @@ void readImage(const std::string& path, int& width, int& height, std::vector<uns
 void readImage(const std::string& path, int& width, int& height, std::vector<unsigned short>& buffer, EImageColorSpace toColorSpace);
 void readImage(const std::string& path, int& width, int& height, std::vector<rgb>& buffer, EImageColorSpace toColorSpace);
 void readImage(const std::string& path, int& width, int& height, std::vector<float>& buffer, EImageColorSpace toColorSpace);
+void readImage(const std::string& path, int& width, int& height, std::vector<half>& buffer, EImageColorSpace toColorSpace);
 void readImage(const std::string& path, int& width, int& height, std::vector<Color>& buffer, EImageColorSpace toColorSpace);
 void readImage(const std::string& path, Image& image, EImageColorSpace toColorSpace);
 
+/**
+ * @brief read a region of a single channel float image, without color conversion
+ *        (eg depth or similarity maps). Only the tiles covering the region of a tiled image are read.
+ * @param[in] path The given path to the image
+ * @param[in] mipLevel The MIP level to read, 0 for the full resolution (see writeImageTiled)
+ * @param[in] xBegin, yBegin The first pixel of the region, in the MIP level
+ * @param[in] xEnd, yEnd The end of the region (excluded), in the MIP level
+ * @param[out] buffer The region pixels, (xEnd - xBegin) * (yEnd - yBegin) values
+ */
+void readImageRegion(const std::string& path, int mipLevel, int xBegin, int yBegin, int xEnd, int yEnd, std::vector<float>& buffer);
+
 /**
  * @brief write an image with a given path and buffer
  * @param[in] path The given path to the image
@@ -206,8 +222,39 @@ void writeImage(const std::string& path, int width, int height, const std::vecto
 void writeImage(const std::string& path, int width, int height, const std::vector<unsigned short>& buffer, EImageQuality imageQuality, OutputFileColorSpace& colorspace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 void writeImage(const std::string& path, int width, int height, const std::vector<rgb>& buffer, EImageQuality imageQuality, OutputFileColorSpace& colorspace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 void writeImage(const std::string& path, int width, int height, const std::vector<float>& buffer, EImageQuality imageQuality, OutputFileColorSpace& colorspace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
+void writeImage(const std::string& path, int width, int height, const std::vector<half>& buffer, EImageQuality imageQuality, OutputFileColorSpace& colorspace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 void writeImage(const std::string& path, int width, int height, const std::vector<Color>& buffer, EImageQuality imageQuality, OutputFileColorSpace& colorspace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 void writeImage(const std::string& path, Image& image, EImageQuality imageQuality, OutputFileColorSpace& colorspace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
 
+/**
+ * @brief write a single channel float image as a tiled EXR file with MIP levels, without color conversion
+ *        (eg depth or similarity maps). The other formats are written by writeImage.
+ *
+ * The MIP level l is a nearest neighbor downsampling: its pixel (x, y) is the pixel (x << l, y << l)
+ * of the full resolution, so the lower levels hold actual values (eg depths) and not averages
+ * mixing the valid values with the invalid ones.
+ *
+ * @param[in] path The given path to the image
+ * @param[in] width The input image width
+ * @param[in] height The input image height
+ * @param[in] buffer The input image buffer
+ * @param[in] imageQuality OPTIMIZED to store half floats, LOSSLESS to store floats
+ * @param[in] metadata The metadata stored in all the MIP levels
+ */
+void writeImageTiled(const std::string& path, int width, int height, const std::vector<float>& buffer, EImageQuality imageQuality, const oiio::ParamValueList& metadata = oiio::ParamValueList());
+
+/**
+ * @brief write an RGB float image as a tiled file (eg EXR or TIFF) by rows of tiles: each row of tiles is
+ *        converted to the output colorspace and written, without a full resolution copy of the image.
+ *        The formats without tiles are written by writeImage.
+ *
+ * @param[in] path The given path to the image
+ * @param[in] image The input image
+ * @param[in] imageQuality OPTIMIZED to store half floats in EXR files, LOSSLESS to store floats
+ * @param[in] colorspace The colorspace conversion
+ * @param[in] metadata The metadata of the file
+ */
+void writeImageTiled(const std::string& path, const Image& image, EImageQuality imageQuality, OutputFileColorSpace colorspace, const oiio::ParamValueList& metadata = oiio::ParamValueList());
+
 } // namespace imageIO
 } // namespace aliceVision
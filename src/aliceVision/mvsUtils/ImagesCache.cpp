@@ -8,6 +8,7 @@
 #include <aliceVision/mvsUtils/common.hpp>
 #include <aliceVision/mvsUtils/fileIO.hpp>
 
+#include <algorithm>
 #include <future>
 
 namespace aliceVision {
@@ -49,18 +50,22 @@ ImagesCache::ImagesCache(const MultiViewParams* mp, imageIO::EImageColorSpace co
 
 void ImagesCache::initIC( std::vector<std::string>& imagesNames )
 {
-    float oneimagemb = (sizeof(Color) * _mp->getMaxImageWidth() * _mp->getMaxImageHeight()) / 1024.f / 1024.f;
-    float maxmbCPU = (float)_mp->userParams.get<int>("images_cache.maxmbCPU", 5000);
-    int npreload = std::max((int)(maxmbCPU / oneimagemb), 5); // image cache has a minimum size of 5
-    npreload = std::min(_mp->ncams, npreload);
+    const float oneimagemb = (sizeof(Color) * _mp->getMaxImageWidth() * _mp->getMaxImageHeight()) / 1024.f / 1024.f;
+    const float maxmbCPU = (float)_mp->userParams.get<int>("images_cache.maxmbCPU", 5000);
+    _nbPrefetchThreads = _mp->userParams.get<int>("images_cache.nbPrefetchThreads", 2);
 
     for(int rc = 0; rc < _mp->ncams; rc++)
     {
         _imagesNames.push_back(imagesNames[rc]);
     }
 
-    _camIdMapId.resize( _mp->ncams, -1 );
-    setCacheSize(npreload);
+    _imgs.resize(_mp->ncams);
+    _lastAccess.resize(_mp->ncams, 0);
+    _schedulePosition.resize(_mp->ncams, -1);
+    _prefetching.resize(_mp->ncams, false);
+
+    // image cache has a minimum size of 5 images
+    _maxBytes = static_cast<std::size_t>(std::max(maxmbCPU, 5.0f * oneimagemb) * 1024.f * 1024.f);
 
     {
         // Cannot resize the vector<mutex> directly, as mutex class is not move-constructible.
@@ -69,55 +74,128 @@ void ImagesCache::initIC( std::vector<std::string>& imagesNames )
         std::vector<std::mutex> imagesMutexesTmp(_mp->ncams);
         _imagesMutexes.swap(imagesMutexesTmp);
     }
+}
 
+ImagesCache::~ImagesCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+        _stopPrefetch = true;
+    }
+    _prefetchCondition.notify_all();
 
+    for(std::thread& thread : _prefetchThreads)
+        thread.join();
 }
 
 void ImagesCache::setCacheSize(int nbPreload)
 {
-    _N_PRELOADED_IMAGES = nbPreload;
-    _imgs.resize(_N_PRELOADED_IMAGES);
-    _mapIdCamId.resize( _N_PRELOADED_IMAGES, -1 );
-    _mapIdClock.resize( _N_PRELOADED_IMAGES, clock() );
+    std::lock_guard<std::mutex> lock(_cacheMutex);
+    _maxBytes = static_cast<std::size_t>(nbPreload) * sizeof(Color) * _mp->getMaxImageWidth() * _mp->getMaxImageHeight();
 }
 
-void ImagesCache::refreshData(int camId)
+std::size_t ImagesCache::getImageBytes(int camId) const
+{
+    return sizeof(Color) * static_cast<std::size_t>(_mp->getWidth(camId)) * static_cast<std::size_t>(_mp->getHeight(camId));
+}
+
+bool ImagesCache::reserve(int camId, int schedulePosition)
+{
+    const std::size_t bytes = getImageBytes(camId);
+
+    while(_usedBytes + bytes > _maxBytes)
+    {
+        // evict the image used the latest: not scheduled, then the farthest in the schedule,
+        // then the least recently accessed
+        int evictedCamId = -1;
+        for(int c = 0; c < _imgs.size(); ++c)
+        {
+            if(_imgs[c] == nullptr || c == camId)
+                continue;
+            if(evictedCamId == -1)
+            {
+                evictedCamId = c;
+                continue;
+            }
+            const int position = (_schedulePosition[c] == -1) ? _mp->ncams : _schedulePosition[c];
+            const int evictedPosition = (_schedulePosition[evictedCamId] == -1) ? _mp->ncams : _schedulePosition[evictedCamId];
+            if(position > evictedPosition || (position == evictedPosition && _lastAccess[c] < _lastAccess[evictedCamId]))
+                evictedCamId = c;
+        }
+
+        if(evictedCamId == -1)
+        {
+            // all the images are evicted, the budget is smaller than this image
+            if(schedulePosition != -1)
+                return false;
+            break;
+        }
+
+        // don't evict an image used before the one to prefetch
+        if(schedulePosition != -1 && _schedulePosition[evictedCamId] != -1 && _schedulePosition[evictedCamId] <= schedulePosition)
+            return false;
+
+        ALICEVISION_LOG_DEBUG("Remove " << _imagesNames.at(evictedCamId) << " from image cache.");
+
+        // the image is released once it is not used anymore
+        _imgs[evictedCamId].reset();
+        _usedBytes -= getImageBytes(evictedCamId);
+    }
+
+    _usedBytes += bytes;
+    return true;
+}
+
+ImagesCache::ImgSharedPtr ImagesCache::getOrLoadImg(int camId)
 {
-    // printf("camId %i\n",camId);
-    // test if the image is in the memory
-    if(_camIdMapId[camId] == -1)
     {
-        // remove the oldest one
-        int mapId = _mapIdClock.minValId();
-        int oldCamId = _mapIdCamId[mapId];
-        if(oldCamId>=0)
-            _camIdMapId[oldCamId] = -1;
-            // TODO: oldCamId should be protected if already used
-
-        // replace with new new
-        _camIdMapId[camId] = mapId;
-        _mapIdCamId[mapId] = camId;
-        _mapIdClock[mapId] = clock();
-
-        // reload data from files
-        long t1 = clock();
-        if (_imgs[mapId] == nullptr)
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+        _lastAccess[camId] = ++_nbAccesses;
+
+        if(_imgs[camId] != nullptr)
         {
-            const int maxWidth = _mp->getMaxImageWidth();
-            const int maxHeight = _mp->getMaxImageHeight();
-            _imgs[mapId] = std::make_shared<Image>(maxWidth, maxHeight);
+            ALICEVISION_LOG_DEBUG("Reuse " << _imagesNames.at(camId) << " from image cache. ");
+            return _imgs[camId];
         }
+        reserve(camId, -1);
+    }
 
-        const std::string imagePath = _imagesNames.at(camId);
-        loadImage(imagePath, _mp, camId, *(_imgs[mapId]), _colorspace, _correctEV);
+    // reload data from files
+    long t1 = clock();
+    ImgSharedPtr img = std::make_shared<Image>();
+    const std::string imagePath = _imagesNames.at(camId);
 
-        ALICEVISION_LOG_DEBUG("Add " << imagePath << " to image cache. " << formatElapsedTime(t1));
+    try
+    {
+        loadImage(imagePath, _mp, camId, *img, _colorspace, _correctEV);
     }
-    else
+    catch(...)
     {
-      ALICEVISION_LOG_DEBUG("Reuse " << _imagesNames.at(camId) << " from image cache. ");
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+        _usedBytes -= getImageBytes(camId);
+        throw;
     }
+
+    {
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+        _imgs[camId] = img;
+    }
+
+    ALICEVISION_LOG_DEBUG("Add " << imagePath << " to image cache. " << formatElapsedTime(t1));
+    return img;
+}
+
+ImagesCache::ImgSharedPtr ImagesCache::getImg_sync(int camId)
+{
+    std::lock_guard<std::mutex> lock(_imagesMutexes[camId]);
+    return getOrLoadImg(camId);
+}
+
+void ImagesCache::refreshData(int camId)
+{
+    getOrLoadImg(camId);
 }
+
 void ImagesCache::refreshData_sync(int camId)
 {
   std::lock_guard<std::mutex> lock(_imagesMutexes[camId]);
@@ -129,11 +207,108 @@ std::future<void> ImagesCache::refreshData_async(int camId)
     return std::async(&ImagesCache::refreshData_sync, this, camId);
 }
 
+void ImagesCache::setSchedule(const std::vector<int>& camIds)
+{
+    {
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+
+        for(int camId : _schedule)
+            _schedulePosition[camId] = -1;
+        _schedule.clear();
+
+        for(int camId : camIds)
+        {
+            if(_schedulePosition[camId] != -1)
+                continue;
+            _schedulePosition[camId] = _schedule.size();
+            _schedule.push_back(camId);
+        }
+
+        // the prefetch threads are started with the first schedule
+        if(_prefetchThreads.empty())
+        {
+            for(int i = 0; i < _nbPrefetchThreads; ++i)
+                _prefetchThreads.emplace_back(&ImagesCache::prefetchLoop, this);
+        }
+    }
+    _prefetchCondition.notify_all();
+}
+
+void ImagesCache::prefetchLoop()
+{
+    std::unique_lock<std::mutex> lock(_cacheMutex);
+
+    while(!_stopPrefetch)
+    {
+        // the first scheduled camera which is not cached, if it fits into the budget
+        int camId = -1;
+        for(int position = 0; position < _schedule.size(); ++position)
+        {
+            const int c = _schedule[position];
+            if(_imgs[c] != nullptr || _prefetching[c])
+                continue;
+            if(reserve(c, position))
+                camId = c;
+            break;
+        }
+
+        if(camId == -1)
+        {
+            _prefetchCondition.wait(lock);
+            continue;
+        }
+
+        _prefetching[camId] = true;
+        lock.unlock();
+
+        {
+            std::lock_guard<std::mutex> cameraLock(_imagesMutexes[camId]);
+
+            long t1 = clock();
+            ImgSharedPtr img;
+            bool loaded = false;
+            {
+                std::lock_guard<std::mutex> cacheLock(_cacheMutex);
+                loaded = (_imgs[camId] != nullptr);
+            }
+
+            // the image may have been loaded by getImg_sync in the meantime
+            if(!loaded)
+            {
+                try
+                {
+                    img = std::make_shared<Image>();
+                    loadImage(_imagesNames.at(camId), _mp, camId, *img, _colorspace, _correctEV);
+                    ALICEVISION_LOG_DEBUG("Prefetch " << _imagesNames.at(camId) << " to image cache. " << formatElapsedTime(t1));
+                }
+                catch(const std::exception& e)
+                {
+                    // getImg_sync will reload it and throw
+                    ALICEVISION_LOG_WARNING("Cannot prefetch " << _imagesNames.at(camId) << ": " << e.what());
+                    img.reset();
+                }
+            }
+
+            std::lock_guard<std::mutex> cacheLock(_cacheMutex);
+            if(img != nullptr)
+                _imgs[camId] = img;
+            else
+                _usedBytes -= getImageBytes(camId);
+        }
+
+        lock.lock();
+        _prefetching[camId] = false;
+    }
+}
+
 Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
 {
-    // get the image index in the memory
-    const int i = _camIdMapId[camId];
-    const ImgSharedPtr& img = _imgs[i];
+    // the cached image of the camera
+    ImgSharedPtr img;
+    {
+        std::lock_guard<std::mutex> lock(_cacheMutex);
+        img = _imgs[camId];
+    }
     
     const int xp = static_cast<int>(pix->x);
     const int yp = static_cast<int>(pix->y);
@@ -14,8 +14,13 @@
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/mvsData/Image.hpp>
 
+#include <condition_variable>
+#include <cstddef>
 #include <future>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace aliceVision {
 namespace mvsUtils {
@@ -39,16 +44,35 @@ private:
 
     const MultiViewParams* _mp;
 
-    int _N_PRELOADED_IMAGES;
-    std::vector<ImgSharedPtr> _imgs;
-
-    std::vector<int> _camIdMapId;
-    std::vector<int> _mapIdCamId;
-    StaticVector<long> _mapIdClock;
+    /// maximum size of the cached images in bytes
+    std::size_t _maxBytes{0};
+    /// size of the cached images and of the images being loaded in bytes
+    std::size_t _usedBytes{0};
 
+    /// cached image of each camera, null if not cached
+    std::vector<ImgSharedPtr> _imgs;
+    /// last access of each camera, to evict the cameras out of the schedule
+    std::vector<long> _lastAccess;
+    long _nbAccesses{0};
+
+    /// upcoming cameras in order of use
+    std::vector<int> _schedule;
+    /// position of each camera in the schedule, -1 if not scheduled
+    std::vector<int> _schedulePosition;
+    /// camera picked by a prefetch thread
+    std::vector<bool> _prefetching;
+
+    /// locked while a camera is loaded
     std::vector<std::mutex> _imagesMutexes;
+    /// protects the cache state, never locked before a camera mutex
+    std::mutex _cacheMutex;
     std::vector<std::string> _imagesNames;
 
+    int _nbPrefetchThreads{2};
+    std::vector<std::thread> _prefetchThreads;
+    std::condition_variable _prefetchCondition;
+    bool _stopPrefetch{false};
+
     imageIO::EImageColorSpace _colorspace{imageIO::EImageColorSpace::AUTO};
     ECorrectEV _correctEV{ECorrectEV::NO_CORRECTION};
 
@@ -56,23 +80,46 @@ public:
     ImagesCache( const MultiViewParams* mp, imageIO::EImageColorSpace colorspace, ECorrectEV correctEV = ECorrectEV::NO_CORRECTION);
     ImagesCache( const MultiViewParams* mp, imageIO::EImageColorSpace colorspace, std::vector<std::string>& imagesNames, ECorrectEV correctEV = ECorrectEV::NO_CORRECTION);
     void initIC( std::vector<std::string>& imagesNames );
+    /// Set the cache budget to nbPreload images of the maximum size
     void setCacheSize(int nbPreload);
     void setCorrectEV(const ECorrectEV correctEV) { _correctEV = correctEV; }
-    ~ImagesCache() = default;
+    ~ImagesCache();
 
-    inline ImgSharedPtr getImg_sync( int camId )
-    {
-        refreshData_sync(camId);
-        const int imageId = _camIdMapId[camId];
-        return _imgs[imageId];
-    }
+    ImgSharedPtr getImg_sync( int camId );
 
     void refreshData(int camId);
     void refreshData_sync(int camId);
 
     std::future<void> refreshData_async(int camId);
 
+    /**
+     * @brief Set the cameras that will be used next, in order of use.
+     *        The prefetch threads load them in this order while they fit into the budget,
+     *        and the images evicted first are the ones used the latest (or not scheduled).
+     * @param[in] camIds the upcoming cameras, the duplicates are ignored
+     */
+    void setSchedule(const std::vector<int>& camIds);
+
     Color getPixelValueInterpolated(const Point2d* pix, int camId);
+
+private:
+    /**
+     * @brief Get the image of a camera, load it if it is not cached. The camera mutex must be locked.
+     */
+    ImgSharedPtr getOrLoadImg(int camId);
+
+    /**
+     * @brief Evict images until an image of the given size fits into the budget, then reserve its size.
+     *        The cache mutex must be locked.
+     * @param[in] camId the camera to load
+     * @param[in] schedulePosition if not -1, only the images used after this position are evicted
+     * @return false if there is not enough room, nothing is reserved
+     */
+    bool reserve(int camId, int schedulePosition);
+
+    std::size_t getImageBytes(int camId) const;
+
+    void prefetchLoop();
 };
 
 } // namespace mvsUtils
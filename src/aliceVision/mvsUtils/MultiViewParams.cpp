@@ -16,6 +16,7 @@
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/multiview/projection.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/accumulators/accumulators.hpp>
@@ -25,6 +26,7 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <exception>
 #include <iostream>
 #include <set>
 
@@ -54,6 +56,20 @@ MultiViewParams::MultiViewParams(const sfmData::SfMData& sfmData,
     {
         std::set<std::pair<int, int>> dimensions; // for print only
         int i = 0;
+
+        // list the folder once: file extension per file stem (the first found)
+        const bool useImagesFolder = !readFromDepthMaps && _imagesFolder != "/" && !_imagesFolder.empty() && fs::is_directory(_imagesFolder) && !fs::is_empty(_imagesFolder);
+        std::map<std::string, std::string> extensionPerStem;
+        if(useImagesFolder)
+        {
+            for(const fs::directory_entry& e : fs::recursive_directory_iterator(_imagesFolder))
+            {
+                const std::string extension = e.path().extension().string();
+                if(imageIO::isSupportedUndistortFormat(extension))
+                    extensionPerStem.emplace(e.path().stem().string(), extension);
+            }
+        }
+
         for(const auto& viewPair : sfmData.getViews())
         {
           const sfmData::View& view = *(viewPair.second.get());
@@ -67,20 +83,15 @@ MultiViewParams::MultiViewParams(const sfmData::SfMData& sfmData,
           {
             path = getFileNameFromViewId(this, view.getViewId(), mvsUtils::EFileType::depthMap, 1);
           }
-          else if(_imagesFolder != "/" && !_imagesFolder.empty() && fs::is_directory(_imagesFolder) && !fs::is_empty(_imagesFolder))
+          else if(useImagesFolder)
           {
             // find folder file extension
-            const fs::recursive_directory_iterator end;
-            const auto findIt = std::find_if(fs::recursive_directory_iterator(_imagesFolder), end,
-                                     [&view](const fs::directory_entry& e) {
-                                        return (e.path().stem() == std::to_string(view.getViewId()) &&
-                                        (imageIO::isSupportedUndistortFormat(e.path().extension().string())));
-                                     });
-
-            if(findIt == end)
+            const auto findIt = extensionPerStem.find(std::to_string(view.getViewId()));
+
+            if(findIt == extensionPerStem.end())
               throw std::runtime_error("Cannot find image file " + std::to_string(view.getViewId()) + " in folder " + _imagesFolder);
 
-            path = _imagesFolder + std::to_string(view.getViewId()) + findIt->path().extension().string();
+            path = _imagesFolder + std::to_string(view.getViewId()) + findIt->second;
           }
 
           dimensions.emplace(view.getWidth(), view.getHeight());
@@ -99,128 +110,212 @@ MultiViewParams::MultiViewParams(const sfmData::SfMData& sfmData,
     // Resize internal structures
     resizeCams(getNbCameras());
 
+    // the image metadata and the camera matrices files are read in parallel
+    std::exception_ptr exception;
+    #pragma omp parallel for schedule(dynamic)
     for(int i = 0; i < getNbCameras(); ++i)
     {
-        const ImageParams& imgParams = _imagesParams.at(i);
-
-        oiio::ParamValueList metadata;
-        imageIO::readImageMetadata(imgParams.path, metadata);
-
-        const auto scaleIt = metadata.find("AliceVision:downscale");
-        const auto pIt = metadata.find("AliceVision:P");
-
-        // find image scale information
-        if(scaleIt != metadata.end() && scaleIt->type() == oiio::TypeDesc::INT)
+        try
         {
-            // use aliceVision image metadata
-            _imagesScale.at(i) = scaleIt->get_int();
+            loadCameraParams(i, cameras);
         }
-        else
+        catch(...)
         {
-            // use image dimension
-            int w, h, channels;
-            imageIO::readImageSpec(imgParams.path, w, h, channels);
-            const int widthScale = imgParams.width / w;
-            const int heightScale = imgParams.height / h;
+            #pragma omp critical
+            exception = std::current_exception();
+        }
+    }
+    if(exception)
+        std::rethrow_exception(exception);
 
-            if((widthScale != 1) && (heightScale != 1))
-                ALICEVISION_LOG_INFO("Reading '" << imgParams.path << "' x" << widthScale << "downscale from file dimension" << std::endl
-                                                 << "\t- No 'AliceVision:downscale' metadata found.");
+    // find max width and max height
+    for(const ImageParams& imgParams : _imagesParams)
+    {
+        _maxImageWidth = std::max(_maxImageWidth, imgParams.width);
+        _maxImageHeight = std::max(_maxImageHeight, imgParams.height);
+    }
 
-            if(widthScale != heightScale)
-                throw std::runtime_error("Scale of file: '" + imgParams.path + "' is not uniform, check image dimension ratio.");
+    ALICEVISION_LOG_INFO("Overall maximum dimension: [" << _maxImageWidth << "x" << _maxImageHeight << "]");
 
-            _imagesScale.at(i) = widthScale;
-        }
+    computeLandmarksPerCamera();
+}
 
-        FocK1K2Arr.at(i) = Point3d(-1.0, -1.0, -1.0);
+void MultiViewParams::loadCameraParams(int index, StaticVector<CameraMatrices>* cameras)
+{
+    const ImageParams& imgParams = _imagesParams.at(index);
 
-        // load camera matrices
-        if(cameras != nullptr)
-        {
-            // use constructor cameras input parameter
-            camArr.at(i) = (*cameras)[i].P;
-            KArr.at(i) = (*cameras)[i].K;
-            RArr.at(i) = (*cameras)[i].R;
-            CArr.at(i) = (*cameras)[i].C;
-            iKArr.at(i) = (*cameras)[i].iK;
-            iRArr.at(i) = (*cameras)[i].iR;
-            iCamArr.at(i) = (*cameras)[i].iCam;
-            FocK1K2Arr.at(i) = Point3d((*cameras)[i].f, (*cameras)[i].k1, (*cameras)[i].k2);
-        }
-        else if(pIt != metadata.end() && pIt->type() == oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44))
+    oiio::ParamValueList metadata;
+    imageIO::readImageMetadata(imgParams.path, metadata);
+
+    const auto scaleIt = metadata.find("AliceVision:downscale");
+    const auto pIt = metadata.find("AliceVision:P");
+
+    // find image scale information
+    if(scaleIt != metadata.end() && scaleIt->type() == oiio::TypeDesc::INT)
+    {
+        // use aliceVision image metadata
+        _imagesScale.at(index) = scaleIt->get_int();
+    }
+    else
+    {
+        // use image dimension
+        int w, h, channels;
+        imageIO::readImageSpec(imgParams.path, w, h, channels);
+        const int widthScale = imgParams.width / w;
+        const int heightScale = imgParams.height / h;
+
+        if((widthScale != 1) && (heightScale != 1))
+            ALICEVISION_LOG_INFO("Reading '" << imgParams.path << "' x" << widthScale << "downscale from file dimension" << std::endl
+                                             << "\t- No 'AliceVision:downscale' metadata found.");
+
+        if(widthScale != heightScale)
+            throw std::runtime_error("Scale of file: '" + imgParams.path + "' is not uniform, check image dimension ratio.");
+
+        _imagesScale.at(index) = widthScale;
+    }
+
+    FocK1K2Arr.at(index) = Point3d(-1.0, -1.0, -1.0);
+
+    // load camera matrices
+    if(cameras != nullptr)
+    {
+        // use constructor cameras input parameter
+        camArr.at(index) = (*cameras)[index].P;
+        KArr.at(index) = (*cameras)[index].K;
+        RArr.at(index) = (*cameras)[index].R;
+        CArr.at(index) = (*cameras)[index].C;
+        iKArr.at(index) = (*cameras)[index].iK;
+        iRArr.at(index) = (*cameras)[index].iR;
+        iCamArr.at(index) = (*cameras)[index].iCam;
+        FocK1K2Arr.at(index) = Point3d((*cameras)[index].f, (*cameras)[index].k1, (*cameras)[index].k2);
+    }
+    else if(pIt != metadata.end() && pIt->type() == oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44))
+    {
+        ALICEVISION_LOG_DEBUG("Reading view " << getViewId(index) << " projection matrix from image metadata.");
+        loadMatricesFromRawProjectionMatrix(index, static_cast<const double*>(pIt->data()));
+    }
+    else
+    {
+        // use P matrix file
+        const std::string fileNameP = getFileNameFromIndex(this, index, EFileType::P);
+        const std::string fileNameD = getFileNameFromIndex(this, index, EFileType::D);
+
+        if(fs::exists(fileNameP), fs::exists(fileNameD))
         {
-            ALICEVISION_LOG_DEBUG("Reading view " << getViewId(i) << " projection matrix from image metadata.");
-            loadMatricesFromRawProjectionMatrix(i, static_cast<const double*>(pIt->data()));
+          ALICEVISION_LOG_DEBUG("Reading view " << getViewId(index) << " projection matrix from file '" << fileNameP << "'.");
+
+          loadMatricesFromTxtFile(index, fileNameP, fileNameD);
         }
         else
         {
-            // use P matrix file
-            const std::string fileNameP = getFileNameFromIndex(this, i, EFileType::P);
-            const std::string fileNameD = getFileNameFromIndex(this, i, EFileType::D);
+          ALICEVISION_LOG_DEBUG("Reading view " << getViewId(index) << " projection matrix from SfMData.");
+          loadMatricesFromSfM(index);
+        }
+    }
 
-            if(fs::exists(fileNameP), fs::exists(fileNameD))
-            {
-              ALICEVISION_LOG_DEBUG("Reading view " << getViewId(i) << " projection matrix from file '" << fileNameP << "'.");
+    if(KArr[index].m11 > (float)(getWidth(index) * 100))
+    {
+        ALICEVISION_LOG_WARNING("Camera " << index << " at infinity. Setting to zero");
+
+        KArr[index].m11 = getWidth(index) / 2;
+        KArr[index].m12 = 0;
+        KArr[index].m13 = getWidth(index) / 2;
+        KArr[index].m21 = 0;
+        KArr[index].m22 = getHeight(index) / 2;
+        KArr[index].m23 = getHeight(index) / 2;
+        KArr[index].m31 = 0;
+        KArr[index].m32 = 0;
+        KArr[index].m33 = 1;
+
+        RArr[index].m11 = 1;
+        RArr[index].m12 = 0;
+        RArr[index].m13 = 0;
+        RArr[index].m21 = 0;
+        RArr[index].m22 = 1;
+        RArr[index].m23 = 0;
+        RArr[index].m31 = 0;
+        RArr[index].m32 = 0;
+        RArr[index].m33 = 1;
+
+        iRArr[index].m11 = 1;
+        iRArr[index].m12 = 0;
+        iRArr[index].m13 = 0;
+        iRArr[index].m21 = 0;
+        iRArr[index].m22 = 1;
+        iRArr[index].m23 = 0;
+        iRArr[index].m31 = 0;
+        iRArr[index].m32 = 0;
+        iRArr[index].m33 = 1;
+
+        iKArr[index] = KArr[index].inverse();
+        iCamArr[index] = iRArr[index] * iKArr[index];
+        CArr[index].x = 0.0;
+        CArr[index].y = 0.0;
+        CArr[index].z = 0.0;
+
+        camArr[index] = KArr[index] * (RArr[index] | (Point3d(0.0, 0.0, 0.0) - RArr[index] * CArr[index]));
+    }
+}
 
-              loadMatricesFromTxtFile(i, fileNameP, fileNameD);
-            }
-            else
+void MultiViewParams::computeLandmarksPerCamera()
+{
+    const sfmData::Landmarks& landmarks = _sfmData.getLandmarks();
+
+    std::vector<const sfmData::Landmark*> landmarksPtr;
+    landmarksPtr.reserve(landmarks.size());
+    for(const auto& landmarkPair : landmarks)
+        landmarksPtr.push_back(&landmarkPair.second);
+
+    // the landmarks are split in contiguous chunks of the same size:
+    // each chunk writes its landmarks after the ones of the previous chunks to keep the landmarks order
+    const std::size_t nbLandmarks = landmarksPtr.size();
+    const int nbChunks = static_cast<int>(std::min(nbLandmarks / 1024 + 1, static_cast<std::size_t>(omp_get_max_threads())));
+    std::vector<std::vector<std::size_t>> offsetsPerChunk(nbChunks, std::vector<std::size_t>(getNbCameras(), 0));
+
+    // count the observations of each camera per chunk
+    #pragma omp parallel for
+    for(int c = 0; c < nbChunks; ++c)
+    {
+        std::vector<std::size_t>& counts = offsetsPerChunk.at(c);
+        for(std::size_t l = nbLandmarks * c / nbChunks; l < nbLandmarks * (c + 1) / nbChunks; ++l)
+        {
+            for(const auto& observationPair : landmarksPtr[l]->observations)
             {
-              ALICEVISION_LOG_DEBUG("Reading view " << getViewId(i) << " projection matrix from SfMData.");
-              loadMatricesFromSfM(i);
+                const auto it = _imageIdsPerViewId.find(observationPair.first);
+                if(it != _imageIdsPerViewId.end())
+                    ++counts[it->second];
             }
         }
+    }
 
-        if(KArr[i].m11 > (float)(getWidth(i) * 100))
+    // convert the counts to the first position of each chunk in the camera landmarks
+    _landmarksPerCamera.resize(getNbCameras());
+    for(int cam = 0; cam < getNbCameras(); ++cam)
+    {
+        std::size_t nbCameraLandmarks = 0;
+        for(std::vector<std::size_t>& offsets : offsetsPerChunk)
         {
-            ALICEVISION_LOG_WARNING("Camera " << i << " at infinity. Setting to zero");
-
-            KArr[i].m11 = getWidth(i) / 2;
-            KArr[i].m12 = 0;
-            KArr[i].m13 = getWidth(i) / 2;
-            KArr[i].m21 = 0;
-            KArr[i].m22 = getHeight(i) / 2;
-            KArr[i].m23 = getHeight(i) / 2;
-            KArr[i].m31 = 0;
-            KArr[i].m32 = 0;
-            KArr[i].m33 = 1;
-
-            RArr[i].m11 = 1;
-            RArr[i].m12 = 0;
-            RArr[i].m13 = 0;
-            RArr[i].m21 = 0;
-            RArr[i].m22 = 1;
-            RArr[i].m23 = 0;
-            RArr[i].m31 = 0;
-            RArr[i].m32 = 0;
-            RArr[i].m33 = 1;
-
-            iRArr[i].m11 = 1;
-            iRArr[i].m12 = 0;
-            iRArr[i].m13 = 0;
-            iRArr[i].m21 = 0;
-            iRArr[i].m22 = 1;
-            iRArr[i].m23 = 0;
-            iRArr[i].m31 = 0;
-            iRArr[i].m32 = 0;
-            iRArr[i].m33 = 1;
-
-            iKArr[i] = KArr[i].inverse();
-            iCamArr[i] = iRArr[i] * iKArr[i];
-            CArr[i].x = 0.0;
-            CArr[i].y = 0.0;
-            CArr[i].z = 0.0;
-
-            camArr[i] = KArr[i] * (RArr[i] | (Point3d(0.0, 0.0, 0.0) - RArr[i] * CArr[i]));
+            const std::size_t count = offsets[cam];
+            offsets[cam] = nbCameraLandmarks;
+            nbCameraLandmarks += count;
         }
-
-        // find max width and max height
-        _maxImageWidth = std::max(_maxImageWidth, imgParams.width);
-        _maxImageHeight = std::max(_maxImageHeight, imgParams.height);
+        _landmarksPerCamera[cam].resize(nbCameraLandmarks);
     }
 
-    ALICEVISION_LOG_INFO("Overall maximum dimension: [" << _maxImageWidth << "x" << _maxImageHeight << "]");
+    #pragma omp parallel for
+    for(int c = 0; c < nbChunks; ++c)
+    {
+        std::vector<std::size_t>& offsets = offsetsPerChunk.at(c);
+        for(std::size_t l = nbLandmarks * c / nbChunks; l < nbLandmarks * (c + 1) / nbChunks; ++l)
+        {
+            for(const auto& observationPair : landmarksPtr[l]->observations)
+            {
+                const auto it = _imageIdsPerViewId.find(observationPair.first);
+                if(it != _imageIdsPerViewId.end())
+                    _landmarksPerCamera[it->second][offsets[it->second]++] = landmarksPtr[l];
+            }
+        }
+    }
 }
 
 
@@ -334,22 +429,14 @@ void MultiViewParams::getMinMaxMidNbDepth(int index, float& min, float& max, flo
   Point3d midDepthPoint = Point3d();
   nbDepths = 0;
 
-  for(const auto& landmarkPair : _sfmData.getLandmarks())
+  for(const sfmData::Landmark* landmark : _landmarksPerCamera.at(index))
   {
-    const sfmData::Landmark& landmark = landmarkPair.second;
-    const Point3d point(landmark.X(0), landmark.X(1), landmark.X(2));
-
-    for(const auto& observationPair : landmark.observations)
-    {
-      if(observationPair.first == viewId)
-      {
-        const float distance = static_cast<float>(pointPlaneDistance(point, cameraPlane.p, cameraPlane.n));
-        accDistanceMin(distance);
-        accDistanceMax(distance);
-        midDepthPoint = midDepthPoint + point;
-        ++nbDepths;
-      }
-    }
+    const Point3d point(landmark->X(0), landmark->X(1), landmark->X(2));
+    const float distance = static_cast<float>(pointPlaneDistance(point, cameraPlane.p, cameraPlane.n));
+    accDistanceMin(distance);
+    accDistanceMax(distance);
+    midDepthPoint = midDepthPoint + point;
+    ++nbDepths;
   }
 
   min = quantile(accDistanceMin, quantile_probability = 1.0 - percentile);
@@ -566,13 +653,10 @@ StaticVector<int> MultiViewParams::findNearestCamsFromLandmarks(int rc, int nbNe
   const geometry::Pose3 pose = _sfmData.getPose(view).getTransform();
   const camera::IntrinsicBase* intrinsicPtr = _sfmData.getIntrinsicPtr(view.getIntrinsicId());
 
-  for(const auto& landmarkPair :_sfmData.getLandmarks())
+  for(const sfmData::Landmark* landmark : _landmarksPerCamera.at(rc))
   {
-    const auto& observations = landmarkPair.second.observations;
-
-    auto viewObsIt = observations.find(viewId);
-    if(viewObsIt == observations.end())
-      continue;
+    const auto& observations = landmark->observations;
+    const auto viewObsIt = observations.find(viewId);
 
     for(const auto& observationPair : observations)
     {
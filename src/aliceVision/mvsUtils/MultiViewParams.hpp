@@ -25,6 +25,7 @@ namespace bpt = boost::property_tree;
 
 namespace sfmData {
 class SfMData;
+struct Landmark;
 } // namespace sfmData
 
 namespace mvsUtils {
@@ -68,6 +69,8 @@ enum class EFileType {
     nmodMap = 41,
     D = 42,
     normalMap = 43,
+    depthMapDeps = 44,
+    deviceProfile = 45,
 };
 
 class MultiViewParams
@@ -234,6 +237,16 @@ public:
         return _sfmData;
     }
 
+    /**
+     * @brief Get the input SfMData landmarks observed by a camera
+     * @param[in] index The camera index
+     * @return the landmarks, in the order of the input SfMData landmarks
+     */
+    inline const std::vector<const sfmData::Landmark*>& getLandmarksPerCamera(int index) const
+    {
+        return _landmarksPerCamera.at(index);
+    }
+
     const std::map<std::string, std::string>& getMetadata(int index) const;
 
     bool is3DPointInFrontOfCam(const Point3d* X, int rc) const;
@@ -315,12 +328,16 @@ private:
     float _minViewAngle = 2.0f;
     /// maximum view angle
     float _maxViewAngle = 70.0f;  // WARNING: may be too low, especially when using seeds from SfM
-    /// input sfmData
+    /// input sfmData (its landmarks must not be modified during the lifetime of the object)
     const sfmData::SfMData& _sfmData;
+    /// input sfmData landmarks observed by each camera
+    std::vector<std::vector<const sfmData::Landmark*>> _landmarksPerCamera;
 
     void loadMatricesFromTxtFile(int index, const std::string& fileNameP, const std::string& fileNameD);
     void loadMatricesFromRawProjectionMatrix(int index, const double* rawProjMatix);
     void loadMatricesFromSfM(int index);
+    void loadCameraParams(int index, StaticVector<CameraMatrices>* cameras);
+    void computeLandmarksPerCamera();
 
     inline void resizeCams(int _ncams)
     {
@@ -117,25 +117,12 @@ bool get2dLineImageIntersection(Point2d* pFrom, Point2d* pTo, Point2d linePoint1
 bool getTarEpipolarDirectedLine(Point2d* pFromTar, Point2d* pToTar, Point2d refpix, int refCam, int tarCam,
                                 const MultiViewParams* mp)
 {
-    const Matrix3x4& rP = mp->camArr[refCam];
+    // the camera centers and inverse matrices are decomposed once in the MultiViewParams
+    const Point3d& rC = mp->CArr[refCam];
+    const Point3d& tC = mp->CArr[tarCam];
+    const Matrix3x3& riP = mp->iCamArr[refCam];
     const Matrix3x4& tP = mp->camArr[tarCam];
 
-    Point3d rC;
-    Matrix3x3 rR;
-    Matrix3x3 riR;
-    Matrix3x3 rK;
-    Matrix3x3 riK;
-    Matrix3x3 riP;
-    mp->decomposeProjectionMatrix(rC, rR, riR, rK, riK, riP, rP);
-
-    Point3d tC;
-    Matrix3x3 tR;
-    Matrix3x3 tiR;
-    Matrix3x3 tK;
-    Matrix3x3 tiK;
-    Matrix3x3 tiP;
-    mp->decomposeProjectionMatrix(tC, tR, tiR, tK, tiK, tiP, tP);
-
     Point3d refvect = riP * refpix;
     refvect = refvect.normalize();
 
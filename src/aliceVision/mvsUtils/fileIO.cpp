@@ -225,6 +225,23 @@ std::string getFileNameFromViewId(const MultiViewParams* mp, int viewId, EFileTy
           ext = "exr";
           break;
       }
+      case EFileType::depthMapDeps:
+      {
+          folder = mp->getDepthMapsFolder();
+          suffix = "_depthMapDeps";
+          ext = "json";
+          break;
+      }
+      case EFileType::deviceProfile:
+      {
+          if(scale == 0)
+              folder = mp->getDepthMapsFilterFolder();
+          else
+              folder = mp->getDepthMapsFolder();
+          suffix = "_deviceProfile";
+          ext = "json";
+          break;
+      }
       case EFileType::normalMap:
       {
           folder = mp->getDepthMapsFilterFolder();
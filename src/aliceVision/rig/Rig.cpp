@@ -8,11 +8,13 @@
 #include "ResidualError.hpp"
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <ceres/rotation.h>
 
 #include <fstream>
 #include <exception>
+#include <limits>
 
 #ifdef VISUAL_DEBUG_MODE
 #include <opencv2/opencv.hpp>
@@ -165,31 +167,63 @@ void Rig::findBestRelativePose(
   const std::vector<localization::LocalizationResult> & resMainCamera = _vLocalizationResults[0];
   const std::vector<localization::LocalizationResult> & resWitnessCamera = _vLocalizationResults[iLocalizer];
   
-  double minReprojError = std::numeric_limits<double>::max();
-  std::size_t iMin = 0;
-  
   assert(vPoses.size() > 0);
-  
-  for(std::size_t i=0 ; i < vPoses.size() ; ++i)
+
+  // views where both pose computations succeeded
+  std::vector<std::size_t> commonViews;
+  commonViews.reserve(resWitnessCamera.size());
+  for(std::size_t j=0 ; j < resWitnessCamera.size() ; ++j )
+  {
+    if ( ( resMainCamera[j].isValid() ) && ( resWitnessCamera[j].isValid() ) )
+      commonViews.push_back(j);
+  }
+
+  // error of each candidate, a candidate is dropped (infinite error) as soon as
+  // its partial error exceeds the best complete error found by any thread
+  std::vector<double> errors(vPoses.size(), std::numeric_limits<double>::infinity());
+  double minReprojError = std::numeric_limits<double>::max();
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i=0 ; i < static_cast<int>(vPoses.size()) ; ++i)
   {
     const geometry::Pose3 & relativePose = vPoses[i];
 
+    double bestError;
+    #pragma omp critical(rigBestRelativePose)
+    bestError = minReprojError;
+
     double error = 0;
-    for(std::size_t j=0 ; j < resWitnessCamera.size() ; ++j )
+    bool dropped = false;
+    for(const std::size_t j : commonViews)
     {
-      // Check that both pose computations succeeded 
-      if ( ( resMainCamera[j].isValid() ) && ( resWitnessCamera[j].isValid() ) )
+      // [poseWitness] = [relativePose]*[poseMainCamera]
+      const geometry::Pose3 poseWitnessCamera = poseFromMainToWitness(resMainCamera[j].getPose(), relativePose);
+      error += reprojectionError(resWitnessCamera[j], poseWitnessCamera);
+      if(error > bestError)
       {
-        // [poseWitness] = [relativePose]*[poseMainCamera]
-        const geometry::Pose3 poseWitnessCamera = poseFromMainToWitness(resMainCamera[j].getPose(), relativePose);
-        error += reprojectionError(resWitnessCamera[j], poseWitnessCamera);
+        dropped = true;
+        break;
       }
     }
-    if ( error < minReprojError )
+    if(dropped)
+      continue;
+
+    errors[i] = error;
+    #pragma omp critical(rigBestRelativePose)
+    minReprojError = std::min(minReprojError, error);
+  }
+
+  // first candidate with the minimal error, as the sequential search
+  // (a candidate reaching the minimal error is never dropped)
+  std::size_t iMin = 0;
+  minReprojError = std::numeric_limits<double>::max();
+  for(std::size_t i=0 ; i < errors.size() ; ++i)
+  {
+    if ( errors[i] < minReprojError )
     {
       iMin = i;
-      minReprojError = error;
-    }           
+      minReprojError = errors[i];
+    }
   }
   result = vPoses[iMin];
   
@@ -328,7 +362,7 @@ bool Rig::optimizeCalibration()
 
   for(auto &elem : vMainPoses)
   {
-    auto pose = elem.second;
+    auto &pose = elem.second;
     double * parameter_block = &pose[0];
     assert(parameter_block && "parameter_block is null in vMainPoses");
     problem.AddParameterBlock(parameter_block, 6);
@@ -475,15 +509,23 @@ bool Rig::optimizeCalibration()
   aliceVision::sfm::BundleAdjustmentCeres::CeresOptions aliceVision_options(true);
   
   ceres::Solver::Options options;
+
+  // the rig poses are only linked to the relative poses: eliminate them first,
+  // the Schur complement is the small dense system of the relative poses
+  options.linear_solver_ordering.reset(new ceres::ParameterBlockOrdering);
+  for(auto &elem : vMainPoses)
+    options.linear_solver_ordering->AddElementToGroup(&elem.second[0], 0);
+  for(std::vector<double> &pose : vRelativePoses)
+    options.linear_solver_ordering->AddElementToGroup(&pose[0], 1);
   
   options.preconditioner_type = aliceVision_options.preconditionerType;
   options.linear_solver_type = aliceVision_options.linearSolverType;
   options.sparse_linear_algebra_library_type = aliceVision_options.sparseLinearAlgebraLibraryType;
   options.minimizer_progress_to_stdout = aliceVision_options.verbose;
   options.logging_type = ceres::SILENT;
-  options.num_threads = 1;//aliceVision_options._nbThreads;
+  options.num_threads = aliceVision_options.nbThreads;
 #if CERES_VERSION_MAJOR < 2
-  options.num_linear_solver_threads = 1;//aliceVision_options._nbThreads;
+  options.num_linear_solver_threads = aliceVision_options.nbThreads;
 #endif
   
   // Solve BA
@@ -36,14 +36,18 @@
 
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <vector>
 
+#include <aliceVision/robustEstimation/prosacSampling.hpp>
 #include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/robustEstimation/sprt.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 namespace aliceVision {
@@ -145,6 +149,136 @@ inline ErrorIndex bestNFA(
 }
 
 
+/**
+ * @brief Find the best NFA from a histogram of the residuals, without sorting them.
+ *
+ * The residuals under the threshold are counted in bins of the same size in logarithmic
+ * scale, between the smallest and the largest one. The NFA is evaluated at the upper bound
+ * of each bin, so the number of inliers is found up to the precision of a bin.
+ * The returned NFA is the one of the selected inliers with their largest residual.
+ * The buffers are allocated once and reused for all the models.
+ */
+class NFAHistogram
+{
+public:
+  /**
+   * @param[in] nbData the number of residuals
+   * @param[in] nbBins the number of bins, the precision of the threshold (in log10) is the
+   *            range of the residuals (in log10) divided by the number of bins
+   */
+  NFAHistogram(std::size_t nbData, std::size_t nbBins)
+    : _histogram(std::max<std::size_t>(nbBins, 1))
+    , _residualBins(nbData)
+  {}
+
+  /**
+   * @brief Find the best NFA and its number of inliers (see bestNFA).
+   * @param[in] residuals the residual of each data
+   * @return (NFA, number of inliers)
+   */
+  ErrorIndex bestNFA(int startIndex,
+                     double logalpha0,
+                     const std::vector<double>& residuals,
+                     double loge0,
+                     double maxThreshold,
+                     const std::vector<float>& logc_n,
+                     const std::vector<float>& logc_k,
+                     double multError = 1.0)
+  {
+    const double epsilon = std::numeric_limits<float>::epsilon();
+    const int nbBins = static_cast<int>(_histogram.size());
+    ErrorIndex bestIndex(std::numeric_limits<double>::infinity(), startIndex);
+    _bestBin = -1;
+    _errorMax = std::numeric_limits<double>::infinity();
+
+    // range of the residuals under the threshold, in log10
+    double logMin = std::numeric_limits<double>::infinity();
+    double logMax = -std::numeric_limits<double>::infinity();
+    for(std::size_t i = 0; i < residuals.size(); ++i)
+    {
+      if(!(residuals[i] <= maxThreshold))
+      {
+        _residualBins[i] = nbBins;
+        continue;
+      }
+      const double logError = log10(residuals[i] + epsilon);
+      logMin = std::min(logMin, logError);
+      logMax = std::max(logMax, logError);
+      // stored until the range is known
+      _residualBins[i] = -1;
+    }
+    if(logMin > logMax)
+      return bestIndex;
+
+    const double binSize = (logMax - logMin) / nbBins;
+    std::fill(_histogram.begin(), _histogram.end(), 0);
+    for(std::size_t i = 0; i < residuals.size(); ++i)
+    {
+      if(_residualBins[i] == nbBins)
+        continue;
+      const int bin = (binSize > 0.0) ? static_cast<int>((log10(residuals[i] + epsilon) - logMin) / binSize) : 0;
+      _residualBins[i] = std::min(bin, nbBins - 1);
+      ++_histogram[_residualBins[i]];
+    }
+
+    // NFA at the upper bound of each bin
+    std::size_t k = 0;
+    for(int b = 0; b < nbBins; ++b)
+    {
+      k += _histogram[b];
+      if(k <= static_cast<std::size_t>(startIndex) || _histogram[b] == 0)
+        continue;
+      const double logBound = (b + 1 == nbBins) ? logMax : logMin + (b + 1) * binSize;
+      const double nfa = loge0 + (logalpha0 + multError * logBound) * (double) (k - startIndex) + logc_n[k] + logc_k[k];
+      if(nfa < bestIndex.first)
+      {
+        bestIndex = ErrorIndex(nfa, k);
+        _bestBin = b;
+      }
+    }
+    if(_bestBin < 0)
+      return bestIndex;
+
+    // exact NFA of the selected inliers
+    _errorMax = 0.0;
+    for(std::size_t i = 0; i < residuals.size(); ++i)
+    {
+      if(_residualBins[i] <= _bestBin)
+        _errorMax = std::max(_errorMax, residuals[i]);
+    }
+    const double logalpha = logalpha0 + multError * log10(_errorMax + epsilon);
+    bestIndex.first = loge0 + logalpha * (double) (bestIndex.second - startIndex) + logc_n[bestIndex.second] + logc_k[bestIndex.second];
+    return bestIndex;
+  }
+
+  /**
+   * @brief The inliers of the last call to bestNFA.
+   * @param[out] inliers the indices of the data
+   */
+  void getInliers(std::vector<std::size_t>& inliers) const
+  {
+    inliers.clear();
+    for(std::size_t i = 0; i < _residualBins.size(); ++i)
+    {
+      if(_residualBins[i] <= _bestBin)
+        inliers.push_back(i);
+    }
+  }
+
+  /// The largest residual of the inliers of the last call to bestNFA
+  double getErrorMax() const
+  {
+    return _errorMax;
+  }
+
+private:
+  std::vector<std::size_t> _histogram;
+  /// bin of each residual, the number of bins for the residuals over the threshold
+  std::vector<int> _residualBins;
+  int _bestBin = -1;
+  double _errorMax = std::numeric_limits<double>::infinity();
+};
+
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
  *
@@ -153,6 +287,13 @@ inline ErrorIndex bestNFA(
  * @param[in] nIter maximum number of consecutive iterations
  * @param[out] model returned model if found
  * @param[in] precision upper bound of the precision (squared error)
+ * @param[out] nbIterations optional number of iterations done
+ * @param[in] sortedIndices optional data indices sorted from the best to the worst quality,
+ *            enables the progressive sampling of the best data first (PROSAC)
+ * @param[in] useSprt enable the early rejection of the models unlikely to be better than the best one (SPRT),
+ *            the data consistent with a model are the ones under the precision or the error threshold of the best model
+ * @param[in] nbHistogramBins if not 0, find the best NFA from a histogram of the residuals with this number
+ *            of bins instead of sorting them (see NFAHistogram)
  *
  * @return (errorMax, minNFA)
  */
@@ -161,9 +302,15 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
   std::vector<size_t> & vec_inliers,
   size_t nIter = 1024,
   typename Kernel::Model * model = nullptr,
-  double precision = std::numeric_limits<double>::infinity())
+  double precision = std::numeric_limits<double>::infinity(),
+  size_t * nbIterations = nullptr,
+  const std::vector<std::size_t> * sortedIndices = nullptr,
+  bool useSprt = false,
+  std::size_t nbHistogramBins = 0)
 {
   vec_inliers.clear();
+  if (nbIterations)
+    *nbIterations = 0;
 
   const size_t sizeSample = Kernel::MINIMUM_SAMPLES;
   const size_t nData = kernel.NumSamples();
@@ -174,7 +321,7 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
     std::numeric_limits<double>::infinity() :
     precision * kernel.normalizer2()(0,0) * kernel.normalizer2()(0,0);
 
-  std::vector<ErrorIndex> vec_residuals(nData); // [residual,index]
+  std::vector<ErrorIndex> vec_residuals(nbHistogramBins ? 0 : nData); // [residual,index]
   std::vector<double> vec_residuals_(nData);
 
   // Possible sampling indices [0,..,nData] (will change in the optimization phase)
@@ -196,16 +343,41 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
 
   bool bACRansacMode = (precision == std::numeric_limits<double>::infinity());
 
+  // Progressive sampling until the samples are drawn among the best set of inliers
+  std::unique_ptr<ProsacSampler> prosacSampler;
+  if (sortedIndices)
+  {
+    assert(sortedIndices->size() == nData);
+    prosacSampler.reset(new ProsacSampler(sizeSample, *sortedIndices, nIter));
+  }
+
+  std::unique_ptr<NFAHistogram> nfaHistogram;
+  if (nbHistogramBins)
+    nfaHistogram.reset(new NFAHistogram(nData, nbHistogramBins));
+
+  std::unique_ptr<SprtTest> sprt;
+  if (useSprt)
+    sprt.reset(new SprtTest(nData, Kernel::MAX_MODELS));
+
+  // the models of each sample, reused to avoid allocations in the main loop
+  std::vector<typename Kernel::Model> vec_models; // Up to max_models solutions
+  vec_models.reserve(Kernel::MAX_MODELS);
+
   // Main estimation loop.
   for (size_t iter=0; iter < nIter; ++iter)
   {
+    if (nbIterations)
+      *nbIterations = iter + 1;
+
     std::vector< std::size_t> vec_sample(sizeSample); // Sample indices
-    if (bACRansacMode)
+    if (prosacSampler)
+      prosacSampler->sample(vec_sample); // Get sample among the best data
+    else if (bACRansacMode)
       UniformSample(sizeSample, vec_index, vec_sample); // Get random sample
     else
       UniformSample(sizeSample, nData, vec_sample); // Get random sample
 
-    std::vector<typename Kernel::Model> vec_models; // Up to max_models solutions
+    vec_models.clear();
     kernel.Fit(vec_sample, &vec_models);
 
     // Evaluate models
@@ -213,7 +385,23 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
     for (size_t k = 0; k < vec_models.size(); ++k)
     {
       // Residuals computation and ordering
-      kernel.Errors(vec_models[k], vec_residuals_);
+      const double sprtThreshold = (maxThreshold < std::numeric_limits<double>::infinity()) ? maxThreshold : errorMax;
+      if (sprt && sprtThreshold < std::numeric_limits<double>::infinity())
+      {
+        // all the residuals are computed if the model is not rejected
+        const typename Kernel::Model& currentModel = vec_models[k];
+        const bool accepted = sprt->verify([&](std::size_t i)
+        {
+          vec_residuals_[i] = kernel.Error(i, currentModel);
+          return vec_residuals_[i] <= sprtThreshold;
+        });
+        if (!accepted)
+          continue;
+      }
+      else
+      {
+        kernel.Errors(vec_models[k], vec_residuals_);
+      }
 
       if (!bACRansacMode)
       {
@@ -228,34 +416,60 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
       }
       if (bACRansacMode)
       {
-        for (size_t i = 0; i < nData; ++i)
+        ErrorIndex best;
+        if (nfaHistogram)
+        {
+          // Most meaningful discrimination inliers/outliers, up to the histogram precision
+          best = nfaHistogram->bestNFA(
+            sizeSample,
+            kernel.logalpha0(),
+            vec_residuals_,
+            loge0,
+            maxThreshold,
+            vec_logc_n,
+            vec_logc_k,
+            kernel.multError());
+        }
+        else
         {
-          const double error = vec_residuals_[i];
-          vec_residuals[i] = ErrorIndex(error, i);
+          for (size_t i = 0; i < nData; ++i)
+          {
+            const double error = vec_residuals_[i];
+            vec_residuals[i] = ErrorIndex(error, i);
+          }
+          std::sort(vec_residuals.begin(), vec_residuals.end());
+
+          // Most meaningful discrimination inliers/outliers
+          best = bestNFA(
+            sizeSample,
+            kernel.logalpha0(),
+            vec_residuals,
+            loge0,
+            maxThreshold,
+            vec_logc_n,
+            vec_logc_k,
+            kernel.multError());
         }
-        std::sort(vec_residuals.begin(), vec_residuals.end());
-
-        // Most meaningful discrimination inliers/outliers
-        const ErrorIndex best = bestNFA(
-          sizeSample,
-          kernel.logalpha0(),
-          vec_residuals,
-          loge0,
-          maxThreshold,
-          vec_logc_n,
-          vec_logc_k,
-          kernel.multError());
 
         if (best.first < minNFA /*&& vec_residuals[best.second-1].first < errorMax*/)
         {
           // A better model was found
           better = true;
           minNFA = best.first;
-          vec_inliers.resize(best.second);
-          for (size_t i=0; i<best.second; ++i)
-            vec_inliers[i] = vec_residuals[i].second;
-          errorMax = vec_residuals[best.second-1].first; // Error threshold
+          if (nfaHistogram)
+          {
+            nfaHistogram->getInliers(vec_inliers);
+            errorMax = nfaHistogram->getErrorMax(); // Error threshold
+          }
+          else
+          {
+            vec_inliers.resize(best.second);
+            for (size_t i=0; i<best.second; ++i)
+              vec_inliers[i] = vec_residuals[i].second;
+            errorMax = vec_residuals[best.second-1].first; // Error threshold
+          }
           if(model) *model = vec_models[k];
+          if(sprt) sprt->setBestInlierRatio(best.second / static_cast<double>(nData));
 
           ALICEVISION_LOG_TRACE("  nfa=" << minNFA
             << " inliers=" << best.second << "/" << nData
@@ -285,6 +499,7 @@ std::pair<double, double> ACRANSAC(const Kernel &kernel,
       {
         // ACRANSAC optimization: draw samples among best set of inliers so far
         vec_index = vec_inliers;
+        prosacSampler.reset();
         if(nIterReserve)
         {
           nIter = iter + 1 + nIterReserve;
@@ -28,8 +28,11 @@
 #include <aliceVision/config.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/multiview/conditioning.hpp>
+#include <aliceVision/multiview/essential.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace aliceVision {
@@ -85,6 +88,61 @@ inline bool hasStrongSupport(const matching::MatchesPerDescType& matchesPerDesc,
 }
 
 
+/**
+ * @brief Check if an error functor evaluates the errors of all the data at once:
+ * static void Errors(const Model&, const Mat& x1, const Mat& x2, double* errors)
+ * with the data stored one per row (see toPointsByRow).
+ */
+template<typename ErrorT, typename Model, typename = void>
+struct HasBatchErrors : std::false_type {};
+
+template<typename ErrorT, typename Model>
+struct HasBatchErrors<ErrorT, Model, decltype(ErrorT::Errors(std::declval<const Model&>(),
+                                                             std::declval<const Mat&>(),
+                                                             std::declval<const Mat&>(),
+                                                             std::declval<double*>()))>
+  : std::true_type {};
+
+/**
+ * @brief Copy of the data for the batch error functors: one data per row, so each
+ * coordinate is stored contiguously (SoA). Empty if the functor has no batch evaluation.
+ */
+template<typename ErrorT, typename Model>
+Mat toPointsByRow(const Mat& points)
+{
+  return HasBatchErrors<ErrorT, Model>::value ? Mat(points.transpose()) : Mat();
+}
+
+template<typename ErrorT, typename Model>
+void computeErrors(const Model& model, const Mat& x1, const Mat& x2, const Mat& x1ByRow, const Mat& x2ByRow,
+                   std::vector<double>& errors, std::true_type)
+{
+  ErrorT::Errors(model, x1ByRow, x2ByRow, errors.data());
+}
+
+template<typename ErrorT, typename Model>
+void computeErrors(const Model& model, const Mat& x1, const Mat& x2, const Mat& x1ByRow, const Mat& x2ByRow,
+                   std::vector<double>& errors, std::false_type)
+{
+  for(Mat::Index sample = 0; sample < x1.cols(); ++sample)
+    errors[sample] = ErrorT::Error(model, x1.col(sample), x2.col(sample));
+}
+
+/**
+ * @brief Compute the errors of all the data, with the batch evaluation of the error functor if any.
+ * @param[in] model The model
+ * @param[in] x1 x2 The data, one data per column
+ * @param[in] x1ByRow x2ByRow The same data, one data per row (see toPointsByRow)
+ * @param[out] errors The error of each data
+ */
+template<typename ErrorT, typename Model>
+void computeErrors(const Model& model, const Mat& x1, const Mat& x2, const Mat& x1ByRow, const Mat& x2ByRow,
+                   std::vector<double>& errors)
+{
+  errors.resize(x1.cols());
+  computeErrors<ErrorT>(model, x1, x2, x1ByRow, x2ByRow, errors, HasBatchErrors<ErrorT, Model>());
+}
+
 /// Two view Kernel adapter for the A contrario model estimator
 /// Handle data normalization and compute the corresponding logalpha 0
 ///  that depends of the error model (point to line, or point to point)
@@ -114,6 +172,8 @@ public:
 
     NormalizePointsFromImageSize(x1, &x1_, &N1_, w1, h1);
     NormalizePointsFromImageSize(x2, &x2_, &N2_, w2, h2);
+    x1ByRow_ = toPointsByRow<ErrorT, Model>(x1_);
+    x2ByRow_ = toPointsByRow<ErrorT, Model>(x2_);
 
     // LogAlpha0 is used to make error data scale invariant
     if(bPointToLine)
@@ -154,9 +214,7 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x1_.cols());
-    for(std::size_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x1_.col(sample), x2_.col(sample));
+    computeErrors<ErrorT>(model, x1_, x2_, x1ByRow_, x2ByRow_, vec_errors);
   }
 
   std::size_t NumSamples() const
@@ -180,6 +238,7 @@ public:
 
 protected:
   Mat x1_, x2_; // Normalized input data
+  Mat x1ByRow_, x2ByRow_; // Normalized input data for the batch error functors
   Mat3 N1_, N2_; // Matrix used to normalize data
   double logalpha0_; // Alpha0 is used to make the error adaptive to the image size
   bool bPointToLine_; // Store if error model is pointToLine or point to point
@@ -216,6 +275,8 @@ public:
     assert(x2d_.cols() == x3D_.cols());
 
     NormalizePointsFromImageSize(x2d, &x2d_, &N1_, w, h);
+    x2dByRow_ = toPointsByRow<ErrorT, Model>(x2d_);
+    x3DByRow_ = toPointsByRow<ErrorT, Model>(x3D_);
   }
 
   enum
@@ -242,9 +303,7 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x2d_.cols());
-    for(std::size_t sample = 0; sample < x2d_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x2d_.col(sample), x3D_.col(sample));
+    computeErrors<ErrorT>(model, x2d_, x3D_, x2dByRow_, x3DByRow_, vec_errors);
   }
 
   std::size_t NumSamples() const
@@ -267,6 +326,7 @@ public:
 private:
   Mat x2d_;
   const Mat& x3D_;
+  Mat x2dByRow_, x3DByRow_; // Input data for the batch error functors
   Mat3 N1_; // Matrix used to normalize data
   double logalpha0_; // Alpha0 is used to make the error adaptive to the image size
 };
@@ -296,6 +356,8 @@ public:
 
     // Normalize points by inverse(K)
     ApplyTransformationToPoints(x2d, N1_, &x2d_);
+    x2dByRow_ = toPointsByRow<ErrorT, Model>(x2d_);
+    x3DByRow_ = toPointsByRow<ErrorT, Model>(x3D_);
   }
 
   enum
@@ -322,9 +384,7 @@ public:
 
   void Errors(const Model & model, std::vector<double> & vec_errors) const
   {
-    vec_errors.resize(x2d_.cols());
-    for(std::size_t sample = 0; sample < x2d_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(model, x2d_.col(sample), x3D_.col(sample));
+    computeErrors<ErrorT>(model, x2d_, x3D_, x2dByRow_, x3DByRow_, vec_errors);
   }
 
   std::size_t NumSamples() const { return x2d_.cols(); }
@@ -344,6 +404,7 @@ public:
 protected:
   Mat x2d_;
   const Mat& x3D_;
+  Mat x2dByRow_, x3DByRow_; // Input data for the batch error functors
   Mat3 N1_; // Matrix used to normalize data
   double logalpha0_; // Alpha0 is used to make the error adaptive to the image size
   Mat3 K_; // Intrinsic camera parameter
@@ -376,6 +437,8 @@ public:
 
     ApplyTransformationToPoints(x1_, K1_.inverse(), &x1k_);
     ApplyTransformationToPoints(x2_, K2_.inverse(), &x2k_);
+    x1ByRow_ = toPointsByRow<ErrorT, Mat3>(x1_);
+    x2ByRow_ = toPointsByRow<ErrorT, Mat3>(x2_);
 
     //Point to line probability (line is the epipolar line)
     const double D = sqrt(w2 * (double)w2 + h2 * (double)h2); // diameter
@@ -411,9 +474,7 @@ public:
   {
     Mat3 F;
     FundamentalFromEssential(model, K1_, K2_, &F);
-    vec_errors.resize(x1_.cols());
-    for(std::size_t sample = 0; sample < x1_.cols(); ++sample)
-      vec_errors[sample] = ErrorT::Error(F, this->x1_.col(sample), this->x2_.col(sample));
+    computeErrors<ErrorT>(F, x1_, x2_, x1ByRow_, x2ByRow_, vec_errors);
   }
 
   std::size_t NumSamples() const { return x1_.cols(); }
@@ -426,6 +487,7 @@ public:
 
 private:
   Mat x1_, x2_, x1k_, x2k_; // image point and camera plane point.
+  Mat x1ByRow_, x2ByRow_; // image point for the batch error functors
   Mat3 N1_, N2_; // Matrix used to normalize data
   double logalpha0_; // Alpha0 is used to make the error adaptive to the image size
   Mat3 K1_, K2_; // Intrinsic camera parameter
@@ -7,9 +7,13 @@
 #pragma once
 
 #include "aliceVision/robustEstimation/randSampling.hpp"
+#include "aliceVision/robustEstimation/prosacSampling.hpp"
+#include "aliceVision/robustEstimation/sprt.hpp"
 #include "aliceVision/robustEstimation/ACRansac.hpp"
 #include "aliceVision/robustEstimation/ransacTools.hpp"
+#include <cassert>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <iostream>
 #include <vector>
@@ -379,6 +383,10 @@ double localOptimization(const Kernel &kernel,
  * @param[in] bVerbose Enable/Disable log messages
  * @param[in] max_iterations Maximum number of iterations for the ransac part.
  * @param[in] outliers_probability The wanted probability of picking outliers.
+ * @param[in] sortedIndices Optional data indices sorted from the best to the worst quality,
+ * enables the progressive sampling of the best data first (PROSAC).
+ * @param[in] useSprt Enable the early rejection of the models unlikely to be better
+ * than the best one (SPRT), with the threshold of the scorer.
  * @return The best model found.
  */
 template<typename Kernel, typename Scorer>
@@ -388,7 +396,9 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
                                 double *best_score = NULL,
                                 bool bVerbose = false,
                                 std::size_t max_iterations = 100,
-                                double outliers_probability = 1e-2)
+                                double outliers_probability = 1e-2,
+                                const std::vector<std::size_t> *sortedIndices = NULL,
+                                bool useSprt = false)
 {
   assert(outliers_probability < 1.0);
   assert(outliers_probability > 0.0);
@@ -416,17 +426,38 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
   std::vector<std::size_t> all_samples(total_samples);
   std::iota(all_samples.begin(), all_samples.end(), 0);
 
+  // The progressive sampling reaches the uniform sampling after the initial number of iterations.
+  std::unique_ptr<ProsacSampler> prosacSampler;
+  if(sortedIndices)
+  {
+    assert(sortedIndices->size() == total_samples);
+    prosacSampler.reset(new ProsacSampler(min_samples, *sortedIndices, max_iterations));
+  }
+
+  std::unique_ptr<SprtTest> sprt;
+  if(useSprt)
+    sprt.reset(new SprtTest(total_samples));
+
+  // the models of each sample, reused to avoid allocations in the main loop
+  std::vector<typename Kernel::Model> models;
+
   for(iteration = 0; iteration < max_iterations; ++iteration) 
   {
     std::vector<std::size_t> sample;
-    UniformSample(min_samples, total_samples, sample);
+    if(prosacSampler)
+      prosacSampler->sample(sample);
+    else
+      UniformSample(min_samples, total_samples, sample);
 
-    std::vector<typename Kernel::Model> models;
+    models.clear();
     kernel.Fit(sample, &models);
 
     // Compute the inlier list for each fit.
     for(std::size_t i = 0; i < models.size(); ++i) 
     {
+      if(sprt && !sprt->verify([&](std::size_t j) { return kernel.Error(j, models[i]) < scorer.getThreshold(); }))
+        continue;
+
       std::vector<std::size_t> inliers;
       double score = scorer.Score(kernel, models[i], all_samples, &inliers);
       if(bVerbose)
@@ -463,6 +494,8 @@ typename Kernel::Model LO_RANSAC(const Kernel &kernel,
         
         bestNumInliers = inliers.size();
         bestInlierRatio = inliers.size() / double(total_samples);
+        if(sprt)
+          sprt->setBestInlierRatio(bestInlierRatio);
 
         if (best_inliers) 
         {
@@ -67,6 +67,9 @@ typename Kernel::Model RANSAC(
   std::vector<size_t> all_samples(total_samples);
   std::iota(all_samples.begin(), all_samples.end(), 0);
 
+  // the models of each sample, reused to avoid allocations in the main loop
+  std::vector<typename Kernel::Model> models;
+
   for (iteration = 0;
     iteration < max_iterations &&
     iteration < really_max_iterations; ++iteration) 
@@ -74,7 +77,7 @@ typename Kernel::Model RANSAC(
       std::vector<size_t> sample;
       UniformSample(min_samples, total_samples, sample);
 
-      std::vector<typename Kernel::Model> models;
+      models.clear();
       kernel.Fit(sample, &models);
 
       // Compute the inlier list for each fit.
@@ -10,6 +10,7 @@
 
 #include <aliceVision/robustEstimation/LineKernel.hpp>
 #include <aliceVision/robustEstimation/ACRansac.hpp>
+#include <aliceVision/robustEstimation/prosacSampling.hpp>
 #include <aliceVision/robustEstimation/randSampling.hpp>
 #include <glog/logging.h>
 
@@ -248,6 +249,84 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_RealisticCase)
   BOOST_CHECK_SMALL(GTModel(1)-line[1], 1e-9);
 }
 
+// Test ACRANSAC with the early rejection of the bad models
+BOOST_AUTO_TEST_CASE(RansacLineFitter_Sprt)
+{
+  const int NbPoints = 1000;
+  const int NbInliers = 300;
+  Mat2X xy(2, NbPoints);
+
+  Vec2 GTModel; // y = 6.3 x + (-2.0)
+  GTModel << -2.0, 6.3;
+
+  std::mt19937 gen;
+  std::uniform_real_distribution<> pos(0, NbPoints);
+  for(Mat::Index i = 0; i < NbPoints; ++i)
+  {
+    if(i < NbInliers)
+      xy.col(i) << i, (double) i * GTModel[1] + GTModel[0];
+    else
+      xy.col(i) << pos(gen), pos(gen) * GTModel[1];
+  }
+
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(xy, NbPoints, NbPoints * GTModel[1]);
+
+  // with and without an upper bound of the precision
+  for(const double precision : {std::numeric_limits<double>::infinity(), 1.0})
+  {
+    seedRandomNumberGenerator(0);
+    std::vector<std::size_t> vec_inliers;
+    Vec2 line;
+    ACRANSAC(lineKernel, vec_inliers, 300, &line, precision, nullptr, nullptr, true);
+
+    BOOST_CHECK(vec_inliers.size() >= NbInliers);
+    BOOST_CHECK_SMALL(GTModel(0)-line[0], 1e-6);
+    BOOST_CHECK_SMALL(GTModel(1)-line[1], 1e-6);
+  }
+}
+
+// Test ACRANSAC with the progressive sampling on a dataset with a low inlier ratio
+BOOST_AUTO_TEST_CASE(RansacLineFitter_Prosac)
+{
+  const int NbPoints = 1000;
+  const int NbInliers = 50;
+  Mat2X xy(2, NbPoints);
+
+  Vec2 GTModel; // y = 6.3 x + (-2.0)
+  GTModel << -2.0, 6.3;
+
+  std::mt19937 gen;
+  std::uniform_real_distribution<> pos(0, NbPoints);
+  std::uniform_real_distribution<> ratio(0.0, 1.0);
+
+  // The inliers are the last points, with a better quality score
+  // than most of the outliers (lower is better, like the Lowe ratio).
+  std::vector<double> quality(NbPoints);
+  for(Mat::Index i = 0; i < NbPoints; ++i)
+  {
+    const bool isInlier = (i >= NbPoints - NbInliers);
+    if(isInlier)
+      xy.col(i) << i, (double) i * GTModel[1] + GTModel[0];
+    else
+      xy.col(i) << pos(gen), pos(gen) * GTModel[1];
+    quality[i] = isInlier ? 0.1 * ratio(gen) : ratio(gen);
+  }
+
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(xy, NbPoints, NbPoints * GTModel[1]);
+
+  // With 5% of inliers, uniform sampling needs ~400 iterations to draw an inlier pair,
+  // the progressive sampling finds it among the first ones.
+  seedRandomNumberGenerator(0);
+  const std::vector<std::size_t> sortedIndices = sortByQuality(quality);
+  std::vector<std::size_t> vec_inliers;
+  Vec2 line;
+  ACRANSAC(lineKernel, vec_inliers, 50, &line, std::numeric_limits<double>::infinity(), nullptr, &sortedIndices);
+
+  BOOST_CHECK(vec_inliers.size() >= NbInliers);
+  BOOST_CHECK_SMALL(GTModel(0)-line[0], 1e-6);
+  BOOST_CHECK_SMALL(GTModel(1)-line[1], 1e-6);
+}
+
 // Generate nbPoints along a line and add gaussian noise.
 // Move some point in the dataset to create outlier contamined data
 
@@ -362,3 +441,60 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSimu)
 
   }
 }
+
+// Compare the best NFA found from a histogram of the residuals with the one found by sorting them
+BOOST_AUTO_TEST_CASE(RansacLineFitter_NFAHistogram)
+{
+  const int S = 100;
+  const float outlierRatio = .3f;
+  Vec2 GTModel;
+  GTModel << -2, .3;
+  std::mt19937 gen;
+
+  const std::size_t numPoints = 2.0 * S * sqrt(2.0);
+  Mat2X points(2, numPoints);
+  std::vector<std::size_t> vec_inliersGT;
+  generateLine(numPoints, outlierRatio, 1.0, GTModel, gen, points, vec_inliersGT);
+
+  ACRANSACOneViewKernel<LineSolver, pointToLineError, Vec2> lineKernel(points, S, S);
+  const std::size_t sizeSample = LineSolver::MINIMUM_SAMPLES;
+  const double loge0 = log10((double) LineSolver::MAX_MODELS * (numPoints - sizeSample));
+  std::vector<float> vec_logc_n, vec_logc_k;
+  makelogcombi(sizeSample, numPoints, vec_logc_k, vec_logc_n);
+
+  std::vector<double> residuals(numPoints);
+  lineKernel.Errors(GTModel, residuals);
+
+  std::vector<ErrorIndex> sortedResiduals(numPoints);
+  for(std::size_t i = 0; i < numPoints; ++i)
+    sortedResiduals[i] = ErrorIndex(residuals[i], i);
+  std::sort(sortedResiduals.begin(), sortedResiduals.end());
+  const ErrorIndex exact = bestNFA(sizeSample, lineKernel.logalpha0(), sortedResiduals, loge0,
+                                   std::numeric_limits<double>::infinity(), vec_logc_n, vec_logc_k, lineKernel.multError());
+
+  NFAHistogram histogram(numPoints, 1000);
+  const ErrorIndex approx = histogram.bestNFA(sizeSample, lineKernel.logalpha0(), residuals, loge0,
+                                              std::numeric_limits<double>::infinity(), vec_logc_n, vec_logc_k, lineKernel.multError());
+
+  // the exact search gives the minimum, the histogram is close to it
+  BOOST_CHECK_LE(exact.first, approx.first + 1e-6);
+  BOOST_CHECK_CLOSE(exact.first, approx.first, 1.0);
+  BOOST_CHECK_LE(std::abs(double(exact.second) - double(approx.second)), 0.02 * exact.second);
+
+  // the inliers are the data under the largest residual
+  std::vector<std::size_t> inliers;
+  histogram.getInliers(inliers);
+  BOOST_CHECK_EQUAL(inliers.size(), approx.second);
+  for(const std::size_t i : inliers)
+    BOOST_CHECK_LE(residuals[i], histogram.getErrorMax());
+  BOOST_CHECK_EQUAL(histogram.getErrorMax(), sortedResiduals[approx.second - 1].first);
+
+  // the whole estimation
+  std::vector<std::size_t> vec_inliers;
+  Vec2 line;
+  const std::pair<double, double> ret = ACRANSAC(lineKernel, vec_inliers, 1000, &line,
+                                                 std::numeric_limits<double>::infinity(), nullptr, nullptr, false, 1000);
+  BOOST_CHECK(ret.second < 0);
+  BOOST_CHECK(vec_inliers.size() <= vec_inliersGT.size());
+  BOOST_CHECK_GE(vec_inliers.size(), 0.9 * exact.second);
+}
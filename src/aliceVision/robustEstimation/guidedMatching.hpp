@@ -14,11 +14,225 @@
 #include "aliceVision/feature/Regions.hpp"
 #include "aliceVision/camera/IntrinsicBase.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace aliceVision {
+
+namespace fundamental {
+namespace kernel {
+struct EpipolarDistanceError;
+} // namespace kernel
+} // namespace fundamental
+
+namespace homography {
+namespace kernel {
+struct AsymmetricError;
+} // namespace kernel
+} // namespace homography
+
 namespace robustEstimation {
 
+/**
+ * @brief Regular grid over 2D points, to visit only the points
+ * close to a location or to a line instead of all of them.
+ */
+class PointsGrid
+{
+public:
+  /**
+   * @param[in] points The indexed points
+   * @param[in] pointsPerCell The expected mean number of points per cell
+   */
+  explicit PointsGrid(const std::vector<Vec2>& points, double pointsPerCell = 4.0)
+  {
+    if(points.empty())
+      return;
+
+    _min = points.front();
+    Vec2 max = points.front();
+    for(const Vec2& pt : points)
+    {
+      _min = _min.cwiseMin(pt);
+      max = max.cwiseMax(pt);
+    }
+    const Vec2 extent = (max - _min).cwiseMax(Vec2::Constant(1.0));
+    const double nbCells = std::max(1.0, points.size() / pointsPerCell);
+    _cellSize = std::sqrt(extent.x() * extent.y() / nbCells);
+    _width = std::min(static_cast<int>(extent.x() / _cellSize) + 1, 1024);
+    _height = std::min(static_cast<int>(extent.y() / _cellSize) + 1, 1024);
+    _cellSize = std::max(extent.x() / _width, extent.y() / _height) * (1.0 + 1e-9);
+
+    // points sorted by cell (compressed rows), in the input order in each cell
+    std::vector<int> pointCells(points.size());
+    _cellStart.assign(_width * _height + 1, 0);
+    for(std::size_t i = 0; i < points.size(); ++i)
+    {
+      const Vec2 cell = (points[i] - _min) / _cellSize;
+      const int x = std::min(static_cast<int>(cell.x()), _width - 1);
+      const int y = std::min(static_cast<int>(cell.y()), _height - 1);
+      pointCells[i] = y * _width + x;
+      ++_cellStart[pointCells[i] + 1];
+    }
+    for(std::size_t c = 1; c < _cellStart.size(); ++c)
+      _cellStart[c] += _cellStart[c - 1];
+
+    std::vector<std::size_t> cellFill(_cellStart.begin(), _cellStart.end() - 1);
+    _pointsId.resize(points.size());
+    for(std::size_t i = 0; i < points.size(); ++i)
+      _pointsId[cellFill[pointCells[i]]++] = i;
+  }
+
+  /**
+   * @brief Call f(pointId) for the points of the cells intersecting the square bounding the disk
+   */
+  template<typename Functor>
+  void forEachInDisk(const Vec2& center, double radius, Functor f) const
+  {
+    if(_pointsId.empty() || !std::isfinite(center.x()) || !std::isfinite(center.y()))
+      return;
+    visitCells(toCellX(center.x() - radius), toCellX(center.x() + radius),
+               toCellY(center.y() - radius), toCellY(center.y() + radius), f);
+  }
+
+  /**
+   * @brief Call f(pointId) for the points of the cells intersecting the band
+   * of half width distance around the line (a, b, c): a.x + b.y + c = 0
+   */
+  template<typename Functor>
+  void forEachNearLine(const Vec3& line, double distance, Functor f) const
+  {
+    const double a = line(0), b = line(1), c = line(2);
+    const double norm = std::hypot(a, b);
+    if(_pointsId.empty() || !(norm > 0.0) || !std::isfinite(c))
+      return;
+
+    if(std::abs(b) >= std::abs(a))
+    {
+      // mostly horizontal line: y range of the band for each column of cells
+      const double margin = distance * norm / std::abs(b);
+      for(int cx = 0; cx < _width; ++cx)
+      {
+        const double x0 = _min.x() + cx * _cellSize;
+        const double y0 = -(a * x0 + c) / b;
+        const double y1 = -(a * (x0 + _cellSize) + c) / b;
+        visitCells(cx, cx, toCellY(std::min(y0, y1) - margin), toCellY(std::max(y0, y1) + margin), f);
+      }
+    }
+    else
+    {
+      // mostly vertical line: x range of the band for each row of cells
+      const double margin = distance * norm / std::abs(a);
+      for(int cy = 0; cy < _height; ++cy)
+      {
+        const double y0 = _min.y() + cy * _cellSize;
+        const double x0 = -(b * y0 + c) / a;
+        const double x1 = -(b * (y0 + _cellSize) + c) / a;
+        visitCells(toCellX(std::min(x0, x1) - margin), toCellX(std::max(x0, x1) + margin), cy, cy, f);
+      }
+    }
+  }
+
+  /**
+   * @brief Call f(pointId) for all the points, in the input order
+   */
+  template<typename Functor>
+  void forEachPoint(Functor f) const
+  {
+    for(std::size_t pointId = 0; pointId < _pointsId.size(); ++pointId)
+      f(pointId);
+  }
+
+private:
+  /// Cell index of a coordinate, -1 or size if outside of the grid
+  static int toCell(double v, double min, double cellSize, int size)
+  {
+    const double cell = std::floor((v - min) / cellSize);
+    if(!(cell >= 0.0))
+      return (cell < 0.0) ? -1 : size; // NaN is outside
+    return (cell >= size) ? size : static_cast<int>(cell);
+  }
+
+  int toCellX(double x) const { return toCell(x, _min.x(), _cellSize, _width); }
+  int toCellY(double y) const { return toCell(y, _min.y(), _cellSize, _height); }
+
+  template<typename Functor>
+  void visitCells(int x0, int x1, int y0, int y1, Functor& f) const
+  {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, _width - 1);
+    y1 = std::min(y1, _height - 1);
+    for(int y = y0; y <= y1; ++y)
+    {
+      for(int x = x0; x <= x1; ++x)
+      {
+        const int cell = y * _width + x;
+        for(std::size_t k = _cellStart[cell]; k < _cellStart[cell + 1]; ++k)
+          f(_pointsId[k]);
+      }
+    }
+  }
+
+  Vec2 _min = Vec2::Zero();
+  double _cellSize = 1.0;
+  int _width = 0;
+  int _height = 0;
+  std::vector<std::size_t> _cellStart;
+  std::vector<std::size_t> _pointsId;
+};
+
+/**
+ * @brief Visit the right points that may have an error to the model below the threshold
+ * for a given left point. By default all the right points are candidates,
+ * the specializations only visit the grid cells close to the transferred point or line.
+ * @tparam ErrorArg The metric to compute distance to the model
+ */
+template<typename ErrorArg>
+struct GuidedMatchingCandidates
+{
+  template<typename ModelArg, typename Functor>
+  static void forEach(const ModelArg& mod, const Vec2& xLeft, double errorTh, const PointsGrid& grid, Functor f)
+  {
+    grid.forEachPoint(f);
+  }
+};
+
+/// Squared distance to the epipolar line in the right image: points in a band around the line
+template<>
+struct GuidedMatchingCandidates<fundamental::kernel::EpipolarDistanceError>
+{
+  template<typename ModelArg, typename Functor>
+  static void forEach(const ModelArg& mod, const Vec2& xLeft, double errorTh, const PointsGrid& grid, Functor f)
+  {
+    grid.forEachNearLine(mod * xLeft.homogeneous(), std::sqrt(errorTh), f);
+  }
+};
+
+/// Squared distance to the transferred point in the right image: points in a disk around it
+template<>
+struct GuidedMatchingCandidates<homography::kernel::AsymmetricError>
+{
+  template<typename ModelArg, typename Functor>
+  static void forEach(const ModelArg& mod, const Vec2& xLeft, double errorTh, const PointsGrid& grid, Functor f)
+  {
+    const Vec3 x2h = mod * xLeft.homogeneous();
+    if(x2h(2) == 0.0)
+      return;
+    grid.forEachInDisk(x2h.head<2>() / x2h(2), std::sqrt(errorTh), f);
+  }
+};
+
+/// Columns of a 2xN matrix as points
+inline std::vector<Vec2> toPoints(const Mat& x)
+{
+  std::vector<Vec2> points(x.cols());
+  for(Mat::Index i = 0; i < x.cols(); ++i)
+    points[i] = x.col(i).head<2>();
+  return points;
+}
+
 /**
  * @brief Guided Matching (features only):
  *   Use a model to find valid correspondences:
@@ -37,24 +251,37 @@ void GuidedMatching(
 {
   assert(xLeft.rows() == xRight.rows());
 
+  // only visit the right points close to the model
+  const bool useGrid = (xRight.rows() == 2);
+  const PointsGrid grid(useGrid ? toPoints(xRight) : std::vector<Vec2>());
+
   // Looking for the corresponding points that have
   //  the smallest distance (smaller than the provided Threshold)
   for (Mat::Index i = 0; i < xLeft.cols(); ++i)
   {
     double min = std::numeric_limits<double>::max();
     matching::IndMatch match;
-    for(Mat::Index j = 0; j < xRight.cols(); ++j)
+    const auto updateMatch = [&](Mat::Index j)
     {
       // Compute the geometric error: error to the model
       const double err = ErrorArg::Error(
                                          mod, // The model
                                          xLeft.col(i), xRight.col(j)); // The corresponding points
-      // if smaller error update corresponding index
-      if(err < errorTh && err < min)
+      // if smaller error update corresponding index (the smallest index for equal errors)
+      if(err < errorTh && (err < min || (err == min && j < static_cast<Mat::Index>(match._j))))
       {
         min = err;
         match = matching::IndMatch(i, j);
       }
+    };
+    if(useGrid)
+    {
+      GuidedMatchingCandidates<ErrorArg>::forEach(mod, xLeft.col(i).template head<2>(), errorTh, grid, updateMatch);
+    }
+    else
+    {
+      for(Mat::Index j = 0; j < xRight.cols(); ++j)
+        updateMatch(j);
     }
     if(min < errorTh)
     {
@@ -84,9 +311,10 @@ struct distanceRatio
   { }
 
   // Update match according the provided distance
+  // (the smallest index for equal distances, whatever the order of the updates)
   inline bool update(std::size_t index, DistT dist)
   {
-    if(dist < bd) // best than any previous
+    if(dist < bd || (dist == bd && index < idx)) // best than any previous
     {
       idx = index;
       // update and swap
@@ -143,11 +371,15 @@ void GuidedMatching(
   //   1. a geometric distance below the provided Threshold
   //   2. a distance ratio between descriptors of valid geometric correspondencess
 
+  // only visit the right points close to the model
+  const bool useGrid = (xRight.rows() == 2);
+  const PointsGrid grid(useGrid ? toPoints(xRight) : std::vector<Vec2>());
+
   for(Mat::Index i = 0; i < xLeft.cols(); ++i)
   {
 
     distanceRatio<typename MetricT::ResultType > dR;
-    for(Mat::Index j = 0; j < xRight.cols(); ++j)
+    const auto updateMatch = [&](Mat::Index j)
     {
       // Compute the geometric error: error to the model
       const double geomErr = ErrorArg::Error(mod, // The model
@@ -160,6 +392,15 @@ void GuidedMatching(
         // Update the corresponding points & distance (if required)
         dR.update(j, descDist);
       }
+    };
+    if(useGrid)
+    {
+      GuidedMatchingCandidates<ErrorArg>::forEach(mod, xLeft.col(i).template head<2>(), errorTh, grid, updateMatch);
+    }
+    else
+    {
+      for(Mat::Index j = 0; j < xRight.cols(); ++j)
+        updateMatch(j);
     }
     // Add correspondence only iff the distance ratio is valid
     if(dR.isValid(distRatio))
@@ -223,10 +464,13 @@ void GuidedMatching(
       rRegionsPos[i] = rRegions.GetRegionPosition(i);
   }
 
+  // only visit the right regions close to the model
+  const PointsGrid grid(rRegionsPos);
+
   for(std::size_t i = 0; i < lRegions.RegionCount(); ++i)
   {
     distanceRatio<double> dR;
-    for(std::size_t j = 0; j < rRegions.RegionCount(); ++j)
+    GuidedMatchingCandidates<ErrorArg>::forEach(mod, lRegionsPos[i], errorTh, grid, [&](std::size_t j)
     {
       // Compute the geometric error: error to the model
       const double geomErr = ErrorArg::Error(mod, // The model
@@ -238,7 +482,7 @@ void GuidedMatching(
         // Update the corresponding points & distance (if required)
         dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
       }
-    }
+    });
     // Add correspondence only iff the distance ratio is valid
     if(dR.isValid(distRatio))
     {
@@ -0,0 +1,155 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/robustEstimation/guidedMatching.hpp"
+#include "aliceVision/multiview/fundamentalKernelSolver.hpp"
+#include "aliceVision/multiview/homographyKernelSolver.hpp"
+
+#include <set>
+#include <vector>
+
+#define BOOST_TEST_MODULE guidedMatching
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::robustEstimation;
+
+namespace {
+
+/// Exhaustive search of the points below the error threshold
+template<typename ErrorArg>
+std::set<std::size_t> exhaustiveCandidates(const Mat3& model, const Vec2& xLeft, const std::vector<Vec2>& points, double errorTh)
+{
+  std::set<std::size_t> candidates;
+  for(std::size_t j = 0; j < points.size(); ++j)
+  {
+    if(ErrorArg::Error(model, xLeft, points[j]) < errorTh)
+      candidates.insert(j);
+  }
+  return candidates;
+}
+
+/// Points visited by the grid search below the error threshold
+template<typename ErrorArg>
+std::set<std::size_t> gridCandidates(const Mat3& model, const Vec2& xLeft, const std::vector<Vec2>& points, const PointsGrid& grid, double errorTh)
+{
+  std::set<std::size_t> candidates;
+  GuidedMatchingCandidates<ErrorArg>::forEach(model, xLeft, errorTh, grid, [&](std::size_t j)
+  {
+    if(ErrorArg::Error(model, xLeft, points[j]) < errorTh)
+      candidates.insert(j);
+  });
+  return candidates;
+}
+
+std::vector<Vec2> randomPoints(std::size_t nbPoints)
+{
+  std::vector<Vec2> points(nbPoints);
+  for(Vec2& pt : points)
+    pt = 1000.0 * (Vec2::Random() + Vec2::Ones());
+  return points;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_gridHomography)
+{
+  const std::vector<Vec2> rightPoints = randomPoints(2000);
+  const PointsGrid grid(rightPoints);
+
+  Mat3 H;
+  H << 1.1, 0.05, 20.0,
+      -0.1, 0.95, -10.0,
+       1e-4, 5e-5, 1.0;
+
+  const double errorTh = Square(8.0);
+  for(const Vec2& xLeft : randomPoints(200))
+  {
+    BOOST_CHECK(gridCandidates<homography::kernel::AsymmetricError>(H, xLeft, rightPoints, grid, errorTh) ==
+                exhaustiveCandidates<homography::kernel::AsymmetricError>(H, xLeft, rightPoints, errorTh));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_gridFundamental)
+{
+  const std::vector<Vec2> rightPoints = randomPoints(2000);
+  const PointsGrid grid(rightPoints);
+
+  const double errorTh = Square(4.0);
+  for(int trial = 0; trial < 10; ++trial)
+  {
+    // random rank 2 matrix
+    const Mat3 R = Mat3::Random();
+    Eigen::JacobiSVD<Mat3> svd(R, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Vec3 d = svd.singularValues();
+    d(2) = 0.0;
+    const Mat3 F = svd.matrixU() * d.asDiagonal() * svd.matrixV().transpose();
+
+    for(const Vec2& xLeft : randomPoints(100))
+    {
+      BOOST_CHECK(gridCandidates<fundamental::kernel::EpipolarDistanceError>(F, xLeft, rightPoints, grid, errorTh) ==
+                  exhaustiveCandidates<fundamental::kernel::EpipolarDistanceError>(F, xLeft, rightPoints, errorTh));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_gridMatches)
+{
+  // same matches as the exhaustive search
+  const std::vector<Vec2> leftPoints = randomPoints(500);
+  Mat3 H;
+  H << 0.9, 0.0, 50.0,
+       0.0, 0.9, 30.0,
+       0.0, 0.0, 1.0;
+
+  Mat xLeft(2, leftPoints.size());
+  Mat xRight(2, leftPoints.size());
+  for(std::size_t i = 0; i < leftPoints.size(); ++i)
+  {
+    xLeft.col(i) = leftPoints[i];
+    xRight.col(i) = (H * leftPoints[i].homogeneous()).hnormalized() + 0.5 * Vec2::Random();
+  }
+
+  matching::IndMatches matches;
+  GuidedMatching<Mat3, homography::kernel::AsymmetricError>(H, xLeft, xRight, Square(2.0), matches);
+
+  matching::IndMatches exhaustiveMatches;
+  for(Mat::Index i = 0; i < xLeft.cols(); ++i)
+  {
+    double min = std::numeric_limits<double>::max();
+    std::size_t best = 0;
+    for(Mat::Index j = 0; j < xRight.cols(); ++j)
+    {
+      const double err = homography::kernel::AsymmetricError::Error(H, xLeft.col(i), xRight.col(j));
+      if(err < Square(2.0) && err < min)
+      {
+        min = err;
+        best = j;
+      }
+    }
+    if(min < Square(2.0))
+      exhaustiveMatches.emplace_back(i, best);
+  }
+  matching::IndMatch::getDeduplicated(exhaustiveMatches);
+
+  BOOST_CHECK_EQUAL(matches.size(), exhaustiveMatches.size());
+  BOOST_CHECK(matches == exhaustiveMatches);
+}
+
+BOOST_AUTO_TEST_CASE(GuidedMatching_distanceRatioTies)
+{
+  // the smallest index is kept for equal distances, whatever the order of the visit
+  for(const std::vector<std::size_t>& order : {std::vector<std::size_t>{2, 5, 7}, std::vector<std::size_t>{7, 5, 2}})
+  {
+    distanceRatio<double> dR;
+    for(std::size_t index : order)
+      dR.update(index, (index == 7) ? 3.0 : 1.0);
+    BOOST_CHECK_EQUAL(dR.idx, 2);
+    BOOST_CHECK_EQUAL(dR.bd, 1.0);
+    BOOST_CHECK_EQUAL(dR.sbd, 1.0);
+  }
+}
@@ -44,6 +44,9 @@ double LeastMedianOfSquares(const Kernel &kernel,
   const std::size_t N = (min_samples < total_samples) ?
           getNumSamples(minProba, outlierRatio, min_samples) : 0;
 
+  // the models of each sample, reused to avoid allocations in the main loop
+  std::vector<typename Kernel::Model> models;
+
   for(std::size_t i = 0; i < N; i++)
   {
 
@@ -52,7 +55,7 @@ double LeastMedianOfSquares(const Kernel &kernel,
     UniformSample(min_samples, total_samples, vec_sample);
 
     // Estimate parameters: the solutions are stored in a vector
-    std::vector<typename Kernel::Model> models;
+    models.clear();
     kernel.Fit(vec_sample, &models);
 
     // Now test the solutions on the whole data
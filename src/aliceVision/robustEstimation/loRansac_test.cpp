@@ -161,3 +161,32 @@ BOOST_AUTO_TEST_CASE(LoRansacLineFitter_RealCaseLoRansac)
     BOOST_CHECK_EQUAL(expectedInliers, vec_inliers.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(LoRansacLineFitter_Sprt)
+{
+  const std::size_t numPoints = 1000;
+  const double outlierRatio = .7;
+  const double gaussianNoiseLevel = 0.01;
+  const std::size_t numTrials = 10;
+
+  Vec2 GTModel;
+  GTModel << -2, .3;
+
+  std::mt19937 gen;
+
+  for(std::size_t trial = 0; trial < numTrials; ++trial)
+  {
+    Mat2X xy(2, numPoints);
+    vector<std::size_t> vec_inliersGT;
+    generateLine(numPoints, outlierRatio, gaussianNoiseLevel, GTModel, gen, xy, vec_inliersGT);
+
+    // the bad models are rejected early, the best one is still found
+    // (a few outliers may be close enough to the line)
+    LineKernelLoRansac kernel(xy);
+    std::vector<std::size_t> vec_inliers;
+    LO_RANSAC(kernel, ScoreEvaluator<LineKernel>(3 * gaussianNoiseLevel), &vec_inliers,
+              nullptr, false, 100, 1e-2, nullptr, true);
+    BOOST_CHECK_GE(vec_inliers.size(), vec_inliersGT.size());
+    BOOST_CHECK_LE(vec_inliers.size(), vec_inliersGT.size() + 5);
+  }
+}
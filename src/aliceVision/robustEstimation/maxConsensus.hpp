@@ -8,6 +8,8 @@
 #pragma once
 
 #include "aliceVision/robustEstimation/randSampling.hpp"
+#include "aliceVision/robustEstimation/sprt.hpp"
+#include <memory>
 #include <limits>
 #include <vector>
 
@@ -29,10 +31,14 @@ namespace robustEstimation{
 /// 2. Kernel::MINIMUM_SAMPLES
 /// 3. Kernel::Fit(vector<int>, vector<Kernel::Model> *)
 /// 4. Kernel::Error(Model, int) -> error
+///
+/// With useSprt, the models unlikely to have more inliers than the best one
+/// are rejected before the end of their verification (SPRT).
 template<typename Kernel, typename Scorer>
 typename Kernel::Model MaxConsensus(const Kernel &kernel,
   const Scorer &scorer,
-  std::vector<std::size_t> *best_inliers = nullptr, std::size_t max_iteration = 1024) {
+  std::vector<std::size_t> *best_inliers = nullptr, std::size_t max_iteration = 1024,
+  bool useSprt = false) {
 
     const std::size_t min_samples = Kernel::MINIMUM_SAMPLES;
     const std::size_t total_samples = kernel.NumSamples();
@@ -58,17 +64,27 @@ typename Kernel::Model MaxConsensus(const Kernel &kernel,
       all_samples.push_back(i);
     }
 
+    std::unique_ptr<SprtTest> sprt;
+    if (useSprt)
+      sprt.reset(new SprtTest(total_samples));
+
+    // the models of each sample, reused to avoid allocations in the main loop
+    std::vector<typename Kernel::Model> models;
+
     for(std::size_t iteration = 0;  iteration < max_iteration; ++iteration) 
     {
       std::vector<std::size_t> sample;
       UniformSample(min_samples, total_samples, sample);
 
-      std::vector<typename Kernel::Model> models;
+      models.clear();
       kernel.Fit(sample, &models);
 
       // Compute costs for each fit.
       for(std::size_t i = 0; i < models.size(); ++i) 
       {
+        if (sprt && !sprt->verify([&](std::size_t j) { return kernel.Error(j, models[i]) < scorer.getThreshold(); }))
+          continue;
+
         std::vector<std::size_t> inliers;
         scorer.Score(kernel, models[i], all_samples, &inliers);
 
@@ -78,6 +94,8 @@ typename Kernel::Model MaxConsensus(const Kernel &kernel,
           //  << ", number of inliers: " << inliers.size());
           best_num_inliers = inliers.size();
           best_model = models[i];
+          if (sprt)
+            sprt->setBestInlierRatio(best_num_inliers / static_cast<double>(total_samples));
           if (best_inliers) 
           {
             best_inliers->swap(inliers);
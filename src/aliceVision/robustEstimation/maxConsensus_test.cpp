@@ -11,6 +11,8 @@
 
 #include "aliceVision/numeric/numeric.hpp"
 
+#include <random>
+
 #define BOOST_TEST_MODULE maxConsensus
 #include <boost/test/included/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
@@ -126,3 +128,33 @@ BOOST_AUTO_TEST_CASE(MaxConsensusLineFitter_RealisticCase) {
   BOOST_CHECK_SMALL((-2.0)-model[0], 1e-9);
   BOOST_CHECK_SMALL( 6.3-model[1], 1e-9);
 }
+
+// Check that the early rejection of the bad models (SPRT) keeps the best model
+BOOST_AUTO_TEST_CASE(MaxConsensusLineFitter_Sprt) {
+
+  const int numPoints = 1000;
+  const int numInliers = 200;
+  Mat2X xy(2, numPoints);
+
+  Vec2 GTModel;
+  GTModel <<  -2.0, 6.3;
+
+  std::mt19937 gen;
+  std::uniform_real_distribution<> pos(0, numPoints);
+  for(Mat::Index i = 0; i < numPoints; ++i)
+  {
+    if(i < numInliers)
+      xy.col(i) << i, (double)i*GTModel[1] + GTModel[0];
+    else
+      xy.col(i) << pos(gen), pos(gen)*GTModel[1];
+  }
+
+  seedRandomNumberGenerator(0);
+  LineKernel kernel(xy);
+  std::vector<size_t> vec_inliers;
+  Vec2 model = MaxConsensus(kernel,
+    ScoreEvaluator<LineKernel>(0.3), &vec_inliers, 1024, true);
+  BOOST_CHECK(vec_inliers.size() >= numInliers);
+  BOOST_CHECK_SMALL((-2.0)-model[0], 1e-6);
+  BOOST_CHECK_SMALL( 6.3-model[1], 1e-6);
+}
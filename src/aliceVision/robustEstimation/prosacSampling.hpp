@@ -0,0 +1,124 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/robustEstimation/randSampling.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace aliceVision {
+namespace robustEstimation {
+
+/**
+ * @brief Sort the data indices from the best to the worst quality.
+ * @param[in] scores The score of each data, the lower the better (e.g. the Lowe ratio of a match)
+ * @return the indices of the data by increasing score (ties keep the data order)
+ */
+template<typename T>
+inline std::vector<std::size_t> sortByQuality(const std::vector<T>& scores)
+{
+  std::vector<std::size_t> sortedIndices(scores.size());
+  std::iota(sortedIndices.begin(), sortedIndices.end(), 0);
+  std::stable_sort(sortedIndices.begin(), sortedIndices.end(),
+                   [&scores](std::size_t a, std::size_t b) { return scores[a] < scores[b]; });
+  return sortedIndices;
+}
+
+/**
+ * @brief Progressive sampling of the data sorted by quality (PROSAC).
+ *
+ * The samples are drawn from a growing set of the best data, so good hypotheses
+ * are drawn first. After maxIterations samples the whole data set is used and
+ * the sampling is the same as the uniform sampling of RANSAC.
+ *
+ * Ondrej Chum, Jiri Matas:
+ * Matching with PROSAC - Progressive Sample Consensus. CVPR 2005: 220-226
+ */
+class ProsacSampler
+{
+public:
+  /**
+   * @param[in] sampleSize The size of the samples
+   * @param[in] sortedIndices The data indices sorted from the best to the worst quality
+   * @param[in] maxIterations The number of samples after which the whole data set is used (T_N)
+   */
+  ProsacSampler(std::size_t sampleSize,
+                const std::vector<std::size_t>& sortedIndices,
+                std::size_t maxIterations)
+    : _sampleSize(sampleSize)
+    , _sortedIndices(sortedIndices)
+    , _n(sampleSize)
+  {
+    assert(sampleSize <= sortedIndices.size());
+
+    // average number of samples drawn only from the sampleSize best data
+    const std::size_t nbData = sortedIndices.size();
+    _tn = static_cast<double>(std::max<std::size_t>(maxIterations, 1));
+    for(std::size_t i = 0; i < sampleSize; ++i)
+      _tn *= static_cast<double>(sampleSize - i) / static_cast<double>(nbData - i);
+  }
+
+  /**
+   * @brief Draw the next sample.
+   * @param[out] sample The data indices of the sample
+   */
+  void sample(std::vector<std::size_t>& sample)
+  {
+    ++_t;
+
+    // grow the set of the best data
+    if(_t > _tnPrime && _n < _sortedIndices.size())
+    {
+      // T'_n is rounded from T_n rather than from the rounded increments of the paper,
+      // so the rounding errors do not delay the use of the whole data set
+      _tn *= static_cast<double>(_n + 1) / static_cast<double>(_n + 1 - _sampleSize);
+      _tnPrime = static_cast<std::size_t>(std::ceil(_tn));
+      ++_n;
+    }
+
+    if(_tnPrime < _t)
+    {
+      // the whole data set is used or the set grows late, uniform sampling among the _n best data
+      UniformSample(_sampleSize, _n, sample);
+    }
+    else
+    {
+      // the last data of the set and sampleSize - 1 data among the better ones
+      UniformSample(_sampleSize - 1, _n - 1, sample);
+      sample.push_back(_n - 1);
+    }
+
+    for(std::size_t& s : sample)
+      s = _sortedIndices[s];
+  }
+
+  /// The number of best data the samples are currently drawn from
+  std::size_t getSetSize() const
+  {
+    return _n;
+  }
+
+private:
+  const std::size_t _sampleSize;
+  const std::vector<std::size_t>& _sortedIndices;
+  /// size of the set of the best data
+  std::size_t _n;
+  /// number of samples drawn
+  std::size_t _t = 0;
+  /// average number of samples drawn from the _n best data (T_n)
+  double _tn = 0.0;
+  /// number of samples after which the set grows (T'_n)
+  std::size_t _tnPrime = 1;
+};
+
+} // namespace robustEstimation
+} // namespace aliceVision
@@ -13,10 +13,30 @@
 #include <cstdlib>
 #include <random>
 #include <cassert>
+#include <cstdint>
 
 namespace aliceVision {
 namespace robustEstimation{
 
+/**
+ * @brief Random number generator used for sampling, one per thread.
+ * It is seeded from std::random_device the first time it is used in a thread,
+ * use seedRandomNumberGenerator to get reproducible samples.
+ */
+inline std::mt19937& randomNumberGenerator()
+{
+  thread_local std::mt19937 generator(std::random_device{}());
+  return generator;
+}
+
+/**
+ * @brief Seed the random number generator of the current thread.
+ * @param[in] seed The seed.
+ */
+inline void seedRandomNumberGenerator(std::uint32_t seed)
+{
+  randomNumberGenerator().seed(seed);
+}
 
 /**
  * @brief Generate a unique random samples without replacement in the 
@@ -44,9 +64,8 @@ inline std::vector<IntT> randSample(IntT lowerBound,
   assert(numSamples <= rangeSize);
   static_assert(std::is_integral<IntT>::value, "Only integer types are supported");
 
-  
-  std::random_device rd;
-  std::mt19937 generator(rd());
+
+  std::mt19937& generator = randomNumberGenerator();
 
   if(numSamples * 1.5 > rangeSize)
   {
@@ -6,6 +6,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/robustEstimation/randSampling.hpp"
+#include "aliceVision/robustEstimation/prosacSampling.hpp"
 #include <set>
 #include <vector>
 
@@ -111,3 +112,65 @@ BOOST_AUTO_TEST_CASE(UniformSampleTest_randSample) {
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(UniformSampleTest_seed) {
+
+  std::vector<std::vector<std::size_t>> firstRun;
+  seedRandomNumberGenerator(42);
+  for(std::size_t i = 0; i < 10; ++i)
+  {
+    std::vector<std::size_t> samples;
+    UniformSample(7, 100, samples);
+    firstRun.push_back(samples);
+  }
+
+  // same seed, same samples
+  seedRandomNumberGenerator(42);
+  for(std::size_t i = 0; i < 10; ++i)
+  {
+    std::vector<std::size_t> samples;
+    UniformSample(7, 100, samples);
+    BOOST_CHECK(samples == firstRun[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ProsacSamplerTest_sortByQuality) {
+
+  const std::vector<float> ratios = {0.8f, 0.2f, 0.5f, 0.2f, 0.9f};
+  const std::vector<std::size_t> expected = {1, 3, 2, 0, 4};
+  BOOST_CHECK(sortByQuality(ratios) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(ProsacSamplerTest_progressive) {
+
+  const std::size_t sampleSize = 4;
+  const std::size_t nbData = 200;
+  const std::size_t maxIterations = 1000;
+
+  // the best data are the last ones
+  std::vector<std::size_t> sortedIndices(nbData);
+  for(std::size_t i = 0; i < nbData; ++i)
+    sortedIndices[i] = nbData - 1 - i;
+
+  ProsacSampler sampler(sampleSize, sortedIndices, maxIterations);
+  std::size_t previousSetSize = sampleSize;
+  for(std::size_t t = 0; t < maxIterations; ++t)
+  {
+    std::vector<std::size_t> sample;
+    sampler.sample(sample);
+    const std::size_t setSize = sampler.getSetSize();
+
+    BOOST_CHECK_EQUAL(sample.size(), sampleSize);
+    BOOST_CHECK(setSize >= previousSetSize);
+    previousSetSize = setSize;
+
+    // no repetition, only the best data of the set
+    const std::set<std::size_t> uniqueSamples(sample.begin(), sample.end());
+    BOOST_CHECK_EQUAL(uniqueSamples.size(), sampleSize);
+    for(const auto& s : sample)
+      BOOST_CHECK(s >= nbData - setSize);
+  }
+
+  // the whole data set is used at the end
+  BOOST_CHECK_EQUAL(sampler.getSetSize(), nbData);
+}
@@ -0,0 +1,155 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/robustEstimation/randSampling.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace aliceVision {
+namespace robustEstimation {
+
+/**
+ * @brief Sequential probability ratio test (SPRT) for the early rejection of bad models.
+ *
+ * The data are verified in a random order and the verification of a model stops as soon as
+ * the likelihood ratio between a bad and a good model exceeds the decision threshold.
+ * The probabilities of a data to be consistent with a good model (epsilon) and
+ * with a bad model (delta) are estimated during the robust estimation.
+ *
+ * Ondrej Chum, Jiri Matas:
+ * Optimal Randomized RANSAC. IEEE PAMI 30(8): 1472-1482 (2008)
+ */
+class SprtTest
+{
+public:
+  /**
+   * @param[in] nbData The number of data
+   * @param[in] modelsPerSample The average number of models computed from one sample (m_S)
+   * @param[in] modelTime The time to compute the models of one sample, in data verifications (t_M)
+   * @param[in] epsilon The initial probability of a data to be consistent with a good model
+   * @param[in] delta The initial probability of a data to be consistent with a bad model
+   */
+  explicit SprtTest(std::size_t nbData,
+                    double modelsPerSample = 1.0,
+                    double modelTime = 200.0,
+                    double epsilon = 0.1,
+                    double delta = 0.01)
+    : _order(nbData)
+    , _modelsPerSample(std::max(modelsPerSample, 1.0))
+    , _modelTime(modelTime)
+    , _epsilon(epsilon)
+    , _delta(delta)
+  {
+    std::iota(_order.begin(), _order.end(), 0);
+    std::shuffle(_order.begin(), _order.end(), randomNumberGenerator());
+    updateThreshold();
+  }
+
+  /**
+   * @brief Verify a model on the data, one data after the other until it is rejected.
+   * @param[in] isConsistent Functor (std::size_t index) -> bool, true if the data is consistent with the model
+   * @return true if the model is not rejected, all the data have then been verified
+   */
+  template<typename IsConsistent>
+  bool verify(IsConsistent isConsistent)
+  {
+    const bool enabled = (_epsilon > _delta);
+    const double consistentRatio = _delta / _epsilon;
+    const double inconsistentRatio = (1.0 - _delta) / (1.0 - _epsilon);
+
+    double lambda = 1.0;
+    std::size_t nbConsistent = 0;
+    for(std::size_t j = 0; j < _order.size(); ++j)
+    {
+      if(isConsistent(_order[j]))
+      {
+        ++nbConsistent;
+        lambda *= consistentRatio;
+      }
+      else
+      {
+        lambda *= inconsistentRatio;
+      }
+
+      if(enabled && lambda > _threshold)
+      {
+        // the model is bad, update the estimate of delta (the initial value counts as one model)
+        ++_nbRejected;
+        _delta += (static_cast<double>(nbConsistent) / static_cast<double>(j + 1) - _delta) / static_cast<double>(_nbRejected + 1);
+        _delta = std::max(_delta, 1e-4);
+        updateThreshold();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Update the probability of a data to be consistent with a good model.
+   * @param[in] inlierRatio The inlier ratio of the best model so far
+   */
+  void setBestInlierRatio(double inlierRatio)
+  {
+    if(inlierRatio <= 0.0 || inlierRatio >= 1.0)
+      return;
+    _epsilon = inlierRatio;
+    updateThreshold();
+  }
+
+  /// The number of models rejected so far
+  std::size_t getNbRejected() const
+  {
+    return _nbRejected;
+  }
+
+  /// The decision threshold on the likelihood ratio (A)
+  double getThreshold() const
+  {
+    return _threshold;
+  }
+
+private:
+  /// Compute the optimal decision threshold A with the fixed point iteration of the paper
+  void updateThreshold()
+  {
+    if(_epsilon <= _delta)
+    {
+      _threshold = 1.0;
+      return;
+    }
+
+    // expected information of a verification (C)
+    const double c = (1.0 - _delta) * std::log((1.0 - _delta) / (1.0 - _epsilon)) + _delta * std::log(_delta / _epsilon);
+    const double k = _modelTime * c / _modelsPerSample + 1.0;
+
+    _threshold = k;
+    for(int i = 0; i < 10; ++i)
+    {
+      const double next = k + std::log(_threshold);
+      if(std::abs(next - _threshold) < 1e-6)
+        break;
+      _threshold = next;
+    }
+  }
+
+  /// random verification order of the data
+  std::vector<std::size_t> _order;
+  const double _modelsPerSample;
+  const double _modelTime;
+  double _epsilon;
+  double _delta;
+  double _threshold = 1.0;
+  std::size_t _nbRejected = 0;
+};
+
+} // namespace robustEstimation
+} // namespace aliceVision
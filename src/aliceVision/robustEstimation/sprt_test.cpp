@@ -0,0 +1,57 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/robustEstimation/sprt.hpp"
+
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE sprt
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::robustEstimation;
+
+BOOST_AUTO_TEST_CASE(SprtTest_rejectBadModels) {
+
+  const std::size_t nbData = 10000;
+  seedRandomNumberGenerator(0);
+  SprtTest sprt(nbData);
+
+  // a good model with 10% of consistent data is verified on all the data
+  std::vector<bool> good(nbData);
+  for(std::size_t i = 0; i < nbData; ++i)
+    good[i] = (i % 10 == 0);
+  std::size_t nbVerified = 0;
+  BOOST_CHECK(sprt.verify([&](std::size_t i) { ++nbVerified; return good[i]; }));
+  BOOST_CHECK_EQUAL(nbVerified, nbData);
+  sprt.setBestInlierRatio(0.1);
+
+  // the bad models with 1% of consistent data are rejected after a few verifications
+  std::mt19937 generator(0);
+  std::bernoulli_distribution bad(0.01);
+  std::size_t nbRejected = 0;
+  nbVerified = 0;
+  for(int m = 0; m < 100; ++m)
+  {
+    if(!sprt.verify([&](std::size_t) { ++nbVerified; return bad(generator); }))
+      ++nbRejected;
+  }
+  BOOST_CHECK_GE(nbRejected, 95);
+  BOOST_CHECK_LT(nbVerified, 100 * nbData / 50);
+  BOOST_CHECK_EQUAL(sprt.getNbRejected(), nbRejected);
+  BOOST_CHECK_GT(sprt.getThreshold(), 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(SprtTest_disabled) {
+
+  // no test when a bad model is as consistent as a good one
+  SprtTest sprt(100, 1.0, 200.0, 0.01, 0.01);
+  std::size_t nbVerified = 0;
+  BOOST_CHECK(sprt.verify([&](std::size_t) { ++nbVerified; return false; }));
+  BOOST_CHECK_EQUAL(nbVerified, 100);
+}
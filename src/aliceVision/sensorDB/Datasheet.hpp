@@ -40,5 +40,12 @@ struct Datasheet
   double _sensorSize;
 };
 
+/**
+ * @brief Normalize a brand or model name for the datasheets comparison
+ * @param[in] name The brand or model name
+ * @return The name in lower case, without punctuation and spaces
+ */
+std::string normalizeName(const std::string& name);
+
 } // namespace sensorDB
 } // namespace aliceVision
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <fstream>
 #include <iterator>
+#include <limits>
 
 namespace fs = boost::filesystem;
 
@@ -66,5 +67,85 @@ bool getInfo(const std::string& brand, const std::string& model, const std::vect
   return true;
 }
 
+DatabaseIndex::DatabaseIndex(const std::vector<Datasheet>& databaseStructure)
+  : _datasheets(databaseStructure)
+{
+  std::unordered_map<std::string, std::size_t> brandIndexes;
+
+  for(std::size_t i = 0; i < _datasheets.size(); ++i)
+  {
+    const std::string brandName = normalizeName(_datasheets[i]._brand);
+    const auto brandIt = brandIndexes.emplace(brandName, _brands.size()).first;
+
+    if(brandIt->second == _brands.size())
+    {
+      _brands.emplace_back();
+      _brands.back().name = brandName;
+    }
+    _brands.at(brandIt->second).models.emplace_back(normalizeName(_datasheets[i]._model), i);
+  }
+}
+
+bool DatabaseIndex::getInfo(const std::string& brand, const std::string& model, Datasheet& datasheetContent) const
+{
+  const std::size_t noDatasheet = std::numeric_limits<std::size_t>::max();
+
+  const std::string brandB = normalizeName(brand);
+  const std::string modelB = normalizeName(model);
+  const std::string query = brandB + '\n' + modelB;
+
+  std::size_t datasheetIndex = noDatasheet;
+  bool isKnownQuery = false;
+  {
+    std::lock_guard<std::mutex> lock(_queriesMutex);
+    const auto queryIt = _queries.find(query);
+    if(queryIt != _queries.end())
+    {
+      isKnownQuery = true;
+      datasheetIndex = queryIt->second;
+    }
+  }
+
+  if(!isKnownQuery)
+  {
+    // first matching datasheet in the database order, with the rules of Datasheet::operator==
+    for(const Brand& brandA : _brands)
+    {
+      if((brandA.name != brandB) &&
+         !boost::algorithm::starts_with(brandA.name, brandB) &&
+         !boost::algorithm::starts_with(brandB, brandA.name))
+        continue;
+
+      for(const auto& modelA : brandA.models)
+      {
+        if(modelA.second >= datasheetIndex)
+          break; // the models are in the database order
+
+        if((modelA.first == modelB) ||
+           (boost::algorithm::ends_with(modelA.first, modelB)) ||
+           (boost::algorithm::ends_with(modelB, modelA.first)))
+        {
+          datasheetIndex = modelA.second;
+          break;
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(_queriesMutex);
+    _queries.emplace(query, datasheetIndex);
+  }
+
+  if(datasheetIndex == noDatasheet)
+    return false;
+
+  datasheetContent = _datasheets.at(datasheetIndex);
+  return true;
+}
+
+bool getInfo(const std::string& brand, const std::string& model, const DatabaseIndex& databaseIndex, Datasheet& datasheetContent)
+{
+  return databaseIndex.getInfo(brand, model, datasheetContent);
+}
+
 } // namespace sensorDB
 } // namespace aliceVision
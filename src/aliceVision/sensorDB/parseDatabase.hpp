@@ -11,6 +11,9 @@
 
 #include <vector>
 #include <string>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
 
 namespace aliceVision {
 namespace sensorDB {
@@ -33,5 +36,62 @@ bool parseDatabase(const std::string& databaseFilePath, std::vector<Datasheet>&
  */
 bool getInfo(const std::string& brand, const std::string& model, const std::vector<Datasheet>& databaseStructure, Datasheet& datasheetContent);
 
+/**
+ * @brief Sensor database indexed by normalized brand
+ *
+ * The names of the datasheets are normalized once and the models are grouped by brand,
+ * so a query is only compared to the models of the matching brands.
+ * The results are kept by normalized brand / model, the next identical queries are a hash lookup.
+ * It gives the same datasheet as the linear search of getInfo().
+ * @note getInfo() is thread safe
+ */
+class DatabaseIndex
+{
+public:
+  DatabaseIndex() = default;
+
+  /**
+   * @brief Build the index of a database
+   * @param[in] databaseStructure The database in memory
+   */
+  explicit DatabaseIndex(const std::vector<Datasheet>& databaseStructure);
+
+  /**
+   * @brief Get information for the given camera brand / model
+   * @param[in] brand The camera brand
+   * @param[in] model The camera model
+   * @param[out] datasheetContent The corresponding datasheet
+   * @return True if ok
+   */
+  bool getInfo(const std::string& brand, const std::string& model, Datasheet& datasheetContent) const;
+
+private:
+
+  /// Normalized brand and its normalized models with their datasheet index
+  struct Brand
+  {
+    std::string name;
+    std::vector<std::pair<std::string, std::size_t>> models;
+  };
+
+  /// Datasheets in the database order
+  std::vector<Datasheet> _datasheets;
+  /// Brands in the order of their first datasheet
+  std::vector<Brand> _brands;
+  /// Datasheet index of the previous queries by normalized brand / model
+  mutable std::unordered_map<std::string, std::size_t> _queries;
+  mutable std::mutex _queriesMutex;
+};
+
+/**
+ * @brief Get information for the given camera brand / model
+ * @param[in] brand The camera brand
+ * @param[in] model The camera model
+ * @param[in] databaseIndex The indexed database
+ * @param[out] datasheetContent The corresponding datasheet
+ * @return True if ok
+ */
+bool getInfo(const std::string& brand, const std::string& model, const DatabaseIndex& databaseIndex, Datasheet& datasheetContent);
+
 } // namespace sensorDB
 } // namespace aliceVision
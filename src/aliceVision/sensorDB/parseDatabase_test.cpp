@@ -111,3 +111,42 @@ BOOST_AUTO_TEST_CASE(ParseDatabaseCanon_EOS_1100D)
   BOOST_CHECK( getInfo( sBrand, sModel, vec_database, datasheet ) );
   BOOST_CHECK_EQUAL( 22.2, datasheet._sensorSize );
 }
+
+BOOST_AUTO_TEST_CASE(DatabaseIndexSameAsLinearSearch)
+{
+  std::vector<Datasheet> vec_database;
+  BOOST_CHECK( parseDatabase( sDatabase, vec_database ) );
+
+  const DatabaseIndex databaseIndex(vec_database);
+
+  const std::vector<std::pair<std::string, std::string>> queries = {
+    {"Canon", "Canon PowerShot SD900"},
+    {"Canon", "Canon EOS 5D Mark II"},
+    {"CANON", "eos 550d"},
+    {"Canon Inc.", "EOS 1100D"},
+    {"NIKON CORPORATION", "NIKON D800"},
+    {"SONY", "ILCE-7RM2"},
+    {"NotExistBrand", "NotExistModel"},
+    {"", ""}
+  };
+
+  // twice: the second queries are found in the index queries
+  for(int pass = 0; pass < 2; ++pass)
+  {
+    for(const auto& query : queries)
+    {
+      Datasheet linearDatasheet;
+      Datasheet indexDatasheet;
+      const bool linearFound = getInfo( query.first, query.second, vec_database, linearDatasheet );
+      const bool indexFound = getInfo( query.first, query.second, databaseIndex, indexDatasheet );
+
+      BOOST_CHECK_EQUAL( linearFound, indexFound );
+      if(linearFound && indexFound)
+      {
+        BOOST_CHECK_EQUAL( linearDatasheet._brand, indexDatasheet._brand );
+        BOOST_CHECK_EQUAL( linearDatasheet._model, indexDatasheet._model );
+        BOOST_CHECK_EQUAL( linearDatasheet._sensorSize, indexDatasheet._sensorSize );
+      }
+    }
+  }
+}
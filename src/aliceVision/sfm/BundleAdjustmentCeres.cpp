@@ -7,15 +7,21 @@
 
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/track/ConcurrentUnionFind.hpp>
+#include <aliceVision/multiview/triangulation/Triangulation.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 
 #include <boost/filesystem.hpp>
 
 #include <ceres/rotation.h>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 
 namespace fs = boost::filesystem;
@@ -30,10 +36,24 @@ using namespace aliceVision::geometry;
  * @brief Create the appropriate cost functor according the provided input camera intrinsic model
  * @param[in] intrinsicPtr The intrinsic pointer
  * @param[in] observation The corresponding observation
+ * @param[in] useAnalyticJacobian Use the analytic cost function of the camera model if it exists
  * @return cost functor
  */
-ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const Vec2& observation)
+ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intrinsicPtr, const Vec2& observation, bool useAnalyticJacobian)
 {
+  if(useAnalyticJacobian)
+  {
+    switch(intrinsicPtr->getType())
+    {
+      case PINHOLE_CAMERA_RADIAL3:
+        return new ResidualErrorCostFunction_PinholeRadialK3(observation.data());
+      case PINHOLE_CAMERA_BROWN:
+        return new ResidualErrorCostFunction_PinholeBrownT2(observation.data());
+      default:
+        break; // no analytic cost function, use the autodiff one
+    }
+  }
+
   switch(intrinsicPtr->getType())
   {
     case PINHOLE_CAMERA:
@@ -83,34 +103,41 @@ ceres::CostFunction* createRigCostFunctionFromIntrinsics(const IntrinsicBase* in
 void BundleAdjustmentCeres::CeresOptions::setDenseBA()
 {
   // default configuration use a DENSE representation
+  useAutoLinearSolver = false;
   preconditionerType = ceres::JACOBI;
   linearSolverType = ceres::DENSE_SCHUR;
   sparseLinearAlgebraLibraryType = ceres::SUITE_SPARSE; // not used but just to avoid a warning in ceres
   ALICEVISION_LOG_DEBUG("BundleAdjustment[Ceres]: DENSE_SCHUR");
 }
 
-void BundleAdjustmentCeres::CeresOptions::setSparseBA()
+/**
+ * @brief Find the most efficient sparse linear algebra library available
+ * @param[out] sparseLinearAlgebraLibraryType The sparse linear algebra library
+ * @return false if no sparse linear algebra library is available
+ */
+bool getSparseLinearAlgebraLibrary(ceres::SparseLinearAlgebraLibraryType& sparseLinearAlgebraLibraryType)
 {
-  preconditionerType = ceres::JACOBI;
-  // if Sparse linear solver are available
   // descending priority order by efficiency (SUITE_SPARSE > CX_SPARSE > EIGEN_SPARSE)
-  if (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE))
+  for(const ceres::SparseLinearAlgebraLibraryType type : {ceres::SUITE_SPARSE, ceres::CX_SPARSE, ceres::EIGEN_SPARSE})
   {
-    sparseLinearAlgebraLibraryType = ceres::SUITE_SPARSE;
-    linearSolverType = ceres::SPARSE_SCHUR;
-    ALICEVISION_LOG_DEBUG("BundleAdjustment[Ceres]: SPARSE_SCHUR, SUITE_SPARSE");
-  }
-  else if (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::CX_SPARSE))
-  {
-    sparseLinearAlgebraLibraryType = ceres::CX_SPARSE;
-    linearSolverType = ceres::SPARSE_SCHUR;
-    ALICEVISION_LOG_DEBUG("BundleAdjustment[Ceres]: SPARSE_SCHUR, CX_SPARSE");
+    if(ceres::IsSparseLinearAlgebraLibraryTypeAvailable(type))
+    {
+      sparseLinearAlgebraLibraryType = type;
+      return true;
+    }
   }
-  else if (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::EIGEN_SPARSE))
+  return false;
+}
+
+void BundleAdjustmentCeres::CeresOptions::setSparseBA()
+{
+  useAutoLinearSolver = false;
+  preconditionerType = ceres::JACOBI;
+  // if Sparse linear solver are available
+  if(getSparseLinearAlgebraLibrary(sparseLinearAlgebraLibraryType))
   {
-    sparseLinearAlgebraLibraryType = ceres::EIGEN_SPARSE;
     linearSolverType = ceres::SPARSE_SCHUR;
-    ALICEVISION_LOG_DEBUG("BundleAdjustment[Ceres]: SPARSE_SCHUR, EIGEN_SPARSE");
+    ALICEVISION_LOG_DEBUG("BundleAdjustment[Ceres]: SPARSE_SCHUR, " << ceres::SparseLinearAlgebraLibraryTypeToString(sparseLinearAlgebraLibraryType));
   }
   else
   {
@@ -119,6 +146,13 @@ void BundleAdjustmentCeres::CeresOptions::setSparseBA()
   }
 }
 
+void BundleAdjustmentCeres::CeresOptions::setAutoBA()
+{
+  // dense BA until the problem is known
+  setDenseBA();
+  useAutoLinearSolver = true;
+}
+
 bool BundleAdjustmentCeres::Statistics::exportToFile(const std::string& folder, const std::string& filename) const
 {
   std::ofstream os;
@@ -141,7 +175,8 @@ bool BundleAdjustmentCeres::Statistics::exportToFile(const std::string& folder,
           "ResidualBlocks;SuccessIteration;BadIteration;"
           "InitRMSE;FinalRMSE;"
           "d=-1;d=0;d=1;d=2;d=3;d=4;"
-          "d=5;d=6;d=7;d=8;d=9;d=10+;\n";
+          "d=5;d=6;d=7;d=8;d=9;d=10+;"
+          "LinearSolver;Preconditioner;Time/LinearSolver(s);Time/Evaluation(s);\n";
   }
 
   std::map<EParameter, std::map<EParameterState, std::size_t>> states = parametersStates;
@@ -176,7 +211,11 @@ bool BundleAdjustmentCeres::Statistics::exportToFile(const std::string& folder,
          os << "0;";
      }
 
-     os << posesWithDistUpperThanTen << ";\n";
+     os << posesWithDistUpperThanTen << ";"
+        << ceres::LinearSolverTypeToString(linearSolverType) << ";"
+        << ceres::PreconditionerTypeToString(preconditionerType) << ";"
+        << linearSolverTime << ";"
+        << evaluationTime << ";\n";
 
   os.close();
   return true;
@@ -221,6 +260,10 @@ void BundleAdjustmentCeres::Statistics::show() const
   ALICEVISION_LOG_INFO("Bundle Adjustment Statistics:\n"
                         << ss.str()
                         << "\t- adjustment duration: " << time << " s\n"
+                        << "\t    - linear solver: " << linearSolverTime << " s\n"
+                        << "\t    - residuals and jacobians evaluation: " << evaluationTime << " s\n"
+                        << "\t- linear solver: " << ceres::LinearSolverTypeToString(linearSolverType)
+                        << " (" << ceres::PreconditionerTypeToString(preconditionerType) << ")\n"
                         << "\t- poses:\n"
                         << "\t    - # refined:  " << states[EParameter::POSE][EParameterState::REFINED]  << "\n"
                         << "\t    - # constant: " << states[EParameter::POSE][EParameterState::CONSTANT] << "\n"
@@ -229,6 +272,7 @@ void BundleAdjustmentCeres::Statistics::show() const
                         << "\t    - # refined:  " << states[EParameter::LANDMARK][EParameterState::REFINED]  << "\n"
                         << "\t    - # constant: " << states[EParameter::LANDMARK][EParameterState::CONSTANT] << "\n"
                         << "\t    - # ignored:  " << states[EParameter::LANDMARK][EParameterState::IGNORED]  << "\n"
+                        << "\t    - # retriangulated: " << nbRetriangulatedLandmarks << "\n"
                         << "\t- intrinsics:\n"
                         << "\t    - # refined:  " << states[EParameter::INTRINSIC][EParameterState::REFINED]  << "\n"
                         << "\t    - # constant: " << states[EParameter::INTRINSIC][EParameterState::CONSTANT] << "\n"
@@ -261,6 +305,145 @@ void BundleAdjustmentCeres::setSolverOptions(ceres::Solver::Options& solverOptio
   }
 }
 
+void BundleAdjustmentCeres::selectLinearSolver(const ceres::Problem& problem, ceres::Solver::Options& solverOptions) const
+{
+  std::map<EParameter, std::map<EParameterState, std::size_t>> states = _statistics.parametersStates;
+  const std::size_t nbRefinedPoses = states[EParameter::POSE][EParameterState::REFINED];
+  const std::size_t nbRefinedIntrinsics = states[EParameter::INTRINSIC][EParameterState::REFINED];
+  const std::size_t nbRefinedLandmarks = states[EParameter::LANDMARK][EParameterState::REFINED];
+  const std::size_t nbObservations = static_cast<std::size_t>(problem.NumResidualBlocks());
+
+  // size of the reduced camera system (upper bound, all the intrinsics blocks are counted if one is refined)
+  std::size_t nbCameraParameters = 6 * nbRefinedPoses;
+  if(nbRefinedIntrinsics > 0)
+  {
+    for(const auto& intrinsicBlockPair : _intrinsicsBlocks)
+      nbCameraParameters += intrinsicBlockPair.second.size();
+  }
+
+  ceres::SparseLinearAlgebraLibraryType sparseLibrary = ceres::SUITE_SPARSE;
+  const bool isSparseAvailable = getSparseLinearAlgebraLibrary(sparseLibrary);
+
+  solverOptions.preconditioner_type = ceres::JACOBI;
+
+  if(nbRefinedLandmarks == 0)
+  {
+    // no landmark to eliminate, the Schur complement doesn't apply
+    solverOptions.linear_solver_type = (isSparseAvailable && nbCameraParameters > _ceresOptions.autoDenseMaxCameraParameters) ? ceres::SPARSE_NORMAL_CHOLESKY : ceres::DENSE_QR;
+    solverOptions.linear_solver_ordering.reset();
+  }
+  else if(nbCameraParameters <= _ceresOptions.autoDenseMaxCameraParameters || !isSparseAvailable)
+  {
+    solverOptions.linear_solver_type = ceres::DENSE_SCHUR;
+  }
+  else if(nbRefinedPoses <= _ceresOptions.autoSparseMaxPoses)
+  {
+    solverOptions.linear_solver_type = ceres::SPARSE_SCHUR;
+  }
+  else
+  {
+    // the reduced camera system is too large to be factorized, use a preconditioned conjugate gradients
+    solverOptions.linear_solver_type = ceres::ITERATIVE_SCHUR;
+    solverOptions.preconditioner_type = (sparseLibrary == ceres::SUITE_SPARSE) ? ceres::CLUSTER_JACOBI : ceres::SCHUR_JACOBI;
+  }
+
+  solverOptions.sparse_linear_algebra_library_type = sparseLibrary;
+
+  ALICEVISION_LOG_DEBUG("BundleAdjustment[Ceres]: automatic linear solver selection:\n"
+                        << "\t- # refined poses: " << nbRefinedPoses << "\n"
+                        << "\t- # refined intrinsics: " << nbRefinedIntrinsics << "\n"
+                        << "\t- # refined landmarks: " << nbRefinedLandmarks << "\n"
+                        << "\t- # observations: " << nbObservations << "\n"
+                        << "\t- linear solver: " << ceres::LinearSolverTypeToString(solverOptions.linear_solver_type) << "\n"
+                        << "\t- preconditioner: " << ceres::PreconditionerTypeToString(solverOptions.preconditioner_type) << "\n"
+                        << "\t- sparse library: " << (isSparseAvailable ? ceres::SparseLinearAlgebraLibraryTypeToString(sparseLibrary) : "none"));
+}
+
+void BundleAdjustmentCeres::resetProblem()
+{
+  _statistics = Statistics();
+
+  _allParametersBlocks.clear();
+  _posesBlocks.clear();
+  _intrinsicsBlocks.clear();
+  _landmarksBlocks.clear();
+  _rigBlocks.clear();
+  _constantParametersPerBlock.clear();
+  _observationsBlocks.clear();
+  _residualBlocksObservations.clear();
+
+  ceres::Problem::Options problemOptions;
+  // the loss function is shared by all the residual blocks of all the adjustments
+  problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+  // residual blocks are removed from the persistent problem
+  problemOptions.enable_fast_removal = _ceresOptions.usePersistentProblem;
+
+  _problem.reset(new ceres::Problem(problemOptions));
+  // set a LossFunction to be less penalized by false measurements.
+  _lossFunction.reset(new ceres::HuberLoss(Square(4.0))); // TODO: make the LOSS function and the parameter an option
+}
+
+void BundleAdjustmentCeres::addParameterBlock(double* parameterBlock, int size, const std::vector<int>& constantParameters, bool isConstant, ceres::Problem& problem)
+{
+  if(!isConstant && problem.HasParameterBlock(parameterBlock))
+  {
+    // the subset parameterization can't be changed, add the block again
+    const auto constantParametersIt = _constantParametersPerBlock.find(parameterBlock);
+    if(constantParametersIt != _constantParametersPerBlock.end() && constantParametersIt->second != constantParameters)
+      removeParameterBlock(parameterBlock, problem);
+  }
+
+  if(!problem.HasParameterBlock(parameterBlock))
+    problem.AddParameterBlock(parameterBlock, size);
+
+  if(isConstant)
+  {
+    // set the whole parameter block as constant.
+    problem.SetParameterBlockConstant(parameterBlock);
+    return;
+  }
+
+  problem.SetParameterBlockVariable(parameterBlock);
+
+  // subset parametrization
+  if(!constantParameters.empty() && _constantParametersPerBlock.find(parameterBlock) == _constantParametersPerBlock.end())
+  {
+    ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(size, constantParameters);
+    problem.SetParameterization(parameterBlock, subsetParameterization);
+    _constantParametersPerBlock[parameterBlock] = constantParameters;
+  }
+}
+
+void BundleAdjustmentCeres::removeParameterBlock(double* parameterBlock, ceres::Problem& problem)
+{
+  _constantParametersPerBlock.erase(parameterBlock);
+
+  if(!problem.HasParameterBlock(parameterBlock))
+    return;
+
+  // remove the residual blocks depending on the parameter block
+  std::vector<ceres::ResidualBlockId> residualBlocks;
+  problem.GetResidualBlocksForParameterBlock(parameterBlock, &residualBlocks);
+
+  for(const ceres::ResidualBlockId residualBlockId : residualBlocks)
+    removeResidualBlock(residualBlockId, problem);
+
+  problem.RemoveParameterBlock(parameterBlock);
+}
+
+void BundleAdjustmentCeres::removeResidualBlock(ceres::ResidualBlockId residualBlockId, ceres::Problem& problem)
+{
+  const auto observationIt = _residualBlocksObservations.find(residualBlockId);
+  if(observationIt != _residualBlocksObservations.end())
+  {
+    const auto landmarkIt = _observationsBlocks.find(observationIt->second.first);
+    if(landmarkIt != _observationsBlocks.end())
+      landmarkIt->second.erase(observationIt->second.second);
+    _residualBlocksObservations.erase(observationIt);
+  }
+  problem.RemoveResidualBlock(residualBlockId);
+}
+
 void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmData, BundleAdjustment::ERefineOptions refineOptions, ceres::Problem& problem)
 {
   const bool refineTranslation = refineOptions & BundleAdjustment::REFINE_TRANSLATION;
@@ -281,25 +464,18 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
     poseBlock.at(5) = t(2);
 
     double* poseBlockPtr = poseBlock.data();
-    problem.AddParameterBlock(poseBlockPtr, 6);
 
     // add pose parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(poseBlockPtr);
 
     // keep the camera extrinsics constants
-    if(cameraPose.isLocked() || isConstant || (!refineTranslation && !refineRotation))
-    {
-      // set the whole parameter block as constant.
-      _statistics.addState(EParameter::POSE, EParameterState::CONSTANT);
-      problem.SetParameterBlockConstant(poseBlockPtr);
-      return;
-    }
+    const bool isConstantBlock = (cameraPose.isLocked() || isConstant || (!refineTranslation && !refineRotation));
 
     // constant parameters
     std::vector<int> constantExtrinsic;
 
     // don't refine rotations
-    if(!refineRotation)
+    if(!isConstantBlock && !refineRotation)
     {
       constantExtrinsic.push_back(0);
       constantExtrinsic.push_back(1);
@@ -307,22 +483,47 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
     }
 
     // don't refine translations
-    if(!refineTranslation)
+    if(!isConstantBlock && !refineTranslation)
     {
       constantExtrinsic.push_back(3);
       constantExtrinsic.push_back(4);
       constantExtrinsic.push_back(5);
     }
 
-    // subset parametrization
-    if(!constantExtrinsic.empty())
+    addParameterBlock(poseBlockPtr, 6, constantExtrinsic, isConstantBlock, problem);
+
+    _statistics.addState(EParameter::POSE, isConstantBlock ? EParameterState::CONSTANT : EParameterState::REFINED);
+  };
+
+  // remove the poses no longer in the scene or set as Ignored in the Local strategy
+  for(auto poseBlockIt = _posesBlocks.begin(); poseBlockIt != _posesBlocks.end();)
+  {
+    if(sfmData.getPoses().count(poseBlockIt->first) && getPoseState(poseBlockIt->first) != EParameterState::IGNORED)
     {
-      ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(6, constantExtrinsic);
-      problem.SetParameterization(poseBlockPtr, subsetParameterization);
+      ++poseBlockIt;
+      continue;
     }
+    removeParameterBlock(poseBlockIt->second.data(), problem);
+    poseBlockIt = _posesBlocks.erase(poseBlockIt);
+  }
 
-    _statistics.addState(EParameter::POSE, EParameterState::REFINED);
-  };
+  // remove the rig sub-poses no longer in the scene
+  for(auto& rigBlocksPair : _rigBlocks)
+  {
+    const auto rigIt = sfmData.getRigs().find(rigBlocksPair.first);
+    for(auto subPoseBlockIt = rigBlocksPair.second.begin(); subPoseBlockIt != rigBlocksPair.second.end();)
+    {
+      if(rigIt != sfmData.getRigs().end() &&
+         subPoseBlockIt->first < rigIt->second.getNbSubPoses() &&
+         rigIt->second.getSubPose(subPoseBlockIt->first).status != sfmData::ERigSubPoseStatus::UNINITIALIZED)
+      {
+        ++subPoseBlockIt;
+        continue;
+      }
+      removeParameterBlock(subPoseBlockIt->second.data(), problem);
+      subPoseBlockIt = rigBlocksPair.second.erase(subPoseBlockIt);
+    }
+  }
 
   // setup poses data
   for(const auto& posePair : sfmData.getPoses())
@@ -384,6 +585,21 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
       ++intrinsicsUsage.at(view.getIntrinsicId());
   }
 
+  // remove the intrinsics no longer used by a reconstructed view or set as Ignored in the Local strategy
+  for(auto intrinsicBlockIt = _intrinsicsBlocks.begin(); intrinsicBlockIt != _intrinsicsBlocks.end();)
+  {
+    const auto usageIt = intrinsicsUsage.find(intrinsicBlockIt->first);
+    if(sfmData.getIntrinsics().count(intrinsicBlockIt->first) &&
+       usageIt != intrinsicsUsage.end() && usageIt->second > 0 &&
+       getIntrinsicState(intrinsicBlockIt->first) != EParameterState::IGNORED)
+    {
+      ++intrinsicBlockIt;
+      continue;
+    }
+    removeParameterBlock(intrinsicBlockIt->second.data(), problem);
+    intrinsicBlockIt = _intrinsicsBlocks.erase(intrinsicBlockIt);
+  }
+
   for(const auto& intrinsicPair: sfmData.getIntrinsics())
   {
     const IndexT intrinsicId = intrinsicPair.first;
@@ -404,10 +620,17 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
     assert(isValid(intrinsicPtr->getType()));
 
     std::vector<double>& intrinsicBlock = _intrinsicsBlocks[intrinsicId];
-    intrinsicBlock = intrinsicPtr->getParams();
+    const std::vector<double> intrinsicParams = intrinsicPtr->getParams();
+
+    // the block can't be resized in the problem
+    if(intrinsicBlock.size() != intrinsicParams.size())
+    {
+      removeParameterBlock(intrinsicBlock.data(), problem);
+      intrinsicBlock.resize(intrinsicParams.size());
+    }
+    std::copy(intrinsicParams.begin(), intrinsicParams.end(), intrinsicBlock.begin());
 
     double* intrinsicBlockPtr = intrinsicBlock.data();
-    problem.AddParameterBlock(intrinsicBlockPtr, intrinsicBlock.size());
 
     // add intrinsic parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(intrinsicBlockPtr);
@@ -415,15 +638,35 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
     // keep the camera intrinsic constant
     if(intrinsicPtr->isLocked() || !refineIntrinsics || getIntrinsicState(intrinsicId) == EParameterState::CONSTANT)
     {
-      // set the whole parameter block as constant.
+      addParameterBlock(intrinsicBlockPtr, intrinsicBlock.size(), std::vector<int>(), true, problem);
       _statistics.addState(EParameter::INTRINSIC, EParameterState::CONSTANT);
-      problem.SetParameterBlockConstant(intrinsicBlockPtr);
       continue;
     }
 
     // constant parameters
     std::vector<int> constantIntrinisc;
 
+    const std::size_t minImagesForOpticalCenter = 3;
+    const bool refineOpticalCenter = refineIntrinsicsOpticalCenter && (usageCount > minImagesForOpticalCenter);
+
+    // set focal length as constant
+    if(!refineIntrinsicsFocalLength)
+      constantIntrinisc.push_back(0);
+
+    // don't refine the optical center
+    if(!refineOpticalCenter)
+    {
+      constantIntrinisc.push_back(1);
+      constantIntrinisc.push_back(2);
+    }
+
+    // lens distortion
+    if(!refineIntrinsicsDistortion)
+      for(std::size_t i = 3; i < intrinsicBlock.size(); ++i)
+        constantIntrinisc.push_back(i);
+
+    addParameterBlock(intrinsicBlockPtr, intrinsicBlock.size(), constantIntrinisc, false, problem);
+
     // refine the focal length
     if(refineIntrinsicsFocalLength)
     {
@@ -442,16 +685,9 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
         problem.SetParameterLowerBound(intrinsicBlockPtr, 0, 0.0);
       }
     }
-    else
-    {
-      // set focal length as constant
-      constantIntrinisc.push_back(0);
-    }
-
-    const std::size_t minImagesForOpticalCenter = 3;
 
     // optical center
-    if(refineIntrinsicsOpticalCenter && (usageCount > minImagesForOpticalCenter))
+    if(refineOpticalCenter)
     {
       // refine optical center within 10% of the image size.
       assert(intrinsicBlock.size() >= 3);
@@ -465,23 +701,6 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
       problem.SetParameterLowerBound(intrinsicBlockPtr, 2, opticalCenterMinPercent * intrinsicPtr->h());
       problem.SetParameterUpperBound(intrinsicBlockPtr, 2, opticalCenterMaxPercent * intrinsicPtr->h());
     }
-    else
-    {
-      // don't refine the optical center
-      constantIntrinisc.push_back(1);
-      constantIntrinisc.push_back(2);
-    }
-
-    // lens distortion
-    if(!refineIntrinsicsDistortion)
-      for(std::size_t i = 3; i < intrinsicBlock.size(); ++i)
-        constantIntrinisc.push_back(i);
-
-    if(!constantIntrinisc.empty())
-    {
-      ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(intrinsicBlock.size(), constantIntrinisc);
-      problem.SetParameterization(intrinsicBlockPtr, subsetParameterization);
-    }
 
     _statistics.addState(EParameter::INTRINSIC, EParameterState::REFINED);
   }
@@ -491,9 +710,24 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
 {
   const bool refineStructure = refineOptions & REFINE_STRUCTURE;
 
-  // set a LossFunction to be less penalized by false measurements.
   // note: set it to NULL if you don't want use a lossFunction.
-  ceres::LossFunction* lossFunction = new ceres::HuberLoss(Square(4.0)); // TODO: make the LOSS function and the parameter an option
+  ceres::LossFunction* lossFunction = _lossFunction.get();
+
+  // remove the landmarks no longer in the scene or set as Ignored in the Local strategy
+  for(auto landmarkBlockIt = _landmarksBlocks.begin(); landmarkBlockIt != _landmarksBlocks.end();)
+  {
+    const auto landmarkIt = sfmData.getLandmarks().find(landmarkBlockIt->first);
+    if(landmarkIt != sfmData.getLandmarks().end() &&
+       !landmarkIt->second.observations.empty() &&
+       getLandmarkState(landmarkBlockIt->first) != EParameterState::IGNORED)
+    {
+      ++landmarkBlockIt;
+      continue;
+    }
+    removeParameterBlock(landmarkBlockIt->second.data(), problem);
+    _observationsBlocks.erase(landmarkBlockIt->first);
+    landmarkBlockIt = _landmarksBlocks.erase(landmarkBlockIt);
+  }
 
   // build the residual blocks corresponding to the track observations
   for(const auto& landmarkPair: sfmData.getLandmarks())
@@ -509,6 +743,9 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
       continue;
     }
 
+    if(landmark.observations.empty())
+      continue;
+
     std::array<double,3>& landmarkBlock = _landmarksBlocks[landmarkId];
     for(std::size_t i = 0; i < 3; ++i)
       landmarkBlock.at(i) = landmark.X(Eigen::Index(i));
@@ -518,6 +755,29 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
     // add landmark parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(landmarkBlockPtr);
 
+    const bool isConstant = (!refineStructure || getLandmarkState(landmarkId) == EParameterState::CONSTANT);
+    addParameterBlock(landmarkBlockPtr, 3, std::vector<int>(), isConstant, problem);
+
+    // residual blocks of the landmark already in the problem
+    HashMap<IndexT, ObservationResidualBlock>* observationsBlocks = nullptr;
+
+    if(_ceresOptions.usePersistentProblem)
+    {
+      observationsBlocks = &_observationsBlocks[landmarkId];
+
+      // remove the residual blocks of the removed or modified observations
+      std::vector<ceres::ResidualBlockId> removedResidualBlocks;
+      for(const auto& observationBlockPair : *observationsBlocks)
+      {
+        const auto observationIt = landmark.observations.find(observationBlockPair.first);
+        const std::array<double,2>& x = observationBlockPair.second.x;
+        if(observationIt == landmark.observations.end() || observationIt->second.x(0) != x[0] || observationIt->second.x(1) != x[1])
+          removedResidualBlocks.push_back(observationBlockPair.second.residualBlockId);
+      }
+      for(const ceres::ResidualBlockId residualBlockId : removedResidualBlocks)
+        removeResidualBlock(residualBlockId, problem);
+    }
+
     // iterate over 2D observation associated to the 3D landmark
     for(const auto& observationPair: landmark.observations)
     {
@@ -543,11 +803,19 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
         _ceresOptions.linearSolverOrdering.AddElementToGroup(intrinsicBlockPtr, 2);
       }
 
+      _statistics.addState(EParameter::LANDMARK, isConstant ? EParameterState::CONSTANT : EParameterState::REFINED);
+
+      // the residual block is already in the persistent problem
+      if(observationsBlocks != nullptr && observationsBlocks->count(observationPair.first))
+        continue;
+
+      ceres::ResidualBlockId residualBlockId;
+
       if(view.isPartOfRig() && !view.isPoseIndependant())
       {
         ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation.x);
 
-        problem.AddResidualBlock(costFunction,
+        residualBlockId = problem.AddResidualBlock(costFunction,
             lossFunction,
             intrinsicBlockPtr,
             poseBlockPtr,
@@ -556,35 +824,196 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
       }
       else
       {
-        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation.x);
+        const IntrinsicBase* intrinsicPtr = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+        const bool useAnalyticJacobian = (_ceresOptions.analyticJacobianIntrinsics.count(intrinsicPtr->getType()) > 0);
+        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(intrinsicPtr, observation.x, useAnalyticJacobian);
 
-        problem.AddResidualBlock(costFunction,
+        residualBlockId = problem.AddResidualBlock(costFunction,
             lossFunction,
             intrinsicBlockPtr,
             poseBlockPtr,
             landmarkBlockPtr); //do we need to copy 3D point to avoid false motion, if failure ?
       }
 
-      if(!refineStructure || getLandmarkState(landmarkId) == EParameterState::CONSTANT)
+      if(observationsBlocks != nullptr)
       {
-        // set the whole landmark parameter block as constant.
-        _statistics.addState(EParameter::LANDMARK, EParameterState::CONSTANT);
-        problem.SetParameterBlockConstant(landmarkBlockPtr);
+        ObservationResidualBlock& observationBlock = (*observationsBlocks)[observationPair.first];
+        observationBlock.residualBlockId = residualBlockId;
+        observationBlock.x = {observation.x(0), observation.x(1)};
+        _residualBlocksObservations[residualBlockId] = std::make_pair(landmarkId, observationPair.first);
       }
-      else
+    }
+  }
+}
+
+void BundleAdjustmentCeres::selectLandmarksSubset(const sfmData::SfMData& sfmData)
+{
+  // pyramid of the image grid: 2x2 cells at the coarsest level, 32x32 at the finest
+  const int pyramidBase = 2;
+  const int pyramidDepth = 5;
+
+  struct Candidate
+  {
+    IndexT landmarkId;
+    const sfmData::Landmark* landmark;
+    const Vec2* x;
+    double residual;
+  };
+
+  // candidate landmarks of each view
+  std::map<IndexT, std::vector<Candidate>> candidatesPerView;
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    if(_localGraph != nullptr && _localGraph->getLandmarkState(landmarkPair.first) == EParameterState::IGNORED)
+      continue;
+    for(const auto& observationPair : landmarkPair.second.observations)
+      candidatesPerView[observationPair.first].push_back({landmarkPair.first, &landmarkPair.second, &observationPair.second.x, 0.0});
+  }
+
+  std::vector<std::pair<const IndexT, std::vector<Candidate>>*> views;
+  views.reserve(candidatesPerView.size());
+  for(auto& viewCandidates : candidatesPerView)
+    views.push_back(&viewCandidates);
+
+  std::vector<std::vector<IndexT>> selectedPerView(views.size());
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < views.size(); ++i)
+  {
+    const sfmData::View& view = sfmData.getView(views[i]->first);
+    std::vector<Candidate>& candidates = views[i]->second;
+    std::vector<IndexT>& selected = selectedPerView[i];
+
+    if(candidates.size() <= _ceresOptions.landmarksSubsamplingMaxPerView)
+    {
+      for(const Candidate& candidate : candidates)
+        selected.push_back(candidate.landmarkId);
+      continue;
+    }
+
+    const IntrinsicBase* intrinsic = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+    const Pose3 pose = sfmData.getPose(view).getTransform();
+    for(Candidate& candidate : candidates)
+      candidate.residual = intrinsic->residual(pose, candidate.landmark->X, *candidate.x).norm();
+
+    // best landmarks first: longest tracks, then smallest residuals
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b)
+    {
+      if(a.landmark->observations.size() != b.landmark->observations.size())
+        return a.landmark->observations.size() > b.landmark->observations.size();
+      return a.residual < b.residual;
+    });
+
+    const double width = (view.getWidth() > 0) ? view.getWidth() : intrinsic->w();
+    const double height = (view.getHeight() > 0) ? view.getHeight() : intrinsic->h();
+
+    // fill the empty cells of each level with the best landmark of the cell
+    std::vector<bool> isSelected(candidates.size(), false);
+    int cellsPerSide = 1;
+    for(int level = 0; level < pyramidDepth && selected.size() < _ceresOptions.landmarksSubsamplingMaxPerView; ++level)
+    {
+      cellsPerSide *= pyramidBase;
+      std::vector<bool> filledCells(cellsPerSide * cellsPerSide, false);
+
+      const auto cellIndex = [&](const Vec2& x)
+      {
+        const int cx = std::min(cellsPerSide - 1, std::max(0, static_cast<int>(x(0) / width * cellsPerSide)));
+        const int cy = std::min(cellsPerSide - 1, std::max(0, static_cast<int>(x(1) / height * cellsPerSide)));
+        return cy * cellsPerSide + cx;
+      };
+
+      for(std::size_t c = 0; c < candidates.size(); ++c)
+      {
+        if(isSelected[c])
+          filledCells[cellIndex(*candidates[c].x)] = true;
+      }
+
+      for(std::size_t c = 0; c < candidates.size() && selected.size() < _ceresOptions.landmarksSubsamplingMaxPerView; ++c)
       {
-        _statistics.addState(EParameter::LANDMARK, EParameterState::REFINED);
+        const int cell = cellIndex(*candidates[c].x);
+        if(isSelected[c] || filledCells[cell])
+          continue;
+        filledCells[cell] = true;
+        isSelected[c] = true;
+        selected.push_back(candidates[c].landmarkId);
       }
     }
   }
+
+  _landmarksSubset.clear();
+  for(const std::vector<IndexT>& selected : selectedPerView)
+    _landmarksSubset.insert(selected.begin(), selected.end());
+
+  ALICEVISION_LOG_INFO("Bundle adjustment with a subset of " << _landmarksSubset.size() << " landmarks (out of " << sfmData.getLandmarks().size() << ").");
+}
+
+void BundleAdjustmentCeres::retriangulateLandmarks(sfmData::SfMData& sfmData)
+{
+  std::vector<sfmData::Landmark*> landmarks;
+  for(auto& landmarkPair : sfmData.getLandmarks())
+  {
+    if(_landmarksSubset.count(landmarkPair.first) ||
+       (_localGraph != nullptr && _localGraph->getLandmarkState(landmarkPair.first) != EParameterState::REFINED))
+      continue;
+    landmarks.push_back(&landmarkPair.second);
+  }
+
+  std::size_t nbRetriangulated = 0;
+
+  #pragma omp parallel for schedule(dynamic, 1000) reduction(+:nbRetriangulated)
+  for(int i = 0; i < landmarks.size(); ++i)
+  {
+    sfmData::Landmark& landmark = *landmarks[i];
+
+    Triangulation triangulation;
+    std::vector<std::pair<const IntrinsicBase*, Pose3>> cameras;
+    cameras.reserve(landmark.observations.size());
+    for(const auto& observationPair : landmark.observations)
+    {
+      const sfmData::View& view = sfmData.getView(observationPair.first);
+      const IntrinsicBase* intrinsic = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+      const Pose3 pose = sfmData.getPose(view).getTransform();
+      triangulation.add(intrinsic->get_projective_equivalent(pose), intrinsic->get_ud_pixel(observationPair.second.x));
+      cameras.emplace_back(intrinsic, pose);
+    }
+
+    if(triangulation.size() < 2)
+      continue;
+
+    const Vec3 X = triangulation.compute();
+    if(triangulation.minDepth() <= 0)
+      continue;
+
+    // keep the position with the smallest residual
+    double residualBefore = 0.0;
+    double residualAfter = 0.0;
+    std::size_t c = 0;
+    for(const auto& observationPair : landmark.observations)
+    {
+      residualBefore += cameras[c].first->residual(cameras[c].second, landmark.X, observationPair.second.x).squaredNorm();
+      residualAfter += cameras[c].first->residual(cameras[c].second, X, observationPair.second.x).squaredNorm();
+      ++c;
+    }
+
+    if(std::isfinite(residualAfter) && residualAfter < residualBefore)
+    {
+      landmark.X = X;
+      ++nbRetriangulated;
+    }
+  }
+
+  _statistics.nbRetriangulatedLandmarks = nbRetriangulated;
+  ALICEVISION_LOG_INFO("Bundle adjustment with a subset of the landmarks: " << nbRetriangulated << " landmarks retriangulated (out of " << landmarks.size() << ").");
 }
 
 void BundleAdjustmentCeres::createProblem(const sfmData::SfMData& sfmData,
                                           ERefineOptions refineOptions,
                                           ceres::Problem& problem)
 {
-  // clear previously computed data
-  resetProblem();
+  // clear the data of the previous adjustment, the parameter blocks are kept
+  _statistics = Statistics();
+  _allParametersBlocks.clear();
+  _ceresOptions.linearSolverOrdering = ceres::ParameterBlockOrdering();
 
   // ensure we are not using incompatible options
   // REFINEINTRINSICS_OPTICALCENTER_ALWAYS and REFINEINTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA cannot be used at the same time
@@ -687,8 +1116,8 @@ void BundleAdjustmentCeres::createJacobian(const sfmData::SfMData& sfmData,
                                            ceres::CRSMatrix& jacobian)
 {
   // create problem
-  ceres::Problem problem;
-  createProblem(sfmData, refineOptions, problem);
+  resetProblem();
+  createProblem(sfmData, refineOptions, *_problem);
 
   // configure Jacobian engine
   double cost = 0.0;
@@ -698,13 +1127,198 @@ void BundleAdjustmentCeres::createJacobian(const sfmData::SfMData& sfmData,
   evalOpt.apply_loss_function = true;
 
   // create Jacobain
-  problem.Evaluate(evalOpt, &cost, NULL, NULL, &jacobian);
+  _problem->Evaluate(evalOpt, &cost, NULL, NULL, &jacobian);
 }
 
-bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions)
+bool BundleAdjustmentCeres::computePosesCovariance(const sfmData::SfMData& sfmData,
+                                                   ERefineOptions refineOptions,
+                                                   HashMap<IndexT, Mat>& posesCovariance)
 {
+  posesCovariance.clear();
+
   // create problem
-  ceres::Problem problem;
+  resetProblem();
+  createProblem(sfmData, refineOptions, *_problem);
+  ceres::Problem& problem = *_problem;
+
+  const bool refinePoses = (refineOptions & REFINE_ROTATION) || (refineOptions & REFINE_TRANSLATION);
+
+  // poses of the problem, sorted by id
+  std::vector<IndexT> poseIds;
+  poseIds.reserve(_posesBlocks.size());
+  for(const auto& poseBlockPair : _posesBlocks)
+  {
+    if(problem.HasParameterBlock(poseBlockPair.second.data()))
+      poseIds.push_back(poseBlockPair.first);
+  }
+  std::sort(poseIds.begin(), poseIds.end());
+
+  if(poseIds.empty())
+    return true;
+
+  HashMap<IndexT, std::size_t> poseIndexes;
+  for(std::size_t i = 0; i < poseIds.size(); ++i)
+    poseIndexes[poseIds[i]] = i;
+
+  // observations of each pose and observed poses of each landmark of the problem
+  std::vector<std::size_t> nbPoseObservations(poseIds.size(), 0);
+  std::vector<std::pair<IndexT, std::vector<std::size_t>>> landmarksPoses;
+  landmarksPoses.reserve(_landmarksBlocks.size());
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    if(_landmarksBlocks.count(landmarkPair.first) == 0)
+      continue;
+
+    std::vector<std::size_t> landmarkPoses;
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const sfmData::View& view = sfmData.getView(observationPair.first);
+      const auto poseIndexIt = poseIndexes.find(view.getPoseId());
+      if(poseIndexIt == poseIndexes.end())
+        continue;
+      landmarkPoses.push_back(poseIndexIt->second);
+      ++nbPoseObservations[poseIndexIt->second];
+    }
+    landmarksPoses.emplace_back(landmarkPair.first, std::move(landmarkPoses));
+  }
+
+  // connected components of the poses through the landmarks
+  track::ConcurrentUnionFind posesUnionFind(poseIds.size());
+  for(const auto& landmarkPoses : landmarksPoses)
+  {
+    for(std::size_t i = 1; i < landmarkPoses.second.size(); ++i)
+      posesUnionFind.unite(landmarkPoses.second.front(), landmarkPoses.second[i]);
+  }
+
+  // constant poses: locked, not refined or set as constant by the Local BA strategy
+  std::vector<bool> isConstantPose(poseIds.size());
+  for(std::size_t i = 0; i < poseIds.size(); ++i)
+  {
+    isConstantPose[i] = (!refinePoses || sfmData.getAbsolutePose(poseIds[i]).isLocked() ||
+                         getPoseState(poseIds[i]) == EParameterState::CONSTANT);
+  }
+
+  // gauge of each component: its most observed pose, if it has no constant pose
+  HashMap<std::size_t, std::size_t> componentsReferencePose;
+  std::set<std::size_t> fixedComponents;
+  for(std::size_t i = 0; i < poseIds.size(); ++i)
+  {
+    const std::size_t component = posesUnionFind.find(i);
+    if(isConstantPose[i])
+      fixedComponents.insert(component);
+
+    const auto referenceIt = componentsReferencePose.find(component);
+    if(referenceIt == componentsReferencePose.end())
+      componentsReferencePose[component] = i;
+    else if(nbPoseObservations[i] > nbPoseObservations[referenceIt->second])
+      referenceIt->second = i;
+  }
+
+  // the landmarks fix the scale: keep constant the most observed landmark of each component
+  HashMap<std::size_t, std::pair<IndexT, std::size_t>> componentsReferenceLandmark;
+  for(const auto& landmarkPoses : landmarksPoses)
+  {
+    if(landmarkPoses.second.empty())
+      continue;
+
+    const std::size_t component = posesUnionFind.find(landmarkPoses.second.front());
+    const auto referenceIt = componentsReferenceLandmark.find(component);
+    if(referenceIt == componentsReferenceLandmark.end())
+      componentsReferenceLandmark[component] = std::make_pair(landmarkPoses.first, landmarkPoses.second.size());
+    else if(landmarkPoses.second.size() > referenceIt->second.second)
+      referenceIt->second = std::make_pair(landmarkPoses.first, landmarkPoses.second.size());
+  }
+
+  for(const auto& referencePair : componentsReferencePose)
+  {
+    // constant landmarks already fix the gauge
+    if(!(refineOptions & REFINE_STRUCTURE) || fixedComponents.count(referencePair.first))
+      continue;
+
+    const std::size_t poseIndex = referencePair.second;
+    problem.SetParameterBlockConstant(_posesBlocks.at(poseIds[poseIndex]).data());
+    isConstantPose[poseIndex] = true;
+
+    const auto landmarkIt = componentsReferenceLandmark.find(referencePair.first);
+    if(landmarkIt != componentsReferenceLandmark.end())
+      problem.SetParameterBlockConstant(_landmarksBlocks.at(landmarkIt->second.first).data());
+  }
+
+  ALICEVISION_LOG_DEBUG("BundleAdjustment[Ceres]: poses covariance of " << poseIds.size() << " poses in "
+                        << componentsReferencePose.size() << " connected component(s).");
+
+  // only the diagonal blocks of the variable poses
+  std::vector<std::pair<const double*, const double*>> covarianceBlocks;
+  for(std::size_t i = 0; i < poseIds.size(); ++i)
+  {
+    if(isConstantPose[i])
+      continue;
+    const double* poseBlockPtr = _posesBlocks.at(poseIds[i]).data();
+    covarianceBlocks.emplace_back(poseBlockPtr, poseBlockPtr);
+  }
+
+  if(covarianceBlocks.empty())
+    return true;
+
+  ceres::Covariance::Options options;
+  options.algorithm_type = ceres::SPARSE_QR;
+  if(!getSparseLinearAlgebraLibrary(options.sparse_linear_algebra_library_type))
+  {
+    ALICEVISION_LOG_WARNING("BundleAdjustment[Ceres]: no sparse linear algebra library available, fallback to dense covariance.");
+    options.algorithm_type = ceres::DENSE_SVD;
+  }
+  options.num_threads = omp_get_max_threads();
+  options.apply_loss_function = true;
+
+  ceres::Covariance covariance(options);
+  if(!covariance.Compute(covarianceBlocks, &problem))
+  {
+    ALICEVISION_LOG_WARNING("BundleAdjustment[Ceres]: the poses covariance cannot be computed (rank deficient Jacobian).");
+    return false;
+  }
+
+  for(std::size_t i = 0; i < poseIds.size(); ++i)
+  {
+    if(isConstantPose[i])
+      continue;
+
+    const double* poseBlockPtr = _posesBlocks.at(poseIds[i]).data();
+    Eigen::Matrix<double, 6, 6, Eigen::RowMajor> poseCovariance;
+    covariance.GetCovarianceBlock(poseBlockPtr, poseBlockPtr, poseCovariance.data());
+    posesCovariance[poseIds[i]] = poseCovariance;
+  }
+  return true;
+}
+
+bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions)
+{
+  ALICEVISION_PROFILE_SCOPE("BundleAdjustmentCeres::adjust");
+
+  // create problem, or update the persistent problem of the previous adjustment
+  if(!_ceresOptions.usePersistentProblem || _problem == nullptr || refineOptions != _problemRefineOptions)
+  {
+    resetProblem();
+    _problemRefineOptions = refineOptions;
+  }
+
+  // adjust the cameras with a subset of the landmarks of the large scenes
+  _useLandmarksSubset = false;
+  if(_ceresOptions.landmarksSubsamplingMaxPerView > 0 &&
+     (refineOptions & (REFINE_ROTATION | REFINE_TRANSLATION | REFINE_INTRINSICS_ALL | REFINE_INTRINSICS_OPTICALCENTER_ALWAYS)))
+  {
+    std::size_t nbObservations = 0;
+    for(const auto& landmarkPair : sfmData.getLandmarks())
+      nbObservations += landmarkPair.second.observations.size();
+
+    if(nbObservations >= _ceresOptions.landmarksSubsamplingMinObservations)
+    {
+      selectLandmarksSubset(sfmData);
+      _useLandmarksSubset = true;
+    }
+  }
+
+  ceres::Problem& problem = *_problem;
   createProblem(sfmData, refineOptions, problem);
 
   // configure a Bundle Adjustment engine and run it
@@ -712,6 +1326,9 @@ bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions ref
   ceres::Solver::Options options;
   setSolverOptions(options);
 
+  if(_ceresOptions.useAutoLinearSolver)
+    selectLinearSolver(problem, options);
+
   // solve BA
   ceres::Solver::Summary summary;
   ceres::Solve(options, &problem, &summary);
@@ -724,14 +1341,27 @@ bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions ref
   if(!summary.IsSolutionUsable())
   {
     ALICEVISION_LOG_WARNING("Bundle Adjustment failed, the solution is not usable.");
+    _useLandmarksSubset = false;
     return false;
   }
 
   // update input sfmData with the solution
   updateFromSolution(sfmData, refineOptions);
 
+  // the other landmarks follow the refined cameras
+  if(_useLandmarksSubset)
+  {
+    if(refineOptions & REFINE_STRUCTURE)
+      retriangulateLandmarks(sfmData);
+    _useLandmarksSubset = false;
+  }
+
   // store some statitics from the summary
   _statistics.time = summary.total_time_in_seconds;
+  _statistics.linearSolverTime = summary.linear_solver_time_in_seconds;
+  _statistics.evaluationTime = summary.residual_evaluation_time_in_seconds + summary.jacobian_evaluation_time_in_seconds;
+  _statistics.linearSolverType = summary.linear_solver_type_used;
+  _statistics.preconditionerType = summary.preconditioner_type_used;
   _statistics.nbSuccessfullIterations = summary.num_successful_steps;
   _statistics.nbUnsuccessfullIterations = summary.num_unsuccessful_steps;
   _statistics.nbResidualBlocks = summary.num_residuals;
@@ -9,11 +9,18 @@
 
 #include <aliceVision/types.hpp>
 #include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/camera/cameraCommon.hpp>
+#include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/sfm/BundleAdjustment.hpp>
 #include <aliceVision/sfm/LocalBundleAdjustmentGraph.hpp>
 
 #include <ceres/ceres.h>
 
+#include <array>
+#include <memory>
+#include <set>
+#include <unordered_set>
+
 namespace aliceVision {
 
 namespace sfmData {
@@ -41,6 +48,12 @@ public:
     void setDenseBA();
     void setSparseBA();
 
+    /**
+     * @brief Select the linear solver from the structure of each problem
+     * @see BundleAdjustmentCeres::selectLinearSolver
+     */
+    void setAutoBA();
+
     ceres::LinearSolverType linearSolverType;
     ceres::PreconditionerType preconditionerType;
     ceres::SparseLinearAlgebraLibraryType sparseLinearAlgebraLibraryType;
@@ -49,6 +62,24 @@ public:
     bool useParametersOrdering = true;
     bool summary = false;
     bool verbose = true;
+    /// select the linear solver for each problem (see setAutoBA)
+    bool useAutoLinearSolver = false;
+    /// automatic selection: max size of the reduced camera system solved with DENSE_SCHUR
+    std::size_t autoDenseMaxCameraParameters = 1000;
+    /// automatic selection: max number of refined poses solved with SPARSE_SCHUR
+    std::size_t autoSparseMaxPoses = 2000;
+    /// camera models using a cost function with analytic jacobians instead of automatic differentiation
+    /// (see ResidualErrorCostFunction.hpp, rig observations always use automatic differentiation)
+    std::set<camera::EINTRINSIC> analyticJacobianIntrinsics = {camera::PINHOLE_CAMERA_RADIAL3, camera::PINHOLE_CAMERA_BROWN};
+    /// keep the Ceres problem between the adjustments with the same refine options,
+    /// and only update the parameter and residual blocks that changed in the scene
+    bool usePersistentProblem = false;
+    /// landmarks subsampling: max number of landmarks of each view used to refine the poses and the intrinsics,
+    /// well distributed in the image and with the longest tracks, the other landmarks are retriangulated
+    /// with the refined cameras after the adjustment (0: all the landmarks are adjusted)
+    std::size_t landmarksSubsamplingMaxPerView = 0;
+    /// landmarks subsampling: min number of observations in the scene to use the subsampling
+    std::size_t landmarksSubsamplingMinObservations = 1000000;
   };
 
   /**
@@ -93,12 +124,22 @@ public:
     std::size_t nbUnsuccessfullIterations = 0;
     /// number of resiudal blocks in the Ceres problem
     std::size_t nbResidualBlocks = 0;
+    /// number of landmarks retriangulated after the adjustment of a subset of the landmarks
+    std::size_t nbRetriangulatedLandmarks = 0;
     /// RMSEinitial: sqrt(initial_cost / num_residuals)
     double RMSEinitial = 0.0;
     /// RMSEfinal: sqrt(final_cost / num_residuals)
     double RMSEfinal = 0.0;
     /// time spent to solve the BA (s)
     double time = 0.0;
+    /// time spent in the linear solver (s)
+    double linearSolverTime = 0.0;
+    /// time spent to evaluate the residuals and the jacobians (s)
+    double evaluationTime = 0.0;
+    /// linear solver used by Ceres
+    ceres::LinearSolverType linearSolverType = ceres::DENSE_SCHUR;
+    /// preconditioner used by Ceres
+    ceres::PreconditionerType preconditionerType = ceres::JACOBI;
     /// number of states per parameter
     std::map<EParameter, std::map<EParameterState, std::size_t>> parametersStates;
     /// The distribution of the cameras for each graph distance <distance, numOfCam>
@@ -124,6 +165,20 @@ public:
                       ERefineOptions refineOptions,
                       ceres::CRSMatrix& jacobian);
 
+  /**
+   * @brief Compute the covariance of each camera pose, marginalized over the other parameters.
+   * Only the block diagonal of the covariance is computed, with a sparse QR factorization of the Jacobian.
+   * The gauge of each connected component of the scene is fixed on its most observed pose and landmark,
+   * unless the component already has a constant pose.
+   * @param[in] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in] refineOptions The chosen refine flag
+   * @param[out] posesCovariance The 6x6 covariance of each variable pose: angle axis(3) + translation(3)
+   * @return false if the covariance cannot be computed (rank deficient Jacobian) else true
+   */
+  bool computePosesCovariance(const sfmData::SfMData& sfmData,
+                              ERefineOptions refineOptions,
+                              HashMap<IndexT, Mat>& posesCovariance);
+
   /**
    * @brief Perform a Bundle Adjustment on the SfM scene with refinement of the requested parameters
    * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
@@ -163,18 +218,34 @@ public:
 private:
 
   /**
-   * @brief Clear structures for a new problem
+   * @brief Clear structures and create a new empty problem
    */
-  inline void resetProblem()
-  {
-    _statistics = Statistics();
+  void resetProblem();
 
-    _allParametersBlocks.clear();
-    _posesBlocks.clear();
-    _intrinsicsBlocks.clear();
-    _landmarksBlocks.clear();
-    _rigBlocks.clear();
-  }
+  /**
+   * @brief Add a parameter block to the problem, or update it if it already exists
+   * @note The parameterization of a block can't be changed, the block is removed and added again if needed
+   * @param[in] parameterBlock The parameter block pointer
+   * @param[in] size The parameter block size
+   * @param[in] constantParameters The constant parameters of the block, if the block is not constant
+   * @param[in] isConstant The whole parameter block is constant
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   */
+  void addParameterBlock(double* parameterBlock, int size, const std::vector<int>& constantParameters, bool isConstant, ceres::Problem& problem);
+
+  /**
+   * @brief Remove a parameter block and its residual blocks from the problem
+   * @param[in] parameterBlock The parameter block pointer
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   */
+  void removeParameterBlock(double* parameterBlock, ceres::Problem& problem);
+
+  /**
+   * @brief Remove a residual block from the problem
+   * @param[in] residualBlockId The residual block id
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   */
+  void removeResidualBlock(ceres::ResidualBlockId residualBlockId, ceres::Problem& problem);
 
   /**
    * @brief Set user Ceres options to the solver
@@ -182,6 +253,18 @@ private:
    */
   void setSolverOptions(ceres::Solver::Options& solverOptions) const;
 
+  /**
+   * @brief Select the linear solver, the preconditioner and the ordering from the size of the problem:
+   *  - no refined landmark: DENSE_QR or SPARSE_NORMAL_CHOLESKY, without parameters ordering
+   *  - small reduced camera system: DENSE_SCHUR
+   *  - up to CeresOptions::autoSparseMaxPoses refined poses: SPARSE_SCHUR
+   *  - larger problems: ITERATIVE_SCHUR, with a CLUSTER_JACOBI preconditioner if SuiteSparse is available, else SCHUR_JACOBI
+   * @note Called after createProblem, if CeresOptions::useAutoLinearSolver is enabled
+   * @param[in] problem The Ceres bundle adjustement problem
+   * @param[in,out] solverOptions The solver options structure
+   */
+  void selectLinearSolver(const ceres::Problem& problem, ceres::Solver::Options& solverOptions) const;
+
   /**
    * @brief Create a parameter block for each extrinsics according to the Ceres format: [Rx, Ry, Rz, tx, ty, tz]
    * @param[in] sfmData The input SfMData contains all the information about the reconstruction, notably the poses and sub-poses
@@ -206,10 +289,27 @@ private:
    */
   void addLandmarksToProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
 
+  /**
+   * @brief Select the landmarks adjusted with the landmarks subsampling: in each view, the landmarks with
+   *  the longest tracks (then the smallest residuals) filling the cells of a pyramid of the image grid,
+   *  from the coarsest level, up to CeresOptions::landmarksSubsamplingMaxPerView landmarks.
+   *  The other landmarks are IGNORED by the adjustment.
+   * @param[in] sfmData The input SfMData contains all the information about the reconstruction
+   */
+  void selectLandmarksSubset(const sfmData::SfMData& sfmData);
+
+  /**
+   * @brief Triangulate again the landmarks out of the adjusted subset, with the refined cameras.
+   *  A landmark keeps its previous position if the new one has a larger residual.
+   * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
+   */
+  void retriangulateLandmarks(sfmData::SfMData& sfmData);
+
   /**
    * @brief Create the Ceres bundle adjustement problem with:
    *  - extrincics and intrinsics parameters blocks.
    *  - residuals blocks for each observation.
+   *  If the problem already contains blocks, only the blocks that changed in the scene are updated.
    * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
    * @param[in] refineOptions The chosen refine flag
    * @param[out] problem The Ceres bundle adjustement problem
@@ -250,11 +350,21 @@ private:
    */
   inline BundleAdjustment::EParameterState getLandmarkState(IndexT landmarkId) const
   {
+    if(_useLandmarksSubset && _landmarksSubset.count(landmarkId) == 0)
+      return BundleAdjustment::EParameterState::IGNORED;
     return (_localGraph != nullptr ? _localGraph->getLandmarkState(landmarkId) : BundleAdjustment::EParameterState::REFINED);
   }
 
   // private members
 
+  /// observation of a residual block of the problem
+  struct ObservationResidualBlock
+  {
+    ceres::ResidualBlockId residualBlockId;
+    /// observed image location stored in the cost function
+    std::array<double,2> x;
+  };
+
   /// use or not the local budle adjustment strategy
   std::shared_ptr<const LocalBundleAdjustmentGraph> _localGraph = nullptr;
 
@@ -264,6 +374,18 @@ private:
   /// last adjustment iteration statisics
   Statistics _statistics;
 
+  /// landmarks of the current adjustment with the landmarks subsampling, the others are IGNORED
+  std::unordered_set<IndexT> _landmarksSubset;
+  /// the current adjustment uses the landmarks subsampling
+  bool _useLandmarksSubset = false;
+
+  /// loss function of all the residual blocks, not owned by the problem
+  std::unique_ptr<ceres::LossFunction> _lossFunction;
+  /// Ceres problem, kept between the adjustments if CeresOptions::usePersistentProblem
+  std::unique_ptr<ceres::Problem> _problem;
+  /// refine options of the current problem
+  ERefineOptions _problemRefineOptions = REFINE_NONE;
+
   // data wrappers for refinement
 
   /// all parameters blocks pointers
@@ -280,6 +402,15 @@ private:
   /// rig sub-poses blocks wrapper
   /// block: ceres angleAxis(3) + translation(3)
   HashMap<IndexT, HashMap<IndexT, std::array<double,6>>> _rigBlocks;
+  /// constant parameters of the parameter blocks with a subset parameterization
+  HashMap<const double*, std::vector<int>> _constantParametersPerBlock;
+
+  // residual blocks of the persistent problem
+
+  /// residual blocks of the observations <landmarkId, <viewId, residual block>>
+  HashMap<IndexT, HashMap<IndexT, ObservationResidualBlock>> _observationsBlocks;
+  /// observation of each residual block <landmarkId, viewId>
+  HashMap<ceres::ResidualBlockId, std::pair<IndexT, IndexT>> _residualBlocksObservations;
 };
 
 } // namespace sfm
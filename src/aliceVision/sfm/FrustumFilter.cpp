@@ -15,7 +15,12 @@
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
 
 namespace aliceVision {
 namespace sfm {
@@ -69,39 +74,164 @@ void FrustumFilter::initFrustum(const sfmData::SfMData& sfmData)
   }
 }
 
+namespace {
+
+/// Axis aligned bounding box of a truncated frustum
+struct FrustumBounds
+{
+  Vec3 min;
+  Vec3 max;
+
+  bool overlap(const FrustumBounds& other) const
+  {
+    return (min.array() <= other.max.array()).all() && (other.min.array() <= max.array()).all();
+  }
+};
+
+/// Integer coordinates of a cell of the frustums grid, packed in a single key
+inline std::int64_t cellKey(std::int64_t x, std::int64_t y, std::int64_t z)
+{
+  const std::int64_t mask = (1 << 21) - 1;
+  return ((x & mask) << 42) | ((y & mask) << 21) | (z & mask);
+}
+
+} // namespace
+
 PairSet FrustumFilter::getFrustumIntersectionPairs() const
 {
-  PairSet pairs;
   // List active view Id
   std::vector<IndexT> viewIds;
-  viewIds.reserve(z_near_z_far_perView.size());
-  std::transform(z_near_z_far_perView.begin(), z_near_z_far_perView.end(),
+  viewIds.reserve(frustum_perView.size());
+  std::transform(frustum_perView.begin(), frustum_perView.end(),
     std::back_inserter(viewIds), stl::RetrieveKey());
+  std::sort(viewIds.begin(), viewIds.end());
 
-  boost::progress_display my_progress_bar(
-    viewIds.size() * (viewIds.size()-1)/2,
-    std::cout, "\nCompute frustum intersection\n");
+  const int nbViews = static_cast<int>(viewIds.size());
 
-  // Exhaustive comparison (use the fact that the intersect function is symmetric)
-  #pragma omp parallel for
-  for (int i = 0; i < (int)viewIds.size(); ++i)
+  // candidate pairs per view i: views j > i to test for intersection
+  std::vector<std::vector<int>> candidates(nbViews);
+
+  if(_bTruncated)
   {
-    for (size_t j = i+1; j < viewIds.size(); ++j)
+    // the truncated frustums are bounded: their bounding boxes are stored in a uniform grid
+    // and only the frustums sharing a grid cell are tested
+    std::vector<FrustumBounds> bounds(nbViews);
+    std::vector<double> extents(nbViews);
+    for(int i = 0; i < nbViews; ++i)
     {
-      if (frustum_perView.at(viewIds[i]).intersect(frustum_perView.at(viewIds[j])))
+      const std::vector<Vec3>& points = frustum_perView.at(viewIds[i]).frustum_points();
+      bounds[i].min = bounds[i].max = points.front();
+      for(const Vec3& point : points)
       {
-        #pragma omp critical
-        {
-          pairs.insert(std::make_pair(viewIds[i], viewIds[j]));
-        }
+        bounds[i].min = bounds[i].min.cwiseMin(point);
+        bounds[i].max = bounds[i].max.cwiseMax(point);
       }
-      // Progress bar update
-      #pragma omp critical
+      extents[i] = (bounds[i].max - bounds[i].min).maxCoeff();
+    }
+
+    // the cell size is the median frustum extent: most of the frustums span a few cells
+    double cellSize = 1.0;
+    if(nbViews > 0)
+    {
+      std::vector<double> sortedExtents = extents;
+      std::nth_element(sortedExtents.begin(), sortedExtents.begin() + nbViews / 2, sortedExtents.end());
+      cellSize = std::max(sortedExtents[nbViews / 2], std::numeric_limits<double>::epsilon());
+    }
+
+    const auto cellCoords = [&](const Vec3& point) {
+      return Eigen::Matrix<std::int64_t, 3, 1>((point / cellSize).array().floor().cast<std::int64_t>());
+    };
+
+    // frustums spanning too many cells are tested against all the others
+    const std::int64_t maxCellsPerFrustum = 512;
+    std::vector<int> largeFrustums;
+    std::map<std::int64_t, std::vector<int>> grid;
+
+    for(int i = 0; i < nbViews; ++i)
+    {
+      const Eigen::Matrix<std::int64_t, 3, 1> cellMin = cellCoords(bounds[i].min);
+      const Eigen::Matrix<std::int64_t, 3, 1> cellMax = cellCoords(bounds[i].max);
+      const Eigen::Matrix<std::int64_t, 3, 1> nbCells = cellMax - cellMin + Eigen::Matrix<std::int64_t, 3, 1>::Ones();
+
+      if(nbCells.prod() > maxCellsPerFrustum)
+      {
+        largeFrustums.push_back(i);
+        continue;
+      }
+
+      for(std::int64_t x = cellMin(0); x <= cellMax(0); ++x)
+        for(std::int64_t y = cellMin(1); y <= cellMax(1); ++y)
+          for(std::int64_t z = cellMin(2); z <= cellMax(2); ++z)
+            grid[cellKey(x, y, z)].push_back(i);
+    }
+
+    for(const auto& cell : grid)
+    {
+      const std::vector<int>& cellFrustums = cell.second;
+      for(std::size_t a = 0; a < cellFrustums.size(); ++a)
+        for(std::size_t b = a + 1; b < cellFrustums.size(); ++b)
+          candidates[std::min(cellFrustums[a], cellFrustums[b])].push_back(std::max(cellFrustums[a], cellFrustums[b]));
+    }
+
+    for(const int i : largeFrustums)
+    {
+      for(int j = 0; j < nbViews; ++j)
       {
-        ++my_progress_bar;
+        if(j != i)
+          candidates[std::min(i, j)].push_back(std::max(i, j));
       }
     }
+
+    // remove the duplicated candidates and the ones with disjoint bounding boxes
+    #pragma omp parallel for
+    for(int i = 0; i < nbViews; ++i)
+    {
+      std::vector<int>& viewCandidates = candidates[i];
+      std::sort(viewCandidates.begin(), viewCandidates.end());
+      viewCandidates.erase(std::unique(viewCandidates.begin(), viewCandidates.end()), viewCandidates.end());
+      viewCandidates.erase(std::remove_if(viewCandidates.begin(), viewCandidates.end(), [&](int j) {
+          return !bounds[i].overlap(bounds[j]);
+        }), viewCandidates.end());
+    }
+  }
+  else
+  {
+    // infinite frustums: exhaustive comparison (use the fact that the intersect function is symmetric)
+    for(int i = 0; i < nbViews; ++i)
+    {
+      candidates[i].resize(nbViews - i - 1);
+      std::iota(candidates[i].begin(), candidates[i].end(), i + 1);
+    }
   }
+
+  std::size_t nbCandidates = 0;
+  for(const std::vector<int>& viewCandidates : candidates)
+    nbCandidates += viewCandidates.size();
+
+  boost::progress_display my_progress_bar(nbCandidates, std::cout, "\nCompute frustum intersection\n");
+
+  std::vector<PairVec> pairsPerView(nbViews);
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < nbViews; ++i)
+  {
+    const Frustum& frustum = frustum_perView.at(viewIds[i]);
+    for(const int j : candidates[i])
+    {
+      if(frustum.intersect(frustum_perView.at(viewIds[j])))
+        pairsPerView[i].emplace_back(viewIds[i], viewIds[j]);
+    }
+
+    // Progress bar update
+    #pragma omp critical
+    {
+      my_progress_bar += candidates[i].size();
+    }
+  }
+
+  PairSet pairs;
+  for(const PairVec& viewPairs : pairsPerView)
+    pairs.insert(viewPairs.begin(), viewPairs.end());
   return pairs;
 }
 
@@ -5,13 +5,12 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "LocalBundleAdjustmentGraph.hpp"
-#include <aliceVision/stl/stl.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <boost/filesystem.hpp>
-#include <lemon/bfs.h>
 
 #include <fstream>
 #include <algorithm>
+#include <numeric>
 
 namespace fs = boost::filesystem;
 
@@ -46,6 +45,11 @@ std::map<int, std::size_t> LocalBundleAdjustmentGraph::getDistancesHistogram() c
     else
       histogram.at(x.second)++;
   }
+
+  // the views not reached by the bounded BFS
+  if(_neighborsPerViewId.size() > _distancePerViewId.size())
+    histogram[-1] = _neighborsPerViewId.size() - _distancePerViewId.size();
+
   return histogram;
 }
 
@@ -68,6 +72,9 @@ void LocalBundleAdjustmentGraph::setAllParametersToRefine(const sfmData::SfMData
   // landmarks
   for(const auto& itLandmark: sfmData.structure)
     _statePerLandmarkId[itLandmark.first] = BundleAdjustment::EParameterState::REFINED;
+
+  _nbPoses = _statePerPoseId.size();
+  _nbLandmarks = _statePerLandmarkId.size();
 }
 
 void LocalBundleAdjustmentGraph::saveIntrinsicsToHistory(const sfmData::SfMData& sfmData)
@@ -136,85 +143,54 @@ void LocalBundleAdjustmentGraph::exportIntrinsicsHistory(const std::string& fold
 bool LocalBundleAdjustmentGraph::removeViews(const sfmData::SfMData& sfmData, const std::set<IndexT>& removedViewsId)
 {
   std::size_t numRemovedNode = 0;
-  std::map<IndexT, std::vector<int>> removedEdgesByIntrinsic;
 
   for(const IndexT& viewId : removedViewsId)
   {
-    const auto it = _nodePerViewId.find(viewId);
-    if(it == _nodePerViewId.end())
+    const auto it = _neighborsPerViewId.find(viewId);
+    if(it == _neighborsPerViewId.end())
     {
       ALICEVISION_LOG_WARNING("The view id: " << viewId << " does not exist in the graph, cannot remove it.");
       continue;
     }
 
-    // keep track of node incident edges that are going to be removed
-    // in order to update _intrinsicEdgesId accordingly
-    { 
-      const IndexT intrinsicId = sfmData.getView(viewId).getIntrinsicId();
-      const auto intrinsicIt = _intrinsicEdgesId.find(intrinsicId);
-      if(intrinsicIt != _intrinsicEdgesId.end())
-      {
-        // store incident edge ids before removal
-        for(lemon::ListGraph::IncEdgeIt e(_graph, it->second); e != lemon::INVALID; ++e)
-        {
-          removedEdgesByIntrinsic[intrinsicId].push_back(_graph.id(lemon::ListGraph::Edge(e)));
-        }
-      }
+    // remove the incident edges from the neighbors
+    for(const IndexT neighborId : it->second)
+    {
+      std::vector<IndexT>& neighbors = _neighborsPerViewId.at(neighborId);
+      const auto neighborIt = std::lower_bound(neighbors.begin(), neighbors.end(), viewId);
+      if(neighborIt != neighbors.end() && *neighborIt == viewId)
+        neighbors.erase(neighborIt);
     }
-    
-    _graph.erase(it->second); // this function erase a node with its incident arcs
-    _viewIdPerNode.erase(it->second);
-    _nodePerViewId.erase(it->first); // warning: invalidates the iterator "it", so it can not be used after this line
+    _neighborsPerViewId.erase(it); // warning: invalidates the iterator "it", so it can not be used after this line
 
-    ++numRemovedNode;
-    ALICEVISION_LOG_DEBUG("The view #" << viewId << " has been successfully removed to the distance graph.");
-  }
-
-  // remove erased edges from _intrinsicsEdgesId
-  for(auto& edgesIt : removedEdgesByIntrinsic)
-  {
-    const IndexT intrinsicId =  edgesIt.first;
-    std::vector<int>& edgeIds = _intrinsicEdgesId[intrinsicId];
-    std::vector<int>& removedEdges = edgesIt.second;
-
-    std::vector<int> newEdgeIds;
-    // sort before using set_difference
-    std::sort(edgeIds.begin(), edgeIds.end());
-    std::sort(removedEdges.begin(), removedEdges.end());
-
-    std::set_difference(
-      edgeIds.begin(), edgeIds.end(), 
-      removedEdges.begin(), removedEdges.end(), 
-      std::back_inserter(newEdgeIds)
-    );
-    std::swap(edgeIds, newEdgeIds);
-
-    if(edgeIds.empty())
+    // remove the intrinsic-edges and the rig-edges
+    const sfmData::View& view = sfmData.getView(viewId);
     {
-      _intrinsicEdgesId.erase(intrinsicId);
+      const auto intrinsicIt = _viewIdsPerIntrinsicId.find(view.getIntrinsicId());
+      if(intrinsicIt != _viewIdsPerIntrinsicId.end())
+        intrinsicIt->second.erase(viewId);
     }
+    for(auto& rigViewIds : _viewIdsPerRigId)
+      rigViewIds.second.erase(viewId);
+
+    ++numRemovedNode;
+    ALICEVISION_LOG_DEBUG("The view #" << viewId << " has been successfully removed to the distance graph.");
   }
   return numRemovedNode == removedViewsId.size();
 }
 
 int LocalBundleAdjustmentGraph::getPoseDistance(const IndexT poseId) const
 {
-  if(_distancePerPoseId.find(poseId) == _distancePerPoseId.end())
-  {
-    ALICEVISION_LOG_DEBUG("The pose #" << poseId << " does not exist in the '_mapDistancePerPoseId' (map size: " << _distancePerPoseId.size() << ") \n");
-    return -1;
-  }
-  return _distancePerPoseId.at(poseId);
+  // the poses not reached by the bounded BFS are not stored
+  const auto it = _distancePerPoseId.find(poseId);
+  return (it != _distancePerPoseId.end()) ? it->second : -1;
 }
 
 int LocalBundleAdjustmentGraph::getViewDistance(const IndexT viewId) const
 {
-  if(_distancePerViewId.find(viewId) == _distancePerViewId.end())
-  {
-    ALICEVISION_LOG_DEBUG("Cannot get the graph-distance of the view #" << viewId << ": does not exist in the '_mapDistancePerViewId':\n");
-    return -1;
-  }
-  return _distancePerViewId.at(viewId);
+  // the views not reached by the bounded BFS are not stored
+  const auto it = _distancePerViewId.find(viewId);
+  return (it != _distancePerViewId.end()) ? it->second : -1;
 }
 
 BundleAdjustment::EParameterState LocalBundleAdjustmentGraph::getStateFromDistance(int distance) const
@@ -246,7 +222,7 @@ void LocalBundleAdjustmentGraph::updateGraphWithNewViews(
   // identify the views we need to add to the graph:
   std::set<IndexT> addedViewsId;
   
-  if(_graph.maxNodeId() + 1 == 0) // the graph is empty: add all the poses of the scene
+  if(_neighborsPerViewId.empty()) // the graph is empty: add all the poses of the scene
   {
     ALICEVISION_LOG_DEBUG("The graph is empty: initial pair & new view(s) added.");
     for(const auto & x : sfmData.getViews())
@@ -264,7 +240,7 @@ void LocalBundleAdjustmentGraph::updateGraphWithNewViews(
   {
     // check if the node does not already exist in the graph
     // it happens when multiple local BA are run successively, with no new reconstructed views.
-    if(_nodePerViewId.find(viewId) != _nodePerViewId.end())
+    if(_neighborsPerViewId.find(viewId) != _neighborsPerViewId.end())
     {
       ALICEVISION_LOG_DEBUG("Cannot add the view id: " << viewId << " to the graph, already exists in the graph.");
       continue;
@@ -277,9 +253,9 @@ void LocalBundleAdjustmentGraph::updateGraphWithNewViews(
       continue;
     }
      
-    lemon::ListGraph::Node newNode = _graph.addNode();
-    _nodePerViewId[viewId] = newNode;
-    _viewIdPerNode[newNode] = viewId;
+    _neighborsPerViewId[viewId];
+    // the views sharing an intrinsic are linked by the intrinsic-edges, until its focal length is considered as constant
+    _viewIdsPerIntrinsicId[sfmData.getView(viewId).getIntrinsicId()].insert(viewId);
     ++nbAddedNodes;
   }
 
@@ -290,17 +266,17 @@ void LocalBundleAdjustmentGraph::updateGraphWithNewViews(
     // each new view need to be connected to the graph
     // we create the 'minNbOfEdgesPerView' best edges and all the other with more than 'minNbOfMatches' shared landmarks
     const std::size_t minNbOfEdgesPerView = 10;
-    std::vector<Pair> newEdges = getNewEdges(sfmData, map_tracksPerView, addedViewsId, minNbOfMatches, minNbOfEdgesPerView);
-    numAddedEdges = newEdges.size();
+    const std::vector<Pair> newEdges = getNewEdges(sfmData, map_tracksPerView, addedViewsId, minNbOfMatches, minNbOfEdgesPerView);
 
     for(const Pair& edge: newEdges)
-      _graph.addEdge(_nodePerViewId.at(edge.first), _nodePerViewId.at(edge.second));
-
-    numAddedEdges += addIntrinsicEdgesToTheGraph(sfmData, addedViewsId);
+    {
+      if(addEdge(edge.first, edge.second))
+        ++numAddedEdges;
+    }
   }
   
   ALICEVISION_LOG_DEBUG("The distances graph has been completed with " << nbAddedNodes<< " nodes & " << numAddedEdges << " edges.");
-  ALICEVISION_LOG_DEBUG("It contains " << _graph.maxNodeId() + 1 << " nodes & " << _graph.maxEdgeId() + 1 << " edges");
+  ALICEVISION_LOG_DEBUG("It contains " << countNodes() << " nodes & " << countEdges() << " edges");
 }
 
 void LocalBundleAdjustmentGraph::computeGraphDistances(const sfmData::SfMData& sfmData, const std::set<IndexT>& newReconstructedViews)
@@ -310,35 +286,57 @@ void LocalBundleAdjustmentGraph::computeGraphDistances(const sfmData::SfMData& s
   // reset the maps
   _distancePerViewId.clear();
   _distancePerPoseId.clear();
-  
-  // setup Breadth First Search using Lemon
-  lemon::Bfs<lemon::ListGraph> bfs(_graph);
-  bfs.init();
-  
-  // add source views for the bfs visit of the _graph
+
+  // the states only depend on the distances up to D+1, the BFS is stopped there
+  const int maxDistance = static_cast<int>(_graphDistanceLimit) + 1;
+
+  // add source views for the bfs visit of the graph
+  std::vector<IndexT> currentViews;
   for(const IndexT viewId: newReconstructedViews)
   {
-    auto it = _nodePerViewId.find(viewId);
-    if(it == _nodePerViewId.end())
+    if(_neighborsPerViewId.find(viewId) == _neighborsPerViewId.end())
       ALICEVISION_LOG_WARNING("The reconstructed view #" << viewId << " cannot be added as source for the BFS: does not exist in the graph.");
-    else
-      bfs.addSource(it->second);
+    else if(_distancePerViewId.emplace(viewId, 0).second)
+      currentViews.push_back(viewId);
   }
-  bfs.start();
-  
-  // handle bfs results (distances)
-  for(const auto& x : _nodePerViewId) // each node in the graph
+
+  // the intrinsic-edges and the rig-edges link all the views of a group, each group is visited once
+  std::set<IndexT> visitedIntrinsics;
+  std::set<IndexT> visitedRigs;
+  std::vector<IndexT> nextViews;
+
+  for(int distance = 1; distance <= maxDistance && !currentViews.empty(); ++distance)
   {
-    auto& node = x.second;
-    int d = -1; 
-    
-    if(bfs.reached(node))
+    nextViews.clear();
+
+    const auto visit = [&](IndexT viewId)
+    {
+      if(_distancePerViewId.emplace(viewId, distance).second)
+        nextViews.push_back(viewId);
+    };
+
+    for(const IndexT viewId : currentViews)
     {
-      d = bfs.dist(node);
-      // dist(): "If node v is not reached from the root(s), then the return value of this function is undefined."
-      // this is why the distance is previously set to -1.
+      for(const IndexT neighborId : _neighborsPerViewId.at(viewId))
+        visit(neighborId);
+
+      const sfmData::View& view = sfmData.getView(viewId);
+
+      const IndexT intrinsicId = view.getIntrinsicId();
+      if(!isFocalLengthConstant(intrinsicId) && visitedIntrinsics.insert(intrinsicId).second)
+      {
+        for(const IndexT otherViewId : _viewIdsPerIntrinsicId.at(intrinsicId))
+          visit(otherViewId);
+      }
+
+      const auto rigIt = _viewIdsPerRigId.find(view.getRigId());
+      if(rigIt != _viewIdsPerRigId.end() && rigIt->second.count(viewId) && visitedRigs.insert(rigIt->first).second)
+      {
+        for(const IndexT otherViewId : rigIt->second)
+          visit(otherViewId);
+      }
     }
-    _distancePerViewId[x.first] = d;
+    std::swap(currentViews, nextViews);
   }
   
   // re-mapping from <ViewId, distance> to <PoseId, distance>:
@@ -356,7 +354,7 @@ void LocalBundleAdjustmentGraph::computeGraphDistances(const sfmData::SfMData& s
   } 
 }
 
-void LocalBundleAdjustmentGraph::convertDistancesToStates(const sfmData::SfMData& sfmData)
+void LocalBundleAdjustmentGraph::convertDistancesToStates(const sfmData::SfMData& sfmData, const track::TracksPerView& tracksPerView)
 {
   // reset the maps
   _statePerPoseId.clear();
@@ -381,14 +379,17 @@ void LocalBundleAdjustmentGraph::convertDistancesToStates(const sfmData::SfMData
   //    - Ignored by default
   //    - Refined <=> its connected to a refined camera
 
+  _nbPoses = sfmData.getPoses().size();
+  _nbLandmarks = sfmData.getLandmarks().size();
+
   // poses
-  for(const auto& posePair : sfmData.getPoses())
+  // only the poses reached by the bounded BFS can be refined or constant
+  for(const auto& poseDistancePair : _distancePerPoseId)
   {
-    const IndexT poseId = posePair.first;
-    const int distance = getPoseDistance(poseId);
-    const BundleAdjustment::EParameterState state = getStateFromDistance(distance);
+    const BundleAdjustment::EParameterState state = getStateFromDistance(poseDistancePair.second);
 
-    _statePerPoseId[poseId] = state;
+    if(state != BundleAdjustment::EParameterState::IGNORED && sfmData.getPoses().count(poseDistancePair.first))
+      _statePerPoseId[poseDistancePair.first] = state;
   }
   
   // instrinsics
@@ -403,32 +404,45 @@ void LocalBundleAdjustmentGraph::convertDistancesToStates(const sfmData::SfMData
   }
   
   // landmarks
-  for(const auto& itLandmark: sfmData.structure)
+  // only the landmarks seen by a refined view can be refined
+  std::set<IndexT> visitedLandmarks;
+  for(const auto& viewDistancePair : _distancePerViewId)
   {
-    const IndexT landmarkId = itLandmark.first;
-    const sfmData::Observations& observations = itLandmark.second.observations;
-    
-    assert(observations.size() >= 2);
+    if(getStateFromDistance(viewDistancePair.second) != BundleAdjustment::EParameterState::REFINED)
+      continue;
+
+    const auto tracksIt = tracksPerView.find(viewDistancePair.first);
+    if(tracksIt == tracksPerView.end())
+      continue;
 
-    std::array<bool, 3> states = {false, false, false};
-    for(const auto& observationIt: observations)
+    for(const std::size_t trackId : tracksIt->second)
     {
-      const int distance = getViewDistance(observationIt.first);
-      const BundleAdjustment::EParameterState viewState = getStateFromDistance(distance);
-      states.at(static_cast<std::size_t>(viewState)) = true;
-    }
+      const IndexT landmarkId = static_cast<IndexT>(trackId);
+      const auto landmarkIt = sfmData.getLandmarks().find(landmarkId);
+      if(landmarkIt == sfmData.getLandmarks().end() || !visitedLandmarks.insert(landmarkId).second)
+        continue;
 
-    // in the general case, a landmark can NOT have observations from refined AND ignored cameras.
-    // in pratice, there is a minimal number of common points to declare the connection between images.
-    // so we can have some points that are not declared in the graph of cameras connections.
-    // for these particular cases, we can have landmarks with refined AND ignored cameras.
-    // in this particular case, we prefer to ignore the landmark to avoid wrong/unconstraint refinements.
+      const sfmData::Observations& observations = landmarkIt->second.observations;
 
-    if(!states.at(static_cast<std::size_t>(BundleAdjustment::EParameterState::REFINED)) ||
-        states.at(static_cast<std::size_t>(BundleAdjustment::EParameterState::IGNORED)))
-      _statePerLandmarkId[landmarkId] = BundleAdjustment::EParameterState::IGNORED;
-    else
-      _statePerLandmarkId[landmarkId] = BundleAdjustment::EParameterState::REFINED;
+      assert(observations.size() >= 2);
+
+      std::array<bool, 3> states = {false, false, false};
+      for(const auto& observationIt: observations)
+      {
+        const int distance = getViewDistance(observationIt.first);
+        const BundleAdjustment::EParameterState viewState = getStateFromDistance(distance);
+        states.at(static_cast<std::size_t>(viewState)) = true;
+      }
+
+      // in the general case, a landmark can NOT have observations from refined AND ignored cameras.
+      // in pratice, there is a minimal number of common points to declare the connection between images.
+      // so we can have some points that are not declared in the graph of cameras connections.
+      // for these particular cases, we can have landmarks with refined AND ignored cameras.
+      // in this particular case, we prefer to ignore the landmark to avoid wrong/unconstraint refinements.
+
+      if(!states.at(static_cast<std::size_t>(BundleAdjustment::EParameterState::IGNORED)))
+        _statePerLandmarkId[landmarkId] = BundleAdjustment::EParameterState::REFINED;
+    }
   }
 }
 
@@ -441,32 +455,25 @@ std::vector<Pair> LocalBundleAdjustmentGraph::getNewEdges(
 {
   std::vector<Pair> newEdges;
   
-  // get landmarks id. of all the reconstructed 3D points (: landmarks)
-  // TODO: avoid copy and use boost::transform_iterator
-  std::set<IndexT> landmarkIds;
-  std::transform(sfmData.getLandmarks().begin(), sfmData.getLandmarks().end(),
-                 std::inserter(landmarkIds, landmarkIds.begin()),
-                 stl::RetrieveKey());
-  
   for(IndexT viewId: newViewsId)
   {
     std::map<IndexT, std::size_t> sharedLandmarksPerView;
 
     // get all the tracks of the new added view
-    const aliceVision::track::TrackIdSet& newViewTrackIds = tracksPerView.at(viewId);
-    
-    // keep the reconstructed tracks (with an associated landmark)
-    std::vector<IndexT> newViewLandmarks; // all landmarks (already reconstructed) visible from the new view
-    
-    newViewLandmarks.reserve(newViewTrackIds.size());
-    std::set_intersection(newViewTrackIds.begin(), newViewTrackIds.end(),
-                          landmarkIds.begin(), landmarkIds.end(),
-                          std::back_inserter(newViewLandmarks));
+    const auto tracksIt = tracksPerView.find(viewId);
+    if(tracksIt == tracksPerView.end())
+      continue;
+    const aliceVision::track::TrackIdSet& newViewTrackIds = tracksIt->second;
     
     // retrieve the common track Ids
-    for(IndexT landmarkId: newViewLandmarks)
+    // only the reconstructed tracks (with an associated landmark) are used, the cost only depends on the new view
+    for(const std::size_t trackId: newViewTrackIds)
     {
-      for(const auto& observations: sfmData.getLandmarks().at(landmarkId).observations)
+      const auto landmarkIt = sfmData.getLandmarks().find(static_cast<IndexT>(trackId));
+      if(landmarkIt == sfmData.getLandmarks().end())
+        continue;
+
+      for(const auto& observations: landmarkIt->second.observations)
       {
         if(observations.first == viewId)
           continue; // do not compare an observation with itself
@@ -578,8 +585,8 @@ void LocalBundleAdjustmentGraph::checkFocalLengthsConsistency(const std::size_t
     // check if the normed standard deviation is < stdevPercentageLimit
     if(normStdev * 100.0 <= stdevPercentageLimit)
     {
+      // the intrinsic-edges of this intrinsic are not used anymore
       _mapFocalIsConstant.at(idIntrinsic) = true;
-      removeIntrinsicEdgesFromTheGraph(idIntrinsic);
       numOfConstFocal++;
       ALICEVISION_LOG_DEBUG("The intrinsic #" << idIntrinsic << " is now considered to be stable.\n");
     }
@@ -609,33 +616,50 @@ void LocalBundleAdjustmentGraph::drawGraph(const sfmData::SfMData& sfmData, cons
   
   // node
   dotStream << "  node [ shape=ellipse, penwidth=5.0, fontname=Helvetica, fontsize=40 ];" << "\n";
-  for(lemon::ListGraph::NodeIt n(_graph); n!=lemon::INVALID; ++n)
+  for(const auto& neighborsPair : _neighborsPerViewId)
   {
-    const IndexT viewId = _viewIdPerNode[n];
-    const int viewDist = _distancePerViewId[viewId];
+    const IndexT viewId = neighborsPair.first;
+    const int viewDist = getViewDistance(viewId);
     
     std::string color = ", color=";
     if(viewDist == 0) color += "red";
     else if(viewDist == 1 ) color += "green";
     else if(viewDist == 2 ) color += "blue";
     else color += "black";
-    dotStream << "  n" << _graph.id(n)
+    dotStream << "  n" << viewId
               << " [ label=\"" << viewId << ": D" << viewDist << " K" << sfmData.getViews().at(viewId)->getIntrinsicId() << "\"" << color << "]; " << "\n";
   }
   
   // edge
   dotStream << "  edge [ shape=ellipse, fontname=Helvetica, fontsize=5, color=black ];" << "\n";
-  for(lemon::ListGraph::EdgeIt e(_graph); e!=lemon::INVALID; ++e)
+  for(const auto& neighborsPair : _neighborsPerViewId)
   {
-    dotStream << "  n" << _graph.id(_graph.u(e)) << " -> " << " n" << _graph.id(_graph.v(e));
-    if(_intrinsicEdgesId.find(static_cast<IndexT>(_graph.id(e))) != _intrinsicEdgesId.end())
-      dotStream << " [color=red]\n";
-    else
-      dotStream << "\n";
+    for(const IndexT neighborId : neighborsPair.second)
+    {
+      if(neighborsPair.first < neighborId)
+        dotStream << "  n" << neighborsPair.first << " -> " << " n" << neighborId << "\n";
+    }
+  }
+
+  // intrinsic-edges and rig-edges
+  const auto drawGroupEdges = [&](const std::set<IndexT>& viewIds)
+  {
+    for(auto itA = viewIds.begin(); itA != viewIds.end(); ++itA)
+      for(auto itB = std::next(itA); itB != viewIds.end(); ++itB)
+        dotStream << "  n" << *itA << " -> " << " n" << *itB << " [color=red]\n";
+  };
+
+  for(const auto& intrinsicViewIds : _viewIdsPerIntrinsicId)
+  {
+    if(!isFocalLengthConstant(intrinsicViewIds.first))
+      drawGroupEdges(intrinsicViewIds.second);
   }
+  for(const auto& rigViewIds : _viewIdsPerRigId)
+    drawGroupEdges(rigViewIds.second);
+
   dotStream << "}" << "\n";
   
-  const std::string dotFilepath = (fs::path(folder) / ("graph_" + std::to_string(_viewIdPerNode.size())  + "_" + nameComplement + ".dot")).string();
+  const std::string dotFilepath = (fs::path(folder) / ("graph_" + std::to_string(_neighborsPerViewId.size())  + "_" + nameComplement + ".dot")).string();
   std::ofstream dotFile;
   dotFile.open(dotFilepath);
   dotFile.write(dotStream.str().c_str(), dotStream.str().length());
@@ -644,103 +668,46 @@ void LocalBundleAdjustmentGraph::drawGraph(const sfmData::SfMData& sfmData, cons
   ALICEVISION_LOG_DEBUG("The graph '"<< dotFilepath << "' has been saved.");
 }
 
-std::size_t LocalBundleAdjustmentGraph::addIntrinsicEdgesToTheGraph(const sfmData::SfMData& sfmData, const std::set<IndexT>& newReconstructedViews)
-{
-  std::map<Pair, IndexT> newIntrinsicEdges;
-
-  for(IndexT newViewId : newReconstructedViews) // for each new view
-  {
-    IndexT newViewIntrinsicId = sfmData.getViews().at(newViewId)->getIntrinsicId();
-    
-    if(isFocalLengthConstant(newViewIntrinsicId)) // do not add edges for a constant intrinsic
-      continue;
-
-    // for each reconstructed view in the graph
-    // warning: at this point, "_nodePerViewId" already contains the "newReconstructedViews"
-    for(const auto& x : _nodePerViewId)
-    {
-      const auto& otherViewId = x.first;
-
-      // if the new view share the same intrinsic than previously reconstructed views
-      // note: do not compare a view with itself (must be tested since "_nodePerViewId" contains "newReconstructedViews")
-      if(newViewId != otherViewId
-         && newViewIntrinsicId == sfmData.getViews().at(otherViewId)->getIntrinsicId())
-      {
-        // register a new intrinsic edge between those views
-        newIntrinsicEdges[std::minmax(otherViewId, newViewId)] = newViewIntrinsicId;
-      }
-    }
-  }
-
-  // create registered intrinsic edges in lemon graph 
-  // and update _intrinsicEdgesId accordingly
-  for(const auto& newEdge : newIntrinsicEdges)
-  {
-    const lemon::ListGraph::Edge edge = _graph.addEdge(_nodePerViewId[newEdge.first.first], _nodePerViewId[newEdge.first.second]);
-    _intrinsicEdgesId[newEdge.second].push_back(_graph.id(edge));
-  }
-  return newIntrinsicEdges.size();
-}
-
-void LocalBundleAdjustmentGraph::removeIntrinsicEdgesFromTheGraph(IndexT intrinsicId)
+bool LocalBundleAdjustmentGraph::addEdge(IndexT viewIdA, IndexT viewIdB)
 {
-  if(_intrinsicEdgesId.count(intrinsicId) == 0)
-    return;
-  for(const int edgeId : _intrinsicEdgesId.at(intrinsicId))
-  {
-    const auto& edge = _graph.edgeFromId(edgeId);
-    assert(_graph.valid(edge));
-    _graph.erase(edge);
-  }
-  _intrinsicEdgesId.erase(intrinsicId);
+  const auto itA = _neighborsPerViewId.find(viewIdA);
+  const auto itB = _neighborsPerViewId.find(viewIdB);
+  if(viewIdA == viewIdB || itA == _neighborsPerViewId.end() || itB == _neighborsPerViewId.end())
+    return false;
+
+  // the neighbors are sorted by view id
+  std::vector<IndexT>& neighborsA = itA->second;
+  const auto posA = std::lower_bound(neighborsA.begin(), neighborsA.end(), viewIdB);
+  if(posA != neighborsA.end() && *posA == viewIdB)
+    return false; // already exists
+  neighborsA.insert(posA, viewIdB);
+
+  std::vector<IndexT>& neighborsB = itB->second;
+  neighborsB.insert(std::lower_bound(neighborsB.begin(), neighborsB.end(), viewIdA), viewIdA);
+  return true;
 }
 
-
 std::size_t LocalBundleAdjustmentGraph::updateRigEdgesToTheGraph(const sfmData::SfMData& sfmData)
 {
   std::size_t numAddedEdges = 0;
 
-  // remove all rig edges
-  for(auto& edgesPerRid: _rigEdgesId)
-  {
-    for(const int edgeId : edgesPerRid.second)
-    {
-      const auto& edge = _graph.edgeFromId(edgeId);
-      assert(_graph.valid(edge));
-      _graph.erase(edge);
-    }
-  }
-  _rigEdgesId.clear();
-
   // recreate rig edges
-  std::map<IndexT, std::vector<IndexT>> viewIdsPerRig;
+  _viewIdsPerRigId.clear();
 
-  for(const auto& viewNode : _nodePerViewId) // for each reconstructed view in the graph
+  for(const auto& viewNode : _neighborsPerViewId) // for each reconstructed view in the graph
   {
     const sfmData::View& view = sfmData.getView(viewNode.first);
     if(view.isPoseIndependant())
       continue;
-    viewIdsPerRig[view.getRigId()].push_back(viewNode.first);
+    _viewIdsPerRigId[view.getRigId()].insert(viewNode.first);
   }
 
-  for(auto& it : viewIdsPerRig)
-    std::sort(it.second.begin(), it.second.end());
-
-  for(const auto& it : viewIdsPerRig)
+  for(const auto& it : _viewIdsPerRigId)
   {
     // if(sfmData.getRig(rigId).isLocked()) // TODO
     //   continue;
-    const IndexT rigId = it.first;
-    const std::vector<IndexT>& views = it.second;
-    for(int i = 0; i < views.size(); ++i)
-    {
-      for(int j = i; j < views.size(); ++j)
-      {
-        lemon::ListGraph::Edge edge = _graph.addEdge(_nodePerViewId[views[i]], _nodePerViewId[views[j]]);
-        _rigEdgesId[rigId].push_back(_graph.id(edge));
-        numAddedEdges++;
-      }
-    }
+    const std::size_t nbViews = it.second.size();
+    numAddedEdges += nbViews * (nbViews - 1) / 2;
   }
 
   return numAddedEdges;
@@ -748,18 +715,30 @@ std::size_t LocalBundleAdjustmentGraph::updateRigEdgesToTheGraph(const sfmData::
 
 unsigned int LocalBundleAdjustmentGraph::countNodes() const
 {
-  unsigned int count = 0;
-  for(lemon::ListGraph::NodeIt n(_graph); n != lemon::INVALID; ++n)
-    ++count;
-  return count;
+  return static_cast<unsigned int>(_neighborsPerViewId.size());
 }
 
 unsigned int LocalBundleAdjustmentGraph::countEdges() const
 {
-  unsigned int count = 0;
-  for(lemon::ListGraph::EdgeIt e(_graph); e != lemon::INVALID; ++e)
-    ++count;
-  return count;
+  std::size_t count = 0;
+  for(const auto& neighborsPair : _neighborsPerViewId)
+    count += neighborsPair.second.size();
+  count /= 2; // each edge is stored by its two views
+
+  const auto countGroupEdges = [](const std::set<IndexT>& viewIds)
+  {
+    return viewIds.empty() ? 0 : viewIds.size() * (viewIds.size() - 1) / 2;
+  };
+
+  for(const auto& intrinsicViewIds : _viewIdsPerIntrinsicId)
+  {
+    if(!isFocalLengthConstant(intrinsicViewIds.first))
+      count += countGroupEdges(intrinsicViewIds.second);
+  }
+  for(const auto& rigViewIds : _viewIdsPerRigId)
+    count += countGroupEdges(rigViewIds.second);
+
+  return static_cast<unsigned int>(count);
 }
 
 } // namespace sfm
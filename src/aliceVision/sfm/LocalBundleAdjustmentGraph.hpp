@@ -10,6 +10,10 @@
 #include <aliceVision/track/Track.hpp>
 #include <aliceVision/sfm/BundleAdjustment.hpp>
 
+#include <map>
+#include <set>
+#include <vector>
+
 namespace aliceVision {
 
 namespace sfmData {
@@ -31,6 +35,7 @@ public:
 
   /**
    * @brief Return the number of posed views for each graph-distance
+   * @note The distance of the views farther than the graph-distance limit + 1 is -1.
    * @return map<distance, numViews>
    */
   std::map<int, std::size_t> getDistancesHistogram() const;
@@ -42,7 +47,7 @@ public:
    */
   inline BundleAdjustment::EParameterState getPoseState(const IndexT poseId) const
   {
-    return _statePerPoseId.at(poseId);
+    return getState(_statePerPoseId, poseId);
   }
  
   /**
@@ -62,7 +67,7 @@ public:
    */
   inline BundleAdjustment::EParameterState getLandmarkState(const IndexT landmarkId) const
   {
-    return _statePerLandmarkId.at(landmarkId);
+    return getState(_statePerLandmarkId, landmarkId);
   }
 
   /**
@@ -72,11 +77,7 @@ public:
    */
   inline std::size_t getNbPosesPerState(BundleAdjustment::EParameterState state) const
   {
-    std::size_t nb = 0;
-    for(const auto& poseStatePair : _statePerPoseId)
-      if(poseStatePair.second == state)
-        ++nb;
-    return nb;
+    return countParametersPerState(_statePerPoseId, _nbPoses, state);
   }
 
   /**
@@ -86,11 +87,7 @@ public:
    */
   inline std::size_t getNbIntrinsicsPerState(BundleAdjustment::EParameterState state) const
   {
-    std::size_t nb = 0;
-    for(const auto& intrinsicStatePair : _statePerIntrinsicId)
-      if(intrinsicStatePair.second == state)
-        ++nb;
-    return nb;
+    return countParametersPerState(_statePerIntrinsicId, _statePerIntrinsicId.size(), state);
   }
 
   /**
@@ -100,11 +97,7 @@ public:
    */
   inline std::size_t getNbLandmarksPerState(BundleAdjustment::EParameterState state) const
   {
-    std::size_t nb = 0;
-    for(const auto& landmarkStatePair : _statePerLandmarkId)
-      if(landmarkStatePair.second == state)
-        ++nb;
-    return nb;
+    return countParametersPerState(_statePerLandmarkId, _nbLandmarks, state);
   }
 
   /**
@@ -147,6 +140,7 @@ public:
   /**
    * @brief Remove specific views from the LocalBA graph. 
    * @details Delete the nodes corresponding to those views and all their incident edges.
+   *          The cost only depends on the number of neighbors of the removed views.
    * @param[in] sfmData contains all the information about the reconstruction
    * @param[in] removedViewsId Set of views index to remove
    * @return true if the number of removed node is equal to the size of \c removedViewsId
@@ -166,8 +160,10 @@ public:
       const std::size_t kMinNbOfMatches = 50);
   
   /**
-   * @brief Compute the intragraph-distance between all the nodes of the graph (posed views) and the newly resected views.
-   * @details The graph-distances are computed using a Breadth-first Search (BFS) method.
+   * @brief Compute the intragraph-distance between the nodes of the graph (posed views) and the newly resected views.
+   * @details The graph-distances are computed using a Breadth-first Search (BFS) method,
+   *          stopped at the graph-distance limit + 1: the farther views are ignored by the Local BA,
+   *          so the cost only depends on the size of the local neighborhood of the new views.
    * @param[in] sfmData contains all the information about the reconstruction, notably the posed views
    * @param[in] newReconstructedViews The list of the newly resected views used (used as source in the BFS algorithm)
    */
@@ -192,9 +188,11 @@ public:
    *     - a Landmarks is set to:
    *        - \a Ignored by default
    *        - \a Refined <=> its connected to a refined camera
+   * @note Only the parameters of the local neighborhood (distance <= D+1) are visited, the other ones are \a Ignored.
    * @param[in] sfmData contains all the information about the reconstruction
+   * @param[in] tracksPerView A map giving the tracks for each view (landmarkId == trackId)
    */
-  void convertDistancesToStates(const sfmData::SfMData& sfmData);
+  void convertDistancesToStates(const sfmData::SfMData& sfmData, const track::TracksPerView& tracksPerView);
 
   /**
    * @brief Update rigs edges.
@@ -204,13 +202,15 @@ public:
   std::size_t updateRigEdgesToTheGraph(const sfmData::SfMData& sfmData);
 
   /**
-   * @brief Count and return the number of nodes in the underlying lemon graph.
+   * @brief Count and return the number of nodes in the graph.
    * @return The number of nodes in the graph.
    */
   unsigned int countNodes() const;
 
   /**
-   * @brief Count and return the number of edges in the underlying lemon graph.
+   * @brief Count and return the number of edges in the graph.
+   * @details The intrinsic-edges and the rig-edges link all the views of a same intrinsic (or rig) together,
+   *          they are counted as the edges of a complete graph.
    * @return The number of edges in the graph.
    */
   unsigned int countEdges() const;
@@ -231,6 +231,46 @@ private:
    */
   int getViewDistance(const IndexT viewId) const;
 
+  /**
+   * @brief Return the state of a parameter, \c Ignored if it has no state
+   * @param[in] states The states of the parameters
+   * @param[in] id The parameter id
+   * @return BundleAdjustment::EParameterState
+   */
+  static inline BundleAdjustment::EParameterState getState(const std::map<IndexT, BundleAdjustment::EParameterState>& states, IndexT id)
+  {
+    const auto it = states.find(id);
+    return (it != states.end()) ? it->second : BundleAdjustment::EParameterState::IGNORED;
+  }
+
+  /**
+   * @brief Count the parameters with a given state, the parameters without state are \c Ignored
+   * @param[in] states The states of the parameters
+   * @param[in] nbParameters The total number of parameters
+   * @param[in] state The given state
+   * @return number of parameters with the given state
+   */
+  static inline std::size_t countParametersPerState(const std::map<IndexT, BundleAdjustment::EParameterState>& states,
+                                                    std::size_t nbParameters,
+                                                    BundleAdjustment::EParameterState state)
+  {
+    std::size_t nb = 0;
+    for(const auto& statePair : states)
+      if(statePair.second == state)
+        ++nb;
+    if(state == BundleAdjustment::EParameterState::IGNORED)
+      nb += nbParameters - states.size();
+    return nb;
+  }
+
+  /**
+   * @brief Add an edge between two views of the graph, if it does not already exist
+   * @param[in] viewIdA The first view
+   * @param[in] viewIdB The second view
+   * @return true if the edge has been added
+   */
+  bool addEdge(IndexT viewIdA, IndexT viewIdB);
+
   /**
    * @brief Return the state for a given distance
    * @param[in] distance between two views
@@ -243,7 +283,7 @@ private:
    * @details The file is name \a graph_<numOfNodes>_<nameComplement>.
    * Node format: [<viewId>: D<distance> K<intrinsics>].
    * Node color: red (D=0), green (D=1), blue (D=2) or black (D>2 or D=-1)
-   * Edge color: black (classic) or red (due to the intrinsic edges)
+   * Edge color: black (classic) or red (due to the intrinsic or rig edges)
    * @param[in] sfmData contains all the information about the reconstruction
    * @param[in] dir
    * @param[in] nameComplement
@@ -295,42 +335,32 @@ private:
   template<typename T> 
   static double standardDeviation(const std::vector<T>& data);
 
-  /**
-   * @brief Add an edge in the graph when 2 views share a same intrinsic not considered as Constant
-   * @param[in] sfmData contains all the information about the reconstruction
-   * @param[in] newReconstructedViews
-   * @return
-   */
-  std::size_t addIntrinsicEdgesToTheGraph(const sfmData::SfMData& sfmData, const std::set<IndexT>& newReconstructedViews);
-  
-  /**
-   * @brief Remove all the edges added by the \c addIntrinsicEdgesToTheGraph function related to .
-   * @param[in] intrinsicId
-   */
-  void removeIntrinsicEdgesFromTheGraph(IndexT intrinsicId);
-
   // Distances data
   // - Local BA needs to know the distance of all the old posed views to the new resected views.
   // - The bundle adjustment will be processed on the closest poses only.
 
-  /// A graph where nodes are poses and an edge exists when 2 poses shared at least 'kMinNbOfMatches' matches.
-  lemon::ListGraph _graph; 
   /// The graph-distance limit setting the Active region (default value: 1)
   std::size_t _graphDistanceLimit = 1;
-  /// Associates each view (indexed by its viewId) to its corresponding node in the graph.
-  std::map<IndexT, lemon::ListGraph::Node> _nodePerViewId;
-  /// Associates each node (in the graph) to its corresponding view.
-  std::map<lemon::ListGraph::Node, IndexT> _viewIdPerNode;
-  /// Store the graph-distances from the new views (0: is a new view, -1: is not connected to the new views)
+  /// The graph: each node is a posed view, with its neighbors (sharing at least 'kMinNbOfMatches' landmarks) sorted by view id.
+  std::map<IndexT, std::vector<IndexT>> _neighborsPerViewId;
+  /// The views of the graph per intrinsic: while its focal length is not constant, they are all linked by "the intrinsic-edges".
+  std::map<IndexT, std::set<IndexT>> _viewIdsPerIntrinsicId;
+  /// The views of the graph per rig: they are all linked by "the rig-edges".
+  std::map<IndexT, std::set<IndexT>> _viewIdsPerRigId;
+  /// Store the graph-distances from the new views (0: is a new view), only for the views reached by the bounded BFS
   std::map<IndexT, int> _distancePerViewId;
-  /// Store the graph-distances from the new poses (0: is a new pose, -1: is not connected to the new poses)
+  /// Store the graph-distances from the new poses (0: is a new pose), only for the poses reached by the bounded BFS
   std::map<IndexT, int> _distancePerPoseId;
-  /// Store the \c EParameterState of each pose in the scene.
+  /// Store the \c EParameterState of the poses of the local neighborhood, the other ones are ignored.
   std::map<IndexT, BundleAdjustment::EParameterState> _statePerPoseId;
   /// Store the \c EParameterState of each intrinsic in the scene.
   std::map<IndexT, BundleAdjustment::EParameterState> _statePerIntrinsicId;
-  /// Store the \c EParameterState of each landmark in the scene.
+  /// Store the \c EParameterState of the landmarks of the local neighborhood, the other ones are ignored.
   std::map<IndexT, BundleAdjustment::EParameterState> _statePerLandmarkId;
+  /// The number of poses in the scene when the states have been computed.
+  std::size_t _nbPoses = 0;
+  /// The number of landmarks in the scene when the states have been computed.
+  std::size_t _nbLandmarks = 0;
   
   // Intrinsics data
   // - Local BA needs to know the evolution of all the intrinsics parameters.
@@ -363,18 +393,6 @@ private:
    * <IntrinsicId, isConsideredAsConstant>
    */
   std::map<IndexT, bool> _mapFocalIsConstant;
-
-  /**
-   * @brief Store the Lemon index of the edges added for the intrinsic links "the intrinsic-edges"
-   * <IntrinsicId, [edgeId]>
-   */
-  std::map<IndexT, std::vector<int>> _intrinsicEdgesId;
-
-  /**
-   * @brief Store the Lemon index of the edges added for the rig links "the intrinsic-edges"
-   * <rigId, [edgeId]>
-   */
-  std::map<IndexT, std::vector<int>> _rigEdgesId;
 };
 
 } // namespace sfm
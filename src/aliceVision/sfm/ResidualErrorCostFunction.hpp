@@ -0,0 +1,302 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/numeric/numeric.hpp>
+
+#include <ceres/ceres.h>
+#include <ceres/rotation.h>
+
+// Define ceres cost functions with analytic jacobians for the most common AliceVision camera models.
+// They compute the same residuals as the autodiff functors of ResidualErrorFunctor.hpp.
+
+namespace aliceVision {
+namespace sfm {
+namespace detail {
+
+/**
+ * @brief Transform a 3D point in the camera coordinates: P = R(w) X + t
+ * @param[in] cam_Rt: Camera parameterized using one block of 6 parameters [R;t]:
+ *   - 3 for rotation(angle axis), 3 for translation
+ * @param[in] pos_3dpoint: the 3D point X
+ * @param[out] pos_proj: the 3D point P in the camera coordinates
+ * @param[out] dP_dw: the jacobian of P wrt. the angle axis w (optional)
+ * @param[out] R: the rotation matrix R(w)
+ */
+inline void transformPoint(const double* const cam_Rt,
+                           const double* const pos_3dpoint,
+                           Vec3& pos_proj,
+                           Mat3* dP_dw,
+                           Mat3& R)
+{
+  // column-major rotation matrix, as Eigen
+  ceres::AngleAxisToRotationMatrix(cam_Rt, R.data());
+
+  const Eigen::Map<const Vec3> X(pos_3dpoint);
+  const Eigen::Map<const Vec3> t(cam_Rt + 3);
+  const Vec3 RX = R * X;
+  pos_proj = RX + t;
+
+  if(dP_dw == nullptr)
+    return;
+
+  // d(R(w) X)/dw = -[R X]x Jl(w), with Jl the left jacobian of SO(3)
+  const Eigen::Map<const Vec3> w(cam_Rt);
+  const double theta2 = w.squaredNorm();
+  const Mat3 W = CrossProductMatrix(w);
+  Mat3 Jl;
+
+  if(theta2 > std::numeric_limits<double>::epsilon())
+  {
+    const double theta = std::sqrt(theta2);
+    Jl = Mat3::Identity() + ((1.0 - std::cos(theta)) / theta2) * W + ((theta - std::sin(theta)) / (theta2 * theta)) * W * W;
+  }
+  else
+  {
+    // first order expansion, as ceres::AngleAxisRotatePoint
+    Jl = Mat3::Identity() + 0.5 * W;
+  }
+
+  *dP_dw = -CrossProductMatrix(RX) * Jl;
+}
+
+/**
+ * @brief Fill the pose and the 3D point jacobians from the jacobian of the residuals wrt. P
+ * @param[in] dRes_dP: the jacobian of the residuals wrt. the 3D point in the camera coordinates
+ * @param[in] dP_dw: the jacobian of P wrt. the angle axis
+ * @param[in] R: the rotation matrix
+ * @param[out] jacobians: the ceres jacobians, [intrinsics, pose, 3D point], row-major
+ */
+inline void fillPoseAndPointJacobians(const Mat23& dRes_dP,
+                                      const Mat3& dP_dw,
+                                      const Mat3& R,
+                                      double** jacobians)
+{
+  if(jacobians[1] != nullptr)
+  {
+    Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> dRes_dRt(jacobians[1]);
+    dRes_dRt.leftCols<3>() = dRes_dP * dP_dw;
+    dRes_dRt.rightCols<3>() = dRes_dP;
+  }
+
+  if(jacobians[2] != nullptr)
+  {
+    Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> dRes_dX(jacobians[2]);
+    dRes_dX = dRes_dP * R;
+  }
+}
+
+/**
+ * @brief Jacobian of the perspective division (x_u, y_u) = (P_x / P_z, P_y / P_z)
+ */
+inline Mat23 perspectiveJacobian(const Vec3& pos_proj)
+{
+  const double invZ = 1.0 / pos_proj(2);
+  Mat23 J;
+  J << invZ, 0.0, -pos_proj(0) * invZ * invZ,
+       0.0, invZ, -pos_proj(1) * invZ * invZ;
+  return J;
+}
+
+} // namespace detail
+
+/**
+ * @brief Ceres cost function with analytic jacobians to use a PinholeRadialK3
+ *
+ *  Data parameter blocks are the following <2,6,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - 6 => the intrinsic data block [focal, principal point x, principal point y, K1, K2, K3],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ *
+ * @see ResidualErrorFunctor_PinholeRadialK3
+ */
+class ResidualErrorCostFunction_PinholeRadialK3 : public ceres::SizedCostFunction<2, 6, 6, 3>
+{
+public:
+  ResidualErrorCostFunction_PinholeRadialK3(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  // Enum to map intrinsics parameters between aliceVision & ceres camera data parameter block.
+  enum {
+    OFFSET_FOCAL_LENGTH = 0,
+    OFFSET_PRINCIPAL_POINT_X = 1,
+    OFFSET_PRINCIPAL_POINT_Y = 2,
+    OFFSET_DISTO_K1 = 3,
+    OFFSET_DISTO_K2 = 4,
+    OFFSET_DISTO_K3 = 5,
+  };
+
+  bool Evaluate(double const* const* parameters, double* out_residuals, double** jacobians) const override
+  {
+    const double* const cam_K = parameters[0];
+    const double focal = cam_K[OFFSET_FOCAL_LENGTH];
+    const double k1 = cam_K[OFFSET_DISTO_K1];
+    const double k2 = cam_K[OFFSET_DISTO_K2];
+    const double k3 = cam_K[OFFSET_DISTO_K3];
+
+    const bool computeJacobians = (jacobians != nullptr);
+    const bool computePoseJacobian = computeJacobians && (jacobians[1] != nullptr);
+
+    // Apply external parameters (Pose)
+    Vec3 pos_proj;
+    Mat3 R;
+    Mat3 dP_dw;
+    detail::transformPoint(parameters[1], parameters[2], pos_proj, computePoseJacobian ? &dP_dw : nullptr, R);
+
+    // Transform the point from homogeneous to euclidean (undistorted point)
+    const double x_u = pos_proj(0) / pos_proj(2);
+    const double y_u = pos_proj(1) / pos_proj(2);
+
+    // Apply distortion (xd,yd) = disto(x_u,y_u)
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = (1.0 + k1*r2 + k2*r4 + k3*r6);
+    const double x_d = x_u * r_coeff;
+    const double y_d = y_u * r_coeff;
+
+    // Apply focal length and principal point to get the final image coordinates
+    out_residuals[0] = cam_K[OFFSET_PRINCIPAL_POINT_X] + focal * x_d - m_pos_2dpoint[0];
+    out_residuals[1] = cam_K[OFFSET_PRINCIPAL_POINT_Y] + focal * y_d - m_pos_2dpoint[1];
+
+    if(!computeJacobians)
+      return true;
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> dRes_dK(jacobians[0]);
+      dRes_dK << x_d, 1.0, 0.0, focal * x_u * r2, focal * x_u * r4, focal * x_u * r6,
+                 y_d, 0.0, 1.0, focal * y_u * r2, focal * y_u * r4, focal * y_u * r6;
+    }
+
+    if(jacobians[1] != nullptr || jacobians[2] != nullptr)
+    {
+      // d(r_coeff)/d(r2)
+      const double dCoeff_dr2 = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+
+      Eigen::Matrix2d dD_dU;
+      dD_dU << r_coeff + 2.0 * x_u * x_u * dCoeff_dr2, 2.0 * x_u * y_u * dCoeff_dr2,
+               2.0 * x_u * y_u * dCoeff_dr2, r_coeff + 2.0 * y_u * y_u * dCoeff_dr2;
+
+      const Mat23 dRes_dP = focal * dD_dU * detail::perspectiveJacobian(pos_proj);
+      detail::fillPoseAndPointJacobians(dRes_dP, dP_dw, R, jacobians);
+    }
+
+    return true;
+  }
+
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+/**
+ * @brief Ceres cost function with analytic jacobians to use a PinholeBrownT2
+ *
+ *  Data parameter blocks are the following <2,8,6,3>
+ *  - 2 => dimension of the residuals,
+ *  - 8 => the intrinsic data block [focal, principal point x, principal point y, K1, K2, K3, T1, T2],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ *
+ * @see ResidualErrorFunctor_PinholeBrownT2
+ */
+class ResidualErrorCostFunction_PinholeBrownT2 : public ceres::SizedCostFunction<2, 8, 6, 3>
+{
+public:
+  ResidualErrorCostFunction_PinholeBrownT2(const double* const pos_2dpoint)
+  {
+    m_pos_2dpoint[0] = pos_2dpoint[0];
+    m_pos_2dpoint[1] = pos_2dpoint[1];
+  }
+
+  // Enum to map intrinsics parameters between aliceVision & ceres camera data parameter block.
+  enum {
+    OFFSET_FOCAL_LENGTH = 0,
+    OFFSET_PRINCIPAL_POINT_X = 1,
+    OFFSET_PRINCIPAL_POINT_Y = 2,
+    OFFSET_DISTO_K1 = 3,
+    OFFSET_DISTO_K2 = 4,
+    OFFSET_DISTO_K3 = 5,
+    OFFSET_DISTO_T1 = 6,
+    OFFSET_DISTO_T2 = 7,
+  };
+
+  bool Evaluate(double const* const* parameters, double* out_residuals, double** jacobians) const override
+  {
+    const double* const cam_K = parameters[0];
+    const double focal = cam_K[OFFSET_FOCAL_LENGTH];
+    const double k1 = cam_K[OFFSET_DISTO_K1];
+    const double k2 = cam_K[OFFSET_DISTO_K2];
+    const double k3 = cam_K[OFFSET_DISTO_K3];
+    const double t1 = cam_K[OFFSET_DISTO_T1];
+    const double t2 = cam_K[OFFSET_DISTO_T2];
+
+    const bool computeJacobians = (jacobians != nullptr);
+    const bool computePoseJacobian = computeJacobians && (jacobians[1] != nullptr);
+
+    // Apply external parameters (Pose)
+    Vec3 pos_proj;
+    Mat3 R;
+    Mat3 dP_dw;
+    detail::transformPoint(parameters[1], parameters[2], pos_proj, computePoseJacobian ? &dP_dw : nullptr, R);
+
+    // Transform the point from homogeneous to euclidean (undistorted point)
+    const double x_u = pos_proj(0) / pos_proj(2);
+    const double y_u = pos_proj(1) / pos_proj(2);
+
+    // Apply distortion (xd,yd) = disto(x_u,y_u)
+    const double r2 = x_u*x_u + y_u*y_u;
+    const double r4 = r2 * r2;
+    const double r6 = r4 * r2;
+    const double r_coeff = (1.0 + k1*r2 + k2*r4 + k3*r6);
+    const double t_x = t2 * (r2 + 2.0 * x_u*x_u) + 2.0 * t1 * x_u * y_u;
+    const double t_y = t1 * (r2 + 2.0 * y_u*y_u) + 2.0 * t2 * x_u * y_u;
+    const double x_d = x_u * r_coeff + t_x;
+    const double y_d = y_u * r_coeff + t_y;
+
+    // Apply focal length and principal point to get the final image coordinates
+    out_residuals[0] = cam_K[OFFSET_PRINCIPAL_POINT_X] + focal * x_d - m_pos_2dpoint[0];
+    out_residuals[1] = cam_K[OFFSET_PRINCIPAL_POINT_Y] + focal * y_d - m_pos_2dpoint[1];
+
+    if(!computeJacobians)
+      return true;
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 8, Eigen::RowMajor>> dRes_dK(jacobians[0]);
+      dRes_dK << x_d, 1.0, 0.0, focal * x_u * r2, focal * x_u * r4, focal * x_u * r6, focal * 2.0 * x_u * y_u, focal * (r2 + 2.0 * x_u*x_u),
+                 y_d, 0.0, 1.0, focal * y_u * r2, focal * y_u * r4, focal * y_u * r6, focal * (r2 + 2.0 * y_u*y_u), focal * 2.0 * x_u * y_u;
+    }
+
+    if(jacobians[1] != nullptr || jacobians[2] != nullptr)
+    {
+      // d(r_coeff)/d(r2)
+      const double dCoeff_dr2 = k1 + 2.0 * k2 * r2 + 3.0 * k3 * r4;
+
+      Eigen::Matrix2d dD_dU;
+      dD_dU << r_coeff + 2.0 * x_u * x_u * dCoeff_dr2 + 6.0 * t2 * x_u + 2.0 * t1 * y_u,
+               2.0 * x_u * y_u * dCoeff_dr2 + 2.0 * t2 * y_u + 2.0 * t1 * x_u,
+               2.0 * x_u * y_u * dCoeff_dr2 + 2.0 * t1 * x_u + 2.0 * t2 * y_u,
+               r_coeff + 2.0 * y_u * y_u * dCoeff_dr2 + 6.0 * t1 * y_u + 2.0 * t2 * x_u;
+
+      const Mat23 dRes_dP = focal * dD_dU * detail::perspectiveJacobian(pos_proj);
+      detail::fillPoseAndPointJacobians(dRes_dP, dP_dw, R, jacobians);
+    }
+
+    return true;
+  }
+
+  double m_pos_2dpoint[2]; // The 2D observation
+};
+
+} // namespace sfm
+} // namespace aliceVision
@@ -6,9 +6,12 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorCostFunction.hpp>
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/multiview/NViewDataSet.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <iostream>
@@ -29,6 +32,9 @@ SfMData getInputScene(const NViewDataSet& d, const NViewDatasetConfigurator& con
 
 track::TracksPerView getTracksPerViews(const SfMData& sfmData);
 
+template<typename Functor, typename CostFunction, int NbIntrinsicParams>
+void checkAnalyticJacobians(const double* const cam_K, const double* const cam_Rt);
+
 // Test summary:
 // - Create a SfMData scene from a synthetic dataset
 //   - since random noise have been added on 2d data point (initial residual is not small)
@@ -136,6 +142,115 @@ BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_EffectiveMinimization_PinholeFisheye)
   BOOST_CHECK(dResidual_before > dResidual_after);
 }
 
+// Test summary:
+// - Evaluate the analytic cost functions and the autodiff functors of the same camera models
+// - Check that the residuals and the jacobians are the same
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_AnalyticJacobians)
+{
+  const double cam_Rt[6] = {0.3, -0.2, 0.1, 0.5, -0.3, 4.0};
+  const double cam_Rt_identity[6] = {0.0, 0.0, 0.0, 0.5, -0.3, 4.0};
+
+  const double cam_K_radialK3[6] = {800.0, 320.0, 240.0, 0.1, -0.05, 0.01};
+  checkAnalyticJacobians<ResidualErrorFunctor_PinholeRadialK3, ResidualErrorCostFunction_PinholeRadialK3, 6>(cam_K_radialK3, cam_Rt);
+  checkAnalyticJacobians<ResidualErrorFunctor_PinholeRadialK3, ResidualErrorCostFunction_PinholeRadialK3, 6>(cam_K_radialK3, cam_Rt_identity);
+
+  const double cam_K_brownT2[8] = {800.0, 320.0, 240.0, 0.1, -0.05, 0.01, 0.002, -0.003};
+  checkAnalyticJacobians<ResidualErrorFunctor_PinholeBrownT2, ResidualErrorCostFunction_PinholeBrownT2, 8>(cam_K_brownT2, cam_Rt);
+  checkAnalyticJacobians<ResidualErrorFunctor_PinholeBrownT2, ResidualErrorCostFunction_PinholeBrownT2, 8>(cam_K_brownT2, cam_Rt_identity);
+}
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_EffectiveMinimization_PinholeBrownT2_AutoDiff)
+{
+  const int nviews = 3;
+  const int npoints = 6;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA_BROWN);
+
+  const double dResidual_before = RMSE(sfmData);
+
+  // Call the BA interface with the autodiff cost functions only
+  BundleAdjustmentCeres::CeresOptions options;
+  options.analyticJacobianIntrinsics.clear();
+  std::shared_ptr<BundleAdjustment> ba_object = std::make_shared<BundleAdjustmentCeres>(options);
+  BOOST_CHECK( ba_object->adjust(sfmData) );
+
+  const double dResidual_after = RMSE(sfmData);
+  BOOST_CHECK(dResidual_before > dResidual_after);
+}
+
+// Test summary:
+// - Adjust a scene with a persistent problem
+// - Modify the scene (new observation, removed observation, removed landmark, new landmark) and adjust it again
+// - Check that the updated problem gives the same result as a new problem
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_PersistentProblem)
+{
+  const int nviews = 4;
+  const int npoints = 8;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA_RADIAL3);
+
+  // the last view only sees the first landmark
+  for(int i = 1; i < npoints; ++i)
+    sfmData.structure.at(i).observations.erase(3);
+
+  BundleAdjustmentCeres::CeresOptions options;
+  options.usePersistentProblem = true;
+  BundleAdjustmentCeres persistentBA(options);
+  BOOST_CHECK( persistentBA.adjust(sfmData) );
+
+  // modify the scene
+  sfmData.structure.at(1).observations[3] = Observation(d._x[3].col(1), 1);
+  sfmData.structure.at(2).observations.erase(0);
+  sfmData.structure.erase(3);
+  Landmark landmark = sfmData.structure.at(4);
+  sfmData.structure[npoints] = landmark;
+
+  SfMData sfmDataReference = sfmData;
+
+  const double dResidual_before = RMSE(sfmData);
+  BOOST_CHECK( persistentBA.adjust(sfmData) );
+  BOOST_CHECK(dResidual_before > RMSE(sfmData));
+
+  BundleAdjustmentCeres::CeresOptions referenceOptions;
+  BundleAdjustmentCeres referenceBA(referenceOptions);
+  BOOST_CHECK( referenceBA.adjust(sfmDataReference) );
+
+  BOOST_CHECK_EQUAL(persistentBA.getStatistics().nbResidualBlocks, referenceBA.getStatistics().nbResidualBlocks);
+  BOOST_CHECK_SMALL(RMSE(sfmData) - RMSE(sfmDataReference), 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_LandmarksSubsampling)
+{
+  const int nviews = 4;
+  const int npoints = 30;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA_RADIAL3);
+
+  const double dResidual_before = RMSE(sfmData);
+
+  // refine the cameras with 8 landmarks per view, the other landmarks are retriangulated
+  BundleAdjustmentCeres::CeresOptions options;
+  options.landmarksSubsamplingMaxPerView = 8;
+  options.landmarksSubsamplingMinObservations = 0;
+  BundleAdjustmentCeres ba(options);
+  BOOST_CHECK( ba.adjust(sfmData) );
+
+  BOOST_CHECK(dResidual_before > RMSE(sfmData));
+  BOOST_CHECK(ba.getStatistics().nbRetriangulatedLandmarks > 0);
+  BOOST_CHECK(ba.getStatistics().nbResidualBlocks < nviews * npoints);
+}
+
 BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_CamerasRing)
 {
   const int nviews = 4;
@@ -206,10 +321,10 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   // 2. Compute the graph-distance between each newly reconstructed views and all the reconstructed views
   localBAGraph->computeGraphDistances(sfmData, newReconstructedViews);
   // 3. Use the graph-distances to assign a LBA state (Refine, Constant & Ignore) for each parameter (poses, intrinsics & landmarks)
-  localBAGraph->convertDistancesToStates(sfmData);
+  localBAGraph->convertDistancesToStates(sfmData, tracksPerView);
 
   BOOST_CHECK_EQUAL(localBAGraph->countNodes(), 4); // 4 views => 4 nodes
-  BOOST_CHECK_EQUAL(localBAGraph->countEdges(), 6); // landmarks connections: 6 edges created (see scheme)
+  BOOST_CHECK_EQUAL(localBAGraph->countEdges(), 3); // landmarks connections: 3 edges created (see scheme)
 
   BOOST_CHECK_EQUAL(localBAGraph->getNbPosesPerState(BundleAdjustment::EParameterState::REFINED), 2);     // v0 & v1
   BOOST_CHECK_EQUAL(localBAGraph->getNbPosesPerState(BundleAdjustment::EParameterState::CONSTANT), 1);    // v2
@@ -349,3 +464,39 @@ track::TracksPerView getTracksPerViews(const SfMData& sfmData)
   return tracksPerView;
 }
 
+template<typename Functor, typename CostFunction, int NbIntrinsicParams>
+void checkAnalyticJacobians(const double* const cam_K, const double* const cam_Rt)
+{
+  const double observation[2] = {310.0, 250.0};
+  const double pos_3dpoint[3] = {0.4, -0.2, 1.5};
+  const double* parameters[3] = {cam_K, cam_Rt, pos_3dpoint};
+
+  ceres::AutoDiffCostFunction<Functor, 2, NbIntrinsicParams, 6, 3> autoDiffCostFunction(new Functor(observation));
+  CostFunction analyticCostFunction(observation);
+
+  double autoDiffResiduals[2];
+  double autoDiffJacobianK[2 * NbIntrinsicParams], autoDiffJacobianRt[2 * 6], autoDiffJacobianX[2 * 3];
+  double* autoDiffJacobians[3] = {autoDiffJacobianK, autoDiffJacobianRt, autoDiffJacobianX};
+  BOOST_CHECK(autoDiffCostFunction.Evaluate(parameters, autoDiffResiduals, autoDiffJacobians));
+
+  double analyticResiduals[2];
+  double analyticJacobianK[2 * NbIntrinsicParams], analyticJacobianRt[2 * 6], analyticJacobianX[2 * 3];
+  double* analyticJacobians[3] = {analyticJacobianK, analyticJacobianRt, analyticJacobianX};
+  BOOST_CHECK(analyticCostFunction.Evaluate(parameters, analyticResiduals, analyticJacobians));
+
+  for(int i = 0; i < 2; ++i)
+    BOOST_CHECK_SMALL(analyticResiduals[i] - autoDiffResiduals[i], 1e-9);
+
+  const int blockSizes[3] = {NbIntrinsicParams, 6, 3};
+  for(int b = 0; b < 3; ++b)
+  {
+    for(int i = 0; i < 2 * blockSizes[b]; ++i)
+      BOOST_CHECK_SMALL(analyticJacobians[b][i] - autoDiffJacobians[b][i], 1e-6 * std::max(1.0, std::abs(autoDiffJacobians[b][i])));
+  }
+
+  // the jacobians of the constant blocks are not requested
+  double* poseOnlyJacobians[3] = {nullptr, analyticJacobianRt, nullptr};
+  BOOST_CHECK(analyticCostFunction.Evaluate(parameters, analyticResiduals, poseOnlyJacobians));
+  for(int i = 0; i < 2 * 6; ++i)
+    BOOST_CHECK_SMALL(analyticJacobianRt[i] - autoDiffJacobianRt[i], 1e-6 * std::max(1.0, std::abs(autoDiffJacobianRt[i])));
+}
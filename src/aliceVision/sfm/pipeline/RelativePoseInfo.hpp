@@ -43,6 +43,8 @@ struct RelativePoseInfo
   std::vector<size_t> vec_inliers;
   double initial_residual_tolerance;
   double found_residual_precision;
+  /// find the best NFA of ACRANSAC from a histogram of the residuals with this number of bins (0 to sort the residuals)
+  std::size_t nbHistogramBins = 0;
 
   RelativePoseInfo()
     :initial_residual_tolerance(std::numeric_limits<double>::infinity()),
@@ -162,49 +162,56 @@ void GlobalSfMRotationAveragingSolver::TripletRotationRejection(
   std::vector< graph::Triplet > vec_triplets_validated;
   vec_triplets_validated.reserve(vec_triplets.size());
 
-  std::vector<float> vec_errToIdentityPerTriplet;
-  vec_errToIdentityPerTriplet.reserve(vec_triplets.size());
   // Compute the composition error for each length 3 cycles
-  for (size_t i = 0; i < vec_triplets.size(); ++i)
+  // (read only access to the relative rotations, one output per triplet)
+  std::vector<float> vec_errToIdentityPerTriplet(vec_triplets.size());
+
+  #pragma omp parallel for schedule(static)
+  for (int i = 0; i < static_cast<int>(vec_triplets.size()); ++i)
   {
     const graph::Triplet & triplet = vec_triplets[i];
     const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
 
     //-- Find the three relative rotations
     const Pair ij(I,J), ji(J,I);
-    const Mat3 RIJ = (map_relatives.count(ij)) ?
-      map_relatives.at(ij).Rij : Mat3(map_relatives.at(ji).Rij.transpose());
+    const auto itIJ = map_relatives.find(ij);
+    const Mat3 RIJ = (itIJ != map_relatives.end()) ?
+      itIJ->second.Rij : Mat3(map_relatives.at(ji).Rij.transpose());
 
     const Pair jk(J,K), kj(K,J);
-    const Mat3 RJK = (map_relatives.count(jk)) ?
-      map_relatives.at(jk).Rij : Mat3(map_relatives.at(kj).Rij.transpose());
+    const auto itJK = map_relatives.find(jk);
+    const Mat3 RJK = (itJK != map_relatives.end()) ?
+      itJK->second.Rij : Mat3(map_relatives.at(kj).Rij.transpose());
 
     const Pair ki(K,I), ik(I,K);
-    const Mat3 RKI = (map_relatives.count(ki)) ?
-      map_relatives.at(ki).Rij : Mat3(map_relatives.at(ik).Rij.transpose());
+    const auto itKI = map_relatives.find(ki);
+    const Mat3 RKI = (itKI != map_relatives.end()) ?
+      itKI->second.Rij : Mat3(map_relatives.at(ik).Rij.transpose());
 
     const Mat3 Rot_To_Identity = RIJ * RJK * RKI; // motion composition
-    const float angularErrorDegree = static_cast<float>(radianToDegree(getRotationMagnitude(Rot_To_Identity)));
-    vec_errToIdentityPerTriplet.push_back(angularErrorDegree);
+    vec_errToIdentityPerTriplet[i] = static_cast<float>(radianToDegree(getRotationMagnitude(Rot_To_Identity)));
+  }
+
+  // Keep the edges of the valid cycles
+  const auto keepEdge = [&](const Pair& edge)
+  {
+    const Pair reverseEdge(edge.second, edge.first);
+    if (map_relatives.count(edge))
+      map_relatives_validated[edge] = map_relatives.at(edge);
+    else
+      map_relatives_validated[reverseEdge] = map_relatives.at(reverseEdge);
+  };
 
-    if (angularErrorDegree < max_angular_error)
+  for (size_t i = 0; i < vec_triplets.size(); ++i)
+  {
+    if (vec_errToIdentityPerTriplet[i] < max_angular_error)
     {
+      const graph::Triplet & triplet = vec_triplets[i];
       vec_triplets_validated.push_back(triplet);
 
-      if (map_relatives.count(ij))
-        map_relatives_validated[ij] = map_relatives.at(ij);
-      else
-        map_relatives_validated[ji] = map_relatives.at(ji);
-
-      if (map_relatives.count(jk))
-        map_relatives_validated[jk] = map_relatives.at(jk);
-      else
-        map_relatives_validated[kj] = map_relatives.at(kj);
-
-      if (map_relatives.count(ki))
-        map_relatives_validated[ki] = map_relatives.at(ki);
-      else
-        map_relatives_validated[ik] = map_relatives.at(ik);
+      keepEdge(Pair(triplet.i, triplet.j));
+      keepEdge(Pair(triplet.j, triplet.k));
+      keepEdge(Pair(triplet.k, triplet.i));
     }
   }
   map_relatives = std::move(map_relatives_validated);
@@ -11,10 +11,10 @@
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/pipeline/global/reindexGlobalSfM.hpp>
-#include <aliceVision/sfm/pipeline/global/MutexSet.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/multiview/translationAveraging/common.hpp>
 #include <aliceVision/multiview/translationAveraging/solver.hpp>
+#include <aliceVision/multiview/translationAveraging/subsampling.hpp>
 #include <aliceVision/graph/graph.hpp>
 #include <aliceVision/track/Track.hpp>
 #include <aliceVision/stl/stl.hpp>
@@ -32,6 +32,8 @@
 
 #include <boost/progress.hpp>
 
+#include <atomic>
+
 namespace aliceVision {
 namespace sfm {
 
@@ -77,6 +79,14 @@ bool GlobalSfMTranslationAveragingSolver::Translation_averaging(ETranslationAver
   //-- GLOBAL TRANSLATIONS ESTIMATION from initial triplets t_ij guess
   //-------------------
 
+  // Reduce the redundant graphs of relative translations (the triplets are kept together)
+  if(m_maxTripletsPerPose > 0)
+  {
+    translationAveraging::RelativeInfoVec keptEstimates;
+    translationAveraging::subsampleRelativeEstimates(m_vec_initialRijTijEstimates, m_vec_initialTripletScores, 3, m_maxTripletsPerPose, keptEstimates);
+    m_vec_initialRijTijEstimates.swap(keptEstimates);
+  }
+
   // Keep the largest Biedge connected component graph of relative translations
   PairSet pairs;
   std::transform(m_vec_initialRijTijEstimates.begin(), m_vec_initialRijTijEstimates.end(),
@@ -294,6 +304,7 @@ void GlobalSfMTranslationAveragingSolver::Compute_translations(const SfMData& sf
     normalizedFeaturesPerView,
     pairwiseMatches,
     m_vec_initialRijTijEstimates,
+    m_vec_initialTripletScores,
     tripletWise_matches);
 }
 
@@ -304,6 +315,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
   const feature::FeaturesPerView & normalizedFeaturesPerView,
   const matching::PairwiseMatches & pairwiseMatches,
   translationAveraging::RelativeInfoVec & vec_initialEstimates,
+  std::vector<double> & vec_initialTripletScores,
   matching::PairwiseMatches & newpairMatches)
 {
   aliceVision::system::Timer timerLP_triplet;
@@ -345,8 +357,19 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     // Avoid to cover each edge of the graph by using an edge coverage algorithm
     // An estimated triplets of translation mark three edges as estimated.
 
+    //-- list the view pairs of each pose edge, to avoid a scan of all the matches per triplet
+    std::map<Pair, std::vector<matching::PairwiseMatches::const_iterator>> map_matches_perPoseEdge;
+    for (auto match_iterator = pairwiseMatches.begin(); match_iterator != pairwiseMatches.end(); ++match_iterator)
+    {
+      const Pair pair = match_iterator->first;
+      const IndexT poseI = sfmData.getViews().at(pair.first)->getPoseId();
+      const IndexT poseJ = sfmData.getViews().at(pair.second)->getPoseId();
+      if (poseI != poseJ)
+        map_matches_perPoseEdge[std::make_pair(std::min(poseI, poseJ), std::max(poseI, poseJ))].push_back(match_iterator);
+    }
+
     //-- precompute the number of track per triplet:
-    HashMap<IndexT, IndexT> map_tracksPerTriplets;
+    std::vector<IndexT> vec_tracksPerTriplets(vec_triplets.size(), 0);
 
     #pragma omp parallel for schedule(dynamic)
     for (int i = 0; i < (int)vec_triplets.size(); ++i)
@@ -354,20 +377,14 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
       // List matches that belong to the triplet of poses
       const graph::Triplet & triplet = vec_triplets[i];
       matching::PairwiseMatches map_triplet_matches;
-      const std::set<IndexT> set_triplet_pose_ids = {triplet.i, triplet.j, triplet.k};
-      // List shared correspondences (pairs) between the triplet poses
-      for (const auto & match_iterator : pairwiseMatches)
+      // List shared correspondences (pairs) between the triplet poses (triplet ids are sorted)
+      for (const Pair & poseEdge : {Pair(triplet.i, triplet.j), Pair(triplet.i, triplet.k), Pair(triplet.j, triplet.k)})
       {
-        const Pair pair = match_iterator.first;
-        const View * v1 = sfmData.getViews().at(pair.first).get();
-        const View * v2 = sfmData.getViews().at(pair.second).get();
-        if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-            (v1->getPoseId() != v2->getPoseId())
-            && set_triplet_pose_ids.count(v1->getPoseId())
-            && set_triplet_pose_ids.count(v2->getPoseId()))
-        {
-          map_triplet_matches.insert( match_iterator );
-        }
+        const auto it = map_matches_perPoseEdge.find(poseEdge);
+        if (it == map_matches_perPoseEdge.end())
+          continue;
+        for (const auto & match_iterator : it->second)
+          map_triplet_matches.insert(*match_iterator);
       }
       // Compute tracks:
       {
@@ -375,8 +392,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         tracksBuilder.build(map_triplet_matches);
         tracksBuilder.filter(3);
 
-        #pragma omp critical
-        map_tracksPerTriplets[i] = tracksBuilder.nbTracks(); //count the # of matches in the UF tree
+        vec_tracksPerTriplets[i] = tracksBuilder.nbTracks(); //count the # of matches in the UF tree
       }
     }
 
@@ -392,11 +408,25 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
       map_tripletIds_perEdge[std::make_pair(triplet.j, triplet.k)].push_back(i);
     }
 
-    // Collect edges that are covered by the triplets
+    // Collect edges that are covered by the triplets (sorted)
     std::vector<myEdge > vec_edges;
     std::transform(map_tripletIds_perEdge.begin(), map_tripletIds_perEdge.end(), std::back_inserter(vec_edges), stl::RetrieveKey());
 
-    aliceVision::sfm::MutexSet<myEdge> m_mutexSet;
+    // Estimated edges: one flag per edge, set without lock by the thread that estimates a triplet
+    std::vector<std::atomic<bool>> vec_edgeEstimated(vec_edges.size());
+    for (auto & edgeEstimated : vec_edgeEstimated)
+      edgeEstimated = false;
+    std::atomic<std::size_t> nbEstimatedEdges(0);
+
+    const auto edgeIndex = [&vec_edges](const myEdge & edge) -> std::size_t
+    {
+      return std::lower_bound(vec_edges.begin(), vec_edges.end(), edge) - vec_edges.begin();
+    };
+    const auto markEstimated = [&](const myEdge & edge)
+    {
+      if (!vec_edgeEstimated[edgeIndex(edge)].exchange(true))
+        ++nbEstimatedEdges;
+    };
 
     boost::progress_display my_progress_bar(
       vec_edges.size(),
@@ -405,6 +435,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
 
     // set number of threads, 1 if openMP is not enabled  
     std::vector<translationAveraging::RelativeInfoVec> initial_estimates(omp_get_max_threads());
+    std::vector<std::vector<double>> initial_scores(omp_get_max_threads());
     const bool bVerbose = false;
 
     #pragma omp parallel for schedule(dynamic)
@@ -415,7 +446,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
       {
         ++my_progress_bar;
       }
-      if (m_mutexSet.count(edge) == 0 && m_mutexSet.size() != vec_edges.size())
+      if (!vec_edgeEstimated[k] && nbEstimatedEdges != vec_edges.size())
       {
         // Find the triplets that support the given edge
         const auto & vec_possibleTripletIndexes = map_tripletIds_perEdge.at(edge);
@@ -424,7 +455,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         std::vector<size_t> vec_commonTracksPerTriplets;
         for (const size_t triplet_index : vec_possibleTripletIndexes)
         {
-          vec_commonTracksPerTriplets.push_back(map_tracksPerTriplets[triplet_index]);
+          vec_commonTracksPerTriplets.push_back(vec_tracksPerTriplets[triplet_index]);
         }
 
         using namespace stl::indexed_sort;
@@ -442,9 +473,9 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
           const graph::Triplet & triplet = vec_triplets[triplet_index];
 
           // If the triplet is already estimated by another thread; try the next one
-          if (m_mutexSet.count(Pair(triplet.i, triplet.j)) &&
-              m_mutexSet.count(Pair(triplet.i, triplet.k)) &&
-              m_mutexSet.count(Pair(triplet.j, triplet.k)))
+          if (vec_edgeEstimated[edgeIndex(Pair(triplet.i, triplet.j))] &&
+              vec_edgeEstimated[edgeIndex(Pair(triplet.i, triplet.k))] &&
+              vec_edgeEstimated[edgeIndex(Pair(triplet.j, triplet.k))])
           {
             break;
           }
@@ -474,9 +505,9 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
           if (bTriplet_estimation)
           {
             // Since new translation edges have been computed, mark their corresponding edges as estimated
-            m_mutexSet.insert(std::make_pair(triplet.i, triplet.j));
-            m_mutexSet.insert(std::make_pair(triplet.j, triplet.k));
-            m_mutexSet.insert(std::make_pair(triplet.i, triplet.k));
+            markEstimated(std::make_pair(triplet.i, triplet.j));
+            markEstimated(std::make_pair(triplet.j, triplet.k));
+            markEstimated(std::make_pair(triplet.i, triplet.k));
 
             // Compute the triplet relative motions (IJ, JK, IK)
             {
@@ -510,6 +541,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
                 std::make_pair(triplet.j, triplet.k), std::make_pair(Rjk, tjk));
               initial_estimates[thread_id].emplace_back(
                 std::make_pair(triplet.i, triplet.k), std::make_pair(Rik, tik));
+              initial_scores[thread_id].push_back(vec_inliers.size());
 
               //--- ATOMIC
               #pragma omp critical
@@ -564,6 +596,8 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         vec_initialEstimates.emplace_back(val);
       }
     }
+    for(const auto & scores : initial_scores)
+      vec_initialTripletScores.insert(vec_initialTripletScores.end(), scores.begin(), scores.end());
   }
 
 
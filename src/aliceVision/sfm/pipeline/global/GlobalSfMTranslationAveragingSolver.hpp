@@ -27,9 +27,22 @@ enum ETranslationAveragingMethod
 class GlobalSfMTranslationAveragingSolver
 {
   translationAveraging::RelativeInfoVec m_vec_initialRijTijEstimates;
+  /// number of inliers of each triplet of m_vec_initialRijTijEstimates
+  std::vector<double> m_vec_initialTripletScores;
+  /// number of best triplets kept per pose (0: all the triplets are kept)
+  std::size_t m_maxTripletsPerPose;
 
 public:
 
+  /**
+   * @param[in] maxTripletsPerPose Subsampling of the relative translations of redundant graphs:
+   *            number of best triplets kept per pose, in addition to a spanning set of triplets
+   *            (0: all the triplets are kept)
+   */
+  explicit GlobalSfMTranslationAveragingSolver(std::size_t maxTripletsPerPose = 0)
+    : m_maxTripletsPerPose(maxTripletsPerPose)
+  {}
+
   /**
    * @brief Use features in normalized camera frames
    */
@@ -62,6 +75,7 @@ private:
            const feature::FeaturesPerView& normalizedFeaturesPerView,
            const matching::PairwiseMatches& pairwiseMatches,
            translationAveraging::RelativeInfoVec& vec_initialEstimates,
+           std::vector<double>& vec_initialTripletScores,
            matching::PairwiseMatches& newpairMatches);
 
   /**
@@ -16,6 +16,7 @@
 #include <aliceVision/multiview/essential.hpp>
 #include <aliceVision/track/Track.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include <dependencies/htmlDoc/htmlDoc.hpp>
 
@@ -113,6 +114,8 @@ void ReconstructionEngine_globalSfM::SetTranslationAveragingMethod(ETranslationA
 
 bool ReconstructionEngine_globalSfM::process()
 {
+  ALICEVISION_PROFILE_SCOPE("globalSfM::process");
+
   // keep only the largest biedge connected subgraph
   {
     const PairSet pairs = matching::getImagePairs(*_pairwiseMatches);
@@ -177,6 +180,8 @@ bool ReconstructionEngine_globalSfM::process()
 bool ReconstructionEngine_globalSfM::Compute_Global_Rotations(const rotationAveraging::RelativeRotations& relatives_R,
                                                               HashMap<IndexT, Mat3>& global_rotations)
 {
+  ALICEVISION_PROFILE_SCOPE("globalSfM::computeGlobalRotations");
+
   if(relatives_R.empty())
     return false;
   // Log statistics about the relative rotation graph
@@ -239,8 +244,10 @@ bool ReconstructionEngine_globalSfM::Compute_Global_Rotations(const rotationAver
 bool ReconstructionEngine_globalSfM::Compute_Global_Translations(const HashMap<IndexT, Mat3>& global_rotations,
                                                                  matching::PairwiseMatches& tripletWise_matches)
 {
+  ALICEVISION_PROFILE_SCOPE("globalSfM::computeGlobalTranslations");
+
   // Translation averaging (compute translations & update them to a global common coordinates system)
-  GlobalSfMTranslationAveragingSolver translation_averaging_solver;
+  GlobalSfMTranslationAveragingSolver translation_averaging_solver(_translationAveragingMaxTripletsPerPose);
   const bool bTranslationAveraging = translation_averaging_solver.Run(
     _eTranslationAveragingMethod,
     _sfmData,
@@ -260,6 +267,8 @@ bool ReconstructionEngine_globalSfM::Compute_Global_Translations(const HashMap<I
 /// Compute the initial structure of the scene
 bool ReconstructionEngine_globalSfM::Compute_Initial_Structure(matching::PairwiseMatches& tripletWise_matches)
 {
+  ALICEVISION_PROFILE_SCOPE("globalSfM::computeInitialStructure");
+
   // Build tracks from selected triplets (Union of all the validated triplet tracks (_tripletWise_matches))
   {
     using namespace aliceVision::track;
@@ -359,9 +368,13 @@ bool ReconstructionEngine_globalSfM::Compute_Initial_Structure(matching::Pairwis
 // Adjust the scene (& remove outliers)
 bool ReconstructionEngine_globalSfM::Adjust()
 {
+  ALICEVISION_PROFILE_SCOPE("globalSfM::adjust");
+
   // refine sfm  scene (in a 3 iteration process (free the parameters regarding their incertainty order)):
   BundleAdjustmentCeres::CeresOptions options;
+  options.setAutoBA(); // select the linear solver from the size of the scene
   options.useParametersOrdering = false; // disable parameters ordering
+  options.landmarksSubsamplingMaxPerView = _landmarksSubsamplingMaxPerView; // adjust the cameras of the large scenes with a subset of the landmarks
 
   BundleAdjustmentCeres BA(options);
   // - refine only Structure and translations
@@ -425,6 +438,8 @@ bool ReconstructionEngine_globalSfM::Adjust()
 
 void ReconstructionEngine_globalSfM::Compute_Relative_Rotations(rotationAveraging::RelativeRotations& vec_relatives_R)
 {
+  ALICEVISION_PROFILE_SCOPE("globalSfM::computeRelativeRotations");
+
   //
   // Build the Relative pose graph from matches:
   //
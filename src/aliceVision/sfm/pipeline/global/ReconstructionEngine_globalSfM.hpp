@@ -35,6 +35,8 @@ public:
   void SetTranslationAveragingMethod(ETranslationAveragingMethod eTranslationAveragingMethod);
 
   void setLockAllIntrinsics(bool v) { _lockAllIntrinsics = v; }
+  void setTranslationAveragingMaxTripletsPerPose(std::size_t v) { _translationAveragingMaxTripletsPerPose = v; }
+  void setLandmarksSubsamplingMaxPerView(std::size_t v) { _landmarksSubsamplingMaxPerView = v; }
 
   virtual bool process();
 
@@ -65,6 +67,10 @@ private:
   ERotationAveragingMethod _eRotationAveragingMethod;
   ETranslationAveragingMethod _eTranslationAveragingMethod;
   bool _lockAllIntrinsics = false;
+  /// subsampling of the relative translations: number of best triplets per pose (0: all)
+  std::size_t _translationAveragingMaxTripletsPerPose = 0;
+  /// bundle adjustment with a subset of the landmarks: max number of landmarks per view (0: all)
+  std::size_t _landmarksSubsamplingMaxPerView = 0;
 
   // Data provider
   feature::FeaturesPerView* _featuresPerView;
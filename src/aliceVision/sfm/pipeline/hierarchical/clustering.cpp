@@ -0,0 +1,295 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "clustering.hpp"
+
+#include <aliceVision/graph/IndexedGraph.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <lemon/connectivity.h>
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+using Graph = graph::indexedGraph::GraphT;
+using Node = Graph::Node;
+
+/**
+ * @brief Find a pseudo-peripheral node of a part of the graph,
+ *        the last node reached by two successive breadth first searches.
+ * @param[in] g The graph
+ * @param[in] labels The part of each node
+ * @param[in] label The part to search in
+ * @param[in] start A node of the part
+ */
+Node findPeripheralNode(const Graph& g, const Graph::NodeMap<int>& labels, int label, Node start)
+{
+  Node node = start;
+  for(int i = 0; i < 2; ++i)
+  {
+    Graph::NodeMap<bool> visited(g, false);
+    std::queue<Node> queue;
+    queue.push(node);
+    visited[node] = true;
+
+    while(!queue.empty())
+    {
+      node = queue.front();
+      queue.pop();
+
+      for(Graph::IncEdgeIt e(g, node); e != lemon::INVALID; ++e)
+      {
+        const Node other = g.runningNode(e);
+        if(labels[other] == label && !visited[other])
+        {
+          visited[other] = true;
+          queue.push(other);
+        }
+      }
+    }
+  }
+  return node;
+}
+
+/**
+ * @brief Split a part of the graph in two halves by greedy graph growing:
+ *        starting from a pseudo-peripheral node, add the node the most connected to the grown half.
+ * @param[in] g The graph
+ * @param[in] weights The weight of each edge
+ * @param[in,out] labels The part of each node, the nodes of the grown half get newLabel
+ * @param[in] part The nodes of the part to split
+ * @param[in] newLabel The label of the grown half
+ * @param[out] half The nodes of the grown half
+ */
+void bisect(const Graph& g,
+            const Graph::EdgeMap<std::size_t>& weights,
+            Graph::NodeMap<int>& labels,
+            const std::vector<Node>& part,
+            int newLabel,
+            std::vector<Node>& half)
+{
+  const int label = labels[part.front()];
+  const std::size_t halfSize = part.size() / 2;
+
+  // connection of each node of the part to the grown half
+  Graph::NodeMap<std::size_t> gains(g, 0);
+  // (gain, node id), outdated entries are skipped when popped
+  std::priority_queue<std::pair<std::size_t, int>> queue;
+  std::size_t nextSeed = 0;
+
+  half.clear();
+  while(half.size() < halfSize)
+  {
+    if(queue.empty())
+    {
+      // start, or restart if the remaining part is disconnected
+      while(labels[part[nextSeed]] != label)
+        ++nextSeed;
+      queue.emplace(0, g.id(findPeripheralNode(g, labels, label, part[nextSeed])));
+    }
+
+    const std::pair<std::size_t, int> top = queue.top();
+    queue.pop();
+
+    const Node node = g.nodeFromId(top.second);
+    if(labels[node] != label || top.first != gains[node])
+      continue;
+
+    labels[node] = newLabel;
+    half.push_back(node);
+
+    for(Graph::IncEdgeIt e(g, node); e != lemon::INVALID; ++e)
+    {
+      const Node other = g.runningNode(e);
+      if(labels[other] == label)
+      {
+        gains[other] += weights[e];
+        queue.emplace(gains[other], g.id(other));
+      }
+    }
+  }
+}
+
+/**
+ * @brief Keep the observations of a landmark in the given views.
+ * @return true if the landmark is still observed at least twice
+ */
+bool restrictLandmark(const sfmData::Landmark& landmark,
+                      const std::set<IndexT>& viewIds,
+                      sfmData::Landmark& clusterLandmark)
+{
+  clusterLandmark = sfmData::Landmark(landmark.X, landmark.descType, sfmData::Observations(), landmark.rgb);
+  for(const auto& observationPair : landmark.observations)
+  {
+    if(viewIds.count(observationPair.first))
+      clusterLandmark.observations.emplace(observationPair);
+  }
+  return clusterLandmark.observations.size() >= 2;
+}
+
+} // namespace
+
+void computePairWeights(const matching::PairwiseMatches& pairwiseMatches,
+                        std::map<Pair, std::size_t>& pairWeights)
+{
+  pairWeights.clear();
+  for(const auto& matchesPair : pairwiseMatches)
+  {
+    std::size_t nbMatches = 0;
+    for(const auto& matchesPerDesc : matchesPair.second)
+      nbMatches += matchesPerDesc.second.size();
+
+    if(nbMatches > 0)
+      pairWeights[matchesPair.first] = nbMatches;
+  }
+}
+
+void clusterViewGraph(const std::map<Pair, std::size_t>& pairWeights,
+                      const ClusteringParams& params,
+                      std::vector<std::set<IndexT>>& clusters)
+{
+  clusters.clear();
+
+  PairSet pairs;
+  for(const auto& pairWeight : pairWeights)
+    pairs.insert(pairWeight.first);
+
+  const graph::indexedGraph viewGraph(pairs);
+  const Graph& g = viewGraph.g;
+  const graph::indexedGraph::map_NodeMapIndex& viewIds = *viewGraph.map_nodeMapIndex;
+
+  Graph::EdgeMap<std::size_t> weights(g);
+  for(Graph::EdgeIt e(g); e != lemon::INVALID; ++e)
+  {
+    const IndexT viewIdU = viewIds[g.u(e)];
+    const IndexT viewIdV = viewIds[g.v(e)];
+    auto it = pairWeights.find(std::make_pair(viewIdU, viewIdV));
+    if(it == pairWeights.end())
+      it = pairWeights.find(std::make_pair(viewIdV, viewIdU));
+    weights[e] = it->second;
+  }
+
+  // split each connected component until the parts are small enough
+  Graph::NodeMap<int> labels(g);
+  int nbLabels = lemon::connectedComponents(g, labels);
+
+  std::vector<std::vector<Node>> parts(nbLabels);
+  for(Graph::NodeIt n(g); n != lemon::INVALID; ++n)
+    parts[labels[n]].push_back(n);
+
+  const std::size_t maxClusterSize = std::max<std::size_t>(params.maxClusterSize, 2);
+  std::vector<std::vector<Node>> cores;
+
+  while(!parts.empty())
+  {
+    std::vector<Node> part = std::move(parts.back());
+    parts.pop_back();
+
+    if(part.size() <= maxClusterSize)
+    {
+      cores.push_back(std::move(part));
+      continue;
+    }
+
+    const int newLabel = nbLabels++;
+    std::vector<Node> half;
+    bisect(g, weights, labels, part, newLabel, half);
+    part.erase(std::remove_if(part.begin(), part.end(), [&](const Node& n){ return labels[n] == newLabel; }), part.end());
+
+    parts.push_back(std::move(part));
+    parts.push_back(std::move(half));
+  }
+
+  // expand each cluster with its most connected neighbor views
+  clusters.resize(cores.size());
+  for(std::size_t i = 0; i < cores.size(); ++i)
+  {
+    const std::vector<Node>& core = cores.at(i);
+    const int label = labels[core.front()];
+    std::set<IndexT>& cluster = clusters.at(i);
+
+    std::map<IndexT, std::size_t> neighbors;
+    for(const Node& node : core)
+    {
+      cluster.insert(viewIds[node]);
+      for(Graph::IncEdgeIt e(g, node); e != lemon::INVALID; ++e)
+      {
+        const Node other = g.runningNode(e);
+        if(labels[other] != label)
+          neighbors[viewIds[other]] += weights[e];
+      }
+    }
+
+    std::vector<std::pair<IndexT, std::size_t>> sortedNeighbors(neighbors.begin(), neighbors.end());
+    std::stable_sort(sortedNeighbors.begin(), sortedNeighbors.end(), [](const std::pair<IndexT, std::size_t>& a, const std::pair<IndexT, std::size_t>& b){
+      return a.second > b.second;
+    });
+
+    const std::size_t nbOverlapViews = std::min(sortedNeighbors.size(), static_cast<std::size_t>(std::ceil(params.overlapRatio * core.size())));
+    for(std::size_t j = 0; j < nbOverlapViews; ++j)
+      cluster.insert(sortedNeighbors.at(j).first);
+
+    ALICEVISION_LOG_DEBUG("Cluster " << i << ": " << core.size() << " views, " << nbOverlapViews << " overlapping views.");
+  }
+
+  ALICEVISION_LOG_INFO("View graph partitioned in " << clusters.size() << " clusters" << std::endl
+    << "\t- # views: " << lemon::countNodes(g) << std::endl
+    << "\t- # image pairs: " << lemon::countEdges(g) << std::endl
+    << "\t- # connected components: " << lemon::countConnectedComponents(g));
+}
+
+void createClusterSfMData(const sfmData::SfMData& sfmData,
+                          const std::set<IndexT>& viewIds,
+                          sfmData::SfMData& clusterSfmData)
+{
+  clusterSfmData = sfmData::SfMData();
+  clusterSfmData.setFeaturesFolders(sfmData.getFeaturesFolders());
+  clusterSfmData.setMatchesFolders(sfmData.getMatchesFolders());
+
+  for(const IndexT viewId : viewIds)
+  {
+    const auto viewIt = sfmData.getViews().find(viewId);
+    if(viewIt == sfmData.getViews().end())
+      continue;
+
+    const sfmData::View& view = *viewIt->second;
+    clusterSfmData.getViews().emplace(viewId, viewIt->second);
+
+    const auto intrinsicIt = sfmData.getIntrinsics().find(view.getIntrinsicId());
+    if(intrinsicIt != sfmData.getIntrinsics().end())
+      clusterSfmData.getIntrinsics().emplace(*intrinsicIt);
+
+    if(view.isPartOfRig())
+      clusterSfmData.getRigs().emplace(view.getRigId(), sfmData.getRigs().at(view.getRigId()));
+
+    if(sfmData.existsPose(view))
+      clusterSfmData.getPoses().emplace(view.getPoseId(), sfmData.getAbsolutePose(view.getPoseId()));
+  }
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    sfmData::Landmark landmark;
+    if(restrictLandmark(landmarkPair.second, viewIds, landmark))
+      clusterSfmData.getLandmarks().emplace(landmarkPair.first, landmark);
+  }
+
+  for(const auto& controlPointPair : sfmData.getControlPoints())
+  {
+    sfmData::Landmark controlPoint;
+    if(restrictLandmark(controlPointPair.second, viewIds, controlPoint))
+      clusterSfmData.getControlPoints().emplace(controlPointPair.first, controlPoint);
+  }
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,70 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/matching/IndMatch.hpp>
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Parameters of the partition of the view graph in overlapping clusters
+ */
+struct ClusteringParams
+{
+  /// maximum number of views of a cluster, before the expansion of the overlap
+  std::size_t maxClusterSize = 200;
+  /// number of views added to each cluster from its neighbors, as a ratio of the cluster size
+  double overlapRatio = 0.2;
+};
+
+/**
+ * @brief Compute the weight of each image pair of the view graph: its number of matches (all describer types).
+ * @param[in] pairwiseMatches The pairwise matches
+ * @param[out] pairWeights The number of matches per image pair
+ */
+void computePairWeights(const matching::PairwiseMatches& pairwiseMatches,
+                        std::map<Pair, std::size_t>& pairWeights);
+
+/**
+ * @brief Partition the view graph in overlapping clusters.
+ *
+ * Each connected component of the view graph is split by recursive bisection until
+ * all the parts have at most maxClusterSize views. A part is grown from a
+ * pseudo-peripheral view by adding the view the most connected to it (in number of matches),
+ * so the cut is small and the clusters are compact.
+ * Then each cluster is expanded with its most connected neighbor views,
+ * so the reconstructions of two neighbor clusters share some views to be aligned on.
+ *
+ * @param[in] pairWeights The number of matches per image pair
+ * @param[in] params The clustering parameters
+ * @param[out] clusters The view ids of each cluster, the clusters are overlapping
+ */
+void clusterViewGraph(const std::map<Pair, std::size_t>& pairWeights,
+                      const ClusteringParams& params,
+                      std::vector<std::set<IndexT>>& clusters);
+
+/**
+ * @brief Extract the SfMData of a cluster: only its views, with their intrinsics, rigs, poses
+ *        and the landmarks observed at least twice in the cluster.
+ * @param[in] sfmData The full scene
+ * @param[in] viewIds The view ids of the cluster
+ * @param[out] clusterSfmData The scene of the cluster
+ */
+void createClusterSfMData(const sfmData::SfMData& sfmData,
+                          const std::set<IndexT>& viewIds,
+                          sfmData::SfMData& clusterSfmData);
+
+} // namespace sfm
+} // namespace aliceVision
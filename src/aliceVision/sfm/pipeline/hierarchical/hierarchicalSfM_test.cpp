@@ -0,0 +1,115 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/pipeline/hierarchical/clustering.hpp>
+#include <aliceVision/sfm/pipeline/hierarchical/merging.hpp>
+#include <aliceVision/sfm/utils/alignment.hpp>
+#include <aliceVision/sfm/utils/syntheticScene.hpp>
+
+#include <cmath>
+
+#define BOOST_TEST_MODULE HIERARCHICAL_SFM
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+using namespace aliceVision::sfmData;
+
+// Test summary:
+// - Partition a 10x10 grid of views in overlapping clusters
+// - Assert that:
+//   - the clusters cover all the views,
+//   - the clusters (without their overlap) have at most maxClusterSize views,
+//   - each cluster shares views with another cluster.
+BOOST_AUTO_TEST_CASE(HIERARCHICAL_SFM_ClusterViewGraph)
+{
+  const IndexT gridSize = 10;
+  std::map<Pair, std::size_t> pairWeights;
+  for(IndexT y = 0; y < gridSize; ++y)
+  {
+    for(IndexT x = 0; x < gridSize; ++x)
+    {
+      const IndexT viewId = y * gridSize + x;
+      if(x + 1 < gridSize)
+        pairWeights[Pair(viewId, viewId + 1)] = 100;
+      if(y + 1 < gridSize)
+        pairWeights[Pair(viewId, viewId + gridSize)] = 100;
+    }
+  }
+
+  ClusteringParams params;
+  params.maxClusterSize = 30;
+  params.overlapRatio = 0.2;
+
+  std::vector<std::set<IndexT>> clusters;
+  clusterViewGraph(pairWeights, params, clusters);
+
+  BOOST_CHECK_GE(clusters.size(), 4);
+
+  std::set<IndexT> views;
+  for(std::size_t i = 0; i < clusters.size(); ++i)
+  {
+    const std::set<IndexT>& cluster = clusters.at(i);
+    BOOST_CHECK_LE(cluster.size(), params.maxClusterSize + std::ceil(params.overlapRatio * params.maxClusterSize));
+    views.insert(cluster.begin(), cluster.end());
+
+    bool hasOverlap = false;
+    for(std::size_t j = 0; j < clusters.size() && !hasOverlap; ++j)
+    {
+      if(i == j)
+        continue;
+      for(const IndexT viewId : cluster)
+        hasOverlap |= (clusters.at(j).count(viewId) > 0);
+    }
+    BOOST_CHECK(hasOverlap);
+  }
+  BOOST_CHECK_EQUAL(views.size(), gridSize * gridSize);
+}
+
+// Test summary:
+// - Split a synthetic scene in two overlapping clusters
+// - Move the second cluster with a similarity
+// - Merge the two clusters
+// - Assert that:
+//   - the camera centers are the ones of the input scene,
+//   - the landmarks of the two clusters are fused.
+BOOST_AUTO_TEST_CASE(HIERARCHICAL_SFM_MergeReconstructions)
+{
+  const int nviews = 12;
+  const int npoints = 64;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+  const SfMData sfmData = getInputScene(d, config, camera::PINHOLE_CAMERA);
+
+  std::vector<SfMData> reconstructions(2);
+  createClusterSfMData(sfmData, {0, 1, 2, 3, 4, 5, 6, 7}, reconstructions.at(0));
+  createClusterSfMData(sfmData, {4, 5, 6, 7, 8, 9, 10, 11}, reconstructions.at(1));
+
+  BOOST_CHECK_EQUAL(reconstructions.at(0).getViews().size(), 8);
+  BOOST_CHECK_EQUAL(reconstructions.at(0).getPoses().size(), 8);
+  BOOST_CHECK_EQUAL(reconstructions.at(0).getLandmarks().size(), npoints);
+
+  const Mat3 R = RotationAroundZ(0.3) * RotationAroundX(-0.2);
+  applyTransform(reconstructions.at(1), 2.5, R, Vec3(1.0, -3.0, 0.5));
+
+  SfMData mergedSfmData;
+  BOOST_CHECK_EQUAL(mergeReconstructions(reconstructions, mergedSfmData), 2);
+
+  BOOST_CHECK_EQUAL(mergedSfmData.getViews().size(), nviews);
+  BOOST_CHECK_EQUAL(mergedSfmData.getPoses().size(), nviews);
+  BOOST_CHECK_EQUAL(mergedSfmData.getLandmarks().size(), npoints);
+
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    const Vec3 center = sfmData.getPose(*viewPair.second).getTransform().center();
+    const Vec3 mergedCenter = mergedSfmData.getPose(mergedSfmData.getView(viewPair.first)).getTransform().center();
+    BOOST_CHECK_SMALL((center - mergedCenter).norm(), 1e-6);
+  }
+
+  for(const auto& landmarkPair : mergedSfmData.getLandmarks())
+    BOOST_CHECK_EQUAL(landmarkPair.second.observations.size(), nviews);
+}
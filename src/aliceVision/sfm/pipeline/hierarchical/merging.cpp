@@ -0,0 +1,195 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "merging.hpp"
+
+#include <aliceVision/sfm/utils/alignment.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <map>
+#include <tuple>
+
+namespace aliceVision {
+namespace sfm {
+
+namespace {
+
+/// (view id, describer type, feature id) of an observation
+using ObservationKey = std::tuple<IndexT, feature::EImageDescriberType, IndexT>;
+/// landmark id of each observation of the merged scene
+using ObservationsLandmarks = std::map<ObservationKey, IndexT>;
+
+std::size_t countCommonReconstructedViews(const sfmData::SfMData& sfmDataA, const sfmData::SfMData& sfmDataB)
+{
+  std::size_t nbCommonViews = 0;
+  for(const auto& viewPair : sfmDataA.getViews())
+  {
+    if(sfmDataA.isPoseAndIntrinsicDefined(viewPair.second.get()) &&
+       sfmDataB.getViews().count(viewPair.first) &&
+       sfmDataB.isPoseAndIntrinsicDefined(viewPair.first))
+      ++nbCommonViews;
+  }
+  return nbCommonViews;
+}
+
+/**
+ * @brief Add an aligned reconstruction to the merged scene.
+ * @param[in] reconstruction The reconstruction, in the merged scene coordinate system
+ * @param[in,out] sfmData The merged scene
+ * @param[in,out] observationsLandmarks The landmark id of each observation of the merged scene
+ * @param[in,out] nextLandmarkId The id of the next new landmark
+ */
+void addReconstruction(const sfmData::SfMData& reconstruction,
+                       sfmData::SfMData& sfmData,
+                       ObservationsLandmarks& observationsLandmarks,
+                       IndexT& nextLandmarkId)
+{
+  // the views already in the scene keep their intrinsics and poses
+  for(const auto& viewPair : reconstruction.getViews())
+  {
+    const sfmData::View& view = *viewPair.second;
+    sfmData.getViews().emplace(viewPair);
+
+    const auto intrinsicIt = reconstruction.getIntrinsics().find(view.getIntrinsicId());
+    if(intrinsicIt != reconstruction.getIntrinsics().end())
+      sfmData.getIntrinsics().emplace(*intrinsicIt);
+
+    if(view.isPartOfRig())
+      sfmData.getRigs().emplace(view.getRigId(), reconstruction.getRigs().at(view.getRigId()));
+
+    if(reconstruction.existsPose(view) && !sfmData.existsPose(view))
+      sfmData.getPoses().emplace(view.getPoseId(), reconstruction.getAbsolutePose(view.getPoseId()));
+  }
+
+  std::size_t nbFusedLandmarks = 0;
+  for(const auto& landmarkPair : reconstruction.getLandmarks())
+  {
+    const sfmData::Landmark& landmark = landmarkPair.second;
+
+    // find a landmark of the scene sharing an observation
+    IndexT landmarkId = UndefinedIndexT;
+    for(const auto& observationPair : landmark.observations)
+    {
+      const auto it = observationsLandmarks.find(ObservationKey(observationPair.first, landmark.descType, observationPair.second.id_feat));
+      if(it != observationsLandmarks.end())
+      {
+        landmarkId = it->second;
+        break;
+      }
+    }
+
+    if(landmarkId == UndefinedIndexT)
+    {
+      landmarkId = nextLandmarkId++;
+      sfmData.getLandmarks().emplace(landmarkId, landmark);
+    }
+    else
+    {
+      ++nbFusedLandmarks;
+    }
+
+    // add the observations in the views the landmark is not observed yet
+    sfmData::Landmark& mergedLandmark = sfmData.getLandmarks().at(landmarkId);
+    for(const auto& observationPair : landmark.observations)
+    {
+      mergedLandmark.observations.emplace(observationPair);
+      if(mergedLandmark.observations.at(observationPair.first).id_feat == observationPair.second.id_feat)
+        observationsLandmarks.emplace(ObservationKey(observationPair.first, landmark.descType, observationPair.second.id_feat), landmarkId);
+    }
+  }
+
+  ALICEVISION_LOG_DEBUG("Reconstruction added to the merged scene:" << std::endl
+    << "\t- # poses: " << reconstruction.getPoses().size() << std::endl
+    << "\t- # landmarks: " << reconstruction.getLandmarks().size() << std::endl
+    << "\t- # fused landmarks: " << nbFusedLandmarks);
+}
+
+} // namespace
+
+std::size_t mergeReconstructions(std::vector<sfmData::SfMData>& reconstructions,
+                                 sfmData::SfMData& sfmData,
+                                 std::size_t minNbCommonViews)
+{
+  sfmData = sfmData::SfMData();
+
+  if(reconstructions.empty())
+    return 0;
+
+  // the reconstruction with the most poses is the reference
+  std::size_t referenceIndex = 0;
+  for(std::size_t i = 1; i < reconstructions.size(); ++i)
+  {
+    if(reconstructions.at(i).getPoses().size() > reconstructions.at(referenceIndex).getPoses().size())
+      referenceIndex = i;
+  }
+
+  sfmData.setFeaturesFolders(reconstructions.at(referenceIndex).getFeaturesFolders());
+  sfmData.setMatchesFolders(reconstructions.at(referenceIndex).getMatchesFolders());
+
+  ObservationsLandmarks observationsLandmarks;
+  IndexT nextLandmarkId = 0;
+  addReconstruction(reconstructions.at(referenceIndex), sfmData, observationsLandmarks, nextLandmarkId);
+
+  std::vector<bool> processed(reconstructions.size(), false);
+  processed.at(referenceIndex) = true;
+  std::size_t nbMerged = 1;
+
+  for(;;)
+  {
+    // the next reconstruction is the one with the most views in common with the merged scene
+    std::size_t bestIndex = reconstructions.size();
+    std::size_t bestNbCommonViews = 0;
+    for(std::size_t i = 0; i < reconstructions.size(); ++i)
+    {
+      if(processed.at(i))
+        continue;
+
+      const std::size_t nbCommonViews = countCommonReconstructedViews(reconstructions.at(i), sfmData);
+      if(nbCommonViews > bestNbCommonViews)
+      {
+        bestIndex = i;
+        bestNbCommonViews = nbCommonViews;
+      }
+    }
+
+    if(bestIndex == reconstructions.size() || bestNbCommonViews < minNbCommonViews)
+      break;
+
+    processed.at(bestIndex) = true;
+    sfmData::SfMData& reconstruction = reconstructions.at(bestIndex);
+
+    double S;
+    Mat3 R;
+    Vec3 t;
+    if(!computeSimilarityFromCommonCameras_viewId(reconstruction, sfmData, &S, &R, &t))
+    {
+      ALICEVISION_LOG_WARNING("Cannot align the reconstruction " << bestIndex << " on the merged scene (" << bestNbCommonViews << " common views).");
+      continue;
+    }
+
+    applyTransform(reconstruction, S, R, t);
+    addReconstruction(reconstruction, sfmData, observationsLandmarks, nextLandmarkId);
+    ++nbMerged;
+
+    ALICEVISION_LOG_INFO("Reconstruction " << bestIndex << " merged (" << bestNbCommonViews << " common views, scale: " << S << ").");
+  }
+
+  for(std::size_t i = 0; i < reconstructions.size(); ++i)
+  {
+    if(!processed.at(i))
+      ALICEVISION_LOG_WARNING("The reconstruction " << i << " has not enough views in common with the merged scene, it is ignored.");
+  }
+
+  ALICEVISION_LOG_INFO("Merged " << nbMerged << " / " << reconstructions.size() << " reconstructions:" << std::endl
+    << "\t- # views: " << sfmData.getViews().size() << std::endl
+    << "\t- # poses: " << sfmData.getPoses().size() << std::endl
+    << "\t- # landmarks: " << sfmData.getLandmarks().size());
+
+  return nbMerged;
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,38 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Merge the reconstructions of overlapping clusters in a single scene.
+ *
+ * The reconstruction with the most poses is the reference.
+ * The other ones are merged one by one, the one sharing the most reconstructed views
+ * with the merged scene first: it is aligned on the common views with a similarity
+ * (computeSimilarityFromCommonCameras_viewId), then its new views, poses and intrinsics are added
+ * and its landmarks are fused with the landmarks sharing an observation (same view, describer type and feature).
+ * The common views keep the pose of the merged scene: a final bundle adjustment is expected.
+ *
+ * @param[in,out] reconstructions The reconstructions of the clusters, transformed in the merged scene coordinate system
+ * @param[out] sfmData The merged scene
+ * @param[in] minNbCommonViews The minimum number of common reconstructed views to align a reconstruction
+ * @return the number of merged reconstructions, including the reference
+ */
+std::size_t mergeReconstructions(std::vector<sfmData::SfMData>& reconstructions,
+                                 sfmData::SfMData& sfmData,
+                                 std::size_t minNbCommonViews = 3);
+
+} // namespace sfm
+} // namespace aliceVision
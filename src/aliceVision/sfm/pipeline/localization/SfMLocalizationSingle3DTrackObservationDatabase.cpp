@@ -8,6 +8,14 @@
 #include "SfMLocalizationSingle3DTrackObservationDatabase.hpp"
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/matching/RegionsMatcher.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <fstream>
+
+namespace fs = boost::filesystem;
 
 namespace aliceVision {
 namespace sfm {
@@ -18,9 +26,24 @@ namespace sfm {
     , _matchingInterface(nullptr)
   {}
 
+  namespace {
+
+  /// Path prefix of the cached database files of a describer type
+  std::string getDatabasePrefix(const std::string& cacheFolder, feature::EImageDescriberType descType)
+  {
+    return (fs::path(cacheFolder) / ("landmarkDescriptors." + feature::EImageDescriberType_enumToString(descType))).string();
+  }
+
+  } // namespace
+
   bool SfMLocalizationSingle3DTrackObservationDatabase::Init(const sfmData::SfMData& sfmData,
-                                                             const feature::RegionsPerView& regionsPerView)
+                                                             const feature::RegionsPerView& regionsPerView,
+                                                             feature::EImageDescriberType descType,
+                                                             const std::string& cacheFolder)
   {
+    _sfmData = nullptr;
+    _matchingInterface.reset();
+
     if (regionsPerView.isEmpty())
     {
       return false;
@@ -32,43 +55,177 @@ namespace sfm {
       return false;
     }
 
-    /*
-    TODO: DELI
+    if(!cacheFolder.empty() && loadDatabase(sfmData, regionsPerView, descType, cacheFolder))
+    {
+      ALICEVISION_LOG_DEBUG("Retrieval database loaded from '" << cacheFolder << "'");
+    }
+    else
+    {
+      // Setup the database
+      // A collection of regions
+      // - each landmark leads to a new region, from its first observation with a feature
+      // - link each region to a landmark id to ease 2D-3D correspondences search
 
-    // Setup the database
-    // A collection of regions
-    // - each view observation leads to a new regions
-    // - link each observation region to a track id to ease 2D-3D correspondences search
+      struct LandmarkObservation
+      {
+        IndexT landmarkId;
+        const feature::Regions* regions;
+        IndexT featureId;
+      };
 
-    const feature::Regions& regionsType = regionsPerView.getFirstViewRegions();
-    landmark_observations_descriptors_.reset(regionsType.EmptyClone());
-    for (const auto & landmark : sfm_data.getLandmarks())
-    {
-      for (const auto & observation : landmark.second.obs)
+      std::vector<LandmarkObservation> landmarkObservations;
+      landmarkObservations.reserve(sfmData.getLandmarks().size());
+
+      for(const auto& landmark : sfmData.getLandmarks())
       {
-        if (observation.second.id_feat != UndefinedIndexT)
+        if(landmark.second.descType != descType)
+          continue;
+
+        for(const auto& observation : landmark.second.observations)
         {
-          // copy the feature/descriptor to landmark_observations_descriptors
-          const feature::Regions& viewRegions = regionsPerView.getRegions(observation.first, landmark.second.descType);
-          viewRegions.CopyRegion(observation.second.id_feat, landmark_observations_descriptors_.get());
-          // link this descriptor to the track Id
-          index_to_landmark_id_.push_back(landmark.first);
+          if(observation.second.id_feat == UndefinedIndexT || !regionsPerView.viewExist(observation.first))
+            continue;
+
+          const feature::MapRegionsPerDesc& regionsPerDesc = regionsPerView.getRegionsPerDesc(observation.first);
+          const auto regionsIt = regionsPerDesc.find(descType);
+          if(regionsIt == regionsPerDesc.end() || observation.second.id_feat >= regionsIt->second->RegionCount())
+            continue;
+
+          landmarkObservations.push_back({landmark.first, regionsIt->second.get(), observation.second.id_feat});
+          break;
         }
       }
+
+      if(landmarkObservations.empty())
+      {
+        ALICEVISION_LOG_WARNING("No landmark observation with " << feature::EImageDescriberType_enumToString(descType) << " regions to match with.");
+        return false;
+      }
+
+      ALICEVISION_LOG_DEBUG("Init retrieval database ... ");
+
+      // all the descriptors are copied in a single container allocated once
+      _landmarkObservationsDescriptors.reset(landmarkObservations.front().regions->EmptyClone());
+      _landmarkObservationsDescriptors->resizeRegions(landmarkObservations.size());
+      _indexToLandmarkId.resize(landmarkObservations.size());
+
+#pragma omp parallel for
+      for(int i = 0; i < landmarkObservations.size(); ++i)
+      {
+        const LandmarkObservation& landmarkObservation = landmarkObservations[i];
+        landmarkObservation.regions->CopyRegion(landmarkObservation.featureId, _landmarkObservationsDescriptors.get(), i);
+        _indexToLandmarkId[i] = landmarkObservation.landmarkId;
+      }
+
+      if(!cacheFolder.empty())
+        saveDatabase(descType, cacheFolder);
     }
-    ALICEVISION_LOG_DEBUG("Init retrieval database ... ");
-    matching_interface_.reset(new
-      matching::Matcher_Regions_Database(matching::ANN_L2, *landmark_observations_descriptors_));
+
+    // the kd-tree index is cached with the database
+    const std::string indexPrefix = cacheFolder.empty() ? "" : getDatabasePrefix(cacheFolder, descType);
+    _matchingInterface.reset(new matching::RegionsDatabaseMatcher(matching::ANN_L2, *_landmarkObservationsDescriptors, indexPrefix));
+
     ALICEVISION_LOG_DEBUG("Retrieval database initialized\n"
-      "#landmark: " << sfm_data.getLandmarks().size() << "\n"
-      "#descriptor initialized: " << landmark_observations_descriptors_->RegionCount());
+      "#landmark: " << sfmData.getLandmarks().size() << "\n"
+      "#descriptor initialized: " << _landmarkObservationsDescriptors->RegionCount());
+
+    _sfmData = &sfmData;
+    return true;
+  }
+
+  bool SfMLocalizationSingle3DTrackObservationDatabase::loadDatabase(const sfmData::SfMData& sfmData,
+                                                                     const feature::RegionsPerView& regionsPerView,
+                                                                     feature::EImageDescriberType descType,
+                                                                     const std::string& cacheFolder)
+  {
+    const std::string prefix = getDatabasePrefix(cacheFolder, descType);
+    const std::string regionsFilename = prefix + ".regions";
+    const std::string landmarksFilename = prefix + ".landmarks";
 
-    sfm_data_ = &sfm_data;
-    */
+    if(!fs::exists(regionsFilename) || !fs::exists(landmarksFilename))
+      return false;
 
+    // landmark id of each region
+    std::ifstream landmarksFile(landmarksFilename, std::ios::in | std::ios::binary);
+    std::uint32_t nbRegions = 0;
+    landmarksFile.read(reinterpret_cast<char*>(&nbRegions), sizeof(nbRegions));
+    std::vector<std::uint32_t> landmarkIds(nbRegions);
+    if(nbRegions > 0)
+      landmarksFile.read(reinterpret_cast<char*>(landmarkIds.data()), nbRegions * sizeof(std::uint32_t));
+
+    if(!landmarksFile.good())
+    {
+      ALICEVISION_LOG_WARNING("Invalid retrieval database file: " << landmarksFilename);
+      return false;
+    }
+
+    // the database must have been built from the same scene
+    for(const std::uint32_t landmarkId : landmarkIds)
+    {
+      const auto landmarkIt = sfmData.getLandmarks().find(landmarkId);
+      if(landmarkIt == sfmData.getLandmarks().end() || landmarkIt->second.descType != descType)
+      {
+        ALICEVISION_LOG_DEBUG("The retrieval database in '" << cacheFolder << "' doesn't match the scene, rebuild it.");
+        return false;
+      }
+    }
+
+    const feature::Regions& regionsType = regionsPerView.getFirstViewRegions(descType);
+    std::unique_ptr<feature::Regions> regions(regionsType.EmptyClone());
+
+    try
+    {
+      regions->MapContainer(regionsFilename);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING("Cannot load the retrieval database: " << e.what());
+      return false;
+    }
+
+    if(regions->RegionCount() != nbRegions)
+    {
+      ALICEVISION_LOG_WARNING("Invalid retrieval database file: " << regionsFilename);
+      return false;
+    }
+
+    _landmarkObservationsDescriptors = std::move(regions);
+    _indexToLandmarkId.assign(landmarkIds.begin(), landmarkIds.end());
     return true;
   }
 
+  void SfMLocalizationSingle3DTrackObservationDatabase::saveDatabase(feature::EImageDescriberType descType,
+                                                                     const std::string& cacheFolder) const
+  {
+    if(!fs::exists(cacheFolder))
+      fs::create_directories(cacheFolder);
+
+    const std::string prefix = getDatabasePrefix(cacheFolder, descType);
+    const std::string landmarksFilename = prefix + ".landmarks";
+
+    try
+    {
+      _landmarkObservationsDescriptors->SaveContainer(prefix + ".regions");
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING("Cannot save the retrieval database: " << e.what());
+      return;
+    }
+
+    std::ofstream landmarksFile(landmarksFilename, std::ios::out | std::ios::binary);
+    const std::uint32_t nbRegions = _indexToLandmarkId.size();
+    landmarksFile.write(reinterpret_cast<const char*>(&nbRegions), sizeof(nbRegions));
+    for(const IndexT landmarkId : _indexToLandmarkId)
+    {
+      const std::uint32_t id = landmarkId;
+      landmarksFile.write(reinterpret_cast<const char*>(&id), sizeof(id));
+    }
+
+    if(!landmarksFile.good())
+      ALICEVISION_LOG_WARNING("Cannot save the retrieval database file: " << landmarksFilename);
+  }
+
   bool SfMLocalizationSingle3DTrackObservationDatabase::Localize(const Pair& imageSize,
                                const camera::IntrinsicBase* optionalIntrinsics,
                                const feature::Regions& queryRegions,
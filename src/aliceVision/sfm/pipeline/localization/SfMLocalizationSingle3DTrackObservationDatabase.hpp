@@ -15,7 +15,9 @@ namespace aliceVision {
 namespace sfm {
 
 // Implementation of a naive method:
-// - init the database of descriptor from the structure and the observations.
+// - init the database of descriptor from the structure and the observations:
+//   one observation per landmark, all the descriptors in a single regions container
+//   with the landmark id of each region in a parallel array.
 // - create a large array with all the used descriptors and init a Matcher with it
 // - to localize an input image compare it's regions to the database and robust estimate
 //   the pose from found 2d-3D correspondences
@@ -31,10 +33,15 @@ public:
   *
   * @param[in] sfmData the SfM scene that have to be described
   * @param[in] regionPerView regions provider
+  * @param[in] descType the describer type of the database
+  * @param[in] cacheFolder optional folder where the database and the matcher index
+  *            are saved, and loaded from by the next localizers of the same scene
   * @return True if the database has been correctly setup
   */
   bool Init(const sfmData::SfMData& sfmData,
-            const feature::RegionsPerView& regionsPerView);
+            const feature::RegionsPerView& regionsPerView,
+            feature::EImageDescriberType descType,
+            const std::string& cacheFolder = "");
 
   /**
   * @brief Try to localize an image in the database
@@ -54,6 +61,21 @@ public:
                 ) const;
 
 private:
+  /**
+  * @brief Load the database saved by a previous Init in the cache folder
+  * @return false if there is no database of the describer type or if it doesn't match the scene
+  */
+  bool loadDatabase(const sfmData::SfMData& sfmData,
+                    const feature::RegionsPerView& regionsPerView,
+                    feature::EImageDescriberType descType,
+                    const std::string& cacheFolder);
+
+  /**
+  * @brief Save the database in the cache folder
+  */
+  void saveDatabase(feature::EImageDescriberType descType,
+                    const std::string& cacheFolder) const;
+
   // Reference to the scene
   const sfmData::SfMData* _sfmData;
   /// Association of a regions to a landmark observation
@@ -19,16 +19,7 @@
 namespace aliceVision {
 namespace sfm {
 
-struct ResectionSquaredResidualError 
-{
-  // Compute the residual of the projection distance(pt2D, Project(P,pt3D))
-  // Return the squared error
-  static double Error(const Mat34& P, const Vec2& pt2D, const Vec3& pt3D)
-  {
-    const Vec2 x = Project(P, pt3D);
-    return (x - pt2D).squaredNorm();
-  }
-};
+using resection::kernel::ResectionSquaredResidualError;
 
 bool SfMLocalizer::Localize(const Pair& imageSize,
                             const camera::IntrinsicBase* optionalIntrinsics,
@@ -65,7 +56,8 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
     KernelType kernel(resectionData.pt2D, imageSize.first, imageSize.second, resectionData.pt3D);
     // Robust estimation of the Projection matrix and its precision
     const std::pair<double,double> ACRansacOut =
-      aliceVision::robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &P, precision);
+      aliceVision::robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &P, precision,
+                                              nullptr, nullptr, resectionData.useSprt, resectionData.nbHistogramBins);
     // Update the upper bound precision of the model found by AC-RANSAC
     resectionData.error_max = ACRansacOut.first;
   }
@@ -102,7 +94,8 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
 
         // Robust estimation of the Projection matrix and its precision
         const std::pair<double, double> ACRansacOut =
-                aliceVision::robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &P, precision);
+                aliceVision::robustEstimation::ACRANSAC(kernel, resectionData.vec_inliers, resectionData.max_iteration, &P, precision,
+                                                        nullptr, nullptr, resectionData.useSprt, resectionData.nbHistogramBins);
         // Update the upper bound precision of the model found by AC-RANSAC
         resectionData.error_max = ACRansacOut.first;
         break;
@@ -141,7 +134,8 @@ bool SfMLocalizer::Localize(const Pair& imageSize,
         // @todo refactor, maybe move scorer directly inside the kernel
         const double threshold = resectionData.error_max * resectionData.error_max * (kernel.normalizer2()(0, 0) * kernel.normalizer2()(0, 0));
         robustEstimation::ScoreEvaluator<KernelType> scorer(threshold);
-        P = robustEstimation::LO_RANSAC(kernel, scorer, &resectionData.vec_inliers);
+        P = robustEstimation::LO_RANSAC(kernel, scorer, &resectionData.vec_inliers, nullptr, false, 100, 1e-2,
+                                        nullptr, resectionData.useSprt);
         break;
       }
 
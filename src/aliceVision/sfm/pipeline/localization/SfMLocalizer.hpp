@@ -42,6 +42,12 @@ struct ImageLocalizerMatchData
   /// Upper bound pixel(s) tolerance for residual errors
   double error_max = std::numeric_limits<double>::infinity();
   size_t max_iteration = 4096;
+
+  /// Reject the bad models before the end of their verification (SPRT)
+  bool useSprt = false;
+
+  /// Find the best NFA of ACRANSAC from a histogram of the residuals with this number of bins (0 to sort the residuals)
+  std::size_t nbHistogramBins = 0;
 };
 
 class SfMLocalizer
@@ -6,12 +6,20 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "regionsIO.hpp"
+#include <aliceVision/feature/tiledExtraction.hpp>
+#include <aliceVision/image/io.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Profiler.hpp>
+#include <aliceVision/system/Storage.hpp>
+#include <aliceVision/system/TaskPool.hpp>
 
 #include <boost/progress.hpp>
 #include <boost/filesystem.hpp>
 
 #include <atomic>
 #include <cassert>
+#include <mutex>
+#include <vector>
 
 namespace fs = boost::filesystem;
 
@@ -22,7 +30,8 @@ using namespace sfmData;
 
 std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
                                               IndexT viewId,
-                                              const feature::ImageDescriber& imageDescriber)
+                                              const feature::ImageDescriber& imageDescriber,
+                                              bool mapDescriptors)
 {
   assert(!folders.empty());
 
@@ -31,28 +40,75 @@ std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& fo
 
   std::string featFilename;
   std::string descFilename;
+  std::string containerFilename;
+
+  system::Storage& storage = system::Storage::get();
 
   for(const std::string& folder : folders)
   {
+    const fs::path containerPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".regions");
     const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
     const fs::path descPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".desc");
 
-    if(fs::exists(featPath) && fs::exists(descPath))
+    // binary regions container has priority over legacy .feat / .desc files
+    if(storage.exists(containerPath.string()))
+    {
+      containerFilename = containerPath.string();
+      featFilename.clear();
+      descFilename.clear();
+    }
+    else if(storage.exists(featPath.string()) && storage.exists(descPath.string()))
     {
+      containerFilename.clear();
       featFilename = featPath.string();
       descFilename = descPath.string();
     }
   }
 
-  if(featFilename.empty() || descFilename.empty())
+  if(containerFilename.empty() && (featFilename.empty() || descFilename.empty()))
     throw std::runtime_error("Can't find view " + basename + " region files");
 
-  ALICEVISION_LOG_TRACE("Features filename: "    << featFilename);
-  ALICEVISION_LOG_TRACE("Descriptors filename: " << descFilename);
+  // local copies of the remote files
+  if(!containerFilename.empty())
+    containerFilename = storage.getLocalPath(containerFilename);
+  else
+  {
+    featFilename = storage.getLocalPath(featFilename);
+    descFilename = storage.getLocalPath(descFilename);
+  }
 
   std::unique_ptr<feature::Regions> regionsPtr;
   imageDescriber.allocate(regionsPtr);
 
+  if(!containerFilename.empty())
+  {
+    ALICEVISION_LOG_TRACE("Regions container filename: " << containerFilename);
+
+    try
+    {
+      if(mapDescriptors)
+        regionsPtr->MapContainer(containerFilename);
+      else
+        regionsPtr->LoadContainer(containerFilename);
+    }
+    catch(const std::exception& e)
+    {
+      std::stringstream ss;
+      ss << "Invalid " << imageDescriberTypeName << " regions container file for the view " << basename << " : \n";
+      ss << "\t- Regions container file : " << containerFilename << "\n";
+      ss << "\t  " << e.what() << "\n";
+      ALICEVISION_LOG_ERROR(ss.str());
+
+      throw std::runtime_error(e.what());
+    }
+
+    ALICEVISION_LOG_TRACE("Region count: " << regionsPtr->RegionCount());
+    return regionsPtr;
+  }
+
+  ALICEVISION_LOG_TRACE("Features filename: "    << featFilename);
+  ALICEVISION_LOG_TRACE("Descriptors filename: " << descFilename);
+
   try
   {
     regionsPtr->Load(featFilename, descFilename);
@@ -83,36 +139,62 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
   const std::string basename = std::to_string(viewId);
 
   std::string featFilename;
+  std::string containerFilename;
 
   // build up a set with normalized paths to remove duplicates
   std::set<std::string> foldersSet;
   for(const auto& folder : folders)
-    foldersSet.insert(fs::canonical(folder).string());
+    foldersSet.insert(system::Storage::isLocalPath(folder) ? fs::canonical(folder).string() : folder);
+
+  system::Storage& storage = system::Storage::get();
 
   for(const auto& folder : foldersSet)
   {
+    const fs::path containerPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".regions");
     const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
-    if(fs::exists(featPath))
+
+    // binary regions container has priority over legacy .feat files
+    if(storage.exists(containerPath.string()))
+    {
+      containerFilename = containerPath.string();
+      featFilename.clear();
+    }
+    else if(storage.exists(featPath.string()))
+    {
+      containerFilename.clear();
       featFilename = featPath.string();
+    }
   }
 
-  if(featFilename.empty())
+  if(containerFilename.empty() && featFilename.empty())
     throw std::runtime_error("Can't find view " + basename + " features file");
 
-  ALICEVISION_LOG_TRACE("Features filename: " << featFilename);
+  const bool useContainer = !containerFilename.empty();
+  const std::string filename = storage.getLocalPath(useContainer ? containerFilename : featFilename);
+
+  ALICEVISION_LOG_TRACE((useContainer ? "Regions container filename: " : "Features filename: ") << filename);
 
   std::unique_ptr<feature::Regions> regionsPtr;
   imageDescriber.allocate(regionsPtr);
 
   try
   {
-    regionsPtr->LoadFeatures(featFilename);
+    if(useContainer)
+    {
+      // only the features are copied from the mapping, the descriptors are released with it
+      regionsPtr->MapContainer(filename);
+      regionsPtr->clearDescriptors();
+    }
+    else
+    {
+      regionsPtr->LoadFeatures(filename);
+    }
   }
   catch(const std::exception& e)
   {
     std::stringstream ss;
     ss << "Invalid " << imageDescriberTypeName << " features file for the view " << basename << " : \n";
-    ss << "\t- Features file : " << featFilename << "\n";
+    ss << "\t- " << (useContainer ? "Regions container file : " : "Features file : ") << filename << "\n";
     ss << "\t  " << e.what() << "\n";
     ALICEVISION_LOG_ERROR(ss.str());
 
@@ -127,8 +209,12 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
             const SfMData& sfmData,
             const std::vector<std::string>& folders,
             const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
-            const std::set<IndexT>& viewIdFilter)
+            const std::set<IndexT>& viewIdFilter,
+            bool mapDescriptors,
+            bool featuresOnly)
 {
+  ALICEVISION_PROFILE_SCOPE("sfm::loadRegionsPerView");
+
   std::vector<std::string> featuresFolders = sfmData.getFeaturesFolders(); // add sfm features folders
   featuresFolders.insert(featuresFolders.end(), folders.begin(), folders.end()); // add user features folders
 
@@ -142,32 +228,45 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
   for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
     imageDescribers.at(i) = createImageDescriber(imageDescriberTypes.at(i));
 
-#pragma omp parallel num_threads(3)
- for(auto iter = sfmData.getViews().begin(); iter != sfmData.getViews().end() && !invalid; ++iter)
- {
-#pragma omp single nowait
-   {
-     for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
-     {
-       if(viewIdFilter.empty() || viewIdFilter.find(iter->second.get()->getViewId()) != viewIdFilter.end())
-       {
-         std::unique_ptr<feature::Regions> regionsPtr = loadRegions(featuresFolders, iter->second.get()->getViewId(), *(imageDescribers.at(i)));
-         if(regionsPtr)
-         {
-#pragma omp critical
-           {
-             regionsPerView.addRegions(iter->second.get()->getViewId(), imageDescriberTypes.at(i), regionsPtr.release());
-             ++progressBar;
-           }
-         }
-         else
-         {
-           invalid = true;
-         }
-       }
-     }
-   }
- }
+  std::vector<const View*> views;
+  views.reserve(sfmData.getViews().size());
+  for(const auto& viewPair : sfmData.getViews())
+    views.push_back(viewPair.second.get());
+
+  system::ParallelForOptions options;
+  options.taskClass = system::ETaskClass::DiskRead;
+  options.grainSize = 1;
+
+  std::mutex mutex;
+
+  system::parallelFor(std::size_t(0), views.size(), [&](std::size_t v)
+  {
+    if(invalid)
+      return;
+
+    const IndexT viewId = views[v]->getViewId();
+    for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
+    {
+      if(viewIdFilter.empty() || viewIdFilter.find(viewId) != viewIdFilter.end())
+      {
+        std::unique_ptr<feature::Regions> regionsPtr = loadRegions(featuresFolders, viewId, *(imageDescribers.at(i)), mapDescriptors || featuresOnly);
+        if(regionsPtr)
+        {
+          if(featuresOnly)
+            regionsPtr->clearDescriptors();
+
+          std::lock_guard<std::mutex> lock(mutex);
+          regionsPerView.addRegions(viewId, imageDescriberTypes.at(i), regionsPtr.release());
+          ++progressBar;
+        }
+        else
+        {
+          invalid = true;
+        }
+      }
+    }
+  }, options);
+
  return !invalid;
 }
 
@@ -177,6 +276,8 @@ bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
                       const std::vector<std::string>& folders,
                       const std::vector<feature::EImageDescriberType>& imageDescriberTypes)
 {
+  ALICEVISION_PROFILE_SCOPE("sfm::loadFeaturesPerView");
+
   std::vector<std::string> featuresFolders = sfmData.getFeaturesFolders(); // add sfm features folders
   featuresFolders.insert(featuresFolders.end(), folders.begin(), folders.end()); // add user features folders
 
@@ -191,26 +292,101 @@ bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
   for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
     imageDescribers.at(i) = createImageDescriber(imageDescriberTypes.at(i));
 
-#pragma omp parallel
-  for (auto iter = sfmData.getViews().begin(); (iter != sfmData.getViews().end()) && (!invalid); ++iter)
+  std::vector<const View*> views;
+  views.reserve(sfmData.getViews().size());
+  for(const auto& viewPair : sfmData.getViews())
+    views.push_back(viewPair.second.get());
+
+  // parsing the features is CPU bound: no disk read limit
+  system::ParallelForOptions options;
+  options.grainSize = 1;
+
+  std::mutex mutex;
+
+  system::parallelFor(std::size_t(0), views.size(), [&](std::size_t v)
   {
-#pragma omp single nowait
+    const IndexT viewId = views[v]->getViewId();
+    for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
     {
-      for(std::size_t i = 0; i < imageDescriberTypes.size(); ++i)
-      {
-        std::unique_ptr<feature::Regions> regionsPtr = loadFeatures(featuresFolders, iter->second.get()->getViewId(), *imageDescribers.at(i));
+      std::unique_ptr<feature::Regions> regionsPtr = loadFeatures(featuresFolders, viewId, *imageDescribers.at(i));
 
-#pragma omp critical
-        {
-          // save loaded Features as PointFeature
-          featuresPerView.addFeatures(iter->second.get()->getViewId(), imageDescriberTypes[i], regionsPtr->GetRegionsPositions());
-          ++progressBar;
-        }
-      }
+      // save loaded Features as PointFeature
+      std::lock_guard<std::mutex> lock(mutex);
+      featuresPerView.addFeatures(viewId, imageDescriberTypes[i], regionsPtr->GetRegionsPositions());
+      ++progressBar;
     }
+  }, options);
+  return !invalid;
+}
+
+bool extractRegionsPerView(feature::RegionsPerView& regionsPerView,
+                           const SfMData& sfmData,
+                           const std::vector<std::shared_ptr<feature::ImageDescriber>>& imageDescribers,
+                           int tileSize,
+                           int tileOverlap,
+                           const std::set<IndexT>& viewIdFilter)
+{
+  ALICEVISION_PROFILE_SCOPE("sfm::extractRegionsPerView");
+
+  std::vector<const View*> views;
+  views.reserve(sfmData.getViews().size());
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    if(viewIdFilter.empty() || viewIdFilter.find(viewPair.first) != viewIdFilter.end())
+      views.push_back(viewPair.second.get());
   }
+
+  system::ParallelForOptions options;
+  options.grainSize = 1;
+
+  // the CUDA image describers extract one image at a time
+  for(const auto& imageDescriber : imageDescribers)
+  {
+    if(imageDescriber->useCuda())
+      options.maxConcurrency = 1;
+  }
+
+  std::atomic_bool invalid(false);
+  std::mutex mutex;
+
+  system::parallelFor(std::size_t(0), views.size(), [&](std::size_t v)
+  {
+    if(invalid)
+      return;
+
+    const View& view = *views[v];
+
+    image::Image<float> imageGrayFloat;
+    image::Image<unsigned char> imageGrayUChar;
+    image::readImage(view.getImagePath(), imageGrayFloat, image::EImageColorSpace::SRGB);
+
+    for(const auto& imageDescriber : imageDescribers)
+    {
+      std::unique_ptr<feature::Regions> regionsPtr;
+      if(!feature::describeImage(*imageDescriber, imageGrayFloat, imageGrayUChar, regionsPtr, tileSize, tileOverlap) || !regionsPtr)
+      {
+        ALICEVISION_LOG_ERROR("Cannot extract the " << feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType())
+                              << " regions of the view '" << view.getImagePath() << "'");
+        invalid = true;
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      regionsPerView.addRegions(view.getViewId(), imageDescriber->getDescriberType(), regionsPtr.release());
+    }
+  }, options);
   return !invalid;
 }
 
+void getFeaturesPerView(feature::FeaturesPerView& featuresPerView,
+                        const feature::RegionsPerView& regionsPerView)
+{
+  for(const auto& viewRegions : regionsPerView.getData())
+  {
+    for(const auto& descRegions : viewRegions.second)
+      featuresPerView.addFeatures(viewRegions.first, descRegions.first, descRegions.second->GetRegionsPositions());
+  }
+}
+
 } // namespace sfm
 } // namespace aliceVision
@@ -21,15 +21,20 @@ namespace sfm {
 
 /**
  * @brief Load Regions (Features & Descriptors) for one view.
+ * @note The binary regions container (.regions) is used if available,
+ *       otherwise the legacy features (.feat) and descriptors (.desc) files are loaded.
  * @param[in] folders The list of featureFolders
  * @param[in] viewId The view id
  * @param[in] imageDescriber The imageDescriber type
+ * @param[in] mapDescriptors Keep the descriptors in the memory-mapped regions container (if available)
  * @return loaded Regions
  */
-std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders, IndexT viewId, const feature::ImageDescriber& imageDescriber);
+std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders, IndexT viewId, const feature::ImageDescriber& imageDescriber, bool mapDescriptors = false);
 
 /**
  * @brief Load Features for one view.
+ * @note The features of the binary regions container (.regions) are used if available,
+ *       otherwise the legacy features file (.feat) is loaded.
  * @param[in] folders The list of featureFolders
  * @param[in] viewId The view id
  * @param[in] imageDescriber The imageDescriber type
@@ -44,13 +49,39 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
  * @param[in] folders The feature Folders
  * @param[in] imageDescriberTypes The imageDescriber types
  * @param[in] filter To load Regions only for a sub-set of the views contained in the sfmData
+ * @param[in] mapDescriptors Keep the descriptors in the memory-mapped regions containers (if available),
+ *            the OS page cache is then the only copy of the descriptors
+ * @param[in] featuresOnly Release the descriptors once loaded, only the features are kept
  * @return true if the regions are correctlty loaded
  */
 bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
                         const sfmData::SfMData& sfmData,
                         const std::vector<std::string>& folders,
                         const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
-                        const std::set<IndexT>& filter = std::set<IndexT>());
+                        const std::set<IndexT>& filter = std::set<IndexT>(),
+                        bool mapDescriptors = false,
+                        bool featuresOnly = false);
+
+/**
+ * @brief Extract the regions of the views of the provided SfMData container in memory,
+ *        as featureExtraction does, without writing the features and descriptors files.
+ * @note The result can be matched directly with matchingImageCollection::computePairwiseMatches,
+ *       and saved with ImageDescriber::Save if needed.
+ * @param[in,out] regionsPerView The regions of each view and describer type
+ * @param[in] sfmData The provided SfMData container
+ * @param[in] imageDescribers The image describers, shared by the threads (the views are described one by one
+ *            if an image describer uses CUDA)
+ * @param[in] tileSize The size of a tile core (in pixels), 0 to extract on the full images
+ * @param[in] tileOverlap The overlap added on each side of a tile core (in pixels)
+ * @param[in] filter To extract Regions only for a sub-set of the views contained in the sfmData
+ * @return true if the regions of all the views are extracted
+ */
+bool extractRegionsPerView(feature::RegionsPerView& regionsPerView,
+                           const sfmData::SfMData& sfmData,
+                           const std::vector<std::shared_ptr<feature::ImageDescriber>>& imageDescribers,
+                           int tileSize = 0,
+                           int tileOverlap = 0,
+                           const std::set<IndexT>& filter = std::set<IndexT>());
 
 /**
  * @brief Load Features for each view of the provided SfMData container.
@@ -65,5 +96,14 @@ bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
                          const std::vector<std::string>& folders,
                          const std::vector<feature::EImageDescriberType>& imageDescriberTypes);
 
+/**
+ * @brief Get the features of regions already in memory (e.g. computed in the same process),
+ *        instead of reading the features files with loadFeaturesPerView.
+ * @param[out] featuresPerView The features of each view and describer type
+ * @param[in] regionsPerView The regions of each view and describer type
+ */
+void getFeaturesPerView(feature::FeaturesPerView& featuresPerView,
+                        const feature::RegionsPerView& regionsPerView);
+
 } // namespace sfm
 } // namespace aliceVision
@@ -0,0 +1,92 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/pipeline/regionsIO.hpp>
+#include <aliceVision/feature/regionsFactory.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE regionsIO
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+feature::SIFT_Regions createRegions(int nbRegions, int seed)
+{
+  feature::SIFT_Regions regions;
+  for(int i = 0; i < nbRegions; ++i)
+  {
+    regions.Features().emplace_back(seed + i, seed + 2.f * i, 1.f + i, 0.5f * i);
+    feature::SIFT_Regions::DescriptorT desc;
+    for(int j = 0; j < 128; ++j)
+      desc[j] = (seed + i + j) % 256;
+    regions.Descriptors().push_back(desc);
+  }
+  return regions;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(regionsIO_containerRoundTrip)
+{
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path("regionsIO_%%%%-%%%%");
+  fs::create_directories(folder);
+
+  // view 1: regions container only (featureExtraction --regionsContainer)
+  // view 2: legacy .feat / .desc files
+  // view 3: both, the container has priority
+  const feature::SIFT_Regions regions1 = createRegions(20, 0);
+  const feature::SIFT_Regions regions2 = createRegions(15, 100);
+  const feature::SIFT_Regions regions3 = createRegions(10, 200);
+  const feature::SIFT_Regions legacyRegions3 = createRegions(5, 300);
+
+  regions1.SaveContainer((folder / "1.sift.regions").string());
+  regions2.Save((folder / "2.sift.feat").string(), (folder / "2.sift.desc").string());
+  regions3.SaveContainer((folder / "3.sift.regions").string());
+  legacyRegions3.Save((folder / "3.sift.feat").string(), (folder / "3.sift.desc").string());
+
+  const std::map<IndexT, const feature::SIFT_Regions*> expected = {{1, &regions1}, {2, &regions2}, {3, &regions3}};
+
+  sfmData::SfMData sfmData;
+  for(const auto& viewRegions : expected)
+    sfmData.getViews().emplace(viewRegions.first, std::make_shared<sfmData::View>("", viewRegions.first));
+
+  const std::vector<feature::EImageDescriberType> describerTypes = {feature::EImageDescriberType::SIFT};
+
+  feature::FeaturesPerView featuresPerView;
+  BOOST_CHECK(sfm::loadFeaturesPerView(featuresPerView, sfmData, {folder.string()}, describerTypes));
+
+  feature::RegionsPerView regionsPerView;
+  BOOST_CHECK(sfm::loadRegionsPerView(regionsPerView, sfmData, {folder.string()}, describerTypes));
+
+  for(const auto& viewRegions : expected)
+  {
+    const feature::SIFT_Regions& regions = *viewRegions.second;
+
+    const feature::PointFeatures& features = featuresPerView.getFeatures(viewRegions.first, feature::EImageDescriberType::SIFT);
+    BOOST_CHECK_EQUAL(features.size(), regions.RegionCount());
+    for(std::size_t i = 0; i < std::min(features.size(), regions.RegionCount()); ++i)
+      BOOST_CHECK_EQUAL(features[i].coords(), regions.Features()[i].coords());
+
+    const feature::SIFT_Regions& loaded = dynamic_cast<const feature::SIFT_Regions&>(regionsPerView.getRegions(viewRegions.first, feature::EImageDescriberType::SIFT));
+    BOOST_CHECK_EQUAL(loaded.RegionCount(), regions.RegionCount());
+    for(std::size_t i = 0; i < std::min(loaded.RegionCount(), regions.RegionCount()); ++i)
+    {
+      BOOST_CHECK_EQUAL(loaded.Features()[i], regions.Features()[i]);
+      BOOST_CHECK(loaded.Descriptors()[i] == regions.Descriptors()[i]);
+    }
+  }
+
+  fs::remove_all(folder);
+}
@@ -21,10 +21,13 @@
 #include <aliceVision/robustEstimation/LORansac.hpp>
 #include <aliceVision/robustEstimation/ScoreEvaluator.hpp>
 #include <aliceVision/graph/connectedComponent.hpp>
+#include <aliceVision/track/io.hpp>
+#include <aliceVision/track/TracksStore.hpp>
 #include <aliceVision/stl/stl.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/cpu.hpp>
 #include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/config.hpp>
 
 #include <dependencies/htmlDoc/htmlDoc.hpp>
@@ -34,6 +37,7 @@
 #include <boost/functional/hash.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <bitset>
 #include <tuple>
 #include <iostream>
 #include <algorithm>
@@ -51,6 +55,32 @@ using namespace aliceVision::geometry;
 using namespace aliceVision::camera;
 using namespace aliceVision::sfmData;
 
+/**
+ * @brief Copy a scene without sharing its views and intrinsics,
+ * to export it while the reconstruction continues.
+ * @param[in] sfmData The scene
+ * @return The independent copy
+ */
+SfMData copyScene(const SfMData& sfmData)
+{
+  SfMData scene = sfmData;
+  for(auto& viewPair : scene.getViews())
+    viewPair.second = std::make_shared<View>(*viewPair.second);
+  for(auto& intrinsicPair : scene.getIntrinsics())
+    intrinsicPair.second = std::shared_ptr<IntrinsicBase>(intrinsicPair.second->clone());
+  return scene;
+}
+
+/**
+ * @brief Get the file of the engine state saved next to a checkpoint.
+ * @param[in] checkpointFile The checkpoint SfMData file
+ * @return The engine state file
+ */
+std::string getCheckpointStateFile(const std::string& checkpointFile)
+{
+  return checkpointFile + ".state.json";
+}
+
 /**
  * @brief Compute indexes of all features in a fixed size pyramid grid.
  * These precomputed values are useful to the next best view selection for incremental SfM.
@@ -59,9 +89,11 @@ using namespace aliceVision::sfmData;
  * @param[in] map_tracks: All putative tracks
  * @param[in] views: All views
  * @param[in] featuresProvider: Input features and descriptors
+ * @param[in] pyramidBase: Base of the pyramid.
  * @param[in] pyramidDepth: Depth of the pyramid.
+ * @param[in] pyramidCodeShifts: First bit of each pyramid level in the pyramid codes (pyramidDepth + 1 values).
  * @param[out] tracksPyramidPerView:
- *             Precomputed list of pyramid cells ID for each track in each view.
+ *             Precomputed pyramid code of each track in each view, in the order of tracksPerView.
  */
 void computeTracksPyramidPerView(
     const track::TracksPerView& tracksPerView,
@@ -70,30 +102,21 @@ void computeTracksPyramidPerView(
     const feature::FeaturesPerView& featuresProvider,
     const std::size_t pyramidBase,
     const std::size_t pyramidDepth,
+    const std::vector<int>& pyramidCodeShifts,
     track::TracksPyramidPerView& tracksPyramidPerView)
 {
   std::vector<std::size_t> widthPerLevel(pyramidDepth);
-  std::vector<std::size_t> startPerLevel(pyramidDepth);
-  std::size_t start = 0;
   for(std::size_t level = 0; level < pyramidDepth; ++level)
-  {
-    startPerLevel[level] = start;
     widthPerLevel[level] = std::pow(pyramidBase, level+1);
-    start += Square(widthPerLevel[level]);
-  }
 
   tracksPyramidPerView.reserve(tracksPerView.size());
   for(const auto& viewTracks: tracksPerView)
-  {
-    auto& trackPyramid = tracksPyramidPerView[viewTracks.first];
-    // reserve 500 tracks in each view
-    trackPyramid.reserve(500 * pyramidDepth);
-  }
+    tracksPyramidPerView[viewTracks.first].resize(viewTracks.second.size());
 
   for(const auto& viewTracks: tracksPerView)
   {
     const auto viewId = viewTracks.first;
-    auto& tracksPyramidIndex = tracksPyramidPerView[viewId];
+    auto& tracksPyramidCodes = tracksPyramidPerView[viewId];
     const View& view = *views.at(viewId).get();
     std::vector<double> cellWidthPerLevel(pyramidDepth);
     std::vector<double> cellHeightPerLevel(pyramidDepth);
@@ -108,7 +131,8 @@ void computeTracksPyramidPerView(
       const track::Track& track = map_tracks.at(trackId);
       const std::size_t featIndex = track.featPerView.at(viewId);
       const auto& feature = featuresProvider.getFeatures(viewId, track.descType)[featIndex]; 
-      
+
+      std::uint32_t code = 0;
       for(std::size_t level = 0; level < pyramidDepth; ++level)
       {
         std::size_t xCell = std::floor(std::max(feature.x(), 0.0f) / cellWidthPerLevel[level]);
@@ -117,8 +141,9 @@ void computeTracksPyramidPerView(
         yCell = std::min(yCell, widthPerLevel[level] - 1);
         const std::size_t levelIndex = xCell + yCell * widthPerLevel[level];
         assert(levelIndex < Square(widthPerLevel[level]));
-        tracksPyramidIndex[trackId * pyramidDepth + level] = startPerLevel[level] + levelIndex;
+        code |= static_cast<std::uint32_t>(levelIndex) << pyramidCodeShifts[level];
       }
+      tracksPyramidCodes[i] = code;
     }
   }
 }
@@ -157,6 +182,8 @@ ReconstructionEngine_sequentialSfM::ReconstructionEngine_sequentialSfM(
 
 bool ReconstructionEngine_sequentialSfM::process()
 {
+  ALICEVISION_PROFILE_SCOPE("sequentialSfM::process");
+
   initializePyramidScoring();
 
   if(fuseMatchesIntoTracks() == 0)
@@ -164,6 +191,10 @@ bool ReconstructionEngine_sequentialSfM::process()
     throw std::runtime_error("No valid tracks.");
   }
 
+  // the checkpoint is resumed as a scene to augment
+  if(_params.resumeFromCheckpoint)
+    loadCheckpoint();
+
   // initial pair choice
   if(_sfmData.getPoses().empty())
   {
@@ -221,30 +252,72 @@ void ReconstructionEngine_sequentialSfM::initializePyramidScoring()
       maxWeight += nbCells * _pyramidWeights[level];
     }
     _pyramidThreshold = maxWeight * 0.2;
+
+    // layout of the pyramid codes and of the cells bitset used for the scoring,
+    // each level starts on a new bitset word
+    _pyramidCodeShifts.resize(_params.pyramidDepth + 1);
+    _pyramidBitsetOffsets.resize(_params.pyramidDepth + 1);
+    int shift = 0;
+    std::size_t offset = 0;
+    for(std::size_t level = 0; level < _params.pyramidDepth; ++level)
+    {
+      const std::size_t nbCells = Square(std::pow(_params.pyramidBase, level+1));
+      int nbBits = 0;
+      while((std::size_t(1) << nbBits) < nbCells)
+        ++nbBits;
+      _pyramidCodeShifts[level] = shift;
+      _pyramidBitsetOffsets[level] = offset;
+      shift += nbBits;
+      offset += (nbCells + 63) / 64;
+    }
+    _pyramidCodeShifts[_params.pyramidDepth] = shift;
+    _pyramidBitsetOffsets[_params.pyramidDepth] = offset;
+
+    if(shift > 32)
+      throw std::runtime_error("The cell indexes of the scoring pyramid don't fit in 32 bits, the pyramid is too deep.");
   }
 }
 
 std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
 {
+  ALICEVISION_PROFILE_SCOPE("sequentialSfM::fuseMatchesIntoTracks");
+
   // compute tracks from matches
-  track::TracksBuilder tracksBuilder;
+  track::TracksStore tracksStore;
 
   {
     // list of features matches for each couple of images
     const aliceVision::matching::PairwiseMatches& matches = *_pairwiseMatches;
 
-    ALICEVISION_LOG_DEBUG("Track building");
-    tracksBuilder.build(matches);
+    const bool useTracksCache = !_params.tracksCacheFile.empty();
+    const std::uint64_t tracksKey = useTracksCache ? track::computeTracksFileKey(matches, _params.useTrackFiltering, _params.minInputTrackLength) : 0;
 
-    if(_params.useTrackFiltering)
+    if(useTracksCache && track::loadTracks(tracksStore, _params.tracksCacheFile, tracksKey))
     {
-      ALICEVISION_LOG_DEBUG("Track filtering");
-      tracksBuilder.filter(_params.minInputTrackLength);
+      ALICEVISION_LOG_INFO("Tracks loaded from the tracks cache: " << _params.tracksCacheFile);
+    }
+    else
+    {
+      track::TracksBuilder tracksBuilder;
+
+      ALICEVISION_LOG_DEBUG("Track building");
+      tracksBuilder.build(matches);
+
+      if(_params.useTrackFiltering)
+      {
+        ALICEVISION_LOG_DEBUG("Track filtering");
+        tracksBuilder.filter(_params.minInputTrackLength);
+      }
+
+      tracksBuilder.exportToStore(tracksStore);
+
+      if(useTracksCache && track::saveTracks(tracksStore, _params.tracksCacheFile, tracksKey))
+        ALICEVISION_LOG_INFO("Tracks saved to the tracks cache: " << _params.tracksCacheFile);
     }
 
     ALICEVISION_LOG_DEBUG("Track export to internal structure");
     // build tracks with STL compliant type
-    tracksBuilder.exportToSTL(_map_tracks);
+    tracksStore.exportToSTL(_map_tracks);
     ALICEVISION_LOG_DEBUG("Build tracks per view");
 
     // Init tracksPerView to have an entry in the map for each view (even if there is no track at all)
@@ -256,7 +329,7 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
     track::tracksUtilsMap::computeTracksPerView(_map_tracks, _map_tracksPerView);
     ALICEVISION_LOG_DEBUG("Build tracks pyramid per view");
     computeTracksPyramidPerView(
-            _map_tracksPerView, _map_tracks, _sfmData.views, *_featuresPerView, _params.pyramidBase, _params.pyramidDepth, _map_featsPyramidPerView);
+            _map_tracksPerView, _map_tracks, _sfmData.views, *_featuresPerView, _params.pyramidBase, _params.pyramidDepth, _pyramidCodeShifts, _map_featsPyramidPerView);
 
     // display stats
     {
@@ -264,7 +337,7 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
       track::tracksUtilsMap::imageIdInTracks(_map_tracksPerView, imagesId);
 
       ALICEVISION_LOG_INFO("Fuse matches into tracks: " << std::endl
-        << "\t- # tracks: " << tracksBuilder.nbTracks() << std::endl
+        << "\t- # tracks: " << tracksStore.nbTracks() << std::endl
         << "\t- # images in tracks: " << imagesId.size());
 
       std::map<size_t, size_t> map_Occurence_TrackLength;
@@ -379,6 +452,8 @@ void ReconstructionEngine_sequentialSfM::remapLandmarkIdsToTrackIds()
 
 double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
 {
+  ALICEVISION_PROFILE_SCOPE("sequentialSfM::incrementalReconstruction");
+
   IndexT resectionId = 0;
 
   std::set<IndexT> remainingViewIds;
@@ -394,7 +469,7 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
       remainingViewIds.insert(viewId);
 
     if(viewResectionId != UndefinedIndexT &&
-       viewResectionId > resectionId)
+       viewResectionId >= resectionId)
     {
       resectionId = viewResectionId + 1;
     }
@@ -421,6 +496,7 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
   }
 
   aliceVision::system::Timer timer;
+  aliceVision::system::Timer checkpointTimer;
 
   std::size_t nbValidPoses = 0;
   std::size_t globalIteration = 0;
@@ -463,6 +539,13 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
       }
 
       ++resectionId;
+
+      // periodic checkpoint, saved in the background
+      if(!_params.checkpointFile.empty() && checkpointTimer.elapsed() > _params.checkpointInterval)
+      {
+        saveCheckpoint();
+        checkpointTimer.reset();
+      }
     }
 
     if(_params.useRigConstraint && !_sfmData.getRigs().empty())
@@ -491,6 +574,8 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
   }
   while(nbValidPoses != _sfmData.getPoses().size());
 
+  waitCheckpoint();
+
   ALICEVISION_LOG_INFO("Incremental Reconstruction completed with " << globalIteration << " iterations:" << std::endl
                        << "\t- # number of resection groups: " << resectionId << std::endl
                        << "\t- # number of poses: " << nbValidPoses << std::endl
@@ -509,68 +594,112 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
   auto chrono_start = std::chrono::steady_clock::now();
 
   // add images to the 3D reconstruction
-#pragma omp parallel for
-  for(int i = 0; i < bestViewIds.size(); ++i)
+  // The views are resected in batches: the resections of a batch are computed in parallel on the current scene,
+  // then the scene is updated serially in the order of bestViewIds.
+  // A batch contains at most one view per intrinsic to initialize or to refine and one view per rig,
+  // the other views are deferred to the next batch to see the updated intrinsics and rig poses.
+  std::vector<IndexT> pendingViewIds = bestViewIds;
+  std::size_t viewIndex = 0;
+
+  while(!pendingViewIds.empty())
   {
-    const IndexT viewId = bestViewIds.at(i);
-    const View& view = *_sfmData.getViews().at(viewId);
+    std::vector<IndexT> batchViewIds;
+    std::vector<IndexT> deferredViewIds;
+    std::set<IndexT> batchIntrinsics;
+    std::set<IndexT> batchRigs;
+    const std::set<IndexT> reconstructedIntrinsics = _sfmData.getReconstructedIntrinsics();
 
-    if(view.isPartOfRig())
+    for(const IndexT viewId : pendingViewIds)
     {
-      // some views can become indirectly localized when the sub-pose becomes defined
-      if(_sfmData.isPoseAndIntrinsicDefined(view.getViewId()))
+      const View& view = *_sfmData.getViews().at(viewId);
+
+      if(view.isPartOfRig())
       {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " was skipped." << std::endl
-          << "View indirectly localized, sub-pose and pose already defined." << std::endl
-          << "\t- view id: " << viewId << std::endl
-          << "\t- rig id: " << view.getRigId() << std::endl
-          << "\t- sub-pose id: " << view.getSubPoseId());
+        // some views can become indirectly localized when the sub-pose becomes defined
+        if(_sfmData.isPoseAndIntrinsicDefined(view.getViewId()))
+        {
+          ALICEVISION_LOG_DEBUG("Resection of image " << viewIndex << " was skipped." << std::endl
+            << "View indirectly localized, sub-pose and pose already defined." << std::endl
+            << "\t- view id: " << viewId << std::endl
+            << "\t- rig id: " << view.getRigId() << std::endl
+            << "\t- sub-pose id: " << view.getSubPoseId());
+
+          remainingViewIds.erase(viewId);
+          ++viewIndex;
+          continue;
+        }
 
-#pragma omp critical
-        remainingViewIds.erase(viewId);
+        // we cannot localize a view if it is part of an initialized rig with unknown rig pose and unknown sub-pose
+        const bool knownPose = _sfmData.existsPose(view);
+        const Rig& rig = _sfmData.getRig(view);
+        const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
 
-        continue;
+        if(rig.isInitialized() && !knownPose && (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
+        {
+          ALICEVISION_LOG_DEBUG("Resection of image " << viewIndex << " was skipped." << std::endl
+            << "Rig initialized but unkown pose and sub-pose." << std::endl
+            << "\t- view id: " << viewId << std::endl
+            << "\t- rig id: " << view.getRigId() << std::endl
+            << "\t- sub-pose id: " << view.getSubPoseId());
+
+          remainingViewIds.erase(viewId);
+          ++viewIndex;
+          continue;
+        }
+
+        if(!batchRigs.insert(view.getRigId()).second)
+        {
+          deferredViewIds.push_back(viewId);
+          continue;
+        }
       }
 
-      // we cannot localize a view if it is part of an initialized rig with unknown rig pose and unknown sub-pose
-      const bool knownPose = _sfmData.existsPose(view);
-      const Rig& rig = _sfmData.getRig(view);
-      const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
+      // the resection initializes or refines the intrinsic at its first usage
+      const camera::IntrinsicBase* intrinsic = _sfmData.getIntrinsicPtr(view.getIntrinsicId());
+      const bool modifiedIntrinsic = (intrinsic == nullptr || !intrinsic->isValid() || reconstructedIntrinsics.count(view.getIntrinsicId()) == 0);
 
-      if(rig.isInitialized() && !knownPose && (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
+      if(modifiedIntrinsic && !batchIntrinsics.insert(view.getIntrinsicId()).second)
       {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " was skipped." << std::endl
-          << "Rig initialized but unkown pose and sub-pose." << std::endl
-          << "\t- view id: " << viewId << std::endl
-          << "\t- rig id: " << view.getRigId() << std::endl
-          << "\t- sub-pose id: " << view.getSubPoseId());
-
-#pragma omp critical
-        remainingViewIds.erase(viewId);
-
+        deferredViewIds.push_back(viewId);
         continue;
       }
+
+      batchViewIds.push_back(viewId);
     }
 
-    ResectionData newResectionData;
-    newResectionData.error_max = _params.localizerEstimatorError;
-    newResectionData.max_iteration = _params.localizerEstimatorMaxIterations;
-    const bool hasResected = computeResection(viewId, newResectionData);
+    // resect the views of the batch on the current scene
+    std::vector<ResectionData> batchResectionData(batchViewIds.size());
+    std::vector<char> batchHasResected(batchViewIds.size(), false);
 
-#pragma omp critical
+#pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < batchViewIds.size(); ++i)
+    {
+      ResectionData& newResectionData = batchResectionData[i];
+      newResectionData.error_max = _params.localizerEstimatorError;
+      newResectionData.max_iteration = _params.localizerEstimatorMaxIterations;
+      newResectionData.nbHistogramBins = _params.nbHistogramBins;
+      batchHasResected[i] = computeResection(batchViewIds[i], newResectionData);
+    }
+
+    // update the scene in a deterministic order
+    for(std::size_t i = 0; i < batchViewIds.size(); ++i, ++viewIndex)
     {
-      if(hasResected)
+      const IndexT viewId = batchViewIds[i];
+
+      if(batchHasResected[i])
       {
-        updateScene(viewId, newResectionData);
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
+        updateScene(viewId, batchResectionData[i]);
+        ALICEVISION_LOG_DEBUG("Resection of image " << viewIndex << " ( view id: " << viewId << " ) succeed.");
         _sfmData.getViews().at(viewId)->setResectionId(resectionId);
       }
       else
       {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was not possible.");
+        ALICEVISION_LOG_DEBUG("Resection of image " << viewIndex << " ( view id: " << viewId << " ) was not possible.");
       }
       remainingViewIds.erase(viewId);
     }
+
+    pendingViewIds.swap(deferredViewIds);
   }
 
   ALICEVISION_LOG_DEBUG("Resection of " << bestViewIds.size() << " new images took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
@@ -594,6 +723,8 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
 
 void ReconstructionEngine_sequentialSfM::triangulate(const std::set<IndexT>& prevReconstructedViews, const std::set<IndexT>& newReconstructedViews)
 {
+  ALICEVISION_PROFILE_SCOPE("sequentialSfM::triangulate");
+
   auto chrono_start = std::chrono::steady_clock::now();
 
   // allow to use to the old triangulatation algorithm (using 2 views only)
@@ -607,10 +738,11 @@ void ReconstructionEngine_sequentialSfM::triangulate(const std::set<IndexT>& pre
 
 bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newReconstructedViews, bool isInitialPair)
 {
+  ALICEVISION_PROFILE_SCOPE("sequentialSfM::bundleAdjustment");
+
   ALICEVISION_LOG_INFO("Bundle adjustment start.");
   auto chronoStart = std::chrono::steady_clock::now();
 
-  BundleAdjustmentCeres::CeresOptions options;
   BundleAdjustment::ERefineOptions refineOptions = BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE;
 
   if(!isInitialPair && !_params.lockAllIntrinsics)
@@ -621,17 +753,9 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
   std::size_t nbOutliers = 0;
   bool enableLocalStrategy = false;
 
-  // enable Sparse solver and local strategy
-  if(_sfmData.getPoses().size() > 100)
-  {
-    options.setSparseBA();
-    if(_params.useLocalBundleAdjustment) // local strategy enable if more than 100 poses
-      enableLocalStrategy = true;
-  }
-  else
-  {
-    options.setDenseBA();
-  }
+  // enable local strategy if more than 100 poses
+  if(_sfmData.getPoses().size() > 100 && _params.useLocalBundleAdjustment)
+    enableLocalStrategy = true;
 
   // add the new reconstructed views to the graph
   if(_params.useLocalBundleAdjustment)
@@ -644,14 +768,9 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
     _localStrategyGraph->computeGraphDistances(_sfmData, newReconstructedViews);
 
     // use the graph-distances to assign a state (Refine, Constant & Ignore) for each parameter (poses, intrinsics & landmarks)
-    _localStrategyGraph->convertDistancesToStates(_sfmData);
+    _localStrategyGraph->convertDistancesToStates(_sfmData, _map_tracksPerView);
 
     const std::size_t nbRefinedPoses = _localStrategyGraph->getNbPosesPerState(BundleAdjustment::EParameterState::REFINED);
-    const std::size_t nbConstantPoses = _localStrategyGraph->getNbPosesPerState(BundleAdjustment::EParameterState::CONSTANT);
-
-    // restore the Dense linear solver type if the number of cameras in the solver is <= 20
-    if(nbRefinedPoses + nbConstantPoses <= 20)
-      options.setDenseBA();
 
     // parameters are refined only if the number of cameras to refine is > to the number of newly added cameras.
     // - if they are equal: it means that none of the new cameras is connected to the local BA graph,
@@ -664,11 +783,23 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
     }
   }
 
-  BundleAdjustmentCeres BA(options);
+  if(_bundleAdjustment == nullptr)
+  {
+    BundleAdjustmentCeres::CeresOptions options;
+    // select the linear solver from the refined parameters of each adjustment
+    options.setAutoBA();
+    // keep the Ceres problem between the adjustments, only the changes of the scene are applied
+    options.usePersistentProblem = true;
+    // adjust the cameras of the large scenes with a subset of the landmarks
+    options.landmarksSubsamplingMaxPerView = _params.baLandmarksSubsamplingMaxPerView;
+    options.landmarksSubsamplingMinObservations = _params.baLandmarksSubsamplingMinObservations;
+    _bundleAdjustment = std::make_shared<BundleAdjustmentCeres>(options);
+  }
+
+  BundleAdjustmentCeres& BA = *_bundleAdjustment;
 
   // give the local strategy graph is local strategy is enable
-  if(enableLocalStrategy)
-    BA.useLocalStrategyGraph(_localStrategyGraph);
+  BA.useLocalStrategyGraph(enableLocalStrategy ? _localStrategyGraph : nullptr);
 
   // perform BA until all point are under the given precision
   do
@@ -820,6 +951,108 @@ void ReconstructionEngine_sequentialSfM::exportStatistics(double reconstructionT
     _localStrategyGraph->exportIntrinsicsHistory(_outputFolder, "intrinsics_history.csv");
 }
 
+bool ReconstructionEngine_sequentialSfM::loadCheckpoint()
+{
+  if(_params.checkpointFile.empty() || !fs::exists(_params.checkpointFile))
+  {
+    ALICEVISION_LOG_INFO("No checkpoint to resume, the reconstruction starts from the input scene.");
+    return false;
+  }
+
+  SfMData checkpoint;
+  if(!sfmDataIO::Load(checkpoint, _params.checkpointFile, sfmDataIO::ESfMData::ALL))
+    throw std::runtime_error("Unable to load the checkpoint file: " + _params.checkpointFile);
+
+  // the locks of the input scene are not always exported
+  for(auto& posePair : checkpoint.getPoses())
+  {
+    const auto inputPoseIt = _sfmData.getPoses().find(posePair.first);
+    if(inputPoseIt != _sfmData.getPoses().end() && inputPoseIt->second.isLocked())
+      posePair.second.lock();
+  }
+  for(auto& intrinsicPair : checkpoint.getIntrinsics())
+  {
+    const auto inputIntrinsicIt = _sfmData.getIntrinsics().find(intrinsicPair.first);
+    if(inputIntrinsicIt != _sfmData.getIntrinsics().end() && inputIntrinsicIt->second->isLocked())
+      intrinsicPair.second->lock();
+  }
+
+  _sfmData = std::move(checkpoint);
+
+  // engine state
+  const std::string stateFile = getCheckpointStateFile(_params.checkpointFile);
+  if(fs::exists(stateFile))
+  {
+    pt::ptree stateTree;
+    pt::read_json(stateFile, stateTree);
+
+    for(const auto& acThresholdNode : stateTree.get_child("acThresholds", pt::ptree()))
+      _map_ACThreshold[acThresholdNode.second.get<IndexT>("viewId")] = acThresholdNode.second.get<double>("threshold");
+  }
+  else
+  {
+    ALICEVISION_LOG_WARNING("No engine state file next to the checkpoint, the default a contrario thresholds are used: " << stateFile);
+  }
+
+  ALICEVISION_LOG_INFO("Resume the reconstruction from the checkpoint: " << _params.checkpointFile << std::endl
+    << "\t- # poses: " << _sfmData.getPoses().size() << std::endl
+    << "\t- # landmarks: " << _sfmData.getLandmarks().size());
+
+  return true;
+}
+
+void ReconstructionEngine_sequentialSfM::saveCheckpoint()
+{
+  waitCheckpoint();
+
+  SfMData scene = copyScene(_sfmData);
+  scene.setAbsolutePath(_params.checkpointFile);
+
+  pt::ptree stateTree;
+  {
+    pt::ptree acThresholdsTree;
+    for(const auto& acThresholdPair : _map_ACThreshold)
+    {
+      pt::ptree acThresholdTree;
+      acThresholdTree.put("viewId", acThresholdPair.first);
+      acThresholdTree.put("threshold", acThresholdPair.second);
+      acThresholdsTree.push_back(std::make_pair("", acThresholdTree));
+    }
+    stateTree.add_child("acThresholds", acThresholdsTree);
+  }
+
+  const std::string checkpointFile = _params.checkpointFile;
+
+  _checkpointSaving = std::async(std::launch::async, [scene, stateTree, checkpointFile]()
+  {
+    aliceVision::system::Timer timer;
+    try
+    {
+      // the scene is saved first: an older state only misses the thresholds of the last views
+      if(!sfmDataIO::Save(scene, checkpointFile, sfmDataIO::ESfMData::ALL))
+        return false;
+
+      const std::string stateFile = getCheckpointStateFile(checkpointFile);
+      const std::string tmpStateFile = stateFile + "." + fs::unique_path().string();
+      pt::write_json(tmpStateFile, stateTree);
+      fs::rename(tmpStateFile, stateFile);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING("Checkpoint export failed: " << e.what());
+      return false;
+    }
+    ALICEVISION_LOG_INFO("Checkpoint saved (" << scene.getPoses().size() << " poses) in " << timer.elapsed() << " s: " << checkpointFile);
+    return true;
+  });
+}
+
+void ReconstructionEngine_sequentialSfM::waitCheckpoint()
+{
+  if(_checkpointSaving.valid() && !_checkpointSaving.get())
+    ALICEVISION_LOG_WARNING("Unable to save the checkpoint: " << _params.checkpointFile);
+}
+
 void ReconstructionEngine_sequentialSfM::calibrateRigs(std::set<IndexT>& updatedViews)
 {
   for(const std::pair<IndexT, Rig>& rigPair : _sfmData.getRigs())
@@ -1023,6 +1256,8 @@ bool ReconstructionEngine_sequentialSfM::findNextBestViews(
 
 bool ReconstructionEngine_sequentialSfM::makeInitialPair3D(const Pair& currentPair)
 {
+  ALICEVISION_PROFILE_SCOPE("sequentialSfM::makeInitialPair3D");
+
   // compute robust Essential matrix for ImageId [I,J]
   // use min max to have I < J
   const std::size_t I = std::min(currentPair.first, currentPair.second);
@@ -1081,6 +1316,7 @@ bool ReconstructionEngine_sequentialSfM::makeInitialPair3D(const Pair& currentPa
 
   // c. robust estimation of the relative pose
   RelativePoseInfo relativePoseInfo;
+  relativePoseInfo.nbHistogramBins = _params.nbHistogramBins;
   const std::pair<std::size_t, std::size_t> imageSizeI(camI->w(), camI->h());
   const std::pair<std::size_t, std::size_t> imageSizeJ(camJ->w(), camJ->h());
 
@@ -1278,6 +1514,7 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
     // Robust estimation of the relative pose
     RelativePoseInfo relativePose_info;
     relativePose_info.initial_residual_tolerance = Square(4.0);
+    relativePose_info.nbHistogramBins = _params.nbHistogramBins;
     
     const bool relativePoseSuccess = robustRelativePose(
           camI->K(), camJ->K(),
@@ -1477,19 +1714,34 @@ std::size_t ReconstructionEngine_sequentialSfM::computeCandidateImageScore(Index
 #ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
   return trackIds.size();
 #else
-  std::size_t score = 0;
   // The number of cells of the pyramid grid represent the score
   // and ensure a proper repartition of features in images.
-  const auto& featsPyramid = _map_featsPyramidPerView.at(viewId);
-  for(std::size_t level = 0; level < _params.pyramidDepth; ++level)
+  const track::TrackIdSet& viewTracks = _map_tracksPerView.at(viewId);
+  const std::vector<std::uint32_t>& viewPyramidCodes = _map_featsPyramidPerView.at(viewId);
+
+  // occupied cells of all the levels
+  std::vector<std::uint64_t> cells(_pyramidBitsetOffsets.back(), 0);
+  for(IndexT trackId: trackIds)
   {
-    std::set<std::size_t> featIndexes; // Set of grid cell indexes in the pyramid
-    for(IndexT trackId: trackIds)
+    const auto it = std::lower_bound(viewTracks.begin(), viewTracks.end(), trackId);
+    assert(it != viewTracks.end() && *it == trackId);
+    const std::uint32_t code = viewPyramidCodes[std::distance(viewTracks.begin(), it)];
+
+    for(std::size_t level = 0; level < _params.pyramidDepth; ++level)
     {
-      std::size_t pyramidIndex = featsPyramid.at(trackId * _params.pyramidDepth + level);
-      featIndexes.insert(pyramidIndex);
+      const int nbBits = _pyramidCodeShifts[level + 1] - _pyramidCodeShifts[level];
+      const std::uint32_t cell = (code >> _pyramidCodeShifts[level]) & ((std::uint32_t(1) << nbBits) - 1);
+      cells[_pyramidBitsetOffsets[level] + cell / 64] |= std::uint64_t(1) << (cell % 64);
     }
-    score += featIndexes.size() * _pyramidWeights[level];
+  }
+
+  std::size_t score = 0;
+  for(std::size_t level = 0; level < _params.pyramidDepth; ++level)
+  {
+    std::size_t nbCells = 0;
+    for(std::size_t w = _pyramidBitsetOffsets[level]; w < _pyramidBitsetOffsets[level + 1]; ++w)
+      nbCells += std::bitset<64>(cells[w]).count();
+    score += nbCells * _pyramidWeights[level];
   }
   return score;
 #endif
@@ -1509,6 +1761,8 @@ std::size_t ReconstructionEngine_sequentialSfM::computeCandidateImageScore(Index
  */
 bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewId, ResectionData& resectionData)
 {
+  ALICEVISION_PROFILE_SCOPE("sequentialSfM::computeResection");
+
   using namespace track;
 
   // A. Compute 2D/3D matches
@@ -1575,22 +1829,25 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewId, R
 
   if (!_htmlLogFile.empty())
   {
-    using namespace htmlDocument;
-    std::ostringstream os;
-    os << "Robust resection of view " << viewId << ": <br>";
-    _htmlDocStream->pushInfo(htmlMarkup("h4",os.str()));
+#pragma omp critical(htmlLog)
+    {
+      using namespace htmlDocument;
+      std::ostringstream os;
+      os << "Robust resection of view " << viewId << ": <br>";
+      _htmlDocStream->pushInfo(htmlMarkup("h4",os.str()));
 
-    os.str("");
-    os << std::endl
-      << "- Image path: " << view_I->getImagePath() << "<br>"
-      << "- Threshold (error max): " << resectionData.error_max << "<br>"
-      << "- Resection status: " << (bResection ? "OK" : "FAILED") << "<br>"
-      << "- # points used for Resection: " << resectionData.featuresId.size() << "<br>"
-      << "- # points validated by robust estimation: " << resectionData.vec_inliers.size() << "<br>"
-      << "- % points validated: "
-      << resectionData.vec_inliers.size()/static_cast<float>(resectionData.featuresId.size()) << "<br>";
+      os.str("");
+      os << std::endl
+        << "- Image path: " << view_I->getImagePath() << "<br>"
+        << "- Threshold (error max): " << resectionData.error_max << "<br>"
+        << "- Resection status: " << (bResection ? "OK" : "FAILED") << "<br>"
+        << "- # points used for Resection: " << resectionData.featuresId.size() << "<br>"
+        << "- # points validated by robust estimation: " << resectionData.vec_inliers.size() << "<br>"
+        << "- % points validated: "
+        << resectionData.vec_inliers.size()/static_cast<float>(resectionData.featuresId.size()) << "<br>";
 
-    _htmlDocStream->pushInfo(os.str());
+      _htmlDocStream->pushInfo(os.str());
+    }
   }
   
   if (!bResection)
@@ -1709,42 +1966,41 @@ void ReconstructionEngine_sequentialSfM::getTracksToTriangulate(const std::set<I
                                                                 const std::set<IndexT>& newReconstructedViews, 
                                                                 std::map<IndexT, std::set<IndexT>> & mapTracksToTriangulate) const
 {
-  std::set<IndexT> allReconstructedViews;
-  allReconstructedViews.insert(previousReconstructedViews.begin(), previousReconstructedViews.end());
-  allReconstructedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
-  
-  std::set<IndexT> allTracksInNewViews;
-  track::tracksUtilsMap::getTracksInImagesFast(newReconstructedViews, _map_tracksPerView, allTracksInNewViews);
+  // sorted reconstructed views
+  std::vector<IndexT> allReconstructedViews;
+  allReconstructedViews.reserve(previousReconstructedViews.size() + newReconstructedViews.size());
+  std::set_union(previousReconstructedViews.begin(), previousReconstructedViews.end(),
+                 newReconstructedViews.begin(), newReconstructedViews.end(),
+                 std::back_inserter(allReconstructedViews));
   
-  std::set<IndexT>::iterator it;
-#pragma omp parallel private(it)
+  std::vector<IndexT> allTracksInNewViews;
+  {
+    std::set<IndexT> tracksInNewViews;
+    track::tracksUtilsMap::getTracksInImagesFast(newReconstructedViews, _map_tracksPerView, tracksInNewViews);
+    allTracksInNewViews.assign(tracksInNewViews.begin(), tracksInNewViews.end());
+  }
+
+  // reconstructed views of each track, the track views are sorted
+  std::vector<std::set<IndexT>> allReconstructedViewsSharingTheTracks(allTracksInNewViews.size());
+
+#pragma omp parallel for schedule(dynamic, 256)
+  for(int i = 0; i < allTracksInNewViews.size(); ++i)
   {
-    for (it = allTracksInNewViews.begin(); it != allTracksInNewViews.end(); ++it)
+    const track::Track& track = _map_tracks.at(allTracksInNewViews[i]);
+    std::set<IndexT>& allReconstructedViewsSharingTheTrack = allReconstructedViewsSharingTheTracks[i];
+
+    for(const auto& featView : track.featPerView)
     {
-#pragma omp single nowait
-      {
-        const std::size_t trackId = *it;
-        
-        const track::Track& track = _map_tracks.at(trackId);
-        
-        std::set<IndexT> allViewsSharingTheTrack;
-        std::transform(track.featPerView.begin(), track.featPerView.end(),
-                       std::inserter(allViewsSharingTheTrack, allViewsSharingTheTrack.begin()),
-                       stl::RetrieveKey());
-        
-        std::set<IndexT> allReconstructedViewsSharingTheTrack;
-        std::set_intersection(allViewsSharingTheTrack.begin(), allViewsSharingTheTrack.end(),
-                              allReconstructedViews.begin(), allReconstructedViews.end(),
-                              std::inserter(allReconstructedViewsSharingTheTrack, allReconstructedViewsSharingTheTrack.begin()));
-        
-        if (allReconstructedViewsSharingTheTrack.size() >= _params.minNbObservationsForTriangulation)
-        {
-#pragma omp critical        
-          mapTracksToTriangulate[trackId] = allReconstructedViewsSharingTheTrack;
-        }
-      }
+      if(std::binary_search(allReconstructedViews.begin(), allReconstructedViews.end(), featView.first))
+        allReconstructedViewsSharingTheTrack.insert(allReconstructedViewsSharingTheTrack.end(), featView.first);
     }
   }
+
+  for(std::size_t i = 0; i < allTracksInNewViews.size(); ++i)
+  {
+    if(allReconstructedViewsSharingTheTracks[i].size() >= _params.minNbObservationsForTriangulation)
+      mapTracksToTriangulate.emplace_hint(mapTracksToTriangulate.end(), allTracksInNewViews[i], std::move(allReconstructedViewsSharingTheTracks[i]));
+  }
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate_multiViewsLORANSAC(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
@@ -1761,138 +2017,192 @@ void ReconstructionEngine_sequentialSfM::triangulate_multiViewsLORANSAC(SfMData&
   std::transform(mapTracksToTriangulate.begin(), mapTracksToTriangulate.end(),
                  std::inserter(setTracksId, setTracksId.begin()),
                  stl::RetrieveKey());
-                   
-#pragma omp parallel for 
-  for (int i = 0; i < setTracksId.size(); i++) // each track (already reconstructed or not)
-  {
-    const IndexT trackId = setTracksId.at(i);
-    bool isValidTrack = true;
-    const track::Track& track = _map_tracks.at(trackId);
-    std::set<IndexT>& observations = mapTracksToTriangulate.at(trackId); // all the posed views possessing the track
+
+  // new triangulation state of each track
+  std::vector<TrackTriangulationState> tracksState(setTracksId.size());
+  std::vector<char> isUpdatedTrackState(setTracksId.size(), false);
+  std::size_t nbSkippedTracks = 0;
+
+  // the scene is only read during the triangulation,
+  // the triangulated landmarks are buffered per thread and merged at the end
+#pragma omp parallel
+  {
+    std::vector<std::pair<IndexT, Landmark>> threadLandmarks;
+    std::vector<IndexT> threadRemovedLandmarks;
+    std::size_t threadNbSkippedTracks = 0;
+
+#pragma omp for schedule(dynamic)
+    for (int i = 0; i < setTracksId.size(); i++) // each track (already reconstructed or not)
+    {
+      const IndexT trackId = setTracksId.at(i);
+      bool isValidTrack = true;
+      const track::Track& track = _map_tracks.at(trackId);
+      std::set<IndexT>& observations = mapTracksToTriangulate.at(trackId); // all the posed views possessing the track
     
-    // The track needs to be seen by a min. number of views to be triangulated
-    if (observations.size() < _params.minNbObservationsForTriangulation)
-      continue;
+      // The track needs to be seen by a min. number of views to be triangulated
+      if (observations.size() < _params.minNbObservationsForTriangulation)
+        continue;
+
+      // A valid landmark that only gained one view since its last triangulation doesn't need to be triangulated again,
+      // as long as the resection of this view validated the observation.
+      {
+        const auto stateIt = _tracksTriangulationState.find(trackId);
+        const auto landmarkIt = scene.structure.find(trackId);
+
+        if(stateIt != _tracksTriangulationState.end() && stateIt->second.nbInliers > 0 && landmarkIt != scene.structure.end())
+        {
+          const std::vector<IndexT>& lastViews = stateIt->second.views;
+          std::vector<IndexT> newViews;
+          std::set_difference(observations.begin(), observations.end(),
+                              lastViews.begin(), lastViews.end(),
+                              std::back_inserter(newViews));
+
+          if(newViews.size() == 1 && landmarkIt->second.observations.count(newViews.front()))
+          {
+            tracksState[i].views.assign(observations.begin(), observations.end());
+            tracksState[i].nbInliers = stateIt->second.nbInliers + 1;
+            isUpdatedTrackState[i] = true;
+            ++threadNbSkippedTracks;
+            continue;
+          }
+        }
+      }
     
-    Vec3 X_euclidean = Vec3::Zero();
-    std::set<IndexT> inliers;
+      Vec3 X_euclidean = Vec3::Zero();
+      std::set<IndexT> inliers;
     
-    if (observations.size() == 2) 
-    {
-      /* --------------------------------------------
-       *    2 observations : triangulation using DLT
-       * -------------------------------------------- */ 
+      if (observations.size() == 2) 
+      {
+        /* --------------------------------------------
+         *    2 observations : triangulation using DLT
+         * -------------------------------------------- */ 
        
-      inliers = observations;
+        inliers = observations;
       
-      // -- Prepare:
-      IndexT I =  *(observations.begin());
-      IndexT J =  *(observations.rbegin());
-      const View* viewI = scene.getViews().at(I).get();
-      const View* viewJ = scene.getViews().at(J).get();
-      const IntrinsicBase* camI = scene.getIntrinsics().at(viewI->getIntrinsicId()).get();
-      const IntrinsicBase* camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId()).get();
-      const Pose3 poseI = scene.getPose(*viewI).getTransform();
-      const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
-      const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
-      const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
+        // -- Prepare:
+        IndexT I =  *(observations.begin());
+        IndexT J =  *(observations.rbegin());
+        const View* viewI = scene.getViews().at(I).get();
+        const View* viewJ = scene.getViews().at(J).get();
+        const IntrinsicBase* camI = scene.getIntrinsics().at(viewI->getIntrinsicId()).get();
+        const IntrinsicBase* camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId()).get();
+        const Pose3 poseI = scene.getPose(*viewI).getTransform();
+        const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
+        const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
+        const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
   
-      // -- Triangulate:
-      TriangulateDLT(camI->get_projective_equivalent(poseI), 
-                     camI->get_ud_pixel(xI), 
-                     camJ->get_projective_equivalent(poseJ), 
-                     camI->get_ud_pixel(xJ), 
-                     &X_euclidean);
+        // -- Triangulate:
+        TriangulateDLT(camI->get_projective_equivalent(poseI), 
+                       camI->get_ud_pixel(xI), 
+                       camJ->get_projective_equivalent(poseJ), 
+                       camI->get_ud_pixel(xJ), 
+                       &X_euclidean);
       
-      // -- Check:
-      //  - angle (small angle leads imprecise triangulation)
-      //  - positive depth
-      //  - residual values
-      // TODO assert(acThresholdIt != _map_ACThreshold.end());
-      const auto& acThresholdItI = _map_ACThreshold.find(I);
-      const auto& acThresholdItJ = _map_ACThreshold.find(J);
-      const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
-      const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
+        // -- Check:
+        //  - angle (small angle leads imprecise triangulation)
+        //  - positive depth
+        //  - residual values
+        // TODO assert(acThresholdIt != _map_ACThreshold.end());
+        const auto& acThresholdItI = _map_ACThreshold.find(I);
+        const auto& acThresholdItJ = _map_ACThreshold.find(J);
+        const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
+        const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
       
-      if (AngleBetweenRays(poseI, camI, poseJ, camJ, xI, xJ) < _params.minAngleForTriangulation ||
-          poseI.depth(X_euclidean) < 0 || 
-          poseJ.depth(X_euclidean) < 0 || 
-          camI->residual(poseI, X_euclidean, xI).norm() > acThresholdI || 
-          camJ->residual(poseJ, X_euclidean, xJ).norm() > acThresholdJ)
-        isValidTrack = false;
-    }
-    else 
-    {
-      /* -------------------------------------------------------
-       *    N obsevations (N>2) : triangulation using LORANSAC 
-       * ------------------------------------------------------- */ 
-     
-      // -- Prepare:
-      Mat2X features(2, observations.size()); // undistorted 2D features (one per pose)
-      std::vector<Mat34> Ps; // projective matrices (one per pose)
+        if (AngleBetweenRays(poseI, camI, poseJ, camJ, xI, xJ) < _params.minAngleForTriangulation ||
+            poseI.depth(X_euclidean) < 0 || 
+            poseJ.depth(X_euclidean) < 0 || 
+            camI->residual(poseI, X_euclidean, xI).norm() > acThresholdI || 
+            camJ->residual(poseJ, X_euclidean, xJ).norm() > acThresholdJ)
+          isValidTrack = false;
+      }
+      else 
       {
-        const track::Track& track = _map_tracks.at(trackId);
-        
-        int i = 0;
-        for (const IndexT& viewId : observations)
+        /* -------------------------------------------------------
+         *    N obsevations (N>2) : triangulation using LORANSAC 
+         * ------------------------------------------------------- */ 
+     
+        // -- Prepare:
+        Mat2X features(2, observations.size()); // undistorted 2D features (one per pose)
+        std::vector<Mat34> Ps; // projective matrices (one per pose)
         {
-          const View* view = scene.getViews().at(viewId).get();
-          const IntrinsicBase* cam = scene.getIntrinsics().at(view->getIntrinsicId()).get();
-          const Vec2 x_ud = cam->get_ud_pixel(_featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>()); // undistorted 2D point
-          features(0,i) = x_ud(0); 
-          features(1,i) = x_ud(1);  
-          Ps.push_back(cam->get_projective_equivalent(scene.getPose(*view).getTransform()));
-          i++;
+          const track::Track& track = _map_tracks.at(trackId);
+        
+          int i = 0;
+          for (const IndexT& viewId : observations)
+          {
+            const View* view = scene.getViews().at(viewId).get();
+            const IntrinsicBase* cam = scene.getIntrinsics().at(view->getIntrinsicId()).get();
+            const Vec2 x_ud = cam->get_ud_pixel(_featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>()); // undistorted 2D point
+            features(0,i) = x_ud(0); 
+            features(1,i) = x_ud(1);  
+            Ps.push_back(cam->get_projective_equivalent(scene.getPose(*view).getTransform()));
+            i++;
+          }
         }
-      }
       
-      // -- Triangulate: 
-      Vec4 X_homogeneous = Vec4::Zero();
-      std::vector<std::size_t> inliersIndex;
+        // -- Triangulate: 
+        Vec4 X_homogeneous = Vec4::Zero();
+        std::vector<std::size_t> inliersIndex;
       
-      TriangulateNViewLORANSAC(features, Ps, &X_homogeneous, &inliersIndex, 8.0);
+        TriangulateNViewLORANSAC(features, Ps, &X_homogeneous, &inliersIndex, 8.0);
       
-      HomogeneousToEuclidean(X_homogeneous, &X_euclidean);     
+        HomogeneousToEuclidean(X_homogeneous, &X_euclidean);     
       
-      // observations = {350, 380, 442} | inliersIndex = [0, 1] | inliers = {350, 380}
-      for (const auto & id : inliersIndex)
-        inliers.insert(*std::next(observations.begin(), id));
-
-      // -- Check:
-      //  - nb of cameras validing the track 
-      //  - angle (small angle leads imprecise triangulation)
-      //  - positive depth (chierality)
-      if (inliers.size() < _params.minNbObservationsForTriangulation ||
-          !checkAngles(X_euclidean, inliers, scene, _params.minAngleForTriangulation) ||
-          !checkChieralities(X_euclidean, inliers, scene))
-        isValidTrack = false;
-    }  
-
-    // -- Add the tringulated point to the scene
-    if (isValidTrack)
-    {
-      Landmark landmark;
-      landmark.X = X_euclidean;
-      landmark.descType = track.descType;
-      for (const IndexT & viewId : inliers) // add inliers as observations
+        // observations = {350, 380, 442} | inliersIndex = [0, 1] | inliers = {350, 380}
+        for (const auto & id : inliersIndex)
+          inliers.insert(*std::next(observations.begin(), id));
+
+        // -- Check:
+        //  - nb of cameras validing the track 
+        //  - angle (small angle leads imprecise triangulation)
+        //  - positive depth (chierality)
+        if (inliers.size() < _params.minNbObservationsForTriangulation ||
+            !checkAngles(X_euclidean, inliers, scene, _params.minAngleForTriangulation) ||
+            !checkChieralities(X_euclidean, inliers, scene))
+          isValidTrack = false;
+      }  
+
+      // -- Add the tringulated point to the scene
+      if (isValidTrack)
       {
-        const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
-        landmark.observations[viewId] = Observation(x, track.featPerView.at(viewId));
+        Landmark landmark;
+        landmark.X = X_euclidean;
+        landmark.descType = track.descType;
+        for (const IndexT & viewId : inliers) // add inliers as observations
+        {
+          const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
+          landmark.observations[viewId] = Observation(x, track.featPerView.at(viewId));
+        }
+        threadLandmarks.emplace_back(trackId, std::move(landmark));
       }
-#pragma omp critical
-      {
-        scene.structure[trackId] = landmark;
-      }      
-    }
-    else
-    {
-#pragma omp critical
+      else
       {
-        if (scene.structure.find(trackId) != scene.structure.end()) 
-          scene.structure.erase(trackId);
+        threadRemovedLandmarks.push_back(trackId);
       }
+
+      tracksState[i].views.assign(observations.begin(), observations.end());
+      tracksState[i].nbInliers = isValidTrack ? inliers.size() : 0;
+      isUpdatedTrackState[i] = true;
+    } // for all shared tracks 
+
+#pragma omp critical
+    {
+      for(auto& landmark : threadLandmarks)
+        scene.structure[landmark.first] = std::move(landmark.second);
+      for(const IndexT trackId : threadRemovedLandmarks)
+        scene.structure.erase(trackId);
+      nbSkippedTracks += threadNbSkippedTracks;
     }
-  } // for all shared tracks 
+  } // omp parallel
+
+  for(std::size_t i = 0; i < setTracksId.size(); ++i)
+  {
+    if(isUpdatedTrackState[i])
+      _tracksTriangulationState[setTracksId[i]] = std::move(tracksState[i]);
+  }
+
+  ALICEVISION_LOG_DEBUG("Triangulation of " << setTracksId.size() - nbSkippedTracks << " tracks, "
+                        << nbSkippedTracks << " landmarks kept with their new observation.");
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
@@ -2055,12 +2365,14 @@ void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, cons
 
 std::size_t ReconstructionEngine_sequentialSfM::removeOutliers(double precision)
 {
-  const std::size_t nbOutliersResidualErr = RemoveOutliers_PixelResidualError(_sfmData, precision, 2);
+  double inliersRMSE = 0.0;
+  const std::size_t nbOutliersResidualErr = RemoveOutliers_PixelResidualError(_sfmData, precision, 2, &inliersRMSE);
   const std::size_t nbOutliersAngleErr = RemoveOutliers_AngleError(_sfmData, _params.minAngleForLandmark);
 
   ALICEVISION_LOG_INFO("Remove outliers: " << std::endl
                         << "\t- # outliers residual error: " << nbOutliersResidualErr << std::endl
-                        << "\t- # outliers angular error: " << nbOutliersAngleErr);
+                        << "\t- # outliers angular error: " << nbOutliersAngleErr << std::endl
+                        << "\t- inliers RMSE: " << inliersRMSE);
 
   return nbOutliersResidualErr + nbOutliersAngleErr;
 }
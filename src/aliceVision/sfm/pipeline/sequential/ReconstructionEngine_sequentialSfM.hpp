@@ -20,12 +20,16 @@
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <future>
+
 namespace fs = boost::filesystem;
 namespace pt = boost::property_tree;
 
 namespace aliceVision {
 namespace sfm {
 
+class BundleAdjustmentCeres;
+
 /// Image score contains <ImageId, NbPutativeCommonPoint, score, isIntrinsicsReconstructed>
 typedef std::tuple<IndexT, std::size_t, std::size_t, bool> ViewConnectionScore;
 
@@ -41,7 +45,7 @@ public:
     int minInputTrackLength = 2;
     int minTrackLength = 2;
     int minPointsPerPose = 30;
-    bool useLocalBundleAdjustment = false;
+    bool useLocalBundleAdjustment = true;
     int localBundelAdjustementGraphDistanceLimit = 1;
 
     bool useRigConstraint = true;
@@ -49,6 +53,12 @@ public:
     /// Has fixed Intrinsics
     bool lockAllIntrinsics = false;
 
+    /// bundle adjustment of the large scenes with a subset of the landmarks:
+    /// max number of landmarks per view used to refine the cameras (0: all the landmarks)
+    std::size_t baLandmarksSubsamplingMaxPerView = 0;
+    /// min number of observations in the scene to use the landmarks subsampling
+    std::size_t baLandmarksSubsamplingMinObservations = 1000000;
+
     /// minimum number of obersvations to triangulate a 3d point.
     std::size_t minNbObservationsForTriangulation = 2;
     /// a 3D point must have at least 2 obervations not too much aligned.
@@ -58,9 +68,13 @@ public:
     float minAngleInitialPair = 5.0f;
     float maxAngleInitialPair = 40.0f;
     bool useTrackFiltering = true;
+    /// binary tracks file, reused instead of building the tracks if it matches the input matches and filtering (empty to disable)
+    std::string tracksCacheFile;
     robustEstimation::ERobustEstimator localizerEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
     double localizerEstimatorError = std::numeric_limits<double>::infinity();
     size_t localizerEstimatorMaxIterations = 4096;
+    /// number of bins of the residual histogram of the ACRANSAC NFA in the resection and relative pose estimations (0 to sort the residuals)
+    std::size_t nbHistogramBins = 0;
 
     // Pyramid scoring
 
@@ -83,6 +97,14 @@ public:
       sfmDataIO::STRUCTURE |
       sfmDataIO::OBSERVATIONS |
       sfmDataIO::CONTROL_POINTS);
+
+    // Checkpoints
+    /// SfMData file of the checkpoints, saved periodically during the resections (empty to disable)
+    std::string checkpointFile;
+    /// minimum time (in seconds) between two checkpoints
+    double checkpointInterval = 600.0;
+    /// continue the reconstruction from the checkpoint file, if it exists
+    bool resumeFromCheckpoint = false;
   };
 
 public:
@@ -145,6 +167,7 @@ public:
 
   /**
    * @brief Update the reconstruction with a new resection group of images
+   * @note The views are resected in parallel and the scene is updated in the order of bestViewIds
    * @param[in] resectionId The resection id
    * @param[in] bestViewIds The best remaining view ids
    * @param[in] prevReconstructedViews The previously reconstructed view ids
@@ -178,6 +201,25 @@ public:
    */
   void exportStatistics(double reconstructionTime);
 
+  /**
+   * @brief Replace the scene by the one of the checkpoint file and restore the engine state.
+   * The camera poses locked in the input scene stay locked.
+   * @return true if a checkpoint has been loaded
+   */
+  bool loadCheckpoint();
+
+  /**
+   * @brief Save a checkpoint of the scene and of the engine state in a background thread.
+   * The scene is copied, so the reconstruction continues during the export.
+   * The previous checkpoint is finished first: only one checkpoint is saved at a time.
+   */
+  void saveCheckpoint();
+
+  /**
+   * @brief Wait for the end of the checkpoint being saved, if any.
+   */
+  void waitCheckpoint();
+
 
   /**
    * @brief calibrateRigs
@@ -226,6 +268,14 @@ private:
     bool isNewIntrinsic;
   };
 
+  struct TrackTriangulationState
+  {
+    /// reconstructed views of the track at its last triangulation (sorted)
+    std::vector<IndexT> views;
+    /// number of views validating the triangulated point (0 if the triangulation failed)
+    std::size_t nbInliers = 0;
+  };
+
   /**
    * @brief Compute the initial 3D seed (First camera t=0; R=Id, second estimated by 5 point algorithm)
    * @param[in] initialPair
@@ -372,6 +422,10 @@ private:
   /// internal cache of precomputed values for the weighting of the pyramid levels
   std::vector<int> _pyramidWeights;
   int _pyramidThreshold;
+  /// first bit of each level in the pyramid codes of the features, with a final entry for the total
+  std::vector<int> _pyramidCodeShifts;
+  /// first word of each level in the bitset of the occupied cells, with a final entry for the total
+  std::vector<std::size_t> _pyramidBitsetOffsets;
 
   // Temporary data
 
@@ -379,16 +433,25 @@ private:
   track::TracksMap _map_tracks;
   /// Putative tracks per view
   track::TracksPerView _map_tracksPerView;
-  /// Precomputed pyramid index for each trackId of each viewId.
+  /// Precomputed pyramid code for each track of each viewId, in the order of _map_tracksPerView.
   track::TracksPyramidPerView _map_featsPyramidPerView;
+  /// Triangulation state of each track, to only triangulate again the tracks affected by the new views
+  HashMap<IndexT, TrackTriangulationState> _tracksTriangulationState;
   /// Per camera confidence (A contrario estimated threshold error)
   HashMap<IndexT, double> _map_ACThreshold;
+  /// Bundle adjustment, its Ceres problem is kept between the adjustments
+  std::shared_ptr<BundleAdjustmentCeres> _bundleAdjustment;
 
   // Local Bundle Adjustment data
 
   /// Contains all the data used by the Local BA approach
   std::shared_ptr<LocalBundleAdjustmentGraph> _localStrategyGraph;
 
+  // Checkpoints
+
+  /// checkpoint being saved in the background
+  std::future<bool> _checkpointSaving;
+
   // Log
 
   /// sfm intermediate reconstruction files
@@ -193,3 +193,67 @@ BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Known_Rig)
   BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), nbPoints);
 }
 
+
+// Test a reconstruction resumed from its checkpoint
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Checkpoint_Resume)
+{
+  const int nviews = 8;
+  const int npoints = 128;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  const SfMData sfmData = getInputScene(d, config, PINHOLE_CAMERA);
+
+  // Remove poses and structure
+  SfMData sfmData2 = sfmData;
+  sfmData2.getPoses().clear();
+  sfmData2.structure.clear();
+
+  // Add a tiny noise in 2D observations to make data more realistic
+  std::normal_distribution<double> distribution(0.0,0.5);
+
+  // Configure the featuresPerView & the matches_provider from the synthetic dataset
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, distribution);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  ReconstructionEngine_sequentialSfM::Params sfmParams;
+  sfmParams.userInitialImagePair = Pair(0, 1);
+  sfmParams.lockAllIntrinsics = true;
+  sfmParams.checkpointFile = "./sequentialSfM_checkpoint.sfm";
+  sfmParams.checkpointInterval = 0.0; // checkpoint after each resection
+
+  fs::remove(sfmParams.checkpointFile);
+
+  {
+    ReconstructionEngine_sequentialSfM sfmEngine(sfmData2, sfmParams, "./");
+    sfmEngine.setFeatures(&featuresPerView);
+    sfmEngine.setMatches(&pairwiseMatches);
+    BOOST_CHECK(sfmEngine.process());
+  }
+
+  SfMData checkpoint;
+  BOOST_CHECK(sfmDataIO::Load(checkpoint, sfmParams.checkpointFile, sfmDataIO::ESfMData::ALL));
+  BOOST_CHECK_GT(checkpoint.getPoses().size(), 2);
+  BOOST_CHECK(fs::exists(sfmParams.checkpointFile + ".state.json"));
+
+  // resume from the last checkpoint
+  sfmParams.resumeFromCheckpoint = true;
+
+  ReconstructionEngine_sequentialSfM sfmEngine(sfmData2, sfmParams, "./");
+  sfmEngine.setFeatures(&featuresPerView);
+  sfmEngine.setMatches(&pairwiseMatches);
+  BOOST_CHECK(sfmEngine.process());
+
+  const double residual = RMSE(sfmEngine.getSfMData());
+  ALICEVISION_LOG_DEBUG("RMSE residual: " << residual);
+  BOOST_CHECK_LT(residual, 0.5);
+  BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getPoses().size(), nviews);
+  BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), npoints);
+
+  fs::remove(sfmParams.checkpointFile);
+  fs::remove(sfmParams.checkpointFile + ".state.json");
+}
@@ -15,6 +15,7 @@
 #include <aliceVision/track/Track.hpp>
 #include <aliceVision/sfm/sfmTriangulation.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
@@ -79,10 +80,13 @@ void StructureEstimationFromKnownPoses::match(
   boost::progress_display my_progress_bar( pairs.size(), std::cout,
     "Compute pairwise fundamental guided matching:\n" );
 
-  #pragma omp parallel
-  for (PairSet::const_iterator it = pairs.begin(); it != pairs.end(); ++it)
+  const std::vector<Pair> pairsVec(pairs.begin(), pairs.end());
+  std::vector<matching::MatchesPerDescType> matchesPerPair(pairsVec.size());
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < pairsVec.size(); ++i)
   {
-    #pragma omp single nowait
+    const Pair* it = &pairsVec[i];
     {
     // --
     // Perform GUIDED MATCHING
@@ -97,8 +101,8 @@ void StructureEstimationFromKnownPoses::match(
     const Pose3 poseR = sfmData.getPose(*viewR).getTransform();
     const Intrinsics::const_iterator iterIntrinsicR = sfmData.getIntrinsics().find(viewR->getIntrinsicId());
 
-    if (sfmData.getIntrinsics().count(viewL->getIntrinsicId()) != 0 ||
-        sfmData.getIntrinsics().count(viewR->getIntrinsicId()) != 0)
+    if (iterIntrinsicL != sfmData.getIntrinsics().end() &&
+        iterIntrinsicR != sfmData.getIntrinsics().end())
     {
       const Mat34 P_L = iterIntrinsicL->second.get()->get_projective_equivalent(poseL);
       const Mat34 P_R = iterIntrinsicR->second.get()->get_projective_equivalent(poseR);
@@ -146,14 +150,21 @@ void StructureEstimationFromKnownPoses::match(
          allImagePairMatches[descType] = matches;
       }
 
-      #pragma omp critical
-      {
-        ++my_progress_bar;
-        _putativeMatches[*it] = allImagePairMatches;
-      }
+      matchesPerPair[i] = std::move(allImagePairMatches);
+    }
+
+    #pragma omp critical
+    {
+      ++my_progress_bar;
     }
     }
   }
+
+  for(std::size_t i = 0; i < pairsVec.size(); ++i)
+  {
+    if(!matchesPerPair[i].empty())
+      _putativeMatches[pairsVec[i]] = std::move(matchesPerPair[i]);
+  }
 }
 
 /// Filter inconsistent correspondences by using 3-view correspondences on view triplets
@@ -171,10 +182,15 @@ void StructureEstimationFromKnownPoses::filter(
 
   boost::progress_display my_progress_bar( triplets.size(), std::cout,
     "Per triplet tracks validation (discard spurious correspondences):\n" );
-  #pragma omp parallel
-  for( Triplets::const_iterator it = triplets.begin(); it != triplets.end(); ++it)
+
+  // validated correspondences per thread, merged at the end
+  std::vector<matching::PairwiseMatches> tripletMatchesPerThread(omp_get_max_threads());
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int t = 0; t < triplets.size(); ++t)
   {
-    #pragma omp single nowait
+    const Triplets::const_iterator it = triplets.begin() + t;
+    matching::PairwiseMatches& tripletMatches = tripletMatchesPerThread.at(omp_get_thread_num());
     {
       #pragma omp critical
       {++my_progress_bar;}
@@ -221,17 +237,14 @@ void StructureEstimationFromKnownPoses::filter(
             if (trianObj.minDepth() > 0 && trianObj.error()/(double)trianObj.size() < 4.0)
             // TODO: Add an angular check ?
             {
-              #pragma omp critical
-              {
-                track::Track::FeatureIdPerView::const_iterator iterI, iterJ, iterK;
-                iterI = iterJ = iterK = subTrack.featPerView.begin();
-                std::advance(iterJ,1);
-                std::advance(iterK,2);
-
-                _tripletMatches[std::make_pair(I,J)][subTrack.descType].emplace_back(iterI->second, iterJ->second);
-                _tripletMatches[std::make_pair(J,K)][subTrack.descType].emplace_back(iterJ->second, iterK->second);
-                _tripletMatches[std::make_pair(I,K)][subTrack.descType].emplace_back(iterI->second, iterK->second);
-              }
+              track::Track::FeatureIdPerView::const_iterator iterI, iterJ, iterK;
+              iterI = iterJ = iterK = subTrack.featPerView.begin();
+              std::advance(iterJ,1);
+              std::advance(iterK,2);
+
+              tripletMatches[std::make_pair(I,J)][subTrack.descType].emplace_back(iterI->second, iterJ->second);
+              tripletMatches[std::make_pair(J,K)][subTrack.descType].emplace_back(iterJ->second, iterK->second);
+              tripletMatches[std::make_pair(I,K)][subTrack.descType].emplace_back(iterI->second, iterK->second);
             }
           }
         }
@@ -240,6 +253,19 @@ void StructureEstimationFromKnownPoses::filter(
   }
   // Clear putatives matches since they are no longer required
   matching::PairwiseMatches().swap(_putativeMatches);
+
+  for(matching::PairwiseMatches& tripletMatches : tripletMatchesPerThread)
+  {
+    for(auto& pairMatches : tripletMatches)
+    {
+      for(auto& descMatches : pairMatches.second)
+      {
+        std::vector<matching::IndMatch>& matches = _tripletMatches[pairMatches.first][descMatches.first];
+        matches.insert(matches.end(), descMatches.second.begin(), descMatches.second.end());
+      }
+    }
+    matching::PairwiseMatches().swap(tripletMatches);
+  }
 }
 
 /// Init & triangulate landmark observations from validated 3-view correspondences
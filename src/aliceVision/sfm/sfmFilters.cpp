@@ -9,85 +9,196 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/stl/stl.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/ParallelReduce.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iterator>
 
 namespace aliceVision {
 namespace sfm {
 
+namespace {
+
+/// Pose and intrinsic of a reconstructed view
+struct ViewGeometry
+{
+  geometry::Pose3 pose;
+  const camera::IntrinsicBase* intrinsic;
+};
+
+/**
+ * @brief Get the pose and the intrinsic of the reconstructed views, composed once for the rigs.
+ * @param[in] sfmData The scene
+ * @return The pose and the intrinsic of each reconstructed view
+ */
+HashMap<IndexT, ViewGeometry> getViewsGeometry(const sfmData::SfMData& sfmData)
+{
+  HashMap<IndexT, ViewGeometry> viewsGeometry;
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    const sfmData::View& view = *viewPair.second;
+    if(sfmData.isPoseAndIntrinsicDefined(&view))
+      viewsGeometry[viewPair.first] = {sfmData.getPose(view).getTransform(), sfmData.getIntrinsicPtr(view.getIntrinsicId())};
+  }
+  return viewsGeometry;
+}
+
+/**
+ * @brief List the landmarks, to process the landmark hash map with an index.
+ * @param[in] sfmData The scene
+ * @return The landmark of each index
+ */
+std::vector<sfmData::Landmarks::iterator> getLandmarksIterators(sfmData::SfMData& sfmData)
+{
+  std::vector<sfmData::Landmarks::iterator> landmarks;
+  landmarks.reserve(sfmData.structure.size());
+  for(auto it = sfmData.structure.begin(); it != sfmData.structure.end(); ++it)
+    landmarks.push_back(it);
+  return landmarks;
+}
+
+/**
+ * @brief Erase the flagged landmarks in one pass.
+ * @param[in] landmarks The landmark of each index
+ * @param[in] removeLandmark The removal flag of each landmark index
+ * @param[in,out] sfmData The scene
+ */
+void eraseLandmarks(const std::vector<sfmData::Landmarks::iterator>& landmarks,
+                    const std::vector<char>& removeLandmark,
+                    sfmData::SfMData& sfmData)
+{
+  for(std::size_t i = 0; i < landmarks.size(); ++i)
+  {
+    if(removeLandmark[i])
+      sfmData.structure.erase(landmarks[i]);
+  }
+}
+
+} // namespace
+
 IndexT RemoveOutliers_PixelResidualError(sfmData::SfMData& sfmData,
                                          const double dThresholdPixel,
-                                         const unsigned int minTrackLength)
+                                         const unsigned int minTrackLength,
+                                         double* outInliersRMSE)
 {
-  IndexT outlier_count = 0;
-  sfmData::Landmarks::iterator iterTracks = sfmData.structure.begin();
+  const HashMap<IndexT, ViewGeometry> viewsGeometry = getViewsGeometry(sfmData);
+  const std::vector<sfmData::Landmarks::iterator> landmarks = getLandmarksIterators(sfmData);
+
+  // the residuals are evaluated in parallel, each landmark compacts its own observations,
+  // the landmarks are erased in a single pass
+  std::vector<char> removeLandmark(landmarks.size(), 0);
 
-  while(iterTracks != sfmData.structure.end())
+  // the residuals are summed with a fixed partition, the RMSE does not depend on the number of threads
+  struct Counts
   {
-    sfmData::Observations & observations = iterTracks->second.observations;
-    sfmData::Observations::iterator itObs = observations.begin();
+    std::size_t outlierCount = 0;
+    std::size_t inlierCount = 0;
+    double inliersSquaredResidual = 0.0;
+  };
+
+  const Counts counts = system::parallelReduce(std::size_t(0), landmarks.size(), Counts(), [&](Counts& sum, std::size_t i)
+  {
+    sfmData::Landmark& landmark = landmarks[i]->second;
+    sfmData::Observations& observations = landmark.observations;
+    double landmarkSquaredResidual = 0.0;
 
-    while(itObs != observations.end())
+    const auto newEnd = std::remove_if(observations.begin(), observations.end(), [&](const sfmData::Observations::value_type& observation)
     {
-      const sfmData::View * view = sfmData.views.at(itObs->first).get();
-      const geometry::Pose3 pose = sfmData.getPose(*view).getTransform();
-      const camera::IntrinsicBase * intrinsic = sfmData.intrinsics.at(view->getIntrinsicId()).get();
-      const Vec2 residual = intrinsic->residual(pose, iterTracks->second.X, itObs->second.x);
+      // an observation of a view without pose or intrinsic has no residual
+      const auto viewGeometryIt = viewsGeometry.find(observation.first);
+      if(viewGeometryIt == viewsGeometry.end())
+        return true;
 
-      if((pose.depth(iterTracks->second.X) < 0) || (residual.norm() > dThresholdPixel))
-      {
-        ++outlier_count;
-        itObs = observations.erase(itObs);
-      }
-      else
-        ++itObs;
-    }
+      const ViewGeometry& viewGeometry = viewGeometryIt->second;
+      const double squaredResidual = viewGeometry.intrinsic->residual(viewGeometry.pose, landmark.X, observation.second.x).squaredNorm();
+
+      if((viewGeometry.pose.depth(landmark.X) < 0) || (squaredResidual > dThresholdPixel * dThresholdPixel))
+        return true;
+
+      landmarkSquaredResidual += squaredResidual;
+      return false;
+    });
 
-    if (observations.empty() || observations.size() < minTrackLength)
-      iterTracks = sfmData.structure.erase(iterTracks);
+    const std::size_t nbOutliers = std::distance(newEnd, observations.end());
+    observations.erase(newEnd, observations.end());
+
+    sum.outlierCount += nbOutliers;
+
+    if(observations.empty() || observations.size() < minTrackLength)
+    {
+      removeLandmark[i] = 1;
+    }
     else
-      ++iterTracks;
-  }
-  return outlier_count;
+    {
+      sum.inlierCount += observations.size();
+      sum.inliersSquaredResidual += landmarkSquaredResidual;
+    }
+  },
+  [](const Counts& left, const Counts& right)
+  {
+    Counts sum;
+    sum.outlierCount = left.outlierCount + right.outlierCount;
+    sum.inlierCount = left.inlierCount + right.inlierCount;
+    sum.inliersSquaredResidual = left.inliersSquaredResidual + right.inliersSquaredResidual;
+    return sum;
+  }, 256);
+
+  eraseLandmarks(landmarks, removeLandmark, sfmData);
+
+  if(outInliersRMSE != nullptr)
+    *outInliersRMSE = (counts.inlierCount > 0) ? std::sqrt(counts.inliersSquaredResidual / (2.0 * counts.inlierCount)) : 0.0;
+
+  return static_cast<IndexT>(counts.outlierCount);
 }
 
 IndexT RemoveOutliers_AngleError(sfmData::SfMData& sfmData, const double dMinAcceptedAngle)
 {
-  IndexT removedTrack_count = 0;
-  sfmData::Landmarks::iterator iterTracks = sfmData.structure.begin();
+  const HashMap<IndexT, ViewGeometry> viewsGeometry = getViewsGeometry(sfmData);
+  const std::vector<sfmData::Landmarks::iterator> landmarks = getLandmarksIterators(sfmData);
+
+  std::vector<char> removeLandmark(landmarks.size(), 0);
+  std::size_t removedTrackCount = 0;
 
-  while(iterTracks != sfmData.structure.end())
+  #pragma omp parallel for schedule(dynamic, 256) reduction(+:removedTrackCount)
+  for(int i = 0; i < static_cast<int>(landmarks.size()); ++i)
   {
-    sfmData::Observations & observations = iterTracks->second.observations;
-    double max_angle = 0.0;
-    for(sfmData::Observations::const_iterator itObs1 = observations.begin(); itObs1 != observations.end(); ++itObs1)
+    const sfmData::Observations& observations = landmarks[i]->second.observations;
+
+    // only the existence of a pair of rays with a large enough angle matters
+    bool validAngle = false;
+    for(sfmData::Observations::const_iterator itObs1 = observations.begin(); itObs1 != observations.end() && !validAngle; ++itObs1)
     {
-      const sfmData::View * view1 = sfmData.views.at(itObs1->first).get();
-      const geometry::Pose3 pose1 = sfmData.getPose(*view1).getTransform();
-      const camera::IntrinsicBase * intrinsic1 = sfmData.intrinsics.at(view1->getIntrinsicId()).get();
+      const auto viewGeometryIt1 = viewsGeometry.find(itObs1->first);
+      if(viewGeometryIt1 == viewsGeometry.end())
+        continue;
+      const ViewGeometry& viewGeometry1 = viewGeometryIt1->second;
 
       sfmData::Observations::const_iterator itObs2 = itObs1;
       ++itObs2;
 
-      for(; itObs2 != observations.end(); ++itObs2)
+      for(; itObs2 != observations.end() && !validAngle; ++itObs2)
       {
-        const sfmData::View * view2 = sfmData.views.at(itObs2->first).get();
-        const geometry::Pose3 pose2 = sfmData.getPose(*view2).getTransform();
-        const camera::IntrinsicBase * intrinsic2 = sfmData.intrinsics.at(view2->getIntrinsicId()).get();
+        const auto viewGeometryIt2 = viewsGeometry.find(itObs2->first);
+        if(viewGeometryIt2 == viewsGeometry.end())
+          continue;
+        const ViewGeometry& viewGeometry2 = viewGeometryIt2->second;
 
-        const double angle = AngleBetweenRays(pose1, intrinsic1, pose2, intrinsic2, itObs1->second.x, itObs2->second.x);
-        max_angle = std::max(angle, max_angle);
+        const double angle = AngleBetweenRays(viewGeometry1.pose, viewGeometry1.intrinsic, viewGeometry2.pose, viewGeometry2.intrinsic, itObs1->second.x, itObs2->second.x);
+        validAngle = (angle >= dMinAcceptedAngle);
       }
     }
-    if (max_angle < dMinAcceptedAngle)
+
+    if(!validAngle)
     {
-      iterTracks = sfmData.structure.erase(iterTracks);
-      ++removedTrack_count;
+      removeLandmark[i] = 1;
+      ++removedTrackCount;
     }
-    else
-      ++iterTracks;
   }
-  return removedTrack_count;
+
+  eraseLandmarks(landmarks, removeLandmark, sfmData);
+
+  return static_cast<IndexT>(removedTrackCount);
 }
 
 bool eraseUnstablePoses(sfmData::SfMData& sfmData, const IndexT min_points_per_pose, std::set<IndexT>* outRemovedViewsId)
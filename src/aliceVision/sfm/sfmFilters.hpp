@@ -31,10 +31,12 @@ inline PairSet Pair_filter(const IterablePairs& pairs, const IterableIndex& inde
 }
 
 /// Remove observations with too large reprojection error.
-/// Return the number of removed tracks.
+/// Return the number of removed observations.
+/// The RMSE of the kept observations is computed in the same pass (outInliersRMSE, optional).
 IndexT RemoveOutliers_PixelResidualError(sfmData::SfMData& sfmData,
                                          const double dThresholdPixel,
-                                         const unsigned int minTrackLength = 2);
+                                         const unsigned int minTrackLength = 2,
+                                         double* outInliersRMSE = nullptr);
 
 // Remove tracks that have a small angle (tracks with tiny angle leads to instable 3D points)
 // Return the number of removed tracks
@@ -13,6 +13,7 @@
 #include <boost/progress.hpp>
 
 #include <deque>
+#include <vector>
 #include <memory>
 
 namespace aliceVision {
@@ -168,19 +169,52 @@ bool StructureComputation_robust::robust_triangulation(const sfmData::SfMData& s
 
   const IndexT nbIter = observations.size(); // TODO: automatic computation of the number of iterations?
 
+  // the projection data of the observations doesn't depend on the hypothesis:
+  // compute it once instead of at each iteration
+  const std::size_t nbObservations = observations.size();
+  std::vector<IndexT> viewIds;
+  std::vector<const IntrinsicBase*> intrinsics;
+  std::vector<Pose3> poses;
+  std::vector<Mat34> Ps;
+  std::vector<Vec2> undistortedPts;
+  viewIds.reserve(nbObservations);
+  intrinsics.reserve(nbObservations);
+  poses.reserve(nbObservations);
+  Ps.reserve(nbObservations);
+  undistortedPts.reserve(nbObservations);
+
+  for(const auto& itObs : observations)
+  {
+    const sfmData::View * view = sfmData.views.at(itObs.first).get();
+    const IntrinsicBase * cam = sfmData.getIntrinsics().at(view->getIntrinsicId()).get();
+    const Pose3 pose = sfmData.getPose(*view).getTransform();
+    viewIds.push_back(itObs.first);
+    intrinsics.push_back(cam);
+    poses.push_back(pose);
+    Ps.push_back(cam->get_projective_equivalent(pose));
+    undistortedPts.push_back(cam->get_ud_pixel(itObs.second.x));
+  }
+
   // - Ransac variables
   Vec3 best_model;
   std::set<IndexT> best_inlier_set;
   double best_error = std::numeric_limits<double>::max();
+  Triangulation trianObj;
 
   // - Ransac loop
   for(IndexT i = 0; i < nbIter; ++i)
   {
     std::set<IndexT> samples;
-    robustEstimation::UniformSample(std::min(std::size_t(min_sample_index), observations.size()), observations.size(), samples);
+    robustEstimation::UniformSample(std::min(std::size_t(min_sample_index), nbObservations), nbObservations, samples);
 
     // Hypothesis generation.
-    const Vec3 current_model = track_sample_triangulation(sfmData, observations, samples);
+    trianObj.clear();
+    for(const IndexT idx : samples)
+    {
+      assert(idx < nbObservations);
+      trianObj.add(Ps[idx], undistortedPts[idx]);
+    }
+    const Vec3 current_model = trianObj.compute();
 
     // Test validity of the hypothesis
     // - chierality (for the samples)
@@ -189,14 +223,9 @@ bool StructureComputation_robust::robust_triangulation(const sfmData::SfMData& s
     // Chierality (Check the point is in front of the sampled cameras)
     bool bChierality = true;
 
-    for(auto& it : samples)
+    for(const IndexT idx : samples)
     {
-      sfmData::Observations::const_iterator itObs = observations.begin();
-      std::advance(itObs, it);
-      const sfmData::View * view = sfmData.views.at(itObs->first).get();
-      const IntrinsicBase * cam = sfmData.getIntrinsics().at(view->getIntrinsicId()).get();
-      const Pose3 pose = sfmData.getPose(*view).getTransform();
-      const double z = pose.depth(current_model); // TODO: cam->depth(pose(X));
+      const double z = poses[idx].depth(current_model); // TODO: cam->depth(pose(X));
       bChierality &= z > 0;
     }
 
@@ -207,17 +236,15 @@ bool StructureComputation_robust::robust_triangulation(const sfmData::SfMData& s
     double current_error = 0.0;
     
     // Classification as inlier/outlier according pixel residual errors.
-    for (const auto& itObs : observations)
+    auto itObs = observations.begin();
+    for(std::size_t o = 0; o < nbObservations; ++o, ++itObs)
     {
-      const sfmData::View * view = sfmData.views.at(itObs.first).get();
-      const IntrinsicBase * intrinsic = sfmData.getIntrinsics().at(view->getIntrinsicId()).get();
-      const Pose3 pose = sfmData.getPose(*view).getTransform();
-      const Vec2 residual = intrinsic->residual(pose, current_model, itObs.second.x);
+      const Vec2 residual = intrinsics[o]->residual(poses[o], current_model, itObs->second.x);
       const double residual_d = residual.norm();
 
       if (residual_d < dThresholdPixel)
       {
-        inlier_set.insert(itObs.first);
+        inlier_set.insert(viewIds[o]);
         current_error += residual_d;
       }
       else
@@ -236,27 +263,5 @@ bool StructureComputation_robust::robust_triangulation(const sfmData::SfMData& s
   return !best_inlier_set.empty();
 }
 
-
-/// Triangulate a given track from a selection of observations
-Vec3 StructureComputation_robust::track_sample_triangulation(const sfmData::SfMData& sfmData,
-                                                             const sfmData::Observations& observations,
-                                                             const std::set<IndexT>& samples) const
-{
-  Triangulation trianObj;
-  for (const IndexT idx : samples)
-  {
-    assert(idx < observations.size());
-    sfmData::Observations::const_iterator itObs = observations.begin();
-    std::advance(itObs, idx);
-    const sfmData::View * view = sfmData.views.at(itObs->first).get();
-    const IntrinsicBase * cam = sfmData.getIntrinsics().at(view->getIntrinsicId()).get();
-    const Pose3 pose = sfmData.getPose(*view).getTransform();
-    trianObj.add(
-      cam->get_projective_equivalent(pose),
-      cam->get_ud_pixel(itObs->second.x));
-  }
-  return trianObj.compute();
-}
-
 } // namespace sfm
 } // namespace aliceVision
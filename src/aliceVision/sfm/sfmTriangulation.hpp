@@ -58,12 +58,6 @@ struct StructureComputation_robust: public StructureComputation_basis
                             Vec3& X,
                             const IndexT min_required_inliers = 3,
                             const IndexT min_sample_index = 3) const;
-
-private:
-  /// Triangulate a given track from a selection of observations
-  Vec3 track_sample_triangulation(const sfmData::SfMData& sfmData,
-                                  const sfmData::Observations& observations,
-                                  const std::set<IndexT>& samples) const;
 };
 
 } // namespace sfm
@@ -7,32 +7,48 @@
 
 #include "statistics.hpp"
 #include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/system/ParallelReduce.hpp>
+
+#include <cmath>
+#include <utility>
+#include <vector>
 
 namespace aliceVision {
 namespace sfm {
 
 double RMSE(const sfmData::SfMData& sfmData)
 {
-  // Compute residuals for each observation
-  std::vector<double> vec;
-  for(sfmData::Landmarks::const_iterator iterTracks = sfmData.getLandmarks().begin();
-      iterTracks != sfmData.getLandmarks().end();
-      ++iterTracks)
-  {
-    const sfmData::Observations& obs = iterTracks->second.observations;
-    for(sfmData::Observations::const_iterator itObs = obs.begin();
-      itObs != obs.end(); ++itObs)
+  // list the landmarks, to process the landmark hash map with an index
+  std::vector<const sfmData::Landmark*> landmarks;
+  landmarks.reserve(sfmData.getLandmarks().size());
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+    landmarks.push_back(&landmarkPair.second);
+
+  // Compute residuals for each observation,
+  // summed with a fixed partition for a result independent of the number of threads
+  using Residuals = std::pair<double, std::size_t>;
+  const Residuals residuals = system::parallelReduce(std::size_t(0), landmarks.size(), Residuals(0.0, 0),
+    [&](Residuals& sum, std::size_t i)
     {
-      const sfmData::View* view = sfmData.getViews().find(itObs->first)->second.get();
-      const geometry::Pose3 pose = sfmData.getPose(*view).getTransform();
-      const std::shared_ptr<camera::IntrinsicBase> intrinsic = sfmData.getIntrinsics().at(view->getIntrinsicId());
-      const Vec2 residual = intrinsic->residual(pose, iterTracks->second.X, itObs->second.x);
-      vec.push_back(residual(0));
-      vec.push_back(residual(1));
-    }
-  }
-  const Eigen::Map<Eigen::RowVectorXd> residuals(&vec[0], vec.size());
-  const double RMSE = std::sqrt(residuals.squaredNorm() / vec.size());
+      const sfmData::Landmark& landmark = *landmarks[i];
+      for(const auto& observationPair : landmark.observations)
+      {
+        const sfmData::View* view = sfmData.getViews().find(observationPair.first)->second.get();
+        const geometry::Pose3 pose = sfmData.getPose(*view).getTransform();
+        const camera::IntrinsicBase* intrinsic = sfmData.getIntrinsics().at(view->getIntrinsicId()).get();
+        const Vec2 residual = intrinsic->residual(pose, landmark.X, observationPair.second.x);
+        sum.first += residual.squaredNorm();
+        sum.second += 2;
+      }
+    },
+    [](const Residuals& left, const Residuals& right)
+    {
+      return Residuals(left.first + right.first, left.second + right.second);
+    }, 256);
+
+  const double squaredResidual = residuals.first;
+  const std::size_t nbResiduals = residuals.second;
+  const double RMSE = std::sqrt(squaredResidual / nbResiduals);
   return RMSE;
 }
 
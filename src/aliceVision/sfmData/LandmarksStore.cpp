@@ -0,0 +1,109 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LandmarksStore.hpp"
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace sfmData {
+
+const std::size_t LandmarksStore::npos;
+
+void LandmarksStore::build(const Landmarks& landmarks)
+{
+  _ids.clear();
+  _ids.reserve(landmarks.size());
+  for(const auto& landmarkPair : landmarks)
+    _ids.push_back(landmarkPair.first);
+  std::sort(_ids.begin(), _ids.end());
+
+  const std::size_t nbLandmarks = _ids.size();
+  _X.resize(3, nbLandmarks);
+  _rgb.resize(nbLandmarks);
+  _descType.resize(nbLandmarks);
+  _observationsOffset.resize(nbLandmarks + 1);
+
+  // observations offsets
+  _observationsOffset[0] = 0;
+  for(std::size_t i = 0; i < nbLandmarks; ++i)
+    _observationsOffset[i + 1] = _observationsOffset[i] + landmarks.at(_ids[i]).observations.size();
+
+  const std::size_t nbObservations = _observationsOffset[nbLandmarks];
+  _observationsViewId.resize(nbObservations);
+  _observationsFeatureId.resize(nbObservations);
+  _observationsX.resize(2, nbObservations);
+
+  for(std::size_t i = 0; i < nbLandmarks; ++i)
+  {
+    const Landmark& landmark = landmarks.at(_ids[i]);
+    _X.col(i) = landmark.X;
+    _rgb[i] = landmark.rgb;
+    _descType[i] = landmark.descType;
+
+    // the observations are already sorted by view id
+    std::size_t observationIndex = _observationsOffset[i];
+    for(const auto& observationPair : landmark.observations)
+    {
+      _observationsViewId[observationIndex] = observationPair.first;
+      _observationsFeatureId[observationIndex] = observationPair.second.id_feat;
+      _observationsX.col(observationIndex) = observationPair.second.x;
+      ++observationIndex;
+    }
+  }
+}
+
+void LandmarksStore::exportToLandmarks(Landmarks& landmarks) const
+{
+  landmarks.clear();
+  for(std::size_t i = 0; i < size(); ++i)
+    landmarks.emplace(_ids[i], getLandmark(i));
+}
+
+void LandmarksStore::updateLandmarks(Landmarks& landmarks) const
+{
+  for(std::size_t i = 0; i < size(); ++i)
+  {
+    const auto landmarkIt = landmarks.find(_ids[i]);
+    if(landmarkIt == landmarks.end())
+      continue;
+    landmarkIt->second.X = _X.col(i);
+    landmarkIt->second.rgb = _rgb[i];
+  }
+}
+
+Landmark LandmarksStore::getLandmark(std::size_t index) const
+{
+  Landmark landmark(_X.col(index), _descType[index], Observations(), _rgb[index]);
+
+  // sorted insertion at the end of the flat map
+  landmark.observations.reserve(nbObservations(index));
+  for(std::size_t k = observationsBegin(index); k < observationsEnd(index); ++k)
+    landmark.observations.emplace_hint(landmark.observations.end(), _observationsViewId[k], Observation(_observationsX.col(k), _observationsFeatureId[k]));
+
+  return landmark;
+}
+
+std::size_t LandmarksStore::getIndex(IndexT landmarkId) const
+{
+  const auto it = std::lower_bound(_ids.begin(), _ids.end(), landmarkId);
+  if(it == _ids.end() || *it != landmarkId)
+    return npos;
+  return std::distance(_ids.begin(), it);
+}
+
+std::size_t LandmarksStore::findObservation(std::size_t index, IndexT viewId) const
+{
+  const auto begin = _observationsViewId.begin() + observationsBegin(index);
+  const auto end = _observationsViewId.begin() + observationsEnd(index);
+  const auto it = std::lower_bound(begin, end, viewId);
+  if(it == end || *it != viewId)
+    return npos;
+  return std::distance(_observationsViewId.begin(), it);
+}
+
+} // namespace sfmData
+} // namespace aliceVision
@@ -0,0 +1,146 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfmData/Landmark.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/image/pixelTypes.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/types.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace sfmData {
+
+/**
+ * @brief Structure of arrays storage of the landmarks of a scene.
+ *
+ * The landmarks are sorted by id, with their positions, colors and describer types in
+ * contiguous arrays. The observations of all the landmarks are stored in a compressed
+ * sparse row layout (offsets per landmark), sorted by view id for each landmark.
+ *
+ * The store is built from the Landmarks of a SfMData for the sweeps over the whole structure
+ * and written back once: a copy of the store is a few vector copies instead of one
+ * allocation per landmark.
+ */
+class LandmarksStore
+{
+public:
+  /// Invalid landmark index
+  static const std::size_t npos = static_cast<std::size_t>(-1);
+
+  LandmarksStore() = default;
+
+  explicit LandmarksStore(const Landmarks& landmarks)
+  {
+    build(landmarks);
+  }
+
+  /**
+   * @brief Build the store from the given landmarks.
+   * @param[in] landmarks The landmarks
+   */
+  void build(const Landmarks& landmarks);
+
+  /**
+   * @brief Export the store in the given landmarks (replaced).
+   * @param[out] landmarks The landmarks
+   */
+  void exportToLandmarks(Landmarks& landmarks) const;
+
+  /**
+   * @brief Update the 3D positions and colors of the given landmarks from the store.
+   * The landmarks of the store not found in the given landmarks are ignored.
+   * @param[in,out] landmarks The landmarks
+   */
+  void updateLandmarks(Landmarks& landmarks) const;
+
+  /**
+   * @brief Get a copy of a landmark in the Landmark structure.
+   * @param[in] index The landmark index
+   * @return The landmark
+   */
+  Landmark getLandmark(std::size_t index) const;
+
+  /// Number of landmarks
+  inline std::size_t size() const { return _ids.size(); }
+
+  /// Whether the store has no landmark
+  inline bool empty() const { return _ids.empty(); }
+
+  /// Number of observations of all the landmarks
+  inline std::size_t nbObservations() const { return _observationsViewId.size(); }
+
+  /**
+   * @brief Get the index of a landmark from its id.
+   * @param[in] landmarkId The landmark id
+   * @return The landmark index or npos if the landmark is not in the store
+   */
+  std::size_t getIndex(IndexT landmarkId) const;
+
+  /// Id of the landmark
+  inline IndexT getId(std::size_t index) const { return _ids[index]; }
+
+  /// 3D position of the landmark
+  inline Mat3X::ColXpr X(std::size_t index) { return _X.col(index); }
+  inline Mat3X::ConstColXpr X(std::size_t index) const { return _X.col(index); }
+
+  /// Color of the landmark
+  inline image::RGBColor& rgb(std::size_t index) { return _rgb[index]; }
+  inline const image::RGBColor& rgb(std::size_t index) const { return _rgb[index]; }
+
+  /// Describer type of the landmark
+  inline feature::EImageDescriberType descType(std::size_t index) const { return _descType[index]; }
+
+  /// First observation index of the landmark
+  inline std::size_t observationsBegin(std::size_t index) const { return _observationsOffset[index]; }
+
+  /// End of the observation indexes of the landmark
+  inline std::size_t observationsEnd(std::size_t index) const { return _observationsOffset[index + 1]; }
+
+  /// Number of observations of the landmark
+  inline std::size_t nbObservations(std::size_t index) const { return observationsEnd(index) - observationsBegin(index); }
+
+  /**
+   * @brief Find the observation of a landmark in a view.
+   * @param[in] index The landmark index
+   * @param[in] viewId The view id
+   * @return The observation index or npos if the landmark is not observed in the view
+   */
+  std::size_t findObservation(std::size_t index, IndexT viewId) const;
+
+  /// View id of the observation
+  inline IndexT observationViewId(std::size_t observationIndex) const { return _observationsViewId[observationIndex]; }
+
+  /// Feature id of the observation
+  inline IndexT observationFeatureId(std::size_t observationIndex) const { return _observationsFeatureId[observationIndex]; }
+
+  /// 2D position of the observation
+  inline Mat2X::ConstColXpr observationX(std::size_t observationIndex) const { return _observationsX.col(observationIndex); }
+
+private:
+  /// landmark ids (sorted)
+  std::vector<IndexT> _ids;
+  /// landmark 3D positions
+  Mat3X _X;
+  /// landmark colors
+  std::vector<image::RGBColor> _rgb;
+  /// landmark describer types
+  std::vector<feature::EImageDescriberType> _descType;
+  /// first observation of each landmark (size() + 1 values)
+  std::vector<std::size_t> _observationsOffset;
+  /// view id of each observation
+  std::vector<IndexT> _observationsViewId;
+  /// feature id of each observation
+  std::vector<IndexT> _observationsFeatureId;
+  /// 2D position of each observation
+  Mat2X _observationsX;
+};
+
+} // namespace sfmData
+} // namespace aliceVision
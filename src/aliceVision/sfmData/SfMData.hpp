@@ -29,9 +29,6 @@ using Poses = HashMap<IndexT, CameraPose>;
 /// Define a collection of IntrinsicParameter (indexed by view.getIntrinsicId())
 using Intrinsics = HashMap<IndexT, std::shared_ptr<camera::IntrinsicBase> >;
 
-/// Define a collection of landmarks are indexed by their TrackId
-using Landmarks = HashMap<IndexT, Landmark>;
-
 /// Define a collection of Rig
 using Rigs = std::map<IndexT, Rig>;
 
@@ -9,6 +9,8 @@
 
 #include <aliceVision/types.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <utility>
 
@@ -392,6 +394,47 @@ public:
     return EEXIFOrientation::UNKNOWN;
   }
 
+  /**
+   * @brief Return true if the view has the "GPS:Latitude" and "GPS:Longitude" metadata
+   * @return true if the view has a GPS position
+   */
+  bool hasGpsMetadata() const
+  {
+    double latitude, longitude, altitude;
+    return getMetadataGpsPosition(latitude, longitude, altitude);
+  }
+
+  /**
+   * @brief Get the GPS position from the "GPS:Latitude", "GPS:Longitude" and "GPS:Altitude" metadata
+   *        (and their "Ref" metadata for the hemisphere)
+   * @param[out] latitude the latitude in degrees, negative in the south
+   * @param[out] longitude the longitude in degrees, negative in the west
+   * @param[out] altitude the altitude in meters, 0 if undefined
+   * @return false if the view has no valid GPS position
+   */
+  bool getMetadataGpsPosition(double& latitude, double& longitude, double& altitude) const
+  {
+    if(!parseGpsCoordinate(getMetadataOrEmpty("GPS:Latitude"), latitude) ||
+       !parseGpsCoordinate(getMetadataOrEmpty("GPS:Longitude"), longitude) ||
+       std::abs(latitude) > 90.0 || std::abs(longitude) > 180.0)
+      return false;
+
+    if(getMetadataOrEmpty("GPS:LatitudeRef") == "S")
+      latitude = -latitude;
+    if(getMetadataOrEmpty("GPS:LongitudeRef") == "W")
+      longitude = -longitude;
+
+    altitude = 0.0;
+    if(hasDigitMetadata("GPS:Altitude", false))
+    {
+      altitude = std::stod(getMetadata("GPS:Altitude"));
+      // 1: below the sea level
+      if(getMetadataOrEmpty("GPS:AltitudeRef") == "1")
+        altitude = -altitude;
+    }
+    return true;
+  }
+
   /**
    * @brief Get the view metadata structure
    * @return the view metadata
@@ -515,6 +558,36 @@ public:
 
 private:
 
+  /**
+   * @brief Parse a GPS coordinate in degrees, from decimal degrees ("48.8582")
+   *        or from degrees, minutes and seconds ("48, 51, 29.5")
+   * @param[in] value the metadata value
+   * @param[out] degrees the coordinate in degrees
+   * @return false if the value is not a GPS coordinate
+   */
+  static bool parseGpsCoordinate(const std::string& value, double& degrees)
+  {
+    degrees = 0.0;
+    double unit = 1.0;
+    std::size_t begin = 0;
+    for(int i = 0; i < 3 && begin < value.size(); ++i)
+    {
+      const std::size_t end = std::min(value.find(',', begin), value.size());
+      try
+      {
+        degrees += std::stod(value.substr(begin, end - begin)) / unit;
+      }
+      catch(std::exception&)
+      {
+        return false;
+      }
+      unit *= 60.0;
+      begin = end + 1;
+    }
+    return (unit > 1.0 && begin >= value.size());
+  }
+
+
   /// image path on disk
   std::string _imagePath;
   /// image width
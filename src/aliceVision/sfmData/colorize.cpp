@@ -8,27 +8,29 @@
 #include "colorize.hpp"
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmData/LandmarksStore.hpp>
 #include <aliceVision/stl/indexedSort.hpp>
 #include <aliceVision/stl/mapUtils.hpp>
 #include <aliceVision/image/io.hpp>
+#include <aliceVision/image/ImageProvider.hpp>
+#include <aliceVision/system/Logger.hpp>
 
 #include <boost/progress.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <map>
+#include <stdexcept>
 #include <vector>
-#include <functional>
 namespace aliceVision {
 namespace sfmData {
 
-void colorizeTracks(SfMData& sfmData)
+void colorizeTracks(SfMData& sfmData, const image::ImageProvider* imageProvider, int level)
 {
-  boost::progress_display progressBar(sfmData.getLandmarks().size(), std::cout, "\nCompute scene structure color\n");
+  // contiguous copy of the structure, colored and written back at the end
+  LandmarksStore store(sfmData.getLandmarks());
 
-  std::vector<std::reference_wrapper<Landmark>> remainingLandmarksToColor;
-  remainingLandmarksToColor.reserve(sfmData.getLandmarks().size());
-
-  for(auto& landmarkPair : sfmData.getLandmarks())
-    remainingLandmarksToColor.push_back(landmarkPair.second);
+  boost::progress_display progressBar(store.size(), std::cout, "\nCompute scene structure color\n");
 
   struct ViewInfo
   {
@@ -39,88 +41,139 @@ void colorizeTracks(SfMData& sfmData)
 
     IndexT viewId;
     std::size_t cardinal;
-    std::vector<std::reference_wrapper<Landmark>> landmarks;
+    std::vector<std::pair<std::size_t, std::size_t>> landmarks; //< <landmark index, observation index> in the store
   };
 
   std::vector<ViewInfo> sortedViewsCardinal;
   sortedViewsCardinal.reserve(sfmData.getViews().size());
+
+  // rank of each view in the sorted views
+  std::map<IndexT, std::size_t> viewsRank; // <ViewId, Rank>
   {
     // create cardinal per viewId map
     std::map<IndexT, std::size_t> viewsCardinalMap; // <ViewId, Cardinal>
-    for(const auto& landmarkPair : sfmData.getLandmarks())
-    {
-      const Observations& observations = landmarkPair.second.observations;
-      for(const auto& observationPair : observations)
-        ++viewsCardinalMap[observationPair.first]; // TODO: 0
-    }
+    for(std::size_t k = 0; k < store.nbObservations(); ++k)
+      ++viewsCardinalMap[store.observationViewId(k)];
 
     // copy key-value pairs from the map to the vector
     for(const auto& cardinalPair : viewsCardinalMap)
       sortedViewsCardinal.push_back(ViewInfo(cardinalPair.first, cardinalPair.second));
 
     // sort the vector, biggest cardinality first
-    std::sort(sortedViewsCardinal.begin(),
-              sortedViewsCardinal.end(),
-              [] (const ViewInfo& l, const ViewInfo& r) { return l.cardinal > r.cardinal; });
+    std::stable_sort(sortedViewsCardinal.begin(),
+                     sortedViewsCardinal.end(),
+                     [] (const ViewInfo& l, const ViewInfo& r) { return l.cardinal > r.cardinal; });
+
+    for(std::size_t rank = 0; rank < sortedViewsCardinal.size(); ++rank)
+      viewsRank.emplace_hint(viewsRank.end(), sortedViewsCardinal.at(rank).viewId, rank);
   }
 
-  // assign each landmark to a view
-  for(ViewInfo& viewCardinal : sortedViewsCardinal)
+  // assign each landmark to its observing view with the biggest cardinality
   {
-    std::vector<std::reference_wrapper<Landmark>> toKeep;
-    const IndexT viewId = viewCardinal.viewId;
+    std::vector<std::size_t> observationsRank(store.nbObservations());
+    for(std::size_t k = 0; k < store.nbObservations(); ++k)
+      observationsRank[k] = viewsRank.at(store.observationViewId(k));
 
-    for(int i = 0; i < remainingLandmarksToColor.size(); ++i)
+    for(std::size_t i = 0; i < store.size(); ++i)
     {
-      Landmark& landmark = remainingLandmarksToColor.at(i);
-      auto it = landmark.observations.find(viewId);
-      if(it != landmark.observations.end())
-      {
-        viewCardinal.landmarks.push_back(landmark);
-      }
-      else
+      if(store.nbObservations(i) == 0)
+        continue;
+
+      std::size_t bestObservation = store.observationsBegin(i);
+      for(std::size_t k = bestObservation + 1; k < store.observationsEnd(i); ++k)
       {
-        toKeep.push_back(landmark);
+        if(observationsRank[k] < observationsRank[bestObservation])
+          bestObservation = k;
       }
+      sortedViewsCardinal.at(observationsRank[bestObservation]).landmarks.emplace_back(i, bestObservation);
     }
-    std::swap(toKeep, remainingLandmarksToColor);
-
-    if(remainingLandmarksToColor.empty())
-      break;
   }
 
-  // create an unsorted index container
-  std::vector<int> unsortedIndexes(sortedViewsCardinal.size()) ;
-  std::iota(std::begin(unsortedIndexes), std::end(unsortedIndexes), 0);
-  std::random_shuffle(unsortedIndexes.begin(), unsortedIndexes.end());
-
   // landmark colorization
-#pragma omp parallel for
-  for(int i = 0; i < unsortedIndexes.size(); ++i)
+  // each landmark is colored from a single view: the views can be processed concurrently,
+  // the biggest views first to balance the threads
+  bool success = true;
+
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < sortedViewsCardinal.size(); ++i)
   {
-    const ViewInfo& viewCardinal = sortedViewsCardinal.at(unsortedIndexes.at(i));
-    if(!viewCardinal.landmarks.empty())
+    const ViewInfo& viewCardinal = sortedViewsCardinal.at(i);
+    if(viewCardinal.landmarks.empty())
+      continue;
+
+    bool succeeded;
+#pragma omp atomic read
+    succeeded = success;
+
+    if(!succeeded)
+      continue;
+
+    try
     {
       const View& view = sfmData.getView(viewCardinal.viewId);
       image::Image<image::RGBColor> image;
-      image::readImage(view.getImagePath(), image, image::EImageColorSpace::SRGB);
+      double scale = 1.0;   //< scale from the observations to the image pixels
+      int xBegin = 0;       //< position of the image in the pixels of its level
+      int yBegin = 0;
 
-      for(Landmark& landmark : viewCardinal.landmarks)
+      if(imageProvider != nullptr)
+      {
+        // only read the region with observations, at the requested level
+        const int imageLevel = std::max(0, std::min(level, imageProvider->getNbLevels(view.getImagePath()) - 1));
+        int width, height;
+        imageProvider->getSize(view.getImagePath(), width, height, imageLevel);
+        scale = 1.0 / (1 << imageLevel);
+
+        int xEnd = 0;
+        int yEnd = 0;
+        xBegin = width;
+        yBegin = height;
+        for(const auto& landmarkPair : viewCardinal.landmarks)
+        {
+          const Vec2 pt = store.observationX(landmarkPair.second) * scale;
+          const int x = clamp(static_cast<int>(pt.x()), 0, width - 1);
+          const int y = clamp(static_cast<int>(pt.y()), 0, height - 1);
+          xBegin = std::min(xBegin, x);
+          yBegin = std::min(yBegin, y);
+          xEnd = std::max(xEnd, x + 1);
+          yEnd = std::max(yEnd, y + 1);
+        }
+        imageProvider->readImage(view.getImagePath(), image, image::EImageColorSpace::SRGB, imageLevel, oiio::ROI(xBegin, xEnd, yBegin, yEnd));
+      }
+      else
+      {
+        image::readImage(view.getImagePath(), image, image::EImageColorSpace::SRGB);
+      }
+
+      for(const auto& landmarkPair : viewCardinal.landmarks)
       {
         // color the point
-        Vec2 pt = landmark.observations.at(view.getViewId()).x;
+        Vec2 pt = store.observationX(landmarkPair.second) * scale;
+        pt.x() -= xBegin;
+        pt.y() -= yBegin;
         // clamp the pixel position if the feature/marker center is outside the image.
         pt.x() = clamp(pt.x(), 0.0, static_cast<double>(image.Width() - 1));
         pt.y() = clamp(pt.y(), 0.0, static_cast<double>(image.Height() - 1));
-        landmark.rgb = image(pt.y(), pt.x());
+        store.rgb(landmarkPair.first) = image(pt.y(), pt.x());
       }
+    }
+    catch(std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Cannot colorize the landmarks of the view " << viewCardinal.viewId << ": " << e.what());
+#pragma omp atomic write
+      success = false;
+    }
 
 #pragma omp critical
-      {
-        progressBar += viewCardinal.landmarks.size();
-      }
+    {
+      progressBar += viewCardinal.landmarks.size();
     }
   }
+
+  if(!success)
+    throw std::runtime_error("Cannot colorize the scene structure.");
+
+  store.updateLandmarks(sfmData.getLandmarks());
 }
 
 } // namespace sfm
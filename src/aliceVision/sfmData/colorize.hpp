@@ -8,6 +8,11 @@
 #pragma once
 
 namespace aliceVision {
+
+namespace image {
+class ImageProvider;
+} // namespace image
+
 namespace sfmData {
 
 class SfMData;
@@ -17,8 +22,12 @@ class SfMData;
  * the sfmData, using the track to determine the best view from which
  * to get the color.
  * @param[in,out] sfmData The container of the data
+ * @param[in] imageProvider Optional images provider: only the region of each view with observations
+ *            is read through it, instead of decoding the full images
+ * @param[in] level The mipmap level of the images read through the images provider
+ *            (each level halves the resolution, clamped to the last level of the image)
  */
-void colorizeTracks(SfMData& sfmData);
+void colorizeTracks(SfMData& sfmData, const image::ImageProvider* imageProvider = nullptr, int level = 0);
 
 } // namespace sfmData
 } // namespace aliceVision
@@ -1,6 +1,7 @@
 
 #include <boost/filesystem.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmData/LandmarksStore.hpp>
 
 #define BOOST_TEST_MODULE sfmData
 #include <boost/test/included/unit_test.hpp>
@@ -50,3 +51,89 @@ BOOST_AUTO_TEST_CASE(SfMData_InternalFolders)
   BOOST_CHECK_EQUAL(sfmData.getRelativeMatchesFolders()[0], fs::relative(refFolder, otherFolder));
 }
 
+
+BOOST_AUTO_TEST_CASE(SfMData_LandmarksStore)
+{
+  sfmData::Landmarks landmarks;
+  for(IndexT landmarkId = 0; landmarkId < 20; ++landmarkId)
+  {
+    // sparse landmark ids with a variable number of observations (none for the first one)
+    sfmData::Landmark& landmark = landmarks[landmarkId * 7];
+    landmark.X = Vec3(landmarkId, 2.0 * landmarkId, -1.0);
+    landmark.descType = feature::EImageDescriberType::SIFT;
+    landmark.rgb = image::RGBColor(landmarkId, 0, 255);
+    for(IndexT viewId = 0; viewId < landmarkId % 5; ++viewId)
+      landmark.observations[viewId * 3] = sfmData::Observation(Vec2(viewId, landmarkId), landmarkId * 10 + viewId);
+  }
+
+  const sfmData::LandmarksStore store(landmarks);
+  BOOST_CHECK_EQUAL(store.size(), landmarks.size());
+
+  std::size_t nbObservations = 0;
+  for(std::size_t i = 0; i < store.size(); ++i)
+  {
+    const IndexT landmarkId = store.getId(i);
+    BOOST_CHECK_EQUAL(store.getIndex(landmarkId), i);
+    BOOST_CHECK(store.getLandmark(i) == landmarks.at(landmarkId));
+    if(i > 0)
+      BOOST_CHECK_LT(store.getId(i - 1), landmarkId);
+
+    for(const auto& observationPair : landmarks.at(landmarkId).observations)
+    {
+      const std::size_t k = store.findObservation(i, observationPair.first);
+      BOOST_REQUIRE_NE(k, sfmData::LandmarksStore::npos);
+      BOOST_CHECK_EQUAL(store.observationFeatureId(k), observationPair.second.id_feat);
+    }
+    BOOST_CHECK_EQUAL(store.findObservation(i, 1), sfmData::LandmarksStore::npos);
+    nbObservations += store.nbObservations(i);
+  }
+  BOOST_CHECK_EQUAL(store.nbObservations(), nbObservations);
+  BOOST_CHECK_EQUAL(store.getIndex(1), sfmData::LandmarksStore::npos);
+
+  // roundtrip
+  sfmData::Landmarks exported;
+  store.exportToLandmarks(exported);
+  BOOST_CHECK(exported == landmarks);
+
+  // update of the positions and colors
+  sfmData::LandmarksStore updatedStore(landmarks);
+  updatedStore.X(updatedStore.getIndex(14)) = Vec3(1.0, 2.0, 3.0);
+  updatedStore.rgb(updatedStore.getIndex(14)) = image::BLACK;
+  updatedStore.updateLandmarks(exported);
+  BOOST_CHECK(exported.at(14).X == Vec3(1.0, 2.0, 3.0));
+  BOOST_CHECK(exported.at(14).rgb == image::BLACK);
+  BOOST_CHECK(exported.at(14).observations == landmarks.at(14).observations);
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_ViewGpsMetadata)
+{
+  double latitude, longitude, altitude;
+
+  BOOST_CHECK(!sfmData::View("filepath", 0).hasGpsMetadata());
+
+  // degrees, minutes, seconds
+  {
+    const sfmData::View view("filepath", 0, UndefinedIndexT, UndefinedIndexT, 0, 0, UndefinedIndexT, UndefinedIndexT,
+                             {{"GPS:Latitude", "48, 51, 29.52"}, {"GPS:LatitudeRef", "N"},
+                              {"GPS:Longitude", "2, 17, 40.2"}, {"GPS:LongitudeRef", "W"}});
+    BOOST_CHECK(view.getMetadataGpsPosition(latitude, longitude, altitude));
+    BOOST_CHECK_CLOSE(latitude, 48.8582, 1e-6);
+    BOOST_CHECK_CLOSE(longitude, -2.2945, 1e-6);
+    BOOST_CHECK_EQUAL(altitude, 0.0);
+  }
+  // decimal degrees, below the sea level
+  {
+    const sfmData::View view("filepath", 0, UndefinedIndexT, UndefinedIndexT, 0, 0, UndefinedIndexT, UndefinedIndexT,
+                             {{"GPS:Latitude", "12.5"}, {"GPS:LatitudeRef", "S"}, {"GPS:Longitude", "5"},
+                              {"GPS:Altitude", "35.5"}, {"GPS:AltitudeRef", "1"}});
+    BOOST_CHECK(view.getMetadataGpsPosition(latitude, longitude, altitude));
+    BOOST_CHECK_EQUAL(latitude, -12.5);
+    BOOST_CHECK_EQUAL(longitude, 5.0);
+    BOOST_CHECK_EQUAL(altitude, -35.5);
+  }
+  // invalid values
+  BOOST_CHECK(!sfmData::View("filepath", 0, UndefinedIndexT, UndefinedIndexT, 0, 0, UndefinedIndexT, UndefinedIndexT,
+                             {{"GPS:Latitude", "north"}, {"GPS:Longitude", "5"}}).hasGpsMetadata());
+  BOOST_CHECK(!sfmData::View("filepath", 0, UndefinedIndexT, UndefinedIndexT, 0, 0, UndefinedIndexT, UndefinedIndexT,
+                             {{"GPS:Latitude", "95.0"}, {"GPS:Longitude", "5"}}).hasGpsMetadata());
+}
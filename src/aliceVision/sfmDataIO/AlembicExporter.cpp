@@ -7,6 +7,7 @@
 
 #include "AlembicExporter.hpp"
 #include <aliceVision/version.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <Alembic/AbcGeom/All.h>
 #include <Alembic/AbcCoreOgawa/All.h>
@@ -392,21 +393,28 @@ void AlembicExporter::addLandmarks(const sfmData::Landmarks& landmarks, const sf
   if(landmarks.empty())
     return;
 
+  // random access to the landmarks, the buffers are filled in parallel
+  std::vector<sfmData::Landmarks::const_iterator> landmarksIts;
+  landmarksIts.reserve(landmarks.size());
+  for(auto it = landmarks.begin(); it != landmarks.end(); ++it)
+    landmarksIts.push_back(it);
+
+  const int nbLandmarks = static_cast<int>(landmarksIts.size());
+
   // Fill vector with the values taken from AliceVision
-  std::vector<V3f> positions;
-  std::vector<Imath::C3f> colors;
-  std::vector<Alembic::Util::uint32_t> descTypes;
-  positions.reserve(landmarks.size());
-  descTypes.reserve(landmarks.size());
-
-  // For all the 3d points in the hash_map
-  for(const auto& landmark : landmarks)
+  std::vector<V3f> positions(nbLandmarks);
+  std::vector<Imath::C3f> colors(nbLandmarks);
+  std::vector<Alembic::Util::uint32_t> descTypes(nbLandmarks);
+
+  #pragma omp parallel for
+  for(int i = 0; i < nbLandmarks; ++i)
   {
-    const Vec3& pt = landmark.second.X;
-    const image::RGBColor& color = landmark.second.rgb;
-    positions.emplace_back(pt[0], pt[1], pt[2]);
-    colors.emplace_back(color.r()/255.f, color.g()/255.f, color.b()/255.f);
-    descTypes.emplace_back(static_cast<Alembic::Util::uint8_t>(landmark.second.descType));
+    const sfmData::Landmark& landmark = landmarksIts.at(i)->second;
+    const Vec3& pt = landmark.X;
+    const image::RGBColor& color = landmark.rgb;
+    positions[i] = V3f(pt[0], pt[1], pt[2]);
+    colors[i] = Imath::C3f(color.r()/255.f, color.g()/255.f, color.b()/255.f);
+    descTypes[i] = static_cast<Alembic::Util::uint8_t>(landmark.descType);
   }
 
   std::vector<Alembic::Util::uint64_t> ids(positions.size());
@@ -432,46 +440,49 @@ void AlembicExporter::addLandmarks(const sfmData::Landmarks& landmarks, const sf
 
   if(withVisibility)
   {
-    std::vector<::uint32_t> visibilitySize;
-    visibilitySize.reserve(positions.size());
-    for(const auto& landmark : landmarks)
+    std::vector<::uint32_t> visibilitySize(nbLandmarks);
+    // first observation of each landmark in the visibility buffers
+    std::vector<std::size_t> visibilityOffset(nbLandmarks + 1, 0);
+    for(int i = 0; i < nbLandmarks; ++i)
     {
-      visibilitySize.emplace_back(landmark.second.observations.size());
+      visibilitySize[i] = landmarksIts.at(i)->second.observations.size();
+      visibilityOffset[i + 1] = visibilityOffset[i] + visibilitySize[i];
     }
-    std::size_t nbObservations = std::accumulate(visibilitySize.begin(), visibilitySize.end(), 0);
+    const std::size_t nbObservations = visibilityOffset.back();
 
     // Use std::vector<::uint32_t> and std::vector<float> instead of std::vector<V2i> and std::vector<V2f>
     // Because Maya don't import them correctly
-    std::vector<::uint32_t> visibilityViewId;
+    std::vector<::uint32_t> visibilityViewId(nbObservations);
     std::vector<::uint32_t> visibilityFeatId;
-    visibilityViewId.reserve(nbObservations);
+    std::vector<float> featPos2d;
 
-    std::vector<float>featPos2d;
     if(withFeatures)
     {
-      featPos2d.reserve(nbObservations*2);
-      visibilityFeatId.reserve(nbObservations);
+      featPos2d.resize(nbObservations * 2);
+      visibilityFeatId.resize(nbObservations);
     }
 
-    for (const auto& landmark : landmarks)
+    #pragma omp parallel for
+    for(int i = 0; i < nbLandmarks; ++i)
     {
-      const sfmData::Observations& observations = landmark.second.observations;
-      for(const auto& vObs: observations )
+      std::size_t obsIndex = visibilityOffset[i];
+      for(const auto& vObs : landmarksIts.at(i)->second.observations)
       {
         const sfmData::Observation& obs = vObs.second;
 
         // viewId
-        visibilityViewId.emplace_back(vObs.first);
+        visibilityViewId[obsIndex] = vObs.first;
 
         if(withFeatures)
         {
           // featureId
-          visibilityFeatId.emplace_back(obs.id_feat);
+          visibilityFeatId[obsIndex] = obs.id_feat;
 
           // feature 2D position (x, y))
-          featPos2d.emplace_back(obs.x[0]);
-          featPos2d.emplace_back(obs.x[1]);
+          featPos2d[2 * obsIndex] = obs.x[0];
+          featPos2d[2 * obsIndex + 1] = obs.x[1];
         }
+        ++obsIndex;
       }
     }
 
@@ -486,14 +497,14 @@ void AlembicExporter::addLandmarks(const sfmData::Landmarks& landmarks, const sf
   }
   if(!landmarksUncertainty.empty())
   {
-    std::vector<V3d> uncertainties;
+    std::vector<V3d> uncertainties(nbLandmarks);
 
-    std::size_t indexLandmark = 0;
-    for(sfmData::Landmarks::const_iterator itLandmark = landmarks.begin(); itLandmark != landmarks.end(); ++itLandmark, ++indexLandmark)
+    #pragma omp parallel for
+    for(int i = 0; i < nbLandmarks; ++i)
     {
-      const IndexT idLandmark = itLandmark->first;
+      const IndexT idLandmark = landmarksIts.at(i)->first;
       const Vec3& u = landmarksUncertainty.at(idLandmark);
-      uncertainties.emplace_back(u[0], u[1], u[2]);
+      uncertainties[i] = V3d(u[0], u[1], u[2]);
     }
     // Uncertainty eigen values (x,y,z)
     OV3dArrayProperty propUncertainty(userProps, "mvg_uncertaintyEigenValues");
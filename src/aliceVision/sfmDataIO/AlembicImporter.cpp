@@ -6,11 +6,16 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "AlembicImporter.hpp"
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <Alembic/AbcGeom/All.h>
 #include <Alembic/AbcCoreFactory/All.h>
 #include <Alembic/AbcCoreOgawa/All.h>
 
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
 namespace aliceVision {
 namespace sfmDataIO {
 
@@ -284,6 +289,9 @@ bool readCamera(const ICamera& camera, const M44d& mat, sfmData::SfMData& sfmDat
   using namespace aliceVision::geometry;
   using namespace aliceVision::camera;
 
+  if(!(flagsPart & (ESfMData::VIEWS | ESfMData::INTRINSICS | ESfMData::EXTRINSICS)))
+    return true;
+
   ICameraSchema cs = camera.getSchema();
   CameraSample camSample;
   if(sampleFrame == 0)
@@ -313,66 +321,72 @@ bool readCamera(const ICamera& camera, const M44d& mat, sfmData::SfMData& sfmDat
 
   if(userProps)
   {
-    if(flagsPart & ESfMData::VIEWS || flagsPart & ESfMData::INTRINSICS)
+    // ids are needed by all the parts
+    if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_viewId"))
     {
-      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_imagePath"))
-        imagePath = getAbcProp<Alembic::Abc::IStringProperty>(userProps, *propHeader, "mvg_imagePath", sampleFrame);
-
-      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_viewId"))
+      try
       {
-        try
-        {
-          viewId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_viewId", sampleFrame);
-        }
-        catch(Alembic::Util::Exception&)
-        {
-          viewId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_viewId", sampleFrame);
-        }
+        viewId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_viewId", sampleFrame);
       }
-      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_poseId"))
+      catch(Alembic::Util::Exception&)
       {
-        try
-        {
-          poseId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_poseId", sampleFrame);
-        }
-        catch(Alembic::Util::Exception&)
-        {
-          poseId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_poseId", sampleFrame);
-        }
+        viewId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_viewId", sampleFrame);
       }
-      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_intrinsicId"))
+    }
+    if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_poseId"))
+    {
+      try
       {
-        try
-        {
-          intrinsicId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_intrinsicId", sampleFrame);
-        }
-        catch(Alembic::Util::Exception&)
-        {
-          intrinsicId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_intrinsicId", sampleFrame);
-        }
+        poseId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_poseId", sampleFrame);
       }
-      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_rigId"))
+      catch(Alembic::Util::Exception&)
       {
-        try
-        {
-          rigId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_rigId", sampleFrame);
-        }
-        catch(Alembic::Util::Exception&)
-        {
-          rigId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_rigId", sampleFrame);
-        }
+        poseId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_poseId", sampleFrame);
       }
-      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_subPoseId"))
+    }
+    if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_intrinsicId"))
+    {
+      try
       {
-        try
-        {
-          subPoseId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_subPoseId", sampleFrame);
-        }
-        catch(Alembic::Util::Exception&)
-        {
-          subPoseId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_subPoseId", sampleFrame);
-        }
+        intrinsicId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_intrinsicId", sampleFrame);
       }
+      catch(Alembic::Util::Exception&)
+      {
+        intrinsicId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_intrinsicId", sampleFrame);
+      }
+    }
+    if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_rigId"))
+    {
+      try
+      {
+        rigId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_rigId", sampleFrame);
+      }
+      catch(Alembic::Util::Exception&)
+      {
+        rigId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_rigId", sampleFrame);
+      }
+    }
+    if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_subPoseId"))
+    {
+      try
+      {
+        subPoseId = getAbcProp<Alembic::Abc::IUInt32Property>(userProps, *propHeader, "mvg_subPoseId", sampleFrame);
+      }
+      catch(Alembic::Util::Exception&)
+      {
+        subPoseId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_subPoseId", sampleFrame);
+      }
+    }
+    if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_poseLocked"))
+    {
+      poseLocked = getAbcProp<Alembic::Abc::IBoolProperty>(userProps, *propHeader, "mvg_poseLocked", sampleFrame);
+    }
+
+    if(flagsPart & ESfMData::VIEWS)
+    {
+      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_imagePath"))
+        imagePath = getAbcProp<Alembic::Abc::IStringProperty>(userProps, *propHeader, "mvg_imagePath", sampleFrame);
+
       if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_frameId"))
       {
         try
@@ -395,23 +409,19 @@ bool readCamera(const ICamera& camera, const M44d& mat, sfmData::SfMData& sfmDat
           resectionId = getAbcProp<Alembic::Abc::IInt32Property>(userProps, *propHeader, "mvg_resectionId", sampleFrame);
         }
       }
-      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_intrinsicLocked"))
-      {
-        intrinsicLocked = getAbcProp<Alembic::Abc::IBoolProperty>(userProps, *propHeader, "mvg_intrinsicLocked", sampleFrame);
-      }
-      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_poseLocked"))
-      {
-        poseLocked = getAbcProp<Alembic::Abc::IBoolProperty>(userProps, *propHeader, "mvg_poseLocked", sampleFrame);
-      }
       if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_poseIndependant"))
       {
         poseIndependant = getAbcProp<Alembic::Abc::IBoolProperty>(userProps, *propHeader, "mvg_poseIndependant", sampleFrame);
       }
-      if(userProps.getPropertyHeader("mvg_sensorSizePix"))
+      if(userProps.getPropertyHeader("mvg_metadata"))
       {
         getAbcArrayProp<Alembic::Abc::IStringArrayProperty>(userProps, "mvg_metadata", sampleFrame, rawMetadata);
         assert(rawMetadata.size() % 2 == 0);
       }
+    }
+
+    if(flagsPart & ESfMData::VIEWS || flagsPart & ESfMData::INTRINSICS)
+    {
       if(userProps.getPropertyHeader("mvg_sensorSizePix"))
       {
         try
@@ -424,6 +434,14 @@ bool readCamera(const ICamera& camera, const M44d& mat, sfmData::SfMData& sfmDat
         }
         assert(sensorSize_pix.size() == 2);
       }
+    }
+
+    if(flagsPart & ESfMData::INTRINSICS)
+    {
+      if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_intrinsicLocked"))
+      {
+        intrinsicLocked = getAbcProp<Alembic::Abc::IBoolProperty>(userProps, *propHeader, "mvg_intrinsicLocked", sampleFrame);
+      }
       if(const Alembic::Abc::PropertyHeader *propHeader = userProps.getPropertyHeader("mvg_intrinsicType"))
       {
         mvg_intrinsicType = getAbcProp<Alembic::Abc::IStringProperty>(userProps, *propHeader, "mvg_intrinsicType", sampleFrame);
@@ -657,13 +675,35 @@ bool readXform(IXform& xform, M44d& mat, sfmData::SfMData& sfmData, ESfMData fla
   return true;
 }
 
+/**
+ * @brief Check if a subtree of the MVG hierarchy contains some of the requested parts
+ * @param[in] iObj the root of the subtree
+ * @param[in] flagsPart the requested parts
+ * @return false if the subtree can be skipped
+ */
+bool isSubtreeNeeded(const IObject& iObj, ESfMData flagsPart)
+{
+  const std::string& name = iObj.getName();
+
+  if(name == "mvgCloud")
+    return (flagsPart & ESfMData::STRUCTURE);
+
+  if(name == "mvgCameras" || name == "mvgCamerasUndefined")
+    return (flagsPart & (ESfMData::VIEWS | ESfMData::INTRINSICS | ESfMData::EXTRINSICS));
+
+  return true;
+}
+
 // Top down read of 3d objects
 void visitObject(IObject iObj, M44d mat, sfmData::SfMData& sfmdata, ESfMData flagsPart, bool isReconstructed = true)
 {
   // ALICEVISION_LOG_DEBUG("ABC visit: " << iObj.getFullName());
+  if(!isSubtreeNeeded(iObj, flagsPart))
+    return;
+
   if(iObj.getName() == "mvgCamerasUndefined")
     isReconstructed = false;
-  
+
   const MetaData& md = iObj.getMetaData();
   if(IPoints::matches(md) && (flagsPart & ESfMData::STRUCTURE))
   {
@@ -693,18 +733,164 @@ void visitObject(IObject iObj, M44d mat, sfmData::SfMData& sfmdata, ESfMData fla
   }
 }
 
-struct AlembicImporter::DataImpl
+/// an independent subtree of the MVG hierarchy, it can be read with its own archive reader
+struct AbcSubtree
 {
-  DataImpl(const std::string& filename)
+  AbcSubtree(const std::string& fullName, const M44d& mat, bool isReconstructed)
+    : fullName(fullName)
+    , mat(mat)
+    , isReconstructed(isReconstructed)
+  {}
+
+  std::string fullName;
+  M44d mat;
+  bool isReconstructed;
+};
+
+IArchive openArchive(const std::string& filename)
+{
+  Alembic::AbcCoreFactory::IFactory factory;
+  Alembic::AbcCoreFactory::IFactory::CoreType coreType;
+  IArchive archive = factory.getArchive(filename, coreType);
+
+  if(!archive.valid())
+    throw std::runtime_error("Can't open '" + filename + "' : Alembic file is not valid.");
+
+  return archive;
+}
+
+IObject getObject(IArchive& archive, const std::string& fullName)
+{
+  IObject iObj = archive.getTop();
+  std::istringstream ss(fullName);
+  std::string name;
+
+  while(std::getline(ss, name, '/'))
+  {
+    if(!name.empty())
+      iObj = iObj.getChild(name);
+  }
+  return iObj;
+}
+
+M44d getXformMatrix(const IObject& iObj)
+{
+  M44d mat;
+
+  if(IXform::matches(iObj.getMetaData()))
+  {
+    IXform xform(iObj, kWrapExisting);
+    XformSample xsample;
+    xform.getSchema().get(xsample);
+    mat = xsample.getMatrix();
+  }
+  return mat;
+}
+
+/**
+ * @brief List the independent subtrees of the MVG hierarchy needed by the requested parts:
+ *        each camera (or rig) and the point cloud.
+ * @param[in] topObj the top object of the archive
+ * @param[in] flagsPart the requested parts
+ * @param[out] subtrees the independent subtrees
+ * @return false if the hierarchy must be read sequentially: unknown layout, animated cameras
+ *         or ids given by the reading order in files without version
+ */
+bool getIndependentSubtrees(const IObject& topObj, ESfMData flagsPart, std::vector<AbcSubtree>& subtrees)
+{
+  if(topObj.getNumChildren() != 1)
+    return false;
+
+  const IObject rootObj = topObj.getChild("mvgRoot");
+
+  if(!rootObj.valid() || !rootObj.getProperties().getPropertyHeader("mvg_ABC_version"))
+    return false;
+
+  const M44d rootMat = getXformMatrix(rootObj);
+
+  for(std::size_t i = 0; i < rootObj.getNumChildren(); ++i)
+  {
+    const IObject groupObj = rootObj.getChild(i);
+    const std::string& groupName = groupObj.getName();
+
+    if(groupName != "mvgCameras" && groupName != "mvgCamerasUndefined" && groupName != "mvgCloud")
+      return false;
+
+    if(!isSubtreeNeeded(groupObj, flagsPart))
+      continue;
+
+    if(groupName == "mvgCloud")
+    {
+      subtrees.emplace_back(groupObj.getFullName(), rootMat, true);
+      continue;
+    }
+
+    const M44d groupMat = rootMat * getXformMatrix(groupObj);
+    const bool isReconstructed = (groupName == "mvgCameras");
+
+    for(std::size_t j = 0; j < groupObj.getNumChildren(); ++j)
+    {
+      const IObject cameraObj = groupObj.getChild(j);
+
+      // animated cameras ids are given by the reading order
+      if(IXform::matches(cameraObj.getMetaData()) &&
+         IXform(cameraObj, kWrapExisting).getSchema().getNumSamples() != 1)
+        return false;
+
+      subtrees.emplace_back(cameraObj.getFullName(), groupMat, isReconstructed);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Merge the data read from an independent subtree
+ * @param[in,out] sfmData the output SfMData
+ * @param[in,out] subtreeData the data of the subtree (moved)
+ */
+void mergeSubtreeData(sfmData::SfMData& sfmData, sfmData::SfMData& subtreeData)
+{
+  for(auto& viewPair : subtreeData.getViews())
+    sfmData.getViews()[viewPair.first] = viewPair.second;
+
+  for(auto& intrinsicPair : subtreeData.getIntrinsics())
+    sfmData.getIntrinsics()[intrinsicPair.first] = intrinsicPair.second;
+
+  for(auto& posePair : subtreeData.getPoses())
+    sfmData.getPoses()[posePair.first] = posePair.second;
+
+  for(auto& rigPair : subtreeData.getRigs())
   {
-    Alembic::AbcCoreFactory::IFactory factory;
-    Alembic::AbcCoreFactory::IFactory::CoreType coreType;
-    Abc::IArchive archive = factory.getArchive(filename, coreType);
+    auto rigIt = sfmData.getRigs().find(rigPair.first);
+
+    if(rigIt == sfmData.getRigs().end())
+    {
+      sfmData.getRigs().emplace(rigPair.first, rigPair.second);
+      continue;
+    }
+
+    // a rig can be split between the reconstructed and the undefined cameras
+    for(IndexT subPoseId = 0; subPoseId < rigPair.second.getNbSubPoses(); ++subPoseId)
+    {
+      const sfmData::RigSubPose& subPose = rigPair.second.getSubPose(subPoseId);
+      sfmData::RigSubPose& mergedSubPose = rigIt->second.getSubPose(subPoseId);
 
-    if(!archive.valid())
-      throw std::runtime_error("Can't open '" + filename + "' : Alembic file is not valid.");
+      if(mergedSubPose.status == sfmData::ERigSubPoseStatus::UNINITIALIZED)
+        mergedSubPose = subPose;
+    }
+  }
 
-    _rootEntity = archive.getTop();
+  // the landmarks ids follow the reading order
+  const std::size_t nbPointsInit = sfmData.structure.size();
+  for(auto& landmarkPair : subtreeData.getLandmarks())
+    sfmData.structure[nbPointsInit + landmarkPair.first] = std::move(landmarkPair.second);
+}
+
+struct AlembicImporter::DataImpl
+{
+  DataImpl(const std::string& filename)
+  {
+    _rootEntity = openArchive(filename).getTop();
     _filename = filename;
   }
   
@@ -756,9 +942,49 @@ void AlembicImporter::populateSfM(sfmData::SfMData& sfmdata, ESfMData flagsPart)
     sfmdata.addMatchesFolder(matchesFolder);
   }
 
-  // TODO : handle the case where the archive wasn't correctly opened
-  M44d xformMat;
-  visitObject(_dataImpl->_rootEntity, xformMat, sfmdata, flagsPart);
+  std::vector<AbcSubtree> subtrees;
+
+  if(!getIndependentSubtrees(_dataImpl->_rootEntity, flagsPart, subtrees))
+  {
+    // TODO : handle the case where the archive wasn't correctly opened
+    M44d xformMat;
+    visitObject(_dataImpl->_rootEntity, xformMat, sfmdata, flagsPart);
+    return;
+  }
+
+  // an archive reader can't be shared between threads, each thread opens its own reader
+  std::vector<IArchive> archives(omp_get_max_threads());
+  archives.front() = _dataImpl->_rootEntity.getArchive();
+
+  std::vector<sfmData::SfMData> subtreesData(subtrees.size());
+  std::string error;
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(subtrees.size()); ++i)
+  {
+    const AbcSubtree& subtree = subtrees.at(i);
+
+    try
+    {
+      IArchive& archive = archives.at(omp_get_thread_num());
+
+      if(!archive.valid())
+        archive = openArchive(_dataImpl->_filename);
+
+      visitObject(getObject(archive, subtree.fullName), subtree.mat, subtreesData.at(i), flagsPart, subtree.isReconstructed);
+    }
+    catch(const std::exception& e)
+    {
+      #pragma omp critical
+      error = e.what();
+    }
+  }
+
+  if(!error.empty())
+    throw std::runtime_error("Can't read '" + _dataImpl->_filename + "' : " + error);
+
+  for(sfmData::SfMData& subtreeData : subtreesData)
+    mergeSubtreeData(sfmdata, subtreeData);
 
   // TODO: fusion of common intrinsics
 }
@@ -0,0 +1,158 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ImageMetadataCache.hpp"
+
+#include <aliceVision/image/io.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <fstream>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace fs = boost::filesystem;
+namespace bpt = boost::property_tree;
+
+ImageMetadataCache::ImageMetadataCache(const std::string& filePath)
+  : _filePath(filePath)
+{
+  if(!fs::is_regular_file(_filePath))
+    return;
+
+  try
+  {
+    bpt::ptree fileTree;
+    bpt::read_json(_filePath, fileTree);
+
+    for(const bpt::ptree::value_type& entryNode : fileTree.get_child("images"))
+    {
+      const bpt::ptree& entryTree = entryNode.second;
+      Entry entry;
+
+      entry.lastWriteTime = entryTree.get<std::time_t>("lastWriteTime");
+      entry.fileSize = entryTree.get<std::uintmax_t>("fileSize");
+      entry.width = entryTree.get<int>("width");
+      entry.height = entryTree.get<int>("height");
+
+      if(entryTree.count("metadata"))
+        for(const bpt::ptree::value_type& metadataNode : entryTree.get_child("metadata"))
+          entry.metadata.emplace(metadataNode.first, metadataNode.second.data());
+
+      _entries.emplace(entryTree.get<std::string>("path"), entry);
+    }
+  }
+  catch(std::exception& e)
+  {
+    // the metadata is read again from the image files
+    ALICEVISION_LOG_WARNING("Cannot load the image metadata cache '" << _filePath << "', it will be rebuilt." << std::endl << e.what());
+    _entries.clear();
+  }
+
+  ALICEVISION_LOG_INFO("Image metadata cache '" << _filePath << "' loaded: " << _entries.size() << " image(s).");
+}
+
+void ImageMetadataCache::readImageMetadata(const std::string& imagePath, int& width, int& height, std::map<std::string, std::string>& metadata)
+{
+  const std::time_t lastWriteTime = fs::last_write_time(imagePath);
+  const std::uintmax_t fileSize = fs::file_size(imagePath);
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto entryIt = _entries.find(imagePath);
+
+    if(entryIt != _entries.end() &&
+       entryIt->second.lastWriteTime == lastWriteTime &&
+       entryIt->second.fileSize == fileSize)
+    {
+      width = entryIt->second.width;
+      height = entryIt->second.height;
+      metadata = entryIt->second.metadata;
+      ++_nbCachedReads;
+      return;
+    }
+  }
+
+  // read the image file outside of the lock
+  Entry entry;
+  entry.lastWriteTime = lastWriteTime;
+  entry.fileSize = fileSize;
+  image::readImageMetadata(imagePath, entry.width, entry.height, entry.metadata);
+
+  width = entry.width;
+  height = entry.height;
+  metadata = entry.metadata;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries[imagePath] = std::move(entry);
+  ++_nbFileReads;
+}
+
+void ImageMetadataCache::save() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if(_nbFileReads == 0 && fs::is_regular_file(_filePath))
+    return; // nothing new
+
+  bpt::ptree imagesTree;
+
+  for(const auto& entryPair : _entries)
+  {
+    const Entry& entry = entryPair.second;
+    bpt::ptree entryTree;
+
+    entryTree.put("path", entryPair.first);
+    entryTree.put("lastWriteTime", entry.lastWriteTime);
+    entryTree.put("fileSize", entry.fileSize);
+    entryTree.put("width", entry.width);
+    entryTree.put("height", entry.height);
+
+    bpt::ptree metadataTree;
+    for(const auto& metadataPair : entry.metadata)
+      metadataTree.put(bpt::ptree::path_type(metadataPair.first, '\0'), metadataPair.second); // keys may contain dots
+    entryTree.add_child("metadata", metadataTree);
+
+    imagesTree.push_back(std::make_pair("", entryTree));
+  }
+
+  bpt::ptree fileTree;
+  fileTree.add_child("images", imagesTree);
+
+  // write in a temporary file, a concurrent reader never sees a partial cache
+  const fs::path bPath(_filePath);
+  const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+  {
+    std::ofstream stream(tmpPath);
+    if(!stream.is_open())
+      throw std::runtime_error("Cannot write the image metadata cache '" + _filePath + "'.");
+    bpt::write_json(stream, fileTree);
+  }
+
+  fs::rename(tmpPath, _filePath);
+  ALICEVISION_LOG_INFO("Image metadata cache '" << _filePath << "' saved: " << _entries.size() << " image(s).");
+}
+
+std::size_t ImageMetadataCache::getNbCachedReads() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbCachedReads;
+}
+
+std::size_t ImageMetadataCache::getNbFileReads() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _nbFileReads;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
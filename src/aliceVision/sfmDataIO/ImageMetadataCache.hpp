@@ -0,0 +1,84 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+/**
+ * @brief Persistent cache of the image metadata
+ *
+ * The metadata of an image is read again only if the image file
+ * last write time or size has changed since it was cached.
+ * @note readImageMetadata() is thread safe
+ */
+class ImageMetadataCache
+{
+public:
+
+  /**
+   * @brief Load the cache file, if it exists
+   * @param[in] filePath The cache JSON file path
+   */
+  explicit ImageMetadataCache(const std::string& filePath);
+
+  /**
+   * @brief Get the size and the metadata of an image, from the cache or from the image file
+   * @param[in] imagePath The image path
+   * @param[out] width The image width
+   * @param[out] height The image height
+   * @param[out] metadata The image metadata
+   */
+  void readImageMetadata(const std::string& imagePath, int& width, int& height, std::map<std::string, std::string>& metadata);
+
+  /**
+   * @brief Save the cache file, if new metadata has been read
+   */
+  void save() const;
+
+  /**
+   * @brief Get the number of images found in the cache
+   * @return number of images
+   */
+  std::size_t getNbCachedReads() const;
+
+  /**
+   * @brief Get the number of images read from their file
+   * @return number of images
+   */
+  std::size_t getNbFileReads() const;
+
+private:
+
+  /// Cached metadata of an image file
+  struct Entry
+  {
+    std::time_t lastWriteTime = 0;
+    std::uintmax_t fileSize = 0;
+    int width = 0;
+    int height = 0;
+    std::map<std::string, std::string> metadata;
+  };
+
+  /// The cache JSON file path
+  std::string _filePath;
+  /// The cached metadata by image path
+  std::unordered_map<std::string, Entry> _entries;
+  std::size_t _nbCachedReads = 0;
+  std::size_t _nbFileReads = 0;
+  mutable std::mutex _mutex;
+};
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -272,3 +272,48 @@ BOOST_AUTO_TEST_CASE(AlembicImporter_importExport) {
     }
 
 }
+
+//-----------------
+// - Create a random scene
+// - Export to Alembic
+// - Import only some parts from Alembic
+//-----------------
+BOOST_AUTO_TEST_CASE(AlembicImporter_importParts) {
+
+    const SfMData sfmData = createTestScene(5, 50, 2, 3, true);
+
+    const std::string abcFile = "importParts.abc";
+    BOOST_CHECK(Save(sfmData, abcFile, ESfMData(ALL)));
+
+    // cameras only: the landmarks are skipped
+    SfMData sfmCameras;
+    {
+        BOOST_CHECK(Load(sfmCameras, abcFile, ESfMData(VIEWS|INTRINSICS|EXTRINSICS)));
+        BOOST_CHECK_EQUAL( sfmData.views.size(), sfmCameras.views.size());
+        BOOST_CHECK_EQUAL( sfmData.getPoses().size(), sfmCameras.getPoses().size());
+        BOOST_CHECK_EQUAL( sfmData.getRigs().size(), sfmCameras.getRigs().size());
+        BOOST_CHECK_EQUAL( sfmData.intrinsics.size(), sfmCameras.intrinsics.size());
+        BOOST_CHECK( sfmCameras.structure.empty());
+    }
+
+    // extrinsics only: the poses keep their ids
+    SfMData sfmExtrinsics;
+    {
+        BOOST_CHECK(Load(sfmExtrinsics, abcFile, ESfMData(EXTRINSICS)));
+        BOOST_CHECK( sfmExtrinsics.views.empty());
+        BOOST_CHECK_EQUAL( sfmData.getPoses().size(), sfmExtrinsics.getPoses().size());
+        for(const auto& posePair : sfmData.getPoses())
+          BOOST_CHECK( sfmExtrinsics.getPoses().count(posePair.first));
+    }
+
+    // structure only: the cameras are skipped
+    SfMData sfmStructure;
+    {
+        BOOST_CHECK(Load(sfmStructure, abcFile, ESfMData(STRUCTURE)));
+        BOOST_CHECK( sfmStructure.views.empty());
+        BOOST_CHECK( sfmStructure.getPoses().empty());
+        BOOST_CHECK_EQUAL( sfmData.structure.size(), sfmStructure.structure.size());
+        for(const auto& landmarkPair : sfmStructure.structure)
+          BOOST_CHECK( landmarkPair.second.observations.empty());
+    }
+}
@@ -0,0 +1,593 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "binaryIO.hpp"
+#include <aliceVision/sfmDataIO/jsonIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/streams/bufferstream.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+namespace bi = boost::interprocess;
+
+namespace {
+
+const char binaryMagic[8] = {'A', 'V', 'S', 'F', 'M', 'B', '\0', '\0'};
+const std::uint32_t binaryVersion = 1;
+
+enum class ESection : std::uint32_t
+{
+  FOLDERS = 0,
+  VIEWS,
+  INTRINSICS,
+  POSES,
+  RIGS,
+  STRUCTURE,
+  OBSERVATIONS,
+  CONTROL_POINTS
+};
+
+struct SectionIndex
+{
+  std::uint32_t type;
+  std::uint32_t nbElements;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+const std::size_t headerSize = sizeof(binaryMagic) + 2 * sizeof(std::uint32_t);
+const std::size_t sectionIndexSize = 2 * sizeof(std::uint32_t) + 2 * sizeof(std::uint64_t);
+
+template<typename T>
+inline void writeValue(std::ostream& stream, const T& value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/**
+ * @brief Sequential reader of the values of a memory block.
+ */
+class BinaryReader
+{
+public:
+  BinaryReader(const char* data, std::size_t size)
+    : _data(data)
+    , _end(data + size)
+  {}
+
+  inline bool canRead(std::size_t size) const
+  {
+    return static_cast<std::size_t>(_end - _data) >= size;
+  }
+
+  template<typename T>
+  inline void read(T& value)
+  {
+    std::memcpy(&value, _data, sizeof(T));
+    _data += sizeof(T);
+  }
+
+private:
+  const char* _data;
+  const char* _end;
+};
+
+void writeTree(std::ostream& stream, const bpt::ptree& tree)
+{
+  bpt::write_json(stream, tree, false);
+}
+
+void readTree(const char* data, std::size_t size, bpt::ptree& tree)
+{
+  bi::ibufferstream stream(data, size);
+  bpt::read_json(stream, tree);
+}
+
+void saveFoldersTree(const sfmData::SfMData& sfmData, bpt::ptree& fileTree)
+{
+  bpt::ptree featureFoldersTree;
+  for(const std::string& featuresFolder : sfmData.getRelativeFeaturesFolders())
+  {
+    bpt::ptree featureFolderTree;
+    featureFolderTree.put("", featuresFolder);
+    featureFoldersTree.push_back(std::make_pair("", featureFolderTree));
+  }
+  fileTree.add_child("featuresFolders", featureFoldersTree);
+
+  bpt::ptree matchingFoldersTree;
+  for(const std::string& matchesFolder : sfmData.getRelativeMatchesFolders())
+  {
+    bpt::ptree matchingFolderTree;
+    matchingFolderTree.put("", matchesFolder);
+    matchingFoldersTree.push_back(std::make_pair("", matchingFolderTree));
+  }
+  fileTree.add_child("matchesFolders", matchingFoldersTree);
+}
+
+void writePoses(std::ostream& stream, const sfmData::Poses& poses)
+{
+  for(const auto& posePair : poses)
+  {
+    const geometry::Pose3& transform = posePair.second.getTransform();
+    writeValue(stream, static_cast<std::uint32_t>(posePair.first));
+    writeValue(stream, static_cast<std::uint32_t>(posePair.second.isLocked()));
+    stream.write(reinterpret_cast<const char*>(Mat3(transform.rotation()).data()), 9 * sizeof(double));
+    stream.write(reinterpret_cast<const char*>(Vec3(transform.center()).data()), 3 * sizeof(double));
+  }
+}
+
+void writeStructure(std::ostream& stream, const sfmData::Landmarks& landmarks, bool saveObservations)
+{
+  for(const auto& landmarkPair : landmarks)
+  {
+    const sfmData::Landmark& landmark = landmarkPair.second;
+    const std::uint8_t rgb[4] = {landmark.rgb.r(), landmark.rgb.g(), landmark.rgb.b(), 0};
+
+    writeValue(stream, static_cast<std::uint32_t>(landmarkPair.first));
+    writeValue(stream, static_cast<std::int32_t>(landmark.descType));
+    writeValue(stream, static_cast<std::uint32_t>(saveObservations ? landmark.observations.size() : 0));
+    stream.write(reinterpret_cast<const char*>(rgb), sizeof(rgb));
+    stream.write(reinterpret_cast<const char*>(Vec3(landmark.X).data()), 3 * sizeof(double));
+  }
+}
+
+void writeObservations(std::ostream& stream, const sfmData::Landmarks& landmarks, bool saveFeatures)
+{
+  for(const auto& landmarkPair : landmarks)
+  {
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const sfmData::Observation& observation = observationPair.second;
+      const Vec2 x = saveFeatures ? Vec2(observation.x) : Vec2::Zero();
+
+      writeValue(stream, static_cast<std::uint32_t>(observationPair.first));
+      writeValue(stream, static_cast<std::uint32_t>(saveFeatures ? observation.id_feat : UndefinedIndexT));
+      stream.write(reinterpret_cast<const char*>(x.data()), 2 * sizeof(double));
+    }
+  }
+}
+
+bool readPoses(BinaryReader& reader, std::size_t nbPoses, sfmData::Poses& poses)
+{
+  const std::size_t recordSize = 2 * sizeof(std::uint32_t) + 12 * sizeof(double);
+
+  if(!reader.canRead(nbPoses * recordSize))
+    return false;
+
+  for(std::size_t i = 0; i < nbPoses; ++i)
+  {
+    std::uint32_t poseId;
+    std::uint32_t locked;
+    Mat3 rotation;
+    Vec3 center;
+
+    reader.read(poseId);
+    reader.read(locked);
+    for(int k = 0; k < 9; ++k)
+      reader.read(rotation.data()[k]);
+    for(int k = 0; k < 3; ++k)
+      reader.read(center.data()[k]);
+
+    poses.emplace(poseId, sfmData::CameraPose(geometry::Pose3(rotation, center), locked != 0));
+  }
+  return true;
+}
+
+bool readStructure(BinaryReader& reader, std::size_t nbLandmarks, BinaryReader* observationsReader, bool loadFeatures, sfmData::Landmarks& landmarks)
+{
+  const std::size_t recordSize = 3 * sizeof(std::uint32_t) + 4 * sizeof(std::uint8_t) + 3 * sizeof(double);
+  const std::size_t observationRecordSize = 2 * sizeof(std::uint32_t) + 2 * sizeof(double);
+
+  if(!reader.canRead(nbLandmarks * recordSize))
+    return false;
+
+  for(std::size_t i = 0; i < nbLandmarks; ++i)
+  {
+    std::uint32_t landmarkId;
+    std::int32_t descType;
+    std::uint32_t nbObservations;
+    std::uint8_t rgb[4];
+    Vec3 X;
+
+    reader.read(landmarkId);
+    reader.read(descType);
+    reader.read(nbObservations);
+    for(int k = 0; k < 4; ++k)
+      reader.read(rgb[k]);
+    for(int k = 0; k < 3; ++k)
+      reader.read(X.data()[k]);
+
+    sfmData::Landmark& landmark = landmarks[landmarkId];
+    landmark.X = X;
+    landmark.descType = static_cast<feature::EImageDescriberType>(descType);
+    landmark.rgb = image::RGBColor(rgb[0], rgb[1], rgb[2]);
+
+    if(observationsReader == nullptr)
+      continue;
+
+    if(!observationsReader->canRead(nbObservations * observationRecordSize))
+      return false;
+
+    // the observations are saved sorted by view id
+    landmark.observations.reserve(nbObservations);
+    for(std::size_t k = 0; k < nbObservations; ++k)
+    {
+      std::uint32_t viewId;
+      std::uint32_t featureId;
+      Vec2 x;
+
+      observationsReader->read(viewId);
+      observationsReader->read(featureId);
+      observationsReader->read(x.data()[0]);
+      observationsReader->read(x.data()[1]);
+
+      sfmData::Observation observation;
+      if(loadFeatures)
+        observation = sfmData::Observation(x, featureId);
+
+      landmark.observations.emplace_hint(landmark.observations.end(), viewId, observation);
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // save flags
+  const bool saveViews = (partFlag & VIEWS) == VIEWS;
+  const bool saveIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool saveExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool saveStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool saveControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+  const bool saveFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
+  const bool saveObservations = saveFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
+
+  // sections to write: <type, #elements, writer>
+  using SectionWriter = std::function<void(std::ostream&)>;
+  std::vector<std::tuple<ESection, std::size_t, SectionWriter>> sections;
+
+  sections.emplace_back(ESection::FOLDERS, 1, [&](std::ostream& stream) {
+    bpt::ptree fileTree;
+    saveFoldersTree(sfmData, fileTree);
+    writeTree(stream, fileTree);
+  });
+
+  if(saveViews && !sfmData.getViews().empty())
+  {
+    sections.emplace_back(ESection::VIEWS, sfmData.getViews().size(), [&](std::ostream& stream) {
+      bpt::ptree viewsTree;
+      for(const auto& viewPair : sfmData.getViews())
+        saveView("", *(viewPair.second), viewsTree);
+      bpt::ptree fileTree;
+      fileTree.add_child("views", viewsTree);
+      writeTree(stream, fileTree);
+    });
+  }
+
+  if(saveIntrinsics && !sfmData.getIntrinsics().empty())
+  {
+    sections.emplace_back(ESection::INTRINSICS, sfmData.getIntrinsics().size(), [&](std::ostream& stream) {
+      bpt::ptree intrinsicsTree;
+      for(const auto& intrinsicPair : sfmData.getIntrinsics())
+        saveIntrinsic("", intrinsicPair.first, intrinsicPair.second, intrinsicsTree);
+      bpt::ptree fileTree;
+      fileTree.add_child("intrinsics", intrinsicsTree);
+      writeTree(stream, fileTree);
+    });
+  }
+
+  if(saveExtrinsics && !sfmData.getPoses().empty())
+  {
+    sections.emplace_back(ESection::POSES, sfmData.getPoses().size(), [&](std::ostream& stream) {
+      writePoses(stream, sfmData.getPoses());
+    });
+  }
+
+  if(saveExtrinsics && !sfmData.getRigs().empty())
+  {
+    sections.emplace_back(ESection::RIGS, sfmData.getRigs().size(), [&](std::ostream& stream) {
+      bpt::ptree rigsTree;
+      for(const auto& rigPair : sfmData.getRigs())
+        saveRig("", rigPair.first, rigPair.second, rigsTree);
+      bpt::ptree fileTree;
+      fileTree.add_child("rigs", rigsTree);
+      writeTree(stream, fileTree);
+    });
+  }
+
+  if(saveStructure && !sfmData.getLandmarks().empty())
+  {
+    sections.emplace_back(ESection::STRUCTURE, sfmData.getLandmarks().size(), [&](std::ostream& stream) {
+      writeStructure(stream, sfmData.getLandmarks(), saveObservations);
+    });
+
+    if(saveObservations)
+    {
+      std::size_t nbObservations = 0;
+      for(const auto& landmarkPair : sfmData.getLandmarks())
+        nbObservations += landmarkPair.second.observations.size();
+
+      sections.emplace_back(ESection::OBSERVATIONS, nbObservations, [&](std::ostream& stream) {
+        writeObservations(stream, sfmData.getLandmarks(), saveFeatures);
+      });
+    }
+  }
+
+  if(saveControlPoints && !sfmData.getControlPoints().empty())
+  {
+    sections.emplace_back(ESection::CONTROL_POINTS, sfmData.getControlPoints().size(), [&](std::ostream& stream) {
+      bpt::ptree controlPointTree;
+      for(const auto& controlPointPair : sfmData.getControlPoints())
+        saveLandmark("", controlPointPair.first, controlPointPair.second, controlPointTree);
+      bpt::ptree fileTree;
+      fileTree.add_child("controlPoints", controlPointTree);
+      writeTree(stream, fileTree);
+    });
+  }
+
+  std::ofstream stream(filename, std::ios::out | std::ios::binary);
+  if(!stream.is_open())
+  {
+    ALICEVISION_LOG_ERROR("Cannot open the binary SfMData file: " << filename);
+    return false;
+  }
+
+  // header
+  stream.write(binaryMagic, sizeof(binaryMagic));
+  writeValue(stream, binaryVersion);
+  writeValue(stream, static_cast<std::uint32_t>(sections.size()));
+
+  // index placeholder, written once the sections are known
+  const std::vector<char> emptyIndex(sections.size() * sectionIndexSize, 0);
+  stream.write(emptyIndex.data(), emptyIndex.size());
+
+  // sections
+  std::vector<SectionIndex> index;
+  index.reserve(sections.size());
+  for(const auto& section : sections)
+  {
+    SectionIndex sectionIndex;
+    sectionIndex.type = static_cast<std::uint32_t>(std::get<0>(section));
+    sectionIndex.nbElements = static_cast<std::uint32_t>(std::get<1>(section));
+    sectionIndex.offset = static_cast<std::uint64_t>(stream.tellp());
+    std::get<2>(section)(stream);
+    sectionIndex.size = static_cast<std::uint64_t>(stream.tellp()) - sectionIndex.offset;
+    index.push_back(sectionIndex);
+  }
+
+  // index
+  stream.seekp(headerSize);
+  for(const SectionIndex& sectionIndex : index)
+  {
+    writeValue(stream, sectionIndex.type);
+    writeValue(stream, sectionIndex.nbElements);
+    writeValue(stream, sectionIndex.offset);
+    writeValue(stream, sectionIndex.size);
+  }
+
+  return stream.good();
+}
+
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
+{
+  // load flags
+  const bool loadViews = (partFlag & VIEWS) == VIEWS;
+  const bool loadIntrinsics = (partFlag & INTRINSICS) == INTRINSICS;
+  const bool loadExtrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
+  const bool loadStructure = (partFlag & STRUCTURE) == STRUCTURE;
+  const bool loadControlPoints = (partFlag & CONTROL_POINTS) == CONTROL_POINTS;
+  const bool loadFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
+  const bool loadObservations = loadFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
+
+  // read-only memory mapping of the file, only the pages of the loaded sections are read
+  bi::file_mapping file;
+  bi::mapped_region region;
+  try
+  {
+    file = bi::file_mapping(filename.c_str(), bi::read_only);
+    region = bi::mapped_region(file, bi::read_only);
+  }
+  catch(const bi::interprocess_exception& e)
+  {
+    ALICEVISION_LOG_ERROR("Cannot map the binary SfMData file: " << filename << std::endl << e.what());
+    return false;
+  }
+
+  const char* data = static_cast<const char*>(region.get_address());
+  const std::size_t dataSize = region.get_size();
+
+  // header
+  BinaryReader headerReader(data, dataSize);
+  if(!headerReader.canRead(headerSize) || std::memcmp(data, binaryMagic, sizeof(binaryMagic)) != 0)
+  {
+    ALICEVISION_LOG_ERROR("Invalid binary SfMData file: " << filename);
+    return false;
+  }
+
+  char magic[sizeof(binaryMagic)];
+  std::uint32_t version;
+  std::uint32_t nbSections;
+  headerReader.read(magic);
+  headerReader.read(version);
+  headerReader.read(nbSections);
+
+  if(version != binaryVersion)
+  {
+    ALICEVISION_LOG_ERROR("Unsupported binary SfMData file version " << version << ": " << filename);
+    return false;
+  }
+
+  if(!headerReader.canRead(nbSections * sectionIndexSize))
+  {
+    ALICEVISION_LOG_ERROR("Invalid binary SfMData file index: " << filename);
+    return false;
+  }
+
+  // index
+  std::map<ESection, SectionIndex> index;
+  for(std::uint32_t i = 0; i < nbSections; ++i)
+  {
+    SectionIndex sectionIndex;
+    headerReader.read(sectionIndex.type);
+    headerReader.read(sectionIndex.nbElements);
+    headerReader.read(sectionIndex.offset);
+    headerReader.read(sectionIndex.size);
+
+    if(sectionIndex.offset > dataSize || sectionIndex.size > dataSize - sectionIndex.offset)
+    {
+      ALICEVISION_LOG_ERROR("Invalid binary SfMData file section " << sectionIndex.type << ": " << filename);
+      return false;
+    }
+    index.emplace(static_cast<ESection>(sectionIndex.type), sectionIndex);
+  }
+
+  const auto hasSection = [&](ESection type) {
+    return index.count(type) > 0;
+  };
+
+  const auto getReader = [&](ESection type) {
+    const SectionIndex& sectionIndex = index.at(type);
+    return BinaryReader(data + sectionIndex.offset, sectionIndex.size);
+  };
+
+  const auto getTree = [&](ESection type, bpt::ptree& tree) {
+    const SectionIndex& sectionIndex = index.at(type);
+    readTree(data + sectionIndex.offset, sectionIndex.size, tree);
+  };
+
+  // folders
+  if(hasSection(ESection::FOLDERS))
+  {
+    bpt::ptree fileTree;
+    getTree(ESection::FOLDERS, fileTree);
+
+    for(bpt::ptree::value_type& featureFolderNode : fileTree.get_child("featuresFolders"))
+      sfmData.addFeaturesFolder(featureFolderNode.second.get_value<std::string>());
+
+    for(bpt::ptree::value_type& matchingFolderNode : fileTree.get_child("matchesFolders"))
+      sfmData.addMatchesFolder(matchingFolderNode.second.get_value<std::string>());
+  }
+
+  // intrinsics
+  if(loadIntrinsics && hasSection(ESection::INTRINSICS))
+  {
+    bpt::ptree fileTree;
+    getTree(ESection::INTRINSICS, fileTree);
+
+    sfmData::Intrinsics& intrinsics = sfmData.getIntrinsics();
+    for(bpt::ptree::value_type& intrinsicNode : fileTree.get_child("intrinsics"))
+    {
+      IndexT intrinsicId;
+      std::shared_ptr<camera::IntrinsicBase> intrinsic;
+
+      loadIntrinsic(intrinsicId, intrinsic, intrinsicNode.second);
+
+      intrinsics.emplace(intrinsicId, intrinsic);
+    }
+  }
+
+  // views
+  if(loadViews && hasSection(ESection::VIEWS))
+  {
+    bpt::ptree fileTree;
+    getTree(ESection::VIEWS, fileTree);
+
+    sfmData::Views& views = sfmData.getViews();
+    for(bpt::ptree::value_type& viewNode : fileTree.get_child("views"))
+    {
+      sfmData::View view;
+      loadView(view, viewNode.second);
+      views.emplace(view.getViewId(), std::make_shared<sfmData::View>(view));
+    }
+  }
+
+  // extrinsics
+  if(loadExtrinsics)
+  {
+    // poses
+    if(hasSection(ESection::POSES))
+    {
+      BinaryReader reader = getReader(ESection::POSES);
+      if(!readPoses(reader, index.at(ESection::POSES).nbElements, sfmData.getPoses()))
+      {
+        ALICEVISION_LOG_ERROR("Invalid binary SfMData file poses: " << filename);
+        return false;
+      }
+    }
+
+    // rigs
+    if(hasSection(ESection::RIGS))
+    {
+      bpt::ptree fileTree;
+      getTree(ESection::RIGS, fileTree);
+
+      sfmData::Rigs& rigs = sfmData.getRigs();
+      for(bpt::ptree::value_type& rigNode : fileTree.get_child("rigs"))
+      {
+        IndexT rigId;
+        sfmData::Rig rig;
+
+        loadRig(rigId, rig, rigNode.second);
+
+        rigs.emplace(rigId, rig);
+      }
+    }
+  }
+
+  // structure
+  if(loadStructure && hasSection(ESection::STRUCTURE))
+  {
+    BinaryReader reader = getReader(ESection::STRUCTURE);
+
+    // the observations section is only read if requested
+    const bool readObservations = loadObservations && hasSection(ESection::OBSERVATIONS);
+    BinaryReader observationsReader = readObservations ? getReader(ESection::OBSERVATIONS) : BinaryReader(nullptr, 0);
+
+    if(!readStructure(reader, index.at(ESection::STRUCTURE).nbElements, readObservations ? &observationsReader : nullptr, loadFeatures, sfmData.getLandmarks()))
+    {
+      ALICEVISION_LOG_ERROR("Invalid binary SfMData file structure: " << filename);
+      return false;
+    }
+  }
+
+  // control points
+  if(loadControlPoints && hasSection(ESection::CONTROL_POINTS))
+  {
+    bpt::ptree fileTree;
+    getTree(ESection::CONTROL_POINTS, fileTree);
+
+    sfmData::Landmarks& controlPoints = sfmData.getControlPoints();
+    for(bpt::ptree::value_type& landmarkNode : fileTree.get_child("controlPoints"))
+    {
+      IndexT landmarkId;
+      sfmData::Landmark landmark;
+
+      loadLandmark(landmarkId, landmark, landmarkNode.second);
+
+      controlPoints.emplace(landmarkId, landmark);
+    }
+  }
+
+  return true;
+}
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -0,0 +1,50 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+
+#include <string>
+
+namespace aliceVision {
+namespace sfmDataIO {
+
+// AliceVision binary SfMData file (.sfmb):
+// -- Header
+// magic "AVSFMB" (8 bytes), version (uint32), #sections (uint32)
+// -- Index
+// per section: section type (uint32), #elements (uint32), offset (uint64), size in bytes (uint64)
+// -- Sections
+// folders, views, intrinsics, rigs, control points: JSON text (same layout as the .sfm file)
+// poses: [poseId (uint32) locked (uint32) rotation (9 x double, column major) center (3 x double)]
+// structure: [landmarkId (uint32) descType (int32) #observations (uint32) rgb (3 x uint8) pad (uint8) X (3 x double)]
+// observations: [viewId (uint32) featureId (uint32) x (2 x double)], in the order of the structure
+// --
+// Only the sections of the requested ESfMData parts are read, from a read-only memory mapping
+// of the file: the landmarks and observations are decoded from the mapped records.
+// The records are in the byte order of the host.
+
+/**
+ * @brief Save an SfMData in a binary file.
+ * @param[in] sfmData The input SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData save flag
+ * @return true if completed
+ */
+bool saveBinary(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+/**
+ * @brief Load a binary SfMData file.
+ * @param[out] sfmData The output SfMData
+ * @param[in] filename The filename
+ * @param[in] partFlag The ESfMData load flag
+ * @return true if completed
+ */
+bool loadBinary(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag);
+
+} // namespace sfmDataIO
+} // namespace aliceVision
@@ -7,11 +7,20 @@
 #include "jsonIO.hpp"
 #include <aliceVision/camera/camera.hpp>
 #include <aliceVision/sfmDataIO/viewIO.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/property_tree/json_parser.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 #include <memory>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
 
 namespace aliceVision {
 namespace sfmDataIO {
@@ -277,6 +286,449 @@ void loadLandmark(IndexT& landmarkId, sfmData::Landmark& landmark, bpt::ptree& l
 }
 
 
+namespace {
+
+/**
+ * @brief Streaming reader of the values of a JSON text.
+ * Values can be quoted (as written by the property tree) or not.
+ */
+class JsonCursor
+{
+public:
+  JsonCursor(const char* begin, const char* end)
+    : _pos(begin)
+    , _end(end)
+  {}
+
+  inline const char* pos() const { return _pos; }
+
+  inline void skipWhitespaces()
+  {
+    while(_pos != _end && (*_pos == ' ' || *_pos == '\n' || *_pos == '\r' || *_pos == '\t'))
+      ++_pos;
+  }
+
+  /// Skip the whitespaces and return the next character (without consuming it)
+  inline char peek()
+  {
+    skipWhitespaces();
+    if(_pos == _end)
+      error("unexpected end of file");
+    return *_pos;
+  }
+
+  inline void expect(char c)
+  {
+    if(peek() != c)
+      error(std::string("'") + c + "' expected");
+    ++_pos;
+  }
+
+  /// Consume the given character if it is the next one
+  inline bool consume(char c)
+  {
+    if(peek() != c)
+      return false;
+    ++_pos;
+    return true;
+  }
+
+  std::string readString()
+  {
+    expect('"');
+    std::string str;
+    while(true)
+    {
+      if(_pos == _end)
+        error("unterminated string");
+      const char c = *_pos++;
+      if(c == '"')
+        break;
+      if(c != '\\')
+      {
+        str.push_back(c);
+        continue;
+      }
+      if(_pos == _end)
+        error("unterminated string");
+      const char escaped = *_pos++;
+      switch(escaped)
+      {
+        case 'b': str.push_back('\b'); break;
+        case 'f': str.push_back('\f'); break;
+        case 'n': str.push_back('\n'); break;
+        case 'r': str.push_back('\r'); break;
+        case 't': str.push_back('\t'); break;
+        case 'u':
+        {
+          if(_end - _pos < 4)
+            error("invalid unicode escape");
+          const unsigned int code = std::stoul(std::string(_pos, _pos + 4), nullptr, 16);
+          _pos += 4;
+          // utf-8 encoding of the basic multilingual plane
+          if(code < 0x80)
+            str.push_back(static_cast<char>(code));
+          else if(code < 0x800)
+          {
+            str.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+          }
+          else
+          {
+            str.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            str.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+          }
+          break;
+        }
+        default: str.push_back(escaped); break;
+      }
+    }
+    return str;
+  }
+
+  double readDouble()
+  {
+    char buffer[64];
+    readNumber(buffer);
+    char* numberEnd;
+    const double value = std::strtod(buffer, &numberEnd);
+    if(numberEnd == buffer)
+      error("number expected");
+    return value;
+  }
+
+  unsigned long readUnsigned()
+  {
+    char buffer[64];
+    readNumber(buffer);
+    char* numberEnd;
+    const unsigned long value = std::strtoul(buffer, &numberEnd, 10);
+    if(numberEnd == buffer)
+      error("number expected");
+    return value;
+  }
+
+  /// Skip a value (string, number, literal, object or array)
+  void skipValue()
+  {
+    const char c = peek();
+    if(c == '"')
+    {
+      skipString();
+      return;
+    }
+    if(c != '{' && c != '[')
+    {
+      while(_pos != _end && *_pos != ',' && *_pos != '}' && *_pos != ']' && *_pos != ' ' && *_pos != '\n' && *_pos != '\r' && *_pos != '\t')
+        ++_pos;
+      return;
+    }
+
+    int depth = 0;
+    while(_pos != _end)
+    {
+      const char v = *_pos;
+      if(v == '"')
+      {
+        skipString();
+        continue;
+      }
+      ++_pos;
+      if(v == '{' || v == '[')
+        ++depth;
+      else if((v == '}' || v == ']') && --depth == 0)
+        return;
+    }
+    error("unexpected end of file");
+  }
+
+  [[noreturn]] void error(const std::string& message) const
+  {
+    throw std::runtime_error("Invalid JSON SfMData file: " + message + ".");
+  }
+
+private:
+  void skipString()
+  {
+    ++_pos; // opening quote
+    while(_pos != _end && *_pos != '"')
+      _pos += (*_pos == '\\') ? 2 : 1;
+    if(_pos >= _end)
+      error("unterminated string");
+    ++_pos;
+  }
+
+  /// Copy the next number token (quoted or not) in a null-terminated buffer
+  void readNumber(char (&buffer)[64])
+  {
+    const bool quoted = consume('"');
+    std::size_t size = 0;
+    while(_pos != _end && *_pos != '"' && *_pos != ',' && *_pos != '}' && *_pos != ']' && *_pos != ' ' && *_pos != '\n' && *_pos != '\r' && *_pos != '\t')
+    {
+      if(size == sizeof(buffer) - 1)
+        error("number too long");
+      buffer[size++] = *_pos++;
+    }
+    buffer[size] = '\0';
+    if(quoted)
+      expect('"');
+  }
+
+  const char* _pos;
+  const char* _end;
+};
+
+template<typename Derived>
+void readArray(JsonCursor& cursor, Eigen::MatrixBase<Derived>& matrix)
+{
+  cursor.expect('[');
+  for(int i = 0; i < matrix.size(); ++i)
+  {
+    if(i > 0)
+      cursor.expect(',');
+    matrix(i) = static_cast<typename Derived::Scalar>(cursor.readDouble());
+  }
+  cursor.expect(']');
+}
+
+void readObservation(JsonCursor& cursor, sfmData::Observations& observations, bool loadFeatures)
+{
+  IndexT observationId = UndefinedIndexT;
+  sfmData::Observation observation;
+
+  cursor.expect('{');
+  if(!cursor.consume('}'))
+  {
+    do
+    {
+      const std::string key = cursor.readString();
+      cursor.expect(':');
+
+      if(key == "observationId")
+        observationId = cursor.readUnsigned();
+      else if(loadFeatures && key == "featureId")
+        observation.id_feat = cursor.readUnsigned();
+      else if(loadFeatures && key == "x")
+        readArray(cursor, observation.x);
+      else
+        cursor.skipValue();
+    }
+    while(cursor.consume(','));
+    cursor.expect('}');
+  }
+
+  if(observationId == UndefinedIndexT)
+    cursor.error("observation without observationId");
+
+  observations.emplace(observationId, observation);
+}
+
+/**
+ * @brief Parse a landmark object, with the schema of saveLandmark.
+ */
+void readLandmark(JsonCursor& cursor, IndexT& landmarkId, sfmData::Landmark& landmark, bool loadObservations, bool loadFeatures)
+{
+  landmarkId = UndefinedIndexT;
+
+  cursor.expect('{');
+  if(!cursor.consume('}'))
+  {
+    do
+    {
+      const std::string key = cursor.readString();
+      cursor.expect(':');
+
+      if(key == "landmarkId")
+        landmarkId = cursor.readUnsigned();
+      else if(key == "descType")
+        landmark.descType = feature::EImageDescriberType_stringToEnum(cursor.readString());
+      else if(key == "color")
+      {
+        Vec3 color;
+        readArray(cursor, color);
+        landmark.rgb = image::RGBColor(color(0), color(1), color(2));
+      }
+      else if(key == "X")
+        readArray(cursor, landmark.X);
+      else if(loadObservations && key == "observations")
+      {
+        cursor.expect('[');
+        if(!cursor.consume(']'))
+        {
+          do
+          {
+            readObservation(cursor, landmark.observations, loadFeatures);
+          }
+          while(cursor.consume(','));
+          cursor.expect(']');
+        }
+      }
+      else
+        cursor.skipValue();
+    }
+    while(cursor.consume(','));
+    cursor.expect('}');
+  }
+
+  if(landmarkId == UndefinedIndexT)
+    cursor.error("landmark without landmarkId");
+}
+
+/**
+ * @brief Parse an array of landmarks in parallel.
+ * The elements are first delimited with a sequential scan, then parsed in parallel.
+ */
+void readLandmarks(const char* begin, const char* end, sfmData::Landmarks& landmarks, bool loadObservations, bool loadFeatures)
+{
+  std::vector<const char*> elements;
+  {
+    JsonCursor cursor(begin, end);
+    cursor.expect('[');
+    if(!cursor.consume(']'))
+    {
+      do
+      {
+        cursor.skipWhitespaces();
+        elements.push_back(cursor.pos());
+        cursor.skipValue();
+      }
+      while(cursor.consume(','));
+      cursor.expect(']');
+    }
+  }
+
+  std::vector<std::pair<IndexT, sfmData::Landmark>> parsedLandmarks(elements.size());
+  std::string errorMessage;
+
+  #pragma omp parallel for schedule(dynamic, 1024)
+  for(int i = 0; i < elements.size(); ++i)
+  {
+    try
+    {
+      JsonCursor cursor(elements.at(i), end);
+      readLandmark(cursor, parsedLandmarks.at(i).first, parsedLandmarks.at(i).second, loadObservations, loadFeatures);
+    }
+    catch(const std::exception& e)
+    {
+      #pragma omp critical
+      errorMessage = e.what();
+    }
+  }
+
+  if(!errorMessage.empty())
+    throw std::runtime_error(errorMessage);
+
+  for(auto& landmarkPair : parsedLandmarks)
+    landmarks.emplace(landmarkPair.first, std::move(landmarkPair.second));
+}
+
+inline void appendValue(std::string& out, double value)
+{
+  char buffer[32];
+  // same precision as the property tree
+  const int size = std::snprintf(buffer, sizeof(buffer), "\"%.*g\"", std::numeric_limits<double>::max_digits10, value);
+  out.append(buffer, size);
+}
+
+inline void appendValue(std::string& out, unsigned int value)
+{
+  char buffer[16];
+  const int size = std::snprintf(buffer, sizeof(buffer), "\"%u\"", value);
+  out.append(buffer, size);
+}
+
+template<typename Derived>
+void appendArray(std::string& out, const Eigen::MatrixBase<Derived>& matrix)
+{
+  out.push_back('[');
+  for(int i = 0; i < matrix.size(); ++i)
+  {
+    if(i > 0)
+      out.append(", ");
+    appendValue(out, matrix(i));
+  }
+  out.push_back(']');
+}
+
+/**
+ * @brief Format a landmark object, with the schema of saveLandmark.
+ */
+void appendLandmark(std::string& out, IndexT landmarkId, const sfmData::Landmark& landmark, bool saveObservations, bool saveFeatures)
+{
+  out.append("        {\"landmarkId\": ");
+  appendValue(out, static_cast<unsigned int>(landmarkId));
+  out.append(", \"descType\": \"");
+  out.append(feature::EImageDescriberType_enumToString(landmark.descType));
+  out.append("\", \"color\": ");
+  appendArray(out, landmark.rgb.cast<unsigned int>());
+  out.append(", \"X\": ");
+  appendArray(out, landmark.X);
+
+  if(saveObservations)
+  {
+    out.append(", \"observations\": [");
+    bool first = true;
+    for(const auto& obsPair : landmark.observations)
+    {
+      out.append(first ? "{\"observationId\": " : ", {\"observationId\": ");
+      appendValue(out, static_cast<unsigned int>(obsPair.first));
+      if(saveFeatures)
+      {
+        out.append(", \"featureId\": ");
+        appendValue(out, static_cast<unsigned int>(obsPair.second.id_feat));
+        out.append(", \"x\": ");
+        appendArray(out, obsPair.second.x);
+      }
+      out.push_back('}');
+      first = false;
+    }
+    out.push_back(']');
+  }
+  out.push_back('}');
+}
+
+/**
+ * @brief Write an array of landmarks, formatted in parallel by blocks.
+ */
+void writeLandmarks(std::ostream& stream, const std::string& name, const sfmData::Landmarks& landmarks, bool saveObservations, bool saveFeatures)
+{
+  const std::size_t blockSize = 100000;
+
+  std::vector<sfmData::Landmarks::const_iterator> iterators;
+  iterators.reserve(landmarks.size());
+  for(auto it = landmarks.begin(); it != landmarks.end(); ++it)
+    iterators.push_back(it);
+
+  stream << ",\n    \"" << name << "\": [\n";
+
+  std::vector<std::string> formatted;
+  for(std::size_t blockBegin = 0; blockBegin < iterators.size(); blockBegin += blockSize)
+  {
+    const int nbLandmarks = static_cast<int>(std::min(blockSize, iterators.size() - blockBegin));
+    formatted.resize(nbLandmarks);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbLandmarks; ++i)
+    {
+      const auto& it = iterators.at(blockBegin + i);
+      formatted.at(i).clear();
+      appendLandmark(formatted.at(i), it->first, it->second, saveObservations, saveFeatures);
+    }
+
+    for(int i = 0; i < nbLandmarks; ++i)
+    {
+      if(blockBegin + i > 0)
+        stream << ",\n";
+      stream << formatted.at(i);
+    }
+  }
+
+  stream << "\n    ]";
+}
+
+} // namespace
+
 bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
 {
   const Vec3 version = {1, 0, 0};
@@ -380,33 +832,34 @@ bool saveJSON(const sfmData::SfMData& sfmData, const std::string& filename, ESfM
     }
   }
 
-  // structure
-  if(saveStructure && !sfmData.getLandmarks().empty())
+  // write the json file with the tree, the structure and the control points are streamed
+  std::string header;
   {
-    bpt::ptree structureTree;
-
-    for(const auto& structurePair : sfmData.getLandmarks())
-      saveLandmark("", structurePair.first, structurePair.second, structureTree, saveObservations, saveFeatures);
-
-    fileTree.add_child("structure", structureTree);
+    std::ostringstream headerStream;
+    bpt::write_json(headerStream, fileTree);
+    header = headerStream.str();
+    // remove the closing brace of the main object
+    header.erase(header.find_last_not_of(" \n"));
+    header.erase(header.find_last_not_of(" \n") + 1);
   }
 
-  // control points
-  if(saveControlPoints && !sfmData.getControlPoints().empty())
-  {
-    bpt::ptree controlPointTree;
+  std::ofstream stream(filename);
+  if(!stream.is_open())
+    return false;
 
-    for(const auto& controlPointPair : sfmData.getControlPoints())
-      saveLandmark("", controlPointPair.first, controlPointPair.second, controlPointTree);
+  stream << header;
 
-    fileTree.add_child("controlPoints", controlPointTree);
-  }
+  // structure
+  if(saveStructure && !sfmData.getLandmarks().empty())
+    writeLandmarks(stream, "structure", sfmData.getLandmarks(), saveObservations, saveFeatures);
 
-  // write the json file with the tree
+  // control points
+  if(saveControlPoints && !sfmData.getControlPoints().empty())
+    writeLandmarks(stream, "controlPoints", sfmData.getControlPoints(), true, true);
 
-  bpt::write_json(filename, fileTree);
+  stream << "\n}\n";
 
-  return true;
+  return stream.good();
 }
 
 bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag, bool incompleteViews)
@@ -422,11 +875,57 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
   const bool loadFeatures = (partFlag & OBSERVATIONS_WITH_FEATURES) == OBSERVATIONS_WITH_FEATURES;
   const bool loadObservations = loadFeatures || ((partFlag & OBSERVATIONS) == OBSERVATIONS);
 
+  // read-only memory mapping of the file
+  boost::interprocess::file_mapping file(filename.c_str(), boost::interprocess::read_only);
+  boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+  const char* data = static_cast<const char*>(region.get_address());
+  const char* dataEnd = data + region.get_size();
+
+  // split the top-level members: the structure and the control points are streamed,
+  // the other members are small and are read in the main tree
+  std::string header = "{";
+  const char* structureBegin = nullptr;
+  const char* controlPointsBegin = nullptr;
+  {
+    JsonCursor cursor(data, dataEnd);
+    cursor.expect('{');
+    if(!cursor.consume('}'))
+    {
+      do
+      {
+        cursor.skipWhitespaces();
+        const char* memberBegin = cursor.pos();
+        const std::string key = cursor.readString();
+        cursor.expect(':');
+        cursor.skipWhitespaces();
+        const char* valueBegin = cursor.pos();
+        cursor.skipValue();
+
+        if(key == "structure")
+          structureBegin = valueBegin;
+        else if(key == "controlPoints")
+          controlPointsBegin = valueBegin;
+        else
+        {
+          if(header.size() > 1)
+            header.push_back(',');
+          header.append(memberBegin, cursor.pos());
+        }
+      }
+      while(cursor.consume(','));
+      cursor.expect('}');
+    }
+  }
+  header.push_back('}');
+
   // main tree
   bpt::ptree fileTree;
 
-  // read the json file and initialize the tree
-  bpt::read_json(filename, fileTree);
+  // initialize the tree
+  {
+    std::istringstream headerStream(header);
+    bpt::read_json(headerStream, fileTree);
+  }
 
   // version
   loadMatrix("version", version, fileTree);
@@ -551,36 +1050,12 @@ bool loadJSON(sfmData::SfMData& sfmData, const std::string& filename, ESfMData p
   }
 
   // structure
-  if(loadStructure && fileTree.count("structure"))
-  {
-    sfmData::Landmarks& structure = sfmData.getLandmarks();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("structure"))
-    {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second, loadObservations, loadFeatures);
-
-      structure.emplace(landmarkId, landmark);
-    }
-  }
+  if(loadStructure && structureBegin != nullptr)
+    readLandmarks(structureBegin, dataEnd, sfmData.getLandmarks(), loadObservations, loadFeatures);
 
   // control points
-  if(loadControlPoints && fileTree.count("controlPoints"))
-  {
-    sfmData::Landmarks& controlPoints = sfmData.getControlPoints();
-
-    for(bpt::ptree::value_type &landmarkNode : fileTree.get_child("controlPoints"))
-    {
-      IndexT landmarkId;
-      sfmData::Landmark landmark;
-
-      loadLandmark(landmarkId, landmark, landmarkNode.second);
-
-      controlPoints.emplace(landmarkId, landmark);
-    }
-  }
+  if(loadControlPoints && controlPointsBegin != nullptr)
+    readLandmarks(controlPointsBegin, dataEnd, sfmData.getControlPoints(), true, true);
 
   return true;
 }
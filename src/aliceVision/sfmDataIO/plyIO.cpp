@@ -6,16 +6,71 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "plyIO.hpp"
+#include <aliceVision/alicevision_omp.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <sstream>
+#include <vector>
 
 namespace aliceVision {
 namespace sfmDataIO {
 
+namespace {
+
+/// number of vertices formatted by the same task
+const std::size_t chunkSize = 1 << 16;
+
+/// number of chunks formatted before being written
+const std::size_t chunksPerBatch = 64;
+
+/// size of a vertex in a binary PLY file: 3 floats and 3 uchars
+const std::size_t binaryVertexSize = 3 * sizeof(float) + 3 * sizeof(std::uint8_t);
+
+/**
+ * @brief Write a vertex in a binary PLY buffer
+ */
+inline void writeBinaryVertex(std::string& buffer, const Vec3& X, const image::RGBColor& rgb)
+{
+  char vertex[binaryVertexSize];
+  const float position[3] = {static_cast<float>(X(0)), static_cast<float>(X(1)), static_cast<float>(X(2))};
+  const std::uint8_t color[3] = {rgb.r(), rgb.g(), rgb.b()};
+  std::memcpy(vertex, position, sizeof(position));
+  std::memcpy(vertex + sizeof(position), color, sizeof(color));
+  buffer.append(vertex, binaryVertexSize);
+}
+
+/**
+ * @brief Write a vertex in an ASCII PLY stream
+ */
+inline void writeAsciiVertex(std::ostream& stream, const Vec3& X, const image::RGBColor& rgb)
+{
+  stream << X.transpose() << " "
+         << (int)rgb.r() << " "
+         << (int)rgb.g() << " "
+         << (int)rgb.b() << "\n";
+}
+
+/**
+ * @brief Whether the machine stores the numbers in little endian order
+ */
+inline bool isLittleEndian()
+{
+  const std::uint16_t value = 1;
+  std::uint8_t firstByte;
+  std::memcpy(&firstByte, &value, 1);
+  return firstByte == 1;
+}
+
+} // namespace
+
 bool savePLY(
   const sfmData::SfMData& sfmData,
   const std::string& filename,
-  ESfMData partFlag)
+  ESfMData partFlag,
+  bool binary)
 {
   const bool b_structure = (partFlag & STRUCTURE) == STRUCTURE;
   const bool b_extrinsics = (partFlag & EXTRINSICS) == EXTRINSICS;
@@ -24,7 +79,7 @@ bool savePLY(
     return false;
 
   //Create the stream and check it is ok
-  std::ofstream stream(filename.c_str());
+  std::ofstream stream(filename.c_str(), binary ? std::ios::out | std::ios::binary : std::ios::out);
   if (!stream.is_open())
     return false;
 
@@ -40,7 +95,7 @@ bool savePLY(
       }
     }
     stream << "ply"
-      << '\n' << "format ascii 1.0"
+      << '\n' << (binary ? (isLittleEndian() ? "format binary_little_endian 1.0" : "format binary_big_endian 1.0") : "format ascii 1.0")
       << '\n' << "element vertex "
         // Vertex count: (#landmark + #view_with_valid_pose)
         << ((b_structure ? sfmData.getLandmarks().size() : 0) +
@@ -55,27 +110,63 @@ bool savePLY(
 
       if (b_extrinsics)
       {
+        std::string buffer;
+        const image::RGBColor cameraColor(0, 255, 0);
         for (const auto& view : sfmData.getViews())
         {
           if (sfmData.isPoseAndIntrinsicDefined(view.second.get()))
           {
             const geometry::Pose3 pose = sfmData.getPose(*(view.second.get())).getTransform();
-            stream << pose.center().transpose()
-              << " 0 255 0" << "\n";
+            if (binary)
+              writeBinaryVertex(buffer, pose.center(), cameraColor);
+            else
+              writeAsciiVertex(stream, pose.center(), cameraColor);
           }
         }
+        stream.write(buffer.data(), buffer.size());
       }
 
       if (b_structure)
       {
+        // the landmarks are formatted by chunks in parallel, and written in order
         const sfmData::Landmarks& landmarks = sfmData.getLandmarks();
-        for (sfmData::Landmarks::const_iterator iterLandmarks = landmarks.begin();
-          iterLandmarks != landmarks.end();
-          ++iterLandmarks)  {
-          stream << iterLandmarks->second.X.transpose() << " "
-                 << (int)iterLandmarks->second.rgb.r() << " "
-                 << (int)iterLandmarks->second.rgb.g() << " "
-                 << (int)iterLandmarks->second.rgb.b() << "\n";
+        std::vector<const sfmData::Landmark*> landmarksList;
+        landmarksList.reserve(landmarks.size());
+        for (const auto& landmark : landmarks)
+          landmarksList.push_back(&landmark.second);
+
+        const std::size_t nbChunks = (landmarksList.size() + chunkSize - 1) / chunkSize;
+        std::vector<std::string> buffers(std::min(nbChunks, chunksPerBatch));
+
+        for (std::size_t batchBegin = 0; batchBegin < nbChunks && stream.good(); batchBegin += chunksPerBatch)
+        {
+          const int nbBatchChunks = static_cast<int>(std::min(chunksPerBatch, nbChunks - batchBegin));
+
+          #pragma omp parallel for schedule(dynamic)
+          for (int c = 0; c < nbBatchChunks; ++c)
+          {
+            const std::size_t begin = (batchBegin + c) * chunkSize;
+            const std::size_t end = std::min(begin + chunkSize, landmarksList.size());
+            std::string& buffer = buffers[c];
+
+            if (binary)
+            {
+              buffer.clear();
+              buffer.reserve((end - begin) * binaryVertexSize);
+              for (std::size_t i = begin; i < end; ++i)
+                writeBinaryVertex(buffer, landmarksList[i]->X, landmarksList[i]->rgb);
+            }
+            else
+            {
+              std::ostringstream chunkStream;
+              for (std::size_t i = begin; i < end; ++i)
+                writeAsciiVertex(chunkStream, landmarksList[i]->X, landmarksList[i]->rgb);
+              buffer = chunkStream.str();
+            }
+          }
+
+          for (int c = 0; c < nbBatchChunks; ++c)
+            stream.write(buffers[c].data(), buffers[c].size());
         }
       }
       stream.flush();
@@ -15,15 +15,17 @@ namespace aliceVision {
 namespace sfmDataIO {
 
 /**
- * @brief Save the structure and camera positions of a SfMData container as 3D points in a PLY ASCII file.
+ * @brief Save the structure and camera positions of a SfMData container as 3D points in a PLY file.
  * @param[in] sfmData The input SfMData
  * @param[in] filename The filename
  * @param[in] partFlag The ESfMData save flag
+ * @param[in] binary Write a binary PLY file (in the byte order of the machine) instead of an ASCII one
  * @return true if completed
  */
 bool savePLY(const sfmData::SfMData& sfmData,
              const std::string& filename,
-             ESfMData partFlag);
+             ESfMData partFlag,
+             bool binary = false);
 
 } // namespace sfmDataIO
 } // namespace aliceVision
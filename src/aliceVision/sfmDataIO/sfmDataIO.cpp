@@ -11,7 +11,10 @@
 #include <aliceVision/sfmDataIO/jsonIO.hpp>
 #include <aliceVision/sfmDataIO/plyIO.hpp>
 #include <aliceVision/sfmDataIO/bafIO.hpp>
+#include <aliceVision/sfmDataIO/binaryIO.hpp>
 #include <aliceVision/sfmDataIO/gtIO.hpp>
+#include <aliceVision/system/Profiler.hpp>
+#include <aliceVision/system/Storage.hpp>
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
 #include <aliceVision/sfmDataIO/AlembicExporter.hpp>
@@ -94,17 +97,27 @@ bool ValidIds(const sfmData::SfMData& sfmData, ESfMData partFlag)
 
 bool Load(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
 {
+  ALICEVISION_PROFILE_SCOPE("sfmDataIO::Load");
+
   const std::string extension = fs::extension(filename);
   bool status = false;
 
+  // local copy of a remote file
+  const bool isLocal = system::Storage::isLocalPath(filename);
+  const auto getLocalPath = [&]() { return isLocal ? filename : system::Storage::get().getLocalPath(filename); };
+
   if(extension == ".sfm" || extension == ".json") // JSON File
   {
-    status = loadJSON(sfmData, filename, partFlag);
+    status = loadJSON(sfmData, getLocalPath(), partFlag);
+  }
+  else if(extension == ".sfmb") // Binary File
+  {
+    status = loadBinary(sfmData, getLocalPath(), partFlag);
   }
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
   else if(extension == ".abc") // Alembic
   {
-    AlembicImporter(filename).populateSfM(sfmData, partFlag);
+    AlembicImporter(getLocalPath()).populateSfM(sfmData, partFlag);
     status = true;
   }
 #endif // ALICEVISION_HAVE_ALEMBIC
@@ -130,15 +143,24 @@ bool Load(sfmData::SfMData& sfmData, const std::string& filename, ESfMData partF
 
 bool Save(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData partFlag)
 {
+  ALICEVISION_PROFILE_SCOPE("sfmDataIO::Save");
+
   const fs::path bPath = fs::path(filename);
   const std::string extension = bPath.extension().string();
-  const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + extension;
+  // a remote file is written locally, then uploaded
+  const bool isLocal = system::Storage::isLocalPath(filename);
+  const fs::path tmpFolder = isLocal ? bPath.parent_path() : fs::temp_directory_path();
+  const std::string tmpPath = (tmpFolder / bPath.stem()).string() + "." + fs::unique_path().string() + extension;
   bool status = false;
 
   if(extension == ".sfm" || extension == ".json") // JSON File
   {
     status = saveJSON(sfmData, tmpPath, partFlag);
   }
+  else if(extension == ".sfmb") // Binary File
+  {
+    status = saveBinary(sfmData, tmpPath, partFlag);
+  }
   else if(extension == ".ply") // Polygon File
   {
     status = savePLY(sfmData, tmpPath, partFlag);
@@ -162,8 +184,23 @@ bool Save(const sfmData::SfMData& sfmData, const std::string& filename, ESfMData
   }
 
   // rename temporay filename
-  if(status)
+  if(status && isLocal)
+  {
     fs::rename(tmpPath, filename);
+  }
+  else if(status)
+  {
+    try
+    {
+      system::Storage::get().upload(tmpPath, filename);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Cannot save the SfM data file: '" << filename << "'." << std::endl << e.what());
+      status = false;
+    }
+    fs::remove(tmpPath);
+  }
 
   return status;
 }
@@ -7,10 +7,15 @@
 
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/sfmDataIO/jsonIO.hpp>
+#include <aliceVision/sfmDataIO/plyIO.hpp>
 
 #include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
 #include <sstream>
+#include <fstream>
+#include <cstring>
 
 #define BOOST_TEST_MODULE sfmDataIO
 #include <boost/test/included/unit_test.hpp>
@@ -175,6 +180,116 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_JSON) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(SfMData_IO_JSON_STRUCTURE) {
+
+  const std::string filename = "SAVE_LOAD_STRUCTURE.sfm";
+
+  sfmData::SfMData sfmData = createTestScene(3, 3, true);
+  for(IndexT landmarkId = 1; landmarkId < 1000; ++landmarkId)
+  {
+    sfmData::Landmark& landmark = sfmData.structure[landmarkId * 3];
+    landmark = sfmData::Landmark(Vec3(landmarkId / 7.0, -1e-10 * landmarkId, 1e8), feature::EImageDescriberType::SIFT, sfmData::Observations(), image::RGBColor(landmarkId % 256, 0, 255));
+    for(IndexT viewId = 0; viewId < landmarkId % 4; ++viewId)
+      landmark.observations[viewId] = sfmData::Observation(Vec2(0.1 * landmarkId, 1.0 / 3.0), landmarkId + viewId);
+  }
+  sfmData.control_points[7] = sfmData::Landmark(Vec3(4, 5, 6), feature::EImageDescriberType::SIFT);
+
+  BOOST_CHECK( Save(sfmData, filename, ALL) );
+
+  // streamed structure
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, ALL) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), sfmData.views.size());
+    BOOST_CHECK( sfmDataLoad.structure == sfmData.structure );
+    BOOST_CHECK( sfmDataLoad.control_points == sfmData.control_points );
+  }
+
+  // same schema as the property tree
+  {
+    bpt::ptree fileTree;
+    bpt::read_json(filename, fileTree);
+    BOOST_CHECK_EQUAL( fileTree.get_child("structure").size(), sfmData.structure.size());
+
+    sfmData::Landmarks structure;
+    for(bpt::ptree::value_type& landmarkNode : fileTree.get_child("structure"))
+    {
+      IndexT landmarkId;
+      sfmData::Landmark landmark;
+      loadLandmark(landmarkId, landmark, landmarkNode.second);
+      structure.emplace(landmarkId, landmark);
+    }
+    BOOST_CHECK( structure == sfmData.structure );
+  }
+
+  // structure without observations
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, STRUCTURE) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), sfmData.structure.size());
+    BOOST_CHECK( sfmDataLoad.structure.at(3).observations.empty() );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_LOAD_BINARY) {
+
+  const std::string filename = "SAVE_LOAD.sfmb";
+
+  sfmData::SfMData sfmData = createTestScene(3, 3, false);
+  sfmData.structure[0].rgb = image::RGBColor(10, 20, 30);
+  sfmData.structure[5] = sfmData::Landmark(Vec3(1, 2, 3), feature::EImageDescriberType::AKAZE);
+  sfmData.control_points[1] = sfmData::Landmark(Vec3(4, 5, 6), feature::EImageDescriberType::SIFT);
+  sfmData.control_points[1].observations[2] = sfmData::Observation(Vec2(7, 8), 9);
+  sfmData.setPose(*sfmData.views.at(1), sfmData::CameraPose(Pose3(RotationAroundX(0.5), Vec3(1, 2, 3)), true));
+  sfmData.addFeaturesFolders({".."});
+
+  BOOST_CHECK( Save(sfmData, filename, ALL) );
+
+  // LOAD
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, ALL) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.intrinsics.size(), sfmData.intrinsics.size());
+    BOOST_CHECK( sfmDataLoad.getPoses() == sfmData.getPoses() );
+    BOOST_CHECK( sfmDataLoad.structure == sfmData.structure );
+    BOOST_CHECK( sfmDataLoad.control_points == sfmData.control_points );
+    BOOST_CHECK_EQUAL( sfmDataLoad.getFeaturesFolders().size(), 1);
+  }
+
+  // LOAD (only a subpart: VIEWS | EXTRINSICS)
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, ESfMData(VIEWS | EXTRINSICS)) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.getPoses().size(), sfmData.getPoses().size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.intrinsics.size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.control_points.size(), 0);
+  }
+
+  // LOAD (only a subpart: STRUCTURE without observations)
+  {
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, STRUCTURE) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), sfmData.structure.size());
+    BOOST_CHECK( sfmDataLoad.structure.at(0).observations.empty() );
+    BOOST_CHECK( sfmDataLoad.structure.at(5).X == sfmData.structure.at(5).X );
+  }
+
+  // SAVE (only a subpart: VIEWS | INTRINSICS) and LOAD ALL
+  {
+    BOOST_CHECK( Save(sfmData, filename, ESfMData(VIEWS | INTRINSICS)) );
+    sfmData::SfMData sfmDataLoad;
+    BOOST_CHECK( Load(sfmDataLoad, filename, ALL) );
+    BOOST_CHECK_EQUAL( sfmDataLoad.views.size(), sfmData.views.size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.intrinsics.size(), sfmData.intrinsics.size());
+    BOOST_CHECK_EQUAL( sfmDataLoad.getPoses().size(), 0);
+    BOOST_CHECK_EQUAL( sfmDataLoad.structure.size(), 0);
+  }
+}
+
 /*
 BOOST_AUTO_TEST_CASE(SfMData_IO_BigFile) {
   const int nbViews = 1000;
@@ -228,3 +343,60 @@ BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_PLY) {
     BOOST_CHECK( fs::is_regular_file(filename) );
   }
 }
+
+BOOST_AUTO_TEST_CASE(SfMData_IO_SAVE_PLY_BINARY) {
+
+  // a structure written in several chunks
+  sfmData::SfMData sfmData = createTestScene(2, 2, true);
+  const std::size_t nbLandmarks = 150000;
+  for(IndexT i = 1; i < nbLandmarks; ++i)
+  {
+    sfmData.structure[i].X = Vec3(i, -0.5 * i, 2.0);
+    sfmData.structure[i].rgb = image::RGBColor(i % 256, (i / 256) % 256, 7);
+  }
+
+  const std::string filename = "SAVE_BINARY.ply";
+  BOOST_CHECK( savePLY(sfmData, filename, ESfMData(STRUCTURE), true) );
+
+  std::ifstream stream(filename, std::ios::binary);
+  BOOST_CHECK( stream.is_open() );
+
+  std::string line;
+  std::size_t nbVertices = 0;
+  while(std::getline(stream, line) && line != "end_header")
+  {
+    if(line.find("element vertex ") == 0)
+      nbVertices = std::stoul(line.substr(15));
+  }
+  BOOST_CHECK_EQUAL(nbVertices, nbLandmarks);
+
+  // the vertices are written in the landmarks order
+  std::size_t nbRead = 0;
+  std::size_t nbDifferent = 0;
+  for(const auto& landmark : sfmData.getLandmarks())
+  {
+    char vertex[15];
+    if(!stream.read(vertex, sizeof(vertex)))
+      break;
+
+    float position[3];
+    unsigned char color[3];
+    std::memcpy(position, vertex, sizeof(position));
+    std::memcpy(color, vertex + sizeof(position), sizeof(color));
+
+    for(int i = 0; i < 3; ++i)
+    {
+      if(position[i] != static_cast<float>(landmark.second.X(i)) || color[i] != landmark.second.rgb(i))
+        ++nbDifferent;
+    }
+    ++nbRead;
+  }
+  BOOST_CHECK_EQUAL(nbRead, nbLandmarks);
+  BOOST_CHECK_EQUAL(nbDifferent, 0);
+
+  // nothing after the vertices
+  BOOST_CHECK( stream.peek() == std::char_traits<char>::eof() );
+
+  stream.close();
+  fs::remove(filename);
+}
@@ -5,6 +5,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "viewIO.hpp"
+#include "ImageMetadataCache.hpp"
 
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/sfmData/uid.hpp>
@@ -20,7 +21,7 @@ namespace fs = boost::filesystem;
 namespace aliceVision {
 namespace sfmDataIO {
 
-void updateIncompleteView(sfmData::View& view)
+void updateIncompleteView(sfmData::View& view, ImageMetadataCache* metadataCache)
 {
   // check if the view is complete
   if(view.getViewId() != UndefinedIndexT &&
@@ -33,7 +34,10 @@ void updateIncompleteView(sfmData::View& view)
   int width, height;
   std::map<std::string, std::string> metadata;
 
-  image::readImageMetadata(view.getImagePath(), width, height, metadata);
+  if(metadataCache != nullptr)
+    metadataCache->readImageMetadata(view.getImagePath(), width, height, metadata);
+  else
+    image::readImageMetadata(view.getImagePath(), width, height, metadata);
 
   view.setWidth(width);
   view.setHeight(height);
@@ -15,11 +15,14 @@
 namespace aliceVision {
 namespace sfmDataIO {
 
+class ImageMetadataCache;
+
 /**
  * @brief update an incomplete view (at least only the image path)
  * @param view The given incomplete view
+ * @param metadataCache The image metadata cache (nullptr to read the image file)
  */
-void updateIncompleteView(sfmData::View& view);
+void updateIncompleteView(sfmData::View& view, ImageMetadataCache* metadataCache = nullptr);
 
 /**
  * @brief create an intrinsic for the given View
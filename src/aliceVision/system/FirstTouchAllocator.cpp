@@ -0,0 +1,33 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "FirstTouchAllocator.hpp"
+
+namespace aliceVision {
+namespace system {
+
+void firstTouch(void* data, std::size_t bytes, TaskPool& pool)
+{
+  if(data == nullptr || bytes < firstTouchMinBytes || pool.getNbThreads() <= 1)
+    return;
+
+  // the smallest page size: the larger pages are touched as well
+  const std::size_t pageBytes = 4096;
+  const std::size_t nbPages = (bytes + pageBytes - 1) / pageBytes;
+
+  volatile char* pages = static_cast<volatile char*>(data);
+
+  ParallelForOptions options;
+  // contiguous blocks of 1MB per thread
+  options.grainSize = 256;
+  parallelFor(std::size_t(0), nbPages, [&](std::size_t page)
+  {
+    pages[page * pageBytes] = 0;
+  }, options, pool);
+}
+
+} // namespace system
+} // namespace aliceVision
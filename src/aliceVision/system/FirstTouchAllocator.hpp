@@ -0,0 +1,74 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/TaskPool.hpp>
+
+#include <cstddef>
+#include <new>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Touch the memory pages of a buffer from the TaskPool threads.
+ *        The OS places a page on the NUMA node of the thread touching it first, so a large
+ *        buffer touched by one thread is local to one node only. Touching it in parallel
+ *        spreads it on the nodes of the pool threads.
+ * @param[in] data The buffer, not used yet
+ * @param[in] bytes The size of the buffer, nothing is done below firstTouchMinBytes
+ * @param[in] pool The pool touching the pages
+ */
+void firstTouch(void* data, std::size_t bytes, TaskPool& pool = TaskPool::get());
+
+/// Minimum size of the buffers touched in parallel by firstTouch
+constexpr std::size_t firstTouchMinBytes = 16 * 1024 * 1024;
+
+/**
+ * @brief Allocator touching the large allocations in parallel before their construction,
+ *        for the big arrays filled and read by parallel loops (e.g. std::vector::resize
+ *        would place all the pages on the node of the calling thread).
+ */
+template <class T>
+class FirstTouchAllocator
+{
+public:
+  using value_type = T;
+
+  FirstTouchAllocator() = default;
+
+  template <class U>
+  FirstTouchAllocator(const FirstTouchAllocator<U>&) noexcept
+  {}
+
+  T* allocate(std::size_t n)
+  {
+    T* data = static_cast<T*>(::operator new(n * sizeof(T)));
+    firstTouch(data, n * sizeof(T));
+    return data;
+  }
+
+  void deallocate(T* data, std::size_t) noexcept
+  {
+    ::operator delete(data);
+  }
+};
+
+template <class T, class U>
+bool operator==(const FirstTouchAllocator<T>&, const FirstTouchAllocator<U>&) noexcept
+{
+  return true;
+}
+
+template <class T, class U>
+bool operator!=(const FirstTouchAllocator<T>&, const FirstTouchAllocator<U>&) noexcept
+{
+  return false;
+}
+
+} // namespace system
+} // namespace aliceVision
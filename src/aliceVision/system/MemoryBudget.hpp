@@ -0,0 +1,78 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Thread safe memory budget shared by concurrent jobs.
+ *
+ * Each job acquires its memory consumption before running and releases it once done,
+ * so jobs of different sizes are packed in the available memory instead of
+ * reserving the biggest job size for each thread.
+ * A job bigger than the whole budget is allowed to run alone.
+ */
+class MemoryBudget
+{
+public:
+
+  /**
+   * @brief Build a memory budget
+   * @param[in] capacity The total memory available for the jobs (in bytes)
+   */
+  explicit MemoryBudget(std::size_t capacity)
+    : _capacity(capacity)
+  {}
+
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+  /**
+   * @brief Wait until the given amount of memory is available and reserve it
+   * @param[in] size The memory to reserve (in bytes)
+   */
+  void acquire(std::size_t size)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _released.wait(lock, [this, size]{ return _used == 0 || _used + size <= _capacity; });
+    _used += size;
+  }
+
+  /**
+   * @brief Release memory reserved with acquire()
+   * @param[in] size The reserved memory (in bytes)
+   */
+  void release(std::size_t size)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _used -= size;
+    }
+    _released.notify_all();
+  }
+
+  std::size_t capacity() const
+  {
+    return _capacity;
+  }
+
+private:
+  /// The total memory available for the jobs
+  const std::size_t _capacity;
+  /// The memory currently reserved by the running jobs
+  std::size_t _used = 0;
+  std::mutex _mutex;
+  std::condition_variable _released;
+};
+
+} // namespace system
+} // namespace aliceVision
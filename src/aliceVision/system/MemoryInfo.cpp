@@ -10,30 +10,59 @@
 
 #include <cmath>
 #include <iomanip>
+#include <limits>
 
 #if defined(__WINDOWS__)
 #include <windows.h>
+#include <psapi.h>
 #elif defined(__LINUX__)
 #include <sys/sysinfo.h>
+#include <fstream>
+#include <sstream>
+#include <string>
 #elif defined(__APPLE__)
 #include <sys/types.h>
 #include <sys/sysctl.h>
+#include <sys/resource.h>
+#include <mach/task.h>
 #include <mach/vm_statistics.h>
 #include <mach/mach_types.h>
 #include <mach/mach_init.h>
 #include <mach/mach_host.h>
 #else
 #warning "System unrecognized. Can't found memory infos."
-#include <limits>
 #endif
 
 
 namespace aliceVision {
 namespace system {
 
+#if defined(__LINUX__)
+/**
+ * @brief Read a value in kB from a /proc file with "Key: value kB" lines
+ * @return the value in bytes, 0 if not found
+ */
+static std::size_t readProcValue(const std::string& filename, const std::string& key)
+{
+    std::ifstream file(filename);
+    std::string line;
+    while(std::getline(file, line))
+    {
+        if(line.compare(0, key.size(), key) != 0 || line.size() <= key.size() || line[key.size()] != ':')
+            continue;
+        std::istringstream value(line.substr(key.size() + 1));
+        std::size_t kb = 0;
+        value >> kb;
+        return kb * 1024;
+    }
+    return 0;
+}
+#endif
+
 MemoryInfo getMemoryInfo()
 {
     MemoryInfo infos;
+    infos.availableRam = 0;
 
 #if defined(__WINDOWS__)
     MEMORYSTATUS memory;
@@ -56,6 +85,7 @@ MemoryInfo getMemoryInfo()
     // infos.bufferRam = sys_info.bufferram * sys_info.mem_unit;
     infos.totalSwap = sys_info.totalswap * sys_info.mem_unit;
     infos.freeSwap = sys_info.freeswap * sys_info.mem_unit;
+    infos.availableRam = readProcValue("/proc/meminfo", "MemAvailable");
 #elif defined(__APPLE__)
     uint64_t physmem;
     size_t len = sizeof physmem;
@@ -96,6 +126,9 @@ MemoryInfo getMemoryInfo()
     infos.totalRam = infos.freeRam = infos.totalSwap = infos.freeSwap = std::numeric_limits<std::size_t>::max();
 #endif
 
+    if(infos.availableRam == 0)
+        infos.availableRam = infos.freeRam;
+
     return infos;
 }
 
@@ -105,12 +138,64 @@ std::ostream& operator<<(std::ostream& os, const MemoryInfo& infos)
   os << std::setw(5)
      << "\t- Total RAM:  " << (infos.totalRam  / convertionGb) << " GB" << std::endl
      << "\t- Free RAM:   " << (infos.freeRam   / convertionGb) << " GB" << std::endl
+     << "\t- Available RAM: " << (infos.availableRam / convertionGb) << " GB" << std::endl
      << "\t- Total swap: " << (infos.totalSwap / convertionGb) << " GB" << std::endl
      << "\t- Free swap:  " << (infos.freeSwap  / convertionGb) << " GB" << std::endl;
   return os;
 }
-
+std::size_t getProcessMemory()
+{
+#if defined(__WINDOWS__)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+    return 0;
+#elif defined(__LINUX__)
+    return readProcValue("/proc/self/status", "VmRSS");
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+        return info.resident_size;
+    return 0;
+#else
+    return 0;
+#endif
 }
+
+std::size_t getProcessPeakMemory()
+{
+#if defined(__WINDOWS__)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#elif defined(__LINUX__)
+    return readProcValue("/proc/self/status", "VmHWM");
+#elif defined(__APPLE__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss; // in bytes on macOS
+    return 0;
+#else
+    return 0;
+#endif
 }
 
+bool resetProcessPeakMemory()
+{
+#if defined(__LINUX__)
+    // writing 5 to clear_refs resets the peak resident set size (VmHWM)
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    if(!clearRefs.is_open())
+        return false;
+    clearRefs << "5";
+    clearRefs.close();
+    return clearRefs.good();
+#else
+    return false;
+#endif
+}
 
+}
+}
@@ -16,6 +16,9 @@ struct MemoryInfo
 {
     std::size_t totalRam;
     std::size_t freeRam;
+    /// memory available for new processes without swapping (free memory and reclaimable caches),
+    /// equal to freeRam if the OS doesn't provide it
+    std::size_t availableRam;
     //	std::size_t sharedRam;
     //	std::size_t bufferRam;
     std::size_t totalSwap;
@@ -26,6 +29,25 @@ MemoryInfo getMemoryInfo();
 
 std::ostream& operator<<(std::ostream& os, const MemoryInfo& infos);
 
+/**
+ * @brief Get the resident memory currently used by the process
+ * @return the resident memory in bytes, 0 if unknown
+ */
+std::size_t getProcessMemory();
+
+/**
+ * @brief Get the peak resident memory used by the process
+ * @return the peak resident memory in bytes (since the last resetProcessPeakMemory), 0 if unknown
+ */
+std::size_t getProcessPeakMemory();
+
+/**
+ * @brief Reset the peak resident memory of the process to its current resident memory
+ * @note Only supported on Linux (kernel 4.0 or later)
+ * @return true if the peak memory has been reset
+ */
+bool resetProcessPeakMemory();
+
 }
 }
 
@@ -0,0 +1,339 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MemoryTracker.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+/// maximum number of samples kept, the oldest ones are decimated beyond
+const std::size_t maxNbSamples = 10000;
+
+inline double toMB(std::size_t bytes)
+{
+  return bytes / (1024.0 * 1024.0);
+}
+
+void writeJsonString(std::ostream& stream, const std::string& str)
+{
+  stream << '"';
+  for(const char c : str)
+  {
+    if(c == '"' || c == '\\')
+      stream << '\\' << c;
+    else if(static_cast<unsigned char>(c) < 0x20)
+      stream << ' ';
+    else
+      stream << c;
+  }
+  stream << '"';
+}
+
+} // namespace
+
+MemoryTracker& MemoryTracker::get()
+{
+  static MemoryTracker tracker;
+  return tracker;
+}
+
+MemoryTracker::MemoryTracker()
+  : _origin(std::chrono::steady_clock::now())
+{}
+
+MemoryTracker::~MemoryTracker()
+{
+  stop();
+}
+
+double MemoryTracker::now() const
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - _origin).count();
+}
+
+void MemoryTracker::start(std::chrono::milliseconds period)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(_thread.joinable())
+    return;
+
+  _stop = false;
+  _thread = std::thread([this, period]()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(!_stop)
+    {
+      lock.unlock();
+      sample();
+      lock.lock();
+      _wakeUp.wait_for(lock, period, [this]{ return _stop; });
+    }
+  });
+}
+
+void MemoryTracker::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(!_thread.joinable())
+      return;
+    _stop = true;
+  }
+  _wakeUp.notify_all();
+  _thread.join();
+}
+
+std::size_t MemoryTracker::getGpuMemory()
+{
+  std::lock_guard<std::mutex> lock(_providersMutex);
+  std::size_t bytes = 0;
+  for(const auto& provider : _gpuProviders)
+    bytes += provider.second();
+  return bytes;
+}
+
+void MemoryTracker::update(std::size_t rss, std::size_t peakRss, std::size_t gpu)
+{
+  _peakRss = std::max({_peakRss, rss, peakRss});
+  _peakGpu = std::max(_peakGpu, gpu);
+
+  for(std::size_t i = 0; i < _runningStages.size(); ++i)
+  {
+    MemoryStageReport& stage = _stages[_runningStages[i]];
+    stage.peakRss = std::max(stage.peakRss, rss);
+    // the process peak has been reached during the stage
+    if(peakRss > _runningStagesStartPeak[i])
+      stage.peakRss = std::max(stage.peakRss, peakRss);
+    stage.peakGpu = std::max(stage.peakGpu, gpu);
+  }
+}
+
+void MemoryTracker::sample()
+{
+  const std::size_t rss = getProcessMemory();
+  const std::size_t peakRss = getProcessPeakMemory();
+  const std::size_t gpu = getGpuMemory();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  update(rss, peakRss, gpu);
+
+  if(_nbSamples++ % _samplesStride != 0)
+    return;
+  if(_samples.size() == maxNbSamples)
+  {
+    // keep one sample out of two
+    for(std::size_t i = 0; i < _samples.size() / 2; ++i)
+      _samples[i] = _samples[2 * i];
+    _samples.resize(_samples.size() / 2);
+    _samplesStride *= 2;
+  }
+  MemorySample memorySample;
+  memorySample.time = now();
+  memorySample.rss = rss;
+  memorySample.gpu = gpu;
+  _samples.push_back(memorySample);
+}
+
+void MemoryTracker::beginStage(const std::string& name)
+{
+  const std::size_t rss = getProcessMemory();
+  const std::size_t peakRss = getProcessPeakMemory();
+  const std::size_t gpu = getGpuMemory();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  update(rss, peakRss, gpu);
+
+  MemoryStageReport stage;
+  stage.name = name;
+  stage.depth = static_cast<int>(_runningStages.size());
+  stage.start = now();
+  stage.startRss = rss;
+  stage.peakRss = rss;
+  stage.peakGpu = gpu;
+  stage.running = true;
+
+  _runningStages.push_back(_stages.size());
+  _runningStagesStartPeak.push_back(peakRss);
+  _stages.push_back(stage);
+}
+
+void MemoryTracker::endStage()
+{
+  const std::size_t rss = getProcessMemory();
+  const std::size_t peakRss = getProcessPeakMemory();
+  const std::size_t gpu = getGpuMemory();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(_runningStages.empty())
+    return;
+  update(rss, peakRss, gpu);
+
+  MemoryStageReport& stage = _stages[_runningStages.back()];
+  stage.duration = now() - stage.start;
+  stage.endRss = rss;
+  stage.running = false;
+
+  _runningStages.pop_back();
+  _runningStagesStartPeak.pop_back();
+}
+
+int MemoryTracker::addGpuMemoryProvider(std::function<std::size_t()> provider)
+{
+  std::lock_guard<std::mutex> lock(_providersMutex);
+  const int id = _nextProviderId++;
+  _gpuProviders[id] = std::move(provider);
+  return id;
+}
+
+void MemoryTracker::removeGpuMemoryProvider(int id)
+{
+  // keep the memory of the provider in the peaks
+  sample();
+
+  std::lock_guard<std::mutex> lock(_providersMutex);
+  _gpuProviders.erase(id);
+}
+
+std::vector<MemoryStageReport> MemoryTracker::getStages() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<MemoryStageReport> stages = _stages;
+  const double time = now();
+  for(MemoryStageReport& stage : stages)
+  {
+    if(stage.running)
+      stage.duration = time - stage.start;
+  }
+  return stages;
+}
+
+std::vector<MemorySample> MemoryTracker::getSamples() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _samples;
+}
+
+std::size_t MemoryTracker::getPeakRss() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _peakRss;
+}
+
+std::size_t MemoryTracker::getPeakGpu() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _peakGpu;
+}
+
+void MemoryTracker::logSummary() const
+{
+  const std::vector<MemoryStageReport> stages = getStages();
+  const std::size_t peakGpu = getPeakGpu();
+
+  std::ostringstream ss;
+  ss.setf(std::ios::fixed);
+  ss.precision(1);
+  ss << "Memory report:" << std::endl
+     << "\t- peak resident memory: " << toMB(getPeakRss()) << " MB" << std::endl;
+  if(peakGpu > 0)
+    ss << "\t- peak GPU memory: " << toMB(peakGpu) << " MB" << std::endl;
+
+  for(const MemoryStageReport& stage : stages)
+  {
+    ss << "\t" << std::string(2 * stage.depth, ' ') << "- " << stage.name << ": "
+       << stage.duration << " s, resident " << toMB(stage.startRss) << " -> " << toMB(stage.endRss)
+       << " MB (peak " << toMB(stage.peakRss) << " MB)";
+    if(peakGpu > 0)
+      ss << ", GPU peak " << toMB(stage.peakGpu) << " MB";
+    if(stage.running)
+      ss << " [running]";
+    ss << std::endl;
+  }
+  ALICEVISION_LOG_INFO(ss.str());
+}
+
+bool MemoryTracker::exportJson(const std::string& path) const
+{
+  std::ofstream stream(path);
+  if(!stream.is_open())
+    return false;
+
+  const std::vector<MemoryStageReport> stages = getStages();
+  const std::vector<MemorySample> samples = getSamples();
+
+  // the times are in seconds and the memory in bytes
+  stream.setf(std::ios::fixed);
+  stream.precision(3);
+  stream << "{\"peakRss\":" << getPeakRss() << ",\"peakGpu\":" << getPeakGpu() << ",\n\"stages\":[";
+  for(std::size_t i = 0; i < stages.size(); ++i)
+  {
+    const MemoryStageReport& stage = stages[i];
+    stream << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+    writeJsonString(stream, stage.name);
+    stream << ",\"depth\":" << stage.depth
+           << ",\"start\":" << stage.start
+           << ",\"duration\":" << stage.duration
+           << ",\"startRss\":" << stage.startRss
+           << ",\"endRss\":" << stage.endRss
+           << ",\"peakRss\":" << stage.peakRss
+           << ",\"peakGpu\":" << stage.peakGpu << "}";
+  }
+  stream << "\n],\n\"samples\":[";
+  for(std::size_t i = 0; i < samples.size(); ++i)
+  {
+    const MemorySample& sample = samples[i];
+    stream << (i == 0 ? "\n" : ",\n") << "[" << sample.time << "," << sample.rss << "," << sample.gpu << "]";
+  }
+  stream << "\n]}\n";
+
+  return stream.good();
+}
+
+MemoryReport::MemoryReport(const std::string& name)
+{
+  int periodMs = 200;
+  if(const char* period = std::getenv("ALICEVISION_MEMORY_SAMPLING_PERIOD"))
+    periodMs = std::atoi(period);
+  if(periodMs <= 0)
+    return;
+
+  _enabled = true;
+  MemoryTracker& tracker = MemoryTracker::get();
+  tracker.start(std::chrono::milliseconds(periodMs));
+  tracker.beginStage(name);
+}
+
+MemoryReport::~MemoryReport()
+{
+  if(!_enabled)
+    return;
+
+  MemoryTracker& tracker = MemoryTracker::get();
+  tracker.endStage();
+  tracker.stop();
+  tracker.logSummary();
+
+  const char* path = std::getenv("ALICEVISION_MEMORY_REPORT");
+  if(path == nullptr || *path == '\0')
+    return;
+
+  if(tracker.exportJson(path))
+    ALICEVISION_LOG_INFO("Memory report written to " << path);
+  else
+    ALICEVISION_LOG_ERROR("Cannot write the memory report to " << path);
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,223 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Memory used by a named stage of the process
+ */
+struct MemoryStageReport
+{
+  std::string name;
+  /// number of enclosing stages
+  int depth = 0;
+  /// start time (in s since the start of the tracker)
+  double start = 0.0;
+  /// duration (in s), up to now for a running stage
+  double duration = 0.0;
+  /// resident memory at the start and at the end of the stage (in bytes)
+  std::size_t startRss = 0;
+  std::size_t endRss = 0;
+  /// high-water mark of the resident memory during the stage (in bytes)
+  std::size_t peakRss = 0;
+  /// high-water mark of the GPU memory during the stage (in bytes)
+  std::size_t peakGpu = 0;
+  bool running = false;
+};
+
+/**
+ * @brief A sample of the memory of the process
+ */
+struct MemorySample
+{
+  /// time (in s since the start of the tracker)
+  double time = 0.0;
+  std::size_t rss = 0;
+  std::size_t gpu = 0;
+};
+
+/**
+ * @brief Background sampler of the memory of the process (resident memory and GPU memory),
+ *        recording its high-water mark per named stage, see MemoryStage and MemoryReport.
+ *
+ * The peak resident memory of a stage also uses the peak given by the OS (getProcessPeakMemory):
+ * a peak reached between two samples is kept if it is higher than the peak before the stage.
+ * The GPU memory is the sum of the bytes given by the GPU memory providers (e.g. the CUDA memory pools).
+ */
+class MemoryTracker
+{
+public:
+
+  /**
+   * @brief Get the tracker instance
+   */
+  static MemoryTracker& get();
+
+  MemoryTracker(const MemoryTracker&) = delete;
+  MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+  /**
+   * @brief Start the background sampling thread (nothing is done if it is running)
+   * @param[in] period The time between two samples
+   */
+  void start(std::chrono::milliseconds period = std::chrono::milliseconds(200));
+
+  /**
+   * @brief Stop the background sampling thread, the stages and the samples are kept
+   */
+  void stop();
+
+  /**
+   * @brief Sample the memory now and update the peak of the running stages
+   */
+  void sample();
+
+  /**
+   * @brief Start a stage, nested in the running stages
+   * @param[in] name The stage name
+   */
+  void beginStage(const std::string& name);
+
+  /**
+   * @brief End the last started running stage
+   */
+  void endStage();
+
+  /**
+   * @brief Add a function giving GPU memory used by the process
+   * @param[in] provider The function, returning a number of bytes (called from the sampling thread)
+   * @return the id of the provider, for removeGpuMemoryProvider
+   */
+  int addGpuMemoryProvider(std::function<std::size_t()> provider);
+
+  /**
+   * @brief Remove a GPU memory provider, after a last sample of its memory
+   * @param[in] id The id given by addGpuMemoryProvider
+   */
+  void removeGpuMemoryProvider(int id);
+
+  /**
+   * @brief Get the stages, in the order of their start
+   */
+  std::vector<MemoryStageReport> getStages() const;
+
+  /**
+   * @brief Get the samples taken since the start of the tracker (the oldest ones are decimated)
+   */
+  std::vector<MemorySample> getSamples() const;
+
+  /// High-water mark of the resident memory of the process since the start of the tracker
+  std::size_t getPeakRss() const;
+
+  /// High-water mark of the GPU memory since the start of the tracker
+  std::size_t getPeakGpu() const;
+
+  /**
+   * @brief Log the duration and the memory of each stage, nested as the stages
+   */
+  void logSummary() const;
+
+  /**
+   * @brief Write the stages and the samples in a JSON file
+   * @param[in] path The output JSON file path
+   * @return true if the file is written
+   */
+  bool exportJson(const std::string& path) const;
+
+private:
+
+  MemoryTracker();
+  ~MemoryTracker();
+
+  double now() const;
+  std::size_t getGpuMemory();
+  /// update the peaks with a sample (_mutex locked)
+  void update(std::size_t rss, std::size_t peakRss, std::size_t gpu);
+
+  const std::chrono::steady_clock::time_point _origin;
+
+  mutable std::mutex _mutex;
+  std::vector<MemoryStageReport> _stages;
+  /// indexes of the running stages in _stages, the last one is the innermost
+  std::vector<std::size_t> _runningStages;
+  /// process peak resident memory given by the OS at the start of each running stage
+  std::vector<std::size_t> _runningStagesStartPeak;
+  std::vector<MemorySample> _samples;
+  /// keep one sample out of _samplesStride
+  std::size_t _samplesStride = 1;
+  std::size_t _nbSamples = 0;
+  std::size_t _peakRss = 0;
+  std::size_t _peakGpu = 0;
+
+  std::mutex _providersMutex;
+  std::map<int, std::function<std::size_t()>> _gpuProviders;
+  int _nextProviderId = 0;
+
+  std::thread _thread;
+  std::condition_variable _wakeUp;
+  bool _stop = false;
+};
+
+/**
+ * @brief Record the memory used during the enclosing C++ scope, as a stage of the MemoryTracker
+ */
+class MemoryStage
+{
+public:
+  explicit MemoryStage(const std::string& name)
+  {
+    MemoryTracker::get().beginStage(name);
+  }
+
+  ~MemoryStage()
+  {
+    MemoryTracker::get().endStage();
+  }
+
+  MemoryStage(const MemoryStage&) = delete;
+  MemoryStage& operator=(const MemoryStage&) = delete;
+};
+
+/**
+ * @brief Sample the memory during its scope (the main function of an executable) and log the
+ *        timings and the memory of the stages at its end.
+ *
+ * The sampling period in ms is given by the environment variable ALICEVISION_MEMORY_SAMPLING_PERIOD
+ * (200 by default, 0 to disable the tracker) and the environment variable ALICEVISION_MEMORY_REPORT
+ * gives the path of a JSON file with the stages and the samples.
+ */
+class MemoryReport
+{
+public:
+  /**
+   * @param[in] name The name of the stage of the whole scope (the executable name)
+   */
+  explicit MemoryReport(const std::string& name = "total");
+  ~MemoryReport();
+
+  MemoryReport(const MemoryReport&) = delete;
+  MemoryReport& operator=(const MemoryReport&) = delete;
+
+private:
+  bool _enabled = false;
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,41 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ParallelReduce.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+std::atomic<bool>& deterministicMode()
+{
+  static std::atomic<bool> deterministic([]()
+  {
+    const char* envDeterministic = std::getenv("ALICEVISION_DETERMINISTIC");
+    return envDeterministic != nullptr && std::strcmp(envDeterministic, "1") == 0;
+  }());
+  return deterministic;
+}
+
+} // namespace
+
+bool isDeterministic()
+{
+  return deterministicMode().load(std::memory_order_relaxed);
+}
+
+void setDeterministic(bool deterministic)
+{
+  deterministicMode().store(deterministic, std::memory_order_relaxed);
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,163 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/TaskPool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Whether the parallel algorithms must give bit-identical results whatever the number of threads.
+ *        Disabled by default, enabled if the environment variable ALICEVISION_DETERMINISTIC is set to 1.
+ */
+bool isDeterministic();
+
+/**
+ * @brief Enable or disable the deterministic mode of the whole process (e.g. from a --deterministic option).
+ *        The stages having a faster non-deterministic alternative (atomic sums, parallel maxflow) check it.
+ */
+void setDeterministic(bool deterministic);
+
+namespace detail {
+
+/**
+ * @brief Number of consecutive iterations of a block of parallelReduce and parallelCollect.
+ *        In deterministic mode, the partition only depends on the number of iterations.
+ */
+inline std::int64_t getReduceBlockSize(std::int64_t nbIterations, std::int64_t blockSize, TaskPool& pool)
+{
+  if(blockSize > 0)
+    return blockSize;
+  if(isDeterministic())
+    return 1024;
+  return std::max<std::int64_t>(1, nbIterations / (8 * pool.getNbThreads()));
+}
+
+} // namespace detail
+
+/**
+ * @brief Parallel reduction of [begin, end) with a fixed partition and a fixed tree.
+ *
+ * The iterations are split in blocks of consecutive iterations, each block is accumulated
+ * in the order of its iterations, then the blocks are combined two by two (pairwise tree,
+ * whatever the threads scheduling). With a fixed block size (or in deterministic mode),
+ * the floating point result does not depend on the number of threads.
+ *
+ * @param[in] begin, end The range of iterations
+ * @param[in] identity The neutral value of combine, the initial value of each block
+ * @param[in] accumulate The accumulation of an iteration: accumulate(T& value, Index i)
+ * @param[in] combine The reduction of two values: T combine(const T& left, const T& right),
+ *            left holds the lower iterations
+ * @param[in] blockSize The number of iterations of a block, 0 for automatic
+ * @param[in] pool The threads
+ * @return the reduction of all the iterations, identity for an empty range
+ */
+template <class T, class Index, class Accumulate, class Combine>
+T parallelReduce(Index begin, Index end, const T& identity, const Accumulate& accumulate, const Combine& combine,
+                 std::int64_t blockSize = 0, TaskPool& pool = TaskPool::get())
+{
+  if(end <= begin)
+    return identity;
+
+  const std::int64_t nbIterations = static_cast<std::int64_t>(end - begin);
+  blockSize = detail::getReduceBlockSize(nbIterations, blockSize, pool);
+  const std::int64_t nbBlocks = (nbIterations + blockSize - 1) / blockSize;
+
+  std::vector<T> blockValues(nbBlocks, identity);
+
+  ParallelForOptions options;
+  options.grainSize = 1;
+  parallelFor(std::int64_t(0), nbBlocks, [&](std::int64_t b)
+  {
+    T& value = blockValues[b];
+    const std::int64_t blockEnd = std::min(nbIterations, (b + 1) * blockSize);
+    for(std::int64_t i = b * blockSize; i < blockEnd; ++i)
+      accumulate(value, static_cast<Index>(begin + i));
+  }, options, pool);
+
+  // pairwise tree: level by level, blockValues[i] = combine(blockValues[i], blockValues[i + stride])
+  for(std::int64_t stride = 1; stride < nbBlocks; stride *= 2)
+  {
+    const std::int64_t nbPairs = (nbBlocks - stride + 2 * stride - 1) / (2 * stride);
+    const auto combinePair = [&](std::int64_t p)
+    {
+      const std::int64_t left = p * 2 * stride;
+      blockValues[left] = combine(blockValues[left], blockValues[left + stride]);
+    };
+
+    // the last levels are too small to be worth the tasks
+    if(nbPairs < 64)
+    {
+      for(std::int64_t p = 0; p < nbPairs; ++p)
+        combinePair(p);
+    }
+    else
+    {
+      parallelFor(std::int64_t(0), nbPairs, combinePair, ParallelForOptions(), pool);
+    }
+  }
+
+  return blockValues.front();
+}
+
+/**
+ * @brief Parallel loop whose outputs are merged in the order of the iterations.
+ *
+ * Each block of consecutive iterations appends its elements to its own vector,
+ * the vectors are then concatenated in the order of the blocks: the result is the same
+ * as the sequential loop, whatever the number of threads and the block size.
+ *
+ * @param[in] begin, end The range of iterations
+ * @param[in] produce The elements of an iteration: produce(std::vector<T>& output, Index i) appends to output
+ * @param[out] result The elements of all the iterations, appended in the order of the iterations
+ * @param[in] blockSize The number of iterations of a block, 0 for automatic
+ * @param[in] pool The threads
+ */
+template <class T, class Index, class Produce>
+void parallelCollect(Index begin, Index end, const Produce& produce, std::vector<T>& result,
+                     std::int64_t blockSize = 0, TaskPool& pool = TaskPool::get())
+{
+  if(end <= begin)
+    return;
+
+  const std::int64_t nbIterations = static_cast<std::int64_t>(end - begin);
+  blockSize = detail::getReduceBlockSize(nbIterations, blockSize, pool);
+  const std::int64_t nbBlocks = (nbIterations + blockSize - 1) / blockSize;
+
+  std::vector<std::vector<T>> blockOutputs(nbBlocks);
+
+  ParallelForOptions options;
+  options.grainSize = 1;
+  parallelFor(std::int64_t(0), nbBlocks, [&](std::int64_t b)
+  {
+    std::vector<T>& output = blockOutputs[b];
+    const std::int64_t blockEnd = std::min(nbIterations, (b + 1) * blockSize);
+    for(std::int64_t i = b * blockSize; i < blockEnd; ++i)
+      produce(output, static_cast<Index>(begin + i));
+  }, options, pool);
+
+  // offset of each block in the result
+  std::vector<std::size_t> offsets(nbBlocks + 1, result.size());
+  for(std::int64_t b = 0; b < nbBlocks; ++b)
+    offsets[b + 1] = offsets[b] + blockOutputs[b].size();
+
+  result.resize(offsets.back());
+  parallelFor(std::int64_t(0), nbBlocks, [&](std::int64_t b)
+  {
+    std::move(blockOutputs[b].begin(), blockOutputs[b].end(), result.begin() + offsets[b]);
+    blockOutputs[b] = std::vector<T>();
+  }, options, pool);
+}
+
+} // namespace system
+} // namespace aliceVision
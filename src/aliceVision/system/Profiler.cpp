@@ -0,0 +1,297 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Profiler.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief The ring buffer of the events of a thread, only written by its thread
+ */
+struct Profiler::ThreadEvents
+{
+  explicit ThreadEvents(std::size_t capacity)
+    : events(capacity)
+  {}
+
+  std::vector<ProfilerEvent> events;
+  /// number of events recorded since the last clear
+  std::atomic<std::size_t> nbRecorded{0};
+};
+
+Profiler& Profiler::get()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler()
+  : _origin(std::chrono::steady_clock::now())
+{
+  const char* tracePath = std::getenv("ALICEVISION_PROFILER_TRACE");
+  if(tracePath != nullptr && tracePath[0] != '\0')
+  {
+    _tracePath = tracePath;
+    enable();
+  }
+}
+
+Profiler::~Profiler() = default;
+
+void Profiler::enable(std::size_t threadCapacity)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _threadCapacity = std::max(std::size_t(1), threadCapacity);
+  }
+  _enabled.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::disable()
+{
+  _enabled.store(false, std::memory_order_relaxed);
+}
+
+void Profiler::clear()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for(auto& thread : _threads)
+    thread->nbRecorded.store(0, std::memory_order_release);
+}
+
+int& Profiler::threadDepth()
+{
+  static thread_local int depth = 0;
+  return depth;
+}
+
+Profiler::ThreadEvents& Profiler::threadEvents()
+{
+  // the buffers are never destroyed before the profiler: the pointer stays valid for the thread lifetime
+  static thread_local ThreadEvents* events = nullptr;
+  if(events == nullptr)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _threads.emplace_back(new ThreadEvents(_threadCapacity));
+    events = _threads.back().get();
+  }
+  return *events;
+}
+
+void Profiler::record(const ProfilerEvent& event)
+{
+  ThreadEvents& thread = threadEvents();
+  const std::size_t nbRecorded = thread.nbRecorded.load(std::memory_order_relaxed);
+  thread.events[nbRecorded % thread.events.size()] = event;
+  thread.nbRecorded.store(nbRecorded + 1, std::memory_order_release);
+}
+
+std::vector<std::vector<ProfilerEvent>> Profiler::getEvents() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<std::vector<ProfilerEvent>> threadsEvents;
+  threadsEvents.reserve(_threads.size());
+
+  for(const auto& thread : _threads)
+  {
+    const std::size_t nbRecorded = thread->nbRecorded.load(std::memory_order_acquire);
+    const std::size_t capacity = thread->events.size();
+    const std::size_t first = (nbRecorded > capacity) ? nbRecorded - capacity : 0;
+
+    std::vector<ProfilerEvent> events;
+    events.reserve(nbRecorded - first);
+    for(std::size_t i = first; i < nbRecorded; ++i)
+      events.push_back(thread->events[i % capacity]);
+    threadsEvents.push_back(std::move(events));
+  }
+  return threadsEvents;
+}
+
+std::size_t Profiler::getNbDroppedEvents() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::size_t nbDropped = 0;
+  for(const auto& thread : _threads)
+  {
+    const std::size_t nbRecorded = thread->nbRecorded.load(std::memory_order_acquire);
+    nbDropped += (nbRecorded > thread->events.size()) ? nbRecorded - thread->events.size() : 0;
+  }
+  return nbDropped;
+}
+
+void Profiler::logSummary() const
+{
+  // statistics of a scope, identified by its label and the labels of its enclosing scopes
+  struct ScopeStats
+  {
+    int depth = 0;
+    const char* label = nullptr;
+    std::size_t nbCalls = 0;
+    std::int64_t duration = 0;
+    std::uint64_t bytes = 0;
+    std::set<std::size_t> threads;
+  };
+
+  // the path separator sorts before the label characters: the scopes are listed under their parent
+  const char separator = '\x1f';
+  std::map<std::string, ScopeStats> scopesStats;
+
+  const std::vector<std::vector<ProfilerEvent>> threadsEvents = getEvents();
+  for(std::size_t t = 0; t < threadsEvents.size(); ++t)
+  {
+    // the events are recorded at their end: visit them from their start to rebuild the paths
+    std::vector<ProfilerEvent> events = threadsEvents[t];
+    std::stable_sort(events.begin(), events.end(), [](const ProfilerEvent& a, const ProfilerEvent& b) {
+      return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+    });
+
+    std::vector<std::string> paths;
+    for(const ProfilerEvent& event : events)
+    {
+      // the enclosing scopes may have been overwritten in the ring buffer
+      paths.resize(std::min(paths.size(), static_cast<std::size_t>(event.depth)));
+      const std::string path = (paths.empty() ? std::string() : paths.back() + separator) + event.label;
+      paths.push_back(path);
+
+      ScopeStats& stats = scopesStats[path];
+      stats.depth = static_cast<int>(paths.size()) - 1;
+      stats.label = event.label;
+      ++stats.nbCalls;
+      stats.duration += event.end - event.start;
+      stats.bytes += event.bytes;
+      stats.threads.insert(t);
+    }
+  }
+
+  if(scopesStats.empty())
+    return;
+
+  std::ostringstream summary;
+  summary.setf(std::ios::fixed);
+  summary.precision(3);
+  summary << "Profiler summary (total time of the scopes over all the threads):";
+  for(const auto& scopeStats : scopesStats)
+  {
+    const ScopeStats& stats = scopeStats.second;
+    const double durationMs = stats.duration / 1e6;
+
+    summary << "\n\t" << std::string(2 * stats.depth, ' ') << stats.label << ": ";
+    // prettyTime only prints whole milliseconds
+    if(durationMs >= 1000.0)
+      summary << prettyTime(durationMs);
+    else
+      summary << durationMs << "ms";
+
+    summary << " (" << stats.nbCalls << " call(s), " << stats.threads.size() << " thread(s)";
+    if(stats.bytes > 0)
+    {
+      const double megaBytes = stats.bytes / (1024.0 * 1024.0);
+      summary << ", " << megaBytes << " MB";
+      if(durationMs > 0)
+        summary << ", " << megaBytes / (durationMs / 1000.0) << " MB/s";
+    }
+    summary << ")";
+  }
+
+  const std::size_t nbDropped = getNbDroppedEvents();
+  if(nbDropped > 0)
+    summary << "\n\t" << nbDropped << " event(s) overwritten in the full thread buffers are missing.";
+
+  ALICEVISION_LOG_INFO(summary.str());
+}
+
+/**
+ * @brief Write a string as a JSON string
+ * @param[in,out] stream The output stream
+ * @param[in] str The string
+ */
+static void writeJsonString(std::ostream& stream, const char* str)
+{
+  stream << '"';
+  for(const char* c = str; *c != '\0'; ++c)
+  {
+    if(*c == '"' || *c == '\\')
+    {
+      stream << '\\' << *c;
+    }
+    else if(static_cast<unsigned char>(*c) < 0x20)
+    {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(*c));
+      stream << escaped;
+    }
+    else
+    {
+      stream << *c;
+    }
+  }
+  stream << '"';
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) const
+{
+  std::ofstream stream(path);
+  if(!stream.is_open())
+    return false;
+
+  // complete events ("X"), the timestamps are in microseconds
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  stream.setf(std::ios::fixed);
+  stream.precision(3);
+
+  bool first = true;
+  const std::vector<std::vector<ProfilerEvent>> threadsEvents = getEvents();
+  for(std::size_t t = 0; t < threadsEvents.size(); ++t)
+  {
+    for(const ProfilerEvent& event : threadsEvents[t])
+    {
+      stream << (first ? "\n" : ",\n") << "{\"name\":";
+      writeJsonString(stream, event.label);
+      stream << ",\"cat\":\"aliceVision\",\"ph\":\"X\",\"pid\":0,\"tid\":" << t
+             << ",\"ts\":" << event.start / 1000.0
+             << ",\"dur\":" << (event.end - event.start) / 1000.0;
+      if(event.bytes > 0)
+        stream << ",\"args\":{\"bytes\":" << event.bytes << "}";
+      stream << "}";
+      first = false;
+    }
+  }
+  stream << "\n]}\n";
+
+  return stream.good();
+}
+
+ProfilerReport::~ProfilerReport()
+{
+  Profiler& profiler = Profiler::get();
+  if(!profiler.isEnabled())
+    return;
+
+  profiler.logSummary();
+
+  const std::string& tracePath = profiler.getTracePath();
+  if(tracePath.empty())
+    return;
+
+  if(profiler.exportChromeTrace(tracePath))
+    ALICEVISION_LOG_INFO("Profiler trace written to " << tracePath);
+  else
+    ALICEVISION_LOG_ERROR("Cannot write the profiler trace to " << tracePath);
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,255 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/nvtx.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief A profiled scope: its label, its duration and the number of bytes it processed
+ */
+struct ProfilerEvent
+{
+  /// label of the scope, with a static storage duration (string literal)
+  const char* label = nullptr;
+  /// start time (in ns since the start of the profiler)
+  std::int64_t start = 0;
+  /// end time (in ns since the start of the profiler)
+  std::int64_t end = 0;
+  /// number of bytes processed in the scope (0 if not given)
+  std::uint64_t bytes = 0;
+  /// number of enclosing scopes in the thread
+  int depth = 0;
+};
+
+/**
+ * @brief Lightweight profiler of nested scopes, see ALICEVISION_PROFILE_SCOPE.
+ *
+ * Each thread records its events in its own ring buffer, without synchronization:
+ * when the ring is full, the oldest events of the thread are overwritten.
+ * The events are read (summary, Chrome trace export) once the profiled work is done.
+ *
+ * The profiler is disabled by default. It is enabled at startup when the environment
+ * variable ALICEVISION_PROFILER_TRACE gives the path of a Chrome trace file,
+ * written at the end of the ALICEVISION_PROFILE_REPORT scope.
+ */
+class Profiler
+{
+public:
+
+  /**
+   * @brief Get the profiler instance
+   * @return instance
+   */
+  static Profiler& get();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  /**
+   * @brief Start recording the events
+   * @param[in] threadCapacity The maximum number of events kept per thread
+   */
+  void enable(std::size_t threadCapacity = 1 << 16);
+
+  /**
+   * @brief Stop recording the events, the recorded events are kept
+   */
+  void disable();
+
+  /**
+   * @brief Returns true if the events are recorded
+   */
+  inline bool isEnabled() const
+  {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Remove the recorded events (no scope must be running)
+   */
+  void clear();
+
+  /**
+   * @brief Get the current time of the profiler clock
+   * @return the time in ns since the start of the profiler
+   */
+  inline std::int64_t now() const
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _origin).count();
+  }
+
+  /**
+   * @brief Record an event of the calling thread
+   * @param[in] event The event
+   */
+  void record(const ProfilerEvent& event);
+
+  /**
+   * @brief Get the recorded events of each thread, in the order of their end time
+   * @return the events per thread (in the order of the first event of the threads)
+   */
+  std::vector<std::vector<ProfilerEvent>> getEvents() const;
+
+  /**
+   * @brief Get the number of events overwritten because a thread ring buffer was full
+   */
+  std::size_t getNbDroppedEvents() const;
+
+  /**
+   * @brief Log the total time, the number of calls and the bytes of each label,
+   *        the labels being nested as their scopes
+   */
+  void logSummary() const;
+
+  /**
+   * @brief Write the recorded events in a Chrome trace file (chrome://tracing, Perfetto)
+   * @param[in] path The output JSON file path
+   * @return true if the file is written
+   */
+  bool exportChromeTrace(const std::string& path) const;
+
+  /**
+   * @brief Get the path of the Chrome trace file given by the environment (empty if none)
+   */
+  const std::string& getTracePath() const
+  {
+    return _tracePath;
+  }
+
+  /**
+   * @brief Get the scope depth of the calling thread
+   * @return a reference on the depth counter of the thread
+   */
+  static int& threadDepth();
+
+private:
+
+  struct ThreadEvents;
+
+  Profiler();
+  ~Profiler();
+
+  ThreadEvents& threadEvents();
+
+  std::atomic<bool> _enabled{false};
+  std::size_t _threadCapacity = 1 << 16;
+  const std::chrono::steady_clock::time_point _origin;
+  std::string _tracePath;
+
+  mutable std::mutex _mutex;
+  std::vector<std::unique_ptr<ThreadEvents>> _threads;
+};
+
+/**
+ * @brief Record the duration of the enclosing C++ scope, see ALICEVISION_PROFILE_SCOPE
+ */
+class ProfilerScope
+{
+public:
+
+  /**
+   * @brief Start the scope
+   * @param[in] label The scope label, with a static storage duration (string literal)
+   * @param[in] bytes The number of bytes processed in the scope (0 if unknown)
+   * @param[in] file The source file of the scope, for the NVTX ranges
+   * @param[in] line The source line of the scope, for the NVTX ranges
+   */
+  explicit ProfilerScope(const char* label, std::uint64_t bytes = 0, const char* file = "", int line = 0)
+  {
+    nvtxPushA(label, file, line);
+    if(Profiler::get().isEnabled())
+    {
+      _event.label = label;
+      _event.bytes = bytes;
+      _event.depth = Profiler::threadDepth()++;
+      _event.start = Profiler::get().now();
+    }
+  }
+
+  ~ProfilerScope()
+  {
+    if(_event.label != nullptr)
+    {
+      _event.end = Profiler::get().now();
+      --Profiler::threadDepth();
+      Profiler::get().record(_event);
+    }
+    nvtxPop(_event.label);
+  }
+
+  ProfilerScope(const ProfilerScope&) = delete;
+  ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+  /**
+   * @brief Add bytes processed in the scope
+   * @param[in] bytes The number of bytes
+   */
+  inline void addBytes(std::uint64_t bytes)
+  {
+    _event.bytes += bytes;
+  }
+
+private:
+  ProfilerEvent _event;
+};
+
+/**
+ * @brief Log the profiler summary and write the Chrome trace file given by the environment
+ *        at the end of its scope, see ALICEVISION_PROFILE_REPORT
+ */
+class ProfilerReport
+{
+public:
+  ProfilerReport() = default;
+  ~ProfilerReport();
+
+  ProfilerReport(const ProfilerReport&) = delete;
+  ProfilerReport& operator=(const ProfilerReport&) = delete;
+};
+
+} // namespace system
+} // namespace aliceVision
+
+/**
+ * The profiler macros are compiled with ALICEVISION_USE_PROFILER (ALICEVISION_USE_PROFILING CMake option)
+ * and don't generate any code without.
+ *
+ * ALICEVISION_PROFILE_SCOPE("label") records the enclosing scope.
+ * ALICEVISION_PROFILE_SCOPE_BYTES("label", bytes) also records the number of bytes it processes.
+ * ALICEVISION_PROFILE_REPORT() reports the profiled events at the end of its scope (the main function).
+ */
+#ifdef ALICEVISION_USE_PROFILER
+
+#define ALICEVISION_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ALICEVISION_PROFILE_CONCAT(a, b) ALICEVISION_PROFILE_CONCAT_IMPL(a, b)
+
+#define ALICEVISION_PROFILE_SCOPE(label) \
+  const ::aliceVision::system::ProfilerScope ALICEVISION_PROFILE_CONCAT(aliceVisionProfilerScope, __LINE__)(label, 0, __FILE__, __LINE__)
+#define ALICEVISION_PROFILE_SCOPE_BYTES(label, bytes) \
+  const ::aliceVision::system::ProfilerScope ALICEVISION_PROFILE_CONCAT(aliceVisionProfilerScope, __LINE__)(label, bytes, __FILE__, __LINE__)
+#define ALICEVISION_PROFILE_REPORT() \
+  const ::aliceVision::system::ProfilerReport aliceVisionProfilerReport
+
+#else
+
+#define ALICEVISION_PROFILE_SCOPE(label)
+#define ALICEVISION_PROFILE_SCOPE_BYTES(label, bytes)
+#define ALICEVISION_PROFILE_REPORT()
+
+#endif
@@ -0,0 +1,251 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Lock-free bounded FIFO queue with multiple producers and multiple consumers,
+ *        used to connect the stages of a pipeline.
+ *
+ * The elements are stored in a ring of preallocated cells, push and pop don't allocate.
+ * Each cell has a sequence number telling if it is ready to be written or read
+ * (bounded MPMC queue of D. Vyukov), the producers and the consumers only
+ * synchronize on the write and read positions, which are on separate cache lines.
+ *
+ * tryPush() and tryPop() never wait. push() waits while the ring is full and pop() waits
+ * while the ring is empty, spinning first then sleeping. Once the producers are done,
+ * close() wakes up the consumers, pop() returns false when the ring is closed and empty.
+ */
+template<class T>
+class RingBuffer
+{
+public:
+
+  /**
+   * @brief Build a ring buffer of the given size.
+   * @param[in] maxSize The maximum number of elements in the ring,
+   *            rounded up to the next power of two (at least 2)
+   */
+  explicit RingBuffer(std::size_t maxSize)
+    : _capacity(roundCapacity(maxSize))
+    , _mask(_capacity - 1)
+    , _cells(new Cell[_capacity])
+  {
+    for(std::size_t i = 0; i < _capacity; ++i)
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  ~RingBuffer()
+  {
+    // destroy the remaining elements
+    const std::size_t writePosition = _writePosition.load(std::memory_order_acquire);
+    for(std::size_t position = _readPosition.load(std::memory_order_acquire); position != writePosition; ++position)
+      reinterpret_cast<T*>(&_cells[position & _mask].storage)->~T();
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  /**
+   * @brief Add an element at the end of the ring if it is not full.
+   * @param[in,out] element The element to add, moved only if it is added
+   * @return false if the ring is full
+   */
+  bool tryPush(T& element)
+  {
+    Cell* cell;
+    std::size_t position = _writePosition.load(std::memory_order_relaxed);
+
+    for(;;)
+    {
+      cell = &_cells[position & _mask];
+      const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+      if(diff == 0)
+      {
+        // the cell is free, reserve it
+        if(_writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if(diff < 0)
+      {
+        // the cell is not read yet
+        return false;
+      }
+      else
+      {
+        // another producer has reserved the cell
+        position = _writePosition.load(std::memory_order_relaxed);
+      }
+    }
+
+    new(&cell->storage) T(std::move(element));
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the first element of the ring if it is not empty.
+   * @param[out] element The removed element
+   * @return false if the ring is empty
+   */
+  bool tryPop(T& element)
+  {
+    Cell* cell;
+    std::size_t position = _readPosition.load(std::memory_order_relaxed);
+
+    for(;;)
+    {
+      cell = &_cells[position & _mask];
+      const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+
+      if(diff == 0)
+      {
+        // the cell is written, reserve it
+        if(_readPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if(diff < 0)
+      {
+        // the cell is not written yet
+        return false;
+      }
+      else
+      {
+        // another consumer has reserved the cell
+        position = _readPosition.load(std::memory_order_relaxed);
+      }
+    }
+
+    T* value = reinterpret_cast<T*>(&cell->storage);
+    element = std::move(*value);
+    value->~T();
+
+    // the cell is free for the producers of the next round
+    cell->sequence.store(position + _capacity, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Add an element at the end of the ring, wait while the ring is full.
+   * @param[in] element The element to add
+   * @return false if the ring is closed, the element is not added
+   */
+  bool push(T element)
+  {
+    for(std::size_t nbTries = 0; !_closed.load(std::memory_order_acquire); ++nbTries)
+    {
+      if(tryPush(element))
+        return true;
+      wait(nbTries);
+    }
+    return false;
+  }
+
+  /**
+   * @brief Remove the first element of the ring, wait while the ring is empty.
+   * @param[out] element The removed element
+   * @return false if the ring is closed and empty
+   */
+  bool pop(T& element)
+  {
+    for(std::size_t nbTries = 0;; ++nbTries)
+    {
+      if(tryPop(element))
+        return true;
+
+      // the elements pushed before close() are visible once closed is read
+      if(_closed.load(std::memory_order_acquire))
+        return tryPop(element);
+
+      wait(nbTries);
+    }
+  }
+
+  /**
+   * @brief Close the ring: no more element can be pushed,
+   *        the remaining elements can still be popped.
+   */
+  void close()
+  {
+    _closed.store(true, std::memory_order_release);
+  }
+
+  bool isClosed() const
+  {
+    return _closed.load(std::memory_order_acquire);
+  }
+
+  /// The maximum number of elements in the ring
+  std::size_t maxSize() const
+  {
+    return _capacity;
+  }
+
+private:
+
+  struct Cell
+  {
+    std::atomic<std::size_t> sequence;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  /// Size of the padding between the positions shared by the producers and the consumers
+  static constexpr std::size_t cacheLineSize = 64;
+
+  static std::size_t roundCapacity(std::size_t maxSize)
+  {
+    std::size_t capacity = 2;
+    while(capacity < maxSize)
+      capacity <<= 1;
+    return capacity;
+  }
+
+  /**
+   * @brief Back off while the ring is full or empty:
+   *        spin for short waits, then yield, then sleep for the slow pipeline stages.
+   */
+  static void wait(std::size_t nbTries)
+  {
+    if(nbTries < 64)
+      return;
+    if(nbTries < 128)
+      std::this_thread::yield();
+    else
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  const std::size_t _capacity;
+  const std::size_t _mask;
+  std::unique_ptr<Cell[]> _cells;
+
+  char _padding0[cacheLineSize];
+  /// position of the next element to pop, shared by the consumers
+  std::atomic<std::size_t> _readPosition{0};
+  char _padding1[cacheLineSize];
+  /// position of the next element to push, shared by the producers
+  std::atomic<std::size_t> _writePosition{0};
+  char _padding2[cacheLineSize];
+  std::atomic<bool> _closed{false};
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,845 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Storage.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+/// get the scheme of an URL, empty for a local path
+std::string getScheme(const std::string& path)
+{
+  const std::size_t pos = path.find("://");
+  if(pos == std::string::npos || pos == 0)
+    return std::string();
+  for(std::size_t i = 0; i < pos; ++i)
+  {
+    if(!std::isalpha(static_cast<unsigned char>(path[i])))
+      return std::string();
+  }
+  std::string scheme = path.substr(0, pos);
+  std::transform(scheme.begin(), scheme.end(), scheme.begin(), ::tolower);
+  return scheme;
+}
+
+/// write a file at once: write a temporary file, then rename it
+void writeLocalFile(const std::string& path, const char* data, std::uint64_t size)
+{
+  const fs::path filePath(path);
+  if(filePath.has_parent_path() && !fs::exists(filePath.parent_path()))
+    fs::create_directories(filePath.parent_path());
+
+  const std::string tmpPath = path + "." + fs::unique_path("%%%%-%%%%-%%%%-%%%%.tmp").string();
+  {
+    std::ofstream stream(tmpPath.c_str(), std::ios::out | std::ios::binary);
+    if(!stream.is_open() || !stream.write(data, size))
+      throw std::runtime_error("Can't write the file '" + path + "'.");
+  }
+  fs::rename(tmpPath, path);
+}
+
+struct Url
+{
+  std::string host;
+  std::string port;
+  /// path and query
+  std::string target;
+};
+
+Url parseUrl(const std::string& url)
+{
+  const std::string scheme = getScheme(url);
+  if(scheme != "http")
+    throw std::runtime_error("Unsupported URL scheme (only http): '" + url + "'.");
+
+  const std::size_t hostBegin = scheme.size() + 3;
+  std::size_t hostEnd = url.find('/', hostBegin);
+  if(hostEnd == std::string::npos)
+    hostEnd = url.size();
+
+  Url result;
+  result.host = url.substr(hostBegin, hostEnd - hostBegin);
+  result.port = "80";
+  result.target = hostEnd < url.size() ? url.substr(hostEnd) : "/";
+
+  const std::size_t portPos = result.host.rfind(':');
+  if(portPos != std::string::npos)
+  {
+    result.port = result.host.substr(portPos + 1);
+    result.host.resize(portPos);
+  }
+  if(result.host.empty())
+    throw std::runtime_error("Invalid URL: '" + url + "'.");
+  return result;
+}
+
+struct HttpResponse
+{
+  int status = 0;
+  std::map<std::string, std::string> headers; ///< lower case names
+  std::vector<char> body;
+
+  std::string getHeader(const std::string& name) const
+  {
+    const auto it = headers.find(name);
+    return it == headers.end() ? std::string() : it->second;
+  }
+};
+
+/// decode a body with the chunked transfer encoding
+std::vector<char> decodeChunkedBody(const std::vector<char>& data)
+{
+  std::vector<char> body;
+  std::size_t pos = 0;
+  while(pos < data.size())
+  {
+    const auto lineEnd = std::search(data.begin() + pos, data.end(), "\r\n", "\r\n" + 2);
+    if(lineEnd == data.end())
+      break;
+    const std::size_t chunkSize = std::strtoull(std::string(data.begin() + pos, lineEnd).c_str(), nullptr, 16);
+    pos = (lineEnd - data.begin()) + 2;
+    if(chunkSize == 0)
+      break;
+    if(chunkSize > data.size() - pos)
+      throw std::runtime_error("Truncated HTTP chunked body.");
+    body.insert(body.end(), data.begin() + pos, data.begin() + pos + chunkSize);
+    pos += chunkSize + 2;
+  }
+  return body;
+}
+
+/**
+ * @brief Send an HTTP/1.1 request on a new connection and read the whole response
+ * @throw std::exception on network errors and invalid responses
+ */
+HttpResponse sendHttpRequest(const std::string& method,
+                             const std::string& url,
+                             const std::vector<std::string>& headers,
+                             const char* body = nullptr,
+                             std::uint64_t bodySize = 0)
+{
+  namespace asio = boost::asio;
+  using asio::ip::tcp;
+
+  const Url parsedUrl = parseUrl(url);
+
+  asio::io_service ioService;
+  tcp::resolver resolver(ioService);
+  tcp::socket socket(ioService);
+  asio::connect(socket, resolver.resolve(tcp::resolver::query(parsedUrl.host, parsedUrl.port)));
+
+  std::ostringstream request;
+  request << method << " " << parsedUrl.target << " HTTP/1.1\r\n"
+          << "Host: " << parsedUrl.host << "\r\n"
+          << "Connection: close\r\n";
+  for(const std::string& header : headers)
+    request << header << "\r\n";
+  if(body != nullptr)
+    request << "Content-Length: " << bodySize << "\r\n";
+  request << "\r\n";
+
+  const std::string requestHeader = request.str();
+  asio::write(socket, asio::buffer(requestHeader));
+  if(body != nullptr && bodySize > 0)
+    asio::write(socket, asio::buffer(body, bodySize));
+
+  // read the response until the server closes the connection
+  std::vector<char> data;
+  std::vector<char> buffer(64 * 1024);
+  boost::system::error_code error;
+  for(;;)
+  {
+    const std::size_t nbBytes = socket.read_some(asio::buffer(buffer), error);
+    data.insert(data.end(), buffer.begin(), buffer.begin() + nbBytes);
+    if(error == asio::error::eof)
+      break;
+    if(error)
+      throw boost::system::system_error(error);
+  }
+
+  const char* headerEndStr = "\r\n\r\n";
+  const auto headerEnd = std::search(data.begin(), data.end(), headerEndStr, headerEndStr + 4);
+  if(headerEnd == data.end())
+    throw std::runtime_error("Invalid HTTP response from '" + url + "'.");
+
+  HttpResponse response;
+  std::istringstream headerStream(std::string(data.begin(), headerEnd));
+  std::string line;
+  std::getline(headerStream, line);
+  {
+    std::istringstream statusLine(line);
+    std::string version;
+    statusLine >> version >> response.status;
+    if(version.compare(0, 5, "HTTP/") != 0)
+      throw std::runtime_error("Invalid HTTP response from '" + url + "'.");
+  }
+  while(std::getline(headerStream, line))
+  {
+    const std::size_t sep = line.find(':');
+    if(sep == std::string::npos)
+      continue;
+    std::string name = line.substr(0, sep);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    std::string value = line.substr(sep + 1);
+    value.erase(0, value.find_first_not_of(" \t"));
+    value.erase(value.find_last_not_of(" \t\r") + 1);
+    response.headers[name] = value;
+  }
+
+  response.body.assign(headerEnd + 4, data.end());
+  if(response.getHeader("transfer-encoding").find("chunked") != std::string::npos)
+  {
+    response.body = decodeChunkedBody(response.body);
+  }
+  else if(method != "HEAD")
+  {
+    const std::string contentLength = response.getHeader("content-length");
+    if(!contentLength.empty())
+    {
+      const std::uint64_t size = std::stoull(contentLength);
+      if(size > response.body.size())
+        throw std::runtime_error("Truncated HTTP response from '" + url + "'.");
+      response.body.resize(size);
+    }
+  }
+  return response;
+}
+
+/// 64 bits FNV-1a hash as 16 hexadecimal characters
+std::string hashString(const std::string& str)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  for(const char c : str)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  std::ostringstream ss;
+  ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return ss.str();
+}
+
+} // namespace
+
+void StorageBackend::readAll(const std::string& path, std::vector<char>& data)
+{
+  read(path, 0, getSize(path), data);
+}
+
+bool LocalStorageBackend::exists(const std::string& path)
+{
+  return fs::exists(path);
+}
+
+std::uint64_t LocalStorageBackend::getSize(const std::string& path)
+{
+  boost::system::error_code ec;
+  const std::uint64_t size = fs::file_size(path, ec);
+  if(ec)
+    throw std::runtime_error("Can't find the file '" + path + "'.");
+  return size;
+}
+
+void LocalStorageBackend::read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data)
+{
+  const std::uint64_t fileSize = getSize(path);
+  data.resize(offset < fileSize ? std::min(size, fileSize - offset) : 0);
+
+  std::ifstream stream(path.c_str(), std::ios::in | std::ios::binary);
+  if(!stream.is_open())
+    throw std::runtime_error("Can't read the file '" + path + "'.");
+  if(!data.empty() && (!stream.seekg(offset) || !stream.read(data.data(), data.size())))
+    throw std::runtime_error("Can't read the file '" + path + "'.");
+}
+
+void LocalStorageBackend::write(const std::string& path, const char* data, std::uint64_t size)
+{
+  writeLocalFile(path, data, size);
+}
+
+void LocalStorageBackend::prefetch(const std::string& path)
+{
+#if defined(__linux__)
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    return;
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+  ::close(fd);
+#endif
+}
+
+HttpStorageBackend::HttpStorageBackend(int nbRetries)
+  : _nbRetries(nbRetries)
+{}
+
+namespace {
+
+/// send a request, retried after the network errors and the server errors (5xx)
+HttpResponse sendHttpRequestWithRetries(int nbRetries,
+                                        const std::string& method,
+                                        const std::string& url,
+                                        const std::vector<std::string>& headers,
+                                        const char* body = nullptr,
+                                        std::uint64_t bodySize = 0)
+{
+  // invalid URLs are not retried
+  parseUrl(url);
+
+  for(int retry = 0; ; ++retry)
+  {
+    std::string error;
+    try
+    {
+      HttpResponse response = sendHttpRequest(method, url, headers, body, bodySize);
+      if(response.status < 500)
+        return response;
+      error = "HTTP status " + std::to_string(response.status);
+    }
+    catch(const std::exception& e)
+    {
+      // network error or truncated response
+      error = e.what();
+    }
+
+    if(retry >= nbRetries)
+      throw std::runtime_error("HTTP " + method + " request failed for '" + url + "': " + error);
+
+    ALICEVISION_LOG_DEBUG("HTTP " << method << " request failed for '" << url << "' (" << error << "), retry " << retry + 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100 << retry));
+  }
+}
+
+} // namespace
+
+bool HttpStorageBackend::exists(const std::string& path)
+{
+  const HttpResponse response = sendHttpRequestWithRetries(_nbRetries, "HEAD", path, {});
+  if(response.status == 404)
+    return false;
+  if(response.status != 200)
+    throw std::runtime_error("Can't get the file '" + path + "' (HTTP status " + std::to_string(response.status) + ").");
+  return true;
+}
+
+std::uint64_t HttpStorageBackend::getSize(const std::string& path)
+{
+  const HttpResponse response = sendHttpRequestWithRetries(_nbRetries, "HEAD", path, {});
+  const std::string contentLength = response.getHeader("content-length");
+  if(response.status != 200 || contentLength.empty())
+    throw std::runtime_error("Can't get the size of the file '" + path + "' (HTTP status " + std::to_string(response.status) + ").");
+  return std::stoull(contentLength);
+}
+
+void HttpStorageBackend::read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data)
+{
+  data.clear();
+  if(size == 0)
+    return;
+
+  const std::string range = "Range: bytes=" + std::to_string(offset) + "-" + std::to_string(offset + size - 1);
+  HttpResponse response = sendHttpRequestWithRetries(_nbRetries, "GET", path, {range});
+
+  if(response.status == 206)
+  {
+    data = std::move(response.body);
+  }
+  else if(response.status == 200)
+  {
+    // the server ignores the ranges: whole file
+    if(offset < response.body.size())
+      data.assign(response.body.begin() + offset, response.body.begin() + std::min<std::uint64_t>(offset + size, response.body.size()));
+  }
+  else if(response.status != 416) // 416: range beyond the end of the file
+  {
+    throw std::runtime_error("Can't read the file '" + path + "' (HTTP status " + std::to_string(response.status) + ").");
+  }
+}
+
+void HttpStorageBackend::readAll(const std::string& path, std::vector<char>& data)
+{
+  HttpResponse response = sendHttpRequestWithRetries(_nbRetries, "GET", path, {});
+  if(response.status != 200)
+    throw std::runtime_error("Can't read the file '" + path + "' (HTTP status " + std::to_string(response.status) + ").");
+  data = std::move(response.body);
+}
+
+void HttpStorageBackend::write(const std::string& path, const char* data, std::uint64_t size)
+{
+  const HttpResponse response = sendHttpRequestWithRetries(_nbRetries, "PUT", path, {"Content-Type: application/octet-stream"}, data, size);
+  if(response.status != 200 && response.status != 201 && response.status != 204)
+    throw std::runtime_error("Can't write the file '" + path + "' (HTTP status " + std::to_string(response.status) + ").");
+}
+
+CachedStorageBackend::CachedStorageBackend(std::shared_ptr<StorageBackend> backend, const std::string& folder, std::uint64_t maxSize)
+  : _backend(std::move(backend))
+  , _folder(folder)
+  , _maxSize(maxSize)
+{
+  if(!fs::exists(_folder) && !fs::create_directories(_folder))
+    throw std::runtime_error("Can't create the storage cache folder '" + _folder + "'.");
+
+  // files of the previous runs, from the least recently used
+  std::vector<std::pair<std::time_t, fs::path>> files;
+  for(const fs::directory_entry& entry : fs::directory_iterator(_folder))
+  {
+    if(!fs::is_regular_file(entry.path()))
+      continue;
+    // temporary file of an interrupted download
+    if(entry.path().extension() == ".tmp")
+    {
+      boost::system::error_code ec;
+      fs::remove(entry.path(), ec);
+      continue;
+    }
+    files.emplace_back(fs::last_write_time(entry.path()), entry.path());
+  }
+  std::sort(files.begin(), files.end());
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  for(const auto& file : files)
+    addEntry(file.second.string(), fs::file_size(file.second));
+}
+
+std::string CachedStorageBackend::getEntryPath(const std::string& path) const
+{
+  // keep the extension of the file, for the readers using it (images)
+  std::string filename = path.substr(0, path.find('?'));
+  filename = filename.substr(filename.find_last_of('/') + 1);
+  const std::size_t extensionPos = filename.find_last_of('.');
+  const std::string extension = extensionPos == std::string::npos ? std::string() : filename.substr(extensionPos);
+
+  return (fs::path(_folder) / (hashString(path) + extension)).string();
+}
+
+bool CachedStorageBackend::touchEntry(const std::string& entryPath)
+{
+  const auto it = _entriesIndex.find(entryPath);
+  if(it == _entriesIndex.end())
+    return false;
+  _entries.splice(_entries.end(), _entries, it->second);
+  // order of the files for the next runs
+  boost::system::error_code ec;
+  fs::last_write_time(entryPath, std::time(nullptr), ec);
+  return true;
+}
+
+void CachedStorageBackend::addEntry(const std::string& entryPath, std::uint64_t size)
+{
+  const auto it = _entriesIndex.find(entryPath);
+  if(it != _entriesIndex.end())
+  {
+    _size -= it->second->second;
+    _entries.erase(it->second);
+    _entriesIndex.erase(it);
+  }
+  _entries.emplace_back(entryPath, size);
+  _entriesIndex[entryPath] = std::prev(_entries.end());
+  _size += size;
+
+  // remove the least recently used files, but the new one
+  while(_size > _maxSize && _entries.size() > 1)
+  {
+    const std::pair<std::string, std::uint64_t> oldest = _entries.front();
+    boost::system::error_code ec;
+    fs::remove(oldest.first, ec);
+    _size -= oldest.second;
+    _entriesIndex.erase(oldest.first);
+    _entries.pop_front();
+  }
+}
+
+bool CachedStorageBackend::isCached(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entriesIndex.count(getEntryPath(path)) > 0;
+}
+
+bool CachedStorageBackend::exists(const std::string& path)
+{
+  return isCached(path) || _backend->exists(path);
+}
+
+std::uint64_t CachedStorageBackend::getSize(const std::string& path)
+{
+  const std::string entryPath = getEntryPath(path);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _entriesIndex.find(entryPath);
+    if(it != _entriesIndex.end())
+      return it->second->second;
+  }
+  return _backend->getSize(path);
+}
+
+std::string CachedStorageBackend::getLocalPath(const std::string& path)
+{
+  const std::string entryPath = getEntryPath(path);
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    // a single download of each file
+    _downloaded.wait(lock, [&]{ return _downloading.count(entryPath) == 0; });
+    if(touchEntry(entryPath))
+      return entryPath;
+    _downloading.insert(entryPath);
+  }
+
+  try
+  {
+    std::vector<char> data;
+    _backend->readAll(path, data);
+    writeLocalFile(entryPath, data.data(), data.size());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    addEntry(entryPath, data.size());
+    _downloading.erase(entryPath);
+  }
+  catch(...)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _downloading.erase(entryPath);
+    }
+    _downloaded.notify_all();
+    throw;
+  }
+  _downloaded.notify_all();
+
+  ALICEVISION_LOG_TRACE("Storage cache: '" << path << "' downloaded in '" << entryPath << "'.");
+  return entryPath;
+}
+
+void CachedStorageBackend::read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data)
+{
+  LocalStorageBackend().read(getLocalPath(path), offset, size, data);
+}
+
+void CachedStorageBackend::write(const std::string& path, const char* data, std::uint64_t size)
+{
+  _backend->write(path, data, size);
+
+  const std::string entryPath = getEntryPath(path);
+  writeLocalFile(entryPath, data, size);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  addEntry(entryPath, size);
+}
+
+void CachedStorageBackend::prefetch(const std::string& path)
+{
+  getLocalPath(path);
+}
+
+/**
+ * @brief Dispatch the remote paths to the backends of their URL scheme
+ */
+class Storage::RemoteBackend : public StorageBackend
+{
+public:
+  explicit RemoteBackend(Storage& storage)
+    : _storage(storage)
+  {}
+
+  bool exists(const std::string& path) override
+  {
+    std::string url;
+    return _storage.getRemoteBackend(path, url).exists(url);
+  }
+
+  std::uint64_t getSize(const std::string& path) override
+  {
+    std::string url;
+    return _storage.getRemoteBackend(path, url).getSize(url);
+  }
+
+  void read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data) override
+  {
+    std::string url;
+    _storage.getRemoteBackend(path, url).read(url, offset, size, data);
+  }
+
+  void readAll(const std::string& path, std::vector<char>& data) override
+  {
+    std::string url;
+    _storage.getRemoteBackend(path, url).readAll(url, data);
+  }
+
+  void write(const std::string& path, const char* data, std::uint64_t size) override
+  {
+    std::string url;
+    _storage.getRemoteBackend(path, url).write(url, data, size);
+  }
+
+private:
+  Storage& _storage;
+};
+
+Storage& Storage::get()
+{
+  static Storage storage;
+  return storage;
+}
+
+Storage::Storage()
+{
+  _backends["file"] = std::make_shared<LocalStorageBackend>();
+  _backends["http"] = std::make_shared<HttpStorageBackend>();
+
+  if(const char* endpoint = std::getenv("ALICEVISION_S3_ENDPOINT"))
+  {
+    _s3Endpoint = endpoint;
+    while(!_s3Endpoint.empty() && _s3Endpoint.back() == '/')
+      _s3Endpoint.pop_back();
+  }
+
+  // the pool must outlive the storage (destroyed in the reverse order)
+  _prefetchGroup.reset(new TaskGroup(TaskPool::get()));
+  _writeGroup.reset(new TaskGroup(TaskPool::get()));
+}
+
+Storage::~Storage()
+{
+  _prefetchGroup->wait();
+  try
+  {
+    flush();
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR(e.what());
+  }
+}
+
+bool Storage::isLocalPath(const std::string& path)
+{
+  const std::string scheme = getScheme(path);
+  return scheme.empty() || scheme == "file";
+}
+
+void Storage::setBackend(const std::string& scheme, std::shared_ptr<StorageBackend> backend)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _backends[scheme] = std::move(backend);
+}
+
+StorageBackend& Storage::getRemoteBackend(const std::string& path, std::string& url)
+{
+  std::string scheme = getScheme(path);
+  url = path;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(scheme == "s3" && _backends.count("s3") == 0)
+  {
+    // path-style URL of the S3 endpoint: s3://bucket/key -> endpoint/bucket/key
+    if(_s3Endpoint.empty())
+      throw std::runtime_error("ALICEVISION_S3_ENDPOINT is needed to access '" + path + "'.");
+    url = _s3Endpoint + "/" + path.substr(5);
+    scheme = getScheme(url);
+  }
+
+  const auto it = _backends.find(scheme);
+  if(it == _backends.end())
+    throw std::runtime_error("No storage backend for the URL '" + path + "'.");
+  return *it->second;
+}
+
+CachedStorageBackend& Storage::getCache()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(!_cache)
+  {
+    std::string folder = (fs::temp_directory_path() / "aliceVision_storage_cache").string();
+    if(const char* cacheFolder = std::getenv("ALICEVISION_STORAGE_CACHE"))
+      folder = cacheFolder;
+
+    std::uint64_t maxSizeMB = 10 * 1024;
+    if(const char* cacheSize = std::getenv("ALICEVISION_STORAGE_CACHE_SIZE"))
+      maxSizeMB = std::strtoull(cacheSize, nullptr, 10);
+
+    _cache.reset(new CachedStorageBackend(std::make_shared<RemoteBackend>(*this), folder, maxSizeMB * 1024 * 1024));
+    ALICEVISION_LOG_INFO("Storage cache folder: " << folder << " (" << maxSizeMB << " MB)");
+  }
+  return *_cache;
+}
+
+StorageBackend& Storage::getBackend(const std::string& path)
+{
+  if(!isLocalPath(path))
+    return getCache();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  return *_backends.at("file");
+}
+
+namespace {
+
+/// local path of a local path or a file:// URL
+std::string toLocalPath(const std::string& path)
+{
+  return getScheme(path).empty() ? path : path.substr(7);
+}
+
+} // namespace
+
+bool Storage::exists(const std::string& path)
+{
+  return getBackend(path).exists(isLocalPath(path) ? toLocalPath(path) : path);
+}
+
+std::uint64_t Storage::getSize(const std::string& path)
+{
+  return getBackend(path).getSize(isLocalPath(path) ? toLocalPath(path) : path);
+}
+
+std::string Storage::getLocalPath(const std::string& path)
+{
+  if(isLocalPath(path))
+    return toLocalPath(path);
+  return getCache().getLocalPath(path);
+}
+
+void Storage::read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data)
+{
+  getBackend(path).read(isLocalPath(path) ? toLocalPath(path) : path, offset, size, data);
+}
+
+void Storage::readAll(const std::string& path, std::vector<char>& data)
+{
+  getBackend(path).readAll(isLocalPath(path) ? toLocalPath(path) : path, data);
+}
+
+void Storage::readBatch(const std::vector<std::string>& paths, std::vector<std::vector<char>>& data)
+{
+  data.resize(paths.size());
+
+  ParallelForOptions options;
+  options.taskClass = ETaskClass::DiskRead;
+  options.grainSize = 1;
+  parallelFor(std::size_t(0), paths.size(), [&](std::size_t i)
+  {
+    readAll(paths[i], data[i]);
+  }, options);
+}
+
+void Storage::prefetch(const std::vector<std::string>& paths)
+{
+  for(const std::string& path : paths)
+  {
+    if(isLocalPath(path))
+    {
+      // no wait: the OS reads in the background
+      getBackend(path).prefetch(toLocalPath(path));
+      continue;
+    }
+
+    _prefetchGroup->run([this, path]()
+    {
+      try
+      {
+        getCache().prefetch(path);
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_DEBUG("Storage prefetch of '" << path << "' failed: " << e.what());
+      }
+    }, ETaskClass::DiskRead);
+  }
+}
+
+void Storage::write(const std::string& path, const char* data, std::uint64_t size)
+{
+  getBackend(path).write(isLocalPath(path) ? toLocalPath(path) : path, data, size);
+}
+
+void Storage::writeAsync(const std::string& path, std::vector<char> data)
+{
+  // shared: std::function needs a copyable functor
+  const auto sharedData = std::make_shared<std::vector<char>>(std::move(data));
+  _writeGroup->run([this, path, sharedData]()
+  {
+    try
+    {
+      write(path, sharedData->data(), sharedData->size());
+    }
+    catch(const std::exception& e)
+    {
+      // no exception: it would cancel the other writes
+      std::lock_guard<std::mutex> lock(_writeErrorsMutex);
+      _writeErrors.push_back(e.what());
+    }
+  }, ETaskClass::DiskWrite);
+}
+
+void Storage::upload(const std::string& localPath, const std::string& path)
+{
+  boost::system::error_code ec;
+  if(isLocalPath(path) && fs::equivalent(localPath, toLocalPath(path), ec))
+    return;
+
+  std::vector<char> data;
+  LocalStorageBackend().readAll(localPath, data);
+  write(path, data.data(), data.size());
+}
+
+void Storage::uploadAsync(const std::string& localPath, const std::string& path)
+{
+  _writeGroup->run([this, localPath, path]()
+  {
+    try
+    {
+      upload(localPath, path);
+    }
+    catch(const std::exception& e)
+    {
+      std::lock_guard<std::mutex> lock(_writeErrorsMutex);
+      _writeErrors.push_back(e.what());
+    }
+  }, ETaskClass::DiskWrite);
+}
+
+void Storage::flush()
+{
+  _writeGroup->wait();
+
+  std::vector<std::string> errors;
+  {
+    std::lock_guard<std::mutex> lock(_writeErrorsMutex);
+    errors.swap(_writeErrors);
+  }
+  if(errors.empty())
+    return;
+
+  std::string message = std::to_string(errors.size()) + " storage write(s) failed:";
+  for(const std::string& error : errors)
+    message += "\n\t- " + error;
+  throw std::runtime_error(message);
+}
+
+} // namespace system
+} // namespace aliceVision
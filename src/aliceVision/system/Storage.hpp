@@ -0,0 +1,291 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/TaskPool.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Storage of the files of a kind of path (local disk, HTTP server, ...).
+ *        The methods can be called from several threads at the same time.
+ */
+class StorageBackend
+{
+public:
+  virtual ~StorageBackend() = default;
+
+  /// Whether the file exists
+  virtual bool exists(const std::string& path) = 0;
+
+  /**
+   * @brief Get the size of a file
+   * @throw std::runtime_error if the file can't be found
+   */
+  virtual std::uint64_t getSize(const std::string& path) = 0;
+
+  /**
+   * @brief Read a byte range of a file
+   * @param[in] path The file path
+   * @param[in] offset The first byte of the range
+   * @param[in] size The number of bytes of the range (truncated at the end of the file)
+   * @param[out] data The bytes of the range
+   * @throw std::runtime_error if the file can't be read
+   */
+  virtual void read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data) = 0;
+
+  /**
+   * @brief Read a whole file
+   * @throw std::runtime_error if the file can't be read
+   */
+  virtual void readAll(const std::string& path, std::vector<char>& data);
+
+  /**
+   * @brief Write a whole file, replacing the existing one
+   * @throw std::runtime_error if the file can't be written
+   */
+  virtual void write(const std::string& path, const char* data, std::uint64_t size) = 0;
+
+  /**
+   * @brief Hint that a file will be read soon (nothing is done by default)
+   */
+  virtual void prefetch(const std::string& /*path*/) {}
+};
+
+/**
+ * @brief Files of the local filesystem
+ */
+class LocalStorageBackend : public StorageBackend
+{
+public:
+  bool exists(const std::string& path) override;
+  std::uint64_t getSize(const std::string& path) override;
+  void read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data) override;
+  void write(const std::string& path, const char* data, std::uint64_t size) override;
+
+  /// Ask the OS to read the file ahead in its page cache
+  void prefetch(const std::string& path) override;
+};
+
+/**
+ * @brief Files of an HTTP/1.1 server, read with range requests and written with PUT requests.
+ *
+ * Works with the plain HTTP endpoints of the object stores (S3 compatible gateway,
+ * public buckets, MinIO, ...). HTTPS and the request signatures are not supported.
+ * Paths are URLs: http://host[:port]/path
+ */
+class HttpStorageBackend : public StorageBackend
+{
+public:
+  /**
+   * @param[in] nbRetries The number of retries of a failed request
+   */
+  explicit HttpStorageBackend(int nbRetries = 3);
+
+  bool exists(const std::string& path) override;
+  std::uint64_t getSize(const std::string& path) override;
+  void read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data) override;
+  void readAll(const std::string& path, std::vector<char>& data) override;
+  void write(const std::string& path, const char* data, std::uint64_t size) override;
+
+private:
+  int _nbRetries;
+};
+
+/**
+ * @brief Local cache of the whole files of a slow backend (e.g. on a local SSD).
+ *
+ * A file is downloaded once in the cache folder, then read from its local copy.
+ * The least recently used files are removed when the cache exceeds its maximum size
+ * (it should be larger than the files used at the same time).
+ * The written files are written to the backend and kept in the cache.
+ * The cache folder can be kept between the runs: the files are identified by their path only.
+ */
+class CachedStorageBackend : public StorageBackend
+{
+public:
+  /**
+   * @param[in] backend The cached backend
+   * @param[in] folder The cache folder, created if needed
+   * @param[in] maxSize The maximum size of the cached files in bytes
+   */
+  CachedStorageBackend(std::shared_ptr<StorageBackend> backend, const std::string& folder, std::uint64_t maxSize);
+
+  bool exists(const std::string& path) override;
+  std::uint64_t getSize(const std::string& path) override;
+  void read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data) override;
+  void write(const std::string& path, const char* data, std::uint64_t size) override;
+
+  /// Download the file in the cache
+  void prefetch(const std::string& path) override;
+
+  /**
+   * @brief Get the path of the local copy of a file, downloaded if needed
+   * @throw std::runtime_error if the file can't be downloaded
+   */
+  std::string getLocalPath(const std::string& path);
+
+  /// Whether the file is in the cache
+  bool isCached(const std::string& path);
+
+  const std::string& getFolder() const { return _folder; }
+
+private:
+  std::string getEntryPath(const std::string& path) const;
+  /// add a file in the cache, then remove the oldest files beyond the maximum size (_mutex locked)
+  void addEntry(const std::string& entryPath, std::uint64_t size);
+  /// mark a cached file as the most recently used, return false if it is not cached (_mutex locked)
+  bool touchEntry(const std::string& entryPath);
+
+  std::shared_ptr<StorageBackend> _backend;
+  std::string _folder;
+  std::uint64_t _maxSize;
+
+  std::mutex _mutex;
+  std::condition_variable _downloaded;
+  /// files being downloaded
+  std::set<std::string> _downloading;
+  /// entry path and size of the cached files, from the least recently used
+  std::list<std::pair<std::string, std::uint64_t>> _entries;
+  std::map<std::string, std::list<std::pair<std::string, std::uint64_t>>::iterator> _entriesIndex;
+  std::uint64_t _size = 0;
+};
+
+/**
+ * @brief Storage of the files read and written by the pipeline: local files or remote files,
+ *        given by an URL, through a local cache.
+ *
+ * The remote files are cached in the folder given by the ALICEVISION_STORAGE_CACHE environment
+ * variable (a temporary folder by default), up to ALICEVISION_STORAGE_CACHE_SIZE MB (10 GB by default).
+ * s3://bucket/key paths are read from the path-style URL of the ALICEVISION_S3_ENDPOINT endpoint
+ * (http://host:port).
+ *
+ * The readers needing a local file (images, memory mapped files) use getLocalPath().
+ * Reads of several files are done in parallel by the TaskPool (ETaskClass::DiskRead) and the
+ * asynchronous writes by the TaskPool (ETaskClass::DiskWrite).
+ */
+class Storage
+{
+public:
+  /// Get the storage of the process
+  static Storage& get();
+
+  Storage();
+  ~Storage();
+
+  Storage(const Storage&) = delete;
+  Storage& operator=(const Storage&) = delete;
+
+  /// Whether a path is a local file path (not an URL)
+  static bool isLocalPath(const std::string& path);
+
+  /**
+   * @brief Set the backend of an URL scheme
+   * @param[in] scheme The scheme of the URLs, "file" for the local paths
+   * @param[in] backend The backend
+   */
+  void setBackend(const std::string& scheme, std::shared_ptr<StorageBackend> backend);
+
+  /**
+   * @brief Get the backend of a path
+   * @throw std::runtime_error if the URL scheme is unknown
+   */
+  StorageBackend& getBackend(const std::string& path);
+
+  bool exists(const std::string& path);
+
+  std::uint64_t getSize(const std::string& path);
+
+  /**
+   * @brief Get a local file with the content of a file: the path itself for a local path,
+   *        the local copy in the cache for a remote file
+   * @throw std::runtime_error if the file can't be read
+   */
+  std::string getLocalPath(const std::string& path);
+
+  /// @see StorageBackend::read
+  void read(const std::string& path, std::uint64_t offset, std::uint64_t size, std::vector<char>& data);
+
+  /// @see StorageBackend::readAll
+  void readAll(const std::string& path, std::vector<char>& data);
+
+  /**
+   * @brief Read several files in parallel
+   * @param[in] paths The files
+   * @param[out] data The content of each file
+   * @throw std::runtime_error if a file can't be read
+   */
+  void readBatch(const std::vector<std::string>& paths, std::vector<std::vector<char>>& data);
+
+  /**
+   * @brief Hint that files will be read soon: the remote files are downloaded in the cache
+   *        by the TaskPool threads and the local files are read ahead by the OS, without waiting.
+   *        The errors are ignored, they are raised by the read of the file.
+   */
+  void prefetch(const std::vector<std::string>& paths);
+
+  /**
+   * @brief Write a file, replacing the existing one
+   * @throw std::runtime_error if the file can't be written
+   */
+  void write(const std::string& path, const char* data, std::uint64_t size);
+
+  /**
+   * @brief Copy a local file to a path of the storage (no copy for the same local path)
+   * @throw std::runtime_error if the file can't be written
+   */
+  void upload(const std::string& localPath, const std::string& path);
+
+  /**
+   * @brief Write a file in the background, the errors are raised by flush()
+   */
+  void writeAsync(const std::string& path, std::vector<char> data);
+
+  /**
+   * @brief Copy a local file to a path of the storage in the background (no copy for the same local path),
+   *        the errors are raised by flush()
+   */
+  void uploadAsync(const std::string& localPath, const std::string& path);
+
+  /**
+   * @brief Wait for the asynchronous writes
+   * @throw std::runtime_error if a write has failed
+   */
+  void flush();
+
+private:
+  class RemoteBackend;
+
+  /// get the backend of a remote path and its URL, s3 paths are converted to the URL of the endpoint
+  StorageBackend& getRemoteBackend(const std::string& path, std::string& url);
+  CachedStorageBackend& getCache();
+
+  std::mutex _mutex;
+  std::map<std::string, std::shared_ptr<StorageBackend>> _backends;
+  std::string _s3Endpoint;
+  /// cache of the remote backends, created at the first remote file
+  std::unique_ptr<CachedStorageBackend> _cache;
+
+  std::unique_ptr<TaskGroup> _prefetchGroup;
+  std::unique_ptr<TaskGroup> _writeGroup;
+  std::mutex _writeErrorsMutex;
+  std::vector<std::string> _writeErrors;
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,388 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TaskPool.hpp"
+#include "cpu.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <thread>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+namespace {
+
+const std::size_t nbTaskClasses = 3;
+
+/**
+ * @brief Get the default number of threads of a pool
+ */
+int getDefaultNbThreads()
+{
+  // follow the OpenMP setting used by the rest of the code
+  if(const char* ompNumThreads = std::getenv("OMP_NUM_THREADS"))
+  {
+    const int nbThreads = std::atoi(ompNumThreads);
+    if(nbThreads > 0)
+      return nbThreads;
+  }
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+} // namespace
+
+struct TaskPool::Task
+{
+  std::function<void()> function;
+  TaskGroup* group = nullptr;
+  ETaskClass taskClass = ETaskClass::Compute;
+  /// the task holds a slot of its class limit
+  bool limited = false;
+};
+
+struct TaskPool::Impl
+{
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  struct ClassState
+  {
+    int limit = 0;
+    int nbRunning = 0;
+    /// tasks waiting for a slot of the class
+    std::deque<Task> waiting;
+  };
+
+  /// queue 0 is filled by the threads outside of the pool, queue i + 1 by the worker i
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+
+  std::atomic<int> nbQueued{0};
+  std::mutex sleepMutex;
+  std::condition_variable wakeUp;
+  bool stop = false;
+
+  mutable std::mutex classesMutex;
+  std::array<ClassState, nbTaskClasses> classes;
+};
+
+namespace {
+
+/// pool of the calling thread if it is a worker, and its queue index
+thread_local const void* currentPool = nullptr;
+thread_local std::size_t currentQueue = 0;
+/// number of tasks of each class running in the calling thread (nested by the waits)
+thread_local std::array<int, nbTaskClasses> currentClasses{};
+
+} // namespace
+
+TaskPool& TaskPool::get()
+{
+  // pin the workers when several nodes share the memory bandwidth
+  static TaskPool pool(0, (getNbNumaNodes() > 1) ? get_numa_nodes_cpus() : std::vector<std::vector<int>>());
+  return pool;
+}
+
+TaskPool& TaskPool::getNumaNode(int node)
+{
+  const int nbNodes = getNbNumaNodes();
+  if(nbNodes <= 1)
+    return get();
+
+  // created on first use: most runs only use some of the nodes
+  static std::mutex mutex;
+  static std::vector<std::unique_ptr<TaskPool>> pools(nbNodes);
+
+  const std::vector<int>& cpus = get_numa_nodes_cpus().at(node);
+  std::lock_guard<std::mutex> lock(mutex);
+  if(!pools[node])
+    pools[node].reset(new TaskPool(static_cast<int>(cpus.size()), {cpus}));
+  return *pools[node];
+}
+
+int TaskPool::getNbNumaNodes()
+{
+  return static_cast<int>(get_numa_nodes_cpus().size());
+}
+
+TaskPool::TaskPool(int nbThreads, const std::vector<std::vector<int>>& nodesCpus)
+  : _impl(new Impl)
+{
+  if(nbThreads <= 0)
+    nbThreads = getDefaultNbThreads();
+
+  // the waiting thread runs tasks too
+  const int nbWorkers = nbThreads - 1;
+
+  _impl->classes[static_cast<std::size_t>(ETaskClass::DiskRead)].limit = 3;
+  _impl->classes[static_cast<std::size_t>(ETaskClass::DiskWrite)].limit = 3;
+
+  for(int i = 0; i < nbWorkers + 1; ++i)
+    _impl->queues.emplace_back(new Impl::Queue);
+
+  for(int i = 0; i < nbWorkers; ++i)
+  {
+    std::vector<int> cpus;
+    if(!nodesCpus.empty())
+      cpus = nodesCpus[static_cast<std::size_t>(i) * nodesCpus.size() / nbWorkers];
+
+    _impl->workers.emplace_back([this, i, cpus]()
+    {
+      currentPool = this;
+      currentQueue = i + 1;
+
+      if(!cpus.empty())
+        set_current_thread_affinity(cpus);
+
+      while(true)
+      {
+        if(tryRunOne())
+          continue;
+
+        std::unique_lock<std::mutex> lock(_impl->sleepMutex);
+        _impl->wakeUp.wait(lock, [this]{ return _impl->stop || _impl->nbQueued > 0; });
+        if(_impl->stop && _impl->nbQueued == 0)
+          return;
+      }
+    });
+  }
+}
+
+TaskPool::~TaskPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(_impl->sleepMutex);
+    _impl->stop = true;
+  }
+  _impl->wakeUp.notify_all();
+  for(std::thread& worker : _impl->workers)
+    worker.join();
+}
+
+int TaskPool::getNbThreads() const
+{
+  return static_cast<int>(_impl->workers.size()) + 1;
+}
+
+void TaskPool::setConcurrencyLimit(ETaskClass taskClass, int limit)
+{
+  std::deque<Task> admitted;
+  {
+    std::lock_guard<std::mutex> lock(_impl->classesMutex);
+    Impl::ClassState& state = _impl->classes[static_cast<std::size_t>(taskClass)];
+    state.limit = std::max(0, limit);
+
+    // a higher limit can admit waiting tasks
+    while(!state.waiting.empty() && (state.limit == 0 || state.nbRunning < state.limit))
+    {
+      admitted.push_back(std::move(state.waiting.front()));
+      state.waiting.pop_front();
+      ++state.nbRunning;
+    }
+  }
+  for(Task& task : admitted)
+    submit(std::move(task));
+}
+
+int TaskPool::getConcurrencyLimit(ETaskClass taskClass) const
+{
+  std::lock_guard<std::mutex> lock(_impl->classesMutex);
+  return _impl->classes[static_cast<std::size_t>(taskClass)].limit;
+}
+
+int TaskPool::getMaxConcurrency(ETaskClass taskClass) const
+{
+  const int limit = getConcurrencyLimit(taskClass);
+  return (limit > 0) ? std::min(limit, getNbThreads()) : getNbThreads();
+}
+
+void TaskPool::submit(Task&& task)
+{
+  const std::size_t classIndex = static_cast<std::size_t>(task.taskClass);
+
+  // wait for a slot of the class, unless the task is nested in a task of the same class
+  if(!task.limited && currentClasses[classIndex] == 0)
+  {
+    std::lock_guard<std::mutex> lock(_impl->classesMutex);
+    Impl::ClassState& state = _impl->classes[classIndex];
+    if(state.limit > 0)
+    {
+      task.limited = true;
+      if(state.nbRunning >= state.limit)
+      {
+        state.waiting.push_back(std::move(task));
+        return;
+      }
+      ++state.nbRunning;
+    }
+  }
+
+  const std::size_t queueIndex = (currentPool == this) ? currentQueue : 0;
+  {
+    Impl::Queue& queue = *_impl->queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(_impl->sleepMutex);
+    ++_impl->nbQueued;
+  }
+  _impl->wakeUp.notify_one();
+}
+
+bool TaskPool::tryRunOne()
+{
+  Task task;
+  bool found = false;
+
+  const std::size_t nbQueues = _impl->queues.size();
+  const std::size_t ownQueue = (currentPool == this) ? currentQueue : 0;
+
+  // own queue first (last task submitted), then steal the oldest task of the other queues
+  for(std::size_t k = 0; k < nbQueues && !found; ++k)
+  {
+    const std::size_t queueIndex = (ownQueue + k) % nbQueues;
+    Impl::Queue& queue = *_impl->queues[queueIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if(queue.tasks.empty())
+      continue;
+    if(k == 0 && queueIndex != 0)
+    {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+    else
+    {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    found = true;
+  }
+  if(!found)
+    return false;
+
+  {
+    std::lock_guard<std::mutex> lock(_impl->sleepMutex);
+    --_impl->nbQueued;
+  }
+
+  const std::size_t classIndex = static_cast<std::size_t>(task.taskClass);
+  std::exception_ptr exception;
+
+  if(!task.group->isCancelled())
+  {
+    ++currentClasses[classIndex];
+    try
+    {
+      task.function();
+    }
+    catch(...)
+    {
+      exception = std::current_exception();
+    }
+    --currentClasses[classIndex];
+  }
+
+  // give the slot of the class to the next waiting task
+  if(task.limited)
+  {
+    Task next;
+    bool admitNext = false;
+    {
+      std::lock_guard<std::mutex> lock(_impl->classesMutex);
+      Impl::ClassState& state = _impl->classes[classIndex];
+      if(!state.waiting.empty() && (state.limit == 0 || state.nbRunning <= state.limit))
+      {
+        next = std::move(state.waiting.front());
+        state.waiting.pop_front();
+        admitNext = true;
+      }
+      else
+      {
+        --state.nbRunning;
+      }
+    }
+    if(admitNext)
+      submit(std::move(next));
+  }
+
+  // release the captures of the task before its group can be destroyed
+  TaskGroup* group = task.group;
+  task.function = nullptr;
+  group->onTaskDone(exception);
+  return true;
+}
+
+TaskGroup::TaskGroup(TaskPool& pool)
+  : _pool(pool)
+{}
+
+TaskGroup::~TaskGroup()
+{
+  try
+  {
+    wait();
+  }
+  catch(...)
+  {
+  }
+}
+
+void TaskGroup::run(std::function<void()> function, ETaskClass taskClass)
+{
+  TaskPool::Task task;
+  task.function = std::move(function);
+  task.group = this;
+  task.taskClass = taskClass;
+
+  ++_nbPending;
+  _pool.submit(std::move(task));
+}
+
+void TaskGroup::wait()
+{
+  while(_nbPending > 0)
+  {
+    if(_pool.tryRunOne())
+      continue;
+
+    // the remaining tasks run in other threads, or wait for a slot of their class
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait_for(lock, std::chrono::milliseconds(1), [this]{ return _nbPending == 0; });
+  }
+
+  std::exception_ptr exception;
+  {
+    // the last task may still be notifying
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::swap(exception, _exception);
+    _cancelled = false;
+  }
+  if(exception)
+    std::rethrow_exception(exception);
+}
+
+void TaskGroup::onTaskDone(std::exception_ptr exception)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(exception && !_exception)
+  {
+    _exception = exception;
+    _cancelled = true;
+  }
+  if(--_nbPending == 0)
+    _done.notify_all();
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,217 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Classes of tasks, each one with its own concurrency limit in a TaskPool
+ */
+enum class ETaskClass
+{
+  Compute = 0, ///< CPU bound, limited by the pool threads only
+  DiskRead,    ///< mostly waiting for the storage to read files
+  DiskWrite    ///< mostly waiting for the storage to write files
+};
+
+class TaskGroup;
+
+/**
+ * @brief Work-stealing pool of threads shared by the parallel algorithms.
+ *
+ * Each worker thread has its own queue of tasks: it runs its last submitted task first
+ * and steals the oldest tasks of the other queues when its queue is empty.
+ * A thread waiting for a TaskGroup runs the queued tasks meanwhile, so nested parallel
+ * loops share the pool threads instead of creating new threads (no oversubscription).
+ *
+ * The tasks of a limited class (e.g. disk reads) wait in a queue of their class while
+ * the limit is reached. The tasks submitted by a task of the same class are not limited:
+ * they would wait for the slot of their parent.
+ *
+ * On NUMA machines, the workers of the shared pool are pinned to the nodes (spread in contiguous
+ * blocks), so the pages they touch first stay local to them. getNumaNode() gives pools whose
+ * workers all run on one node, for the work that should stay close to its data.
+ */
+class TaskPool
+{
+public:
+  /**
+   * @brief Get the pool shared by the whole process.
+   *        Its number of threads is OMP_NUM_THREADS if defined, the number of cores otherwise.
+   */
+  static TaskPool& get();
+
+  /**
+   * @brief Get the pool whose worker threads are pinned to the CPUs of a NUMA node.
+   *        Its number of threads is the number of CPUs of the node.
+   *        Without several NUMA nodes, it is the shared pool.
+   * @param[in] node The NUMA node index, in [0, getNbNumaNodes())
+   */
+  static TaskPool& getNumaNode(int node);
+
+  /// Number of NUMA nodes having CPUs (1 without NUMA information)
+  static int getNbNumaNodes();
+
+  /**
+   * @param[in] nbThreads The number of threads running the tasks, including the waiting thread
+   *            (0 for OMP_NUM_THREADS if defined, the number of cores otherwise)
+   * @param[in] nodesCpus The CPUs of each node the worker threads are spread on, in contiguous blocks
+   *            (empty for no thread pinning). The waiting threads are never pinned.
+   */
+  explicit TaskPool(int nbThreads = 0, const std::vector<std::vector<int>>& nodesCpus = {});
+  ~TaskPool();
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  /// Number of threads running the tasks: the worker threads and the waiting thread
+  int getNbThreads() const;
+
+  /**
+   * @brief Set the maximum number of tasks of a class running at the same time
+   * @param[in] taskClass The class of tasks
+   * @param[in] limit The maximum number of tasks, 0 for no limit
+   */
+  void setConcurrencyLimit(ETaskClass taskClass, int limit);
+
+  /// Maximum number of tasks of a class running at the same time, 0 for no limit
+  int getConcurrencyLimit(ETaskClass taskClass) const;
+
+  /// Maximum number of tasks of a class that can run at the same time in the pool
+  int getMaxConcurrency(ETaskClass taskClass) const;
+
+private:
+  friend class TaskGroup;
+  struct Task;
+  struct Impl;
+
+  void submit(Task&& task);
+
+  /// Run a queued task from the calling thread, return false if there was none
+  bool tryRunOne();
+
+  std::unique_ptr<Impl> _impl;
+};
+
+/**
+ * @brief Set of tasks submitted to a TaskPool and waited for together.
+ *
+ * The first exception thrown by a task cancels the tasks of the group that have not
+ * started yet, and is rethrown by wait().
+ */
+class TaskGroup
+{
+public:
+  explicit TaskGroup(TaskPool& pool = TaskPool::get());
+
+  /// Wait for the tasks, their exception is lost: call wait() before
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  /**
+   * @brief Submit a task to the pool
+   * @param[in] function The task
+   * @param[in] taskClass The class of the task, for its concurrency limit
+   */
+  void run(std::function<void()> function, ETaskClass taskClass = ETaskClass::Compute);
+
+  /**
+   * @brief Wait for all the tasks submitted to the group, running queued tasks meanwhile
+   * @throw the first exception thrown by a task of the group
+   */
+  void wait();
+
+  /// Whether a task of the group has thrown an exception
+  bool isCancelled() const { return _cancelled; }
+
+  TaskPool& getPool() { return _pool; }
+
+private:
+  friend class TaskPool;
+
+  /// Mark a task of the group as done (exception is the error of the task, if any)
+  void onTaskDone(std::exception_ptr exception);
+
+  TaskPool& _pool;
+  std::atomic<int> _nbPending{0};
+  std::atomic<bool> _cancelled{false};
+  std::exception_ptr _exception;
+  std::mutex _mutex;
+  std::condition_variable _done;
+};
+
+/**
+ * @brief Options of parallelFor
+ */
+struct ParallelForOptions
+{
+  /// class of the iterations, for the concurrency limit of the pool
+  ETaskClass taskClass = ETaskClass::Compute;
+  /// maximum number of iterations running at the same time, 0 for the pool limit only
+  int maxConcurrency = 0;
+  /// number of consecutive iterations taken at once by a thread, 0 for automatic
+  int grainSize = 0;
+};
+
+/**
+ * @brief Run function(i) for each i in [begin, end) on the TaskPool threads.
+ *        The iterations are distributed dynamically (as schedule(dynamic) does).
+ *        It can be nested: the waiting threads run the iterations of the inner loops.
+ * @throw the first exception thrown by an iteration, the next iterations are not started
+ */
+template <class Index, class Function>
+void parallelFor(Index begin, Index end, const Function& function,
+                 const ParallelForOptions& options = ParallelForOptions(),
+                 TaskPool& pool = TaskPool::get())
+{
+  if(end <= begin)
+    return;
+
+  const std::int64_t nbIterations = static_cast<std::int64_t>(end - begin);
+
+  int nbRunners = pool.getMaxConcurrency(options.taskClass);
+  if(options.maxConcurrency > 0)
+    nbRunners = std::min(nbRunners, options.maxConcurrency);
+  nbRunners = static_cast<int>(std::min<std::int64_t>(nbRunners, nbIterations));
+
+  const std::int64_t grainSize = (options.grainSize > 0) ? options.grainSize : std::max<std::int64_t>(1, nbIterations / (8 * nbRunners));
+
+  std::atomic<std::int64_t> next(0);
+  TaskGroup group(pool);
+
+  // each runner takes the next chunk of iterations until all are done
+  const auto runner = [&]()
+  {
+    for(std::int64_t chunk = next.fetch_add(grainSize); chunk < nbIterations && !group.isCancelled(); chunk = next.fetch_add(grainSize))
+    {
+      const std::int64_t chunkEnd = std::min(chunk + grainSize, nbIterations);
+      for(std::int64_t i = chunk; i < chunkEnd; ++i)
+        function(static_cast<Index>(begin + i));
+    }
+  };
+
+  for(int r = 0; r < nbRunners; ++r)
+    group.run(runner, options.taskClass);
+
+  group.wait();
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -164,3 +164,154 @@ int get_total_cpus(void)
 
 #endif /* GET_TOTAL_CPUS_DEFINED */
 
+
+/* cpu_has_avx2() runtime detection of the instruction set */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+namespace aliceVision {
+namespace system {
+
+static bool detect_avx2(void)
+{
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	/* OSXSAVE and AVX */
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+	/* the OS saves the XMM and YMM registers */
+	if ((_xgetbv(0) & 0x6) != 0x6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+}
+}}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+namespace aliceVision {
+namespace system {
+
+static bool detect_avx2(void)
+{
+	/* also checks that the OS saves the YMM registers */
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+}
+}}
+#else
+namespace aliceVision {
+namespace system {
+
+static bool detect_avx2(void)
+{
+	return false;
+}
+}}
+#endif
+
+namespace aliceVision {
+namespace system {
+
+bool cpu_has_avx2(void)
+{
+	static const bool hasAvx2 = detect_avx2();
+	return hasAvx2;
+}
+}}
+
+
+/* get_numa_nodes_cpus() and set_current_thread_affinity(): uses the Linux sysfs and pthread affinity */
+#if defined linux || defined __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+namespace aliceVision {
+namespace system {
+
+/* parse a list of CPUs or nodes as "0-3,8,10-11" */
+static std::vector<int> parse_id_list(const std::string& list)
+{
+	std::vector<int> ids;
+	std::stringstream ss(list);
+	std::string range;
+	while (std::getline(ss, range, ',')) {
+		int first, last;
+		const int n = sscanf(range.c_str(), "%d-%d", &first, &last);
+		if (n < 1) continue;
+		if (n == 1) last = first;
+		for (int id = first; id <= last; ++id)
+			ids.push_back(id);
+	}
+	return ids;
+}
+
+static bool read_line(const std::string& path, std::string& line)
+{
+	std::ifstream f(path);
+	return f && std::getline(f, line);
+}
+
+static std::vector<std::vector<int>> detect_numa_nodes_cpus(void)
+{
+	std::vector<std::vector<int>> nodes;
+	std::string line;
+	if (read_line("/sys/devices/system/node/online", line)) {
+		for (int node : parse_id_list(line)) {
+			std::string cpus;
+			if (!read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", cpus))
+				continue;
+			std::vector<int> nodeCpus = parse_id_list(cpus);
+			/* memory only nodes */
+			if (!nodeCpus.empty())
+				nodes.push_back(nodeCpus);
+		}
+	}
+	return nodes;
+}
+
+bool set_current_thread_affinity(const std::vector<int>& cpus)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu : cpus) {
+		if (cpu >= 0 && cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+	}
+	return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+}}
+#else
+namespace aliceVision {
+namespace system {
+
+static std::vector<std::vector<int>> detect_numa_nodes_cpus(void)
+{
+	return {};
+}
+
+bool set_current_thread_affinity(const std::vector<int>&)
+{
+	return false;
+}
+}}
+#endif
+
+namespace aliceVision {
+namespace system {
+
+const std::vector<std::vector<int>>& get_numa_nodes_cpus(void)
+{
+	static const std::vector<std::vector<int>> nodes = []() {
+		std::vector<std::vector<int>> detected = detect_numa_nodes_cpus();
+		if (detected.empty()) {
+			detected.emplace_back();
+			for (int cpu = 0; cpu < get_total_cpus(); ++cpu)
+				detected.back().push_back(cpu);
+		}
+		return detected;
+	}();
+	return nodes;
+}
+}}
@@ -6,6 +6,19 @@
 
 #pragma once
 
+#include <vector>
+
+// Kernels compiled for AVX2 and selected at runtime with use_avx2_kernels().
+// With GCC and Clang they are compiled for AVX2 through the target attribute,
+// so the rest of the code does not require any instruction set flag.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ALICEVISION_HAVE_AVX2
+#define ALICEVISION_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define ALICEVISION_HAVE_AVX2
+#define ALICEVISION_AVX2_TARGET
+#endif
+
 namespace aliceVision {
 namespace system {
 
@@ -22,6 +35,35 @@ int cpu_clock_by_os();
  */
 int get_total_cpus();
 
+/**
+ * @brief Returns true if the CPU and the OS support AVX2 instructions.
+ * @note The result is computed once and cached.
+ */
+bool cpu_has_avx2();
+
+/**
+ * @brief Returns true if the kernels compiled with ALICEVISION_AVX2_TARGET can be used on this CPU.
+ * @note Inline copy of cpu_has_avx2() for the dispatch in the inner loops.
+ */
+inline bool use_avx2_kernels()
+{
+  static const bool hasAvx2 = cpu_has_avx2();
+  return hasAvx2;
+}
+
+/**
+ * @brief Returns the CPUs of each NUMA node having CPUs.
+ *        Without NUMA information, returns a single node with all the CPUs.
+ * @note The result is computed once and cached.
+ */
+const std::vector<std::vector<int>>& get_numa_nodes_cpus();
+
+/**
+ * @brief Restricts the calling thread to the given CPUs.
+ * @return false if the thread affinity is not supported or cannot be set
+ */
+bool set_current_thread_affinity(const std::vector<int>& cpus);
+
 }
 }
 
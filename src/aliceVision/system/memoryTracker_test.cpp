@@ -0,0 +1,77 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MemoryTracker.hpp"
+#include "MemoryInfo.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#define BOOST_TEST_MODULE systemMemoryTracker
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+BOOST_AUTO_TEST_CASE(MemoryTracker_stages)
+{
+  system::MemoryTracker& tracker = system::MemoryTracker::get();
+  tracker.start(std::chrono::milliseconds(1));
+
+  std::atomic<std::size_t> gpuBytes(0);
+  const int provider = tracker.addGpuMemoryProvider([&gpuBytes]() { return gpuBytes.load(); });
+
+  const std::size_t bytes = 64 * 1024 * 1024;
+  {
+    system::MemoryStage stage("outer");
+    {
+      system::MemoryStage innerStage("inner");
+      std::unique_ptr<char[]> buffer(new char[bytes]);
+      std::memset(buffer.get(), 1, bytes);
+      gpuBytes = 1000;
+      tracker.sample();
+      gpuBytes = 0;
+    }
+  }
+  tracker.removeGpuMemoryProvider(provider);
+  tracker.stop();
+
+  const std::vector<system::MemoryStageReport> stages = tracker.getStages();
+  BOOST_REQUIRE_EQUAL(stages.size(), 2);
+  BOOST_CHECK_EQUAL(stages[0].name, "outer");
+  BOOST_CHECK_EQUAL(stages[0].depth, 0);
+  BOOST_CHECK_EQUAL(stages[1].name, "inner");
+  BOOST_CHECK_EQUAL(stages[1].depth, 1);
+
+  for(const system::MemoryStageReport& stage : stages)
+  {
+    BOOST_CHECK(!stage.running);
+    BOOST_CHECK_GE(stage.duration, 0.0);
+    BOOST_CHECK_EQUAL(stage.peakGpu, 1000);
+    BOOST_CHECK_GE(stage.peakRss, stage.startRss);
+    BOOST_CHECK_GE(stage.peakRss, stage.endRss);
+    // the resident memory is unknown on some systems
+    if(system::getProcessMemory() > 0)
+      BOOST_CHECK_GE(stage.peakRss, stage.startRss + bytes / 2);
+  }
+  BOOST_CHECK_GE(stages[0].duration, stages[1].duration);
+  BOOST_CHECK_GE(tracker.getPeakRss(), stages[0].peakRss);
+  BOOST_CHECK_EQUAL(tracker.getPeakGpu(), 1000);
+  BOOST_CHECK(!tracker.getSamples().empty());
+
+  const std::string path = "memoryTracker_test.json";
+  BOOST_CHECK(tracker.exportJson(path));
+  std::ifstream file(path);
+  const std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  BOOST_CHECK(json.find("\"name\":\"inner\"") != std::string::npos);
+  BOOST_CHECK(json.find("\"samples\":[") != std::string::npos);
+  file.close();
+  std::remove(path.c_str());
+}
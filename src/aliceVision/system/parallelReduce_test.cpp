@@ -0,0 +1,101 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ParallelReduce.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#define BOOST_TEST_MODULE systemParallelReduce
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+namespace {
+
+/// values of very different magnitudes, their float sum depends on the order
+double term(int i)
+{
+  return std::pow(10.0, (i * 7) % 23 - 11) * ((i % 3 == 0) ? -1.0 : 1.0);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ParallelReduce_sum)
+{
+  system::TaskPool pool(4);
+
+  // empty range
+  BOOST_CHECK_EQUAL(system::parallelReduce(5, 5, 42, [](int&, int) {}, [](int a, int b) { return a + b; }, 0, pool), 42);
+
+  for(int size : {1, 7, 1000, 100000})
+  {
+    for(std::int64_t blockSize : {0, 1, 3, 1024})
+    {
+      const std::int64_t sum = system::parallelReduce(0, size, std::int64_t(0),
+                                                      [](std::int64_t& value, int i) { value += i; },
+                                                      [](std::int64_t a, std::int64_t b) { return a + b; },
+                                                      blockSize, pool);
+      BOOST_CHECK_EQUAL(sum, std::int64_t(size) * (size - 1) / 2);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ParallelReduce_reproducible)
+{
+  const auto reduce = [](system::TaskPool& pool, std::int64_t blockSize)
+  {
+    return system::parallelReduce(0, 200000, 0.0,
+                                  [](double& value, int i) { value += term(i); },
+                                  [](double a, double b) { return a + b; },
+                                  blockSize, pool);
+  };
+
+  system::TaskPool pool1(1);
+  system::TaskPool pool3(3);
+  system::TaskPool pool8(8);
+
+  // fixed partition: bit-identical whatever the number of threads
+  const double reference = reduce(pool1, 100);
+  for(int run = 0; run < 5; ++run)
+  {
+    BOOST_CHECK_EQUAL(reduce(pool3, 100), reference);
+    BOOST_CHECK_EQUAL(reduce(pool8, 100), reference);
+  }
+
+  // the automatic partition is fixed in deterministic mode
+  const bool deterministic = system::isDeterministic();
+  system::setDeterministic(true);
+  BOOST_CHECK(system::isDeterministic());
+  const double automaticReference = reduce(pool1, 0);
+  BOOST_CHECK_EQUAL(reduce(pool3, 0), automaticReference);
+  BOOST_CHECK_EQUAL(reduce(pool8, 0), automaticReference);
+  system::setDeterministic(deterministic);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelReduce_collect)
+{
+  system::TaskPool pool(4);
+
+  for(std::int64_t blockSize : {0, 1, 5, 1024})
+  {
+    // iteration i gives i % 4 elements
+    std::vector<int> result{-1};
+    system::parallelCollect(0, 5000, [](std::vector<int>& output, int i)
+    {
+      for(int k = 0; k < i % 4; ++k)
+        output.push_back(i);
+    }, result, blockSize, pool);
+
+    std::vector<int> expected{-1};
+    for(int i = 0; i < 5000; ++i)
+      for(int k = 0; k < i % 4; ++k)
+        expected.push_back(i);
+
+    BOOST_CHECK(result == expected);
+  }
+}
@@ -0,0 +1,131 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Profiler.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE systemProfiler
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+BOOST_AUTO_TEST_CASE(Profiler_nestedScopes)
+{
+  system::Profiler& profiler = system::Profiler::get();
+  profiler.clear();
+
+  // not recorded while disabled
+  {
+    system::ProfilerScope scope("disabled");
+  }
+  profiler.enable();
+  {
+    system::ProfilerScope scope("parent", 10);
+    for(int i = 0; i < 3; ++i)
+    {
+      system::ProfilerScope child("child");
+      child.addBytes(5);
+    }
+  }
+  profiler.disable();
+
+  const std::vector<std::vector<system::ProfilerEvent>> events = profiler.getEvents();
+  BOOST_REQUIRE_EQUAL(events.size(), 1);
+  BOOST_REQUIRE_EQUAL(events.front().size(), 4);
+
+  // recorded at their end: the children first
+  for(int i = 0; i < 3; ++i)
+  {
+    const system::ProfilerEvent& child = events.front()[i];
+    BOOST_CHECK_EQUAL(std::strcmp(child.label, "child"), 0);
+    BOOST_CHECK_EQUAL(child.depth, 1);
+    BOOST_CHECK_EQUAL(child.bytes, 5);
+    BOOST_CHECK(child.start <= child.end);
+  }
+
+  const system::ProfilerEvent& parent = events.front().back();
+  BOOST_CHECK_EQUAL(std::strcmp(parent.label, "parent"), 0);
+  BOOST_CHECK_EQUAL(parent.depth, 0);
+  BOOST_CHECK_EQUAL(parent.bytes, 10);
+  BOOST_CHECK(parent.start <= events.front().front().start);
+  BOOST_CHECK(parent.end >= events.front()[2].end);
+  BOOST_CHECK_EQUAL(system::Profiler::threadDepth(), 0);
+
+  profiler.logSummary();
+}
+
+BOOST_AUTO_TEST_CASE(Profiler_threadsRingBuffer)
+{
+  system::Profiler& profiler = system::Profiler::get();
+  profiler.clear();
+
+  // the new threads only keep their last 4 events
+  profiler.enable(4);
+
+  std::vector<std::thread> threads;
+  for(int t = 0; t < 2; ++t)
+  {
+    threads.emplace_back([]() {
+      for(int i = 0; i < 10; ++i)
+      {
+        system::ProfilerScope scope("work", i);
+      }
+    });
+  }
+  for(std::thread& thread : threads)
+    thread.join();
+  profiler.disable();
+
+  const std::vector<std::vector<system::ProfilerEvent>> events = profiler.getEvents();
+
+  // the main thread of the previous test and the 2 new threads
+  BOOST_REQUIRE_EQUAL(events.size(), 3);
+  BOOST_CHECK(events[0].empty());
+  for(std::size_t t = 1; t < 3; ++t)
+  {
+    BOOST_REQUIRE_EQUAL(events[t].size(), 4);
+    for(std::size_t i = 0; i < 4; ++i)
+      BOOST_CHECK_EQUAL(events[t][i].bytes, 6 + i);
+  }
+  BOOST_CHECK_EQUAL(profiler.getNbDroppedEvents(), 2 * 6);
+}
+
+BOOST_AUTO_TEST_CASE(Profiler_chromeTrace)
+{
+  system::Profiler& profiler = system::Profiler::get();
+  profiler.clear();
+
+  profiler.enable();
+  {
+    system::ProfilerScope scope("trace \"scope\"", 42);
+  }
+  profiler.disable();
+
+  const std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("profiler_%%%%.json")).string();
+  BOOST_REQUIRE(profiler.exportChromeTrace(path));
+
+  boost::property_tree::ptree trace;
+  boost::property_tree::read_json(path, trace);
+  boost::filesystem::remove(path);
+
+  const boost::property_tree::ptree& traceEvents = trace.get_child("traceEvents");
+  BOOST_REQUIRE_EQUAL(traceEvents.size(), 1);
+
+  const boost::property_tree::ptree& event = traceEvents.front().second;
+  BOOST_CHECK_EQUAL(event.get<std::string>("name"), "trace \"scope\"");
+  BOOST_CHECK_EQUAL(event.get<std::string>("ph"), "X");
+  BOOST_CHECK_EQUAL(event.get<int>("tid"), 0);
+  BOOST_CHECK_EQUAL(event.get<std::uint64_t>("args.bytes"), 42);
+  BOOST_CHECK(event.get<double>("dur") >= 0.0);
+}
@@ -0,0 +1,117 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "RingBuffer.hpp"
+
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE systemRingBuffer
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+BOOST_AUTO_TEST_CASE(RingBuffer_fifo)
+{
+  system::RingBuffer<int> ring(3);
+
+  // the size is rounded up to a power of two
+  BOOST_CHECK_EQUAL(ring.maxSize(), 4);
+
+  int element = 0;
+  BOOST_CHECK(!ring.tryPop(element));
+
+  for(int round = 0; round < 3; ++round)
+  {
+    for(int i = 0; i < 4; ++i)
+    {
+      element = i;
+      BOOST_CHECK(ring.tryPush(element));
+    }
+
+    // full
+    element = 4;
+    BOOST_CHECK(!ring.tryPush(element));
+    BOOST_CHECK_EQUAL(element, 4);
+
+    for(int i = 0; i < 4; ++i)
+    {
+      BOOST_CHECK(ring.tryPop(element));
+      BOOST_CHECK_EQUAL(element, i);
+    }
+    BOOST_CHECK(!ring.tryPop(element));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RingBuffer_close)
+{
+  std::shared_ptr<int> value = std::make_shared<int>(42);
+  {
+    system::RingBuffer<std::shared_ptr<int>> ring(2);
+    BOOST_CHECK(ring.push(value));
+    BOOST_CHECK(ring.push(value));
+    BOOST_CHECK_EQUAL(value.use_count(), 3);
+
+    ring.close();
+    BOOST_CHECK(!ring.push(value));
+
+    // the remaining elements can be popped
+    std::shared_ptr<int> element;
+    BOOST_CHECK(ring.pop(element));
+    BOOST_CHECK_EQUAL(*element, 42);
+    element.reset();
+    BOOST_CHECK_EQUAL(value.use_count(), 2);
+  }
+  // the element left in the ring is destroyed
+  BOOST_CHECK_EQUAL(value.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(RingBuffer_multipleProducersConsumers)
+{
+  const int nbProducers = 4;
+  const int nbConsumers = 4;
+  const int nbElementsPerProducer = 20000;
+
+  system::RingBuffer<int> ring(16);
+  std::vector<long long> sumPerConsumer(nbConsumers, 0);
+  std::vector<int> countPerConsumer(nbConsumers, 0);
+
+  std::vector<std::thread> consumers;
+  for(int c = 0; c < nbConsumers; ++c)
+  {
+    consumers.emplace_back([&, c]()
+    {
+      int element;
+      while(ring.pop(element))
+      {
+        sumPerConsumer[c] += element;
+        ++countPerConsumer[c];
+      }
+    });
+  }
+
+  std::vector<std::thread> producers;
+  for(int p = 0; p < nbProducers; ++p)
+  {
+    producers.emplace_back([&, p]()
+    {
+      for(int i = 0; i < nbElementsPerProducer; ++i)
+        ring.push(p * nbElementsPerProducer + i);
+    });
+  }
+
+  for(std::thread& producer : producers)
+    producer.join();
+  ring.close();
+  for(std::thread& consumer : consumers)
+    consumer.join();
+
+  const long long nbElements = nbProducers * nbElementsPerProducer;
+  BOOST_CHECK_EQUAL(std::accumulate(countPerConsumer.begin(), countPerConsumer.end(), 0), nbElements);
+  BOOST_CHECK_EQUAL(std::accumulate(sumPerConsumer.begin(), sumPerConsumer.end(), 0LL), nbElements * (nbElements - 1) / 2);
+}
@@ -0,0 +1,221 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "Storage.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE systemStorage
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+namespace fs = boost::filesystem;
+namespace asio = boost::asio;
+using asio::ip::tcp;
+
+namespace {
+
+/**
+ * @brief Minimal HTTP server of files in memory: HEAD, GET (with a byte range) and PUT
+ */
+class TestHttpServer
+{
+public:
+  TestHttpServer()
+    : _acceptor(_ioService, tcp::endpoint(asio::ip::address_v4::loopback(), 0))
+  {
+    _thread = std::thread([this]() { run(); });
+  }
+
+  ~TestHttpServer()
+  {
+    _stop = true;
+    // unblock the accept
+    tcp::socket socket(_ioService);
+    boost::system::error_code ec;
+    socket.connect(_acceptor.local_endpoint(), ec);
+    _thread.join();
+  }
+
+  std::string getUrl() const
+  {
+    return "http://127.0.0.1:" + std::to_string(_acceptor.local_endpoint().port());
+  }
+
+  std::map<std::string, std::string> files;
+  std::atomic<int> nbGet{0};
+
+private:
+  void run()
+  {
+    while(!_stop)
+    {
+      tcp::socket socket(_ioService);
+      boost::system::error_code ec;
+      _acceptor.accept(socket, ec);
+      if(ec || _stop)
+        continue;
+
+      asio::streambuf requestBuffer;
+      asio::read_until(socket, requestBuffer, "\r\n\r\n", ec);
+      if(ec)
+        continue;
+
+      std::istream requestStream(&requestBuffer);
+      std::string method, target, line;
+      requestStream >> method >> target;
+      std::getline(requestStream, line);
+      std::size_t contentLength = 0;
+      std::string range;
+      while(std::getline(requestStream, line) && line != "\r")
+      {
+        if(line.compare(0, 16, "Content-Length: ") == 0)
+          contentLength = std::stoul(line.substr(16));
+        if(line.compare(0, 13, "Range: bytes=") == 0)
+          range = line.substr(13);
+      }
+
+      std::ostringstream response;
+      if(method == "PUT")
+      {
+        std::string body(std::istreambuf_iterator<char>(requestStream), {});
+        if(body.size() < contentLength)
+        {
+          std::vector<char> rest(contentLength - body.size());
+          asio::read(socket, asio::buffer(rest), ec);
+          body.append(rest.begin(), rest.end());
+        }
+        files[target] = body;
+        response << "HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n";
+      }
+      else if(files.count(target) == 0)
+      {
+        response << "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+      }
+      else
+      {
+        const std::string& file = files[target];
+        std::string body = file;
+        int status = 200;
+        if(!range.empty())
+        {
+          const std::size_t first = std::stoul(range);
+          const std::size_t last = std::min<std::size_t>(std::stoul(range.substr(range.find('-') + 1)), file.size() - 1);
+          body = file.substr(first, last + 1 - first);
+          status = 206;
+        }
+        response << "HTTP/1.1 " << status << " OK\r\nContent-Length: " << body.size() << "\r\n\r\n";
+        if(method == "GET")
+        {
+          response << body;
+          ++nbGet;
+        }
+      }
+      asio::write(socket, asio::buffer(response.str()), ec);
+      socket.shutdown(tcp::socket::shutdown_both, ec);
+    }
+  }
+
+  asio::io_service _ioService;
+  tcp::acceptor _acceptor;
+  std::atomic<bool> _stop{false};
+  std::thread _thread;
+};
+
+std::string toString(const std::vector<char>& data)
+{
+  return std::string(data.begin(), data.end());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Storage_local)
+{
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path();
+  const std::string path = (folder / "file.bin").string();
+
+  system::Storage storage;
+  BOOST_CHECK(system::Storage::isLocalPath(path));
+  BOOST_CHECK(!system::Storage::isLocalPath("http://localhost/file.bin"));
+  BOOST_CHECK(!storage.exists(path));
+
+  storage.writeAsync(path, std::vector<char>{'a', 'b', 'c', 'd'});
+  storage.flush();
+  BOOST_CHECK(storage.exists(path));
+  BOOST_CHECK_EQUAL(storage.getSize(path), 4);
+  BOOST_CHECK_EQUAL(storage.getLocalPath(path), path);
+
+  std::vector<char> data;
+  storage.read(path, 1, 2, data);
+  BOOST_CHECK_EQUAL(toString(data), "bc");
+  storage.read(path, 3, 10, data);
+  BOOST_CHECK_EQUAL(toString(data), "d");
+
+  std::vector<std::vector<char>> batch;
+  storage.readBatch({path, "file://" + path}, batch);
+  BOOST_CHECK_EQUAL(batch.size(), 2);
+  BOOST_CHECK_EQUAL(toString(batch[1]), "abcd");
+
+  BOOST_CHECK_THROW(storage.readAll((folder / "missing.bin").string(), data), std::runtime_error);
+
+  fs::remove_all(folder);
+}
+
+BOOST_AUTO_TEST_CASE(Storage_http)
+{
+  TestHttpServer server;
+  server.files["/bucket/image.jpg"] = "0123456789";
+
+  const fs::path cacheFolder = fs::temp_directory_path() / fs::unique_path();
+  const std::string url = server.getUrl() + "/bucket/image.jpg";
+
+  system::HttpStorageBackend http(0);
+  BOOST_CHECK(http.exists(url));
+  BOOST_CHECK(!http.exists(server.getUrl() + "/bucket/missing.jpg"));
+  BOOST_CHECK_EQUAL(http.getSize(url), 10);
+
+  std::vector<char> data;
+  http.read(url, 2, 3, data);
+  BOOST_CHECK_EQUAL(toString(data), "234");
+  http.readAll(url, data);
+  BOOST_CHECK_EQUAL(toString(data), "0123456789");
+  BOOST_CHECK_THROW(http.readAll(server.getUrl() + "/bucket/missing.jpg", data), std::runtime_error);
+
+  // cache tier: a single download for several reads
+  std::string localPath;
+  {
+    system::CachedStorageBackend cache(std::make_shared<system::HttpStorageBackend>(0), cacheFolder.string(), 1024);
+    const int nbGet = server.nbGet;
+    localPath = cache.getLocalPath(url);
+    BOOST_CHECK_EQUAL(fs::path(localPath).extension().string(), ".jpg");
+    BOOST_CHECK_EQUAL(fs::file_size(localPath), 10);
+    cache.read(url, 5, 2, data);
+    BOOST_CHECK_EQUAL(toString(data), "56");
+    BOOST_CHECK_EQUAL(server.nbGet - nbGet, 1);
+
+    cache.write(server.getUrl() + "/bucket/out.txt", "result", 6);
+    BOOST_CHECK_EQUAL(server.files["/bucket/out.txt"], "result");
+    BOOST_CHECK(cache.isCached(server.getUrl() + "/bucket/out.txt"));
+  }
+
+  // the cache folder is reused, the least recently used files are removed beyond the maximum size
+  fs::last_write_time(localPath, fs::last_write_time(localPath) - 10);
+  {
+    system::CachedStorageBackend cache(std::make_shared<system::HttpStorageBackend>(0), cacheFolder.string(), 12);
+    BOOST_CHECK(!cache.isCached(url));
+    BOOST_CHECK(cache.isCached(server.getUrl() + "/bucket/out.txt"));
+  }
+
+  fs::remove_all(cacheFolder);
+}
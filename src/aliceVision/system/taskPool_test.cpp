@@ -0,0 +1,151 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TaskPool.hpp"
+#include "FirstTouchAllocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MODULE systemTaskPool
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+
+BOOST_AUTO_TEST_CASE(TaskPool_parallelFor)
+{
+  system::TaskPool pool(4);
+  BOOST_CHECK_EQUAL(pool.getNbThreads(), 4);
+
+  for(int grainSize : {0, 1, 7})
+  {
+    std::vector<int> counts(1000, 0);
+    system::ParallelForOptions options;
+    options.grainSize = grainSize;
+    system::parallelFor(0, 1000, [&](int i) { ++counts[i]; }, options, pool);
+
+    for(int i = 0; i < 1000; ++i)
+      BOOST_CHECK_EQUAL(counts[i], 1);
+  }
+
+  // empty range
+  system::parallelFor(5, 5, [](int) { throw std::logic_error("no iteration expected"); }, system::ParallelForOptions(), pool);
+}
+
+BOOST_AUTO_TEST_CASE(TaskPool_nested)
+{
+  system::TaskPool pool(3);
+
+  std::atomic<int> sum(0);
+  system::parallelFor(0, 20, [&](int i)
+  {
+    system::parallelFor(0, 50, [&](int j) { sum += i * 50 + j; }, system::ParallelForOptions(), pool);
+  }, system::ParallelForOptions(), pool);
+
+  BOOST_CHECK_EQUAL(sum.load(), 1000 * 999 / 2);
+}
+
+BOOST_AUTO_TEST_CASE(TaskPool_singleThread)
+{
+  // the waiting thread runs all the tasks
+  system::TaskPool pool(1);
+
+  std::atomic<int> sum(0);
+  system::TaskGroup group(pool);
+  for(int i = 0; i < 10; ++i)
+    group.run([&sum, i]() { sum += i; }, system::ETaskClass::DiskRead);
+  group.wait();
+
+  BOOST_CHECK_EQUAL(sum.load(), 45);
+}
+
+BOOST_AUTO_TEST_CASE(TaskPool_exception)
+{
+  system::TaskPool pool(4);
+
+  std::atomic<int> nbDone(0);
+  BOOST_CHECK_THROW(system::parallelFor(0, 100000, [&](int i)
+  {
+    if(i == 10)
+      throw std::runtime_error("iteration failure");
+    ++nbDone;
+  }, system::ParallelForOptions(), pool), std::runtime_error);
+
+  // the group can be used again after the exception
+  system::TaskGroup group(pool);
+  group.run([]() { throw std::invalid_argument("task failure"); });
+  BOOST_CHECK_THROW(group.wait(), std::invalid_argument);
+  group.run([&nbDone]() { nbDone = -1; });
+  BOOST_CHECK_NO_THROW(group.wait());
+  BOOST_CHECK_EQUAL(nbDone.load(), -1);
+}
+
+BOOST_AUTO_TEST_CASE(TaskPool_concurrencyLimit)
+{
+  system::TaskPool pool(8);
+  pool.setConcurrencyLimit(system::ETaskClass::DiskRead, 2);
+  BOOST_CHECK_EQUAL(pool.getConcurrencyLimit(system::ETaskClass::DiskRead), 2);
+  BOOST_CHECK_EQUAL(pool.getMaxConcurrency(system::ETaskClass::DiskRead), 2);
+  BOOST_CHECK_EQUAL(pool.getMaxConcurrency(system::ETaskClass::Compute), 8);
+
+  std::atomic<int> nbRunning(0);
+  std::atomic<int> maxRunning(0);
+  const auto task = [&]()
+  {
+    const int running = ++nbRunning;
+    int previousMax = maxRunning;
+    while(running > previousMax && !maxRunning.compare_exchange_weak(previousMax, running))
+    {}
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    --nbRunning;
+  };
+
+  // tasks of the class submitted one by one
+  {
+    system::TaskGroup group(pool);
+    for(int i = 0; i < 20; ++i)
+      group.run(task, system::ETaskClass::DiskRead);
+    group.wait();
+  }
+  BOOST_CHECK_LE(maxRunning.load(), 2);
+  BOOST_CHECK_GE(maxRunning.load(), 1);
+
+  // limit of the loop itself
+  maxRunning = 0;
+  system::ParallelForOptions options;
+  options.maxConcurrency = 3;
+  options.grainSize = 1;
+  system::parallelFor(0, 30, [&](int) { task(); }, options, pool);
+  BOOST_CHECK_LE(maxRunning.load(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(TaskPool_numaNodes)
+{
+  const int nbNodes = system::TaskPool::getNbNumaNodes();
+  BOOST_CHECK_GE(nbNodes, 1);
+
+  for(int node = 0; node < nbNodes; ++node)
+  {
+    std::atomic<int> sum(0);
+    system::parallelFor(0, 100, [&](int i) { sum += i; }, system::ParallelForOptions(), system::TaskPool::getNumaNode(node));
+    BOOST_CHECK_EQUAL(sum.load(), 4950);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TaskPool_firstTouchAllocator)
+{
+  // large enough to be touched by the pool threads
+  const std::size_t size = 2 * system::firstTouchMinBytes / sizeof(int) + 3;
+  std::vector<int, system::FirstTouchAllocator<int>> values(size, 7);
+
+  BOOST_CHECK_EQUAL(values.front(), 7);
+  BOOST_CHECK_EQUAL(values.back(), 7);
+  BOOST_CHECK_EQUAL(static_cast<std::size_t>(std::count(values.begin(), values.end(), 7)), size);
+}
@@ -0,0 +1,142 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace track {
+
+/**
+ * @brief Lock-free union-find over the dense set of elements [0, size).
+ *
+ * The parent and the rank of each element are packed in a single atomic word,
+ * so unite() and find() can be called concurrently from several threads.
+ * Roots are linked by rank (ties broken by index) with a compare-and-swap,
+ * and find() compresses the paths by halving.
+ *
+ * Richard J. Anderson, Heather Woll:
+ * Wait-free parallel algorithms for the union-find problem. STOC 1991: 370-380
+ */
+class ConcurrentUnionFind
+{
+public:
+  /**
+   * @param[in] size The number of elements, each one in its own set
+   */
+  explicit ConcurrentUnionFind(std::size_t size)
+    : _nodes(size)
+  {
+    assert(size <= PARENT_MASK);
+    for(std::size_t i = 0; i < size; ++i)
+      _nodes[i].store(encode(i, 0), std::memory_order_relaxed);
+  }
+
+  /// The number of elements
+  std::size_t size() const
+  {
+    return _nodes.size();
+  }
+
+  /**
+   * @brief Find the representative of the set of an element.
+   * @param[in] x The element
+   * @return The root of the set of x
+   */
+  std::size_t find(std::size_t x)
+  {
+    for(;;)
+    {
+      std::uint64_t word = _nodes[x].load(std::memory_order_acquire);
+      const std::size_t p = parent(word);
+      if(p == x)
+        return x;
+
+      const std::size_t gp = parent(_nodes[p].load(std::memory_order_acquire));
+      if(gp == p)
+        return p;
+
+      // path halving, x is not a root so its rank doesn't matter anymore
+      _nodes[x].compare_exchange_weak(word, encode(gp, rank(word)), std::memory_order_release, std::memory_order_relaxed);
+      x = gp;
+    }
+  }
+
+  /**
+   * @brief Merge the sets of two elements.
+   * @param[in] x The first element
+   * @param[in] y The second element
+   */
+  void unite(std::size_t x, std::size_t y)
+  {
+    for(;;)
+    {
+      x = find(x);
+      y = find(y);
+      if(x == y)
+        return;
+
+      std::uint64_t wordX = _nodes[x].load(std::memory_order_acquire);
+      std::uint64_t wordY = _nodes[y].load(std::memory_order_acquire);
+      if(parent(wordX) != x || parent(wordY) != y)
+        continue; // a root has been linked in the meantime
+
+      // link the lowest (rank, index) root under the other one
+      if(rank(wordX) > rank(wordY) || (rank(wordX) == rank(wordY) && x > y))
+      {
+        std::swap(x, y);
+        std::swap(wordX, wordY);
+      }
+
+      if(!_nodes[x].compare_exchange_strong(wordX, encode(y, rank(wordX)), std::memory_order_acq_rel, std::memory_order_relaxed))
+        continue;
+
+      // the rank is only a heuristic, the update can fail if y has been linked in the meantime
+      if(rank(wordX) == rank(wordY))
+        _nodes[y].compare_exchange_strong(wordY, encode(y, rank(wordY) + 1), std::memory_order_acq_rel, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  /**
+   * @brief Check if two elements are in the same set.
+   * @note Only reliable when no unite() is running concurrently
+   */
+  bool sameSet(std::size_t x, std::size_t y)
+  {
+    return find(x) == find(y);
+  }
+
+private:
+  static const int RANK_SHIFT = 56;
+  static const std::uint64_t PARENT_MASK = (std::uint64_t(1) << RANK_SHIFT) - 1;
+
+  static std::uint64_t encode(std::size_t parent, std::uint64_t rank)
+  {
+    return (rank << RANK_SHIFT) | static_cast<std::uint64_t>(parent);
+  }
+
+  static std::size_t parent(std::uint64_t word)
+  {
+    return static_cast<std::size_t>(word & PARENT_MASK);
+  }
+
+  static std::uint64_t rank(std::uint64_t word)
+  {
+    return word >> RANK_SHIFT;
+  }
+
+  std::vector<std::atomic<std::uint64_t>> _nodes;
+};
+
+} // namespace track
+} // namespace aliceVision
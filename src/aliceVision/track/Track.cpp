@@ -6,83 +6,116 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Track.hpp"
+#include "TracksStore.hpp"
+#include "ConcurrentUnionFind.hpp"
+
+#include <limits>
 
 namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
 
 void TracksBuilder::build(const PairwiseMatches& pairwiseMatches)
 {
-  typedef std::set<IndexedFeaturePair> SetIndexedPair;
+  // list the matches of each pair, to process them in parallel
+  std::vector<std::pair<Pair, const MatchesPerDescType*>> pairs;
+  std::vector<std::size_t> pairsOffset(1, 0);
+  pairs.reserve(pairwiseMatches.size());
+  pairsOffset.reserve(pairwiseMatches.size() + 1);
+  for(const auto& matchesPerDescIt: pairwiseMatches)
+  {
+    std::size_t nbMatches = 0;
+    for(const auto& matchesIt: matchesPerDescIt.second)
+      nbMatches += matchesIt.second.size();
+    pairs.emplace_back(matchesPerDescIt.first, &matchesPerDescIt.second);
+    pairsOffset.push_back(pairsOffset.back() + 2 * nbMatches);
+  }
 
-  // set of all features of all images: (imageIndex, featureIndex)
-  SetIndexedPair allFeatures;
+  // all features of all images: (imageIndex, featureIndex)
+  _features.resize(pairsOffset.back());
 
-  // for each couple of images make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+  #pragma omp parallel for schedule(dynamic)
+  for(int p = 0; p < static_cast<int>(pairs.size()); ++p)
   {
-    const std::size_t& I = matchesPerDescIt.first.first;
-    const std::size_t& J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
+    const std::size_t& I = pairs[p].first.first;
+    const std::size_t& J = pairs[p].first.second;
+    std::size_t f = pairsOffset[p];
 
-    for(const auto& matchesIt: matchesPerDesc)
+    for(const auto& matchesIt: *pairs[p].second)
     {
       const feature::EImageDescriberType descType = matchesIt.first;
       const IndMatches& matches = matchesIt.second;
       // we have correspondences between I and J image index.
       for(const IndMatch& m: matches)
       {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        allFeatures.insert(pairI);
-        allFeatures.insert(pairJ);
+        _features[f++] = IndexedFeaturePair(I, KeypointId(descType, m._i));
+        _features[f++] = IndexedFeaturePair(J, KeypointId(descType, m._j));
       }
     }
   }
 
-  // build the node indirection for each referenced feature
-  MapIndexToNode map_indexToNode;
-  map_indexToNode.reserve(allFeatures.size());
-  _map_nodeToIndex.reserve(allFeatures.size());
+  // sort and remove duplicates to get the dense feature index
+  std::sort(_features.begin(), _features.end());
+  _features.erase(std::unique(_features.begin(), _features.end()), _features.end());
+  _features.shrink_to_fit();
 
-  for(const IndexedFeaturePair& featPair: allFeatures)
+  const auto featureIndex = [&](const IndexedFeaturePair& feature) -> std::size_t
   {
-    lemon::ListDigraph::Node node = _graph.addNode();
-    map_indexToNode.insert(std::make_pair(featPair, node));
-    _map_nodeToIndex.insert(std::make_pair(node, featPair));
-  }
-
-  // add the element of myset to the UnionFind insert method.
-  _index = std::unique_ptr<IndexMap>( new IndexMap(_graph) );
-  _tracksUF = std::unique_ptr<UnionFindObject>(new UnionFindObject(*_index));
-
-  for(ListDigraph::NodeIt it(_graph); it != INVALID; ++it)
-  {
-    _tracksUF->insert(it);
-  }
+    return std::distance(_features.begin(), std::lower_bound(_features.begin(), _features.end(), feature));
+  };
 
   // make the union according the pair matches
-  for(const auto& matchesPerDescIt: pairwiseMatches)
+  ConcurrentUnionFind tracksUF(_features.size());
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int p = 0; p < static_cast<int>(pairs.size()); ++p)
   {
-    const std::size_t& I = matchesPerDescIt.first.first;
-    const std::size_t& J = matchesPerDescIt.first.second;
-    const MatchesPerDescType& matchesPerDesc = matchesPerDescIt.second;
+    const std::size_t& I = pairs[p].first.first;
+    const std::size_t& J = pairs[p].first.second;
 
-    for(const auto& matchesIt: matchesPerDesc)
+    for(const auto& matchesIt: *pairs[p].second)
     {
       const feature::EImageDescriberType descType = matchesIt.first;
       const IndMatches& matches = matchesIt.second;
-      // we have correspondences between I and J image index.
       for(const IndMatch& m: matches)
       {
-        IndexedFeaturePair pairI(I, KeypointId(descType, m._i));
-        IndexedFeaturePair pairJ(J, KeypointId(descType, m._j));
-        _tracksUF->join(map_indexToNode[pairI], map_indexToNode[pairJ]);
+        tracksUF.unite(featureIndex(IndexedFeaturePair(I, KeypointId(descType, m._i))),
+                       featureIndex(IndexedFeaturePair(J, KeypointId(descType, m._j))));
       }
     }
   }
+
+  // root of each feature
+  std::vector<std::size_t> featureTrack(_features.size());
+
+  #pragma omp parallel for
+  for(int i = 0; i < static_cast<int>(featureTrack.size()); ++i)
+    featureTrack[i] = tracksUF.find(i);
+
+  // number the tracks by their first feature, independently of the union order
+  const std::size_t undefined = std::numeric_limits<std::size_t>::max();
+  std::vector<std::size_t> rootTrack(_features.size(), undefined);
+  std::size_t nbTracks = 0;
+  for(std::size_t& track : featureTrack)
+  {
+    std::size_t& trackId = rootTrack[track];
+    if(trackId == undefined)
+      trackId = nbTracks++;
+    track = trackId;
+  }
+
+  // features of each track, sorted
+  _trackOffsets.assign(nbTracks + 1, 0);
+  for(std::size_t track : featureTrack)
+    ++_trackOffsets[track + 1];
+  for(std::size_t t = 0; t < nbTracks; ++t)
+    _trackOffsets[t + 1] += _trackOffsets[t];
+
+  std::vector<std::size_t> cursor(_trackOffsets.begin(), _trackOffsets.end() - 1);
+  _trackFeatures.resize(_features.size());
+  for(std::size_t i = 0; i < featureTrack.size(); ++i)
+    _trackFeatures[cursor[featureTrack[i]]++] = i;
 }
 
 void TracksBuilder::filter(std::size_t minTrackLength, bool multithreaded)
@@ -91,49 +124,46 @@ void TracksBuilder::filter(std::size_t minTrackLength, bool multithreaded)
   // - track that are too short,
   // - track with id conflicts (many times the same image index)
 
-  std::set<int> set_classToErase;
+  std::vector<char> validTracks(nbTracks());
 
-#pragma omp parallel if(multithreaded)
-  for(lemon::UnionFindEnum<IndexMap>::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
+  #pragma omp parallel for if(multithreaded)
+  for(int t = 0; t < static_cast<int>(validTracks.size()); ++t)
   {
-
-#pragma omp single nowait
-    {
-      std::size_t cpt = 0;
-      std::set<std::size_t> myset;
-      for(lemon::UnionFindEnum<IndexMap>::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
-      {
-        myset.insert(_map_nodeToIndex[iit].first);
-        ++cpt;
-      }
-      if(myset.size() != cpt || myset.size() < minTrackLength)
-      {
-#pragma omp critical
-        set_classToErase.insert(cit.operator int());
-      }
-    }
+    const std::size_t begin = _trackOffsets[t];
+    const std::size_t end = _trackOffsets[t + 1];
+    bool valid = (end - begin >= minTrackLength);
+    // features are sorted by image index
+    for(std::size_t i = begin + 1; valid && i < end; ++i)
+      valid = (_features[_trackFeatures[i - 1]].first != _features[_trackFeatures[i]].first);
+    validTracks[t] = valid;
   }
 
-  std::for_each(set_classToErase.begin(), set_classToErase.end(),
-    std::bind1st(std::mem_fun(&UnionFindObject::eraseClass), _tracksUF.get()));
+  // keep the valid tracks, in the same order
+  std::size_t nbValidTracks = 0;
+  std::size_t nbValidFeatures = 0;
+  for(std::size_t t = 0; t < validTracks.size(); ++t)
+  {
+    if(!validTracks[t])
+      continue;
+    for(std::size_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
+      _trackFeatures[nbValidFeatures++] = _trackFeatures[i];
+    _trackOffsets[++nbValidTracks] = nbValidFeatures;
+  }
+  _trackOffsets.resize(nbValidTracks + 1);
+  _trackFeatures.resize(nbValidFeatures);
 }
 
 bool TracksBuilder::exportToStream(std::ostream& os)
 {
-  std::size_t cpt = 0;
-  for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
+  for(std::size_t t = 0; t < nbTracks(); ++t)
   {
-    os << "Class: " << cpt++ << std::endl;
-    std::size_t cptTrackLength = 0;
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
-    {
-      ++cptTrackLength;
-    }
-    os << "\t" << "track length: " << cptTrackLength << std::endl;
+    os << "Class: " << t << std::endl;
+    os << "\t" << "track length: " << _trackOffsets[t + 1] - _trackOffsets[t] << std::endl;
 
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
+    for(std::size_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
     {
-      os << _map_nodeToIndex[ iit ].first << "  " << _map_nodeToIndex[ iit ].second << std::endl;
+      const IndexedFeaturePair& currentPair = _features[_trackFeatures[i]];
+      os << currentPair.first << "  " << currentPair.second << std::endl;
     }
   }
   return os.good();
@@ -142,18 +172,17 @@ bool TracksBuilder::exportToStream(std::ostream& os)
 void TracksBuilder::exportToSTL(TracksMap& allTracks) const
 {
   allTracks.clear();
+  allTracks.reserve(nbTracks());
 
-  std::size_t trackIndex = 0;
-  for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit, ++trackIndex)
+  for(std::size_t t = 0; t < nbTracks(); ++t)
   {
     // create the output track
-    std::pair<TracksMap::iterator, bool> ret = allTracks.insert(std::make_pair(trackIndex, Track()));
+    Track& outTrack = allTracks.emplace_hint(allTracks.end(), t, Track())->second;
+    outTrack.featPerView.reserve(_trackOffsets[t + 1] - _trackOffsets[t]);
 
-    Track& outTrack = ret.first->second;
-
-    for(lemon::UnionFindEnum< IndexMap >::ItemIt iit(*_tracksUF, cit); iit != INVALID; ++iit)
+    for(std::size_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
     {
-      const IndexedFeaturePair & currentPair = _map_nodeToIndex.at(iit);
+      const IndexedFeaturePair& currentPair = _features[_trackFeatures[i]];
       // all descType inside the track will be the same
       outTrack.descType = currentPair.second.descType;
       outTrack.featPerView[currentPair.first] = currentPair.second.featIndex;
@@ -161,6 +190,38 @@ void TracksBuilder::exportToSTL(TracksMap& allTracks) const
   }
 }
 
+void TracksBuilder::exportToStore(TracksStore& allTracks) const
+{
+  std::vector<std::size_t> trackIds(nbTracks());
+  std::vector<feature::EImageDescriberType> descTypes(nbTracks(), feature::EImageDescriberType::UNINITIALIZED);
+  std::vector<std::size_t> trackOffsets(1, 0);
+  std::vector<std::size_t> viewIds;
+  std::vector<std::size_t> featIds;
+
+  trackOffsets.reserve(nbTracks() + 1);
+  viewIds.reserve(_trackFeatures.size());
+  featIds.reserve(_trackFeatures.size());
+
+  for(std::size_t t = 0; t < nbTracks(); ++t)
+  {
+    trackIds[t] = t;
+    for(std::size_t i = _trackOffsets[t]; i < _trackOffsets[t + 1]; ++i)
+    {
+      const IndexedFeaturePair& currentPair = _features[_trackFeatures[i]];
+      // all descType inside the track will be the same
+      descTypes[t] = currentPair.second.descType;
+      // features are sorted by view id, keep the last feature of a view like exportToSTL
+      if(i + 1 < _trackOffsets[t + 1] && _features[_trackFeatures[i + 1]].first == currentPair.first)
+        continue;
+      viewIds.push_back(currentPair.first);
+      featIds.push_back(currentPair.second.featIndex);
+    }
+    trackOffsets.push_back(viewIds.size());
+  }
+
+  allTracks = TracksStore(std::move(trackIds), std::move(descTypes), std::move(trackOffsets), std::move(viewIds), std::move(featIds));
+}
+
 namespace tracksUtilsMap {
 
 bool getCommonTracksInImages(const std::set<std::size_t>& imageIndexes,
@@ -13,10 +13,8 @@
 #include <aliceVision/stl/FlatMap.hpp>
 #include <aliceVision/stl/FlatSet.hpp>
 
-#include <lemon/list_graph.h>
-#include <lemon/unionfind.h>
-
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <functional>
 #include <vector>
@@ -28,7 +26,8 @@ namespace aliceVision {
 namespace track {
 
 using namespace aliceVision::matching;
-using namespace lemon;
+
+class TracksStore;
 
 /**
  * @brief A Track is a feature visible accross multiple views.
@@ -52,20 +51,18 @@ typedef stl::flat_map<std::size_t, Track> TracksMap;
 typedef std::vector<std::size_t> TrackIdSet;
 
 /**
- * @brief Data structure that contains for each features of each view, its corresponding cell positions for each level of the pyramid, i.e.
+ * @brief Data structure that contains for each feature of each view its cell positions in each level of a pyramid, i.e.
  * for each view:
- *   each feature is mapped N times (N=depth of the pyramid)
- *      each times it contains the absolute position P of the cell in the corresponding pyramid level
+ *   each feature has a 32 bits code packing the index of its cell in every level of the pyramid (N=depth of the pyramid)
  *
- * FeatsPyramidPerView contains map<viewId, map<trackId*N, pyramidIndex>>
+ * TracksPyramidPerView contains map<viewId, vector<code>>, the codes being in the order of the view tracks in TracksPerView.
  *
- * Cell position:
- * Consider the set of all cells of all pyramids, there are M = \sum_{l=1...N} K_l^2 cells with K_l = 2^l and l=1...N
- * We enumerate the cells starting from the first pyramid l=1 (so that they have position from 0 to 3 (ie K^2 - 1))
- * and we go on for increasing values of l so that e.g. the first cell of the pyramid at l=2 has position K^2, the second K^2 + 1 etc...
- * So in general the i-th cell of the pyramid at level l has position P= \sum_{j=1...l-1} K_j^2 + i
+ * Cell index:
+ * The pyramid level l=1...N is a grid of K_l x K_l cells with K_l = 2^l.
+ * The cell (x, y) of the level l has the index i = x + y * K_l, stored on ceil(log2(K_l^2)) bits,
+ * the first level being in the lowest bits of the code.
  */
-typedef stl::flat_map<std::size_t, stl::flat_map<std::size_t, std::size_t> > TracksPyramidPerView;
+typedef stl::flat_map<std::size_t, std::vector<std::uint32_t> > TracksPyramidPerView;
 
 /**
  * @brief TracksPerView is a list of visible track ids for each view.
@@ -91,6 +88,11 @@ struct KeypointId
     return descType < other.descType;
   }
 
+  bool operator==(const KeypointId& other) const
+  {
+    return descType == other.descType && featIndex == other.featIndex;
+  }
+
   feature::EImageDescriberType descType = feature::EImageDescriberType::UNINITIALIZED;
   std::size_t featIndex = 0;
 };
@@ -131,31 +133,17 @@ struct TracksBuilder
 {
   /// IndexedFeaturePair is: map<viewId, keypointId>
   typedef std::pair<std::size_t, KeypointId> IndexedFeaturePair;
-  typedef ListDigraph::NodeMap<std::size_t> IndexMap;
-  typedef lemon::UnionFindEnum< IndexMap > UnionFindObject;
-
-  typedef stl::flat_map< lemon::ListDigraph::Node, IndexedFeaturePair> MapNodeToIndex;
-  typedef stl::flat_map< IndexedFeaturePair, lemon::ListDigraph::Node > MapIndexToNode;
 
-  /// graph container to create the node
-  lemon::ListDigraph _graph;
-  /// node to index map
-  MapNodeToIndex _map_nodeToIndex;
-  std::unique_ptr<IndexMap> _index;
-  std::unique_ptr<UnionFindObject> _tracksUF;
-
-  const UnionFindObject& getUnionFindEnum() const
-  {
-    return *_tracksUF;
-  }
-
-  const MapNodeToIndex& getReverseMap() const
-  {
-    return _map_nodeToIndex;
-  }
+  /// all the matched features, sorted: the dense feature index of the union-find
+  std::vector<IndexedFeaturePair> _features;
+  /// feature indexes of each track (sorted), in [_trackOffsets[i], _trackOffsets[i+1])
+  std::vector<std::size_t> _trackFeatures;
+  std::vector<std::size_t> _trackOffsets{0};
 
   /**
    * @brief Build tracks for a given series of pairWise matches
+   * @note The union of the matches is multithreaded, the tracks are sorted by their first feature
+   *       so the result doesn't depend on the number of threads.
    * @param[in] pairwiseMatches PairWise matches
    */
   void build(const PairwiseMatches& pairwiseMatches);
@@ -180,16 +168,19 @@ struct TracksBuilder
    */
   void exportToSTL(TracksMap& allTracks) const;
 
+  /**
+   * @brief Export tracks in the compact CSR layout of TracksStore,
+   *        with the same track ids as exportToSTL
+   */
+  void exportToStore(TracksStore& allTracks) const;
+
   /**
    * @brief Return the number of connected set in the UnionFind structure (tree forest)
    * @return number of connected set in the UnionFind structure
    */
   std::size_t nbTracks() const
   {
-    std::size_t cpt = 0;
-    for(lemon::UnionFindEnum< IndexMap >::ClassIt cit(*_tracksUF); cit != INVALID; ++cit)
-      ++cpt;
-    return cpt;
+    return _trackOffsets.size() - 1;
   }
 };
 
@@ -0,0 +1,219 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TracksStore.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace aliceVision {
+namespace track {
+
+const std::size_t TracksStore::UNDEFINED;
+
+TracksStore::TracksStore(const TracksMap& tracks)
+{
+  std::size_t nbObservations = 0;
+  for(const auto& track : tracks)
+    nbObservations += track.second.featPerView.size();
+
+  _trackIds.reserve(tracks.size());
+  _descTypes.reserve(tracks.size());
+  _trackOffsets.reserve(tracks.size() + 1);
+  _viewIds.reserve(nbObservations);
+  _featIds.reserve(nbObservations);
+
+  // TracksMap and featPerView are sorted by id
+  for(const auto& track : tracks)
+  {
+    _trackIds.push_back(track.first);
+    _descTypes.push_back(track.second.descType);
+    for(const auto& feat : track.second.featPerView)
+    {
+      _viewIds.push_back(feat.first);
+      _featIds.push_back(feat.second);
+    }
+    _trackOffsets.push_back(_viewIds.size());
+  }
+
+  computeTracksPerView();
+}
+
+TracksStore::TracksStore(std::vector<std::size_t>&& trackIds,
+                         std::vector<feature::EImageDescriberType>&& descTypes,
+                         std::vector<std::size_t>&& trackOffsets,
+                         std::vector<std::size_t>&& viewIds,
+                         std::vector<std::size_t>&& featIds)
+  : _trackIds(std::move(trackIds))
+  , _descTypes(std::move(descTypes))
+  , _trackOffsets(std::move(trackOffsets))
+  , _viewIds(std::move(viewIds))
+  , _featIds(std::move(featIds))
+{
+  assert(_descTypes.size() == _trackIds.size());
+  assert(_trackOffsets.size() == _trackIds.size() + 1);
+  assert(_trackOffsets.back() == _viewIds.size());
+  assert(_featIds.size() == _viewIds.size());
+  assert(std::is_sorted(_trackIds.begin(), _trackIds.end()));
+
+  computeTracksPerView();
+}
+
+std::size_t TracksStore::getTrackIndex(std::size_t trackId) const
+{
+  const auto it = std::lower_bound(_trackIds.begin(), _trackIds.end(), trackId);
+  if(it == _trackIds.end() || *it != trackId)
+    return UNDEFINED;
+  return static_cast<std::size_t>(std::distance(_trackIds.begin(), it));
+}
+
+std::size_t TracksStore::getFeatId(std::size_t trackIndex, std::size_t viewId) const
+{
+  const Range<std::size_t> viewIds = getTrackViewIds(trackIndex);
+  const std::size_t* it = std::lower_bound(viewIds.begin(), viewIds.end(), viewId);
+  if(it == viewIds.end() || *it != viewId)
+    return UNDEFINED;
+  return _featIds[_trackOffsets[trackIndex] + (it - viewIds.begin())];
+}
+
+TracksStore::Range<std::size_t> TracksStore::getTracksInView(std::size_t viewId) const
+{
+  const auto it = std::lower_bound(_views.begin(), _views.end(), viewId);
+  if(it == _views.end() || *it != viewId)
+    return Range<std::size_t>(nullptr, nullptr);
+  const std::size_t v = static_cast<std::size_t>(std::distance(_views.begin(), it));
+  return Range<std::size_t>(_viewTracks.data() + _viewOffsets[v], _viewTracks.data() + _viewOffsets[v + 1]);
+}
+
+void TracksStore::getCommonTracksInViews(const std::set<std::size_t>& viewIds,
+                                         std::vector<std::size_t>& trackIndexes) const
+{
+  assert(!viewIds.empty());
+  trackIndexes.clear();
+
+  std::vector<Range<std::size_t>> viewsTracks;
+  viewsTracks.reserve(viewIds.size());
+  for(std::size_t viewId : viewIds)
+  {
+    const Range<std::size_t> viewTracks = getTracksInView(viewId);
+    // one view has no track, so there is no track in common
+    if(viewTracks.empty())
+      return;
+    viewsTracks.push_back(viewTracks);
+  }
+
+  // intersect starting from the smallest sets
+  std::sort(viewsTracks.begin(), viewsTracks.end(),
+            [](const Range<std::size_t>& a, const Range<std::size_t>& b) { return a.size() < b.size(); });
+
+  trackIndexes.assign(viewsTracks.front().begin(), viewsTracks.front().end());
+  std::vector<std::size_t> tmp;
+  tmp.reserve(trackIndexes.size());
+  for(std::size_t i = 1; i < viewsTracks.size() && !trackIndexes.empty(); ++i)
+  {
+    tmp.clear();
+    std::set_intersection(trackIndexes.begin(), trackIndexes.end(),
+                          viewsTracks[i].begin(), viewsTracks[i].end(),
+                          std::back_inserter(tmp));
+    trackIndexes.swap(tmp);
+  }
+}
+
+void TracksStore::getTracksInViews(const std::set<std::size_t>& viewIds,
+                                   std::vector<std::size_t>& trackIndexes) const
+{
+  trackIndexes.clear();
+  for(std::size_t viewId : viewIds)
+  {
+    const Range<std::size_t> viewTracks = getTracksInView(viewId);
+    trackIndexes.insert(trackIndexes.end(), viewTracks.begin(), viewTracks.end());
+  }
+  std::sort(trackIndexes.begin(), trackIndexes.end());
+  trackIndexes.erase(std::unique(trackIndexes.begin(), trackIndexes.end()), trackIndexes.end());
+}
+
+void TracksStore::exportToSTL(TracksMap& tracks) const
+{
+  tracks.clear();
+  tracks.reserve(nbTracks());
+
+  for(std::size_t i = 0; i < nbTracks(); ++i)
+  {
+    // track ids are increasing, insert at the end
+    Track& track = tracks.emplace_hint(tracks.end(), _trackIds[i], Track())->second;
+    track.descType = _descTypes[i];
+    track.featPerView.reserve(getTrackLength(i));
+    for(std::size_t j = _trackOffsets[i]; j < _trackOffsets[i + 1]; ++j)
+      track.featPerView.emplace_hint(track.featPerView.end(), _viewIds[j], _featIds[j]);
+  }
+}
+
+void TracksStore::exportToSTL(const std::vector<std::size_t>& trackIndexes,
+                              const std::set<std::size_t>& viewIds,
+                              TracksMap& tracks) const
+{
+  tracks.clear();
+  tracks.reserve(trackIndexes.size());
+
+  for(std::size_t i : trackIndexes)
+  {
+    Track& track = tracks[_trackIds[i]];
+    track.descType = _descTypes[i];
+    track.featPerView.clear();
+    for(std::size_t j = _trackOffsets[i]; j < _trackOffsets[i + 1]; ++j)
+    {
+      if(viewIds.empty() || viewIds.count(_viewIds[j]))
+        track.featPerView.emplace_hint(track.featPerView.end(), _viewIds[j], _featIds[j]);
+    }
+  }
+}
+
+void TracksStore::exportToSTL(TracksPerView& tracksPerView) const
+{
+  tracksPerView.clear();
+  tracksPerView.reserve(nbViews());
+
+  for(std::size_t v = 0; v < nbViews(); ++v)
+  {
+    TrackIdSet& viewTracks = tracksPerView.emplace_hint(tracksPerView.end(), _views[v], TrackIdSet())->second;
+    viewTracks.reserve(_viewOffsets[v + 1] - _viewOffsets[v]);
+    // track indexes are sorted like the track ids
+    for(std::size_t j = _viewOffsets[v]; j < _viewOffsets[v + 1]; ++j)
+      viewTracks.push_back(_trackIds[_viewTracks[j]]);
+  }
+}
+
+void TracksStore::computeTracksPerView()
+{
+  _views = _viewIds;
+  std::sort(_views.begin(), _views.end());
+  _views.erase(std::unique(_views.begin(), _views.end()), _views.end());
+
+  // view index of each observation
+  std::vector<std::size_t> observationViews(_viewIds.size());
+  _viewOffsets.assign(_views.size() + 1, 0);
+  for(std::size_t j = 0; j < _viewIds.size(); ++j)
+  {
+    const std::size_t v = static_cast<std::size_t>(std::distance(_views.begin(), std::lower_bound(_views.begin(), _views.end(), _viewIds[j])));
+    observationViews[j] = v;
+    ++_viewOffsets[v + 1];
+  }
+  for(std::size_t v = 0; v < _views.size(); ++v)
+    _viewOffsets[v + 1] += _viewOffsets[v];
+
+  // fill in the order of the tracks, so each view has sorted track indexes
+  std::vector<std::size_t> cursor(_viewOffsets.begin(), _viewOffsets.end() - 1);
+  _viewTracks.resize(_viewIds.size());
+  for(std::size_t i = 0; i < nbTracks(); ++i)
+  {
+    for(std::size_t j = _trackOffsets[i]; j < _trackOffsets[i + 1]; ++j)
+      _viewTracks[cursor[observationViews[j]]++] = i;
+  }
+}
+
+} // namespace track
+} // namespace aliceVision
@@ -0,0 +1,248 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/track/Track.hpp>
+
+#include <cstddef>
+#include <set>
+#include <vector>
+
+namespace aliceVision {
+namespace track {
+
+/**
+ * @brief Compact storage of the tracks in compressed sparse row (CSR) layout.
+ *
+ * The observations of all the tracks are stored in two flat arrays of view ids and feature ids,
+ * the observations of the i-th track being in [trackOffsets[i], trackOffsets[i+1]) sorted by view id.
+ * The visible tracks of each view are stored the same way, as sorted arrays of track indexes.
+ *
+ * Tracks are addressed by their index in the store, from 0 to nbTracks() - 1.
+ * The track indexes are sorted by increasing track id, so the order of the tracks is the one of TracksMap.
+ *
+ * The store is immutable: it is built at once from a TracksBuilder or from a TracksMap,
+ * and can be converted back to TracksMap / TracksPerView for the existing consumers.
+ */
+class TracksStore
+{
+public:
+  /// Read-only contiguous range of elements
+  template<typename T>
+  class Range
+  {
+  public:
+    Range(const T* begin, const T* end)
+      : _begin(begin)
+      , _end(end)
+    {}
+
+    const T* begin() const { return _begin; }
+    const T* end() const { return _end; }
+    std::size_t size() const { return static_cast<std::size_t>(_end - _begin); }
+    bool empty() const { return _begin == _end; }
+    const T& operator[](std::size_t i) const { return _begin[i]; }
+
+  private:
+    const T* _begin;
+    const T* _end;
+  };
+
+  /// Value returned for a track or a feature that is not in the store
+  static const std::size_t UNDEFINED = static_cast<std::size_t>(-1);
+
+  TracksStore() = default;
+
+  /**
+   * @brief Build the store from tracks.
+   * @param[in] tracks The tracks to store
+   */
+  explicit TracksStore(const TracksMap& tracks);
+
+  /**
+   * @brief Build the store from a list of tracks in CSR layout.
+   * @param[in] trackIds The increasing id of each track
+   * @param[in] descTypes The descriptor type of each track
+   * @param[in] trackOffsets The offset of the first observation of each track, with a final entry for the total
+   * @param[in] viewIds The view id of each observation, increasing inside each track
+   * @param[in] featIds The feature id of each observation
+   */
+  TracksStore(std::vector<std::size_t>&& trackIds,
+              std::vector<feature::EImageDescriberType>&& descTypes,
+              std::vector<std::size_t>&& trackOffsets,
+              std::vector<std::size_t>&& viewIds,
+              std::vector<std::size_t>&& featIds);
+
+  /// The number of tracks
+  std::size_t nbTracks() const
+  {
+    return _trackIds.size();
+  }
+
+  /// The number of observations of all the tracks
+  std::size_t nbObservations() const
+  {
+    return _viewIds.size();
+  }
+
+  /// The number of views with at least one visible track
+  std::size_t nbViews() const
+  {
+    return _views.size();
+  }
+
+  /// The ids of the views with at least one visible track, sorted increasing
+  const std::vector<std::size_t>& getViewIds() const
+  {
+    return _views;
+  }
+
+  /// The increasing track ids, per track index
+  const std::vector<std::size_t>& getTrackIds() const
+  {
+    return _trackIds;
+  }
+
+  /// The descriptor types, per track index
+  const std::vector<feature::EImageDescriberType>& getDescTypes() const
+  {
+    return _descTypes;
+  }
+
+  /// The offset of the first observation of each track, with a final entry for the total
+  const std::vector<std::size_t>& getTrackOffsets() const
+  {
+    return _trackOffsets;
+  }
+
+  /// The view ids of all the observations
+  const std::vector<std::size_t>& getObservationViewIds() const
+  {
+    return _viewIds;
+  }
+
+  /// The feature ids of all the observations
+  const std::vector<std::size_t>& getObservationFeatIds() const
+  {
+    return _featIds;
+  }
+
+  /// The id of the track at the given index
+  std::size_t getTrackId(std::size_t trackIndex) const
+  {
+    return _trackIds[trackIndex];
+  }
+
+  /// The descriptor type of the track at the given index
+  feature::EImageDescriberType getDescType(std::size_t trackIndex) const
+  {
+    return _descTypes[trackIndex];
+  }
+
+  /// The number of observations of the track at the given index
+  std::size_t getTrackLength(std::size_t trackIndex) const
+  {
+    return _trackOffsets[trackIndex + 1] - _trackOffsets[trackIndex];
+  }
+
+  /// The view ids of the track at the given index, sorted increasing
+  Range<std::size_t> getTrackViewIds(std::size_t trackIndex) const
+  {
+    return trackRange(_viewIds, trackIndex);
+  }
+
+  /// The feature ids of the track at the given index, in the order of getTrackViewIds
+  Range<std::size_t> getTrackFeatIds(std::size_t trackIndex) const
+  {
+    return trackRange(_featIds, trackIndex);
+  }
+
+  /**
+   * @brief Find the index of a track from its id.
+   * @param[in] trackId The track id
+   * @return The track index or UNDEFINED if the track is not in the store
+   */
+  std::size_t getTrackIndex(std::size_t trackId) const;
+
+  /**
+   * @brief Find the feature of a track in a view.
+   * @param[in] trackIndex The track index
+   * @param[in] viewId The view id
+   * @return The feature id or UNDEFINED if the track is not visible in the view
+   */
+  std::size_t getFeatId(std::size_t trackIndex, std::size_t viewId) const;
+
+  /**
+   * @brief Get the visible tracks of a view.
+   * @param[in] viewId The view id
+   * @return The sorted indexes of the visible tracks, empty if the view is unknown
+   */
+  Range<std::size_t> getTracksInView(std::size_t viewId) const;
+
+  /**
+   * @brief Find the tracks visible in all the given views.
+   * @param[in] viewIds The views we are looking for common tracks
+   * @param[out] trackIndexes The sorted indexes of the common tracks
+   */
+  void getCommonTracksInViews(const std::set<std::size_t>& viewIds,
+                              std::vector<std::size_t>& trackIndexes) const;
+
+  /**
+   * @brief Find the tracks visible in at least one of the given views.
+   * @param[in] viewIds The views we are looking for tracks
+   * @param[out] trackIndexes The sorted indexes of the tracks
+   */
+  void getTracksInViews(const std::set<std::size_t>& viewIds,
+                        std::vector<std::size_t>& trackIndexes) const;
+
+  /**
+   * @brief Export all the tracks as a TracksMap.
+   * @param[out] tracks The tracks
+   */
+  void exportToSTL(TracksMap& tracks) const;
+
+  /**
+   * @brief Export some tracks as a TracksMap, restricted to their observations in the given views.
+   * @param[in] trackIndexes The indexes of the tracks to export
+   * @param[in] viewIds The views to keep, all the views if empty
+   * @param[out] tracks The tracks
+   */
+  void exportToSTL(const std::vector<std::size_t>& trackIndexes,
+                   const std::set<std::size_t>& viewIds,
+                   TracksMap& tracks) const;
+
+  /**
+   * @brief Export the visible track ids of each view as a TracksPerView.
+   * @param[out] tracksPerView The visible track ids of each view
+   */
+  void exportToSTL(TracksPerView& tracksPerView) const;
+
+private:
+  template<typename T>
+  Range<T> trackRange(const std::vector<T>& values, std::size_t trackIndex) const
+  {
+    return Range<T>(values.data() + _trackOffsets[trackIndex], values.data() + _trackOffsets[trackIndex + 1]);
+  }
+
+  /// Build the per view arrays from the per track arrays
+  void computeTracksPerView();
+
+  // per track arrays
+  std::vector<std::size_t> _trackIds;
+  std::vector<feature::EImageDescriberType> _descTypes;
+  std::vector<std::size_t> _trackOffsets{0};
+  // per observation arrays
+  std::vector<std::size_t> _viewIds;
+  std::vector<std::size_t> _featIds;
+  // per view arrays
+  std::vector<std::size_t> _views;
+  std::vector<std::size_t> _viewOffsets{0};
+  std::vector<std::size_t> _viewTracks;
+};
+
+} // namespace track
+} // namespace aliceVision
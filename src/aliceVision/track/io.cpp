@@ -0,0 +1,249 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "io.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace track {
+
+namespace {
+
+/// 64 bits FNV-1a hash, fed with 64 bits words
+class Fnv1aHash
+{
+public:
+  void add(std::uint64_t value)
+  {
+    for(int i = 0; i < 8; ++i)
+    {
+      _hash ^= (value >> (8 * i)) & 0xff;
+      _hash *= 0x100000001b3ull;
+    }
+  }
+
+  std::uint64_t value() const
+  {
+    return _hash;
+  }
+
+private:
+  std::uint64_t _hash = 0xcbf29ce484222325ull;
+};
+
+template<typename T>
+void writeArray(std::ofstream& stream, const std::vector<T>& values)
+{
+  const std::vector<std::uint64_t> buffer(values.begin(), values.end());
+  stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(std::uint64_t));
+}
+
+template<typename T>
+const char* readArray(const char* data, std::size_t size, std::vector<T>& values)
+{
+  values.resize(size);
+  if(sizeof(T) == sizeof(std::uint64_t))
+  {
+    std::memcpy(values.data(), data, size * sizeof(std::uint64_t));
+  }
+  else
+  {
+    for(std::size_t i = 0; i < size; ++i)
+    {
+      std::uint64_t value;
+      std::memcpy(&value, data + i * sizeof(std::uint64_t), sizeof(std::uint64_t));
+      values[i] = static_cast<T>(value);
+    }
+  }
+  return data + size * sizeof(std::uint64_t);
+}
+
+} // namespace
+
+std::uint64_t computeTracksFileKey(
+  const matching::PairwiseMatches& matches,
+  bool useTrackFiltering,
+  std::size_t minTrackLength)
+{
+  Fnv1aHash hash;
+  hash.add(TRACKS_FILE_VERSION);
+  hash.add(useTrackFiltering);
+  hash.add(useTrackFiltering ? minTrackLength : 0);
+
+  // PairwiseMatches and MatchesPerDescType are ordered maps, the hash is deterministic
+  for(const auto& matchesPerDescIt : matches)
+  {
+    hash.add(matchesPerDescIt.first.first);
+    hash.add(matchesPerDescIt.first.second);
+    for(const auto& matchesIt : matchesPerDescIt.second)
+    {
+      hash.add(static_cast<std::uint64_t>(matchesIt.first));
+      hash.add(matchesIt.second.size());
+      for(const matching::IndMatch& m : matchesIt.second)
+      {
+        hash.add(m._i);
+        hash.add(m._j);
+      }
+    }
+  }
+  return hash.value();
+}
+
+bool saveTracks(
+  const TracksStore& tracks,
+  const std::string& filepath,
+  std::uint64_t key)
+{
+  const fs::path bPath = fs::path(filepath);
+  const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+  TracksFileHeader header;
+  header.key = key;
+  header.nbTracks = tracks.nbTracks();
+  header.nbObservations = tracks.nbObservations();
+
+  // write temporary file
+  {
+    std::ofstream stream(tmpPath.c_str(), std::ios::out | std::ios::binary);
+    if(!stream.is_open())
+    {
+      ALICEVISION_LOG_WARNING("Can't save binary tracks file, can't open: " << tmpPath);
+      return false;
+    }
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(TracksFileHeader));
+    writeArray(stream, tracks.getTrackIds());
+    writeArray(stream, tracks.getTrackOffsets());
+    writeArray(stream, tracks.getObservationViewIds());
+    writeArray(stream, tracks.getObservationFeatIds());
+
+    std::vector<std::uint32_t> descTypes(tracks.nbTracks());
+    for(std::size_t i = 0; i < descTypes.size(); ++i)
+      descTypes[i] = static_cast<std::uint32_t>(tracks.getDescType(i));
+    stream.write(reinterpret_cast<const char*>(descTypes.data()), descTypes.size() * sizeof(std::uint32_t));
+
+    if(!stream.good())
+    {
+      ALICEVISION_LOG_WARNING("Can't save binary tracks file, write error: " << tmpPath);
+      stream.close();
+      fs::remove(tmpPath);
+      return false;
+    }
+  }
+
+  // rename temporary file
+  fs::rename(tmpPath, filepath);
+  return true;
+}
+
+bool loadTracks(
+  TracksStore& tracks,
+  const std::string& filepath,
+  std::uint64_t key)
+{
+  if(!fs::exists(filepath))
+    return false;
+
+  namespace bi = boost::interprocess;
+  bi::file_mapping file;
+  bi::mapped_region region;
+  try
+  {
+    file = bi::file_mapping(filepath.c_str(), bi::read_only);
+    region = bi::mapped_region(file, bi::read_only);
+  }
+  catch(const bi::interprocess_exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Can't map binary tracks file '" << filepath << "': " << e.what());
+    return false;
+  }
+
+  const char* data = static_cast<const char*>(region.get_address());
+  const std::uint64_t fileSize = region.get_size();
+
+  TracksFileHeader header;
+  if(fileSize < sizeof(TracksFileHeader))
+  {
+    ALICEVISION_LOG_WARNING("Invalid binary tracks file: " << filepath);
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(TracksFileHeader));
+
+  if(header.magic != TRACKS_FILE_MAGIC)
+  {
+    ALICEVISION_LOG_WARNING("Invalid binary tracks file: " << filepath);
+    return false;
+  }
+
+  if(header.version != TRACKS_FILE_VERSION)
+  {
+    ALICEVISION_LOG_WARNING("Unsupported binary tracks file version (" << header.version << "): " << filepath);
+    return false;
+  }
+
+  if(header.key != key)
+  {
+    ALICEVISION_LOG_DEBUG("Binary tracks file built from other matches: " << filepath);
+    return false;
+  }
+
+  const std::uint64_t maxCount = fileSize / sizeof(std::uint64_t);
+  if(header.nbTracks > maxCount || header.nbObservations > maxCount ||
+     fileSize != sizeof(TracksFileHeader) + (2 * header.nbTracks + 1 + 2 * header.nbObservations) * sizeof(std::uint64_t) + header.nbTracks * sizeof(std::uint32_t))
+  {
+    ALICEVISION_LOG_WARNING("Truncated binary tracks file: " << filepath);
+    return false;
+  }
+
+  std::vector<std::size_t> trackIds;
+  std::vector<std::size_t> trackOffsets;
+  std::vector<std::size_t> viewIds;
+  std::vector<std::size_t> featIds;
+  std::vector<feature::EImageDescriberType> descTypes(header.nbTracks);
+
+  data += sizeof(TracksFileHeader);
+  data = readArray(data, header.nbTracks, trackIds);
+  data = readArray(data, header.nbTracks + 1, trackOffsets);
+  data = readArray(data, header.nbObservations, viewIds);
+  data = readArray(data, header.nbObservations, featIds);
+  for(std::size_t i = 0; i < descTypes.size(); ++i)
+  {
+    std::uint32_t descType;
+    std::memcpy(&descType, data + i * sizeof(std::uint32_t), sizeof(std::uint32_t));
+    descTypes[i] = static_cast<feature::EImageDescriberType>(descType);
+  }
+
+  // check the CSR layout before building the store
+  bool valid = (trackOffsets.front() == 0 && trackOffsets.back() == viewIds.size());
+  for(std::size_t i = 0; valid && i < trackIds.size(); ++i)
+  {
+    valid = (trackOffsets[i] <= trackOffsets[i + 1]) && (i == 0 || trackIds[i - 1] < trackIds[i]);
+    for(std::size_t j = trackOffsets[i] + 1; valid && j < trackOffsets[i + 1]; ++j)
+      valid = (viewIds[j - 1] < viewIds[j]);
+  }
+  if(!valid)
+  {
+    ALICEVISION_LOG_WARNING("Invalid tracks in binary tracks file: " << filepath);
+    return false;
+  }
+
+  tracks = TracksStore(std::move(trackIds), std::move(descTypes), std::move(trackOffsets), std::move(viewIds), std::move(featIds));
+  return true;
+}
+
+}  // namespace track
+}  // namespace aliceVision
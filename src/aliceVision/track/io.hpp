@@ -0,0 +1,95 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/track/TracksStore.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace aliceVision {
+namespace track {
+
+/**
+ * @brief Binary tracks file (.tracks)
+ *
+ * The layout is:
+ *  - a fixed size header (TracksFileHeader)
+ *  - the track ids, nbTracks x uint64
+ *  - the track offsets, (nbTracks + 1) x uint64
+ *  - the view ids of the observations, nbObservations x uint64
+ *  - the feature ids of the observations, nbObservations x uint64
+ *  - the describer types of the tracks, nbTracks x uint32
+ *
+ * It is the CSR layout of TracksStore, in native byte order.
+ * The key identifies the matches and the filtering used to build the tracks,
+ * so the file can be reused as a cache by the next runs on the same matches.
+ */
+
+/// Magic number identifying a binary tracks file ("AVTR")
+constexpr std::uint32_t TRACKS_FILE_MAGIC = 0x52545641;
+/// Current version of the binary tracks file format
+constexpr std::uint32_t TRACKS_FILE_VERSION = 1;
+
+/**
+ * @brief Fixed size header of a binary tracks file
+ */
+struct TracksFileHeader
+{
+  std::uint32_t magic = TRACKS_FILE_MAGIC;
+  std::uint32_t version = TRACKS_FILE_VERSION;
+  /// key of the input matches and filtering (see computeTracksFileKey)
+  std::uint64_t key = 0;
+  std::uint64_t nbTracks = 0;
+  std::uint64_t nbObservations = 0;
+};
+
+static_assert(sizeof(TracksFileHeader) == 32, "Unexpected TracksFileHeader size.");
+
+/**
+ * @brief Compute the key of the tracks built from the given matches.
+ *
+ * @param[in] matches: the input pairwise matches
+ * @param[in] useTrackFiltering: are the tracks filtered (TracksBuilder::filter)
+ * @param[in] minTrackLength: the minimum track length of the filtering
+ * @return a 64 bits hash of the matches and of the filtering parameters
+ */
+std::uint64_t computeTracksFileKey(
+  const matching::PairwiseMatches& matches,
+  bool useTrackFiltering,
+  std::size_t minTrackLength);
+
+/**
+ * @brief Save tracks in a binary tracks file.
+ *
+ * @param[in] tracks: the tracks
+ * @param[in] filepath: the binary tracks file (.tracks)
+ * @param[in] key: the key of the tracks (see computeTracksFileKey)
+ * @return false if the file can't be written
+ */
+bool saveTracks(
+  const TracksStore& tracks,
+  const std::string& filepath,
+  std::uint64_t key);
+
+/**
+ * @brief Load tracks from a binary tracks file, the file is memory mapped.
+ *
+ * @param[out] tracks: the tracks
+ * @param[in] filepath: the binary tracks file (.tracks)
+ * @param[in] key: the expected key of the tracks (see computeTracksFileKey)
+ * @return false if the file doesn't exist, is invalid or has another key
+ */
+bool loadTracks(
+  TracksStore& tracks,
+  const std::string& filepath,
+  std::uint64_t key);
+
+}  // namespace track
+}  // namespace aliceVision
@@ -5,11 +5,18 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file,
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
+#include "aliceVision/track/ConcurrentUnionFind.hpp"
 #include "aliceVision/track/Track.hpp"
+#include "aliceVision/track/TracksStore.hpp"
+#include "aliceVision/track/io.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
+#include "aliceVision/alicevision_omp.hpp"
 
 #include <vector>
 #include <utility>
+#include <random>
+#include <cstdio>
+#include <fstream>
 
 #define BOOST_TEST_MODULE Track
 #include <boost/test/included/unit_test.hpp>
@@ -226,3 +233,232 @@ BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
     BOOST_CHECK_EQUAL(base.size(), set_visibleTracks.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(Track_Store)
+{
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //2 -> 3
+
+  PairwiseMatches map_pairwisematches;
+
+  const IndMatch testAB[] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+  const IndMatch testBC[] = {IndMatch(0,0), IndMatch(1,6)};
+
+  const std::vector<IndMatch> ab(testAB, testAB+3);
+  const std::vector<IndMatch> bc(testBC, testBC+2);
+  const int A = 0;
+  const int B = 1;
+  const int C = 2;
+  map_pairwisematches[ std::make_pair(A, B) ][EImageDescriberType::UNKNOWN] = ab;
+  map_pairwisematches[ std::make_pair(B, C) ][EImageDescriberType::UNKNOWN] = bc;
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build( map_pairwisematches );
+
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+  TracksStore store;
+  trackBuilder.exportToStore(store);
+
+  BOOST_CHECK_EQUAL(3, store.nbTracks());
+  BOOST_CHECK_EQUAL(8, store.nbObservations());
+  BOOST_CHECK_EQUAL(3, store.nbViews());
+
+  // same tracks as exportToSTL and the TracksMap adapter
+  {
+    TracksMap map_tracksFromStore;
+    store.exportToSTL(map_tracksFromStore);
+    TracksMap map_tracksRoundTrip;
+    TracksStore(map_tracks).exportToSTL(map_tracksRoundTrip);
+
+    BOOST_CHECK_EQUAL(map_tracks.size(), map_tracksFromStore.size());
+    BOOST_CHECK_EQUAL(map_tracks.size(), map_tracksRoundTrip.size());
+    for(const auto& track : map_tracks)
+    {
+      BOOST_CHECK(track.second.featPerView == map_tracksFromStore.at(track.first).featPerView);
+      BOOST_CHECK(track.second.featPerView == map_tracksRoundTrip.at(track.first).featPerView);
+      BOOST_CHECK(EImageDescriberType::UNKNOWN == map_tracksFromStore.at(track.first).descType);
+    }
+  }
+
+  // same tracks per view as computeTracksPerView
+  {
+    TracksPerView map_tracksPerView;
+    tracksUtilsMap::computeTracksPerView(map_tracks, map_tracksPerView);
+    TracksPerView map_tracksPerViewFromStore;
+    store.exportToSTL(map_tracksPerViewFromStore);
+    BOOST_CHECK(map_tracksPerView == map_tracksPerViewFromStore);
+  }
+
+  // queries
+  const std::size_t trackIndex = store.getTrackIndex(1);
+  BOOST_CHECK_EQUAL(1, trackIndex);
+  BOOST_CHECK_EQUAL(TracksStore::UNDEFINED, store.getTrackIndex(10));
+  BOOST_CHECK_EQUAL(3, store.getTrackLength(trackIndex));
+  BOOST_CHECK_EQUAL(6, store.getFeatId(trackIndex, C));
+  BOOST_CHECK_EQUAL(TracksStore::UNDEFINED, store.getFeatId(store.getTrackIndex(2), C));
+
+  BOOST_CHECK_EQUAL(3, store.getTracksInView(B).size());
+  BOOST_CHECK_EQUAL(2, store.getTracksInView(C).size());
+  BOOST_CHECK(store.getTracksInView(10).empty());
+
+  std::vector<std::size_t> trackIndexes;
+  store.getCommonTracksInViews({A, C}, trackIndexes);
+  BOOST_CHECK(trackIndexes == std::vector<std::size_t>({0, 1}));
+  store.getCommonTracksInViews({A, 10}, trackIndexes);
+  BOOST_CHECK(trackIndexes.empty());
+  store.getTracksInViews({A, C}, trackIndexes);
+  BOOST_CHECK(trackIndexes == std::vector<std::size_t>({0, 1, 2}));
+
+  // same common tracks as getCommonTracksInImages
+  {
+    const std::set<std::size_t> imageIndexes{B, C};
+    TracksMap map_commonTracks;
+    tracksUtilsMap::getCommonTracksInImages(imageIndexes, map_tracks, map_commonTracks);
+
+    store.getCommonTracksInViews(imageIndexes, trackIndexes);
+    TracksMap map_commonTracksFromStore;
+    store.exportToSTL(trackIndexes, imageIndexes, map_commonTracksFromStore);
+
+    BOOST_CHECK_EQUAL(map_commonTracks.size(), map_commonTracksFromStore.size());
+    for(const auto& track : map_commonTracks)
+      BOOST_CHECK(track.second.featPerView == map_commonTracksFromStore.at(track.first).featPerView);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Track_ConcurrentUnionFind)
+{
+  const int nbElements = 10000;
+  const int nbUnions = 8000;
+
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<int> distribution(0, nbElements - 1);
+  std::vector<std::pair<int, int>> unions(nbUnions);
+  for(auto& u : unions)
+    u = std::make_pair(distribution(randomNumberGenerator), distribution(randomNumberGenerator));
+
+  // sequential reference
+  std::vector<int> reference(nbElements);
+  for(int i = 0; i < nbElements; ++i)
+    reference[i] = i;
+  const auto findReference = [&](int x)
+  {
+    while(reference[x] != x)
+      x = reference[x];
+    return x;
+  };
+  for(const auto& u : unions)
+    reference[findReference(u.first)] = findReference(u.second);
+
+  ConcurrentUnionFind unionFind(nbElements);
+  #pragma omp parallel for
+  for(int i = 0; i < nbUnions; ++i)
+    unionFind.unite(unions[i].first, unions[i].second);
+
+  for(int i = 0; i < nbElements; ++i)
+  {
+    const int j = distribution(randomNumberGenerator);
+    BOOST_CHECK_EQUAL(findReference(i) == findReference(j), unionFind.sameSet(i, j));
+    BOOST_CHECK_EQUAL(unionFind.sameSet(i, unions[i % nbUnions].first), unionFind.sameSet(i, unions[i % nbUnions].second));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Track_BuildDeterministic)
+{
+  // random matches between 20 images
+  const int nbViews = 20;
+  const int nbFeatures = 500;
+
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<int> distribution(0, nbFeatures - 1);
+  PairwiseMatches map_pairwisematches;
+  for(int i = 0; i < nbViews; ++i)
+  {
+    for(int j = i + 1; j < std::min(i + 4, nbViews); ++j)
+    {
+      IndMatches& matches = map_pairwisematches[std::make_pair(i, j)][EImageDescriberType::UNKNOWN];
+      for(int k = 0; k < 200; ++k)
+        matches.emplace_back(distribution(randomNumberGenerator), distribution(randomNumberGenerator));
+    }
+  }
+
+  const int maxThreads = omp_get_max_threads();
+
+  TracksMap map_tracks;
+  std::vector<TracksMap> map_tracksPerRun;
+  for(int nbThreads : {1, 2, 4})
+  {
+    omp_set_num_threads(nbThreads);
+    TracksBuilder trackBuilder;
+    trackBuilder.build(map_pairwisematches);
+    trackBuilder.filter(2);
+    trackBuilder.exportToSTL(map_tracks);
+    map_tracksPerRun.push_back(map_tracks);
+  }
+  omp_set_num_threads(maxThreads);
+
+  BOOST_CHECK(!map_tracks.empty());
+  for(const TracksMap& map_tracksRun : map_tracksPerRun)
+  {
+    BOOST_CHECK_EQUAL(map_tracks.size(), map_tracksRun.size());
+    for(const auto& track : map_tracksRun)
+      BOOST_CHECK(track.second.featPerView == map_tracks.at(track.first).featPerView);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Track_BinaryFile)
+{
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //2 -> 3
+
+  PairwiseMatches map_pairwisematches;
+
+  const IndMatch testAB[] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+  const IndMatch testBC[] = {IndMatch(0,0), IndMatch(1,6)};
+
+  map_pairwisematches[ std::make_pair(0, 1) ][EImageDescriberType::SIFT] = std::vector<IndMatch>(testAB, testAB+3);
+  map_pairwisematches[ std::make_pair(1, 2) ][EImageDescriberType::SIFT] = std::vector<IndMatch>(testBC, testBC+2);
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build( map_pairwisematches );
+  TracksStore store;
+  trackBuilder.exportToStore(store);
+
+  const std::uint64_t key = computeTracksFileKey(map_pairwisematches, false, 2);
+  BOOST_CHECK_NE(key, computeTracksFileKey(map_pairwisematches, true, 2));
+  BOOST_CHECK_NE(computeTracksFileKey(map_pairwisematches, true, 2), computeTracksFileKey(map_pairwisematches, true, 3));
+
+  const std::string filepath = "track_test_binaryFile.tracks";
+  BOOST_CHECK(saveTracks(store, filepath, key));
+
+  TracksStore loadedStore;
+  BOOST_CHECK(!loadTracks(loadedStore, filepath, key + 1));
+  BOOST_CHECK(loadTracks(loadedStore, filepath, key));
+
+  TracksMap map_tracks;
+  store.exportToSTL(map_tracks);
+  TracksMap map_loadedTracks;
+  loadedStore.exportToSTL(map_loadedTracks);
+
+  BOOST_CHECK_EQUAL(3, map_loadedTracks.size());
+  BOOST_CHECK_EQUAL(store.nbViews(), loadedStore.nbViews());
+  for(const auto& track : map_tracks)
+  {
+    BOOST_CHECK(track.second.featPerView == map_loadedTracks.at(track.first).featPerView);
+    BOOST_CHECK(EImageDescriberType::SIFT == map_loadedTracks.at(track.first).descType);
+  }
+
+  // truncated file
+  {
+    std::ofstream stream(filepath.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+    stream.put(0);
+  }
+  BOOST_CHECK(!loadTracks(loadedStore, filepath, key));
+
+  std::remove(filepath.c_str());
+  BOOST_CHECK(!loadTracks(loadedStore, filepath, key));
+}
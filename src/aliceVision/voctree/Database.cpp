@@ -5,17 +5,84 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Database.hpp"
-#include <boost/accumulators/accumulators.hpp>
-#include <boost/accumulators/statistics/tail.hpp>
 #include <boost/progress.hpp>
+#include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <mutex>
+#include <set>
 #include <stdexcept>
 #include <boost/format.hpp>
 
 namespace aliceVision{
 namespace voctree{
 
+namespace {
+
+/// Append an unsigned integer encoded with 7 bits per byte, the high bit marking the continuation
+inline void encodeVarint(uint32_t value, std::vector<uint8_t>& bytes)
+{
+  while(value >= 0x80)
+  {
+    bytes.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<uint8_t>(value));
+}
+
+/// Decode an unsigned integer encoded by encodeVarint and advance the pointer
+inline uint32_t decodeVarint(const uint8_t*& bytes)
+{
+  uint32_t value = 0;
+  int shift = 0;
+  while(*bytes & 0x80)
+  {
+    value |= static_cast<uint32_t>(*bytes++ & 0x7f) << shift;
+    shift += 7;
+  }
+  value |= static_cast<uint32_t>(*bytes++) << shift;
+  return value;
+}
+
+/// Order of the matches: best score first, then lowest id
+inline bool isBetterMatch(const DocMatch& a, const DocMatch& b)
+{
+  return (a.score < b.score) || (a.score == b.score && a.id < b.id);
+}
+
+/// Keep the N best matches, sorted
+inline void keepBestMatches(DocMatches& matches, std::size_t N)
+{
+  if(matches.size() > N)
+  {
+    std::partial_sort(matches.begin(), matches.begin() + N, matches.end(), isBetterMatch);
+    matches.resize(N);
+  }
+  else
+  {
+    std::sort(matches.begin(), matches.end(), isBetterMatch);
+  }
+}
+
+/// TF-IDF weight of a word contained in Ni documents of a database of N documents
+inline float computeTfIdfWeight(float N, std::size_t Ni, float default_weight)
+{
+  if(Ni != 0)
+    return std::log(N / Ni);
+  return default_weight;
+}
+
+/// Database file header
+const char databaseFileMagic[4] = {'A', 'V', 'D', 'B'};
+const uint32_t databaseFileVersion = 1;
+
+/// compress the postings inserted after the build of the index when they are more than
+/// this ratio of the compressed ones (and more than the minimum)
+const std::size_t insertedPostingsMaxRatio = 4;
+const std::size_t insertedPostingsMin = 1 << 16;
+
+} // namespace
+
 std::ostream& operator<<(std::ostream& os, const SparseHistogram &dv)	
 {
 	for( const auto &e : dv )
@@ -27,26 +94,37 @@ std::ostream& operator<<(std::ostream& os, const SparseHistogram &dv)
 }
 
 Database::Database(uint32_t num_words)
-: word_files_(num_words),
-word_weights_( num_words, 1.0f ) { }
+: word_weights_( num_words, 1.0f ) { }
 
 DocId Database::insert(DocId doc_id, const SparseHistogram& document)
 {
   // Ensure that the new document to insert is not already there.
   assert(database_.find(doc_id) == database_.end());
 
-  // For each word, retrieve its inverted file and increment the count for doc_id.
-  for(SparseHistogram::const_iterator it = document.begin(), end = document.end(); it != end; ++it)
+  const bool indexed = hasInvertedIndex();
+  database_[doc_id] = document;
+
+  // Update the document frequencies, the TF-IDF weights follow them
+  for(const auto& word : document)
   {
-    Word word = it->first;
-    InvertedFile& file = word_files_[word];
-    if(file.empty() || file.back().id != doc_id)
-      file.push_back(WordFrequency(doc_id, it->second.size()));
-    else
-      file.back().count += it->second.size();
+    if(static_cast<std::size_t>(word.first) >= word_documents_.size())
+      word_documents_.resize(word.first + 1, 0);
+    ++word_documents_[word.first];
   }
+  weightsOutdated_ = tfIdfWeights_;
 
-  database_[doc_id] = document;
+  if(!indexed)
+    return doc_id;
+
+  // Append the postings of the document to the inverted index
+  const uint32_t documentIndex = static_cast<uint32_t>(index_.documents.size());
+  index_.documents.push_back(doc_id);
+  for(const auto& word : document)
+    index_.insertedPostings[word.first].emplace_back(documentIndex, static_cast<uint32_t>(word.second.size()));
+  index_.nbInsertedPostings += document.size();
+
+  if(index_.nbInsertedPostings > std::max(insertedPostingsMin, index_.nbPostings / insertedPostingsMaxRatio))
+    buildInvertedIndex();
 
   return doc_id;
 }
@@ -110,23 +188,294 @@ void Database::find(const std::vector<Word>& document, std::size_t N, std::vecto
  */
 void Database::find( const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
 {
-  // Accumulate the best N matches
-  using bestN_tag = boost::accumulators::tag::tail<boost::accumulators::left>;
-  boost::accumulators::accumulator_set<DocMatch, boost::accumulators::features<bestN_tag> > acc(bestN_tag::cache_size = N);
+  EIndexedDistance method;
+  if(!hasInvertedIndex() || !getIndexedDistance(distanceMethod, method))
+  {
+    findAllDocuments(query, N, matches, distanceMethod);
+    return;
+  }
+
+  ScoreAccumulator accumulator;
+  accumulateScores(query, method, 0, accumulator);
+  selectMatches(accumulator, N, matches);
+}
+
+void Database::findBatch(const SparseHistogramPerImage& queries, std::size_t N, std::map<DocId, DocMatches>& matches, const std::string& distanceMethod) const
+{
+  EIndexedDistance method;
+  const bool useIndex = hasInvertedIndex() && getIndexedDistance(distanceMethod, method);
+
+  std::vector<SparseHistogramPerImage::const_iterator> queryIts;
+  queryIts.reserve(queries.size());
+  for(auto it = queries.begin(); it != queries.end(); ++it)
+    queryIts.push_back(it);
+
+  std::vector<DocMatches> queryMatches(queryIts.size());
+
+  #pragma omp parallel
+  {
+    // one accumulator per thread, reset after each query
+    ScoreAccumulator accumulator;
+
+    #pragma omp for schedule(dynamic)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(queryIts.size()); ++i)
+    {
+      if(useIndex)
+      {
+        accumulateScores(queryIts[i]->second, method, 0, accumulator);
+        selectMatches(accumulator, N, queryMatches[i]);
+      }
+      else
+      {
+        findAllDocuments(queryIts[i]->second, N, queryMatches[i], distanceMethod);
+      }
+    }
+  }
+
+  matches.clear();
+  for(std::size_t i = 0; i < queryIts.size(); ++i)
+    matches[queryIts[i]->first] = std::move(queryMatches[i]);
+}
+
+void Database::findBatchSymmetric(std::size_t N, std::map<DocId, DocMatches>& matches, const std::string& distanceMethod) const
+{
+  EIndexedDistance method;
+  if(!hasInvertedIndex() || !getIndexedDistance(distanceMethod, method))
+  {
+    findBatch(database_, N, matches, distanceMethod);
+    return;
+  }
+
+  const std::size_t nbDocuments = index_.documents.size();
+  N = std::min(N, nbDocuments);
+
+  std::vector<const SparseHistogram*> documents;
+  documents.reserve(nbDocuments);
+  for(const DocId documentId : index_.documents)
+    documents.push_back(&database_.at(documentId));
+
+  // best matches of each document computed by the previous documents, as a bounded max-heap
+  std::vector<DocMatches> previousMatches(nbDocuments);
+  std::vector<std::mutex> previousMatchesMutex(nbDocuments);
+  // best matches of each document computed by itself
+  std::vector<DocMatches> nextMatches(nbDocuments);
+
+  #pragma omp parallel
+  {
+    ScoreAccumulator accumulator;
+
+    #pragma omp for schedule(dynamic)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nbDocuments); ++i)
+    {
+      // only score the document itself and the next documents
+      accumulateScores(*documents[i], method, i, accumulator);
+
+      for(uint32_t j : accumulator.touched)
+      {
+        const float distance = static_cast<float>(- accumulator.scores[j]);
+        accumulator.scores[j] = 0.0;
+        accumulator.isTouched[j] = 0;
+
+        // the documents without any match have a null distance, they are added at the end
+        if(!(distance < 0.0f) || N == 0)
+          continue;
+
+        nextMatches[i].emplace_back(index_.documents[j], distance);
+
+        if(j == static_cast<uint32_t>(i))
+          continue;
+
+        // the couple (j, i) has the same distance
+        const DocMatch match(index_.documents[i], distance);
+        std::lock_guard<std::mutex> lock(previousMatchesMutex[j]);
+        DocMatches& heap = previousMatches[j];
+        if(heap.size() < N)
+        {
+          heap.push_back(match);
+          std::push_heap(heap.begin(), heap.end(), isBetterMatch);
+        }
+        else if(isBetterMatch(match, heap.front()))
+        {
+          std::pop_heap(heap.begin(), heap.end(), isBetterMatch);
+          heap.back() = match;
+          std::push_heap(heap.begin(), heap.end(), isBetterMatch);
+        }
+      }
+      accumulator.touched.clear();
+      keepBestMatches(nextMatches[i], N);
+    }
+  }
+
+  std::vector<DocMatches> documentMatches(nbDocuments);
+
+  #pragma omp parallel
+  {
+    std::set<DocId> matchedIds;
+
+    #pragma omp for schedule(dynamic)
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nbDocuments); ++i)
+    {
+      DocMatches& m = documentMatches[i];
+      m.swap(previousMatches[i]);
+      m.insert(m.end(), nextMatches[i].begin(), nextMatches[i].end());
+      DocMatches().swap(nextMatches[i]);
+      keepBestMatches(m, N);
+
+      if(m.size() < N)
+      {
+        // complete with the documents of null distance, by increasing id
+        matchedIds.clear();
+        for(const DocMatch& match : m)
+          matchedIds.insert(match.id);
+        for(auto it = database_.begin(); it != database_.end() && m.size() < N; ++it)
+          if(matchedIds.count(it->first) == 0)
+            m.emplace_back(it->first, static_cast<float>(- 0.0));
+      }
+    }
+  }
+
+  matches.clear();
+  for(std::size_t i = 0; i < nbDocuments; ++i)
+    matches[index_.documents[i]] = std::move(documentMatches[i]);
+}
+
+bool Database::getIndexedDistance(const std::string& distanceMethod, EIndexedDistance& method) const
+{
+  // "classic" and "weightedStrongCommonPoints" also depend on the words that are not shared
+  // with the query (see sparseDistance), they are computed on all the documents
+  if(distanceMethod == "commonPoints")
+    method = COMMON_POINTS;
+  else if(distanceMethod == "strongCommonPoints")
+    method = STRONG_COMMON_POINTS;
+  else if(distanceMethod == "inversedWeightedCommonPoints")
+    method = INVERSED_WEIGHTED_COMMON_POINTS;
+  else
+    return false;
+  return true;
+}
+
+void Database::accumulateScores(const SparseHistogram& query, EIndexedDistance method, std::size_t firstDocument, ScoreAccumulator& accumulator) const
+{
+  const std::size_t num_words = index_.wordOffsets.size() - 1;
+  if(accumulator.scores.size() != index_.documents.size())
+  {
+    accumulator.scores.assign(index_.documents.size(), 0.0);
+    accumulator.isTouched.assign(index_.documents.size(), 0);
+    accumulator.touched.clear();
+  }
+
+  // the query words are visited by increasing word, so each score is summed
+  // in the same order as sparseDistance
+  for(const auto& queryWord : query)
+  {
+    const Word word = queryWord.first;
+    if(word < 0)
+      continue;
+
+    const std::size_t queryCount = queryWord.second.size();
+    const float weight = (method == INVERSED_WEIGHTED_COMMON_POINTS) ? getWordWeight(word) : 1.0f;
+
+    const auto addPosting = [&](std::size_t documentIndex, std::size_t count)
+    {
+      if(!accumulator.isTouched[documentIndex])
+      {
+        accumulator.isTouched[documentIndex] = 1;
+        accumulator.touched.push_back(static_cast<uint32_t>(documentIndex));
+      }
+
+      double& score = accumulator.scores[documentIndex];
+      switch(method)
+      {
+        case COMMON_POINTS:
+          score += std::min(queryCount, count);
+          break;
+        case STRONG_COMMON_POINTS:
+          if(queryCount == 1 && count == 1)
+            score += 1;
+          break;
+        case INVERSED_WEIGHTED_COMMON_POINTS:
+          score += (1.0 / static_cast<int>(std::min(queryCount, count))) * weight;
+          break;
+      }
+    };
+
+    // compressed postings
+    if(static_cast<std::size_t>(word) < num_words)
+    {
+      const uint8_t* it = index_.postings.data() + index_.wordOffsets[word];
+      const uint8_t* end = index_.postings.data() + index_.wordOffsets[word + 1];
+      std::size_t documentIndex = 0;
+
+      while(it != end)
+      {
+        documentIndex += decodeVarint(it);
+        const std::size_t count = decodeVarint(it);
+        if(documentIndex >= firstDocument)
+          addPosting(documentIndex, count);
+      }
+    }
+
+    // postings of the documents inserted after the build
+    const auto insertedIt = index_.insertedPostings.find(word);
+    if(insertedIt != index_.insertedPostings.end())
+    {
+      for(const auto& posting : insertedIt->second)
+        if(posting.first >= firstDocument)
+          addPosting(posting.first, posting.second);
+    }
+  }
+}
+
+void Database::selectMatches(ScoreAccumulator& accumulator, std::size_t N, DocMatches& matches) const
+{
+  N = std::min(N, index_.documents.size());
+  matches.clear();
+
+  // the documents without any common word have a null distance,
+  // the touched documents with a negative distance are enough if there are at least N of them
+  for(uint32_t i : accumulator.touched)
+  {
+    const float distance = static_cast<float>(- accumulator.scores[i]);
+    if(distance < 0.0f)
+      matches.emplace_back(index_.documents[i], distance);
+  }
+
+  if(matches.size() < N)
+  {
+    matches.clear();
+    matches.reserve(index_.documents.size());
+    for(std::size_t i = 0; i < index_.documents.size(); ++i)
+      matches.emplace_back(index_.documents[i], static_cast<float>(- accumulator.scores[i]));
+  }
+
+  keepBestMatches(matches, N);
+
+  for(uint32_t i : accumulator.touched)
+  {
+    accumulator.scores[i] = 0.0;
+    accumulator.isTouched[i] = 0;
+  }
+  accumulator.touched.clear();
+}
+
+void Database::findAllDocuments(const SparseHistogram& query, std::size_t N, DocMatches& matches, const std::string& distanceMethod) const
+{
+  std::vector<float> wordWeightsBuffer;
+  const std::vector<float>& wordWeights = getWordWeights(wordWeightsBuffer);
+
+  matches.clear();
+  matches.reserve(database_.size());
 
-  /// @todo Try only computing distances against documents sharing at least one word
   for(const auto& document: database_)
   {
-    // for each document/image in the database compute the distance between the 
+    // for each document/image in the database compute the distance between the
     // histograms of the query image and the others
-    float distance = sparseDistance(query, document.second, distanceMethod, word_weights_);
-    acc(DocMatch(document.first, distance));
+    float distance = sparseDistance(query, document.second, distanceMethod, wordWeights);
+    matches.emplace_back(document.first, distance);
   }
 
   // extract the best N
-  boost::accumulators::extractor<bestN_tag> bestN;
-  matches.resize(std::min(N, database_.size()));
-  std::copy(bestN(acc).begin(), bestN(acc).end(), matches.begin());
+  keepBestMatches(matches, N);
 }
 
 /**
@@ -137,16 +486,89 @@ void Database::find( const SparseHistogram& query, std::size_t N, std::vector<Do
  */
 void Database::computeTfIdfWeights(float default_weight)
 {
+  buildInvertedIndex();
+
   float N = (float) database_.size();
-  std::size_t num_words = word_files_.size();
+  std::size_t num_words = word_weights_.size();
+  for(std::size_t i = 0; i < num_words; ++i)
+  {
+    // number of documents containing the word
+    const std::size_t Ni = (i < word_documents_.size()) ? word_documents_[i] : 0;
+    word_weights_[i] = computeTfIdfWeight(N, Ni, default_weight);
+  }
+
+  tfIdfWeights_ = true;
+  weightsOutdated_ = false;
+  default_weight_ = default_weight;
+}
+
+float Database::getWordWeight(Word word) const
+{
+  if(weightsOutdated_)
+  {
+    const std::size_t Ni = (static_cast<std::size_t>(word) < word_documents_.size()) ? word_documents_[word] : 0;
+    return computeTfIdfWeight((float) database_.size(), Ni, default_weight_);
+  }
+  if(static_cast<std::size_t>(word) < word_weights_.size())
+    return word_weights_[word];
+  return default_weight_;
+}
+
+const std::vector<float>& Database::getWordWeights(std::vector<float>& buffer) const
+{
+  if(!weightsOutdated_)
+    return word_weights_;
+
+  buffer.resize(word_weights_.size());
+  for(std::size_t i = 0; i < buffer.size(); ++i)
+    buffer[i] = getWordWeight(static_cast<Word>(i));
+  return buffer;
+}
+
+void Database::buildInvertedIndex()
+{
+  index_ = InvertedIndex();
+
+  std::size_t num_words = word_weights_.size();
+  num_words = std::max(num_words, word_documents_.size());
+
+  // bucket the postings by word (counting sort), the documents being visited by increasing id
+  std::vector<std::size_t> wordNbPostings(num_words + 1, 0);
+  for(const auto& document : database_)
+    for(const auto& word : document.second)
+      ++wordNbPostings[word.first + 1];
   for(std::size_t i = 0; i < num_words; ++i)
+    wordNbPostings[i + 1] += wordNbPostings[i];
+
+  std::vector<std::pair<uint32_t, uint32_t> > postings(wordNbPostings.back()); // document index, count
+  std::vector<std::size_t> wordEnd(wordNbPostings.begin(), wordNbPostings.end() - 1);
+
+  index_.documents.reserve(database_.size());
+  for(const auto& document : database_)
   {
-    std::size_t Ni = word_files_[i].size();
-    if(Ni != 0)
-      word_weights_[i] = std::log(N / Ni);
-    else
-      word_weights_[i] = default_weight;
+    const uint32_t documentIndex = static_cast<uint32_t>(index_.documents.size());
+    index_.documents.push_back(document.first);
+    for(const auto& word : document.second)
+      postings[wordEnd[word.first]++] = std::make_pair(documentIndex, static_cast<uint32_t>(word.second.size()));
   }
+
+  // delta encoding
+  index_.wordOffsets.resize(num_words + 1);
+  index_.postings.reserve(postings.size() * 2);
+  for(std::size_t i = 0; i < num_words; ++i)
+  {
+    index_.wordOffsets[i] = index_.postings.size();
+    uint32_t previousIndex = 0;
+    for(std::size_t p = wordNbPostings[i]; p < wordNbPostings[i + 1]; ++p)
+    {
+      encodeVarint(postings[p].first - previousIndex, index_.postings);
+      encodeVarint(postings[p].second, index_.postings);
+      previousIndex = postings[p].first;
+    }
+  }
+  index_.wordOffsets[num_words] = index_.postings.size();
+  index_.postings.shrink_to_fit();
+  index_.nbPostings = postings.size();
 }
 
 void Database::saveWeights(const std::string& file) const
@@ -167,9 +589,10 @@ void Database::loadWeights(const std::string& file)
     in.open(file.c_str(), std::ios_base::binary);
     uint32_t num_words = 0;
     in.read((char*) (&num_words), sizeof (uint32_t));
-    word_files_.resize(num_words); // Inverted files start out empty
     word_weights_.resize(num_words);
     in.read((char*) (&word_weights_[0]), num_words * sizeof (float));
+    tfIdfWeights_ = false;
+    weightsOutdated_ = false;
   }
   catch(std::ifstream::failure& e)
   {
@@ -177,6 +600,110 @@ void Database::loadWeights(const std::string& file)
   }
 }
 
+void Database::save(const std::string& file) const
+{
+  std::ofstream out(file.c_str(), std::ios_base::binary);
+  if(!out.is_open())
+    throw std::runtime_error("Can't save the database file, can't open '" + file + "' !");
+
+  const uint32_t num_words = word_weights_.size();
+  const uint8_t tfIdfWeights = tfIdfWeights_;
+  const uint8_t weightsOutdated = weightsOutdated_;
+  const uint32_t nbDocuments = database_.size();
+
+  out.write(databaseFileMagic, sizeof(databaseFileMagic));
+  out.write((const char*) (&databaseFileVersion), sizeof (uint32_t));
+  out.write((const char*) (&num_words), sizeof (uint32_t));
+  out.write((const char*) (word_weights_.data()), num_words * sizeof (float));
+  out.write((const char*) (&tfIdfWeights), sizeof (uint8_t));
+  out.write((const char*) (&weightsOutdated), sizeof (uint8_t));
+  out.write((const char*) (&default_weight_), sizeof (float));
+  out.write((const char*) (&nbDocuments), sizeof (uint32_t));
+
+  for(const auto& document : database_)
+  {
+    const uint32_t documentId = document.first;
+    const uint32_t nbWords = document.second.size();
+    out.write((const char*) (&documentId), sizeof (uint32_t));
+    out.write((const char*) (&nbWords), sizeof (uint32_t));
+    for(const auto& word : document.second)
+    {
+      const int32_t wordId = word.first;
+      const uint32_t nbFeatures = word.second.size();
+      out.write((const char*) (&wordId), sizeof (int32_t));
+      out.write((const char*) (&nbFeatures), sizeof (uint32_t));
+      out.write((const char*) (word.second.data()), nbFeatures * sizeof (IndexT));
+    }
+  }
+
+  if(!out.good())
+    throw std::runtime_error("Can't save the database file, '" + file + "' is incorrect !");
+}
+
+void Database::load(const std::string& file)
+{
+  std::ifstream in;
+  in.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
+
+  Database db;
+  try
+  {
+    in.open(file.c_str(), std::ios_base::binary);
+
+    char magic[sizeof(databaseFileMagic)];
+    uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    in.read((char*) (&version), sizeof (uint32_t));
+    if(!std::equal(magic, magic + sizeof(magic), databaseFileMagic) || version != databaseFileVersion)
+      throw std::runtime_error((boost::format("Invalid database file '%s'") % file).str());
+
+    uint32_t num_words = 0;
+    uint8_t tfIdfWeights = 0;
+    uint8_t weightsOutdated = 0;
+    uint32_t nbDocuments = 0;
+    in.read((char*) (&num_words), sizeof (uint32_t));
+    db.word_weights_.resize(num_words);
+    in.read((char*) (db.word_weights_.data()), num_words * sizeof (float));
+    in.read((char*) (&tfIdfWeights), sizeof (uint8_t));
+    in.read((char*) (&weightsOutdated), sizeof (uint8_t));
+    in.read((char*) (&db.default_weight_), sizeof (float));
+    in.read((char*) (&nbDocuments), sizeof (uint32_t));
+
+    for(uint32_t i = 0; i < nbDocuments; ++i)
+    {
+      uint32_t documentId = 0;
+      uint32_t nbWords = 0;
+      in.read((char*) (&documentId), sizeof (uint32_t));
+      in.read((char*) (&nbWords), sizeof (uint32_t));
+
+      SparseHistogram document;
+      for(uint32_t w = 0; w < nbWords; ++w)
+      {
+        int32_t wordId = 0;
+        uint32_t nbFeatures = 0;
+        in.read((char*) (&wordId), sizeof (int32_t));
+        in.read((char*) (&nbFeatures), sizeof (uint32_t));
+        if(wordId < 0)
+          throw std::runtime_error((boost::format("Invalid database file '%s'") % file).str());
+        std::vector<IndexT>& features = document[wordId];
+        features.resize(nbFeatures);
+        in.read((char*) (features.data()), nbFeatures * sizeof (IndexT));
+      }
+      db.insert(documentId, document);
+    }
+
+    db.tfIdfWeights_ = tfIdfWeights;
+    db.weightsOutdated_ = weightsOutdated;
+  }
+  catch(std::ifstream::failure& e)
+  {
+    throw std::runtime_error((boost::format("Failed to load database file '%s'") % file).str());
+  }
+
+  db.buildInvertedIndex();
+  *this = std::move(db);
+}
+
 ///**
 // * Normalize a document vector representing the histogram of visual words for a given image
 // * 
@@ -69,6 +69,10 @@ public:
   /**
    * @brief Insert a new document.
    *
+   * The document frequencies of its words are updated and, if the inverted index is built,
+   * its postings are added to the index, so the document can be queried right away.
+   * The TF-IDF weights (see computeTfIdfWeights) follow the new document frequencies.
+   *
    * @param doc_id Unique ID of the new document to insert
    * @param document The set of quantized words in a document/image.
    * \return An ID representing the inserted document.
@@ -104,14 +108,65 @@ public:
    */
   void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
 
+  /**
+   * @brief Find the top N matches in the database for several query documents, in parallel.
+   *
+   * The matches are the same as the ones of find() for each query.
+   * @param[in] queries The query documents
+   * @param[in] N The number of matches to return for each query.
+   * @param[out] matches IDs and scores for the top N matching database documents of each query.
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void findBatch(const SparseHistogramPerImage& queries, std::size_t N, std::map<DocId, DocMatches>& matches, const std::string& distanceMethod = "strongCommonPoints") const;
+
+  /**
+   * @brief Find the top N matches in the database for all the documents of the database, in parallel.
+   *
+   * The distance methods supported by the inverted index are symmetric, so the distance of each couple
+   * of documents is computed only once, for the first document of the couple.
+   * The matches are the same as the ones of findBatch(getSparseHistogramPerImage()).
+   * @param[in] N The number of matches to return for each document.
+   * @param[out] matches IDs and scores for the top N matching database documents of each document.
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void findBatchSymmetric(std::size_t N, std::map<DocId, DocMatches>& matches, const std::string& distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
-   * training examples into the database.
+   * training examples into the database. The inverted index is built (see buildInvertedIndex).
+   *
+   * The weights then follow the next insertions: until the next call, the weights of the query words
+   * are computed on the fly from the current document frequencies.
    *
    * @param default_weight The default weight of a word that appears in none of the training documents.
    */
   void computeTfIdfWeights(float default_weight = 1.0f);
 
+  /**
+   * @brief Build the compressed inverted index of the inserted documents.
+   *
+   * With the inverted index, find() and findBatch() only visit the postings of the query words
+   * (for the distance methods that only depend on the common words).
+   * The documents inserted afterwards are appended to the index, in uncompressed postings
+   * which are compressed when they become too large compared to the compressed ones.
+   */
+  void buildInvertedIndex();
+
+  /**
+   * @brief Returns true if the inverted index is built for all the inserted documents.
+   */
+  bool hasInvertedIndex() const
+  {
+    return !index_.wordOffsets.empty() && index_.documents.size() == database_.size();
+  }
+
+  /**
+   * @brief Get the current weight of a word
+   * @param[in] word The word
+   * @return the TF-IDF weight of the word if computed by computeTfIdfWeights, the loaded weight otherwise
+   */
+  float getWordWeight(Word word) const;
+
   /**
    * @brief Return the size of the database in terms of number of documents
    * @return the number of documents
@@ -123,9 +178,18 @@ public:
   /// Load the vocabulary word weights from a file.
   void loadWeights(const std::string& file);
 
-  // Save weights and documents
-  //void save(const std::string& file) const;
-  //void load(const std::string& file);
+  /**
+   * @brief Save the weights and the documents of the database to a file.
+   * @param[in] file The database file
+   */
+  void save(const std::string& file) const;
+
+  /**
+   * @brief Load the weights and the documents of a database file and build the inverted index.
+   * New documents can then be inserted and the database saved again.
+   * @param[in] file The database file
+   */
+  void load(const std::string& file);
 
   const SparseHistogramPerImage& getSparseHistogramPerImage() const
   {
@@ -134,29 +198,89 @@ public:
   
 private:
 
-  struct WordFrequency
+  /**
+   * @brief Inverted index in compressed sparse row format.
+   *
+   * The postings of a word are the (index delta, count) of the documents containing the word,
+   * by increasing document index, encoded as variable length integers (7 bits per byte).
+   * The postings of the documents inserted after the build are stored uncompressed, by word.
+   */
+  struct InvertedIndex
   {
-    DocId id;
-    uint32_t count;
-
-    WordFrequency() = default;
-    WordFrequency(DocId _id, uint32_t _count)
-      : id(_id)
-      , count(_count)
-    {}
+    /// offset of the postings of each word in postings, of size number of words + 1
+    std::vector<std::size_t> wordOffsets;
+    /// encoded postings of all the words
+    std::vector<uint8_t> postings;
+    /// number of encoded postings
+    std::size_t nbPostings = 0;
+    /// id of each indexed document (by increasing id for the documents of the build, then by insertion)
+    std::vector<DocId> documents;
+    /// (document index, count) of the documents inserted after the build, by word
+    std::map<Word, std::vector<std::pair<uint32_t, uint32_t> > > insertedPostings;
+    /// number of postings in insertedPostings
+    std::size_t nbInsertedPostings = 0;
   };
 
-  // Stored in increasing order by DocId
-  typedef std::vector<WordFrequency> InvertedFile;
-
   /// @todo Use sorted vector?
   // typedef std::vector< std::pair<Word, float> > DocumentVector;
   
   friend std::ostream& operator<<(std::ostream& os, const SparseHistogram& dv);
 
-  std::vector<InvertedFile> word_files_;
   std::vector<float> word_weights_;
+  /// number of documents containing each word
+  std::vector<uint32_t> word_documents_;
+  /// true if the weights are the TF-IDF weights computed by computeTfIdfWeights
+  bool tfIdfWeights_ = false;
+  /// true if documents have been inserted since the computation of the TF-IDF weights
+  bool weightsOutdated_ = false;
+  float default_weight_ = 1.0f;
   SparseHistogramPerImage database_; // Precomputed for inserted documents
+  InvertedIndex index_;
+
+  /// Get the current weight of all the words (see getWordWeight)
+  const std::vector<float>& getWordWeights(std::vector<float>& buffer) const;
+
+  /// Distance methods computed with the inverted index
+  enum EIndexedDistance
+  {
+    COMMON_POINTS,
+    STRONG_COMMON_POINTS,
+    INVERSED_WEIGHTED_COMMON_POINTS
+  };
+
+  /// Reusable dense accumulator of the scores of the indexed documents
+  struct ScoreAccumulator
+  {
+    std::vector<double> scores;
+    /// indices of the documents with a score
+    std::vector<uint32_t> touched;
+    std::vector<uint8_t> isTouched;
+  };
+
+  /**
+   * @brief Get the indexed distance from the distance method name
+   * @return false if the distance method can't be computed with the inverted index
+   */
+  bool getIndexedDistance(const std::string& distanceMethod, EIndexedDistance& method) const;
+
+  /**
+   * @brief Accumulate the scores of the indexed documents against the query (distance = -score)
+   * @param[in] query The query document
+   * @param[in] method The distance method
+   * @param[in] firstDocument The index of the first document to score
+   * @param[in,out] accumulator The scores, distinct from zero in the touched documents only
+   */
+  void accumulateScores(const SparseHistogram& query, EIndexedDistance method, std::size_t firstDocument, ScoreAccumulator& accumulator) const;
+
+  /**
+   * @brief Select the top N matches from the accumulated scores and reset the accumulator
+   */
+  void selectMatches(ScoreAccumulator& accumulator, std::size_t N, DocMatches& matches) const;
+
+  /**
+   * @brief Find the top N matches by computing the distance to all the documents
+   */
+  void findAllDocuments(const SparseHistogram& query, std::size_t N, DocMatches& matches, const std::string& distanceMethod) const;
 
   /**
    * Normalize a document vector representing the histogram of visual words for a given image
@@ -33,6 +33,7 @@ public:
     this->levels_ = levels;
     this->k_ = splits;
     this->setNodeCounts();
+    this->resetDeviceTree();
   }
 
   uint32_t nodes() const
@@ -42,6 +43,7 @@ public:
 
   std::vector<Feature, FeatureAllocator>& centers()
   {
+    this->resetDeviceTree();
     return this->centers_;
   }
 
@@ -52,6 +54,7 @@ public:
 
   std::vector<uint8_t>& validCenters()
   {
+    this->resetDeviceTree();
     return this->valid_centers_;
   }
 
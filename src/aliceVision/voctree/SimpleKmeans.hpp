@@ -7,6 +7,8 @@
 #pragma once
 
 #include "distance.hpp"
+#include "distanceCuda.hpp"
+#include "distanceSimd.hpp"
 #include "DefaultAllocator.hpp"
 
 #include <aliceVision/system/Logger.hpp>
@@ -18,6 +20,7 @@
 #include <numeric>
 #include <vector>
 #include <limits>
+#include <type_traits>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
@@ -257,6 +260,10 @@ bool checkVectorElements(const std::vector<Feature, FeatureAllocator> &f, const
  * @brief Class for performing K-means clustering, optimized for a particular feature type and metric.
  *
  * The standard Lloyd's algorithm is used. By default, cluster centers are initialized randomly.
+ * With a mini-batch size, the mini-batch K-means algorithm is used instead on the large sets of features:
+ *
+ *  Sculley, D. (2010). "Web-scale k-means clustering" Proceedings of the 19th
+ *  international conference on World Wide Web. pp. 1177-1178.
  */
 template<class Feature,
          class Distance = L2<Feature, Feature>,
@@ -284,6 +291,11 @@ public:
     choose_centers_ = init;
   }
 
+  const Distance& getDistance() const
+  {
+    return distance_;
+  }
+
   std::size_t getMaxIterations() const
   {
     return max_iterations_;
@@ -304,6 +316,39 @@ public:
     restarts_ = restarts;
   }
 
+  std::size_t getMiniBatchSize() const
+  {
+    return mini_batch_size_;
+  }
+
+  /**
+   * @brief Use the mini-batch K-means on the sets of more than batchSize features.
+   *
+   * Each iteration updates the centers with batchSize features drawn at random, the
+   * maximum number of iterations is then the maximum number of mini-batches.
+   * The centers are initialized on a random sample of 3 * batchSize features.
+   * @param[in] batchSize The number of features of a mini-batch, 0 to always use Lloyd's algorithm
+   */
+  void setMiniBatchSize(std::size_t batchSize)
+  {
+    mini_batch_size_ = batchSize;
+  }
+
+  bool getUseCuda() const
+  {
+    return use_cuda_;
+  }
+
+  /**
+   * @brief Assign the large sets of features to the centers on the GPU,
+   * if built with CUDA and a device is available (enabled by default).
+   * @note The assignments are the same as on the CPU.
+   */
+  void setUseCuda(bool useCuda)
+  {
+    use_cuda_ = useCuda;
+  }
+
   int getVerbose() const
   {
     return verbose_;
@@ -347,11 +392,48 @@ private:
                                     std::vector<Feature, FeatureAllocator>& centers,
                                     std::vector<unsigned int>& membership) const;
 
+  squared_distance_type clusterMiniBatch(const std::vector<Feature*>& features, std::size_t k,
+                                         std::vector<Feature, FeatureAllocator>& centers,
+                                         std::vector<unsigned int>& membership) const;
+
+  /// Assign each feature to its nearest center, returns the sum squared error.
+  squared_distance_type assignToCenters(const std::vector<Feature*>& features,
+                                        const std::vector<Feature, FeatureAllocator>& centers,
+                                        std::vector<unsigned int>& membership) const;
+
+  /**
+   * @brief Find the center nearest to a feature.
+   * @param[in] feature The feature
+   * @param[in] centers The centers
+   * @param[in] useSimd Use the SIMD kernels (see useSimdKernels)
+   * @param[in,out] buffer Temporary storage of the feature converted to double
+   * @param[out] distance The distance to the nearest center
+   * @return the index of the nearest center
+   */
+  unsigned int findNearestCenter(const Feature& feature, const std::vector<Feature, FeatureAllocator>& centers,
+                                 bool useSimd, std::vector<double>& buffer, squared_distance_type& distance) const;
+
+  /// Returns true if the SIMD kernels give the same distances as Distance on these centers.
+  bool useSimdKernels(const std::vector<Feature, FeatureAllocator>& centers) const;
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  /// Copy the features on the GPU, returns false if the GPU can't be used for these features.
+  bool uploadFeaturesCuda(const std::vector<Feature*>& features, cuda::DeviceVectors& deviceFeatures) const;
+
+  /// Assign the features copied on the GPU to their nearest center, returns false on failure.
+  bool assignToCentersCuda(const cuda::DeviceVectors& deviceFeatures,
+                           const std::vector<Feature, FeatureAllocator>& centers,
+                           std::vector<unsigned int>& nearest,
+                           std::vector<double>& distances) const;
+#endif
+
   Feature zero_;
   Distance distance_;
   Initializer choose_centers_;
   std::size_t max_iterations_;
   std::size_t restarts_;
+  std::size_t mini_batch_size_;
+  bool use_cuda_;
   int verbose_;
 };
 
@@ -362,8 +444,10 @@ distance_(d),
 //    choose_centers_( InitRandom( ) ),
 choose_centers_(InitKmeanspp()),
 max_iterations_(100),
-verbose_(verbose),
-restarts_(1)
+restarts_(1),
+mini_batch_size_(0),
+use_cuda_(true),
+verbose_(verbose)
 {
 }
 
@@ -390,13 +474,33 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::ve
   new_centers.resize(k);
   std::vector<unsigned int> new_membership(features.size());
 
+  const bool useMiniBatch = mini_batch_size_ > 0 && features.size() > mini_batch_size_;
+  std::vector<Feature*> seeding_features;
+
   squared_distance_type least_sse = std::numeric_limits<squared_distance_type>::max();
   assert(restarts_ > 0);
   for(std::size_t starts = 0; starts < restarts_; ++starts)
   {
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Trial " << starts + 1 << "/" << restarts_);
-    choose_centers_(features, k, new_centers, distance_, verbose_);
-    squared_distance_type sse = clusterOnce(features, k, new_centers, new_membership);
+    if(useMiniBatch)
+    {
+      // Choose the initial centers on a random sample of the features
+      const std::size_t sample_size = std::min(features.size(), 3 * mini_batch_size_);
+      seeding_features = features;
+      for(std::size_t i = 0; i < sample_size; ++i)
+      {
+        const std::size_t j = i + rand() % (features.size() - i);
+        std::swap(seeding_features[i], seeding_features[j]);
+      }
+      seeding_features.resize(sample_size);
+      choose_centers_(seeding_features, k, new_centers, distance_, verbose_);
+    }
+    else
+    {
+      choose_centers_(features, k, new_centers, distance_, verbose_);
+    }
+    squared_distance_type sse = useMiniBatch ? clusterMiniBatch(features, k, new_centers, new_membership)
+                                             : clusterOnce(features, k, new_centers, new_membership);
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("End of Trial " << starts + 1 << "/" << restarts_);
     if(sse < least_sse)
     {
@@ -424,6 +528,14 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
   std::vector<Feature, FeatureAllocator> new_centers(k);
   squared_distance_type max_center_shift = std::numeric_limits<squared_distance_type>::max();
 
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  // the features are copied once on the GPU for all the iterations
+  cuda::DeviceVectors device_features;
+  const bool use_cuda = uploadFeaturesCuda(features, device_features);
+#endif
+  std::vector<unsigned int> device_nearest;
+  std::vector<double> device_distances;
+
   if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Iterations");
   for(std::size_t iter = 0; iter < max_iterations_; ++iter)
   {
@@ -438,49 +550,52 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
 
 
     // Assign data objects to current centers
-    #pragma omp parallel for shared( new_centers, new_center_counts, features, centers, membership)
-    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+    // Each thread accumulates its own centers, merged at the end of the assignment
+    const bool useSimd = useSimdKernels(centers);
+    bool assigned = false;
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    assigned = use_cuda && assignToCentersCuda(device_features, centers, device_nearest, device_distances);
+#endif
+    #pragma omp parallel
     {
-      squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
-      unsigned int nearest = 0;
-      bool found = false;
-
-      // @todo if k is large, let's say k>100 use FLAAN to retrieve the 
-      // cluster center
+      std::vector<std::size_t> thread_center_counts(k, 0);
+      std::vector<Feature, FeatureAllocator> thread_centers(k, zero_);
+      std::vector<double> buffer;
+      bool thread_is_stable = true;
 
-      // Find the nearest cluster center to feature i
-      for(unsigned int j = 0; j < k; ++j)
+      #pragma omp for
+      for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
       {
-        squared_distance_type distance = distance_(*features[i], centers[j]);
-        //		printf("\t\tdistance %f\n", (float)distance);
-        //		PrintFeat(*features[i] );
-        if(distance < d_min)
+        // @todo if k is large, let's say k>100 use FLAAN to retrieve the
+        // cluster center
+
+        // Find the nearest cluster center to feature i
+        squared_distance_type d_min;
+        const unsigned int nearest = assigned ? device_nearest[i] : findNearestCenter(*features[i], centers, useSimd, buffer, d_min);
+
+        // Assign feature i to the cluster it is nearest to
+        if(membership[i] != nearest)
         {
-          d_min = distance;
-          nearest = j;
-          found = true;
+          thread_is_stable = false;
+          membership[i] = nearest;
         }
-        //		 printf("\t distance %f %f\n", (double)distance, (double)d_min);
-      }
-      assert(found);
-      // Assign feature i to the cluster it is nearest to
-      if(membership[i] != nearest)
-      {
-        is_stable = false;
-        membership[i] = nearest;
-      }
-      // Accumulate the cluster center and its membership count
-      //	  printf("\t nearest %d\n", nearest);
-      //			checkElements(*features[i], "feat");
+        // Accumulate the cluster center and its membership count
+        thread_centers[nearest] += *features[i];
+        ++thread_center_counts[nearest];
+      }//for
+
       #pragma omp critical
       {
-        new_centers[nearest] += *features[i];
-        //			checkElements(new_centers[nearest], "sum");
-        //	  printf("\t new_centers[nearest] += *features[i];\n");
-        ++new_center_counts[nearest];
-        //	  printf("\taccumulate\n");
+        for(std::size_t j = 0; j < k; ++j)
+        {
+          if(thread_center_counts[j] == 0)
+            continue;
+          new_centers[j] += thread_centers[j];
+          new_center_counts[j] += thread_center_counts[j];
+        }
+        is_stable = is_stable && thread_is_stable;
       }
-    }//for
+    }
 
     if(is_stable) break;
 
@@ -530,5 +645,225 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
   return sse;
 }
 
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterMiniBatch(const std::vector<Feature*>& features, std::size_t k,
+                                                                    std::vector<Feature, FeatureAllocator>& centers,
+                                                                    std::vector<unsigned int>& membership) const
+{
+  typedef typename Distance::value_type feature_value_type;
+
+  const std::size_t batch_size = std::min(mini_batch_size_, features.size());
+  // stop when the smoothed inertia of the mini-batches does not improve anymore
+  const std::size_t max_no_improvement = 10;
+  const double alpha = std::min(1.0, 2.0 * batch_size / (features.size() + 1));
+
+  std::vector<std::size_t> center_counts(k, 0);
+  std::vector<Feature*> batch(batch_size);
+  std::vector<unsigned int> batch_membership(batch_size);
+  double ewa_inertia = 0.0;
+  double best_ewa_inertia = std::numeric_limits<double>::max();
+  std::size_t no_improvement = 0;
+
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Mini-batch iterations");
+  for(std::size_t iter = 0; iter < max_iterations_; ++iter)
+  {
+    if(verbose_ > 0) ALICEVISION_LOG_DEBUG("*");
+    // Draw the mini-batch and assign it to the current centers
+    for(std::size_t i = 0; i < batch_size; ++i)
+      batch[i] = features[rand() % features.size()];
+    const squared_distance_type batch_sse = assignToCenters(batch, centers, batch_membership);
+
+    // Move each center toward its features, with a per-center learning rate
+    for(std::size_t i = 0; i < batch_size; ++i)
+    {
+      const unsigned int c = batch_membership[i];
+      const double eta = 1.0 / static_cast<double>(++center_counts[c]);
+      Feature step = *batch[i];
+      step *= static_cast<feature_value_type>(eta);
+      centers[c] *= static_cast<feature_value_type>(1.0 - eta);
+      centers[c] += step;
+    }
+
+    const double inertia = static_cast<double>(batch_sse) / batch_size;
+    ewa_inertia = (iter == 0) ? inertia : ewa_inertia * (1.0 - alpha) + inertia * alpha;
+    if(ewa_inertia < best_ewa_inertia)
+    {
+      best_ewa_inertia = ewa_inertia;
+      no_improvement = 0;
+    }
+    else if(++no_improvement >= max_no_improvement)
+    {
+      break;
+    }
+  }
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("");
+
+  // Assign all the features to the final centers
+  membership.resize(features.size());
+  return assignToCenters(features, centers, membership);
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::assignToCenters(const std::vector<Feature*>& features,
+                                                                   const std::vector<Feature, FeatureAllocator>& centers,
+                                                                   std::vector<unsigned int>& membership) const
+{
+  squared_distance_type sse = squared_distance_type(0);
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  cuda::DeviceVectors device_features;
+  std::vector<unsigned int> device_nearest;
+  std::vector<double> device_distances;
+  if(uploadFeaturesCuda(features, device_features) &&
+     assignToCentersCuda(device_features, centers, device_nearest, device_distances))
+  {
+    for(std::size_t i = 0; i < features.size(); ++i)
+    {
+      membership[i] = device_nearest[i];
+      sse += device_distances[i];
+    }
+    return sse;
+  }
+#endif
+
+  const bool useSimd = useSimdKernels(centers);
+  #pragma omp parallel reduction(+:sse)
+  {
+    std::vector<double> buffer;
+
+    #pragma omp for
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+    {
+      squared_distance_type distance;
+      membership[i] = findNearestCenter(*features[i], centers, useSimd, buffer, distance);
+      sse += distance;
+    }
+  }
+  return sse;
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+unsigned int SimpleKmeans<Feature, Distance, FeatureAllocator>::findNearestCenter(const Feature& feature,
+                                                                                  const std::vector<Feature, FeatureAllocator>& centers,
+                                                                                  bool useSimd, std::vector<double>& buffer,
+                                                                                  squared_distance_type& distance) const
+{
+  squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
+  unsigned int nearest = 0;
+
+#ifdef ALICEVISION_HAVE_AVX2
+  if(useSimd)
+  {
+    const std::size_t size = feature.size();
+    buffer.resize(size);
+    for(std::size_t d = 0; d < size; ++d)
+      buffer[d] = static_cast<double>(feature[d]);
+
+    const std::size_t k = centers.size();
+    double distances[4];
+    for(std::size_t j = 0; j < k; j += 4)
+    {
+      // the missing lanes are computed on the first center of the quad and ignored
+      const std::size_t nbLanes = std::min(k - j, std::size_t(4));
+      const float* c0 = getFloatData(centers[j]);
+      const float* c1 = (nbLanes > 1) ? getFloatData(centers[j + 1]) : c0;
+      const float* c2 = (nbLanes > 2) ? getFloatData(centers[j + 2]) : c0;
+      const float* c3 = (nbLanes > 3) ? getFloatData(centers[j + 3]) : c0;
+      optim_avx2::l2x4_avx2(buffer.data(), c0, c1, c2, c3, size, distances);
+
+      // same order and strict comparison as the generic version
+      for(std::size_t lane = 0; lane < nbLanes; ++lane)
+      {
+        if(distances[lane] < d_min)
+        {
+          d_min = distances[lane];
+          nearest = static_cast<unsigned int>(j + lane);
+        }
+      }
+    }
+    distance = d_min;
+    return nearest;
+  }
+#endif
+
+  for(unsigned int j = 0; j < centers.size(); ++j)
+  {
+    const squared_distance_type d = distance_(feature, centers[j]);
+    if(d < d_min)
+    {
+      d_min = d;
+      nearest = j;
+    }
+  }
+  distance = d_min;
+  return nearest;
+}
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+template < class Feature, class Distance, class FeatureAllocator >
+bool SimpleKmeans<Feature, Distance, FeatureAllocator>::uploadFeaturesCuda(const std::vector<Feature*>& features,
+                                                                           cuda::DeviceVectors& deviceFeatures) const
+{
+  if(!use_cuda_ ||
+     features.size() < cuda::MIN_NB_FEATURES ||
+     features.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()) ||
+     !std::is_same<Distance, L2<Feature, Feature> >::value ||
+     !optim_cuda::IsCompatible<Feature>::value)
+    return false;
+
+  const std::size_t dimension = features.front()->size();
+  if(!cuda::supportNearestCenters(dimension))
+    return false;
+
+  const std::vector<float> hostFeatures = optim_cuda::toDimensionMajor(features.size(), dimension,
+                                                                       [&](std::size_t i) -> const Feature& { return *features[i]; });
+  if(!deviceFeatures.upload(hostFeatures.data(), features.size(), dimension))
+  {
+    ALICEVISION_LOG_DEBUG("Can't upload the features on the GPU, use CPU k-means assignment.");
+    return false;
+  }
+  return true;
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+bool SimpleKmeans<Feature, Distance, FeatureAllocator>::assignToCentersCuda(const cuda::DeviceVectors& deviceFeatures,
+                                                                            const std::vector<Feature, FeatureAllocator>& centers,
+                                                                            std::vector<unsigned int>& nearest,
+                                                                            std::vector<double>& distances) const
+{
+  const std::size_t dimension = deviceFeatures.dimension();
+  const std::vector<float> hostCenters = optim_cuda::toFeatureMajor(centers.size(), dimension,
+                                                                    [&](std::size_t i) -> const Feature& { return centers[i]; });
+  cuda::DeviceVectors deviceCenters;
+  std::vector<int> deviceNearest(deviceFeatures.count());
+  distances.resize(deviceFeatures.count());
+
+  if(!deviceCenters.upload(hostCenters.data(), centers.size(), dimension) ||
+     !cuda::nearestCenters(deviceFeatures, deviceCenters, deviceNearest.data(), distances.data()))
+  {
+    ALICEVISION_LOG_WARNING("GPU k-means assignment failed, use CPU k-means assignment.");
+    return false;
+  }
+  nearest.assign(deviceNearest.begin(), deviceNearest.end());
+  return true;
+}
+#endif
+
+template < class Feature, class Distance, class FeatureAllocator >
+bool SimpleKmeans<Feature, Distance, FeatureAllocator>::useSimdKernels(const std::vector<Feature, FeatureAllocator>& centers) const
+{
+#ifdef ALICEVISION_HAVE_AVX2
+  return std::is_same<Distance, L2<Feature, Feature> >::value &&
+         !centers.empty() &&
+         getFloatData(centers[0]) != nullptr &&
+         centers[0].size() % 4 == 0 &&
+         system::use_avx2_kernels();
+#else
+  return false;
+#endif
+}
+
 }
 }
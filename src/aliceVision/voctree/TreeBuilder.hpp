@@ -8,7 +8,11 @@
 
 #include "MutableVocabularyTree.hpp"
 #include "SimpleKmeans.hpp"
+
+#include <boost/function.hpp>
+
 #include <deque>
+#include <random>
 //#include <cstdio> //DEBUG
 
 namespace aliceVision {
@@ -28,6 +32,10 @@ public:
   typedef DistanceT<Feature, Feature> Distance;
   typedef SimpleKmeans<Feature, Distance, FeatureAllocator> Kmeans;
   typedef std::vector<Feature, FeatureAllocator> FeatureVector;
+  /// Callback receiving a chunk of the training features
+  typedef boost::function<void(const FeatureVector&)> FeatureVisitor;
+  /// Function passing all the training features, chunk after chunk, to the given callback
+  typedef boost::function<void(const FeatureVisitor&)> FeatureSource;
 
   /**
    * @brief Constructor
@@ -48,6 +56,24 @@ public:
    */
   void build(const FeatureVector& training_features, uint32_t k, uint32_t levels);
 
+  /**
+   * @brief Build a new vocabulary tree from features streamed chunk after chunk (e.g. file after file),
+   * so the memory does not depend on the number of training features.
+   *
+   * The tree is built level after level, each level reading all the features once:
+   * the features are quantized with the levels already built and a random sample
+   * of at most max(maxFeatures / nbNodes, k + 1) features is kept for each node of the level.
+   * When the samples keep all the features of each subset, the subsets are the ones of build()
+   * up to the features assigned to another center by the last k-means iteration.
+   *
+   * @param source      The function passing the training features to its callback,
+   *                    it must give the same features in the same order at each call.
+   * @param k           The branching factor, or max children of any node.
+   * @param levels      The number of levels in the tree.
+   * @param maxFeatures The maximum number of features kept in memory for one level.
+   */
+  void buildStreaming(const FeatureSource& source, uint32_t k, uint32_t levels, std::size_t maxFeatures);
+
   /// Get the built vocabulary tree.
 
   const Tree& tree() const
@@ -80,6 +106,13 @@ public:
   }
 
 protected:
+  /**
+   * @brief Quantize a feature with the levels of the tree already built.
+   * @return the index of its node at the given level (-1 for the root),
+   *         or -2 if the feature does not reach a node clustered at this level
+   */
+  int32_t findNode(const Feature& feature, uint32_t level, const std::vector<uint8_t>& clustered) const;
+
   Tree tree_;
   Kmeans kmeans_;
   Feature zero_;
@@ -172,5 +205,137 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
   }
 }
 
+template<class Feature, template<typename, typename> class DistanceT, class FeatureAllocator>
+void TreeBuilder<Feature, DistanceT, FeatureAllocator>::buildStreaming(const FeatureSource& source,
+                                                                      uint32_t k, uint32_t levels,
+                                                                      std::size_t maxFeatures)
+{
+  // Initial setup and memory allocation for the tree
+  tree_.clear();
+  tree_.setSize(levels, k);
+  tree_.centers().reserve(tree_.nodes());
+  tree_.validCenters().reserve(tree_.nodes());
+
+  // 1 for the centers computed by k-means, their features are clustered at the next level.
+  // As in build(), the centers of the subsets of k or fewer features are leaves.
+  std::vector<uint8_t> clustered;
+  clustered.reserve(tree_.nodes());
+
+  std::mt19937 generator(0);
+  FeatureVector centers; // always size k
+  std::size_t nbNodes = 1;  // number of subsets to cluster at this level
+  int32_t firstNode = -1; // index of the first of these subsets (-1 for the root)
+
+  for(uint32_t level = 0; level < levels; ++level)
+  {
+    if(verbose_) printf("# Level %u\n", level);
+
+    // Sample the features of each subset of this level
+    const std::size_t capacity = std::max(maxFeatures / nbNodes, std::size_t(k) + 1);
+    std::vector<FeatureVector> samples(nbNodes);
+    std::vector<std::size_t> nbSubsetFeatures(nbNodes, 0);
+    std::vector<int32_t> nodes;
+
+    source([&](const FeatureVector& chunk)
+    {
+      nodes.resize(chunk.size());
+      #pragma omp parallel for
+      for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(chunk.size()); ++i)
+        nodes[i] = findNode(chunk[i], level, clustered);
+
+      for(std::size_t i = 0; i < chunk.size(); ++i)
+      {
+        if(nodes[i] < -1)
+          continue;
+        const std::size_t subset = nodes[i] - firstNode;
+        FeatureVector& sample = samples[subset];
+        const std::size_t n = nbSubsetFeatures[subset]++;
+        // reservoir sampling
+        if(n < capacity)
+        {
+          sample.push_back(chunk[i]);
+        }
+        else
+        {
+          const std::size_t j = std::uniform_int_distribution<std::size_t>(0, n)(generator);
+          if(j < capacity)
+            sample[j] = chunk[i];
+        }
+      }
+    });
+
+    std::vector<unsigned int> membership;
+    std::vector<Feature*> subset;
+    for(std::size_t i = 0; i < nbNodes; ++i)
+    {
+      FeatureVector& sample = samples[i];
+      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu (%lu sampled)\n", i + 1, nbNodes, nbSubsetFeatures[i], sample.size());
+
+      // If the subset already has k or fewer elements, just use those as the centers.
+      if(sample.size() <= k)
+      {
+        if(verbose_ > 2) printf("#\tno need to cluster %lu elements\n", sample.size());
+        tree_.centers().insert(tree_.centers().end(), sample.begin(), sample.end());
+        tree_.validCenters().insert(tree_.validCenters().end(), sample.size(), 1);
+        // Mark non-existent centers as invalid.
+        tree_.centers().insert(tree_.centers().end(), k - sample.size(), zero_);
+        tree_.validCenters().insert(tree_.validCenters().end(), k - sample.size(), 0);
+        clustered.insert(clustered.end(), k, 0);
+      }
+      else
+      {
+        // Cluster the current subset into k centers.
+        if(verbose_ > 2) printf("#\tclustering the current subset of %lu elements into %d centers\n", sample.size(), k);
+        subset.clear();
+        for(Feature& f: sample)
+          subset.push_back(&f);
+        kmeans_.clusterPointers(subset, k, centers, membership);
+        // Add the centers and mark them as valid.
+        tree_.centers().insert(tree_.centers().end(), centers.begin(), centers.end());
+        tree_.validCenters().insert(tree_.validCenters().end(), k, 1);
+        clustered.insert(clustered.end(), k, 1);
+      }
+      // Release the memory of the subset
+      FeatureVector().swap(sample);
+    }
+    if(verbose_) printf("# centers so far = %lu\n", tree_.centers().size());
+
+    firstNode = (firstNode + 1) * k;
+    nbNodes *= k;
+  }
+}
+
+template<class Feature, template<typename, typename> class DistanceT, class FeatureAllocator>
+int32_t TreeBuilder<Feature, DistanceT, FeatureAllocator>::findNode(const Feature& feature, uint32_t level,
+                                                                   const std::vector<uint8_t>& clustered) const
+{
+  typedef typename Distance::result_type distance_type;
+
+  const Distance& distance = kmeans_.getDistance();
+  int32_t index = -1; // virtual "root" index, which has no associated center.
+  for(uint32_t l = 0; l < level; ++l)
+  {
+    // Find the child center closest to the feature.
+    const int32_t first_child = (index + 1) * tree_.splits();
+    int32_t best_child = first_child;
+    distance_type best_distance = std::numeric_limits<distance_type>::max();
+    for(int32_t child = first_child; child < first_child + (int32_t) tree_.splits(); ++child)
+    {
+      if(!tree_.validCenters()[child])
+        break; // Fewer than splits() children.
+      const distance_type child_distance = distance(feature, tree_.centers()[child]);
+      if(child_distance < best_distance)
+      {
+        best_child = child;
+        best_distance = child_distance;
+      }
+    }
+    index = best_child;
+  }
+  if(index >= 0 && !clustered[index])
+    return -2;
+  return index;
+}
+
 }
 }
@@ -158,8 +158,10 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
       else if(i1->first < i2->first)
       {
         N1 += i1->second.size()*word_weights[i1->first];
-         ++i1;
+        ++i1;
       }
+      else
+      {
         if( ( fabs(i1->second.size() - 1.0) < epsilon ) && ( fabs(i2->second.size() - 1.0) < epsilon) )
         {
           score += word_weights[i1->first];
@@ -168,6 +170,7 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
         }
         ++i1;
         ++i2;
+      }
     }
 
     while(i1 != i1e)
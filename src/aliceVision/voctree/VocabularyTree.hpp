@@ -8,17 +8,29 @@
 
 #include <aliceVision/config.hpp>
 #include "distance.hpp"
+#include "distanceCuda.hpp"
+#include "distanceSimd.hpp"
 #include "DefaultAllocator.hpp"
 
+#include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/regionsFactory.hpp>
 
 #include <aliceVision/types.hpp>
 #include <aliceVision/system/Logger.hpp>
 
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
 #include <stdint.h>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
 #include <cassert>
 #include <limits>
 #include <fstream>
@@ -66,6 +78,8 @@ public:
   virtual void save(const std::string& file) const = 0;
   /// Load vocabulary from a file.
   virtual void load(const std::string& file) = 0;
+  /// Map vocabulary file in memory (read-only).
+  virtual void loadMapped(const std::string& file) = 0;
 
   /**
    * @brief Create a SparseHistogram from a blind vector of descriptors.
@@ -84,6 +98,13 @@ public:
   /// Clears vocabulary, leaving an empty tree.
   virtual void clear() = 0;
 
+  /**
+   * @brief Quantize the large sets of features on the GPU, if built with CUDA and a device is available.
+   * @note Enabled by default, the visual words are the same as on the CPU.
+   */
+  virtual void setUseCuda(bool useCuda) = 0;
+  virtual bool useCuda() const = 0;
+
 };
 
 inline IVocabularyTree::~IVocabularyTree() {}
@@ -117,10 +138,26 @@ public:
   template<class DescriptorT>
   Word quantize(const DescriptorT& feature) const;
 
-  /// Quantizes a set of features into visual words.
+  /// Quantizes a set of features into visual words (see quantizeBatch).
   template<class DescriptorT>
   std::vector<Word> quantize(const std::vector<DescriptorT>& features) const;
 
+  /**
+   * @brief Quantizes a set of features into visual words, by blocks of features descended level by level.
+   *
+   * In a block, the features are visited in the order of their current node, so the children centers
+   * of a node are read once for all its features. With the L2 distance and float centers,
+   * the distances to 4 children are computed at once with SIMD instructions (if supported by the CPU).
+   * The blocks are processed in parallel.
+   * With CUDA, the large sets of float or unsigned char features are quantized on the GPU (see setUseCuda).
+   * @note The words are identical to the ones of quantize(feature).
+   * @param[in] features the features to quantize
+   * @param[in] blockSize the number of features of a block
+   * @return the visual word of each feature
+   */
+  template<class DescriptorT>
+  std::vector<Word> quantizeBatch(const std::vector<DescriptorT>& features, std::size_t blockSize = 256) const;
+
   /// Quantizes a set of features into sparse histogram of visual words.
   template<class DescriptorT>
   SparseHistogram quantizeToSparse(const std::vector<DescriptorT>& features) const;
@@ -141,15 +178,44 @@ public:
   /// Clears vocabulary, leaving an empty tree.
   void clear() override;
 
+  void setUseCuda(bool useCuda) override
+  {
+    useCuda_ = useCuda;
+  }
+
+  bool useCuda() const override
+  {
+    return useCuda_;
+  }
+
   /// Save vocabulary to a file.
   void save(const std::string& file) const override;
   /// Load vocabulary from a file.
   void load(const std::string& file) override;
 
+  /**
+   * @brief Map the vocabulary file in memory, read-only.
+   *
+   * The centers are not copied: they are read from the pages of the file, loaded on demand
+   * and shared by all the processes mapping the same file. The file must not be modified while mapped.
+   * If the centers can't be used in place (non trivially copyable or over-aligned Feature),
+   * the file is loaded in memory.
+   * @param file vocabulary file path
+   */
+  void loadMapped(const std::string& file) override;
+
+  /// Returns true if the centers are mapped from the vocabulary file.
+  bool isMapped() const
+  {
+    return mappedCenters_ != nullptr;
+  }
+
   bool operator==(const VocabularyTree& other) const
   {
-    return (centers_ == other.centers_) &&
-        (valid_centers_ == other.valid_centers_) &&
+    const std::size_t size = nbCenters();
+    return (size == other.nbCenters()) &&
+        std::equal(centersData(), centersData() + size, other.centersData()) &&
+        std::equal(validCentersData(), validCentersData() + size, other.validCentersData()) &&
         (k_ == other.k_) &&
         (levels_ == other.levels_) &&
         (num_words_ == other.num_words_) &&
@@ -165,12 +231,75 @@ protected:
   uint32_t num_words_; // number of leaf nodes
   uint32_t word_start_; // number of non-leaf nodes, or offset to the first leaf node
 
+  /// vocabulary file mapped in memory (see loadMapped), shared by the copies of the tree
+  std::shared_ptr<boost::interprocess::mapped_region> mappedRegion_;
+  const Feature* mappedCenters_ = nullptr;
+  const uint8_t* mappedValidCenters_ = nullptr;
+
+  bool useCuda_ = true;
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  /// Copy of the tree on the GPU, uploaded by the first quantization on the GPU
+  struct DeviceTreeCache
+  {
+    std::mutex mutex;
+    cuda::DeviceTree tree;
+    bool failed = false;
+  };
+  /// shared by the copies of the tree, replaced when the centers change
+  mutable std::shared_ptr<DeviceTreeCache> deviceTree_ = std::make_shared<DeviceTreeCache>();
+#endif
+
+  /// Release the copy of the tree on the GPU, must be called when the centers change.
+  void resetDeviceTree()
+  {
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+    deviceTree_ = std::make_shared<DeviceTreeCache>();
+#endif
+  }
+
+  /// Centers, in memory or mapped from the vocabulary file.
+  const Feature* centersData() const
+  {
+    return mappedCenters_ ? mappedCenters_ : centers_.data();
+  }
+
+  /// Validity of the centers, in memory or mapped from the vocabulary file.
+  const uint8_t* validCentersData() const
+  {
+    return mappedCenters_ ? mappedValidCenters_ : valid_centers_.data();
+  }
+
+  std::size_t nbCenters() const
+  {
+    return mappedCenters_ ? (word_start_ + num_words_) : centers_.size();
+  }
+
   bool initialized() const
   {
     return num_words_ != 0;
   }
 
   void setNodeCounts();
+
+  /// Find the child center of the given node closest to the feature.
+  template<class DescriptorT>
+  int32_t findBestChild(const DescriptorT& feature, int32_t index) const;
+
+  /// Returns true if the SIMD kernels give the same distances as Distance<DescriptorT, Feature>.
+  template<class DescriptorT>
+  bool useSimdKernels() const;
+
+#ifdef ALICEVISION_HAVE_AVX2
+  /// Find the child center of the given node closest to a feature converted to double (AVX2).
+  int32_t findBestChild_avx2(const double* feature, std::size_t size, int32_t index) const;
+#endif
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  /// Quantize the features on the GPU, returns false if the GPU can't be used for these features.
+  template<class DescriptorT>
+  bool quantizeCuda(const std::vector<DescriptorT>& features, std::vector<Word>& words) const;
+#endif
 };
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -188,34 +317,148 @@ VocabularyTree<Feature, Distance, FeatureAllocator>::VocabularyTree(const std::s
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 template<class DescriptorT>
-Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const DescriptorT& feature) const
+int32_t VocabularyTree<Feature, Distance, FeatureAllocator>::findBestChild(const DescriptorT& feature, int32_t index) const
 {
   typedef typename Distance<Feature, DescriptorT>::result_type distance_type;
 
-  //	printf("asserting\n");
-  assert(initialized());
-  //	printf("initialized\n");
-  int32_t index = -1; // virtual "root" index, which has no associated center.
-  for(unsigned level = 0; level < levels_; ++level)
+  // Calculate the offset to the first child of the current index.
+  int32_t first_child = (index + 1) * splits();
+  // Find the child center closest to the query.
+  int32_t best_child = first_child;
+  distance_type best_distance = std::numeric_limits<distance_type>::max();
+  const Feature* centers = centersData();
+  const uint8_t* valid_centers = validCentersData();
+  for(int32_t child = first_child; child < first_child + (int32_t) splits(); ++child)
+  {
+    if(!valid_centers[child])
+      break; // Fewer than splits() children.
+    distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers[child]);
+    if(child_distance < best_distance)
+    {
+      best_child = child;
+      best_distance = child_distance;
+    }
+  }
+  return best_child;
+}
+
+#ifdef ALICEVISION_HAVE_AVX2
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+int32_t VocabularyTree<Feature, Distance, FeatureAllocator>::findBestChild_avx2(const double* feature, std::size_t size, int32_t index) const
+{
+  const int32_t first_child = (index + 1) * splits();
+  const int32_t last_child = first_child + (int32_t) splits();
+  int32_t best_child = first_child;
+  double best_distance = std::numeric_limits<double>::max();
+  double distances[4];
+  const Feature* centers = centersData();
+  const uint8_t* valid_centers = validCentersData();
+
+  for(int32_t child = first_child; child < last_child; child += 4)
   {
-    // Calculate the offset to the first child of the current index.
-    int32_t first_child = (index + 1) * splits();
-    // Find the child center closest to the query.
-    int32_t best_child = first_child;
-    distance_type best_distance = std::numeric_limits<distance_type>::max();
-    for(int32_t child = first_child; child < first_child + (int32_t) splits(); ++child)
+    // valid children of this quad, the missing lanes are computed on the first child and ignored
+    int nbLanes = 0;
+    while(nbLanes < 4 && child + nbLanes < last_child && valid_centers[child + nbLanes])
+      ++nbLanes;
+    if(nbLanes == 0)
+      break; // Fewer than splits() children.
+
+    const float* c0 = getFloatData(centers[child]);
+    const float* c1 = (nbLanes > 1) ? getFloatData(centers[child + 1]) : c0;
+    const float* c2 = (nbLanes > 2) ? getFloatData(centers[child + 2]) : c0;
+    const float* c3 = (nbLanes > 3) ? getFloatData(centers[child + 3]) : c0;
+    optim_avx2::l2x4_avx2(feature, c0, c1, c2, c3, size, distances);
+
+    // same order and strict comparison as findBestChild
+    for(int lane = 0; lane < nbLanes; ++lane)
     {
-      if(!valid_centers_[child])
-        break; // Fewer than splits() children.
-      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers_[child]);
-      if(child_distance < best_distance)
+      if(distances[lane] < best_distance)
       {
-        best_child = child;
-        best_distance = child_distance;
+        best_child = child + lane;
+        best_distance = distances[lane];
       }
     }
-    index = best_child;
+    if(nbLanes < 4)
+      break;
   }
+  return best_child;
+}
+#endif
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+bool VocabularyTree<Feature, Distance, FeatureAllocator>::quantizeCuda(const std::vector<DescriptorT>& features, std::vector<Word>& words) const
+{
+  const std::size_t dimension = features.front().size();
+  if(!useCuda_ ||
+     features.size() < cuda::MIN_NB_FEATURES ||
+     features.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()) ||
+     !std::is_same<Distance<DescriptorT, Feature>, L2<DescriptorT, Feature> >::value ||
+     !optim_cuda::IsCompatible<Feature>::value ||
+     !optim_cuda::IsCompatible<DescriptorT>::value ||
+     dimension != centersData()[0].size() ||
+     !cuda::supportNearestCenters(dimension))
+    return false;
+
+  const std::shared_ptr<DeviceTreeCache> deviceTree = deviceTree_;
+  {
+    std::lock_guard<std::mutex> lock(deviceTree->mutex);
+    if(deviceTree->failed)
+      return false;
+    if(deviceTree->tree.empty())
+    {
+      const std::vector<float> centers = optim_cuda::toFeatureMajor(nbCenters(), dimension,
+                                                                    [&](std::size_t i) -> const Feature& { return centersData()[i]; });
+      if(!deviceTree->tree.upload(centers.data(), validCentersData(), nbCenters(), dimension, k_, levels_))
+      {
+        ALICEVISION_LOG_DEBUG("Can't upload the vocabulary tree on the GPU, use CPU quantization.");
+        deviceTree->failed = true;
+        return false;
+      }
+    }
+  }
+
+  const std::vector<float> hostFeatures = optim_cuda::toDimensionMajor(features.size(), dimension,
+                                                                       [&](std::size_t i) -> const DescriptorT& { return features[i]; });
+  cuda::DeviceVectors deviceFeatures;
+  std::vector<int32_t> nodes(features.size());
+  if(!deviceFeatures.upload(hostFeatures.data(), features.size(), dimension) ||
+     !cuda::quantize(deviceFeatures, deviceTree->tree, nodes.data()))
+  {
+    ALICEVISION_LOG_WARNING("GPU quantization failed, use CPU quantization.");
+    return false;
+  }
+
+  for(std::size_t i = 0; i < features.size(); ++i)
+    words[i] = nodes[i] - word_start_;
+  return true;
+}
+#endif
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+bool VocabularyTree<Feature, Distance, FeatureAllocator>::useSimdKernels() const
+{
+#ifdef ALICEVISION_HAVE_AVX2
+  return std::is_same<Distance<DescriptorT, Feature>, L2<DescriptorT, Feature> >::value &&
+         nbCenters() != 0 &&
+         getFloatData(centersData()[0]) != nullptr &&
+         centersData()[0].size() % 4 == 0 &&
+         system::use_avx2_kernels();
+#else
+  return false;
+#endif
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const DescriptorT& feature) const
+{
+  assert(initialized());
+  int32_t index = -1; // virtual "root" index, which has no associated center.
+  for(unsigned level = 0; level < levels_; ++level)
+    index = findBestChild(feature, index);
 
   return index - word_start_;
 }
@@ -224,18 +467,76 @@ template<class Feature, template<typename, typename> class Distance, class Featu
 template<class DescriptorT>
 std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const std::vector<DescriptorT>& features) const
 {
-  // ALICEVISION_LOG_DEBUG("VocabularyTree quantize: " << features.size());
+  return quantizeBatch(features);
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantizeBatch(const std::vector<DescriptorT>& features, std::size_t blockSize) const
+{
+  assert(initialized());
   std::vector<Word> imgVisualWords(features.size(), 0);
+  if(features.empty())
+    return imgVisualWords;
 
-  // quantize the features
-  #pragma omp parallel for
-  for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(features.size()); ++j)
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+  if(quantizeCuda(features, imgVisualWords))
+    return imgVisualWords;
+#endif
+
+  blockSize = std::max(blockSize, std::size_t(1));
+  const std::size_t size = features.front().size();
+  const bool useSimd = useSimdKernels<DescriptorT>() && size == centersData()[0].size();
+  const std::size_t nbBlocks = (features.size() + blockSize - 1) / blockSize;
+
+  #pragma omp parallel
   {
-    // store the visual word associated to the feature in the temporary list
-    imgVisualWords[j] = quantize<DescriptorT>(features[j]);
+    std::vector<int32_t> nodes(blockSize);
+    std::vector<std::size_t> order(blockSize);
+    std::vector<double> blockFeatures(useSimd ? blockSize * size : 0); // features converted to double
+
+    #pragma omp for schedule(dynamic)
+    for(ptrdiff_t b = 0; b < static_cast<ptrdiff_t>(nbBlocks); ++b)
+    {
+      const std::size_t begin = b * blockSize;
+      const std::size_t nbBlockFeatures = std::min(blockSize, features.size() - begin);
+
+      std::fill(nodes.begin(), nodes.begin() + nbBlockFeatures, -1); // virtual "root" index
+      std::iota(order.begin(), order.begin() + nbBlockFeatures, 0);
+
+      if(useSimd)
+      {
+        for(std::size_t i = 0; i < nbBlockFeatures; ++i)
+          for(std::size_t d = 0; d < size; ++d)
+            blockFeatures[i * size + d] = static_cast<double>(features[begin + i][d]);
+      }
+
+      for(unsigned level = 0; level < levels_; ++level)
+      {
+        // visit the features by node, so the children centers of a node stay in cache
+        if(level > 0)
+          std::sort(order.begin(), order.begin() + nbBlockFeatures,
+                    [&](std::size_t i, std::size_t j) { return nodes[i] < nodes[j]; });
+
+        for(std::size_t k = 0; k < nbBlockFeatures; ++k)
+        {
+          const std::size_t i = order[k];
+#ifdef ALICEVISION_HAVE_AVX2
+          if(useSimd)
+          {
+            nodes[i] = findBestChild_avx2(&blockFeatures[i * size], size, nodes[i]);
+            continue;
+          }
+#endif
+          nodes[i] = findBestChild(features[begin + i], nodes[i]);
+        }
+      }
+
+      for(std::size_t i = 0; i < nbBlockFeatures; ++i)
+        imgVisualWords[begin + i] = nodes[i] - word_start_;
+    }
   }
 
-  // add the vector to the documents
   return imgVisualWords;
 }
 
@@ -272,6 +573,10 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::clear()
 {
   centers_.clear();
   valid_centers_.clear();
+  mappedRegion_.reset();
+  mappedCenters_ = nullptr;
+  mappedValidCenters_ = nullptr;
+  resetDeviceTree();
   k_ = levels_ = num_words_ = word_start_ = 0;
 }
 
@@ -285,10 +590,10 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::save(const std::string
   std::ofstream out(file.c_str(), std::ios_base::binary);
   out.write((char*) (&k_), sizeof (uint32_t));
   out.write((char*) (&levels_), sizeof (uint32_t));
-  uint32_t size = centers_.size();
+  uint32_t size = nbCenters();
   out.write((char*) (&size), sizeof (uint32_t));
-  out.write((char*) (&centers_[0]), centers_.size() * sizeof (Feature));
-  out.write((char*) (&valid_centers_[0]), valid_centers_.size());
+  out.write((char*) (centersData()), size * sizeof (Feature));
+  out.write((char*) (validCentersData()), size);
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -320,6 +625,64 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::load(const std::string
   assert(size == num_words_ + word_start_);
 }
 
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::loadMapped(const std::string& file)
+{
+  namespace bi = boost::interprocess;
+
+  // the centers follow a header of 3 uint32_t (see save)
+  const std::size_t headerSize = 3 * sizeof(uint32_t);
+
+  if(!std::is_trivially_copyable<Feature>::value || (headerSize % alignof(Feature)) != 0)
+  {
+    ALICEVISION_LOG_DEBUG("The centers of the vocabulary tree can't be mapped, load the file in memory: " << file);
+    load(file);
+    return;
+  }
+
+  clear();
+
+  std::shared_ptr<bi::mapped_region> region;
+  try
+  {
+    const bi::file_mapping mapping(file.c_str(), bi::read_only);
+    region = std::make_shared<bi::mapped_region>(mapping, bi::read_only);
+  }
+  catch(const bi::interprocess_exception& e)
+  {
+    throw std::runtime_error("Failed to map vocabulary tree file " + file + ": " + e.what());
+  }
+
+  const uint8_t* data = static_cast<const uint8_t*>(region->get_address());
+  const std::size_t fileSize = region->get_size();
+
+  uint32_t size = 0;
+  if(fileSize >= headerSize)
+  {
+    std::memcpy(&k_, data, sizeof(uint32_t));
+    std::memcpy(&levels_, data + sizeof(uint32_t), sizeof(uint32_t));
+    std::memcpy(&size, data + 2 * sizeof(uint32_t), sizeof(uint32_t));
+  }
+
+  if(fileSize < headerSize || levels_ == 0 ||
+     fileSize < headerSize + static_cast<std::size_t>(size) * (sizeof(Feature) + 1))
+  {
+    clear();
+    throw std::runtime_error("Failed to load vocabulary tree file" + file);
+  }
+
+  setNodeCounts();
+  if(size != num_words_ + word_start_)
+  {
+    clear();
+    throw std::runtime_error("Failed to load vocabulary tree file" + file);
+  }
+
+  mappedCenters_ = reinterpret_cast<const Feature*>(data + headerSize);
+  mappedValidCenters_ = data + headerSize + static_cast<std::size_t>(size) * sizeof(Feature);
+  mappedRegion_ = region;
+}
+
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
 void VocabularyTree<Feature, Distance, FeatureAllocator>::setNodeCounts()
 {
@@ -373,7 +736,14 @@ inline std::unique_ptr<IVocabularyTree> createVoctreeForDescriberType(feature::E
   return res;
 }
 
-inline void load(std::unique_ptr<IVocabularyTree>& out_voctree, feature::EImageDescriberType& out_descType, const std::string& filepath)
+/**
+ * @brief Create and load the vocabulary tree of the describer type given by the filename extension (<name>.<descType>.tree)
+ * @param[out] out_voctree The vocabulary tree
+ * @param[out] out_descType The describer type
+ * @param[in] filepath The vocabulary tree file
+ * @param[in] memoryMapped Map the file in memory instead of reading it (see VocabularyTree::loadMapped)
+ */
+inline void load(std::unique_ptr<IVocabularyTree>& out_voctree, feature::EImageDescriberType& out_descType, const std::string& filepath, bool memoryMapped = false)
 {
   std::size_t lastDot = filepath.find_last_of(".");
   if(lastDot == std::string::npos)
@@ -386,7 +756,10 @@ inline void load(std::unique_ptr<IVocabularyTree>& out_voctree, feature::EImageD
 
   out_descType = feature::EImageDescriberType_stringToEnum(descTypeStr);
   out_voctree = createVoctreeForDescriberType(out_descType);
-  out_voctree->load(filepath);
+  if(memoryMapped)
+    out_voctree->loadMapped(filepath);
+  else
+    out_voctree->load(filepath);
 }
 
 }
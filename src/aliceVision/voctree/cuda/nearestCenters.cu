@@ -0,0 +1,310 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "nearestCenters.hpp"
+
+#include <cuda_runtime.h>
+
+#include <cfloat>
+
+namespace aliceVision {
+namespace voctree {
+namespace cuda {
+
+namespace {
+
+/// number of features processed by one block (one thread per feature)
+constexpr int FEATURE_TILE = 128;
+/// number of centers loaded at once in shared memory
+constexpr int CENTER_TILE = 16;
+/// shared memory available for one block
+constexpr std::size_t MAX_SHARED_MEMORY = 48 * 1024;
+
+/// Round a / b to nearest higher integer value.
+inline unsigned int divUp(unsigned int a, unsigned int b)
+{
+  return (a % b != 0) ? (a / b + 1) : (a / b);
+}
+
+/**
+ * @brief Squared L2 distance between a feature (one element every nbFeatures) and a center,
+ * in the same order and with the same roundings as the L2 functor on the CPU.
+ */
+__device__ inline double l2Distance(const float* feature, int nbFeatures, const float* center, int dimension)
+{
+  double result = 0.0;
+  for(int d = 0; d < dimension; ++d)
+  {
+    // no fused multiply-add, a subtraction alone is not contracted
+    const double diff = static_cast<double>(feature[static_cast<std::size_t>(d) * nbFeatures]) - static_cast<double>(center[d]);
+    result = __dadd_rn(result, __dmul_rn(diff, diff));
+  }
+  return result;
+}
+
+/**
+ * @brief Find the nearest center of each feature, one thread per feature.
+ *
+ * The centers are streamed tile by tile in shared memory where each element is read
+ * by all the threads at once (broadcast).
+ */
+__global__ void nearestCentersKernel(const float* features,
+                                     int nbFeatures,
+                                     const float* centers,
+                                     int nbCenters,
+                                     int dimension,
+                                     int* nearest,
+                                     double* distances)
+{
+  extern __shared__ float centerTile[];
+
+  const int featureIndex = blockIdx.x * blockDim.x + threadIdx.x;
+  const float* feature = features + featureIndex;
+
+  double best = DBL_MAX;
+  int bestIndex = 0;
+
+  for(int firstCenter = 0; firstCenter < nbCenters; firstCenter += CENTER_TILE)
+  {
+    const int tileCenters = min(CENTER_TILE, nbCenters - firstCenter);
+
+    // wait for the previous tile to be consumed
+    __syncthreads();
+    for(int e = threadIdx.x; e < tileCenters * dimension; e += blockDim.x)
+      centerTile[e] = centers[firstCenter * dimension + e];
+    __syncthreads();
+
+    if(featureIndex >= nbFeatures)
+      continue;
+
+    // same order and strict comparison as the CPU
+    for(int c = 0; c < tileCenters; ++c)
+    {
+      const double distance = l2Distance(feature, nbFeatures, centerTile + c * dimension, dimension);
+      if(distance < best)
+      {
+        best = distance;
+        bestIndex = firstCenter + c;
+      }
+    }
+  }
+
+  if(featureIndex < nbFeatures)
+  {
+    nearest[featureIndex] = bestIndex;
+    distances[featureIndex] = best;
+  }
+}
+
+/**
+ * @brief Descend the vocabulary tree, one thread per feature.
+ */
+__global__ void quantizeKernel(const float* features,
+                               int nbFeatures,
+                               const float* __restrict__ centers,
+                               const uint8_t* __restrict__ validCenters,
+                               int dimension,
+                               int splits,
+                               int levels,
+                               int32_t* nodes)
+{
+  const int featureIndex = blockIdx.x * blockDim.x + threadIdx.x;
+  if(featureIndex >= nbFeatures)
+    return;
+
+  const float* feature = features + featureIndex;
+
+  int32_t index = -1; // virtual "root" index, which has no associated center.
+  for(int level = 0; level < levels; ++level)
+  {
+    // same order and strict comparison as VocabularyTree::findBestChild
+    const int32_t firstChild = (index + 1) * splits;
+    int32_t bestChild = firstChild;
+    double bestDistance = DBL_MAX;
+    for(int32_t child = firstChild; child < firstChild + splits; ++child)
+    {
+      if(!validCenters[child])
+        break; // Fewer than splits children.
+      const double distance = l2Distance(feature, nbFeatures, centers + static_cast<std::size_t>(child) * dimension, dimension);
+      if(distance < bestDistance)
+      {
+        bestChild = child;
+        bestDistance = distance;
+      }
+    }
+    index = bestChild;
+  }
+  nodes[featureIndex] = index;
+}
+
+/**
+ * @brief Device buffer released at the end of the scope
+ */
+struct DeviceBuffer
+{
+  void* data = nullptr;
+
+  ~DeviceBuffer()
+  {
+    if(data != nullptr)
+      cudaFree(data);
+  }
+
+  bool allocate(std::size_t size)
+  {
+    return cudaMalloc(&data, size) == cudaSuccess;
+  }
+};
+
+} // namespace
+
+bool supportNearestCenters(std::size_t dimension)
+{
+  if(dimension == 0 || CENTER_TILE * dimension * sizeof(float) > MAX_SHARED_MEMORY)
+    return false;
+
+  int nbDevices = 0;
+  return (cudaGetDeviceCount(&nbDevices) == cudaSuccess) && (nbDevices > 0);
+}
+
+DeviceVectors::~DeviceVectors()
+{
+  clear();
+}
+
+bool DeviceVectors::upload(const float* data, int count, int dimension)
+{
+  clear();
+
+  const std::size_t size = static_cast<std::size_t>(count) * dimension * sizeof(float);
+  if(count <= 0 || dimension <= 0 || cudaMalloc(reinterpret_cast<void**>(&_data), size) != cudaSuccess)
+  {
+    _data = nullptr;
+    return false;
+  }
+
+  if(cudaMemcpy(_data, data, size, cudaMemcpyHostToDevice) != cudaSuccess)
+  {
+    clear();
+    return false;
+  }
+
+  _count = count;
+  _dimension = dimension;
+  return true;
+}
+
+void DeviceVectors::clear()
+{
+  if(_data != nullptr)
+    cudaFree(_data);
+
+  _data = nullptr;
+  _count = 0;
+  _dimension = 0;
+}
+
+DeviceTree::~DeviceTree()
+{
+  clear();
+}
+
+bool DeviceTree::upload(const float* centers, const uint8_t* validCenters, int count, int dimension, int splits, int levels)
+{
+  clear();
+
+  if(!_centers.upload(centers, count, dimension))
+    return false;
+
+  if(cudaMalloc(reinterpret_cast<void**>(&_validCenters), count) != cudaSuccess)
+  {
+    _validCenters = nullptr;
+    clear();
+    return false;
+  }
+
+  if(cudaMemcpy(_validCenters, validCenters, count, cudaMemcpyHostToDevice) != cudaSuccess)
+  {
+    clear();
+    return false;
+  }
+
+  _splits = splits;
+  _levels = levels;
+  return true;
+}
+
+void DeviceTree::clear()
+{
+  _centers.clear();
+  if(_validCenters != nullptr)
+    cudaFree(_validCenters);
+
+  _validCenters = nullptr;
+  _splits = 0;
+  _levels = 0;
+}
+
+bool nearestCenters(const DeviceVectors& features, const DeviceVectors& centers, int* nearest, double* distances)
+{
+  if(features.empty() || centers.empty() || features.dimension() != centers.dimension())
+    return false;
+
+  const int nbFeatures = features.count();
+  const int dimension = features.dimension();
+  const std::size_t sharedSize = CENTER_TILE * dimension * sizeof(float);
+  if(sharedSize > MAX_SHARED_MEMORY)
+    return false;
+
+  DeviceBuffer deviceNearest;
+  DeviceBuffer deviceDistances;
+
+  if(!deviceNearest.allocate(nbFeatures * sizeof(int)) ||
+     !deviceDistances.allocate(nbFeatures * sizeof(double)))
+    return false;
+
+  const dim3 grid(divUp(nbFeatures, FEATURE_TILE));
+  const dim3 block(FEATURE_TILE);
+
+  nearestCentersKernel<<<grid, block, sharedSize>>>(features.data(), nbFeatures, centers.data(), centers.count(), dimension,
+                                                    static_cast<int*>(deviceNearest.data), static_cast<double*>(deviceDistances.data));
+
+  if(cudaGetLastError() != cudaSuccess)
+    return false;
+
+  // synchronous copies, wait for the kernel
+  return (cudaMemcpy(nearest, deviceNearest.data, nbFeatures * sizeof(int), cudaMemcpyDeviceToHost) == cudaSuccess) &&
+         (cudaMemcpy(distances, deviceDistances.data, nbFeatures * sizeof(double), cudaMemcpyDeviceToHost) == cudaSuccess);
+}
+
+bool quantize(const DeviceVectors& features, const DeviceTree& tree, int32_t* nodes)
+{
+  if(features.empty() || tree.empty() || features.dimension() != tree.centers().dimension())
+    return false;
+
+  const int nbFeatures = features.count();
+
+  DeviceBuffer deviceNodes;
+  if(!deviceNodes.allocate(nbFeatures * sizeof(int32_t)))
+    return false;
+
+  const dim3 grid(divUp(nbFeatures, FEATURE_TILE));
+  const dim3 block(FEATURE_TILE);
+
+  quantizeKernel<<<grid, block>>>(features.data(), nbFeatures, tree.centers().data(), tree.validCenters(),
+                                  features.dimension(), tree.splits(), tree.levels(),
+                                  static_cast<int32_t*>(deviceNodes.data));
+
+  if(cudaGetLastError() != cudaSuccess)
+    return false;
+
+  // synchronous copy, wait for the kernel
+  return cudaMemcpy(nodes, deviceNodes.data, nbFeatures * sizeof(int32_t), cudaMemcpyDeviceToHost) == cudaSuccess;
+}
+
+} // namespace cuda
+} // namespace voctree
+} // namespace aliceVision
@@ -0,0 +1,128 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aliceVision {
+namespace voctree {
+namespace cuda {
+
+/// Minimal number of features for which the GPU is faster than the CPU
+constexpr std::size_t MIN_NB_FEATURES = 2048;
+
+/**
+ * @brief Check if the nearest center search can run on the GPU.
+ * @param[in] dimension The number of elements of a feature
+ * @return true if a CUDA device is available and the dimension is supported
+ */
+bool supportNearestCenters(std::size_t dimension);
+
+/**
+ * @brief Float vectors stored on the current CUDA device
+ */
+class DeviceVectors
+{
+public:
+  DeviceVectors() = default;
+  ~DeviceVectors();
+
+  DeviceVectors(const DeviceVectors&) = delete;
+  DeviceVectors& operator=(const DeviceVectors&) = delete;
+
+  /**
+   * @brief Copy the vectors on the current CUDA device
+   * @param[in] data The count * dimension values (the layout is given by the functions using the vectors)
+   * @param[in] count The number of vectors
+   * @param[in] dimension The number of elements of a vector
+   * @return false if the device memory can't be allocated
+   */
+  bool upload(const float* data, int count, int dimension);
+
+  /// Release the device memory
+  void clear();
+
+  inline bool empty() const { return _data == nullptr; }
+  inline const float* data() const { return _data; }
+  inline int count() const { return _count; }
+  inline int dimension() const { return _dimension; }
+
+private:
+  float* _data = nullptr;
+  int _count = 0;
+  int _dimension = 0;
+};
+
+/**
+ * @brief Centers of a vocabulary tree stored on the current CUDA device
+ */
+class DeviceTree
+{
+public:
+  DeviceTree() = default;
+  ~DeviceTree();
+
+  DeviceTree(const DeviceTree&) = delete;
+  DeviceTree& operator=(const DeviceTree&) = delete;
+
+  /**
+   * @brief Copy the tree on the current CUDA device
+   * @param[in] centers The centers, stored center by center
+   * @param[in] validCenters The validity of each center
+   * @param[in] count The number of centers
+   * @param[in] dimension The number of elements of a center
+   * @param[in] splits The branching factor of the tree
+   * @param[in] levels The number of levels of the tree
+   * @return false if the device memory can't be allocated
+   */
+  bool upload(const float* centers, const uint8_t* validCenters, int count, int dimension, int splits, int levels);
+
+  /// Release the device memory
+  void clear();
+
+  inline bool empty() const { return _centers.empty(); }
+  inline const DeviceVectors& centers() const { return _centers; }
+  inline const uint8_t* validCenters() const { return _validCenters; }
+  inline int splits() const { return _splits; }
+  inline int levels() const { return _levels; }
+
+private:
+  DeviceVectors _centers;
+  uint8_t* _validCenters = nullptr;
+  int _splits = 0;
+  int _levels = 0;
+};
+
+/**
+ * @brief Find the nearest center of each feature on the GPU (squared L2 distance).
+ *
+ * The distances are accumulated in double, dimension after dimension and without fused
+ * multiply-add, so they are the same as the ones of the L2 functor on the CPU.
+ * @param[in] features The features, stored dimension by dimension (features[d * nbFeatures + i])
+ * @param[in] centers The centers, stored center by center, with the dimension of the features
+ * @param[out] nearest The index of the nearest center of each feature
+ * @param[out] distances The distance to the nearest center of each feature
+ * @return false if the computation can't run on the device
+ */
+bool nearestCenters(const DeviceVectors& features, const DeviceVectors& centers, int* nearest, double* distances);
+
+/**
+ * @brief Quantize features into visual words on the GPU (squared L2 distance).
+ *
+ * One thread descends the tree for one feature, the distances are the same as the ones
+ * of the L2 functor on the CPU (see nearestCenters).
+ * @param[in] features The features, stored dimension by dimension (features[d * nbFeatures + i])
+ * @param[in] tree The vocabulary tree, with the dimension of the features
+ * @param[out] nodes The index of the leaf node of each feature
+ * @return false if the computation can't run on the device
+ */
+bool quantize(const DeviceVectors& features, const DeviceTree& tree, int32_t* nodes);
+
+} // namespace cuda
+} // namespace voctree
+} // namespace aliceVision
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <aliceVision/feature/RegionsPerView.hpp>
 #include <aliceVision/voctree/Database.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
 
@@ -14,7 +15,7 @@
 
 namespace aliceVision {
 
-namespace sfm {
+namespace sfmData {
 class SfMData;
 }
 
@@ -38,6 +39,22 @@ std::size_t populateDatabase(const sfmData::SfMData& sfmData,
                              Database& db,
                              const int Nmax = 0);
 
+/**
+ * @brief Given a vocabulary tree, it builds a database from the SIFT descriptors of regions already in memory
+ *        (e.g. computed in the same process by sfm::extractRegionsPerView), instead of the descriptor files
+ *
+ * @param[in] regionsPerView The regions of each view, the views without SIFT regions are skipped
+ * @param[in] tree The vocabulary tree to be used for feature quantization
+ * @param[out] db The built database
+ * @param[in] Nmax The maximum number of descriptors used for each view. For Nmax = 0 (default), all the descriptors are used.
+ * @return the number of overall descriptors used
+ */
+template<class VocDescriptorT>
+std::size_t populateDatabase(const feature::RegionsPerView& regionsPerView,
+                             const VocabularyTree<VocDescriptorT>& tree,
+                             Database& db,
+                             const int Nmax = 0);
+
 /**
  * @brief Given an non empty database, it queries the database with a set of images
  * and their associated features and returns, for each image, the first \p numResults best
@@ -6,6 +6,7 @@
 
 #include "descriptorLoader.hpp"
 
+#include <aliceVision/feature/regionsFactory.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/config.hpp>
@@ -57,6 +58,52 @@ std::size_t populateDatabase(const sfmData::SfMData& sfmData,
     ++display;
   }
 
+  db.buildInvertedIndex();
+
+  // Return the result
+  return numDescriptors;
+}
+
+template<class VocDescriptorT>
+std::size_t populateDatabase(const feature::RegionsPerView& regionsPerView,
+                             const VocabularyTree<VocDescriptorT>& tree,
+                             Database& db,
+                             const int Nmax)
+{
+  std::size_t numDescriptors = 0;
+
+  for(const auto& viewRegions : regionsPerView.getData())
+  {
+    const auto regionsIt = viewRegions.second.find(feature::EImageDescriberType::SIFT);
+    if(regionsIt == viewRegions.second.end())
+      continue;
+
+    const feature::SIFT_Regions* regions = dynamic_cast<const feature::SIFT_Regions*>(regionsIt->second.get());
+    if(regions == nullptr)
+      continue;
+
+    const std::vector<feature::SIFT_Regions::DescriptorT>& descriptors = regions->Descriptors();
+
+    // same as the descriptor files: only the first Nmax descriptors
+    SparseHistogram newDoc;
+    if(Nmax != 0 && descriptors.size() > static_cast<std::size_t>(Nmax))
+    {
+      const std::vector<feature::SIFT_Regions::DescriptorT> firstDescriptors(descriptors.begin(), descriptors.begin() + Nmax);
+      newDoc = tree.quantizeToSparse(firstDescriptors);
+      numDescriptors += firstDescriptors.size();
+    }
+    else
+    {
+      newDoc = tree.quantizeToSparse(descriptors);
+      numDescriptors += descriptors.size();
+    }
+
+    // Insert document in database
+    db.insert(viewRegions.first, newDoc);
+  }
+
+  db.buildInvertedIndex();
+
   // Return the result
   return numDescriptors;
 }
@@ -99,6 +146,8 @@ std::size_t populateDatabase(const sfmData::SfMData& sfmData,
     ++display;
   }
 
+  db.buildInvertedIndex();
+
   // Return the result
   return numDescriptors;
 }
@@ -5,6 +5,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "descriptorLoader.hpp"
+#include <aliceVision/feature/regionsContainer.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/system/Logger.hpp>
 
@@ -15,6 +16,15 @@ namespace voctree {
 
 void getInfoBinFile(const std::string &path, int dim, std::size_t &numDescriptors, int &bytesPerElement)
 {
+  if(feature::isRegionsContainerFile(path))
+  {
+    // the regions container header gives the number of descriptors and their element size
+    const feature::RegionsContainerMapping mapping(path);
+    numDescriptors = mapping.header().count;
+    bytesPerElement = (numDescriptors > 0) ? mapping.header().descriptorBinSize : 0;
+    return;
+  }
+
   std::fstream fs;
 
   // the file is supposed to have the number of descriptors as first element and then
@@ -64,17 +74,28 @@ void getListOfDescriptorFiles(const sfmData::SfMData& sfmData, const std::vector
   if(sfmData.getViews().empty())
     throw std::runtime_error("Can't get list of descriptor files, no views found");
 
+  // the regions container of a view has priority over its legacy .desc file
+  const std::string basenameSuffix = "." + feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  const auto findDescriptorFile = [&](const std::string& featureFolder, IndexT viewId, std::string& filepath)
+  {
+    for(const std::string& extension : {".regions", ".desc"})
+    {
+      filepath = (bfs::path(featureFolder) / (std::to_string(viewId) + basenameSuffix + extension)).string();
+      if(bfs::exists(filepath))
+        return true;
+    }
+    return false;
+  };
+
   // explore the sfm_data container to get the files path
   for(const auto& view : sfmData.getViews())
   {
     bool found = false;
+    std::string filepath;
 
     for(const std::string& featureFolder : featuresFolders)
     {
-      // generate the equivalent .desc file path
-      const std::string filepath = bfs::path(bfs::path(featureFolder) / (std::to_string(view.first) + "." + feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT) + ".desc")).string();
-
-      if(bfs::exists(filepath))
+      if(findDescriptorFile(featureFolder, view.first, filepath))
       {
         descriptorsFiles[view.first] = filepath;
         found = true;
@@ -87,9 +108,7 @@ void getListOfDescriptorFiles(const sfmData::SfMData& sfmData, const std::vector
 
     for(const std::string& featureFolder : sfmData.getFeaturesFolders())
     {
-      const std::string filepath = bfs::path(bfs::path(featureFolder) / (std::to_string(view.first) + "." + feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT) + ".desc")).string();
-
-      if(bfs::exists(filepath))
+      if(findDescriptorFile(featureFolder, view.first, filepath))
       {
         descriptorsFiles[view.first] = filepath;
         found = true;
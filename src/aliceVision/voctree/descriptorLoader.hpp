@@ -17,10 +17,10 @@ namespace aliceVision {
 namespace voctree {
 
 /**
- * @brief Get the number of descriptors contained inside a .desc file and the number of bytes
- * used to store each descriptor elements
+ * @brief Get the number of descriptors contained inside a .desc file (or a .regions container)
+ * and the number of bytes used to store each descriptor elements
  *
- * @param[in] path The .desc filename
+ * @param[in] path The .desc or .regions filename
  * @param[in] dim The number of elements per descriptor
  * @param[out] numDescriptors The number of descriptors stored in the file
  * @param[out] bytesPerElement The number of bytes used to store each element of the descriptor
@@ -31,7 +31,8 @@ void getInfoBinFile(const std::string& path, int dim, std::size_t& numDescriptor
  * @brief Extract a list of decriptor files from a sfmData.
  * @param[in] sfmDataPath The input sfmData
  * @param[in] featuresFolders The folder(s) containing the descriptor files
- * @param[out] descriptorsFiles A list of descriptor files 
+ * @param[out] descriptorsFiles A list of descriptor files: the .regions container of each view
+ *             if available, its .desc file otherwise
  */
 void getListOfDescriptorFiles(const sfmData::SfMData& sfmData,
                               const std::vector<std::string>& featuresFolders,
@@ -41,9 +41,15 @@ std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
   {
     // if it is the first one read the number of descriptors and the type of data (we are assuming the the feat are all the same...)
     // bytesPerElement could be 0 even after the first element (eg it has 0 descriptors...), so do it until we get the correct info
-    if(bytesPerElement == 0)
+    // a regions container also stores the features: its header gives the number of descriptors
+    if(bytesPerElement == 0 || feature::isRegionsContainerFile(currentFile.second))
     {
-      getInfoBinFile(currentFile.second, DescriptorT::static_size, numDescriptors, bytesPerElement);
+      std::size_t fileNumDescriptors = 0;
+      int fileBytesPerElement = 0;
+      getInfoBinFile(currentFile.second, DescriptorT::static_size, fileNumDescriptors, fileBytesPerElement);
+      numDescriptors += fileNumDescriptors;
+      if(bytesPerElement == 0)
+        bytesPerElement = fileBytesPerElement;
     }
     else
     {
@@ -0,0 +1,71 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/config.hpp>
+
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CUDA)
+#include <aliceVision/voctree/cuda/nearestCenters.hpp>
+#endif
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace aliceVision {
+namespace voctree {
+namespace optim_cuda {
+
+/**
+ * @brief True if the elements of the feature type are exactly represented by float,
+ * so the distances computed on the GPU are the same as on the CPU.
+ */
+template<class T>
+struct IsCompatible : std::integral_constant<bool, std::is_same<typename T::value_type, float>::value ||
+                                                   std::is_same<typename T::value_type, unsigned char>::value>
+{};
+
+/**
+ * @brief Convert features to float, stored dimension by dimension (out[d * nbFeatures + i]).
+ * @param[in] nbFeatures The number of features
+ * @param[in] dimension The number of elements of a feature
+ * @param[in] getFeature Functor returning the feature of the given index
+ * @return the converted features
+ */
+template<class GetFeature>
+std::vector<float> toDimensionMajor(std::size_t nbFeatures, std::size_t dimension, GetFeature getFeature)
+{
+  std::vector<float> out(nbFeatures * dimension);
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+  {
+    const auto& feature = getFeature(i);
+    for(std::size_t d = 0; d < dimension; ++d)
+      out[d * nbFeatures + i] = static_cast<float>(feature[d]);
+  }
+  return out;
+}
+
+/**
+ * @brief Convert features to float, stored feature by feature (out[i * dimension + d]).
+ * @see toDimensionMajor
+ */
+template<class GetFeature>
+std::vector<float> toFeatureMajor(std::size_t nbFeatures, std::size_t dimension, GetFeature getFeature)
+{
+  std::vector<float> out(nbFeatures * dimension);
+  for(std::size_t i = 0; i < nbFeatures; ++i)
+  {
+    const auto& feature = getFeature(i);
+    for(std::size_t d = 0; d < dimension; ++d)
+      out[i * dimension + d] = static_cast<float>(feature[d]);
+  }
+  return out;
+}
+
+} // namespace optim_cuda
+} // namespace voctree
+} // namespace aliceVision
@@ -0,0 +1,74 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/Descriptor.hpp>
+#include <aliceVision/system/cpu.hpp>
+
+#include <cstddef>
+
+namespace aliceVision {
+namespace voctree {
+
+/// Raw data of a float descriptor, nullptr for the other feature types.
+template<class T>
+inline const float* getFloatData(const T&) { return nullptr; }
+template<std::size_t N>
+inline const float* getFloatData(const feature::Descriptor<float, N>& descriptor) { return descriptor.getData(); }
+
+} // namespace voctree
+} // namespace aliceVision
+
+// AVX2 distance kernels, selected at runtime (see system::use_avx2_kernels)
+#ifdef ALICEVISION_HAVE_AVX2
+#include <immintrin.h>
+
+namespace aliceVision {
+namespace voctree {
+namespace optim_avx2 {
+
+/**
+ * @brief Squared Euclidean distances between one descriptor and 4 float centers (AVX2).
+ *
+ * Each lane accumulates one center in double, dimension after dimension,
+ * so the results are the same as the ones of the generic L2 functor.
+ * @param[in] a the descriptor, already converted to double
+ * @param[in] b0 b1 b2 b3 the centers
+ * @param[in] size the number of dimensions, must be a multiple of 4
+ * @param[out] result the 4 distances
+ */
+ALICEVISION_AVX2_TARGET
+inline void l2x4_avx2(const double* a, const float* b0, const float* b1, const float* b2, const float* b3,
+                      std::size_t size, double* result)
+{
+  __m256d sum = _mm256_setzero_pd();
+  for(std::size_t i = 0; i < size; i += 4)
+  {
+    //-- Transpose 4 dimensions of the 4 centers
+    __m128 r0 = _mm_loadu_ps(b0 + i);
+    __m128 r1 = _mm_loadu_ps(b1 + i);
+    __m128 r2 = _mm_loadu_ps(b2 + i);
+    __m128 r3 = _mm_loadu_ps(b3 + i);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    //-- Accumulate in the order of the dimensions
+    __m256d diff = _mm256_sub_pd(_mm256_set1_pd(a[i]), _mm256_cvtps_pd(r0));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(diff, diff));
+    diff = _mm256_sub_pd(_mm256_set1_pd(a[i + 1]), _mm256_cvtps_pd(r1));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(diff, diff));
+    diff = _mm256_sub_pd(_mm256_set1_pd(a[i + 2]), _mm256_cvtps_pd(r2));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(diff, diff));
+    diff = _mm256_sub_pd(_mm256_set1_pd(a[i + 3]), _mm256_cvtps_pd(r3));
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(diff, diff));
+  }
+  _mm256_storeu_pd(result, sum);
+}
+
+} // namespace optim_avx2
+} // namespace voctree
+} // namespace aliceVision
+
+#endif // ALICEVISION_HAVE_AVX2
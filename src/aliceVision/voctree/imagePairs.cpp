@@ -0,0 +1,92 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "imagePairs.hpp"
+
+#include <algorithm>
+
+namespace aliceVision {
+namespace voctree {
+
+void convertAllMatchesToPairList(const PairList &allMatches, std::size_t numMatches, OrderedPairList &outPairList)
+{
+  outPairList.clear();
+
+  if(numMatches == 0)
+    numMatches = allMatches.size();  // disable image matching limit
+
+  for(const auto& match : allMatches)
+  {
+    ImageID currImageId = match.first;
+    OrderedListOfImageID bestMatches;
+
+    for(const ImageID currMatchId : match.second)
+    {
+      // avoid self-matching
+      if(currMatchId == currImageId)
+        continue;
+
+      // if the currMatchId ID is lower than the current image ID and
+      // the current image ID is not already in the list of currMatchId
+      //BOOST_ASSERT( ( currMatchId < currImageId ) && ( outPairList.find( currMatchId ) != outPairList.end() ) );
+      if(currMatchId < currImageId)
+      {
+        OrderedPairList::const_iterator currMatches = outPairList.find(currMatchId);
+        if(currMatches != outPairList.end() &&
+                currMatches->second.find(currImageId) == currMatches->second.end())
+        {
+          // then add it to the list
+          bestMatches.insert(currMatchId);
+        }
+      }
+      else
+      {
+        bestMatches.insert(currMatchId);
+      }
+
+      // stop if numMatches is satisfied
+      if(bestMatches.size() == numMatches)
+        break;
+    }
+
+    // fill the output if we have matches
+    if(!bestMatches.empty())
+      outPairList[currImageId] = bestMatches;
+  }
+}
+
+void getImagePairs(PairSet& pairs, const Database& db, std::size_t numImageQuery)
+{
+  // the queries are the documents of the database, each couple is scored once
+  std::map<DocId, DocMatches> allDocMatches;
+  db.findBatchSymmetric((numImageQuery == 0) ? db.size() : numImageQuery, allDocMatches);
+
+  PairList allMatches;
+  for(const auto& document : db.getSparseHistogramPerImage())
+  {
+    ListOfImageID& imgMatches = allMatches[document.first];
+
+    const auto docMatchesIt = allDocMatches.find(document.first);
+    if(docMatchesIt == allDocMatches.end())
+      continue;
+
+    imgMatches.reserve(docMatchesIt->second.size());
+    for(const DocMatch& m : docMatchesIt->second)
+      imgMatches.push_back(m.id);
+  }
+
+  OrderedPairList pairList;
+  convertAllMatchesToPairList(allMatches, numImageQuery, pairList);
+
+  for(const auto& imagePairs : pairList)
+  {
+    for(const ImageID imageId : imagePairs.second)
+      pairs.emplace(std::min<IndexT>(imagePairs.first, imageId), std::max<IndexT>(imagePairs.first, imageId));
+  }
+}
+
+} // namespace voctree
+} // namespace aliceVision
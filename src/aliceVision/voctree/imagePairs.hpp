@@ -0,0 +1,60 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/voctree/Database.hpp>
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace aliceVision {
+namespace voctree {
+
+typedef std::size_t ImageID;
+
+// just a list of doc id
+typedef std::vector<ImageID> ListOfImageID;
+
+// An ordered and unique list of doc id
+typedef std::set<ImageID> OrderedListOfImageID;
+
+// For each image ID it contains the  list of matching imagess
+typedef std::map<ImageID, ListOfImageID> PairList;
+
+// For each image ID it contains the ordered list of matching images
+typedef std::map<ImageID, OrderedListOfImageID> OrderedPairList;
+
+/**
+ * It processes a pairlist containing all the matching images for each image ID and return
+ * a similar list limited to a numMatches number of matching images and such that
+ * there is no repetitions: eg if the image 1 matches with 2 in the list of image 2
+ * there won't be the image 1
+ *
+ * @param[in] allMatches A pairlist containing all the matching images for each image of the dataset
+ * @param[in] numMatches The maximum number of matching images to consider for each image (if 0, consider all matches)
+ * @param[out] matches A processed version of allMatches that consider only the first numMatches without repetitions
+ */
+void convertAllMatchesToPairList(const PairList &allMatches, std::size_t numMatches, OrderedPairList &outPairList);
+
+/**
+ * @brief Select the image pairs to match with the documents of a database, as imageMatching does
+ *        with a vocabulary tree for the images of one SfMData (A_A mode), without reading or writing files.
+ *
+ * The database can be built from regions in memory with populateDatabase(regionsPerView, ...),
+ * the pairs can then be given to matchingImageCollection::computePairwiseMatches.
+ *
+ * @param[out] pairs The image pairs (smallest view id first)
+ * @param[in] db The database, with its word weights (loaded or computed with computeTfIdfWeights)
+ * @param[in] numImageQuery The number of best matching images kept for each image (if 0, consider all matches)
+ */
+void getImagePairs(PairSet& pairs, const Database& db, std::size_t numImageQuery);
+
+} // namespace voctree
+} // namespace aliceVision
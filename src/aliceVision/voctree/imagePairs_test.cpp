@@ -0,0 +1,84 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/imagePairs.hpp>
+
+#include <vector>
+
+#define BOOST_TEST_MODULE imagePairs
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::voctree;
+
+BOOST_AUTO_TEST_CASE(imagePairs_convertAllMatchesToPairList)
+{
+  PairList allMatches;
+  allMatches[0] = {0, 1, 2, 3};
+  allMatches[1] = {1, 0, 3, 2};
+  allMatches[2] = {2, 3, 0, 1};
+  allMatches[3] = {3, 2, 1, 0};
+
+  // all matches, each couple once
+  {
+    OrderedPairList pairList;
+    convertAllMatchesToPairList(allMatches, 0, pairList);
+
+    BOOST_CHECK_EQUAL(pairList.size(), 3);
+    BOOST_CHECK(pairList.at(0) == OrderedListOfImageID({1, 2, 3}));
+    BOOST_CHECK(pairList.at(1) == OrderedListOfImageID({2, 3}));
+    BOOST_CHECK(pairList.at(2) == OrderedListOfImageID({3}));
+  }
+
+  // the first match of each image, without the self-matches and the couples already listed
+  {
+    OrderedPairList pairList;
+    convertAllMatchesToPairList(allMatches, 1, pairList);
+
+    BOOST_CHECK_EQUAL(pairList.size(), 4);
+    BOOST_CHECK(pairList.at(0) == OrderedListOfImageID({1}));
+    BOOST_CHECK(pairList.at(1) == OrderedListOfImageID({3}));
+    BOOST_CHECK(pairList.at(2) == OrderedListOfImageID({3}));
+    BOOST_CHECK(pairList.at(3) == OrderedListOfImageID({0}));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(imagePairs_getImagePairs)
+{
+  // two groups of two documents with the same words
+  const std::vector<std::vector<Word>> documents = {
+    {0, 1, 2, 3, 4, 5, 6, 7},
+    {0, 1, 2, 3, 4, 5, 6, 8},
+    {10, 11, 12, 13, 14, 15, 16, 17},
+    {10, 11, 12, 13, 14, 15, 16, 18}};
+
+  Database db(19);
+  for(std::size_t i = 0; i < documents.size(); ++i)
+  {
+    SparseHistogram histo;
+    computeSparseHistogram(documents[i], histo);
+    db.insert(static_cast<DocId>(i), histo);
+  }
+  db.computeTfIdfWeights();
+
+  // the best match of each image is itself, then the other image of its group
+  {
+    PairSet pairs;
+    getImagePairs(pairs, db, 2);
+
+    BOOST_CHECK(pairs == PairSet({Pair(0, 1), Pair(2, 3)}));
+  }
+
+  // all the images with a common word
+  {
+    PairSet pairs;
+    getImagePairs(pairs, db, 0);
+
+    BOOST_CHECK(pairs.count(Pair(0, 1)));
+    BOOST_CHECK(pairs.count(Pair(2, 3)));
+  }
+}
@@ -6,6 +6,7 @@
 
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/voctree/SimpleKmeans.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
 
 #include <iostream>
 #include <fstream>
@@ -290,3 +291,69 @@ BOOST_AUTO_TEST_CASE(kmeanVarying)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(kmeanMiniBatch)
+{
+  using namespace aliceVision;
+  ALICEVISION_LOG_DEBUG("Testing mini-batch kmeans...");
+
+  const std::size_t DIMENSION = 128;
+  const std::size_t FEATURENUMBER = 1000;
+  const std::size_t K = 10;
+
+  typedef feature::Descriptor<float, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat> FeatureFloatVector;
+
+  // generate k clusters well far away
+  std::default_random_engine generator;
+  std::uniform_real_distribution<float> noise(-1.f, 1.f);
+  FeatureFloatVector features;
+  features.reserve(FEATURENUMBER * K);
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+    {
+      FeatureFloat f;
+      for(std::size_t d = 0; d < DIMENSION; ++d)
+        f[d] = noise(generator) + ((d % K == i) ? 20.f : 0.f);
+      features.push_back(f);
+    }
+  }
+
+  voctree::SimpleKmeans<FeatureFloat> kmeans(FeatureFloat(0));
+  kmeans.setVerbose(0);
+  kmeans.setRestarts(3);
+  kmeans.setMiniBatchSize(500);
+  BOOST_CHECK_EQUAL(kmeans.getMiniBatchSize(), 500);
+
+  FeatureFloatVector centers;
+  std::vector<unsigned int> membership;
+  const double sse = kmeans.cluster(features, K, centers, membership);
+
+  BOOST_CHECK(voctree::checkVectorElements(centers, "minibatch"));
+  BOOST_CHECK_EQUAL(membership.size(), features.size());
+
+  // each cluster is recovered
+  std::vector<std::size_t> h(K, 0);
+  for(std::size_t i = 0; i < membership.size(); ++i)
+  {
+    ++h[membership[i]];
+    BOOST_CHECK_EQUAL(membership[i], membership[(i / FEATURENUMBER) * FEATURENUMBER]);
+  }
+  for(std::size_t i = 0; i < h.size(); ++i)
+    BOOST_CHECK_EQUAL(h[i], FEATURENUMBER);
+
+  // the returned error is the one of the final assignment
+  voctree::L2<FeatureFloat, FeatureFloat> distance;
+  double expectedSse = 0.0;
+  for(std::size_t i = 0; i < features.size(); ++i)
+    expectedSse += distance(features[i], centers[membership[i]]);
+  BOOST_CHECK_CLOSE(sse, expectedSse, 1e-6);
+
+  // close to the error of Lloyd's algorithm
+  kmeans.setMiniBatchSize(0);
+  FeatureFloatVector lloydCenters;
+  std::vector<unsigned int> lloydMembership;
+  const double lloydSse = kmeans.cluster(features, K, lloydCenters, lloydMembership);
+  BOOST_CHECK_LT(sse, 1.05 * lloydSse);
+}
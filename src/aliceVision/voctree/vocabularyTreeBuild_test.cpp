@@ -9,6 +9,8 @@
 
 #include <Eigen/Core>
 
+#include <boost/filesystem.hpp>
+
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -21,7 +23,8 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
 {
   using namespace aliceVision;
 
-  const std::string treeName = "test.tree";
+  // written in the temporary folder, not in the working directory of the tests
+  const std::string treeName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.tree")).string();
 
   const std::size_t DIMENSION = 3;
   const std::size_t FEATURENUMBER = 100;
@@ -69,6 +72,7 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
 
   voctree::MutableVocabularyTree<FeatureFloat> loadedtree;
   loadedtree.load(treeName);
+  boost::filesystem::remove(treeName);
 
   // check the centers are the same
   FeatureFloatVector centerOrig = builder.tree().centers();
@@ -83,3 +87,67 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
   }
 //  voctree::printFeatVector( features ); 
 }
+
+BOOST_AUTO_TEST_CASE(voctreeBuilderStreaming)
+{
+  using namespace aliceVision;
+
+  const std::size_t DIMENSION = 3;
+  const std::size_t FEATURENUMBER = 100;
+  const std::size_t K = 4;
+  const std::size_t LEVELS = 3;
+  const std::size_t LEAVESNUMBER = std::pow(K, LEVELS);
+  const std::size_t STEP = 1;
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+  typedef voctree::TreeBuilder<FeatureFloat> Builder;
+
+  // generate well separated clusters, so the k-means converge to the same assignments
+  FeatureFloatVector features;
+  features.reserve(FEATURENUMBER * LEAVESNUMBER);
+  for(std::size_t i = 0; i < LEAVESNUMBER; ++i)
+  {
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+    {
+      features.push_back((0.1f * FeatureFloat::Random(1, DIMENSION) + Eigen::MatrixXf::Constant(1, DIMENSION, STEP * i) - Eigen::MatrixXf::Constant(1, DIMENSION, STEP * (LEAVESNUMBER - 1) / 2)) / ((STEP * (LEAVESNUMBER - 1) / 2) * sqrt(DIMENSION)));
+    }
+  }
+
+  // stream the features by chunks of 1000
+  const Builder::FeatureSource source = [&](const Builder::FeatureVisitor& visitor)
+  {
+    for(std::size_t begin = 0; begin < features.size(); begin += 1000)
+    {
+      const FeatureFloatVector chunk(features.begin() + begin, features.begin() + std::min(begin + 1000, features.size()));
+      visitor(chunk);
+    }
+  };
+
+  Builder builder(FeatureFloat::Zero());
+  builder.setVerbose(0);
+  builder.kmeans().setRestarts(3);
+
+  srand(0);
+  builder.build(features, K, LEVELS);
+  const FeatureFloatVector centers = builder.tree().centers();
+  const std::vector<uint8_t> validCenters = builder.tree().validCenters();
+
+  // all the features of each subset are kept: same tree
+  srand(0);
+  builder.buildStreaming(source, K, LEVELS, features.size() * LEAVESNUMBER / K);
+  BOOST_CHECK_EQUAL(builder.tree().centers().size(), centers.size());
+  BOOST_CHECK(builder.tree().validCenters() == validCenters);
+  voctree::L2<FeatureFloat, FeatureFloat> distance;
+  for(std::size_t i = 0; i < std::min(centers.size(), builder.tree().centers().size()); ++i)
+    BOOST_CHECK_SMALL(distance(builder.tree().centers()[i], centers[i]), 10e-8);
+
+  // few features per node: still a complete tree
+  builder.buildStreaming(source, K, LEVELS, 1000);
+  BOOST_CHECK_EQUAL(builder.tree().centers().size(), centers.size());
+  BOOST_CHECK(voctree::checkVectorElements(builder.tree().centers(), "streaming"));
+  std::size_t nbValid = 0;
+  for(uint8_t valid : builder.tree().validCenters())
+    nbValid += valid;
+  BOOST_CHECK_GT(nbValid, K);
+}
@@ -5,14 +5,18 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/MutableVocabularyTree.hpp>
+#include <aliceVision/feature/Descriptor.hpp>
 
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <random>
 
 #define BOOST_TEST_MODULE vocabularyTree
 #include <boost/test/included/unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
+#include <boost/filesystem.hpp>
 
 using namespace std;
 using namespace aliceVision::voctree;
@@ -57,3 +61,303 @@ BOOST_AUTO_TEST_CASE(database)
     BOOST_CHECK_SMALL(static_cast<double>(match[0].score), 0.001);
   }
 }
+
+BOOST_AUTO_TEST_CASE(database_invertedIndex)
+{
+  const uint32_t cardWords = 500;
+  const std::size_t cardDocuments = 200;
+
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<Word> wordDistribution(0, cardWords - 1);
+
+  // random documents with repeated words
+  std::vector<SparseHistogram> documents(cardDocuments);
+  for(std::size_t i = 0; i < cardDocuments; ++i)
+  {
+    std::vector<Word> words(20 + i % 30);
+    for(Word& word : words)
+      word = wordDistribution(generator);
+    computeSparseHistogram(words, documents[i]);
+  }
+
+  // database with the inverted index
+  Database db(cardWords);
+  for(std::size_t i = 0; i < cardDocuments; ++i)
+    db.insert(3 * i + 1, documents[i]);
+  db.computeTfIdfWeights();
+  BOOST_CHECK(db.hasInvertedIndex());
+
+  // database without the inverted index, with the same weights
+  const std::string weightsFile = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.weights")).string();
+  db.saveWeights(weightsFile);
+  Database dbReference;
+  dbReference.loadWeights(weightsFile);
+  boost::filesystem::remove(weightsFile);
+  for(std::size_t i = 0; i < cardDocuments; ++i)
+    dbReference.insert(3 * i + 1, documents[i]);
+  BOOST_CHECK(!dbReference.hasInvertedIndex());
+
+  for(const std::string distanceMethod : {"classic", "commonPoints", "strongCommonPoints", "inversedWeightedCommonPoints"})
+  {
+    for(std::size_t i = 0; i < cardDocuments; i += 7)
+    {
+      DocMatches matches;
+      DocMatches matchesReference;
+      db.find(documents[i], 10, matches, distanceMethod);
+      dbReference.find(documents[i], 10, matchesReference, distanceMethod);
+      BOOST_CHECK(matches == matchesReference);
+    }
+  }
+
+  // a new insertion is indexed
+  db.insert(0, documents[0]);
+  BOOST_CHECK(db.hasInvertedIndex());
+  DocMatches matches;
+  db.find(documents[0], 2, matches, "strongCommonPoints");
+  BOOST_CHECK_EQUAL(matches.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(database_findBatch)
+{
+  const uint32_t cardWords = 300;
+  const std::size_t cardDocuments = 150;
+
+  std::mt19937 generator(11);
+  std::uniform_int_distribution<Word> wordDistribution(0, cardWords - 1);
+
+  Database db(cardWords);
+  for(std::size_t i = 0; i < cardDocuments; ++i)
+  {
+    std::vector<Word> words(5 + i % 20);
+    for(Word& word : words)
+      word = wordDistribution(generator);
+    SparseHistogram document;
+    computeSparseHistogram(words, document);
+    db.insert(2 * i + 5, document);
+  }
+  db.computeTfIdfWeights();
+
+  for(const std::string distanceMethod : {"classic", "commonPoints", "strongCommonPoints", "inversedWeightedCommonPoints"})
+  {
+    // including more matches than documents sharing words with the query
+    for(std::size_t N : {1, 10, 100, 1000})
+    {
+      std::map<DocId, DocMatches> matches;
+      std::map<DocId, DocMatches> matchesSymmetric;
+      db.findBatch(db.getSparseHistogramPerImage(), N, matches, distanceMethod);
+      db.findBatchSymmetric(N, matchesSymmetric, distanceMethod);
+      BOOST_REQUIRE_EQUAL(matches.size(), cardDocuments);
+      BOOST_REQUIRE_EQUAL(matchesSymmetric.size(), cardDocuments);
+
+      for(const auto& document : db.getSparseHistogramPerImage())
+      {
+        DocMatches matchesReference;
+        db.find(document.second, N, matchesReference, distanceMethod);
+        BOOST_CHECK_EQUAL(matchesReference.size(), std::min(N, cardDocuments));
+        BOOST_CHECK(matches.at(document.first) == matchesReference);
+        BOOST_CHECK(matchesSymmetric.at(document.first) == matchesReference);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(database_incremental)
+{
+  const uint32_t cardWords = 200;
+  const std::size_t cardDocuments = 120;
+
+  std::mt19937 generator(5);
+  std::uniform_int_distribution<Word> wordDistribution(0, cardWords - 1);
+
+  std::vector<SparseHistogram> documents(cardDocuments);
+  for(std::size_t i = 0; i < cardDocuments; ++i)
+  {
+    std::vector<Word> words(10 + i % 15);
+    for(Word& word : words)
+      word = wordDistribution(generator);
+    computeSparseHistogram(words, documents[i]);
+  }
+
+  // database built at once
+  Database dbReference(cardWords);
+  for(std::size_t i = 0; i < cardDocuments; ++i)
+    dbReference.insert(i, documents[i]);
+  dbReference.computeTfIdfWeights();
+
+  // database built incrementally, saved and reloaded in the middle, the documents inserted in another order
+  const std::string databaseFile = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.db")).string();
+  {
+    Database db(cardWords);
+    for(std::size_t i = cardDocuments / 2; i < cardDocuments; ++i)
+      db.insert(i, documents[i]);
+    db.computeTfIdfWeights();
+    for(std::size_t i = 0; i < cardDocuments / 4; ++i)
+      db.insert(i, documents[i]);
+    db.save(databaseFile);
+  }
+  Database db;
+  db.load(databaseFile);
+  boost::filesystem::remove(databaseFile);
+  BOOST_CHECK_EQUAL(db.size(), cardDocuments / 2 + cardDocuments / 4);
+  BOOST_CHECK(db.hasInvertedIndex());
+  for(std::size_t i = cardDocuments / 4; i < cardDocuments / 2; ++i)
+    db.insert(i, documents[i]);
+  BOOST_CHECK(db.hasInvertedIndex());
+  BOOST_CHECK(db.getSparseHistogramPerImage() == dbReference.getSparseHistogramPerImage());
+
+  // the weights follow the insertions
+  for(Word word = 0; word < static_cast<Word>(cardWords); ++word)
+    BOOST_CHECK_EQUAL(db.getWordWeight(word), dbReference.getWordWeight(word));
+
+  for(const std::string distanceMethod : {"classic", "commonPoints", "strongCommonPoints", "inversedWeightedCommonPoints"})
+  {
+    std::map<DocId, DocMatches> matches;
+    std::map<DocId, DocMatches> matchesReference;
+    db.findBatchSymmetric(20, matches, distanceMethod);
+    dbReference.findBatchSymmetric(20, matchesReference, distanceMethod);
+    BOOST_CHECK(matches == matchesReference);
+
+    for(std::size_t i = 0; i < cardDocuments; i += 9)
+    {
+      DocMatches m;
+      DocMatches mReference;
+      db.find(documents[i], 20, m, distanceMethod);
+      dbReference.find(documents[i], 20, mReference, distanceMethod);
+      BOOST_CHECK(m == mReference);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(quantizeBatch)
+{
+  typedef aliceVision::feature::Descriptor<float, 128> CenterT;
+  typedef aliceVision::feature::Descriptor<unsigned char, 128> DescriptorUChar;
+
+  const uint32_t levels = 3;
+  const uint32_t splits = 10;
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> distribution(0.f, 255.f);
+
+  // random tree
+  MutableVocabularyTree<CenterT> tree;
+  tree.setSize(levels, splits);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters().resize(tree.nodes(), 1);
+  for(CenterT& center : tree.centers())
+    for(std::size_t d = 0; d < CenterT::static_size; ++d)
+      center[d] = distribution(generator);
+
+  for(uint32_t node = 0; node < tree.nodes(); node += splits)
+  {
+    // nodes with fewer than splits() children
+    if((node / splits) % 3 == 1)
+      std::fill(tree.validCenters().begin() + node + 7, tree.validCenters().begin() + node + splits, 0);
+    // equidistant children
+    if((node / splits) % 4 == 2)
+      tree.centers()[node + 5] = tree.centers()[node + 2];
+  }
+
+  // random descriptors, some of them on the centers
+  std::vector<DescriptorUChar> descriptorsUChar(1000);
+  std::vector<CenterT> descriptorsFloat(descriptorsUChar.size());
+  for(std::size_t i = 0; i < descriptorsUChar.size(); ++i)
+  {
+    for(std::size_t d = 0; d < CenterT::static_size; ++d)
+    {
+      descriptorsUChar[i][d] = static_cast<unsigned char>(distribution(generator));
+      descriptorsFloat[i][d] = distribution(generator);
+    }
+    if(i % 10 == 0)
+      descriptorsFloat[i] = tree.centers()[i % tree.nodes()];
+  }
+
+  // the batched quantization gives the same words as the per descriptor quantization,
+  // whatever the block size
+  for(std::size_t blockSize : {1, 7, 256})
+  {
+    const std::vector<Word> wordsUChar = tree.quantizeBatch(descriptorsUChar, blockSize);
+    const std::vector<Word> wordsFloat = tree.quantizeBatch(descriptorsFloat, blockSize);
+    BOOST_REQUIRE_EQUAL(wordsUChar.size(), descriptorsUChar.size());
+    BOOST_REQUIRE_EQUAL(wordsFloat.size(), descriptorsFloat.size());
+    for(std::size_t i = 0; i < descriptorsUChar.size(); ++i)
+    {
+      BOOST_CHECK_EQUAL(wordsUChar[i], tree.quantize(descriptorsUChar[i]));
+      BOOST_CHECK_EQUAL(wordsFloat[i], tree.quantize(descriptorsFloat[i]));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(sparseDistance_weightedStrongCommonPoints)
+{
+  const std::vector<float> weights = {0.5f, 1.f, 2.f, 4.f, 8.f, 16.f, 32.f};
+
+  // no common word: the words only in one histogram don't count
+  SparseHistogram v1 = {{1, {0}}, {3, {1}}};
+  SparseHistogram v2 = {{2, {0}}, {4, {1}}, {6, {2}}};
+  BOOST_CHECK_EQUAL(sparseDistance(v1, v2, "weightedStrongCommonPoints", weights), 0.f);
+  BOOST_CHECK_EQUAL(sparseDistance(v2, v1, "weightedStrongCommonPoints", weights), 0.f);
+
+  // the words seen once in both histograms count with their weight
+  v1[4] = {2};
+  v1[5] = {3, 4};
+  v2[5] = {3};
+  BOOST_CHECK_EQUAL(sparseDistance(v1, v2, "weightedStrongCommonPoints", weights), -weights[4]);
+  BOOST_CHECK_EQUAL(sparseDistance(v1, v2, "strongCommonPoints", weights), -1.f);
+}
+
+BOOST_AUTO_TEST_CASE(loadMapped)
+{
+  typedef aliceVision::feature::Descriptor<float, 128> CenterT;
+
+  std::mt19937 generator(3);
+  std::uniform_real_distribution<float> distribution(0.f, 255.f);
+
+  MutableVocabularyTree<CenterT> tree;
+  tree.setSize(2, 8);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters().resize(tree.nodes(), 1);
+  for(CenterT& center : tree.centers())
+    for(std::size_t d = 0; d < CenterT::static_size; ++d)
+      center[d] = distribution(generator);
+  std::fill(tree.validCenters().begin() + 8 + 5, tree.validCenters().begin() + 8 + 8, 0);
+
+  const std::string treeFile = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.tree")).string();
+  tree.save(treeFile);
+
+  VocabularyTree<CenterT> loadedTree(treeFile);
+  VocabularyTree<CenterT> mappedTree;
+  mappedTree.loadMapped(treeFile);
+
+  BOOST_CHECK(!loadedTree.isMapped());
+  BOOST_CHECK(mappedTree.isMapped());
+  BOOST_CHECK_EQUAL(mappedTree.levels(), 2);
+  BOOST_CHECK_EQUAL(mappedTree.splits(), 8);
+  BOOST_CHECK_EQUAL(mappedTree.words(), 64);
+  BOOST_CHECK(mappedTree == loadedTree);
+
+  std::vector<CenterT> descriptors(100);
+  for(CenterT& descriptor : descriptors)
+    for(std::size_t d = 0; d < CenterT::static_size; ++d)
+      descriptor[d] = distribution(generator);
+  BOOST_CHECK(mappedTree.quantize(descriptors) == loadedTree.quantize(descriptors));
+
+  // a mapped tree can be saved
+  const std::string savedFile = treeFile + ".saved";
+  mappedTree.save(savedFile);
+  VocabularyTree<CenterT> reloadedTree(savedFile);
+  BOOST_CHECK(reloadedTree == loadedTree);
+
+  // the copies share the mapping
+  VocabularyTree<CenterT> copiedTree(mappedTree);
+  mappedTree.clear();
+  BOOST_CHECK(copiedTree.isMapped());
+  BOOST_CHECK(copiedTree == loadedTree);
+
+  boost::filesystem::remove(savedFile);
+  copiedTree.clear();
+  boost::filesystem::remove(treeFile);
+
+  // invalid file
+  BOOST_CHECK_THROW(mappedTree.loadMapped(treeFile), std::runtime_error);
+}
@@ -0,0 +1,405 @@
+#!/usr/bin/env python3
+# This file is part of the AliceVision project.
+# Copyright (c) 2019 AliceVision contributors.
+# This Source Code Form is subject to the terms of the Mozilla Public License,
+# v. 2.0. If a copy of the MPL was not distributed with this file,
+# You can obtain one at https://mozilla.org/MPL/2.0/.
+
+"""
+Run the photogrammetry pipeline (cameraInit to texturing) on reference datasets,
+record the wall time, CPU time, peak memory, GPU usage and I/O volume of each stage,
+and compare them to a stored baseline.
+
+Each stage runs with ALICEVISION_MEMORY_REPORT and ALICEVISION_PROFILER_TRACE set,
+so the software using the memory tracker and the profiler also write their reports
+(peak RSS and GPU memory per stage, Chrome trace of the profiled scopes).
+
+Usage:
+  pipelineBenchmark.py --bin <aliceVision binaries folder> --output <work folder> [--baseline baseline.json]
+"""
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import threading
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+# metrics compared to the baseline: name, minimal absolute difference reported as a regression
+COMPARED_METRICS = [
+    ("wallTime", 1.0),                      # seconds
+    ("cpuTime", 1.0),                       # seconds
+    ("peakRss", 32 * 1024 * 1024),          # bytes
+    ("peakGpu", 32 * 1024 * 1024),          # bytes
+    ("ioReadBytes", 16 * 1024 * 1024),      # bytes
+    ("ioWriteBytes", 16 * 1024 * 1024),     # bytes
+]
+
+
+def pipelineStages(dataset, folder, sensorDatabase):
+    """
+    The stages of the pipeline (as the default Meshroom graph), each one with its software and arguments.
+    The dense stages need a CUDA device: they are skipped with --noGpu.
+    """
+    def path(*names):
+        return os.path.join(folder, *names)
+
+    cameraInitArgs = ["--imageFolder", dataset["imagesFolder"],
+                      "--sensorDatabase", sensorDatabase,
+                      "--output", path("cameraInit.sfm")]
+    if "focalLengthPix" in dataset:
+        cameraInitArgs += ["--defaultFocalLengthPix", str(dataset["focalLengthPix"])]
+
+    return [
+        {"name": "cameraInit", "software": "aliceVision_cameraInit", "args": cameraInitArgs},
+        {"name": "featureExtraction", "software": "aliceVision_featureExtraction",
+         "args": ["--input", path("cameraInit.sfm"), "--output", path("features")],
+         "folders": ["features"]},
+        {"name": "imageMatching", "software": "aliceVision_imageMatching",
+         "args": ["--input", path("cameraInit.sfm"), "--featuresFolders", path("features"),
+                  "--output", path("imageMatches.txt")]},
+        {"name": "featureMatching", "software": "aliceVision_featureMatching",
+         "args": ["--input", path("cameraInit.sfm"), "--featuresFolders", path("features"),
+                  "--imagePairsList", path("imageMatches.txt"), "--output", path("matches")],
+         "folders": ["matches"]},
+        {"name": "incrementalSfM", "software": "aliceVision_incrementalSfM",
+         "args": ["--input", path("cameraInit.sfm"), "--featuresFolders", path("features"),
+                  "--matchesFolders", path("matches"), "--output", path("sfm.abc"),
+                  "--extraInfoFolder", path("sfm")],
+         "folders": ["sfm"]},
+        {"name": "prepareDenseScene", "software": "aliceVision_prepareDenseScene",
+         "args": ["--input", path("sfm.abc"), "--output", path("prepareDenseScene")],
+         "folders": ["prepareDenseScene"]},
+        {"name": "depthMapEstimation", "software": "aliceVision_depthMapEstimation", "gpu": True,
+         "args": ["--input", path("sfm.abc"), "--imagesFolder", path("prepareDenseScene"),
+                  "--output", path("depthMap")],
+         "folders": ["depthMap"]},
+        {"name": "depthMapFiltering", "software": "aliceVision_depthMapFiltering", "gpu": True,
+         "args": ["--input", path("sfm.abc"), "--depthMapsFolder", path("depthMap"),
+                  "--output", path("depthMapFilter")],
+         "folders": ["depthMapFilter"]},
+        {"name": "meshing", "software": "aliceVision_meshing", "gpu": True,
+         "args": ["--input", path("sfm.abc"), "--depthMapsFolder", path("depthMapFilter"),
+                  "--output", path("densePointCloud.abc"), "--outputMesh", path("mesh.obj")]},
+        {"name": "meshFiltering", "software": "aliceVision_meshFiltering", "gpu": True,
+         "args": ["--inputMesh", path("mesh.obj"), "--outputMesh", path("meshFiltered.obj")]},
+        {"name": "texturing", "software": "aliceVision_texturing", "gpu": True,
+         "args": ["--input", path("densePointCloud.abc"), "--inputMesh", path("meshFiltered.obj"),
+                  "--imagesFolder", path("prepareDenseScene"), "--output", path("texturing")],
+         "folders": ["texturing"]},
+    ]
+
+
+def findSoftware(binFolder, name):
+    """ Get the path of a software in the binaries folder, or in the PATH """
+    for candidate in (name, name + ".exe"):
+        if binFolder:
+            candidatePath = os.path.join(binFolder, candidate)
+            if os.path.isfile(candidatePath) and os.access(candidatePath, os.X_OK):
+                return candidatePath
+    return shutil.which(name)
+
+
+class ProcessSampler(threading.Thread):
+    """
+    Sample a running process: its logical I/O (/proc/<pid>/io, Linux only)
+    and the utilization of the GPUs (nvidia-smi, if available).
+    """
+
+    def __init__(self, pid, period):
+        super().__init__(daemon=True)
+        self.pid = pid
+        self.period = period
+        self.stopEvent = threading.Event()
+        self.readChars = 0
+        self.writeChars = 0
+        self.gpuUtilization = []
+        self.nvidiaSmi = shutil.which("nvidia-smi")
+
+    def sampleIo(self):
+        try:
+            with open("/proc/{}/io".format(self.pid)) as ioFile:
+                for line in ioFile:
+                    key, value = line.split(":")
+                    if key == "rchar":
+                        self.readChars = int(value)
+                    elif key == "wchar":
+                        self.writeChars = int(value)
+        except (OSError, ValueError):
+            pass
+
+    def sampleGpu(self):
+        if not self.nvidiaSmi:
+            return
+        try:
+            output = subprocess.check_output([self.nvidiaSmi, "--query-gpu=utilization.gpu", "--format=csv,noheader,nounits"],
+                                             stderr=subprocess.DEVNULL, timeout=5)
+            values = [float(v) for v in output.decode().split()]
+            if values:
+                self.gpuUtilization.append(max(values))
+        except (OSError, ValueError, subprocess.SubprocessError):
+            self.nvidiaSmi = None
+
+    def run(self):
+        while not self.stopEvent.wait(self.period):
+            self.sampleIo()
+            self.sampleGpu()
+
+    def stop(self):
+        self.stopEvent.set()
+        self.join()
+
+
+def readJson(path):
+    try:
+        with open(path) as jsonFile:
+            return json.load(jsonFile)
+    except (OSError, ValueError):
+        return None
+
+
+def runStage(stage, softwarePath, folder, logFile, samplingPeriod):
+    """ Run a stage and measure it, returns its metrics """
+    memoryReportPath = os.path.join(folder, "reports", stage["name"] + "_memory.json")
+    tracePath = os.path.join(folder, "reports", stage["name"] + "_trace.json")
+    for reportPath in (memoryReportPath, tracePath):
+        if os.path.exists(reportPath):
+            os.remove(reportPath)
+    for subFolder in stage.get("folders", []):
+        os.makedirs(os.path.join(folder, subFolder), exist_ok=True)
+
+    env = dict(os.environ)
+    env["ALICEVISION_MEMORY_REPORT"] = memoryReportPath
+    env["ALICEVISION_PROFILER_TRACE"] = tracePath
+
+    logFile.write("\n===== {}: {}\n".format(stage["name"], " ".join([softwarePath] + stage["args"])))
+    logFile.flush()
+
+    start = time.monotonic()
+    process = subprocess.Popen([softwarePath] + stage["args"], stdout=logFile, stderr=subprocess.STDOUT, env=env)
+    sampler = ProcessSampler(process.pid, samplingPeriod)
+    sampler.start()
+
+    if hasattr(os, "wait4"):
+        _, status, usage = os.wait4(process.pid, 0)
+        process.returncode = os.waitstatus_to_exitcode(status) if hasattr(os, "waitstatus_to_exitcode") else (status >> 8)
+    else:
+        process.wait()
+        usage = None
+    wallTime = time.monotonic() - start
+    sampler.stop()
+
+    metrics = {"exitCode": process.returncode, "wallTime": wallTime}
+    if usage is not None:
+        cpuTime = usage.ru_utime + usage.ru_stime
+        metrics["cpuTime"] = cpuTime
+        metrics["cpuUtilization"] = cpuTime / wallTime if wallTime > 0 else 0.0
+        # ru_maxrss is in kilobytes on Linux, in bytes on macOS
+        metrics["peakRss"] = usage.ru_maxrss * (1 if sys.platform == "darwin" else 1024)
+        # block I/O, in 512 bytes units
+        metrics["ioReadBytes"] = usage.ru_inblock * 512
+        metrics["ioWriteBytes"] = usage.ru_oublock * 512
+    if sampler.readChars or sampler.writeChars:
+        metrics["readChars"] = sampler.readChars
+        metrics["writeChars"] = sampler.writeChars
+    if sampler.gpuUtilization:
+        metrics["gpuUtilizationMean"] = sum(sampler.gpuUtilization) / len(sampler.gpuUtilization)
+        metrics["gpuUtilizationMax"] = max(sampler.gpuUtilization)
+
+    memoryReport = readJson(memoryReportPath)
+    if memoryReport:
+        metrics["peakRss"] = max(metrics.get("peakRss", 0), memoryReport.get("peakRss", 0))
+        metrics["peakGpu"] = memoryReport.get("peakGpu", 0)
+        metrics["memoryReport"] = memoryReportPath
+    if os.path.exists(tracePath):
+        metrics["profilerTrace"] = tracePath
+
+    return metrics
+
+
+def prepareDataset(dataset, binFolder, datasetsFolder):
+    """ Get the images of a dataset: rendered, cloned or local, returns the images folder """
+    datasetFolder = os.path.join(datasetsFolder, dataset["name"])
+    kind = dataset["type"]
+
+    if kind == "synthetic":
+        imagesFolder = os.path.join(datasetFolder, "images")
+        if not os.path.isdir(imagesFolder) or not os.listdir(imagesFolder):
+            software = findSoftware(binFolder, "aliceVision_utils_syntheticDataset")
+            if not software:
+                raise RuntimeError("aliceVision_utils_syntheticDataset not found")
+            options = dataset.get("options", {})
+            args = [software, "--output", imagesFolder, "--outputSfMData", os.path.join(datasetFolder, "groundTruth.sfm")]
+            for key in ("nbViews", "arcAngle", "width", "height"):
+                if key in options:
+                    args += ["--" + key, str(options[key])]
+            subprocess.check_call(args)
+        return imagesFolder
+
+    if kind == "git":
+        if not os.path.isdir(datasetFolder):
+            subprocess.check_call(["git", "clone", "--depth", "1", dataset["url"], datasetFolder])
+        return os.path.join(datasetFolder, dataset.get("imagesSubfolder", ""))
+
+    if kind == "folder":
+        return dataset["path"]
+
+    raise RuntimeError("Unknown dataset type: " + kind)
+
+
+def benchmarkDataset(dataset, args):
+    """ Run the pipeline on a dataset, returns the metrics of its stages """
+    folder = os.path.join(args.output, "runs", dataset["name"])
+    if os.path.isdir(folder):
+        shutil.rmtree(folder)
+    os.makedirs(os.path.join(folder, "reports"))
+
+    dataset = dict(dataset)
+    dataset["imagesFolder"] = prepareDataset(dataset, args.bin, os.path.join(args.output, "datasets"))
+    if dataset["type"] == "synthetic" and "focalLengthPix" not in dataset:
+        # the synthetic images have no metadata, their focal length in pixels is their width
+        dataset["focalLengthPix"] = dataset.get("options", {}).get("width", 1600)
+
+    results = {"stages": {}}
+    with open(os.path.join(folder, "pipeline.log"), "w") as logFile:
+        for stage in pipelineStages(dataset, folder, args.sensorDatabase):
+            if args.stages and stage["name"] not in args.stages:
+                continue
+            if stage.get("gpu") and args.noGpu:
+                print("  {:<20} skipped (--noGpu)".format(stage["name"]))
+                continue
+            softwarePath = findSoftware(args.bin, stage["software"])
+            if not softwarePath:
+                print("  {:<20} skipped ({} not found)".format(stage["name"], stage["software"]))
+                break
+
+            metrics = runStage(stage, softwarePath, folder, logFile, args.samplingPeriod)
+            results["stages"][stage["name"]] = metrics
+            print("  {:<20} {:8.1f} s  {:6.1f} cores  {:8.1f} MB".format(
+                stage["name"], metrics["wallTime"], metrics.get("cpuUtilization", 0.0), metrics.get("peakRss", 0) / 1048576.0))
+            if metrics["exitCode"] != 0:
+                print("  {} failed (exit code {}), see {}".format(stage["name"], metrics["exitCode"], logFile.name))
+                results["failed"] = stage["name"]
+                break
+
+    total = {}
+    for metrics in results["stages"].values():
+        for key in ("wallTime", "cpuTime", "ioReadBytes", "ioWriteBytes"):
+            if key in metrics:
+                total[key] = total.get(key, 0) + metrics[key]
+        for key in ("peakRss", "peakGpu"):
+            if key in metrics:
+                total[key] = max(total.get(key, 0), metrics[key])
+    results["total"] = total
+    return results
+
+
+def compareToBaseline(results, baseline, tolerance):
+    """ Print the relative difference of each metric, returns the list of regressions """
+    regressions = []
+    for datasetName, datasetResults in results["datasets"].items():
+        baselineDataset = baseline.get("datasets", {}).get(datasetName)
+        if not baselineDataset:
+            print("{}: no baseline".format(datasetName))
+            continue
+        print("{}:".format(datasetName))
+        baselineStages = baselineDataset.get("stages", {})
+        entries = [(name, metrics, baselineStages.get(name)) for name, metrics in datasetResults["stages"].items()]
+        missingStages = [name for name in baselineStages if name not in datasetResults["stages"]]
+        for name in missingStages:
+            print("  {:<20} not run (in the baseline)".format(name))
+        # the totals are comparable if the same stages have run
+        if not missingStages and all(name in baselineStages for name in datasetResults["stages"]):
+            entries.append(("total", datasetResults["total"], baselineDataset.get("total")))
+        for name, metrics, baselineMetrics in entries:
+            if not baselineMetrics:
+                continue
+            differences = []
+            for metric, minDifference in COMPARED_METRICS:
+                if metric not in metrics or not baselineMetrics.get(metric):
+                    continue
+                value = metrics[metric]
+                reference = baselineMetrics[metric]
+                ratio = value / reference - 1.0
+                regression = ratio > tolerance and (value - reference) > minDifference
+                differences.append("{} {:+.1%}{}".format(metric, ratio, " (regression)" if regression else ""))
+                if regression:
+                    regressions.append("{}/{}/{}: {} -> {} ({:+.1%})".format(datasetName, name, metric, reference, value, ratio))
+            print("  {:<20} {}".format(name, ", ".join(differences)))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bin", default="", help="Folder of the aliceVision software (the PATH is used otherwise).")
+    parser.add_argument("--output", required=True, help="Work folder: datasets, runs, reports and results.")
+    parser.add_argument("--datasets", default=os.path.join(SCRIPT_DIR, "datasets.json"), help="Datasets description file.")
+    parser.add_argument("--dataset", action="append", default=[], help="Only benchmark this dataset (can be repeated).")
+    parser.add_argument("--stages", nargs="*", default=[], help="Only run these stages (their inputs must exist).")
+    parser.add_argument("--sensorDatabase", default=os.path.join(SCRIPT_DIR, "..", "aliceVision", "sensorDB", "cameraSensors.db"),
+                        help="Camera sensors database of cameraInit.")
+    parser.add_argument("--noGpu", action="store_true", help="Skip the dense stages, they need a CUDA device.")
+    parser.add_argument("--samplingPeriod", type=float, default=0.5, help="Period of the I/O and GPU samples (in seconds).")
+    parser.add_argument("--baseline", default="", help="Baseline results file to compare with.")
+    parser.add_argument("--tolerance", type=float, default=0.1, help="Relative increase of a metric reported as a regression.")
+    parser.add_argument("--saveBaseline", default="", help="Save the results as a baseline file.")
+    args = parser.parse_args()
+
+    datasetsDescription = readJson(args.datasets)
+    if datasetsDescription is None:
+        print("Cannot read the datasets description: " + args.datasets)
+        return 1
+    # the datasets given on the command line, the default datasets otherwise
+    if args.dataset:
+        datasets = [d for d in datasetsDescription["datasets"] if d["name"] in args.dataset]
+    else:
+        datasets = [d for d in datasetsDescription["datasets"] if d.get("default", True)]
+
+    results = {
+        "machine": {"platform": platform.platform(), "processor": platform.processor(), "cpus": os.cpu_count()},
+        "date": time.strftime("%Y-%m-%dT%H:%M:%S"),
+        "datasets": {},
+    }
+    failed = False
+    for dataset in datasets:
+        print("Dataset {}".format(dataset["name"]))
+        try:
+            results["datasets"][dataset["name"]] = benchmarkDataset(dataset, args)
+        except (RuntimeError, OSError, subprocess.CalledProcessError) as error:
+            print("  cannot benchmark {}: {}".format(dataset["name"], error))
+            failed = True
+            continue
+        failed = failed or "failed" in results["datasets"][dataset["name"]]
+
+    os.makedirs(args.output, exist_ok=True)
+    resultsPath = os.path.join(args.output, "results.json")
+    with open(resultsPath, "w") as resultsFile:
+        json.dump(results, resultsFile, indent=2, sort_keys=True)
+    print("Results written to " + resultsPath)
+
+    if args.saveBaseline:
+        shutil.copyfile(resultsPath, args.saveBaseline)
+        print("Baseline written to " + args.saveBaseline)
+
+    if args.baseline:
+        baseline = readJson(args.baseline)
+        if baseline is None:
+            print("Cannot read the baseline: " + args.baseline)
+            return 1
+        regressions = compareToBaseline(results, baseline, args.tolerance)
+        if regressions:
+            print("Performance regressions (tolerance {:.0%}):".format(args.tolerance))
+            for regression in regressions:
+                print("  " + regression)
+            return 1
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
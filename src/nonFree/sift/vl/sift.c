@@ -672,6 +672,7 @@ Gaussian window size is set to have standard deviation
 #include "sift.h"
 #include "imopv.h"
 #include "mathop.h"
+#include "sift_avx2.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -816,6 +817,23 @@ _vl_sift_smooth (VlSiftFilt * self,
     return ;
   }
 
+#ifndef VL_DISABLE_AVX2
+  if (self->avx2Enabled) {
+    _vl_imconvcol_vf_avx2 (tempImage, height,
+                           inputImage, width, height, width,
+                           self->gaussFilter,
+                           - self->gaussFilterWidth, self->gaussFilterWidth,
+                           1, VL_PAD_BY_CONTINUITY | VL_TRANSPOSE) ;
+
+    _vl_imconvcol_vf_avx2 (outputImage, width,
+                           tempImage, height, width, height,
+                           self->gaussFilter,
+                           - self->gaussFilterWidth, self->gaussFilterWidth,
+                           1, VL_PAD_BY_CONTINUITY | VL_TRANSPOSE) ;
+    return ;
+  }
+#endif
+
   vl_imconvcol_vf (tempImage, height,
                    inputImage, width, height, width,
                    self->gaussFilter,
@@ -941,6 +959,8 @@ vl_sift_new (int width, int height,
 
   f-> grad_o  = o_min - 1 ;
 
+  f-> avx2Enabled = VL_FALSE ;
+
   /* initialize fast_expn stuff */
   fast_expn_init () ;
 
@@ -1124,6 +1144,11 @@ vl_sift_process_next_octave (VlSiftFilt *f)
   octave = vl_sift_get_octave        (f, s_min) ;
 
   /* next octave */
+#ifndef VL_DISABLE_AVX2
+  if (f->avx2Enabled) {
+    _vl_sift_downsample_avx2 (octave, pt, w, h) ;
+  } else
+#endif
   copy_and_downsample (octave, pt, w, h, 1) ;
 
   f-> o_cur            += 1 ;
@@ -1193,6 +1218,13 @@ vl_sift_detect (VlSiftFilt * f)
     vl_sift_pix* src_a = vl_sift_get_octave (f, s    ) ;
     vl_sift_pix* src_b = vl_sift_get_octave (f, s + 1) ;
     vl_sift_pix* end_a = src_a + w * h ;
+#ifndef VL_DISABLE_AVX2
+    if (f->avx2Enabled) {
+      _vl_sift_dog_avx2 (pt, src_a, src_b, w * h) ;
+      pt += w * h ;
+      continue ;
+    }
+#endif
     while (src_a != end_a) {
       *pt++ = *src_b++ - *src_a++ ;
     }
@@ -1483,6 +1515,13 @@ vl_sift_update_gradient (VlSiftFilt *f)
     src  = vl_sift_get_octave (f,s) ;
     grad = f->grad + 2 * so * (s - s_min -1) ;
 
+#ifndef VL_DISABLE_AVX2
+    if (f->avx2Enabled) {
+      _vl_sift_gradient_avx2 (grad, src, w, h) ;
+      continue ;
+    }
+#endif
+
     /* first pixel of the first row */
     gx = src[+xo] - src[0] ;
     gy = src[+yo] - src[0] ;
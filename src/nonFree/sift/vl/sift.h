@@ -86,6 +86,8 @@ typedef struct _VlSiftFilt
   vl_sift_pix *grad ;   /**< GSS gradient data. */
   int grad_o ;          /**< GSS gradient data octave. */
 
+  vl_bool avx2Enabled ; /**< use the AVX2 scale space code. */
+
 } VlSiftFilt ;
 
 /** @name Create and destroy
@@ -158,6 +160,7 @@ VL_INLINE double vl_sift_get_edge_thresh    (VlSiftFilt const *f) ;
 VL_INLINE double vl_sift_get_norm_thresh    (VlSiftFilt const *f) ;
 VL_INLINE double vl_sift_get_magnif         (VlSiftFilt const *f) ;
 VL_INLINE double vl_sift_get_window_size    (VlSiftFilt const *f) ;
+VL_INLINE vl_bool vl_sift_get_avx2_enabled  (VlSiftFilt const *f) ;
 
 VL_INLINE vl_sift_pix *vl_sift_get_octave  (VlSiftFilt const *f, int s) ;
 VL_INLINE VlSiftKeypoint const *vl_sift_get_keypoints (VlSiftFilt const *f) ;
@@ -171,6 +174,7 @@ VL_INLINE void vl_sift_set_edge_thresh (VlSiftFilt *f, double t) ;
 VL_INLINE void vl_sift_set_norm_thresh (VlSiftFilt *f, double t) ;
 VL_INLINE void vl_sift_set_magnif      (VlSiftFilt *f, double m) ;
 VL_INLINE void vl_sift_set_window_size (VlSiftFilt *f, double m) ;
+VL_INLINE void vl_sift_set_avx2_enabled (VlSiftFilt *f, vl_bool x) ;
 /** @} */
 
 /* -------------------------------------------------------------------
@@ -418,5 +422,35 @@ vl_sift_set_window_size (VlSiftFilt *f, double x)
   f -> windowSize = x ;
 }
 
+/** ------------------------------------------------------------------
+ ** @brief Get whether the AVX2 scale space code is used
+ ** @param f SIFT filter.
+ ** @return @c true if the AVX2 code is used.
+ **/
+
+VL_INLINE vl_bool
+vl_sift_get_avx2_enabled (VlSiftFilt const *f)
+{
+  return f -> avx2Enabled ;
+}
+
+/** ------------------------------------------------------------------
+ ** @brief Use the AVX2 scale space code
+ ** @param f SIFT filter.
+ ** @param x @c true to use the AVX2 code.
+ **
+ ** When enabled, the Gaussian smoothing, downsampling, difference of
+ ** Gaussians and gradient computation use AVX2 instructions. The
+ ** caller is responsible for checking that the CPU supports AVX2.
+ ** The setting is ignored if the library is built without AVX2
+ ** support (VL_DISABLE_AVX2). It is disabled by default.
+ **/
+
+VL_INLINE void
+vl_sift_set_avx2_enabled (VlSiftFilt *f, vl_bool x)
+{
+  f -> avx2Enabled = x ;
+}
+
 /* VL_SIFT_H */
 #endif
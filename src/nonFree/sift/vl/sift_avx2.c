@@ -0,0 +1,409 @@
+/** @file sift_avx2.c
+ ** @brief Vectorized SIFT scale space operations - AVX2 - Definition
+ **
+ ** AVX2 versions of the scalar loops building the SIFT Gaussian scale
+ ** space: column convolution (Gaussian smoothing), downsampling,
+ ** difference of Gaussians and gradient magnitude/orientation.
+ **
+ ** The functions perform the same operations in the same order as
+ ** their scalar counterparts in imopv.c and sift.c (no fused
+ ** multiply-add is used), so that the scale space, and therefore the
+ ** detected keypoints, are the same whichever path is selected. The
+ ** only difference is the gradient orientation wrap to [0, 2 pi),
+ ** done in single instead of double precision.
+ **/
+
+/*
+Copyright (C) 2007-12 Andrea Vedaldi and Brian Fulkerson.
+All rights reserved.
+
+This file is part of the VLFeat library and is made available under
+the terms of the BSD license (see the COPYING file).
+*/
+
+#if ! defined(VL_DISABLE_AVX2) & ! defined(__AVX2__)
+#error "Compiling with AVX2 enabled, but no __AVX2__ defined"
+#endif
+
+#if ! defined(VL_DISABLE_AVX2)
+
+#include <immintrin.h>
+#include "imopv.h"
+#include "mathop.h"
+#include "sift_avx2.h"
+
+/* ---------------------------------------------------------------- */
+/*                                                      Convolution */
+/* ---------------------------------------------------------------- */
+
+/** @internal
+ ** @brief Convolve 8 adjacent columns at row @a y
+ **
+ ** Computes <code>sum_k filt[k] src[x, y - k]</code> for the 8 columns
+ ** starting at @a src, padding the columns by continuity or by zero.
+ ** The samples are accumulated from @a filt_end down to @a filt_begin,
+ ** like in the scalar code.
+ **/
+
+VL_INLINE __m256
+_vl_imconvcol_8_avx2 (float const* src, vl_index src_height, vl_size src_stride,
+                      float const* filt, vl_index filt_begin, vl_index filt_end,
+                      vl_index y, vl_bool zeropad)
+{
+  __m256 acc = _mm256_setzero_ps () ;
+  float const* filti = filt + (filt_end - filt_begin) ;
+  vl_index k ;
+
+  if (y - filt_end >= 0 && y - filt_begin < src_height) {
+    /* the filter support is entirely inside the column */
+    float const* srci = src + (y - filt_end) * src_stride ;
+    for (k = filt_end ; k >= filt_begin ; --k) {
+      __m256 v = _mm256_loadu_ps (srci) ;
+      acc = _mm256_add_ps (acc, _mm256_mul_ps (v, _mm256_broadcast_ss (filti--))) ;
+      srci += src_stride ;
+    }
+    return acc ;
+  }
+
+  for (k = filt_end ; k >= filt_begin ; --k) {
+    vl_index p = y - k ;
+    __m256 v ;
+    if (p < 0 || p >= src_height) {
+      if (zeropad) { --filti ; continue ; }
+      p = VL_MAX(VL_MIN(p, src_height - 1), 0) ;
+    }
+    v = _mm256_loadu_ps (src + p * src_stride) ;
+    acc = _mm256_add_ps (acc, _mm256_mul_ps (v, _mm256_broadcast_ss (filti--))) ;
+  }
+  return acc ;
+}
+
+/** @internal
+ ** @brief Transpose a 8x8 block of floats held in 8 registers
+ **/
+
+VL_INLINE void
+_vl_transpose_8x8_avx2 (__m256 r [8])
+{
+  __m256 t0 = _mm256_unpacklo_ps (r[0], r[1]) ;
+  __m256 t1 = _mm256_unpackhi_ps (r[0], r[1]) ;
+  __m256 t2 = _mm256_unpacklo_ps (r[2], r[3]) ;
+  __m256 t3 = _mm256_unpackhi_ps (r[2], r[3]) ;
+  __m256 t4 = _mm256_unpacklo_ps (r[4], r[5]) ;
+  __m256 t5 = _mm256_unpackhi_ps (r[4], r[5]) ;
+  __m256 t6 = _mm256_unpacklo_ps (r[6], r[7]) ;
+  __m256 t7 = _mm256_unpackhi_ps (r[6], r[7]) ;
+  __m256 s0 = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE(1,0,1,0)) ;
+  __m256 s1 = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE(3,2,3,2)) ;
+  __m256 s2 = _mm256_shuffle_ps (t1, t3, _MM_SHUFFLE(1,0,1,0)) ;
+  __m256 s3 = _mm256_shuffle_ps (t1, t3, _MM_SHUFFLE(3,2,3,2)) ;
+  __m256 s4 = _mm256_shuffle_ps (t4, t6, _MM_SHUFFLE(1,0,1,0)) ;
+  __m256 s5 = _mm256_shuffle_ps (t4, t6, _MM_SHUFFLE(3,2,3,2)) ;
+  __m256 s6 = _mm256_shuffle_ps (t5, t7, _MM_SHUFFLE(1,0,1,0)) ;
+  __m256 s7 = _mm256_shuffle_ps (t5, t7, _MM_SHUFFLE(3,2,3,2)) ;
+  r[0] = _mm256_permute2f128_ps (s0, s4, 0x20) ;
+  r[1] = _mm256_permute2f128_ps (s1, s5, 0x20) ;
+  r[2] = _mm256_permute2f128_ps (s2, s6, 0x20) ;
+  r[3] = _mm256_permute2f128_ps (s3, s7, 0x20) ;
+  r[4] = _mm256_permute2f128_ps (s0, s4, 0x31) ;
+  r[5] = _mm256_permute2f128_ps (s1, s5, 0x31) ;
+  r[6] = _mm256_permute2f128_ps (s2, s6, 0x31) ;
+  r[7] = _mm256_permute2f128_ps (s3, s7, 0x31) ;
+}
+
+/** @brief Convolve image along columns - AVX2
+ ** @sa ::vl_imconvcol_vf
+ **
+ ** Same semantic as ::vl_imconvcol_vf. Unlike the SSE2 version, the
+ ** image does not need to be aligned. When the output is transposed,
+ ** blocks of 8x8 results are transposed in registers so that the
+ ** output is written by rows.
+ **/
+
+void
+_vl_imconvcol_vf_avx2 (float* dst, vl_size dst_stride,
+                       float const* src,
+                       vl_size src_width, vl_size src_height, vl_size src_stride,
+                       float const* filt, vl_index filt_begin, vl_index filt_end,
+                       int step, unsigned int flags)
+{
+  vl_index x = 0 ;
+  vl_index y, yd, i ;
+  vl_index const width  = (vl_index) src_width ;
+  vl_index const height = (vl_index) src_height ;
+  vl_index const dheight = (height - 1) / step + 1 ;
+  vl_bool transp  = flags & VL_TRANSPOSE ;
+  vl_bool zeropad = (flags & VL_PAD_MASK) == VL_PAD_BY_ZERO ;
+
+  for (x = 0 ; x + 8 <= width ; x += 8) {
+    float const* srcx = src + x ;
+    y = 0 ; yd = 0 ;
+
+    if (transp) {
+      /* 8x8 blocks: 8 output rows of 8 contiguous values */
+      for ( ; yd + 8 <= dheight ; yd += 8) {
+        __m256 r [8] ;
+        for (i = 0 ; i < 8 ; ++i, y += step) {
+          r[i] = _vl_imconvcol_8_avx2 (srcx, height, src_stride,
+                                       filt, filt_begin, filt_end, y, zeropad) ;
+        }
+        _vl_transpose_8x8_avx2 (r) ;
+        for (i = 0 ; i < 8 ; ++i) {
+          _mm256_storeu_ps (dst + (x + i) * dst_stride + yd, r[i]) ;
+        }
+      }
+    }
+
+    for ( ; yd < dheight ; ++yd, y += step) {
+      __m256 acc = _vl_imconvcol_8_avx2 (srcx, height, src_stride,
+                                         filt, filt_begin, filt_end, y, zeropad) ;
+      if (transp) {
+        float tmp [8] ;
+        _mm256_storeu_ps (tmp, acc) ;
+        for (i = 0 ; i < 8 ; ++i) {
+          dst [(x + i) * dst_stride + yd] = tmp [i] ;
+        }
+      } else {
+        _mm256_storeu_ps (dst + yd * dst_stride + x, acc) ;
+      }
+    }
+  }
+
+  /* remaining columns */
+  for ( ; x < width ; ++x) {
+    for (y = 0, yd = 0 ; yd < dheight ; ++yd, y += step) {
+      float acc = 0 ;
+      float const* filti = filt + (filt_end - filt_begin) ;
+      vl_index k ;
+      for (k = filt_end ; k >= filt_begin ; --k) {
+        vl_index p = y - k ;
+        if (p < 0 || p >= height) {
+          if (zeropad) { --filti ; continue ; }
+          p = VL_MAX(VL_MIN(p, height - 1), 0) ;
+        }
+        acc += src [x + p * src_stride] * *filti-- ;
+      }
+      if (transp) {
+        dst [x * dst_stride + yd] = acc ;
+      } else {
+        dst [yd * dst_stride + x] = acc ;
+      }
+    }
+  }
+}
+
+/* ---------------------------------------------------------------- */
+/*                                           Downsample and DoG     */
+/* ---------------------------------------------------------------- */
+
+/** @brief Copy and downsample an image by a factor 2 - AVX2
+ **
+ ** @param dst    output image buffer.
+ ** @param src    input image buffer.
+ ** @param width  input image width.
+ ** @param height input image height.
+ **
+ ** Same semantic as the scalar @c copy_and_downsample of sift.c with
+ ** @c d=1.
+ **/
+
+void
+_vl_sift_downsample_avx2 (float* dst, float const* src,
+                          int width, int height)
+{
+  int x, y ;
+  int const dwidth = width / 2 ;
+  for (y = 0 ; y < height ; y += 2) {
+    float const* srcrowp = src + y * width ;
+    x = 0 ;
+    for ( ; x + 8 <= dwidth ; x += 8) {
+      __m256 a = _mm256_loadu_ps (srcrowp + 2 * x) ;
+      __m256 b = _mm256_loadu_ps (srcrowp + 2 * x + 8) ;
+      /* [a0 a2 b0 b2 | a4 a6 b4 b6] -> [a0 a2 a4 a6 b0 b2 b4 b6] */
+      __m256 e = _mm256_shuffle_ps (a, b, _MM_SHUFFLE(2,0,2,0)) ;
+      e = _mm256_castpd_ps (_mm256_permute4x64_pd (_mm256_castps_pd (e), _MM_SHUFFLE(3,1,2,0))) ;
+      _mm256_storeu_ps (dst, e) ;
+      dst += 8 ;
+    }
+    for ( ; x < dwidth ; ++x) {
+      *dst++ = srcrowp [2 * x] ;
+    }
+  }
+}
+
+/** @brief Difference of Gaussians - AVX2
+ **
+ ** @param dst    output buffer.
+ ** @param src_a  first level.
+ ** @param src_b  next level.
+ ** @param size   number of pixels of a level.
+ **
+ ** Computes <code>dst = src_b - src_a</code>.
+ **/
+
+void
+_vl_sift_dog_avx2 (float* dst, float const* src_a, float const* src_b,
+                   vl_size size)
+{
+  vl_size i = 0 ;
+  for ( ; i + 8 <= size ; i += 8) {
+    _mm256_storeu_ps (dst + i, _mm256_sub_ps (_mm256_loadu_ps (src_b + i),
+                                              _mm256_loadu_ps (src_a + i))) ;
+  }
+  for ( ; i < size ; ++i) {
+    dst [i] = src_b [i] - src_a [i] ;
+  }
+}
+
+/* ---------------------------------------------------------------- */
+/*                                                         Gradient */
+/* ---------------------------------------------------------------- */
+
+/** @internal
+ ** @brief Vectorized ::vl_fast_sqrt_f
+ **/
+
+VL_INLINE __m256
+_vl_fast_sqrt_8f_avx2 (__m256 x)
+{
+  __m256 const half  = _mm256_set1_ps (0.5F) ;
+  __m256 const three_halves = _mm256_set1_ps (1.5F) ;
+  __m256 xhalf = _mm256_mul_ps (half, x) ;
+  __m256i i = _mm256_sub_epi32 (_mm256_set1_epi32 (0x5f3759df),
+                                _mm256_srai_epi32 (_mm256_castps_si256 (x), 1)) ;
+  __m256 y = _mm256_castsi256_ps (i) ;
+  /* two Newton steps */
+  y = _mm256_mul_ps (y, _mm256_sub_ps (three_halves, _mm256_mul_ps (_mm256_mul_ps (xhalf, y), y))) ;
+  y = _mm256_mul_ps (y, _mm256_sub_ps (three_halves, _mm256_mul_ps (_mm256_mul_ps (xhalf, y), y))) ;
+  /* (x < 1e-8) ? 0 : x * resqrt(x) */
+  return _mm256_andnot_ps (_mm256_cmp_ps (x, _mm256_set1_ps (1e-8F), _CMP_LT_OQ),
+                           _mm256_mul_ps (x, y)) ;
+}
+
+/** @internal
+ ** @brief Vectorized <code>vl_mod_2pi_f(vl_fast_atan2_f(y,x) + 2 pi)</code>
+ **/
+
+VL_INLINE __m256
+_vl_fast_atan2_2pi_8f_avx2 (__m256 y, __m256 x)
+{
+  __m256 const zero = _mm256_setzero_ps () ;
+  __m256 const sign = _mm256_set1_ps (-0.0F) ;
+  __m256 const twopi = _mm256_set1_ps ((float) (2 * VL_PI)) ;
+  __m256 abs_y = _mm256_add_ps (_mm256_andnot_ps (sign, y), _mm256_set1_ps (VL_EPSILON_F)) ;
+  __m256 xpos  = _mm256_cmp_ps (x, zero, _CMP_GE_OQ) ;
+  __m256 num   = _mm256_blendv_ps (_mm256_add_ps (x, abs_y), _mm256_sub_ps (x, abs_y), xpos) ;
+  __m256 den   = _mm256_blendv_ps (_mm256_sub_ps (abs_y, x), _mm256_add_ps (x, abs_y), xpos) ;
+  __m256 r     = _mm256_div_ps (num, den) ;
+  __m256 angle = _mm256_blendv_ps (_mm256_set1_ps ((float) (3 * VL_PI / 4)),
+                                   _mm256_set1_ps ((float) (VL_PI / 4)), xpos) ;
+  __m256 ynegative ;
+  /* angle += (c3*r*r - c1) * r */
+  angle = _mm256_add_ps (angle,
+                         _mm256_mul_ps (_mm256_sub_ps (_mm256_mul_ps (_mm256_mul_ps (_mm256_set1_ps (0.1821F), r), r),
+                                                       _mm256_set1_ps (0.9675F)), r)) ;
+  ynegative = _mm256_cmp_ps (y, zero, _CMP_LT_OQ) ;
+  angle = _mm256_blendv_ps (angle, _mm256_xor_ps (angle, sign), ynegative) ;
+  /* the angle is in [-pi, pi], a single correction is enough */
+  angle = _mm256_add_ps (angle, twopi) ;
+  angle = _mm256_sub_ps (angle, _mm256_and_ps (_mm256_cmp_ps (angle, twopi, _CMP_GT_OQ), twopi)) ;
+  return angle ;
+}
+
+/** @internal
+ ** @brief Save the gradient of one pixel (scalar)
+ **/
+
+VL_INLINE void
+_vl_sift_save_gradient (float* grad, float gx, float gy)
+{
+  grad [0] = vl_fast_sqrt_f (gx*gx + gy*gy) ;
+  grad [1] = vl_mod_2pi_f   (vl_fast_atan2_f (gy, gx) + 2*VL_PI) ;
+}
+
+/** @internal
+ ** @brief Compute the gradient of one row
+ **
+ ** @param grad  output gradient of the row (magnitude and angle interleaved).
+ ** @param src   row.
+ ** @param up    row used as @c y-1 for the vertical derivative.
+ ** @param down  row used as @c y+1 for the vertical derivative.
+ ** @param sy    vertical derivative scale (0.5 for central differences).
+ ** @param width row width.
+ **/
+
+static void
+_vl_sift_gradient_row_avx2 (float* grad, float const* src,
+                            float const* up, float const* down,
+                            float sy, int width)
+{
+  __m256 const half = _mm256_set1_ps (0.5F) ;
+  __m256 const vsy  = _mm256_set1_ps (sy) ;
+  int x = 1 ;
+
+  /* first pixel */
+  _vl_sift_save_gradient (grad, src[1] - src[0], sy * (down[0] - up[0])) ;
+
+  /* middle pixels */
+  for ( ; x + 8 <= width - 1 ; x += 8) {
+    __m256 gx = _mm256_mul_ps (half, _mm256_sub_ps (_mm256_loadu_ps (src + x + 1),
+                                                    _mm256_loadu_ps (src + x - 1))) ;
+    __m256 gy = _mm256_mul_ps (vsy, _mm256_sub_ps (_mm256_loadu_ps (down + x),
+                                                   _mm256_loadu_ps (up + x))) ;
+    __m256 mod = _vl_fast_sqrt_8f_avx2 (_mm256_add_ps (_mm256_mul_ps (gx, gx),
+                                                       _mm256_mul_ps (gy, gy))) ;
+    __m256 ang = _vl_fast_atan2_2pi_8f_avx2 (gy, gx) ;
+    /* interleave [m0 a0 m1 a1 ...] */
+    __m256 lo = _mm256_unpacklo_ps (mod, ang) ;
+    __m256 hi = _mm256_unpackhi_ps (mod, ang) ;
+    _mm256_storeu_ps (grad + 2 * x,     _mm256_permute2f128_ps (lo, hi, 0x20)) ;
+    _mm256_storeu_ps (grad + 2 * x + 8, _mm256_permute2f128_ps (lo, hi, 0x31)) ;
+  }
+  for ( ; x < width - 1 ; ++x) {
+    _vl_sift_save_gradient (grad + 2 * x,
+                            0.5F * (src[x + 1] - src[x - 1]),
+                            sy * (down[x] - up[x])) ;
+  }
+
+  /* last pixel */
+  _vl_sift_save_gradient (grad + 2 * x,
+                          src[x] - src[x - 1],
+                          sy * (down[x] - up[x])) ;
+}
+
+/** @brief Gradient magnitude and orientation of a level - AVX2
+ **
+ ** @param grad   output buffer (2 x width x height, magnitude and angle interleaved).
+ ** @param src    scale space level.
+ ** @param width  level width (at least 2).
+ ** @param height level height (at least 2).
+ **
+ ** Same semantic as the per-level loop of ::vl_sift_update_gradient.
+ **/
+
+void
+_vl_sift_gradient_avx2 (float* grad, float const* src,
+                        int width, int height)
+{
+  int y ;
+
+  /* first row */
+  _vl_sift_gradient_row_avx2 (grad, src, src, src + width, 1.0F, width) ;
+
+  /* middle rows */
+  for (y = 1 ; y < height - 1 ; ++y) {
+    float const* row = src + y * width ;
+    _vl_sift_gradient_row_avx2 (grad + 2 * y * width, row,
+                                row - width, row + width, 0.5F, width) ;
+  }
+
+  /* last row */
+  {
+    float const* row = src + (height - 1) * width ;
+    _vl_sift_gradient_row_avx2 (grad + 2 * (height - 1) * width, row,
+                                row - width, row, 1.0F, width) ;
+  }
+}
+
+/* ! VL_DISABLE_AVX2 */
+#endif
@@ -0,0 +1,42 @@
+/** @file sift_avx2.h
+ ** @brief Vectorized SIFT scale space operations - AVX2
+ **/
+
+/*
+Copyright (C) 2007-12 Andrea Vedaldi and Brian Fulkerson.
+All rights reserved.
+
+This file is part of the VLFeat library and is made available under
+the terms of the BSD license (see the COPYING file).
+*/
+
+#ifndef VL_SIFT_AVX2_H
+#define VL_SIFT_AVX2_H
+
+#include "generic.h"
+
+#ifndef VL_DISABLE_AVX2
+
+VL_EXPORT
+void _vl_imconvcol_vf_avx2 (float* dst, vl_size dst_stride,
+                            float const* src,
+                            vl_size src_width, vl_size src_height, vl_size src_stride,
+                            float const* filt, vl_index filt_begin, vl_index filt_end,
+                            int step, unsigned int flags) ;
+
+VL_EXPORT
+void _vl_sift_downsample_avx2 (float* dst, float const* src,
+                               int width, int height) ;
+
+VL_EXPORT
+void _vl_sift_dog_avx2 (float* dst, float const* src_a, float const* src_b,
+                        vl_size size) ;
+
+VL_EXPORT
+void _vl_sift_gradient_avx2 (float* grad, float const* src,
+                             int width, int height) ;
+
+#endif
+
+/* VL_SIFT_AVX2_H */
+#endif
@@ -0,0 +1,132 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/image/all.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::image;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Measure the wall time of one nonlinear diffusion step (Perona-Malik coefficients and FED cycle).
+ * @param[in] in The input image
+ * @param[in] Lx, Ly The derivatives of the smoothed input image
+ * @param[in] tau The FED cycle timings
+ * @param[in] tiled Use the tiled multi-threaded functions
+ * @param[in] repetitions The number of runs, the fastest one is kept
+ * @param[out] out The diffused image
+ * @return the wall time in ms
+ */
+double benchmark(const Image<float>& in, const Image<float>& Lx, const Image<float>& Ly, const std::vector<float>& tau,
+                 bool tiled, int repetitions, Image<float>& out)
+{
+  double bestTime = std::numeric_limits<double>::max();
+  Image<float> diff;
+  for(int r = 0; r < repetitions; ++r)
+  {
+    out = in;
+    system::Timer timer;
+    if(tiled)
+    {
+      ImagePeronaMalikG2DiffusionCoefTiled(Lx, Ly, 0.05f, diff);
+      ImageFEDCycleTiled(out, diff, tau);
+    }
+    else
+    {
+      ImagePeronaMalikG2DiffusionCoef(Lx, Ly, 0.05f, diff);
+      ImageFEDCycle(out, diff, tau);
+    }
+    bestTime = std::min(bestTime, timer.elapsedMs());
+  }
+  return bestTime;
+}
+
+int main(int argc, char **argv)
+{
+  int width = 2048;
+  int height = 1536;
+  float diffusionTime = 4.f;
+  int repetitions = 5;
+
+  po::options_description allParams("AliceVision diffusionBenchmark\n"
+                                    "Measure the nonlinear diffusion of AKAZE on a random image, "
+                                    "with the reference and the tiled multi-threaded functions");
+  allParams.add_options()
+    ("width", po::value<int>(&width)->default_value(width),
+      "Width of the random image.")
+    ("height", po::value<int>(&height)->default_value(height),
+      "Height of the random image.")
+    ("diffusionTime", po::value<float>(&diffusionTime)->default_value(diffusionTime),
+      "Total time of the FED cycle, gives the number of steps.")
+    ("repetitions", po::value<int>(&repetitions)->default_value(repetitions),
+      "Number of runs of each function, the fastest one is kept.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  width = std::max(3, width);
+  height = std::max(3, height);
+  repetitions = std::max(1, repetitions);
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+  Image<float> in(width, height);
+  for(int i = 0; i < height; ++i)
+    for(int j = 0; j < width; ++j)
+      in(i, j) = distribution(generator);
+
+  Image<float> smoothed, Lx, Ly;
+  ImageGaussianFilter(in, 1.f, smoothed, 0, 0);
+  ImageScharrXDerivative(smoothed, Lx, false);
+  ImageScharrYDerivative(smoothed, Ly, false);
+
+  std::vector<float> tau;
+  FEDCycleTimings(diffusionTime, 0.25f, tau);
+
+  Image<float> ref, tiled;
+  const double refTime = benchmark(in, Lx, Ly, tau, false, repetitions, ref);
+  const double tiledTime = benchmark(in, Lx, Ly, tau, true, repetitions, tiled);
+
+  ALICEVISION_COUT("FED cycle (" << tau.size() << " steps, " << width << "x" << height << "): "
+                   << "reference " << refTime << " ms, tiled " << tiledTime << " ms, "
+                   << "speedup " << refTime / tiledTime);
+
+  if(!tiled.allFinite())
+  {
+    ALICEVISION_CERR("ERROR: invalid values in the tiled diffusion.");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,367 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/image/all.hpp>
+#include <aliceVision/feature/feature.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+namespace bpt = boost::property_tree;
+
+/// Version of the benchmark output file, to update when the results layout changes
+const int BENCHMARK_OUTPUT_VERSION = 1;
+
+/**
+ * @brief Measures of the extraction of one image
+ */
+struct BenchmarkMeasure
+{
+  /// wall time of the whole extraction in seconds
+  double wallTime = std::numeric_limits<double>::max();
+  /// wall time of each extraction stage in seconds (if supported by the describer)
+  feature::ExtractionStagesTimings stages;
+  /// peak resident memory of the process during the extraction in bytes
+  std::size_t peakMemory = 0;
+  /// peak resident memory increase during the extraction in bytes
+  std::size_t peakMemoryIncrease = 0;
+  std::size_t nbFeatures = 0;
+
+  double featuresPerSecond() const
+  {
+    return (wallTime > 0.0) ? nbFeatures / wallTime : 0.0;
+  }
+};
+
+/**
+ * @brief Get all the image describer types of this build
+ */
+std::string getAllDescriberTypes()
+{
+  std::vector<std::string> types;
+  for(int i = 0; i <= std::numeric_limits<unsigned char>::max(); ++i)
+  {
+    const feature::EImageDescriberType type = static_cast<feature::EImageDescriberType>(i);
+    if(type == feature::EImageDescriberType::UNKNOWN || type == feature::EImageDescriberType::UNINITIALIZED)
+      continue;
+    try
+    {
+      types.push_back(feature::EImageDescriberType_enumToString(type));
+    }
+    catch(const std::out_of_range&)
+    {
+      // not an image describer type of this build
+    }
+  }
+  return boost::algorithm::join(types, ",");
+}
+
+/**
+ * @brief List the images of a folder, sorted by name
+ */
+std::vector<std::string> getImages(const std::string& folder)
+{
+  std::vector<std::string> images;
+  for(fs::directory_iterator it(folder); it != fs::directory_iterator(); ++it)
+  {
+    if(fs::is_regular_file(it->status()))
+      images.push_back(it->path().string());
+  }
+  std::sort(images.begin(), images.end());
+  return images;
+}
+
+/**
+ * @brief Extract the features of an image and measure the extraction
+ * @param[in] imageDescriber The image describer
+ * @param[in] imageGrayFloat The float image
+ * @param[in] imageGrayUChar The 8-bit image
+ * @param[in] nbRepetitions The number of extractions, the fastest one is kept
+ * @return the measure of the fastest extraction
+ */
+BenchmarkMeasure measureExtraction(feature::ImageDescriber& imageDescriber,
+                                   const image::Image<float>& imageGrayFloat,
+                                   const image::Image<unsigned char>& imageGrayUChar,
+                                   int nbRepetitions)
+{
+  BenchmarkMeasure bestMeasure;
+
+  for(int r = 0; r < nbRepetitions; ++r)
+  {
+    BenchmarkMeasure measure;
+    std::unique_ptr<feature::Regions> regions;
+
+    imageDescriber.setStagesTimings(&measure.stages);
+
+    system::resetProcessPeakMemory();
+    const std::size_t memoryBefore = system::getProcessMemory();
+
+    system::Timer timer;
+    if(imageDescriber.useFloatImage())
+      imageDescriber.describe(imageGrayFloat, regions);
+    else
+      imageDescriber.describe(imageGrayUChar, regions);
+    measure.wallTime = timer.elapsed();
+
+    measure.peakMemory = system::getProcessPeakMemory();
+    measure.peakMemoryIncrease = (measure.peakMemory > memoryBefore) ? measure.peakMemory - memoryBefore : 0;
+    measure.nbFeatures = regions ? regions->RegionCount() : 0;
+
+    imageDescriber.setStagesTimings(nullptr);
+
+    if(measure.wallTime < bestMeasure.wallTime)
+      bestMeasure = measure;
+  }
+  return bestMeasure;
+}
+
+bpt::ptree toTree(const BenchmarkMeasure& measure)
+{
+  bpt::ptree tree;
+  tree.put("wallTime", measure.wallTime);
+  tree.put("stages.pyramid", measure.stages.pyramid);
+  tree.put("stages.detection", measure.stages.detection);
+  tree.put("stages.orientation", measure.stages.orientation);
+  tree.put("stages.description", measure.stages.description);
+  tree.put("peakMemory", measure.peakMemory);
+  tree.put("peakMemoryIncrease", measure.peakMemoryIncrease);
+  tree.put("features", measure.nbFeatures);
+  tree.put("featuresPerSecond", measure.featuresPerSecond());
+  return tree;
+}
+
+/// - Extract the features of a fixed set of images with each describer type and preset
+/// - Export the time, memory and throughput of each extraction
+int main(int argc, char **argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string imagesFolder;
+  std::string outputFilename;
+
+  // user optional parameters
+
+  std::string describerTypesName = getAllDescriberTypes();
+  std::string describerPresetsName = "low,medium,normal,high,ultra";
+  bool forceCpuExtraction = true;
+  int nbRepetitions = 3;
+  int maxThreads = 0;
+
+  po::options_description allParams("AliceVision featuresBenchmark");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&imagesFolder)->required(),
+      "Folder of the benchmark images.")
+    ("output,o", po::value<std::string>(&outputFilename)->required(),
+      "Output benchmark results file (*.json).");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
+      feature::EImageDescriberType_informations().c_str())
+    ("describerPresets,p", po::value<std::string>(&describerPresetsName)->default_value(describerPresetsName),
+      "ImageDescriber configurations to benchmark (low, medium, normal, high, ultra) separated by commas.")
+    ("forceCpuExtraction", po::value<bool>(&forceCpuExtraction)->default_value(forceCpuExtraction),
+      "Use only CPU feature extraction methods.")
+    ("repetitions", po::value<int>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of extractions of each image, the fastest one is kept.")
+    ("maxThreads", po::value<int>(&maxThreads)->default_value(maxThreads),
+      "Use a given number of threads (0: use all the available threads).");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(maxThreads > 0)
+    omp_set_num_threads(maxThreads);
+
+  nbRepetitions = std::max(1, nbRepetitions);
+
+  const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
+  std::vector<std::string> describerPresets;
+  boost::split(describerPresets, describerPresetsName, boost::is_any_of(","));
+
+  // load the benchmark images
+  std::vector<std::string> imagePaths;
+  std::vector<image::Image<float>> imagesGrayFloat;
+  std::vector<image::Image<unsigned char>> imagesGrayUChar;
+
+  for(const std::string& imagePath : getImages(imagesFolder))
+  {
+    image::Image<float> imageGrayFloat;
+    try
+    {
+      image::readImage(imagePath, imageGrayFloat, image::EImageColorSpace::SRGB);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING("Skip '" << imagePath << "', it can't be read: " << e.what());
+      continue;
+    }
+    imagePaths.push_back(imagePath);
+    imagesGrayUChar.emplace_back((imageGrayFloat.GetMat() * 255.f).cast<unsigned char>());
+    imagesGrayFloat.push_back(std::move(imageGrayFloat));
+  }
+
+  if(imagePaths.empty())
+  {
+    ALICEVISION_LOG_ERROR("No image in the benchmark folder '" << imagesFolder << "'");
+    return EXIT_FAILURE;
+  }
+
+  const system::MemoryInfo memoryInfo = system::getMemoryInfo();
+
+  bpt::ptree benchmarkTree;
+  benchmarkTree.put("version", BENCHMARK_OUTPUT_VERSION);
+  benchmarkTree.put("machine.nbCores", omp_get_num_procs());
+  benchmarkTree.put("machine.nbThreads", omp_get_max_threads());
+  benchmarkTree.put("machine.totalRam", memoryInfo.totalRam);
+  benchmarkTree.put("repetitions", nbRepetitions);
+
+  bpt::ptree imagesTree;
+  for(std::size_t i = 0; i < imagePaths.size(); ++i)
+  {
+    bpt::ptree imageTree;
+    imageTree.put("path", imagePaths.at(i));
+    imageTree.put("width", imagesGrayFloat.at(i).Width());
+    imageTree.put("height", imagesGrayFloat.at(i).Height());
+    imagesTree.push_back(std::make_pair("", imageTree));
+  }
+  benchmarkTree.add_child("images", imagesTree);
+
+  bpt::ptree resultsTree;
+
+  ALICEVISION_LOG_INFO(std::left
+                       << std::setw(16) << "describer" << std::setw(10) << "preset"
+                       << std::setw(12) << "time (s)" << std::setw(12) << "pyramid" << std::setw(12) << "detection"
+                       << std::setw(12) << "orientation" << std::setw(12) << "description"
+                       << std::setw(12) << "peak (MB)" << std::setw(12) << "features" << "features/s");
+
+  for(const feature::EImageDescriberType describerType : describerTypes)
+  {
+    for(const std::string& describerPreset : describerPresets)
+    {
+      std::unique_ptr<feature::ImageDescriber> imageDescriber = feature::createImageDescriber(describerType);
+      imageDescriber->setConfigurationPreset(describerPreset);
+      if(forceCpuExtraction)
+        imageDescriber->setUseCuda(false);
+
+      // sum of the measures of all the images
+      BenchmarkMeasure total;
+      total.wallTime = 0.0;
+
+      bpt::ptree measuresTree;
+      for(std::size_t i = 0; i < imagePaths.size(); ++i)
+      {
+        const BenchmarkMeasure measure = measureExtraction(*imageDescriber, imagesGrayFloat.at(i), imagesGrayUChar.at(i), nbRepetitions);
+
+        bpt::ptree measureTree = toTree(measure);
+        measureTree.put("image", i);
+        measuresTree.push_back(std::make_pair("", measureTree));
+
+        total.wallTime += measure.wallTime;
+        total.stages.pyramid += measure.stages.pyramid;
+        total.stages.detection += measure.stages.detection;
+        total.stages.orientation += measure.stages.orientation;
+        total.stages.description += measure.stages.description;
+        total.peakMemory = std::max(total.peakMemory, measure.peakMemory);
+        total.peakMemoryIncrease = std::max(total.peakMemoryIncrease, measure.peakMemoryIncrease);
+        total.nbFeatures += measure.nbFeatures;
+      }
+
+      bpt::ptree resultTree;
+      resultTree.put("describerType", feature::EImageDescriberType_enumToString(describerType));
+      resultTree.put("describerPreset", describerPreset);
+      resultTree.put("useCuda", imageDescriber->useCuda());
+      resultTree.add_child("total", toTree(total));
+      resultTree.add_child("images", measuresTree);
+      resultsTree.push_back(std::make_pair("", resultTree));
+
+      ALICEVISION_LOG_INFO(std::left << std::fixed << std::setprecision(3)
+                           << std::setw(16) << feature::EImageDescriberType_enumToString(describerType) << std::setw(10) << describerPreset
+                           << std::setw(12) << total.wallTime << std::setw(12) << total.stages.pyramid << std::setw(12) << total.stages.detection
+                           << std::setw(12) << total.stages.orientation << std::setw(12) << total.stages.description
+                           << std::setw(12) << total.peakMemory / (1024 * 1024) << std::setw(12) << total.nbFeatures
+                           << std::setprecision(0) << total.featuresPerSecond());
+    }
+  }
+
+  benchmarkTree.add_child("results", resultsTree);
+
+  try
+  {
+    bpt::write_json(outputFilename, benchmarkTree);
+  }
+  catch(const bpt::ptree_error& e)
+  {
+    ALICEVISION_LOG_ERROR("Can't write the benchmark results file '" << outputFilename << "': " << e.what());
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_LOG_INFO("Benchmark results saved in '" << outputFilename << "'");
+  return EXIT_SUCCESS;
+}
@@ -192,10 +192,14 @@ int main(int argc, char **argv)
   // gvld-consistancy matrix, intitialized to -1,  >0 consistancy value, -1=unknow, -2=false
   std::vector<bool> valide(vec_PutativeMatches.size(), true);// indices of match in the initial matches, if true at the end of KVLD, a match is kept.
 
+  // the scale images are computed once and shared by the KVLD iterations
+  const ImageScale scaleA(imgA);
+  const ImageScale scaleB(imgB);
+
   size_t it_num=0;
   KvldParameters kvldparameters; // initial parameters of KVLD
   while (it_num < 5 &&
-          kvldparameters.inlierRate > KVLD(imgA, imgB, regionsL->Features(), regionsR->Features(),
+          kvldparameters.inlierRate > KVLD(imgA, imgB, scaleA, scaleB, regionsL->Features(), regionsR->Features(),
           matchesPair, matchesFiltered, vec_score,E,valide,kvldparameters)) {
     kvldparameters.inlierRate /= 2;
     //std::cout<<"low inlier rate, re-select matches with new rate="<<kvldparameters.inlierRate<<std::endl;
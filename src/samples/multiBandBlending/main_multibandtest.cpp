@@ -4,7 +4,6 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file,
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
-#include <aliceVision/mesh/MultiBandBlending.hpp>
 #include <aliceVision/mvsData/Image.hpp>
 #include <aliceVision/mvsData/imageIO.hpp>
 #include <aliceVision//mvsData/Color.hpp>
@@ -22,7 +21,6 @@
 #define ALICEVISION_SOFTWARE_VERSION_MINOR 0
 
 using namespace aliceVision;
-using namespace aliceVision::mesh;
 
 namespace po = boost::program_options;
 
@@ -98,15 +96,16 @@ int main(int argc, char **argv)
   inImg.resize(w, h);
   ALICEVISION_LOG_INFO("Input image loaded: " << w << "x" << h);
 
+  imageIO::OutputFileColorSpace colorspace(imageIO::EImageColorSpace::AUTO);
+
   const std::string inImgFilename = filesPath + "inImg.exr";
   ALICEVISION_LOG_INFO("Write input image: " << inImgFilename);
-  imageIO::writeImage(inImgFilename, inImg.width(), inImg.height(), inImg.data(), imageIO::EImageQuality::LOSSLESS, imageIO::EImageColorSpace::AUTO);
+  imageIO::writeImage(inImgFilename, inImg.width(), inImg.height(), inImg.data(), imageIO::EImageQuality::LOSSLESS, colorspace);
 
   ALICEVISION_LOG_INFO("Compute MBB.");
   //Calculate bands
-  MultiBandBlending multiBandBlending;
   std::vector<Image> pyramidL; //laplacian pyramid
-  multiBandBlending.laplacianDownscalePyramid(pyramidL, inImg, nbBand, downscaleMBB);
+  inImg.laplacianPyramid(pyramidL, nbBand, downscaleMBB);
 
   ALICEVISION_LOG_INFO("Write bands");
   //Write bands + reconstitution
@@ -116,7 +115,7 @@ int main(int argc, char **argv)
       ALICEVISION_LOG_INFO("Writing band :" + std::to_string(b));
       int downscaleBand = std::pow(downscaleMBB, b);
       const std::string bandFilename = filesPath + std::string("band") + std::to_string(b) + ".exr";
-      imageIO::writeImage(bandFilename, pyramidL[b].width(), pyramidL[b].height(), pyramidL[b].data(), imageIO::EImageQuality::LOSSLESS, imageIO::EImageColorSpace::AUTO);
+      imageIO::writeImage(bandFilename, pyramidL[b].width(), pyramidL[b].height(), pyramidL[b].data(), imageIO::EImageQuality::LOSSLESS, colorspace);
       for(int i = 0; i < inImg.width() * inImg.height(); ++i)
       {
           Point2d pix(i%inImg.width(), static_cast<int>(i/inImg.width()));
@@ -127,7 +126,7 @@ int main(int argc, char **argv)
   }
   const std::string outImgFilename = filesPath + "outImg.exr";
   ALICEVISION_LOG_INFO("Write output image: " << outImgFilename);
-  imageIO::writeImage(outImgFilename, outImg.width(), outImg.height(), outImg.data(), imageIO::EImageQuality::LOSSLESS, imageIO::EImageColorSpace::AUTO);
+  imageIO::writeImage(outImgFilename, outImg.width(), outImg.height(), outImg.data(), imageIO::EImageQuality::LOSSLESS, colorspace);
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,501 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+#include <aliceVision/multiview/projection.hpp>
+#include <aliceVision/multiview/conditioning.hpp>
+#include <aliceVision/multiview/essentialKernelSolver.hpp>
+#include <aliceVision/multiview/fundamentalKernelSolver.hpp>
+#include <aliceVision/multiview/homographyKernelSolver.hpp>
+#include <aliceVision/multiview/resection/ResectionKernel.hpp>
+#include <aliceVision/multiview/resection/P3PSolver.hpp>
+#include <aliceVision/robustEstimation/ACRansac.hpp>
+#include <aliceVision/robustEstimation/ACRansacKernelAdaptator.hpp>
+#include <aliceVision/robustEstimation/LORansac.hpp>
+#include <aliceVision/robustEstimation/LORansacKernelAdaptor.hpp>
+#include <aliceVision/robustEstimation/ScoreEvaluator.hpp>
+#include <aliceVision/robustEstimation/prosacSampling.hpp>
+#include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::robustEstimation;
+
+namespace po = boost::program_options;
+namespace bpt = boost::property_tree;
+
+/// Version of the benchmark output file, to update when the results layout changes
+const int BENCHMARK_OUTPUT_VERSION = 1;
+
+/// number of heap allocations of the process
+std::atomic<std::size_t> nbAllocations(0);
+
+#if defined(__GLIBC__)
+// count the allocations of the whole process (std containers and Eigen matrices)
+// by wrapping the glibc allocator
+#define ALICEVISION_COUNT_ALLOCATIONS
+
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t nb, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+
+void* malloc(std::size_t size) __THROW
+{
+  nbAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t nb, std::size_t size) __THROW
+{
+  nbAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(nb, size);
+}
+
+void* realloc(void* ptr, std::size_t size) __THROW
+{
+  nbAllocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+#endif
+
+const int imageWidth = 1000;
+const int imageHeight = 1000;
+
+/**
+ * @brief Synthetic correspondences between two views and the 3D points seen by the second view
+ */
+struct Dataset
+{
+  Mat x1;
+  Mat x2;
+  Mat pt3D;
+  Mat3 K1;
+  Mat3 K2;
+  /// true if the correspondence is not an outlier
+  std::vector<bool> isInlier;
+  /// correspondences sorted from the best to the worst synthetic quality (PROSAC)
+  std::vector<std::size_t> sortedIndices;
+};
+
+/**
+ * @brief Generate a dataset with NViewDataSet.
+ * @param[in] nbPoints The number of correspondences
+ * @param[in] outlierRatio The ratio of correspondences replaced by random points in the second view
+ * @param[in] noise The standard deviation of the gaussian noise of the inliers, in pixels
+ * @param[in] planar Put all the 3D points on a plane (for the homography estimation)
+ * @param[in] generator The random number generator
+ */
+Dataset generateDataset(std::size_t nbPoints, double outlierRatio, double noise, bool planar, std::mt19937& generator)
+{
+  // NViewDataSet uses the std::rand generator
+  std::srand(generator());
+
+  // two neighboring views of a ring of 8 cameras looking at the points
+  NViewDataSet d = NRealisticCamerasRing(8, nbPoints, NViewDatasetConfigurator(1000, 1000, imageWidth / 2, imageHeight / 2));
+  if(planar)
+  {
+    d._X.row(2).setZero();
+    d._x[0] = Project(d.P(0), d._X);
+    d._x[1] = Project(d.P(1), d._X);
+  }
+
+  Dataset data;
+  data.x1 = d._x[0];
+  data.x2 = d._x[1];
+  data.pt3D = d._X;
+  data.K1 = d._K[0];
+  data.K2 = d._K[1];
+  data.isInlier.assign(nbPoints, true);
+
+  std::normal_distribution<double> noiseDistribution(0.0, noise);
+  for(Mat::Index i = 0; i < data.x1.size(); ++i)
+  {
+    data.x1.data()[i] += noiseDistribution(generator);
+    data.x2.data()[i] += noiseDistribution(generator);
+  }
+
+  std::vector<std::size_t> indices(nbPoints);
+  std::iota(indices.begin(), indices.end(), 0);
+  std::shuffle(indices.begin(), indices.end(), generator);
+
+  std::uniform_real_distribution<double> xDistribution(0.0, imageWidth);
+  std::uniform_real_distribution<double> yDistribution(0.0, imageHeight);
+  const std::size_t nbOutliers = static_cast<std::size_t>(outlierRatio * nbPoints);
+  for(std::size_t i = 0; i < nbOutliers; ++i)
+  {
+    data.x2.col(indices[i]) << xDistribution(generator), yDistribution(generator);
+    data.isInlier[indices[i]] = false;
+  }
+
+  // synthetic matching scores (like a Lowe ratio): the inliers are better on average
+  std::uniform_real_distribution<double> inlierScore(0.0, 0.7);
+  std::uniform_real_distribution<double> outlierScore(0.3, 1.0);
+  std::vector<double> scores(nbPoints);
+  for(std::size_t i = 0; i < nbPoints; ++i)
+    scores[i] = data.isInlier[i] ? inlierScore(generator) : outlierScore(generator);
+  data.sortedIndices = sortByQuality(scores);
+
+  return data;
+}
+
+/**
+ * @brief Kernel that counts its minimal fits, i.e. the number of iterations of the estimator
+ */
+template<typename KernelT>
+class CountingKernel : public KernelT
+{
+public:
+  using KernelT::KernelT;
+
+  void Fit(const std::vector<std::size_t>& samples, std::vector<typename KernelT::Model>* models) const
+  {
+    ++nbFits;
+    KernelT::Fit(samples, models);
+  }
+
+  mutable std::size_t nbFits = 0;
+};
+
+/**
+ * @brief Options of the robust estimators
+ */
+enum class EVariant
+{
+  DEFAULT,
+  PROSAC,
+  SPRT,
+  HISTOGRAM
+};
+
+std::string EVariant_enumToString(EVariant variant)
+{
+  switch(variant)
+  {
+    case EVariant::DEFAULT:   return "default";
+    case EVariant::PROSAC:    return "prosac";
+    case EVariant::SPRT:      return "sprt";
+    case EVariant::HISTOGRAM: return "histogram";
+  }
+  throw std::out_of_range("Invalid variant enum");
+}
+
+struct Settings
+{
+  std::size_t maxIterations = 1024;
+  /// inlier threshold of LORansac in pixels
+  double threshold = 4.0;
+};
+
+template<typename Kernel>
+std::size_t runACRansac(const Kernel& kernel, const Dataset& data, EVariant variant,
+                        const Settings& settings, std::vector<std::size_t>& inliers)
+{
+  typename Kernel::Model model;
+  ACRANSAC(kernel, inliers, settings.maxIterations, &model, std::numeric_limits<double>::infinity(), nullptr,
+           (variant == EVariant::PROSAC) ? &data.sortedIndices : nullptr,
+           variant == EVariant::SPRT,
+           (variant == EVariant::HISTOGRAM) ? 1000 : 0);
+  return kernel.nbFits;
+}
+
+template<typename Kernel>
+std::size_t runLORansac(const Kernel& kernel, double normalizedThreshold, const Dataset& data, EVariant variant,
+                        const Settings& settings, std::vector<std::size_t>& inliers)
+{
+  ScoreEvaluator<Kernel> scorer(normalizedThreshold);
+  LO_RANSAC(kernel, scorer, &inliers, nullptr, false, settings.maxIterations, 1e-2,
+            (variant == EVariant::PROSAC) ? &data.sortedIndices : nullptr,
+            variant == EVariant::SPRT);
+  return kernel.nbFits;
+}
+
+/**
+ * @brief A solver and estimator combination
+ */
+struct Combination
+{
+  std::string problem;
+  std::string estimator;
+  EVariant variant;
+  bool planar;
+  /// run the estimation, return the number of iterations
+  std::function<std::size_t(const Dataset&, std::vector<std::size_t>&)> run;
+};
+
+std::vector<Combination> getCombinations(const Settings& settings)
+{
+  typedef CountingKernel<ACKernelAdaptor<fundamental::kernel::SevenPointSolver, fundamental::kernel::SimpleError,
+                                         UnnormalizerT, Mat3>> FundamentalACKernel;
+  typedef CountingKernel<KernelAdaptorLoRansac<fundamental::kernel::SevenPointSolver, fundamental::kernel::SymmetricEpipolarDistanceError,
+                                               UnnormalizerT, Mat3, fundamental::kernel::EightPointSolver>> FundamentalLOKernel;
+  typedef CountingKernel<ACKernelAdaptorEssential<essential::kernel::FivePointSolver, fundamental::kernel::EpipolarDistanceError,
+                                                  UnnormalizerT, Mat3>> EssentialACKernel;
+  typedef CountingKernel<ACKernelAdaptor<homography::kernel::FourPointSolver, homography::kernel::AsymmetricError,
+                                         UnnormalizerI, Mat3>> HomographyACKernel;
+  typedef CountingKernel<ACKernelAdaptorResection<resection::kernel::SixPointResectionSolver, resection::kernel::ResectionSquaredResidualError,
+                                                  UnnormalizerResection, Mat34>> ResectionACKernel;
+  typedef CountingKernel<ACKernelAdaptorResection_K<resection::P3PSolver, resection::kernel::ResectionSquaredResidualError,
+                                                    UnnormalizerResection, Mat34>> ResectionKACKernel;
+  typedef CountingKernel<KernelAdaptorResectionLORansac_K<resection::P3PSolver, resection::kernel::ResectionSquaredResidualError,
+                                                          UnnormalizerResection, resection::kernel::SixPointResectionSolver, Mat34>> ResectionKLOKernel;
+
+  std::vector<Combination> combinations;
+
+  for(EVariant variant : {EVariant::DEFAULT, EVariant::PROSAC, EVariant::SPRT, EVariant::HISTOGRAM})
+  {
+    combinations.push_back({"fundamental_7pt", "acransac", variant, false,
+      [=](const Dataset& data, std::vector<std::size_t>& inliers) {
+        const FundamentalACKernel kernel(data.x1, imageWidth, imageHeight, data.x2, imageWidth, imageHeight, true);
+        return runACRansac(kernel, data, variant, settings, inliers);
+      }});
+    combinations.push_back({"essential_5pt", "acransac", variant, false,
+      [=](const Dataset& data, std::vector<std::size_t>& inliers) {
+        const EssentialACKernel kernel(data.x1, imageWidth, imageHeight, data.x2, imageWidth, imageHeight, data.K1, data.K2);
+        return runACRansac(kernel, data, variant, settings, inliers);
+      }});
+    combinations.push_back({"homography_4pt", "acransac", variant, true,
+      [=](const Dataset& data, std::vector<std::size_t>& inliers) {
+        const HomographyACKernel kernel(data.x1, imageWidth, imageHeight, data.x2, imageWidth, imageHeight, false);
+        return runACRansac(kernel, data, variant, settings, inliers);
+      }});
+    combinations.push_back({"resection_6pt", "acransac", variant, false,
+      [=](const Dataset& data, std::vector<std::size_t>& inliers) {
+        const ResectionACKernel kernel(data.x2, imageWidth, imageHeight, data.pt3D);
+        return runACRansac(kernel, data, variant, settings, inliers);
+      }});
+    combinations.push_back({"resection_p3p", "acransac", variant, false,
+      [=](const Dataset& data, std::vector<std::size_t>& inliers) {
+        const ResectionKACKernel kernel(data.x2, data.pt3D, data.K2);
+        return runACRansac(kernel, data, variant, settings, inliers);
+      }});
+  }
+
+  // the NFA histogram is specific to ACRansac
+  for(EVariant variant : {EVariant::DEFAULT, EVariant::PROSAC, EVariant::SPRT})
+  {
+    combinations.push_back({"fundamental_7pt", "loransac", variant, false,
+      [=](const Dataset& data, std::vector<std::size_t>& inliers) {
+        const FundamentalLOKernel kernel(data.x1, imageWidth, imageHeight, data.x2, imageWidth, imageHeight, true);
+        const double normalizedThreshold = Square(settings.threshold * kernel.normalizer2()(0, 0));
+        return runLORansac(kernel, normalizedThreshold, data, variant, settings, inliers);
+      }});
+    combinations.push_back({"resection_p3p", "loransac", variant, false,
+      [=](const Dataset& data, std::vector<std::size_t>& inliers) {
+        const ResectionKLOKernel kernel(data.x2, data.pt3D, data.K2);
+        const double normalizedThreshold = Square(settings.threshold * kernel.normalizer2()(0, 0));
+        return runLORansac(kernel, normalizedThreshold, data, variant, settings, inliers);
+      }});
+  }
+
+  return combinations;
+}
+
+/**
+ * @brief Measures of one estimation
+ */
+struct BenchmarkMeasure
+{
+  std::size_t nbIterations = 0;
+  /// wall time of the estimation in seconds
+  double wallTime = std::numeric_limits<double>::max();
+  /// number of heap allocations during the estimation
+  std::size_t nbAllocations = 0;
+  std::size_t nbInliers = 0;
+  /// ratio of the estimated inliers that are true inliers
+  double precision = 0.0;
+  /// ratio of the true inliers that are estimated inliers
+  double recall = 0.0;
+};
+
+BenchmarkMeasure measure(const Combination& combination, const Dataset& data, int nbRepetitions, std::uint32_t seed)
+{
+  BenchmarkMeasure best;
+  std::vector<std::size_t> inliers;
+
+  for(int r = 0; r < nbRepetitions; ++r)
+  {
+    // same samples for each repetition, only the fastest one is kept
+    seedRandomNumberGenerator(seed);
+
+    const std::size_t allocationsBefore = nbAllocations.load();
+    system::Timer timer;
+    const std::size_t nbIterations = combination.run(data, inliers);
+    const double wallTime = timer.elapsed();
+    const std::size_t allocations = nbAllocations.load() - allocationsBefore;
+
+    if(wallTime < best.wallTime)
+    {
+      best.wallTime = wallTime;
+      best.nbIterations = nbIterations;
+      best.nbAllocations = allocations;
+    }
+  }
+
+  const std::size_t nbTrueInliers = std::count(data.isInlier.begin(), data.isInlier.end(), true);
+  const std::size_t nbGoodInliers = std::count_if(inliers.begin(), inliers.end(), [&](std::size_t i) { return data.isInlier[i]; });
+
+  best.nbInliers = inliers.size();
+  best.precision = inliers.empty() ? 0.0 : static_cast<double>(nbGoodInliers) / inliers.size();
+  best.recall = (nbTrueInliers == 0) ? 0.0 : static_cast<double>(nbGoodInliers) / nbTrueInliers;
+  return best;
+}
+
+int main(int argc, char **argv)
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string outputFilename;
+  std::string outlierRatiosName = "0.1,0.3,0.5,0.7";
+  std::size_t nbPoints = 1000;
+  double noise = 0.5;
+  int nbRepetitions = 3;
+  int randomSeed = std::mt19937::default_seed;
+  Settings settings;
+
+  po::options_description allParams("AliceVision robustEstimationBenchmark\n"
+                                    "Measure the robust estimators on synthetic correspondences");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("output,o", po::value<std::string>(&outputFilename),
+      "Output benchmark results file (*.json).")
+    ("outlierRatios", po::value<std::string>(&outlierRatiosName)->default_value(outlierRatiosName),
+      "Ratios of outliers of the datasets, separated by commas.")
+    ("nbPoints", po::value<std::size_t>(&nbPoints)->default_value(nbPoints),
+      "Number of correspondences of each dataset.")
+    ("noise", po::value<double>(&noise)->default_value(noise),
+      "Standard deviation of the noise of the inliers, in pixels.")
+    ("maxIterations", po::value<std::size_t>(&settings.maxIterations)->default_value(settings.maxIterations),
+      "Maximum number of iterations of the estimators.")
+    ("threshold", po::value<double>(&settings.threshold)->default_value(settings.threshold),
+      "Inlier threshold of LORansac, in pixels.")
+    ("repetitions", po::value<int>(&nbRepetitions)->default_value(nbRepetitions),
+      "Number of runs of each estimation, the fastest one is kept.")
+    ("randomSeed", po::value<int>(&randomSeed)->default_value(randomSeed),
+      "Seed of the datasets and of the estimators.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  nbRepetitions = std::max(1, nbRepetitions);
+
+  std::vector<std::string> outlierRatiosStr;
+  boost::split(outlierRatiosStr, outlierRatiosName, boost::is_any_of(","));
+
+#ifndef ALICEVISION_COUNT_ALLOCATIONS
+  ALICEVISION_LOG_WARNING("The allocations are not counted on this platform.");
+#endif
+
+  const std::vector<Combination> combinations = getCombinations(settings);
+
+  bpt::ptree benchmarkTree;
+  benchmarkTree.put("version", BENCHMARK_OUTPUT_VERSION);
+  benchmarkTree.put("nbPoints", nbPoints);
+  benchmarkTree.put("noise", noise);
+  benchmarkTree.put("maxIterations", settings.maxIterations);
+  bpt::ptree resultsTree;
+
+  std::mt19937 generator(randomSeed);
+
+  for(const std::string& outlierRatioStr : outlierRatiosStr)
+  {
+    const double outlierRatio = std::stod(outlierRatioStr);
+    const Dataset dataset = generateDataset(nbPoints, outlierRatio, noise, false, generator);
+    const Dataset planarDataset = generateDataset(nbPoints, outlierRatio, noise, true, generator);
+
+    ALICEVISION_COUT("outlier ratio " << outlierRatio << ":");
+    ALICEVISION_COUT(std::left << std::setw(18) << "problem" << std::setw(10) << "estimator" << std::setw(11) << "variant"
+                     << std::right << std::setw(11) << "iterations" << std::setw(12) << "time (ms)"
+                     << std::setw(13) << "allocations" << std::setw(9) << "inliers"
+                     << std::setw(11) << "precision" << std::setw(8) << "recall");
+
+    for(const Combination& combination : combinations)
+    {
+      const BenchmarkMeasure m = measure(combination, combination.planar ? planarDataset : dataset, nbRepetitions, randomSeed);
+
+      ALICEVISION_COUT(std::left << std::setw(18) << combination.problem << std::setw(10) << combination.estimator
+                       << std::setw(11) << EVariant_enumToString(combination.variant)
+                       << std::right << std::setw(11) << m.nbIterations
+                       << std::setw(12) << std::fixed << std::setprecision(3) << 1000.0 * m.wallTime
+                       << std::setw(13) << m.nbAllocations << std::setw(9) << m.nbInliers
+                       << std::setw(11) << std::setprecision(3) << m.precision
+                       << std::setw(8) << m.recall << std::defaultfloat);
+
+      bpt::ptree resultTree;
+      resultTree.put("problem", combination.problem);
+      resultTree.put("estimator", combination.estimator);
+      resultTree.put("variant", EVariant_enumToString(combination.variant));
+      resultTree.put("outlierRatio", outlierRatio);
+      resultTree.put("nbIterations", m.nbIterations);
+      resultTree.put("wallTime", m.wallTime);
+#ifdef ALICEVISION_COUNT_ALLOCATIONS
+      resultTree.put("nbAllocations", m.nbAllocations);
+#endif
+      resultTree.put("nbInliers", m.nbInliers);
+      resultTree.put("precision", m.precision);
+      resultTree.put("recall", m.recall);
+      resultsTree.push_back(std::make_pair("", resultTree));
+    }
+  }
+
+  benchmarkTree.add_child("results", resultsTree);
+
+  if(!outputFilename.empty())
+  {
+    bpt::write_json(outputFilename, benchmarkTree);
+    ALICEVISION_LOG_INFO("Benchmark results saved in '" << outputFilename << "'");
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,172 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/multiview/projection.hpp>
+#include <aliceVision/multiview/essentialKernelSolver.hpp>
+#include <aliceVision/multiview/fundamentalKernelSolver.hpp>
+#include <aliceVision/multiview/homographyKernelSolver.hpp>
+#include <aliceVision/multiview/resection/P4PfSolver.hpp>
+#include <aliceVision/multiview/resection/P5PfrSolver.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Random scene seen by two cameras: 3D points and their projections.
+ */
+struct SyntheticScene
+{
+  SyntheticScene(std::size_t nbPoints, std::mt19937& generator)
+  {
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    auto random = [&]() { return distribution(generator); };
+
+    pt3D.resize(3, nbPoints);
+    for(Mat::Index i = 0; i < pt3D.size(); ++i)
+      pt3D.data()[i] = random();
+    pt3D.row(2).array() += 5.0; // in front of the cameras
+
+    const Mat3 R2 = RotationAroundY(0.1 * random()) * RotationAroundX(0.1 * random());
+    const Vec3 t2(1.0 + 0.1 * random(), 0.1 * random(), 0.1 * random());
+
+    Mat34 P1, P2;
+    P_From_KRt(Mat3::Identity(), Mat3::Identity(), Vec3::Zero(), &P1);
+    P_From_KRt(Mat3::Identity(), R2, t2, &P2);
+    Project(P1, pt3D, &x1);
+    Project(P2, pt3D, &x2);
+  }
+
+  Mat3X pt3D;
+  /// normalized camera coordinates in the first and the second camera
+  Mat2X x1, x2;
+};
+
+/**
+ * @brief Measure the latency of a minimal solver.
+ * @param[in] name The solver name
+ * @param[in] nbCalls The number of solver calls
+ * @param[in] models The model container, cleared before each call so its storage is reused
+ * @param[in] solve Functor (iteration, models) that runs the solver once
+ */
+template<typename Model, typename Solve>
+void benchmark(const std::string& name, int nbCalls, std::vector<Model>& models, Solve solve)
+{
+  std::size_t nbModels = 0;
+  system::Timer timer;
+  for(int i = 0; i < nbCalls; ++i)
+  {
+    models.clear();
+    solve(i, models);
+    nbModels += models.size();
+  }
+  const double elapsedMs = timer.elapsedMs();
+
+  ALICEVISION_COUT(name << ": " << 1000.0 * elapsedMs / nbCalls << " us per call, "
+                   << static_cast<double>(nbModels) / nbCalls << " models per call");
+}
+
+int main(int argc, char **argv)
+{
+  int nbCalls = 10000;
+  int nbScenes = 100;
+  int randomSeed = std::mt19937::default_seed;
+
+  po::options_description allParams("AliceVision solversBenchmark\n"
+                                    "Measure the latency of the minimal solvers on random scenes");
+  allParams.add_options()
+    ("calls", po::value<int>(&nbCalls)->default_value(nbCalls),
+      "Number of calls of each solver.")
+    ("scenes", po::value<int>(&nbScenes)->default_value(nbScenes),
+      "Number of random scenes the solvers are called on, in turn.")
+    ("randomSeed", po::value<int>(&randomSeed)->default_value(randomSeed),
+      "Seed of the random scenes.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  nbCalls = std::max(1, nbCalls);
+  nbScenes = std::max(1, nbScenes);
+
+  std::mt19937 generator(randomSeed);
+  std::vector<SyntheticScene> scenes;
+  for(int i = 0; i < nbScenes; ++i)
+    scenes.emplace_back(8, generator);
+
+  auto scene = [&](int i) -> const SyntheticScene& { return scenes[i % scenes.size()]; };
+
+  {
+    std::vector<Mat3> models;
+    models.reserve(essential::kernel::FivePointSolver::MAX_MODELS);
+    benchmark("essential 5 points", nbCalls, models, [&](int i, std::vector<Mat3>& m) {
+      essential::kernel::FivePointSolver::Solve(scene(i).x1.leftCols<5>(), scene(i).x2.leftCols<5>(), &m);
+    });
+  }
+  {
+    std::vector<Mat3> models;
+    models.reserve(fundamental::kernel::SevenPointSolver::MAX_MODELS);
+    benchmark("fundamental 7 points", nbCalls, models, [&](int i, std::vector<Mat3>& m) {
+      fundamental::kernel::SevenPointSolver::Solve(scene(i).x1.leftCols<7>(), scene(i).x2.leftCols<7>(), &m);
+    });
+  }
+  {
+    std::vector<Mat3> models;
+    models.reserve(fundamental::kernel::EightPointSolver::MAX_MODELS);
+    benchmark("fundamental 8 points", nbCalls, models, [&](int i, std::vector<Mat3>& m) {
+      fundamental::kernel::EightPointSolver::Solve(scene(i).x1, scene(i).x2, &m);
+    });
+  }
+  {
+    std::vector<Mat3> models;
+    models.reserve(homography::kernel::FourPointSolver::MAX_MODELS);
+    benchmark("homography 4 points", nbCalls, models, [&](int i, std::vector<Mat3>& m) {
+      homography::kernel::FourPointSolver::Solve(scene(i).x1.leftCols<4>(), scene(i).x2.leftCols<4>(), &m);
+    });
+  }
+  {
+    std::vector<resection::p4fSolution> models;
+    models.reserve(resection::P4PfSolver::MAX_MODELS);
+    benchmark("resection P4Pf", nbCalls, models, [&](int i, std::vector<resection::p4fSolution>& m) {
+      resection::P4PfSolver::solve(1000.0 * scene(i).x1.leftCols<4>(), scene(i).pt3D.leftCols<4>(), &m);
+    });
+  }
+  {
+    std::vector<resection::p5pfrModel> models;
+    models.reserve(resection::P5PfrSolver::MAX_MODELS);
+    benchmark("resection P5Pfr", nbCalls, models, [&](int i, std::vector<resection::p5pfrModel>& m) {
+      resection::P5PfrSolver::solve(1000.0 * scene(i).x1.leftCols<5>(), scene(i).pt3D.leftCols<5>(), 1, &m);
+    });
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -14,6 +14,7 @@
 #include <aliceVision/hdr/DebevecCalibrate.hpp>
 #include <aliceVision/hdr/GrossbergCalibrate.hpp>
 #include <aliceVision/hdr/emorCurve.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -462,6 +463,21 @@ int main(int argc, char** argv)
   else
     calibrationWeight.setFunction(hdr::EFunctionType_stringToEnum(calibrationWeightFunction));
 
+  // without calibration nor recovery, the images are only needed by the merge:
+  // stream them from their files instead of loading all of them
+  bool streamMerge = (!inputResponsePath.empty() || calibrationMethod == ECalibrationMethod::LINEAR) && recoverSourcePath.empty();
+
+  for(const std::string& outputHDRImagePath : outputHDRImagesPath)
+    streamMerge = streamMerge && (fs::path(outputHDRImagePath).extension() == ".exr");
+
+  for(const std::vector<std::string>& group : imagesPaths)
+    for(const std::string& imagePath : group)
+      streamMerge = streamMerge && hdr::hdrMerge::isStreamable(imagePath);
+
+  if(streamMerge)
+    ALICEVISION_LOG_INFO("The LDR images are merged by blocks of rows from their files.");
+
+  std::vector<std::vector<std::string>> imagesPaths_sorted(nbGroups);
 
   for(int g = 0; g < nbGroups; ++g)
   {
@@ -480,17 +496,38 @@ int main(int argc, char** argv)
     std::vector<float> aperture;
     std::vector<std::string> colorSpace;
 
+    // decode the images of the group in parallel (RAW demosaicing is the bottleneck)
+    bool readSuccess = true;
+
+    #pragma omp parallel for schedule(dynamic)
     for(int i=0; i<nbImages; ++i)
     {
-      std::string &imagePath = inputImagesNames[i];
-      stemImages[i] = fs::path(imagePath).stem().string();
-      nameImages[i] = fs::path(imagePath).filename().string();
+      const std::string &imagePath = inputImagesNames[i];
 
       ALICEVISION_LOG_INFO("Reading " << imagePath);
 
-      image::readImage(imagePath, ldrImages[i], loadColorSpace);
+      try
+      {
+        if(!streamMerge)
+          image::readImage(imagePath, ldrImages[i], loadColorSpace);
+        metadatas[i] = image::readImageMetadata(imagePath);
+      }
+      catch(std::exception& e)
+      {
+        ALICEVISION_LOG_ERROR(std::string("Error: ") + e.what());
+        #pragma omp atomic write
+        readSuccess = false;
+      }
+    }
 
-      metadatas[i] = image::readImageMetadata(imagePath);
+    if(!readSuccess)
+      return EXIT_FAILURE;
+
+    for(int i=0; i<nbImages; ++i)
+    {
+      std::string &imagePath = inputImagesNames[i];
+      stemImages[i] = fs::path(imagePath).stem().string();
+      nameImages[i] = fs::path(imagePath).filename().string();
 
       // Debevec and Robertson algorithms use shutter speed as ev value
       // TODO: in the future, we should use EVs instead of just shutter speed.
@@ -532,6 +569,7 @@ int main(int argc, char** argv)
 
     // we sort the images according to their exposure time
     ldrImageGroups_sorted[g].resize(nbImages);
+    imagesPaths_sorted[g].resize(nbImages);
     for(int i=0; i<nbImages; ++i)
     {
       std::vector<float>::iterator it = std::find(ldrTimes.begin(), ldrTimes.end(), ldrTimes_sorted.at(i));
@@ -542,6 +580,7 @@ int main(int argc, char** argv)
       }
 
       ldrImageGroups_sorted[g].at(i) = ldrImages.at(std::distance(ldrTimes.begin(), it));
+      imagesPaths_sorted[g].at(i) = inputImagesNames.at(std::distance(ldrTimes.begin(), it));
     }
 
     // find target exposure time corresponding to the image name given by user
@@ -631,12 +670,26 @@ int main(int argc, char** argv)
 
   for(int g = 0; g < nbGroups; ++g)
   {
-    image::Image<image::RGBfColor> HDRimage(ldrImageGroups[g].front().Width(), ldrImageGroups[g].front().Height(), false);
-
     hdr::hdrMerge merge;
-    merge.process(ldrImageGroups_sorted[g], times_sorted[g], fusionWeight, response, HDRimage, targetTimes[g], false, clampedValueCorrection);
 
-    image::writeImage(outputHDRImagesPath[g], HDRimage, image::EImageColorSpace::AUTO, targetMetadatas[g]);
+    if(streamMerge)
+    {
+      try
+      {
+        merge.process(imagesPaths_sorted[g], times_sorted[g], fusionWeight, response, loadColorSpace, outputHDRImagesPath[g], targetMetadatas[g], targetTimes[g], false, clampedValueCorrection);
+      }
+      catch(std::exception& e)
+      {
+        ALICEVISION_LOG_ERROR(std::string("Error: ") + e.what());
+        return EXIT_FAILURE;
+      }
+    }
+    else
+    {
+      image::Image<image::RGBfColor> HDRimage(ldrImageGroups[g].front().Width(), ldrImageGroups[g].front().Height(), false);
+      merge.process(ldrImageGroups_sorted[g], times_sorted[g], fusionWeight, response, HDRimage, targetTimes[g], false, clampedValueCorrection);
+      image::writeImage(outputHDRImagesPath[g], HDRimage, image::EImageColorSpace::AUTO, targetMetadatas[g]);
+    }
 
     ALICEVISION_LOG_INFO("Successfull HDR fusion of " << nbImages << " LDR images centered on " << targets[g]);
     ALICEVISION_LOG_INFO("HDR image written as " << outputHDRImagesPath[g]);
@@ -8,23 +8,95 @@
 #include <aliceVision/image/io.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/MemoryBudget.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
 
+/**
+ * @brief Get the approximate memory used to convert an image
+ * @param[in] width The image width in the file
+ * @param[in] height The image height in the file
+ * @param[in] pixelSize The size of an output pixel (in bytes)
+ * @param[in] halfSize The RAW image is demosaiced at half resolution
+ * @return The memory (in bytes)
+ */
+std::size_t imageMemory(int width, int height, std::size_t pixelSize, bool halfSize)
+{
+  // RAW sensor data (16 bits) at full resolution,
+  // demosaiced RAW pixels (4 x 16 bits), float decoded image and output image at the output resolution
+  const std::size_t nbPixels = static_cast<std::size_t>(width) * height;
+  const std::size_t outputPixelMemory = 4 * sizeof(unsigned short) + sizeof(image::RGBfColor) + pixelSize;
+  return nbPixels * sizeof(unsigned short) + (halfSize ? nbPixels / 4 : nbPixels) * outputPixelMemory;
+}
+
+/**
+ * @brief Get the number of threads to convert the images and the memory budget shared by them
+ * @param[in] maxImageMemory The memory used to convert the biggest image (in bytes)
+ * @param[in] minImageMemory The memory used to convert the smallest image (in bytes)
+ * @param[in] nbImages The number of images
+ * @param[in] maxThreads The user maximum number of threads (0 for no limit)
+ * @param[out] budgetMemory The memory budget of the conversions (in bytes)
+ * @return The number of threads
+ */
+int computeNbThreads(std::size_t maxImageMemory, std::size_t minImageMemory, std::size_t nbImages, int maxThreads, std::size_t& budgetMemory)
+{
+  const std::size_t availableRam = system::getMemoryInfo().availableRam;
+  budgetMemory = std::max(maxImageMemory, static_cast<std::size_t>(0.9 * availableRam));
+
+  // the memory budget limits the images decoded at the same time
+  std::size_t nbThreads = (availableRam == 0 || minImageMemory == 0) ? 1 : std::max(std::size_t(1), budgetMemory / minImageMemory);
+
+  if(availableRam == 0)
+    ALICEVISION_LOG_WARNING("Cannot find available system memory, this can be due to OS limitations.\n"
+                            "Use only one thread to convert the images.");
+
+  if(maxThreads > 0)
+    nbThreads = std::min(static_cast<std::size_t>(maxThreads), nbThreads);
+  nbThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), nbThreads);
+  nbThreads = std::max(std::size_t(1), std::min(nbImages, nbThreads));
+
+  return static_cast<int>(nbThreads);
+}
+
+/**
+ * @brief Convert an image
+ * @param[in] path The input image path
+ * @param[in] outputPath The output image path
+ * @param[in] inputSettings The input plugin settings
+ */
+template<typename T>
+void convertImage(const std::string& path, const std::string& outputPath, const oiio::ParamValueList& inputSettings)
+{
+  // read input image
+  // only read the 3 first channels
+  image::Image<T> image;
+
+  ALICEVISION_LOG_INFO("Reading " << path);
+  image::readImage(path, image, image::EImageColorSpace::LINEAR, inputSettings);
+  const oiio::ParamValueList metadata = image::readImageMetadata(path);
+
+  // write output image
+  image::writeImage(outputPath, image, image::EImageColorSpace::AUTO, metadata);
+}
+
 int main(int argc, char** argv)
 {
   // command-line parameters
@@ -33,6 +105,8 @@ int main(int argc, char** argv)
   std::vector<std::string> imagePaths;
   std::string outputFolder;
   std::string outImageFileTypeName = image::EImageFileType_enumToString(image::EImageFileType::EXR);
+  bool halfSize = false;
+  int maxThreads = 0;
 
   po::options_description allParams("AliceVision convertRAW");
 
@@ -46,7 +120,11 @@ int main(int argc, char** argv)
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
     ("outputFileType", po::value<std::string>(&outImageFileTypeName)->default_value(outImageFileTypeName),
-      image::EImageFileType_informations().c_str());
+      image::EImageFileType_informations().c_str())
+    ("halfSize", po::value<bool>(&halfSize)->default_value(halfSize),
+      "Demosaic the RAW images at half resolution (faster, for previews).")
+    ("maxThreads", po::value<int>(&maxThreads)->default_value(maxThreads),
+      "Maximum number of threads (0 to use all the cores the available memory allows).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -93,7 +171,19 @@ int main(int argc, char** argv)
   if(!fs::is_directory(outputFolder))
     fs::create_directory(outputFolder);
 
-  int nbImages = 0;
+  // the EXR files store half floats: decode the images directly in half floats
+  const bool halfOutput = (outputFileType == image::EImageFileType::EXR);
+  const std::size_t pixelSize = halfOutput ? sizeof(image::RGBhColor) : sizeof(image::RGBColor);
+
+  oiio::ParamValueList inputSettings;
+  if(halfSize)
+    inputSettings.push_back(oiio::ParamValue("raw:half_size", 1));
+
+  std::vector<std::string> outputPaths;
+  std::vector<std::size_t> imagesMemory;
+  outputPaths.reserve(imagePaths.size());
+  imagesMemory.reserve(imagePaths.size());
+
   for(const std::string& path : imagePaths)
   {
     // check input path
@@ -103,27 +193,20 @@ int main(int argc, char** argv)
       return EXIT_FAILURE;
     }
 
-    nbImages += 1;
-
     // genrate output filename
     std::string outputPath = (outputFolder + "/" + fs::path(path).filename().replace_extension(image::EImageFileType_enumToString(outputFileType)).string());
 
-    if(fs::is_regular_file(outputPath))
+    if(fs::is_regular_file(outputPath) || std::find(outputPaths.begin(), outputPaths.end(), outputPath) != outputPaths.end())
     {
       ALICEVISION_LOG_ERROR("Error: Image '" + outputPath + "' already exists.");
       return EXIT_FAILURE;
     }
 
-    // read input image
-    // only read the 3 first channels
-    image::Image<image::RGBColor> image;
-    oiio::ParamValueList metadata;
-
+    int width = 0;
+    int height = 0;
     try
     {
-      ALICEVISION_LOG_INFO("Reading " << path);
-      image::readImage(path, image, image::EImageColorSpace::LINEAR);
-      metadata = image::readImageMetadata(path);
+      image::readImageMetadata(path, width, height);
     }
     catch(std::exception& e)
     {
@@ -131,17 +214,55 @@ int main(int argc, char** argv)
       return EXIT_FAILURE;
     }
 
-    // write output image
+    outputPaths.push_back(outputPath);
+    imagesMemory.push_back(imageMemory(width, height, pixelSize, halfSize));
+  }
+
+  const int nbImages = static_cast<int>(imagePaths.size());
+
+  std::size_t budgetMemory = 0;
+  const std::size_t maxImageMemory = imagesMemory.empty() ? 0 : *std::max_element(imagesMemory.begin(), imagesMemory.end());
+  const std::size_t minImageMemory = imagesMemory.empty() ? 0 : *std::min_element(imagesMemory.begin(), imagesMemory.end());
+  const int nbThreads = computeNbThreads(maxImageMemory, minImageMemory, imagePaths.size(), maxThreads, budgetMemory);
+  system::MemoryBudget memoryBudget(budgetMemory);
+
+  ALICEVISION_LOG_INFO("Convert the images with " << nbThreads << " thread(s).");
+
+  bool success = true;
+
+  #pragma omp parallel for num_threads(nbThreads) schedule(dynamic)
+  for(int i = 0; i < nbImages; ++i)
+  {
+    // skip the remaining images after an error
+    bool succeeded;
+    #pragma omp atomic read
+    succeeded = success;
+
+    if(!succeeded)
+      continue;
+
+    memoryBudget.acquire(imagesMemory[i]);
+
     try
     {
-      image::writeImage(outputPath, image, image::EImageColorSpace::AUTO, metadata);
+      if(halfOutput)
+        convertImage<image::RGBhColor>(imagePaths[i], outputPaths[i], inputSettings);
+      else
+        convertImage<image::RGBColor>(imagePaths[i], outputPaths[i], inputSettings);
     }
     catch(std::exception& e)
     {
       ALICEVISION_LOG_ERROR(std::string("Error: ") + e.what());
-      return EXIT_FAILURE;
+      #pragma omp atomic write
+      success = false;
     }
+
+    memoryBudget.release(imagesMemory[i]);
   }
+
+  if(!success)
+    return EXIT_FAILURE;
+
   ALICEVISION_LOG_INFO("Successfull conversion of " << nbImages << " image(s).");
   return EXIT_SUCCESS;
 }
@@ -103,7 +103,7 @@ int main(int argc, char** argv)
 
   // load SfMData files
   sfmData::SfMData sfmData;
-  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData(sfmDataIO::VIEWS | sfmDataIO::INTRINSICS | sfmDataIO::EXTRINSICS)))
   {
     ALICEVISION_LOG_ERROR("The input SfMData file '" << sfmDataFilename << "' cannot be read.");
     return EXIT_FAILURE;
@@ -138,37 +138,44 @@ int main(int argc, char** argv)
   std::map<std::string, std::map<std::size_t, IndexT>> videoViewPerFrame;
   std::map<std::string, std::vector<std::pair<std::size_t, IndexT>> > dslrViewPerKey;
 
-  ALICEVISION_LOG_INFO("Build animated camera(s)...");
-
-  image::Image<image::RGBfColor> image, image_ud;
-  boost::progress_display progressBar(sfmData.getViews().size());
-
+  // views to export
+  std::vector<const sfmData::View*> views;
+  views.reserve(sfmData.getViews().size());
   for(const auto& viewPair : sfmData.getViews())
   {
-    const sfmData::View& view = *(viewPair.second);
-
-    ++progressBar;
-
     // regex filter
     if(!viewFilter.empty() &&
-       !std::regex_match(view.getImagePath(), regexFilter))
+       !std::regex_match(viewPair.second->getImagePath(), regexFilter))
       continue;
+    views.push_back(viewPair.second.get());
+  }
+
+  // undistort camera images
+  if(undistortedImages)
+  {
+    ALICEVISION_LOG_INFO("Undistort camera image(s)...");
 
-    const std::string imagePathStem = fs::path(viewPair.second->getImagePath()).stem().string();
+    boost::progress_display progressBar(views.size());
 
-    // undistort camera images
-    if(undistortedImages)
+    // undistortion maps shared by the views of the same intrinsic
+    camera::UndistortionMapCache undistortionMaps;
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < views.size(); ++i)
     {
+      const sfmData::View& view = *(views.at(i));
+      const std::string imagePathStem = fs::path(view.getImagePath()).stem().string();
       sfmData::Intrinsics::const_iterator iterIntrinsic = sfmData.getIntrinsics().find(view.getIntrinsicId());
       const std::string dstImage = (undistortedImagesFolderPath / (std::to_string(view.getIntrinsicId()) + "_" + imagePathStem + "." + image::EImageFileType_enumToString(outputFileType))).string();
       const camera::IntrinsicBase * cam = iterIntrinsic->second.get();
 
+      image::Image<image::RGBfColor> image, image_ud;
       image::readImage(view.getImagePath(), image, image::EImageColorSpace::LINEAR);
 
       if(cam->isValid() && cam->have_disto())
       {
         // undistort the image and save it
-        camera::UndistortImage(image, cam, image_ud, image::FBLACK, true); // correct principal point
+        camera::UndistortImage(image, cam, image_ud, image::FBLACK, undistortionMaps, true); // correct principal point
         image::writeImage(dstImage, image_ud, image::EImageColorSpace::LINEAR);
       }
       else // (no distortion)
@@ -176,7 +183,18 @@ int main(int argc, char** argv)
         // copy the image since there is no distortion
         image::writeImage(dstImage, image, image::EImageColorSpace::LINEAR);
       }
+
+      #pragma omp critical
+      ++progressBar;
     }
+  }
+
+  ALICEVISION_LOG_INFO("Build animated camera(s)...");
+
+  for(const sfmData::View* viewPtr : views)
+  {
+    const sfmData::View& view = *viewPtr;
+    const std::string imagePathStem = fs::path(view.getImagePath()).stem().string();
 
     // pose and intrinsic defined
     if(!sfmData.isPoseAndIntrinsicDefined(&view))
@@ -8,11 +8,15 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmData/colorize.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfmDataIO/plyIO.hpp>
+#include <aliceVision/image/ImageProvider.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/config.hpp>
 
 #include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
 
 #include <string>
 #include <vector>
@@ -20,11 +24,12 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
 namespace po = boost::program_options;
+namespace fs = boost::filesystem;
 
 // Convert from a SfMData format to another
 int main(int argc, char **argv)
@@ -34,6 +39,9 @@ int main(int argc, char **argv)
   std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
   std::string sfmDataFilename;
   std::string outputSfMDataFilename;
+  int downscale = 1;
+  float maxMemory = 1024.f;
+  bool binaryPly = true;
 
   po::options_description allParams("AliceVision exportColoredPointCloud");
 
@@ -44,12 +52,21 @@ int main(int argc, char **argv)
     ("output,o", po::value<std::string>(&outputSfMDataFilename)->required(),
       "Output point cloud with visibilities as SfMData file.");
 
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("downscale", po::value<int>(&downscale)->default_value(downscale),
+      "Downscale factor of the images used to colorize the points (power of 2, 1 for the full resolution).")
+    ("maxMemory", po::value<float>(&maxMemory)->default_value(maxMemory),
+      "Memory budget of the decoded images (in MB).")
+    ("binaryPly", po::value<bool>(&binaryPly)->default_value(binaryPly),
+      "Write a binary file instead of an ASCII one when the output is a PLY file.");
+
   po::options_description logParams("Log parameters");
   logParams.add_options()
     ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
       "verbosity level (fatal, error, warning, info, debug, trace).");
 
-  allParams.add(requiredParams).add(logParams);
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
 
   po::variables_map vm;
   try
@@ -88,6 +105,17 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  // the images are read at the mipmap level of the downscale factor
+  int level = 0;
+  while((1 << level) < downscale)
+    ++level;
+
+  if(downscale < 1 || (1 << level) != downscale)
+  {
+    ALICEVISION_LOG_ERROR("The downscale factor must be a power of 2.");
+    return EXIT_FAILURE;
+  }
+
   // load input SfMData scene
   sfmData::SfMData sfmData;
   if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
@@ -97,11 +125,23 @@ int main(int argc, char **argv)
   }
 
   // compute the scene structure color
-  sfmData::colorizeTracks(sfmData);
+  try
+  {
+    const image::ImageProvider imageProvider(maxMemory, false);
+    sfmData::colorizeTracks(sfmData, &imageProvider, level);
+  }
+  catch(std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR(e.what());
+    return EXIT_FAILURE;
+  }
 
   // export the SfMData scene in the expected format
   ALICEVISION_LOG_INFO("Saving output result to " << outputSfMDataFilename << "...");
-  if(!sfmDataIO::Save(sfmData, outputSfMDataFilename.c_str(), sfmDataIO::ESfMData::ALL))
+  const bool isPly = (boost::to_lower_copy(fs::path(outputSfMDataFilename).extension().string()) == ".ply");
+  const bool saved = isPly ? sfmDataIO::savePLY(sfmData, outputSfMDataFilename, sfmDataIO::ESfMData::ALL, binaryPly)
+                           : sfmDataIO::Save(sfmData, outputSfMDataFilename.c_str(), sfmDataIO::ESfMData::ALL);
+  if(!saved)
   {
     ALICEVISION_LOG_ERROR("The output SfMData file '" + sfmDataFilename + "' cannot be save.");
     return EXIT_FAILURE;
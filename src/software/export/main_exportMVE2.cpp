@@ -109,6 +109,7 @@ bool exportToMVE2Format(
     std::string sOutViewIteratorDirectory;
     std::size_t view_index = 0;
     std::map<std::size_t, IndexT> viewIdToviewIndex;
+    UndistortionMapCache undistortionMaps;
     for(Views::const_iterator iter = sfm_data.getViews().begin();
       iter != sfm_data.getViews().end(); ++iter, ++my_progress_bar)
     {
@@ -139,7 +140,7 @@ bool exportToMVE2Format(
       {
         // Undistort and save the image
         readImage(srcImage, image, image::EImageColorSpace::NO_CONVERSION);
-        UndistortImage(image, cam, image_ud, BLACK);
+        UndistortImage(image, cam, image_ud, BLACK, undistortionMaps);
         writeImage(dstImage, image_ud, image::EImageColorSpace::NO_CONVERSION);
       }
       else // (no distortion)
@@ -103,6 +103,7 @@ int main(int argc, char **argv)
 
   // export undistorted images and thumbnail images
   boost::progress_display progressBar(sfmData.getViews().size(), std::cout, "Exporting Images for MeshroomMaya\n");
+  camera::UndistortionMapCache undistortionMaps;
   for(auto& viewPair : sfmData.getViews())
   {
     const sfmData::View& view = *viewPair.second;
@@ -119,7 +120,7 @@ int main(int argc, char **argv)
 
     // compute undistorted image
     if(intrinsicPtr->isValid() && intrinsicPtr->have_disto())
-      camera::UndistortImage(image, intrinsicPtr.get(), imageUd, image::BLACK, true);
+      camera::UndistortImage(image, intrinsicPtr.get(), imageUd, image::BLACK, undistortionMaps, true);
     else
       imageUd = image;
 
@@ -98,6 +98,7 @@ bool exportToPMVSFormat(
 
     // Export (calibrated) views as undistorted images
     Image<RGBColor> image, image_ud;
+    UndistortionMapCache undistortionMaps;
     for(Views::const_iterator iter = sfm_data.getViews().begin();
       iter != sfm_data.getViews().end(); ++iter, ++my_progress_bar)
     {
@@ -117,7 +118,7 @@ bool exportToPMVSFormat(
       {
         // undistort the image and save it
         readImage( srcImage, image, image::EImageColorSpace::NO_CONVERSION);
-        UndistortImage(image, cam, image_ud, BLACK);
+        UndistortImage(image, cam, image_ud, BLACK, undistortionMaps);
         writeImage(dstImage, image_ud, image::EImageColorSpace::NO_CONVERSION);
       }
       else // (no distortion)
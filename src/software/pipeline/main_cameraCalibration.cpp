@@ -15,7 +15,9 @@
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/RingBuffer.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -38,16 +40,35 @@
 #include <stdexcept>
 #include <exception>
 #include <map>
+#include <memory>
 #include <limits>
+#include <algorithm>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 namespace bfs = boost::filesystem;
 namespace po = boost::program_options;
 
+/// A decoded input frame, waiting for the pattern detection
+struct InputFrame
+{
+  std::size_t inputIndex = 0;
+  std::size_t frameIndex = 0;
+  cv::Mat viewGray;
+};
+
+/// The pattern detected in an input frame
+struct FrameDetection
+{
+  std::size_t inputIndex = 0;
+  std::size_t frameIndex = 0;
+  std::vector<cv::Point2f> pointbuf;
+  std::vector<int> detectedId;
+};
+
 int main(int argc, char** argv)
 {
   // Command line arguments
@@ -64,6 +85,7 @@ int main(int argc, char** argv)
   std::size_t minInputFrames = 10;
   double squareSize = 1.0;
   double maxTotalAvgErr = 0.1;
+  double minFrameMotion = 0.0;
 
 
   po::options_description desc("\n\nThis program is used to calibrate a camera from a dataset of images.\n");
@@ -98,6 +120,9 @@ int main(int argc, char** argv)
            "Minimal number of frames to limit the refinement loop.\n")
           ("maxTotalAvgErr,e", po::value<double>(&maxTotalAvgErr)->default_value(maxTotalAvgErr),
            "Max Total Average Error.\n")
+          ("minFrameMotion", po::value<double>(&minFrameMotion)->default_value(minFrameMotion),
+           "Minimal motion with the previous detected frame, as the mean absolute difference of their thumbnails (in gray levels), "
+           "the frames with less motion are skipped without detection (0 to detect in all the frames).\n")
           ("debugRejectedImgFolder", po::value<std::string>(&debugRejectedImgFolder)->default_value(""),
            "Folder to export delete images during the refinement loop.\n")
           ("debugSelectedImgFolder,d", po::value<std::string>(&debugSelectedImgFolder)->default_value(""),
@@ -193,48 +218,149 @@ int main(int argc, char** argv)
   aliceVision::system::Timer duration;
   
   std::size_t currentFrame = 0;
-  while (feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
-  {
-    cv::Mat viewGray;
-    cv::eigen2cv(imageGrey.GetMat(), viewGray);
+  std::size_t nbSkippedFrames = 0;
+  cv::Mat previousThumbnail;
+  std::string errorMessage;
 
-    // Check image is correctly loaded
-    if (viewGray.size() == cv::Size(0, 0))
-    {
-      throw std::runtime_error(std::string("Invalid image: ") + currentImgName);
-    }
-    // Check image size is always the same
-    if (imageSize == cv::Size(0, 0))
+  // read the next frame to detect, skip the frames without enough motion
+  const auto readNextFrame = [&](InputFrame& inputFrame) -> bool
+  {
+    try
     {
-      // First image: initialize the image size.
-      imageSize = viewGray.size();
+      while (feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+      {
+        cv::Mat viewGray;
+        cv::eigen2cv(imageGrey.GetMat(), viewGray);
+
+        // Check image is correctly loaded
+        if (viewGray.size() == cv::Size(0, 0))
+        {
+          throw std::runtime_error(std::string("Invalid image: ") + currentImgName);
+        }
+        // Check image size is always the same
+        if (imageSize == cv::Size(0, 0))
+        {
+          // First image: initialize the image size.
+          imageSize = viewGray.size();
+        }
+        // Check image resolutions are always the same
+        else if (imageSize != viewGray.size())
+        {
+          throw std::runtime_error(std::string("You cannot mix multiple image resolutions during the camera calibration. See image file: ") + currentImgName);
+        }
+
+        ALICEVISION_CERR("[" << currentFrame << "/" << nbFrames << "] (" << iInputFrame << "/" << nbFramesToProcess << ")");
+
+        inputFrame.inputIndex = iInputFrame;
+        inputFrame.frameIndex = currentFrame;
+        inputFrame.viewGray = viewGray;
+
+        ++iInputFrame;
+        currentFrame = std::floor(iInputFrame * step);
+        feed.goToFrame(currentFrame);
+
+        if (minFrameMotion > 0.0)
+        {
+          // compare the frame thumbnail with the one of the previous detected frame
+          cv::Mat thumbnail;
+          const double thumbnailScale = std::min(1.0, 160.0 / viewGray.cols);
+          cv::resize(viewGray, thumbnail, cv::Size(), thumbnailScale, thumbnailScale, cv::INTER_AREA);
+
+          if (!previousThumbnail.empty() &&
+              cv::norm(thumbnail, previousThumbnail, cv::NORM_L1) / thumbnail.total() < minFrameMotion)
+          {
+            ++nbSkippedFrames;
+            continue;
+          }
+          previousThumbnail = thumbnail;
+        }
+        return true;
+      }
     }
-    // Check image resolutions are always the same
-    else if (imageSize != viewGray.size())
+    catch (std::exception& e)
     {
-      throw std::runtime_error(std::string("You cannot mix multiple image resolutions during the camera calibration. See image file: ") + currentImgName);
+      errorMessage = e.what();
     }
+    return false;
+  };
+
+  std::vector<FrameDetection> frameDetections;
 
-    std::vector<cv::Point2f> pointbuf;
-    std::vector<int> detectedId;
-    ALICEVISION_CERR("[" << currentFrame << "/" << nbFrames << "] (" << iInputFrame << "/" << nbFramesToProcess << ")");
+  // detect the chosen pattern in a frame
+  const auto detectPattern = [&](const InputFrame& inputFrame)
+  {
+    FrameDetection frameDetection;
+    frameDetection.inputIndex = inputFrame.inputIndex;
+    frameDetection.frameIndex = inputFrame.frameIndex;
 
     // Find the chosen pattern in images
-    const bool found = aliceVision::calibration::findPattern(patternType, viewGray, boardSize, detectedId, pointbuf);
-    
+    const bool found = aliceVision::calibration::findPattern(patternType, inputFrame.viewGray, boardSize, frameDetection.detectedId, frameDetection.pointbuf);
+
     if (found)
     {
-      validFrames.push_back(currentFrame);
-      detectedIdPerFrame.push_back(detectedId);
-      imagePoints.push_back(pointbuf);
+      #pragma omp critical(cameraCalibrationDetections)
+      frameDetections.push_back(std::move(frameDetection));
+    }
+  };
+
+  // one thread decodes the frames ahead, the others detect the pattern in the decoded frames
+  int nbThreads = std::max(2, omp_get_max_threads());
+#if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
+  // CCTag detection runs on a single pipe
+  if (patternType == aliceVision::calibration::Pattern::ASYMMETRIC_CCTAG_GRID)
+    nbThreads = 2;
+#endif
+  aliceVision::system::RingBuffer<std::shared_ptr<InputFrame>> decodedQueue(nbThreads);
+
+  #pragma omp parallel num_threads(nbThreads)
+  {
+    if (omp_get_num_threads() < 2)
+    {
+      // the decoding can't run with the detection, process the frames one by one
+      InputFrame inputFrame;
+      while (readNextFrame(inputFrame))
+        detectPattern(inputFrame);
     }
+    else if (omp_get_thread_num() == 0)
+    {
+      // decode stage
+      std::shared_ptr<InputFrame> inputFrame = std::make_shared<InputFrame>();
+      while (readNextFrame(*inputFrame))
+      {
+        decodedQueue.push(inputFrame);
+        inputFrame = std::make_shared<InputFrame>();
+      }
+      decodedQueue.close();
+    }
+    else
+    {
+      // detection stage
+      std::shared_ptr<InputFrame> inputFrame;
+      while (decodedQueue.pop(inputFrame))
+      {
+        detectPattern(*inputFrame);
+        inputFrame.reset(); // release the frame before waiting for the next one
+      }
+    }
+  }
+
+  if (!errorMessage.empty())
+    throw std::runtime_error(errorMessage);
 
-    ++iInputFrame;
-    currentFrame = std::floor(iInputFrame * step);
-    feed.goToFrame(currentFrame);
+  // keep the detections in the frames order
+  std::sort(frameDetections.begin(), frameDetections.end(),
+            [](const FrameDetection& a, const FrameDetection& b) { return a.inputIndex < b.inputIndex; });
+
+  for (FrameDetection& frameDetection : frameDetections)
+  {
+    validFrames.push_back(frameDetection.frameIndex);
+    detectedIdPerFrame.push_back(std::move(frameDetection.detectedId));
+    imagePoints.push_back(std::move(frameDetection.pointbuf));
   }
 
-  
+  if (minFrameMotion > 0.0)
+    ALICEVISION_CERR(nbSkippedFrames << " input images skipped without enough motion.");
+
   ALICEVISION_CERR("find points duration: " << aliceVision::system::prettyTime(duration.elapsedMs()));
   ALICEVISION_CERR("Grid detected in " << imagePoints.size() << " images on " << iInputFrame << " input images.");
 
@@ -300,8 +426,18 @@ int main(int argc, char** argv)
                                          writePoints ? calibImagePoints : std::vector<std::vector<cv::Point2f> >(),
                                          totalAvgErr);
 
+  // the calibration works on the indexes of the detections, get the corresponding frames of the feed
+  const auto toFeedFrames = [&validFrames](const std::vector<std::size_t>& detectionIndexes)
+  {
+    std::vector<std::size_t> feedFrames;
+    feedFrames.reserve(detectionIndexes.size());
+    for (std::size_t detectionIndex : detectionIndexes)
+      feedFrames.push_back(validFrames.at(detectionIndex));
+    return feedFrames;
+  };
+
   aliceVision::calibration::exportDebug(debugSelectedImgFolder, debugRejectedImgFolder,
-                                    feed, calibInputFrames, rejectInputFrames, remainingImagesIndexes,
+                                    feed, toFeedFrames(calibInputFrames), toFeedFrames(rejectInputFrames), toFeedFrames(remainingImagesIndexes),
                                     cameraMatrix, distCoeffs, imageSize);
 
   ALICEVISION_COUT("Total duration: " << aliceVision::system::prettyTime(durationAlgo.elapsedMs()));
@@ -8,6 +8,7 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/sfmDataIO/jsonIO.hpp>
 #include <aliceVision/sfmDataIO/viewIO.hpp>
+#include <aliceVision/sfmDataIO/ImageMetadataCache.hpp>
 #include <aliceVision/sensorDB/parseDatabase.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
@@ -27,7 +28,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -186,6 +187,7 @@ int main(int argc, char **argv)
   EGroupCameraFallback groupCameraFallback = EGroupCameraFallback::FOLDER;
 
   bool allowSingleView = false;
+  std::string metadataCachePath;
 
   po::options_description allParams("AliceVision cameraInit");
 
@@ -218,7 +220,9 @@ int main(int argc, char **argv)
       " * " + EGroupCameraFallback_enumToString(EGroupCameraFallback::IMAGE) + ": consider that each image has different internal camera parameters").c_str())
     ("allowSingleView", po::value<bool>(&allowSingleView)->default_value(allowSingleView),
       "Allow the program to process a single view.\n"
-      "Warning: if a single view is process, the output file can't be use in many other programs.");
+      "Warning: if a single view is process, the output file can't be use in many other programs.")
+    ("metadataCache", po::value<std::string>(&metadataCachePath)->default_value(metadataCachePath),
+      "Image metadata cache file path (*.json), the metadata of the unchanged images is not read again (or empty to disable).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -342,16 +346,19 @@ int main(int argc, char **argv)
   }
 
   // check sensor database
-  std::vector<sensorDB::Datasheet> sensorDatabase;
+  std::vector<sensorDB::Datasheet> sensorDatasheets;
   if(!sensorDatabasePath.empty())
   {
-    if(!sensorDB::parseDatabase(sensorDatabasePath, sensorDatabase))
+    if(!sensorDB::parseDatabase(sensorDatabasePath, sensorDatasheets))
     {
       ALICEVISION_LOG_ERROR("Invalid input database '" << sensorDatabasePath << "', please specify a valid file.");
       return EXIT_FAILURE;
     }
   }
 
+  // index the sensor database once for all the views
+  const sensorDB::DatabaseIndex sensorDatabase(sensorDatasheets);
+
   // use current time as seed for random generator for intrinsic Id without metadata
   std::srand(std::time(0));
 
@@ -382,13 +389,24 @@ int main(int argc, char **argv)
     if(listFiles(imageFolder, {".jpg", ".jpeg", ".tif", ".tiff", ".exr"},  imagePaths))
     {
       std::vector<sfmData::View> incompleteViews(imagePaths.size());
+      std::unique_ptr<sfmDataIO::ImageMetadataCache> metadataCache;
+
+      if(!metadataCachePath.empty())
+        metadataCache.reset(new sfmDataIO::ImageMetadataCache(metadataCachePath));
 
-      #pragma omp parallel for
+      #pragma omp parallel for schedule(dynamic)
       for(int i = 0; i < incompleteViews.size(); ++i)
       {
         sfmData::View& view = incompleteViews.at(i);
         view.setImagePath(imagePaths.at(i));
-        sfmDataIO::updateIncompleteView(view);
+        sfmDataIO::updateIncompleteView(view, metadataCache.get());
+      }
+
+      if(metadataCache)
+      {
+        ALICEVISION_LOG_INFO("Image metadata: " << metadataCache->getNbCachedReads() << " image(s) from the cache, "
+                             << metadataCache->getNbFileReads() << " image(s) read.");
+        metadataCache->save();
       }
 
       for(const auto& view : incompleteViews)
@@ -36,7 +36,9 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <map>
 #include <memory>
+#include <mutex>
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
 #include <aliceVision/sfmDataIO/AlembicExporter.hpp>
@@ -45,7 +47,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 4
 
 using namespace aliceVision;
 
@@ -68,6 +70,8 @@ int main(int argc, char** argv)
   std::string sfmFilePath;
   /// the folder containing the descriptors
   std::string descriptorsFolder;
+  /// the prebuilt localization database folder
+  std::string localizationDatabaseFolder;
   /// the media file to localize
   std::string mediaFilepath;
  
@@ -108,6 +112,14 @@ int main(int argc, char** argv)
   /// enable/disable the robust matching (geometric validation) when matching query image
   /// and databases images
   bool robustMatching = true;
+  /// maximum number of frames waiting between two stages of the localization pipeline
+  std::size_t pipelineQueueSize = 0;
+  /// localize the frames by tracking the landmarks of the previous frame
+  bool useTracking = false;
+  /// radius of the search window of the tracked landmarks
+  double trackingWindow = 20.0;
+  /// minimum number of inliers of a frame localized by tracking
+  std::size_t trackingMinInliers = 50;
   
   /// the Alembic export file
   std::string exportAlembicFile = "trackedcameras.abc";
@@ -128,6 +140,8 @@ int main(int argc, char** argv)
   /// remove the points that does not have a minimum visibility over the sequence
   /// ie that are seen at least by minPointVisibility frames of the sequence
   std::size_t minPointVisibility = 0;
+  /// number of last frames refined online with each new localized frame
+  std::size_t refineWindow = 0;
   
   /// whether to save visual debug info
   std::string visualDebug = "";
@@ -149,6 +163,10 @@ int main(int argc, char** argv)
   commonParams.add_options()
       ("descriptorPath", po::value<std::string>(&descriptorsFolder),
           "Folder containing the descriptors for all the images (ie the *.desc.)")
+      ("localizationDatabase", po::value<std::string>(&localizationDatabaseFolder),
+          "Folder of a localization database built with aliceVision_localizationDatabase: "
+          "the reconstructed descriptors (and the voctree documents) are loaded from it "
+          "instead of the descriptors of all the images.")
       ("matchDescTypes", po::value<std::string>(&matchDescTypeNames)->default_value(matchDescTypeNames),
           "The describer types to use for the matching")
       ("preset", po::value<feature::EImageDescriberPreset>(&featurePreset)->default_value(featurePreset), 
@@ -195,6 +213,17 @@ int main(int argc, char** argv)
       ("robustMatching", po::value<bool>(&robustMatching)->default_value(robustMatching), 
           "[voctree] Enable/Disable the robust matching between query and database images, "
           "all putative matches will be considered.")
+      ("pipelineQueueSize", po::value<std::size_t>(&pipelineQueueSize)->default_value(pipelineQueueSize),
+          "[voctree] Localize the frames with a pipeline: the features extraction, the matching "
+          "and the pose estimation of consecutive frames run at the same time. Maximum number "
+          "of frames waiting between two stages of the pipeline (0 = Disable)")
+      ("useTracking", po::value<bool>(&useTracking)->default_value(useTracking),
+          "[voctree] Localize the frames by tracking the landmarks of the previous frame, "
+          "the database is queried only if the tracking fails (AllResults only).")
+      ("trackingWindow", po::value<double>(&trackingWindow)->default_value(trackingWindow),
+          "[voctree] Radius (in pixels) of the search window around the projection of a tracked landmark.")
+      ("trackingMinInliers", po::value<std::size_t>(&trackingMinInliers)->default_value(trackingMinInliers),
+          "[voctree] Minimum number of inliers to accept a frame localized by tracking.")
 // cctag specific options
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
       ("nNearestKeyFrames", po::value<size_t>(&nNearestKeyFrames)->default_value(nNearestKeyFrames), 
@@ -215,7 +244,11 @@ int main(int argc, char** argv)
           "[bundle adjustment] It does not refine intrinsics during BA")
       ("minPointVisibility", po::value<size_t>(&minPointVisibility)->default_value(minPointVisibility), 
           "[bundle adjustment] Minimum number of observation that a point must "
-          "have in order to be considered for bundle adjustment");
+          "have in order to be considered for bundle adjustment")
+      ("refineWindow", po::value<std::size_t>(&refineWindow)->default_value(refineWindow),
+          "[bundle adjustment] Refine each localized frame online with the last N frames of the "
+          "sequence, the older frames are kept constant (0 = Disable). The intrinsics are refined "
+          "unless --noBArefineIntrinsics is set.");
   
 // output options
   po::options_description outputParams("Options for the output of the localizer");
@@ -320,13 +353,15 @@ int main(int argc, char** argv)
   std::unique_ptr<localization::LocalizerParameters> param;
   
   std::unique_ptr<localization::ILocalizer> localizer;
+  /// the voctree localizer, if used
+  localization::VoctreeLocalizer* voctreeLocalizer = nullptr;
   
   // initialize the localizer according to the chosen type of describer
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
   if(!useVoctreeLocalizer)
   {
-    localization::CCTagLocalizer* tmpLoc = new localization::CCTagLocalizer(sfmData, descriptorsFolder);
+    localization::CCTagLocalizer* tmpLoc = new localization::CCTagLocalizer(sfmData, descriptorsFolder, localizationDatabaseFolder);
     localizer.reset(tmpLoc);
 
     localization::CCTagLocalizer::Parameters* tmpParam = new localization::CCTagLocalizer::Parameters();
@@ -341,9 +376,11 @@ int main(int argc, char** argv)
                                                    descriptorsFolder,
                                                    vocTreeFilepath,
                                                    weightsFilepath,
-                                                   matchDescTypes);
+                                                   matchDescTypes,
+                                                   localizationDatabaseFolder);
 
     localizer.reset(tmpLoc);
+    voctreeLocalizer = tmpLoc;
     
     localization::VoctreeLocalizer::Parameters *tmpParam = new localization::VoctreeLocalizer::Parameters();
     param.reset(tmpParam);
@@ -355,6 +392,9 @@ int main(int argc, char** argv)
     tmpParam->_matchingError = matchingErrorMax;
     tmpParam->_nbFrameBufferMatching = nbFrameBufferMatching;
     tmpParam->_useRobustMatching = robustMatching;
+    tmpParam->_useTracking = useTracking;
+    tmpParam->_trackingWindow = trackingWindow;
+    tmpParam->_trackingMinInliers = trackingMinInliers;
   }
   
   assert(localizer);
@@ -407,46 +447,123 @@ int main(int argc, char** argv)
   bacc::accumulator_set<double, bacc::stats<bacc::tag::mean, bacc::tag::min, bacc::tag::max, bacc::tag::sum > > stats;
   
   std::vector<localization::LocalizationResult> vec_localizationResults;
+
+  std::unique_ptr<localization::SequenceRefiner> sequenceRefiner;
+  if(refineWindow > 0)
+    sequenceRefiner.reset(new localization::SequenceRefiner(refineWindow, 3, !noBArefineIntrinsics));
   
-  while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+  // save the localization result of a frame, the frames are saved in order
+  const auto saveFrame = [&](const localization::LocalizationResult& localizationResult,
+                             const camera::PinholeRadialK3& frameIntrinsics,
+                             const std::string& imageName,
+                             std::size_t frameId)
   {
-    ALICEVISION_COUT("******************************");
-    ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
-    ALICEVISION_COUT("******************************");
-    localization::LocalizationResult localizationResult;
-    auto detect_start = std::chrono::steady_clock::now();
-    localizer->localize(imageGrey, 
-                       param.get(),
-                       hasIntrinsics /*useInputIntrinsics*/,
-                       queryIntrinsics,
-                       localizationResult,
-                       currentImgName);
-    auto detect_end = std::chrono::steady_clock::now();
-    auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-    ALICEVISION_COUT("\nLocalization took  " << detect_elapsed.count() << " [ms]");
-    stats(detect_elapsed.count());
-    
     vec_localizationResults.emplace_back(localizationResult);
+    localization::LocalizationResult& savedResult = vec_localizationResults.back();
+    const camera::PinholeRadialK3* savedIntrinsics = &frameIntrinsics;
+
+    // refine the frame with the previous frames of the window
+    if(sequenceRefiner != nullptr && savedResult.isValid())
+    {
+      const std::size_t resultIndex = vec_localizationResults.size() - 1;
+      if(sequenceRefiner->refineFrame(resultIndex, savedResult))
+      {
+        std::map<std::size_t, geometry::Pose3> windowPoses;
+        sequenceRefiner->getWindowPoses(windowPoses);
+        for(const auto& windowPose : windowPoses)
+          vec_localizationResults.at(windowPose.first).setPose(windowPose.second);
+        savedIntrinsics = &savedResult.getIntrinsics();
+      }
+      else
+      {
+        ALICEVISION_LOG_WARNING("Unable to refine frame " << frameId);
+      }
+    }
 
     // save data
-    if(localizationResult.isValid())
+    if(savedResult.isValid())
     {
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
-      exporter.addCameraKeyframe(localizationResult.getPose(), &queryIntrinsics, currentImgName, frameCounter, frameCounter);
+      exporter.addCameraKeyframe(savedResult.getPose(), savedIntrinsics, imageName, frameId, frameId);
 #endif
       
       goodFrameCounter++;
-      goodFrameList.push_back(currentImgName + " : " + std::to_string(localizationResult.getIndMatch3D2D().size()) );
+      goodFrameList.push_back(imageName + " : " + std::to_string(localizationResult.getIndMatch3D2D().size()) );
     }
     else
     {
-      ALICEVISION_CERR("Unable to localize frame " << frameCounter);
+      ALICEVISION_CERR("Unable to localize frame " << frameId);
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
-      exporter.jumpKeyframe(currentImgName);
+      exporter.jumpKeyframe(imageName);
 #endif
     }
-    ++frameCounter;
-    feed.goToNextFrame();
+  };
+
+  if(voctreeLocalizer != nullptr && pipelineQueueSize > 0)
+  {
+    // start time of the frames in the pipeline
+    std::map<std::size_t, std::chrono::steady_clock::time_point> framesStart;
+    std::mutex framesStartMutex;
+
+    // called from the extraction stage
+    const auto readFrame = [&](localization::SequenceFrame& frame)
+    {
+      if(frameCounter > 0)
+        feed.goToNextFrame();
+
+      if(!feed.readImage(frame.imageGrey, frame.queryIntrinsics, frame.imagePath, frame.useInputIntrinsics))
+        return false;
+
+      frame.frameId = frameCounter++;
+      std::lock_guard<std::mutex> lock(framesStartMutex);
+      framesStart[frame.frameId] = std::chrono::steady_clock::now();
+      return true;
+    };
+
+    // called from the pose estimation stage, in the frames order
+    const auto onLocalized = [&](const localization::SequenceFrame& frame, const localization::LocalizationResult& localizationResult)
+    {
+      std::chrono::steady_clock::time_point frameStart;
+      {
+        std::lock_guard<std::mutex> lock(framesStartMutex);
+        frameStart = framesStart.at(frame.frameId);
+        framesStart.erase(frame.frameId);
+      }
+      const auto frameElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - frameStart);
+      ALICEVISION_COUT("FRAME " << myToString(frame.frameId, 4) << ": localization took " << frameElapsed.count() << " [ms]");
+      stats(frameElapsed.count());
+
+      currentImgName = frame.imagePath;
+      saveFrame(localizationResult, frame.queryIntrinsics, frame.imagePath, frame.frameId);
+    };
+
+    voctreeLocalizer->localizeSequence(readFrame, param.get(), onLocalized, pipelineQueueSize);
+  }
+  else
+  {
+    while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+    {
+      ALICEVISION_COUT("******************************");
+      ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
+      ALICEVISION_COUT("******************************");
+      localization::LocalizationResult localizationResult;
+      auto detect_start = std::chrono::steady_clock::now();
+      localizer->localize(imageGrey, 
+                         param.get(),
+                         hasIntrinsics /*useInputIntrinsics*/,
+                         queryIntrinsics,
+                         localizationResult,
+                         currentImgName);
+      auto detect_end = std::chrono::steady_clock::now();
+      auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+      ALICEVISION_COUT("\nLocalization took  " << detect_elapsed.count() << " [ms]");
+      stats(detect_elapsed.count());
+
+      saveFrame(localizationResult, queryIntrinsics, currentImgName, frameCounter);
+
+      ++frameCounter;
+      feed.goToNextFrame();
+    }
   }
 
   if(wantsJsonOutput)
@@ -12,7 +12,9 @@
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/config.hpp>
 
 #include <boost/program_options.hpp>
@@ -98,6 +100,8 @@ int main(int argc, char **argv)
 
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
+  ALICEVISION_PROFILE_REPORT();
+  system::MemoryReport memoryReport("computeStructureFromKnownPoses");
   
   // load input SfMData scene
   sfmData::SfMData sfmData;
@@ -13,7 +13,9 @@
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/gpu/gpu.hpp>
 
 #include <boost/program_options.hpp>
@@ -22,7 +24,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 5
 
 using namespace aliceVision;
 
@@ -53,6 +55,10 @@ int main(int argc, char* argv[])
     int sgmWSH = 4;
     double sgmGammaC = 5.5;
     double sgmGammaP = 8.0;
+    bool sgmStreamVolume = false;
+    bool sgmCoarseToFine = false;
+    int sgmCoarseToFineFactor = 4;
+    int sgmCoarseToFineDepthsMargin = 32;
 
     // refineRc
     int refineMaxTCams = 6;
@@ -65,8 +71,14 @@ int main(int argc, char* argv[])
     double refineGammaP = 8.0;
     bool refineUseTcOrRcPixSize = false;
 
+    // tiles
+    bool useTiles = false;
+    int sgmTileOverlap = 16;
+
     // intermediate results
     bool exportIntermediateResults = false;
+    bool tiledHalfMaps = false;
+    bool exportDeviceProfile = false;
 
     // number of GPUs to use (0 means use all GPUs)
     int nbGPUs = 0;
@@ -103,6 +115,16 @@ int main(int argc, char* argv[])
             "Semi Global Matching: GammaC threshold.")
         ("sgmGammaP", po::value<double>(&sgmGammaP)->default_value(sgmGammaP),
             "Semi Global Matching: GammaP threshold.")
+        ("sgmStreamVolume", po::value<bool>(&sgmStreamVolume)->default_value(sgmStreamVolume),
+            "Semi Global Matching: Stream the similarity volume from the host during the optimization "
+            "instead of keeping it in GPU memory (less GPU memory, more transfers).")
+        ("sgmCoarseToFine", po::value<bool>(&sgmCoarseToFine)->default_value(sgmCoarseToFine),
+            "Semi Global Matching: Compute a coarse SGM first, then sweep each tile of rows only around "
+            "the depths found by the coarse SGM.")
+        ("sgmCoarseToFineFactor", po::value<int>(&sgmCoarseToFineFactor)->default_value(sgmCoarseToFineFactor),
+            "Semi Global Matching: Pixel step factor of the coarse SGM.")
+        ("sgmCoarseToFineDepthsMargin", po::value<int>(&sgmCoarseToFineDepthsMargin)->default_value(sgmCoarseToFineDepthsMargin),
+            "Semi Global Matching: Number of depths swept on each side of the range found by the coarse SGM.")
         ("refineMaxTCams", po::value<int>(&refineMaxTCams)->default_value(refineMaxTCams),
             "Refine: Number of neighbour cameras.")
         ("refineNSamplesHalf", po::value<int>(&refineNSamplesHalf)->default_value(refineNSamplesHalf),
@@ -121,8 +143,18 @@ int main(int argc, char* argv[])
             "Refine: GammaP threshold.")
         ("refineUseTcOrRcPixSize", po::value<bool>(&refineUseTcOrRcPixSize)->default_value(refineUseTcOrRcPixSize),
             "Refine: Use current camera pixel size or minimum pixel size of neighbour cameras.")
+        ("useTiles", po::value<bool>(&useTiles)->default_value(useTiles),
+            "Process the images by overlapping tiles sized from the free GPU memory.")
+        ("sgmTileOverlap", po::value<int>(&sgmTileOverlap)->default_value(sgmTileOverlap),
+            "Semi Global Matching: Number of rows shared by two consecutive tiles.")
         ("exportIntermediateResults", po::value<bool>(&exportIntermediateResults)->default_value(exportIntermediateResults),
             "Export intermediate results from the SGM and Refine steps.")
+        ("tiledHalfMaps", po::value<bool>(&tiledHalfMaps)->default_value(tiledHalfMaps),
+            "Write the depth and similarity maps as half float tiled EXR files with MIP levels "
+            "(half the size on disk, the depths are rounded to about 0.05% of their value).")
+        ("exportDeviceProfile", po::value<bool>(&exportDeviceProfile)->default_value(exportDeviceProfile),
+            "Write the time, transfer time and peak device memory of the device stages of each depth map "
+            "in <viewId>_deviceProfile.json (the device is synchronized at each stage and transfer).")
         ("nbGPUs", po::value<int>(&nbGPUs)->default_value(nbGPUs),
             "Number of GPUs to use (0 means use all GPUs).");
 
@@ -165,6 +197,8 @@ int main(int argc, char* argv[])
 
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
+    ALICEVISION_PROFILE_REPORT();
+    system::MemoryReport memoryReport("depthMapEstimation");
 
     // print GPU Information
     ALICEVISION_LOG_INFO(gpu::gpuInformationCUDA());
@@ -172,8 +206,7 @@ int main(int argc, char* argv[])
     // check if the gpu suppport CUDA compute capability 2.0
     if(!gpu::gpuSupportCUDA(2,0))
     {
-      ALICEVISION_LOG_ERROR("This program needs a CUDA-Enabled GPU (with at least compute capability 2.0).");
-      return EXIT_FAILURE;
+      ALICEVISION_LOG_WARNING("No CUDA-Enabled GPU (with at least compute capability 2.0), the depth maps are computed on the CPU.");
     }
 
     // check if the scale is correct
@@ -204,6 +237,10 @@ int main(int argc, char* argv[])
     mp.userParams.put("semiGlobalMatching.wsh", sgmWSH);
     mp.userParams.put("semiGlobalMatching.gammaC", sgmGammaC);
     mp.userParams.put("semiGlobalMatching.gammaP", sgmGammaP);
+    mp.userParams.put("semiGlobalMatching.streamVolume", sgmStreamVolume);
+    mp.userParams.put("semiGlobalMatching.coarseToFine", sgmCoarseToFine);
+    mp.userParams.put("semiGlobalMatching.coarseToFineFactor", sgmCoarseToFineFactor);
+    mp.userParams.put("semiGlobalMatching.coarseToFineDepthsMargin", sgmCoarseToFineDepthsMargin);
 
     // refineRc
     mp.userParams.put("refineRc.maxTCams", refineMaxTCams);
@@ -216,8 +253,16 @@ int main(int argc, char* argv[])
     mp.userParams.put("refineRc.gammaP", refineGammaP);
     mp.userParams.put("refineRc.useTcOrRcPixSize", refineUseTcOrRcPixSize);
 
+    // tiles
+    mp.userParams.put("depthMap.useTiles", useTiles);
+    mp.userParams.put("semiGlobalMatching.tileOverlap", sgmTileOverlap);
+
     // intermediate results
     mp.userParams.put("depthMap.intermediateResults", exportIntermediateResults);
+    mp.userParams.put("depthMap.deviceProfile", exportDeviceProfile);
+
+    // output maps storage
+    mp.userParams.put("global.tiledHalfMaps", tiledHalfMaps);
 
     std::vector<int> cams;
     cams.reserve(mp.ncams);
@@ -12,9 +12,12 @@
 #include <aliceVision/mvsUtils/MultiViewParams.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include <aliceVision/depthMap/RefineRc.hpp>
+#include <aliceVision/depthMap/PlaneSweeping.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -22,7 +25,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 2
 
 using namespace aliceVision;
 
@@ -51,6 +54,8 @@ int main(int argc, char* argv[])
     int pixSizeBallWithLowSimilarity = 0;
     int nNearestCams = 10;
     bool computeNormalMaps = false;
+    bool tiledHalfMaps = false;
+    bool exportDeviceProfile = false;
 
     po::options_description allParams("AliceVision depthMapFiltering\n"
                                       "Filter depth map to remove values that are not consistent with other depth maps");
@@ -85,7 +90,13 @@ int main(int argc, char* argv[])
         ("nNearestCams", po::value<int>(&nNearestCams)->default_value(nNearestCams),
             "Number of nearest cameras.")
         ("computeNormalMaps", po::value<bool>(&computeNormalMaps)->default_value(computeNormalMaps),
-            "Compute normal maps per depth map");
+            "Compute normal maps per depth map")
+        ("tiledHalfMaps", po::value<bool>(&tiledHalfMaps)->default_value(tiledHalfMaps),
+            "Write the filtered depth and similarity maps as half float tiled EXR files with MIP levels "
+            "(half the size on disk, the depths are rounded to about 0.05% of their value).")
+        ("exportDeviceProfile", po::value<bool>(&exportDeviceProfile)->default_value(exportDeviceProfile),
+            "Write the time, transfer time and peak device memory of the consistency filtering of each depth map "
+            "in <viewId>_deviceProfile.json when it runs on a CUDA device.");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -126,6 +137,8 @@ int main(int argc, char* argv[])
 
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
+    ALICEVISION_PROFILE_REPORT();
+    system::MemoryReport memoryReport("depthMapFiltering");
 
     // read the input SfM scene
     sfmData::SfMData sfmData;
@@ -140,6 +153,8 @@ int main(int argc, char* argv[])
 
     mp.setMinViewAngle(minViewAngle);
     mp.setMaxViewAngle(maxViewAngle);
+    mp.userParams.put("global.tiledHalfMaps", tiledHalfMaps);
+    mp.userParams.put("depthMap.deviceProfile", exportDeviceProfile);
 
     StaticVector<int> cams;
     cams.reserve(mp.ncams);
@@ -169,7 +184,13 @@ int main(int argc, char* argv[])
 
     {
         fuseCut::Fuser fs(&mp);
-        fs.filterGroups(cams, pixSizeBall, pixSizeBallWithLowSimilarity, nNearestCams);
+
+        // count the consistent cameras on the CUDA devices if any, on the CPU threads otherwise
+        if(depthMap::listCUDADevices(false) > 0)
+            depthMap::computeNbConsistentCamsMaps(&mp, cams, pixSizeBall, pixSizeBallWithLowSimilarity, nNearestCams);
+        else
+            fs.filterGroups(cams, pixSizeBall, pixSizeBallWithLowSimilarity, nNearestCams);
+
         fs.filterDepthMaps(cams, minNumOfConsistentCams, minNumOfConsistentCamsWithLowSimilarity);
     }
 
@@ -10,16 +10,23 @@
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/feature.hpp>
+#include <aliceVision/feature/featuresCache.hpp>
+#include <aliceVision/feature/memoryProfile.hpp>
+#include <aliceVision/feature/tiledExtraction.hpp>
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_POPSIFT) \
  || ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
 #define ALICEVISION_HAVE_GPU_FEATURES
 #include <aliceVision/gpu/gpu.hpp>
 #endif
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/system/RingBuffer.hpp>
+#include <aliceVision/system/MemoryBudget.hpp>
 #include <aliceVision/system/MemoryInfo.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/config.hpp>
 
 #include <boost/program_options.hpp>
@@ -37,7 +44,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -51,6 +58,8 @@ class FeatureExtractor
     const sfmData::View& view;
     std::size_t memoryConsuption = 0;
     std::string outputBasename;
+    /// image content hash, empty if the features cache is not used
+    std::string imageHash;
     std::vector<std::size_t> cpuImageDescriberIndexes;
     std::vector<std::size_t> gpuImageDescriberIndexes;
 
@@ -80,18 +89,30 @@ class FeatureExtractor
       return outputBasename + "." + feature::EImageDescriberType_enumToString(imageDescriberType) + ".desc";
     }
 
-    void setImageDescribers(const std::vector<std::shared_ptr<feature::ImageDescriber>>& imageDescribers)
+    std::string getRegionsContainerPath(feature::EImageDescriberType imageDescriberType) const
+    {
+      return outputBasename + "." + feature::EImageDescriberType_enumToString(imageDescriberType) + ".regions";
+    }
+
+    void setImageDescribers(const std::vector<std::shared_ptr<feature::ImageDescriber>>& imageDescribers,
+                            int tileSize,
+                            int tileOverlap,
+                            const feature::ImageDescriberMemoryProfile& memoryProfile)
     {
       for(std::size_t i = 0; i < imageDescribers.size(); ++i)
       {
         const std::shared_ptr<feature::ImageDescriber>& imageDescriber = imageDescribers.at(i);
         feature::EImageDescriberType imageDescriberType = imageDescriber->getDescriberType();
 
-        if(fs::exists(getFeaturesPath(imageDescriberType)) &&
-           fs::exists(getDescriptorPath(imageDescriberType)))
+        if(fs::exists(getRegionsContainerPath(imageDescriberType)) ||
+           (fs::exists(getFeaturesPath(imageDescriberType)) &&
+            fs::exists(getDescriptorPath(imageDescriberType))))
           continue;
 
-        memoryConsuption += imageDescriber->getMemoryConsumption(view.getWidth(), view.getHeight());
+        if(feature::useTiledExtraction(imageDescriberType, tileSize))
+          memoryConsuption += feature::getTiledMemoryConsumption(*imageDescriber, view.getWidth(), view.getHeight(), tileSize, tileOverlap, &memoryProfile);
+        else
+          memoryConsuption += memoryProfile.getMemoryConsumption(*imageDescriber, view.getWidth(), view.getHeight());
 
         if(imageDescriber->useCuda())
           gpuImageDescriberIndexes.push_back(i);
@@ -101,6 +122,29 @@ class FeatureExtractor
     }
   };
 
+  /// decoded image of a view job, output of the decode stage
+  struct ViewImage
+  {
+    const ViewJob& job;
+    image::Image<float> imageGrayFloat;
+
+    explicit ViewImage(const ViewJob& job)
+      : job(job)
+    {}
+  };
+
+  /// extracted regions of a view job, output of the describe stage
+  struct ViewRegions
+  {
+    const ViewJob& job;
+    /// image describer index and extracted regions
+    std::vector<std::pair<std::size_t, std::unique_ptr<feature::Regions>>> regionsPerDescriber;
+
+    explicit ViewRegions(const ViewJob& job)
+      : job(job)
+    {}
+  };
+
 public:
 
   explicit FeatureExtractor(const sfmData::SfMData& sfmData)
@@ -123,33 +167,126 @@ public:
     _outputFolder = folder;
   }
 
+  void setUseRegionsContainer(bool useRegionsContainer)
+  {
+    _useRegionsContainer = useRegionsContainer;
+  }
+
+  void setImageDescriberPreset(const std::string& preset)
+  {
+    _imageDescriberPreset = preset;
+  }
+
+  void setGpuJobsPerDevice(int gpuJobsPerDevice)
+  {
+    _gpuJobsPerDevice = std::max(1, gpuJobsPerDevice);
+  }
+
+  void setTiles(int tileSize, int tileOverlap)
+  {
+    _tileSize = std::max(0, tileSize);
+    _tileOverlap = std::max(0, tileOverlap);
+  }
+
+  void setMemoryProfile(const feature::ImageDescriberMemoryProfile& memoryProfile)
+  {
+    _memoryProfile = memoryProfile;
+  }
+
+  void setFeaturesCache(const std::string& folder)
+  {
+    _featuresCache.reset(folder.empty() ? nullptr : new feature::FeaturesCache(folder));
+  }
+
   void addImageDescriber(std::shared_ptr<feature::ImageDescriber>& imageDescriber)
   {
     _imageDescribers.push_back(imageDescriber);
   }
 
-  void process()
+  /**
+   * @brief Measure the memory consumption of the CPU image describers on the biggest image of the range
+   * @return the memory profile, empty if the memory can't be measured on this system
+   */
+  feature::ImageDescriberMemoryProfile calibrateMemoryProfile() const
   {
-    // iteration on each view in the range in order
-    // to prepare viewJob stack
-    sfmData::Views::const_iterator itViewBegin = _sfmData.getViews().begin();
-    sfmData::Views::const_iterator itViewEnd = _sfmData.getViews().end();
+    feature::ImageDescriberMemoryProfile memoryProfile(_imageDescriberPreset);
 
-    if(_rangeStart != -1)
+    sfmData::Views::const_iterator itViewBegin;
+    sfmData::Views::const_iterator itViewEnd;
+    getViewsRange(itViewBegin, itViewEnd);
+
+    const sfmData::View* calibrationView = nullptr;
+    for(auto it = itViewBegin; it != itViewEnd; ++it)
     {
-      std::advance(itViewBegin, _rangeStart);
-      itViewEnd = itViewBegin;
-      std::advance(itViewEnd, _rangeSize);
+      const sfmData::View* view = it->second.get();
+      if(calibrationView == nullptr ||
+         view->getWidth() * view->getHeight() > calibrationView->getWidth() * calibrationView->getHeight())
+        calibrationView = view;
+    }
+
+    if(calibrationView == nullptr)
+      return memoryProfile;
+
+    ALICEVISION_LOG_INFO("Memory calibration on view '" << calibrationView->getImagePath() << "'");
+
+    image::Image<float> imageGrayFloat;
+    image::readImage(calibrationView->getImagePath(), imageGrayFloat, image::EImageColorSpace::SRGB);
+
+    for(const auto& imageDescriber : _imageDescribers)
+    {
+      // GPU describers mostly use the device memory
+      if(imageDescriber->useCuda())
+        continue;
+
+      const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType());
+      feature::DescriberMemoryModel model;
+
+      if(!feature::measureDescriberMemoryModel(*imageDescriber, imageGrayFloat, model))
+      {
+        ALICEVISION_LOG_WARNING("Cannot measure the process memory on this system, the memory calibration is skipped.");
+        return feature::ImageDescriberMemoryProfile(_imageDescriberPreset);
+      }
+
+      ALICEVISION_LOG_INFO("Memory model of " << imageDescriberTypeName << ": "
+                           << model.bytesPerPixel * 1000000.0 / (1024.0 * 1024.0) << " MB per megapixel + "
+                           << model.overhead / (1024 * 1024) << " MB (estimated "
+                           << imageDescriber->getMemoryConsumption(imageGrayFloat.Width(), imageGrayFloat.Height()) / (1024 * 1024)
+                           << " MB, measured " << model.getMemoryConsumption(imageGrayFloat.Width(), imageGrayFloat.Height()) / (1024 * 1024)
+                           << " MB for the calibration image)");
+
+      memoryProfile.setModel(imageDescriber->getDescriberType(), model);
     }
+    return memoryProfile;
+  }
+
+  void process()
+  {
+    // iteration on each view in the range in order
+    // to prepare viewJob stack
+    sfmData::Views::const_iterator itViewBegin;
+    sfmData::Views::const_iterator itViewEnd;
+    getViewsRange(itViewBegin, itViewEnd);
 
     std::size_t jobMaxMemoryConsuption = 0;
 
-    for(auto it = itViewBegin; it != itViewEnd; ++it)
+    // image content hashes for the features cache
+    std::vector<std::string> imageHashes;
+    if(_featuresCache)
+      imageHashes = computeImageHashes(itViewBegin, itViewEnd);
+
+    std::size_t viewIndex = 0;
+    for(auto it = itViewBegin; it != itViewEnd; ++it, ++viewIndex)
     {
       const sfmData::View& view = *(it->second.get());
       ViewJob viewJob(view, _outputFolder);
 
-      viewJob.setImageDescribers(_imageDescribers);
+      if(_featuresCache)
+      {
+        viewJob.imageHash = imageHashes.at(viewIndex);
+        restoreFromFeaturesCache(viewJob);
+      }
+
+      viewJob.setImageDescribers(_imageDescribers, _tileSize, _tileOverlap, _memoryProfile);
       jobMaxMemoryConsuption = std::max(jobMaxMemoryConsuption, viewJob.memoryConsuption);
 
       if(viewJob.useCPU())
@@ -159,94 +296,437 @@ public:
         _gpuJobs.push_back(viewJob);
     }
 
-    if(!_cpuJobs.empty())
+    // GPU jobs are spread over all the supported devices by gpuJobsPerDevice lanes per device,
+    // see computeGpuJobs(). They run while the CPU threads process the CPU jobs.
+    const std::vector<int> gpuDevices = getGpuDevices();
+    const std::size_t nbGpuLanes = _gpuJobs.empty() ? 0 : std::min(_gpuJobs.size(), gpuDevices.size() * _gpuJobsPerDevice);
+
+    if(!_cpuJobs.empty() && jobMaxMemoryConsuption == 0)
+      throw std::runtime_error("Cannot compute feature extraction job max memory consumption.");
+
+    omp_set_nested(1);
+
+#pragma omp parallel sections num_threads(2)
     {
-      system::MemoryInfo memoryInformation = system::getMemoryInfo();
+#pragma omp section
+      {
+        if(nbGpuLanes > 0)
+          computeGpuJobs(gpuDevices, nbGpuLanes);
+      }
+#pragma omp section
+      {
+        if(!_cpuJobs.empty())
+          computeCpuJobs(jobMaxMemoryConsuption, nbGpuLanes);
+      }
+    }
+  }
+
+private:
+
+  /**
+   * @brief Get the views of the extraction range
+   * @param[out] itViewBegin The first view of the range
+   * @param[out] itViewEnd The end of the range
+   */
+  void getViewsRange(sfmData::Views::const_iterator& itViewBegin, sfmData::Views::const_iterator& itViewEnd) const
+  {
+    itViewBegin = _sfmData.getViews().begin();
+    itViewEnd = _sfmData.getViews().end();
+
+    if(_rangeStart != -1)
+    {
+      std::advance(itViewBegin, _rangeStart);
+      itViewEnd = itViewBegin;
+      std::advance(itViewEnd, _rangeSize);
+    }
+  }
+
+  /**
+   * @brief Get the CUDA devices used for the GPU jobs
+   * @return the CUDA device ids, at least one
+   */
+  std::vector<int> getGpuDevices() const
+  {
+    std::vector<int> devices;
+#ifdef ALICEVISION_HAVE_GPU_FEATURES
+    if(!_gpuJobs.empty())
+      devices = gpu::gpuSupportedDevicesCUDA(3, 0);
+#endif
+    if(devices.empty())
+      devices.push_back(0);
+    return devices;
+  }
+
+  /**
+   * @brief Compute the CPU jobs, packing as many jobs as the available memory allows
+   * @param[in] jobMaxMemoryConsuption The maximum memory consumption of one job
+   * @param[in] nbGpuLanes The number of GPU jobs running at the same time
+   */
+  void computeCpuJobs(std::size_t jobMaxMemoryConsuption, std::size_t nbGpuLanes)
+  {
+    system::MemoryInfo memoryInformation = system::getMemoryInfo();
 
-      ALICEVISION_LOG_DEBUG("Job max memory consumption: " << jobMaxMemoryConsuption << " B");
-      ALICEVISION_LOG_DEBUG("Memory information: " << std::endl <<memoryInformation);
+    ALICEVISION_LOG_DEBUG("Job max memory consumption: " << jobMaxMemoryConsuption << " B");
+    ALICEVISION_LOG_DEBUG("Memory information: " << std::endl <<memoryInformation);
 
-      if(jobMaxMemoryConsuption == 0)
-        throw std::runtime_error("Cannot compute feature extraction job max memory consumption.");
+    // reclaimable caches are available for the jobs too
+    const std::size_t availableRam = memoryInformation.availableRam;
 
-      std::size_t nbThreads =  (0.9 * memoryInformation.freeRam) / jobMaxMemoryConsuption;
+    // keep the memory used by the GPU jobs running in parallel
+    const std::size_t gpuLanesMemory = nbGpuLanes * jobMaxMemoryConsuption;
+    const std::size_t freeRam = (0.9 * availableRam > gpuLanesMemory) ? (0.9 * availableRam - gpuLanesMemory) : 0;
 
-      if(memoryInformation.freeRam == 0)
+    // the jobs have different sizes, the number of threads allows to run the smallest jobs together
+    // and the memory budget limits the jobs running at the same time (see computeCpuPipeline)
+    std::size_t jobMinMemoryConsuption = jobMaxMemoryConsuption;
+    for(const auto& job : _cpuJobs)
+      if(job.memoryConsuption > 0)
+        jobMinMemoryConsuption = std::min(jobMinMemoryConsuption, job.memoryConsuption);
+
+    std::size_t nbThreads = std::max(std::size_t(1), freeRam / jobMinMemoryConsuption);
+
+    if(availableRam == 0)
+    {
+      ALICEVISION_LOG_WARNING("Cannot find available system memory, this can be due to OS limitations.\n"
+                              "Use only one thread for CPU feature extraction.");
+      nbThreads = 1;
+    }
+
+    // nbThreads should not be higher than user maxThreads param
+    if(_maxThreads > 0)
+      nbThreads = std::min(static_cast<std::size_t>(_maxThreads), nbThreads);
+
+    // nbThreads should not be higher than the core number
+    nbThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), nbThreads);
+
+    // nbThreads should not be higher than the job number
+    nbThreads = std::min(_cpuJobs.size(), nbThreads);
+
+    ALICEVISION_LOG_DEBUG("# threads for extraction: " << nbThreads);
+
+    // decode stage concurrency: each decoder holds one image being read
+    // and one decoded image waiting for a describer, use the memory left by the describers
+    std::size_t imageMaxMemoryConsuption = 0;
+    for(const auto& job : _cpuJobs)
+      imageMaxMemoryConsuption = std::max(imageMaxMemoryConsuption, job.view.getWidth() * job.view.getHeight() * 4 * sizeof(float));
+
+    // the decoders can use the memory not needed by the biggest job, at most a quarter of the memory
+    const std::size_t decodersFreeRam = (freeRam > jobMaxMemoryConsuption) ? std::min(freeRam - jobMaxMemoryConsuption, freeRam / 4) : 0;
+    std::size_t nbDecodeThreads = (imageMaxMemoryConsuption > 0) ? decodersFreeRam / (2 * imageMaxMemoryConsuption) : nbThreads;
+    nbDecodeThreads = std::max(std::size_t(1), std::min(nbThreads, nbDecodeThreads));
+
+    // the describers share the memory left by the decoders
+    const std::size_t decodersMemory = nbDecodeThreads * 2 * imageMaxMemoryConsuption;
+    const std::size_t describersMemory = (freeRam > decodersMemory) ? (freeRam - decodersMemory) : 0;
+
+    // serialize stage concurrency: regions are small, a few writers are enough to hide I/O waits
+    const std::size_t nbWriteThreads = std::max(std::size_t(1), std::min(nbThreads, std::size_t(2)));
+
+    ALICEVISION_LOG_DEBUG("# threads for decoding: " << nbDecodeThreads << ", writing: " << nbWriteThreads);
+    ALICEVISION_LOG_DEBUG("Memory budget of the describers: " << describersMemory << " B");
+
+    computeCpuPipeline(nbDecodeThreads, nbThreads, nbWriteThreads, describersMemory);
+  }
+
+  /**
+   * @brief Compute the CPU jobs with a bounded three stages pipeline: decode -> describe -> serialize
+   *
+   * Each stage has its own threads and the stages are connected by bounded queues,
+   * so that image reading and features writing don't stall the describers.
+   *
+   * @param[in] nbDecodeThreads The number of threads reading the images
+   * @param[in] nbDescribeThreads The number of threads extracting the features
+   * @param[in] nbWriteThreads The number of threads writing the features
+   * @param[in] describersMemory The memory shared by the describe threads, each job reserves its memory consumption
+   */
+  void computeCpuPipeline(std::size_t nbDecodeThreads, std::size_t nbDescribeThreads, std::size_t nbWriteThreads, std::size_t describersMemory)
+  {
+    system::RingBuffer<std::shared_ptr<ViewImage>> decodedQueue(nbDecodeThreads);
+    system::RingBuffer<std::shared_ptr<ViewRegions>> describedQueue(nbDescribeThreads);
+    system::MemoryBudget describersBudget(describersMemory);
+
+#pragma omp parallel num_threads(3)
+    {
+      if(omp_get_num_threads() < 3)
+      {
+        // the stages can't run at the same time, process the jobs one by one
+#pragma omp single
+        {
+          ALICEVISION_LOG_WARNING("Cannot run the feature extraction pipeline, process the views sequentially.");
+          for(const auto& job : _cpuJobs)
+            computeViewJob(job, _imageDescribers);
+        }
+      }
+      else if(omp_get_thread_num() == 0)
+      {
+        // decode stage
+#pragma omp parallel for num_threads(nbDecodeThreads) schedule(dynamic)
+        for(int i = 0; i < _cpuJobs.size(); ++i)
+        {
+          std::shared_ptr<ViewImage> viewImage = std::make_shared<ViewImage>(_cpuJobs.at(i));
+          readViewImage(viewImage->job, viewImage->imageGrayFloat);
+          decodedQueue.push(viewImage);
+        }
+        decodedQueue.close();
+      }
+      else if(omp_get_thread_num() == 1)
+      {
+        // describe stage
+#pragma omp parallel num_threads(nbDescribeThreads)
+        {
+          std::shared_ptr<ViewImage> viewImage;
+          while(decodedQueue.pop(viewImage))
+          {
+            std::shared_ptr<ViewRegions> viewRegions = std::make_shared<ViewRegions>(viewImage->job);
+            const std::size_t jobMemory = viewImage->job.memoryConsuption;
+
+            describersBudget.acquire(jobMemory);
+            describeView(viewImage->imageGrayFloat, _imageDescribers, *viewRegions);
+            describersBudget.release(jobMemory);
+
+            viewImage.reset(); // release the image before waiting for the next stage
+            describedQueue.push(viewRegions);
+          }
+        }
+        describedQueue.close();
+      }
+      else if(omp_get_thread_num() == 2)
       {
-        ALICEVISION_LOG_WARNING("Cannot find available system memory, this can be due to OS limitations.\n"
-                                "Use only one thread for CPU feature extraction.");
-        nbThreads = 1;
+        // serialize stage
+#pragma omp parallel num_threads(nbWriteThreads)
+        {
+          std::shared_ptr<ViewRegions> viewRegions;
+          while(describedQueue.pop(viewRegions))
+            saveViewRegions(*viewRegions, _imageDescribers);
+        }
       }
+    }
+  }
 
-      // nbThreads should not be higher than user maxThreads param
-      if(_maxThreads > 0)
-        nbThreads = std::min(static_cast<std::size_t>(_maxThreads), nbThreads);
+  /**
+   * @brief Compute the GPU jobs on all the given devices
+   *
+   * Each lane is a thread with its own image describers bound to one device.
+   * Several lanes per device keep several images in the device pipeline:
+   * while a lane waits for its extraction, another one decodes and uploads the next image.
+   *
+   * @param[in] devices The CUDA device ids
+   * @param[in] nbLanes The number of lanes
+   */
+  void computeGpuJobs(const std::vector<int>& devices, std::size_t nbLanes)
+  {
+    ALICEVISION_LOG_INFO("GPU feature extraction on " << devices.size() << " device(s), " << nbLanes << " job(s) in flight.");
 
-      // nbThreads should not be higher than the core number
-      nbThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), nbThreads);
+#pragma omp parallel num_threads(nbLanes)
+    {
+      const int lane = omp_get_thread_num();
+      const int device = devices.at(lane % devices.size());
+
+      // image describers of the lane
+      std::vector<std::shared_ptr<feature::ImageDescriber>> imageDescribers(_imageDescribers.size());
 
-      // nbThreads should not be higher than the job number
-      nbThreads = std::min(_cpuJobs.size(), nbThreads);
+#pragma omp critical(gpuImageDescribers)
+      {
+        for(std::size_t i = 0; i < _imageDescribers.size(); ++i)
+        {
+          if(!_imageDescribers.at(i)->useCuda())
+            continue;
+
+          std::shared_ptr<feature::ImageDescriber> imageDescriber = feature::createImageDescriber(_imageDescribers.at(i)->getDescriberType());
+          imageDescriber->setConfigurationPreset(_imageDescriberPreset);
+          imageDescriber->setCudaDevice(device);
+          imageDescriber->setCudaPipe(lane);
+          imageDescribers.at(i) = imageDescriber;
+        }
+      }
 
-      ALICEVISION_LOG_DEBUG("# threads for extraction: " << nbThreads);
-      omp_set_nested(1);
+      // wait for all the lanes, creating an image describer can reset the shared GPU resources
+#pragma omp barrier
 
-#pragma omp parallel for num_threads(nbThreads)
-      for(int i = 0; i < _cpuJobs.size(); ++i)
-        computeViewJob(_cpuJobs.at(i));
+#pragma omp for schedule(dynamic)
+      for(int i = 0; i < _gpuJobs.size(); ++i)
+        computeViewJob(_gpuJobs.at(i), imageDescribers, true);
     }
+  }
 
-    if(!_gpuJobs.empty())
+  void computeViewJob(const ViewJob& job,
+                      const std::vector<std::shared_ptr<feature::ImageDescriber>>& imageDescribers,
+                      bool useGPU = false)
+  {
+    ViewRegions viewRegions(job);
     {
-      for(const auto& job : _gpuJobs)
-        computeViewJob(job, true);
+      image::Image<float> imageGrayFloat;
+      readViewImage(job, imageGrayFloat);
+      describeView(imageGrayFloat, imageDescribers, viewRegions, useGPU);
     }
+    saveViewRegions(viewRegions, imageDescribers);
   }
 
-private:
-
-  void computeViewJob(const ViewJob& job, bool useGPU = false)
+  void readViewImage(const ViewJob& job, image::Image<float>& imageGrayFloat) const
   {
-    image::Image<float> imageGrayFloat;
-    image::Image<unsigned char> imageGrayUChar;
+    ALICEVISION_PROFILE_SCOPE("featureExtraction::readViewImage");
 
     image::readImage(job.view.getImagePath(), imageGrayFloat, image::EImageColorSpace::SRGB);
+  }
+
+  void describeView(const image::Image<float>& imageGrayFloat,
+                    const std::vector<std::shared_ptr<feature::ImageDescriber>>& imageDescribers,
+                    ViewRegions& viewRegions,
+                    bool useGPU = false) const
+  {
+    ALICEVISION_PROFILE_SCOPE("featureExtraction::describeView");
+
+    const ViewJob& job = viewRegions.job;
+    image::Image<unsigned char> imageGrayUChar;
 
     const auto imageDescriberIndexes = useGPU ? job.gpuImageDescriberIndexes : job.cpuImageDescriberIndexes;
 
     for(auto& imageDescriberIndex : imageDescriberIndexes)
     {
-      const auto& imageDescriber = _imageDescribers.at(imageDescriberIndex);
+      const auto& imageDescriber = imageDescribers.at(imageDescriberIndex);
       const feature::EImageDescriberType imageDescriberType = imageDescriber->getDescriberType();
       const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
 
-      // Compute features and descriptors and export them to files
+      // Compute features and descriptors
       ALICEVISION_LOG_INFO("Extracting " << imageDescriberTypeName  << " features from view '" << job.view.getImagePath() << "' " << (useGPU ? "[gpu]" : "[cpu]"));
 
       std::unique_ptr<feature::Regions> regions;
-      if(imageDescriber->useFloatImage())
-      {
-        // image buffer use float image, use the read buffer
-        imageDescriber->describe(imageGrayFloat, regions);
-      }
+      feature::describeImage(*imageDescriber, imageGrayFloat, imageGrayUChar, regions, _tileSize, _tileOverlap);
+      viewRegions.regionsPerDescriber.emplace_back(imageDescriberIndex, std::move(regions));
+    }
+  }
+
+  void saveViewRegions(const ViewRegions& viewRegions,
+                       const std::vector<std::shared_ptr<feature::ImageDescriber>>& imageDescribers) const
+  {
+    ALICEVISION_PROFILE_SCOPE("featureExtraction::saveViewRegions");
+
+    const ViewJob& job = viewRegions.job;
+
+    for(const auto& describerRegions : viewRegions.regionsPerDescriber)
+    {
+      const auto& imageDescriber = imageDescribers.at(describerRegions.first);
+      const feature::Regions* regions = describerRegions.second.get();
+      const feature::EImageDescriberType imageDescriberType = imageDescriber->getDescriberType();
+      const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
+
+      // Export features and descriptors to files
+      if(_useRegionsContainer)
+        imageDescriber->SaveContainer(regions, job.getRegionsContainerPath(imageDescriberType));
       else
-      {
-        // image buffer can't use float image
-        if(imageGrayUChar.Width() == 0) // the first time, convert the float buffer to uchar
-          imageGrayUChar = (imageGrayFloat.GetMat() * 255.f).cast<unsigned char>();
-        imageDescriber->describe(imageGrayUChar, regions);
-      }
-      imageDescriber->Save(regions.get(), job.getFeaturesPath(imageDescriberType), job.getDescriptorPath(imageDescriberType));
+        imageDescriber->Save(regions, job.getFeaturesPath(imageDescriberType), job.getDescriptorPath(imageDescriberType));
+
+      if(_featuresCache && !job.imageHash.empty())
+        _featuresCache->store(getFeaturesCacheKey(job, imageDescriberType), getOutputExtensions(imageDescriberType), job.outputBasename);
+
       ALICEVISION_LOG_INFO(std::left << std::setw(6) << " " << regions->RegionCount() << " " << imageDescriberTypeName  << " features extracted from view '" << job.view.getImagePath() << "'");
     }
   }
 
+  /**
+   * @brief Compute the content hash of the images of the given views
+   * @return the image hashes, in the views order
+   */
+  std::vector<std::string> computeImageHashes(const sfmData::Views::const_iterator& itViewBegin,
+                                              const sfmData::Views::const_iterator& itViewEnd) const
+  {
+    ALICEVISION_PROFILE_SCOPE("featureExtraction::computeImageHashes");
+
+    std::vector<const sfmData::View*> views;
+    for(auto it = itViewBegin; it != itViewEnd; ++it)
+      views.push_back(it->second.get());
+
+    std::vector<std::string> imageHashes(views.size());
+
+#pragma omp parallel for schedule(dynamic) num_threads(_maxThreads > 0 ? _maxThreads : omp_get_max_threads())
+    for(int i = 0; i < views.size(); ++i)
+    {
+      imageHashes.at(i) = feature::computeFileContentHash(views.at(i)->getImagePath());
+
+      if(imageHashes.at(i).empty())
+        ALICEVISION_LOG_WARNING("Can't compute the content hash of '" << views.at(i)->getImagePath() << "', the features cache is not used for this image.");
+    }
+    return imageHashes;
+  }
+
+  /**
+   * @brief Get the extensions of the output files of the given image describer type
+   */
+  std::vector<std::string> getOutputExtensions(feature::EImageDescriberType imageDescriberType) const
+  {
+    const std::string imageDescriberTypeName = feature::EImageDescriberType_enumToString(imageDescriberType);
+
+    if(_useRegionsContainer)
+      return {"." + imageDescriberTypeName + ".regions"};
+    return {"." + imageDescriberTypeName + ".feat", "." + imageDescriberTypeName + ".desc"};
+  }
+
+  /**
+   * @brief Get the features cache key of a view job for the given image describer type
+   *
+   * The key depends on the image content and on all the settings that change the extraction result.
+   */
+  std::string getFeaturesCacheKey(const ViewJob& job, feature::EImageDescriberType imageDescriberType) const
+  {
+    bool useCuda = false;
+    for(const auto& imageDescriber : _imageDescribers)
+      if(imageDescriber->getDescriberType() == imageDescriberType)
+        useCuda = imageDescriber->useCuda();
+
+    const int tileSize = feature::useTiledExtraction(imageDescriberType, _tileSize) ? _tileSize : 0;
+
+    std::ostringstream describerSettings;
+    describerSettings << feature::EImageDescriberType_enumToString(imageDescriberType)
+                      << ";preset=" << _imageDescriberPreset
+                      << ";cuda=" << useCuda
+                      << ";tileSize=" << tileSize
+                      << ";tileOverlap=" << (tileSize > 0 ? _tileOverlap : 0);
+
+    return feature::FeaturesCache::getKey(job.imageHash, describerSettings.str());
+  }
+
+  /**
+   * @brief Copy the outputs of the view job found in the features cache to the output folder,
+   *        the corresponding image describers are then skipped by ViewJob::setImageDescribers
+   */
+  void restoreFromFeaturesCache(const ViewJob& job) const
+  {
+    if(job.imageHash.empty())
+      return;
+
+    for(const auto& imageDescriber : _imageDescribers)
+    {
+      const feature::EImageDescriberType imageDescriberType = imageDescriber->getDescriberType();
+
+      if(fs::exists(job.getRegionsContainerPath(imageDescriberType)) ||
+         (fs::exists(job.getFeaturesPath(imageDescriberType)) &&
+          fs::exists(job.getDescriptorPath(imageDescriberType))))
+        continue;
+
+      const std::string key = getFeaturesCacheKey(job, imageDescriberType);
+      const std::vector<std::string> extensions = getOutputExtensions(imageDescriberType);
+
+      if(_featuresCache->has(key, extensions) &&
+         _featuresCache->restore(key, extensions, job.outputBasename))
+        ALICEVISION_LOG_INFO("View '" << job.view.getImagePath() << "': "
+                             << feature::EImageDescriberType_enumToString(imageDescriberType)
+                             << " features restored from the features cache.");
+    }
+  }
+
   const sfmData::SfMData& _sfmData;
   std::vector<std::shared_ptr<feature::ImageDescriber>> _imageDescribers;
   std::string _outputFolder;
   int _rangeStart = -1;
   int _rangeSize = -1;
   int _maxThreads = -1;
+  bool _useRegionsContainer = false;
+  std::string _imageDescriberPreset = feature::EImageDescriberPreset_enumToString(feature::EImageDescriberPreset::NORMAL);
+  int _gpuJobsPerDevice = 2;
+  int _tileSize = 0;
+  int _tileOverlap = 256;
+  feature::ImageDescriberMemoryProfile _memoryProfile;
+  std::unique_ptr<feature::FeaturesCache> _featuresCache;
   std::vector<ViewJob> _cpuJobs;
   std::vector<ViewJob> _gpuJobs;
 };
@@ -270,6 +750,13 @@ int main(int argc, char **argv)
   int rangeSize = 1;
   int maxThreads = 0;
   bool forceCpuExtraction = false;
+  bool useRegionsContainer = false;
+  int gpuJobsPerDevice = 2;
+  int tileSize = 0;
+  int tileOverlap = 256;
+  std::string memoryProfileFilename;
+  bool calibrateMemory = false;
+  std::string featuresCacheFolder;
 
   po::options_description allParams("AliceVision featureExtraction");
 
@@ -278,7 +765,7 @@ int main(int argc, char **argv)
     ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
       "SfMData file.")
     ("output,o", po::value<std::string>(&outputFolder)->required(),
-      "Output path for the features and descriptors files (*.feat, *.desc).");
+      "Output path for the features and descriptors files (*.feat, *.desc or *.regions).");
 
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
@@ -289,6 +776,26 @@ int main(int argc, char **argv)
       "Configuration 'ultra' can take long time !")
     ("forceCpuExtraction", po::value<bool>(&forceCpuExtraction)->default_value(forceCpuExtraction),
       "Use only CPU feature extraction methods.")
+    ("gpuJobsPerDevice", po::value<int>(&gpuJobsPerDevice)->default_value(gpuJobsPerDevice),
+      "Number of images processed at the same time on each GPU device.\n"
+      "GPU jobs are spread over all the supported CUDA devices.")
+    ("regionsContainer", po::value<bool>(&useRegionsContainer)->default_value(useRegionsContainer),
+      "Export features and descriptors in a single memory-mappable binary file (*.regions) "
+      "instead of separate *.feat and *.desc files.")
+    ("tileSize", po::value<int>(&tileSize)->default_value(tileSize),
+      "Extract the features of large images tile by tile, the memory needed by the describers then depends "
+      "on the tile size instead of the image size. Size of a tile in pixels (0 to disable).")
+    ("tileOverlap", po::value<int>(&tileOverlap)->default_value(tileOverlap),
+      "Overlap in pixels added on each side of a tile, it should be larger than the biggest features.")
+    ("memoryProfile", po::value<std::string>(&memoryProfileFilename)->default_value(memoryProfileFilename),
+      "Measured memory consumption of the image describers (*.json) used to schedule the extraction jobs. "
+      "Written by the memory calibration, read otherwise.")
+    ("calibrateMemory", po::value<bool>(&calibrateMemory)->default_value(calibrateMemory),
+      "Measure the memory consumption of the image describers on the biggest image before the extraction "
+      "(Linux only). The result is saved in the memory profile file if any.")
+    ("featuresCache", po::value<std::string>(&featuresCacheFolder)->default_value(featuresCacheFolder),
+      "Folder of previously extracted features indexed by image content and describer settings. "
+      "Unchanged images are not extracted again, even if their view ids have changed (empty to disable).")
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
       "Range image index start.")
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
@@ -333,6 +840,8 @@ int main(int argc, char **argv)
 
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
+  ALICEVISION_PROFILE_REPORT();
+  system::MemoryReport memoryReport("featureExtraction");
 
   if(describerTypesName.empty())
   {
@@ -366,6 +875,15 @@ int main(int argc, char **argv)
   // create feature extractor
   FeatureExtractor extractor(sfmData);
   extractor.setOutputFolder(outputFolder);
+  extractor.setUseRegionsContainer(useRegionsContainer);
+  extractor.setImageDescriberPreset(describerPreset);
+  extractor.setGpuJobsPerDevice(gpuJobsPerDevice);
+
+  // set tiled extraction
+  extractor.setTiles(tileSize, tileOverlap);
+
+  // set features cache
+  extractor.setFeaturesCache(featuresCacheFolder);
 
   // set maxThreads
   extractor.setMaxThreads(maxThreads);
@@ -401,6 +919,30 @@ int main(int argc, char **argv)
     }
   }
 
+  // memory profile of the image describers
+  if(calibrateMemory)
+  {
+    const feature::ImageDescriberMemoryProfile memoryProfile = extractor.calibrateMemoryProfile();
+
+    if(!memoryProfile.empty() && !memoryProfileFilename.empty())
+    {
+      memoryProfile.save(memoryProfileFilename);
+      ALICEVISION_LOG_INFO("Memory profile saved in '" << memoryProfileFilename << "'");
+    }
+    extractor.setMemoryProfile(memoryProfile);
+  }
+  else if(!memoryProfileFilename.empty() && fs::exists(memoryProfileFilename))
+  {
+    feature::ImageDescriberMemoryProfile memoryProfile;
+    memoryProfile.load(memoryProfileFilename);
+
+    if(memoryProfile.getDescriberPreset() != describerPreset)
+      ALICEVISION_LOG_WARNING("The memory profile '" << memoryProfileFilename << "' has been measured with the '"
+                              << memoryProfile.getDescriberPreset() << "' preset, it is not used.");
+    else
+      extractor.setMemoryProfile(memoryProfile);
+  }
+
   // feature extraction routines
   // for each View of the SfMData container:
   // - if regions file exist continue,
@@ -11,21 +11,23 @@
 #include <aliceVision/sfm/pipeline/ReconstructionEngine.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
 #include <aliceVision/feature/RegionsPerView.hpp>
+#include <aliceVision/feature/RegionsCache.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/matchingImageCollection/matchingCommon.hpp>
 #include <aliceVision/matchingImageCollection/ImageCollectionMatcher_generic.hpp>
 #include <aliceVision/matchingImageCollection/ImageCollectionMatcher_cascadeHashing.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilter.hpp>
-#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_F_AC.hpp>
-#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_E_AC.hpp>
-#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_H_AC.hpp>
-#include <aliceVision/matchingImageCollection/GeometricFilterMatrix_HGrowing.hpp>
 #include <aliceVision/matchingImageCollection/GeometricFilterType.hpp>
+#include <aliceVision/matchingImageCollection/pairScheduler.hpp>
+#include <aliceVision/matchingImageCollection/pairwiseMatching.hpp>
+#include <aliceVision/matchingImageCollection/matchingStats.hpp>
 #include <aliceVision/matching/pairwiseAdjacencyDisplay.hpp>
 #include <aliceVision/matching/io.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/feature/selection.hpp>
 #include <aliceVision/graph/graph.hpp>
 #include <aliceVision/stl/stl.hpp>
@@ -40,7 +42,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -80,6 +82,37 @@ void getStatsMap(const PairwiseMatches& map)
 #endif
 }
 
+/// Estimate the matching cost of each view from the size of its descriptors files
+std::map<IndexT, double> getViewMatchingCosts(const sfmData::SfMData& sfmData,
+                                              const std::vector<std::string>& featuresFolders,
+                                              const std::vector<feature::EImageDescriberType>& describerTypes)
+{
+  std::map<IndexT, double> viewCosts;
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    double cost = 0.0;
+    for(const feature::EImageDescriberType descType : describerTypes)
+    {
+      const std::string basename = std::to_string(viewPair.first) + "." + feature::EImageDescriberType_enumToString(descType);
+      // same priority as the regions loading: the last folder wins
+      std::uintmax_t fileSize = 0;
+      for(const std::string& folder : featuresFolders)
+      {
+        const fs::path containerPath = fs::path(folder) / (basename + ".regions");
+        const fs::path descPath = fs::path(folder) / (basename + ".desc");
+        if(fs::exists(containerPath))
+          fileSize = fs::file_size(containerPath);
+        else if(fs::exists(descPath))
+          fileSize = fs::file_size(descPath);
+      }
+      cost += fileSize;
+    }
+    // in MB, at least 1 so views without regions still count
+    viewCosts[viewPair.first] = std::max(cost / (1024.0 * 1024.0), 1.0);
+  }
+  return viewCosts;
+}
+
 /// Compute corresponding features between a series of views:
 /// - Load view images description (regions: features & descriptors)
 /// - Compute putative local feature matches (descriptors matching)
@@ -107,12 +140,22 @@ int main(int argc, char **argv)
   double geometricErrorMax = 0.0; //< the maximum reprojection error allowed for image matching with geometric validation
   bool savePutativeMatches = false;
   bool guidedMatching = false;
+  bool useProsac = false;
+  bool useSprt = false;
+  std::size_t nbHistogramBins = 0;
   int maxIteration = 2048;
   bool matchFilePerImage = false;
   size_t numMatchesToKeep = 0;
   bool useGridSort = true;
   bool exportDebugFiles = false;
-  const std::string fileExtension = "txt";
+  bool mapDescriptors = true;
+  std::string fileExtension = "txt";
+  std::string cascadeHashingFolder;
+  std::string kdtreeIndexFolder;
+  int regionsCacheSize = 0;
+  bool balancedRanges = false;
+  std::string viewCostsFilename;
+  bool exportMatchingStats = false;
 
   po::options_description allParams(
      "Compute corresponding features between a series of views:\n"
@@ -138,16 +181,20 @@ int main(int argc, char **argv)
     ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
       feature::EImageDescriberType_informations().c_str())
     ("imagePairsList,l", po::value<std::string>(&predefinedPairList)->default_value(predefinedPairList),
-      "Path to a file which contains the list of image pairs to match.")
+      "Path to a file which contains the list of image pairs to match. "
+      "A binary pairs file (.bin, see aliceVision_imageMatching) is not loaded at once: "
+      "with a range, only the pairs of the range are read and the ranges get the same number of pairs.")
     ("photometricMatchingMethod,p", po::value<std::string>(&nearestMatchingMethod)->default_value(nearestMatchingMethod),
       "For Scalar based regions descriptor:\n"
       "* BRUTE_FORCE_L2: L2 BruteForce matching\n"
+      "* BRUTE_FORCE_L2_CUDA: L2 BruteForce matching on the GPU (CPU if no CUDA device)\n"
       "* ANN_L2: L2 Approximate Nearest Neighbor matching\n"
       "* CASCADE_HASHING_L2: L2 Cascade Hashing matching\n"
       "* FAST_CASCADE_HASHING_L2: L2 Cascade Hashing with precomputed hashed regions\n"
       "(faster than CASCADE_HASHING_L2 but use more memory)\n"
       "For Binary based descriptor:\n"
-      "* BRUTE_FORCE_HAMMING: BruteForce Hamming matching")
+      "* BRUTE_FORCE_HAMMING: BruteForce Hamming matching\n"
+      "* BRUTE_FORCE_HAMMING_CUDA: BruteForce Hamming matching on the GPU (CPU if no CUDA device)")
     ("geometricEstimator", po::value<robustEstimation::ERobustEstimator>(&geometricEstimator)->default_value(geometricEstimator),
       "Geometric estimator:\n"
       "* acransac: A-Contrario Ransac\n"
@@ -155,12 +202,30 @@ int main(int argc, char **argv)
     ("geometricError", po::value<double>(&geometricErrorMax)->default_value(geometricErrorMax), 
           "Maximum error (in pixels) allowed for features matching during geometric verification. "
           "If set to 0 it lets the ACRansac select an optimal value.")
+    ("useProsac", po::value<bool>(&useProsac)->default_value(useProsac),
+      "Draw the samples of the geometric estimation among the matches with the best distance ratio first (PROSAC). "
+      "Only used when the putative matches are computed, the distance ratios are not saved in the match files.")
+    ("useSprt", po::value<bool>(&useSprt)->default_value(useSprt),
+      "Reject the bad models of the geometric estimation before the verification of all the matches (SPRT).")
+    ("nbHistogramBins", po::value<std::size_t>(&nbHistogramBins)->default_value(nbHistogramBins),
+      "Find the best NFA of the ACRansac geometric estimation from a histogram of the residuals with this number of bins "
+      "instead of sorting them (0 to sort the residuals).")
     ("savePutativeMatches", po::value<bool>(&savePutativeMatches)->default_value(savePutativeMatches),
       "Save putative matches.")
     ("guidedMatching", po::value<bool>(&guidedMatching)->default_value(guidedMatching),
       "Use the found model to improve the pairwise correspondences.")
     ("matchFilePerImage", po::value<bool>(&matchFilePerImage)->default_value(matchFilePerImage),
       "Save matches in a separate file per image.")
+    ("matchFileType", po::value<std::string>(&fileExtension)->default_value(fileExtension),
+      "Match file format:\n"
+      "* txt: text file\n"
+      "* bin: binary file with a per pair index and compressed feature indices, faster to load")
+    ("cascadeHashingFolder", po::value<std::string>(&cascadeHashingFolder)->default_value(cascadeHashingFolder),
+      "Folder used by FAST_CASCADE_HASHING_L2 to save the hashed descriptions of each view and reload them "
+      "instead of recomputing them (e.g. shared by all the chunks of a distributed matching). Disabled if empty.")
+    ("kdtreeIndexFolder", po::value<std::string>(&kdtreeIndexFolder)->default_value(kdtreeIndexFolder),
+      "Folder used by ANN_L2 to save the kd-tree index of each view and reload it "
+      "instead of rebuilding it (e.g. shared by all the chunks of a distributed matching). Disabled if empty.")
     ("distanceRatio", po::value<float>(&distRatio)->default_value(distRatio),
       "Distance ratio to discard non meaningful matches.")
     ("maxIteration", po::value<int>(&maxIteration)->default_value(maxIteration),
@@ -169,12 +234,31 @@ int main(int argc, char **argv)
       "Use matching grid sort.")
     ("exportDebugFiles", po::value<bool>(&exportDebugFiles)->default_value(exportDebugFiles),
       "Export debug files (svg, dot).")
+    ("mapDescriptors", po::value<bool>(&mapDescriptors)->default_value(mapDescriptors),
+      "Keep the descriptors of binary regions files (*.regions) memory-mapped instead of loading them in memory.\n"
+      "Several matching processes on the same node share the same pages.")
+    ("regionsCacheSize", po::value<int>(&regionsCacheSize)->default_value(regionsCacheSize),
+      "Memory budget (in MB) of the regions cache used for the photometric matching. "
+      "The regions are loaded on demand and the pairs are matched by blocks of views fitting in the cache, "
+      "so the memory no longer depends on the number of views. "
+      "Disabled if 0: all the regions are loaded before matching. Not used by FAST_CASCADE_HASHING_L2.")
     ("maxMatches", po::value<std::size_t>(&numMatchesToKeep)->default_value(numMatchesToKeep),
       "Maximum number pf matches to keep.")
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
       "Range image index start.")
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
-      "Range size.");
+      "Range size.")
+    ("balancedRanges", po::value<bool>(&balancedRanges)->default_value(balancedRanges),
+      "Split the pairs in blocks of the pair matrix and distribute the blocks to the ranges "
+      "according to their estimated matching cost (from the size of the descriptors files), "
+      "instead of the image index of the first view of each pair. "
+      "The range of index rangeStart / rangeSize gets the same pairs for each value of rangeStart in this range.")
+    ("viewCostsFile", po::value<std::string>(&viewCostsFilename)->default_value(viewCostsFilename),
+      "View costs file used by balancedRanges instead of the size of the descriptors files "
+      "(e.g. measured on a previous matching, see aliceVision_utils_matchingStatistics).")
+    ("exportMatchingStats", po::value<bool>(&exportMatchingStats)->default_value(exportMatchingStats),
+      "Export the duration of the matching steps of each pair and view, with the number of features, "
+      "putative matches, inliers and robust estimation iterations (matchingStats.csv in the output folder).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -217,6 +301,8 @@ int main(int argc, char **argv)
 
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
+  ALICEVISION_PROFILE_REPORT();
+  system::MemoryReport memoryReport("featureMatching");
 
   // check and set input options
   if(matchesFolder.empty() || !fs::is_directory(matchesFolder))
@@ -225,8 +311,54 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  if(fileExtension != "txt" && fileExtension != "bin")
+  {
+    ALICEVISION_LOG_ERROR("Invalid match file type: " + fileExtension);
+    return EXIT_FAILURE;
+  }
+
+  if(!cascadeHashingFolder.empty())
+  {
+    // may be created concurrently by another chunk
+    boost::system::error_code ec;
+    fs::create_directories(cascadeHashingFolder, ec);
+    if(!fs::is_directory(cascadeHashingFolder))
+    {
+      ALICEVISION_LOG_ERROR("Cannot create the cascade hashing folder: " + cascadeHashingFolder);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if(!kdtreeIndexFolder.empty())
+  {
+    // may be created concurrently by another chunk
+    boost::system::error_code ec;
+    fs::create_directories(kdtreeIndexFolder, ec);
+    if(!fs::is_directory(kdtreeIndexFolder))
+    {
+      ALICEVISION_LOG_ERROR("Cannot create the kd-tree index folder: " + kdtreeIndexFolder);
+      return EXIT_FAILURE;
+    }
+  }
+
   const matchingImageCollection::EGeometricFilterType geometricFilterType = matchingImageCollection::EGeometricFilterType_stringToEnum(geometricFilterTypeName);
 
+  matchingImageCollection::PairwiseMatchingParams matchingParams;
+  matchingParams.matcherType = EMatcherType_stringToEnum(nearestMatchingMethod);
+  matchingParams.distRatio = distRatio;
+  matchingParams.cascadeHashingFolder = cascadeHashingFolder;
+  matchingParams.kdtreeIndexFolder = kdtreeIndexFolder;
+  matchingParams.geometricFilterType = geometricFilterType;
+  matchingParams.geometricEstimator = geometricEstimator;
+  matchingParams.geometricErrorMax = geometricErrorMax;
+  matchingParams.maxIteration = maxIteration;
+  matchingParams.useProsac = useProsac;
+  matchingParams.useSprt = useSprt;
+  matchingParams.nbHistogramBins = nbHistogramBins;
+  matchingParams.guidedMatching = guidedMatching;
+  matchingParams.useGridSort = useGridSort;
+  matchingParams.numMatchesToKeep = numMatchesToKeep;
+
   if(describerTypesName.empty())
   {
     ALICEVISION_LOG_ERROR("Empty option: --describerMethods");
@@ -256,17 +388,63 @@ int main(int argc, char **argv)
   PairSet pairs;
   std::set<IndexT> filter;
 
+  // with balanced ranges, all the pairs are loaded then distributed by blocks
+  const bool useBalancedRanges = balancedRanges && rangeSize > 0;
+  const int pairsRangeStart = useBalancedRanges ? -1 : rangeStart;
+  const int pairsRangeSize = useBalancedRanges ? 0 : rangeSize;
+
   if(predefinedPairList.empty())
   {
-    pairs = exhaustivePairs(sfmData.getViews(), rangeStart, rangeSize);
+    pairs = exhaustivePairs(sfmData.getViews(), pairsRangeStart, pairsRangeSize);
+  }
+  else if(fs::extension(predefinedPairList) == ".bin")
+  {
+    // read the shard of the pairs of the range by byte range
+    const std::size_t nbShards = (pairsRangeSize > 0) ? (sfmData.getViews().size() + pairsRangeSize - 1) / pairsRangeSize : 1;
+    const std::size_t shardIndex = (pairsRangeSize > 0) ? std::max(pairsRangeStart, 0) / pairsRangeSize : 0;
+    std::size_t nbPairsTotal = 0;
+    ALICEVISION_LOG_INFO("Load pair list from binary file: " << predefinedPairList);
+    if(!loadPairsBinary(predefinedPairList, pairs, shardIndex, nbShards, &nbPairsTotal))
+        return EXIT_FAILURE;
+    ALICEVISION_LOG_INFO("Pairs shard " << shardIndex << " / " << nbShards << " (" << pairs.size() << " pairs out of " << nbPairsTotal << ").");
   }
   else
   {
     ALICEVISION_LOG_INFO("Load pair list from file: " << predefinedPairList);
-    if(!loadPairs(predefinedPairList, pairs, rangeStart, rangeSize))
+    if(!loadPairs(predefinedPairList, pairs, pairsRangeStart, pairsRangeSize))
         return EXIT_FAILURE;
   }
 
+  if(useBalancedRanges)
+  {
+    const std::size_t nbRanges = (sfmData.getViews().size() + rangeSize - 1) / rangeSize;
+    const std::size_t rangeIndex = std::max(rangeStart, 0) / rangeSize;
+    std::map<IndexT, double> viewCosts;
+    if(viewCostsFilename.empty())
+    {
+      viewCosts = getViewMatchingCosts(sfmData, featuresFolders, feature::EImageDescriberType_stringToEnums(describerTypesName));
+    }
+    else
+    {
+      if(!matchingImageCollection::loadViewCosts(viewCostsFilename, viewCosts) || viewCosts.empty())
+      {
+        ALICEVISION_LOG_ERROR("Invalid view costs file: " + viewCostsFilename);
+        return EXIT_FAILURE;
+      }
+      // views without measure get the mean cost
+      double meanCost = 0.0;
+      for(const auto& viewCost : viewCosts)
+        meanCost += viewCost.second;
+      meanCost /= viewCosts.size();
+      for(const auto& viewPair : sfmData.getViews())
+        viewCosts.emplace(viewPair.first, meanCost);
+    }
+    const std::vector<PairBlock> blocks = getPairBlocks(pairs, PAIR_BLOCK_SIZE, viewCosts);
+
+    pairs = getPairBlocksShard(blocks, rangeIndex, nbRanges);
+    ALICEVISION_LOG_INFO("Balanced range " << rangeIndex << " / " << nbRanges << " (" << blocks.size() << " blocks of pairs).");
+  }
+
   if(pairs.empty())
   {
     ALICEVISION_LOG_INFO("No image pair to match.");
@@ -288,8 +466,13 @@ int main(int argc, char **argv)
   PairwiseMatches mapPutativesMatches;
 
   // allocate the right Matcher according the Matching requested method
-  EMatcherType collectionMatcherType = EMatcherType_stringToEnum(nearestMatchingMethod);
-  std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(collectionMatcherType, distRatio);
+  std::unique_ptr<IImageCollectionMatcher> imageCollectionMatcher = createImageCollectionMatcher(matchingParams.matcherType, distRatio, cascadeHashingFolder, kdtreeIndexFolder);
+
+  // per pair and per view instrumentation
+  matchingImageCollection::MatchingStats matchingStats;
+  matchingImageCollection::MatchingStats* stats = exportMatchingStats ? &matchingStats : nullptr;
+  imageCollectionMatcher->setMatchingStats(stats);
+  system::Timer stepTimer;
 
   const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
 
@@ -297,10 +480,40 @@ int main(int argc, char **argv)
 
   // load the corresponding view regions
   RegionsPerView regionPerView;
-  if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter))
+  std::unique_ptr<feature::RegionsCache> regionsCache;
+
+  if(regionsCacheSize > 0)
   {
-    ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
-    return EXIT_FAILURE;
+    // regions are loaded on demand by the matcher
+    std::vector<std::string> cacheFeaturesFolders = sfmData.getFeaturesFolders();
+    cacheFeaturesFolders.insert(cacheFeaturesFolders.end(), featuresFolders.begin(), featuresFolders.end());
+
+    auto imageDescribers = std::make_shared<std::map<feature::EImageDescriberType, std::unique_ptr<feature::ImageDescriber>>>();
+    for(const feature::EImageDescriberType descType : describerTypes)
+      (*imageDescribers)[descType] = feature::createImageDescriber(descType);
+
+    regionsCache.reset(new feature::RegionsCache(static_cast<std::size_t>(regionsCacheSize) * 1024 * 1024,
+      [cacheFeaturesFolders, imageDescribers, mapDescriptors, stats](IndexT viewId, feature::EImageDescriberType descType)
+      {
+        system::Timer loadTimer;
+        std::unique_ptr<feature::Regions> regions = sfm::loadRegions(cacheFeaturesFolders, viewId, *imageDescribers->at(descType), mapDescriptors);
+        if(stats)
+        {
+          const double loadMs = loadTimer.elapsedMs();
+          #pragma omp critical
+          stats->views[viewId].loadingMs += loadMs;
+        }
+        return regions;
+      }));
+  }
+  else
+  {
+    if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter, mapDescriptors))
+    {
+      ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
+      return EXIT_FAILURE;
+    }
+    matchingStats.steps["loadRegions"] += stepTimer.elapsedMs();
   }
 
   // perform the matching
@@ -312,12 +525,41 @@ int main(int argc, char **argv)
     ALICEVISION_LOG_INFO(EImageDescriberType_enumToString(descType) + " Regions Matching");
 
     // photometric matching of putative pairs
+    if(regionsCache && imageCollectionMatcher->Match(*regionsCache, pairs, descType, mapPutativesMatches))
+      continue;
+
+    if(regionPerView.isEmpty())
+    {
+      ALICEVISION_LOG_WARNING("The " << nearestMatchingMethod << " matcher does not support the regions cache, all the regions are loaded.");
+      stepTimer.reset();
+      if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter, mapDescriptors))
+      {
+        ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
+        return EXIT_FAILURE;
+      }
+      matchingStats.steps["loadRegions"] += stepTimer.elapsedMs();
+    }
     imageCollectionMatcher->Match(regionPerView, pairs, descType, mapPutativesMatches);
 
     // TODO: DELI
     // if(!guided_matching) regionPerView.clearDescriptors()
   }
 
+  matchingStats.steps["putativeMatching"] += timer.elapsedMs();
+
+  // the geometric filtering only needs the features, except for the guided matching
+  if(regionPerView.isEmpty())
+  {
+    regionsCache.reset();
+    stepTimer.reset();
+    if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter, mapDescriptors, !guidedMatching))
+    {
+      ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
+      return EXIT_FAILURE;
+    }
+    matchingStats.steps["loadRegions"] += stepTimer.elapsedMs();
+  }
+
   if(mapPutativesMatches.empty())
   {
     ALICEVISION_LOG_INFO("No putative matches.");
@@ -325,20 +567,7 @@ int main(int argc, char **argv)
     return rangeSize ? EXIT_SUCCESS : EXIT_FAILURE;
   }
 
-  if(geometricFilterType == EGeometricFilterType::HOMOGRAPHY_GROWING)
-  {
-    // sort putative matches according to their Lowe ratio
-    // This is suggested by [F.Srajer, 2016]: the matches used to be the seeds of the homographies growing are chosen according
-    // to the putative matches order. This modification should improve recall.
-    for(auto& imgPair: mapPutativesMatches)
-    {
-      for(auto& descType: imgPair.second)
-      {
-        IndMatches & matches = descType.second;
-        sortMatches_byDistanceRatio(matches);
-      }
-    }
-  }
+  sortPutativeMatches(mapPutativesMatches, geometricFilterType);
 
   // when a range is specified, generate a file prefix to reflect the current iteration (rangeStart/rangeSize)
   // => with matchFilePerImage: avoids overwriting files if a view is present in several iterations
@@ -395,139 +624,30 @@ int main(int argc, char **argv)
 
   matching::PairwiseMatches geometricMatches;
 
-  ALICEVISION_LOG_INFO("Geometric filtering: using " << matchingImageCollection::EGeometricFilterType_enumToString(geometricFilterType));
+  geometricFiltering(geometricMatches, sfmData, regionPerView, mapPutativesMatches, matchingParams, stats);
 
-  switch(geometricFilterType)
-  {
-
-    case EGeometricFilterType::NO_FILTERING:
-      geometricMatches = mapPutativesMatches;
-    break;
-
-    case EGeometricFilterType::FUNDAMENTAL_MATRIX:
-    {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator),
-        mapPutativesMatches,
-        guidedMatching);
-    }
-    break;
-
-    case EGeometricFilterType::ESSENTIAL_MATRIX:
-    {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_E_AC(std::numeric_limits<double>::infinity(), maxIteration),
-        mapPutativesMatches,
-        guidedMatching);
-
-      // perform an additional check to remove pairs with poor overlap
-      std::vector<PairwiseMatches::key_type> toRemoveVec;
-      for(PairwiseMatches::const_iterator iterMap = geometricMatches.begin();
-        iterMap != geometricMatches.end(); ++iterMap)
-      {
-        const size_t putativePhotometricCount = mapPutativesMatches.find(iterMap->first)->second.getNbAllMatches();
-        const size_t putativeGeometricCount = iterMap->second.getNbAllMatches();
-        const float ratio = putativeGeometricCount / (float)putativePhotometricCount;
-        if (putativeGeometricCount < 50 || ratio < .3f)
-          toRemoveVec.push_back(iterMap->first); // the image pair will be removed
-      }
-
-      // remove discarded pairs
-      for(std::vector<PairwiseMatches::key_type>::const_iterator iter = toRemoveVec.begin();
-          iter != toRemoveVec.end(); ++iter)
-        geometricMatches.erase(*iter);
-    }
-    break;
-
-    case EGeometricFilterType::HOMOGRAPHY_MATRIX:
-    {
-      const bool onlyGuidedMatching = true;
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_H_AC(std::numeric_limits<double>::infinity(), maxIteration),
-        mapPutativesMatches, guidedMatching,
-        onlyGuidedMatching ? -1.0 : 0.6);
-    }
-    break;
-
-    case EGeometricFilterType::HOMOGRAPHY_GROWING:
-    {
-      matchingImageCollection::robustModelEstimation(geometricMatches,
-        &sfmData,
-        regionPerView,
-        GeometricFilterMatrix_HGrowing(std::numeric_limits<double>::infinity(), maxIteration),
-        mapPutativesMatches,
-        guidedMatching);
-    }
-    break;
-  }
-
-  ALICEVISION_LOG_INFO(std::to_string(geometricMatches.size()) + " geometric image pair matches:");
-  for(const auto& matchGeo: geometricMatches)
-    ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGeo.first.first) + ", " + std::to_string(matchGeo.first.second) + ") contains " + std::to_string(matchGeo.second.getNbAllMatches()) + " geometric matches.");
+  matchingStats.steps["geometricFiltering"] += timer.elapsedMs();
 
   // grid filtering
-  ALICEVISION_LOG_INFO("Grid filtering");
+  stepTimer.reset();
 
   PairwiseMatches finalMatches;
-  
-  {
-    for(const auto& geometricMatch: geometricMatches)
-    {
-      //Get the image pair and their matches.
-      const Pair& indexImagePair = geometricMatch.first;
-      const aliceVision::matching::MatchesPerDescType& matchesPerDesc = geometricMatch.second;
-
-      for(const auto& match: matchesPerDesc)
-      {
-        const feature::EImageDescriberType descType = match.first;
-        assert(descType != feature::EImageDescriberType::UNINITIALIZED);
-        const aliceVision::matching::IndMatches& inputMatches = match.second;
+  gridFiltering(finalMatches, sfmData, regionPerView, geometricMatches, matchingParams);
 
-        const feature::FeatRegions<feature::SIOPointFeature>* rRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.second, descType));
-        const feature::FeatRegions<feature::SIOPointFeature>* lRegions = dynamic_cast<const feature::FeatRegions<feature::SIOPointFeature>*>(&regionPerView.getRegions(indexImagePair.first, descType));
-
-        // get the regions for the current view pair:
-        if(rRegions && lRegions)
-        {
-          // sorting function:
-          aliceVision::matching::IndMatches outMatches;
-          sortMatches_byFeaturesScale(inputMatches, *lRegions, *rRegions, outMatches);
-
-          if(useGridSort)
-          {
-            // TODO: rename as matchesGridOrdering
-            matchesGridFiltering(*lRegions, *rRegions, indexImagePair, sfmData, outMatches);
-          }
-          if(numMatchesToKeep > 0)
-          {
-            size_t finalSize = std::min(numMatchesToKeep, outMatches.size());
-            outMatches.resize(finalSize);
-          }
-
-          // std::cout << "Left features: " << lRegions->Features().size() << ", right features: " << rRegions->Features().size() << ", num matches: " << inputMatches.size() << ", num filtered matches: " << outMatches.size() << std::endl;
-          finalMatches[indexImagePair].insert(std::make_pair(descType, outMatches));
-        }
-        else
-        {
-          ALICEVISION_LOG_INFO("You cannot perform the grid filtering with these regions");
-        }
-      }
-    }
-
-    ALICEVISION_LOG_INFO("After grid filtering:");
-    for(const auto& matchGridFiltering: finalMatches)
-      ALICEVISION_LOG_INFO("\t- image pair (" + std::to_string(matchGridFiltering.first.first) + ", " + std::to_string(matchGridFiltering.first.second) + ") contains " + std::to_string(matchGridFiltering.second.getNbAllMatches()) + " geometric matches.");
-  }
+  matchingStats.steps["gridFiltering"] += stepTimer.elapsedMs();
 
   // export geometric filtered matches
   ALICEVISION_LOG_INFO("Save geometric matches.");
+  stepTimer.reset();
   Save(finalMatches, matchesFolder, fileExtension, matchFilePerImage, filePrefix);
+  matchingStats.steps["saveMatches"] += stepTimer.elapsedMs();
+
+  if(exportMatchingStats)
+  {
+    const std::string statsFilename = (fs::path(matchesFolder) / (filePrefix + "matchingStats.csv")).string();
+    ALICEVISION_LOG_INFO("Save matching statistics: " << statsFilename);
+    matchingImageCollection::saveMatchingStats(statsFilename, matchingStats);
+  }
   ALICEVISION_LOG_INFO("Task done in (s): " + std::to_string(timer.elapsed()));
 
   // d. Export some statistics
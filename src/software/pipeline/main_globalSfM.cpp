@@ -12,17 +12,20 @@
 #include <aliceVision/sfm/pipeline/global/ReconstructionEngine_globalSfM.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <cstdlib>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -46,6 +49,8 @@ int main(int argc, char **argv)
   int rotationAveragingMethod = static_cast<int>(sfm::ROTATION_AVERAGING_L2);
   int translationAveragingMethod = static_cast<int>(sfm::TRANSLATION_AVERAGING_SOFTL1);
   bool lockAllIntrinsics = false;
+  int translationAveragingMaxTripletsPerPose = 0;
+  int landmarksSubsamplingMaxPerView = 0;
 
   po::options_description allParams("Implementation of the paper\n"
     "\"Global Fusion of Relative Motions for "
@@ -75,7 +80,14 @@ int main(int argc, char **argv)
       "* 2: L2 minimization")
     ("translationAveraging", po::value<int>(&translationAveragingMethod)->default_value(translationAveragingMethod),
       "* 1: L1 minimization\n"
-      "* 2: L2 minimization of sum of squared Chordal distances")
+      "* 2: L2 minimization of sum of squared Chordal distances\n"
+      "* 3: L1 soft minimization")
+    ("translationAveragingMaxTripletsPerPose", po::value<int>(&translationAveragingMaxTripletsPerPose)->default_value(translationAveragingMaxTripletsPerPose),
+      "Subsampling of the relative translations of redundant graphs: number of best triplets kept per pose, "
+      "in addition to a spanning set of triplets (0: all the triplets are kept).")
+    ("landmarksSubsamplingMaxPerView", po::value<int>(&landmarksSubsamplingMaxPerView)->default_value(landmarksSubsamplingMaxPerView),
+      "Bundle adjustment of the large scenes (1M+ observations) with a subset of the landmarks: max number of well distributed landmarks "
+      "per view used to refine the cameras, the other landmarks are retriangulated (0: all the landmarks are adjusted).")
     ("lockAllIntrinsics", po::value<bool>(&lockAllIntrinsics)->default_value(lockAllIntrinsics),
       "Force lock of all camera intrinsic parameters, so they will not be refined during Bundle Adjustment.");
 
@@ -116,6 +128,8 @@ int main(int argc, char **argv)
 
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
+  ALICEVISION_PROFILE_REPORT();
+  system::MemoryReport memoryReport("globalSfM");
 
   if (rotationAveragingMethod < sfm::ROTATION_AVERAGING_L1 ||
       rotationAveragingMethod > sfm::ROTATION_AVERAGING_L2 )
@@ -193,6 +207,8 @@ int main(int argc, char **argv)
 
   // configure reconstruction parameters
   sfmEngine.setLockAllIntrinsics(lockAllIntrinsics); // TODO: rename param
+  sfmEngine.setTranslationAveragingMaxTripletsPerPose(std::max(0, translationAveragingMaxTripletsPerPose));
+  sfmEngine.setLandmarksSubsamplingMaxPerView(std::max(0, landmarksSubsamplingMaxPerView));
 
   // configure motion averaging method
   sfmEngine.SetRotationAveragingMethod(sfm::ERotationAveragingMethod(rotationAveragingMethod));
@@ -9,6 +9,8 @@
 #include <aliceVision/voctree/Database.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
 #include <aliceVision/voctree/databaseIO.hpp>
+#include <aliceVision/voctree/imagePairs.hpp>
+#include <aliceVision/matchingImageCollection/pairBuilder.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/config.hpp>
@@ -18,6 +20,7 @@
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <ostream>
@@ -28,7 +31,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 static const int DIMENSION = 128;
 
@@ -40,21 +43,13 @@ namespace fs = boost::filesystem;
 typedef aliceVision::feature::Descriptor<float, DIMENSION> DescriptorFloat;
 typedef aliceVision::feature::Descriptor<unsigned char, DIMENSION> DescriptorUChar;
 
-typedef std::size_t ImageID;
-
 using aliceVision::IndexT;
-
-// just a list of doc id
-typedef std::vector<ImageID> ListOfImageID;
-
-// An ordered and unique list of doc id
-typedef std::set<ImageID> OrderedListOfImageID;
-
-// For each image ID it contains the  list of matching imagess
-typedef std::map<ImageID, ListOfImageID> PairList;
-
-// For each image ID it contains the ordered list of matching images
-typedef std::map<ImageID, OrderedListOfImageID> OrderedPairList;
+using aliceVision::voctree::ImageID;
+using aliceVision::voctree::ListOfImageID;
+using aliceVision::voctree::OrderedListOfImageID;
+using aliceVision::voctree::PairList;
+using aliceVision::voctree::OrderedPairList;
+using aliceVision::voctree::convertAllMatchesToPairList;
 
 /**
  * @brief Function that prints a PairList
@@ -156,63 +151,6 @@ std::string EImageMatchingMode_enumToString(EImageMatchingMode modeMultiSfM)
   throw std::out_of_range("Invalid modeMultiSfM : " + modeMultiSfM);
 }
 
-/**
- * It processes a pairlist containing all the matching images for each image ID and return
- * a similar list limited to a numMatches number of matching images and such that
- * there is no repetitions: eg if the image 1 matches with 2 in the list of image 2
- * there won't be the image 1
- *
- * @param[in] allMatches A pairlist containing all the matching images for each image of the dataset
- * @param[in] numMatches The maximum number of matching images to consider for each image (if 0, consider all matches)
- * @param[out] matches A processed version of allMatches that consider only the first numMatches without repetitions
- */
-void convertAllMatchesToPairList(const PairList &allMatches, std::size_t numMatches, OrderedPairList &outPairList)
-{
-  outPairList.clear();
-
-  if(numMatches == 0)
-    numMatches = allMatches.size();  // disable image matching limit
-
-  for(const auto& match : allMatches)
-  {
-    ImageID currImageId = match.first;
-    OrderedListOfImageID bestMatches;
-
-    for(const ImageID currMatchId : match.second)
-    {
-      // avoid self-matching
-      if(currMatchId == currImageId)
-        continue;
-
-      // if the currMatchId ID is lower than the current image ID and
-      // the current image ID is not already in the list of currMatchId
-      //BOOST_ASSERT( ( currMatchId < currImageId ) && ( outPairList.find( currMatchId ) != outPairList.end() ) );
-      if(currMatchId < currImageId)
-      {
-        OrderedPairList::const_iterator currMatches = outPairList.find(currMatchId);
-        if(currMatches != outPairList.end() &&
-                currMatches->second.find(currImageId) == currMatches->second.end())
-        {
-          // then add it to the list
-          bestMatches.insert(currMatchId);
-        }
-      }
-      else
-      {
-        bestMatches.insert(currMatchId);
-      }
-
-      // stop if numMatches is satisfied
-      if(bestMatches.size() == numMatches)
-        break;
-    }
-
-    // fill the output if we have matches
-    if(!bestMatches.empty())
-      outPairList[currImageId] = bestMatches;
-  }
-}
-
 void generateAllMatchesInOneMap(const std::map<IndexT, std::string>& descriptorsFiles, OrderedPairList& outPairList)
 {
   for(const auto& descItA: descriptorsFiles)
@@ -286,39 +224,58 @@ void generateFromVoctree(PairList& allMatches,
       allMatches[descriptorPair.first] = {};
   }
 
-  // query each document
-  #pragma omp parallel for
-  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFiles.size()); ++i)
-  {
-    auto itA = descriptorsFiles.cbegin();
-    std::advance(itA, i);
-    const IndexT viewIdA = itA->first;
-    const std::string featuresPathA = itA->second;
+  std::map<aliceVision::voctree::DocId, aliceVision::voctree::DocMatches> allDocMatches;
 
-    aliceVision::voctree::SparseHistogram imageSH;
+  if(modeMultiSfM == EImageMatchingMode::A_A)
+  {
+    // the queries are the documents of the database, each couple is scored once
+    db.findBatchSymmetric(numImageQuery, allDocMatches);
+  }
+  else
+  {
+    aliceVision::voctree::SparseHistogramPerImage queries;
 
     if(modeMultiSfM != EImageMatchingMode::A_B)
     {
       // sparse histogram of A is already computed in the DB
-      imageSH = db.getSparseHistogramPerImage().at(viewIdA);
+      for(const auto& descriptorPair : descriptorsFiles)
+        queries[descriptorPair.first] = db.getSparseHistogramPerImage().at(descriptorPair.first);
     }
     else // mode AB
     {
       // compute the sparse histogram of each image A
-      std::vector<DescriptorUChar> descriptors;
-      // read the descriptors
-      loadDescsFromBinFile(featuresPathA, descriptors, false, nbMaxDescriptors);
-      imageSH = tree.quantizeToSparse(descriptors);
+      #pragma omp parallel for
+      for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(descriptorsFiles.size()); ++i)
+      {
+        auto itA = descriptorsFiles.cbegin();
+        std::advance(itA, i);
+
+        std::vector<DescriptorUChar> descriptors;
+        // read the descriptors
+        loadDescsFromBinFile(itA->second, descriptors, false, nbMaxDescriptors);
+        aliceVision::voctree::SparseHistogram imageSH = tree.quantizeToSparse(descriptors);
+
+        #pragma omp critical
+        {
+          queries[itA->first] = std::move(imageSH);
+        }
+      }
     }
 
-    std::vector<aliceVision::voctree::DocMatch> matches;
+    // query each document
+    db.findBatch(queries, numImageQuery, allDocMatches);
+  }
 
-    db.find(imageSH, numImageQuery, matches);
+  for(const auto& descriptorPair : descriptorsFiles)
+  {
+    const auto docMatchesIt = allDocMatches.find(descriptorPair.first);
+    if(docMatchesIt == allDocMatches.end())
+      continue;
 
-    ListOfImageID& imgMatches = allMatches.at(viewIdA);
-    imgMatches.reserve(imgMatches.size() + matches.size());
+    ListOfImageID& imgMatches = allMatches.at(descriptorPair.first);
+    imgMatches.reserve(imgMatches.size() + docMatchesIt->second.size());
 
-    for(const aliceVision::voctree::DocMatch& m : matches)
+    for(const aliceVision::voctree::DocMatch& m : docMatchesIt->second)
     {
       imgMatches.push_back(m.id);
     }
@@ -353,6 +310,20 @@ int main(int argc, char** argv)
   /// flag for the optional weights file
   bool withWeights = false;
 
+  // sequence parameters
+
+  /// the number of next frames matched with each frame (0 to disable the sequential mode)
+  std::size_t sequentialWindow = 0;
+  /// the number of loop closure candidates retrieved from the vocabulary tree for each frame
+  std::size_t nbLoopClosureMatches = 5;
+
+  // spatial parameters
+
+  /// the number of nearest images (from the pose priors or the GPS metadata) matched with each image (0 to disable the spatial mode)
+  std::size_t spatialNeighbors = 0;
+  /// the max angle in degrees between the viewing directions of the spatial pairs (0 to disable)
+  double spatialMaxViewAngle = 0.0;
+
   // multiple SfM parameters
 
   /// a second file containing a list of features
@@ -381,7 +352,9 @@ int main(int argc, char** argv)
       "Input file path of the vocabulary tree. This file can be generated by createVoctree. "
       "This software is intended to be used with a generic, pre-trained vocabulary tree.")
     ("output,o", po::value<std::string>(&outputFile)->required(),
-      "Filepath to the output file with the list of selected image pairs.");
+      "Filepath to the output file with the list of selected image pairs. "
+      "With the .bin extension, the pairs are written in a compact binary pairs file, "
+      "and the brute force pairs of a single SfMData are only stored as the list of its images.");
 
   po::options_description optionalParams("Optional parameters");
   optionalParams.add_options()
@@ -395,6 +368,27 @@ int main(int argc, char** argv)
     ("weights,w", po::value<std::string>(&weightsName),
       "Input name for the vocabulary tree weight file, if not provided all voctree leaves will have the same weight.");
 
+  po::options_description sequenceParams("Sequence");
+  sequenceParams.add_options()
+      ("sequentialWindow", po::value<std::size_t>(&sequentialWindow)->default_value(sequentialWindow),
+        "For temporally ordered images (video frames), match each image with the given number of next images "
+        "of the sequence (sorted by frame id, then by image path) instead of the brute force or vocabulary tree pairs. "
+        "0 disables the sequential mode.")
+      ("nbLoopClosureMatches", po::value<std::size_t>(&nbLoopClosureMatches)->default_value(nbLoopClosureMatches),
+        "In sequential or spatial mode, the number of images outside of the sequential window (or of the spatial neighbors) "
+        "retrieved from the vocabulary tree for each image (loop closure candidates). "
+        "Requires a vocabulary tree, 0 disables the loop closure.");
+
+  po::options_description spatialParams("Spatial");
+  spatialParams.add_options()
+      ("spatialNeighbors", po::value<std::size_t>(&spatialNeighbors)->default_value(spatialNeighbors),
+        "For the images with a position prior (pose of the input SfMData or GPS metadata, e.g. drone images), "
+        "match each image with the given number of nearest images (kd-tree of the positions) instead of the brute force "
+        "or vocabulary tree pairs. 0 disables the spatial mode.")
+      ("spatialMaxViewAngle", po::value<double>(&spatialMaxViewAngle)->default_value(spatialMaxViewAngle),
+        "In spatial mode, the max angle (in degrees) between the viewing directions of the images of a pair, "
+        "for the images with a pose prior. 0 disables the viewing direction filter.");
+
   po::options_description multiSfMParams("Multiple SfM");
   multiSfMParams.add_options()
       ("inputB", po::value<std::string>(&sfmDataFilenameB),
@@ -409,7 +403,7 @@ int main(int argc, char** argv)
       ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
         "verbosity level (fatal, error, warning, info, debug, trace).");
 
-  allParams.add(requiredParams).add(optionalParams).add(multiSfMParams).add(logParams);
+  allParams.add(requiredParams).add(optionalParams).add(sequenceParams).add(spatialParams).add(multiSfMParams).add(logParams);
 
   po::variables_map vm;
   try
@@ -452,6 +446,23 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  const bool useSequence = (sequentialWindow > 0);
+  const bool useSpatial = (spatialNeighbors > 0);
+  // the sequential and spatial modes only use the vocabulary tree for the loop closures
+  const bool useLoopClosures = (useSequence || useSpatial);
+
+  if(useSequence && useMultiSfM)
+  {
+    ALICEVISION_LOG_ERROR("The sequential mode is not compatible with multiple SfMData inputs.");
+    return EXIT_FAILURE;
+  }
+
+  if(useSpatial && (useSequence || useMultiSfM))
+  {
+    ALICEVISION_LOG_ERROR("The spatial mode is not compatible with the sequential mode or with multiple SfMData inputs.");
+    return EXIT_FAILURE;
+  }
+
   // load SfMData
   sfmData::SfMData sfmDataA, sfmDataB;
 
@@ -480,6 +491,10 @@ int main(int argc, char** argv)
 
   OrderedPairList selectedPairs;
 
+  // with a binary output, the brute force pairs of a single SfMData are implicit (all the pairs of these images)
+  const bool binaryOutput = (fs::extension(outputFile) == ".bin");
+  std::vector<IndexT> exhaustiveViewIds;
+
   std::map<IndexT, std::string> descriptorsFilesA, descriptorsFilesB;
 
   // load descriptor filenames
@@ -488,14 +503,59 @@ int main(int argc, char** argv)
   if(useMultiSfM)
     aliceVision::voctree::getListOfDescriptorFiles(sfmDataB, featuresFolders, descriptorsFilesB);
 
-  if(treeName.empty() && (descriptorsFilesA.size() + descriptorsFilesB.size()) > 200)
+  // rank of each image in the sequence
+  std::map<IndexT, std::size_t> sequenceRanks;
+
+  if(useSequence)
+  {
+    ALICEVISION_LOG_INFO("Sequential generation (window of " << sequentialWindow << " images)");
+
+    const std::vector<IndexT> viewIds = sequenceOrder(sfmDataA.getViews());
+    for(std::size_t i = 0; i < viewIds.size(); ++i)
+      sequenceRanks[viewIds[i]] = i;
+
+    for(const Pair& pair : sequentialPairs(sfmDataA.getViews(), sequentialWindow))
+    {
+      if(descriptorsFilesA.count(pair.first) && descriptorsFilesA.count(pair.second))
+        selectedPairs[pair.first].insert(pair.second);
+    }
+  }
+
+  // pairs of the nearest images
+  PairSet spatialNeighborPairs;
+
+  if(useSpatial)
+  {
+    ALICEVISION_LOG_INFO("Spatial generation (" << spatialNeighbors << " nearest images)");
+
+    auto spatial_start = std::chrono::steady_clock::now();
+    std::size_t nbPositionedViews = 0;
+    spatialNeighborPairs = spatialPairs(sfmDataA, spatialNeighbors, spatialMaxViewAngle, &nbPositionedViews);
+    for(const Pair& pair : spatialNeighborPairs)
+    {
+      if(descriptorsFilesA.count(pair.first) && descriptorsFilesA.count(pair.second))
+        selectedPairs[pair.first].insert(pair.second);
+    }
+    auto spatial_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - spatial_start);
+    ALICEVISION_LOG_INFO(nbPositionedViews << " images with a pose prior or a GPS position out of " << sfmDataA.getViews().size()
+                         << ", " << spatialNeighborPairs.size() << " spatial pairs in " << spatial_elapsed.count() << " msec.");
+    if(nbPositionedViews < sfmDataA.getViews().size())
+      ALICEVISION_LOG_WARNING("The images without position are only matched with the loop closure candidates of the vocabulary tree.");
+  }
+
+  if(!useLoopClosures && treeName.empty() && (descriptorsFilesA.size() + descriptorsFilesB.size()) > 200)
     ALICEVISION_LOG_WARNING("No vocabulary tree argument, so it will use the brute force approach which can be compute intensive for aliceVision_featureMatching.");
 
-  if(treeName.empty() || (descriptorsFilesA.size() + descriptorsFilesB.size()) < minNbImages)
+  if(!useLoopClosures && (treeName.empty() || (descriptorsFilesA.size() + descriptorsFilesB.size()) < minNbImages))
   {
     ALICEVISION_LOG_INFO("Brute force generation");
 
-    if((matchingMode == EImageMatchingMode::A_A_AND_A_B) ||
+    if(binaryOutput && matchingMode == EImageMatchingMode::A_A)
+    {
+      for(const auto& descItA : descriptorsFilesA)
+        exhaustiveViewIds.push_back(descItA.first);
+    }
+    else if((matchingMode == EImageMatchingMode::A_A_AND_A_B) ||
        (matchingMode == EImageMatchingMode::A_AB) ||
        (matchingMode == EImageMatchingMode::A_A))
       generateAllMatchesInOneMap(descriptorsFilesA, selectedPairs);
@@ -508,13 +568,19 @@ int main(int argc, char** argv)
 
   // if selectedPairs is not already computed by a brute force approach,
   // we compute it with the vocabulary tree approach.
-  if(selectedPairs.empty())
+  // In sequential or spatial mode, the vocabulary tree only adds loop closure candidates.
+  const bool useVoctree = useLoopClosures ?
+        (!treeName.empty() && nbLoopClosureMatches > 0 && descriptorsFilesA.size() >= minNbImages) :
+        (selectedPairs.empty() && exhaustiveViewIds.empty());
+
+  if(useVoctree)
   {
     // load vocabulary tree
     ALICEVISION_LOG_INFO("Loading vocabulary tree");
 
     auto loadVoctree_start = std::chrono::steady_clock::now();
-    aliceVision::voctree::VocabularyTree<DescriptorFloat> tree(treeName);
+    aliceVision::voctree::VocabularyTree<DescriptorFloat> tree;
+    tree.loadMapped(treeName);
     auto loadVoctree_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - loadVoctree_start);
     {
       std::stringstream ss;
@@ -618,14 +684,47 @@ int main(int argc, char** argv)
 
       auto detect_start = std::chrono::steady_clock::now();
 
+      // in sequential or spatial mode, query enough documents to get the loop closure candidates outside of the window
+      // (or of the spatial neighbors)
+      const std::size_t nbQueryDocuments = useSequence ? (nbLoopClosureMatches + 2 * sequentialWindow + 1) :
+                                           useSpatial ? (nbLoopClosureMatches + 2 * spatialNeighbors + 1) : numImageQuery;
+
       if(matchingMode == EImageMatchingMode::A_A_AND_A_B)
       {
-        generateFromVoctree(allMatches, descriptorsFilesA, db,  tree, EImageMatchingMode::A_A, nbMaxDescriptors, numImageQuery);
-        generateFromVoctree(allMatches, descriptorsFilesA, db2, tree, EImageMatchingMode::A_B, nbMaxDescriptors, numImageQuery);
+        generateFromVoctree(allMatches, descriptorsFilesA, db,  tree, EImageMatchingMode::A_A, nbMaxDescriptors, nbQueryDocuments);
+        generateFromVoctree(allMatches, descriptorsFilesA, db2, tree, EImageMatchingMode::A_B, nbMaxDescriptors, nbQueryDocuments);
       }
       else
       {
-        generateFromVoctree(allMatches, descriptorsFilesA, db, tree, matchingMode,  nbMaxDescriptors, numImageQuery);
+        generateFromVoctree(allMatches, descriptorsFilesA, db, tree, matchingMode,  nbMaxDescriptors, nbQueryDocuments);
+      }
+
+      if(useSequence)
+      {
+        // remove the images already in the sequential window
+        for(auto& imageMatches : allMatches)
+        {
+          const std::size_t rank = sequenceRanks.at(imageMatches.first);
+          ListOfImageID& matchIds = imageMatches.second;
+          matchIds.erase(std::remove_if(matchIds.begin(), matchIds.end(), [&](ImageID matchId)
+          {
+            const std::size_t matchRank = sequenceRanks.at(matchId);
+            return ((matchRank > rank) ? (matchRank - rank) : (rank - matchRank)) <= sequentialWindow;
+          }), matchIds.end());
+        }
+      }
+      else if(useSpatial)
+      {
+        // remove the spatial neighbors
+        for(auto& imageMatches : allMatches)
+        {
+          const IndexT imageId = imageMatches.first;
+          ListOfImageID& matchIds = imageMatches.second;
+          matchIds.erase(std::remove_if(matchIds.begin(), matchIds.end(), [&](ImageID matchId)
+          {
+            return spatialNeighborPairs.count(std::make_pair(std::min<IndexT>(imageId, matchId), std::max<IndexT>(imageId, matchId))) > 0;
+          }), matchIds.end());
+        }
       }
 
       auto detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
@@ -635,7 +734,10 @@ int main(int argc, char** argv)
       detect_start = std::chrono::steady_clock::now();
 
       ALICEVISION_LOG_INFO("Convert all matches to pairList");
-      convertAllMatchesToPairList(allMatches, numImageQuery, selectedPairs);
+      OrderedPairList voctreePairs;
+      convertAllMatchesToPairList(allMatches, useLoopClosures ? nbLoopClosureMatches : numImageQuery, voctreePairs);
+      for(const auto& imagePairs : voctreePairs)
+        selectedPairs[imagePairs.first].insert(imagePairs.second.begin(), imagePairs.second.end());
       detect_elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - detect_start);
       ALICEVISION_LOG_INFO("Convert all matches to pairList took " << detect_elapsed.count() << " sec.");
     }
@@ -654,10 +756,37 @@ int main(int argc, char** argv)
   }
 
   // write it to file
-  std::ofstream fileout;
-  fileout.open(outputFile, std::ofstream::out);
-  fileout << selectedPairs;
-  fileout.close();
+  if(binaryOutput)
+  {
+    bool saved = false;
+    if(!exhaustiveViewIds.empty())
+    {
+      saved = saveExhaustivePairsBinary(outputFile, exhaustiveViewIds);
+    }
+    else
+    {
+      PairVec pairs;
+      for(const auto& imagePairs : selectedPairs)
+      {
+        for(const ImageID imageId : imagePairs.second)
+          pairs.emplace_back(imagePairs.first, imageId);
+      }
+      OrderedPairList().swap(selectedPairs);
+      saved = savePairsBinary(outputFile, std::move(pairs));
+    }
+    if(!saved)
+    {
+      ALICEVISION_LOG_ERROR("Unable to write the binary pairs file: " << outputFile);
+      return EXIT_FAILURE;
+    }
+  }
+  else
+  {
+    std::ofstream fileout;
+    fileout.open(outputFile, std::ofstream::out);
+    fileout << selectedPairs;
+    fileout.close();
+  }
 
   ALICEVISION_LOG_INFO("pairList exported in: " << outputFile);
 
@@ -12,7 +12,9 @@
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/types.hpp>
 #include <aliceVision/config.hpp>
 
@@ -24,7 +26,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 5
 
 using namespace aliceVision;
 
@@ -140,24 +142,45 @@ int main(int argc, char **argv)
       "Force lock of all camera intrinsic parameters, so they will not be refined during Bundle Adjustment.")
     ("useLocalBA,l", po::value<bool>(&sfmParams.useLocalBundleAdjustment)->default_value(sfmParams.useLocalBundleAdjustment),
       "Enable/Disable the Local bundle adjustment strategy.\n"
-      "It reduces the reconstruction time, especially for big datasets (500+ images).")
+      "It reduces the reconstruction time, especially for big datasets (500+ images).\n"
+      "It is only used when the scene has more than 100 poses.")
     ("localBAGraphDistance", po::value<int>(&sfmParams.localBundelAdjustementGraphDistanceLimit)->default_value(sfmParams.localBundelAdjustementGraphDistanceLimit),
       "Graph-distance limit setting the Active region in the Local Bundle Adjustment strategy.")
+    ("baLandmarksSubsamplingMaxPerView", po::value<std::size_t>(&sfmParams.baLandmarksSubsamplingMaxPerView)->default_value(sfmParams.baLandmarksSubsamplingMaxPerView),
+      "Bundle adjustment of the large scenes with a subset of the landmarks: max number of well distributed landmarks "
+      "per view used to refine the cameras, the other landmarks are retriangulated (0: all the landmarks are adjusted).")
+    ("baLandmarksSubsamplingMinObservations", po::value<std::size_t>(&sfmParams.baLandmarksSubsamplingMinObservations)->default_value(sfmParams.baLandmarksSubsamplingMinObservations),
+      "Min number of observations in the scene to use the landmarks subsampling in the bundle adjustment.")
     ("localizerEstimator", po::value<robustEstimation::ERobustEstimator>(&sfmParams.localizerEstimator)->default_value(sfmParams.localizerEstimator),
       "Estimator type used to localize cameras (acransac (default), ransac, lsmeds, loransac, maxconsensus)")
     ("localizerEstimatorError", po::value<double>(&sfmParams.localizerEstimatorError)->default_value(0.0),
       "Reprojection error threshold (in pixels) for the localizer estimator (0 for default value according to the estimator).")
     ("localizerEstimatorMaxIterations", po::value<std::size_t>(&sfmParams.localizerEstimatorMaxIterations)->default_value(sfmParams.localizerEstimatorMaxIterations),
       "Max number of RANSAC iterations.")
+    ("nbHistogramBins", po::value<std::size_t>(&sfmParams.nbHistogramBins)->default_value(sfmParams.nbHistogramBins),
+      "Find the best NFA of the ACRansac resection and relative pose estimations from a histogram of the residuals "
+      "with this number of bins instead of sorting them (0 to sort the residuals).")
     ("useOnlyMatchesFromInputFolder", po::value<bool>(&useOnlyMatchesFromInputFolder)->default_value(useOnlyMatchesFromInputFolder),
       "Use only matches from the input matchesFolder parameter.\n"
       "Matches folders previously added to the SfMData file will be ignored.")
     ("useTrackFiltering", po::value<bool>(&sfmParams.useTrackFiltering)->default_value(sfmParams.useTrackFiltering),
       "Enable/Disable the track filtering.\n")
+    ("tracksCacheFile", po::value<std::string>(&sfmParams.tracksCacheFile)->default_value(sfmParams.tracksCacheFile),
+      "Binary tracks file (.tracks) shared between runs on the same matches.\n"
+      "The tracks are loaded from this file if it has been built from the same matches and track filtering, "
+      "otherwise they are built and saved to this file.")
     ("useRigConstraint", po::value<bool>(&sfmParams.useRigConstraint)->default_value(sfmParams.useRigConstraint),
       "Enable/Disable rig constraint.\n")
     ("lockScenePreviouslyReconstructed", po::value<bool>(&lockScenePreviouslyReconstructed)->default_value(lockScenePreviouslyReconstructed),
-      "Lock/Unlock scene previously reconstructed.\n");
+      "Lock/Unlock scene previously reconstructed.\n")
+    ("checkpointFile", po::value<std::string>(&sfmParams.checkpointFile)->default_value(sfmParams.checkpointFile),
+      "SfMData file of the reconstruction checkpoints (.abc if AliceVision is built with Alembic, or .sfm).\n"
+      "The reconstruction is saved periodically in the background, to be resumed if the process is interrupted.")
+    ("checkpointInterval", po::value<double>(&sfmParams.checkpointInterval)->default_value(sfmParams.checkpointInterval),
+      "Minimum time (in seconds) between two checkpoints.")
+    ("resume", po::value<bool>(&sfmParams.resumeFromCheckpoint)->default_value(sfmParams.resumeFromCheckpoint),
+      "Continue the reconstruction from the checkpoint file, if it exists.\n"
+      "The other inputs (scene, features, matches and parameters) must be the ones of the interrupted run.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -196,6 +219,8 @@ int main(int argc, char **argv)
 
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
+  ALICEVISION_PROFILE_REPORT();
+  system::MemoryReport memoryReport("incrementalSfM");
 
   const double defaultLoRansacLocalizationError = 4.0;
   if(!robustEstimation::adjustRobustEstimatorThreshold(sfmParams.localizerEstimator, sfmParams.localizerEstimatorError, defaultLoRansacLocalizationError))
@@ -203,6 +228,12 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  if(sfmParams.resumeFromCheckpoint && sfmParams.checkpointFile.empty())
+  {
+    ALICEVISION_LOG_ERROR("The resume option requires a checkpoint file.");
+    return EXIT_FAILURE;
+  }
+
   // load input SfMData scene
   sfmData::SfMData sfmData;
   if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
@@ -0,0 +1,131 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/localization/VoctreeLocalizer.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+
+int main(int argc, char** argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string sfmDataFilename;
+  std::string outputFolder;
+  std::string descriptorsFolder;
+  std::string vocTreeFilepath;
+  std::string weightsFilepath;
+  std::string matchDescTypeNames = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+
+  po::options_description allParams(
+    "Build a localization database from a reconstruction: the descriptors associated to the landmarks "
+    "and the vocabulary tree documents of the views are saved in memory-mappable files, "
+    "shared by the localizers of the scene (cameraLocalization --localizationDatabase).\n"
+    "AliceVision localizationDatabase");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
+      "SfMData file.")
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output localization database folder.")
+    ("voctree", po::value<std::string>(&vocTreeFilepath)->required(),
+      "Filename for the vocabulary tree.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("descriptorPath", po::value<std::string>(&descriptorsFolder),
+      "Folder containing the descriptors for all the images (ie the *.desc.)")
+    ("voctreeWeights", po::value<std::string>(&weightsFilepath),
+      "Filename for the vocabulary tree weights.")
+    ("matchDescTypes", po::value<std::string>(&matchDescTypeNames)->default_value(matchDescTypeNames),
+      "The describer types to use for the matching.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  // load SfMData
+  sfmData::SfMData sfmData;
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmDataFilename + "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  system::Timer timer;
+
+  // load the reconstructed regions and build the voctree documents of the scene
+  const localization::VoctreeLocalizer localizer(sfmData,
+                                                 descriptorsFolder,
+                                                 vocTreeFilepath,
+                                                 weightsFilepath,
+                                                 feature::EImageDescriberType_stringToEnums(matchDescTypeNames));
+
+  if(!localizer.isInit())
+  {
+    ALICEVISION_LOG_ERROR("Cannot initialize the localizer.");
+    return EXIT_FAILURE;
+  }
+
+  localizer.saveLocalizationDatabase(outputFolder);
+
+  ALICEVISION_LOG_INFO("Localization database built in " << timer.elapsedMs() / 1000.0 << " s.");
+  return EXIT_SUCCESS;
+}
@@ -7,6 +7,7 @@
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/TaskPool.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
 
 #include <OpenMesh/Core/IO/reader/OBJReader.hh>
@@ -20,16 +21,284 @@
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
 namespace bfs = boost::filesystem;
 namespace po = boost::program_options;
 
+// Mesh type
+typedef OpenMesh::TriMesh_ArrayKernelT<>                      Mesh;
+// Decimater type
+typedef OpenMesh::Decimater::DecimaterT< Mesh >               Decimater;
+// Decimation Module Handle type
+typedef OpenMesh::Decimater::ModQuadricT< Mesh >::Handle HModQuadric;
+
+/**
+ * @brief Decimate a mesh with the quadric error metric, the locked vertices are kept
+ * @param[in,out] mesh The mesh
+ * @param[in] nbOutputPoints The target number of vertices
+ * @param[in] maxError The maximum quadric error of a collapse (0 for no limit)
+ */
+void decimateMesh(Mesh& mesh, int nbOutputPoints, double maxError)
+{
+    // a decimater object, connected to a mesh
+    Decimater   decimater(mesh);
+    // use a quadric module
+    HModQuadric hModQuadric;
+    // register module at the decimater
+    decimater.add(hModQuadric);
+
+    /*
+     * since we need exactly one priority module (non-binary)
+     * we have to call set_binary(false) for our priority module
+     * in the case of HModQuadric, unset_max_err() calls set_binary(false) internally
+     */
+    if(maxError > 0.0)
+        decimater.module(hModQuadric).set_max_err(maxError, false);
+    else
+        decimater.module(hModQuadric).unset_max_err();
+    // let the decimater initialize the mesh and the modules
+    decimater.initialize();
+    // do decimation
+    decimater.decimate_to(nbOutputPoints);
+    decimater.mesh().garbage_collection();
+}
+
+/**
+ * @brief Split the faces in spatially coherent partitions of the same size,
+ *        by median splits of the face centers along the longest axis
+ * @param[in] mesh The mesh
+ * @param[in] faceVertices The vertex indexes of each face
+ * @param[in] nbPartitions The number of partitions
+ * @param[out] facesPerPartition The face indexes of each partition
+ */
+void partitionFaces(const Mesh& mesh,
+                    const std::vector<std::array<int, 3>>& faceVertices,
+                    int nbPartitions,
+                    std::vector<std::vector<int>>& facesPerPartition)
+{
+    std::vector<Mesh::Point> centers(faceVertices.size());
+    for(std::size_t f = 0; f < faceVertices.size(); ++f)
+    {
+        const std::array<int, 3>& v = faceVertices[f];
+        centers[f] = (mesh.point(Mesh::VertexHandle(v[0])) + mesh.point(Mesh::VertexHandle(v[1])) + mesh.point(Mesh::VertexHandle(v[2]))) / 3.0f;
+    }
+
+    std::vector<int> faces(faceVertices.size());
+    std::iota(faces.begin(), faces.end(), 0);
+    facesPerPartition.assign(nbPartitions, {});
+
+    std::function<void(std::size_t, std::size_t, int, int)> split = [&](std::size_t begin, std::size_t end, int firstPartition, int nbParts)
+    {
+        if(nbParts == 1)
+        {
+            facesPerPartition[firstPartition].assign(faces.begin() + begin, faces.begin() + end);
+            return;
+        }
+
+        Mesh::Point bboxMin = centers[faces[begin]];
+        Mesh::Point bboxMax = bboxMin;
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            bboxMin.minimize(centers[faces[i]]);
+            bboxMax.maximize(centers[faces[i]]);
+        }
+        const Mesh::Point extent = bboxMax - bboxMin;
+        const int axis = extent[0] >= extent[1] && extent[0] >= extent[2] ? 0 : (extent[1] >= extent[2] ? 1 : 2);
+
+        const int nbLeftParts = nbParts / 2;
+        const std::size_t middle = begin + (end - begin) * nbLeftParts / nbParts;
+        std::nth_element(faces.begin() + begin, faces.begin() + middle, faces.begin() + end,
+                         [&](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+        split(begin, middle, firstPartition, nbLeftParts);
+        split(middle, end, firstPartition + nbLeftParts, nbParts - nbLeftParts);
+    };
+    split(0, faces.size(), 0, nbPartitions);
+}
+
+/**
+ * @brief Decimate a mesh by spatial partitions in parallel, then decimate the partitions borders.
+ *
+ * The vertices shared by several partitions are locked during the decimation of the partitions,
+ * so the decimated partitions are stitched back on these vertices. Each partition is decimated
+ * to its share of the target, then a final decimation of the whole mesh (also limited by maxError)
+ * reaches the target. The quadrics of the final pass are computed on the decimated partitions.
+ *
+ * @param[in,out] mesh The mesh
+ * @param[in] nbOutputPoints The target number of vertices
+ * @param[in] maxError The maximum quadric error of a collapse (0 for no limit)
+ * @param[in] nbPartitions The number of partitions decimated in parallel
+ */
+void decimateMeshByPartitions(Mesh& mesh, int nbOutputPoints, double maxError, int nbPartitions)
+{
+    const int nbInputPoints = mesh.n_vertices();
+
+    std::vector<std::array<int, 3>> faceVertices;
+    faceVertices.reserve(mesh.n_faces());
+    for(Mesh::FaceIter fIt = mesh.faces_begin(); fIt != mesh.faces_end(); ++fIt)
+    {
+        std::array<int, 3> v;
+        int i = 0;
+        for(Mesh::FaceVertexIter fvIt = mesh.fv_iter(*fIt); fvIt.is_valid() && i < 3; ++fvIt)
+            v[i++] = fvIt->idx();
+        if(i == 3)
+            faceVertices.push_back(v);
+    }
+
+    std::vector<std::vector<int>> facesPerPartition;
+    partitionFaces(mesh, faceVertices, nbPartitions, facesPerPartition);
+
+    // partition of each vertex: -1 for the vertices of several partitions (locked), -2 for the unused vertices
+    std::vector<int> vertexPartition(nbInputPoints, -2);
+    for(int p = 0; p < nbPartitions; ++p)
+    {
+        for(int f : facesPerPartition[p])
+        {
+            for(int v : faceVertices[f])
+            {
+                int& vp = vertexPartition[v];
+                vp = (vp == -2 || vp == p) ? p : -1;
+            }
+        }
+    }
+    const int nbBorderPoints = std::count(vertexPartition.begin(), vertexPartition.end(), -1);
+
+    ALICEVISION_LOG_INFO("Decimation of " << nbPartitions << " partitions (" << nbBorderPoints << " vertices on the partitions borders).");
+
+    std::vector<Mesh> partitions(nbPartitions);
+    // input vertex index of the vertices of each partition
+    std::vector<OpenMesh::VPropHandleT<int>> inputIndexes(nbPartitions);
+    // faces that can't be added to their partition (non-manifold configuration on the border),
+    // their vertices are locked and the faces are added when stitching the partitions
+    std::vector<std::vector<int>> pendingFaces(nbPartitions);
+
+    system::ParallelForOptions options;
+    options.grainSize = 1;
+
+    system::parallelFor(0, nbPartitions, [&](int p)
+    {
+        Mesh& subMesh = partitions[p];
+        OpenMesh::VPropHandleT<int>& inputIndex = inputIndexes[p];
+        subMesh.add_property(inputIndex);
+        subMesh.request_vertex_status();
+
+        std::unordered_map<int, Mesh::VertexHandle> subVertices;
+        int nbLockedPoints = 0;
+        for(int f : facesPerPartition[p])
+        {
+            std::array<Mesh::VertexHandle, 3> subFace;
+            for(int i = 0; i < 3; ++i)
+            {
+                const int v = faceVertices[f][i];
+                auto it = subVertices.find(v);
+                if(it == subVertices.end())
+                {
+                    const Mesh::VertexHandle vh = subMesh.add_vertex(mesh.point(Mesh::VertexHandle(v)));
+                    subMesh.property(inputIndex, vh) = v;
+                    if(vertexPartition[v] == -1)
+                    {
+                        subMesh.status(vh).set_locked(true);
+                        ++nbLockedPoints;
+                    }
+                    it = subVertices.emplace(v, vh).first;
+                }
+                subFace[i] = it->second;
+            }
+            if(!subMesh.add_face(subFace[0], subFace[1], subFace[2]).is_valid())
+            {
+                pendingFaces[p].push_back(f);
+                for(const Mesh::VertexHandle& vh : subFace)
+                {
+                    if(!subMesh.status(vh).locked())
+                    {
+                        subMesh.status(vh).set_locked(true);
+                        ++nbLockedPoints;
+                    }
+                }
+            }
+        }
+
+        // share of the target, the locked vertices are kept
+        const int nbSubPoints = subMesh.n_vertices();
+        const int nbSubOutputPoints = std::max(nbLockedPoints, static_cast<int>(static_cast<double>(nbSubPoints) * nbOutputPoints / nbInputPoints));
+        decimateMesh(subMesh, nbSubOutputPoints, maxError);
+    }, options);
+
+    // stitch the partitions on their shared vertices
+    Mesh merged;
+    std::unordered_map<int, Mesh::VertexHandle> borderVertices;
+    int nbMissingFaces = 0;
+    for(int p = 0; p < nbPartitions; ++p)
+    {
+        Mesh& subMesh = partitions[p];
+        std::vector<Mesh::VertexHandle> mergedVertices(subMesh.n_vertices());
+        // merged vertex of the locked vertices of the partition, for its pending faces
+        std::unordered_map<int, Mesh::VertexHandle> lockedVertices;
+        for(Mesh::VertexIter vIt = subMesh.vertices_begin(); vIt != subMesh.vertices_end(); ++vIt)
+        {
+            const int v = subMesh.property(inputIndexes[p], *vIt);
+            if(vertexPartition[v] != -1)
+            {
+                mergedVertices[vIt->idx()] = merged.add_vertex(subMesh.point(*vIt));
+                if(subMesh.status(*vIt).locked())
+                    lockedVertices[v] = mergedVertices[vIt->idx()];
+                continue;
+            }
+            auto it = borderVertices.find(v);
+            if(it == borderVertices.end())
+                it = borderVertices.emplace(v, merged.add_vertex(subMesh.point(*vIt))).first;
+            mergedVertices[vIt->idx()] = it->second;
+        }
+        for(Mesh::FaceIter fIt = subMesh.faces_begin(); fIt != subMesh.faces_end(); ++fIt)
+        {
+            std::array<Mesh::VertexHandle, 3> mergedFace;
+            int i = 0;
+            for(Mesh::FaceVertexIter fvIt = subMesh.fv_iter(*fIt); fvIt.is_valid() && i < 3; ++fvIt)
+                mergedFace[i++] = mergedVertices[fvIt->idx()];
+            if(!merged.add_face(mergedFace[0], mergedFace[1], mergedFace[2]).is_valid())
+                ++nbMissingFaces;
+        }
+        for(int f : pendingFaces[p])
+        {
+            std::array<Mesh::VertexHandle, 3> mergedFace;
+            for(int i = 0; i < 3; ++i)
+            {
+                const int v = faceVertices[f][i];
+                mergedFace[i] = vertexPartition[v] == -1 ? borderVertices.at(v) : lockedVertices.at(v);
+            }
+            if(!merged.add_face(mergedFace[0], mergedFace[1], mergedFace[2]).is_valid())
+                ++nbMissingFaces;
+        }
+        // release the partition
+        subMesh = Mesh();
+    }
+
+    if(nbMissingFaces > 0)
+        ALICEVISION_LOG_WARNING(nbMissingFaces << " facets can't be stitched back (non-manifold configurations).");
+
+    ALICEVISION_LOG_INFO("Decimated partitions: " << merged.n_vertices() << " vertices and " << merged.n_faces() << " facets.");
+
+    mesh = merged;
+    merged = Mesh();
+
+    // final pass: the borders are unlocked
+    if(static_cast<int>(mesh.n_vertices()) > nbOutputPoints)
+        decimateMesh(mesh, nbOutputPoints, maxError);
+}
+
 int main(int argc, char* argv[])
 {
     system::Timer timer;
@@ -43,6 +312,8 @@ int main(int argc, char* argv[])
     int minVertices = 0;
     int maxVertices = 0;
     bool flipNormals = false;
+    double maxError = 0.0;
+    int nbPartitions = 1;
 
     po::options_description allParams("AliceVision meshResampling");
 
@@ -64,7 +335,12 @@ int main(int argc, char* argv[])
         ("maxVertices", po::value<int>(&maxVertices)->default_value(maxVertices),
             "Max number of output vertices.")
         ("flipNormals", po::value<bool>(&flipNormals)->default_value(flipNormals),
-            "Option to flip face normals. It can be needed as it depends on the vertices order in triangles and the convention change from one software to another.");
+            "Option to flip face normals. It can be needed as it depends on the vertices order in triangles and the convention change from one software to another.")
+        ("maxError", po::value<double>(&maxError)->default_value(maxError),
+            "Maximum quadric error of a vertex collapse, the decimation stops before the target if it is reached (0 for no limit).")
+        ("nbPartitions", po::value<int>(&nbPartitions)->default_value(nbPartitions),
+            "Number of spatial partitions of the mesh decimated in parallel, with locked borders, before a final decimation "
+            "of the borders (1 for a sequential decimation, 0 for automatic).");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -110,13 +386,6 @@ int main(int argc, char* argv[])
     if(!bfs::is_directory(outDirectory))
         bfs::create_directory(outDirectory);
 
-    // Mesh type
-    typedef OpenMesh::TriMesh_ArrayKernelT<>                      Mesh;
-    // Decimater type
-    typedef OpenMesh::Decimater::DecimaterT< Mesh >               Decimater;
-    // Decimation Module Handle type
-    typedef OpenMesh::Decimater::ModQuadricT< Mesh >::Handle HModQuadric;
-
     Mesh mesh;
     if(!OpenMesh::IO::read_mesh(mesh, inputMeshPath.c_str()))
     {
@@ -153,29 +422,20 @@ int main(int argc, char* argv[])
     ALICEVISION_LOG_INFO("Input mesh: " << nbInputPoints << " vertices and " << mesh.n_faces() << " facets.");
     ALICEVISION_LOG_INFO("Target output mesh: " << nbOutputPoints << " vertices.");
 
+    if(nbPartitions == 0)
     {
-        // a decimater object, connected to a mesh
-        Decimater   decimater(mesh);
-        // use a quadric module
-        HModQuadric hModQuadric;
-        // register module at the decimater
-        decimater.add(hModQuadric);
-
-        // the way to access the module
-        std::cout << decimater.module(hModQuadric).name() << std::endl;
-
-        /*
-         * since we need exactly one priority module (non-binary)
-         * we have to call set_binary(false) for our priority module
-         * in the case of HModQuadric, unset_max_err() calls set_binary(false) internally
-         */
-        decimater.module(hModQuadric).unset_max_err();
-        // let the decimater initialize the mesh and the modules
-        decimater.initialize();
-        // do decimation
-        size_t removedVertices = decimater.decimate_to(nbOutputPoints);
-        decimater.mesh().garbage_collection();
+        // partitions of about 250k vertices, a few per thread
+        const int nbThreads = system::TaskPool::get().getNbThreads();
+        nbPartitions = std::min(4 * nbThreads, nbInputPoints / 250000);
+        if(nbThreads == 1)
+            nbPartitions = 1;
     }
+
+    if(nbPartitions > 1 && nbOutputPoints < nbInputPoints)
+        decimateMeshByPartitions(mesh, nbOutputPoints, maxError, nbPartitions);
+    else
+        decimateMesh(mesh, nbOutputPoints, maxError);
+
     ALICEVISION_LOG_INFO("Output mesh: " << mesh.n_vertices() << " vertices and " << mesh.n_faces() << " facets.");
 
     if(mesh.n_faces() == 0)
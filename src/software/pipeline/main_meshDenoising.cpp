@@ -7,7 +7,10 @@
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/TaskPool.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
+#include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/Texturing.hpp>
 
 #include <EigenTypes.h>
 #include <MeshTypes.h>
@@ -15,23 +18,244 @@
 #include <MeshNormalFilter.h>
 #include <MeshNormalDenoising.h>
 
-#include <OpenMesh/Core/IO/reader/OBJReader.hh>
-#include <OpenMesh/Core/IO/writer/OBJWriter.hh>
-#include <OpenMesh/Core/IO/IOManager.hh>
-
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
 namespace bfs = boost::filesystem;
 namespace po = boost::program_options;
 
+/**
+ * @brief Move the points in the unit sphere (as SDFilter::normalize_mesh): centered on the bounding box center,
+ *        scaled by the largest distance to the center. The whole mesh is normalized once,
+ *        so the filter parameters have the same meaning in all the partitions.
+ * @param[in,out] points The points
+ * @param[out] center The bounding box center
+ * @param[out] scale The largest distance to the center
+ */
+void normalizePoints(StaticVector<Point3d>& points, Point3d& center, double& scale)
+{
+    Point3d bboxMin = points[0];
+    Point3d bboxMax = points[0];
+    for(const Point3d& p : points)
+    {
+        bboxMin = Point3d(std::min(bboxMin.x, p.x), std::min(bboxMin.y, p.y), std::min(bboxMin.z, p.z));
+        bboxMax = Point3d(std::max(bboxMax.x, p.x), std::max(bboxMax.y, p.y), std::max(bboxMax.z, p.z));
+    }
+    center = (bboxMin + bboxMax) / 2.0;
+
+    scale = 0.0;
+    for(const Point3d& p : points)
+        scale = std::max(scale, (p - center).size());
+    if(scale <= 0.0)
+        scale = 1.0;
+
+    for(Point3d& p : points)
+        p = (p - center) / scale;
+}
+
+/**
+ * @brief Split the faces in spatially coherent partitions of the same size,
+ *        by median splits of the face centers along the longest axis
+ * @param[in] mesh The mesh
+ * @param[in] nbPartitions The number of partitions
+ * @param[out] facesPerPartition The face indexes of each partition
+ */
+void partitionFaces(const mesh::Mesh& mesh, int nbPartitions, std::vector<std::vector<int>>& facesPerPartition)
+{
+    const StaticVector<Point3d>& pts = *mesh.pts;
+    const StaticVector<mesh::Mesh::triangle>& tris = *mesh.tris;
+
+    std::vector<Point3d> centers(tris.size());
+    for(int f = 0; f < tris.size(); ++f)
+        centers[f] = (pts[tris[f].v[0]] + pts[tris[f].v[1]] + pts[tris[f].v[2]]) / 3.0;
+
+    std::vector<int> faces(tris.size());
+    std::iota(faces.begin(), faces.end(), 0);
+    facesPerPartition.assign(nbPartitions, {});
+
+    std::function<void(std::size_t, std::size_t, int, int)> split = [&](std::size_t begin, std::size_t end, int firstPartition, int nbParts)
+    {
+        if(nbParts == 1)
+        {
+            facesPerPartition[firstPartition].assign(faces.begin() + begin, faces.begin() + end);
+            return;
+        }
+
+        Point3d bboxMin = centers[faces[begin]];
+        Point3d bboxMax = bboxMin;
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            const Point3d& c = centers[faces[i]];
+            for(int k = 0; k < 3; ++k)
+            {
+                bboxMin.m[k] = std::min(bboxMin.m[k], c.m[k]);
+                bboxMax.m[k] = std::max(bboxMax.m[k], c.m[k]);
+            }
+        }
+        const Point3d extent = bboxMax - bboxMin;
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+        const int nbLeftParts = nbParts / 2;
+        const std::size_t middle = begin + (end - begin) * nbLeftParts / nbParts;
+        std::nth_element(faces.begin() + begin, faces.begin() + middle, faces.begin() + end,
+                         [&](int a, int b) { return centers[a].m[axis] < centers[b].m[axis]; });
+
+        split(begin, middle, firstPartition, nbLeftParts);
+        split(middle, end, firstPartition + nbLeftParts, nbParts - nbLeftParts);
+    };
+    split(0, faces.size(), 0, nbPartitions);
+}
+
+/**
+ * @brief Denoise a mesh by spatial partitions with overlap, in parallel.
+ *
+ * Each partition is extended by some rings of adjacent faces, the extended partition is denoised
+ * in its own TriMesh (built from the mesh buffers, only for the partition), then only the vertices owned
+ * by the partition are updated: the overlap gives them the neighborhood of the global filter.
+ * The memory of the filter is bounded by the size of the extended partitions running at the same time.
+ *
+ * @param[in,out] mesh The mesh, normalized (see normalizePoints)
+ * @param[in] param The denoising parameters
+ * @param[in] nbPartitions The number of partitions
+ * @param[in] overlapRings The number of rings of adjacent faces added around each partition
+ * @param[in] maxParallelPartitions The maximum number of partitions denoised at the same time (0 for the pool threads)
+ * @return false if the denoising of a partition has failed
+ */
+bool denoiseMeshByPartitions(mesh::Mesh& mesh, const SDFilter::MeshDenoisingParameters& param,
+                             int nbPartitions, int overlapRings, int maxParallelPartitions)
+{
+    const StaticVector<Point3d>& pts = *mesh.pts;
+    const StaticVector<mesh::Mesh::triangle>& tris = *mesh.tris;
+
+    std::vector<std::vector<int>> facesPerPartition;
+    partitionFaces(mesh, nbPartitions, facesPerPartition);
+
+    // faces of each vertex (CSR)
+    std::vector<int> vertexFacesOffsets(pts.size() + 1, 0);
+    for(const mesh::Mesh::triangle& t : tris)
+        for(int v : t.v)
+            ++vertexFacesOffsets[v + 1];
+    std::partial_sum(vertexFacesOffsets.begin(), vertexFacesOffsets.end(), vertexFacesOffsets.begin());
+    std::vector<int> vertexFaces(vertexFacesOffsets.back());
+    {
+        std::vector<int> fill(vertexFacesOffsets.begin(), vertexFacesOffsets.end() - 1);
+        for(int f = 0; f < tris.size(); ++f)
+            for(int v : tris[f].v)
+                vertexFaces[fill[v]++] = f;
+    }
+
+    // partition owning each vertex: the first partition having one of its faces
+    std::vector<int> vertexOwner(pts.size(), -1);
+    for(int p = 0; p < nbPartitions; ++p)
+        for(int f : facesPerPartition[p])
+            for(int v : tris[f].v)
+                if(vertexOwner[v] == -1)
+                    vertexOwner[v] = p;
+
+    // the partitions read the input points, the denoised points are written apart
+    std::vector<Point3d> denoisedPts(pts.begin(), pts.end());
+    std::atomic<bool> failed(false);
+    std::atomic<int> nbMissingFaces(0);
+
+    system::ParallelForOptions options;
+    options.grainSize = 1;
+    options.maxConcurrency = maxParallelPartitions;
+
+    system::parallelFor(0, nbPartitions, [&](int p)
+    {
+        // extend the partition by rings of adjacent faces
+        std::vector<int> faces = facesPerPartition[p];
+        std::unordered_set<int> partitionFaces(faces.begin(), faces.end());
+        std::size_t ringBegin = 0;
+        for(int ring = 0; ring < overlapRings && ringBegin < faces.size(); ++ring)
+        {
+            const std::size_t ringEnd = faces.size();
+            for(std::size_t i = ringBegin; i < ringEnd; ++i)
+            {
+                for(int v : tris[faces[i]].v)
+                {
+                    for(int k = vertexFacesOffsets[v]; k < vertexFacesOffsets[v + 1]; ++k)
+                    {
+                        if(partitionFaces.insert(vertexFaces[k]).second)
+                            faces.push_back(vertexFaces[k]);
+                    }
+                }
+            }
+            ringBegin = ringEnd;
+        }
+        partitionFaces.clear();
+
+        TriMesh subMesh;
+        std::unordered_map<int, TriMesh::VertexHandle> subVertices;
+        std::vector<int> inputIndexes;
+        for(int f : faces)
+        {
+            std::array<TriMesh::VertexHandle, 3> subFace;
+            for(int i = 0; i < 3; ++i)
+            {
+                const int v = tris[f].v[i];
+                auto it = subVertices.find(v);
+                if(it == subVertices.end())
+                {
+                    const Point3d& point = pts[v];
+                    it = subVertices.emplace(v, subMesh.add_vertex(TriMesh::Point(point.x, point.y, point.z))).first;
+                    inputIndexes.push_back(v);
+                }
+                subFace[i] = it->second;
+            }
+            if(!subMesh.add_face(subFace[0], subFace[1], subFace[2]).is_valid())
+                ++nbMissingFaces;
+        }
+        subVertices.clear();
+
+        ALICEVISION_LOG_INFO("Denoising of partition " << p + 1 << "/" << nbPartitions << ": " << facesPerPartition[p].size()
+                             << " facets and " << faces.size() - facesPerPartition[p].size() << " overlapping facets.");
+
+        TriMesh subOutMesh;
+        SDFilter::MeshNormalDenoising denoiser(subMesh);
+        denoiser.denoise(param, subOutMesh);
+        if(subOutMesh.n_vertices() != subMesh.n_vertices())
+        {
+            ALICEVISION_LOG_ERROR("Failed to denoise the partition " << p + 1 << "/" << nbPartitions << ".");
+            failed = true;
+            return;
+        }
+
+        // the vertices keep their order in the denoised mesh
+        for(std::size_t i = 0; i < inputIndexes.size(); ++i)
+        {
+            const int v = inputIndexes[i];
+            if(vertexOwner[v] != p)
+                continue;
+            const TriMesh::Point& point = subOutMesh.point(TriMesh::VertexHandle(i));
+            denoisedPts[v] = Point3d(point[0], point[1], point[2]);
+        }
+    }, options);
+
+    if(nbMissingFaces > 0)
+        ALICEVISION_LOG_WARNING(nbMissingFaces << " facets can't be added to the partitions (non-manifold configurations), they are not used by the filter.");
+
+    std::copy(denoisedPts.begin(), denoisedPts.end(), mesh.pts->begin());
+    return !failed;
+}
+
 int main(int argc, char* argv[])
 {
     system::Timer timer;
@@ -48,6 +272,9 @@ int main(int argc, char* argv[])
     float eta = 1.5;
     float mu = 1.5;
     float nu = 0.3;
+    int maxPartitionFaces = 1000000;
+    int partitionOverlap = 10;
+    int maxParallelPartitions = 0;
 
     po::options_description allParams("AliceVision meshDenoising");
 
@@ -75,7 +302,13 @@ int main(int argc, char* argv[])
         ("meshUpdateMethod", po::value<int>(&meshUpdateMethod)->default_value(meshUpdateMethod),
             "Mesh Update Method: \n"
             "* ITERATIVE_UPDATE(" BOOST_PP_STRINGIZE(SDFilter::MeshFilterParameters::ITERATIVE_UPDATE) ") (default): ShapeUp styled iterative solver\n"
-            "* POISSON_UPDATE(" BOOST_PP_STRINGIZE(SDFilter::MeshFilterParameters::POISSON_UPDATE) "): Poisson-based update from [Want et al. 2015]\n");
+            "* POISSON_UPDATE(" BOOST_PP_STRINGIZE(SDFilter::MeshFilterParameters::POISSON_UPDATE) "): Poisson-based update from [Want et al. 2015]\n")
+        ("maxPartitionFaces", po::value<int>(&maxPartitionFaces)->default_value(maxPartitionFaces),
+            "Maximum number of facets of a partition, the partitions are denoised in parallel (0 to denoise the whole mesh at once).")
+        ("partitionOverlap", po::value<int>(&partitionOverlap)->default_value(partitionOverlap),
+            "Number of rings of adjacent facets added around each partition, for the neighborhood of the filter on the partitions borders.")
+        ("maxParallelPartitions", po::value<int>(&maxParallelPartitions)->default_value(maxParallelPartitions),
+            "Maximum number of partitions denoised at the same time, to bound the memory (0 for the number of threads).");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -122,16 +355,26 @@ int main(int argc, char* argv[])
         bfs::create_directory(outDirectory);
 
 
-    TriMesh inMesh;
-    if(!OpenMesh::IO::read_mesh(inMesh, inputMeshPath.c_str()))
+    mesh::Texturing texturing;
+    try
+    {
+        texturing.loadFromMeshFile(inputMeshPath);
+    }
+    catch(const std::exception& e)
+    {
+        ALICEVISION_LOG_ERROR(e.what());
+    }
+    mesh::Mesh* mesh = texturing.me;
+
+    if(!mesh)
     {
         ALICEVISION_LOG_ERROR("Unable to read input mesh from the file: " << inputMeshPath);
         return EXIT_FAILURE;
     }
-    if(inMesh.n_vertices() == 0 || inMesh.n_faces() == 0)
+    if(mesh->pts->empty() || mesh->tris->empty())
     {
         ALICEVISION_LOG_ERROR("Empty mesh from the file: " << inputMeshPath);
-        ALICEVISION_LOG_ERROR("Input mesh: " << inMesh.n_vertices() << " vertices and " << inMesh.n_faces() << " facets.");
+        ALICEVISION_LOG_ERROR("Input mesh: " << mesh->pts->size() << " vertices and " << mesh->tris->size() << " facets.");
         return EXIT_FAILURE;
     }
 
@@ -168,47 +411,32 @@ int main(int argc, char* argv[])
     param.output();
 
     ALICEVISION_LOG_INFO("Mesh file: \"" << inputMeshPath << "\" loaded.");
-    ALICEVISION_LOG_INFO("Input mesh: " << inMesh.n_vertices() << " vertices and " << inMesh.n_faces() << " facets.");
+    ALICEVISION_LOG_INFO("Input mesh: " << mesh->pts->size() << " vertices and " << mesh->tris->size() << " facets.");
 
-    TriMesh outMesh;
     ALICEVISION_LOG_INFO("Mesh normalization.");
     // Normalize the input mesh
-    Eigen::Vector3d original_center;
-    double original_scale;
-    SDFilter::normalize_mesh(inMesh, original_center, original_scale);
-    if(true)
-    {
-        ALICEVISION_LOG_INFO("Start mesh denoising.");
-        // Filter the normals and construct the output mesh
-        SDFilter::MeshNormalDenoising denoiser(inMesh);
-        denoiser.denoise(param, outMesh);
-        ALICEVISION_LOG_INFO("Mesh denoising done.");
-    }
-    else
-    {
-        ALICEVISION_LOG_INFO("Start mesh filtering.");
-        // Filter the normals and construct the output mesh
-        SDFilter::MeshNormalFilter filter(inMesh);
-        filter.filter(param, outMesh);
-        ALICEVISION_LOG_INFO("Mesh filtering done.");
-    }
-    SDFilter::restore_mesh(outMesh, original_center, original_scale);
+    Point3d originalCenter;
+    double originalScale;
+    normalizePoints(*mesh->pts, originalCenter, originalScale);
 
-    ALICEVISION_LOG_INFO("Output mesh: " << outMesh.n_vertices() << " vertices and " << outMesh.n_faces() << " facets.");
+    const int nbPartitions = (maxPartitionFaces > 0) ? std::max(1, (mesh->tris->size() + maxPartitionFaces - 1) / maxPartitionFaces) : 1;
 
-    if(outMesh.n_faces() == 0)
+    ALICEVISION_LOG_INFO("Start mesh denoising (" << nbPartitions << " partitions).");
+    if(!denoiseMeshByPartitions(*mesh, param, nbPartitions, (nbPartitions > 1) ? partitionOverlap : 0, maxParallelPartitions))
     {
-        ALICEVISION_LOG_ERROR("Failed: the output mesh is empty.");
+        ALICEVISION_LOG_ERROR("Failed: mesh denoising.");
         return EXIT_FAILURE;
     }
+    ALICEVISION_LOG_INFO("Mesh denoising done.");
+
+    for(Point3d& p : *mesh->pts)
+        p = p * originalScale + originalCenter;
+
+    ALICEVISION_LOG_INFO("Output mesh: " << mesh->pts->size() << " vertices and " << mesh->tris->size() << " facets.");
 
     ALICEVISION_LOG_INFO("Save mesh.");
     // Save output mesh
-    if(!OpenMesh::IO::write_mesh(outMesh, outputMeshPath))
-    {
-        ALICEVISION_LOG_ERROR("Failed to save mesh file: \"" << outputMeshPath << "\".");
-        return EXIT_FAILURE;
-    }
+    mesh->save(outputMeshPath);
 
     ALICEVISION_LOG_INFO("Mesh file: \"" << outputMeshPath << "\" saved.");
 
@@ -6,7 +6,9 @@
 
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Profiler.hpp>
 #include <aliceVision/mesh/MeshEnergyOpt.hpp>
 #include <aliceVision/mesh/Texturing.hpp>
 #include <aliceVision/mvsUtils/common.hpp>
@@ -17,7 +19,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 3
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -43,9 +45,9 @@ int main(int argc, char* argv[])
     po::options_description requiredParams("Required parameters");
     requiredParams.add_options()
         ("inputMesh,i", po::value<std::string>(&inputMeshPath)->required(),
-            "Input Mesh (OBJ file format).")
+            "Input Mesh (OBJ or binary PLY file format).")
         ("outputMesh,o", po::value<std::string>(&outputMeshPath)->required(),
-            "Output mesh (OBJ file format).");
+            "Output mesh (OBJ or binary PLY file format, from the extension).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -97,13 +99,15 @@ int main(int argc, char* argv[])
 
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
+    ALICEVISION_PROFILE_REPORT();
+    system::MemoryReport memoryReport("meshFiltering");
 
     bfs::path outDirectory = bfs::path(outputMeshPath).parent_path();
     if(!bfs::is_directory(outDirectory))
         bfs::create_directory(outDirectory);
 
     mesh::Texturing texturing;
-    texturing.loadFromOBJ(inputMeshPath);
+    texturing.loadFromMeshFile(inputMeshPath);
     mesh::Mesh* mesh = texturing.me;
 
     if(!mesh)
@@ -167,7 +171,7 @@ int main(int argc, char* argv[])
     ALICEVISION_LOG_INFO("Save mesh.");
 
     // Save output mesh
-    outMesh.saveToObj(outputMeshPath);
+    outMesh.save(outputMeshPath);
 
     ALICEVISION_LOG_INFO("Mesh file: \"" << outputMeshPath << "\" saved.");
 
@@ -10,6 +10,8 @@
 #include <aliceVision/fuseCut/LargeScale.hpp>
 #include <aliceVision/fuseCut/ReconstructionPlan.hpp>
 #include <aliceVision/fuseCut/DelaunayGraphCut.hpp>
+#include <aliceVision/fuseCut/MemoryEstimation.hpp>
+#include <aliceVision/fuseCut/PartitionedReconstruction.hpp>
 #include <aliceVision/mesh/meshPostProcessing.hpp>
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/Rgb.hpp>
@@ -19,15 +21,23 @@
 #include <aliceVision/mvsUtils/fileIO.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/ParallelReduce.hpp>
 #include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Profiler.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <limits>
+
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 3
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 6
 
 using namespace aliceVision;
 
@@ -149,6 +159,16 @@ int main(int argc, char* argv[])
     bool addLandmarksToTheDensePointCloud = false;
     bool saveRawDensePointCloud = false;
     bool colorizeOutput = false;
+    bool deterministic = system::isDeterministic();
+    int nbPartitions = 8;
+    float partitionsOverlap = 0.1f;
+    int rangeStart = -1;
+    int rangeSize = -1;
+    std::string checkpointsFolder;
+    bool resume = false;
+    bool autoMaxPoints = false;
+    int maxMemory = 0;
+    bool memoryDryRun = false;
 
     fuseCut::FuseParams fuseParams;
 
@@ -161,7 +181,7 @@ int main(int argc, char* argv[])
         ("output,o", po::value<std::string>(&outputDensePointCloud)->required(),
           "Output Dense SfMData file.")
         ("outputMesh,o", po::value<std::string>(&outputMesh)->required(),
-          "Output mesh (OBJ file format).");
+          "Output mesh (OBJ or binary PLY file format, from the extension).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -175,6 +195,13 @@ int main(int argc, char* argv[])
             "Max points at the end of the depth maps fusion.")
         ("maxPointsPerVoxel", po::value<int>(&maxPtsPerVoxel)->default_value(maxPtsPerVoxel),
             "Max points per voxel.")
+        ("autoMaxPoints", po::value<bool>(&autoMaxPoints)->default_value(autoMaxPoints),
+            "Set maxPoints and maxPointsPerVoxel to the largest number of points with a predicted meshing memory lower than maxMemory.")
+        ("maxMemory", po::value<int>(&maxMemory)->default_value(maxMemory),
+            "Memory available for the meshing (in MB), used to check the predicted memory and by autoMaxPoints. "
+            "If 0, the RAM available on the system.")
+        ("memoryDryRun", po::value<bool>(&memoryDryRun)->default_value(memoryDryRun),
+            "Only report the predicted memory of the meshing for the selected number of points.")
         ("minStep", po::value<int>(&fuseParams.minStep)->default_value(fuseParams.minStep),
             "The step used to load depth values from depth maps is computed from maxInputPts. Here we define the minimal value for this step, "
             "so on small datasets we will not spend too much time at the beginning loading all depth values.")
@@ -186,12 +213,28 @@ int main(int argc, char* argv[])
             "Partitioning: 'singleBlock' or 'auto'.")
         ("repartition", po::value<ERepartitionMode>(&repartitionMode)->default_value(repartitionMode),
             "Repartition: 'multiResolution' or 'regularGrid'.")
+        ("nbPartitions", po::value<int>(&nbPartitions)->default_value(nbPartitions),
+            "Minimal number of partitions of the space, with the 'multiResolution' repartition and the 'auto' partitioning. "
+            "The partitions are reconstructed independently, each one with up to maxPoints points, then stitched.")
+        ("partitionsOverlap", po::value<float>(&partitionsOverlap)->default_value(partitionsOverlap),
+            "Size of the overlap added on each side of the partitions, relatively to the partition size (from 0 to 0.5).")
+        ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
+            "Reconstruct a sub-range of partitions from index rangeStart to rangeStart+rangeSize, without stitching them. "
+            "A last call without range stitches the partitions.")
+        ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
+            "Reconstruct a sub-range of N partitions (N=rangeSize).")
         ("estimateSpaceFromSfM", po::value<bool>(&estimateSpaceFromSfM)->default_value(estimateSpaceFromSfM),
             "Estimate the 3d space from the SfM.")
         ("addLandmarksToTheDensePointCloud", po::value<bool>(&addLandmarksToTheDensePointCloud)->default_value(addLandmarksToTheDensePointCloud),
             "Add SfM Landmarks into the dense point cloud (created from depth maps). If only the SfM is provided in input, SfM landmarks will be used regardless of this option.")
         ("colorizeOutput", po::value<bool>(&colorizeOutput)->default_value(colorizeOutput),
-            "Whether to colorize output dense point cloud and mesh.");
+            "Whether to colorize output dense point cloud and mesh.")
+        ("checkpointsFolder", po::value<std::string>(&checkpointsFolder)->default_value(checkpointsFolder),
+            "Folder of the binary checkpoints of the dense point cloud, the tetrahedralization and the graph weights, "
+            "saved in the background after each stage (no checkpoint if empty).")
+        ("resume", po::value<bool>(&resume)->default_value(resume),
+            "Continue the meshing from the last checkpoint of the checkpoints folder, if it exists. "
+            "The inputs and the options of the stages before the checkpoint must be the same.");
 
     po::options_description advancedParams("Advanced parameters");
     advancedParams.add_options()
@@ -217,8 +260,14 @@ int main(int argc, char* argv[])
             "minAngleThreshold")
         ("refineFuse", po::value<bool>(&fuseParams.refineFuse)->default_value(fuseParams.refineFuse),
             "refineFuse")
+        ("spatialHashFusion", po::value<bool>(&fuseParams.spatialHashFusion)->default_value(fuseParams.spatialHashFusion),
+            "Fuse the depth maps in a 3D spatial hash at pixel size resolution: a single read of the depth maps and no kd-tree search. "
+            "refineFuse is not used.")
         ("saveRawDensePointCloud", po::value<bool>(&saveRawDensePointCloud)->default_value(saveRawDensePointCloud),
-            "Save dense point cloud before cut and filtering.");
+            "Save dense point cloud before cut and filtering.")
+        ("deterministic", po::value<bool>(&deterministic)->default_value(deterministic),
+            "Accumulate the ray casting weights in a fixed order and use the sequential max-flow, for results independent of the number of threads. "
+            "Enabled by default with the environment variable ALICEVISION_DETERMINISTIC=1.");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -259,6 +308,14 @@ int main(int argc, char* argv[])
 
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
+    ALICEVISION_PROFILE_REPORT();
+    system::MemoryReport memoryReport("meshing");
+
+    if(resume && checkpointsFolder.empty())
+    {
+      ALICEVISION_LOG_ERROR("The resume option requires a checkpoints folder.");
+      return EXIT_FAILURE;
+    }
 
     if(depthMapsFolder.empty() || depthMapsFilterFolder.empty())
     {
@@ -279,6 +336,12 @@ int main(int argc, char* argv[])
       }
     }
 
+    if(nbPartitions < 1 || partitionsOverlap < 0.0f || partitionsOverlap >= 0.5f)
+    {
+      ALICEVISION_LOG_ERROR("Invalid partitions options: nbPartitions must be positive and partitionsOverlap in [0, 0.5[.");
+      return EXIT_FAILURE;
+    }
+
     // read the input SfM scene
     sfmData::SfMData sfmData;
     if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
@@ -291,6 +354,38 @@ int main(int argc, char* argv[])
     mvsUtils::MultiViewParams mp(sfmData, "", depthMapsFolder, depthMapsFilterFolder, meshingFromDepthMaps);
 
     mp.userParams.put("LargeScale.universePercentile", universePercentile);
+    mp.userParams.put("delaunaycut.deterministic", deterministic);
+    system::setDeterministic(deterministic);
+
+    {
+      const std::size_t availableMemory = (maxMemory > 0) ? std::size_t(maxMemory) * 1024 * 1024 : system::getMemoryInfo().availableRam;
+      const bool parallelMaxflow = !deterministic && omp_get_max_threads() > 1;
+      // the fused points are typically seen by a few cameras
+      const double nbCamerasPerPoint = std::min(double(mp.getNbCameras()), 10.0);
+
+      if(autoMaxPoints)
+      {
+        const std::size_t memoryMaxPoints = fuseCut::computeMaxPointsForMemory(availableMemory, fuseParams.maxInputPoints, nbCamerasPerPoint, parallelMaxflow);
+        if(memoryMaxPoints == 0)
+        {
+          ALICEVISION_LOG_ERROR("The fusion of " << fuseParams.maxInputPoints << " input points (maxInputPoints) does not fit in "
+                                << availableMemory / (1024 * 1024) << " MB.");
+          return EXIT_FAILURE;
+        }
+        fuseParams.maxPoints = int(std::min(memoryMaxPoints, std::size_t(std::numeric_limits<int>::max())));
+        maxPtsPerVoxel = fuseParams.maxPoints;
+        ALICEVISION_LOG_INFO("Max points selected from the available memory: " << fuseParams.maxPoints << ".");
+      }
+
+      const fuseCut::MeshingMemoryEstimation memoryEstimation = fuseCut::estimateMeshingMemory(fuseParams.maxPoints, fuseParams.maxInputPoints,
+                                                                                                nbCamerasPerPoint, parallelMaxflow);
+      ALICEVISION_LOG_INFO(memoryEstimation << std::endl << "Available memory: " << availableMemory / (1024 * 1024) << " MB.");
+      if(memoryEstimation.getPeak() > availableMemory)
+        ALICEVISION_LOG_WARNING("The predicted meshing memory is larger than the available memory, reduce maxPoints or use autoMaxPoints.");
+
+      if(memoryDryRun)
+        return EXIT_SUCCESS;
+    }
 
     int ocTreeDim = mp.userParams.get<int>("LargeScale.gridLevel0", 1024);
     const auto baseDir = mp.userParams.get<std::string>("LargeScale.baseDirName", "root01024");
@@ -411,12 +506,9 @@ int main(int argc, char* argv[])
             switch(partitioningMode)
             {
                 case ePartitioningAuto:
-                {
-                    throw std::invalid_argument("Meshing mode: 'multiResolution', partitioning: 'auto' is not yet implemented.");
-                }
                 case ePartitioningSingleBlock:
                 {
-                    ALICEVISION_LOG_INFO("Meshing mode: multi-resolution, partitioning: single block.");
+                    ALICEVISION_LOG_INFO("Meshing mode: multi-resolution, partitioning: " << (partitioningMode == ePartitioningAuto ? "auto." : "single block."));
                     std::array<Point3d, 8> hexah;
 
                     float minPixSize;
@@ -448,6 +540,50 @@ int main(int argc, char* argv[])
                     }
                     delete voxels;
 
+                    if(partitioningMode == ePartitioningAuto)
+                    {
+                        const std::vector<std::array<Point3d, 8>> partitions = fuseCut::computePartitions(&hexah[0], nbPartitions);
+                        std::vector<std::string> partitionsFolders;
+                        for(int i = 0; i < partitions.size(); ++i)
+                            partitionsFolders.push_back(fuseCut::getPartitionFolder(tmpDirectory.string() + "/", i));
+
+                        int firstPartition = 0;
+                        int lastPartition = partitions.size();
+                        if(rangeSize != -1)
+                        {
+                            if(rangeStart < 0 || rangeSize <= 0)
+                            {
+                                ALICEVISION_LOG_ERROR("Range is incorrect");
+                                return EXIT_FAILURE;
+                            }
+                            firstPartition = std::min(rangeStart, lastPartition);
+                            lastPartition = std::min(rangeStart + rangeSize, lastPartition);
+                        }
+
+                        for(int i = firstPartition; i < lastPartition; ++i)
+                        {
+                            if(mvsUtils::FileExists(partitionsFolders[i] + "mesh.bin"))
+                            {
+                                ALICEVISION_LOG_INFO("Partition " << i << " is already reconstructed.");
+                                continue;
+                            }
+                            ALICEVISION_LOG_INFO("Reconstruct the partition " << i << " of " << partitions.size() << ".");
+                            fuseCut::reconstructPartition(mp, partitions[i], partitionsOverlap, fuseParams,
+                                                          addLandmarksToTheDensePointCloud ? &sfmData : nullptr, spaceSteps, partitionsFolders[i],
+                                                          checkpointsFolder.empty() ? "" : fuseCut::getPartitionFolder(checkpointsFolder + "/", i), resume);
+                        }
+
+                        if(rangeSize != -1)
+                        {
+                            ALICEVISION_LOG_INFO("Partitions " << firstPartition << " to " << lastPartition << " reconstructed, "
+                                                 "run without range to stitch the " << partitions.size() << " partitions.");
+                            return EXIT_SUCCESS;
+                        }
+
+                        fuseCut::joinPartitionsMeshes(partitions, partitionsOverlap, partitionsFolders, mesh, ptsCams);
+                        break;
+                    }
+
                     StaticVector<int> cams;
                     if(meshingFromDepthMaps)
                     {
@@ -464,6 +600,7 @@ int main(int argc, char* argv[])
                         throw std::logic_error("No camera to make the reconstruction");
                     
                     fuseCut::DelaunayGraphCut delaunayGC(&mp);
+                    delaunayGC.setCheckpoints(checkpointsFolder, resume);
                     delaunayGC.createDensePointCloud(&hexah[0], cams, addLandmarksToTheDensePointCloud ? &sfmData : nullptr, meshingFromDepthMaps ? &fuseParams : nullptr);
                     if(saveRawDensePointCloud)
                     {
@@ -499,7 +636,7 @@ int main(int argc, char* argv[])
 
     // Generate output files: 
     // - dense point-cloud with observations as sfmData
-    // - mesh as .obj
+    // - mesh as .obj or .ply
 
     if(mesh == nullptr || mesh->pts->empty() || mesh->tris->empty())
       throw std::runtime_error("No valid mesh was generated.");
@@ -531,8 +668,8 @@ int main(int argc, char* argv[])
     ALICEVISION_LOG_INFO("Save dense point cloud.");
     sfmDataIO::Save(densePointCloud, outputDensePointCloud, sfmDataIO::ESfMData::ALL_DENSE);
 
-    ALICEVISION_LOG_INFO("Save obj mesh file.");
-    mesh->saveToObj(outputMesh);
+    ALICEVISION_LOG_INFO("Save mesh file.");
+    mesh->save(outputMesh);
     delete mesh;
 
 
@@ -8,8 +8,15 @@
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/image/all.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/MemoryBudget.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Profiler.hpp>
+#include <aliceVision/system/Storage.hpp>
+#include <aliceVision/system/TaskPool.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -18,15 +25,19 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <cmath>
+#include <mutex>
 #include <vector>
 #include <set>
 #include <iterator>
 #include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <limits>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -37,6 +48,54 @@ using namespace aliceVision::sfmData;
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
 
+/**
+ * @brief Reference the source image in the output folder instead of re-encoding it:
+ *        create a symbolic link, or copy the file if links are not supported
+ * @param[in] srcImage The source image path
+ * @param[in] dstImage The output image path
+ */
+void linkImage(const std::string& srcImage, const std::string& dstImage)
+{
+  boost::system::error_code ec;
+  fs::remove(dstImage, ec);
+  fs::create_symlink(fs::absolute(srcImage), dstImage, ec);
+  if(ec)
+  {
+    ALICEVISION_LOG_DEBUG("Cannot link '" << dstImage << "' to '" << srcImage << "' (" << ec.message() << "), copy it.");
+    fs::copy_file(srcImage, dstImage, fs::copy_option::overwrite_if_exists);
+  }
+}
+
+/**
+ * @brief Get the number of threads to process the views
+ * @param[in] maxImageMemory The memory used to process the biggest image (in bytes)
+ * @param[in] minImageMemory The memory used to process the smallest image (in bytes)
+ * @param[in] nbViews The number of views to process
+ * @param[in] maxThreads The maximum number of threads, 0 for no limit
+ * @param[out] budgetMemory The memory shared by the threads (in bytes)
+ * @return the number of threads
+ */
+int computeNbThreads(std::size_t maxImageMemory, std::size_t minImageMemory, std::size_t nbViews, int maxThreads, std::size_t& budgetMemory)
+{
+  const std::size_t availableRam = system::getMemoryInfo().availableRam;
+  budgetMemory = std::max(maxImageMemory, static_cast<std::size_t>(0.9 * availableRam));
+
+  // the images are mostly decoded and encoded, which waits for the storage:
+  // use one thread per core and let the memory budget limit the images in memory at the same time
+  std::size_t nbThreads = (availableRam == 0 || minImageMemory == 0) ? 1 : std::max(std::size_t(1), budgetMemory / minImageMemory);
+
+  if(availableRam == 0)
+    ALICEVISION_LOG_WARNING("Cannot find available system memory, this can be due to OS limitations.\n"
+                            "Use only one thread to export the images.");
+
+  if(maxThreads > 0)
+    nbThreads = std::min(static_cast<std::size_t>(maxThreads), nbThreads);
+  nbThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), nbThreads);
+  nbThreads = std::max(std::size_t(1), std::min(nbViews, nbThreads));
+
+  return static_cast<int>(nbThreads);
+}
+
 bool prepareDenseScene(const SfMData& sfmData,
                        const std::vector<std::string>& imagesFolders,
                        int beginIndex,
@@ -45,7 +104,9 @@ bool prepareDenseScene(const SfMData& sfmData,
                        image::EImageFileType outputFileType,
                        bool saveMetadata,
                        bool saveMatricesFiles,
-                       bool evCorrection)
+                       bool evCorrection,
+                       bool linkImages,
+                       int maxThreads)
 {
   // defined view Ids
   std::set<IndexT> viewIds;
@@ -81,13 +142,50 @@ bool prepareDenseScene(const SfMData& sfmData,
   const float medianEv = sfmData.getMedianEv();
   ALICEVISION_LOG_INFO("median Ev : " << medianEv);
 
-#pragma omp parallel for num_threads(3)
-  for(int i = 0; i < viewIds.size(); ++i)
+  // undistortion maps shared by the views of the same intrinsic
+  UndistortionMapCache undistortionMaps;
+
+  // memory of the decoded image and of its undistorted copy
+  const auto imageMemory = [](const View& view) { return view.getWidth() * view.getHeight() * sizeof(RGBfColor) * 2; };
+
+  std::size_t maxImageMemory = 0;
+  std::size_t minImageMemory = std::numeric_limits<std::size_t>::max();
+  for(IndexT viewId : viewIds)
   {
-    auto itView = viewIds.begin();
-    std::advance(itView, i);
+    const std::size_t memory = imageMemory(*sfmData.getViews().at(viewId));
+    maxImageMemory = std::max(maxImageMemory, memory);
+    minImageMemory = std::min(minImageMemory, memory);
+  }
+
+  std::size_t budgetMemory = 0;
+  const int nbThreads = computeNbThreads(maxImageMemory, viewIds.empty() ? 0 : minImageMemory, viewIds.size(), maxThreads, budgetMemory);
+  system::MemoryBudget memoryBudget(budgetMemory);
+
+  ALICEVISION_LOG_INFO("Export the images with " << nbThreads << " thread(s).");
+
+  const std::vector<IndexT> viewIdsList(viewIds.begin(), viewIds.end());
 
-    const IndexT viewId = *itView;
+  system::ParallelForOptions options;
+  options.maxConcurrency = nbThreads;
+  options.grainSize = 1;
+
+  std::mutex progressMutex;
+
+  // read ahead the source images of the next views (downloaded in the storage cache for the remote images)
+  const std::size_t readAheadSize = nbThreads;
+  const auto prefetchImage = [&](std::size_t i)
+  {
+    if(imagesFolders.empty() && i < viewIdsList.size())
+      system::Storage::get().prefetch({sfmData.getViews().at(viewIdsList[i])->getImagePath()});
+  };
+  for(std::size_t i = 0; i < readAheadSize; ++i)
+    prefetchImage(i);
+
+  system::parallelFor(std::size_t(0), viewIdsList.size(), [&](std::size_t i)
+  {
+    prefetchImage(i + readAheadSize);
+
+    const IndexT viewId = viewIdsList[i];
     const View* view = sfmData.getViews().at(viewId).get();
 
     Intrinsics::const_iterator iterIntrinsic = sfmData.getIntrinsics().find(view->getIntrinsicId());
@@ -190,6 +288,26 @@ bool prepareDenseScene(const SfMData& sfmData,
 
       const std::string dstColorImage = (fs::path(outFolder) / (baseFilename + "." + image::EImageFileType_enumToString(outputFileType))).string();
       const IntrinsicBase* cam = iterIntrinsic->second.get();
+
+      // the source image can be used as is if there is nothing to change in its content or metadata
+      if(linkImages && !saveMetadata && !evCorrection && !(cam->isValid() && cam->hasDistortion()))
+      {
+        std::string srcExtension = fs::path(srcImage).extension().string();
+        std::transform(srcExtension.begin(), srcExtension.end(), srcExtension.begin(), ::tolower);
+
+        if(srcExtension == "." + image::EImageFileType_enumToString(outputFileType))
+        {
+          linkImage(srcImage, dstColorImage);
+
+          std::lock_guard<std::mutex> lock(progressMutex);
+          ++progressBar;
+          return;
+        }
+      }
+
+      const std::size_t memory = imageMemory(*view);
+      memoryBudget.acquire(memory);
+
       Image<RGBfColor> image, image_ud;
 
       readImage(srcImage, image, image::EImageColorSpace::LINEAR);
@@ -215,18 +333,20 @@ bool prepareDenseScene(const SfMData& sfmData,
       if(cam->isValid() && cam->have_disto())
       {
         // undistort the image and save it
-        UndistortImage(image, cam, image_ud, FBLACK);
+        UndistortImage(image, cam, image_ud, FBLACK, undistortionMaps);
         writeImage(dstColorImage, image_ud, image::EImageColorSpace::AUTO, metadata);
       }
       else
       {
         writeImage(dstColorImage, image, image::EImageColorSpace::AUTO, metadata);
       }
+
+      memoryBudget.release(memory);
     }
 
-    #pragma omp critical
+    std::lock_guard<std::mutex> lock(progressMutex);
     ++progressBar;
-  }
+  }, options);
 
   return true;
 }
@@ -245,6 +365,8 @@ int main(int argc, char *argv[])
   bool saveMetadata = true;
   bool saveMatricesTxtFiles = false;
   bool evCorrection = false;
+  bool linkImages = false;
+  int maxThreads = 0;
 
   po::options_description allParams("AliceVision prepareDenseScene");
 
@@ -271,7 +393,14 @@ int main(int argc, char *argv[])
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
       "Range size.")
     ("evCorrection", po::value<bool>(&evCorrection)->default_value(evCorrection),
-      "Correct exposure value.");
+      "Correct exposure value.")
+    ("linkImages", po::value<bool>(&linkImages)->default_value(linkImages),
+      "Link the source images (or copy them if links are not supported) instead of re-encoding them "
+      "when they already have the output file type and nothing has to be changed: "
+      "no distortion, no exposure correction and no metadata to save. "
+      "The linked images have no exposure metadata for the later exposure corrections.")
+    ("maxThreads", po::value<int>(&maxThreads)->default_value(maxThreads),
+      "Maximum number of threads to export the images (0: from the available memory and cores).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -310,6 +439,8 @@ int main(int argc, char *argv[])
 
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
+  ALICEVISION_PROFILE_REPORT();
+  system::MemoryReport memoryReport("prepareDenseScene");
 
   // set output file type
   image::EImageFileType outputFileType = image::EImageFileType_stringToEnum(outImageFileTypeName);
@@ -349,7 +480,7 @@ int main(int argc, char *argv[])
   }
 
   // export
-  if(prepareDenseScene(sfmData, imagesFolders, rangeStart, rangeEnd, outFolder, outputFileType, saveMetadata, saveMatricesTxtFiles, evCorrection))
+  if(prepareDenseScene(sfmData, imagesFolders, rangeStart, rangeEnd, outFolder, outputFileType, saveMetadata, saveMatricesTxtFiles, evCorrection, linkImages, maxThreads))
     return EXIT_SUCCESS;
 
   return EXIT_FAILURE;
@@ -34,6 +34,8 @@
 #include <vector>
 #include <chrono>
 #include <memory>
+#include <map>
+#include <mutex>
 
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
 #include <aliceVision/sfmDataIO/AlembicExporter.hpp>
@@ -42,7 +44,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -107,6 +109,8 @@ int main(int argc, char** argv)
   std::size_t numResults = 4;
   /// maximum number of matching documents to retain
   std::size_t maxResults = 10;
+  /// maximum number of frames waiting between two stages of the localization pipeline
+  std::size_t pipelineQueueSize = 2;
   
   // parameters for cctag localizer
   std::size_t nNearestKeyFrames = 5;
@@ -176,6 +180,10 @@ int main(int argc, char** argv)
           "[voctree] Maximum matching error (in pixels) allowed for image matching with "
           "geometric verification. If set to 0 it lets the ACRansac select "
           "an optimal value.")
+      ("pipelineQueueSize", po::value<std::size_t>(&pipelineQueueSize)->default_value(pipelineQueueSize),
+          "[voctree] Localize the frames of each camera with a pipeline: the features extraction, the matching "
+          "and the pose estimation of consecutive frames run at the same time. Maximum number "
+          "of frames waiting between two stages of the pipeline (0 = Disable)")
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_CCTAG)
   // parameters for cctag localizer
       ("nNearestKeyFrames", po::value<std::size_t>(&nNearestKeyFrames)->default_value(nNearestKeyFrames),
@@ -376,47 +384,104 @@ int main(int argc, char** argv)
     // used to collect the match data result
     std::vector<localization::LocalizationResult> vLocalizationResults;
     std::size_t currentFrame = 0;
-    while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+
+    // save the localization result of a frame, the frames are saved in order
+    const auto saveFrame = [&](const localization::LocalizationResult& localizationResult,
+                               const camera::PinholeRadialK3& frameIntrinsics,
+                               std::size_t frameId)
     {
-      ALICEVISION_COUT("******************************");
-      ALICEVISION_COUT("Stream " << idCamera << " Frame " << myToString(currentFrame, 4) << "/" << nbFrames << " : (" << iInputFrame << "/" << nbFramesToProcess << ")");
-      ALICEVISION_COUT("******************************");
-      auto detect_start = std::chrono::steady_clock::now();
-      localization::LocalizationResult localizationResult;
-      localizer->setCudaPipe( idCamera );
-      const bool ok = localizer->localize(imageGrey,
-                                          param.get(),
-                                          hasIntrinsics/*useInputIntrinsics*/,
-                                          queryIntrinsics,
-                                          localizationResult);
-      assert( ok == localizationResult.isValid() );
       vLocalizationResults.emplace_back(localizationResult);
-      sfmData::CameraPose pose(localizationResult.getPose());
-      auto detect_end = std::chrono::steady_clock::now();
-      auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-      ALICEVISION_COUT("Localization took  " << detect_elapsed.count() << " [ms]");
-      stats(detect_elapsed.count());
-      
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_ALEMBIC)
+      sfmData::CameraPose pose(localizationResult.getPose());
       if(localizationResult.isValid())
       {
-        exporter.addCamera("camera"+std::to_string(idCamera)+"."+myToString(currentFrame,4),
-                           sfmData::View(subMediaFilepath, currentFrame, currentFrame),
+        exporter.addCamera("camera"+std::to_string(idCamera)+"."+myToString(frameId,4),
+                           sfmData::View(subMediaFilepath, frameId, frameId),
                            &pose,
-                           &queryIntrinsics);
+                           &frameIntrinsics);
       }
       else
       {
         // @fixme for now just add a fake camera so that it still can be see in MAYA
-        exporter.addCamera("camera"+std::to_string(idCamera)+".V."+myToString(currentFrame,4),
-                           sfmData::View(subMediaFilepath, currentFrame, currentFrame),
+        exporter.addCamera("camera"+std::to_string(idCamera)+".V."+myToString(frameId,4),
+                           sfmData::View(subMediaFilepath, frameId, frameId),
                            &pose,
-                           &queryIntrinsics);
+                           &frameIntrinsics);
       }
 #endif
-      ++iInputFrame;
-      currentFrame = std::floor(iInputFrame * step);
-      feed.goToFrame(currentFrame);
+    };
+
+    localizer->setCudaPipe( idCamera );
+    localization::VoctreeLocalizer* voctreeLocalizer = dynamic_cast<localization::VoctreeLocalizer*>(localizer.get());
+
+    if(voctreeLocalizer != nullptr && pipelineQueueSize > 0)
+    {
+      // start time of the frames in the pipeline
+      std::map<std::size_t, std::chrono::steady_clock::time_point> framesStart;
+      std::mutex framesStartMutex;
+
+      // called from the extraction stage
+      const auto readFrame = [&](localization::SequenceFrame& frame)
+      {
+        if(!feed.readImage(frame.imageGrey, frame.queryIntrinsics, frame.imagePath, frame.useInputIntrinsics))
+          return false;
+
+        ALICEVISION_COUT("Stream " << idCamera << " Frame " << myToString(currentFrame, 4) << "/" << nbFrames << " : (" << iInputFrame << "/" << nbFramesToProcess << ")");
+        frame.frameId = currentFrame;
+        {
+          std::lock_guard<std::mutex> lock(framesStartMutex);
+          framesStart[frame.frameId] = std::chrono::steady_clock::now();
+        }
+        ++iInputFrame;
+        currentFrame = std::floor(iInputFrame * step);
+        feed.goToFrame(currentFrame);
+        return true;
+      };
+
+      // called from the pose estimation stage, in the frames order
+      const auto onLocalized = [&](const localization::SequenceFrame& frame, const localization::LocalizationResult& localizationResult)
+      {
+        std::chrono::steady_clock::time_point frameStart;
+        {
+          std::lock_guard<std::mutex> lock(framesStartMutex);
+          frameStart = framesStart.at(frame.frameId);
+          framesStart.erase(frame.frameId);
+        }
+        const auto frameElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - frameStart);
+        ALICEVISION_COUT("Stream " << idCamera << " Frame " << myToString(frame.frameId, 4) << ": localization took " << frameElapsed.count() << " [ms]");
+        stats(frameElapsed.count());
+
+        saveFrame(localizationResult, frame.queryIntrinsics, frame.frameId);
+      };
+
+      voctreeLocalizer->localizeSequence(readFrame, param.get(), onLocalized, pipelineQueueSize);
+    }
+    else
+    {
+      while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+      {
+        ALICEVISION_COUT("******************************");
+        ALICEVISION_COUT("Stream " << idCamera << " Frame " << myToString(currentFrame, 4) << "/" << nbFrames << " : (" << iInputFrame << "/" << nbFramesToProcess << ")");
+        ALICEVISION_COUT("******************************");
+        auto detect_start = std::chrono::steady_clock::now();
+        localization::LocalizationResult localizationResult;
+        const bool ok = localizer->localize(imageGrey,
+                                            param.get(),
+                                            hasIntrinsics/*useInputIntrinsics*/,
+                                            queryIntrinsics,
+                                            localizationResult);
+        assert( ok == localizationResult.isValid() );
+        auto detect_end = std::chrono::steady_clock::now();
+        auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+        ALICEVISION_COUT("Localization took  " << detect_elapsed.count() << " [ms]");
+        stats(detect_elapsed.count());
+
+        saveFrame(localizationResult, queryIntrinsics, currentFrame);
+
+        ++iInputFrame;
+        currentFrame = std::floor(iInputFrame * step);
+        feed.goToFrame(currentFrame);
+      }
     }
 
     rig.setTrackingResult(vLocalizationResults, idCamera);
@@ -0,0 +1,169 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfm/pipeline/pairwiseMatchesIO.hpp>
+#include <aliceVision/sfm/pipeline/hierarchical/clustering.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/config.hpp>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <cstdlib>
+#include <fstream>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+int main(int argc, char **argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string sfmDataFilename;
+  std::vector<std::string> matchesFolders;
+  std::string outputFolder;
+
+  // user optional parameters
+
+  std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  sfm::ClusteringParams clusteringParams;
+  bool useOnlyMatchesFromInputFolder = false;
+
+  po::options_description allParams(
+    "Partition the views of a scene in overlapping clusters, each one reconstructed independently\n"
+    "(with incrementalSfM, possibly on separate nodes) and merged with sfmMerging.\n"
+    "AliceVision sfmClustering");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
+      "SfMData file.")
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output folder for the SfMData files of the clusters.")
+    ("matchesFolders,m", po::value<std::vector<std::string>>(&matchesFolders)->multitoken()->required(),
+      "Path to folder(s) in which computed matches are stored.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
+      feature::EImageDescriberType_informations().c_str())
+    ("maxClusterSize", po::value<std::size_t>(&clusteringParams.maxClusterSize)->default_value(clusteringParams.maxClusterSize),
+      "Maximum number of views in a cluster, before the expansion of the overlap.")
+    ("overlapRatio", po::value<double>(&clusteringParams.overlapRatio)->default_value(clusteringParams.overlapRatio),
+      "Number of views added to each cluster from its neighbor clusters, as a ratio of the cluster size.\n"
+      "The clusters are merged on their common views, so at least 3 of them must be reconstructed.")
+    ("useOnlyMatchesFromInputFolder", po::value<bool>(&useOnlyMatchesFromInputFolder)->default_value(useOnlyMatchesFromInputFolder),
+      "Use only matches from the input matchesFolder parameter.\n"
+      "Matches folders previously added to the SfMData file will be ignored.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  // load input SfMData scene
+  sfmData::SfMData sfmData;
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmDataFilename + "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  // get imageDescriber type
+  const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
+
+  // matches reading
+  matching::PairwiseMatches pairwiseMatches;
+  if(!sfm::loadPairwiseMatches(pairwiseMatches, sfmData, matchesFolders, describerTypes, 0, useOnlyMatchesFromInputFolder))
+  {
+    ALICEVISION_LOG_ERROR("Unable to load matches.");
+    return EXIT_FAILURE;
+  }
+
+  // partition the view graph
+  std::map<Pair, std::size_t> pairWeights;
+  sfm::computePairWeights(pairwiseMatches, pairWeights);
+
+  std::vector<std::set<IndexT>> clusters;
+  sfm::clusterViewGraph(pairWeights, clusteringParams, clusters);
+
+  if(clusters.empty())
+  {
+    ALICEVISION_LOG_ERROR("No cluster found, the matches are empty.");
+    return EXIT_FAILURE;
+  }
+
+  if(!fs::exists(outputFolder))
+    fs::create_directory(outputFolder);
+
+  // export the scene of each cluster, the matches folders are kept so each one can be reconstructed independently
+  sfmData.addMatchesFolders(matchesFolders);
+
+  std::ofstream clustersFile((fs::path(outputFolder) / "clusters.txt").string());
+  for(std::size_t i = 0; i < clusters.size(); ++i)
+  {
+    const std::string clusterFilename = (fs::path(outputFolder) / ("cluster_" + std::to_string(i) + ".sfm")).string();
+
+    sfmData::SfMData clusterSfmData;
+    sfm::createClusterSfMData(sfmData, clusters.at(i), clusterSfmData);
+    clusterSfmData.setAbsolutePath(clusterFilename);
+
+    ALICEVISION_LOG_INFO("Export cluster " << i << " (" << clusterSfmData.getViews().size() << " views): " << clusterFilename);
+    if(!sfmDataIO::Save(clusterSfmData, clusterFilename, sfmDataIO::ESfMData::ALL))
+    {
+      ALICEVISION_LOG_ERROR("Unable to save the cluster SfMData file: " << clusterFilename);
+      return EXIT_FAILURE;
+    }
+    clustersFile << clusterFilename << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/sfmFilters.hpp>
+#include <aliceVision/sfm/pipeline/hierarchical/merging.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/config.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+
+int main(int argc, char **argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::vector<std::string> sfmDataFilenames;
+  std::string outSfMDataFilename;
+
+  // user optional parameters
+
+  std::size_t minNbCommonViews = 3;
+  double maxReprojectionError = 4.0;
+  bool lockAllIntrinsics = false;
+
+  po::options_description allParams(
+    "Merge the reconstructions of overlapping clusters (see sfmClustering) in a single scene,\n"
+    "aligned on their common views and refined with a final bundle adjustment.\n"
+    "AliceVision sfmMerging");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::vector<std::string>>(&sfmDataFilenames)->multitoken()->required(),
+      "SfMData files of the cluster reconstructions.")
+    ("output,o", po::value<std::string>(&outSfMDataFilename)->required(),
+      "Output SfMData scene.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("minNbCommonViews", po::value<std::size_t>(&minNbCommonViews)->default_value(minNbCommonViews),
+      "Minimum number of reconstructed views in common with the merged scene to align a reconstruction.")
+    ("maxReprojectionError", po::value<double>(&maxReprojectionError)->default_value(maxReprojectionError),
+      "Maximum reprojection error (in pixels) of the observations after the first bundle adjustment.")
+    ("lockAllIntrinsics", po::value<bool>(&lockAllIntrinsics)->default_value(lockAllIntrinsics),
+      "Force lock of all camera intrinsic parameters, so they will not be refined during Bundle Adjustment.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  // load the cluster reconstructions
+  std::vector<sfmData::SfMData> reconstructions(sfmDataFilenames.size());
+  for(std::size_t i = 0; i < sfmDataFilenames.size(); ++i)
+  {
+    if(!sfmDataIO::Load(reconstructions.at(i), sfmDataFilenames.at(i), sfmDataIO::ESfMData::ALL))
+    {
+      ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmDataFilenames.at(i) + "' cannot be read.");
+      return EXIT_FAILURE;
+    }
+  }
+
+  aliceVision::system::Timer timer;
+
+  sfmData::SfMData sfmData;
+  if(sfm::mergeReconstructions(reconstructions, sfmData, minNbCommonViews) == 0)
+  {
+    ALICEVISION_LOG_ERROR("No reconstruction to merge.");
+    return EXIT_FAILURE;
+  }
+  reconstructions.clear();
+
+  // final bundle adjustment of the merged scene, the clusters are already refined:
+  // adjust everything at once, remove the outliers of the overlaps and adjust again
+  sfm::BundleAdjustmentCeres::CeresOptions options;
+  options.setAutoBA(); // select the linear solver from the size of the scene
+  sfm::BundleAdjustmentCeres BA(options);
+
+  sfm::BundleAdjustment::ERefineOptions refineOptions = sfm::BundleAdjustment::REFINE_ROTATION | sfm::BundleAdjustment::REFINE_TRANSLATION | sfm::BundleAdjustment::REFINE_STRUCTURE;
+  if(!lockAllIntrinsics)
+    refineOptions |= sfm::BundleAdjustment::REFINE_INTRINSICS_ALL;
+
+  if(!BA.adjust(sfmData, refineOptions))
+  {
+    ALICEVISION_LOG_ERROR("Bundle adjustment of the merged scene failed.");
+    return EXIT_FAILURE;
+  }
+
+  const IndexT nbOutliers = sfm::RemoveOutliers_PixelResidualError(sfmData, maxReprojectionError);
+  ALICEVISION_LOG_INFO("Removed " << nbOutliers << " outlier observations (reprojection error > " << maxReprojectionError << " px).");
+
+  if(nbOutliers > 0 && !BA.adjust(sfmData, refineOptions))
+  {
+    ALICEVISION_LOG_ERROR("Bundle adjustment of the merged scene failed.");
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_LOG_INFO("Merging took (s): " + std::to_string(timer.elapsed()));
+
+  ALICEVISION_LOG_INFO("Export SfMData to disk: " + outSfMDataFilename);
+  sfmData.setAbsolutePath(outSfMDataFilename);
+  if(!sfmDataIO::Save(sfmData, outSfMDataFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("Unable to save the merged SfMData file: " << outSfMDataFilename);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_LOG_INFO("Merged Structure from Motion results:" << std::endl
+    << "\t- # input reconstructions: " << sfmDataFilenames.size() << std::endl
+    << "\t- # cameras calibrated: " << sfmData.getValidViews().size() << std::endl
+    << "\t- # poses: " << sfmData.getPoses().size() << std::endl
+    << "\t- # landmarks: " << sfmData.getLandmarks().size());
+
+  return EXIT_SUCCESS;
+}
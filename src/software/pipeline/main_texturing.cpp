@@ -15,7 +15,9 @@
 #include <aliceVision/mvsUtils/ImagesCache.hpp>
 #include <aliceVision/system/cmdline.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryTracker.hpp>
 #include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/Profiler.hpp>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -23,7 +25,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 3
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 3
 
 using namespace aliceVision;
 
@@ -60,7 +62,7 @@ int main(int argc, char* argv[])
         ("input,i", po::value<std::string>(&sfmDataFilename)->required(),
           "Dense point cloud SfMData file.")
         ("inputMesh", po::value<std::string>(&inputMeshFilepath)->required(),
-            "Input mesh to texture.")
+            "Input mesh to texture (OBJ or binary PLY file format).")
         ("output,o", po::value<std::string>(&outputFolder)->required(),
             "Folder for output mesh: OBJ, material and texture files.");
 
@@ -108,7 +110,13 @@ int main(int argc, char* argv[])
             "Method to remap visibilities from the reconstruction to the input mesh.\n"
             " * Pull: For each vertex of the input mesh, pull the visibilities from the closest vertex in the reconstruction.\n"
             " * Push: For each vertex of the reconstruction, push the visibilities to the closest triangle in the input mesh.\n"
-            " * PullPush: Combine results from Pull and Push results.'");
+            " * PullPush: Combine results from Pull and Push results.'")
+        ("maxMemory", po::value<int>(&texParams.maxMemory)->default_value(texParams.maxMemory),
+            "Memory budget of the texture generation (in MB), shared by the atlases filled together and the cameras processed together. "
+            "0 to use the available RAM.")
+        ("useGpu", po::value<bool>(&texParams.useGpu)->default_value(texParams.useGpu),
+            "Accumulate the contributions of the cameras in the atlases on the GPU (CUDA builds only). "
+            "The texture generation falls back to the CPU if no device or not enough device memory is available.");
 
     po::options_description logParams("Log parameters");
     logParams.add_options()
@@ -149,6 +157,8 @@ int main(int argc, char* argv[])
 
     // set verbose level
     system::Logger::get()->setLogLevel(verboseLevel);
+    ALICEVISION_PROFILE_REPORT();
+    system::MemoryReport memoryReport("texturing");
 
     texParams.visibilityRemappingMethod = mesh::EVisibilityRemappingMethod_stringToEnum(visibilityRemappingMethod);
     texParams.processColorspace = imageIO::EImageColorSpace_stringToEnum(processColorspaceName);
@@ -176,8 +186,8 @@ int main(int argc, char* argv[])
     {
       mesh.clear();
 
-      // load input obj file
-      mesh.loadFromOBJ(inputMeshFilepath, flipNormals);
+      // load input mesh file
+      mesh.loadFromMeshFile(inputMeshFilepath, flipNormals);
 
       // load reference dense point cloud with visibilities
       mesh::Mesh refPoints;
@@ -22,7 +22,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::sfm;
@@ -41,6 +41,7 @@ int main(int argc, char **argv)
   std::string outputStats;
   std::string algorithm = cov::EAlgorithm_enumToString(cov::eAlgorithmSvdTaylorExpansion);
   bool debug = false;
+  bool sparsePosesCovariance = false;
 
   po::options_description params("AliceVision Uncertainty");
   params.add_options()
@@ -52,6 +53,9 @@ int main(int argc, char **argv)
     "Output covariances file.")
   ("algorithm,a", po::value<std::string>(&algorithm)->default_value(algorithm),
     "Algorithm.")
+  ("sparsePosesCovariance", po::value<bool>(&sparsePosesCovariance)->default_value(sparsePosesCovariance),
+    "Only compute the poses uncertainty from the block diagonal of the covariance, with a sparse factorization of the Jacobian. "
+    "The algorithm and outputCov options are not used and the landmarks uncertainty is not computed.")
   ("debug,d", po::value<bool>(&debug)->default_value(debug),
     "Enable creation of debug files in the current folder.")
     ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
@@ -102,14 +106,34 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
-  ceres::CRSMatrix jacobian;
+  const BundleAdjustment::ERefineOptions refineOptions = BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE;
+
+  if(sparsePosesCovariance)
   {
-    BundleAdjustmentCeres bundleAdjustmentObj;
-    BundleAdjustment::ERefineOptions refineOptions = BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE;
-    bundleAdjustmentObj.createJacobian(sfmData, refineOptions, jacobian);
-  }
+    HashMap<IndexT, Mat> posesCovariance;
+    {
+      BundleAdjustmentCeres bundleAdjustmentObj;
+      if(!bundleAdjustmentObj.computePosesCovariance(sfmData, refineOptions, posesCovariance))
+      {
+        std::cerr << "The poses covariance cannot be computed." << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
 
+    for(const auto& poseCovariancePair : posesCovariance)
+    {
+      const Eigen::SelfAdjointEigenSolver<Mat> eigenSolver(poseCovariancePair.second, Eigen::EigenvaluesOnly);
+      sfmData._posesUncertainty[poseCovariancePair.first] = eigenSolver.eigenvalues(); // create uncertainty entry
+    }
+  }
+  else
   {
+    ceres::CRSMatrix jacobian;
+    {
+      BundleAdjustmentCeres bundleAdjustmentObj;
+      bundleAdjustmentObj.createJacobian(sfmData, refineOptions, jacobian);
+    }
+
     cov::Options options;
     // Configure covariance engine (find the indexes of the most distatnt points etc.)
     // setPts2Fix(opt, mutable_points.size() / 3, mutable_points.data());
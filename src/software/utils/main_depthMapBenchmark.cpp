@@ -0,0 +1,356 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/Pinhole.hpp>
+#include <aliceVision/depthMap/RefineRc.hpp>
+#include <aliceVision/depthMap/cuda/PlaneSweepingCuda.hpp>
+#include <aliceVision/mvsData/Point2d.hpp>
+#include <aliceVision/mvsData/Point3d.hpp>
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/imageIO.hpp>
+#include <aliceVision/mvsUtils/MultiViewParams.hpp>
+#include <aliceVision/mvsUtils/fileIO.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include "syntheticDataset/SyntheticDataset.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace bpt = boost::property_tree;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Compare the depth maps to the ground truth depths of the scene.
+ * @param[in] threshold the relative depth error of an inlier
+ * @return the completeness, inlier ratio and relative depth error statistics
+ */
+bpt::ptree getAccuracy(const mvsUtils::MultiViewParams& mp, const syntheticDataset::SyntheticScene& scene, double threshold)
+{
+  std::vector<double> relativeErrors;
+  std::size_t nbPixels = 0;
+
+  for(int rc = 0; rc < mp.ncams; ++rc)
+  {
+    int width = 0;
+    int height = 0;
+    std::vector<float> depthMap;
+    imageIO::readImage(getFileNameFromIndex(&mp, rc, mvsUtils::EFileType::depthMap, 1), width, height, depthMap, imageIO::EImageColorSpace::NO_CONVERSION);
+
+    const double pixelRatio = mp.getWidth(rc) / static_cast<double>(width);
+    const Point3d& C = mp.CArr[rc];
+
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        const Point3d direction = (mp.iCamArr[rc] * Point2d(x * pixelRatio, y * pixelRatio)).normalize();
+        const double groundTruth = scene.intersect(Vec3(C.x, C.y, C.z), Vec3(direction.x, direction.y, direction.z));
+        if(groundTruth <= 0.0)
+          continue;
+
+        ++nbPixels;
+        const float depth = depthMap[y * width + x];
+        if(depth > 0.0f)
+          relativeErrors.push_back(std::abs(depth - groundTruth) / groundTruth);
+      }
+    }
+  }
+
+  bpt::ptree accuracyTree;
+  const std::size_t nbInliers = std::count_if(relativeErrors.begin(), relativeErrors.end(), [&](double e) { return e < threshold; });
+  accuracyTree.put("completeness", nbPixels > 0 ? relativeErrors.size() / double(nbPixels) : 0.0);
+  accuracyTree.put("inlierRatio", nbPixels > 0 ? nbInliers / double(nbPixels) : 0.0);
+
+  if(!relativeErrors.empty())
+  {
+    double sum = 0.0;
+    for(const double e : relativeErrors)
+      sum += e;
+    std::nth_element(relativeErrors.begin(), relativeErrors.begin() + relativeErrors.size() / 2, relativeErrors.end());
+    accuracyTree.put("relativeErrorMean", sum / relativeErrors.size());
+    accuracyTree.put("relativeErrorMedian", relativeErrors[relativeErrors.size() / 2]);
+  }
+  return accuracyTree;
+}
+
+/**
+ * @brief Sum the device profiles of the depth maps (see depthMap::DeviceProfile).
+ * @return the total time, compute time, transfer time and peak device memory, per stage and overall
+ */
+bpt::ptree getDeviceStatistics(const mvsUtils::MultiViewParams& mp)
+{
+  std::map<std::string, bpt::ptree> stagesTrees;
+  bpt::ptree deviceTree;
+  double timeMs = 0.0;
+  double computeMs = 0.0;
+  double transferMs = 0.0;
+  float peakUsedMemoryMB = 0.0f;
+
+  for(int rc = 0; rc < mp.ncams; ++rc)
+  {
+    const std::string profileFilepath = getFileNameFromIndex(&mp, rc, mvsUtils::EFileType::deviceProfile, 1);
+    if(!fs::exists(profileFilepath))
+      continue;
+
+    bpt::ptree profileTree;
+    bpt::read_json(profileFilepath, profileTree);
+
+    timeMs += profileTree.get<double>("timeMs", 0.0);
+    computeMs += profileTree.get<double>("computeMs", 0.0);
+    transferMs += profileTree.get<double>("transferMs", 0.0);
+    peakUsedMemoryMB = std::max(peakUsedMemoryMB, profileTree.get<float>("peakUsedMemoryMB", 0.0f));
+
+    for(const auto& stage : profileTree.get_child("stages", bpt::ptree()))
+    {
+      bpt::ptree& stageTree = stagesTrees[stage.first];
+      for(const char* key : {"nbCalls", "timeMs", "computeMs", "transferMs", "transferMB"})
+        stageTree.put(key, stageTree.get<double>(key, 0.0) + stage.second.get<double>(key, 0.0));
+      stageTree.put("peakUsedMemoryMB", std::max(stageTree.get<float>("peakUsedMemoryMB", 0.0f), stage.second.get<float>("peakUsedMemoryMB", 0.0f)));
+    }
+  }
+
+  deviceTree.put("timeMs", timeMs);
+  deviceTree.put("computeMs", computeMs);
+  deviceTree.put("transferMs", transferMs);
+  deviceTree.put("peakUsedMemoryMB", peakUsedMemoryMB);
+
+  bpt::ptree allStagesTree;
+  for(const auto& stageTree : stagesTrees)
+    allStagesTree.add_child(stageTree.first, stageTree.second);
+  deviceTree.add_child("stages", allStagesTree);
+  return deviceTree;
+}
+
+int main(int argc, char** argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string outputFolder;
+  std::string outputFilename;
+  int nbViews = 5;
+  double arcAngle = 30.0;
+  int width = 1600;
+  int height = 1200;
+  std::string downscalesString = "4,2";
+  std::string nbDepthsString = "1500";
+  int cudaDevice = 0;
+  double inlierThreshold = 0.01;
+  double minInlierRatio = 0.0;
+
+  po::options_description allParams(
+    "Render a synthetic textured scene with known poses, compute its depth maps and measure "
+    "the time and memory of each device stage, the CPU time and the accuracy against the ground truth, "
+    "for each downscale and number of depths.\n"
+    "AliceVision depthMapBenchmark");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output folder for the synthetic images and the depth maps.")
+    ("outputBenchmark", po::value<std::string>(&outputFilename)->required(),
+      "Output benchmark JSON file.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("nbViews", po::value<int>(&nbViews)->default_value(nbViews),
+      "Number of views of the synthetic scene.")
+    ("arcAngle", po::value<double>(&arcAngle)->default_value(arcAngle),
+      "Angle of the arc of the views around the scene (in degrees).")
+    ("width", po::value<int>(&width)->default_value(width),
+      "Width of the synthetic images.")
+    ("height", po::value<int>(&height)->default_value(height),
+      "Height of the synthetic images.")
+    ("downscales", po::value<std::string>(&downscalesString)->default_value(downscalesString),
+      "Image downscale factors to benchmark, separated by commas.")
+    ("nbDepths", po::value<std::string>(&nbDepthsString)->default_value(nbDepthsString),
+      "Maximum numbers of depths of the SGM to benchmark, separated by commas.")
+    ("cudaDevice", po::value<int>(&cudaDevice)->default_value(cudaDevice),
+      "CUDA device to benchmark.")
+    ("inlierThreshold", po::value<double>(&inlierThreshold)->default_value(inlierThreshold),
+      "Relative depth error of the inliers.")
+    ("minInlierRatio", po::value<double>(&minInlierRatio)->default_value(minInlierRatio),
+      "Fail if the ratio of inlier pixels of a run is lower (0 to disable), for regression testing.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  const auto parseIntegers = [](const std::string& str)
+  {
+    std::vector<std::string> tokens;
+    boost::split(tokens, str, boost::is_any_of(","), boost::token_compress_on);
+    std::vector<int> values;
+    for(const std::string& token : tokens)
+    {
+      if(!token.empty())
+        values.push_back(std::stoi(token));
+    }
+    return values;
+  };
+
+  const std::vector<int> downscales = parseIntegers(downscalesString);
+  const std::vector<int> nbDepthsList = parseIntegers(nbDepthsString);
+
+  if(nbViews < 2 || downscales.empty() || nbDepthsList.empty() ||
+     std::any_of(downscales.begin(), downscales.end(), [](int d) { return d < 1; }))
+  {
+    ALICEVISION_LOG_ERROR("Invalid number of views, downscales or numbers of depths.");
+    return EXIT_FAILURE;
+  }
+
+  if(depthMap::listCUDADevices(false) <= cudaDevice)
+  {
+    ALICEVISION_LOG_ERROR("No CUDA device " << cudaDevice << ".");
+    return EXIT_FAILURE;
+  }
+
+  const syntheticDataset::SyntheticScene scene;
+  sfmData::SfMData sfmData;
+  const std::string imagesFolder = (fs::path(outputFolder) / "images").string();
+  fs::create_directories(imagesFolder);
+  syntheticDataset::createSyntheticDataset(scene, nbViews, arcAngle, width, height, imagesFolder, sfmData);
+
+  bpt::ptree benchmarkTree;
+  benchmarkTree.put("nbViews", nbViews);
+  benchmarkTree.put("width", width);
+  benchmarkTree.put("height", height);
+  benchmarkTree.put("landmarks", sfmData.getLandmarks().size());
+  benchmarkTree.put("inlierThreshold", inlierThreshold);
+
+  bpt::ptree runsTree;
+  bool regression = false;
+
+  for(const int downscale : downscales)
+  {
+    for(const int nbDepths : nbDepthsList)
+    {
+      // the depth maps of a previous run would be reused as up to date
+      const std::string runFolder = (fs::path(outputFolder) / ("downscale" + std::to_string(downscale) + "_depths" + std::to_string(nbDepths))).string();
+      fs::remove_all(runFolder);
+      fs::create_directories(runFolder);
+
+      mvsUtils::MultiViewParams mp(sfmData, "", runFolder, "", false, downscale);
+      mp.userParams.put("semiGlobalMatching.maxDepthsToStore", nbDepths);
+      mp.userParams.put("semiGlobalMatching.maxDepthsToSweep", nbDepths);
+      mp.userParams.put("depthMap.deviceProfile", true);
+
+      std::vector<int> cams(mp.ncams);
+      for(int rc = 0; rc < mp.ncams; ++rc)
+        cams[rc] = rc;
+
+      const bool hasPeakMemory = system::resetProcessPeakMemory();
+      const std::clock_t cpuStart = std::clock();
+      system::Timer timer;
+
+      depthMap::estimateAndRefineDepthMaps(cudaDevice, &mp, cams);
+
+      const double time = timer.elapsed();
+      const double cpuTime = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+      bpt::ptree runTree;
+      runTree.put("downscale", downscale);
+      runTree.put("nbDepths", nbDepths);
+      runTree.put("width", mp.getWidth(0));
+      runTree.put("height", mp.getHeight(0));
+      runTree.put("time", time);
+      runTree.put("cpuTime", cpuTime);
+      if(hasPeakMemory)
+        runTree.put("peakMemory", system::getProcessPeakMemory());
+      runTree.add_child("device", getDeviceStatistics(mp));
+
+      const bpt::ptree accuracyTree = getAccuracy(mp, scene, inlierThreshold);
+      runTree.add_child("accuracy", accuracyTree);
+
+      const double inlierRatio = accuracyTree.get<double>("inlierRatio");
+      ALICEVISION_LOG_INFO("Downscale " << downscale << ", " << nbDepths << " depths: " << time << " s, "
+                           << "inlier ratio " << inlierRatio << ".");
+
+      if(inlierRatio < minInlierRatio)
+      {
+        ALICEVISION_LOG_ERROR("Inlier ratio " << inlierRatio << " lower than " << minInlierRatio << ".");
+        regression = true;
+      }
+
+      runsTree.push_back(std::make_pair("", runTree));
+    }
+  }
+
+  benchmarkTree.add_child("runs", runsTree);
+
+  try
+  {
+    bpt::write_json(outputFilename, benchmarkTree);
+  }
+  catch(const bpt::json_parser_error& e)
+  {
+    ALICEVISION_LOG_ERROR("Cannot write the benchmark file: " << outputFilename << ", " << e.what());
+    return EXIT_FAILURE;
+  }
+
+  return regression ? EXIT_FAILURE : EXIT_SUCCESS;
+}
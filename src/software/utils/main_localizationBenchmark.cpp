@@ -0,0 +1,370 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/localization/VoctreeLocalizer.hpp>
+#include <aliceVision/localization/LocalizationResult.hpp>
+#include <aliceVision/dataio/FeedProvider.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/robustEstimation/estimators.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace bpt = boost::property_tree;
+
+/**
+ * @brief Get the latency distribution of a stage of the localization.
+ * @param[in] latencies The latency of each frame in milliseconds
+ * @return the mean, maximum and the 50th, 95th and 99th percentiles (nearest rank)
+ */
+bpt::ptree getLatencyStatistics(std::vector<double> latencies)
+{
+  bpt::ptree statsTree;
+  if(latencies.empty())
+    return statsTree;
+
+  std::sort(latencies.begin(), latencies.end());
+
+  const auto percentile = [&](double p)
+  {
+    const std::size_t rank = static_cast<std::size_t>(std::ceil(p / 100.0 * latencies.size()));
+    return latencies.at(std::max<std::size_t>(rank, 1) - 1);
+  };
+
+  statsTree.put("mean", std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size());
+  statsTree.put("p50", percentile(50.0));
+  statsTree.put("p95", percentile(95.0));
+  statsTree.put("p99", percentile(99.0));
+  statsTree.put("max", latencies.back());
+  return statsTree;
+}
+
+int main(int argc, char** argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string sfmDataFilename;
+  std::string mediaFilepath;
+  std::string outputFilename;
+  std::string calibFile;
+  std::string descriptorsFolder;
+  std::string localizationDatabaseFolder;
+  std::string vocTreeFilepath;
+  std::string weightsFilepath;
+  std::string matchDescTypeNames = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  feature::EImageDescriberPreset featurePreset = feature::EImageDescriberPreset::NORMAL;
+  robustEstimation::ERobustEstimator resectionEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  robustEstimation::ERobustEstimator matchingEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  double resectionErrorMax = 4.0;
+  double matchingErrorMax = 4.0;
+  std::string algostring = "AllResults";
+  std::size_t numResults = 4;
+  std::size_t maxResults = 10;
+  std::size_t nbFrameBufferMatching = 10;
+  bool robustMatching = true;
+  bool useTracking = false;
+  std::string threadCountsString = std::to_string(omp_get_max_threads());
+  std::size_t maxFrames = 0;
+
+  po::options_description allParams(
+    "Replay an image sequence against a reconstruction and measure the localization: "
+    "the latency distribution of each stage, the frames per second and the peak memory "
+    "for each number of threads.\n"
+    "AliceVision localizationBenchmark");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("sfmdata", po::value<std::string>(&sfmDataFilename)->required(),
+      "The sfm_data.json kind of file generated by AliceVision.")
+    ("mediafile", po::value<std::string>(&mediaFilepath)->required(),
+      "The folder path or the filename for the media to localize.")
+    ("output,o", po::value<std::string>(&outputFilename)->required(),
+      "Output benchmark JSON file.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("calibration", po::value<std::string>(&calibFile),
+      "Calibration file.")
+    ("descriptorPath", po::value<std::string>(&descriptorsFolder),
+      "Folder containing the descriptors for all the images (ie the *.desc.)")
+    ("localizationDatabase", po::value<std::string>(&localizationDatabaseFolder),
+      "Folder of a localization database built with aliceVision_localizationDatabase.")
+    ("voctree", po::value<std::string>(&vocTreeFilepath),
+      "Filename for the vocabulary tree.")
+    ("voctreeWeights", po::value<std::string>(&weightsFilepath),
+      "Filename for the vocabulary tree weights.")
+    ("matchDescTypes", po::value<std::string>(&matchDescTypeNames)->default_value(matchDescTypeNames),
+      "The describer types to use for the matching.")
+    ("preset", po::value<feature::EImageDescriberPreset>(&featurePreset)->default_value(featurePreset),
+      "Preset for the feature extractor {LOW,MEDIUM,NORMAL,HIGH,ULTRA}.")
+    ("resectionEstimator", po::value<robustEstimation::ERobustEstimator>(&resectionEstimator)->default_value(resectionEstimator),
+      "The type of *sac framework to use for resection.")
+    ("matchingEstimator", po::value<robustEstimation::ERobustEstimator>(&matchingEstimator)->default_value(matchingEstimator),
+      "The type of *sac framework to use for matching.")
+    ("reprojectionError", po::value<double>(&resectionErrorMax)->default_value(resectionErrorMax),
+      "Maximum reprojection error (in pixels) allowed for resectioning.")
+    ("matchingError", po::value<double>(&matchingErrorMax)->default_value(matchingErrorMax),
+      "Maximum matching error (in pixels) allowed for image matching with geometric verification.")
+    ("algorithm", po::value<std::string>(&algostring)->default_value(algostring),
+      "Algorithm type: FirstBest, AllResults.")
+    ("nbImageMatch", po::value<std::size_t>(&numResults)->default_value(numResults),
+      "Number of images to retrieve in database.")
+    ("maxResults", po::value<std::size_t>(&maxResults)->default_value(maxResults),
+      "For algorithm AllResults, it stops the image matching when this number of matched images is reached. If 0 it is ignored.")
+    ("nbFrameBufferMatching", po::value<std::size_t>(&nbFrameBufferMatching)->default_value(nbFrameBufferMatching),
+      "Number of previous frame of the sequence to use for matching (0 = Disable).")
+    ("robustMatching", po::value<bool>(&robustMatching)->default_value(robustMatching),
+      "Enable/Disable the robust matching between query and database images.")
+    ("useTracking", po::value<bool>(&useTracking)->default_value(useTracking),
+      "Localize the frames by tracking the landmarks of the previous frame (AllResults only).")
+    ("threads", po::value<std::string>(&threadCountsString)->default_value(threadCountsString),
+      "Comma separated numbers of threads, the sequence is replayed for each of them.")
+    ("maxFrames", po::value<std::size_t>(&maxFrames)->default_value(maxFrames),
+      "Maximum number of frames of the sequence to localize (0 = All).");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  const double defaultLoRansacMatchingError = 4.0;
+  const double defaultLoRansacResectionError = 4.0;
+  if(!robustEstimation::adjustRobustEstimatorThreshold(matchingEstimator, matchingErrorMax, defaultLoRansacMatchingError) ||
+     !robustEstimation::adjustRobustEstimatorThreshold(resectionEstimator, resectionErrorMax, defaultLoRansacResectionError))
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<int> threadCounts;
+  {
+    std::vector<std::string> threadCountsStrings;
+    boost::split(threadCountsStrings, threadCountsString, boost::is_any_of(","));
+    for(const std::string& threadCount : threadCountsStrings)
+    {
+      try
+      {
+        threadCounts.push_back(std::stoi(threadCount));
+      }
+      catch(const std::exception&)
+      {
+        threadCounts.push_back(0);
+      }
+
+      if(threadCounts.back() <= 0)
+      {
+        ALICEVISION_LOG_ERROR("Invalid number of threads: '" << threadCount << "'.");
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  const std::vector<feature::EImageDescriberType> matchDescTypes = feature::EImageDescriberType_stringToEnums(matchDescTypeNames);
+
+  // load SfMData
+  sfmData::SfMData sfmData;
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmDataFilename + "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  localization::VoctreeLocalizer::Parameters param;
+  param._algorithm = localization::VoctreeLocalizer::initFromString(algostring);
+  param._numResults = numResults;
+  param._maxResults = maxResults;
+  param._ccTagUseCuda = false;
+  param._matchingError = matchingErrorMax;
+  param._nbFrameBufferMatching = nbFrameBufferMatching;
+  param._useRobustMatching = robustMatching;
+  param._useTracking = useTracking;
+  param._featurePreset = featurePreset;
+  param._errorMax = resectionErrorMax;
+  param._resectionEstimator = resectionEstimator;
+  param._matchingEstimator = matchingEstimator;
+
+  bpt::ptree benchmarkTree;
+  benchmarkTree.put("sfmdata", sfmDataFilename);
+  benchmarkTree.put("mediafile", mediaFilepath);
+  benchmarkTree.put("algorithm", algostring);
+  benchmarkTree.put("nbImageMatch", numResults);
+  benchmarkTree.put("matchDescTypes", matchDescTypeNames);
+
+  bpt::ptree runsTree;
+
+  for(const int nbThreads : threadCounts)
+  {
+    ALICEVISION_LOG_INFO("Localization benchmark with " << nbThreads << " threads.");
+    omp_set_num_threads(nbThreads);
+
+    // a new localizer for each run, the frame buffer of the previous run is not reused
+    system::Timer initTimer;
+    localization::VoctreeLocalizer localizer(sfmData,
+                                             descriptorsFolder,
+                                             vocTreeFilepath,
+                                             weightsFilepath,
+                                             matchDescTypes,
+                                             localizationDatabaseFolder);
+    if(!localizer.isInit())
+    {
+      ALICEVISION_LOG_ERROR("Cannot initialize the localizer.");
+      return EXIT_FAILURE;
+    }
+    const double initTime = initTimer.elapsed();
+
+    dataio::FeedProvider feed(mediaFilepath, calibFile);
+    if(!feed.isInit())
+    {
+      ALICEVISION_LOG_ERROR("Cannot initialize the feed provider.");
+      return EXIT_FAILURE;
+    }
+
+    // the peak memory of the localization only, the memory of the previous runs is released
+    const bool hasPeakMemory = system::resetProcessPeakMemory();
+
+    // latency of each frame per stage, in milliseconds
+    std::map<std::string, std::vector<double>> stagesLatencies;
+    std::size_t nbFrames = 0;
+    std::size_t nbLocalized = 0;
+
+    image::Image<float> imageGrey;
+    camera::PinholeRadialK3 queryIntrinsics;
+    bool hasIntrinsics = false;
+    std::string imagePath;
+
+    system::Timer runTimer;
+    system::Timer stageTimer;
+
+    while((maxFrames == 0 || nbFrames < maxFrames) &&
+          feed.readImage(imageGrey, queryIntrinsics, imagePath, hasIntrinsics))
+    {
+      stagesLatencies["read"].push_back(stageTimer.elapsedMs());
+
+      stageTimer.reset();
+      feature::MapRegionsPerDesc queryRegions;
+      localizer.extractRegions(imageGrey, &param, queryRegions, imagePath);
+      const double extractionTime = stageTimer.elapsedMs();
+
+      stageTimer.reset();
+      localization::LocalizationResult localizationResult;
+      if(localizer.localize(queryRegions,
+                            std::make_pair(imageGrey.Width(), imageGrey.Height()),
+                            &param,
+                            hasIntrinsics,
+                            queryIntrinsics,
+                            localizationResult,
+                            imagePath))
+        ++nbLocalized;
+      const double localizationTime = stageTimer.elapsedMs();
+
+      stagesLatencies["extraction"].push_back(extractionTime);
+      stagesLatencies["localization"].push_back(localizationTime);
+      stagesLatencies["total"].push_back(extractionTime + localizationTime);
+      ++nbFrames;
+
+      ALICEVISION_LOG_DEBUG("Frame " << nbFrames << ": " << extractionTime + localizationTime << " ms.");
+
+      stageTimer.reset();
+      feed.goToNextFrame();
+    }
+
+    const double runTime = runTimer.elapsed();
+
+    bpt::ptree runTree;
+    runTree.put("threads", nbThreads);
+    runTree.put("frames", nbFrames);
+    runTree.put("localized", nbLocalized);
+    runTree.put("initializationTime", initTime);
+    runTree.put("time", runTime);
+    runTree.put("fps", runTime > 0.0 ? nbFrames / runTime : 0.0);
+    if(hasPeakMemory)
+      runTree.put("peakMemory", system::getProcessPeakMemory());
+
+    bpt::ptree stagesTree;
+    for(const auto& stageLatencies : stagesLatencies)
+      stagesTree.add_child(stageLatencies.first, getLatencyStatistics(stageLatencies.second));
+    runTree.add_child("latency", stagesTree);
+
+    runsTree.push_back(std::make_pair("", runTree));
+
+    ALICEVISION_LOG_INFO("Localized " << nbLocalized << "/" << nbFrames << " frames with " << nbThreads << " threads: "
+                         << runTree.get<double>("fps") << " fps.");
+  }
+
+  benchmarkTree.add_child("runs", runsTree);
+
+  try
+  {
+    bpt::write_json(outputFilename, benchmarkTree);
+  }
+  catch(const bpt::ptree_error& e)
+  {
+    ALICEVISION_LOG_ERROR("Cannot save the benchmark file '" << outputFilename << "': " << e.what());
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_LOG_INFO("Localization benchmark saved in '" << outputFilename << "'.");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/matchingImageCollection/matchingStats.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+using namespace aliceVision::matchingImageCollection;
+
+namespace po = boost::program_options;
+
+/// Report the slowest pairs and views of one or several featureMatching runs (--exportMatchingStats)
+/// and fit a cost model usable to balance the next runs.
+int main(int argc, char **argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::vector<std::string> statsFilenames;
+  std::string outputViewCostsFilename;
+  int nbTop = 20;
+
+  po::options_description allParams(
+    "Report the slowest pairs and views of feature matching runs and fit a matching cost model.\n"
+    "AliceVision matchingStatistics");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::vector<std::string>>(&statsFilenames)->multitoken()->required(),
+      "Matching statistics file(s) exported by featureMatching (e.g. all the chunks of a distributed matching).");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("outputViewCosts,o", po::value<std::string>(&outputViewCostsFilename)->default_value(outputViewCostsFilename),
+      "Output view costs file, to use with featureMatching --balancedRanges --viewCostsFile.")
+    ("top", po::value<int>(&nbTop)->default_value(nbTop),
+      "Number of pairs and views to report.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  MatchingStats stats;
+  for(const std::string& filename : statsFilenames)
+  {
+    if(!loadMatchingStats(filename, stats))
+    {
+      ALICEVISION_LOG_ERROR("Invalid matching statistics file: " << filename);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if(stats.pairs.empty())
+  {
+    ALICEVISION_LOG_ERROR("No pair in the matching statistics.");
+    return EXIT_FAILURE;
+  }
+
+  const std::size_t nbReported = static_cast<std::size_t>(std::max(nbTop, 0));
+
+  // steps
+  ALICEVISION_LOG_INFO("Steps (summed over the runs):");
+  for(const auto& step : stats.steps)
+    ALICEVISION_LOG_INFO("\t- " << step.first << ": " << system::prettyTime(step.second));
+
+  // pairs
+  double putativeMs = 0.0;
+  double geometricMs = 0.0;
+  std::vector<std::pair<double, Pair>> pairCosts;
+  pairCosts.reserve(stats.pairs.size());
+  for(const auto& pairStats : stats.pairs)
+  {
+    putativeMs += pairStats.second.putativeMatchingMs;
+    geometricMs += pairStats.second.geometricFilteringMs;
+    pairCosts.emplace_back(pairStats.second.totalMs(), pairStats.first);
+  }
+  std::sort(pairCosts.rbegin(), pairCosts.rend());
+
+  ALICEVISION_LOG_INFO(stats.pairs.size() << " pairs: putative matching " << system::prettyTime(putativeMs)
+                       << ", geometric filtering " << system::prettyTime(geometricMs) << ".");
+
+  ALICEVISION_LOG_INFO("Slowest pairs (I, J): total, putative, geometric (ms) | features I, J | putatives | inliers | iterations");
+  for(std::size_t i = 0; i < std::min(nbReported, pairCosts.size()); ++i)
+  {
+    const Pair& pair = pairCosts[i].second;
+    const PairMatchingStats& s = stats.pairs.at(pair);
+    ALICEVISION_LOG_INFO("\t- (" << pair.first << ", " << pair.second << "): "
+                         << s.totalMs() << ", " << s.putativeMatchingMs << ", " << s.geometricFilteringMs
+                         << " | " << s.nbFeaturesI << ", " << s.nbFeaturesJ
+                         << " | " << s.nbPutativeMatches << " | " << s.nbInliers << " | " << s.nbRansacIterations);
+  }
+
+  // views: the duration of its pairs, its loading and its indexing
+  std::map<IndexT, double> viewMs;
+  for(const auto& pairStats : stats.pairs)
+  {
+    viewMs[pairStats.first.first] += pairStats.second.totalMs();
+    viewMs[pairStats.first.second] += pairStats.second.totalMs();
+  }
+  for(const auto& viewStats : stats.views)
+    viewMs[viewStats.first] += viewStats.second.loadingMs + viewStats.second.indexingMs;
+
+  std::vector<std::pair<double, IndexT>> viewCosts;
+  viewCosts.reserve(viewMs.size());
+  for(const auto& v : viewMs)
+    viewCosts.emplace_back(v.second, v.first);
+  std::sort(viewCosts.rbegin(), viewCosts.rend());
+
+  ALICEVISION_LOG_INFO("Slowest views: pairs + loading + indexing (ms) | loading | indexing");
+  for(std::size_t i = 0; i < std::min(nbReported, viewCosts.size()); ++i)
+  {
+    const IndexT viewId = viewCosts[i].second;
+    const auto it = stats.views.find(viewId);
+    const ViewMatchingStats s = (it == stats.views.end()) ? ViewMatchingStats() : it->second;
+    ALICEVISION_LOG_INFO("\t- " << viewId << ": " << viewCosts[i].first << " | " << s.loadingMs << " | " << s.indexingMs);
+  }
+
+  // cost model
+  const PairCostModel model = fitPairCostModel(stats);
+  ALICEVISION_LOG_INFO("Pair cost model (ms) = " << model.constantMs
+                       << " + " << model.featuresProductMs << " * nbFeaturesI * nbFeaturesJ / 1e6"
+                       << " + " << model.putativeMatchesMs << " * nbPutativeMatches / 1e3"
+                       << " (R2 = " << model.r2 << ")");
+
+  if(!outputViewCostsFilename.empty())
+  {
+    ALICEVISION_LOG_INFO("Save view costs: " << outputViewCostsFilename);
+    saveViewCosts(outputViewCostsFilename, getMeasuredViewCosts(stats));
+  }
+
+  return EXIT_SUCCESS;
+}
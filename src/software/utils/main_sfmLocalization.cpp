@@ -23,7 +23,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 
@@ -49,6 +49,7 @@ int main(int argc, char **argv)
 
   std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
   double maxResidualError = std::numeric_limits<double>::infinity();
+  std::string databaseCacheFolder;
 
   po::options_description allParams(
     "Image localization in an existing SfM reconstruction\n"
@@ -70,7 +71,10 @@ int main(int argc, char **argv)
     ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
       feature::EImageDescriberType_informations().c_str())
     ("maxResidualError", po::value<double>(&maxResidualError)->default_value(maxResidualError),
-      "Upper bound of the residual error tolerance.");
+      "Upper bound of the residual error tolerance.")
+    ("databaseCacheFolder", po::value<std::string>(&databaseCacheFolder),
+      "Folder where the landmarks descriptors database and its matcher index are saved, "
+      "they are loaded from it by the next localizations of the same scene.");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -163,7 +167,7 @@ int main(int argc, char **argv)
     if (!fs::exists(outputFolder))
       fs::create_directory(outputFolder);
     
-    if(!localizer.Init(sfmData, regionsPerView))
+    if(!localizer.Init(sfmData, regionsPerView, describerType, databaseCacheFolder))
     {
       ALICEVISION_LOG_ERROR("Cannot initialize the SfM localizer");
     }
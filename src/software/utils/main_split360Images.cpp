@@ -10,6 +10,8 @@
 #include <aliceVision/image/Sampler.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <dependencies/vectorGraphics/svgDrawer.hpp>
 
@@ -24,6 +26,8 @@
 #include <iostream>
 #include <iterator>
 #include <fstream>
+#include <map>
+#include <memory>
 #include <vector>
 
 // These constants define the current software version.
@@ -169,71 +173,143 @@ bool splitDualFisheye(const std::string& imagePath, const std::string& outputFol
   return true;
 }
 
-bool splitEquirectangular(const std::string& imagePath, const std::string& outputFolder, std::size_t nbSplits, std::size_t splitResolution)
+/**
+ * @brief Backward mapping of the splits of an equirectangular image:
+ *        for each pixel of the pinhole images, where it comes from the panoramic image
+ * Computed once for all the equirectangular images of the same size.
+ */
+class EquirectangularSplitRemap
 {
-  image::Image<image::RGBColor> imageSource;
-  image::readImage(imagePath, imageSource, image::EImageColorSpace::LINEAR);
+public:
 
-  const int inWidth = imageSource.Width();
-  const int inHeight = imageSource.Height();
+  EquirectangularSplitRemap(int inWidth, int inHeight, std::size_t nbSplits, std::size_t splitResolution)
+    : _splitResolution(splitResolution)
+  {
+    const double twoPi = M_PI * 2.0;
+    const double alpha = twoPi / static_cast<double>(nbSplits);
+    _focal = focalFromPinholeHeight(inHeight, degreeToRadian(60.0));
 
-  std::vector<PinholeCameraR> cameras;
+    _positions.resize(nbSplits, std::vector<Vec2f>(splitResolution * splitResolution));
 
-  const double twoPi = M_PI * 2.0;
-  const double alpha = twoPi / static_cast<double>(nbSplits);
-  const double focal = focalFromPinholeHeight(inHeight, degreeToRadian(60.0));
+    double angle = 0.0;
+    for(std::size_t s = 0; s < nbSplits; ++s)
+    {
+      const PinholeCameraR camera(_focal, splitResolution, splitResolution, RotationAroundY(angle));
+      std::vector<Vec2f>& positions = _positions.at(s);
+      const int resolution = splitResolution;
 
-  double angle = 0.0;
-  for(std::size_t i = 0; i < nbSplits; ++i)
-  {
-    cameras.emplace_back(focal, splitResolution, splitResolution, RotationAroundY(angle));
-    angle += alpha;
+      #pragma omp parallel for
+      for(int j = 0; j < resolution; ++j)
+      {
+        for(int i = 0; i < resolution; ++i)
+        {
+          const Vec3 ray = camera.getRay(i, j);
+          const Vec2 x = SphericalMapping::get2DPoint(ray, inWidth, inHeight);
+          positions[j * resolution + i] = x.cast<float>();
+        }
+      }
+      angle += alpha;
+    }
   }
 
-  const image::Sampler2d<image::SamplerLinear> sampler;
-  image::Image<image::RGBColor> imaOut(splitResolution, splitResolution, image::BLACK);
+  double getFocal() const { return _focal; }
+  std::size_t getNbSplits() const { return _positions.size(); }
+  std::size_t getSplitResolution() const { return _splitResolution; }
+
+  /**
+   * @brief Get the positions in the panoramic image of the pixels of a split
+   * @param[in] split The split index
+   * @return The positions (x, y), row by row
+   */
+  const std::vector<Vec2f>& getPositions(std::size_t split) const { return _positions.at(split); }
 
-  size_t index = 0;
-  for(const PinholeCameraR& camera : cameras)
+private:
+  double _focal;
+  std::size_t _splitResolution;
+  std::vector<std::vector<Vec2f>> _positions;
+};
+
+/**
+ * @brief Get the remap of the equirectangular images of a given size, computed at the first request
+ * @note thread safe
+ */
+std::shared_ptr<const EquirectangularSplitRemap> getEquirectangularSplitRemap(int inWidth, int inHeight, std::size_t nbSplits, std::size_t splitResolution)
+{
+  static std::map<std::pair<int, int>, std::shared_ptr<const EquirectangularSplitRemap>> remaps;
+  std::shared_ptr<const EquirectangularSplitRemap> remap;
+
+  #pragma omp critical(split360ImagesRemaps)
   {
-    imaOut.fill(image::BLACK);
+    std::shared_ptr<const EquirectangularSplitRemap>& cachedRemap = remaps[std::make_pair(inWidth, inHeight)];
+    if(!cachedRemap)
+      cachedRemap = std::make_shared<const EquirectangularSplitRemap>(inWidth, inHeight, nbSplits, splitResolution);
+    remap = cachedRemap;
+  }
+  return remap;
+}
 
-    // Backward mapping:
-    // - Find for each pixels of the pinhole image where it comes from the panoramic image
-    for(int j = 0; j < splitResolution; ++j)
-    {
-      for(int i = 0; i < splitResolution; ++i)
-      {
-        const Vec3 ray = camera.getRay(i, j);
-        const Vec2 x = SphericalMapping::get2DPoint(ray, inWidth, inHeight);
-        imaOut(j,i) = sampler(imageSource, x(1), x(0));
-      }
-    }
+bool splitEquirectangular(const std::string& imagePath, const std::string& outputFolder, std::size_t nbSplits, std::size_t splitResolution)
+{
+  image::Image<image::RGBColor> imageSource;
+  image::readImage(imagePath, imageSource, image::EImageColorSpace::LINEAR);
 
-    // save image
+  const std::shared_ptr<const EquirectangularSplitRemap> remap = getEquirectangularSplitRemap(imageSource.Width(), imageSource.Height(), nbSplits, splitResolution);
+  const int nbPixels = splitResolution * splitResolution;
 
-    oiio::ImageBuf bufferOut;
-    image::getBufferFromImage(imageSource, bufferOut);
+  // output metadata
+  // override make and model in order to force camera model in SfM
+  oiio::ImageSpec outMetadataSpec;
+  outMetadataSpec.extra_attribs = image::readImageMetadata(imagePath);
+  outMetadataSpec.attribute("Make",  "Custom");
+  outMetadataSpec.attribute("Model", "Pinhole");
+  outMetadataSpec.attribute("Exif:FocalLength", static_cast<float>(remap->getFocal()));
 
-    oiio::ImageSpec& outMetadataSpec = bufferOut.specmod();
+  const image::Sampler2d<image::SamplerLinear> sampler;
+  image::Image<image::RGBColor> imaOut(splitResolution, splitResolution, image::BLACK);
 
-    outMetadataSpec.extra_attribs = image::readImageMetadata(imagePath);
+  for(std::size_t index = 0; index < nbSplits; ++index)
+  {
+    const std::vector<Vec2f>& positions = remap->getPositions(index);
+    image::RGBColor* outPixels = imaOut.data();
 
-    // Ooerride make and model in order to force camera model in SfM
-    outMetadataSpec.attribute("Make",  "Custom");
-    outMetadataSpec.attribute("Model", "Pinhole");
-    outMetadataSpec.attribute("Exif:FocalLength", static_cast<float>(focal));
+    // backward mapping with the precomputed positions
+    // (the rows are split between threads if the images are not processed in parallel)
+    #pragma omp parallel for
+    for(int p = 0; p < nbPixels; ++p)
+      outPixels[p] = sampler(imageSource, positions[p](1), positions[p](0));
 
+    // save image
     boost::filesystem::path path(imagePath);
     image::writeImage(outputFolder + std::string("/") + path.stem().string() + std::string("_") + std::to_string(index) + path.extension().string(),
                       imaOut, image::EImageColorSpace::AUTO, outMetadataSpec.extra_attribs);
-
-    ++index;
   }
   ALICEVISION_LOG_INFO(imagePath + " successfully split");
   return true;
 }
 
+/**
+ * @brief Get the number of images split at the same time
+ * @param[in] imageMemory The memory used to split the biggest image (in bytes)
+ * @param[in] nbImages The number of images
+ * @return The number of threads
+ */
+int computeNbThreads(std::size_t imageMemory, std::size_t nbImages)
+{
+  const std::size_t availableRam = system::getMemoryInfo().availableRam;
+
+  if(availableRam == 0)
+  {
+    ALICEVISION_LOG_WARNING("Cannot find available system memory, this can be due to OS limitations.\n"
+                            "Split the images one by one.");
+    return 1;
+  }
+
+  std::size_t nbThreads = (imageMemory == 0) ? 1 : std::max(std::size_t(1), static_cast<std::size_t>(0.9 * availableRam) / imageMemory);
+  nbThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), nbThreads);
+  nbThreads = std::max(std::size_t(1), std::min(nbImages, nbThreads));
+
+  return static_cast<int>(nbThreads);
+}
 
 bool splitEquirectangularDemo(const std::string& imagePath, const std::string& outputFolder, std::size_t nbSplits, std::size_t splitResolution)
 {
@@ -440,34 +516,72 @@ int main(int argc, char** argv)
     }
   }
 
+  // memory used to split the biggest image: the input image, its float copy for the dual-fisheye, the output images
+  std::size_t imageMemory = 0;
   for(const std::string& imagePath : imagePaths)
   {
-    bool hasCorrectPath = true;
-
-    if(splitMode == "equirectangular")
+    int width = 0;
+    int height = 0;
+    try
     {
-      if(equirectangularDemoMode)
-        hasCorrectPath = splitEquirectangularDemo(imagePath, outputFolder, equirectangularNbSplits, equirectangularSplitResolution);
-      else
-        hasCorrectPath = splitEquirectangular(imagePath, outputFolder, equirectangularNbSplits, equirectangularSplitResolution);
+      image::readImageMetadata(imagePath, width, height);
     }
-    else if(splitMode == "dualfisheye")
+    catch(std::exception&)
     {
-      hasCorrectPath = splitDualFisheye(imagePath, outputFolder, dualFisheyeSplitPreset);
+      continue; // reported below
     }
-    else //exif
+
+    const std::size_t nbPixels = static_cast<std::size_t>(width) * height;
+    const std::size_t splitsMemory = (splitMode == "equirectangular") ? equirectangularSplitResolution * equirectangularSplitResolution * sizeof(image::RGBColor) : nbPixels * sizeof(image::RGBfColor) / 2;
+    imageMemory = std::max(imageMemory, nbPixels * (splitMode == "dualfisheye" ? sizeof(image::RGBfColor) : sizeof(image::RGBColor)) + splitsMemory);
+  }
+
+  const int nbImages = static_cast<int>(imagePaths.size());
+  const int nbThreads = computeNbThreads(imageMemory, imagePaths.size());
+
+  ALICEVISION_LOG_INFO("Split " << nbImages << " image(s) with " << nbThreads << " thread(s).");
+
+  #pragma omp parallel for num_threads(nbThreads) schedule(dynamic)
+  for(int i = 0; i < nbImages; ++i)
+  {
+    const std::string& imagePath = imagePaths.at(i);
+    bool hasCorrectPath = true;
+
+    try
     {
-      ALICEVISION_LOG_ERROR("Exif mode not implemented yet !");
+      if(splitMode == "equirectangular")
+      {
+        if(equirectangularDemoMode)
+          hasCorrectPath = splitEquirectangularDemo(imagePath, outputFolder, equirectangularNbSplits, equirectangularSplitResolution);
+        else
+          hasCorrectPath = splitEquirectangular(imagePath, outputFolder, equirectangularNbSplits, equirectangularSplitResolution);
+      }
+      else if(splitMode == "dualfisheye")
+      {
+        hasCorrectPath = splitDualFisheye(imagePath, outputFolder, dualFisheyeSplitPreset);
+      }
+      else //exif
+      {
+        ALICEVISION_LOG_ERROR("Exif mode not implemented yet !");
+      }
+    }
+    catch(std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR(e.what());
+      hasCorrectPath = false;
     }
 
     if(!hasCorrectPath)
+    {
+      #pragma omp critical(split360ImagesBadPaths)
       badPaths.push_back(imagePath);
+    }
   }
 
   if(!badPaths.empty())
   {
     ALICEVISION_LOG_ERROR("Error: Can't open image file(s) below");
-    for(const std::string& imagePath : imagePaths)
+    for(const std::string& imagePath : badPaths)
        ALICEVISION_LOG_ERROR("\t - " << imagePath);
   }
 
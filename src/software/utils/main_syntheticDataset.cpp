@@ -0,0 +1,123 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include "syntheticDataset/SyntheticDataset.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <cstdlib>
+#include <string>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+int main(int argc, char** argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string outputFolder;
+  std::string outputSfMFilename;
+  int nbViews = 24;
+  double arcAngle = 90.0;
+  int width = 1600;
+  int height = 1200;
+
+  po::options_description allParams(
+    "Render the images of a synthetic textured scene with known poses, "
+    "the input of the pipeline benchmarks (the focal length in pixels is the image width).\n"
+    "AliceVision syntheticDataset");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output folder for the synthetic images.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("outputSfMData", po::value<std::string>(&outputSfMFilename)->default_value(outputSfMFilename),
+      "Output SfMData file of the ground truth: views, poses, intrinsic and landmarks.")
+    ("nbViews", po::value<int>(&nbViews)->default_value(nbViews),
+      "Number of views of the synthetic scene.")
+    ("arcAngle", po::value<double>(&arcAngle)->default_value(arcAngle),
+      "Angle of the arc of the views around the scene (in degrees).")
+    ("width", po::value<int>(&width)->default_value(width),
+      "Width of the synthetic images.")
+    ("height", po::value<int>(&height)->default_value(height),
+      "Height of the synthetic images.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(nbViews < 2 || width < 1 || height < 1)
+  {
+    ALICEVISION_LOG_ERROR("Invalid number of views or image size.");
+    return EXIT_FAILURE;
+  }
+
+  fs::create_directories(outputFolder);
+
+  const syntheticDataset::SyntheticScene scene;
+  sfmData::SfMData sfmData;
+  syntheticDataset::createSyntheticDataset(scene, nbViews, arcAngle, width, height, outputFolder, sfmData);
+
+  if(!outputSfMFilename.empty() && !sfmDataIO::Save(sfmData, outputSfMFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("Unable to write the ground truth: " << outputSfMFilename);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_LOG_INFO("Synthetic images written in " << outputFolder);
+  return EXIT_SUCCESS;
+}
@@ -26,7 +26,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 static const int DIMENSION = 128;
 
@@ -53,6 +53,8 @@ int main(int argc, char** argv)
   std::uint32_t K = 10;
   std::uint32_t restart = 5;
   std::uint32_t LEVELS = 6;
+  std::size_t miniBatchSize = 0;
+  std::size_t maxDescriptors = 0;
   bool sanityCheck = true;
 
   po::options_description allParams("This program is used to load the sift descriptors from a SfMData file and create a vocabulary tree\n"
@@ -73,6 +75,8 @@ int main(int argc, char** argv)
     (",k", po::value<uint32_t>(&K)->default_value(10), "The branching factor of the tree")
     ("restart,r", po::value<uint32_t>(&restart)->default_value(5), "Number of times that the kmean is launched for each cluster, the best solution is kept")
     (",L", po::value<uint32_t>(&LEVELS)->default_value(6), "Number of levels of the tree")
+    ("miniBatchSize", po::value<std::size_t>(&miniBatchSize)->default_value(miniBatchSize), "Use the mini-batch kmean with batches of this number of descriptors on the larger clusters (0 to use the standard kmean)")
+    ("maxDescriptors", po::value<std::size_t>(&maxDescriptors)->default_value(maxDescriptors), "Read the descriptor files once per level of the tree and keep at most this number of descriptors in memory, sampled for each cluster (0 to load all the descriptors in memory)")
     ("sanitycheck,s", po::value<bool>(&sanityCheck)->default_value(sanityCheck), "Perform a sanity check at the end of the creation of the vocabulary tree. The sanity check is a query to the database with the same documents/images useed to train the vocabulary tree");
 
   po::options_description logParams("Log parameters");
@@ -122,30 +126,64 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
-  std::vector<DescriptorFloat> descriptors;
+  // Create tree
+  aliceVision::voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
+  builder.setVerbose(tbVerbosity);
+  builder.kmeans().setRestarts(restart);
+  builder.kmeans().setMiniBatchSize(miniBatchSize);
 
+  std::vector<DescriptorFloat> descriptors;
   std::vector<size_t> descRead;
-  ALICEVISION_COUT("Reading descriptors from " << sfmDataFilename);
+  std::map<IndexT, std::string> descriptorsFiles;
   auto detect_start = std::chrono::steady_clock::now();
-  size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
   auto detect_end = std::chrono::steady_clock::now();
   auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-  if(descriptors.size() == 0)
+
+  if(maxDescriptors == 0)
   {
-    ALICEVISION_CERR("No descriptors loaded!!");
-    return EXIT_FAILURE;
+    ALICEVISION_COUT("Reading descriptors from " << sfmDataFilename);
+    detect_start = std::chrono::steady_clock::now();
+    size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
+    detect_end = std::chrono::steady_clock::now();
+    detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+    if(descriptors.size() == 0)
+    {
+      ALICEVISION_CERR("No descriptors loaded!!");
+      return EXIT_FAILURE;
+    }
+
+    ALICEVISION_COUT("Done! " << descRead.size() << " sets of descriptors read for a total of " << numTotDescriptors << " features");
+    ALICEVISION_COUT("Reading took " << detect_elapsed.count() << " sec");
+  }
+  else
+  {
+    aliceVision::voctree::getListOfDescriptorFiles(sfmData, featuresFolders, descriptorsFiles);
+    if(descriptorsFiles.empty())
+    {
+      ALICEVISION_CERR("No descriptor file found!!");
+      return EXIT_FAILURE;
+    }
+    ALICEVISION_COUT(descriptorsFiles.size() << " descriptor files will be read for each level of the tree");
   }
 
-  ALICEVISION_COUT("Done! " << descRead.size() << " sets of descriptors read for a total of " << numTotDescriptors << " features");
-  ALICEVISION_COUT("Reading took " << detect_elapsed.count() << " sec");
+  // read the descriptor files one after the other
+  const aliceVision::voctree::TreeBuilder<DescriptorFloat>::FeatureSource streamDescriptors =
+    [&](const aliceVision::voctree::TreeBuilder<DescriptorFloat>::FeatureVisitor& visitor)
+  {
+    std::vector<DescriptorFloat> fileDescriptors;
+    for(const auto& descriptorsFile : descriptorsFiles)
+    {
+      aliceVision::feature::loadDescsFromBinFile<DescriptorFloat, DescriptorUChar>(descriptorsFile.second, fileDescriptors, false);
+      visitor(fileDescriptors);
+    }
+  };
 
-  // Create tree
-  aliceVision::voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
-  builder.setVerbose(tbVerbosity);
-  builder.kmeans().setRestarts(restart);
   ALICEVISION_COUT("Building a tree of L=" << LEVELS << " levels with a branching factor of k=" << K);
   detect_start = std::chrono::steady_clock::now();
-  builder.build(descriptors, K, LEVELS);
+  if(maxDescriptors == 0)
+    builder.build(descriptors, K, LEVELS);
+  else
+    builder.buildStreaming(streamDescriptors, K, LEVELS, maxDescriptors);
   detect_end = std::chrono::steady_clock::now();
   detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
   ALICEVISION_COUT("Tree created in " << ((float) detect_elapsed.count()) / 1000 << " sec");
@@ -183,6 +221,17 @@ int main(int argc, char** argv)
     // update the offset
     offset += descRead[i];
   }
+  // the descriptors are not in memory, read them once more
+  if(maxDescriptors != 0)
+  {
+    size_t i = 0;
+    streamDescriptors([&](const std::vector<DescriptorFloat>& fileDescriptors)
+    {
+      aliceVision::voctree::SparseHistogram histo;
+      aliceVision::voctree::computeSparseHistogram(builder.tree().quantize(fileDescriptors), histo);
+      allSparseHistograms[i++] = histo;
+    });
+  }
   detect_end = std::chrono::steady_clock::now();
   detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
   ALICEVISION_COUT("Feature quantization took " << detect_elapsed.count() << " sec");
@@ -236,7 +236,8 @@ int main(int argc, char** argv)
   // load vocabulary tree
 
   ALICEVISION_LOG_INFO("Loading vocabulary tree\n");
-  aliceVision::voctree::VocabularyTree<DescriptorFloat> tree(treeName);
+  aliceVision::voctree::VocabularyTree<DescriptorFloat> tree;
+  tree.loadMapped(treeName);
   ALICEVISION_LOG_INFO("tree loaded with\n\t"
           << tree.levels() << " levels\n\t" 
           << tree.splits() << " branching factor");
@@ -15,6 +15,7 @@
 #include <aliceVision/graph/graph.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 //load features per view
 #include <aliceVision/sfm/pipeline/regionsIO.hpp>
 // feature matches
@@ -196,10 +197,34 @@ bool ColorHarmonizationEngineGlobal::Process()
   map_relativeHistograms[1].resize(_pairwiseMatches.size());
   map_relativeHistograms[2].resize(_pairwiseMatches.size());
 
-  for (size_t i = 0; i < _pairwiseMatches.size(); ++i)
+  if(_selectionMethod != eHistogramHarmonizeFullFrame &&
+     _selectionMethod != eHistogramHarmonizeMatchedPoints &&
+     _selectionMethod != eHistogramHarmonizeVLDSegment)
   {
-    matching::PairwiseMatches::const_iterator iter = _pairwiseMatches.begin();
-    std::advance(iter, i);
+    std::cout << "Selection method unsupported" << std::endl;
+    return false;
+  }
+
+  // the pairs are processed in parallel, each one only keeps its two images in memory
+  std::vector<matching::PairwiseMatches::const_iterator> vec_pairs;
+  vec_pairs.reserve(_pairwiseMatches.size());
+  for(matching::PairwiseMatches::const_iterator iter = _pairwiseMatches.begin(); iter != _pairwiseMatches.end(); ++iter)
+    vec_pairs.push_back(iter);
+
+  bool success = true;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < static_cast<int>(vec_pairs.size()); ++i)
+  {
+    // skip the remaining pairs after an error
+    bool succeeded;
+    #pragma omp atomic read
+    succeeded = success;
+
+    if(!succeeded)
+      continue;
+
+    matching::PairwiseMatches::const_iterator iter = vec_pairs[i];
 
     const size_t viewI = iter->first.first;
     const size_t viewJ = iter->first.second;
@@ -210,113 +235,122 @@ bool ColorHarmonizationEngineGlobal::Process()
     //-- Edges names:
     std::pair< std::string, std::string > p_imaNames;
     p_imaNames = make_pair( _fileNames[ viewI ], _fileNames[ viewJ ] );
+
+    #pragma omp critical(colorHarmonizeLog)
     std::cout << "Current edge : "
       << fs::path(p_imaNames.first).filename().string() << "\t"
       << fs::path(p_imaNames.second).filename().string() << std::endl;
 
-    //-- Compute the masks from the data selection:
-    Image< unsigned char > maskI ( _imageSize[ viewI ].first, _imageSize[ viewI ].second );
-    Image< unsigned char > maskJ ( _imageSize[ viewJ ].first, _imageSize[ viewJ ].second );
-
-    switch(_selectionMethod)
+    try
     {
-      case eHistogramHarmonizeFullFrame:
-      {
-        colorHarmonization::CommonDataByPair_fullFrame  dataSelector(
-          p_imaNames.first,
-          p_imaNames.second);
-        dataSelector.computeMask( maskI, maskJ );
-      }
-      break;
-      case eHistogramHarmonizeMatchedPoints:
-      {
-        int circleSize = 10;
-        colorHarmonization::CommonDataByPair_matchedPoints dataSelector(
-          p_imaNames.first,
-          p_imaNames.second,
-          matchesPerDesc,
-          _regionsPerView.getRegionsPerDesc(viewI),
-          _regionsPerView.getRegionsPerDesc(viewJ),
-          circleSize);
-        dataSelector.computeMask( maskI, maskJ );
-      }
-      break;
-      case eHistogramHarmonizeVLDSegment:
-      {
-        maskI.fill(0);
-        maskJ.fill(0);
+      //-- Compute the masks from the data selection:
+      Image< unsigned char > maskI ( _imageSize[ viewI ].first, _imageSize[ viewI ].second );
+      Image< unsigned char > maskJ ( _imageSize[ viewJ ].first, _imageSize[ viewJ ].second );
 
-        for(const auto& matchesIt: matchesPerDesc)
+      switch(_selectionMethod)
+      {
+        case eHistogramHarmonizeFullFrame:
+        {
+          colorHarmonization::CommonDataByPair_fullFrame  dataSelector(
+            p_imaNames.first,
+            p_imaNames.second);
+          dataSelector.computeMask( maskI, maskJ );
+        }
+        break;
+        case eHistogramHarmonizeMatchedPoints:
         {
-          const feature::EImageDescriberType descType = matchesIt.first;
-          const IndMatches& matches = matchesIt.second;
-          colorHarmonization::CommonDataByPair_vldSegment dataSelector(
+          int circleSize = 10;
+          colorHarmonization::CommonDataByPair_matchedPoints dataSelector(
             p_imaNames.first,
             p_imaNames.second,
-            matches,
-            feature::getSIOPointFeatures(_regionsPerView.getRegions(viewI, descType)),
-            feature::getSIOPointFeatures(_regionsPerView.getRegions(viewJ, descType)));
-
+            matchesPerDesc,
+            _regionsPerView.getRegionsPerDesc(viewI),
+            _regionsPerView.getRegionsPerDesc(viewJ),
+            circleSize);
           dataSelector.computeMask( maskI, maskJ );
         }
+        break;
+        case eHistogramHarmonizeVLDSegment:
+        {
+          maskI.fill(0);
+          maskJ.fill(0);
+
+          for(const auto& matchesIt: matchesPerDesc)
+          {
+            const feature::EImageDescriberType descType = matchesIt.first;
+            const IndMatches& matches = matchesIt.second;
+            colorHarmonization::CommonDataByPair_vldSegment dataSelector(
+              p_imaNames.first,
+              p_imaNames.second,
+              matches,
+              feature::getSIOPointFeatures(_regionsPerView.getRegions(viewI, descType)),
+              feature::getSIOPointFeatures(_regionsPerView.getRegions(viewJ, descType)));
+
+            dataSelector.computeMask( maskI, maskJ );
+          }
+        }
+        break;
       }
-      break;
-      default:
-        std::cout << "Selection method unsupported" << std::endl;
-        return false;
-    }
 
-    //-- Export the masks
-    bool bExportMask = false;
-    if (bExportMask)
-    {
-      string sEdge = _fileNames[ viewI ] + "_" + _fileNames[ viewJ ];
-      sEdge = (fs::path(_outputDirectory) / sEdge ).string();
+      //-- Export the masks
+      bool bExportMask = false;
+      if (bExportMask)
+      {
+        string sEdge = _fileNames[ viewI ] + "_" + _fileNames[ viewJ ];
+        sEdge = (fs::path(_outputDirectory) / sEdge ).string();
 
-      if( !fs::exists(sEdge) )
-        fs::create_directory(sEdge);
+        if( !fs::exists(sEdge) )
+          fs::create_directory(sEdge);
 
-      string out_filename_I = "00_mask_I.png";
-      out_filename_I = (fs::path(sEdge) / out_filename_I).string();
+        string out_filename_I = "00_mask_I.png";
+        out_filename_I = (fs::path(sEdge) / out_filename_I).string();
+
+        string out_filename_J = "00_mask_J.png";
+        out_filename_J = (fs::path(sEdge) / out_filename_J).string();
+        writeImage(out_filename_I, maskI, image::EImageColorSpace::AUTO);
+        writeImage(out_filename_J, maskJ, image::EImageColorSpace::AUTO);
+      }
 
-      string out_filename_J = "00_mask_J.png";
-      out_filename_J = (fs::path(sEdge) / out_filename_J).string();
-      writeImage(out_filename_I, maskI, image::EImageColorSpace::AUTO);
-      writeImage(out_filename_J, maskJ, image::EImageColorSpace::AUTO);
+      //-- Compute the histograms of the 3 channels (RGB), in one pass over each image
+      Histogram< double > histosI[3] = {Histogram< double >( minvalue, maxvalue, bin),
+                                        Histogram< double >( minvalue, maxvalue, bin),
+                                        Histogram< double >( minvalue, maxvalue, bin)};
+      Histogram< double > histosJ[3] = {Histogram< double >( minvalue, maxvalue, bin),
+                                        Histogram< double >( minvalue, maxvalue, bin),
+                                        Histogram< double >( minvalue, maxvalue, bin)};
+      {
+        Image< RGBColor > imageI;
+        readImage(p_imaNames.first, imageI, image::EImageColorSpace::LINEAR);
+        colorHarmonization::CommonDataByPair::computeHistos( histosI, maskI, imageI );
+      }
+      {
+        Image< RGBColor > imageJ;
+        readImage(p_imaNames.second, imageJ, image::EImageColorSpace::LINEAR);
+        colorHarmonization::CommonDataByPair::computeHistos( histosJ, maskJ, imageJ );
+      }
+
+      for(int channelIndex = 0; channelIndex < 3; ++channelIndex)
+      {
+        map_relativeHistograms[channelIndex][i] = relativeColorHistogramEdge(
+          map_cameraNodeToCameraIndex.at(viewI), map_cameraNodeToCameraIndex.at(viewJ),
+          histosI[channelIndex].GetHist(), histosJ[channelIndex].GetHist());
+      }
     }
+    catch(std::exception& e)
+    {
+      #pragma omp critical(colorHarmonizeLog)
+      std::cerr << "Cannot compute the histograms of the edge "
+        << fs::path(p_imaNames.first).filename().string() << "\t"
+        << fs::path(p_imaNames.second).filename().string() << ": " << e.what() << std::endl;
 
-    //-- Compute the histograms
-    Image< RGBColor > imageI, imageJ;
-    readImage(p_imaNames.first, imageI, image::EImageColorSpace::LINEAR);
-    readImage(p_imaNames.second, imageJ, image::EImageColorSpace::LINEAR);
-
-    Histogram< double > histoI( minvalue, maxvalue, bin);
-    Histogram< double > histoJ( minvalue, maxvalue, bin);
-
-    int channelIndex = 0; // RED channel
-    colorHarmonization::CommonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    colorHarmonization::CommonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeR = map_relativeHistograms[channelIndex][i];
-    edgeR = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[viewI], map_cameraNodeToCameraIndex[viewJ],
-      histoI.GetHist(), histoJ.GetHist());
-
-    histoI = histoJ = Histogram< double >( minvalue, maxvalue, bin);
-    channelIndex = 1; // GREEN channel
-    colorHarmonization::CommonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    colorHarmonization::CommonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeG = map_relativeHistograms[channelIndex][i];
-    edgeG = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[viewI], map_cameraNodeToCameraIndex[viewJ],
-      histoI.GetHist(), histoJ.GetHist());
-
-    histoI = histoJ = Histogram< double >( minvalue, maxvalue, bin);
-    channelIndex = 2; // BLUE channel
-    colorHarmonization::CommonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    colorHarmonization::CommonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeB = map_relativeHistograms[channelIndex][i];
-    edgeB = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[viewI], map_cameraNodeToCameraIndex[viewJ],
-      histoI.GetHist(), histoJ.GetHist());
+      #pragma omp atomic write
+      success = false;
+    }
   }
 
+  if(!success)
+    return false;
+
   std::cout << "\n -- \n SOLVE for color consistency with linear programming\n --" << std::endl;
   //-- Solve for the gains and offsets:
   std::vector<size_t> vec_indexToFix;
@@ -324,9 +358,7 @@ bool ColorHarmonizationEngineGlobal::Process()
 
   using namespace aliceVision::linearProgramming;
 
-  std::vector<double> vec_solution_r(_fileNames.size() * 2 + 1);
-  std::vector<double> vec_solution_g(_fileNames.size() * 2 + 1);
-  std::vector<double> vec_solution_b(_fileNames.size() * 2 + 1);
+  std::vector<double> vec_solutions[3];
 
   aliceVision::system::Timer timer;
 
@@ -335,40 +367,32 @@ bool ColorHarmonizationEngineGlobal::Process()
   #else
   typedef OSI_CISolverWrapper SOLVER_LP_T;
   #endif
-  // Red channel
-  {
-    SOLVER_LP_T lpSolver(vec_solution_r.size());
 
-    GainOffsetConstraintBuilder cstBuilder(map_relativeHistograms[0], vec_indexToFix);
-    LPConstraintsSparse constraint;
-    cstBuilder.Build(constraint);
-    lpSolver.setup(constraint);
-    lpSolver.solve();
-    lpSolver.getSolution(vec_solution_r);
-  }
-  // Green channel
+  // one LP by channel (RGB)
+  // the OSI solvers are independent instances, the channels are solved in parallel
+  // (the MOSEK solvers share a global environment)
+  #if !ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_MOSEK)
+  #pragma omp parallel for num_threads(3)
+  #endif
+  for(int channelIndex = 0; channelIndex < 3; ++channelIndex)
   {
-    SOLVER_LP_T lpSolver(vec_solution_g.size());
+    std::vector<double>& vec_solution = vec_solutions[channelIndex];
+    vec_solution.resize(_fileNames.size() * 2 + 1);
 
-    GainOffsetConstraintBuilder cstBuilder(map_relativeHistograms[1], vec_indexToFix);
-    LPConstraintsSparse constraint;
-    cstBuilder.Build(constraint);
-    lpSolver.setup(constraint);
-    lpSolver.solve();
-    lpSolver.getSolution(vec_solution_g);
-  }
-  // Blue channel
-  {
-    SOLVER_LP_T lpSolver(vec_solution_b.size());
+    SOLVER_LP_T lpSolver(vec_solution.size());
 
-    GainOffsetConstraintBuilder cstBuilder(map_relativeHistograms[2], vec_indexToFix);
+    GainOffsetConstraintBuilder cstBuilder(map_relativeHistograms[channelIndex], vec_indexToFix);
     LPConstraintsSparse constraint;
     cstBuilder.Build(constraint);
     lpSolver.setup(constraint);
     lpSolver.solve();
-    lpSolver.getSolution(vec_solution_b);
+    lpSolver.getSolution(vec_solution);
   }
 
+  const std::vector<double>& vec_solution_r = vec_solutions[0];
+  const std::vector<double>& vec_solution_g = vec_solutions[1];
+  const std::vector<double>& vec_solution_b = vec_solutions[2];
+
   std::cout << std::endl
     << " ColorHarmonization solving on a graph with: " << _pairwiseMatches.size() << " edges took (s): "
     << timer.elapsed() << std::endl
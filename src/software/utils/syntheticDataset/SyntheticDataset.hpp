@@ -0,0 +1,244 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2019 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/camera/Pinhole.hpp>
+#include <aliceVision/mvsData/Rgb.hpp>
+#include <aliceVision/mvsData/imageIO.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace syntheticDataset {
+
+/**
+ * @brief Synthetic scene: a sphere in front of a back wall, above a ground plane,
+ *        with a procedural texture so that the views are photo-consistent.
+ * @note The y axis points down, as in the camera frame.
+ */
+struct SyntheticScene
+{
+  Vec3 sphereCenter = Vec3(0.0, 0.0, 5.0);
+  double sphereRadius = 1.0;
+  /// back wall plane z = wallZ
+  double wallZ = 8.0;
+  /// ground plane y = groundY
+  double groundY = 1.2;
+
+  /**
+   * @brief Get the distance to the first surface along a ray.
+   * @param[in] origin the ray origin
+   * @param[in] direction the normalized ray direction
+   * @return the distance, -1 if the ray does not hit the scene
+   */
+  double intersect(const Vec3& origin, const Vec3& direction) const
+  {
+    double t = std::numeric_limits<double>::max();
+
+    const Vec3 oc = origin - sphereCenter;
+    const double b = oc.dot(direction);
+    const double delta = b * b - (oc.squaredNorm() - sphereRadius * sphereRadius);
+    if(delta >= 0.0 && -b - std::sqrt(delta) > 0.0)
+      t = -b - std::sqrt(delta);
+
+    if(direction(2) > 1e-9)
+    {
+      const double tWall = (wallZ - origin(2)) / direction(2);
+      if(tWall > 0.0)
+        t = std::min(t, tWall);
+    }
+
+    if(direction(1) > 1e-9)
+    {
+      const double tGround = (groundY - origin(1)) / direction(1);
+      if(tGround > 0.0)
+        t = std::min(t, tGround);
+    }
+
+    return (t == std::numeric_limits<double>::max()) ? -1.0 : t;
+  }
+
+  /**
+   * @brief Get the color of a point of the scene: a few octaves of value noise per channel.
+   */
+  rgb getColor(const Vec3& X) const
+  {
+    rgb color;
+    unsigned char* channels[3] = {&color.r, &color.g, &color.b};
+    for(int c = 0; c < 3; ++c)
+    {
+      double value = 0.0;
+      double amplitude = 0.5;
+      double frequency = 10.0;
+      for(int octave = 0; octave < 4; ++octave)
+      {
+        value += amplitude * valueNoise(X * frequency, c * 4 + octave);
+        amplitude *= 0.5;
+        frequency *= 2.0;
+      }
+      *channels[c] = static_cast<unsigned char>(std::min(255.0, std::max(0.0, 255.0 * value / 0.9375)));
+    }
+    return color;
+  }
+
+private:
+  static double latticeValue(int x, int y, int z, int seed)
+  {
+    std::uint32_t h = static_cast<std::uint32_t>(x) * 73856093u ^ static_cast<std::uint32_t>(y) * 19349663u ^
+                      static_cast<std::uint32_t>(z) * 83492791u ^ static_cast<std::uint32_t>(seed) * 2654435761u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return (h & 0xffffffu) / static_cast<double>(0x1000000);
+  }
+
+  /// trilinear interpolation of a random lattice with a smoothstep
+  static double valueNoise(const Vec3& p, int seed)
+  {
+    const int x0 = static_cast<int>(std::floor(p(0)));
+    const int y0 = static_cast<int>(std::floor(p(1)));
+    const int z0 = static_cast<int>(std::floor(p(2)));
+    const auto smooth = [](double t) { return t * t * (3.0 - 2.0 * t); };
+    const double fx = smooth(p(0) - x0);
+    const double fy = smooth(p(1) - y0);
+    const double fz = smooth(p(2) - z0);
+
+    double value = 0.0;
+    for(int dz = 0; dz < 2; ++dz)
+      for(int dy = 0; dy < 2; ++dy)
+        for(int dx = 0; dx < 2; ++dx)
+          value += (dx ? fx : 1.0 - fx) * (dy ? fy : 1.0 - fy) * (dz ? fz : 1.0 - fz) *
+                   latticeValue(x0 + dx, y0 + dy, z0 + dz, seed);
+    return value;
+  }
+};
+
+/**
+ * @brief Create the views looking at the sphere from an horizontal arc, render their images
+ *        and add the landmarks seen by at least two views.
+ * @param[in] scene the synthetic scene
+ * @param[in] nbViews the number of views
+ * @param[in] arcAngle the angle of the arc of the views in degrees
+ * @param[in] width the image width
+ * @param[in] height the image height
+ * @param[in] imagesFolder the folder of the rendered images
+ * @param[out] sfmData the views, poses, intrinsic and landmarks
+ */
+inline void createSyntheticDataset(const SyntheticScene& scene, int nbViews, double arcAngle, int width, int height,
+                            const std::string& imagesFolder, sfmData::SfMData& sfmData)
+{
+  const double focal = static_cast<double>(width);
+  auto intrinsic = std::make_shared<camera::Pinhole>(width, height, focal, width / 2.0, height / 2.0);
+  sfmData.intrinsics[0] = intrinsic;
+
+  const Mat3 K = intrinsic->K();
+  const Mat3 Kinv = K.inverse();
+  const double distance = 5.0;
+
+  std::vector<geometry::Pose3> poses;
+  for(int i = 0; i < nbViews; ++i)
+  {
+    const double angle = (nbViews > 1) ? degreeToRadian(arcAngle) * (i / double(nbViews - 1) - 0.5) : 0.0;
+    const Vec3 center = scene.sphereCenter + Vec3(distance * std::sin(angle), -0.3, -distance * std::cos(angle));
+
+    // camera frame: x right, y down, z forward
+    const Vec3 forward = (scene.sphereCenter - center).normalized();
+    const Vec3 right = forward.cross(Vec3(0.0, -1.0, 0.0)).normalized();
+    const Vec3 down = forward.cross(right);
+    Mat3 R;
+    R.row(0) = right;
+    R.row(1) = down;
+    R.row(2) = forward;
+    poses.emplace_back(R, center);
+
+    const std::string imagePath = (boost::filesystem::path(imagesFolder) / (std::to_string(i) + ".png")).string();
+    sfmData.views[i] = std::make_shared<sfmData::View>(imagePath, i, 0, i, width, height);
+    sfmData.setPose(*sfmData.views.at(i), sfmData::CameraPose(poses.back()));
+
+    // render with 2x2 samples per pixel
+    std::vector<rgb> image(width * height);
+    const Mat3 Rt = R.transpose();
+#pragma omp parallel for
+    for(int y = 0; y < height; ++y)
+    {
+      for(int x = 0; x < width; ++x)
+      {
+        Vec3 sum = Vec3::Zero();
+        for(int s = 0; s < 4; ++s)
+        {
+          const Vec3 direction = (Rt * Kinv * Vec3(x - 0.25 + 0.5 * (s % 2), y - 0.25 + 0.5 * (s / 2), 1.0)).normalized();
+          const double t = scene.intersect(center, direction);
+          if(t > 0.0)
+          {
+            const rgb color = scene.getColor(center + t * direction);
+            sum += Vec3(color.r, color.g, color.b);
+          }
+        }
+        sum /= 4.0;
+        image[y * width + x] = rgb(static_cast<unsigned char>(sum(0)), static_cast<unsigned char>(sum(1)), static_cast<unsigned char>(sum(2)));
+      }
+    }
+
+    imageIO::OutputFileColorSpace colorspace(imageIO::EImageColorSpace::NO_CONVERSION);
+    imageIO::writeImage(imagePath, width, height, image, imageIO::EImageQuality::LOSSLESS, colorspace);
+  }
+
+  // landmarks on a grid of pixels of each view, observed by the views that see them
+  const int gridStep = std::max(1, width / 48);
+  IndexT landmarkId = 0;
+  for(int i = 0; i < nbViews; ++i)
+  {
+    const Mat3 Rt = poses[i].rotation().transpose();
+    for(int y = gridStep / 2; y < height; y += gridStep)
+    {
+      for(int x = gridStep / 2; x < width; x += gridStep)
+      {
+        const Vec3 direction = (Rt * Kinv * Vec3(x, y, 1.0)).normalized();
+        const double t = scene.intersect(poses[i].center(), direction);
+        if(t <= 0.0)
+          continue;
+
+        sfmData::Landmark landmark(poses[i].center() + t * direction, feature::EImageDescriberType::SIFT);
+        for(int j = 0; j < nbViews; ++j)
+        {
+          const Vec3 Xc = poses[j].rotation() * (landmark.X - poses[j].center());
+          if(Xc(2) <= 0.0)
+            continue;
+          const Vec3 x = K * Xc;
+          const Vec2 pt(x(0) / x(2), x(1) / x(2));
+          if(pt(0) < 0.0 || pt(1) < 0.0 || pt(0) >= width || pt(1) >= height)
+            continue;
+
+          // occlusion test
+          const Vec3 toPoint = landmark.X - poses[j].center();
+          if(std::abs(scene.intersect(poses[j].center(), toPoint.normalized()) - toPoint.norm()) > 1e-6 * toPoint.norm() + 1e-6)
+            continue;
+          landmark.observations[j] = sfmData::Observation(pt, landmarkId);
+        }
+        if(landmark.observations.size() >= 2)
+          sfmData.structure[landmarkId++] = landmark;
+      }
+    }
+  }
+
+  ALICEVISION_LOG_INFO("Synthetic scene: " << nbViews << " views of " << width << "x" << height << ", "
+                       << sfmData.getLandmarks().size() << " landmarks.");
+}
+
+} // namespace syntheticDataset
+} // namespace aliceVision